@@ -31,3 +31,23 @@ def ptxla_cc_test(
         ],
         **kwargs
     )
+
+def ptxla_cc_binary(
+        deps,
+        copts = [],
+        **kwargs):
+    native.cc_binary(
+        linkstatic = True,
+        copts = copts + [
+            "-isystemexternal/torch",  # Required for system includes.
+        ],
+        deps = deps + [
+            "@pybind11//:pybind11_embed",  # libpython
+            "@torch//:headers",
+            "@torch//:libc10",
+            "@torch//:libtorch",
+            "@torch//:libtorch_cpu",
+            "@torch//:libtorch_python",
+        ],
+        **kwargs
+    )
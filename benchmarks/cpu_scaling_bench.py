@@ -0,0 +1,160 @@
+"""Measures how the CPU inference throughput scales with the CPUs it runs on.
+
+Every configuration runs in fresh processes of the CPU plugin, since the
+affinity of the client is set when it is created:
+  threads=N: one process on the first N CPUs of NUMA node 0.
+  all: one process on all the CPUs of the host, across the sockets.
+  per_numa_node: a process per NUMA node, each pinned to its node and running
+    concurrently, whose throughputs add up.
+The model is an MLP, run on batches of random inputs. The report holds the
+samples per second of every configuration, and its speedup over one thread.
+
+It needs the CPU plugin to be installed, see plugins/cpu/README.md:
+
+  python xla/benchmarks/cpu_scaling_bench.py --json-output=cpu_scaling.json
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import time
+
+
+def run_worker(args):
+  import torch
+  import torch_xla
+  from torch_xla.experimental import plugins
+  import torch_xla.runtime as xr
+  import torch_xla_cpu_plugin
+
+  plugins.use_dynamic_plugins()
+  plugins.register_plugin('CPU', torch_xla_cpu_plugin.CpuPlugin())
+  xr.set_device_type('CPU')
+  device = torch_xla.device()
+
+  layers = []
+  for _ in range(args.layers):
+    layers += [torch.nn.Linear(args.width, args.width), torch.nn.ReLU()]
+  model = torch.nn.Sequential(*layers).to(device).eval()
+  batch = torch.randn(args.batch_size, args.width, device=device)
+
+  with torch.no_grad():
+    for _ in range(args.warmup):
+      model(batch)
+      torch_xla.sync(wait=True)
+    t_start = time.perf_counter()
+    for _ in range(args.iterations):
+      model(batch)
+      torch_xla.sync()
+    torch_xla.sync(wait=True)
+    wall_s = time.perf_counter() - t_start
+  print(json.dumps({
+      'samples_per_s': args.iterations * args.batch_size / wall_s,
+      'cpus': len(os.sched_getaffinity(0)),
+  }))
+
+
+def start_worker(args, env_overrides):
+  env = dict(os.environ)
+  env.update(env_overrides)
+  worker_args = [
+      sys.executable, __file__, '--worker', f'--layers={args.layers}',
+      f'--width={args.width}', f'--batch-size={args.batch_size}',
+      f'--warmup={args.warmup}', f'--iterations={args.iterations}'
+  ]
+  return subprocess.Popen(
+      worker_args, env=env, stdout=subprocess.PIPE, text=True)
+
+
+def wait_workers(workers):
+  results = []
+  for worker in workers:
+    stdout, _ = worker.communicate()
+    if worker.returncode != 0:
+      raise RuntimeError(f'Worker failed with exit code {worker.returncode}')
+    results.append(json.loads(stdout.strip().splitlines()[-1]))
+  return {
+      'samples_per_s': sum(r['samples_per_s'] for r in results),
+      'cpus': sum(r['cpus'] for r in results),
+      'processes': len(results),
+  }
+
+
+def get_configs(node_cpus):
+  configs = []
+  threads = 1
+  while threads < len(node_cpus[0]):
+    configs.append((f'threads={threads}', [{
+        'XLA_CPU_NUMA_NODE': '0',
+        'XLA_CPU_INTRA_OP_THREADS': str(threads)
+    }]))
+    threads *= 2
+  configs.append((f'threads={len(node_cpus[0])}', [{
+      'XLA_CPU_NUMA_NODE': '0'
+  }]))
+  if len(node_cpus) > 1:
+    configs.append(('all', [{}]))
+    configs.append(('per_numa_node', [{
+        'XLA_CPU_NUMA_NODE': str(node)
+    } for node in range(len(node_cpus))]))
+  return configs
+
+
+def parse_args(args=None):
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      '--worker',
+      action='store_true',
+      help='Run a single measurement, as the driver does in its processes.',
+  )
+  parser.add_argument(
+      '--layers', type=int, default=8, help='Linear layers of the MLP.')
+  parser.add_argument(
+      '--width', type=int, default=1024, help='Features of every layer.')
+  parser.add_argument(
+      '--batch-size', type=int, default=64, help='Samples of every batch.')
+  parser.add_argument(
+      '--warmup',
+      type=int,
+      default=5,
+      help='Batches run ahead of the timed ones.',
+  )
+  parser.add_argument(
+      '--iterations', type=int, default=50, help='Timed batches.')
+  parser.add_argument(
+      '--json-output',
+      type=str,
+      help='File to also write the results to, as JSON.',
+  )
+  return parser.parse_args(args)
+
+
+def main():
+  args = parse_args()
+  if args.worker:
+    run_worker(args)
+    return
+
+  import torch_xla_cpu_plugin
+  node_cpus = torch_xla_cpu_plugin.numa_node_cpus()
+  print(f'# NUMA nodes: {len(node_cpus)}, CPUs: '
+        f'{sum(len(cpus) for cpus in node_cpus)}')
+  print(f"{'# config':<16} {'processes':>9} {'cpus':>6} {'samples/s':>12} "
+        f"{'speedup':>8}")
+  results = {}
+  for name, envs in get_configs(node_cpus):
+    result = wait_workers([start_worker(args, env) for env in envs])
+    results[name] = result
+    speedup = result['samples_per_s'] / results['threads=1']['samples_per_s']
+    print(f"{name:<16} {result['processes']:>9} {result['cpus']:>6} "
+          f"{result['samples_per_s']:>12.1f} {speedup:>8.2f}")
+
+  if args.json_output:
+    with open(args.json_output, 'w') as f:
+      json.dump(results, f, indent=2)
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,139 @@
+"""Measures the dispatch throughput of small ops in eager mode.
+
+Every op of the suite runs in a loop on small tensors, after a warm-up which
+compiles its executable. The report holds, for the timed loop of every op:
+  ops/s: the op invocations per second of wall time.
+  compiles: the executables compiled during the warm-up and the timed loop,
+    the latter of which should not compile any.
+  compile: the time spent compiling, out of `EagerOpCompileTime`.
+  dispatch: the wall time spent outside of the compilation, tracing, looking
+    up and launching the executables.
+  execute: the time the executions took, out of `EagerOpExecuteTime`, which
+    overlaps with the dispatch of the following ops.
+
+It runs on any PJRT device, e.g. with `PJRT_DEVICE=CPU` in CI:
+
+  PJRT_DEVICE=CPU python xla/benchmarks/eager_bench.py --json-output=eager.json
+"""
+
+import argparse
+import json
+import time
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from torch_xla.experimental import eager_mode
+
+OPS = {
+    "add": lambda a, b: a + b,
+    "mul": lambda a, b: a * b,
+    "relu": lambda a, b: torch.relu(a),
+    "sum": lambda a, b: a.sum(),
+    "matmul": lambda a, b: a @ b,
+    "softmax": lambda a, b: torch.softmax(a, dim=-1),
+    "cat": lambda a, b: torch.cat([a, b]),
+    "view": lambda a, b: a.view(-1),
+}
+
+
+def metric_totals(name):
+  """Returns the number of samples and the total time of a timed metric."""
+  data = met.metric_data(name)
+  if data is None:
+    return 0, 0.0
+  number, total_time_ns, _ = data
+  return number, total_time_ns * 1e-9
+
+
+def run_op(fn, a, b, warmup, iterations):
+  compiles_start, _ = metric_totals("EagerOpCompileTime")
+  for _ in range(warmup):
+    fn(a, b)
+  xm.wait_device_ops()
+
+  compiles_warm, compile_s_start = metric_totals("EagerOpCompileTime")
+  _, execute_s_start = metric_totals("EagerOpExecuteTime")
+  t_start = time.perf_counter()
+  for _ in range(iterations):
+    fn(a, b)
+  xm.wait_device_ops()
+  wall_s = time.perf_counter() - t_start
+  compiles_end, compile_s_end = metric_totals("EagerOpCompileTime")
+  _, execute_s_end = metric_totals("EagerOpExecuteTime")
+
+  compile_s = compile_s_end - compile_s_start
+  return {
+      "ops_per_s": iterations / wall_s,
+      "warmup_compiles": compiles_warm - compiles_start,
+      "compiles": compiles_end - compiles_warm,
+      "wall_s": wall_s,
+      "compile_s": compile_s,
+      "dispatch_s": wall_s - compile_s,
+      "execute_s": execute_s_end - execute_s_start,
+  }
+
+
+def parse_args(args=None):
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      "--ops",
+      type=str,
+      default=",".join(OPS),
+      help="Comma separated ops to run, out of: " + ", ".join(OPS) + ".",
+  )
+  parser.add_argument(
+      "--size",
+      type=int,
+      default=16,
+      help="Size of the dimensions of the square input tensors.",
+  )
+  parser.add_argument(
+      "--warmup",
+      type=int,
+      default=10,
+      help="Invocations of every op ahead of the timed ones.",
+  )
+  parser.add_argument(
+      "--iterations",
+      type=int,
+      default=1000,
+      help="Timed invocations of every op.",
+  )
+  parser.add_argument(
+      "--json-output",
+      type=str,
+      help="File to also write the results to, as JSON.",
+  )
+  return parser.parse_args(args)
+
+
+def main():
+  args = parse_args()
+  device = torch_xla.device()
+  eager_mode(True)
+  a = torch.randn(args.size, args.size, device=device)
+  b = torch.randn(args.size, args.size, device=device)
+  xm.wait_device_ops()
+
+  print(f"# Device: {xm.xla_device_hw(device)}, size: {args.size}, "
+        f"iterations: {args.iterations}")
+  print(f"{'# op':<14} {'ops/s':>10} {'compiles':>9} {'compile (s)':>12} "
+        f"{'dispatch (s)':>13} {'execute (s)':>12}")
+  results = {}
+  for name in args.ops.split(","):
+    result = run_op(OPS[name], a, b, args.warmup, args.iterations)
+    results[name] = result
+    compiles = result["warmup_compiles"] + result["compiles"]
+    print(f"{name:<14} {result['ops_per_s']:>10.1f} {compiles:>9} "
+          f"{result['compile_s']:>12.4f} {result['dispatch_s']:>13.4f} "
+          f"{result['execute_s']:>12.4f}")
+
+  if args.json_output:
+    with open(args.json_output, "w") as f:
+      json.dump(results, f, indent=2)
+
+
+if __name__ == "__main__":
+  main()
@@ -28,7 +28,7 @@ from enum import Enum
 from torchbench_model import TorchBenchModelLoader
 from benchmark_model import BenchmarkModel
 from benchmark_experiment import ExperimentLoader, BenchmarkExperiment
-from util import cleanup, move_to_device, randomize_input, reset_rng_state, us_to_s, ns_to_s, StrOrBool
+from util import cleanup, mean_confidence_interval, move_to_device, randomize_input, reset_rng_state, us_to_s, ns_to_s, StrOrBool
 
 import torch_xla
 import torch_xla.core.xla_model as xm
@@ -36,6 +36,11 @@ import torch_xla.debug.profiler as xp
 
 logger = logging.getLogger(__name__)
 
+# PyTorch/XLA timed metrics of the compilation phases besides "CompileTime",
+# which is always collected: the lowering of the graphs to XLA computations,
+# and their serialization into the persistent cache.
+COMPILE_PHASE_METRICS = ["LowerGraph", "SerializeComputation"]
+
 
 class ExperimentRunner:
 
@@ -298,15 +303,18 @@ class ExperimentRunner:
 
       # Repeat the experiment and accumulate metrics.
       with model.pick_grad():
-        for repeat_iteration in range(self._args.repeat):
-          metrics, _ = self.run_once_and_gather_metrics(experiment, model,
-                                                        experiment_config,
-                                                        model_config,
-                                                        repeat_iteration)
-          for k, v in metrics.items():
-            if k not in accumulated_metrics:
-              accumulated_metrics[k] = []
-            accumulated_metrics[k].append(v)
+        if self._args.steady_state:
+          accumulated_metrics = self.run_steady_state_and_gather_metrics(
+              experiment, model)
+        else:
+          for repeat_iteration in range(self._args.repeat):
+            metrics, _ = self.run_once_and_gather_metrics(
+                experiment, model, experiment_config, model_config,
+                repeat_iteration)
+            for k, v in metrics.items():
+              if k not in accumulated_metrics:
+                accumulated_metrics[k] = []
+              accumulated_metrics[k].append(v)
     elif not model.skip_verifier():
       try:
         verification_code = verify(
@@ -346,6 +354,12 @@ class ExperimentRunner:
     met.clear_all()
     dynamo_utils.counters.clear()
     metrics = OrderedDict()
+    collect_efficiency = (
+        benchmark_experiment.xla and not benchmark_experiment.torch_xla2)
+    if collect_efficiency:
+      graph_executions = {
+          graph["hash"]: graph["executions"] for graph in met.graph_stats()
+      }
 
     # Start timers.
     t_start = time.perf_counter()
@@ -444,13 +458,18 @@ class ExperimentRunner:
       if self._args.dump_pytorch_xla_metrics:
         self._dump_pytorch_xla_metrics(experiment_config, model_config,
                                        repeat_iteration)
-      for m in ("CompileTime", "ExecuteTime"):
+      xla_metrics = ["CompileTime", "ExecuteTime"]
+      if self._args.collect_compile_phases:
+        xla_metrics += COMPILE_PHASE_METRICS
+      for m in xla_metrics:
         data = met.metric_data(m)
         data = data if data is not None else (0, 0, [])
         number, total_time, _ = data
         # Time is measured in nano-seconds
         metrics[f"xla_{m}_time_s"] = ns_to_s(total_time)
         metrics[f"xla_{m}_number"] = number
+      if collect_efficiency:
+        self._collect_xla_efficiency_metrics(graph_executions, metrics)
 
     # Additional experiment metrics can be added here.
 
@@ -463,6 +482,94 @@ class ExperimentRunner:
 
     return metrics, output
 
+  def _compile_count(self, benchmark_experiment: BenchmarkExperiment) -> int:
+    count = dynamo_utils.counters["stats"]["unique_graphs"]
+    if benchmark_experiment.xla and not benchmark_experiment.torch_xla2:
+      data = met.metric_data("CompileTime")
+      count += data[0] if data is not None else 0
+    return count
+
+  def run_steady_state_and_gather_metrics(
+      self, benchmark_experiment: BenchmarkExperiment,
+      benchmark_model: BenchmarkModel) -> typing.OrderedDict[str, List[Any]]:
+    """Runs iterations until the run is in a steady state, then for a time
+    budget, and returns the metrics of the latter.
+
+    The run is in a steady state once the last `--steady-state-window`
+    iterations neither compiled a graph nor varied in time by more than the
+    `--steady-state-cv` coefficient of variation. The metrics are lists, like
+    the accumulated metrics of the repetitions, of one element unless noted.
+    """
+    reset_rng_state(benchmark_experiment)
+    inputs_list = self._prepare_inputs(benchmark_model.example_inputs,
+                                       self._args.randomize_input)
+    window = max(self._args.steady_state_window, 2)
+
+    def step(i):
+      output, _, _ = self._default_iter_fn(benchmark_experiment,
+                                           benchmark_model,
+                                           inputs_list[i % len(inputs_list)])
+      return output
+
+    # Warm up.
+    step_times = []
+    compiled = []
+    steady = False
+    warmup_steps = 0
+    while warmup_steps < self._args.steady_state_max_warmup_steps:
+      compile_count = self._compile_count(benchmark_experiment)
+      t_start = time.perf_counter()
+      step(warmup_steps)
+      self._synchronize(benchmark_experiment)
+      step_times.append(time.perf_counter() - t_start)
+      compiled.append(self._compile_count(benchmark_experiment) > compile_count)
+      warmup_steps += 1
+      if len(step_times) >= window and not any(compiled[-window:]):
+        recent = np.asarray(step_times[-window:])
+        if np.std(recent) <= self._args.steady_state_cv * np.mean(recent):
+          steady = True
+          break
+    if not steady:
+      logger.warning(f"No steady state after {warmup_steps} warm-up steps, "
+                     "measuring anyway")
+
+    # Measure. The iterations are not synchronized on the device, except for
+    # the last one, so that the host and the device overlap as they do in
+    # training loops. The step times are the ones of the dispatches but the
+    # last, whose time includes the wait on the device.
+    compile_count = self._compile_count(benchmark_experiment)
+    step_times = []
+    t_start = time.perf_counter()
+    t_budget = t_start + self._args.steady_state_budget_s
+    t_step = t_start
+    while True:
+      step(warmup_steps + len(step_times))
+      done = time.perf_counter() >= t_budget
+      if done:
+        self._synchronize(benchmark_experiment)
+      t_end = time.perf_counter()
+      step_times.append(t_end - t_step)
+      t_step = t_end
+      if done:
+        break
+
+    total_time = t_end - t_start
+    per_iter_time = total_time / len(step_times)
+    low, high = mean_confidence_interval(step_times)
+    metrics = OrderedDict()
+    metrics["total_time"] = [total_time]
+    # All the step times.
+    metrics["per_iter_time"] = step_times
+    metrics["per_iter_time_ci_low"] = [low]
+    metrics["per_iter_time_ci_high"] = [high]
+    metrics["throughput"] = [1 / per_iter_time]
+    metrics["steady_state_reached"] = [1 if steady else 0]
+    metrics["steady_state_warmup_steps"] = [warmup_steps]
+    metrics["steady_state_compiles"] = [
+        self._compile_count(benchmark_experiment) - compile_count
+    ]
+    return metrics
+
   def _prepare_inputs(self, example_inputs: Sequence[Any],
                       should_randomize_input: bool):
     inputs_list = []
@@ -685,6 +792,37 @@ class ExperimentRunner:
           metrics["inductor_ops"] = dict()
         metrics["inductor_ops"][op_name] = extract_prof_info(event)
 
+  def _collect_xla_efficiency_metrics(self, graph_executions: Dict[bytes, int],
+                                      metrics: Dict[str, Any]):
+    # Only the executions since `graph_executions` count, which held the
+    # executions of every graph before the repetition.
+    flops = 0
+    device_time_ns = 0
+    for graph in met.graph_stats():
+      executions = graph["executions"] - graph_executions.get(graph["hash"], 0)
+      if executions <= 0:
+        continue
+      flops += graph["flops"] * executions
+      if graph["execute_time_p50_ns"] is not None:
+        device_time_ns += graph["execute_time_p50_ns"] * executions
+
+    total_time = metrics["total_time"]
+    tflops = flops / total_time / 1e12 if flops > 0 and total_time > 0 else None
+    metrics["xla_flops"] = flops
+    metrics["xla_tflops"] = tflops
+    metrics["xla_model_flops_utilization"] = (
+        tflops / self._args.peak_tflops
+        if tflops and self._args.peak_tflops > 0 else None)
+    # The time the device was not executing the graphs, as a fraction of the
+    # wall time.
+    metrics["xla_host_bound_fraction"] = (
+        max(0.0, 1.0 - ns_to_s(device_time_ns) / total_time)
+        if device_time_ns > 0 and total_time > 0 else None)
+    try:
+      metrics["xla_peak_bytes_used"] = xm.get_memory_info()["peak_bytes_used"]
+    except RuntimeError as e:
+      logger.debug(f"Device memory info is not available: {e}")
+
   def _dump_dynamo_counters(
       self, experiment_config: typing.OrderedDict[str, Optional[StrOrBool]],
       model_config: typing.OrderedDict[str, Optional[StrOrBool]],
@@ -811,6 +949,41 @@ def parse_args(args=None):
       default=1,
       help="Number of times to repeat the model iteration inside a timed run.",
   )
+  parser.add_argument(
+      "--steady-state",
+      action="store_true",
+      help="""Instead of the fixed --repeat and --iterations-per-run counts,
+        run iterations until they neither compile nor vary in time, then for
+        --steady-state-budget-s seconds, reporting the step time confidence
+        interval and the throughput.""",
+  )
+  parser.add_argument(
+      "--steady-state-window",
+      type=int,
+      default=10,
+      help="""Number of consecutive iterations without compilations, and with
+        times within --steady-state-cv, that make a steady state.""",
+  )
+  parser.add_argument(
+      "--steady-state-cv",
+      type=float,
+      default=0.05,
+      help="""Largest coefficient of variation (standard deviation over mean)
+        of the iteration times of a steady state.""",
+  )
+  parser.add_argument(
+      "--steady-state-max-warmup-steps",
+      type=int,
+      default=1000,
+      help="""Number of warm-up iterations after which the measurement starts
+        even if no steady state was reached.""",
+  )
+  parser.add_argument(
+      "--steady-state-budget-s",
+      type=float,
+      default=10.0,
+      help="Time budget, in seconds, of the steady state measurement.",
+  )
   parser.add_argument(
       "--batch-size",
       type=int,
@@ -910,6 +1083,23 @@ def parse_args(args=None):
       action="store_true",
       help="""Collect dynamo counters as part of the regular metrics.""",
   )
+  parser.add_argument(
+      "--collect-compile-phases",
+      action="store_true",
+      help="""Collect the time spent lowering the graphs, compiling them with
+        XLA, and serializing them into the persistent cache (when
+        `XLA_PERSISTENT_CACHE_PATH` is set) as part of the regular metrics.
+        `result_analyzer.py --baseline` compares them across runs.""",
+  )
+  parser.add_argument(
+      "--peak-tflops",
+      type=float,
+      default=float(os.environ.get("XLA_PEAK_TFLOPS", 0)),
+      help="""Peak dense TFLOP/s of one device, against which the model FLOPs
+        utilization of the PyTorch/XLA experiments is computed. The FLOPs are
+        the ones of the XLA cost analysis of the executed graphs, per device.
+        Defaults to `XLA_PEAK_TFLOPS`.""",
+  )
   parser.add_argument(
       "--dump-pytorch-profiles",
       action="store_true",
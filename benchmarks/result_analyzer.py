@@ -4,11 +4,26 @@ import logging
 import numpy as np
 import os
 import pandas as pd
+import sys
 import time
 from typing import Optional
 
 logger = logging.getLogger(__name__)
 
+# Report columns of the compilation phases, each the total time, in seconds,
+# of the experiment_runner.py metric it maps to over all the repetitions.
+COMPILE_PHASES = {
+    "xla_lowering_time": "xla_LowerGraph_time_s",
+    "xla_backend_compile_time": "xla_CompileTime_time_s",
+    "xla_serialization_time": "xla_SerializeComputation_time_s",
+}
+
+# Columns identifying the configuration of a run, across runs.
+CONFIG_COLUMNS = [
+    "suite_name", "model_name", "accelerator_model", "xla", "dynamo",
+    "torch_xla2", "test", "batch_size"
+]
+
 
 class ResultAnalyzer:
 
@@ -67,6 +82,13 @@ class ResultAnalyzer:
         "xla_median_trace_per_iter_time": pd.Series(dtype="float"),
         "xla_compile_time": pd.Series(dtype="float"),
         "dynamo_compile_time": pd.Series(dtype="float"),
+        "xla_lowering_time": pd.Series(dtype="float"),
+        "xla_backend_compile_time": pd.Series(dtype="float"),
+        "xla_serialization_time": pd.Series(dtype="float"),
+        "median_xla_tflops": pd.Series(dtype="float"),
+        "median_xla_model_flops_utilization": pd.Series(dtype="float"),
+        "median_xla_host_bound_fraction": pd.Series(dtype="float"),
+        "max_xla_peak_bytes_used": pd.Series(dtype="float"),
         "outputs_file": pd.Series(dtype="str"),
     })
     for file in jsonl_files:
@@ -101,6 +123,10 @@ class ResultAnalyzer:
     d["dynamo_compile_time"] = compile_time if dataline["experiment"][
         "dynamo"] else -1
     d["xla_compile_time"] = compile_time if dataline["experiment"]["xla"] else -1
+
+    for column, metric in COMPILE_PHASES.items():
+      values = dataline["metrics"].get(metric)
+      d[column] = float(np.sum(values)) if values is not None else -1
     return d
 
   # TODO: handle error message properly (database length restriction)
@@ -160,6 +186,8 @@ class ResultAnalyzer:
         d["metrics"]["xla_median_trace_per_iter_time"] = -1
         d["metrics"]["xla_compile_time"] = -1
         d["metrics"]["dynamo_compile_time"] = -1
+        for column in COMPILE_PHASES:
+          d["metrics"][column] = -1
 
       runs.append(d)
 
@@ -215,6 +243,42 @@ class ResultAnalyzer:
       metric_df.to_csv(
           self.database, mode="a", encoding="utf-8", header=False, index=False)
 
+  def find_compile_regressions(self):
+    """Compares the compilation phases of the CSV report to the latest run of
+    the same configurations in the baseline CSV report or database.
+
+    Returns the rows of the phases slower than the baseline by more than the
+    regression threshold, as a fraction of the baseline time.
+    """
+
+    def load(path):
+      df = pd.read_csv(path)
+      df[CONFIG_COLUMNS] = df[CONFIG_COLUMNS].fillna("None").astype(str)
+      df = df[df["error_message"].isna()]
+      return df.sort_values("timestamp").groupby(CONFIG_COLUMNS).tail(1)
+
+    current = load(self.output_file)
+    baseline = load(os.path.abspath(self._args.baseline))
+    merged = current.merge(
+        baseline, on=CONFIG_COLUMNS, suffixes=("", "_baseline"))
+    regressions = []
+    for _, row in merged.iterrows():
+      for phase in COMPILE_PHASES:
+        time_s = row[phase]
+        baseline_s = row[f"{phase}_baseline"]
+        if pd.isna(time_s) or pd.isna(baseline_s) or baseline_s <= 0:
+          continue
+        change = (time_s - baseline_s) / baseline_s
+        if change > self._args.regression_threshold:
+          regressions.append({
+              **{column: row[column] for column in CONFIG_COLUMNS},
+              "phase": phase,
+              "baseline_time": baseline_s,
+              "time": time_s,
+              "change": change,
+          })
+    return pd.DataFrame(regressions)
+
   def run(self):
     if self._args.output_format == "jsonl":
       self.run_jsonl()
@@ -223,6 +287,18 @@ class ResultAnalyzer:
     else:
       raise ValueError(f"Unsupported output format: {self._args.output_format}")
 
+    if self._args.baseline:
+      if self._args.output_format != "csv":
+        raise ValueError("--baseline requires --output-format=csv")
+      regressions = self.find_compile_regressions()
+      if regressions.empty:
+        print("No compilation time regressions against the baseline")
+        return True
+      print("Compilation time regressions against the baseline:")
+      print(regressions.to_string(index=False))
+      return False
+    return True
+
 
 def parse_args(args=None):
   parser = argparse.ArgumentParser()
@@ -271,6 +347,21 @@ def parse_args(args=None):
       help="User provided timestamp used if the input data does not have it.",
   )
 
+  parser.add_argument(
+      "--baseline",
+      type=str,
+      help="""Path to the CSV report or database of a previous run, whose
+        compilation phase times are compared to the ones of this run.""",
+  )
+
+  parser.add_argument(
+      "--regression-threshold",
+      type=float,
+      default=0.1,
+      help="""Slowdown of a compilation phase over the baseline, as a fraction
+        of the baseline time, above which it is reported as a regression.""",
+  )
+
   parser.add_argument(
       "--hide-errors",
       default=False,
@@ -294,7 +385,8 @@ def main():
 
   logger.info(args)
   analyzer = ResultAnalyzer(args)
-  analyzer.run()
+  if not analyzer.run():
+    sys.exit(1)
 
 
 if __name__ == "__main__":
@@ -32,6 +32,18 @@ def us_to_s(us):
   return us * 1e-6
 
 
+def mean_confidence_interval(values, z=1.96):
+  """Returns the bounds of the confidence interval of the mean of `values`,
+  95% by default, from the normal approximation of its distribution."""
+  n = len(values)
+  mean = sum(values) / n
+  if n < 2:
+    return mean, mean
+  variance = sum((v - mean)**2 for v in values) / (n - 1)
+  half_width = z * (variance / n)**0.5
+  return mean - half_width, mean + half_width
+
+
 @functools.lru_cache(None)
 def patch_torch_manual_seed():
   """Make torch manual seed deterministic. Helps with accuracy testing."""
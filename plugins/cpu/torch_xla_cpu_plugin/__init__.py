@@ -1,13 +1,106 @@
+import glob
 import os
+from typing import List, Optional
+
 from torch_xla.experimental import plugins
 from torch_xla._internal import tpu
+import torch_xla.utils.utils as xu
+
+# Number of CPUs the intra-op thread pool of the client runs on.
+XLA_CPU_INTRA_OP_THREADS = 'XLA_CPU_INTRA_OP_THREADS'
+# NUMA node to pin the process to.
+XLA_CPU_NUMA_NODE = 'XLA_CPU_NUMA_NODE'
+# Whether to run one device per NUMA node, each in its own process.
+XLA_CPU_DEVICE_PER_NUMA_NODE = 'XLA_CPU_DEVICE_PER_NUMA_NODE'
+
+
+def _parse_cpu_list(cpu_list: str) -> List[int]:
+  """Parses a kernel CPU list, like `0-3,8-11`."""
+  cpus = []
+  for part in cpu_list.strip().split(','):
+    if not part:
+      continue
+    first, _, last = part.partition('-')
+    cpus.extend(range(int(first), int(last or first) + 1))
+  return cpus
+
+
+def numa_node_cpus() -> List[List[int]]:
+  """Returns the CPUs of every NUMA node of the host, out of sysfs.
+
+  Hosts without NUMA information are reported as a single node.
+  """
+  nodes = []
+  paths = glob.glob('/sys/devices/system/node/node[0-9]*/cpulist')
+  for path in sorted(
+      paths, key=lambda p: int(os.path.basename(os.path.dirname(p))[4:])):
+    with open(path) as f:
+      cpus = _parse_cpu_list(f.read())
+    if cpus:
+      nodes.append(cpus)
+  return nodes or [sorted(os.sched_getaffinity(0))]
 
 
 class CpuPlugin(plugins.DevicePlugin):
+  """PJRT CPU plugin, with control over the CPUs its client runs on.
+
+  The intra-op thread pool of the CPU client has a thread per CPU the process
+  may run on, so the options restrict the affinity of the process before the
+  client is created:
+    intra_op_threads: number of CPUs to run on, the first ones of the NUMA
+      node if any. Defaults to `XLA_CPU_INTRA_OP_THREADS`.
+    numa_node: NUMA node to run on, which keeps the memory traffic on one
+      socket. Defaults to `XLA_CPU_NUMA_NODE`.
+    device_per_numa_node: whether `xmp.spawn` runs a process per NUMA node,
+      each with a single device pinned to its node. Defaults to
+      `XLA_CPU_DEVICE_PER_NUMA_NODE`.
+  The client shares its intra-op pool among all its devices, which is why
+  the cores are partitioned across processes rather than devices.
+  """
+
+  def __init__(self,
+               intra_op_threads: Optional[int] = None,
+               numa_node: Optional[int] = None,
+               device_per_numa_node: Optional[bool] = None):
+    super().__init__()
+    self._intra_op_threads = (
+        intra_op_threads if intra_op_threads is not None else xu.getenv_as(
+            XLA_CPU_INTRA_OP_THREADS, int))
+    self._numa_node = (
+        numa_node
+        if numa_node is not None else xu.getenv_as(XLA_CPU_NUMA_NODE, int))
+    self._device_per_numa_node = (
+        device_per_numa_node if device_per_numa_node is not None else
+        xu.getenv_as(XLA_CPU_DEVICE_PER_NUMA_NODE, bool, False))
 
   def library_path(self) -> str:
     return os.path.join(
         os.path.dirname(__file__), 'lib', 'pjrt_c_api_cpu_plugin.so')
 
   def physical_chip_count(self) -> int:
-    return 1
+    return len(numa_node_cpus()) if self._device_per_numa_node else 1
+
+  def configure_multiprocess(self, local_rank, local_world_size):
+    if self._device_per_numa_node:
+      self._numa_node = local_rank % len(numa_node_cpus())
+
+  def client_create_options(self) -> dict:
+    self._pin_process()
+    return {}
+
+  def _pin_process(self):
+    if self._numa_node is None and self._intra_op_threads is None:
+      return
+    cpus = sorted(os.sched_getaffinity(0))
+    if self._numa_node is not None:
+      nodes = numa_node_cpus()
+      if self._numa_node >= len(nodes):
+        raise ValueError(f'NUMA node {self._numa_node} out of the '
+                         f'{len(nodes)} nodes of the host')
+      allowed = set(cpus)
+      cpus = [cpu for cpu in nodes[self._numa_node] if cpu in allowed]
+    if self._intra_op_threads is not None:
+      cpus = cpus[:max(self._intra_op_threads, 1)]
+    os.sched_setaffinity(0, cpus)
+    # The execution pool of torch_xla defaults to a thread per host CPU.
+    os.environ.setdefault('XLA_THREAD_POOL_SIZE', str(len(cpus)))
@@ -0,0 +1,305 @@
+// Measures the collectives of the runtime, outside of the lazy tensor stack.
+//
+// Every collective is compiled as a replicated computation over all the local
+// devices, and timed through ComputationClient::ExecuteReplicated. Message
+// sizes and replica group shapes are swept, and the results are reported the
+// way nccl-tests does: the algorithm bandwidth is the message size over the
+// time, and the bus bandwidth scales it by the fraction of the data each
+// replica moves across the links, so that it compares with the peak link
+// bandwidth whichever the collective and the group size.
+//
+// The sweep is configured with environment variables:
+//   BENCHMARK_MIN_BYTES: smallest message size, in bytes (default 8).
+//   BENCHMARK_MAX_BYTES: largest message size, in bytes (default 256MB).
+//   BENCHMARK_STEP_FACTOR: multiplier from one size to the next (default 2).
+//   BENCHMARK_WARMUP_ITERS: executions ahead of the timed ones (default 5).
+//   BENCHMARK_ITERS: timed executions per size (default 20).
+//   BENCHMARK_GROUP_SIZE: replicas per group, or 0 to sweep over all the
+//     group sizes dividing the number of devices (default 0).
+//   BENCHMARK_COLLECTIVES: comma separated subset of all_reduce, all_gather,
+//     reduce_scatter, all_to_all and collective_permute (default all).
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_split.h"
+#include "xla/hlo/builder/xla_builder.h"
+#include "xla/hlo/builder/xla_computation.h"
+#include "xla/hlo/ir/hlo_sharding.h"
+#include "xla/literal.h"
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tensor_source.h"
+#include "torch_xla/csrc/status.h"
+
+namespace torch_xla {
+namespace {
+
+using runtime::ComputationClient;
+
+enum class Collective {
+  kAllReduce,
+  kAllGather,
+  kReduceScatter,
+  kAllToAll,
+  kCollectivePermute,
+};
+
+struct CollectiveInfo {
+  Collective collective;
+  const char* name;
+};
+
+constexpr CollectiveInfo kCollectives[] = {
+    {Collective::kAllReduce, "all_reduce"},
+    {Collective::kAllGather, "all_gather"},
+    {Collective::kReduceScatter, "reduce_scatter"},
+    {Collective::kAllToAll, "all_to_all"},
+    {Collective::kCollectivePermute, "collective_permute"},
+};
+
+constexpr xla::PrimitiveType kElementType = xla::PrimitiveType::F32;
+
+// Number of elements of the message, rounded so that it splits evenly among
+// the replicas of a group.
+int64_t MessageElements(int64_t bytes, int64_t group_size) {
+  int64_t elements =
+      std::max<int64_t>(bytes / xla::ShapeUtil::ByteSizeOfPrimitiveType(
+                                    kElementType),
+                        1);
+  return (elements + group_size - 1) / group_size * group_size;
+}
+
+// Ratio of the bus bandwidth to the algorithm bandwidth, as in nccl-tests.
+double BusBandwidthFactor(Collective collective, int64_t group_size) {
+  double n = static_cast<double>(group_size);
+  switch (collective) {
+    case Collective::kAllReduce:
+      return 2.0 * (n - 1) / n;
+    case Collective::kAllGather:
+    case Collective::kReduceScatter:
+    case Collective::kAllToAll:
+      return (n - 1) / n;
+    case Collective::kCollectivePermute:
+      return 1.0;
+  }
+  return 1.0;
+}
+
+std::vector<xla::ReplicaGroup> MakeReplicaGroups(int64_t num_devices,
+                                                 int64_t group_size) {
+  std::vector<xla::ReplicaGroup> groups(num_devices / group_size);
+  for (int64_t i = 0; i < num_devices; ++i) {
+    groups[i / group_size].add_replica_ids(i);
+  }
+  return groups;
+}
+
+xla::XlaComputation CreateAddComputation() {
+  xla::XlaBuilder builder("AddComputation");
+  xla::Shape scalar_shape = xla::ShapeUtil::MakeShape(kElementType, {});
+  xla::XlaOp x = xla::Parameter(&builder, 0, scalar_shape, "x");
+  xla::XlaOp y = xla::Parameter(&builder, 1, scalar_shape, "y");
+  xla::Add(x, y);
+  XLA_ASSIGN_OR_THROW(xla::XlaComputation computation, builder.Build());
+  return computation;
+}
+
+// Returns the shape of the input each replica feeds to the collective. The
+// message size is the one of the larger of the input and output buffers, as
+// in nccl-tests, so all-gather takes a shard of it.
+xla::Shape InputShape(Collective collective, int64_t elements,
+                      int64_t group_size) {
+  if (collective == Collective::kAllGather) {
+    elements /= group_size;
+  }
+  return xla::ShapeUtil::MakeShape(kElementType, {elements});
+}
+
+xla::XlaComputation CreateCollectiveComputation(Collective collective,
+                                                const xla::Shape& shape,
+                                                int64_t num_devices,
+                                                int64_t group_size) {
+  xla::XlaBuilder builder("CollectiveBenchmark");
+  xla::XlaOp x = xla::Parameter(&builder, 0, shape, "x");
+  std::vector<xla::ReplicaGroup> groups =
+      MakeReplicaGroups(num_devices, group_size);
+  switch (collective) {
+    case Collective::kAllReduce:
+      xla::AllReduce(x, CreateAddComputation(), groups);
+      break;
+    case Collective::kAllGather:
+      xla::AllGather(x, /*all_gather_dimension=*/0, group_size, groups);
+      break;
+    case Collective::kReduceScatter:
+      xla::ReduceScatter(x, CreateAddComputation(), /*scatter_dimension=*/0,
+                         group_size, groups);
+      break;
+    case Collective::kAllToAll:
+      xla::AllToAll(x, /*split_dimension=*/0, /*concat_dimension=*/0,
+                    group_size, groups);
+      break;
+    case Collective::kCollectivePermute: {
+      // Every replica sends to the next one of its group, as in a ring.
+      std::vector<std::pair<int64_t, int64_t>> source_target_pairs;
+      for (int64_t i = 0; i < num_devices; ++i) {
+        int64_t base = i / group_size * group_size;
+        source_target_pairs.emplace_back(i,
+                                         base + (i - base + 1) % group_size);
+      }
+      xla::CollectivePermute(x, source_target_pairs);
+      break;
+    }
+  }
+  XLA_ASSIGN_OR_THROW(xla::XlaComputation computation, builder.Build());
+  return computation;
+}
+
+// Transfers a zeroed input to every device, and wraps the buffers as the
+// replicated argument ExecuteReplicated takes.
+ComputationClient::DataPtr CreateReplicatedArgument(
+    ComputationClient* client, const xla::Shape& shape,
+    const std::vector<std::string>& devices) {
+  std::vector<std::shared_ptr<const runtime::TensorSource>> sources;
+  for (const std::string& device : devices) {
+    sources.push_back(std::make_shared<runtime::LiteralSource>(
+        xla::Literal::CreateFromShape(shape), device));
+  }
+  std::vector<ComputationClient::DataPtr> shards =
+      client->TransferToDevice(sources);
+  return client->WrapDataShards(shards, devices.front(), shape,
+                                xla::HloSharding::Replicate().ToProto());
+}
+
+// Returns the average time of one execution, in microseconds.
+double TimeCollective(ComputationClient* client,
+                      const ComputationClient::Computation& computation,
+                      const ComputationClient::DataPtr& argument,
+                      const std::vector<std::string>& devices,
+                      int64_t warmup_iters, int64_t iters) {
+  ComputationClient::ExecuteReplicatedOptions options;
+  auto execute = [&]() {
+    XLA_ASSIGN_OR_THROW(
+        std::vector<ComputationClient::DataPtr> results,
+        client->ExecuteReplicated(computation, {argument}, devices, options));
+    return results;
+  };
+  for (int64_t i = 0; i < warmup_iters; ++i) {
+    execute();
+  }
+  client->WaitDeviceOps(devices);
+
+  int64_t start_ns = runtime::sys_util::NowNs();
+  for (int64_t i = 0; i < iters; ++i) {
+    execute();
+  }
+  client->WaitDeviceOps(devices);
+  int64_t elapsed_ns = runtime::sys_util::NowNs() - start_ns;
+  return static_cast<double>(elapsed_ns) / 1000.0 / std::max<int64_t>(iters, 1);
+}
+
+std::vector<int64_t> GetGroupSizes(int64_t num_devices) {
+  int64_t group_size =
+      runtime::sys_util::GetEnvInt("BENCHMARK_GROUP_SIZE", 0);
+  if (group_size > 0) {
+    XLA_CHECK_EQ(num_devices % group_size, 0)
+        << "BENCHMARK_GROUP_SIZE=" << group_size
+        << " must divide the number of devices " << num_devices;
+    return {group_size};
+  }
+  std::vector<int64_t> group_sizes;
+  for (int64_t size = num_devices; size > 1; --size) {
+    if (num_devices % size == 0) {
+      group_sizes.push_back(size);
+    }
+  }
+  return group_sizes;
+}
+
+std::vector<CollectiveInfo> GetCollectives() {
+  std::string names =
+      runtime::sys_util::GetEnvString("BENCHMARK_COLLECTIVES", "");
+  if (names.empty()) {
+    return {std::begin(kCollectives), std::end(kCollectives)};
+  }
+  std::vector<CollectiveInfo> collectives;
+  for (absl::string_view name : absl::StrSplit(names, ',')) {
+    auto it = std::find_if(
+        std::begin(kCollectives), std::end(kCollectives),
+        [&](const CollectiveInfo& info) { return name == info.name; });
+    XLA_CHECK(it != std::end(kCollectives)) << "Unknown collective: " << name;
+    collectives.push_back(*it);
+  }
+  return collectives;
+}
+
+void RunBenchmarks() {
+  XLA_ASSIGN_OR_THROW(ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  XLA_CHECK_EQ(client->GetNumProcesses(), 1)
+      << "The collective benchmark runs within a single process";
+  std::vector<std::string> devices = client->GetLocalDevices();
+  int64_t num_devices = devices.size();
+  XLA_CHECK_GT(num_devices, 1) << "Collectives need more than one device";
+
+  int64_t min_bytes = runtime::sys_util::GetEnvInt("BENCHMARK_MIN_BYTES", 8);
+  int64_t max_bytes =
+      runtime::sys_util::GetEnvInt("BENCHMARK_MAX_BYTES", 256 << 20);
+  int64_t step_factor =
+      std::max<int64_t>(runtime::sys_util::GetEnvInt("BENCHMARK_STEP_FACTOR",
+                                                     2),
+                        2);
+  int64_t warmup_iters =
+      runtime::sys_util::GetEnvInt("BENCHMARK_WARMUP_ITERS", 5);
+  int64_t iters = runtime::sys_util::GetEnvInt("BENCHMARK_ITERS", 20);
+
+  std::printf("# Devices: %ld, warmup iters: %ld, iters: %ld\n", num_devices,
+              warmup_iters, iters);
+  std::printf("%-20s %6s %14s %14s %12s %12s %12s\n", "# collective", "group",
+              "size (B)", "count (elems)", "time (us)", "algbw (GB/s)",
+              "busbw (GB/s)");
+  for (const CollectiveInfo& info : GetCollectives()) {
+    for (int64_t group_size : GetGroupSizes(num_devices)) {
+      for (int64_t bytes = min_bytes; bytes <= max_bytes;
+           bytes *= step_factor) {
+        int64_t elements = MessageElements(bytes, group_size);
+        int64_t message_bytes =
+            elements * xla::ShapeUtil::ByteSizeOfPrimitiveType(kElementType);
+        xla::Shape shape = InputShape(info.collective, elements, group_size);
+
+        std::vector<ComputationClient::CompileInstance> instances;
+        instances.emplace_back(
+            CreateCollectiveComputation(info.collective, shape, num_devices,
+                                        group_size),
+            devices.front(), devices, /*output_shape=*/nullptr);
+        std::vector<ComputationClient::ComputationPtr> computations =
+            client->Compile(std::move(instances));
+        ComputationClient::DataPtr argument =
+            CreateReplicatedArgument(client, shape, devices);
+
+        double time_us = TimeCollective(client, *computations.front(),
+                                        argument, devices, warmup_iters, iters);
+        double algbw = static_cast<double>(message_bytes) / time_us / 1.0e3;
+        double busbw = algbw * BusBandwidthFactor(info.collective, group_size);
+        std::printf("%-20s %6ld %14ld %14ld %12.2f %12.3f %12.3f\n", info.name,
+                    group_size, message_bytes, elements, time_us, algbw, busbw);
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace torch_xla
+
+int main(int argc, char* argv[]) {
+  torch_xla::RunBenchmarks();
+  return 0;
+}
@@ -0,0 +1,210 @@
+// Measures how the lowering and the compilation of a graph scale with its
+// size, to find the knees of their growth, like the wrapping of the
+// parameters into a tuple past the parameter wrapping threshold.
+//
+// For every parameter count of the sweep, a synthetic graph is traced and
+// synced once, which lowers and compiles it, as the graphs of the sweep all
+// differ. Node i of the graph computes
+//   (node[i - 1] + node[(i - 1) / fan_out]) * parameter[i % parameters]
+// so that every node is read by about fan_out + 1 others, and every parameter
+// is read once the graph has as many nodes. The parameters are tiled across
+// the devices when running in SPMD mode and BENCHMARK_SHARDED is set.
+//
+// The phases are read back from their timed metrics:
+//   LowerGraph: the lowering of the graph into an XLA computation.
+//   CompileTime: the compilation of the computation by the client.
+//   SyncTensorsGraph: the whole sync, including the execution.
+// along with whether the parameters were wrapped, and the growth of the host
+// resident memory across the sync.
+//
+// The benchmark is configured with environment variables:
+//   BENCHMARK_PARAMETERS: comma separated parameter counts of the sweep
+//     (default around the default wrapping threshold of 3200).
+//   BENCHMARK_NODES: nodes of the graph, or 0 for as many as parameters
+//     (default 0).
+//   BENCHMARK_FAN_OUT: see above (default 4).
+//   BENCHMARK_SHARDED: whether to tile the parameters in SPMD mode (default
+//     true).
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/strip.h"
+#include "xla/array2d.h"
+#include "xla/hlo/ir/hlo_sharding.h"
+
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/device.h"
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/metrics.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_methods.h"
+#include "torch_xla/csrc/tensor_util.h"
+#include "torch_xla/csrc/xla_graph_executor.h"
+
+namespace torch_xla {
+namespace {
+
+// Returns the accumulated time of a timed metric, in seconds.
+template <typename MetricData>
+double AccumulatedSeconds(MetricData* data) {
+  return data == nullptr ? 0.0 : data->Accumulator() / 1.0e9;
+}
+
+double LowerGraphSeconds() {
+  return AccumulatedSeconds(torch::lazy::GetMetric("LowerGraph"));
+}
+
+double CompileSeconds() {
+  return AccumulatedSeconds(runtime::metrics::GetMetric("CompileTime"));
+}
+
+int64_t WrappedGraphs() {
+  torch::lazy::CounterData* counter =
+      torch::lazy::GetCounter("ParameterWrappedGraphs");
+  return counter == nullptr ? 0 : counter->Value();
+}
+
+// Returns the resident memory of the process, in bytes, out of /proc.
+int64_t ResidentBytes() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    int64_t kilobytes = 0;
+    if (absl::StartsWith(line, "VmRSS:") &&
+        absl::SimpleAtoi(absl::StripAsciiWhitespace(absl::StripSuffix(
+                             line.substr(sizeof("VmRSS:") - 1), "kB")),
+                         &kilobytes)) {
+      return kilobytes * 1024;
+    }
+  }
+  return 0;
+}
+
+std::vector<int64_t> GetParameterCounts() {
+  std::string counts = runtime::sys_util::GetEnvString(
+      "BENCHMARK_PARAMETERS", "512,1024,2048,3072,3199,3200,4096,8192");
+  std::vector<int64_t> result;
+  for (absl::string_view count : absl::StrSplit(counts, ',')) {
+    int64_t value = 0;
+    XLA_CHECK(absl::SimpleAtoi(count, &value) && value > 0)
+        << "Invalid parameter count: " << count;
+    result.push_back(value);
+  }
+  return result;
+}
+
+// Creates the parameters, of `rows` rows so that the graphs of the sweep all
+// differ, tiled across `num_shards` devices if more than one.
+std::vector<XLATensorPtr> CreateParameters(
+    int64_t num_parameters, int64_t rows, int64_t num_shards,
+    const torch::lazy::BackendDevice& device) {
+  std::vector<at::Tensor> tensors;
+  for (int64_t i = 0; i < num_parameters; ++i) {
+    tensors.push_back(
+        at::rand({rows * num_shards, 8}, at::TensorOptions(at::kFloat)));
+  }
+  std::vector<std::string> devices(tensors.size(), device.toString());
+  std::vector<XLATensor::ShardingSpecPtr> shardings;
+  if (num_shards > 1) {
+    xla::Array2D<int64_t> mesh(num_shards, 1);
+    mesh.FillIota(0);
+    xla::OpSharding sharding = xla::HloSharding::Tile(mesh).ToProto();
+    for (const at::Tensor& tensor : tensors) {
+      shardings.push_back(std::make_shared<XLATensor::ShardingSpec>(
+          sharding, CreateComputationShapeFromTensor(tensor, &device)));
+    }
+  }
+  std::vector<torch::lazy::BackendDataPtr> data =
+      shardings.empty() ? CreateTensorsData(tensors, devices)
+                        : CreateTensorsData(tensors, shardings, devices);
+  std::vector<XLATensorPtr> parameters;
+  for (size_t i = 0; i < data.size(); ++i) {
+    parameters.push_back(XLATensor::Create(std::move(data[i])));
+    if (!shardings.empty()) {
+      parameters.back()->SetShardingSpec(*shardings[i]);
+    }
+  }
+  return parameters;
+}
+
+XLATensorPtr TraceGraph(const std::vector<XLATensorPtr>& parameters,
+                        int64_t num_nodes, int64_t fan_out) {
+  std::vector<XLATensorPtr> nodes = {parameters.front()};
+  for (int64_t i = 1; i <= num_nodes; ++i) {
+    XLATensorPtr sum = tensor_methods::add(
+        nodes[i - 1], nodes[(i - 1) / fan_out], /*alpha=*/1);
+    nodes.push_back(
+        tensor_methods::mul(sum, parameters[i % parameters.size()]));
+  }
+  return nodes.back();
+}
+
+void RunBenchmarks() {
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  XLA_ASSIGN_OR_THROW(torch::lazy::BackendDevice * absl_nonnull const device,
+                      bridge::GetDefaultDevice());
+  int64_t num_nodes = runtime::sys_util::GetEnvInt("BENCHMARK_NODES", 0);
+  int64_t fan_out =
+      std::max<int64_t>(runtime::sys_util::GetEnvInt("BENCHMARK_FAN_OUT", 4),
+                        1);
+  int64_t num_shards =
+      UseVirtualDevice() &&
+              runtime::sys_util::GetEnvBool("BENCHMARK_SHARDED", true)
+          ? client->GetLocalDevices().size()
+          : 1;
+
+  XLAGraphExecutor* executor = XLAGraphExecutor::Get();
+  const std::vector<std::string> devices = {device->toString()};
+  std::printf("# Device: %s, shards: %ld, fan out: %ld\n",
+              device->toString().c_str(), num_shards, fan_out);
+  std::printf("%-12s %10s %8s %12s %12s %12s %14s\n", "# parameters", "nodes",
+              "wrapped", "lower (s)", "compile (s)", "sync (s)", "rss +(MB)");
+  std::vector<int64_t> parameter_counts = GetParameterCounts();
+  for (size_t p = 0; p < parameter_counts.size(); ++p) {
+    int64_t num_parameters = parameter_counts[p];
+    std::vector<XLATensorPtr> parameters = CreateParameters(
+        num_parameters, /*rows=*/p + 1, num_shards, *device);
+    int64_t graph_nodes = num_nodes > 0 ? num_nodes : num_parameters;
+    std::vector<XLATensorPtr> tensors = {
+        TraceGraph(parameters, graph_nodes, fan_out)};
+
+    double lower_s = LowerGraphSeconds();
+    double compile_s = CompileSeconds();
+    int64_t wrapped = WrappedGraphs();
+    int64_t resident_bytes = ResidentBytes();
+    int64_t start_ns = runtime::sys_util::NowNs();
+    executor->SyncTensorsGraph(&tensors, devices, /*wait=*/true,
+                               /*sync_ltc_data=*/true);
+    double sync_s = (runtime::sys_util::NowNs() - start_ns) / 1.0e9;
+    std::printf("%-12ld %10ld %8s %12.3f %12.3f %12.3f %14.1f\n",
+                num_parameters, graph_nodes,
+                WrappedGraphs() > wrapped ? "yes" : "no",
+                LowerGraphSeconds() - lower_s, CompileSeconds() - compile_s,
+                sync_s, (ResidentBytes() - resident_bytes) / 1.0e6);
+  }
+}
+
+}  // namespace
+}  // namespace torch_xla
+
+int main(int argc, char* argv[]) {
+  torch_xla::RunBenchmarks();
+  return 0;
+}
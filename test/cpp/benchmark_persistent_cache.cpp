@@ -0,0 +1,215 @@
+// Measures the loads of a persistent compilation cache by a cold process, as a
+// restarted training or serving job does them: the time to the first
+// execution, and to the lookup of every entry, with serial lookups or with
+// the entries prefetched on a background thread, as XLA_PERSISTENT_CACHE does.
+//
+// The benchmark runs in two steps, in separate processes, so that the loads
+// do not find the executables in memory:
+//   BENCHMARK_MODE=fill: compiles BENCHMARK_ENTRIES computations and stores
+//     them in the cache, through the serialization and the encoding of the
+//     persistent cache of the graph executor.
+//   BENCHMARK_MODE=load: looks all the entries up, in the order they were
+//     stored, and executes the first one.
+// Dropping the page cache between the two, e.g. with
+//   sync && echo 3 > /proc/sys/vm/drop_caches
+// makes the loads read the storage, which is what tells local SSDs from
+// network filesystems apart.
+//
+// The benchmark is configured with environment variables:
+//   BENCHMARK_MODE: fill or load (default load).
+//   BENCHMARK_CACHE_DIR: directory of the cache, on the storage to measure.
+//   BENCHMARK_ENTRIES: computations of the cache (default 100).
+//   BENCHMARK_OPS: operations of every computation, which sets the size of
+//     the executables (default 1000).
+//   BENCHMARK_PREFETCH: whether the load prefetches the entries (default
+//     false).
+//   XLA_PERSISTENT_CACHE_COMPRESSION, XLA_PERSISTENT_CACHE_COMPRESSION_LEVEL:
+//     the codec of the entries written by the fill, as for the graph executor.
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "xla/hlo/builder/xla_builder.h"
+#include "xla/hlo/builder/xla_computation.h"
+#include "xla/literal.h"
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/runtime/cache.h"
+#include "torch_xla/csrc/runtime/cache_codec.h"
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tensor_source.h"
+#include "torch_xla/csrc/status.h"
+
+namespace torch_xla {
+namespace {
+
+using runtime::ComputationClient;
+using Cache =
+    runtime::util::PersistentCache<int64_t, ComputationClient::Computation>;
+
+constexpr int64_t kElements = 1024;
+
+double ElapsedMs(int64_t start_ns) {
+  return (runtime::sys_util::NowNs() - start_ns) / 1.0e6;
+}
+
+std::unique_ptr<Cache> CreateCache(ComputationClient* client,
+                                   const std::string& cache_dir,
+                                   int64_t num_entries) {
+  XLA_ASSIGN_OR_THROW(
+      runtime::util::CacheCodec codec,
+      runtime::util::ParseCacheCodec(runtime::sys_util::GetEnvString(
+          "XLA_PERSISTENT_CACHE_COMPRESSION", "none")));
+  int level = runtime::sys_util::GetEnvInt(
+      "XLA_PERSISTENT_CACHE_COMPRESSION_LEVEL", 1);
+  auto serialize = [client, codec, level](
+                       const ComputationClient::ComputationPtr& computation) {
+    return runtime::util::EncodeCacheEntry(
+        client->SerializeComputation(computation), codec, level);
+  };
+  auto deserialize = [client](std::string serialization) {
+    XLA_ASSIGN_OR_THROW(
+        std::string decoded,
+        runtime::util::DecodeCacheEntry(std::move(serialization)));
+    return client->DeserializeComputation(decoded);
+  };
+  return std::make_unique<Cache>(num_entries, cache_dir,
+                                 /*readonly_storage=*/false, serialize,
+                                 deserialize);
+}
+
+xla::Shape ArgumentShape() {
+  return xla::ShapeUtil::MakeShape(xla::PrimitiveType::F32, {kElements});
+}
+
+// A chain of `num_ops` multiply-adds, whose constants make every `index`
+// yield a different computation.
+xla::XlaComputation CreateComputation(int64_t index, int64_t num_ops) {
+  xla::XlaBuilder builder("PersistentCacheBenchmark");
+  xla::XlaOp x = xla::Parameter(&builder, 0, ArgumentShape(), "x");
+  for (int64_t i = 0; i < num_ops; ++i) {
+    x = xla::Add(xla::Mul(x, xla::ConstantR0<float>(&builder, 1.0f + i)),
+                 xla::ConstantR0<float>(&builder, static_cast<float>(index)));
+    x = xla::Tanh(x);
+  }
+  XLA_ASSIGN_OR_THROW(xla::XlaComputation computation, builder.Build());
+  return computation;
+}
+
+void Fill(ComputationClient* client, Cache* cache, int64_t num_entries) {
+  int64_t num_ops = runtime::sys_util::GetEnvInt("BENCHMARK_OPS", 1000);
+  std::string device = client->GetDefaultDevice();
+  int64_t start_ns = runtime::sys_util::NowNs();
+  for (int64_t i = 0; i < num_entries; ++i) {
+    std::vector<ComputationClient::CompileInstance> instances;
+    instances.emplace_back(CreateComputation(i, num_ops), device,
+                           client->GetCompilationDevices(device, {}),
+                           /*output_shape=*/nullptr);
+    cache->Add(i, std::move(client->Compile(std::move(instances)).front()));
+  }
+  int64_t stored_bytes = 0;
+  for (const auto& [name, entry] : cache->ListStoredEntries()) {
+    stored_bytes += entry.size_bytes;
+  }
+  std::printf("# Filled %ld entries of %ld ops, %.1f MB, in %.1f ms\n",
+              num_entries, num_ops, stored_bytes / 1.0e6, ElapsedMs(start_ns));
+}
+
+void Load(ComputationClient* client, Cache* cache, int64_t num_entries,
+          int64_t process_start_ns, int64_t cache_start_ns) {
+  bool prefetch = runtime::sys_util::GetEnvBool("BENCHMARK_PREFETCH", false);
+  int64_t stored_bytes = 0;
+  for (const auto& [name, entry] : cache->ListStoredEntries()) {
+    stored_bytes += entry.size_bytes;
+  }
+  std::thread prefetcher;
+  if (prefetch) {
+    std::vector<std::string> names;
+    for (int64_t i = 0; i < num_entries; ++i) {
+      names.push_back(std::to_string(i));
+    }
+    prefetcher = std::thread(
+        [cache, names = std::move(names)]() { cache->Prefetch(names); });
+  }
+
+  std::vector<double> lookup_ms;
+  double first_execution_ms = 0.0;
+  int64_t lookups_start_ns = runtime::sys_util::NowNs();
+  for (int64_t i = 0; i < num_entries; ++i) {
+    int64_t start_ns = runtime::sys_util::NowNs();
+    ComputationClient::ComputationPtr computation = cache->Get(i);
+    lookup_ms.push_back(ElapsedMs(start_ns));
+    XLA_CHECK(computation != nullptr) << "Missing cache entry " << i;
+    if (i == 0) {
+      std::string device = client->GetDefaultDevice();
+      std::vector<std::shared_ptr<const runtime::TensorSource>> sources = {
+          std::make_shared<runtime::LiteralSource>(
+              xla::Literal::CreateFromShape(ArgumentShape()), device)};
+      std::vector<ComputationClient::DataPtr> arguments =
+          client->TransferToDevice(sources);
+      XLA_ASSIGN_OR_THROW(
+          std::vector<ComputationClient::DataPtr> results,
+          client->ExecuteComputation(*computation, arguments, device));
+      XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> literals,
+                          client->TransferFromDevice(results));
+      first_execution_ms = ElapsedMs(process_start_ns);
+    }
+  }
+  double lookups_ms = ElapsedMs(lookups_start_ns);
+  if (prefetcher.joinable()) {
+    prefetcher.join();
+  }
+
+  std::vector<double> sorted_ms = lookup_ms;
+  std::sort(sorted_ms.begin(), sorted_ms.end());
+  std::printf("# Entries: %ld, %.1f MB, prefetch: %s\n", num_entries,
+              stored_bytes / 1.0e6, prefetch ? "true" : "false");
+  std::printf("%-32s %12.2f\n", "client and cache init (ms)",
+              (cache_start_ns - process_start_ns) / 1.0e6);
+  std::printf("%-32s %12.2f\n", "first execution (ms)", first_execution_ms);
+  std::printf("%-32s %12.2f\n", "first lookup (ms)", lookup_ms.front());
+  std::printf("%-32s %12.2f\n", "lookup p50 (ms)",
+              sorted_ms[sorted_ms.size() / 2]);
+  std::printf("%-32s %12.2f\n", "lookup max (ms)", sorted_ms.back());
+  std::printf("%-32s %12.2f\n", "all lookups (ms)", lookups_ms);
+  std::printf("%-32s %12.2f\n", "load throughput (MB/s)",
+              stored_bytes / 1.0e3 / std::max(lookups_ms, 1e-3));
+}
+
+void RunBenchmark() {
+  int64_t process_start_ns = runtime::sys_util::NowNs();
+  std::string mode = runtime::sys_util::GetEnvString("BENCHMARK_MODE", "load");
+  std::string cache_dir =
+      runtime::sys_util::GetEnvString("BENCHMARK_CACHE_DIR", "");
+  XLA_CHECK(!cache_dir.empty()) << "BENCHMARK_CACHE_DIR is not set";
+  int64_t num_entries =
+      std::max<int64_t>(runtime::sys_util::GetEnvInt("BENCHMARK_ENTRIES", 100),
+                        1);
+
+  XLA_ASSIGN_OR_THROW(ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  std::unique_ptr<Cache> cache = CreateCache(client, cache_dir, num_entries);
+  int64_t cache_start_ns = runtime::sys_util::NowNs();
+  if (mode == "fill") {
+    Fill(client, cache.get(), num_entries);
+  } else {
+    XLA_CHECK_EQ(mode, "load") << "Unknown BENCHMARK_MODE";
+    Load(client, cache.get(), num_entries, process_start_ns, cache_start_ns);
+  }
+}
+
+}  // namespace
+}  // namespace torch_xla
+
+int main(int argc, char* argv[]) {
+  torch_xla::RunBenchmark();
+  return 0;
+}
@@ -0,0 +1,203 @@
+// Measures the host paths of the SPMD sharded data, which the loads and saves
+// of the sharded checkpoints go through:
+//   shard: ShardingUtil::ShardTensor, the split of a CPU tensor into the
+//     padded shards of every local device.
+//   upload: ShardingUtil::CreateShardedData, the transfer of the shards, until
+//     the device buffers are ready.
+//   gather: the transfer of the sharded data back to the host as a single
+//     literal, which replicates it on the devices first.
+// Every phase is reported as its average time over the timed iterations, and
+// in GB/s of the global tensor.
+//
+// The meshes are swept over the local devices:
+//   1d: the rows tiled across all the devices.
+//   2d: the rows and the columns tiled across a 2D mesh of the devices.
+//   partial: the rows tiled across half of the devices, and replicated twice.
+//   replicated: the whole tensor on every device.
+// and every size is run with even dimensions, and with uneven ones, which the
+// shards are padded for.
+//
+// The benchmark runs in SPMD mode, e.g. with XLA_USE_SPMD=1, and is configured
+// with environment variables:
+//   BENCHMARK_MIN_BYTES: smallest f32 tensor size, in bytes (default 1MB).
+//   BENCHMARK_MAX_BYTES: largest f32 tensor size, in bytes (default 256MB).
+//   BENCHMARK_STEP_FACTOR: multiplier from one size to the next (default 4).
+//   BENCHMARK_WARMUP_ITERS: iterations ahead of the timed ones (default 2).
+//   BENCHMARK_ITERS: timed iterations per size (default 10).
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ATen/ATen.h>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "xla/array2d.h"
+#include "xla/hlo/ir/hlo_sharding.h"
+#include "xla/literal.h"
+
+#include "torch_xla/csrc/device.h"
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_util.h"
+#include "torch_xla/csrc/xla_sharding_util.h"
+
+namespace torch_xla {
+namespace {
+
+using runtime::ComputationClient;
+
+struct Mesh {
+  std::string name;
+  xla::OpSharding sharding;
+};
+
+// Summed over the timed iterations, in microseconds.
+struct PhaseTimes {
+  double shard = 0.0;
+  double upload = 0.0;
+  double gather = 0.0;
+};
+
+double ElapsedUs(int64_t start_ns) {
+  return (runtime::sys_util::NowNs() - start_ns) / 1000.0;
+}
+
+std::vector<Mesh> GetMeshes(int64_t num_devices) {
+  std::vector<Mesh> meshes;
+  xla::Array2D<int64_t> mesh_1d(num_devices, 1);
+  mesh_1d.FillIota(0);
+  meshes.push_back({"1d", xla::HloSharding::Tile(mesh_1d).ToProto()});
+  // The most square 2D mesh of the devices.
+  int64_t rows = static_cast<int64_t>(std::sqrt(num_devices));
+  while (num_devices % rows != 0) {
+    --rows;
+  }
+  if (rows > 1) {
+    xla::Array2D<int64_t> mesh_2d(rows, num_devices / rows);
+    mesh_2d.FillIota(0);
+    meshes.push_back({"2d", xla::HloSharding::Tile(mesh_2d).ToProto()});
+  }
+  if (num_devices % 2 == 0) {
+    xla::TileAssignment tiles({num_devices / 2, 1, 2});
+    meshes.push_back(
+        {"partial", xla::HloSharding::PartialTile(tiles).ToProto()});
+  }
+  meshes.push_back({"replicated", xla::HloSharding::Replicate().ToProto()});
+  return meshes;
+}
+
+void WaitReady(ComputationClient* client,
+               const ComputationClient::DataPtr& handle) {
+  std::vector<ComputationClient::DataPtr> shards =
+      client->GetDataShards(handle);
+  absl::BlockingCounter counter(shards.size());
+  for (const ComputationClient::DataPtr& shard : shards) {
+    client->OnReadyCallback(shard, [&counter]() { counter.DecrementCount(); });
+  }
+  counter.Wait();
+}
+
+void RunIteration(ComputationClient* client, const at::Tensor& tensor,
+                  const XLATensor::ShardingSpecPtr& sharding,
+                  const std::vector<std::string>& devices, PhaseTimes* times) {
+  int64_t start_ns = runtime::sys_util::NowNs();
+  std::vector<at::Tensor> shards = ShardingUtil::ShardTensor(
+      tensor, sharding, devices, /*padded=*/true);
+  times->shard += ElapsedUs(start_ns);
+
+  start_ns = runtime::sys_util::NowNs();
+  ComputationClient::DataPtr handle =
+      ShardingUtil::CreateShardedData(shards, devices, sharding);
+  WaitReady(client, handle);
+  times->upload += ElapsedUs(start_ns);
+
+  start_ns = runtime::sys_util::NowNs();
+  XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> literals,
+                      client->TransferFromDevice({handle}));
+  times->gather += ElapsedUs(start_ns);
+  XLA_CHECK_EQ(literals.front().element_count(), tensor.numel());
+}
+
+void RunBenchmarks() {
+  XLA_CHECK(UseVirtualDevice()) << "The benchmark runs in SPMD mode";
+  XLA_ASSIGN_OR_THROW(ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  std::vector<std::string> devices = client->GetLocalDevices();
+  int64_t num_devices = devices.size();
+  torch::lazy::BackendDevice virtual_device = GetVirtualDevice();
+
+  int64_t min_bytes =
+      runtime::sys_util::GetEnvInt("BENCHMARK_MIN_BYTES", 1 << 20);
+  int64_t max_bytes =
+      runtime::sys_util::GetEnvInt("BENCHMARK_MAX_BYTES", 256 << 20);
+  int64_t step_factor =
+      std::max<int64_t>(runtime::sys_util::GetEnvInt("BENCHMARK_STEP_FACTOR",
+                                                     4),
+                        2);
+  int64_t warmup_iters =
+      runtime::sys_util::GetEnvInt("BENCHMARK_WARMUP_ITERS", 2);
+  int64_t iters = std::max<int64_t>(
+      runtime::sys_util::GetEnvInt("BENCHMARK_ITERS", 10), 1);
+
+  std::printf("# Devices: %ld, warmup iters: %ld, iters: %ld\n", num_devices,
+              warmup_iters, iters);
+  std::printf("%-12s %8s %16s %12s %12s %12s %10s %10s %10s\n", "# mesh",
+              "uneven", "shape", "shard (us)", "upload (us)", "gather (us)",
+              "shard GB/s", "upload GB/s", "gather GB/s");
+  for (const Mesh& mesh : GetMeshes(num_devices)) {
+    for (int64_t bytes = min_bytes; bytes <= max_bytes; bytes *= step_factor) {
+      for (bool uneven : {false, true}) {
+        // Rounded so that the even dimensions split among all the devices.
+        int64_t cols = num_devices * 64;
+        int64_t rows = std::max<int64_t>(bytes / 4 / cols, 1);
+        rows = (rows + num_devices - 1) / num_devices * num_devices;
+        if (uneven) {
+          ++rows;
+          ++cols;
+        }
+        at::Tensor tensor =
+            at::rand({rows, cols}, at::TensorOptions(at::kFloat));
+        auto sharding = std::make_shared<XLATensor::ShardingSpec>(
+            mesh.sharding,
+            CreateComputationShapeFromTensor(tensor, &virtual_device));
+
+        PhaseTimes warmup_times;
+        for (int64_t i = 0; i < warmup_iters; ++i) {
+          RunIteration(client, tensor, sharding, devices, &warmup_times);
+        }
+        PhaseTimes times;
+        for (int64_t i = 0; i < iters; ++i) {
+          RunIteration(client, tensor, sharding, devices, &times);
+        }
+        // Bytes per microsecond, scaled to GB/s.
+        auto bandwidth = [&](double time_us) {
+          return static_cast<double>(tensor.nbytes()) * iters /
+                 std::max(time_us, 1.0) / 1.0e3;
+        };
+        std::string shape = std::to_string(rows) + "x" + std::to_string(cols);
+        std::printf(
+            "%-12s %8s %16s %12.1f %12.1f %12.1f %10.3f %10.3f %10.3f\n",
+            mesh.name.c_str(), uneven ? "yes" : "no", shape.c_str(),
+            times.shard / iters, times.upload / iters, times.gather / iters,
+            bandwidth(times.shard), bandwidth(times.upload),
+            bandwidth(times.gather));
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace torch_xla
+
+int main(int argc, char* argv[]) {
+  torch_xla::RunBenchmarks();
+  return 0;
+}
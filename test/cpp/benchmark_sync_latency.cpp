@@ -0,0 +1,202 @@
+// Measures the host latency of SyncTensorsGraph on a computation cache hit,
+// from the call to the enqueue of the execution, which bounds the step rate
+// of serving loops.
+//
+// A stack of dense layers is traced, synced once to compile it, and then
+// traced and synced again for every iteration. The device is waited for
+// between the iterations, outside of the timed sections, so that the host
+// never waits on a previous execution. The total latency is timed around
+// SyncTensorsGraph, and the latency of every phase is read back from its
+// timed metric:
+//   CollectSyncTensors: the collection of the tensors to sync.
+//   ExtractIRAndPrepareXlaData: the output placeholders of the tensors.
+//   RunPostOrder: the walk of the graph and the binding of its arguments.
+//   FinalizeGraphHash: the hash of the graph.
+//   LookupCachedCompile: the computation cache lookup.
+//   ScheduleSyncTensorsGraph: the scheduling of the execution.
+//
+// The benchmark is configured with environment variables:
+//   BENCHMARK_LAYERS: dense layers of the graph (default 100).
+//   BENCHMARK_WARMUP_ITERS: syncs ahead of the timed ones (default 10).
+//   BENCHMARK_ITERS: timed syncs (default 1000).
+//   BENCHMARK_JSON_OUTPUT: file the percentiles are also written to, as JSON,
+//     for regression gates (default none).
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_methods.h"
+#include "torch_xla/csrc/xla_graph_executor.h"
+
+namespace torch_xla {
+namespace {
+
+constexpr const char* kPhases[] = {
+    "CollectSyncTensors",  "ExtractIRAndPrepareXlaData",
+    "RunPostOrder",        "FinalizeGraphHash",
+    "LookupCachedCompile", "ScheduleSyncTensorsGraph",
+};
+
+constexpr const char* kTotal = "SyncTensorsGraph";
+
+struct Percentiles {
+  double p50 = 0.0;
+  double p99 = 0.0;
+  double mean = 0.0;
+};
+
+Percentiles ComputePercentiles(std::vector<double> samples) {
+  Percentiles result;
+  if (samples.empty()) {
+    return result;
+  }
+  std::sort(samples.begin(), samples.end());
+  auto at = [&](double quantile) {
+    size_t index = static_cast<size_t>(quantile * (samples.size() - 1));
+    return samples[index];
+  };
+  result.p50 = at(0.50);
+  result.p99 = at(0.99);
+  for (double sample : samples) {
+    result.mean += sample;
+  }
+  result.mean /= samples.size();
+  return result;
+}
+
+// Returns the latest sample of the timed metric `name`, in microseconds, if
+// it got one since it had `*num_samples`, which is then updated.
+std::optional<double> GetNewSample(const char* name, size_t* num_samples) {
+  torch::lazy::MetricData* data = torch::lazy::GetMetric(name);
+  if (data == nullptr) {
+    return std::nullopt;
+  }
+  double accumulator = 0.0;
+  size_t total_samples = 0;
+  std::vector<torch::lazy::Sample> samples =
+      data->Samples(&accumulator, &total_samples);
+  if (total_samples == *num_samples || samples.empty()) {
+    return std::nullopt;
+  }
+  *num_samples = total_samples;
+  return samples.back().value / 1000.0;
+}
+
+XLATensorPtr CreateTensor(at::IntArrayRef sizes,
+                          const torch::lazy::BackendDevice& device) {
+  XLA_ASSIGN_OR_THROW(
+      XLATensorPtr tensor,
+      XLATensor::Create(at::rand(sizes, at::TensorOptions(at::kFloat)),
+                        device));
+  return tensor;
+}
+
+void RunBenchmark() {
+  XLA_ASSIGN_OR_THROW(torch::lazy::BackendDevice * absl_nonnull const device,
+                      bridge::GetDefaultDevice());
+  int64_t num_layers = runtime::sys_util::GetEnvInt("BENCHMARK_LAYERS", 100);
+  int64_t warmup_iters =
+      runtime::sys_util::GetEnvInt("BENCHMARK_WARMUP_ITERS", 10);
+  int64_t iters = runtime::sys_util::GetEnvInt("BENCHMARK_ITERS", 1000);
+  std::string json_output =
+      runtime::sys_util::GetEnvString("BENCHMARK_JSON_OUTPUT", "");
+
+  XLATensorPtr input = CreateTensor({16, 64}, *device);
+  std::vector<XLATensorPtr> weights;
+  std::vector<XLATensorPtr> biases;
+  for (int64_t i = 0; i < num_layers; ++i) {
+    weights.push_back(CreateTensor({64, 64}, *device));
+    biases.push_back(CreateTensor({64}, *device));
+  }
+  auto trace = [&]() {
+    XLATensorPtr x = input;
+    for (int64_t i = 0; i < num_layers; ++i) {
+      x = tensor_methods::add(tensor_methods::matmul(x, weights[i]),
+                              biases[i], /*alpha=*/1);
+    }
+    return std::vector<XLATensorPtr>{x};
+  };
+
+  XLAGraphExecutor* executor = XLAGraphExecutor::Get();
+  const std::vector<std::string> devices = {device->toString()};
+  auto sync = [&](std::vector<XLATensorPtr>* tensors) {
+    executor->SyncTensorsGraph(tensors, devices, /*wait=*/false,
+                               /*sync_ltc_data=*/true);
+  };
+  for (int64_t i = 0; i < warmup_iters; ++i) {
+    std::vector<XLATensorPtr> tensors = trace();
+    sync(&tensors);
+    executor->WaitDeviceOps(devices);
+  }
+
+  constexpr size_t kNumPhases = std::size(kPhases);
+  std::vector<size_t> num_samples(kNumPhases, 0);
+  for (size_t p = 0; p < kNumPhases; ++p) {
+    GetNewSample(kPhases[p], &num_samples[p]);
+  }
+  std::vector<std::vector<double>> phase_samples(kNumPhases);
+  std::vector<double> total_samples;
+  for (int64_t i = 0; i < iters; ++i) {
+    std::vector<XLATensorPtr> tensors = trace();
+    int64_t start_ns = runtime::sys_util::NowNs();
+    sync(&tensors);
+    int64_t elapsed_ns = runtime::sys_util::NowNs() - start_ns;
+    total_samples.push_back(elapsed_ns / 1000.0);
+    executor->WaitDeviceOps(devices);
+    for (size_t p = 0; p < kNumPhases; ++p) {
+      std::optional<double> sample = GetNewSample(kPhases[p], &num_samples[p]);
+      if (sample) {
+        phase_samples[p].push_back(*sample);
+      }
+    }
+  }
+
+  std::printf("# Device: %s, layers: %ld, iters: %ld\n",
+              device->toString().c_str(), num_layers, iters);
+  std::printf("%-28s %10s %12s %12s %12s\n", "# phase", "samples", "p50 (us)",
+              "p99 (us)", "mean (us)");
+  std::vector<std::string> json_entries;
+  auto report = [&](const char* name, const std::vector<double>& samples) {
+    Percentiles percentiles = ComputePercentiles(samples);
+    std::printf("%-28s %10zu %12.2f %12.2f %12.2f\n", name, samples.size(),
+                percentiles.p50, percentiles.p99, percentiles.mean);
+    json_entries.push_back(absl::StrCat(
+        "\"", name, "\": {\"samples\": ", samples.size(),
+        ", \"p50_us\": ", percentiles.p50, ", \"p99_us\": ", percentiles.p99,
+        ", \"mean_us\": ", percentiles.mean, "}"));
+  };
+  for (size_t p = 0; p < kNumPhases; ++p) {
+    report(kPhases[p], phase_samples[p]);
+  }
+  report(kTotal, total_samples);
+
+  if (!json_output.empty()) {
+    std::ofstream out(json_output);
+    XLA_CHECK(out) << "Failed to open " << json_output;
+    out << "{" << absl::StrJoin(json_entries, ", ") << "}\n";
+  }
+}
+
+}  // namespace
+}  // namespace torch_xla
+
+int main(int argc, char* argv[]) {
+  torch_xla::RunBenchmark();
+  return 0;
+}
@@ -0,0 +1,161 @@
+// Measures the tracing hot path of the lazy tensor stack: the time it takes
+// to build the IR of representative ops through tensor_methods, to create the
+// IR values of scalars, and to hash and walk large graphs. Nothing is compiled
+// nor executed, besides the uploads of the inputs.
+//
+// The suite runs on Google Benchmark, and takes its flags, e.g.:
+//   benchmark_tracing --benchmark_filter=BM_Add
+//   benchmark_tracing --benchmark_out=tracing.json --benchmark_out_format=json
+// the latter of which writes the results as JSON for regression tracking.
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <torch/csrc/lazy/core/ir_util.h>
+
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_methods.h"
+#include "torch_xla/csrc/xla_graph_executor.h"
+
+namespace torch_xla {
+namespace {
+
+const torch::lazy::BackendDevice& GetDevice() {
+  static const torch::lazy::BackendDevice device = []() {
+    XLA_ASSIGN_OR_THROW(torch::lazy::BackendDevice * absl_nonnull const device,
+                        bridge::GetDefaultDevice());
+    return *device;
+  }();
+  return device;
+}
+
+XLATensorPtr CreateTensor(const at::Tensor& tensor) {
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_tensor,
+                      XLATensor::Create(tensor, GetDevice()));
+  return xla_tensor;
+}
+
+XLATensorPtr CreateTensor(at::IntArrayRef sizes) {
+  return CreateTensor(at::rand(sizes, at::TensorOptions(at::kFloat)));
+}
+
+// Builds `num_chains` independent chains of additions, of about
+// `num_nodes / num_chains` nodes each, and returns their ends. The chains
+// bound the depth of the graph, which is destroyed recursively.
+std::vector<XLATensorPtr> CreateGraph(int64_t num_nodes, int64_t num_chains) {
+  XLATensorPtr input = CreateTensor({8});
+  std::vector<XLATensorPtr> roots(num_chains, input);
+  for (int64_t i = 0; i < num_nodes; ++i) {
+    XLATensorPtr& root = roots[i % num_chains];
+    root = tensor_methods::add(root, input, /*alpha=*/1);
+  }
+  return roots;
+}
+
+void BM_Add(benchmark::State& state) {
+  XLATensorPtr a = CreateTensor({128, 128});
+  XLATensorPtr b = CreateTensor({128, 128});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tensor_methods::add(a, b, /*alpha=*/1));
+  }
+}
+BENCHMARK(BM_Add);
+
+void BM_Matmul(benchmark::State& state) {
+  XLATensorPtr a = CreateTensor({128, 256});
+  XLATensorPtr b = CreateTensor({256, 64});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tensor_methods::matmul(a, b));
+  }
+}
+BENCHMARK(BM_Matmul);
+
+// A chain of `state.range(0)` views, as the reshapes of attention layers do.
+void BM_ViewChain(benchmark::State& state) {
+  XLATensorPtr input = CreateTensor({16, 32, 64});
+  const std::vector<std::vector<int64_t>> sizes = {
+      {16, 2048}, {512, 64}, {16, 32, 64}, {32768}};
+  for (auto _ : state) {
+    XLATensorPtr view = input;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      view = tensor_methods::view(view, sizes[i % sizes.size()]);
+    }
+    benchmark::DoNotOptimize(view);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ViewChain)->Arg(1)->Arg(8);
+
+void BM_IndexPut(benchmark::State& state) {
+  XLATensorPtr input = CreateTensor({64, 64});
+  XLATensorPtr index = CreateTensor(at::randint(64, {16}, at::kLong));
+  XLATensorPtr values = CreateTensor({16, 64});
+  std::vector<XLATensorPtr> indices = {index};
+  const std::vector<int64_t> permutation = {0, 1};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tensor_methods::index_put(
+        input, indices, /*start_dim=*/0, values, /*accumulate=*/false,
+        permutation));
+  }
+}
+BENCHMARK(BM_IndexPut);
+
+void BM_Cat(benchmark::State& state) {
+  std::vector<XLATensorPtr> inputs;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    inputs.push_back(CreateTensor({4, 16}));
+  }
+  for (auto _ : state) {
+    XLA_ASSIGN_OR_THROW(XLATensorPtr result,
+                        tensor_methods::cat(inputs, /*dim=*/0, at::kFloat));
+    benchmark::DoNotOptimize(result);
+  }
+}
+BENCHMARK(BM_Cat)->Arg(100);
+
+// Alternates between a few values, which the scalar cache may hold.
+void BM_GetIrValueForScalar(benchmark::State& state) {
+  XLAGraphExecutor* executor = XLAGraphExecutor::Get();
+  int64_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(executor->GetIrValueForScalar(
+        at::Scalar(static_cast<double>(i++ % 4)), xla::PrimitiveType::F32,
+        GetDevice()));
+  }
+}
+BENCHMARK(BM_GetIrValueForScalar);
+
+void BM_GetGraphHash(benchmark::State& state) {
+  std::vector<XLATensorPtr> roots =
+      CreateGraph(state.range(0), /*num_chains=*/100);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(XLAGraphExecutor::Get()->GetGraphHash(roots));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetGraphHash)->Arg(10000)->Arg(100000);
+
+// Walks the graph as RunPostOrder() does on a miss of its post-order cache.
+void BM_ComputePostOrder(benchmark::State& state) {
+  std::vector<XLATensorPtr> tensors =
+      CreateGraph(state.range(0), /*num_chains=*/100);
+  std::vector<const torch::lazy::Node*> roots;
+  for (const XLATensorPtr& tensor : tensors) {
+    roots.push_back(tensor->GetIrValue().node.get());
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(torch::lazy::Util::ComputePostOrder(roots));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ComputePostOrder)->Arg(10000)->Arg(100000);
+
+}  // namespace
+}  // namespace torch_xla
+
+BENCHMARK_MAIN();
@@ -0,0 +1,242 @@
+// Measures the host to device and device to host transfers of tensors, with
+// the host conversions of their data separately from the transfers
+// themselves, the way the lazy tensor stack runs them:
+//   convert: the creation of the transfer sources out of the CPU tensor, as
+//     CreateTensorsData does it, that is, the element type conversion and the
+//     gather of a non-contiguous tensor into the staging buffer.
+//   h2d: the transfer of the sources, until the device buffers are ready.
+//   d2h: the transfer of the device buffers back into literals.
+//   to tensor: the conversion of the literals into CPU tensors of the source
+//     element type, as XlaDataToTensors does it.
+// The sources of the shards of a tiled tensor are strided views of it, which
+// the transfers gather themselves, so the sharded rows account that gather to
+// h2d unless the shards need an element type conversion.
+//
+// Every phase is reported in GB/s of the device data, averaged over the timed
+// iterations, for every size, case and shard count. The cases are:
+//   f32: a contiguous f32 tensor transferred as f32.
+//   f32_bf16: a contiguous f32 tensor transferred as bf16.
+//   i64_i32: a contiguous i64 tensor transferred as s32.
+//   f32_transposed: a transposed f32 tensor transferred as f32.
+//
+// The sweep is configured with environment variables:
+//   BENCHMARK_MIN_BYTES: smallest f32 tensor size, in bytes (default 1MB).
+//   BENCHMARK_MAX_BYTES: largest f32 tensor size, in bytes (default 256MB).
+//   BENCHMARK_STEP_FACTOR: multiplier from one size to the next (default 4).
+//   BENCHMARK_WARMUP_ITERS: transfers ahead of the timed ones (default 2).
+//   BENCHMARK_ITERS: timed transfers per size (default 10).
+//   BENCHMARK_SHARDED: whether to also tile the tensors along their first
+//     dimension across all the local devices, when there are more than one
+//     (default true).
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ATen/ATen.h>
+
+#include "absl/synchronization/blocking_counter.h"
+#include "xla/array2d.h"
+#include "xla/hlo/ir/hlo_sharding.h"
+#include "xla/literal.h"
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/device.h"
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tensor_source.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_util.h"
+#include "torch_xla/csrc/xla_sharding_util.h"
+
+namespace torch_xla {
+namespace {
+
+using runtime::ComputationClient;
+
+struct TransferCase {
+  const char* name;
+  at::ScalarType source_type;
+  xla::PrimitiveType device_type;
+  bool transposed;
+};
+
+constexpr TransferCase kCases[] = {
+    {"f32", at::kFloat, xla::PrimitiveType::F32, false},
+    {"f32_bf16", at::kFloat, xla::PrimitiveType::BF16, false},
+    {"i64_i32", at::kLong, xla::PrimitiveType::S32, false},
+    {"f32_transposed", at::kFloat, xla::PrimitiveType::F32, true},
+};
+
+// Elements of the minor dimension of the tensors.
+constexpr int64_t kColumns = 1024;
+
+// Times of the phases of the transfers, in microseconds, summed over the
+// timed iterations.
+struct PhaseTimes {
+  double convert = 0.0;
+  double h2d = 0.0;
+  double d2h = 0.0;
+  double to_tensor = 0.0;
+};
+
+double ElapsedUs(int64_t start_ns) {
+  return (runtime::sys_util::NowNs() - start_ns) / 1000.0;
+}
+
+// Returns a [rows, kColumns] tensor, holding a transposed view if `transposed`.
+at::Tensor CreateSourceTensor(const TransferCase& transfer_case,
+                              int64_t rows) {
+  at::TensorOptions options(transfer_case.source_type);
+  if (transfer_case.transposed) {
+    return at::randint(1 << 10, {kColumns, rows}, options).t();
+  }
+  return at::randint(1 << 10, {rows, kColumns}, options);
+}
+
+void WaitReady(ComputationClient* client,
+               const std::vector<ComputationClient::DataPtr>& handles) {
+  std::vector<ComputationClient::DataPtr> buffers;
+  for (const ComputationClient::DataPtr& handle : handles) {
+    std::vector<ComputationClient::DataPtr> shards =
+        client->GetDataShards(handle);
+    buffers.insert(buffers.end(), shards.begin(), shards.end());
+  }
+  absl::BlockingCounter counter(buffers.size());
+  for (const ComputationClient::DataPtr& buffer : buffers) {
+    client->OnReadyCallback(buffer, [&counter]() { counter.DecrementCount(); });
+  }
+  counter.Wait();
+}
+
+// Runs one transfer of `tensor` to the device and back, tiled across
+// `devices` if there are more than one, and adds the times of its phases to
+// `times`.
+void RunTransfer(ComputationClient* client, const at::Tensor& tensor,
+                 const xla::Shape& shape,
+                 const std::vector<std::string>& devices, PhaseTimes* times) {
+  int64_t start_ns = runtime::sys_util::NowNs();
+  std::vector<std::shared_ptr<const runtime::TensorSource>> sources;
+  XLATensor::ShardingSpecPtr sharding;
+  if (devices.size() == 1) {
+    sources.push_back(CreateTensorSource(tensor, shape, devices.front()));
+  } else {
+    xla::Array2D<int64_t> mesh(devices.size(), 1);
+    mesh.FillIota(0);
+    sharding = std::make_shared<XLATensor::ShardingSpec>(
+        xla::HloSharding::Tile(mesh).ToProto(), shape);
+    sources = ShardingUtil::CreateShardSources(tensor, sharding, devices);
+  }
+  times->convert += ElapsedUs(start_ns);
+
+  start_ns = runtime::sys_util::NowNs();
+  std::vector<ComputationClient::DataPtr> handles;
+  if (sharding == nullptr) {
+    handles = client->TransferToDevice(sources);
+  } else {
+    handles.push_back(client->TransferShardsToDevice(
+        sources, GetVirtualDevice().toString(), shape, sharding->sharding));
+  }
+  WaitReady(client, handles);
+  times->h2d += ElapsedUs(start_ns);
+
+  std::vector<ComputationClient::DataPtr> shards =
+      client->GetDataShards(handles.front());
+  start_ns = runtime::sys_util::NowNs();
+  XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> literals,
+                      client->TransferFromDevice(shards));
+  times->d2h += ElapsedUs(start_ns);
+
+  start_ns = runtime::sys_util::NowNs();
+  for (xla::Literal& literal : literals) {
+    at::Tensor result =
+        MakeTensorFromXlaLiteral(std::move(literal), tensor.scalar_type());
+    XLA_CHECK_EQ(result.numel() * devices.size(), tensor.numel());
+  }
+  times->to_tensor += ElapsedUs(start_ns);
+}
+
+void RunBenchmarks() {
+  XLA_ASSIGN_OR_THROW(ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  XLA_ASSIGN_OR_THROW(torch::lazy::BackendDevice * absl_nonnull const device,
+                      bridge::GetDefaultDevice());
+  std::vector<std::vector<std::string>> device_sets = {{device->toString()}};
+  std::vector<std::string> local_devices = client->GetLocalDevices();
+  if (local_devices.size() > 1 &&
+      runtime::sys_util::GetEnvBool("BENCHMARK_SHARDED", true)) {
+    device_sets.push_back(local_devices);
+  }
+
+  int64_t min_bytes =
+      runtime::sys_util::GetEnvInt("BENCHMARK_MIN_BYTES", 1 << 20);
+  int64_t max_bytes =
+      runtime::sys_util::GetEnvInt("BENCHMARK_MAX_BYTES", 256 << 20);
+  int64_t step_factor =
+      std::max<int64_t>(runtime::sys_util::GetEnvInt("BENCHMARK_STEP_FACTOR",
+                                                     4),
+                        2);
+  int64_t warmup_iters =
+      runtime::sys_util::GetEnvInt("BENCHMARK_WARMUP_ITERS", 2);
+  int64_t iters = std::max<int64_t>(
+      runtime::sys_util::GetEnvInt("BENCHMARK_ITERS", 10), 1);
+
+  std::printf("# Device: %s, local devices: %zu, warmup iters: %ld, "
+              "iters: %ld\n",
+              device->toString().c_str(), local_devices.size(), warmup_iters,
+              iters);
+  std::printf("# Bandwidths in GB/s of the device data\n");
+  std::printf("%-16s %6s %14s %14s %12s %12s %12s %12s\n", "# case", "shards",
+              "size (B)", "device (B)", "convert", "h2d", "d2h", "to tensor");
+  for (const TransferCase& transfer_case : kCases) {
+    for (const std::vector<std::string>& devices : device_sets) {
+      int64_t num_shards = devices.size();
+      for (int64_t bytes = min_bytes; bytes <= max_bytes;
+           bytes *= step_factor) {
+        // Rounded so that the rows split evenly among the shards.
+        int64_t rows = std::max<int64_t>(bytes / 4 / kColumns, 1);
+        rows = (rows + num_shards - 1) / num_shards * num_shards;
+        at::Tensor tensor = CreateSourceTensor(transfer_case, rows);
+        xla::Shape shape = MakeShapeWithDeviceLayout(
+            xla::ShapeUtil::MakeShape(transfer_case.device_type,
+                                      {rows, kColumns}),
+            static_cast<XlaDeviceType>(device->type()));
+        int64_t device_bytes = xla::ShapeUtil::ByteSizeOf(shape);
+
+        PhaseTimes warmup_times;
+        for (int64_t i = 0; i < warmup_iters; ++i) {
+          RunTransfer(client, tensor, shape, devices, &warmup_times);
+        }
+        PhaseTimes times;
+        for (int64_t i = 0; i < iters; ++i) {
+          RunTransfer(client, tensor, shape, devices, &times);
+        }
+        // Bytes per microsecond, scaled to GB/s.
+        auto bandwidth = [&](double time_us) {
+          return static_cast<double>(device_bytes) * iters /
+                 std::max(time_us, 1.0) / 1.0e3;
+        };
+        std::printf("%-16s %6ld %14ld %14ld %12.3f %12.3f %12.3f %12.3f\n",
+                    transfer_case.name, num_shards, tensor.nbytes(),
+                    device_bytes, bandwidth(times.convert),
+                    bandwidth(times.h2d), bandwidth(times.d2h),
+                    bandwidth(times.to_tensor));
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace torch_xla
+
+int main(int argc, char* argv[]) {
+  torch_xla::RunBenchmarks();
+  return 0;
+}
@@ -114,7 +114,8 @@ if [[ "$RUN_CPP_TESTS" == "cpp_tests" ]]; then
               "test_status_dont_show_cpp_stacktraces"
               "test_status_show_cpp_stacktraces"
               "test_debug_macros"
-              "test_device")
+              "test_device"
+              "test_simd_convert")
 fi
 for name in "${test_names[@]}"; do
   echo "Running $name cpp test..."
@@ -762,7 +762,9 @@ TEST_F(AtenXlaTensorTest, TestEinsumPyTorchLowerBilinear) {
   });
 
   ExpectCounterNotChanged("aten::.*", cpp_test::GetIgnoredCounters());
-  ExpectCounterChanged("EinsumFallback", cpp_test::GetIgnoredCounters());
+  ExpectCounterNotChanged("EinsumFallback", cpp_test::GetIgnoredCounters());
+  ExpectCounterChanged("EinsumPathContractions",
+                       cpp_test::GetIgnoredCounters());
   ExpectCounterChanged("xla::einsum", cpp_test::GetIgnoredCounters());
 }
 
@@ -784,7 +786,7 @@ TEST_F(AtenXlaTensorTest, TestEinsumPyTorchLowerBilinearBackward) {
   });
 
   ExpectCounterNotChanged("aten::.*", cpp_test::GetIgnoredCounters());
-  ExpectCounterChanged("EinsumFallback", cpp_test::GetIgnoredCounters());
+  ExpectCounterNotChanged("EinsumFallback", cpp_test::GetIgnoredCounters());
   ExpectCounterChanged("xla::einsum", cpp_test::GetIgnoredCounters());
 }
 
@@ -943,10 +945,35 @@ TEST_F(AtenXlaTensorTest, TestEinsumThreeInputs) {
   });
 
   ExpectCounterNotChanged("aten::.*", cpp_test::GetIgnoredCounters());
-  ExpectCounterChanged("EinsumFallback", cpp_test::GetIgnoredCounters());
+  ExpectCounterNotChanged("EinsumFallback", cpp_test::GetIgnoredCounters());
+  ExpectCounterChanged("EinsumPathContractions",
+                       cpp_test::GetIgnoredCounters());
   ExpectCounterChanged("xla::einsum", cpp_test::GetIgnoredCounters());
 }
 
+TEST_F(AtenXlaTensorTest, TestEinsumChainPath) {
+  // Contracting the first two operands first would build a 64x64
+  // intermediate, the last two a 2x64 one.
+  torch::Tensor a = torch::rand({64, 2}, torch::TensorOptions(torch::kFloat));
+  torch::Tensor b = torch::rand({2, 64}, torch::TensorOptions(torch::kFloat));
+  torch::Tensor c = torch::rand({64, 2}, torch::TensorOptions(torch::kFloat));
+  std::string equation = "ij,jk,kl->il";
+  torch::Tensor result = torch::einsum(equation, {a, b, c});
+  ForEachDevice([&](const torch::Device& device) {
+    torch::Tensor xla_a = CopyToDevice(a, device);
+    torch::Tensor xla_b = CopyToDevice(b, device);
+    torch::Tensor xla_c = CopyToDevice(c, device);
+    torch::Tensor xla_result = torch::einsum(equation, {xla_a, xla_b, xla_c});
+    AllClose(result, xla_result, /*rtol=*/1e-4, /*atol=*/1e-4);
+    std::string hlo = GetTensorHloGraph(xla_result);
+    EXPECT_EQ(hlo.find("f32[64,64]"), std::string::npos) << hlo;
+  });
+
+  ExpectCounterNotChanged("aten::.*", cpp_test::GetIgnoredCounters());
+  ExpectCounterNotChanged("EinsumFallback", cpp_test::GetIgnoredCounters());
+  ExpectCounterChanged("EinsumPathSearches", cpp_test::GetIgnoredCounters());
+}
+
 TEST_F(AtenXlaTensorTest, TestEinsumExtraSpaces) {
   torch::Tensor a = torch::rand({5}, torch::TensorOptions(torch::kFloat));
   torch::Tensor b = torch::rand({5}, torch::TensorOptions(torch::kFloat));
@@ -1669,6 +1696,25 @@ TEST_F(AtenXlaTensorTest, TestStack) {
   }
 }
 
+TEST_F(AtenXlaTensorTest, TestStackManyInputs) {
+  std::vector<torch::Tensor> inputs;
+  for (int i = 0; i < 256; ++i) {
+    inputs.push_back(torch::rand({4, 3}, torch::TensorOptions(torch::kFloat)));
+  }
+  for (int dim : {0, 1, 2}) {
+    torch::Tensor stacked = torch::stack(inputs, dim);
+    torch::Tensor concatenated = torch::cat(inputs, dim % 2);
+    ForEachDevice([&](const torch::Device& device) {
+      std::vector<torch::Tensor> xla_inputs;
+      for (const torch::Tensor& input : inputs) {
+        xla_inputs.push_back(CopyToDevice(input, device));
+      }
+      AllClose(stacked, torch::stack(xla_inputs, dim));
+      AllClose(concatenated, torch::cat(xla_inputs, dim % 2));
+    });
+  }
+}
+
 TEST_F(AtenXlaTensorTest, TestCat) {
   torch::Tensor a = torch::rand({2, 1, 3}, torch::TensorOptions(torch::kFloat));
   torch::Tensor b = torch::rand({2, 2, 3}, torch::TensorOptions(torch::kFloat));
@@ -1639,7 +1639,7 @@ TEST_F(AtenXlaTensorTest, TestLayerNorm) {
       });
 
       ExpectCounterNotChanged("aten::.*", cpp_test::GetIgnoredCounters());
-      ExpectCounterChanged("xla::native_batch_norm",
+      ExpectCounterChanged("xla::native_layer_norm",
                            cpp_test::GetIgnoredCounters());
     }
   }
@@ -1676,14 +1676,67 @@ TEST_F(AtenXlaTensorTest, TestLayerNormBackward) {
       });
 
       ExpectCounterNotChanged("aten::.*", cpp_test::GetIgnoredCounters());
-      ExpectCounterChanged("xla::native_batch_norm",
+      ExpectCounterChanged("xla::native_layer_norm",
                            cpp_test::GetIgnoredCounters());
-      ExpectCounterChanged("xla::native_batch_norm_backward",
+      ExpectCounterChanged("xla::native_layer_norm_backward",
                            cpp_test::GetIgnoredCounters());
     }
   }
 }
 
+TEST_F(AtenXlaTensorTest, TestRmsNorm) {
+  torch::Tensor input =
+      torch::rand({20, 10, 10, 10}, torch::TensorOptions(torch::kFloat));
+  double eps = 1e-05;
+  torch::Tensor undef;
+  for (bool undef_weight : {true, false}) {
+    for (int64_t normalized_size : {2, 3}) {
+      std::vector<int64_t> normalized_shape(normalized_size, 10);
+      torch::Tensor weight =
+          torch::rand(normalized_shape, torch::TensorOptions(torch::kFloat));
+      torch::Tensor output = torch::rms_norm(
+          input, normalized_shape, undef_weight ? undef : weight, eps);
+      ForEachDevice([&](const torch::Device& device) {
+        torch::Tensor xla_input = CopyToDevice(input, device);
+        torch::Tensor xla_weight =
+            undef_weight ? undef : CopyToDevice(weight, device);
+        torch::Tensor xla_output =
+            torch::rms_norm(xla_input, normalized_shape, xla_weight, eps);
+        AllClose(output, xla_output, /*rtol=*/1e-3, /*atol=*/1e-5);
+      });
+
+      ExpectCounterNotChanged("aten::.*", cpp_test::GetIgnoredCounters());
+      ExpectCounterChanged("xla::rms_norm", cpp_test::GetIgnoredCounters());
+    }
+  }
+}
+
+TEST_F(AtenXlaTensorTest, TestRmsNormBackward) {
+  torch::Tensor input = torch::rand(
+      {2, 3, 3, 3}, torch::TensorOptions(torch::kFloat).requires_grad(true));
+  double eps = 1e-05;
+  for (bool undef_weight : {true, false}) {
+    for (int64_t normalized_size : {2, 3}) {
+      std::vector<int64_t> normalized_shape(normalized_size, 3);
+      auto testfn =
+          [&](const std::vector<torch::Tensor>& inputs) -> torch::Tensor {
+        return torch::rms_norm(inputs[0], normalized_shape, inputs[1], eps);
+      };
+      torch::Tensor weight =
+          torch::rand(normalized_shape,
+                      torch::TensorOptions(torch::kFloat).requires_grad(true));
+      torch::Tensor undef;
+      ForEachDevice([&](const torch::Device& device) {
+        TestBackward({input, undef_weight ? undef : weight}, device, testfn,
+                     /*rtol=*/1e-3, /*atol=*/1e-4);
+      });
+
+      ExpectCounterNotChanged("aten::.*", cpp_test::GetIgnoredCounters());
+      ExpectCounterChanged("xla::rms_norm", cpp_test::GetIgnoredCounters());
+    }
+  }
+}
+
 // TEST_F(AtenXlaTensorTest, TestNuclearNorm) {
 //   torch::Tensor a = torch::rand({4, 3}, torch::TensorOptions(torch::kFloat));
 //   torch::Tensor b = torch::nuclear_norm(a);
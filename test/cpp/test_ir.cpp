@@ -1,12 +1,17 @@
 #include <gtest/gtest.h>
 
 #include <stdexcept>
+#include <vector>
+
+#include "xla/hlo/ir/hlo_sharding.h"
+#include "xla/literal_util.h"
 
 #include "test/cpp/cpp_test_util.h"
 #include "test/cpp/torch_xla_test.h"
 #include "torch_xla/csrc/ir.h"
 #include "torch_xla/csrc/lowering_context.h"
 #include "torch_xla/csrc/ops/arithmetic_ir_ops.h"
+#include "torch_xla/csrc/ops/constant.h"
 #include "torch_xla/csrc/ops/dynamic_ir.h"
 #include "torch_xla/csrc/ops/expand.h"
 #include "torch_xla/csrc/ops/nonzero.h"
@@ -15,6 +20,7 @@
 #include "torch_xla/csrc/ops/select.h"
 #include "torch_xla/csrc/ops/unselect.h"
 #include "torch_xla/csrc/ops/update_slice.h"
+#include "torch_xla/csrc/xla_sharding_util.h"
 
 namespace torch_xla {
 namespace cpp_test {
@@ -51,6 +57,58 @@ TEST_F(IrTest, TestHash) {
   EXPECT_NE(add1->hash(), sub->hash());
 }
 
+TEST_F(IrTest, TestLargeConstantHash) {
+  // Large enough to be hashed over several chunks.
+  std::vector<float> values(3 * (1 << 18) + 5);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<float>(i);
+  }
+  torch::lazy::NodePtr constant1 =
+      torch_xla::MakeNode<Constant>(xla::LiteralUtil::CreateR1<float>(values));
+  torch::lazy::NodePtr constant2 =
+      torch_xla::MakeNode<Constant>(xla::LiteralUtil::CreateR1<float>(values));
+  EXPECT_EQ(constant1->hash(), constant2->hash());
+
+  values.back() += 1.0f;
+  torch::lazy::NodePtr constant3 =
+      torch_xla::MakeNode<Constant>(xla::LiteralUtil::CreateR1<float>(values));
+  EXPECT_NE(constant1->hash(), constant3->hash());
+}
+
+TEST_F(IrTest, TestShardingHash) {
+  torch::lazy::NodePtr scalar1 = ScalarOp(1.0, xla::F32);
+  torch::lazy::NodePtr scalar2 = ScalarOp(1.0, xla::F32);
+  XlaNode* node = dynamic_cast<XlaNode*>(scalar1.get());
+  node->SetSharding(xla::HloSharding::Replicate().ToProto(), 0);
+  EXPECT_NE(scalar1->hash(), scalar2->hash());
+  // The hash follows the latest sharding, and goes back to the unsharded hash
+  // once the sharding is cleared.
+  torch::lazy::hash_t replicated_hash = scalar1->hash();
+  node->SetSharding(xla::HloSharding::Manual().ToProto(), 0);
+  EXPECT_NE(scalar1->hash(), replicated_hash);
+  node->ClearSharding();
+  EXPECT_EQ(scalar1->hash(), scalar2->hash());
+}
+
+TEST_F(IrTest, TestShardedOutputsTracked) {
+  ForEachDevice([&](const torch::lazy::BackendDevice& device) {
+    torch::lazy::NodePtr scalar1 = ScalarOp(1.0, xla::F32);
+    torch::lazy::NodePtr scalar2 = ScalarOp(2.0, xla::F32);
+    torch::lazy::Value add =
+        torch::lazy::Value(scalar1, 0) + torch::lazy::Value(scalar2, 0);
+    dynamic_cast<XlaNode*>(scalar2.get())
+        ->SetSharding(xla::HloSharding::Replicate().ToProto(), 0);
+
+    LoweringContext lowering_ctx("TestShardedOutputsTracked", device);
+    lowering_ctx.AddResult(torch::lazy::Output(add.node.get(), add.index));
+    EXPECT_EQ(lowering_ctx.GetEmittedOutputs().size(), 3);
+    ASSERT_EQ(lowering_ctx.GetShardedOutputs().size(), 1);
+    EXPECT_EQ(lowering_ctx.GetShardedOutputs().begin()->first.node,
+              scalar2.get());
+    EXPECT_TRUE(ShardingUtil::SetHloSharding(&lowering_ctx));
+  });
+}
+
 TEST_F(IrTest, TestSelectUnselect) {
   ForEachDevice([&](const torch::lazy::BackendDevice& device) {
     at::Tensor a =
@@ -0,0 +1,280 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "torch_xla/csrc/simd_convert.h"
+
+namespace torch_xla {
+namespace simd_convert {
+namespace {
+
+uint32_t FloatBits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float BitsFloat(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint16_t ReferenceF32ToBF16(float value) {
+  uint32_t bits = FloatBits(value);
+  if (std::isnan(value)) {
+    return std::signbit(value) ? 0xffc0 : 0x7fc0;
+  }
+  return (bits + 0x7fff + ((bits >> 16) & 1)) >> 16;
+}
+
+float ReferenceF16ToF32(uint16_t half) {
+  uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  int exponent = (half >> 10) & 0x1f;
+  int mantissa = half & 0x3ff;
+  float magnitude;
+  if (exponent == 0x1f) {
+    magnitude = mantissa != 0 ? std::numeric_limits<float>::quiet_NaN()
+                              : std::numeric_limits<float>::infinity();
+  } else if (exponent == 0) {
+    magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+  } else {
+    magnitude = std::ldexp(static_cast<float>(mantissa | 0x400), exponent - 25);
+  }
+  return BitsFloat(FloatBits(magnitude) | sign);
+}
+
+// The float16 values are all the ones of a float, so the nearest one is found
+// by looking at the two neighbors of the truncated value.
+uint16_t ReferenceF32ToF16(float value) {
+  uint16_t sign = std::signbit(value) ? 0x8000 : 0;
+  float magnitude = std::fabs(value);
+  if (std::isnan(value)) {
+    return sign | 0x7e00;
+  }
+  if (magnitude >= 65520.0f) {
+    return sign | 0x7c00;
+  }
+  uint16_t low = 0;
+  for (int bit = 14; bit >= 0; --bit) {
+    uint16_t candidate = low | (1 << bit);
+    if (ReferenceF16ToF32(candidate) <= magnitude) {
+      low = candidate;
+    }
+  }
+  uint16_t high = low + 1;
+  float low_error = magnitude - ReferenceF16ToF32(low);
+  float high_error = ReferenceF16ToF32(high) - magnitude;
+  if (high_error < low_error || (high_error == low_error && (low & 1) != 0)) {
+    return sign | high;
+  }
+  return sign | low;
+}
+
+std::vector<float> TestFloats() {
+  std::vector<float> values = {
+      0.0f,
+      -0.0f,
+      1.0f,
+      -1.0f,
+      std::numeric_limits<float>::infinity(),
+      -std::numeric_limits<float>::infinity(),
+      std::numeric_limits<float>::quiet_NaN(),
+      -std::numeric_limits<float>::quiet_NaN(),
+      BitsFloat(0x7f800001),
+      BitsFloat(0xff800001),
+      BitsFloat(0x7fffffff),
+      std::numeric_limits<float>::max(),
+      std::numeric_limits<float>::lowest(),
+      std::numeric_limits<float>::min(),
+      std::numeric_limits<float>::denorm_min(),
+      // Ties of the bfloat16 rounding.
+      BitsFloat(0x3f808000),
+      BitsFloat(0x3f818000),
+      BitsFloat(0x7f7f8000),
+      // Around the largest float16 and its denormals.
+      65504.0f,
+      65519.0f,
+      65520.0f,
+      std::ldexp(1.0f, -24),
+      std::ldexp(1.0f, -25),
+      std::ldexp(3.0f, -26),
+  };
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<uint32_t> bits;
+  std::uniform_real_distribution<float> halves(-70000.0f, 70000.0f);
+  while (values.size() < 100003) {
+    values.push_back(BitsFloat(bits(generator)));
+    values.push_back(halves(generator));
+  }
+  return values;
+}
+
+std::vector<Isa> TestIsas() {
+  std::vector<Isa> isas = {Isa::kScalar};
+  for (Isa isa : {Isa::kNeon, Isa::kAvx2, Isa::kAvx512}) {
+    SetMaxIsaForTesting(isa);
+    if (GetIsa() == isa) {
+      isas.push_back(isa);
+    }
+  }
+  return isas;
+}
+
+class SimdConvertTest : public ::testing::Test {
+ protected:
+  void TearDown() override { SetMaxIsaForTesting(Isa::kAvx512); }
+};
+
+TEST_F(SimdConvertTest, F32ToBF16) {
+  std::vector<float> src = TestFloats();
+  for (Isa isa : TestIsas()) {
+    SetMaxIsaForTesting(isa);
+    std::vector<uint16_t> dest(src.size());
+    int64_t n = F32ToBF16(src.data(), dest.data(), src.size());
+    EXPECT_EQ(n == 0, isa == Isa::kScalar);
+    // Only a tail shorter than a vector is left to the caller.
+    EXPECT_TRUE(isa == Isa::kScalar ||
+                n + 16 > static_cast<int64_t>(src.size()));
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(dest[i], ReferenceF32ToBF16(src[i])) << src[i];
+    }
+  }
+}
+
+TEST_F(SimdConvertTest, BF16ToF32) {
+  std::vector<uint16_t> src(1 << 16);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = i;
+  }
+  for (Isa isa : TestIsas()) {
+    SetMaxIsaForTesting(isa);
+    std::vector<float> dest(src.size());
+    int64_t n = BF16ToF32(src.data(), dest.data(), src.size());
+    EXPECT_EQ(n == 0, isa == Isa::kScalar);
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(FloatBits(dest[i]), static_cast<uint32_t>(src[i]) << 16);
+    }
+  }
+}
+
+TEST_F(SimdConvertTest, F32ToF16) {
+  std::vector<float> src = TestFloats();
+  for (Isa isa : TestIsas()) {
+    SetMaxIsaForTesting(isa);
+    std::vector<uint16_t> dest(src.size());
+    int64_t n = F32ToF16(src.data(), dest.data(), src.size());
+    EXPECT_EQ(n == 0, isa == Isa::kScalar);
+    for (int64_t i = 0; i < n; ++i) {
+      uint16_t expected = ReferenceF32ToF16(src[i]);
+      if (std::isnan(src[i])) {
+        // The NaN payloads are not specified.
+        ASSERT_TRUE(std::isnan(ReferenceF16ToF32(dest[i])));
+        ASSERT_EQ(dest[i] & 0x8000, expected & 0x8000);
+      } else {
+        ASSERT_EQ(dest[i], expected) << src[i];
+      }
+    }
+  }
+}
+
+TEST_F(SimdConvertTest, F16ToF32) {
+  std::vector<uint16_t> src(1 << 16);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = i;
+  }
+  for (Isa isa : TestIsas()) {
+    SetMaxIsaForTesting(isa);
+    std::vector<float> dest(src.size());
+    int64_t n = F16ToF32(src.data(), dest.data(), src.size());
+    EXPECT_EQ(n == 0, isa == Isa::kScalar);
+    for (int64_t i = 0; i < n; ++i) {
+      float expected = ReferenceF16ToF32(src[i]);
+      if (std::isnan(expected)) {
+        ASSERT_TRUE(std::isnan(dest[i]));
+      } else {
+        ASSERT_EQ(FloatBits(dest[i]), FloatBits(expected)) << i;
+      }
+    }
+  }
+}
+
+TEST_F(SimdConvertTest, S64ToS32) {
+  std::mt19937_64 generator(0);
+  std::vector<int64_t> src = {0, -1, std::numeric_limits<int64_t>::max(),
+                              std::numeric_limits<int64_t>::min()};
+  while (src.size() < 1003) {
+    src.push_back(static_cast<int64_t>(generator()));
+  }
+  for (Isa isa : TestIsas()) {
+    SetMaxIsaForTesting(isa);
+    std::vector<int32_t> dest(src.size());
+    int64_t n = S64ToS32(src.data(), dest.data(), src.size());
+    EXPECT_EQ(n == 0, isa == Isa::kScalar);
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(dest[i], static_cast<int32_t>(src[i]));
+    }
+  }
+}
+
+TEST_F(SimdConvertTest, S32ToS64) {
+  std::mt19937 generator(0);
+  std::vector<int32_t> src = {0, -1, std::numeric_limits<int32_t>::max(),
+                              std::numeric_limits<int32_t>::min()};
+  while (src.size() < 1003) {
+    src.push_back(static_cast<int32_t>(generator()));
+  }
+  for (Isa isa : TestIsas()) {
+    SetMaxIsaForTesting(isa);
+    std::vector<int64_t> dest(src.size());
+    int64_t n = S32ToS64(src.data(), dest.data(), src.size());
+    EXPECT_EQ(n == 0, isa == Isa::kScalar);
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(dest[i], src[i]);
+    }
+  }
+}
+
+TEST_F(SimdConvertTest, PackInt4) {
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> values(-8, 7);
+  std::vector<int8_t> src(2 * 1003);
+  for (int8_t& value : src) {
+    value = values(generator);
+  }
+  for (Isa isa : TestIsas()) {
+    SetMaxIsaForTesting(isa);
+    std::vector<uint8_t> dest(src.size() / 2);
+    int64_t n = PackInt4(src.data(), dest.data(), dest.size());
+    EXPECT_EQ(n == 0, isa == Isa::kScalar);
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(dest[i], (src[2 * i] & 0xf) | ((src[2 * i + 1] & 0xf) << 4));
+    }
+  }
+}
+
+TEST_F(SimdConvertTest, UnpackInt4) {
+  std::vector<uint8_t> src(256 * 5 + 3);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = i;
+  }
+  for (Isa isa : TestIsas()) {
+    SetMaxIsaForTesting(isa);
+    std::vector<int8_t> dest(2 * src.size());
+    int64_t n = UnpackInt4(src.data(), dest.data(), src.size());
+    EXPECT_EQ(n == 0, isa == Isa::kScalar);
+    for (int64_t i = 0; i < n; ++i) {
+      ASSERT_EQ(dest[2 * i], ((src[i] & 0xf) ^ 8) - 8) << i;
+      ASSERT_EQ(dest[2 * i + 1], ((src[i] >> 4) ^ 8) - 8) << i;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace simd_convert
+}  // namespace torch_xla
@@ -34,6 +34,17 @@ bool XlaDataValuesEqual(torch::lazy::BackendDataPtr a,
                       XlaDataToTensors({a, b}, {element_type, element_type}));
   return TensorCompare(tensors[0], tensors[1]);
 }
+
+at::Tensor TensorSourceToTensor(const runtime::TensorSource& source) {
+  at::ScalarType scalar_type = TorchTypeFromXlaType(source.primitive_type());
+  std::vector<int64_t> strides = source.byte_strides();
+  for (int64_t& stride : strides) {
+    stride /= c10::elementSize(scalar_type);
+  }
+  return at::from_blob(const_cast<void*>(source.data()), source.dimensions(),
+                       strides, at::TensorOptions(scalar_type))
+      .clone();
+}
 }  // namespace
 
 class XLAShardingTest : public AtenXlaTensorTestBase {
@@ -226,6 +237,9 @@ TEST_F(XLAShardingTest, ShardTensor) {
   EXPECT_EQ(shards.size(), 8);
   EXPECT_EQ(shards[0].sizes(), c10::ArrayRef<long>({10, 1, 4, 4, 2}));
   EXPECT_EQ(shards[7].sizes(), c10::ArrayRef<long>({10, 1, 4, 4, 2}));
+  // The data of the uneven shard is followed by zero padding.
+  EXPECT_TRUE(shards[7].narrow(3, 0, 3).eq(1).all().item<bool>());
+  EXPECT_TRUE(shards[7].narrow(3, 3, 1).eq(0).all().item<bool>());
 }
 
 TEST_F(XLAShardingTest, ShardTensorMultiHost) {
@@ -297,6 +311,38 @@ TEST_F(XLAShardingTest, ShardTensorMiniBatch) {
   EXPECT_EQ(shards[3].sizes(), c10::ArrayRef<long>({2, 7, 4}));
 }
 
+TEST_F(XLAShardingTest, CreateShardSources) {
+  std::vector<std::string> devices = {"TPU:0", "TPU:1", "TPU:2", "TPU:3",
+                                      "TPU:4", "TPU:5", "TPU:6", "TPU:7"};
+  XLA_ASSIGN_OR_THROW(const torch::lazy::BackendDevice* default_device,
+                      bridge::GetDefaultDevice());
+  xla::Array2D<int64_t> mesh({
+      {0, 1, 2, 3},
+      {4, 5, 6, 7},
+  });
+  xla::OpSharding sharding = xla::HloSharding::Tile(mesh).ToProto();
+  // The first tensor splits evenly, its shards being read straight out of it,
+  // and the second needs its last shards padded. The third one is a
+  // transposed view, of the same shape as the second.
+  at::Tensor even = at::rand({8, 8}, at::TensorOptions(at::kFloat));
+  at::Tensor uneven = at::rand({8, 7}, at::TensorOptions(at::kFloat));
+  at::Tensor transposed =
+      at::rand({7, 8}, at::TensorOptions(at::kFloat)).transpose(0, 1);
+  for (const at::Tensor& tensor : {even, uneven, transposed}) {
+    auto sharding_spec = std::make_shared<XLATensor::ShardingSpec>(
+        sharding, CreateComputationShapeFromTensor(tensor, default_device));
+    std::vector<at::Tensor> shards = ShardingUtil::ShardTensor(
+        tensor, sharding_spec, devices, /*padded=*/true);
+    std::vector<std::shared_ptr<const runtime::TensorSource>> sources =
+        ShardingUtil::CreateShardSources(tensor, sharding_spec, devices);
+    ASSERT_EQ(sources.size(), shards.size());
+    for (size_t i = 0; i < sources.size(); ++i) {
+      EXPECT_EQ(sources[i]->device(), devices[i]);
+      EXPECT_TRUE(TensorCompare(TensorSourceToTensor(*sources[i]), shards[i]));
+    }
+  }
+}
+
 TEST_F(XLAShardingTest, EqualShardingSpecs) {
   auto tensor = at::ones({8, 7}, at::TensorOptions(at::kFloat));
   XLA_ASSIGN_OR_THROW(const torch::lazy::BackendDevice* default_device,
@@ -320,6 +366,88 @@ TEST_F(XLAShardingTest, EqualShardingSpecs) {
   EXPECT_FALSE(ShardingUtil::EqualShardingSpecs(tiled_2d, replicated));
 }
 
+TEST_F(XLAShardingTest, InternOpSharding) {
+  xla::OpSharding tiled =
+      xla::HloSharding::Tile({{0, 1, 2, 3}, {4, 5, 6, 7}}).ToProto();
+  xla::OpSharding transposed =
+      xla::HloSharding::Tile({{0, 2, 4, 6}, {1, 3, 5, 7}}).ToProto();
+  // Copies of the same sharding share their canonical one.
+  xla::OpSharding tiled_copy = tiled;
+  auto interned = ShardingUtil::InternOpSharding(tiled);
+  EXPECT_EQ(ShardingUtil::InternOpSharding(tiled_copy), interned);
+  EXPECT_NE(ShardingUtil::InternOpSharding(transposed), interned);
+  EXPECT_TRUE(ShardingUtil::EqualOpShardings(*interned, tiled_copy));
+  EXPECT_FALSE(ShardingUtil::EqualOpShardings(tiled, transposed));
+  EXPECT_EQ(ShardingUtil::HashOpSharding(tiled),
+            ShardingUtil::HashOpSharding(tiled_copy));
+
+  // Shardings only told apart by their metadata are not the same.
+  xla::OpSharding annotated = tiled;
+  annotated.add_metadata()->set_op_name("annotated");
+  EXPECT_FALSE(ShardingUtil::EqualOpShardings(tiled, annotated));
+  EXPECT_NE(ShardingUtil::InternOpSharding(annotated), interned);
+}
+
+TEST_F(XLAShardingTest, GetShardReplicaAndIndicesForDevicesMemoized) {
+  std::vector<std::string> devices = {"TPU:0", "TPU:1", "TPU:2", "TPU:3",
+                                      "TPU:4", "TPU:5", "TPU:6", "TPU:7"};
+  xla::OpSharding sharding =
+      xla::HloSharding::Tile({{0, 1, 2, 3}, {4, 5, 6, 7}}).ToProto();
+  auto first = ShardingUtil::GetShardReplicaAndIndicesForDevices(
+      {4, 2}, {8, 7}, sharding, devices);
+  // A different shape of the same shards is not served the first indices.
+  auto other = ShardingUtil::GetShardReplicaAndIndicesForDevices(
+      {4, 2}, {8, 8}, sharding, devices);
+  auto second = ShardingUtil::GetShardReplicaAndIndicesForDevices(
+      {4, 2}, {8, 7}, sharding, devices);
+  ASSERT_EQ(first.size(), second.size());
+  for (size_t i = 0; i < first.size(); ++i) {
+    EXPECT_EQ(first[i].first, second[i].first);
+    ASSERT_EQ(first[i].second.size(), second[i].second.size());
+    for (size_t j = 0; j < first[i].second.size(); ++j) {
+      EXPECT_EQ(first[i].second[j].slice().start(),
+                second[i].second[j].slice().start());
+      EXPECT_EQ(first[i].second[j].slice().stop(),
+                second[i].second[j].slice().stop());
+    }
+  }
+  // The last device's columns end at the edges of the respective tensors.
+  EXPECT_EQ(first[7].second[1].slice().stop(), 7);
+  EXPECT_EQ(other[7].second[1].slice().stop(), 8);
+}
+
+TEST_F(XLAShardingTest, GetShardOverlaps) {
+  std::vector<std::string> devices = {"TPU:0", "TPU:1", "TPU:2", "TPU:3"};
+  // Tiles the 8x7 tensor into 4x4 shards, each replicated on two devices.
+  xla::OpSharding sharding =
+      xla::HloSharding::PartialTile(xla::TileAssignment({2, 1, 2})).ToProto();
+  auto overlaps = ShardingUtil::GetShardOverlaps({4, 7}, {8, 7}, sharding,
+                                                 devices, {3, 2}, {6, 5});
+  // Rows [3, 4) come from the first shard, and rows [4, 6) from the second,
+  // read from the first replica of each.
+  ASSERT_EQ(overlaps.size(), 2);
+  EXPECT_EQ(overlaps[0].shard, 0);
+  EXPECT_EQ(overlaps[0].shard_offsets, std::vector<int64_t>({3, 2}));
+  EXPECT_EQ(overlaps[0].region_offsets, std::vector<int64_t>({0, 0}));
+  EXPECT_EQ(overlaps[0].sizes, std::vector<int64_t>({1, 3}));
+  EXPECT_EQ(overlaps[1].shard, 2);
+  EXPECT_EQ(overlaps[1].shard_offsets, std::vector<int64_t>({0, 2}));
+  EXPECT_EQ(overlaps[1].region_offsets, std::vector<int64_t>({1, 0}));
+  EXPECT_EQ(overlaps[1].sizes, std::vector<int64_t>({2, 3}));
+
+  // A region within a single shard only overlaps that shard.
+  overlaps = ShardingUtil::GetShardOverlaps({4, 7}, {8, 7}, sharding, devices,
+                                            {5, 0}, {7, 7});
+  ASSERT_EQ(overlaps.size(), 1);
+  EXPECT_EQ(overlaps[0].shard, 2);
+
+  // A region the shards on the devices do not cover fails.
+  EXPECT_THROW(ShardingUtil::GetShardOverlaps({4, 7}, {8, 7}, sharding,
+                                              {"TPU:0", "TPU:1"}, {3, 0},
+                                              {6, 7}),
+               std::exception);
+}
+
 TEST_F(XLAShardingTest, CreateTensorsData) {
   if (torch_xla::runtime::sys_util::GetEnvString(
           torch_xla::runtime::env::kEnvPjRtDevice, "") == "") {
@@ -381,6 +509,45 @@ TEST_F(XLAShardingTest, CreateTensorsData) {
   }
 }
 
+TEST_F(XLAShardingTest, ReshardDataReusesComputation) {
+  if (torch_xla::runtime::sys_util::GetEnvString(
+          torch_xla::runtime::env::kEnvPjRtDevice, "") == "") {
+    GTEST_SKIP() << "`PJRT_DEVICE` is not set.";
+  }
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  int64_t n_devices = client->GetLocalDevices().size();
+  if (n_devices < 2) {
+    GTEST_SKIP() << "Resharding needs multiple devices.";
+  }
+  at::Tensor tensor = at::rand({8, 8}, at::TensorOptions(at::kFloat));
+  XLA_ASSIGN_OR_THROW(const torch::lazy::BackendDevice* default_device,
+                      bridge::GetDefaultDevice());
+  xla::Array<int64_t> tile_assignment({1, n_devices});
+  tile_assignment.FillIota(0);
+  auto sharding_spec = std::make_shared<XLATensor::ShardingSpec>(
+      xla::HloSharding::Tile(tile_assignment).ToProto(),
+      CreateComputationShapeFromTensor(tensor, default_device));
+  torch::lazy::BackendDataPtr tensor_data = CreateTensorsData(
+      {tensor}, {sharding_spec}, {default_device->toString()})[0];
+  std::vector<runtime::ComputationClient::DataPtr> handles = {
+      UnwrapXlaData(tensor_data)};
+
+  // The second resharding between the same layouts reuses the program.
+  MetricsSnapshot before;
+  for (int i = 0; i < 2; ++i) {
+    std::vector<runtime::ComputationClient::DataPtr> resharded =
+        client->ReshardData(handles, {xla::HloSharding::Replicate().ToProto()});
+    ASSERT_EQ(resharded.size(), 1);
+    EXPECT_EQ(resharded[0]->GetSharding().type(), xla::OpSharding::REPLICATED);
+  }
+  MetricsSnapshot after;
+  std::vector<MetricsSnapshot::ChangedCounter> changed =
+      before.CounterChanged("ReshardDataCacheHit", after, nullptr);
+  ASSERT_EQ(changed.size(), 1);
+  EXPECT_EQ(changed[0].after - changed[0].before, 1);
+}
+
 TEST_F(XLAShardingTest, PrepareOutputShardingPropagation) {
   xla::Shape shape = xla::ShapeUtil::MakeShape(xla::PrimitiveType::F32, {4, 4});
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
@@ -447,6 +614,20 @@ TEST_F(XLAShardingTest, PrepareOutputShardingPropagation) {
       std::dynamic_pointer_cast<torch_xla::runtime::ComputationClient::Data>(
           data_placeholders[0])
           ->HasValue());
+
+  // The specs extracted once are shared by the next steps, which only create
+  // new placeholders for them.
+  std::vector<XLATensor::ShardingSpecPtr> output_sharding_specs =
+      sharding_specs;
+  std::vector<torch::lazy::BackendDataPtr> next_placeholders;
+  ShardingUtil::PrepareOutputShardingPropagation(&tensors, {0},
+                                                 output_sharding_specs,
+                                                 &next_placeholders,
+                                                 &sharding_specs);
+  EXPECT_EQ(sharding_specs[0], output_sharding_specs[0]);
+  ASSERT_EQ(next_placeholders.size(), 1);
+  EXPECT_NE(next_placeholders[0], data_placeholders[0]);
+  EXPECT_EQ(tensors[0]->data()->handle, next_placeholders[0]);
 }
 
 }  // namespace cpp_test
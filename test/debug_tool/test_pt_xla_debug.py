@@ -341,6 +341,25 @@ class PtXLADebugTest(unittest.TestCase):
 
     open(self.debug_file_name, 'w').close()
 
+  def test_recompilation_analysis(self):
+    device = torch_xla.device()
+    for size in (7, 8):
+      t1 = torch.ones(size, 3, device=device) * 2
+      torch_xla.sync()
+    with open(self.debug_file_name, 'rb') as f:
+      lines = [line.decode() for line in f.readlines()]
+      analysis = [
+          line for line in lines if line.startswith('Recompilation Analysis:')
+      ]
+
+    self.assertTrue(
+        any('is closest to the previously compiled graph' in line
+            for line in analysis))
+    self.assertTrue(
+        any('Different shape' in line and 'f32[7,3]' in line and
+            'f32[8,3]' in line for line in analysis))
+    open(self.debug_file_name, 'w').close()
+
 
 if __name__ == '__main__':
   test = unittest.main()
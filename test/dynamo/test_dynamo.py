@@ -182,6 +182,23 @@ class DynamoInferenceBasicTest(parameterized.TestCase):
     # Dynamo has to sync the input since they are intermedate IR(xla_xy and xla_y3)
     self.assertEqual(met.counter_value('DynamoSyncInputExecuteTime'), 1)
 
+  @skipOnNeuron
+  def test_output_shapes_looked_up_once(self):
+    device = torch_xla.device()
+    xla_x = torch.randn(4, 4, device=device)
+    xla_y = torch.randn(4, 4, device=device)
+    torch_xla.sync()
+    fn_simple_dynamo = torch.compile(self.fn_simple, backend="openxla")
+    fn_simple_dynamo(xla_x, xla_y)
+    met.clear_counters()
+    for _ in range(3):
+      res_xla_dynamo = fn_simple_dynamo(xla_x, xla_y)
+    # The first execution after the compilation looked the shapes up.
+    self.assertNotIn('UncachedDynamoOutputShapes', met.counter_names())
+    self.assertTrue(
+        torch.allclose(self.fn_simple(xla_x.cpu(), xla_y.cpu()),
+                       res_xla_dynamo.cpu()))
+
   def test_fn_without_input(self):
 
     def fn_without_input(device):
@@ -128,6 +128,15 @@ class PybindTest(unittest.TestCase):
     assert (len(hash_out) == 1)
     assert (hash_out[0].equal(xla_out))
 
+    # An input holding pending IR is synced by the call itself.
+    met.clear_counters()
+    pending_input = expected_input[-1] * 1
+    pending_inputs = expected_input[:-1] + [pending_input]
+    hash_out = torch_xla._XLAC._run_cached_graph(
+        hash, pending_inputs, sync_inputs=True)
+    self.assertEqual(met.counter_value('DynamoSyncInputExecuteTime'), 1)
+    assert (hash_out[0].equal(xla_out))
+
     assert ('RunCachedGraphInputData' in met.metric_names())
     assert ('RunCachedGraphOutputData' in met.metric_names())
 
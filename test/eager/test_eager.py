@@ -53,6 +53,29 @@ class Eager(unittest.TestCase):
     self.assertEqual(met.metric_data("EagerOpCompileTime")[0], 1)
     self.assertEqual(met.metric_data("EagerOpExecuteTime")[0], 2)
 
+  def test_eager_warm_up(self):
+    self.assertTrue(torch_xla.experimental.is_eager_mode())
+    device = torch_xla.device()
+
+    xm.wait_device_ops()
+    met.clear_all()
+    fn = lambda a, b: torch.tanh(a * b)
+    torch_xla.experimental.eager.warm_up_eager_ops(fn, [[(7, 3), (7, 3)],
+                                                        [(9, 3), (9, 3)]])
+    xm.wait_device_ops()
+    self.assertEqual(met.counter_value("EagerWarmUpOps"), 4)
+    self.assertEqual(met.metric_data("EagerOpCompileTime")[0], 4)
+    self.assertIsNone(met.metric_data("EagerOpExecuteTime"))
+
+    t1 = torch.randn(9, 3).to(device)
+    t2 = torch.randn(9, 3).to(device)
+    t3 = fn(t1, t2)
+    xm.wait_device_ops()
+    # The ops run with the executables compiled by the warm-up.
+    self.assertEqual(met.metric_data("EagerOpCompileTime")[0], 4)
+    self.assertEqual(met.metric_data("EagerOpExecuteTime")[0], 2)
+    self.assertTrue(torch.allclose(t3.cpu(), torch.tanh(t1.cpu() * t2.cpu())))
+
   def test_eager_in_place(self):
     self.assertTrue(torch_xla.experimental.is_eager_mode())
     device = torch_xla.device()
@@ -0,0 +1,50 @@
+import os
+import unittest
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+import torch_xla.core.xla_model as xm
+
+
+class EagerWindow(unittest.TestCase):
+
+  @classmethod
+  def setUpClass(cls):
+    torch_xla.experimental.eager_mode(True)
+
+  def test_window_runs_ops_together(self):
+    device = torch_xla.device()
+    t1 = torch.randn(5, 5, device=device)
+    xm.wait_device_ops()
+    met.clear_all()
+
+    # The four ops fill the window, and run as one graph.
+    t2 = t1 * 2
+    t3 = t2 + 1
+    t4 = t3.abs()
+    t4.sub_(t1)
+    self.assertEqual(met.metric_data("EagerWindowOps")[0], 1)
+    xm.wait_device_ops()
+    self.assertEqual(met.metric_data("EagerOpExecuteTime")[0], 1)
+    expected = (t1.cpu() * 2 + 1).abs() - t1.cpu()
+    self.assertTrue(torch.allclose(t4.cpu(), expected))
+
+  def test_window_runs_before_host_fetch(self):
+    device = torch_xla.device()
+    t1 = torch.randn(5, 5, device=device)
+    xm.wait_device_ops()
+    met.clear_all()
+
+    t2 = t1 * 3
+    # The pending op runs before the value reaches the host.
+    self.assertTrue(torch.allclose(t2.cpu(), t1.cpu() * 3))
+    self.assertEqual(met.metric_data("EagerWindowOps")[0], 1)
+
+
+if __name__ == '__main__':
+  if os.environ.get('XLA_EAGER_WINDOW_OPS') is None:
+    os.environ['XLA_EAGER_WINDOW_OPS'] = '4'
+  test = unittest.main(exit=False)
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -8,6 +8,7 @@ import torch_xla.core.xla_model as xm
 import torch_xla.experimental.xla_quantized_matmul
 from torch_xla import runtime as xr
 from torch_xla.experimental.xla_quantized_matmul import XlaQuantizedLinear
+from torch_xla.experimental.xla_quantized_matmul import pack_int4, unpack_int4
 from torch.ao.quantization.utils import determine_qparams
 
 torch.manual_seed(123456)
@@ -285,6 +286,56 @@ class QuantizedTest(parameterized.TestCase):
           self.assertGreater(
               self._calc_cosine_dist(out_quant_xla.cpu(), out_quant), 0.999999)
 
+  def test_int4_pack_unpack(self):
+    # Large enough for the vectorized kernels and a scalar tail.
+    weight = torch.randint(-8, 8, (3, 1030)).to(torch.int8)
+    packed = pack_int4(weight)
+    self.assertEqual(packed.dtype, torch.uint8)
+    self.assertEqual(packed.shape, (3, 515))
+    self.assertEqual(packed[0, 0].item() & 0xf, weight[0, 0].item() & 0xf)
+    self.assertTrue(torch.equal(unpack_int4(packed), weight))
+    # Unpacked on the device, the packed bytes being what is transferred.
+    self.assertTrue(torch.equal(unpack_int4(packed.to(device)).cpu(), weight))
+
+  def test_int4_cast_on_device(self):
+    weight = torch.randint(-8, 7, (4, 2)).to(torch.int8).to(device)
+    w = torch_xla._XLAC._xla_cast_int4(weight)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([w])
+    self.assertTrue(re.search(r's4.*convert.*s8', hlo) is not None)
+    self.assertNotIn('constant', hlo)
+
+
+  @parameterized.parameters([-1, 4])
+  def test_weight_read_quantized(self, block_size):
+    with torch.no_grad():
+      x = torch.randn((3, 8), dtype=torch.bfloat16).to(device)
+      if block_size == -1:
+        w_int = torch.randint(-128, 127, (16, 8), dtype=torch.int8)
+        scaler = torch.randn((16,), dtype=torch.bfloat16)
+      else:
+        w_int = torch.randint(-128, 127, (2, 4, 16), dtype=torch.int8)
+        scaler = torch.randn((2, 16), dtype=torch.bfloat16)
+      output = torch.ops.xla.quantized_matmul(
+          x, w_int.to(device), scaler.to(device), block_size=block_size)
+      hlo = torch_xla._XLAC._get_xla_tensors_hlo([output])
+      self.assertIn('xla::quantized_dot',
+                    torch_xla._XLAC._get_xla_tensors_text([output]))
+      # The weight is an operand of the dot, never dequantized on its own.
+      self.assertTrue(re.search(r'dot.*bf16.*s8', hlo) is not None)
+      self.assertNotIn('bf16[' + ','.join(map(str, w_int.shape)), hlo)
+
+  def test_fp8_per_channel_matmul(self):
+    with torch.no_grad():
+      x = torch.randn((3, 8), dtype=torch.bfloat16)
+      w = torch.randn((16, 8)).to(torch.float8_e4m3fn)
+      scaler = torch.rand((16,), dtype=torch.bfloat16)
+      torch_out = torch.ops.xla.quantized_matmul(x, w, scaler)
+      xla_out = torch.ops.xla.quantized_matmul(
+          x.to(device), w.to(device), scaler.to(device))
+      self.assertEqual(xla_out.dtype, torch_out.dtype)
+      self.assertGreater(
+          self._calc_cosine_dist(xla_out.cpu(), torch_out), 0.999)
+
 
 if __name__ == '__main__':
   unittest.main()
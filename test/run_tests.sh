@@ -192,12 +192,14 @@ function run_xla_op_tests2 {
   run_test "$_TEST_DIR/scan/test_scan.py"
   run_test "$_TEST_DIR/scan/test_scan_spmd.py"
   run_test "$_TEST_DIR/scan/test_scan_layers.py"
+  run_test "$_TEST_DIR/scan/test_ring_attention.py"
   run_test "$_TEST_DIR/test_gru.py"
   run_test "$_TEST_DIR/test_as_stride_use_slice.py"
   run_test "$_TEST_DIR/test_placeholder.py"
   run_xla_hlo_debug run_test "$_TEST_DIR/scan/test_scan_debug.py"
   run_test "$_TEST_DIR/test_autocast.py"
   run_test "$_TEST_DIR/eager/test_eager.py"
+  XLA_EAGER_WINDOW_OPS=4 run_test "$_TEST_DIR/eager/test_eager_window.py"
   run_test "$_TEST_DIR/eager/test_eager_with_xla_compile.py"
   run_test "$_TEST_DIR/eager/test_eager_with_torch_compile.py"
 
@@ -233,6 +235,8 @@ function run_xla_op_tests3 {
   run_test "$_TEST_DIR/spmd/test_dynamo_spmd.py"
   run_test "$_TEST_DIR/spmd/test_spmd_debugging.py"
   run_test "$_TEST_DIR/spmd/test_xla_distributed_checkpoint.py"
+  run_test "$_TEST_DIR/spmd/test_streaming_readback.py"
+  run_test "$_TEST_DIR/spmd/test_streaming_load.py"
   run_test "$_TEST_DIR/spmd/test_xla_spmd_python_api_interaction.py"
   run_test "$_TEST_DIR/spmd/test_dtensor_integration.py"
   run_test "$_TEST_DIR/spmd/test_dtensor_integration2.py"
@@ -253,6 +257,51 @@ function run_xla_op_tests3 {
   run_test "$_TEST_DIR/test_torch_distributed_xla_backend.py"
   run_test "$_TEST_DIR/test_compilation_cache_utils.py"
   run_test "$_TEST_DIR/test_persistent_cache.py"
+  run_test "$_TEST_DIR/test_async_compilation.py"
+  run_test "$_TEST_DIR/test_inline_execution.py"
+  run_test "$_TEST_DIR/test_background_runtime_init.py"
+  run_test "$_TEST_DIR/test_ir_debug_sampling.py"
+  run_test "$_TEST_DIR/test_trace_profiler.py"
+  run_test "$_TEST_DIR/test_zero_copy_readback.py"
+  run_test "$_TEST_DIR/test_transfer_parameter_layouts.py"
+  run_test "$_TEST_DIR/test_pooled_readback.py"
+  run_test "$_TEST_DIR/test_scalar_pool.py"
+  run_test "$_TEST_DIR/test_all_reduce_bucketing.py"
+  run_test "$_TEST_DIR/test_compressed_all_reduce.py"
+  run_test "$_TEST_DIR/test_pipeline_parallel.py"
+  run_test "$_TEST_DIR/test_lowered_once.py"
+  run_test "$_TEST_DIR/test_chunked_cross_entropy.py"
+  run_test "$_TEST_DIR/test_blocked_attention.py"
+  run_test "$_TEST_DIR/test_sorted_scatter_add.py"
+  run_test "$_TEST_DIR/test_sparse_embedding_bag.py"
+  run_test "$_TEST_DIR/test_batched_nms.py"
+  run_test "$_TEST_DIR/test_associative_scan.py"
+  run_test "$_TEST_DIR/test_approx_topk.py"
+  run_test "$_TEST_DIR/test_counter_rng.py"
+  run_test "$_TEST_DIR/test_dropout_recompute_mask.py"
+  run_test "$_TEST_DIR/test_conv_channels_last.py"
+  run_test "$_TEST_DIR/test_checkpoint_policy.py"
+  run_test "$_TEST_DIR/test_bounded_dynamism.py"
+  run_test "$_TEST_DIR/test_view_composition.py"
+  run_test "$_TEST_DIR/test_parallel_lowering.py"
+  run_test "$_TEST_DIR/test_graph_split.py"
+  run_test "$_TEST_DIR/test_compile_option_autotune.py"
+  run_test "$_TEST_DIR/test_async_buffer_deletion.py"
+  run_test "$_TEST_DIR/test_output_arena.py"
+  run_test "$_TEST_DIR/test_compilation_cache_idle_unload.py"
+  run_test "$_TEST_DIR/test_sample_tokens.py"
+  run_test "$_TEST_DIR/test_fp8_dot.py"
+  run_test "$_TEST_DIR/test_downcast_indices.py"
+  run_test "$_TEST_DIR/test_predict_next_graph.py"
+  run_test "$_TEST_DIR/test_reduction_accumulation.py"
+  run_test "$_TEST_DIR/test_scatter_free_lowerings.py"
+  run_test "$_TEST_DIR/test_ir_simplification.py"
+  run_test "$_TEST_DIR/test_parameter_wrapping.py"
+  run_test "$_TEST_DIR/test_warm_up_cache.py"
+  run_test "$_TEST_DIR/test_graph_capture.py"
+  run_test "$_TEST_DIR/test_cpu_async.py"
+  run_test "$_TEST_DIR/test_memory_kind.py"
+  PJRT_DEVICE=CPU CPU_NUM_DEVICES=2 run_test "$_TEST_DIR/test_multi_device_threads.py"
   run_test "$_TEST_DIR/test_devices.py"
   run_test "$_TEST_DIR/test_manual_xla_registration.py"
   run_test_multi_devices "$_TEST_DIR/spmd/test_xla_dtensor_placements.py"
@@ -0,0 +1,41 @@
+import sys
+
+import torch
+import torch_xla
+from torch_xla.experimental.ring_attention import ring_attention
+from absl.testing import absltest, parameterized
+
+
+def _attention(q, k, v, causal, sm_scale):
+  logits = torch.matmul(q, k.transpose(-1, -2)) * sm_scale
+  if causal:
+    mask = torch.ones(
+        logits.shape[-2:], dtype=torch.bool, device=q.device).tril()
+    logits = logits.masked_fill(~mask, float('-inf'))
+  return torch.matmul(torch.softmax(logits, dim=-1), v)
+
+
+class RingAttentionTest(parameterized.TestCase):
+
+  @parameterized.named_parameters(('full', False), ('causal', True))
+  def test_single_block_ring(self, causal):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    q, k, v = (torch.randn(2, 8, 16, device=device, requires_grad=True)
+               for _ in range(3))
+    out = ring_attention(q, k, v, ring=[0], causal=causal, sm_scale=0.25)
+    out.sum().backward()
+    torch_xla.sync()
+    grads = [t.grad.cpu() for t in (q, k, v)]
+
+    ref = [t.detach().cpu().requires_grad_() for t in (q, k, v)]
+    expected = _attention(*ref, causal=causal, sm_scale=0.25)
+    expected.sum().backward()
+    torch.testing.assert_close(out.cpu(), expected, atol=1e-5, rtol=1e-4)
+    for grad, t in zip(grads, ref):
+      torch.testing.assert_close(grad, t.grad, atol=1e-5, rtol=1e-4)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -610,6 +610,29 @@ class ScanTest(TestBase, parameterized.TestCase):
     # Check if my_scan_fn is in the cache
     assert fn1 not in cache, "fn1 should not be in the cache"
 
+  def test_scan_lowers_to_native_node(self):
+    """
+    Test that scanning the same `fn` over different values builds the same
+    graph, around a single native scan node.
+    """
+
+    def fn(carry, x):
+      return carry + x, torch.sin(x)
+
+    hashes = []
+    for _ in range(2):
+      init = torch.randn(4, device=self.device)
+      xs = torch.randn(8, 4, device=self.device)
+      torch_xla.sync()
+      carry, ys = scan(fn, init, xs)
+      text = torch_xla._XLAC._get_xla_tensors_text([carry, ys])
+      self.assertEqual(text.count('xla::scan'), 1)
+      hashes.append(torch_xla._XLAC._get_graph_hash([carry, ys]))
+      expected_carry, expected_ys = _loopy_scan(fn, init, xs)
+      super().compareResults(carry, expected_carry)
+      super().compareResults(ys, expected_ys)
+    self.assertEqual(hashes[0], hashes[1])
+
 
 class PyTreeTest(TestBase):
 
@@ -0,0 +1,96 @@
+import json
+import os
+import struct
+import sys
+import tempfile
+import unittest
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+import torch_xla.distributed.spmd as xs
+from torch_xla.experimental.streaming_load import load_safetensors
+
+import test_xla_sharding_base
+
+_DTYPE_NAMES = {torch.float32: 'F32', torch.bfloat16: 'BF16'}
+
+
+def _write_safetensors(path, tensors):
+  header, data, offset = {}, [], 0
+  for name, tensor in tensors.items():
+    raw = tensor.contiguous().view(torch.uint8).flatten().numpy().tobytes()
+    header[name] = {
+        'dtype': _DTYPE_NAMES[tensor.dtype],
+        'shape': list(tensor.shape),
+        'data_offsets': [offset, offset + len(raw)],
+    }
+    data.append(raw)
+    offset += len(raw)
+  header['__metadata__'] = {'format': 'pt'}
+  encoded = json.dumps(header).encode()
+  with open(path, 'wb') as f:
+    f.write(struct.pack('<Q', len(encoded)))
+    f.write(encoded)
+    f.write(b''.join(data))
+
+
+class StreamingLoadTest(test_xla_sharding_base.XlaShardingTest):
+
+  @classmethod
+  def setUpClass(cls):
+    super().setUpClass()
+
+  def setUp(self):
+    super().setUp()
+    self.tmpdir = tempfile.TemporaryDirectory()
+    self.path = os.path.join(self.tmpdir.name, 'model.safetensors')
+
+  def tearDown(self):
+    self.tmpdir.cleanup()
+    super().tearDown()
+
+  def test_sharded(self):
+    mesh = self._get_mesh((self.n_devices, 1))
+    tensors = {
+        'even': torch.randn(self.n_devices * 4, 8),
+        # An uneven first dimension makes the last shard padded.
+        'uneven': torch.randn(self.n_devices * 4 + 1, 8),
+        'replicated': torch.randn(3, 5).to(torch.bfloat16),
+    }
+    _write_safetensors(self.path, tensors)
+    met.clear_all()
+    loaded = load_safetensors(
+        self.path,
+        sharding=lambda name, shape: None if name == 'replicated' else mesh.
+        get_op_sharding((0, 1)))
+    self.assertEqual(set(loaded), set(tensors))
+    for name, tensor in tensors.items():
+      self.assertEqual(loaded[name].dtype, tensor.dtype)
+      self.assertTrue(torch.equal(loaded[name].cpu(), tensor), name)
+    self.assertIn('0, 1',
+                  torch_xla._XLAC._get_xla_sharding_spec(loaded['even']))
+    self.assertGreater(met.counter_value('MappedTensorSource'), 0)
+    if self.n_devices > 1:
+      self.assertEqual(met.counter_value('MappedTensorPaddedShards'), 1)
+
+  def test_batches(self):
+    tensors = {f't{i}': torch.randn(16, 16) for i in range(4)}
+    _write_safetensors(self.path, tensors)
+    met.clear_all()
+    # Two tensors fit in a batch.
+    loaded = load_safetensors(self.path, max_inflight_bytes=2 * 16 * 16 * 4)
+    for name, tensor in tensors.items():
+      self.assertTrue(torch.equal(loaded[name].cpu(), tensor), name)
+    self.assertEqual(met.counter_value('MappedTensorBatches'), 2)
+
+  def test_truncated_file(self):
+    _write_safetensors(self.path, {'t': torch.randn(64, 64)})
+    os.truncate(self.path, os.path.getsize(self.path) - 4)
+    with self.assertRaises(RuntimeError):
+      load_safetensors(self.path)
+
+
+if __name__ == '__main__':
+  test = unittest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
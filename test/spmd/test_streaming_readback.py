@@ -0,0 +1,58 @@
+import os
+import sys
+import tempfile
+import unittest
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+import torch_xla.distributed.spmd as xs
+from torch_xla.experimental.streaming_readback import read_to
+
+import test_xla_sharding_base
+
+
+class StreamingReadbackTest(test_xla_sharding_base.XlaShardingTest):
+
+  @classmethod
+  def setUpClass(cls):
+    super().setUpClass()
+
+  def test_sharded_into_tensor(self):
+    mesh = self._get_mesh((self.n_devices, 1))
+    # An uneven first dimension makes the last shard padded.
+    t = torch.randn(self.n_devices * 4 + 1, 8)
+    xt = xs.mark_sharding(t.to('xla'), mesh, (0, 1))
+    dest = torch.empty_like(t)
+    self.assertIs(read_to(xt, dest), dest)
+    self.assertTrue(torch.equal(dest, t))
+
+  def test_replicated_into_file(self):
+    mesh = self._get_mesh((self.n_devices, 1))
+    t = torch.randn(16, 8)
+    xt = xs.mark_sharding(t.to('xla'), mesh, (None, None))
+    with tempfile.TemporaryDirectory() as tmpdir:
+      path = os.path.join(tmpdir, 'tensor.bin')
+      read_to(xt, path)
+      self.assertEqual(os.path.getsize(path), t.numel() * t.element_size())
+      loaded = torch.from_file(path, size=t.numel(), dtype=t.dtype)
+      self.assertTrue(torch.equal(loaded.view(t.shape), t))
+
+  def test_unsharded_chunks(self):
+    t = torch.randn(10, 4)
+    xt = t.to('xla') * 2
+    met.clear_all()
+    dest = read_to(xt, torch.empty_like(t), max_chunk_bytes=3 * 4 * 4)
+    self.assertTrue(torch.equal(dest, t * 2))
+    # The chunks of 3 rows share one graph, the last one has a single row.
+    self.assertLessEqual(met.metric_data('CompileTime')[0], 3)
+
+  def test_bad_destination(self):
+    xt = torch.randn(4, 4).to('xla')
+    with self.assertRaises(ValueError):
+      read_to(xt, torch.empty(4, 5))
+
+
+if __name__ == '__main__':
+  test = unittest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -5,7 +5,10 @@ from unittest.mock import patch
 import math
 import numpy as np
 import os
+import subprocess
 import sys
+import tempfile
+import textwrap
 
 import torch
 from torch import nn
@@ -88,6 +91,57 @@ class XlaAutoShardingTest(test_xla_sharding_base.XlaShardingTest):
     cnt = met.counter_value("CompileWithAutoSharding")
     self.assertTrue((cnt is not None) and (cnt <= 3))
 
+  @unittest.skipUnless(xr.device_type() in ["TPU", "CPU"],
+                       "Auto-sharding currently supports TPU & CPU backends.")
+  @unittest.skipIf(xr.global_runtime_device_count() < 4,
+                   "Needs at least two candidate meshes.")
+  def test_mesh_candidates(self):
+    met.clear_counters()
+    os.environ['XLA_AUTO_SPMD_MESH_CANDIDATES'] = 'auto'
+    try:
+      t1 = torch.rand(64, 128)
+      t2 = torch.rand(128, 256)
+      xt3 = t1.to('xla') @ t2.to('xla')
+      torch_xla.sync()
+    finally:
+      del os.environ['XLA_AUTO_SPMD_MESH_CANDIDATES']
+    # 1xN, 2xN/2, ... up to N/2x2.
+    n_candidates = int(math.log2(self.n_devices))
+    self.assertEqual(
+        met.counter_value("AutoShardingMeshCandidates"), n_candidates)
+    self.assertEqual(met.counter_value("CompileWithAutoSharding"), 1)
+    torch.testing.assert_close(xt3.cpu(), t1 @ t2)
+
+  @unittest.skipUnless(xr.device_type() in ["TPU", "CPU"],
+                       "Auto-sharding currently supports TPU & CPU backends.")
+  def test_auto_sharding_plan_reused_across_runs(self):
+    script = textwrap.dedent("""
+        import torch
+        import torch_xla
+        import torch_xla.debug.metrics as met
+        import torch_xla.runtime as xr
+
+        xr.use_spmd(auto=True)
+        xt = torch.ones(64, 128).to('xla') @ torch.ones(128, 256).to('xla')
+        torch_xla.sync()
+        print(met.counter_value('CompileWithAutoSharding') or 0,
+              met.counter_value('AutoShardingPlanCacheHit') or 0)
+        """)
+    with tempfile.TemporaryDirectory() as plan_dir:
+      env = dict(os.environ, XLA_AUTO_SPMD_PLAN_CACHE_PATH=plan_dir)
+      # The executable itself must not be cached.
+      env.pop('XLA_PERSISTENT_CACHE_PATH', None)
+      runs = [
+          subprocess.run([sys.executable, '-c', script],
+                         env=env,
+                         capture_output=True,
+                         text=True,
+                         check=True) for _ in range(2)
+      ]
+    # The second run compiles the graph with the plan of the first one.
+    self.assertEqual(runs[0].stdout.split()[-2:], ['1', '0'])
+    self.assertEqual(runs[1].stdout.split()[-2:], ['0', '1'])
+
 
 if __name__ == '__main__':
   test = unittest.main()
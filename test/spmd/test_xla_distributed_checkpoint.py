@@ -621,6 +621,30 @@ class CheckpointManagerTest(DistributedCheckpointTestBase):
       self.assertTrue(chkpt_mgr.save(preemption_step, state_dict))
       self.assertTrue(chkpt_mgr.reached_preemption(step))
 
+  @unittest.skipIf(xr.device_type() != 'TPU',
+                   'TPU required for worker IP discovery')
+  @run_with_tmpdir
+  def test_emergency_snapshot(self, tmpdir):
+    snapshot_path = os.path.join(tmpdir, 'snapshot')
+    chkpt_mgr = CheckpointManager(
+        os.path.join(tmpdir, 'chkpt'),
+        save_interval=100,
+        snapshot_path=snapshot_path)
+    model = self._get_sharded_model()
+    state_dict = model.state_dict()
+    self.assertIsNone(chkpt_mgr.restore_snapshot(state_dict))
+
+    self.assertFalse(chkpt_mgr.save(1, state_dict))
+    self.assertIsNone(chkpt_mgr.restore_snapshot(state_dict))
+    with unittest.mock.patch('torch_xla._XLAC._sync_point_reached',
+                             lambda x: True):
+      self.assertTrue(chkpt_mgr.save(2, state_dict))
+
+    new_state_dict = self._get_sharded_model().state_dict()
+    self.assertEqual(chkpt_mgr.restore_snapshot(new_state_dict), 2)
+    for name, tensor in state_dict.items():
+      self.assertTrue(torch.allclose(tensor.cpu(), new_state_dict[name].cpu()))
+
 
 @unittest.skipIf(xr.device_type() != 'TPU',
                  'TPU required for worker IP discovery')
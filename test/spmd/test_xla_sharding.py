@@ -1,3 +1,4 @@
+import concurrent.futures
 import copy
 
 from collections import OrderedDict
@@ -169,6 +170,21 @@ class BasicXlaShardingTest(test_xla_sharding_base.XlaShardingTest):
       # row in the mesh, which is device_id // 2
       self.assertEqual(shard.replica_id, i // 2)
 
+  def test_local_region(self):
+    mesh = self._get_mesh((self.n_devices, 1))
+    t = torch.arange(self.n_devices * 4 * 3, dtype=torch.float32).reshape(
+        self.n_devices * 4, 3)
+    xt = xs.mark_sharding(t.to('xla'), mesh, (0, 1))
+    met.clear_counters()
+    region = xt.local_region((slice(2, 6), slice(1, None)))
+    self.assertEqual(region.device, torch.device('cpu'))
+    self.assertTrue(torch.equal(region, t[2:6, 1:]))
+    # Only the shards overlapping the rows [2, 6) are transferred.
+    expected_shards = 2 if self.n_devices > 1 else 1
+    self.assertEqual(met.counter_value('ShardsRegionShards'), expected_shards)
+    self.assertTrue(torch.equal(xt.local_region(slice(None)), t))
+    self.assertEqual(xt.local_region(slice(3, 3)).shape, (0, 3))
+
   def test_load_local_shards(self):
     num_element = self.n_devices
     mesh = self._get_mesh((self.n_devices,))
@@ -628,7 +644,44 @@ class BasicXlaShardingTest(test_xla_sharding_base.XlaShardingTest):
     # Verify that the fc1 & output are sharded and valid
     model.fc1.weight.to('cpu')
     output.to('cpu')
-    self.assertEqual(met.counter_value("ReplicateShardedData"), 2)
+    # Tiled data is assembled on the host rather than replicated on device.
+    self.assertEqual(
+        (met.counter_value("ReplicateShardedData") or 0) +
+        (met.counter_value("HostAssembledShardedData") or 0), 2)
+
+  def test_replicated_upload_device_copies(self):
+    met.clear_all()
+    t = torch.randn(8, 8)
+    # Uploads in SPMD mode are implicitly replicated.
+    xt = t.to('xla')
+    if self.n_devices > 1:
+      self.assertEqual(
+          met.counter_value("ReplicatedShardDeviceCopies"), self.n_devices - 1)
+    self.assertTrue(torch.equal((xt + 1).cpu(), t + 1))
+
+  def test_replicated_upload_batch(self):
+    tensors = [torch.randn(4, 4) * i for i in range(16)]
+    met.clear_all()
+    device = str(torch_xla.device())
+    xtensors = torch_xla._XLAC._xla_tensors_from_aten(tensors,
+                                                      [device] * len(tensors))
+    # The replicas of each tensor share the source of its first shard.
+    self.assertEqual(
+        met.counter_value("ReplicatedShardSources") or 0,
+        len(tensors) * (self.n_devices - 1))
+    for t, xt in zip(tensors, xtensors):
+      self.assertTrue(torch.equal(xt.cpu(), t))
+
+  def test_tiled_readback_assembled_on_host(self):
+    met.clear_all()
+    # An uneven first dimension makes the last shard padded.
+    t = torch.randn(self.n_devices * 2 + 1, 3)
+    xt = xs.mark_sharding(
+        t.to('xla'), self._get_mesh((self.n_devices, 1)), (0, 1))
+    self.assertTrue(torch.equal(xt.cpu(), t))
+    if self.n_devices > 1:
+      self.assertEqual(met.counter_value("HostAssembledShardedData"), 1)
+      self.assertFalse(met.counter_value("ReplicateShardedData"))
 
   def test_inplace_add_with_sharding(self):
     xt = torch.ones(2, 2).to('xla')
@@ -1476,6 +1529,27 @@ class BasicXlaShardingTest(test_xla_sharding_base.XlaShardingTest):
     ):
       data, _ = iter(train_device_loader).__next__()
 
+  def test_minibatch_assembler(self):
+    mesh = xs.get_1d_mesh("data")
+    batch = torch.randn(mesh.size() * 2, 8)
+    assembler = xs.MinibatchAssembler(mesh, ('data', None), batch.shape,
+                                      batch.dtype)
+    slices = batch.chunk(mesh.size())
+    met.clear_counters()
+    # The slices are added from concurrent threads, as the workers of a data
+    # loader would.
+    with concurrent.futures.ThreadPoolExecutor(max_workers=4) as executor:
+      list(executor.map(assembler.add_shard, range(len(slices)), slices))
+    # Adding the shard of a device twice fails.
+    with self.assertRaises(RuntimeError):
+      assembler.add_shard(0, slices[0])
+    xt = assembler.finish()
+    self.assertEqual(met.counter_value('ShardedBatchShards'), mesh.size())
+    self.assertEqual(xt.global_tensor.shape, batch.shape)
+    expected = xs.mark_sharding(batch.to('xla'), mesh, ('data', None))
+    self.assertEqual(xt.sharding_spec, expected.sharding_spec)
+    self.assertTrue(torch.equal(xt.global_tensor.cpu(), batch))
+
   def test_fallback(self):
     device = torch_xla.device()
 
@@ -1,5 +1,6 @@
 import torch_xla
 import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
 from torch_xla.stablehlo import exported_program_to_stablehlo, StableHLOExportOptions
 from torch.utils import _pytree as pytree
 import torch
@@ -73,6 +74,28 @@ class StableHLOInferenceTest(unittest.TestCase):
 
     self.assertTrue(torch.allclose(output, output2, atol=1e-3))
 
+  def test_compile_cached_across_calls(self):
+
+    class Mul(torch.nn.Module):
+
+      def forward(self, x, y):
+        return x * y
+
+    m = Mul()
+    data = (torch.randn(10, 10), torch.randn(10, 10))
+    exported = export_torch_model(m, data)
+
+    device = torch_xla.device()
+    xla_data = pytree.tree_map_only(torch.Tensor, lambda x: x.to(device),
+                                    data)
+    met.clear_counters()
+    for _ in range(3):
+      output = exported(*xla_data).cpu()
+    # Only the first call converts and compiles the bytecode.
+    self.assertEqual(met.counter_value('UncachedStablehloCompile'), 1)
+    self.assertEqual(met.counter_value('CachedStablehloCompile'), 2)
+    self.assertTrue(torch.allclose(m(*data), output, atol=1e-3))
+
   def test_model_with_dict(self):
 
     class DictInput(torch.nn.Module):
@@ -1,6 +1,7 @@
 import tempfile
 import torch_xla
 import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
 from torch_xla import save_torch_model_as_stablehlo, save_as_stablehlo
 from torch_xla.stablehlo import StableHLOExportOptions, StableHLOGraphModule
 import torch
@@ -25,6 +26,29 @@ class StableHloDumpTest(unittest.TestCase):
     stablehlo = xm.get_stablehlo([z])
     self.assertEqual(stablehlo.count("stablehlo.add"), 1)
 
+  def test_conversion_cached(self):
+    device = torch_xla.device()
+    x = torch.tensor([5], device=device)
+    z = x * x
+    met.clear_counters()
+    bytecode = xm.get_stablehlo_bytecode([z])
+    self.assertEqual(xm.get_stablehlo_bytecode([z]), bytecode)
+    self.assertEqual(met.counter_value('CachedStablehloConversion'), 1)
+
+  def test_save_stablehlo(self):
+    device = torch_xla.device()
+    x = torch.tensor([4], device=device)
+    z = x - x
+    with tempfile.TemporaryDirectory() as tempdir:
+      path = os.path.join(tempdir, 'module.mlir')
+      xm.save_stablehlo(path, [z], bytecode=False)
+      with open(path) as f:
+        self.assertEqual(f.read(), xm.get_stablehlo([z]))
+      path = os.path.join(tempdir, 'module.mlirbc')
+      xm.save_stablehlo(path, [z])
+      with open(path, 'rb') as f:
+        self.assertEqual(f.read(), xm.get_stablehlo_bytecode([z]))
+
   def test_resnet18(self):
     device = torch_xla.device()
     xla_resnet18 = torchvision.models.resnet18()
@@ -0,0 +1,110 @@
+import os
+import sys
+
+# Set before the runtime reads them.
+os.environ['XLA_ALWAYS_ALLREDUCE'] = '1'
+os.environ['XLA_ALL_REDUCE_BUCKET_CAP_MB'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class AllReduceBucketingTest(absltest.TestCase):
+
+  def _reduce(self, tensors):
+    return [xm.all_reduce(xm.REDUCE_SUM, t, scale=0.5) for t in tensors]
+
+  def test_chained_all_reduces_bucketed(self):
+    device = torch_xla.device()
+    tensors = [torch.rand(64, 64) for _ in range(4)]
+    xtensors = [t.to(device) for t in tensors]
+    torch_xla.sync()
+    met.clear_counters()
+    results = self._reduce(xtensors)
+    torch_xla.sync()
+    for result, t in zip(results, tensors):
+      torch.testing.assert_close(result.cpu(), t * 0.5)
+    self.assertEqual(met.counter_value('AllReduceBuckets'), 1)
+    self.assertEqual(met.counter_value('BucketedAllReduces'), len(tensors))
+
+  def test_bucket_cap(self):
+    device = torch_xla.device()
+    # Each operand takes half of the 1MB cap, so they pair up.
+    tensors = [torch.rand(128, 1024) for _ in range(4)]
+    xtensors = [t.to(device) for t in tensors]
+    torch_xla.sync()
+    met.clear_counters()
+    results = self._reduce(xtensors)
+    torch_xla.sync()
+    for result, t in zip(results, tensors):
+      torch.testing.assert_close(result.cpu(), t * 0.5)
+    self.assertEqual(met.counter_value('AllReduceBuckets'), 2)
+    self.assertEqual(met.counter_value('BucketedAllReduces'), len(tensors))
+
+  def test_dependent_all_reduces_not_bucketed(self):
+    device = torch_xla.device()
+    t = torch.rand(16, 16)
+    xt = t.to(device)
+    torch_xla.sync()
+    met.clear_counters()
+    result = xm.all_reduce(xm.REDUCE_SUM, xt, scale=0.5)
+    result = xm.all_reduce(xm.REDUCE_SUM, result, scale=0.5)
+    torch_xla.sync()
+    torch.testing.assert_close(result.cpu(), t * 0.25)
+    self.assertIsNone(met.counter_value('AllReduceBuckets'))
+
+  def test_duplicate_all_reduces_merged(self):
+    device = torch_xla.device()
+    t = torch.rand(16, 16)
+    xt = t.to(device)
+    torch_xla.sync()
+    met.clear_counters()
+    first = xm.all_reduce(xm.REDUCE_SUM, xt, scale=0.5)
+    second = xm.all_reduce(xm.REDUCE_SUM, xt, scale=0.5)
+    # A different scale makes a different all-reduce.
+    third = xm.all_reduce(xm.REDUCE_SUM, xt, scale=0.25)
+    torch_xla.sync()
+    torch.testing.assert_close(first.cpu(), t * 0.5)
+    torch.testing.assert_close(second.cpu(), t * 0.5)
+    torch.testing.assert_close(third.cpu(), t * 0.25)
+    self.assertEqual(met.counter_value('DeduplicatedAllReduces'), 1)
+
+  def test_token_domains_chained_apart(self):
+    device = torch_xla.device()
+    xt = torch.rand(16, 16).to(device)
+    torch_xla.sync()
+    first = xm.all_reduce(xm.REDUCE_SUM, xt, scale=0.5)
+    with xm.token_domain('tensor_parallel'):
+      second = xm.all_reduce(xm.REDUCE_SUM, xt, scale=0.5)
+    self.assertEqual(torch_xla._XLAC._get_token_domain(), '')
+    third = xm.all_reduce(xm.REDUCE_SUM, xt, scale=0.5)
+    # Only the collectives of the same domain are chained through their token.
+    ir = torch_xla._XLAC._get_xla_tensors_text
+    self.assertEqual(ir([second]).count('xla::cross_replica_sum'), 1)
+    self.assertEqual(ir([third]).count('xla::cross_replica_sum'), 2)
+    torch_xla.sync()
+    for result in (first, second, third):
+      torch.testing.assert_close(result.cpu(), xt.cpu() * 0.5)
+
+  def test_collective_start_not_chained(self):
+    device = torch_xla.device()
+    xt = torch.rand(16, 16).to(device)
+    torch_xla.sync()
+    first = xm.all_reduce(xm.REDUCE_SUM, xt, scale=0.5)
+    pending = xm.collective_start(
+        xm.all_reduce, xm.REDUCE_SUM, xt, scale=0.25)
+    ir = torch_xla._XLAC._get_xla_tensors_text
+    self.assertEqual(ir([pending.wait()]).count('xla::cross_replica_sum'), 1)
+    torch.testing.assert_close(first.cpu(), xt.cpu() * 0.5)
+    # Waited on after the step boundary, the result is device data.
+    torch_xla.sync()
+    self.assertNotIn('xla::cross_replica_sum', ir([pending.wait()]))
+    torch.testing.assert_close(pending.wait().cpu(), xt.cpu() * 0.25)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
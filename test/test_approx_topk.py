@@ -0,0 +1,66 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.runtime as xr
+from absl.testing import absltest, parameterized
+from torch_xla.experimental.approx_topk import (approx_topk, approx_topk_mode,
+                                                get_topk_recall_target)
+
+
+class ApproxTopKTest(parameterized.TestCase):
+
+  def _recall(self, indices, expected_indices):
+    found = 0
+    for row, expected_row in zip(indices.tolist(), expected_indices.tolist()):
+      found += len(set(row) & set(expected_row))
+    return found / expected_indices.numel()
+
+  @parameterized.product(largest=[True, False], dim=[0, 1])
+  def test_approx_topk(self, largest, dim):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    input = torch.randn(4096, 64) if dim == 0 else torch.randn(64, 4096)
+    values, indices = approx_topk(
+        input.to(device), 16, dim=dim, largest=largest, recall_target=0.95)
+    expected_values, expected_indices = torch.topk(
+        input, 16, dim=dim, largest=largest)
+    values = values.cpu()
+    indices = indices.cpu()
+    self.assertEqual(values.shape, expected_values.shape)
+    self.assertEqual(indices.dtype, torch.int64)
+    torch.testing.assert_close(values, input.gather(dim, indices))
+    # The values are sorted.
+    diffs = values.diff(dim=dim)
+    self.assertTrue(torch.all(diffs <= 0 if largest else diffs >= 0))
+    if dim == 0:
+      indices, expected_indices = indices.t(), expected_indices.t()
+    self.assertGreaterEqual(self._recall(indices, expected_indices), 0.9)
+    if xr.device_type() != 'TPU':
+      # The fallback is exact.
+      torch.testing.assert_close(values, expected_values)
+
+  def test_approx_topk_mode(self):
+    device = torch_xla.device()
+    input = torch.randn(8, 1024, device=device)
+    self.assertIsNone(get_topk_recall_target())
+    with approx_topk_mode(0.9):
+      self.assertEqual(get_topk_recall_target(), 0.9)
+      values, _ = torch.topk(input, 8)
+    self.assertIsNone(get_topk_recall_target())
+    hlo = torch_xla._XLAC._get_xla_tensors_text([values])
+    self.assertIn('xla::approx_topk', hlo)
+
+    exact_values, _ = torch.topk(input, 8)
+    hlo = torch_xla._XLAC._get_xla_tensors_text([exact_values])
+    self.assertNotIn('xla::approx_topk', hlo)
+
+  def test_invalid_recall_target(self):
+    with self.assertRaises(RuntimeError):
+      with approx_topk_mode(1.5):
+        pass
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
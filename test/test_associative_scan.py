@@ -0,0 +1,100 @@
+import os
+import sys
+
+os.environ['XLA_ASSOCIATIVE_SCAN_MIN_SIZE'] = '16'
+
+import torch
+import torch_xla
+from absl.testing import absltest, parameterized
+from torch_xla.experimental.associative_scan import associative_scan
+
+
+class AssociativeScanTest(parameterized.TestCase):
+
+  def _assert_scanned(self, tensor):
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([tensor])
+    self.assertNotIn('reduce-window', hlo)
+
+  @parameterized.product(size=[16, 17, 1000], dim=[0, 1])
+  def test_cumsum(self, size, dim):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    shape = [3, 3]
+    shape[dim] = size
+    input = torch.randn(*shape)
+    output = torch.cumsum(input.to(device), dim=dim)
+    self._assert_scanned(output)
+    torch.testing.assert_close(
+        output.cpu(), torch.cumsum(input, dim=dim), atol=1e-4, rtol=1e-4)
+
+  def test_cumsum_integers(self):
+    device = torch_xla.device()
+    input = torch.randint(-5, 5, (4, 513))
+    output = torch.cumsum(input.to(device), dim=1)
+    self.assertEqual(output.cpu().tolist(),
+                     torch.cumsum(input, dim=1).tolist())
+
+  @parameterized.parameters(16, 33)
+  def test_cumprod(self, size):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    input = torch.rand(4, size) + 0.5
+    output = torch.cumprod(input.to(device), dim=1)
+    self._assert_scanned(output)
+    torch.testing.assert_close(
+        output.cpu(), torch.cumprod(input, dim=1), atol=1e-4, rtol=1e-4)
+
+  def test_cummax(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    # Distinct values, so that the indices are unique.
+    input = torch.randperm(4 * 100).float().view(4, 100)
+    values, indices = torch.cummax(input.to(device), dim=1)
+    self._assert_scanned(values)
+    expected_values, expected_indices = torch.cummax(input, dim=1)
+    torch.testing.assert_close(values.cpu(), expected_values)
+    torch.testing.assert_close(indices.cpu(), expected_indices)
+
+  def test_short_dims_use_reduce_window(self):
+    device = torch_xla.device()
+    output = torch.cumsum(torch.randn(4, 15, device=device), dim=1)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([output])
+    self.assertIn('reduce-window', hlo)
+
+  @parameterized.parameters(1, 7, 64)
+  def test_linear_recurrence(self, size):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    a = torch.rand(size, 5)
+    b = torch.randn(size, 5)
+    expected = []
+    h = torch.zeros(5)
+    for t in range(size):
+      h = a[t] * h + b[t]
+      expected.append(h)
+    expected = torch.stack(expected)
+
+    def compose(lhs, rhs):
+      return rhs[0] * lhs[0], rhs[0] * lhs[1] + rhs[1]
+
+    _, output = associative_scan(compose, (a.to(device), b.to(device)))
+    torch.testing.assert_close(output.cpu(), expected, atol=1e-4, rtol=1e-4)
+
+  def test_gradient(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    input = torch.randn(2, 37)
+    grad = torch.randn(2, 37)
+    cpu_input = input.clone().requires_grad_()
+    torch.cumsum(cpu_input, dim=1).backward(grad)
+
+    xla_input = input.to(device).requires_grad_()
+    associative_scan(lambda x, y: x + y, xla_input, dim=1).backward(
+        grad.to(device))
+    torch.testing.assert_close(
+        xla_input.grad.cpu(), cpu_input.grad, atol=1e-4, rtol=1e-4)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,28 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class AsyncBufferDeletionTest(absltest.TestCase):
+
+  def test_dropped_buffers_are_released(self):
+    device = torch_xla.device()
+    params = [torch.rand(64, 64).to(device) for _ in range(100)]
+    torch_xla.sync()
+    met.clear_counters()
+    # The step replaces all the parameters, dropping their old buffers.
+    params = [p * 2 for p in params]
+    torch_xla.sync()
+    expected = params[0].cpu()
+    params = [p + 1 for p in params]
+    torch_xla.sync()
+    torch.testing.assert_close(params[0].cpu(), expected + 1)
+    self.assertGreaterEqual(met.counter_value('AsyncBufferDeletions'), 100)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,61 @@
+import os
+import sys
+
+# Must be set before the computation cache is created.
+os.environ['XLA_ASYNC_COMPILATION'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+import torch_xla.runtime as xr
+from absl.testing import absltest
+
+
+class AsyncCompilationTest(absltest.TestCase):
+
+  def setUp(self):
+    met.clear_all()
+
+  def test_execution_waits_for_compilation(self):
+    t = torch.randn(4, 4)
+    xt = t.to('xla')
+    s = xt @ xt + 1
+    torch_xla.sync()
+    self.assertEqual(met.counter_value('AsyncCompile'), 1)
+    self.assertTrue(torch.allclose(s.cpu(), t @ t + 1, atol=1e-4))
+    self.assertEqual(xr.get_num_pending_compilations(), 0)
+
+  def test_executions_deferred_until_compiled(self):
+    t = torch.randn(8, 8)
+    xt = t.to('xla')
+    outputs = []
+    for i in range(3):
+      outputs.append(xt * (i + 2) - xt.sum())
+      torch_xla.sync()
+    for i, out in enumerate(outputs):
+      self.assertTrue(
+          torch.allclose(out.cpu(), t * (i + 2) - t.sum(), atol=1e-4))
+    self.assertEqual(xr.get_num_pending_compilations(), 0)
+
+  def test_warm_up_cache_compiles_in_background(self):
+    inputs = [torch.randn(size).to('xla') for size in (3, 5, 7)]
+    outputs = [xinput + xinput for xinput in inputs]
+    hashes = [torch_xla._XLAC._get_graph_hash([out]) for out in outputs]
+    for out in outputs:
+      torch_xla._XLAC._xla_warm_up_cache([out], [])
+    self.assertEqual(met.counter_value('AsyncCompile'), 3)
+
+    xr.wait_pending_compilations(hashes)
+    self.assertEqual(xr.get_num_pending_compilations(), 0)
+
+    # The warmed up graphs must be in the computation cache now.
+    for xinput, graph_hash in zip(inputs, hashes):
+      result = torch_xla._XLAC._run_cached_graph(graph_hash, [xinput])
+      self.assertEqual(len(result), 1)
+      self.assertTrue(torch.allclose(result[0].cpu(), xinput.cpu() * 2))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -2,6 +2,7 @@ import re
 import torch
 import torch_xla
 import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
 import unittest
 
 import torch_xla.distributed.spmd.xla_sharding as xs
@@ -103,6 +104,23 @@ class TestAutocastXla(unittest.TestCase):
         self.assertRegex(hlo, r".*convert.*f32.*convert.*bf16")
         self.assertRegex(hlo, r".*power.*f32.*power.*f32")
 
+  def test_weight_cast_cache(self):
+    weight = torch.randn(10, 10, device=device)
+    data = torch.randn(4, 10, device=device).to(torch.bfloat16)
+    met.clear_all()
+
+    with torch.autocast("xla"):
+      outputs = [torch.matmul(data, weight) for _ in range(3)]
+      self.assertEqual(met.counter_value('AutocastCastCacheHit'), 2)
+      hlo = torch_xla._XLAC._get_xla_tensors_hlo(outputs)
+      self.assertEqual(len(re.findall(r"convert.*f32\[10,10\]", hlo)), 1)
+      # An in place update of the weight casts it again.
+      with torch.no_grad():
+        weight.add_(1)
+      output = torch.matmul(data, weight)
+      self.assertEqual(met.counter_value('AutocastCastCacheHit'), 2)
+      self.assertEqual(output.dtype, torch.bfloat16)
+
 
 if __name__ == "__main__":
   unittest.main()
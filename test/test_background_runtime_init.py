@@ -0,0 +1,27 @@
+import os
+import sys
+
+# Must be set before importing torch_xla.
+os.environ['XLA_BACKGROUND_RUNTIME_INIT'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class BackgroundRuntimeInitTest(absltest.TestCase):
+
+  def test_first_device_access_waits_for_initialization(self):
+    t = torch.ones(4, 4, device=torch_xla.device()) * 2
+    torch_xla.sync()
+    self.assertTrue(torch_xla._XLAC._xla_runtime_is_initialized())
+    torch.testing.assert_close(t.cpu(), torch.full((4, 4), 2.0))
+    self.assertIn('StartupTime', met.metric_names())
+    self.assertIn('StartupClientCreateTime', met.metric_names())
+    self.assertIn('StartupDeviceSetupTime', met.metric_names())
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
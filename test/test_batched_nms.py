@@ -0,0 +1,98 @@
+import sys
+
+import torch
+import torch_xla
+from absl.testing import absltest, parameterized
+from torch_xla.experimental.batched_nms import batched_nms
+
+
+def _reference_nms(boxes, scores, classes, iou_threshold, score_threshold):
+  order = sorted(range(scores.numel()), key=lambda i: -scores[i].item())
+  area = (boxes[:, 2] - boxes[:, 0]) * (boxes[:, 3] - boxes[:, 1])
+  keep = []
+  for i in order:
+    if scores[i] <= score_threshold:
+      continue
+    suppressed = False
+    for j in keep:
+      if classes[i] != classes[j]:
+        continue
+      lo = torch.max(boxes[i, :2], boxes[j, :2])
+      hi = torch.min(boxes[i, 2:], boxes[j, 2:])
+      inter = (hi - lo).clamp(min=0).prod()
+      if inter / (area[i] + area[j] - inter) > iou_threshold:
+        suppressed = True
+        break
+    if not suppressed:
+      keep.append(i)
+  return keep
+
+
+class BatchedNmsTest(parameterized.TestCase):
+
+  def _inputs(self, batch_size, num_boxes, num_classes):
+    torch.manual_seed(0)
+    corners = torch.rand(batch_size, num_boxes, 2) * 10
+    sizes = torch.rand(batch_size, num_boxes, 2) * 5 + 1
+    boxes = torch.cat([corners, corners + sizes], dim=2)
+    # Distinct scores, so that the order of the boxes is unique.
+    scores = torch.randperm(batch_size * num_boxes).float().view(
+        batch_size, num_boxes) / (batch_size * num_boxes)
+    classes = torch.randint(0, num_classes, (batch_size, num_boxes))
+    return boxes, scores, classes
+
+  @parameterized.parameters((1, 1, 20), (3, 1, 20), (3, 4, 20), (2, 3, 64))
+  def test_batched_nms(self, num_classes, batch_size, max_output_size):
+    device = torch_xla.device()
+    boxes, scores, classes = self._inputs(batch_size, 40, num_classes)
+    indices, counts = batched_nms(
+        boxes.to(device),
+        scores.to(device),
+        classes.to(device),
+        iou_threshold=0.3,
+        max_output_size=max_output_size,
+        score_threshold=0.1)
+    self.assertEqual(indices.shape, (batch_size, max_output_size))
+    self.assertEqual(counts.shape, (batch_size,))
+    indices = indices.cpu()
+    counts = counts.cpu()
+    for b in range(batch_size):
+      keep = _reference_nms(boxes[b], scores[b], classes[b], 0.3,
+                            0.1)[:max_output_size]
+      self.assertEqual(counts[b].item(), len(keep))
+      self.assertEqual(indices[b, :len(keep)].tolist(), keep)
+      self.assertTrue(torch.all(indices[b, len(keep):] == -1))
+
+  def test_padding_boxes(self):
+    device = torch_xla.device()
+    boxes, scores, classes = self._inputs(2, 10, 2)
+    scores[1, 5:] = float('-inf')
+    indices, counts = batched_nms(
+        boxes.to(device),
+        scores.to(device),
+        classes.to(device),
+        iou_threshold=0.5,
+        max_output_size=10)
+    indices = indices.cpu()
+    for b in range(2):
+      keep = _reference_nms(boxes[b], scores[b], classes[b], 0.5,
+                            float('-inf'))
+      self.assertEqual(indices[b, :len(keep)].tolist(), keep)
+    self.assertTrue(torch.all(indices[1] < 5))
+
+  def test_single_graph(self):
+    device = torch_xla.device()
+    boxes, scores, classes = self._inputs(4, 16, 3)
+    indices, counts = batched_nms(
+        boxes.to(device),
+        scores.to(device),
+        classes.to(device),
+        iou_threshold=0.5,
+        max_output_size=8)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([indices, counts])
+    self.assertEqual(hlo.count(' while('), 1)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
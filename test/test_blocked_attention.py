@@ -0,0 +1,52 @@
+import os
+import sys
+
+os.environ['XLA_BLOCKED_ATTENTION'] = '1'
+os.environ['XLA_BLOCKED_ATTENTION_BLOCK_SIZE'] = '16'
+
+import torch
+import torch.nn.functional as F
+import torch_xla
+from absl.testing import absltest, parameterized
+
+
+class BlockedAttentionTest(parameterized.TestCase):
+
+  @parameterized.parameters((False, 40, 40), (True, 40, 40), (False, 24, 56),
+                            (True, 56, 56))
+  def test_matches_composite_attention(self, is_causal, query_len, key_len):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    q = torch.randn(2, 3, query_len, 8)
+    k = torch.randn(2, 3, key_len, 8)
+    v = torch.randn(2, 3, key_len, 4)
+    grad = torch.randn(2, 3, query_len, 4)
+
+    inputs = [t.clone().requires_grad_() for t in (q, k, v)]
+    expected = F.scaled_dot_product_attention(*inputs, is_causal=is_causal)
+    expected.backward(grad)
+
+    xla_inputs = [t.to(device).requires_grad_() for t in (q, k, v)]
+    output = F.scaled_dot_product_attention(*xla_inputs, is_causal=is_causal)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([output])
+    self.assertIn(' while(', hlo)
+    output.backward(grad.to(device))
+    torch_xla.sync()
+
+    torch.testing.assert_close(
+        output.cpu(), expected.detach(), atol=1e-4, rtol=1e-4)
+    for xla_input, input in zip(xla_inputs, inputs):
+      torch.testing.assert_close(
+          xla_input.grad.cpu(), input.grad, atol=1e-4, rtol=1e-4)
+
+  def test_short_sequences_use_composite_attention(self):
+    device = torch_xla.device()
+    q, k, v = (torch.randn(1, 2, 16, 8, device=device) for _ in range(3))
+    output = F.scaled_dot_product_attention(q, k, v)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([output])
+    self.assertNotIn(' while(', hlo)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,68 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest, parameterized
+from torch_xla.experimental import bounded_dynamism
+
+
+class BoundedDynamismTest(parameterized.TestCase):
+
+  def _assert_no_transfer(self):
+    self.assertNotIn('TransferFromDeviceTime', met.metric_names())
+
+  @parameterized.parameters((16,), (4, 8), (2, 3, 5))
+  def test_nonzero(self, *shape):
+    device = torch_xla.device()
+    input = torch.randint(0, 2, shape)
+    met.clear_all()
+    indices, count = bounded_dynamism.nonzero(input.to(device))
+    self.assertEqual(indices.shape, (input.numel(), input.dim()))
+    self.assertEqual(indices.dtype, torch.int64)
+    torch_xla.sync()
+    self._assert_no_transfer()
+
+    expected = torch.nonzero(input)
+    count = count.item()
+    self.assertEqual(count, expected.shape[0])
+    indices = indices.cpu()
+    torch.testing.assert_close(indices[:count], expected)
+    self.assertTrue(torch.all(indices[count:] == 0))
+
+  def test_masked_select(self):
+    device = torch_xla.device()
+    input = torch.randn(4, 8)
+    mask = input > 0
+    met.clear_all()
+    values, count = bounded_dynamism.masked_select(
+        input.to(device), mask.to(device))
+    self.assertEqual(values.shape, (input.numel(),))
+    self.assertEqual(values.dtype, input.dtype)
+    # The padded values reduce without a transfer of the count.
+    valid = bounded_dynamism.padding_mask(count, values.numel())
+    total = (values * valid).sum()
+    torch_xla.sync()
+    self._assert_no_transfer()
+
+    expected = torch.masked_select(input, mask)
+    torch.testing.assert_close(total.cpu(), expected.sum())
+    count = count.item()
+    self.assertEqual(count, expected.numel())
+    torch.testing.assert_close(values.cpu()[:count], expected)
+
+  def test_masked_select_broadcast(self):
+    device = torch_xla.device()
+    input = torch.randn(4, 8)
+    mask = torch.tensor([True, False] * 4)
+    values, count = bounded_dynamism.masked_select(
+        input.to(device), mask.to(device))
+    expected = torch.masked_select(input, mask)
+    count = count.item()
+    self.assertEqual(count, expected.numel())
+    torch.testing.assert_close(values.cpu()[:count], expected)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,64 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.utils.checkpoint as checkpoint
+from absl.testing import absltest, parameterized
+
+
+def _make_model(device):
+  torch.manual_seed(0)
+  return torch.nn.Sequential(
+      torch.nn.Linear(32, 64),
+      torch.nn.GELU(),
+      torch.nn.Linear(64, 32),
+  ).to(device)
+
+
+def _run(model, x, **kwargs):
+  if kwargs:
+    out = checkpoint.checkpoint(model, x, **kwargs)
+  else:
+    out = model(x)
+  out.sum().backward()
+  return [p.grad for p in model.parameters()] + [x.grad]
+
+
+class CheckpointPolicyTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      'nothing_saveable',
+      'dots_saveable',
+      checkpoint.dots_saveable,
+      lambda func: func.overloadpacket == torch.ops.aten.addmm,
+  )
+  def test_gradients_match(self, policy):
+    device = torch_xla.device()
+    x = torch.randn(8, 32, device=device)
+    expected = _run(_make_model(device), x.clone().requires_grad_())
+    grads = _run(
+        _make_model(device), x.clone().requires_grad_(), policy=policy)
+    torch_xla.sync()
+    for grad, expected_grad in zip(grads, expected):
+      torch.testing.assert_close(grad.cpu(), expected_grad.cpu())
+
+  def test_dots_are_not_recomputed(self):
+    device = torch_xla.device()
+
+    def count_dots(policy):
+      x = torch.randn(8, 32, device=device, requires_grad=True)
+      grads = _run(_make_model(device), x, policy=policy)
+      hlo = torch_xla._XLAC._get_xla_tensors_hlo(grads)
+      torch_xla.sync()
+      return hlo.count(' dot(')
+
+    self.assertLess(count_dots('dots_saveable'), count_dots('nothing_saveable'))
+
+  def test_unknown_policy(self):
+    with self.assertRaisesRegex(ValueError, 'Unknown remat policy'):
+      checkpoint.checkpoint(torch.sin, torch.zeros(2), policy='everything')
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,72 @@
+import sys
+
+import torch
+import torch.nn.functional as F
+import torch_xla
+from torch_xla.experimental.chunked_cross_entropy import chunked_cross_entropy
+from absl.testing import absltest, parameterized
+
+
+class ChunkedCrossEntropyTest(parameterized.TestCase):
+
+  @parameterized.parameters(('mean', 16), ('sum', 7), ('none', 100))
+  def test_matches_cross_entropy(self, reduction, chunk_size):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    logits = torch.randn(3, 5, 50) * 4
+    target = torch.randint(0, 50, (3, 5))
+    target[0, 1] = -100
+
+    expected_logits = logits.clone().requires_grad_()
+    expected = F.cross_entropy(
+        expected_logits.reshape(-1, 50),
+        target.reshape(-1),
+        reduction=reduction)
+    if reduction == 'none':
+      expected = expected.reshape(target.shape)
+    expected.sum().backward()
+
+    xla_logits = logits.to(device).requires_grad_()
+    loss = chunked_cross_entropy(
+        xla_logits,
+        target.to(device),
+        reduction=reduction,
+        chunk_size=chunk_size)
+    loss.sum().backward()
+    torch_xla.sync()
+
+    torch.testing.assert_close(loss.cpu(), expected.detach())
+    torch.testing.assert_close(xla_logits.grad.cpu(), expected_logits.grad)
+
+  def test_lowers_to_loops(self):
+    device = torch_xla.device()
+    logits = torch.randn(4, 64, device=device, requires_grad=True)
+    target = torch.randint(0, 64, (4,), device=device)
+    loss = chunked_cross_entropy(logits, target, chunk_size=16)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([loss])
+    self.assertIn(' while(', hlo)
+    self.assertNotIn('exponential(f32[4,64]', hlo)
+    loss.backward()
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([logits.grad])
+    self.assertIn(' while(', hlo)
+
+  def test_bfloat16_logits(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    logits = torch.randn(8, 40).to(torch.bfloat16)
+    target = torch.randint(0, 40, (8,))
+
+    xla_logits = logits.to(device).requires_grad_()
+    loss = chunked_cross_entropy(xla_logits, target.to(device), chunk_size=16)
+    loss.backward()
+    torch_xla.sync()
+
+    expected = F.cross_entropy(logits.float(), target)
+    self.assertEqual(xla_logits.grad.dtype, torch.bfloat16)
+    torch.testing.assert_close(
+        loss.cpu().float(), expected, atol=1e-2, rtol=1e-2)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,36 @@
+import os
+import sys
+
+os.environ['XLA_COMPILATION_CACHE_IDLE_STEPS'] = '2'
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class CompilationCacheIdleUnloadTest(absltest.TestCase):
+
+  def test_idle_executables_are_reloaded_without_recompiling(self):
+    device = torch_xla.device()
+    x = torch.rand(8, 8).to(device)
+    torch_xla.sync()
+    met.clear_all()
+    y = x * 2
+    torch_xla.sync()
+    # Another graph runs for long enough to get the first one unloaded.
+    for _ in range(4):
+      z = x + 1
+      torch_xla.sync()
+    self.assertGreaterEqual(met.counter_value('CompilationCacheIdleUnloads'), 1)
+    num_compiles = met.metric_data('CompileTime')[0]
+    y = x * 2
+    torch_xla.sync()
+    self.assertEqual(met.metric_data('CompileTime')[0], num_compiles)
+    self.assertEqual(met.counter_value('PersistentCacheHit'), 1)
+    torch.testing.assert_close(y.cpu(), x.cpu() * 2)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,51 @@
+import os
+import sys
+
+# Set before the runtime reads them.
+os.environ['XLA_COMPILE_OPTION_CANDIDATES'] = (
+    'xla_cpu_enable_fast_math=false;xla_cpu_enable_fast_min_max=false')
+os.environ['XLA_COMPILE_OPTION_AUTOTUNE_MIN_EXECUTIONS'] = '2'
+os.environ['XLA_COMPILE_OPTION_AUTOTUNE_SAMPLES'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+def step(x, y):
+  return (x @ y).tanh() + x
+
+
+class CompileOptionAutotuneTest(absltest.TestCase):
+
+  def test_hot_graph_is_tuned_once(self):
+    device = torch_xla.device()
+    x, y = torch.rand(8, 8), torch.rand(8, 8)
+    xx, xy = x.to(device), y.to(device)
+    torch_xla.sync()
+    met.clear_counters()
+    expected = step(x, y)
+    for _ in range(12):
+      # The executions alternate between the candidates once compiled, all of
+      # which compute the same results.
+      result = step(xx, xy)
+      torch_xla.sync()
+      xm.wait_device_ops()
+      torch.testing.assert_close(result.cpu(), expected)
+    self.assertEqual(met.counter_value('CompileOptionAutotune'), 1)
+
+  def test_cold_graph_is_not_tuned(self):
+    device = torch_xla.device()
+    xx = torch.rand(8, 8).to(device)
+    torch_xla.sync()
+    met.clear_counters()
+    result = xx * 3 - 1
+    torch_xla.sync()
+    self.assertIsNone(met.counter_value('CompileOptionAutotune'))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
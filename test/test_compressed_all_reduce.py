@@ -0,0 +1,63 @@
+import os
+import sys
+
+# Set before the runtime reads it, so that the single device reduces too.
+os.environ['XLA_ALWAYS_ALLREDUCE'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class CompressedAllReduceTest(absltest.TestCase):
+
+  def test_bf16_reduction(self):
+    device = torch_xla.device()
+    t = torch.rand(32, 32)
+    xt = t.to(device)
+    met.clear_counters()
+    result = xm.all_reduce(xm.REDUCE_SUM, xt, reduce_dtype=torch.bfloat16)
+    self.assertIn('reduce_element_type=bf16',
+                  torch_xla._XLAC._get_xla_tensors_text([result]))
+    self.assertEqual(result.dtype, torch.float32)
+    torch.testing.assert_close(result.cpu(), t.bfloat16().float())
+    self.assertEqual(met.counter_value('CompressedAllReduceOperands'), 1)
+
+  def test_error_feedback(self):
+    device = torch_xla.device()
+    tensors = [torch.rand(16, 16), torch.rand(8)]
+    xtensors = [t.to(device) for t in tensors]
+    residuals = [torch.zeros_like(t, device=device) for t in xtensors]
+    xm.all_reduce(
+        xm.REDUCE_SUM,
+        xtensors,
+        reduce_dtype=torch.bfloat16,
+        residuals=residuals)
+    torch_xla.sync()
+    for t, xt, residual in zip(tensors, xtensors, residuals):
+      torch.testing.assert_close(xt.cpu(), t.bfloat16().float())
+      torch.testing.assert_close(residual.cpu(), t - t.bfloat16().float())
+
+  def test_fp8_reduction_scaled_into_range(self):
+    device = torch_xla.device()
+    # Beyond the float8_e4m3fn range, unless scaled.
+    t = torch.rand(64) * 1e4
+    result = xm.all_reduce(
+        xm.REDUCE_SUM, t.to(device), reduce_dtype=torch.float8_e4m3fn)
+    torch.testing.assert_close(result.cpu(), t, rtol=0.07, atol=20.0)
+
+  def test_integer_inputs_not_compressed(self):
+    device = torch_xla.device()
+    t = torch.randint(0, 1 << 20, (16,))
+    met.clear_counters()
+    result = xm.all_reduce(
+        xm.REDUCE_SUM, t.to(device), reduce_dtype=torch.bfloat16)
+    torch.testing.assert_close(result.cpu(), t)
+    self.assertIsNone(met.counter_value('CompressedAllReduceOperands'))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
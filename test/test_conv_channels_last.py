@@ -0,0 +1,53 @@
+import os
+import sys
+
+os.environ['XLA_CONV_LAYOUT'] = 'nhwc'
+
+import torch
+import torch_xla
+from absl.testing import absltest, parameterized
+
+
+class ConvChannelsLastTest(parameterized.TestCase):
+
+  @parameterized.product(
+      groups=[1, 4], bias=[True, False], stride=[1, 2], dims=[2, 3])
+  def test_conv(self, groups, bias, stride, dims):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    conv_cls = torch.nn.Conv2d if dims == 2 else torch.nn.Conv3d
+    conv = conv_cls(
+        8, 16, 3, stride=stride, padding=1, groups=groups, bias=bias)
+    input = torch.randn((2, 8) + (9,) * dims, requires_grad=True)
+    conv(input).sum().backward()
+
+    xla_conv = conv_cls(
+        8, 16, 3, stride=stride, padding=1, groups=groups,
+        bias=bias).to(device)
+    xla_conv.load_state_dict(conv.state_dict())
+    xla_input = input.detach().to(device).requires_grad_()
+    output = xla_conv(xla_input)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([output])
+    self.assertIn('dim_labels=b' + '012'[:dims] + 'f_', hlo)
+    output.sum().backward()
+
+    torch.testing.assert_close(
+        output.cpu(), conv(input), rtol=1e-4, atol=1e-4)
+    torch.testing.assert_close(
+        xla_input.grad.cpu(), input.grad, rtol=1e-4, atol=1e-4)
+    torch.testing.assert_close(
+        xla_conv.weight.grad.cpu(), conv.weight.grad, rtol=1e-4, atol=1e-4)
+
+  def test_transposed_conv(self):
+    device = torch_xla.device()
+    conv = torch.nn.ConvTranspose2d(8, 4, 3, stride=2)
+    input = torch.randn(2, 8, 7, 7)
+    xla_conv = torch.nn.ConvTranspose2d(8, 4, 3, stride=2).to(device)
+    xla_conv.load_state_dict(conv.state_dict())
+    torch.testing.assert_close(
+        xla_conv(input.to(device)).cpu(), conv(input), rtol=1e-4, atol=1e-4)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,50 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class CpuAsyncTest(absltest.TestCase):
+
+  def setUp(self):
+    met.clear_all()
+
+  def test_matches_cpu(self):
+    x = torch.randn(8, 8)
+    xla_x = x.to('xla')
+    loss = (xla_x @ xla_x).sum()
+    transfer = xm.cpu_async([loss, xla_x])
+    self.assertEqual(met.counter_value('GetTensorsAsync'), 1)
+    # The pending graph was executed by the call.
+    self.assertIn('ExecuteTime', met.metric_names())
+    cpu_loss, cpu_x = transfer.wait()
+    self.assertTrue(transfer.is_ready())
+    torch.testing.assert_close(cpu_loss, (x @ x).sum(), rtol=1e-4, atol=1e-4)
+    self.assertTrue(torch.equal(cpu_x, x))
+    # Waiting again returns the same values.
+    self.assertTrue(torch.equal(transfer.wait()[0], cpu_loss))
+
+  def test_overlaps_with_next_step(self):
+    w = torch.randn(16, 16).to('xla')
+    transfers = []
+    for _ in range(3):
+      w = w * 0.5 + 1
+      torch_xla.sync()
+      transfers.append(xm.cpu_async([w.sum()]))
+    expected = w.sum().cpu()
+    self.assertEqual(transfers[-1].wait()[0].item(), expected.item())
+    for transfer in transfers:
+      self.assertEqual(transfer.wait()[0].dtype, torch.float32)
+
+  def test_cpu_data_tensor(self):
+    t = torch.tensor([1.0, 2.0], device='xla')
+    cpu_t, = xm.cpu_async([t]).wait()
+    self.assertTrue(torch.equal(cpu_t, torch.tensor([1.0, 2.0])))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,68 @@
+import os
+import sys
+
+os.environ['XLA_DOWNCAST_INDICES'] = '1'
+
+import torch
+import torch.nn.functional as F
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class DowncastIndicesTest(absltest.TestCase):
+
+  def _assert_downcast(self, fn, *args):
+    device = torch_xla.device()
+    expected = fn(*args)
+    met.clear_counters()
+    output = fn(*[arg.to(device) for arg in args])
+    self.assertGreater(met.counter_value('DowncastIndex'), 0)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([output])
+    self.assertIn('s32[', hlo)
+    torch.testing.assert_close(output.cpu(), expected)
+
+  def test_gather(self):
+    input = torch.randn(6, 7)
+    index = torch.randint(0, 7, (6, 3))
+    self._assert_downcast(lambda x, i: torch.gather(x, 1, i), input, index)
+
+  def test_scatter(self):
+    input = torch.randn(6, 7)
+    index = torch.randint(0, 6, (4, 7))
+    src = torch.randn(4, 7)
+    self._assert_downcast(lambda x, i, s: x.scatter_add(0, i, s), input,
+                          index, src)
+
+  def test_index_select(self):
+    input = torch.randn(10, 4)
+    index = torch.randint(0, 10, (5,))
+    self._assert_downcast(lambda x, i: torch.index_select(x, 0, i), input,
+                          index)
+
+  def test_embedding(self):
+    weight = torch.randn(100, 8)
+    indices = torch.randint(0, 100, (4, 16))
+    self._assert_downcast(lambda w, i: F.embedding(i, w), weight, indices)
+
+  def test_index_and_index_put(self):
+    input = torch.randn(10, 5)
+    index = torch.tensor([-1, 0, 3, -4])
+    values = torch.randn(4, 5)
+    self._assert_downcast(lambda x, i: x[i], input, index)
+    self._assert_downcast(
+        lambda x, i, v: x.index_put((i,), v, accumulate=True), input, index,
+        values)
+
+  def test_int32_index_not_cast_back(self):
+    device = torch_xla.device()
+    input = torch.randn(10, 4, device=device)
+    index = torch.randint(0, 10, (5,), dtype=torch.int32, device=device)
+    output = torch.index_select(input, 0, index.long())
+    ir = torch_xla._XLAC._get_xla_tensors_text([output])
+    self.assertNotIn('xla::cast', ir)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
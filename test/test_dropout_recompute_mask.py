@@ -0,0 +1,50 @@
+import os
+import sys
+
+os.environ['XLA_DROPOUT_RECOMPUTE_MASK'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class DropoutRecomputeMaskTest(absltest.TestCase):
+
+  def test_gradient_matches_forward_mask(self):
+    device = torch_xla.device()
+    met.clear_all()
+    x = torch.randn(256, 256, device=device, requires_grad=True)
+    out, mask = torch.native_dropout(x, 0.5, True)
+    self.assertEqual(met.counter_value('DropoutMaskRecomputed'), 1)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([mask])
+    self.assertIn('opt-barrier', hlo)
+    grad = torch.native_dropout_backward(torch.ones_like(out), mask, 2.0)
+    out, mask, grad = out.cpu(), mask.cpu(), grad.cpu()
+    self.assertEqual(mask.dtype, torch.bool)
+    # The regenerated mask keeps the same elements as the forward.
+    torch.testing.assert_close(mask, out != 0)
+    torch.testing.assert_close(grad, mask.float() * 2.0)
+
+  def test_dropout_backward(self):
+    device = torch_xla.device()
+    x = torch.randn(128, 128, device=device, requires_grad=True)
+    out = torch.nn.functional.dropout(x, p=0.5, training=True)
+    out.sum().backward()
+    torch_xla.sync()
+    kept = out.detach().cpu() != 0
+    expected = torch.where(kept, 2.0, 0.0)
+    torch.testing.assert_close(x.grad.cpu(), expected)
+
+  def test_eval_keeps_forward_mask(self):
+    device = torch_xla.device()
+    met.clear_all()
+    x = torch.randn(16, 16, device=device)
+    out, mask = torch.native_dropout(x, 0.5, False)
+    self.assertFalse(met.counter_value('DropoutMaskRecomputed'))
+    self.assertTrue(torch.all(mask.cpu()))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
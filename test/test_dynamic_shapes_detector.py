@@ -2,6 +2,7 @@ import re
 import textwrap
 import torch
 import torch_xla
+import torch_xla.debug.metrics
 import test_utils
 import unittest
 
@@ -249,6 +250,41 @@ class TestDynamicShapeDetector(test_utils.XlaTestCase):
       self._run_and_compare(
           foo, args=(inp, 2), max_different_graphs=max_different_graphs)
 
+  def test_shape_buckets_bound_graphs(self):
+    # Test: the varying dimension is padded to powers of two, so that sizes
+    # 6~8 share a single graph, on top of the one traced for size 5.
+
+    def foo(x):
+      return x * 2
+
+    optfoo = torch_xla.compile(
+        foo, max_different_graphs=2, shape_buckets=True)
+    for size in range(5, 9):
+      inp = torch.rand(size, 4, device='xla')
+      out = optfoo(inp)
+      self.assertEqual(out.shape, inp.shape)
+      self.assertEqual(out, foo(inp))
+
+  def test_shape_buckets_ladder_and_mask(self):
+    # Test: the varying dimension is padded to the given ladder, and the mask
+    # marks the valid elements.
+
+    def foo(x, padding_masks):
+      mask = padding_masks[0]
+      if mask is None:
+        return x.sum()
+      return (x * mask).sum()
+
+    torch_xla.debug.metrics.clear_counters()
+    optfoo = torch_xla.compile(foo, shape_buckets=[16, 32])
+    for size in (10, 12, 20):
+      inp = torch.rand(size, device='xla')
+      self.assertEqual(optfoo(inp), inp.sum())
+
+    self.assertEqual(
+        torch_xla.debug.metrics.counter_value('ShapeBucketingPaddingElements'),
+        (16 - 12) + (32 - 20))
+
 
 if __name__ == "__main__":
   unittest.main()
@@ -0,0 +1,72 @@
+import sys
+
+import torch
+import torch_xla
+from absl.testing import absltest
+from torch_xla.experimental.fp8 import Fp8Linear, fp8_dot
+
+
+class Fp8DotTest(absltest.TestCase):
+
+  def _state(self, device, history_len=4):
+    return (torch.ones([], device=device),
+            torch.zeros([history_len], device=device))
+
+  def test_delayed_scaling(self):
+    device = torch_xla.device()
+    x = torch.randn(16, 32)
+    w = torch.randn(8, 32)
+    x_scale, x_history = self._state(device)
+    w_scale, w_history = self._state(device)
+    xla_x, xla_w = x.to(device), w.to(device)
+    for step in range(3):
+      output = fp8_dot(xla_x, xla_w, x_scale, w_scale, x_history, w_history)
+      hlo = torch_xla._XLAC._get_xla_tensors_text([output, x_scale, x_history])
+      self.assertIn('xla::fp8_dot', hlo)
+      torch_xla.sync()
+      torch.testing.assert_close(
+          output.cpu(), x @ w.t(), rtol=0.15, atol=0.15 * 32**0.5)
+    # The amax of the unchanged operand fills the history.
+    torch.testing.assert_close(x_history.cpu()[:3],
+                               x.abs().max().repeat(3))
+    self.assertEqual(x_history.cpu()[3].item(), 0.0)
+    torch.testing.assert_close(x_scale.cpu(), 448.0 / x.abs().max())
+    torch.testing.assert_close(w_scale.cpu(), 448.0 / w.abs().max())
+
+  def test_scale_kept_without_amax(self):
+    device = torch_xla.device()
+    x = torch.zeros(4, 8, device=device)
+    w = torch.ones(2, 8, device=device)
+    x_scale, x_history = self._state(device)
+    w_scale, w_history = self._state(device)
+    x_scale.fill_(2.0)
+    fp8_dot(x, w, x_scale, w_scale, x_history, w_history, margin=1)
+    torch_xla.sync()
+    self.assertEqual(x_scale.cpu().item(), 2.0)
+    self.assertEqual(w_scale.cpu().item(), 448.0 / 2)
+
+  def test_fp8_linear(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    linear = torch.nn.Linear(32, 16)
+    fp8_linear = Fp8Linear(32, 16, amax_history_len=8)
+    fp8_linear.load_state_dict(linear.state_dict(), strict=False)
+    linear, fp8_linear = linear.to(device), fp8_linear.to(device)
+    x = torch.randn(4, 32, device=device, requires_grad=True)
+    fp8_x = x.detach().clone().requires_grad_()
+    for _ in range(2):
+      linear(x).sum().backward()
+      fp8_linear(fp8_x).sum().backward()
+      torch_xla.sync()
+    torch.testing.assert_close(fp8_x.grad.cpu(), x.grad.cpu(), rtol=0.2,
+                               atol=0.1)
+    torch.testing.assert_close(fp8_linear.weight.grad.cpu(),
+                               linear.weight.grad.cpu(), rtol=0.2, atol=0.2)
+    for name in ('x', 'w', 'grad', 'w_t', 'grad_t', 'x_t'):
+      self.assertNotEqual(
+          getattr(fp8_linear, f'{name}_amax_history')[0].cpu().item(), 0.0)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
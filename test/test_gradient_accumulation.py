@@ -74,6 +74,34 @@ class GradAccumulationTest(XlaTestCase):
     super().compareResults([accum_carried_tensor_ga], [carried_tensor_manual])
     super().compareResults(model_ga.parameters(), model_manual.parameters())
 
+  def test_existing_grads(self):
+    """Accumulate into the gradients of an earlier accumulation"""
+    batch_size = 4
+    inputs = torch.randn(batch_size, 10).to(self.device)
+    targets = torch.randn(batch_size, 5).to(self.device)
+
+    def train_step_fw(input_batch, target_batch):
+      output = model_ga(input_batch)
+      return torch.nn.functional.mse_loss(output, target_batch)
+
+    torch.manual_seed(43)
+    model_ga = SimpleModel().to(self.device)
+    for _ in range(2):
+      gradient_accumulation(train_step_fw, (inputs, targets), model_ga)
+      torch_xla.sync()
+
+    torch.manual_seed(43)
+    model_manual = SimpleModel().to(self.device)
+    for _ in range(2):
+      for i in range(batch_size):
+        output = model_manual(inputs[i:i + 1])
+        loss = torch.nn.functional.mse_loss(output, targets[i:i + 1])
+        (loss / batch_size).backward()
+      torch_xla.sync()
+
+    super().compareResults([p.grad for p in model_ga.parameters()],
+                           [p.grad for p in model_manual.parameters()])
+
   def test_with_carried_tensors(self):
     """Test gradient accumulation with carried tensors, including with RNG"""
     batch_size = 2
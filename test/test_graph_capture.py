@@ -0,0 +1,53 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from torch_xla.experimental.graph_capture import capture
+from absl.testing import absltest
+
+
+class GraphCaptureTest(absltest.TestCase):
+
+  def setUp(self):
+    met.clear_all()
+
+  def test_replay_matches_eager(self):
+    w = torch.randn(4, 4).to('xla')
+
+    def fn(x):
+      return {'out': x @ w + 1, 'scale': 2}
+
+    graph, out = capture(fn, torch.randn(4, 4).to('xla'))
+    self.assertEqual(out['scale'], 2)
+    compiles = met.metric_data('CompileTime')[0]
+    for _ in range(3):
+      x = torch.randn(4, 4)
+      out = graph.replay(x.to('xla'))
+      self.assertEqual(out['scale'], 2)
+      self.assertTrue(
+          torch.allclose(out['out'].cpu(), x @ w.cpu() + 1, atol=1e-4))
+    self.assertEqual(met.metric_data('CompileTime')[0], compiles)
+    self.assertEqual(met.metric_data('ReplayGraph')[0], 3)
+
+  def test_replay_updates_inputs_in_place(self):
+
+    def fn(acc, x):
+      acc.add_(x)
+      return acc * 2
+
+    acc = torch.zeros(8).to('xla')
+    graph, _ = capture(fn, acc, torch.ones(8).to('xla'))
+    out = graph.replay(acc, torch.full((8,), 2.0).to('xla'))
+    self.assertTrue(torch.allclose(acc.cpu(), torch.full((8,), 3.0)))
+    self.assertTrue(torch.allclose(out.cpu(), torch.full((8,), 6.0)))
+
+  def test_replay_rejects_other_shapes(self):
+    graph, _ = capture(lambda x: x + 1, torch.zeros(4).to('xla'))
+    with self.assertRaises(RuntimeError):
+      graph.replay(torch.zeros(5).to('xla'))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
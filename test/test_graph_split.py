@@ -0,0 +1,58 @@
+import os
+import sys
+
+# Set before the runtime reads them.
+os.environ['XLA_GRAPH_SPLIT_MAX_NODES'] = '16'
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+def chain(x, y, steps):
+  for _ in range(steps):
+    x = (x * 0.5 + y).tanh()
+  return x
+
+
+class GraphSplitTest(absltest.TestCase):
+
+  def test_split_matches_whole_graph(self):
+    device = torch_xla.device()
+    x, y = torch.rand(4, 4), torch.rand(4, 4)
+    xx, xy = x.to(device), y.to(device)
+    torch_xla.sync()
+    met.clear_counters()
+    result = chain(xx, xy, 20)
+    torch_xla.sync()
+    torch.testing.assert_close(result.cpu(), chain(x, y, 20))
+    self.assertEqual(met.counter_value('GraphSplits'), 1)
+    self.assertGreater(met.counter_value('GraphSplitPieces'), 2)
+
+  def test_pieces_are_cached(self):
+    device = torch_xla.device()
+    x, y = torch.rand(4, 4), torch.rand(4, 4)
+    xx, xy = x.to(device), y.to(device)
+    torch_xla.sync()
+    chain(xx, xy, 30)
+    torch_xla.sync()
+    compilations = met.metric_data('CompileTime')[0]
+    result = chain(xx, xy, 30)
+    torch_xla.sync()
+    torch.testing.assert_close(result.cpu(), chain(x, y, 30))
+    self.assertEqual(met.metric_data('CompileTime')[0], compilations)
+
+  def test_small_graph_not_split(self):
+    device = torch_xla.device()
+    xx = torch.rand(4, 4).to(device)
+    torch_xla.sync()
+    met.clear_counters()
+    result = xx * 2 + 1
+    torch_xla.sync()
+    self.assertIsNone(met.counter_value('GraphSplits'))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,35 @@
+import os
+import sys
+
+# Must be set before the first execution.
+os.environ['XLA_INLINE_EXECUTION'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class InlineExecutionTest(absltest.TestCase):
+
+  def setUp(self):
+    met.clear_all()
+
+  def _step(self, x):
+    y = x @ x + 1
+    torch_xla.sync()
+    return y
+
+  def test_executes_on_calling_thread(self):
+    x = torch.randn(8, 8)
+    xla_x = x.to('xla')
+    for step in range(1, 3):
+      y = self._step(xla_x)
+      self.assertEqual(met.counter_value('InlineExecution'), step)
+    torch.testing.assert_close(y.cpu(), x @ x + 1, rtol=1e-4, atol=1e-4)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
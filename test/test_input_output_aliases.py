@@ -11,6 +11,7 @@ import torch.nn.functional as F
 import torch_xla
 import torch_xla.core.xla_model as xm
 import torch_xla.debug.metrics as met
+from torch_xla.experimental import kv_cache
 
 
 def create_xla_config_context(set_func, get_func):
@@ -273,9 +274,38 @@ class InputOutputAliasesTest(parameterized.TestCase):
       # no longer present for the IR node.
       self.assertEqual(
           torch_xla._XLAC._is_placecholder(t0), enable_buffer_donor_config)
+      # The old buffer of t1 is dead after the sync, so it is donated without
+      # being marked.
       self.assertEqual(
           met.metric_data("InputOutputAliasCount")[1],
-          enable_buffer_donor_config)
+          enable_buffer_donor_config + 1)
+
+  def test_auto_donation_of_dead_parameter(self):
+    xla_device = torch_xla.device()
+    t0 = torch.randn(4, 2, 2).to(xla_device)
+    t1 = torch.randn(4, 2, 2).to(xla_device)
+    expected = t0.cpu() * 2
+    met.clear_all()
+    t2 = t0 * 2
+    del t0
+    # Neither the LTC nor the user config donation applies to a partial sync
+    # without sync_xla_data.
+    torch_xla._XLAC._xla_sync_multi([t1, t2], [str(xla_device)], True, False)
+    self.assertEqual(met.counter_value("AutoBufferDonations"), 1)
+    self.assertEqual(met.metric_data("InputOutputAliasCount")[1], 1.0)
+    torch.testing.assert_close(t2.cpu(), expected)
+
+  def test_no_auto_donation_of_live_parameter(self):
+    xla_device = torch_xla.device()
+    t0 = torch.randn(4, 2, 2).to(xla_device)
+    expected = t0.cpu()
+    met.clear_all()
+    t1 = t0 * 2
+    t2 = t0 + 1
+    # t0 holds its buffer, and the pending graph of t2 reads it too.
+    torch_xla._XLAC._xla_sync_multi([t1], [str(xla_device)], True, False)
+    self.assertNotIn("AutoBufferDonations", met.counter_names())
+    torch.testing.assert_close(t2.cpu(), expected + 1)
 
   def test_user_config_donation_with_ltc_donation_overlap(self):
     met.clear_all()
@@ -339,6 +369,24 @@ class InputOutputAliasesTest(parameterized.TestCase):
     torch_xla.sync()
     self.assertTrue(torch_xla._XLAC._get_buffer_donation(input))
 
+  def test_kv_cache_update_aliasing(self):
+    xla_device = torch_xla.device()
+    cache = torch.zeros(2, 16, 8)
+    xla_cache = cache.to(xla_device)
+    torch_xla.sync()
+    met.clear_all()
+    for step in range(4):
+      update = torch.randn(2, 1, 8)
+      cache[:, step:step + 1] = update
+      index = torch.tensor([0, step, 0]).to(xla_device)
+      kv_cache.update_(xla_cache, update.to(xla_device), index)
+      torch_xla.sync()
+      self.assertEqual(met.metric_data("InputOutputAliasCount")[1], 1.0)
+    self.assertNotIn("DynamicUpdateSliceNotAliased", met.counter_names())
+    # The indices are data, so every step runs the same graph.
+    self.assertEqual(met.metric_data("CompileTime")[0], 1)
+    self.assertTrue(torch.allclose(xla_cache.cpu(), cache))
+
 
 def test_device_data_node_tracing_aliasing(self):
   """
@@ -0,0 +1,32 @@
+import os
+import sys
+
+# Must be set before the first IR node is created.
+os.environ['XLA_IR_DEBUG'] = '1'
+os.environ['XLA_IR_DEBUG_OP_KINDS'] = 'aten::mul'
+
+import torch
+import torch_xla
+from absl.testing import absltest
+
+
+class IrDebugSamplingTest(absltest.TestCase):
+
+  def test_only_selected_op_kinds_capture_frames(self):
+    device = torch_xla.device()
+    x = torch.randn(4, 4, device=device)
+    y = (x + 1) * 2
+    lines = torch_xla._XLAC._get_xla_tensors_text([y]).split('\n')
+    mul_lines = [line for line in lines if 'aten::mul' in line]
+    add_lines = [line for line in lines if 'aten::add' in line]
+    self.assertNotEqual(mul_lines, [])
+    self.assertNotEqual(add_lines, [])
+    for line in mul_lines:
+      self.assertIn('location=', line)
+    for line in add_lines:
+      self.assertNotIn('location=', line)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
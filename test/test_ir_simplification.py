@@ -0,0 +1,40 @@
+import os
+import sys
+
+# Set before the runtime reads it.
+os.environ['XLA_IR_SIMPLIFY'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class IrSimplificationTest(absltest.TestCase):
+
+  def test_duplicate_nodes_lowered_once(self):
+    device = torch_xla.device()
+    t = torch.rand(4, 8)
+    xt = t.to(device)
+    torch_xla.sync()
+    met.clear_all()
+    a = xt.t().exp()
+    b = xt.t().exp()
+    result = a + b
+    torch_xla.sync()
+    torch.testing.assert_close(result.cpu(), t.t().exp() * 2)
+    # The second transpose and exp.
+    self.assertGreaterEqual(met.counter_value('IrDeduplicatedNodes'), 2)
+    self.assertIn('IrSimplifiedNodes', met.metric_names())
+
+  def test_random_ops_not_merged(self):
+    device = torch_xla.device()
+    a = torch.rand(64, device=device)
+    b = torch.rand(64, device=device)
+    torch_xla.sync()
+    self.assertFalse(torch.equal(a.cpu(), b.cpu()))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
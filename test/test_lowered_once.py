@@ -0,0 +1,66 @@
+import sys
+
+import torch
+import torch_xla
+from torch_xla.experimental.lowered_once import lowered_once
+from absl.testing import absltest
+
+
+class Layer(torch.nn.Module):
+
+  def __init__(self):
+    super().__init__()
+    self.linear = torch.nn.Linear(8, 8)
+
+  def forward(self, x):
+    return torch.relu(self.linear(x)) + x
+
+
+class LoweredOnceTest(absltest.TestCase):
+
+  def test_layers_share_computation(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    layers = [Layer().to(device) for _ in range(3)]
+    reference = [Layer().to(device) for _ in range(3)]
+    for layer, ref in zip(layers, reference):
+      ref.load_state_dict(layer.state_dict())
+    x = torch.rand(4, 8, device=device)
+
+    y = x
+    for layer in map(lowered_once, layers):
+      y = layer(y)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([y])
+    self.assertEqual(hlo.count(' call('), len(layers))
+    y.sum().backward()
+
+    expected = x
+    for ref in reference:
+      expected = ref(expected)
+    expected.sum().backward()
+    torch_xla.sync()
+
+    torch.testing.assert_close(y.cpu(), expected.cpu())
+    for layer, ref in zip(layers, reference):
+      torch.testing.assert_close(layer.linear.weight.grad.cpu(),
+                                 ref.linear.weight.grad.cpu())
+
+  def test_function_with_pytree_outputs(self):
+    device = torch_xla.device()
+
+    @lowered_once
+    def fn(a, b):
+      return {'sum': a + b, 'prod': a * b}
+
+    a = torch.rand(4, device=device)
+    b = torch.rand(4, device=device)
+    first = fn(a, b)
+    second = fn(b, a)
+    torch_xla.sync()
+    torch.testing.assert_close(first['sum'].cpu(), (a + b).cpu())
+    torch.testing.assert_close(second['prod'].cpu(), (a * b).cpu())
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
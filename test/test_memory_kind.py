@@ -0,0 +1,31 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+from absl.testing import absltest
+
+
+class MemoryKindTest(absltest.TestCase):
+
+  def test_get_memory_kind(self):
+    xt = torch.randn(4, 4).to('xla') + 1
+    self.assertIsInstance(xm.get_memory_kind(xt), str)
+
+  def test_same_memory_kind_keeps_values(self):
+    t = torch.randn(4, 4)
+    xt = t.to('xla')
+    memory_kind = xm.get_memory_kind(xt)
+    self.assertIs(xm.set_memory_kind(xt, memory_kind), xt)
+    self.assertEqual(xm.get_memory_kind(xt), memory_kind)
+    self.assertTrue(torch.allclose((xt * 2).cpu(), t * 2))
+
+  def test_unknown_memory_kind(self):
+    xt = torch.randn(4, 4).to('xla')
+    with self.assertRaises(RuntimeError):
+      xm.set_memory_kind(xt, 'no_such_memory')
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,49 @@
+import os
+import sys
+import unittest
+
+os.environ['XLA_MEMORY_SAMPLER'] = '1'
+os.environ['XLA_MEMORY_SAMPLER_INTERVAL_MS'] = '10'
+os.environ['XLA_MEMORY_SAMPLER_WARMUP_STEPS'] = '2'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+import torch_xla.runtime as xr
+from absl.testing import absltest
+
+
+@unittest.skipIf(xr.device_type() not in ('TPU', 'CUDA'),
+                 'Requires a device reporting its memory')
+class MemorySamplerTest(absltest.TestCase):
+
+  def test_step_peaks(self):
+    device = torch_xla.device()
+    tensors = []
+    for _ in range(6):
+      # Keep the peak growing after the warmup steps.
+      tensors.append(torch.ones(4096, 4096, device=device))
+      xm.mark_step()
+      xm.wait_device_ops()
+    # Closes the last step, after its execution completed.
+    xm.mark_step()
+
+    real_device = torch_xla._XLAC._xla_real_devices([str(device)])[0]
+    history = met.memory_history()
+    self.assertIn(real_device, history)
+    device_history = history[real_device]
+    self.assertGreater(device_history['bytes_limit'], 0)
+    self.assertNotEqual(device_history['samples'], [])
+    self.assertGreaterEqual(device_history['samples'][-1]['bytes_used'],
+                            len(tensors) * 4096 * 4096 * 4)
+    steps = [peak['step'] for peak in device_history['step_peaks']]
+    self.assertEqual(steps, sorted(steps))
+    self.assertGreater(device_history['growth_alerts'], 0)
+    self.assertIn('DeviceMemoryGrowthAlert', met.counter_names())
+    self.assertIn(f'DeviceMemoryStepPeak/{real_device}', met.metric_names())
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -1,4 +1,6 @@
+import json
 import os
+import tempfile
 import time
 
 import torch
@@ -59,6 +61,143 @@ class MetricsTest(unittest.TestCase):
     self.assertIn('LazyTracing', met.metric_names())
     self.assertGreater(met.metric_data('LazyTracing')[0], 1)
 
+  def test_graph_walk_metrics(self):
+    xla_device = torch_xla.device()
+    t1 = torch.randn(4, 4, device=xla_device)
+    torch_xla.sync()
+    met.clear_all()
+    t2 = t1 @ t1 + 1
+    torch_xla._XLAC._get_graph_hash([t2])
+    torch_xla._XLAC._xla_sync_multi([t2], devices=[])
+    for name in ('CollectSyncTensors', 'RunPostOrder', 'FinalizeGraphHash',
+                 'LowerGraph'):
+      self.assertIn(name, met.metric_names())
+    # The sync walks the same roots as the hash query.
+    self.assertEqual(met.counter_value('CachedPostOrder'), 1)
+
+  def test_ir_shape_cache(self):
+    xla_device = torch_xla.device()
+    a = torch.randn(7, 13, device=xla_device)
+    b = torch.randn(7, 13, device=xla_device)
+    torch_xla.sync()
+    met.clear_all()
+    c = torch.atan2(a, b)
+    self.assertGreater(met.counter_value('IrShapeCacheMiss'), 0)
+    # The same op over the same shapes reuses the shape, even though its
+    # operands compute something else.
+    met.clear_all()
+    torch.atan2(c, a)
+    self.assertIsNone(met.counter_value('IrShapeCacheMiss'))
+    self.assertGreater(met.counter_value('IrShapeCacheHit'), 0)
+
+  def test_thread_pool_metrics(self):
+    xla_device = torch_xla.device()
+    met.clear_all()
+    t1 = torch.randn(4, 4, device=xla_device) * 2
+    torch_xla.sync()
+    t1.cpu()
+    for name in ('ExecutionThreadPoolQueueDepth', 'ExecutionThreadPoolWaitTime',
+                 'TransferThreadPoolQueueDepth', 'TransferThreadPoolWaitTime'):
+      self.assertIn(name, met.metric_names())
+
+  def test_device_idle_time(self):
+    xla_device = torch_xla.device()
+    met.clear_all()
+    t1 = torch.randn(4, 4, device=xla_device)
+    for _ in range(3):
+      t1 = t1 * 2
+      torch_xla.sync()
+      xm.wait_device_ops()
+    # The device idles between the steps.
+    self.assertIn('DeviceIdleTime', met.metric_names())
+
+  def test_graph_stats(self):
+    xla_device = torch_xla.device()
+    t1 = torch.randn(16, 16, device=xla_device)
+    torch_xla.sync()
+    for _ in range(3):
+      t2 = t1 @ t1
+      graph_hash = torch_xla._XLAC._get_graph_hash([t2])
+      torch_xla.sync()
+    xm.wait_device_ops()
+    stats = {graph['hash']: graph for graph in met.graph_stats()}
+    self.assertIn(graph_hash, stats)
+    graph = stats[graph_hash]
+    self.assertEqual(graph['executions'], 3)
+    self.assertEqual(graph['compilations'], 1)
+    self.assertGreater(graph['compile_time_ns'], 0)
+    # The completion of the last execution may only be recorded after the
+    # wait returns.
+    self.assertIn(len(graph['execute_times_ns']), (2, 3))
+    self.assertIsNotNone(graph['execute_time_p99_ns'])
+    self.assertEqual(graph['output_bytes'], 16 * 16 * 4)
+    if graph['flops'] > 0:
+      self.assertGreaterEqual(graph['flops'], 2 * 16 * 16 * 16)
+      self.assertGreater(graph['tflops'], 0)
+    self.assertIn('Graph: ', met.metrics_report())
+    self.assertIn('ptxla_graph_executions_total', met.openmetrics_report())
+
+  def test_openmetrics_report(self):
+    xla_device = torch_xla.device()
+    met.clear_all()
+    t1 = torch.randn(4, 4, device=xla_device) + 1
+    torch_xla.sync()
+    report = met.openmetrics_report()
+    self.assertTrue(report.endswith('# EOF\n'))
+    self.assertIn('# TYPE ptxla_MarkStep counter', report)
+    self.assertRegex(report, r'ptxla_MarkStep_total\{device="[A-Z]*"\} 1')
+    self.assertIn('# TYPE ptxla_ExecuteTime summary', report)
+    self.assertRegex(report,
+                     r'ptxla_ExecuteTime\{device="[A-Z]*",quantile="0.5"\}')
+
+  def test_step_timeline(self):
+    xla_device = torch_xla.device()
+    t1 = torch.randn(4, 4, device=xla_device) + 1
+    torch_xla.sync()
+    t1.cpu()
+    events = json.loads(met.step_timeline())['traceEvents']
+    phases = set(event['name'] for event in events)
+    for phase in ('Lowering', 'Execute', 'TransferFromDevice'):
+      self.assertIn(phase, phases)
+    for event in events:
+      self.assertEqual(event['ph'], 'X')
+      self.assertGreaterEqual(event['dur'], 0)
+    with tempfile.TemporaryDirectory() as tmpdir:
+      path = os.path.join(tmpdir, 'timeline.json')
+      met.dump_step_timeline(path)
+      with open(path) as f:
+        self.assertIn('traceEvents', json.load(f))
+
+  def test_computation_memory_footprint(self):
+    xla_device = torch_xla.device()
+    met.clear_all()
+    t1 = torch.randn(8, 8, device=xla_device) @ torch.randn(
+        8, 8, device=xla_device)
+    graph_hash = torch_xla._XLAC._get_graph_hash([t1])
+    torch_xla.sync()
+    self.assertIn('ComputationOutputBytes', met.metric_names())
+    footprint = torch_xla._XLAC._get_graph_memory_footprint(graph_hash)
+    self.assertIsNotNone(footprint)
+    self.assertGreaterEqual(footprint['output_bytes'], 8 * 8 * 4)
+    self.assertEqual(
+        footprint['execution_bytes'], footprint['output_bytes'] -
+        footprint['alias_bytes'] + footprint['temp_bytes'])
+
+  def test_transfer_shares_contiguous_storage(self):
+    xla_device = torch_xla.device()
+    met.clear_all()
+    t1 = torch.arange(16, dtype=torch.float32).reshape(4, 4)
+    expected = t1.clone()
+    t2 = t1.to(xla_device)
+    # The transfer is done with the host data once the call returns.
+    t1.zero_()
+    self.assertEqual(met.counter_value('AtenSourceSharedStorage'), 1)
+    self.assertTrue(torch.equal(t2.cpu(), expected))
+    # Transposed tensors still go through a contiguous copy.
+    t3 = expected.t().to(xla_device)
+    self.assertEqual(met.counter_value('AtenSourceSharedStorage'), 1)
+    self.assertTrue(torch.equal(t3.cpu(), expected.t()))
+
   def test_eager_metrics(self):
     with torch_xla.experimental.eager_mode_context(True):
       xla_device = torch_xla.device()
@@ -236,6 +375,43 @@ class MetricsTest(unittest.TestCase):
     torch_xla._XLAC._xla_increment_counter('FakeCounter', 2)
     self.assertEqual(met.counter_value('FakeCounter'), 2)
 
+  def test_fallback_cost(self):
+    met.clear_all()
+    t1 = torch.randn(16, 16, device=torch_xla.device()) + 1
+    t1.median()
+    metric_names = met.metric_names()
+    for phase in ('SyncTime', 'TransferFromDeviceTime',
+                  'TransferFromDeviceBytes', 'CpuTime',
+                  'TransferToDeviceBytes'):
+      self.assertIn(f'aten::median/{phase}', metric_names)
+    _, from_device_bytes, _ = met.metric_data(
+        'aten::median/TransferFromDeviceBytes')
+    self.assertEqual(from_device_bytes, 16 * 16 * 4)
+
+  def test_fallback_single_transfers(self):
+    t1 = torch.randn(16, 16, device=torch_xla.device()) + 1
+    xm.mark_step()
+    met.clear_all()
+    values, indices = t1.median(dim=0)
+    self.assertEqual(met.metric_data('TransferFromDeviceTime')[0], 1)
+    # Both results are uploaded with the same transfer.
+    self.assertEqual(met.metric_data('TransferToDeviceTime')[0], 1)
+    self.assertEqual(values.device, t1.device)
+    self.assertEqual(indices.device, t1.device)
+    expected = t1.cpu().median(dim=0).values
+    self.assertTrue(torch.allclose(values.cpu(), expected))
+
+  def test_mark_step_visits_dirty_tensors(self):
+    params = [torch.randn(4, device=torch_xla.device()) for _ in range(32)]
+    xm.mark_step()
+    met.clear_all()
+    pending = params[0] * 2
+    xm.mark_step()
+    _, _, samples = met.metric_data('DirtyTensors')
+    # Only the tensor with pending IR is visited, not the parameters.
+    self.assertEqual(samples[-1][1], 1)
+    self.assertEqual(pending.cpu(), params[0].cpu() * 2)
+
   def test_get_fallback_ops(self):
 
     def getAndAssertFallbackOpsLenEquals(count):
@@ -25,6 +25,39 @@ def _mp_fn(index):
         print(
             'Wrong result from core {}: {}'.format(i, result), file=sys.stderr)
         sys.exit(1)
+
+    # Tokens, routing weights and expert indices go through one all-to-all,
+    # with the number of valid slots sent to each replica.
+    tokens = torch.tensor([[ordinal, i] for i in range(size)],
+                          dtype=torch.float32,
+                          device=device)
+    weights = torch.full((size,), ordinal / 2, device=device)
+    indices = torch.full((size,), ordinal, dtype=torch.int32, device=device)
+    split_sizes = torch.full((xr.world_size(),),
+                             ordinal % slots_per_device,
+                             dtype=torch.int32,
+                             device=device)
+    results, recv_sizes = xm.all_to_all_coalesced(
+        [tokens, weights, indices],
+        split_dimension=0,
+        concat_dimension=0,
+        split_count=xr.world_size(),
+        split_sizes=split_sizes)
+    tokens, weights, indices = [t.cpu() for t in results]
+    for i in range(0, xr.world_size()):
+      chunk = slice(i * slots_per_device, (i + 1) * slots_per_device)
+      expected_slots = range(ordinal * slots_per_device,
+                             (ordinal + 1) * slots_per_device)
+      if (tokens[chunk, 0].tolist() != [i] * slots_per_device or
+          tokens[chunk, 1].tolist() != list(expected_slots) or
+          weights[chunk].tolist() != [i / 2] * slots_per_device or
+          indices[chunk].tolist() != [i] * slots_per_device or
+          recv_sizes[i].item() != i % slots_per_device):
+        print(
+            'Wrong coalesced result from core {}: {} {} {} {}'.format(
+                i, tokens, weights, indices, recv_sizes),
+            file=sys.stderr)
+        sys.exit(1)
   else:
     print(
         'Default device {} is not a TPU device'.format(device), file=sys.stderr)
@@ -0,0 +1,45 @@
+import threading
+import unittest
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.runtime as xr
+from absl.testing import absltest
+
+
+@unittest.skipIf(xr.addressable_runtime_device_count() < 2,
+                 'Requires at least two local devices')
+class MultiDeviceThreadsTest(absltest.TestCase):
+
+  def test_threads_drive_devices_concurrently(self):
+    num_steps = 10
+    results = {}
+    errors = []
+
+    def run(index):
+      try:
+        device = torch_xla.device(index)
+        torch_xla._XLAC._xla_set_default_device(str(device))
+        x = torch.ones(16, 16, device=device) * (index + 1)
+        for _ in range(num_steps):
+          x = x @ torch.eye(16, device=device) + 1
+          xm.mark_step()
+        xm.wait_device_ops([str(device)])
+        results[index] = x.cpu()
+      except Exception as e:
+        errors.append(e)
+
+    threads = [threading.Thread(target=run, args=(i,)) for i in range(2)]
+    for thread in threads:
+      thread.start()
+    for thread in threads:
+      thread.join()
+    self.assertEqual(errors, [])
+    for index in range(2):
+      expected = torch.full((16, 16), float(index + 1 + num_steps))
+      torch.testing.assert_close(results[index], expected)
+
+
+if __name__ == '__main__':
+  absltest.main()
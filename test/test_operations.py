@@ -154,6 +154,25 @@ class TestParallelLoader(test_utils.XlaTestCase):
         self.assertEqual(data.device, device)
         self.assertEqual(target.device, device)
 
+  def test_native_prefetch(self):
+    device = torch_xla.device()
+    batches = [{
+        'data': torch.full((4, 2), i, dtype=torch.float32),
+        'labels': [torch.tensor(i), 'label']
+    } for i in range(5)]
+    para_loader = pl.ParallelLoader(
+        batches, [device], device_prefetch_size=2, native_prefetch=True)
+    met.clear_counters()
+    loaded = list(para_loader.per_device_loader(device))
+    self.assertEqual(len(loaded), len(batches))
+    # The batches come in order, with the same structure.
+    for i, batch in enumerate(loaded):
+      self.assertEqual(batch['data'].device, device)
+      self.assertEqual(batch['labels'][1], 'label')
+      self.assertEqual(batch['data'].cpu(), batches[i]['data'])
+      self.assertEqual(batch['labels'][0].item(), i)
+    self.assertEqual(met.counter_value('DevicePrefetcherBatches'), len(batches))
+
 
 class TestAtenTensorTo(test_utils.XlaTestCase):
 
@@ -2437,6 +2456,31 @@ class TestWaitDeviceOps(test_utils.XlaTestCase):
                     "EagerOpExecuteTime" in met.metric_names())
 
 
+class TestDLPack(test_utils.XlaTestCase):
+
+  @unittest.skipIf(xr.device_type() != 'CPU', 'DLPack is tested on CPU')
+  def test_to_dlpack_with_stream(self):
+    t = torch.arange(8, dtype=torch.float32, device='xla') * 2
+    torch_xla.sync()
+    # The CPU buffers ignore the stream and block until they are ready.
+    for stream in (None, -1, 1):
+      cpu_t = torch.utils.dlpack.from_dlpack(
+          xdlpack.to_dlpack(t, stream=stream))
+      self.assertEqual(cpu_t, torch.arange(8, dtype=torch.float32) * 2)
+
+  @unittest.skipIf(xr.device_type() != 'CPU', 'DLPack is tested on CPU')
+  def test_from_dlpack_host_zero_copy(self):
+    met.clear_all()
+    cpu_t = torch.arange(12, dtype=torch.float32).reshape(3, 4)
+    xla_t = xdlpack.from_dlpack(cpu_t)
+    self.assertEqual(met.counter_value('ZeroCopyDLPackImport'), 1)
+    self.assertEqual(xla_t.device, torch_xla.device())
+    self.assertEqual((xla_t + 1).cpu(), cpu_t + 1)
+    # The transposed memory is imported too, through a copy if needed.
+    xla_t = xdlpack.from_dlpack(cpu_t.t())
+    self.assertEqual(xla_t.cpu(), cpu_t.t())
+
+
 class TestDebuggingUtil(test_utils.XlaTestCase):
 
   @skipOnEagerDebug
@@ -2588,6 +2632,52 @@ class TestOpBuilder(test_utils.XlaTestCase):
             'transpose_a': False
         })
 
+  def test_computation_from_module_proto_cache(self):
+    device = torch_xla.device()
+    a = torch.tensor([1.0, 2.0, 3.0], device=device)
+    b = torch.tensor([4.0, 5.0, 6.0], device=device)
+    ctx = torch_xla._XLAC.lowering.LoweringContext("ProtoCacheTest")
+    ctx.build([a * b])
+    proto = ctx.hlo()
+
+    met.clear_counters()
+    computation = xb.computation_from_module_proto("proto_cache", proto)
+    self.assertEqual(met.counter_value("CachedUserComputation"), None)
+    # Building the same proto again reuses the computation.
+    xb.computation_from_module_proto("proto_cache", proto)
+    self.assertEqual(met.counter_value("CachedUserComputation"), 1)
+
+    result = torch_xla._XLAC._xla_user_computation("xla::proto_cache", [a, b],
+                                                   computation)
+    self.assertEqual(result[0].cpu(), (a * b).cpu())
+
+  def test_op_builder_computation_cache(self):
+    device = torch_xla.device()
+    a = torch.tensor([1.0, 2.0, 3.0], device=device)
+    b = torch.tensor([4.0, 5.0, 6.0], device=device)
+    shapes = xb.tensor_shape([a, b])
+
+    def scaled_add(x, y, scale=1.0):
+      return x + y * y.scalar_like(scale)
+
+    met.clear_counters()
+    computation = xb.create_computation('builder_cache', scaled_add, shapes)
+    self.assertEqual(met.counter_value('CachedBuilderComputation'), None)
+    # Building the same ops again reuses the computation and its hash.
+    cached = xb.create_computation('builder_cache', scaled_add, shapes)
+    self.assertEqual(met.counter_value('CachedBuilderComputation'), 1)
+    # Different arguments or shapes build a new one.
+    xb.create_computation('builder_cache', scaled_add, shapes, scale=2.0)
+    xb.create_computation('builder_cache', scaled_add,
+                          xb.tensor_shape([a[:2], b[:2]]))
+    self.assertEqual(met.counter_value('CachedBuilderComputation'), 1)
+
+    self.assertEqual(
+        xb.get_computation_hlo(cached), xb.get_computation_hlo(computation))
+    result = torch_xla._XLAC._xla_user_computation('xla::builder_cache',
+                                                   [a, b], cached)
+    self.assertEqual(result[0].cpu(), (a + b).cpu())
+
   def test_type_conversion(self):
     for xla_type in xb._XLA_PT_TYPE_MAP:
       pt_type = xb.Op.to_torch_type(xla_type)
@@ -0,0 +1,51 @@
+import os
+import sys
+
+os.environ['XLA_OUTPUT_ARENA'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class OutputArenaTest(absltest.TestCase):
+
+  def test_steady_state_steps_reuse_the_outputs(self):
+    device = torch_xla.device()
+    x = torch.rand(16, 16)
+    w = torch.rand(16, 16)
+    xla_x = x.to(device)
+    xla_w = w.to(device)
+    torch_xla.sync()
+    met.clear_all()
+    for _ in range(5):
+      xla_y = xla_x @ xla_w + 1
+      torch.testing.assert_close(
+          xla_y.cpu(), x @ w + 1, rtol=1e-2, atol=1e-2)
+      del xla_y
+    # The first step allocates the arena buffer, and the following ones write
+    # their output into it again.
+    self.assertEqual(met.counter_value('OutputArenaAllocations'), 1)
+    self.assertEqual(met.counter_value('OutputArenaReuses'), 4)
+    self.assertIn('OutputDeviceAllocations', met.metric_names())
+
+  def test_held_outputs_get_new_buffers(self):
+    device = torch_xla.device()
+    xla_x = torch.rand(8, 8).to(device)
+    torch_xla.sync()
+    met.clear_all()
+    outputs = []
+    for _ in range(3):
+      outputs.append(xla_x * 3)
+      torch_xla.sync()
+    self.assertIsNone(met.counter_value('OutputArenaReuses'))
+    self.assertEqual(met.counter_value('OutputArenaAllocations'), 3)
+    # Each output kept its own buffer.
+    for output in outputs:
+      torch.testing.assert_close(output.cpu(), outputs[0].cpu())
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
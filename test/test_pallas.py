@@ -172,6 +172,18 @@ class PallasTest(parameterized.TestCase):
                                                   [x.dtype])
     self.assertTrue(torch.allclose(output[0].cpu(), expected_output.cpu()))
 
+  def test_register_tpu_kernel(self):
+    kernel_id = torch_xla._XLAC._xla_register_tpu_kernel("kernel_a")
+    self.assertEqual(
+        torch_xla._XLAC._xla_register_tpu_kernel("kernel_a"), kernel_id)
+    self.assertNotEqual(
+        torch_xla._XLAC._xla_register_tpu_kernel("kernel_b"), kernel_id)
+
+    x = torch.arange(8, dtype=torch.int).to('xla')
+    # The IDs which were never registered are rejected.
+    with self.assertRaises(RuntimeError):
+      torch_xla._XLAC._xla_tpu_custom_call([x], -1, [x.shape], [x.dtype])
+
   @unittest.skipIf(xr.device_type() != 'TPU', "This test only works on TPU.")
   def test_tpu_custom_call_pallas_raise(self):
     # This payload is generated by the following Pallas code:
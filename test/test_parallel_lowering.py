@@ -0,0 +1,43 @@
+import os
+import sys
+
+# Set before the runtime reads them.
+os.environ['XLA_PARALLEL_LOWERING_THREADS'] = '4'
+os.environ['XLA_PARALLEL_LOWERING_MIN_NODES'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class ParallelLoweringTest(absltest.TestCase):
+
+  def test_independent_outputs(self):
+    device = torch_xla.device()
+    tensors = [torch.rand(8, 8) for _ in range(4)]
+    xtensors = [t.to(device) for t in tensors]
+    torch_xla.sync()
+    met.clear_counters()
+    results = [(t @ t).relu() for t in xtensors]
+    torch_xla.sync()
+    for result, t in zip(results, tensors):
+      torch.testing.assert_close(result.cpu(), (t @ t).relu())
+    self.assertEqual(met.counter_value('ParallelLoweringPartitions'), 4)
+
+  def test_shared_input_not_split(self):
+    device = torch_xla.device()
+    t = torch.rand(8, 8)
+    xt = t.to(device)
+    torch_xla.sync()
+    met.clear_counters()
+    results = [xt * 2, xt + 1]
+    torch_xla.sync()
+    torch.testing.assert_close(results[0].cpu(), t * 2)
+    torch.testing.assert_close(results[1].cpu(), t + 1)
+    self.assertIsNone(met.counter_value('ParallelLoweringPartitions'))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,42 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class ParameterWrappingTest(absltest.TestCase):
+
+  def _add_all(self, shape):
+    device = torch_xla.device()
+    tensors = [torch.rand(shape) for _ in range(4)]
+    xtensors = [t.to(device) for t in tensors]
+    torch_xla.sync()
+    return tensors, xtensors
+
+  def test_graph_threshold(self):
+    tensors, xtensors = self._add_all((3, 5))
+    met.clear_counters()
+
+    @torch_xla.compile(parameter_wrapping_threshold=2)
+    def add_all(*xs):
+      return sum(xs)
+
+    result = add_all(*xtensors)
+    torch.testing.assert_close(result.cpu(), sum(tensors))
+    self.assertEqual(met.counter_value('ParameterWrappedGraphs'), 1)
+    self.assertIsNone(torch_xla._XLAC._get_parameter_wrapping_threshold())
+
+  def test_default_threshold(self):
+    tensors, xtensors = self._add_all((5, 3))
+    met.clear_counters()
+    result = sum(xtensors)
+    torch_xla.sync()
+    torch.testing.assert_close(result.cpu(), sum(tensors))
+    self.assertIsNone(met.counter_value('ParameterWrappedGraphs'))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
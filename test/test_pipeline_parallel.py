@@ -0,0 +1,62 @@
+import sys
+
+import torch
+import torch_xla
+from torch_xla.distributed import pipeline_parallel as pp
+from absl.testing import absltest
+
+
+class PipelineScheduleTest(absltest.TestCase):
+
+  def test_one_f_one_b_schedule(self):
+    F, B = pp.FORWARD, pp.BACKWARD
+    self.assertEqual(
+        pp.one_f_one_b_schedule(num_stages=3, stage=0, num_microbatches=4),
+        [(F, 0), (F, 1), (F, 2), (B, 0), (F, 3), (B, 1), (B, 2), (B, 3)])
+    self.assertEqual(
+        pp.one_f_one_b_schedule(num_stages=3, stage=2, num_microbatches=4),
+        [(F, 0), (B, 0), (F, 1), (B, 1), (F, 2), (B, 2), (F, 3), (B, 3)])
+
+  def test_schedule_runs_every_microbatch_once(self):
+    for stage in range(4):
+      schedule = pp.one_f_one_b_schedule(4, stage, num_microbatches=2)
+      self.assertCountEqual(schedule, [(pp.FORWARD, i) for i in range(2)] +
+                            [(pp.BACKWARD, i) for i in range(2)])
+      for i in range(2):
+        self.assertLess(
+            schedule.index((pp.FORWARD, i)), schedule.index((pp.BACKWARD, i)))
+
+
+class PipelineStageTest(absltest.TestCase):
+
+  def test_single_stage_accumulates_gradients(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    module = torch.nn.Linear(4, 4).to(device)
+    reference = torch.nn.Linear(4, 4).to(device)
+    reference.load_state_dict(module.state_dict())
+    data = torch.rand(8, 4, device=device)
+    target = torch.rand(8, 4, device=device)
+    loss_fn = lambda y, t: torch.nn.functional.mse_loss(
+        y, t, reduction='sum')
+
+    stage = pp.PipelineStage(
+        module, 0, activation_shape=(2, 4), stage_ranks=[0], loss_fn=loss_fn)
+    losses = stage.run(
+        microbatches=list(data.split(2)), targets=list(target.split(2)))
+    loss_fn(reference(data), target).backward()
+    torch_xla.sync()
+
+    self.assertLen(losses, 4)
+    torch.testing.assert_close(
+        sum(l.cpu() for l in losses),
+        loss_fn(reference(data), target).detach().cpu())
+    torch.testing.assert_close(module.weight.grad.cpu(),
+                               reference.weight.grad.cpu())
+    torch.testing.assert_close(module.bias.grad.cpu(),
+                               reference.bias.grad.cpu())
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
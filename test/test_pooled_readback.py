@@ -0,0 +1,46 @@
+import os
+import sys
+
+os.environ['XLA_HOST_BUFFER_POOL_SIZE_MB'] = '64'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class PooledReadbackTest(absltest.TestCase):
+
+  def test_small_values_are_packed(self):
+    device = torch_xla.device()
+    expected = [torch.rand(4, 4) for _ in range(8)]
+    xla_tensors = [t.to(device) + 1 for t in expected]
+    xm.mark_step()
+    met.clear_counters()
+    results = torch_xla._XLAC._xla_get_cpu_tensors(xla_tensors)
+    self.assertEqual(met.counter_value('PackedTransferFromDevice'), 1)
+    for result, tensor in zip(results, expected):
+      torch.testing.assert_close(result, tensor + 1)
+
+  def test_results_outlive_the_pool_buffers(self):
+    device = torch_xla.device()
+    results = []
+    for i in range(4):
+      results.append((torch.full((1024, 64), i, device=device) * 2).cpu())
+    # Later readbacks reuse the released buffers, but not the ones backing
+    # live tensors.
+    for i, result in enumerate(results):
+      torch.testing.assert_close(result, torch.full((1024, 64), i * 2.0))
+
+  def test_readback_with_conversion(self):
+    device = torch_xla.device()
+    expected = torch.rand(16, 8).to(torch.bfloat16)
+    result = (expected.to(device) * 1).cpu()
+    self.assertEqual(result.dtype, torch.bfloat16)
+    torch.testing.assert_close(result, expected)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,38 @@
+import os
+import sys
+
+os.environ['XLA_PREDICT_NEXT_GRAPH'] = '1'
+# Unloads the executables at every step, so that the predicted ones have to be
+# loaded back.
+os.environ['XLA_COMPILATION_CACHE_IDLE_STEPS'] = '0'
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class PredictNextGraphTest(absltest.TestCase):
+
+  def test_alternating_graphs_are_staged(self):
+    device = torch_xla.device()
+    x = torch.rand(8, 8).to(device)
+    torch_xla.sync()
+    met.clear_all()
+    for _ in range(4):
+      y = x * 2
+      torch_xla.sync()
+      z = x + 1
+      torch_xla.sync()
+    # Both graphs are predicted from the second round on.
+    self.assertEqual(met.counter_value('GraphPredictionHits'), 5)
+    self.assertIsNone(met.counter_value('GraphPredictionMisses'))
+    self.assertGreaterEqual(met.counter_value('StageNextComputation'), 5)
+    self.assertEqual(met.metric_data('CompileTime')[0], 2)
+    torch.testing.assert_close(y.cpu(), x.cpu() * 2)
+    torch.testing.assert_close(z.cpu(), x.cpu() + 1)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
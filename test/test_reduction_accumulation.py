@@ -0,0 +1,52 @@
+import os
+import sys
+
+os.environ['XLA_REDUCTION_ACCUMULATION'] = 'f32'
+os.environ['XLA_REDUCTION_UPCAST_MIN_SIZE'] = '64'
+
+import torch
+import torch_xla
+from absl.testing import absltest
+
+
+class ReductionAccumulationTest(absltest.TestCase):
+
+  def test_long_sum_accumulates_in_f32(self):
+    # Past 256, adding ones in bf16 no longer changes the sum.
+    input = torch.ones(4096, dtype=torch.bfloat16, device=torch_xla.device())
+    output = input.sum()
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([output])
+    self.assertIn('f32[4096]', hlo)
+    self.assertEqual(output.dtype, torch.bfloat16)
+    self.assertEqual(output.item(), 4096)
+
+  def test_long_mean_and_var(self):
+    input = torch.randn(8, 2048)
+    xla_input = input.to(torch.bfloat16).to(torch_xla.device())
+    torch.testing.assert_close(
+        xla_input.mean(dim=1).float().cpu(),
+        input.to(torch.bfloat16).float().mean(dim=1),
+        atol=1e-2,
+        rtol=1e-2)
+    torch.testing.assert_close(
+        xla_input.var(dim=1).float().cpu(),
+        input.to(torch.bfloat16).float().var(dim=1),
+        atol=2e-2,
+        rtol=2e-2)
+
+  def test_short_sum_keeps_bf16(self):
+    input = torch.ones(8, 16, dtype=torch.bfloat16, device=torch_xla.device())
+    output = input.sum(dim=1)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([output])
+    self.assertNotIn('f32[8,16]', hlo)
+    self.assertTrue(torch.all(output.cpu() == 16))
+
+  def test_f32_sum_unchanged(self):
+    input = torch.randn(4096)
+    output = input.to(torch_xla.device()).sum()
+    torch.testing.assert_close(output.cpu(), input.sum())
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,63 @@
+import sys
+
+import torch
+import torch_xla
+from absl.testing import absltest
+from torch_xla.experimental.sampling import sample_tokens
+
+
+class SampleTokensTest(absltest.TestCase):
+
+  def test_greedy(self):
+    device = torch_xla.device()
+    logits = torch.randn(4, 1000)
+    expected = torch.argmax(logits, dim=-1)
+    tokens = sample_tokens(logits.to(device), temperature=0.0)
+    self.assertEqual(tokens.dtype, torch.int64)
+    self.assertEqual(tokens.shape, torch.Size([4]))
+    self.assertTrue(torch.equal(tokens.cpu(), expected))
+    tokens = sample_tokens(logits.to(device), temperature=1.0, top_k=1)
+    self.assertTrue(torch.equal(tokens.cpu(), expected))
+
+  def test_top_k(self):
+    device = torch_xla.device()
+    logits = torch.randn(2, 3, 512)
+    _, allowed = torch.topk(logits, 8, dim=-1)
+    xla_logits = logits.to(device)
+    for _ in range(8):
+      tokens = sample_tokens(xla_logits, temperature=2.0, top_k=8).cpu()
+      self.assertEqual(tokens.shape, torch.Size([2, 3]))
+      self.assertTrue(torch.all((allowed == tokens.unsqueeze(-1)).any(-1)))
+
+  def test_top_p(self):
+    device = torch_xla.device()
+    logits = torch.full((4, 64), -10.0)
+    logits[:, 3] = 10.0
+    logits[:, 7] = 9.5
+    xla_logits = logits.to(device)
+    for _ in range(8):
+      tokens = sample_tokens(xla_logits, temperature=1.0, top_p=0.5).cpu()
+      self.assertTrue(torch.all(tokens == 3))
+      tokens = sample_tokens(xla_logits, temperature=1.0, top_p=0.99).cpu()
+      self.assertTrue(torch.all((tokens == 3) | (tokens == 7)))
+
+  def test_samples(self):
+    device = torch_xla.device()
+    logits = torch.zeros(256, 4).to(device)
+    tokens = sample_tokens(logits, temperature=1.0).cpu()
+    # Every token of a uniform distribution gets drawn.
+    self.assertEqual(set(tokens.tolist()), {0, 1, 2, 3})
+
+  def test_no_recompilation(self):
+    device = torch_xla.device()
+    logits = torch.randn(2, 128, device=device)
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo(
+        [sample_tokens(logits, temperature=0.7, top_p=0.9)])
+    other_hlo = torch_xla._XLAC._get_xla_tensors_hlo(
+        [sample_tokens(logits, temperature=1.3, top_p=0.5)])
+    self.assertEqual(hlo, other_hlo)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
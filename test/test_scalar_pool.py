@@ -0,0 +1,49 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class ScalarPoolTest(absltest.TestCase):
+
+  def _step(self, t, scalars):
+    for scalar in scalars:
+      t = t * scalar
+    return t
+
+  def test_scalars_batched_and_reused(self):
+    device = torch_xla.device()
+    t = torch.rand(4, 4)
+    # Values unlikely to be pooled by the other tests.
+    scalars = [1.0 + i / 1024 + 1 / 3 for i in range(8)]
+    xt = t.to(device)
+    torch_xla.sync()
+    met.clear_counters()
+    result = self._step(xt, scalars).cpu()
+    torch.testing.assert_close(result, self._step(t, scalars))
+    self.assertEqual(met.counter_value('DeviceDataCacheMiss'), len(scalars))
+    self.assertEqual(met.counter_value('BatchedScalarTransfers'), 1)
+    self.assertEqual(met.counter_value('BatchedScalars'), len(scalars))
+
+    # The next step reuses the uploaded scalars.
+    met.clear_counters()
+    result = self._step(xt, scalars).cpu()
+    torch.testing.assert_close(result, self._step(t, scalars))
+    self.assertIsNone(met.counter_value('DeviceDataCacheMiss'))
+    self.assertIsNone(met.counter_value('BatchedScalarTransfers'))
+
+  def test_zero_dim_tensor_read_back(self):
+    device = torch_xla.device()
+    xt = torch.tensor(2.71828, device=device)
+    # Lowers the tensor data to the pooled device data, which the tensor takes
+    # over when synced.
+    torch_xla._XLAC._get_xla_tensors_text([xt])
+    torch_xla.sync()
+    self.assertAlmostEqual(xt.item(), 2.71828, places=5)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
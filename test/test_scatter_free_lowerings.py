@@ -0,0 +1,66 @@
+import os
+import sys
+
+os.environ['XLA_RESIZE_LOWERING'] = 'matmul'
+os.environ['XLA_MAX_POOL_BACKWARD_LOWERING'] = 'dense'
+
+import torch
+import torch.nn.functional as F
+import torch_xla
+from absl.testing import absltest, parameterized
+
+
+class ScatterFreeLoweringsTest(parameterized.TestCase):
+
+  def _check(self, fn, input, unexpected_hlo):
+    device = torch_xla.device()
+    input = input.requires_grad_()
+    output = fn(input)
+    output.backward(torch.ones_like(output))
+
+    xla_input = input.detach().to(device).requires_grad_()
+    xla_output = fn(xla_input)
+    xla_output.backward(torch.ones_like(xla_output))
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([xla_output, xla_input.grad])
+    self.assertNotIn(unexpected_hlo, hlo)
+    torch.testing.assert_close(
+        xla_output.cpu(), output, rtol=1e-4, atol=1e-4)
+    torch.testing.assert_close(
+        xla_input.grad.cpu(), input.grad, rtol=1e-4, atol=1e-4)
+
+  @parameterized.product(
+      size=[(5, 7), (16, 16), (3, 2)], align_corners=[False, True])
+  def test_upsample_bilinear(self, size, align_corners):
+    self._check(
+        lambda x: F.interpolate(
+            x, size=size, mode='bilinear', align_corners=align_corners),
+        torch.randn(2, 3, 6, 4), 'gather(')
+
+  @parameterized.product(
+      kernel_size=[2, 3],
+      stride=[1, 2],
+      padding=[0, 1],
+      ceil_mode=[False, True])
+  def test_max_pool2d(self, kernel_size, stride, padding, ceil_mode):
+    if padding * 2 > kernel_size:
+      self.skipTest('padding too large for the kernel')
+    self._check(
+        lambda x: F.max_pool2d(
+            x, kernel_size, stride=stride, padding=padding,
+            ceil_mode=ceil_mode), torch.randn(2, 3, 9, 8), 'select-and-scatter')
+
+  def test_max_pool2d_ties(self):
+    # Overlapping windows of equal elements pass their gradient to the first
+    # one.
+    self._check(
+        lambda x: F.max_pool2d(x, 3, stride=1), torch.ones(1, 1, 5, 5),
+        'select-and-scatter')
+
+  def test_max_pool3d(self):
+    self._check(lambda x: F.max_pool3d(x, 2, stride=2),
+                torch.randn(1, 2, 4, 6, 6), 'select-and-scatter')
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,78 @@
+import os
+import sys
+
+os.environ['XLA_SORTED_SCATTER_ADD'] = '1'
+
+import torch
+import torch.nn.functional as F
+import torch_xla
+from absl.testing import absltest, parameterized
+
+
+class SortedScatterAddTest(parameterized.TestCase):
+
+  def _assert_sorted(self, tensor):
+    hlo = torch_xla._XLAC._get_xla_tensors_hlo([tensor])
+    self.assertIn(' sort(', hlo)
+
+  def test_index_put_accumulate(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    base = torch.randn(10, 4, 3)
+    indices = torch.randint(0, 10, (50,))
+    values = torch.randn(50, 4, 3)
+    expected = base.index_put((indices,), values, accumulate=True)
+
+    output = base.to(device).index_put((indices.to(device),),
+                                       values.to(device),
+                                       accumulate=True)
+    self._assert_sorted(output)
+    torch.testing.assert_close(output.cpu(), expected, atol=1e-5, rtol=1e-5)
+
+  @parameterized.parameters(None, 3)
+  def test_embedding_backward(self, padding_idx):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    weight = torch.randn(100, 8)
+    indices = torch.randint(0, 20, (4, 64))
+    grad = torch.randn(4, 64, 8)
+
+    cpu_weight = weight.clone().requires_grad_()
+    F.embedding(indices, cpu_weight, padding_idx=padding_idx).backward(grad)
+
+    xla_weight = weight.to(device).requires_grad_()
+    output = F.embedding(
+        indices.to(device), xla_weight, padding_idx=padding_idx)
+    output.backward(grad.to(device))
+    self._assert_sorted(xla_weight.grad)
+    torch.testing.assert_close(
+        xla_weight.grad.cpu(), cpu_weight.grad, atol=1e-4, rtol=1e-4)
+
+  @parameterized.parameters(0, 1)
+  def test_scatter_add(self, dim):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    input = torch.randn(6, 7)
+    index = torch.randint(0, input.size(dim), (5, 4))
+    src = torch.randn(5, 6)
+    expected = input.scatter_add(dim, index, src)
+
+    output = input.to(device).scatter_add(dim, index.to(device), src.to(device))
+    self._assert_sorted(output)
+    torch.testing.assert_close(output.cpu(), expected, atol=1e-5, rtol=1e-5)
+
+  def test_deterministic(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    indices = torch.randint(0, 4, (4096,)).to(device)
+    values = torch.randn(4096, 16).to(device)
+    results = []
+    for _ in range(2):
+      base = torch.zeros(4, 16, device=device)
+      results.append(base.index_put((indices,), values, accumulate=True).cpu())
+    self.assertTrue(torch.equal(results[0], results[1]))
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
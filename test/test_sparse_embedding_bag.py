@@ -0,0 +1,131 @@
+import sys
+
+import torch
+import torch.nn.functional as F
+import torch_xla
+from absl.testing import absltest, parameterized
+from torch_xla.experimental.sparse_embedding_bag import SparseEmbeddingBag
+
+
+class SparseEmbeddingBagTest(parameterized.TestCase):
+
+  def _inputs(self, include_last_offset):
+    torch.manual_seed(0)
+    weight = torch.randn(50, 8)
+    indices = torch.randint(0, 20, (40,))
+    # An empty bag, and a bag of a single index.
+    offsets = torch.tensor([0, 5, 5, 6, 17, 30])
+    if include_last_offset:
+      offsets = torch.cat([offsets, torch.tensor([40])])
+    return weight, indices, offsets
+
+  @parameterized.product(
+      mode=['sum', 'mean', 'max'], include_last_offset=[False, True])
+  def test_forward(self, mode, include_last_offset):
+    device = torch_xla.device()
+    weight, indices, offsets = self._inputs(include_last_offset)
+    expected = F.embedding_bag(
+        indices,
+        weight,
+        offsets,
+        mode=mode,
+        include_last_offset=include_last_offset)
+
+    output = F.embedding_bag(
+        indices.to(device),
+        weight.to(device),
+        offsets.to(device),
+        mode=mode,
+        include_last_offset=include_last_offset)
+    torch.testing.assert_close(output.cpu(), expected, atol=1e-5, rtol=1e-5)
+
+  @parameterized.parameters('sum', 'mean')
+  def test_dense_backward(self, mode):
+    device = torch_xla.device()
+    weight, indices, offsets = self._inputs(False)
+    grad = torch.randn(offsets.numel(), 8)
+
+    cpu_weight = weight.clone().requires_grad_()
+    F.embedding_bag(indices, cpu_weight, offsets, mode=mode).backward(grad)
+
+    xla_weight = weight.to(device).requires_grad_()
+    F.embedding_bag(
+        indices.to(device), xla_weight, offsets.to(device),
+        mode=mode).backward(grad.to(device))
+    torch.testing.assert_close(
+        xla_weight.grad.cpu(), cpu_weight.grad, atol=1e-5, rtol=1e-5)
+
+  @parameterized.product(
+      mode=['sum', 'mean'], include_last_offset=[False, True])
+  def test_sparse_backward(self, mode, include_last_offset):
+    device = torch_xla.device()
+    weight, indices, offsets = self._inputs(include_last_offset)
+    num_bags = offsets.numel() - (1 if include_last_offset else 0)
+    grad = torch.randn(num_bags, 8)
+
+    cpu_weight = weight.clone().requires_grad_()
+    F.embedding_bag(
+        indices,
+        cpu_weight,
+        offsets,
+        mode=mode,
+        include_last_offset=include_last_offset).backward(grad)
+
+    module = SparseEmbeddingBag(
+        50, 8, mode=mode, include_last_offset=include_last_offset).to(device)
+    with torch.no_grad():
+      module.weight.copy_(weight.to(device))
+    output = module(indices.to(device), offsets.to(device))
+    output.backward(grad.to(device))
+    self.assertIsNone(module.weight.grad)
+
+    grad_indices, grad_values = module.sparse_grad
+    self.assertEqual(grad_indices.shape, indices.shape)
+    grad_indices = grad_indices.cpu()
+    grad_values = grad_values.cpu()
+    unique = indices.unique()
+    torch.testing.assert_close(grad_indices[:unique.numel()], unique)
+    self.assertTrue(torch.all(grad_indices[unique.numel():] == 50))
+    torch.testing.assert_close(
+        grad_values[:unique.numel()],
+        cpu_weight.grad[unique],
+        atol=1e-5,
+        rtol=1e-5)
+
+    module.apply_sparse_grad_(0.1)
+    torch.testing.assert_close(
+        module.weight.cpu(),
+        weight - 0.1 * cpu_weight.grad,
+        atol=1e-5,
+        rtol=1e-5)
+
+  def test_per_sample_weights(self):
+    device = torch_xla.device()
+    weight, indices, offsets = self._inputs(False)
+    per_sample_weights = torch.rand(indices.numel())
+    grad = torch.randn(offsets.numel(), 8)
+
+    cpu_weight = weight.clone().requires_grad_()
+    F.embedding_bag(
+        indices,
+        cpu_weight,
+        offsets,
+        mode='sum',
+        per_sample_weights=per_sample_weights).backward(grad)
+
+    module = SparseEmbeddingBag(50, 8, mode='sum').to(device)
+    with torch.no_grad():
+      module.weight.copy_(weight.to(device))
+    module(indices.to(device), offsets.to(device),
+           per_sample_weights.to(device)).backward(grad.to(device))
+    module.apply_sparse_grad_(1.0)
+    torch.testing.assert_close(
+        module.weight.cpu(),
+        weight - cpu_weight.grad,
+        atol=1e-5,
+        rtol=1e-5)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -188,6 +188,208 @@ class TestSyncFreeAdam(TestSyncFreeOptimizerBase):
     self._test_adam_optimizer_helper(syncfree.Adam, torch.optim.Adam)
     self._test_adam_optimizer_helper(syncfree.AdamW, torch.optim.AdamW)
 
+  def test_multi_tensor_adam_step(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    params = [torch.rand(8, 4), torch.rand(3), torch.rand(2, 2, 2)]
+    grads = [torch.rand(p.shape) for p in params]
+    results = []
+    for foreach in (False, True):
+      for amsgrad in (False, True):
+        xla_params = [p.clone().to(device) for p in params]
+        xla_grads = [g.to(device) for g in grads]
+        exp_avgs = [torch.zeros_like(p) for p in xla_params]
+        exp_avg_sqs = [torch.zeros_like(p) for p in xla_params]
+        max_exp_avg_sqs = [torch.zeros_like(p) for p in xla_params]
+        found_inf = torch.tensor(0.0, device=device)
+        steps = [torch.zeros_like(found_inf) for _ in xla_params]
+        for _ in range(3):
+          syncfree._functional.adam_step(
+              found_inf,
+              steps,
+              xla_params,
+              xla_grads,
+              exp_avgs,
+              exp_avg_sqs,
+              max_exp_avg_sqs,
+              amsgrad=amsgrad,
+              beta1=0.9,
+              beta2=0.99,
+              lr=1e-2,
+              weight_decay=0.1,
+              eps=1e-8,
+              maximize=False,
+              use_adamw=True,
+              foreach=foreach)
+          torch_xla.sync()
+        results.append([p.cpu() for p in xla_params + exp_avgs + steps])
+    for per_tensor, multi_tensor in zip(results[:2], results[2:]):
+      for expected, actual in zip(per_tensor, multi_tensor):
+        np.testing.assert_allclose(
+            expected.numpy(), actual.numpy(), rtol=1e-6, atol=1e-6)
+
+  def test_multi_tensor_adam_step_unscale(self):
+    device = torch_xla.device()
+    torch.manual_seed(0)
+    params = [torch.rand(8, 4), torch.rand(3)]
+    grads = [torch.rand(p.shape) for p in params]
+    scale = 1024.0
+
+    def run(grads, inv_scale):
+      xla_params = [p.clone().to(device) for p in params]
+      xla_grads = [g.to(device) for g in grads]
+      found_inf = torch.tensor(0.0, device=device)
+      steps = [torch.zeros_like(found_inf) for _ in xla_params]
+      syncfree._functional.adam_step(
+          found_inf,
+          steps,
+          xla_params, [g.clone() for g in xla_grads],
+          [torch.zeros_like(p) for p in xla_params],
+          [torch.zeros_like(p) for p in xla_params],
+          [torch.zeros_like(p) for p in xla_params],
+          amsgrad=False,
+          beta1=0.9,
+          beta2=0.99,
+          lr=1e-2,
+          weight_decay=0.1,
+          eps=1e-8,
+          maximize=False,
+          use_adamw=True,
+          inv_scale=inv_scale)
+      torch_xla.sync()
+      return [p.cpu() for p in xla_params], found_inf.item()
+
+    inv_scale = torch.tensor(1.0 / scale, device=device)
+    expected, _ = run(grads, None)
+    actual, found_inf = run([g * scale for g in grads], inv_scale)
+    self.assertEqual(found_inf, 0.0)
+    for expected_param, actual_param in zip(expected, actual):
+      np.testing.assert_allclose(
+          expected_param.numpy(), actual_param.numpy(), rtol=1e-6, atol=1e-6)
+
+    # A non finite gradient skips the step of every parameter.
+    scaled = [g * scale for g in grads]
+    scaled[1][0] = float('inf')
+    skipped, found_inf = run(scaled, inv_scale)
+    self.assertEqual(found_inf, 1.0)
+    for param, skipped_param in zip(params, skipped):
+      np.testing.assert_allclose(param.numpy(), skipped_param.numpy())
+
+
+class TestSyncFreeLambAdafactor(unittest.TestCase):
+
+  def _run_step(self, step_fn, params, grads, states, found_infs):
+    device = torch_xla.device()
+    xla_params = [p.clone().to(device) for p in params]
+    xla_grads = [g.to(device) for g in grads]
+    xla_states = [[t.clone().to(device) for t in kind] for kind in states]
+    steps = [torch.tensor(0.0, device=device) for _ in params]
+    for found_inf in found_infs:
+      step_fn(
+          torch.tensor(found_inf, device=device), steps, xla_params,
+          xla_grads, *xla_states)
+      torch_xla.sync()
+    return [p.cpu() for p in xla_params]
+
+  def test_lamb_step(self):
+    torch.manual_seed(0)
+    params = [torch.rand(8, 4), torch.rand(5)]
+    grads = [torch.rand(p.shape) for p in params]
+    beta1, beta2, lr, weight_decay, eps = 0.9, 0.99, 1e-2, 0.1, 1e-6
+
+    def step_fn(found_inf, steps, params, grads, exp_avgs, exp_avg_sqs):
+      syncfree._functional.lamb_step(
+          found_inf,
+          steps,
+          params,
+          grads,
+          exp_avgs,
+          exp_avg_sqs,
+          beta1=beta1,
+          beta2=beta2,
+          lr=lr,
+          weight_decay=weight_decay,
+          eps=eps,
+          maximize=False)
+
+    states = [[torch.zeros_like(p) for p in params] for _ in range(2)]
+    actual = self._run_step(step_fn, params, grads, states, [0.0, 1.0, 0.0])
+
+    for param, grad, result in zip(params, grads, actual):
+      p = param.clone()
+      m = torch.zeros_like(p)
+      v = torch.zeros_like(p)
+      for step in (1, 2):
+        m = beta1 * m + (1 - beta1) * grad
+        v = beta2 * v + (1 - beta2) * grad * grad
+        update = (m / (1 - beta1**step)) / (
+            torch.sqrt(v / (1 - beta2**step)) + eps) + weight_decay * p
+        trust_ratio = p.norm() / update.norm()
+        p = p - lr * trust_ratio * update
+      np.testing.assert_allclose(
+          p.numpy(), result.numpy(), rtol=1e-5, atol=1e-5)
+
+  def test_adafactor_step(self):
+    torch.manual_seed(0)
+    params = [torch.rand(2, 8, 4), torch.rand(6, 3), torch.rand(5)]
+    grads = [torch.rand(p.shape) for p in params]
+    lr, beta2_decay, eps1, eps2, d = 1e-2, -0.8, 1e-30, 1e-3, 1.0
+
+    def step_fn(found_inf, steps, params, grads, row_vars, col_vars):
+      syncfree._functional.adafactor_step(
+          found_inf,
+          steps,
+          params,
+          grads,
+          row_vars,
+          col_vars,
+          lr=lr,
+          beta2_decay=beta2_decay,
+          eps1=eps1,
+          eps2=eps2,
+          d=d,
+          weight_decay=0.0,
+          maximize=False)
+
+    row_vars = [
+        torch.zeros(p.shape[:-1]) if p.dim() >= 2 else torch.zeros_like(p)
+        for p in params
+    ]
+    col_vars = [
+        torch.zeros(p.shape[:-2] + p.shape[-1:])
+        if p.dim() >= 2 else torch.empty(0) for p in params
+    ]
+    actual = self._run_step(step_fn, params, grads, [row_vars, col_vars],
+                            [0.0, 1.0, 0.0])
+
+    # The reference uses the keepdim variances of torch.optim.Adafactor.
+    for param, grad, result in zip(params, grads, actual):
+      p = param.clone()
+      row_var = torch.zeros(p.shape[:-1] + (1,)) if p.dim() >= 2 else None
+      col_var = torch.zeros(p.shape[:-2] + (1,) +
+                            p.shape[-1:]) if p.dim() >= 2 else None
+      variance = torch.zeros_like(p)
+      for step in (1, 2):
+        one_minus_beta2 = step**beta2_decay
+        rho = min(lr, 1 / step**0.5)
+        alpha = max(eps2, p.norm().item() / p.numel()**0.5) * rho
+        if p.dim() >= 2:
+          row_mean = grad.norm(dim=-1, keepdim=True).square() / grad.size(-1)
+          row_var = row_var.lerp(row_mean, one_minus_beta2)
+          col_mean = grad.norm(dim=-2, keepdim=True).square() / grad.size(-2)
+          col_var = col_var.lerp(col_mean, one_minus_beta2)
+          var_estimate = row_var @ col_var
+          var_estimate = var_estimate / row_var.mean(
+              dim=-2, keepdim=True).clamp(min=eps1)
+        else:
+          variance = variance.lerp(grad * grad, one_minus_beta2)
+          var_estimate = variance.clone()
+        update = var_estimate.clamp(min=eps1 * eps1).rsqrt() * grad
+        denom = max(1.0, update.norm().item() / (update.numel()**0.5 * d))
+        p = p - alpha / denom * update
+      np.testing.assert_allclose(
+          p.numpy(), result.numpy(), rtol=1e-5, atol=1e-5)
+
 
 if __name__ == "__main__":
   test = unittest.main(verbosity=FLAGS.verbosity, exit=False)
@@ -0,0 +1,59 @@
+import os
+import sys
+
+os.environ['XLA_TRACE_PROFILER'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class TraceProfilerTest(absltest.TestCase):
+
+  def test_trace_profile(self):
+    device = torch_xla.device()
+    a = torch.rand(8, 8, device=device)
+    b = torch.rand(8, 8, device=device)
+    for _ in range(3):
+      c = torch.mm(a, b) * 2
+    xm.mark_step()
+
+    stats = met.trace_profile()
+    by_key = {(s['category'], s['op']): s for s in stats}
+    self.assertEqual(by_key[('aten_op', 'aten::mm')]['count'], 3)
+    self.assertEqual(by_key[('aten_op', 'aten::mul')]['count'], 3)
+    self.assertIn(('node_creation', 'aten::mm'), by_key)
+    self.assertIn(('shape_inference', 'aten::mm'), by_key)
+    self.assertGreaterEqual(by_key[('lowering', 'aten::mm')]['count'], 1)
+    self.assertGreater(by_key[('lowering', 'aten::mm')]['instructions'], 0)
+    self.assertEqual([s['total_ns'] for s in stats],
+                     sorted([s['total_ns'] for s in stats], reverse=True))
+    for s in stats:
+      self.assertGreaterEqual(s['total_ns'], s['max_ns'])
+
+    # Only the last step is returned by default, but all of them in total.
+    c = torch.mm(a, b)
+    xm.mark_step()
+    by_key = {(s['category'], s['op']): s for s in met.trace_profile()}
+    self.assertEqual(by_key[('aten_op', 'aten::mm')]['count'], 1)
+    by_key = {
+        (s['category'], s['op']): s for s in met.trace_profile(total=True)
+    }
+    self.assertEqual(by_key[('aten_op', 'aten::mm')]['count'], 4)
+
+  def test_lowering_report(self):
+    device = torch_xla.device()
+    a = torch.rand(4, 4, device=device)
+    b = torch.rand(4, 4, device=device)
+    c = torch.mm(a, b)
+    xm.mark_step()
+    report = met.metrics_report()
+    self.assertIn('Lowering: aten::mm', report)
+    self.assertIn('  Instructions: ', report)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,35 @@
+import os
+import sys
+
+os.environ['XLA_TRANSFER_PARAMETER_LAYOUTS'] = '1'
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class TransferParameterLayoutsTest(absltest.TestCase):
+
+  def test_transfer_after_compile(self):
+    device = torch_xla.device()
+    weight = torch.rand(8, 128, device=device)
+    xm.mark_step()
+
+    for _ in range(2):
+      batch = torch.rand(8, 128)
+      met.clear_counters()
+      result = (batch.to(device) * weight).sum(dim=0)
+      xm.mark_step()
+      torch.testing.assert_close(
+          result.cpu(), (batch * weight.cpu()).sum(dim=0))
+    # The second batch is transferred in the layout recorded at the
+    # compilation of the first step.
+    self.assertGreaterEqual(
+        met.counter_value('ParameterLayoutTransferToDevice'), 1)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,54 @@
+import os
+
+os.environ["XLA_DISABLE_FUNCTIONALIZATION"] = "1"
+
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class ViewCompositionTest(absltest.TestCase):
+
+  def _count(self, tensor, op):
+    hlo = torch_xla._XLAC._get_xla_tensors_text([tensor])
+    return hlo.count(op + '(')
+
+  def test_narrow_chain_update(self):
+    device = torch_xla.device()
+    input = torch.zeros(64, 64)
+    xla_input = input.to(device)
+    met.clear_all()
+    for tensor in (input, xla_input):
+      view = tensor
+      for _ in range(8):
+        view = view.narrow(0, 1, view.shape[0] - 2)
+      view.add_(1.0)
+    self.assertIn('ComposedViews', met.counter_names())
+    self.assertEqual(self._count(xla_input, 'xla::update_slice'), 1)
+    torch.testing.assert_close(xla_input.cpu(), input)
+
+  def test_strided_select_chain_update(self):
+    device = torch_xla.device()
+    input = torch.zeros(32, 8)
+    xla_input = input.to(device)
+    for tensor in (input, xla_input):
+      tensor[1:31:2][2:14:3][1:].add_(2.0)
+    self.assertEqual(self._count(xla_input, 'xla::unselect'), 1)
+    torch.testing.assert_close(xla_input.cpu(), input)
+
+  def test_permutes_cancel(self):
+    device = torch_xla.device()
+    input = torch.zeros(2, 3, 4)
+    xla_input = input.to(device)
+    for tensor in (input, xla_input):
+      tensor.permute(1, 2, 0).permute(2, 0, 1).add_(1.0)
+    self.assertEqual(self._count(xla_input, 'aten::permute'), 0)
+    torch.testing.assert_close(xla_input.cpu(), input)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
@@ -0,0 +1,42 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+import torch_xla.runtime as xr
+from absl.testing import absltest
+
+
+class WarmUpCacheTest(absltest.TestCase):
+
+  def setUp(self):
+    met.clear_all()
+
+  def test_warm_up_cache_batch(self):
+    inputs = [torch.randn(size).to('xla') for size in (3, 5, 7)]
+    outputs = [xinput * 2 for xinput in inputs]
+    hashes = [torch_xla._XLAC._get_graph_hash([out]) for out in outputs]
+    # The last group lowers to the same graph as the first one.
+    xr.warm_up_cache([[out] for out in outputs] + [[outputs[0]]])
+    self.assertEqual(met.counter_value('WarmUpCacheGraphs'), 3)
+    self.assertEqual(met.counter_value('WarmUpCacheDeduplicated'), 1)
+    self.assertEqual(met.metric_data('CompileTime')[0], 1)
+
+    # The warmed up graphs must be in the computation cache now.
+    for xinput, graph_hash in zip(inputs, hashes):
+      result = torch_xla._XLAC._run_cached_graph(graph_hash, [xinput])
+      self.assertEqual(len(result), 1)
+      self.assertTrue(torch.allclose(result[0].cpu(), xinput.cpu() * 2))
+
+  def test_warm_up_cache_batch_skips_cached_graphs(self):
+    xinput = torch.randn(4, 4).to('xla')
+    xr.warm_up_cache([[xinput + 1]])
+    self.assertEqual(met.counter_value('WarmUpCacheGraphs'), 1)
+    xr.warm_up_cache([[xinput + 1]])
+    self.assertEqual(met.counter_value('WarmUpCacheGraphs'), 1)
+    self.assertEqual(met.counter_value('WarmUpCacheHit'), 1)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
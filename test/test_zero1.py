@@ -151,6 +151,42 @@ class XlaZeRO1Test(test_utils.XlaTestCase):
 
         self.assertEqual(param, sharded_master_weights[loaded_param_idx])
 
+  @unittest.skipIf(xr.device_type() == 'TPU', "Crash on TPU")
+  def test_zero1_fused_step(self):
+    device = torch_xla.device()
+    for optimizer_class, kwargs in ((torch.optim.SGD, {
+        'lr': 0.1,
+        'momentum': 0.9
+    }), (torch.optim.AdamW, {
+        'lr': 0.01
+    })):
+      torch.manual_seed(0)
+      model = nn.Linear(32, 31).to(device)
+      fused_model = deepcopy(model)
+      x = torch.randn((8, 32), device=device)
+      opt = ZeroRedundancyOptimizer(
+          model.parameters(), optimizer_class, max_norm=0.5, **kwargs)
+      fused_opt = ZeroRedundancyOptimizer(
+          fused_model.parameters(),
+          optimizer_class,
+          max_norm=0.5,
+          fused_step=True,
+          **kwargs)
+      for _ in range(3):
+        for m, o in ((model, opt), (fused_model, fused_opt)):
+          o.zero_grad()
+          m(x).square().sum().backward()
+          o.step()
+        self.assertIn(
+            'xla::zero_optimizer_step',
+            torch_xla._XLAC._get_xla_tensors_text([fused_opt.grad_norm]))
+        torch_xla.sync()
+      for p, fused_p in zip(model.parameters(), fused_model.parameters()):
+        torch.testing.assert_close(
+            p.cpu(), fused_p.cpu(), rtol=1e-5, atol=1e-5)
+      torch.testing.assert_close(opt.grad_norm.cpu(),
+                                 fused_opt.grad_norm.cpu())
+
 
 def _mp_fn(index):
   device = torch_xla.device()
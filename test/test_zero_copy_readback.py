@@ -0,0 +1,35 @@
+import sys
+
+import torch
+import torch_xla
+import torch_xla.debug.metrics as met
+from absl.testing import absltest
+
+
+class ZeroCopyReadbackTest(absltest.TestCase):
+
+  def test_readback_takes_over_literal(self):
+    device = torch_xla.device()
+    expected = torch.rand(4, 16)
+    xla_tensor = expected.to(device) * 2
+    met.clear_counters()
+    result = xla_tensor.cpu()
+    self.assertGreaterEqual(met.counter_value('ZeroCopyLiteralToTensor'), 1)
+    torch.testing.assert_close(result, expected * 2)
+    self.assertTrue(result.is_contiguous())
+
+    # The storage taken over from the literal can still grow.
+    result.resize_(8, 16)
+    torch.testing.assert_close(result[:4], expected * 2)
+
+  def test_readback_with_conversion(self):
+    device = torch_xla.device()
+    expected = torch.arange(10, dtype=torch.int64)
+    result = (expected.to(device) + 1).cpu()
+    self.assertEqual(result.dtype, torch.int64)
+    torch.testing.assert_close(result, expected + 1)
+
+
+if __name__ == '__main__':
+  test = absltest.main()
+  sys.exit(0 if test.result.wasSuccessful() else 1)
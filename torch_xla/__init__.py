@@ -272,3 +272,8 @@ from ._internal import custom_kernel, decomp_registration, c10d_registration
 
 # select default PJRT_DEVICE before any execution
 runtime._maybe_select_default_device()
+
+# Initialize the runtime while the rest of the program starts up, instead of
+# on the first device access.
+if os.getenv('XLA_BACKGROUND_RUNTIME_INIT', '0') == '1':
+  _XLAC._xla_start_runtime_initialization()
@@ -510,7 +510,10 @@ def extract_internal(xla_model: torch.fx.GraphModule):
        special_return_handler, xla_args_need_update) = extract_graph_helper(
            xla_model, sym_constants_to_graph_vars)
 
-    if not config.skip_input_data_check:
+    # Outside of SPMD, the inputs are synced by `_run_cached_graph` itself, so
+    # that a guarded rerun crosses into C++ once.
+    sync_inputs = not config.skip_input_data_check and not xr.is_spmd()
+    if not config.skip_input_data_check and not sync_inputs:
       # `torch_xla.sync()` needs to be blocking since we want to access args's
       # XLADatas and they can't be placeholder.
       input_tensors_to_sync = [
@@ -549,7 +552,8 @@ def extract_internal(xla_model: torch.fx.GraphModule):
 
     # graph input should be tensor only
     graph_input = graph_input_matcher(xla_args_tensor_only)
-    res = torch_xla._XLAC._run_cached_graph(graph_hash, graph_input)
+    res = torch_xla._XLAC._run_cached_graph(
+        graph_hash, graph_input, sync_inputs=sync_inputs)
     res = special_return_handler.addDumbReturn(xla_args_tensor_only, res)
 
     assert len(res) == len(args_and_out), f"{len(res)} v.s. {len(args_and_out)}"
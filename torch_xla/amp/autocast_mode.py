@@ -40,3 +40,11 @@ class autocast(torch.amp.autocast_mode.autocast):
           cache_enabled=cache_enabled)
     else:
       print('Warning: AMP only supported for XLA:TPU. Ignoring autocast.')
+
+  def __exit__(self, exc_type, exc_val, exc_tb):
+    result = super().__exit__(exc_type, exc_val, exc_tb)
+    # The casts of the weights are cached by the XLA autocast kernels, on top
+    # of the upstream cache, until the outermost region exits.
+    if not torch.is_autocast_enabled('xla'):
+      torch_xla._XLAC._xla_clear_autocast_cache()
+    return result
@@ -8,10 +8,43 @@ def adam_step(found_inf: Tensor, state_steps: List[Tensor],
               params: List[Tensor], grads: List[Tensor], exp_avgs: List[Tensor],
               exp_avg_sqs: List[Tensor], max_exp_avg_sqs: List[Tensor], *,
               amsgrad: bool, beta1: float, beta2: float, lr: float,
-              weight_decay: float, eps: float, maximize: bool, use_adamw: bool):
+              weight_decay: float, eps: float, maximize: bool, use_adamw: bool,
+              foreach: bool = True,
+              inv_scale: Optional[Tensor] = None):
   r"""Functional API that performs PT-XLA sync-free Adam/AdamW algorithm computation
+
+  With `foreach`, all the parameters are updated by a single IR node, instead
+  of one per parameter. They must then share the dtype of `found_inf`.
+
+  With `inv_scale`, the `grads` are AMP scaled, and are unscaled and checked
+  for inf/nan values into `found_inf` before the update. With `foreach`, this
+  happens within the update node, which leaves the `grads` scaled.
    """
 
+  if foreach:
+    torch_xla._XLAC._xla_multi_tensor_adam_optimizer_step_(
+        found_inf,
+        state_steps,
+        params,
+        grads,
+        exp_avgs,
+        exp_avg_sqs,
+        max_exp_avg_sqs,
+        beta1,
+        beta2,
+        lr,
+        weight_decay,
+        eps,
+        amsgrad,
+        maximize,
+        use_adamw,
+        inv_scale=inv_scale)
+    return
+
+  if inv_scale is not None:
+    torch._amp_foreach_non_finite_check_and_unscale_(grads, found_inf,
+                                                     inv_scale)
+
   for i, param in enumerate(params):
     grad = grads[i]
     exp_avg = exp_avgs[i]
@@ -43,3 +76,41 @@ def sgd_step(found_inf: Tensor, state_steps: List[Tensor], params: List[Tensor],
     torch_xla._XLAC._xla_sgd_optimizer_step_(found_inf, step, param, buf, d_p,
                                              weight_decay, momentum, lr,
                                              dampening, nesterov, maximize)
+
+
+def lamb_step(found_inf: Tensor, state_steps: List[Tensor],
+              params: List[Tensor], grads: List[Tensor], exp_avgs: List[Tensor],
+              exp_avg_sqs: List[Tensor], *, beta1: float, beta2: float,
+              lr: float, weight_decay: float, eps: float, maximize: bool):
+  r"""Functional API that performs PT-XLA sync-free LAMB algorithm computation.
+
+  All the parameters are updated by a single IR node, each with its own trust
+  ratio. They must share the dtype of `found_inf`.
+   """
+
+  torch_xla._XLAC._xla_lamb_optimizer_step_(found_inf, state_steps, params,
+                                            grads, exp_avgs, exp_avg_sqs,
+                                            beta1, beta2, lr, weight_decay,
+                                            eps, maximize)
+
+
+def adafactor_step(found_inf: Tensor, state_steps: List[Tensor],
+                   params: List[Tensor], grads: List[Tensor],
+                   row_vars: List[Tensor], col_vars: List[Tensor], *, lr: float,
+                   beta2_decay: float, eps1: float, eps2: float, d: float,
+                   weight_decay: float, maximize: bool):
+  r"""Functional API that performs PT-XLA sync-free Adafactor algorithm
+  computation, as `torch.optim.Adafactor` does.
+
+  All the parameters are updated by a single IR node. They must share the dtype
+  of `found_inf`. The second moment of a parameter of rank two or more is
+  factored: its row variance has the shape of the parameter without the last
+  dimension, and its column variance without the one before. The row variance
+  of the other parameters has their shape, and their column variance is
+  ignored.
+   """
+
+  torch_xla._XLAC._xla_adafactor_optimizer_step_(found_inf, state_steps, params,
+                                                 grads, row_vars, col_vars, lr,
+                                                 beta2_decay, eps1, eps2, d,
+                                                 weight_decay, maximize)
@@ -37,7 +37,10 @@ class AdamW(torch.optim.AdamW):
   """
 
   @torch.no_grad()
-  def step(self, closure=None, found_inf: Tensor = None):
+  def step(self,
+           closure=None,
+           found_inf: Tensor = None,
+           inv_scale: Tensor = None):
     """Performs a single optimization step.
 
         Args:
@@ -46,13 +49,32 @@ class AdamW(torch.optim.AdamW):
             found_inf (torch.Tensor, optional): A scalar tensor indicates if
                 the optimizer.step should be performed (found_inf is 0 or None) or
                 skipped (found_inf == 1).
+            inv_scale (torch.Tensor, optional): The inverse of the AMP loss
+                scale, when the gradients are still scaled. The step then
+                unscales them and checks them for inf/nan values into
+                `found_inf`. With a single parameter group and `foreach`, this
+                happens within the update, in a single pass over the
+                gradients, which are left scaled.
         """
     if found_inf is None:
+      if inv_scale is not None:
+        raise ValueError("The inv_scale tensor requires a found_inf tensor")
       return super(AdamW, self).step(closure=closure)
 
     if found_inf.shape:
       raise ValueError("The found_inf tensor has to be scalar type")
 
+    # The check of the gradients of every group has to be done before any
+    # group is updated, so only a single group is unscaled within its step.
+    if inv_scale is not None and len(self.param_groups) > 1:
+      torch._amp_foreach_non_finite_check_and_unscale_([
+          p.grad
+          for group in self.param_groups
+          for p in group['params']
+          if p.grad is not None
+      ], found_inf, inv_scale)
+      inv_scale = None
+
     loss = None
     if closure is not None:
       with torch.enable_grad():
@@ -115,6 +137,8 @@ class AdamW(torch.optim.AdamW):
           weight_decay=group['weight_decay'],
           eps=group['eps'],
           maximize=group['maximize'],
-          use_adamw=True)
+          use_adamw=True,
+          foreach=group.get('foreach') is not False,
+          inv_scale=inv_scale)
 
     return loss
@@ -247,7 +247,7 @@ def set_replication(device: torch.device,
   else:
     torch_xla._XLAC._xla_set_replication_devices([])
     devctx.device_index = 0
-  torch_xla._XLAC._set_all_reduce_token(devctx.device, None)
+  torch_xla._XLAC._reset_all_reduce_tokens(devctx.device)
   torch_xla._XLAC._xla_set_default_device(device)
 
 
@@ -387,6 +387,83 @@ def _fetch_gradients(optimizer: optim.Optimizer) -> List[torch.Tensor]:
   return gradients
 
 
+@contextlib.contextmanager
+def token_domain(name: Optional[str] = None,
+                 groups: Optional[List[List[int]]] = None):
+  """Orders the collectives issued within the context only among themselves.
+
+  By default, all the collectives of a device are chained into a single
+  token, so XLA runs them in program order. The collectives of different
+  domains, like the data parallel gradient all-reduces and the tensor parallel
+  all-gathers, do not depend on each other through their token, which lets XLA
+  overlap them with each other and with compute. Every process must issue the
+  collectives of a domain in the same order.
+
+  Args:
+    name (string, optional): The name of the token domain.
+    groups (list, optional): The replica groups of the collectives issued within
+      the context, which name the domain when `name` is not given.
+  """
+  if name is None:
+    name = 'groups:' + str(groups or [])
+  previous = torch_xla._XLAC._get_token_domain()
+  torch_xla._XLAC._set_token_domain(name)
+  try:
+    yield
+  finally:
+    torch_xla._XLAC._set_token_domain(previous)
+
+
+class AsyncCollective(object):
+  """The pending result of a collective issued by `collective_start()`.
+
+  XLA runs the collective asynchronously with the computations which do not
+  depend on it, and places its completion right before the first use of its
+  result. When `wait()` is only called after a step boundary, the collective
+  ran along the computations of the step it was issued in, and its result is
+  an output of that step, like a prefetched parameter.
+  """
+
+  def __init__(self, result: Any):
+    self._result = result
+
+  def wait(self) -> Any:
+    """Returns the result of the collective."""
+    return self._result
+
+
+_async_collective_ids = itertools.count()
+
+
+def collective_start(fn: Callable[..., Any], *args,
+                     **kwargs) -> AsyncCollective:
+  """Issues the collective `fn(*args, **kwargs)` so that it may overlap others.
+
+  The collective goes in a token domain of its own (see `token_domain()`), so
+  it is not ordered after the collectives issued before it, like the gradient
+  all-reduces of the previous layer, and XLA may start it as soon as its
+  inputs are ready. The scheduling itself is up to XLA's latency hiding
+  scheduler, whose flags and the async collective flags of the backend can be
+  set with `torch_xla.set_custom_compile_options()`.
+
+  Args:
+    fn (callable): The collective, like `all_gather` or `reduce_scatter`.
+    *args: The positional arguments of `fn`.
+    **kwargs: The keyword arguments of `fn`.
+
+  Returns:
+    The `AsyncCollective` whose `wait()` returns the result of `fn`.
+
+  Example:
+
+    >>> pending = xm.collective_start(xm.all_gather, next_layer_shard, dim=0)
+    >>> y = layer(x, current_layer_params)
+    >>> next_layer_params = pending.wait()
+  """
+  with token_domain('async:{}'.format(next(_async_collective_ids))):
+    return AsyncCollective(fn(*args, **kwargs))
+
+
 def _get_all_reduce_token() -> Tuple[Any, DeviceContext]:
   devctx = _get_device_context()
   token = torch_xla._XLAC._get_all_reduce_token(devctx.device)
@@ -398,7 +475,10 @@ def all_reduce(
     inputs: Union[torch.Tensor, List[torch.Tensor]],
     scale: float = 1.0,
     groups: Optional[List[List[int]]] = None,
-    pin_layout: bool = True) -> Union[torch.Tensor, List[torch.Tensor]]:
+    pin_layout: bool = True,
+    reduce_dtype: Optional[torch.dtype] = None,
+    residuals: Optional[List[torch.Tensor]] = None
+) -> Union[torch.Tensor, List[torch.Tensor]]:
   """Performs an inplace reduce operation on the input tensor(s).
 
   Args:
@@ -419,6 +499,17 @@ def all_reduce(
       participate in the communication has slightly different program, but it might
       cause some xla compilation to fail. Unpin the layout when you see error message
       like "HloModule has a mix of layout constrained".
+    reduce_dtype (torch.dtype, optional): A narrower floating point type, like
+      ``torch.bfloat16`` or ``torch.float8_e5m2``, to reduce the floating
+      point inputs in, which cuts the bytes sent over the interconnect. The
+      inputs are converted back to their type after the reduction. Fp8 inputs
+      are first scaled into range by a factor shared by all the inputs of the
+      same type.
+    residuals (list, optional): With a list of inputs and `reduce_dtype`, one
+      residual per input, like zero initialized tensors kept across steps. Each
+      residual is added to its input before the conversion to `reduce_dtype`,
+      and updated inplace with the conversion error, so that the error is fed
+      back into the next reduction.
 
   Returns:
     If a single `torch.Tensor` is passed, the return value is a `torch.Tensor`
@@ -437,18 +528,22 @@ def all_reduce(
       return inputs
 
   if isinstance(inputs, torch.Tensor):
+    assert residuals is None, 'Residuals require a list of inputs'
     result = None
-    if scale == 1.0 and groups == [] and pin_layout:
+    if scale == 1.0 and groups == [] and pin_layout and reduce_dtype is None:
       # TODO(alanwaketan): Support groups.
       # Only c10d_functional version cc ops are traceable by Dynamo.
       result = torch.ops._c10d_functional.all_reduce(inputs, reduce_type, "")
     else:
-      result = torch_xla._XLAC._xla_all_reduce(reduce_type, inputs, scale,
-                                               groups, pin_layout)
+      result = torch_xla._XLAC._xla_all_reduce(
+          reduce_type, inputs, scale, groups, pin_layout, reduce_dtype)
     results = [result]
   else:
+    assert residuals is None or len(residuals) == len(inputs), (
+        'Expected one residual per input')
     torch_xla._XLAC._xla_all_reduce_inplace(reduce_type, inputs, scale, groups,
-                                            pin_layout)
+                                            pin_layout, reduce_dtype, residuals
+                                            or [])
     results = inputs
   return results[0] if isinstance(inputs, torch.Tensor) else results
 
@@ -744,6 +839,59 @@ def all_to_all(value: torch.Tensor,
   return result[0]
 
 
+def all_to_all_coalesced(
+    values: List[torch.Tensor],
+    split_dimension: int,
+    concat_dimension: int,
+    split_count: int,
+    groups: Optional[List[List[int]]] = None,
+    pin_layout: bool = True,
+    split_sizes: Optional[torch.Tensor] = None
+) -> Union[List[torch.Tensor], Tuple[List[torch.Tensor], torch.Tensor]]:
+  """Performs the `all_to_all()` of several tensors as a single operation.
+
+  The tensors may have different shapes and types, but are all split and
+  concatenated along the same dimensions.
+
+  Args:
+    values (list): The input tensors.
+    split_dimension (int): The dimension upon which the split should happen.
+    concat_dimension (int): The dimension upon which the concat should happen.
+    split_count (int): The split count.
+    groups (list, optional): A list of list, representing the replica groups for
+      the `all_to_all_coalesced()` operation. If `None` there will be only one
+      group with all the replicas in it.
+    pin_layout (bool, optional): whether to pin the layout for this
+      communication op. See `all_to_all()`.
+    split_sizes (torch.Tensor, optional): For variable sized splits, like the
+      tokens routed to each expert under a capacity factor, an integer tensor
+      with the number of valid entries in each of the `split_count` chunks. The
+      chunks keep their fixed, bounding size, the entries past the valid ones
+      being padding, and the sizes are exchanged along with the chunks.
+
+  Returns:
+    The list of the results of the `all_to_all()` of the inputs. With
+    `split_sizes`, a tuple of that list and a tensor with the number of valid
+    entries in the chunk received from each replica.
+  """
+  inputs = list(values)
+  if split_sizes is not None:
+    # Shaped so that the split and the concat keep one size per chunk.
+    sizes_shape = [1] * (max(split_dimension, concat_dimension) + 1)
+    sizes_shape[split_dimension] = split_count
+    inputs.append(split_sizes.reshape(sizes_shape))
+  token, devctx = _get_all_reduce_token()
+  result = torch_xla._XLAC._xla_all_to_all_coalesced(inputs, token,
+                                                     split_dimension,
+                                                     concat_dimension,
+                                                     split_count, groups or [],
+                                                     pin_layout)
+  torch_xla._XLAC._set_all_reduce_token(devctx.device, result[-1])
+  if split_sizes is not None:
+    return result[:len(values)], result[len(values)].reshape(split_count)
+  return result[:-1]
+
+
 def collective_permute(value: torch.Tensor,
                        pairs: List[List[int]]) -> torch.Tensor:
   """Performs a XLA `CollectivePermute()` operation on the input tensor.
@@ -1081,6 +1229,28 @@ def get_stablehlo_bytecode(tensors: Optional[torch.Tensor] = None) -> bytes:
       tensors, torch_xla._XLAC._xla_get_default_device(), [], True)
 
 
+def save_stablehlo(path: str,
+                   tensors: Optional[torch.Tensor] = None,
+                   bytecode: bool = True):
+  """Writes the StableHLO of the computation graph to a file.
+
+  The graph is picked as in `get_stablehlo_bytecode`. The StableHLO is
+  streamed to the file as it is converted, rather than built in memory, which
+  suits large models.
+
+  Args:
+    path (str): The file to write.
+    tensors (list[torch.Tensor], optional): Tensors that represent the
+      output/root of the StableHLO graph.
+    bytecode (bool): Whether to write bytecode, rather than text.
+  """
+  if tensors is None:
+    tensors = []
+  torch_xla._XLAC._save_stablehlo(tensors,
+                                  torch_xla._XLAC._xla_get_default_device(),
+                                  bytecode, path)
+
+
 def wait_device_ops(devices: List[str] = []):
   """Waits for all the async operations on the given devices to complete.
 
@@ -1091,6 +1261,25 @@ def wait_device_ops(devices: List[str] = []):
   torch_xla._XLAC._xla_wait_device_ops(devices=devices)
 
 
+def cpu_async(tensors: List[torch.Tensor]) -> 'torch_xla._XLAC.TensorsTransfer':
+  """Starts copying `tensors` to CPU, without waiting for the copies.
+
+  The pending computations of `tensors` are executed as by `.cpu()`, but the
+  call returns once the copies from device are started, so that they overlap
+  with the tracing of the next step. Typically used to log losses or metrics
+  every step.
+
+  Args:
+    tensors: List of `torch.Tensor`s on `xla` devices.
+
+  Returns:
+    A handle whose `is_ready()` tells whether the copies completed, without
+    blocking, and whose `wait()` blocks until they did and returns the CPU
+    tensors.
+  """
+  return torch_xla._XLAC._xla_get_cpu_tensors_async(tensors)
+
+
 def all_reduce_bucketized_gradients(gradients: List[torch.Tensor],
                                     scale: float,
                                     groups: Optional[List[List[int]]],
@@ -1266,6 +1455,28 @@ def _maybe_convert_to_cpu(data: Any, convert: bool = True) -> ToXlaTensorArena:
   return ToXlaTensorArena(convert_fn, select_fn).transform(data)
 
 
+def _get_input_shardings(tensors: List[torch.Tensor],
+                         input_sharding: Optional[ShardingSpec]):
+  shardings = None
+  if input_sharding:
+    shardings = [input_sharding.xla_spec(t) for t in tensors]
+  if input_sharding and input_sharding.minibatch:
+    # when minibatch is configured we must make sure batch dimension of
+    # the tensor is divisible by the local runtime device count.
+    for tensor, sharding in zip(tensors, shardings):
+      # assume batch dimension is 0
+      local_runtime_device_count = torch_xla.runtime.addressable_runtime_device_count(
+      )
+      if sharding and tensor.dim() > 0 and (tensor.size()[0] %
+                                            local_runtime_device_count) != 0:
+        raise RuntimeError(
+            "When minibatch is configured, the per-host batch size must be divisible "
+            + "by local runtime device count. Per host input data shape " +
+            f"= {tensor.size()}, local_runtime_device_count = {local_runtime_device_count}"
+        )
+  return shardings
+
+
 def send_cpu_data_to_device(
     datas: Any,
     device: Union[str, torch.device],
@@ -1273,24 +1484,7 @@ def send_cpu_data_to_device(
 
   def convert_fn(tensors):
     devices = [str(device)] * len(tensors)
-    shardings = None
-    if input_sharding:
-      shardings = [input_sharding.xla_spec(t) for t in tensors]
-    if input_sharding and input_sharding.minibatch:
-      # when minibatch is configured we must make sure batch dimension of
-      # the tensor is divisible by the local runtime device count.
-      for tensor, sharding in zip(tensors, shardings):
-        # assume batch dimension is 0
-        local_runtime_device_count = torch_xla.runtime.addressable_runtime_device_count(
-        )
-        if sharding and tensor.dim() > 0 and (tensor.size()[0] %
-                                              local_runtime_device_count) != 0:
-          raise RuntimeError(
-              "When minibatch is configured, the per-host batch size must be divisible "
-              + "by local runtime device count. Per host input data shape " +
-              f"= {tensor.size()}, local_runtime_device_count = {local_runtime_device_count}"
-          )
-
+    shardings = _get_input_shardings(tensors, input_sharding)
     xtensors = torch_xla._XLAC._xla_tensors_from_aten(tensors, devices,
                                                       shardings)
     return xtensors
@@ -1478,6 +1672,42 @@ def get_rng_state(device: Optional[str] = None) -> int:
   return torch_xla._XLAC._xla_get_rng_seed(str(device) if device else '')
 
 
+def get_rng_generator_state(device: Optional[str] = None) -> torch.Tensor:
+  """Gets the full state of the random number generator.
+
+  Unlike :func:`get_rng_state`, the state holds the offset of the next random
+  op from the base seed as well, which the ``XLA_RNG_COUNTER_BASED`` mode needs
+  to resume the random stream in the middle of a step. It is laid out as the
+  state of a ``torch.Generator`` of an XLA device.
+
+  Args:
+    device (string, optional): The device whose RNG state needs to be retrieved.
+      If missing the default device state is returned.
+
+  Returns:
+    The RNG state, as a CPU uint8 tensor.
+  """
+  if device is None:
+    device = torch_xla._XLAC._xla_get_default_device()
+  return torch_xla._XLAC._xla_get_rng_generator_state(
+      str(device) if device else '')
+
+
+def set_rng_generator_state(state: torch.Tensor,
+                            device: Optional[str] = None):
+  """Sets the full state of the random number generator.
+
+  Args:
+    state (torch.Tensor): A state returned by :func:`get_rng_generator_state`.
+    device (string, optional): The device where the RNG state needs to be set.
+      If missing the default device state will be set.
+  """
+  if device is None:
+    device = torch_xla._XLAC._xla_get_default_device()
+  torch_xla._XLAC._xla_set_rng_generator_state(state,
+                                               str(device) if device else '')
+
+
 @contextlib.contextmanager
 def fork_rng(device: Optional[str] = None, enabled: bool = True):
   """
@@ -1492,17 +1722,19 @@ def fork_rng(device: Optional[str] = None, enabled: bool = True):
 
   if device is None:
     device = torch_xla._XLAC._xla_get_default_device()
-  xla_rng_state = get_rng_state(device=device)
+  xla_rng_state = get_rng_generator_state(device=device)
 
   try:
     yield
   finally:
-    set_rng_state(xla_rng_state, device=device)
+    set_rng_generator_state(xla_rng_state, device=device)
 
 
 class MemoryInfo(TypedDict):
   bytes_used: str
   bytes_limit: int
+  peak_bytes_used: int
+  largest_free_block_bytes: int
 
 
 def get_memory_info(device: Optional[torch.device] = None) -> MemoryInfo:
@@ -1518,13 +1750,42 @@ def get_memory_info(device: Optional[torch.device] = None) -> MemoryInfo:
   Example:
 
     >>> xm.get_memory_info()
-    {'bytes_used': 290816, 'bytes_limit': 34088157184, 'peak_bytes_used': 500816}
+    {'bytes_used': 290816, 'bytes_limit': 34088157184,
+     'peak_bytes_used': 500816, 'largest_free_block_bytes': 34087866368}
   """
   if device == None:
     device = xla_device()
   return torch_xla._XLAC._xla_memory_info(str(device))
 
 
+def set_memory_kind(tensor: torch.Tensor, memory_kind: str) -> torch.Tensor:
+  """Moves the data of an XLA tensor to another memory space of its devices.
+
+  Data placed in host memory, like large optimizer states, does not take
+  device memory while it is not used. The executions using it as an argument
+  copy it to the device for their duration. Graph outputs can be placed in
+  host memory with the `place_to_host` op of
+  `torch_xla.experimental.stablehlo_custom_call`.
+
+  Args:
+    tensor: The XLA tensor, which is materialized if needed.
+    memory_kind: The kind of the target memory space, like `'device'`,
+      `'pinned_host'` or `'unpinned_host'`.
+
+  Returns:
+    `tensor`, whose data is moved in place.
+  """
+  torch_xla._XLAC._xla_sync_multi([tensor], devices=[], wait=False)
+  torch_xla._XLAC._xla_set_memory_kind(tensor, memory_kind)
+  return tensor
+
+
+def get_memory_kind(tensor: torch.Tensor) -> str:
+  """Returns the kind of the memory space holding the data of an XLA tensor."""
+  torch_xla._XLAC._xla_sync_multi([tensor], devices=[], wait=False)
+  return torch_xla._XLAC._xla_get_memory_kind(tensor)
+
+
 def optimization_barrier_(tensors: List[torch.Tensor]):
   """Blocks xla compiler from moving computations across this barrier. The common
   use case would be blocking xla common-subexpression elimination pass from undoing
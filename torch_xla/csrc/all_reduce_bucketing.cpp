@@ -0,0 +1,293 @@
+#include "torch_xla/csrc/all_reduce_bucketing.h"
+
+#include <map>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/cross_replica_reduces.h"
+#include "torch_xla/csrc/ir_simplification.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/status.h"
+
+namespace torch_xla {
+namespace {
+
+const AllReduce* AsBucketableAllReduce(const torch::lazy::Node* node) {
+  if (node->op() != xla_cross_replica_sum) {
+    return nullptr;
+  }
+  const AllReduce* all_reduce = dynamic_cast<const AllReduce*>(node);
+  // The residuals, which follow the operands, would need to be interleaved
+  // with those of the other members.
+  return all_reduce != nullptr && all_reduce->has_token() &&
+                 !all_reduce->has_residuals()
+             ? all_reduce
+             : nullptr;
+}
+
+int64_t OperandBytes(const AllReduce* all_reduce) {
+  int64_t bytes = 0;
+  const std::vector<torch::lazy::Output>& operands = all_reduce->operands();
+  for (size_t i = 0; i + 1 < operands.size(); ++i) {
+    const XlaNode* operand = dynamic_cast<const XlaNode*>(operands[i].node);
+    bytes +=
+        xla::ShapeUtil::ByteSizeOf(operand->xla_shape(operands[i].index));
+  }
+  return bytes;
+}
+
+torch::lazy::Output TokenOutput(const AllReduce* all_reduce) {
+  return torch::lazy::Output(all_reduce, all_reduce->num_outputs() - 1);
+}
+
+// Whether `next` can join the bucket ending with `last`, whose members are
+// `members`.
+bool CanJoin(const AllReduce* last, const AllReduce* next,
+             const std::unordered_set<const torch::lazy::Node*>& members) {
+  if (next->reduce_type() != last->reduce_type() ||
+      next->scale() != last->scale() || next->groups() != last->groups() ||
+      next->pin_layout() != last->pin_layout() ||
+      next->reduce_element_type() != last->reduce_element_type()) {
+    return false;
+  }
+  // The bucket takes the token of its first member only, so the others must
+  // chain on the previous member's token.
+  const std::vector<torch::lazy::Output>& operands = next->operands();
+  if (!(operands.back() == TokenOutput(last))) {
+    return false;
+  }
+  for (size_t i = 0; i + 1 < operands.size(); ++i) {
+    if (members.count(operands[i].node) > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The attributes and inputs, but the token, which make two all-reduces compute
+// the same results.
+using AllReduceKey =
+    std::tuple<AllReduceType, double, std::vector<std::vector<int64_t>>, bool,
+               std::optional<xla::PrimitiveType>, bool,
+               std::vector<std::pair<const torch::lazy::Node*, size_t>>>;
+
+AllReduceKey MakeAllReduceKey(const AllReduce* all_reduce) {
+  const std::vector<torch::lazy::Output>& operands = all_reduce->operands();
+  size_t num_inputs = operands.size() - (all_reduce->has_token() ? 1 : 0);
+  std::vector<std::pair<const torch::lazy::Node*, size_t>> inputs;
+  inputs.reserve(num_inputs);
+  for (size_t i = 0; i < num_inputs; ++i) {
+    inputs.emplace_back(operands[i].node, operands[i].index);
+  }
+  return {all_reduce->reduce_type(), all_reduce->scale(), all_reduce->groups(),
+          all_reduce->pin_layout(), all_reduce->reduce_element_type(),
+          all_reduce->has_token(), std::move(inputs)};
+}
+
+bool UsesAny(const torch::lazy::Node* node,
+             const std::unordered_set<const torch::lazy::Node*>& members) {
+  for (const torch::lazy::Output& operand : node->operands()) {
+    if (members.count(operand.node) > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+absl::Status LowerBucket(const std::vector<const AllReduce*>& bucket,
+                         LoweringContext* loctx) {
+  std::vector<xla::XlaOp> inputs;
+  for (const AllReduce* all_reduce : bucket) {
+    const std::vector<torch::lazy::Output>& operands = all_reduce->operands();
+    for (size_t i = 0; i + 1 < operands.size(); ++i) {
+      XLA_ASSIGN_OR_RETURN(xla::XlaOp input,
+                           loctx->SafeGetOutputOp(operands[i]));
+      inputs.push_back(input);
+    }
+  }
+  const AllReduce* first = bucket.front();
+  XLA_ASSIGN_OR_RETURN(xla::XlaOp token,
+                       loctx->SafeGetOutputOp(first->operands().back()));
+  std::vector<xla::XlaOp> results =
+      BuildAllReduce(first->reduce_type(), inputs, token, first->scale(),
+                     first->groups(), first->pin_layout(),
+                     first->reduce_element_type());
+  // Every member returns the token of the whole bucket, as the bucket runs
+  // after all of their predecessors.
+  size_t result_index = 0;
+  for (const AllReduce* all_reduce : bucket) {
+    for (size_t i = 0; i + 1 < all_reduce->num_outputs(); ++i) {
+      loctx->AssignOutputOp(torch::lazy::Output(all_reduce, i),
+                            results[result_index++]);
+    }
+    loctx->AssignOutputOp(TokenOutput(all_reduce), results.back());
+  }
+  TORCH_LAZY_COUNTER("AllReduceBuckets", 1);
+  TORCH_LAZY_COUNTER("BucketedAllReduces", bucket.size());
+  return absl::OkStatus();
+}
+
+// Lowers `duplicate` to the results of `original`, and its token to the one it
+// takes, since it issues no collective.
+absl::Status LowerDuplicate(const AllReduce* duplicate,
+                            const AllReduce* original,
+                            LoweringContext* loctx) {
+  size_t num_results =
+      duplicate->num_outputs() - (duplicate->has_token() ? 1 : 0);
+  for (size_t i = 0; i < num_results; ++i) {
+    XLA_ASSIGN_OR_RETURN(
+        xla::XlaOp result,
+        loctx->SafeGetOutputOp(torch::lazy::Output(original, i)));
+    loctx->AssignOutputOp(torch::lazy::Output(duplicate, i), result);
+  }
+  if (duplicate->has_token()) {
+    XLA_ASSIGN_OR_RETURN(
+        xla::XlaOp token,
+        loctx->SafeGetOutputOp(duplicate->operands().back()));
+    loctx->AssignOutputOp(TokenOutput(duplicate), token);
+  }
+  TORCH_LAZY_COUNTER("DeduplicatedAllReduces", 1);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int64_t GetAllReduceBucketCapBytes() {
+  static const int64_t bucket_cap_bytes =
+      runtime::sys_util::GetEnvInt("XLA_ALL_REDUCE_BUCKET_CAP_MB", 0) *
+      (int64_t{1} << 20);
+  return bucket_cap_bytes;
+}
+
+std::unordered_map<const torch::lazy::Node*, const AllReduce*>
+FindDuplicateAllReduces(c10::ArrayRef<const torch::lazy::Node*> post_order) {
+  std::unordered_map<const torch::lazy::Node*, const AllReduce*> duplicates;
+  std::map<AllReduceKey, const AllReduce*> first_of;
+  for (const torch::lazy::Node* node : post_order) {
+    if (node->op() != xla_cross_replica_sum) {
+      continue;
+    }
+    const AllReduce* all_reduce = dynamic_cast<const AllReduce*>(node);
+    // The residuals carry the state of the compressed all-reduces, which every
+    // one of them updates.
+    if (all_reduce == nullptr || all_reduce->has_residuals()) {
+      continue;
+    }
+    auto [it, inserted] =
+        first_of.emplace(MakeAllReduceKey(all_reduce), all_reduce);
+    if (!inserted) {
+      duplicates.emplace(all_reduce, it->second);
+    }
+  }
+  return duplicates;
+}
+
+std::vector<std::vector<const AllReduce*>> PlanAllReduceBuckets(
+    c10::ArrayRef<const torch::lazy::Node*> post_order,
+    int64_t bucket_cap_bytes,
+    const std::unordered_map<const torch::lazy::Node*, const AllReduce*>&
+        duplicates) {
+  std::vector<std::vector<const AllReduce*>> buckets;
+  std::vector<const AllReduce*> bucket;
+  std::unordered_set<const torch::lazy::Node*> members;
+  int64_t bucket_bytes = 0;
+  auto close_bucket = [&]() {
+    if (bucket.size() > 1) {
+      buckets.push_back(std::move(bucket));
+    }
+    bucket.clear();
+    members.clear();
+    bucket_bytes = 0;
+  };
+
+  for (const torch::lazy::Node* node : post_order) {
+    auto duplicate_it = duplicates.find(node);
+    if (duplicate_it != duplicates.end()) {
+      // A duplicate takes the results of its original, which must be lowered
+      // by then.
+      if (members.count(duplicate_it->second) > 0) {
+        close_bucket();
+      }
+      continue;
+    }
+    const AllReduce* all_reduce = AsBucketableAllReduce(node);
+    if (all_reduce == nullptr) {
+      // The bucket is lowered in place of its last member, so it must end
+      // before the first use of its outputs.
+      if (!members.empty() && UsesAny(node, members)) {
+        close_bucket();
+      }
+      continue;
+    }
+    int64_t bytes = OperandBytes(all_reduce);
+    if (bucket.empty() || !CanJoin(bucket.back(), all_reduce, members) ||
+        bucket_bytes + bytes > bucket_cap_bytes) {
+      close_bucket();
+    }
+    if (bytes <= bucket_cap_bytes) {
+      bucket.push_back(all_reduce);
+      members.insert(all_reduce);
+      bucket_bytes += bytes;
+    }
+  }
+  close_bucket();
+  return buckets;
+}
+
+absl::Status LowerWithAllReduceBuckets(
+    c10::ArrayRef<const torch::lazy::Node*> post_order,
+    int64_t bucket_cap_bytes, LoweringContext* loctx) {
+  std::unordered_map<const torch::lazy::Node*, const AllReduce*> duplicates =
+      FindDuplicateAllReduces(post_order);
+  std::vector<std::vector<const AllReduce*>> buckets;
+  if (bucket_cap_bytes > 0) {
+    buckets = PlanAllReduceBuckets(post_order, bucket_cap_bytes, duplicates);
+  }
+  // Maps the members of the buckets to their bucket, for the last member, or
+  // to nothing, for the ones lowered along with a later member.
+  std::unordered_map<const torch::lazy::Node*,
+                     const std::vector<const AllReduce*>*>
+      bucket_of;
+  for (const std::vector<const AllReduce*>& bucket : buckets) {
+    for (const AllReduce* all_reduce : bucket) {
+      bucket_of[all_reduce] = nullptr;
+    }
+    bucket_of[bucket.back()] = &bucket;
+  }
+
+  IrSimplification simplification;
+  if (UseIrSimplification()) {
+    simplification = SimplifyPostOrder(post_order);
+  }
+
+  for (const torch::lazy::Node* node : post_order) {
+    XLA_ASSIGN_OR_RETURN(bool simplified,
+                         LowerSimplified(*node, simplification, loctx));
+    if (simplified) {
+      continue;
+    }
+    auto duplicate_it = duplicates.find(node);
+    if (duplicate_it != duplicates.end()) {
+      XLA_RETURN_IF_ERROR(LowerDuplicate(
+          dynamic_cast<const AllReduce*>(node), duplicate_it->second, loctx));
+      continue;
+    }
+    auto it = bucket_of.find(node);
+    if (it == bucket_of.end()) {
+      XLA_RETURN_IF_ERROR(loctx->LowerNode(*node).status());
+    } else if (it->second != nullptr) {
+      XLA_RETURN_IF_ERROR(LowerBucket(*it->second, loctx));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,55 @@
+#ifndef XLA_TORCH_XLA_CSRC_ALL_REDUCE_BUCKETING_H_
+#define XLA_TORCH_XLA_CSRC_ALL_REDUCE_BUCKETING_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <c10/util/ArrayRef.h>
+#include <torch/csrc/lazy/core/ir.h>
+
+#include "absl/status/status.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/all_reduce.h"
+
+namespace torch_xla {
+
+// Returns the maximum size in bytes of the operands of the all-reduces
+// combined into one, from $XLA_ALL_REDUCE_BUCKET_CAP_MB. Zero, the default,
+// disables the bucketing.
+int64_t GetAllReduceBucketCapBytes();
+
+// Maps the all-reduces of `post_order` which compute the same results as an
+// earlier one, as they share its inputs, reduce type, scale, groups, layout
+// pinning and reduce element type, to that earlier all-reduce. The ones with
+// residuals are never duplicates.
+std::unordered_map<const torch::lazy::Node*, const AllReduce*>
+FindDuplicateAllReduces(c10::ArrayRef<const torch::lazy::Node*> post_order);
+
+// Groups the all-reduces of `post_order` which can run as a single one into
+// buckets of operands totalling at most `bucket_cap_bytes`. The all-reduces of
+// a bucket follow one another through their tokens, share their reduce type,
+// scale, groups, layout pinning and reduce element type, carry no residuals,
+// and none of their outputs is used before the last of them, so that the
+// bucket can be lowered in its place. The `duplicates` are left out of the
+// buckets, which end before them when they hold their original. Only the
+// buckets of more than one all-reduce are returned, in post order.
+std::vector<std::vector<const AllReduce*>> PlanAllReduceBuckets(
+    c10::ArrayRef<const torch::lazy::Node*> post_order,
+    int64_t bucket_cap_bytes,
+    const std::unordered_map<const torch::lazy::Node*, const AllReduce*>&
+        duplicates = {});
+
+// Lowers the nodes of `post_order` into `loctx`, each bucket of all-reduces
+// planned with `bucket_cap_bytes` as a single all-reduce over the operands of
+// all of them, and every duplicate all-reduce to the results of its original.
+// With $XLA_IR_SIMPLIFY set, the duplicate and constant nodes found by
+// SimplifyPostOrder() are lowered to the ops of their simplification.
+absl::Status LowerWithAllReduceBuckets(
+    c10::ArrayRef<const torch::lazy::Node*> post_order,
+    int64_t bucket_cap_bytes, LoweringContext* loctx);
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_ALL_REDUCE_BUCKETING_H_
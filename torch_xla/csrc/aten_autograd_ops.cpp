@@ -238,6 +238,87 @@ torch::autograd::variable_list MaxPool3dAutogradFunction::backward(
   return grad_inputs;
 }
 
+torch::Tensor BlockedAttentionAutogradFunction::forward(
+    torch::autograd::AutogradContext* ctx, torch::Tensor query,
+    torch::Tensor key, torch::Tensor value, double scale, bool is_causal,
+    int64_t block_size) {
+  ctx->saved_data["scale"] = scale;
+  ctx->saved_data["is_causal"] = is_causal;
+  ctx->saved_data["block_size"] = block_size;
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_query, bridge::GetXlaTensor(query));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_key, bridge::GetXlaTensor(key));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_value, bridge::GetXlaTensor(value));
+  std::tuple<XLATensorPtr, XLATensorPtr> outputs =
+      tensor_methods::blocked_attention(xla_query, xla_key, xla_value, scale,
+                                        is_causal, block_size);
+  torch::Tensor output = bridge::AtenFromXlaTensor(std::get<0>(outputs));
+  torch::Tensor lse = bridge::AtenFromXlaTensor(std::get<1>(outputs));
+  ctx->save_for_backward({query, key, value, output, lse});
+  return output;
+}
+
+torch::autograd::variable_list BlockedAttentionAutogradFunction::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_output) {
+  double scale = ctx->saved_data["scale"].toDouble();
+  bool is_causal = ctx->saved_data["is_causal"].toBool();
+  int64_t block_size = ctx->saved_data["block_size"].toInt();
+  torch::autograd::variable_list saved = ctx->get_saved_variables();
+  XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xla_saved,
+                      bridge::GetXlaTensors(saved));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_grad_output,
+                      bridge::GetXlaTensor(grad_output[0].contiguous()));
+  std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> grads =
+      tensor_methods::blocked_attention_backward(
+          xla_grad_output, xla_saved[0], xla_saved[1], xla_saved[2],
+          xla_saved[3], xla_saved[4], scale, is_causal, block_size);
+  // The scale, the causal flag and the block size have no gradients.
+  torch::Tensor undef;
+  return {bridge::AtenFromXlaTensor(std::get<0>(grads)),
+          bridge::AtenFromXlaTensor(std::get<1>(grads)),
+          bridge::AtenFromXlaTensor(std::get<2>(grads)),
+          undef,
+          undef,
+          undef};
+}
+
+torch::Tensor RmsNormAutogradFunction::forward(
+    torch::autograd::AutogradContext* ctx, torch::Tensor input,
+    torch::Tensor weight, int64_t normalized_ndim, double eps) {
+  ctx->saved_data["normalized_ndim"] = normalized_ndim;
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input, bridge::GetXlaTensor(input));
+  XLATensorPtr xla_weight =
+      bridge::GetOrCreateXlaTensor(weight, xla_input->GetDevice());
+  std::tuple<XLATensorPtr, XLATensorPtr> outputs =
+      tensor_methods::rms_norm(xla_input, normalized_ndim, xla_weight, eps);
+  torch::Tensor rstd = bridge::AtenFromXlaTensor(std::get<1>(outputs));
+  ctx->save_for_backward({input, weight, rstd});
+  return bridge::AtenFromXlaTensor(std::get<0>(outputs));
+}
+
+torch::autograd::variable_list RmsNormAutogradFunction::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_output) {
+  int64_t normalized_ndim = ctx->saved_data["normalized_ndim"].toInt();
+  torch::autograd::variable_list saved = ctx->get_saved_variables();
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input, bridge::GetXlaTensor(saved[0]));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_rstd, bridge::GetXlaTensor(saved[2]));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_grad_output,
+                      bridge::GetXlaTensor(grad_output[0]));
+  XLATensorPtr xla_weight =
+      bridge::GetOrCreateXlaTensor(saved[1], xla_input->GetDevice());
+  std::tuple<XLATensorPtr, XLATensorPtr> grads =
+      tensor_methods::rms_norm_backward(xla_grad_output, xla_input,
+                                        normalized_ndim, xla_rstd, xla_weight);
+  // The weight has a gradient only if there is one, and the number of
+  // normalized dimensions and the epsilon have none.
+  torch::Tensor undef;
+  return {bridge::AtenFromXlaTensor(std::get<0>(grads)),
+          saved[1].defined() ? bridge::AtenFromXlaTensor(std::get<1>(grads))
+                             : undef,
+          undef, undef};
+}
+
 torch::Tensor max_pool2d_forward(torch::Tensor self,
                                  torch::IntArrayRef kernel_size,
                                  torch::IntArrayRef stride,
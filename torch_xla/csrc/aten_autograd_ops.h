@@ -46,6 +46,31 @@ struct MaxPool3dAutogradFunction
       torch::autograd::variable_list grad_output);
 };
 
+// The scaled dot product attention of the blocked attention lowering, whose
+// backward recomputes the probabilities from the saved log-sum-exps.
+struct BlockedAttentionAutogradFunction
+    : public torch::autograd::Function<BlockedAttentionAutogradFunction> {
+  static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
+                               torch::Tensor query, torch::Tensor key,
+                               torch::Tensor value, double scale,
+                               bool is_causal, int64_t block_size);
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_output);
+};
+
+// The root mean square normalization, whose backward reuses the reciprocal
+// root mean square saved by the fused forward.
+struct RmsNormAutogradFunction
+    : public torch::autograd::Function<RmsNormAutogradFunction> {
+  static torch::Tensor forward(torch::autograd::AutogradContext* ctx,
+                               torch::Tensor input, torch::Tensor weight,
+                               int64_t normalized_ndim, double eps);
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_output);
+};
+
 torch::Tensor max_pool2d_forward(torch::Tensor self,
                                  torch::IntArrayRef kernel_size,
                                  torch::IntArrayRef stride,
@@ -1,17 +1,38 @@
 #include "torch_xla/csrc/aten_fallback.h"
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <ATen/Context.h>
 #include <ATen/DLConvertor.h>
-#include <ATen/native/CPUFallback.h>
+#include <ATen/core/dispatch/Dispatcher.h>
 #include <ATen/ops/_copy_from_and_resize.h>
 #include <ATen/ops/_to_cpu.h>
+#include <c10/core/impl/VirtualGuardImpl.h>
+#include <torch/csrc/lazy/core/metrics.h>
 #include <torch/csrc/utils/device_lazy_init.h>
 
+#include "absl/strings/str_cat.h"
+#include "xla/pjrt/pjrt_compiler.h"
+
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/dl_convertor.h"
 #include "torch_xla/csrc/function_call_tracker.h"
 #include "torch_xla/csrc/runtime/metrics.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/tf_logging.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_util.h"
+#include "torch_xla/csrc/xla_graph_executor.h"
 
 namespace torch_xla {
 
@@ -22,10 +43,441 @@ namespace torch_xla {
 static std::unordered_map<std::string, ::torch_xla::runtime::metrics::Counter*>
     _fallback_counters;
 
+namespace {
+
+constexpr size_t kNumFallbackPhases = 3;
+
+const char* FallbackPhaseName(FallbackPhase phase) {
+  switch (phase) {
+    case FallbackPhase::kSync:
+      return "Sync";
+    case FallbackPhase::kTransferFromDevice:
+      return "TransferFromDevice";
+    case FallbackPhase::kTransferToDevice:
+      return "TransferToDevice";
+  }
+  return "Unknown";
+}
+
+// The costs accounted to the fallback running on a thread.
+struct FallbackCost {
+  std::array<int64_t, kNumFallbackPhases> time_ns = {};
+  std::array<int64_t, kNumFallbackPhases> bytes = {};
+  // Whether a phase happened at all, the sync may be a no-op.
+  std::array<bool, kNumFallbackPhases> happened = {};
+};
+
+thread_local FallbackCost* current_fallback_cost = nullptr;
+
+// The cost metrics of a fallback operator.
+struct FallbackMetrics {
+  explicit FallbackMetrics(const std::string& name) {
+    for (size_t i = 0; i < kNumFallbackPhases; ++i) {
+      std::string phase = FallbackPhaseName(static_cast<FallbackPhase>(i));
+      time[i] = new ::torch_xla::runtime::metrics::Metric(
+          absl::StrCat(name, "/", phase, "Time"),
+          ::torch_xla::runtime::metrics::MetricFnTime);
+      if (static_cast<FallbackPhase>(i) != FallbackPhase::kSync) {
+        bytes[i] = new ::torch_xla::runtime::metrics::Metric(
+            absl::StrCat(name, "/", phase, "Bytes"),
+            ::torch_xla::runtime::metrics::MetricFnBytes);
+      }
+    }
+    cpu_time = new ::torch_xla::runtime::metrics::Metric(
+        absl::StrCat(name, "/CpuTime"),
+        ::torch_xla::runtime::metrics::MetricFnTime);
+  }
+
+  std::array<::torch_xla::runtime::metrics::Metric*, kNumFallbackPhases>
+      time = {};
+  std::array<::torch_xla::runtime::metrics::Metric*, kNumFallbackPhases>
+      bytes = {};
+  ::torch_xla::runtime::metrics::Metric* cpu_time;
+};
+
+std::mutex fallback_mutex;
+std::unordered_map<std::string, FallbackMetrics*> fallback_metrics;
+
+// An argument of a fallback holding tensors, a tensor or a list of them.
+struct TensorArgument {
+  size_t index;
+  c10::IValue original;
+  // The tensors of the argument, undefined for the absent optional ones.
+  std::vector<at::Tensor> tensors;
+  // The tensors of the argument on the backend running the fallback.
+  std::vector<at::Tensor> backend_tensors;
+};
+
+bool IsSameAlias(const c10::AliasInfo* alias_info,
+                 const c10::AliasInfo* other) {
+  return alias_info == other ||
+         (alias_info != nullptr && other != nullptr && *alias_info == *other);
+}
+
+std::vector<TensorArgument> GetTensorArguments(const c10::OperatorHandle& op,
+                                               const torch::jit::Stack& stack) {
+  const size_t num_arguments = op.schema().arguments().size();
+  const size_t arguments_begin = stack.size() - num_arguments;
+  std::vector<TensorArgument> tensor_arguments;
+  for (size_t i = 0; i < num_arguments; ++i) {
+    const c10::IValue& ivalue = stack[arguments_begin + i];
+    TensorArgument argument{i, ivalue};
+    if (ivalue.isTensor()) {
+      argument.tensors.push_back(ivalue.toTensor());
+    } else if (ivalue.isTensorList()) {
+      argument.tensors = ivalue.toTensorVector();
+    } else if (ivalue.isOptionalTensorList()) {
+      for (const std::optional<at::Tensor>& tensor :
+           ivalue.toOptionalTensorVector()) {
+        argument.tensors.push_back(tensor.value_or(at::Tensor()));
+      }
+    } else {
+      continue;
+    }
+    tensor_arguments.push_back(std::move(argument));
+  }
+  return tensor_arguments;
+}
+
+// Replaces the tensors of the arguments on `stack` by their backend tensors.
+void SetBackendArguments(const c10::OperatorHandle& op,
+                         const std::vector<TensorArgument>& tensor_arguments,
+                         torch::jit::Stack* stack) {
+  const size_t arguments_begin =
+      stack->size() - op.schema().arguments().size();
+  for (const TensorArgument& argument : tensor_arguments) {
+    c10::IValue& ivalue = (*stack)[arguments_begin + argument.index];
+    if (argument.original.isTensor()) {
+      ivalue = c10::IValue(argument.backend_tensors.front());
+    } else if (argument.original.isTensorList()) {
+      ivalue = c10::IValue(c10::List<at::Tensor>(argument.backend_tensors));
+    } else {
+      c10::List<std::optional<at::Tensor>> list;
+      for (const at::Tensor& tensor : argument.backend_tensors) {
+        list.push_back(tensor.defined() ? std::optional<at::Tensor>(tensor)
+                                        : std::nullopt);
+      }
+      ivalue = c10::IValue(std::move(list));
+    }
+  }
+}
+
+// Replaces the device arguments on `stack` by `device`, and returns the first
+// original one, if any.
+std::optional<c10::Device> SetDeviceArguments(const c10::OperatorHandle& op,
+                                              const c10::Device& device,
+                                              torch::jit::Stack* stack) {
+  const size_t num_arguments = op.schema().arguments().size();
+  const size_t arguments_begin = stack->size() - num_arguments;
+  std::optional<c10::Device> original;
+  for (size_t i = 0; i < num_arguments; ++i) {
+    c10::IValue& ivalue = (*stack)[arguments_begin + i];
+    if (ivalue.isDevice()) {
+      if (!original) {
+        original = ivalue.toDevice();
+      }
+      ivalue = c10::IValue(device);
+    }
+  }
+  return original;
+}
+
+// Replaces the results of `op` on `stack`: the mutable aliases by their
+// original argument, and the other tensors by `to_xla` of them. Errors on
+// views.
+void SetResults(const c10::OperatorHandle& op,
+                const std::vector<TensorArgument>& tensor_arguments,
+                const std::function<at::Tensor(const at::Tensor&)>& to_xla,
+                torch::jit::Stack* stack) {
+  const std::vector<c10::Argument>& schema_args = op.schema().arguments();
+  const std::vector<c10::Argument>& schema_returns = op.schema().returns();
+  const size_t returns_begin = stack->size() - schema_returns.size();
+  for (size_t i = 0; i < schema_returns.size(); ++i) {
+    c10::IValue& ivalue = (*stack)[returns_begin + i];
+    const c10::AliasInfo* alias_info = schema_returns[i].alias_info();
+    if (alias_info != nullptr && alias_info->isWrite()) {
+      bool found_alias = false;
+      for (const TensorArgument& argument : tensor_arguments) {
+        if (IsSameAlias(alias_info, schema_args[argument.index].alias_info())) {
+          ivalue = argument.original;
+          found_alias = true;
+          break;
+        }
+      }
+      TORCH_CHECK(found_alias, "The operator ", op.schema().operator_name(),
+                  " appears to have invalid alias information. Found a "
+                  "return tensor argument with a mismatched mutable alias: ",
+                  schema_returns[i]);
+      continue;
+    }
+    TORCH_CHECK(alias_info == nullptr, "The operator ",
+                op.schema().operator_name(),
+                " appears to be a view operator, but it has no "
+                "implementation for the XLA backend. View operators don't "
+                "support falling back to run on the CPU, since the tensor's "
+                "storage cannot be shared across devices.");
+    if (ivalue.isTensor() && ivalue.toTensor().defined()) {
+      ivalue = c10::IValue(to_xla(ivalue.toTensor()));
+    } else if (ivalue.isTensorList()) {
+      std::vector<at::Tensor> tensors;
+      for (const at::Tensor& tensor : ivalue.toTensorVector()) {
+        tensors.push_back(tensor.defined() ? to_xla(tensor) : tensor);
+      }
+      ivalue = c10::IValue(c10::List<at::Tensor>(std::move(tensors)));
+    }
+  }
+}
+
+// Uploads the CPU data which `tensors` hold, pending their first use, with a
+// single transfer. The views and the sharded tensors are left for their first
+// use.
+void UploadTensorsData(const std::vector<at::Tensor>& tensors) {
+  std::vector<XLATensorPtr> xla_tensors;
+  std::vector<at::Tensor> tensors_data;
+  std::vector<std::string> devices;
+  std::unordered_set<int64_t> tensor_ids;
+  for (const at::Tensor& tensor : tensors) {
+    absl::StatusOr<XLATensorPtr> xla_tensor = bridge::GetXlaTensor(tensor);
+    if (!xla_tensor.ok() || (*xla_tensor)->data()->view != nullptr ||
+        (*xla_tensor)->sharding_spec() != nullptr ||
+        (*xla_tensor)->data()->handle != nullptr ||
+        (*xla_tensor)->CurrentIrValue() ||
+        !tensor_ids.insert((*xla_tensor)->GetUniqueId()).second) {
+      continue;
+    }
+    std::optional<at::Tensor> tensor_data = (*xla_tensor)->CurrentTensorData();
+    if (!tensor_data) {
+      continue;
+    }
+    tensors_data.push_back(*tensor_data);
+    devices.push_back((*xla_tensor)->GetDevice().toString());
+    xla_tensors.push_back(*std::move(xla_tensor));
+  }
+  std::vector<torch::lazy::BackendDataPtr> handles =
+      CreateTensorsData(tensors_data, devices);
+  for (size_t i = 0; i < xla_tensors.size(); ++i) {
+    xla_tensors[i]->SetXlaData(std::move(handles[i]));
+  }
+}
+
+// Runs `op` on the CPU, as at::native::cpu_fallback() does, erroring on
+// views. Rather than fetching every tensor list argument on its own, and
+// uploading every result on its own, all the XLA tensors of the arguments
+// are fetched with a single sync and transfer, and all the results, mutated
+// arguments included, uploaded with a single transfer.
+void CpuFallback(const c10::OperatorHandle& op, torch::jit::Stack* stack) {
+  std::vector<TensorArgument> tensor_arguments =
+      GetTensorArguments(op, *stack);
+  std::optional<c10::Device> target_device =
+      SetDeviceArguments(op, c10::Device(at::kCPU), stack);
+
+  std::vector<at::Tensor> defined_tensors;
+  for (const TensorArgument& argument : tensor_arguments) {
+    for (const at::Tensor& tensor : argument.tensors) {
+      if (tensor.defined()) {
+        defined_tensors.push_back(tensor);
+      }
+      if (!target_device && bridge::IsXlaTensor(tensor)) {
+        target_device = tensor.device();
+      }
+    }
+  }
+  std::vector<at::Tensor> cpu_tensors;
+  if (!defined_tensors.empty()) {
+    cpu_tensors = at::_to_cpu(defined_tensors);
+  }
+  size_t next_cpu_tensor = 0;
+  for (TensorArgument& argument : tensor_arguments) {
+    for (const at::Tensor& tensor : argument.tensors) {
+      argument.backend_tensors.push_back(
+          tensor.defined() ? cpu_tensors[next_cpu_tensor++] : at::Tensor());
+    }
+  }
+  SetBackendArguments(op, tensor_arguments, stack);
+
+  op.redispatchBoxed(c10::DispatchKeySet(c10::DispatchKey::CPU), stack);
+
+  // The mutated arguments are updated with their CPU values.
+  const std::vector<c10::Argument>& schema_args = op.schema().arguments();
+  std::vector<at::Tensor> uploads;
+  for (const TensorArgument& argument : tensor_arguments) {
+    const c10::AliasInfo* alias_info =
+        schema_args[argument.index].alias_info();
+    if (alias_info == nullptr || !alias_info->isWrite()) {
+      continue;
+    }
+    for (size_t j = 0; j < argument.tensors.size(); ++j) {
+      if (bridge::IsXlaTensor(argument.tensors[j]) &&
+          argument.backend_tensors[j].defined()) {
+        at::_copy_from_and_resize(argument.backend_tensors[j],
+                                  argument.tensors[j]);
+        uploads.push_back(argument.tensors[j]);
+      }
+    }
+  }
+
+  // The other results are moved to the target device.
+  SetResults(
+      op, tensor_arguments,
+      [&](const at::Tensor& tensor) {
+        if (!target_device) {
+          return tensor;
+        }
+        at::Tensor xla_tensor = bridge::CreateXlaTensor(
+            tensor, bridge::AtenDeviceToXlaDevice(*target_device));
+        uploads.push_back(xla_tensor);
+        return xla_tensor;
+      },
+      stack);
+  UploadTensorsData(uploads);
+}
+
+bool UseCudaFallbackEnv() {
+  static const bool use_cuda_fallback = [] {
+    if (!runtime::sys_util::GetEnvBool("XLA_FALLBACK_CUDA", false)) {
+      return false;
+    }
+    XLA_ASSIGN_OR_THROW(
+        runtime::ComputationClient * absl_nonnull const client,
+        runtime::GetComputationClient());
+    return client->GetPlatformID() == xla::CudaId() && at::hasCUDA();
+  }();
+  return use_cuda_fallback;
+}
+
+// Whether `op` runs on the CUDA backend, with the buffers of its XLA tensors:
+// the XLA devices must be CUDA ones, the CUDA backend must implement `op`,
+// and the arguments must hold unsharded XLA tensors, and no other tensors
+// than the CPU scalars.
+bool UseCudaFallback(const c10::OperatorHandle& op,
+                     const torch::jit::Stack& stack) {
+  if (!UseCudaFallbackEnv() ||
+      !op.hasKernelForDispatchKey(c10::DispatchKey::CUDA)) {
+    return false;
+  }
+  bool has_xla_tensor = false;
+  for (const TensorArgument& argument : GetTensorArguments(op, stack)) {
+    for (const at::Tensor& tensor : argument.tensors) {
+      if (!tensor.defined()) {
+        continue;
+      }
+      absl::StatusOr<XLATensorPtr> xla_tensor = bridge::GetXlaTensor(tensor);
+      if (xla_tensor.ok()) {
+        if ((*xla_tensor)->sharding_spec() != nullptr) {
+          return false;
+        }
+        has_xla_tensor = true;
+      } else if (!tensor.is_cpu() || tensor.dim() != 0) {
+        return false;
+      }
+    }
+  }
+  return has_xla_tensor;
+}
+
+// Wraps the buffer of a CUDA tensor as the data of an XLA tensor.
+at::Tensor CudaToXla(const at::Tensor& tensor) {
+  return fromDLPack(at::toDLPack(tensor.contiguous()));
+}
+
+// Runs `op` on the CUDA backend, with CUDA tensors sharing the buffers of the
+// XLA arguments, and wraps the buffers of the CUDA results as XLA data. The
+// pending graphs of the arguments are executed with a single sync, and no data
+// goes through the host. As the XLA buffers are immutable, the mutated
+// arguments are copied on the device first, and take the buffer of the copy.
+void CudaFallback(const c10::OperatorHandle& op, torch::jit::Stack* stack) {
+  TORCH_LAZY_COUNTER("CudaFallback", 1);
+  std::vector<TensorArgument> tensor_arguments =
+      GetTensorArguments(op, *stack);
+  std::vector<XLATensorPtr> xla_tensors;
+  for (const TensorArgument& argument : tensor_arguments) {
+    for (const at::Tensor& tensor : argument.tensors) {
+      if (tensor.defined() && bridge::IsXlaTensor(tensor)) {
+        XLA_ASSIGN_OR_THROW(XLATensorPtr xla_tensor,
+                            bridge::GetXlaTensor(tensor));
+        xla_tensors.push_back(std::move(xla_tensor));
+      }
+    }
+  }
+  {
+    FallbackPhaseTimer sync_timer(FallbackPhase::kSync);
+    XLAGraphExecutor::Get()->SyncTensorsGraph(&xla_tensors, {}, /*wait=*/true,
+                                              /*sync_ltc_data=*/false);
+  }
+
+  const std::vector<c10::Argument>& schema_args = op.schema().arguments();
+  std::optional<c10::Device> cuda_device;
+  std::vector<std::pair<XLATensorPtr, at::Tensor>> mutations;
+  for (TensorArgument& argument : tensor_arguments) {
+    const c10::AliasInfo* alias_info =
+        schema_args[argument.index].alias_info();
+    bool is_write = alias_info != nullptr && alias_info->isWrite();
+    for (const at::Tensor& tensor : argument.tensors) {
+      if (!tensor.defined() || !bridge::IsXlaTensor(tensor)) {
+        argument.backend_tensors.push_back(tensor);
+        continue;
+      }
+      XLA_ASSIGN_OR_THROW(XLATensorPtr xla_tensor,
+                          bridge::GetXlaTensor(tensor));
+      // Uploads the tensors which only hold CPU data.
+      xla_tensor->GetXlaData();
+      at::Tensor cuda_tensor = at::fromDLPack(toDLPack(tensor));
+      if (is_write) {
+        cuda_tensor = cuda_tensor.clone();
+        mutations.emplace_back(std::move(xla_tensor), cuda_tensor);
+      }
+      if (!cuda_device) {
+        cuda_device = cuda_tensor.device();
+      }
+      argument.backend_tensors.push_back(std::move(cuda_tensor));
+    }
+  }
+  SetBackendArguments(op, tensor_arguments, stack);
+  SetDeviceArguments(op, *cuda_device, stack);
+
+  op.redispatchBoxed(c10::DispatchKeySet(c10::DispatchKey::CUDA), stack);
+
+  // The XLA computations reading the results run on streams of their own.
+  c10::impl::VirtualGuardImpl guard(c10::DeviceType::CUDA);
+  guard.getStream(*cuda_device).synchronize();
+
+  for (auto& [xla_tensor, cuda_tensor] : mutations) {
+    XLA_ASSIGN_OR_THROW(XLATensorPtr result,
+                        bridge::GetXlaTensor(CudaToXla(cuda_tensor)));
+    xla_tensor->SetXlaData(result->GetXlaData());
+  }
+  SetResults(
+      op, tensor_arguments,
+      [](const at::Tensor& tensor) {
+        return tensor.is_cuda() ? CudaToXla(tensor) : tensor;
+      },
+      stack);
+}
+
+}  // namespace
+
+FallbackPhaseTimer::FallbackPhaseTimer(FallbackPhase phase) : phase_(phase) {
+  if (current_fallback_cost != nullptr) {
+    start_ns_ = runtime::sys_util::NowNs();
+  }
+}
+
+FallbackPhaseTimer::~FallbackPhaseTimer() {
+  if (current_fallback_cost == nullptr || start_ns_ == 0) {
+    return;
+  }
+  size_t index = static_cast<size_t>(phase_);
+  current_fallback_cost->time_ns[index] +=
+      runtime::sys_util::NowNs() - start_ns_;
+  current_fallback_cost->bytes[index] += bytes_;
+  current_fallback_cost->happened[index] = true;
+}
+
 // Get all the executed fallback operations.
 // In other words, get all of them whose counters are not zero.
 std::vector<std::string> GetFallbackOperations() {
   std::vector<std::string> fallback;
+  std::lock_guard<std::mutex> lock(fallback_mutex);
   for (auto const& pair : _fallback_counters) {
     if (pair.second->Value() != 0) {
       fallback.push_back(pair.first);
@@ -43,10 +495,17 @@ void xla_fallback(const c10::OperatorHandle& op, torch::jit::Stack* stack) {
   // because this boxed fallback kernel is used by multiple operators,
   // and the macro stamps out a static Counter object with a fixed name
   // at the code location that it was called.
-  if (_fallback_counters.find(name) == _fallback_counters.end()) {
-    _fallback_counters[name] = new ::torch_xla::runtime::metrics::Counter(name);
+  FallbackMetrics* metrics;
+  {
+    std::lock_guard<std::mutex> lock(fallback_mutex);
+    if (_fallback_counters.find(name) == _fallback_counters.end()) {
+      _fallback_counters[name] =
+          new ::torch_xla::runtime::metrics::Counter(name);
+      fallback_metrics[name] = new FallbackMetrics(name);
+    }
+    _fallback_counters[name]->AddValue(1);
+    metrics = fallback_metrics[name];
   }
-  _fallback_counters[name]->AddValue(1);
 
   auto& args = op.schema().arguments();
   auto arguments = torch::jit::last(stack, args.size());
@@ -59,10 +518,63 @@ void xla_fallback(const c10::OperatorHandle& op, torch::jit::Stack* stack) {
     }
   }
 
-  // Call the actual boxed CPU fallback.
-  // Set error_on_views as XLA should take care
-  // of all view ops after functionalization.
-  at::native::cpu_fallback(op, stack, true);
+  // Call the actual boxed CPU fallback, or the CUDA one, with
+  // $XLA_FALLBACK_CUDA on CUDA devices. They error on views, as XLA should
+  // take care of all view ops after functionalization.
+  //
+  // The syncs and transfers it triggers account their costs to it. Nested
+  // fallbacks, if any, are accounted to the outermost one.
+  FallbackCost cost;
+  bool outermost = current_fallback_cost == nullptr;
+  if (outermost) {
+    current_fallback_cost = &cost;
+  }
+  bool on_cuda = UseCudaFallback(op, *stack);
+  int64_t start_ns = runtime::sys_util::NowNs();
+  try {
+    if (on_cuda) {
+      CudaFallback(op, stack);
+    } else {
+      CpuFallback(op, stack);
+    }
+  } catch (...) {
+    if (outermost) {
+      current_fallback_cost = nullptr;
+    }
+    throw;
+  }
+  if (!outermost) {
+    return;
+  }
+  current_fallback_cost = nullptr;
+  int64_t cpu_time_ns = runtime::sys_util::NowNs() - start_ns;
+  // The upload of the results does not count its bytes, and the sharded ones
+  // are only uploaded on their first use, so their bytes are accounted here
+  // rather than by the transfers. The results of the CUDA fallback are not
+  // transferred at all.
+  size_t transfer_to_device =
+      static_cast<size_t>(FallbackPhase::kTransferToDevice);
+  for (const c10::IValue& ivalue : torch::jit::last(
+           stack, on_cuda ? 0 : op.schema().returns().size())) {
+    if (ivalue.isTensor() && ivalue.toTensor().defined()) {
+      cost.bytes[transfer_to_device] += ivalue.toTensor().nbytes();
+    } else if (ivalue.isTensorList()) {
+      for (const at::Tensor& tensor : ivalue.toTensorVector()) {
+        cost.bytes[transfer_to_device] += tensor.nbytes();
+      }
+    }
+  }
+  for (size_t i = 0; i < kNumFallbackPhases; ++i) {
+    if (cost.happened[i]) {
+      cpu_time_ns -= cost.time_ns[i];
+      metrics->time[i]->AddSample(cost.time_ns[i]);
+    }
+    if (metrics->bytes[i] != nullptr &&
+        (cost.happened[i] || cost.bytes[i] > 0)) {
+      metrics->bytes[i]->AddSample(cost.bytes[i]);
+    }
+  }
+  metrics->cpu_time->AddSample(std::max<int64_t>(cpu_time_ns, 0));
 }
 
 TORCH_LIBRARY_IMPL(_, XLA, m) {
@@ -3,12 +3,48 @@
 
 #include <ATen/core/stack.h>
 
+#include <cstdint>
+
 namespace torch_xla {
 
 void xla_fallback(const c10::OperatorHandle& op, torch::jit::Stack* stack);
 
 std::vector<std::string> GetFallbackOperations();
 
+// The phases of a CPU fallback, besides the CPU kernel itself, which are
+// accounted per operator as the `<op>/<phase>Time` metrics, and for the
+// transfers as the `<op>/<phase>Bytes` metrics. The CPU kernel time is the
+// rest of the fallback time, as `<op>/CpuTime`. The arguments of a fallback
+// are fetched with a single transfer, and its results uploaded with another.
+// With $XLA_FALLBACK_CUDA, the ops run on the CUDA backend instead, with the
+// XLA buffers, and only sync; `<op>/CpuTime` is then their CUDA time.
+enum class FallbackPhase {
+  // Execution of the pending graph of the XLA arguments.
+  kSync,
+  kTransferFromDevice,
+  kTransferToDevice,
+};
+
+// Accounts the time of `phase` for the lifetime of the object to the CPU
+// fallback running on the calling thread, if any.
+class FallbackPhaseTimer {
+ public:
+  explicit FallbackPhaseTimer(FallbackPhase phase);
+
+  ~FallbackPhaseTimer();
+
+  // Accounts `bytes` transferred in this phase.
+  void AddBytes(int64_t bytes) { bytes_ += bytes; }
+
+  // Accounts nothing, for a phase which turned out to be a no-op.
+  void Discard() { start_ns_ = 0; }
+
+ private:
+  FallbackPhase phase_;
+  int64_t start_ns_ = 0;
+  int64_t bytes_ = 0;
+};
+
 }  // namespace torch_xla
 
 #endif  // XLA_TORCH_XLA_CSRC_ATEN_FALLBACK_H_
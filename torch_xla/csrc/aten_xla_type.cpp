@@ -1,7 +1,10 @@
+#include <cmath>
 #include <iterator>
+#include <limits>
 #include <mutex>
 #include <optional>
 
+#include <ATen/Dispatch.h>
 #include <ATen/ExpandUtils.h>
 #include <ATen/FunctionalTensorWrapper.h>
 #include <ATen/MetaFunctions.h>
@@ -30,6 +33,7 @@
 #include "torch_xla/csrc/debug_util.h"
 #include "torch_xla/csrc/device.h"
 #include "torch_xla/csrc/dtype.h"
+#include "torch_xla/csrc/einsum_path.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/ops/as_strided.h"
 #include "torch_xla/csrc/ops/as_strided_view_update.h"
@@ -41,6 +45,7 @@
 #include "torch_xla/csrc/ops/update_slice.h"
 #include "torch_xla/csrc/ops/view.h"
 #include "torch_xla/csrc/pooling.h"
+#include "torch_xla/csrc/resize_ops.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/metrics.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
@@ -50,9 +55,18 @@
 #include "torch_xla/csrc/tensor_methods.h"
 #include "torch_xla/csrc/tensor_util.h"
 #include "torch_xla/csrc/torch_util.h"
+#include "torch_xla/csrc/trace_profiler.h"
 #include "torch_xla/csrc/xla_graph_executor.h"
 #include "torch_xla/csrc/xla_sharding_util.h"
 
+// Every entry point below starts with this macro, which additionally times it
+// for the trace profiler.
+#undef TORCH_LAZY_FN_COUNTER_TIMED_TRACING
+#define TORCH_LAZY_FN_COUNTER_TIMED_TRACING(ns) \
+  TORCH_LAZY_FN_COUNTER(ns);                   \
+  TORCH_LAZY_TIMED("LazyTracing");             \
+  XLA_TRACE_PROFILER_ATEN_OP()
+
 // [Implementation Guidelines]
 // - If you want to call a at::func which doesn't have a kernel registered
 // according to xla_native_functions.yaml,
@@ -439,6 +453,95 @@ void DoBinaryOpOut(const at::Tensor& self, const at::Tensor& other,
   bin_op_out(operands.first, operands.second, xla_out);
 }
 
+constexpr int64_t kEmbeddingBagMax = 2;
+
+// Lowers an embedding_bag of the sum, mean or max mode to an EmbeddingBag.
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> EmbeddingBag(
+    const at::Tensor& weight, const at::Tensor& indices,
+    const at::Tensor& offsets, int64_t mode,
+    const std::optional<at::Tensor>& per_sample_weights,
+    bool include_last_offset) {
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_indices, bridge::GetXlaTensor(indices));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_weight, bridge::GetXlaTensor(weight));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_offsets, bridge::GetXlaTensor(offsets));
+
+  XLATensorPtr sample_weights;
+  if (per_sample_weights.has_value() && per_sample_weights.value().defined()) {
+    XLA_ASSIGN_OR_THROW(sample_weights,
+                        bridge::GetXlaTensor(per_sample_weights.value()));
+  } else {
+    sample_weights = tensor_methods::full_like(
+        xla_indices, 1.0, *torch_xla::bridge::GetXlaDevice(weight),
+        at::ScalarType::Float);
+  }
+
+  auto result =
+      tensor_methods::embedding_bag(xla_weight, xla_indices, xla_offsets, mode,
+                                    sample_weights, include_last_offset);
+  return std::make_tuple(bridge::AtenFromXlaTensor(std::get<0>(result)),
+                         bridge::AtenFromXlaTensor(std::get<1>(result)),
+                         bridge::AtenFromXlaTensor(std::get<2>(result)),
+                         bridge::AtenFromXlaTensor(std::get<3>(result)));
+}
+
+// Checks that `normalized_shape` is the shape of the last dimensions of
+// `input`.
+void CheckNormalizedShape(const at::Tensor& input,
+                          at::IntArrayRef normalized_shape) {
+  int64_t normalized_ndim = normalized_shape.size();
+  XLA_CHECK_GE(normalized_ndim, 1)
+      << "Expected normalized_shape to be at least 1-dimensional";
+  XLA_CHECK_GE(input.dim(), normalized_ndim)
+      << "Input of shape " << input.sizes()
+      << " has fewer dimensions than normalized_shape " << normalized_shape;
+  XLA_CHECK(input.sizes().slice(input.dim() - normalized_ndim) ==
+            normalized_shape)
+      << "Input of shape " << input.sizes()
+      << " does not end with normalized_shape " << normalized_shape;
+}
+
+// Whether scaled_dot_product_attention() lowers to the blocked attention, per
+// $XLA_BLOCKED_ATTENTION. It does by default on the devices other than TPU,
+// which have the Pallas flash attention kernels instead.
+bool UseBlockedAttention(XlaDeviceType hw_type) {
+  return runtime::sys_util::GetEnvBool("XLA_BLOCKED_ATTENTION",
+                                       !CheckTpuDevice(hw_type));
+}
+
+int64_t GetBlockedAttentionBlockSize() {
+  static const int64_t block_size =
+      runtime::sys_util::GetEnvInt("XLA_BLOCKED_ATTENTION_BLOCK_SIZE", 512);
+  return block_size;
+}
+
+// Whether the blocked attention computes the attention of `query`, `key` and
+// `value` with these options. The masks, the dropout and the grouped query
+// attention are left to the composite implementation, and so are the short
+// sequences, whose scores fit in a single block.
+bool CanUseBlockedAttention(const at::Tensor& query, const at::Tensor& key,
+                            const at::Tensor& value,
+                            const std::optional<at::Tensor>& attn_mask,
+                            double dropout_p, bool enable_gqa) {
+  if (attn_mask.has_value() || dropout_p > 0.0 || enable_gqa ||
+      query.dim() < 3 || key.dim() != query.dim() ||
+      value.dim() != query.dim() || !at::isFloatingType(query.scalar_type()) ||
+      key.scalar_type() != query.scalar_type() ||
+      value.scalar_type() != query.scalar_type() ||
+      key.size(-1) != query.size(-1) || value.size(-2) != key.size(-2) ||
+      key.size(-2) <= GetBlockedAttentionBlockSize()) {
+    return false;
+  }
+  for (int64_t dim = 0; dim < query.dim() - 2; ++dim) {
+    if (key.size(dim) != query.size(dim) ||
+        value.size(dim) != query.size(dim)) {
+      return false;
+    }
+  }
+  XlaDeviceType hw_type =
+      static_cast<XlaDeviceType>(bridge::GetCurrentDevice().type());
+  return UseBlockedAttention(hw_type);
+}
+
 }  // namespace
 
 at::Tensor& XLANativeFunctions::__ilshift__(at::Tensor& self,
@@ -1654,6 +1757,38 @@ at::Tensor XLANativeFunctions::einsum(std::string_view equation,
       [](const auto& xla_tensor) { return static_cast<bool>(xla_tensor); });
 
   TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
+  // Einsums of more operands are contracted a pair at a time, in the order
+  // which keeps the intermediates small, unless the caller gave the path.
+  if (tensors.size() > 2 && !path.has_value() && all_xla_tensors_are_valid &&
+      !TensorsAreOfType(xla_tensors, at::ScalarType::Long)) {
+    std::vector<std::vector<int64_t>> shapes;
+    for (const at::Tensor& tensor : tensors) {
+      std::optional<c10::IntArrayRef> sizes =
+          c10::asIntArrayRefSlowOpt(tensor.sym_sizes());
+      if (!sizes) {
+        break;
+      }
+      shapes.push_back(sizes->vec());
+    }
+    std::optional<EinsumPath> contraction_path =
+        shapes.size() == tensors.size()
+            ? GetEinsumPath(cleansed_equation, shapes)
+            : std::nullopt;
+    if (contraction_path) {
+      TORCH_LAZY_COUNTER("EinsumPathContractions", contraction_path->size());
+      std::vector<at::Tensor> operands(tensors.begin(), tensors.end());
+      for (const EinsumContraction& contraction : *contraction_path) {
+        at::Tensor result = XLANativeFunctions::einsum(
+            contraction.equation,
+            {operands[contraction.lhs], operands[contraction.rhs]},
+            /*path=*/std::nullopt);
+        operands.erase(operands.begin() + contraction.rhs);
+        operands.erase(operands.begin() + contraction.lhs);
+        operands.push_back(std::move(result));
+      }
+      return operands.front();
+    }
+  }
   // Einsum operations with more than 2 operands, like bilinear operations, are
   // not currently supported in XLA
   if (tensors.size() < 1 || tensors.size() > 2 || !all_xla_tensors_are_valid ||
@@ -1696,6 +1831,24 @@ at::Tensor XLANativeFunctions::embedding_dense_backward(
       scale_grad_by_freq));
 }
 
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+XLANativeFunctions::_embedding_bag(
+    const at::Tensor& weight, const at::Tensor& indices,
+    const at::Tensor& offsets, bool scale_grad_by_freq, int64_t mode,
+    bool sparse, const std::optional<at::Tensor>& per_sample_weights,
+    bool include_last_offset, int64_t padding_idx) {
+  TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
+  // The max mode does not compute the max_indices its backward needs.
+  if (mode == kEmbeddingBagMax || scale_grad_by_freq || padding_idx != -1) {
+    return at::native::call_fallback_fn<&xla_fallback,
+                                        ATEN_OP(_embedding_bag)>::
+        call(weight, indices, offsets, scale_grad_by_freq, mode, sparse,
+             per_sample_weights, include_last_offset, padding_idx);
+  }
+  return EmbeddingBag(weight, indices, offsets, mode, per_sample_weights,
+                      include_last_offset);
+}
+
 std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
 XLANativeFunctions::_embedding_bag_forward_only(
     const at::Tensor& weight, const at::Tensor& indices,
@@ -1703,7 +1856,7 @@ XLANativeFunctions::_embedding_bag_forward_only(
     bool sparse, const std::optional<at::Tensor>& per_sample_weights,
     bool include_last_offset, int64_t padding_idx) {
   TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
-  if (mode == 1 || scale_grad_by_freq || sparse || padding_idx != -1) {
+  if (scale_grad_by_freq || padding_idx != -1) {
     return at::native::call_fallback_fn<
         &xla_fallback,
         ATEN_OP(_embedding_bag_forward_only)>::call(weight, indices, offsets,
@@ -1712,27 +1865,8 @@ XLANativeFunctions::_embedding_bag_forward_only(
                                                     include_last_offset,
                                                     padding_idx);
   }
-  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_indices, bridge::GetXlaTensor(indices));
-  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_weight, bridge::GetXlaTensor(weight));
-  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_offsets, bridge::GetXlaTensor(offsets));
-
-  XLATensorPtr sample_weights;
-  if (per_sample_weights.has_value() && per_sample_weights.value().defined()) {
-    XLA_ASSIGN_OR_THROW(sample_weights,
-                        bridge::GetXlaTensor(per_sample_weights.value()));
-  } else {
-    sample_weights = tensor_methods::full_like(
-        xla_indices, 1.0, *torch_xla::bridge::GetXlaDevice(weight),
-        at::ScalarType::Float);
-  }
-
-  auto result =
-      tensor_methods::embedding_bag(xla_weight, xla_indices, xla_offsets, mode,
-                                    sample_weights, include_last_offset);
-  return std::make_tuple(bridge::AtenFromXlaTensor(std::get<0>(result)),
-                         bridge::AtenFromXlaTensor(std::get<1>(result)),
-                         bridge::AtenFromXlaTensor(std::get<2>(result)),
-                         bridge::AtenFromXlaTensor(std::get<3>(result)));
+  return EmbeddingBag(weight, indices, offsets, mode, per_sample_weights,
+                      include_last_offset);
 }
 
 at::Tensor XLANativeFunctions::_embedding_bag_backward(
@@ -1746,7 +1880,23 @@ at::Tensor XLANativeFunctions::_embedding_bag_backward(
   if (sparse) {
     TORCH_WARN(
         "XLA does not support EmbeddingBag sparse backward function. "
-        "Falling back to the dense function.");
+        "Falling back to the dense function. See "
+        "torch_xla.experimental.sparse_embedding_bag for a compact "
+        "gradient.");
+  }
+  if (mode != kEmbeddingBagMax && !scale_grad_by_freq && padding_idx == -1) {
+    XLA_ASSIGN_OR_THROW(XLATensorPtr xla_grad, bridge::GetXlaTensor(grad));
+    XLA_ASSIGN_OR_THROW(XLATensorPtr xla_indices,
+                        bridge::GetXlaTensor(indices_));
+    XLA_ASSIGN_OR_THROW(XLATensorPtr xla_offset2bag,
+                        bridge::GetXlaTensor(offset2bag));
+    XLA_ASSIGN_OR_THROW(XLATensorPtr xla_bag_size,
+                        bridge::GetXlaTensor(bag_size_));
+    const torch::lazy::BackendDevice& device = xla_grad->GetDevice();
+    return bridge::AtenFromXlaTensor(tensor_methods::embedding_bag_backward(
+        xla_grad, xla_indices, xla_offset2bag, xla_bag_size,
+        bridge::GetOrCreateXlaTensor(per_sample_weights_opt, device),
+        num_weights, mode));
   }
   if (runtime::sys_util::GetEnvBool("XLA_DISABLE_FUNCTIONALIZATION", false)) {
     return at::native::_embedding_bag_backward_symint(
@@ -3350,6 +3500,33 @@ const at::Tensor& XLANativeFunctions::resize_(
   return self;
 }
 
+at::Tensor XLANativeFunctions::rms_norm(const at::Tensor& input,
+                                        at::IntArrayRef normalized_shape,
+                                        const std::optional<at::Tensor>& weight,
+                                        std::optional<double> eps) {
+  TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
+  CheckNormalizedShape(input, normalized_shape);
+  XLA_CHECK(at::isFloatingType(input.scalar_type()))
+      << "rms_norm only supports floating point inputs, got "
+      << input.scalar_type();
+  // Like the composite implementation, the epsilon defaults to the one of the
+  // input type.
+  double eps_value = 0.0;
+  if (eps.has_value()) {
+    eps_value = *eps;
+  } else {
+    AT_DISPATCH_FLOATING_TYPES_AND2(
+        at::ScalarType::Half, at::ScalarType::BFloat16, input.scalar_type(),
+        "rms_norm", [&] {
+          eps_value = static_cast<double>(
+              std::numeric_limits<scalar_t>::epsilon());
+        });
+  }
+  return aten_autograd_ops::RmsNormAutogradFunction::apply(
+      input, weight.value_or(at::Tensor()), normalized_shape.size(),
+      eps_value);
+}
+
 at::Tensor XLANativeFunctions::roll(const at::Tensor& self,
                                     at::IntArrayRef shifts,
                                     at::IntArrayRef dims) {
@@ -3462,6 +3639,24 @@ at::Tensor scatter_reduce_helper(const at::Tensor& self, int64_t dim,
   }
 }
 
+at::Tensor XLANativeFunctions::scaled_dot_product_attention(
+    const at::Tensor& query, const at::Tensor& key, const at::Tensor& value,
+    const std::optional<at::Tensor>& attn_mask, double dropout_p,
+    bool is_causal, std::optional<double> scale, bool enable_gqa) {
+  TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
+  if (!CanUseBlockedAttention(query, key, value, attn_mask, dropout_p,
+                              enable_gqa)) {
+    return at::native::scaled_dot_product_attention(
+        query, key, value, attn_mask, dropout_p, is_causal, scale, enable_gqa);
+  }
+  double softmax_scale =
+      scale.has_value() ? *scale
+                        : 1.0 / std::sqrt(static_cast<double>(query.size(-1)));
+  return aten_autograd_ops::BlockedAttentionAutogradFunction::apply(
+      query, key, value, softmax_scale, is_causal,
+      GetBlockedAttentionBlockSize());
+}
+
 at::Tensor XLANativeFunctions::scatter(const at::Tensor& self, int64_t dim,
                                        const at::Tensor& index,
                                        const at::Tensor& src) {
@@ -3901,6 +4096,15 @@ std::tuple<at::Tensor, at::Tensor> XLANativeFunctions::topk(
     const at::Tensor& self, int64_t k, int64_t dim, bool largest, bool sorted) {
   TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
   XLA_ASSIGN_OR_THROW(XLATensorPtr xla_self, bridge::GetXlaTensor(self));
+  std::optional<double> recall_target =
+      XLAGraphExecutor::Get()->TopKRecallTarget();
+  if (recall_target) {
+    // The approximate top-k is always sorted.
+    auto results = tensor_methods::approx_topk(xla_self, k, dim, largest,
+                                               *recall_target);
+    return std::make_tuple(bridge::AtenFromXlaTensor(std::get<0>(results)),
+                           bridge::AtenFromXlaTensor(std::get<1>(results)));
+  }
   auto results =
       tensor_methods::topk(xla_self, k, dim, largest, sorted, /*stable=*/false);
   return std::make_tuple(bridge::AtenFromXlaTensor(std::get<0>(results)),
@@ -3995,10 +4199,10 @@ at::Tensor XLANativeFunctions::upsample_bilinear2d_backward(
   XLA_ASSIGN_OR_THROW(XLATensorPtr xla_grad_output,
                       bridge::GetXlaTensor(grad_output));
   // Only the XLA TPU backend for now implements the CustomCall required by
-  // our XLA lowering.
+  // our XLA lowering, which the matmul lowering does without.
   XlaDeviceType hw_type =
       static_cast<XlaDeviceType>(xla_grad_output->GetDevice().type());
-  if (!CheckTpuDevice(hw_type)) {
+  if (!CheckTpuDevice(hw_type) && !resize::UseMatmulResize(hw_type)) {
     return at::native::call_fallback_fn<
         &xla_fallback,
         ATEN_OP(upsample_bilinear2d_backward)>::call(grad_output, output_size,
@@ -4209,16 +4413,49 @@ at::Scalar XLANativeFunctions::_local_scalar_dense(const at::Tensor& self) {
                                       ATEN_OP(_local_scalar_dense)>::call(self);
 }
 
-// re-use the composite kernel from core, that way we don't need to provide a
-// backwards formula for native_layer_norm
 std::tuple<at::Tensor, at::Tensor, at::Tensor>
 XLANativeFunctions::native_layer_norm(const at::Tensor& input,
                                       at::IntArrayRef normalized_shape,
                                       const std::optional<at::Tensor>& weight,
                                       const std::optional<at::Tensor>& bias,
                                       double eps) {
-  return at::native::math_native_layer_norm(input, normalized_shape, weight,
-                                            bias, eps);
+  TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
+  CheckNormalizedShape(input, normalized_shape);
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input, bridge::GetXlaTensor(input));
+  const torch::lazy::BackendDevice& device = xla_input->GetDevice();
+  auto outputs = tensor_methods::native_layer_norm(
+      xla_input, normalized_shape.size(),
+      bridge::GetOrCreateXlaTensor(weight, device),
+      bridge::GetOrCreateXlaTensor(bias, device), eps);
+  return std::make_tuple(bridge::AtenFromXlaTensor(std::get<0>(outputs)),
+                         bridge::AtenFromXlaTensor(std::get<1>(outputs)),
+                         bridge::AtenFromXlaTensor(std::get<2>(outputs)));
+}
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor>
+XLANativeFunctions::native_layer_norm_backward(
+    const at::Tensor& grad_out, const at::Tensor& input,
+    at::IntArrayRef normalized_shape, const at::Tensor& mean,
+    const at::Tensor& rstd, const std::optional<at::Tensor>& weight,
+    const std::optional<at::Tensor>& bias, std::array<bool, 3> output_mask) {
+  TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_grad_out,
+                      bridge::GetXlaTensor(grad_out));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input, bridge::GetXlaTensor(input));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_mean, bridge::GetXlaTensor(mean));
+  XLA_ASSIGN_OR_THROW(XLATensorPtr xla_rstd, bridge::GetXlaTensor(rstd));
+  const torch::lazy::BackendDevice& device = xla_grad_out->GetDevice();
+  auto gradients = tensor_methods::native_layer_norm_backward(
+      xla_grad_out, xla_input, normalized_shape.size(), xla_mean, xla_rstd,
+      bridge::GetOrCreateXlaTensor(weight, device));
+  at::Tensor undefined;
+  return std::make_tuple(
+      output_mask[0] ? bridge::AtenFromXlaTensor(std::get<0>(gradients))
+                     : undefined,
+      output_mask[1] ? bridge::AtenFromXlaTensor(std::get<1>(gradients))
+                     : undefined,
+      output_mask[2] ? bridge::AtenFromXlaTensor(std::get<2>(gradients))
+                     : undefined);
 }
 
 // re-use the composite kernel from core, that way we don't need to provide a
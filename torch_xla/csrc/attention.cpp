@@ -0,0 +1,300 @@
+#include "torch_xla/csrc/attention.h"
+
+#include <algorithm>
+
+#include "absl/types/span.h"
+#include "xla/hlo/builder/lib/constants.h"
+#include "xla/hlo/builder/lib/loops.h"
+#include "xla/shape_util.h"
+#include "xla/util.h"
+
+#include "torch_xla/csrc/helpers.h"
+#include "torch_xla/csrc/shape_helper.h"
+#include "torch_xla/csrc/status.h"
+
+namespace torch_xla {
+namespace {
+
+const xla::PrimitiveType kF32 = xla::PrimitiveType::F32;
+const xla::PrimitiveType kS32 = xla::PrimitiveType::S32;
+
+// The sizes of an attention, with the batch dimensions flattened.
+struct AttentionDims {
+  int64_t batch;
+  int64_t query_len;
+  int64_t key_len;
+  int64_t head_dim;
+  int64_t value_dim;
+  int64_t block_size;
+  int64_t num_blocks;
+};
+
+AttentionDims GetAttentionDims(xla::XlaOp query, xla::XlaOp key,
+                               xla::XlaOp value, int64_t block_size) {
+  const xla::Shape& query_shape = ShapeHelper::ShapeOfXlaOp(query);
+  const xla::Shape& key_shape = ShapeHelper::ShapeOfXlaOp(key);
+  const xla::Shape& value_shape = ShapeHelper::ShapeOfXlaOp(value);
+  int64_t rank = query_shape.dimensions_size();
+  AttentionDims dims;
+  dims.batch = 1;
+  for (int64_t i = 0; i < rank - 2; ++i) {
+    dims.batch *= query_shape.dimensions(i);
+  }
+  dims.query_len = query_shape.dimensions(rank - 2);
+  dims.key_len = key_shape.dimensions(rank - 2);
+  dims.head_dim = query_shape.dimensions(rank - 1);
+  dims.value_dim = value_shape.dimensions(rank - 1);
+  dims.block_size = std::min(block_size, dims.key_len);
+  dims.num_blocks = xla::CeilOfRatio(dims.key_len, dims.block_size);
+  return dims;
+}
+
+// The batched product of "lhs" and "rhs" over their dimensions
+// "lhs_contracting" and "rhs_contracting", accumulated in F32. The batch is
+// their first dimension. "lhs" is converted to the type of "rhs".
+xla::XlaOp BatchDot(xla::XlaOp lhs, xla::XlaOp rhs, int64_t lhs_contracting,
+                    int64_t rhs_contracting) {
+  xla::PrimitiveType type = ShapeHelper::ShapeOfXlaOp(rhs).element_type();
+  xla::DotDimensionNumbers dims;
+  dims.add_lhs_batch_dimensions(0);
+  dims.add_rhs_batch_dimensions(0);
+  dims.add_lhs_contracting_dimensions(lhs_contracting);
+  dims.add_rhs_contracting_dimensions(rhs_contracting);
+  xla::PrecisionConfig precision_config =
+      XlaHelpers::BuildPrecisionConfig(XlaHelpers::mat_mul_precision());
+  return xla::DotGeneral(xla::ConvertElementType(lhs, type), rhs, dims,
+                         &precision_config, kF32);
+}
+
+// A block of the keys and values of the flattened attention.
+struct KeyValueBlock {
+  xla::XlaOp key;
+  xla::XlaOp value;
+  // The offset of the block in the keys.
+  xla::XlaOp offset;
+  // Whether a query attends to a key of the block, of shape [B, Sq, block].
+  // The last block is moved back to end at the last key, and its keys which
+  // belong to the block before are masked, like the keys after the query with
+  // a causal mask.
+  xla::XlaOp mask;
+};
+
+xla::XlaOp Int32(xla::XlaBuilder* builder, int64_t value) {
+  return xla::ConstantR0<int32_t>(builder, static_cast<int32_t>(value));
+}
+
+KeyValueBlock GetKeyValueBlock(xla::XlaOp key, xla::XlaOp value,
+                               xla::XlaOp index, const AttentionDims& dims,
+                               bool is_causal) {
+  xla::XlaBuilder* builder = key.builder();
+  xla::XlaOp zero = xla::Zero(builder, kS32);
+  xla::XlaOp start = index * Int32(builder, dims.block_size);
+  xla::XlaOp offset =
+      xla::Min(start, Int32(builder, dims.key_len - dims.block_size));
+  KeyValueBlock block;
+  block.key = xla::DynamicSlice(key, {zero, offset, zero},
+                                {dims.batch, dims.block_size, dims.head_dim});
+  block.value =
+      xla::DynamicSlice(value, {zero, offset, zero},
+                        {dims.batch, dims.block_size, dims.value_dim});
+  block.offset = offset;
+  xla::Shape scores_shape = xla::ShapeUtil::MakeShape(
+      kS32, {dims.batch, dims.query_len, dims.block_size});
+  xla::XlaOp keys = xla::Iota(builder, scores_shape, 2) + offset;
+  block.mask = xla::Ge(keys, start);
+  if (is_causal) {
+    xla::XlaOp queries = xla::Iota(builder, scores_shape, 1);
+    block.mask = xla::And(block.mask, xla::Le(keys, queries));
+  }
+  return block;
+}
+
+xla::XlaOp BuildScores(xla::XlaOp query, const KeyValueBlock& block,
+                       double scale) {
+  xla::XlaOp scores = BatchDot(query, block.key, 2, 2);
+  return scores *
+         xla::ConstantR0<float>(query.builder(), static_cast<float>(scale));
+}
+
+xla::XlaOp ReduceRows(xla::XlaOp values) {
+  xla::XlaBuilder* builder = values.builder();
+  return xla::Reduce(values, xla::Zero(builder, kF32),
+                     XlaHelpers::CreateAddComputation(kF32), {2});
+}
+
+xla::XlaOp Flatten(xla::XlaOp input, int64_t batch) {
+  const xla::Shape& shape = ShapeHelper::ShapeOfXlaOp(input);
+  int64_t rank = shape.dimensions_size();
+  return xla::Reshape(input, {batch, shape.dimensions(rank - 2),
+                              shape.dimensions(rank - 1)});
+}
+
+xla::XlaOp Unflatten(xla::XlaOp input, const xla::Shape& shape) {
+  return xla::Reshape(xla::ConvertElementType(input, shape.element_type()),
+                      shape.dimensions());
+}
+
+}  // namespace
+
+std::vector<xla::XlaOp> BuildBlockedAttention(xla::XlaOp query, xla::XlaOp key,
+                                              xla::XlaOp value, double scale,
+                                              bool is_causal,
+                                              int64_t block_size) {
+  xla::XlaBuilder* builder = query.builder();
+  const xla::Shape& query_shape = ShapeHelper::ShapeOfXlaOp(query);
+  AttentionDims dims = GetAttentionDims(query, key, value, block_size);
+  std::vector<int64_t> rows_dims = {dims.batch, dims.query_len};
+  std::vector<int64_t> output_dims = {dims.batch, dims.query_len,
+                                      dims.value_dim};
+
+  // The loop carries the index of the block, the running max and sum of the
+  // exponentials of the scores of every query, the output relative to them,
+  // and the query, keys and values.
+  std::vector<xla::XlaOp> init_values = {
+      xla::Zero(builder, kS32),
+      xla::Broadcast(xla::MinFiniteValue(builder, kF32), rows_dims),
+      xla::Broadcast(xla::Zero(builder, kF32), rows_dims),
+      xla::Broadcast(xla::Zero(builder, kF32), output_dims),
+      Flatten(query, dims.batch),
+      Flatten(key, dims.batch),
+      Flatten(value, dims.batch)};
+  XLA_ASSIGN_OR_THROW(
+      std::vector<xla::XlaOp> result,
+      xla::WhileLoopHelper(
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            return xla::Lt(values[0], Int32(builder, dims.num_blocks));
+          },
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            KeyValueBlock block = GetKeyValueBlock(values[5], values[6],
+                                                   values[0], dims, is_causal);
+            xla::XlaOp scores = xla::Select(
+                block.mask, BuildScores(values[4], block, scale),
+                xla::Broadcast(xla::MinValue(builder, kF32),
+                               {dims.batch, dims.query_len, dims.block_size}));
+            xla::XlaOp max = xla::Max(
+                values[1],
+                xla::Reduce(scores, xla::MinValue(builder, kF32),
+                            XlaHelpers::CreateMaxComputation(kF32), {2}));
+            xla::XlaOp probs = xla::Exp(
+                scores -
+                xla::BroadcastInDim(
+                    max, {dims.batch, dims.query_len, dims.block_size},
+                    {0, 1}));
+            xla::XlaOp correction = xla::Exp(values[1] - max);
+            xla::XlaOp sum = values[2] * correction + ReduceRows(probs);
+            xla::XlaOp output =
+                values[3] * xla::BroadcastInDim(correction, output_dims,
+                                                {0, 1}) +
+                BatchDot(probs, block.value, 2, 1);
+            return std::vector<xla::XlaOp>{
+                values[0] + xla::One(builder, kS32),
+                max,
+                sum,
+                output,
+                values[4],
+                values[5],
+                values[6]};
+          },
+          init_values, "BlockedAttentionLoop", builder));
+  xla::XlaOp output =
+      result[3] / xla::BroadcastInDim(result[2], output_dims, {0, 1});
+  xla::XlaOp lse = result[1] + xla::Log(result[2]);
+  std::vector<int64_t> lse_dims(query_shape.dimensions().begin(),
+                                query_shape.dimensions().end() - 1);
+  xla::Shape output_shape = query_shape;
+  output_shape.set_dimensions(output_shape.dimensions_size() - 1,
+                              dims.value_dim);
+  return {Unflatten(output, output_shape), xla::Reshape(lse, lse_dims)};
+}
+
+std::vector<xla::XlaOp> BuildBlockedAttentionBackward(
+    xla::XlaOp grad_output, xla::XlaOp query, xla::XlaOp key, xla::XlaOp value,
+    xla::XlaOp output, xla::XlaOp lse, double scale, bool is_causal,
+    int64_t block_size) {
+  xla::XlaBuilder* builder = query.builder();
+  AttentionDims dims = GetAttentionDims(query, key, value, block_size);
+  std::vector<int64_t> scores_dims = {dims.batch, dims.query_len,
+                                      dims.block_size};
+  xla::XlaOp flat_grad_output = Flatten(grad_output, dims.batch);
+  // The rows of the gradient of the scores are offset by the product of the
+  // output and its gradient, in F32.
+  xla::XlaOp delta = ReduceRows(
+      xla::ConvertElementType(flat_grad_output, kF32) *
+      xla::ConvertElementType(Flatten(output, dims.batch), kF32));
+
+  // The loop carries the index of the block, the F32 gradients of the query,
+  // the keys and the values, and the operands of the backward. The blocks add
+  // to the gradients of their keys and values, which the last block shares
+  // with the block before: its masked probabilities add zero to them.
+  std::vector<xla::XlaOp> init_values = {
+      xla::Zero(builder, kS32),
+      xla::Broadcast(xla::Zero(builder, kF32),
+                     {dims.batch, dims.query_len, dims.head_dim}),
+      xla::Broadcast(xla::Zero(builder, kF32),
+                     {dims.batch, dims.key_len, dims.head_dim}),
+      xla::Broadcast(xla::Zero(builder, kF32),
+                     {dims.batch, dims.key_len, dims.value_dim}),
+      Flatten(query, dims.batch),
+      Flatten(key, dims.batch),
+      Flatten(value, dims.batch),
+      flat_grad_output,
+      xla::Reshape(lse, {dims.batch, dims.query_len}),
+      delta};
+  XLA_ASSIGN_OR_THROW(
+      std::vector<xla::XlaOp> result,
+      xla::WhileLoopHelper(
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            return xla::Lt(values[0], Int32(builder, dims.num_blocks));
+          },
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            KeyValueBlock block = GetKeyValueBlock(values[5], values[6],
+                                                   values[0], dims, is_causal);
+            xla::XlaOp scale_op =
+                xla::ConstantR0<float>(builder, static_cast<float>(scale));
+            xla::XlaOp probs = xla::Select(
+                block.mask,
+                xla::Exp(BuildScores(values[4], block, scale) -
+                         xla::BroadcastInDim(values[8], scores_dims, {0, 1})),
+                xla::Broadcast(xla::Zero(builder, kF32), scores_dims));
+            xla::XlaOp grad_probs = BatchDot(values[7], block.value, 2, 2);
+            xla::XlaOp grad_scores =
+                probs * (grad_probs -
+                         xla::BroadcastInDim(values[9], scores_dims, {0, 1})) *
+                scale_op;
+            xla::XlaOp grad_query =
+                values[1] + BatchDot(grad_scores, block.key, 2, 1);
+
+            xla::XlaOp zero = xla::Zero(builder, kS32);
+            auto add_block = [&](xla::XlaOp grads, xla::XlaOp grad_block,
+                                 int64_t dim) {
+              xla::XlaOp current =
+                  xla::DynamicSlice(grads, {zero, block.offset, zero},
+                                    {dims.batch, dims.block_size, dim});
+              return xla::DynamicUpdateSlice(grads, current + grad_block,
+                                             {zero, block.offset, zero});
+            };
+            xla::XlaOp grad_key =
+                add_block(values[2], BatchDot(grad_scores, values[4], 1, 1),
+                          dims.head_dim);
+            xla::XlaOp grad_value =
+                add_block(values[3], BatchDot(probs, values[7], 1, 1),
+                          dims.value_dim);
+            return std::vector<xla::XlaOp>{
+                values[0] + xla::One(builder, kS32),
+                grad_query,
+                grad_key,
+                grad_value,
+                values[4],
+                values[5],
+                values[6],
+                values[7],
+                values[8],
+                values[9]};
+          },
+          init_values, "BlockedAttentionBackwardLoop", builder));
+  return {Unflatten(result[1], ShapeHelper::ShapeOfXlaOp(query)),
+          Unflatten(result[2], ShapeHelper::ShapeOfXlaOp(key)),
+          Unflatten(result[3], ShapeHelper::ShapeOfXlaOp(value))};
+}
+
+}  // namespace torch_xla
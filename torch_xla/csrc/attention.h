@@ -0,0 +1,33 @@
+#ifndef XLA_TORCH_XLA_CSRC_ATTENTION_H_
+#define XLA_TORCH_XLA_CSRC_ATTENTION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "xla/hlo/builder/xla_builder.h"
+
+namespace torch_xla {
+
+// Builds the scaled dot product attention of "query" [..., Sq, D], "key"
+// [..., Sk, D] and "value" [..., Sk, Dv] without the [Sq, Sk] scores: a loop
+// reads "block_size" keys and values at a time and adds them to an online
+// softmax, in F32. With "is_causal", a query only attends to the keys up to its
+// own position. Returns the output [..., Sq, Dv], in the type of "query", and
+// the F32 log-sum-exps [..., Sq] of the scores the backward reads.
+std::vector<xla::XlaOp> BuildBlockedAttention(xla::XlaOp query, xla::XlaOp key,
+                                              xla::XlaOp value, double scale,
+                                              bool is_causal,
+                                              int64_t block_size);
+
+// Builds the gradients of BuildBlockedAttention() for "query", "key" and
+// "value", from the gradient of the output, the output and the log-sum-exps
+// "lse". The probabilities of a block are recomputed from "lse", so only a
+// block of scores is live at a time.
+std::vector<xla::XlaOp> BuildBlockedAttentionBackward(
+    xla::XlaOp grad_output, xla::XlaOp query, xla::XlaOp key, xla::XlaOp value,
+    xla::XlaOp output, xla::XlaOp lse, double scale, bool is_causal,
+    int64_t block_size);
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_ATTENTION_H_
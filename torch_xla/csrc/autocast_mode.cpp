@@ -1,15 +1,108 @@
+#include "torch_xla/csrc/autocast_mode.h"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <unordered_map>
+
 #include <ATen/ATen.h>
+#include <ATen/CachedTensorUtils.h>
 #include <ATen/NativeFunctions.h>
 #include <ATen/Operators.h>
 #include <ATen/autocast_mode.h>
 #include <c10/core/impl/LocalDispatchKeySet.h>
 #include <c10/util/intrusive_ptr.h>
+#include <torch/csrc/lazy/core/metrics.h>
 #include <torch/library.h>
 
 namespace at {
 namespace autocast {
 namespace {
 
+// The lower precision casts of the fp32 leaf tensors, keyed by their
+// TensorImpl, with the version of the tensor they were cast at. Unlike the
+// cache of at::autocast::cached_cast(), it holds the leaves which do not
+// require grad too, as the weights do under inference, and it never returns a
+// cast of an older version of a tensor updated in place within the region.
+struct XlaCastCache {
+  std::mutex mutex;
+  std::unordered_map<TensorImpl*,
+                     std::tuple<c10::weak_intrusive_ptr<TensorImpl>, uint32_t,
+                                Tensor>>
+      casts;
+};
+
+XlaCastCache* GetXlaCastCache() {
+  static XlaCastCache* cache = new XlaCastCache();
+  return cache;
+}
+
+Tensor XlaCachedCast(at::ScalarType to_type, const Tensor& arg) {
+  constexpr c10::DeviceType device_type = c10::DeviceType::XLA;
+  bool can_try_cache =
+      is_autocast_eligible(arg, device_type) && arg.scalar_type() != to_type &&
+      to_type == get_lower_precision_fp_from_device_type(device_type) &&
+      arg.scalar_type() == at::kFloat && arg.is_leaf() && !arg.is_view() &&
+      is_autocast_cache_enabled() && !at::caching::is_cached_tensor(arg);
+  if (!can_try_cache) {
+    return cached_cast(to_type, arg, device_type);
+  }
+  XlaCastCache* cache = GetXlaCastCache();
+  uint32_t version = arg._version();
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  auto it = cache->casts.find(arg.unsafeGetTensorImpl());
+  if (it != cache->casts.end() && !std::get<0>(it->second).expired() &&
+      std::get<1>(it->second) == version) {
+    TORCH_LAZY_COUNTER("AutocastCastCacheHit", 1);
+    return std::get<2>(it->second);
+  }
+  Tensor casted = arg.to(to_type);
+  cache->casts[arg.unsafeGetTensorImpl()] = std::make_tuple(
+      c10::weak_intrusive_ptr<TensorImpl>(arg.getIntrusivePtr()), version,
+      casted);
+  return casted;
+}
+
+std::optional<Tensor> XlaCachedCast(at::ScalarType to_type,
+                                    const std::optional<Tensor>& arg) {
+  if (!arg.has_value()) {
+    return arg;
+  }
+  return XlaCachedCast(to_type, *arg);
+}
+
+// The other arguments are cast, or passed through, as upstream does.
+template <class T>
+decltype(auto) XlaCachedCast(at::ScalarType to_type, T&& arg) {
+  return cached_cast(to_type, std::forward<T>(arg), c10::DeviceType::XLA);
+}
+
+// The lower_precision_fp policy, casting the weights once per region through
+// the XLA cast cache.
+template <class Redispatch, Redispatch* F, class Ret, class ArgList>
+struct XlaLowerPrecisionFp_ {};
+
+template <class Redispatch, Redispatch* F, class Ret, class... Args>
+struct XlaLowerPrecisionFp_<Redispatch, F, Ret,
+                            c10::guts::typelist::typelist<Args...>> {
+  static Ret call(Args... args) {
+    c10::impl::ExcludeDispatchKeyGuard no_autocast(
+        c10::DispatchKey::AutocastXLA);
+    return (*F)(XlaCachedCast(
+        get_lower_precision_fp_from_device_type(c10::DeviceType::XLA),
+        args)...);
+  }
+};
+
+template <class Redispatch, Redispatch* F>
+struct XlaLowerPrecisionFp {
+  using type = XlaLowerPrecisionFp_<
+      Redispatch, F,
+      typename c10::guts::function_traits<Redispatch>::return_type,
+      typename c10::guts::function_traits<Redispatch>::parameter_types>;
+};
+
 #define KERNEL_XLA(OP, POLICY) KERNEL(c10::DeviceType::XLA, OP, POLICY)
 
 #define KERNEL_XLA2(OP, OVERLOAD, POLICY) \
@@ -22,36 +115,46 @@ namespace {
                                         REGISTER_NAME, REGISTER_SIGNATURE,     \
                                         REDISPATCH_SIGNATURE, POLICY)
 
+#define KERNEL_XLA_LOWER_PRECISION_FP(OP)            \
+  m.impl(TORCH_SELECTIVE_NAME("aten::" #OP),         \
+         &XlaLowerPrecisionFp<decltype(ATEN_FN(OP)), \
+                              &ATEN_FN(OP)>::type::call);
+
+#define KERNEL_XLA2_LOWER_PRECISION_FP(OP, OVERLOAD)           \
+  m.impl(TORCH_SELECTIVE_NAME("aten::" #OP "." #OVERLOAD),     \
+         &XlaLowerPrecisionFp<decltype(ATEN_FN2(OP, OVERLOAD)), \
+                              &ATEN_FN2(OP, OVERLOAD)>::type::call);
+
 TORCH_LIBRARY_IMPL(_, AutocastXLA, m) {
   m.fallback(torch::CppFunction::makeFallthrough());
 }
 
 TORCH_LIBRARY_IMPL(aten, AutocastXLA, m) {
   // lower_precision_fp cast policy
-  KERNEL_XLA(conv1d, lower_precision_fp)
-  KERNEL_XLA2(conv1d, padding, lower_precision_fp)
-  KERNEL_XLA(conv2d, lower_precision_fp)
-  KERNEL_XLA2(conv2d, padding, lower_precision_fp)
-  KERNEL_XLA(conv3d, lower_precision_fp)
-  KERNEL_XLA2(conv3d, padding, lower_precision_fp)
-  KERNEL_XLA(bmm, lower_precision_fp)
-  KERNEL_XLA(mm, lower_precision_fp)
-  KERNEL_XLA(baddbmm, lower_precision_fp)
-  KERNEL_XLA(addmm, lower_precision_fp)
-  KERNEL_XLA(addbmm, lower_precision_fp)
-  KERNEL_XLA(linear, lower_precision_fp)
-  KERNEL_XLA(matmul, lower_precision_fp)
-  KERNEL_XLA(conv_tbc, lower_precision_fp)
-  KERNEL_XLA(conv_transpose1d, lower_precision_fp)
-  KERNEL_XLA2(conv_transpose2d, input, lower_precision_fp)
-  KERNEL_XLA2(conv_transpose3d, input, lower_precision_fp)
-  KERNEL_XLA(prelu, lower_precision_fp)
-  KERNEL_XLA(relu, lower_precision_fp)
-  KERNEL_XLA(max_pool2d, lower_precision_fp)
-  KERNEL_XLA(einsum, lower_precision_fp)
+  KERNEL_XLA_LOWER_PRECISION_FP(conv1d)
+  KERNEL_XLA2_LOWER_PRECISION_FP(conv1d, padding)
+  KERNEL_XLA_LOWER_PRECISION_FP(conv2d)
+  KERNEL_XLA2_LOWER_PRECISION_FP(conv2d, padding)
+  KERNEL_XLA_LOWER_PRECISION_FP(conv3d)
+  KERNEL_XLA2_LOWER_PRECISION_FP(conv3d, padding)
+  KERNEL_XLA_LOWER_PRECISION_FP(bmm)
+  KERNEL_XLA_LOWER_PRECISION_FP(mm)
+  KERNEL_XLA_LOWER_PRECISION_FP(baddbmm)
+  KERNEL_XLA_LOWER_PRECISION_FP(addmm)
+  KERNEL_XLA_LOWER_PRECISION_FP(addbmm)
+  KERNEL_XLA_LOWER_PRECISION_FP(linear)
+  KERNEL_XLA_LOWER_PRECISION_FP(matmul)
+  KERNEL_XLA_LOWER_PRECISION_FP(conv_tbc)
+  KERNEL_XLA_LOWER_PRECISION_FP(conv_transpose1d)
+  KERNEL_XLA2_LOWER_PRECISION_FP(conv_transpose2d, input)
+  KERNEL_XLA2_LOWER_PRECISION_FP(conv_transpose3d, input)
+  KERNEL_XLA_LOWER_PRECISION_FP(prelu)
+  KERNEL_XLA_LOWER_PRECISION_FP(relu)
+  KERNEL_XLA_LOWER_PRECISION_FP(max_pool2d)
+  KERNEL_XLA_LOWER_PRECISION_FP(einsum)
   // Disable `scaled_dot_product_attention` for now since it causes
   // undefined symbol with official torch whl.
-  // KERNEL_XLA(scaled_dot_product_attention, lower_precision_fp)
+  // KERNEL_XLA_LOWER_PRECISION_FP(scaled_dot_product_attention)
 
   // fp32 cast policy
   // Commented out ops are included in the AutoCastCPU Policy,
@@ -166,3 +269,13 @@ TORCH_LIBRARY_IMPL(aten, AutocastXLA, m) {
 }  // namespace
 }  // namespace autocast
 }  // namespace at
+
+namespace torch_xla {
+
+void ClearAutocastCache() {
+  at::autocast::XlaCastCache* cache = at::autocast::GetXlaCastCache();
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  cache->casts.clear();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,14 @@
+#ifndef XLA_TORCH_XLA_CSRC_AUTOCAST_MODE_H_
+#define XLA_TORCH_XLA_CSRC_AUTOCAST_MODE_H_
+
+namespace torch_xla {
+
+// Drops the lower precision casts of the fp32 leaf tensors, the weights, which
+// the XLA autocast regions cache. A cast is reused while its tensor keeps its
+// version, until the cache is cleared, at every step and on leaving the
+// outermost torch_xla.amp.autocast region.
+void ClearAutocastCache();
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_AUTOCAST_MODE_H_
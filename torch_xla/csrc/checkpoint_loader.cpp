@@ -0,0 +1,226 @@
+#include "torch_xla/csrc/checkpoint_loader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+
+#include <ATen/Functions.h>
+#include <c10/util/accumulate.h>
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+#include "tsl/profiler/lib/traceme.h"
+#include "xla/hlo/ir/hlo_sharding.h"
+
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/dtype.h"
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/tensor_source.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor.h"
+#include "torch_xla/csrc/tensor_util.h"
+#include "torch_xla/csrc/xla_sharding_util.h"
+
+namespace torch_xla {
+namespace {
+
+absl::Status ErrnoError(const std::string& what, const std::string& path) {
+  return absl::InternalError(
+      absl::StrCat(what, " ", path, ": ", std::strerror(errno)));
+}
+
+// A file mapped in memory for reading, unmapped on destruction.
+class MappedFile {
+ public:
+  static absl::StatusOr<std::shared_ptr<MappedFile>> Open(
+      const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return ErrnoError("Failed to open", path);
+    }
+    struct stat buffer;
+    if (fstat(fd, &buffer) != 0) {
+      close(fd);
+      return ErrnoError("Failed to stat", path);
+    }
+    size_t size = buffer.st_size;
+    void* mapped = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                            : nullptr;
+    if (mapped == MAP_FAILED) {
+      absl::Status status = ErrnoError("Failed to map", path);
+      close(fd);
+      return status;
+    }
+    // The mapping outlives the file descriptor.
+    close(fd);
+    return std::make_shared<MappedFile>(static_cast<char*>(mapped), size);
+  }
+
+  MappedFile(char* data, size_t size) : data_(data), size_(size) {}
+
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+  }
+
+  char* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+  // Drops the pages holding [offset, offset + size) from the process, so that
+  // they no longer count in its resident memory. The mapping stays valid, and
+  // the pages are read back from the file if accessed again.
+  void DropPages(size_t offset, size_t size) const {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t begin = offset / page_size * page_size;
+    size_t end = std::min(offset + size, size_);
+    if (data_ != nullptr && end > begin) {
+      madvise(data_ + begin, end - begin, MADV_DONTNEED);
+    }
+  }
+
+ private:
+  char* data_;
+  size_t size_;
+};
+
+// Returns the source of the transfer of the CPU `tensor` to `device`. It is
+// read in place when it already has the element type the device stores, and
+// converted into a staging copy otherwise.
+std::shared_ptr<const runtime::TensorSource> CreateMappedSource(
+    const at::Tensor& tensor, const std::string& device) {
+  torch::lazy::BackendDevice backend_device = ParseDeviceString(device);
+  xla::Shape shape = CreateComputationShapeFromTensor(tensor, &backend_device);
+  if (TorchTypeFromXlaType(shape.element_type()) != tensor.scalar_type()) {
+    return CreateTensorSource(tensor, std::move(shape), device);
+  }
+  TORCH_LAZY_COUNTER("MappedTensorSource", 1);
+  return std::make_shared<runtime::StridedViewSource>(tensor, std::move(shape),
+                                                      device);
+}
+
+// Transfers the tiles of `tensor` for the local devices, as ShardTensor() and
+// CreateShardedData() do, but out of views of `tensor` rather than copies.
+runtime::ComputationClient::DataPtr TransferMappedShards(
+    runtime::ComputationClient* client, const at::Tensor& tensor,
+    const XLATensor::ShardingSpecPtr& sharding_spec) {
+  std::vector<std::string> devices = client->GetLocalDevices();
+  std::vector<int64_t> shard_shape = ShardingUtil::GetShardShape(sharding_spec);
+  auto replica_and_indices = ShardingUtil::GetShardReplicaAndIndicesForDevices(
+      shard_shape, tensor.sizes().vec(), sharding_spec->sharding, devices);
+  std::vector<std::shared_ptr<const runtime::TensorSource>> sources;
+  sources.reserve(devices.size());
+  for (size_t i = 0; i < devices.size(); ++i) {
+    at::Tensor shard = tensor.index(replica_and_indices[i].second);
+    if (shard.sizes() != c10::IntArrayRef(shard_shape)) {
+      // The tiles of uneven shardings are zero padded to the right, which
+      // takes a copy of them.
+      TORCH_LAZY_COUNTER("MappedTensorPaddedShards", 1);
+      std::vector<int64_t> pads;
+      for (int64_t j = shard_shape.size() - 1; j >= 0; --j) {
+        pads.push_back(0);
+        pads.push_back(shard_shape[j] - shard.size(j));
+      }
+      shard = at::constant_pad_nd(shard, pads, 0);
+    }
+    sources.push_back(CreateMappedSource(shard, devices[i]));
+  }
+  return client->TransferShardsToDevice(sources, GetVirtualDevice().toString(),
+                                        sharding_spec->shape,
+                                        sharding_spec->sharding);
+}
+
+}  // namespace
+
+absl::StatusOr<std::vector<at::Tensor>> LoadMappedTensors(
+    const std::string& path, absl::Span<const MappedTensorInfo> infos,
+    const torch::lazy::BackendDevice& device, int64_t max_inflight_bytes) {
+  tsl::profiler::TraceMe activity("LoadMappedTensors",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  bool is_spmd =
+      static_cast<XlaDeviceType>(device.type()) == XlaDeviceType::SPMD;
+  XLA_ASSIGN_OR_RETURN(std::shared_ptr<MappedFile> file,
+                       MappedFile::Open(path));
+  // The views keep the mapping alive through their storage, for as long as a
+  // transfer references them.
+  std::vector<at::Tensor> views;
+  views.reserve(infos.size());
+  for (const MappedTensorInfo& info : infos) {
+    int64_t size =
+        c10::multiply_integers(info.sizes) * c10::elementSize(info.dtype);
+    if (info.offset < 0 ||
+        static_cast<size_t>(info.offset + size) > file->size()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Tensor of ", size, " bytes at offset ", info.offset,
+                       " is out of the ", file->size(), " bytes of ", path));
+    }
+    if (info.sharding.has_value() && !is_spmd) {
+      return absl::InvalidArgumentError(
+          "Sharded tensors must be loaded on the SPMD virtual device");
+    }
+    views.push_back(at::from_blob(
+        file->data() + info.offset, info.sizes, [file](void*) {},
+        at::TensorOptions(info.dtype)));
+  }
+
+  XLA_ASSIGN_OR_RETURN(runtime::ComputationClient * absl_nonnull const client,
+                       runtime::GetComputationClient());
+  std::vector<at::Tensor> tensors(infos.size());
+  size_t begin = 0;
+  while (begin < infos.size()) {
+    // Every batch holds at least one tensor, however big.
+    size_t end = begin + 1;
+    int64_t batch_bytes = views[begin].nbytes();
+    while (end < infos.size() &&
+           batch_bytes + views[end].nbytes() <= max_inflight_bytes) {
+      batch_bytes += views[end].nbytes();
+      ++end;
+    }
+
+    std::vector<std::shared_ptr<const runtime::TensorSource>> sources;
+    std::vector<size_t> source_indices;
+    for (size_t i = begin; i < end; ++i) {
+      if (!is_spmd) {
+        sources.push_back(CreateMappedSource(views[i], device.toString()));
+        source_indices.push_back(i);
+        continue;
+      }
+      // The tiles of a tensor go to the devices in parallel, the tensors of
+      // the batch one after the other.
+      auto sharding_spec = std::make_shared<XLATensor::ShardingSpec>(
+          infos[i].sharding.value_or(xla::HloSharding::Replicate().ToProto()),
+          CreateComputationShapeFromTensor(views[i], &device));
+      XLATensorPtr xla_tensor = XLATensor::Create(
+          TransferMappedShards(client, views[i], sharding_spec),
+          infos[i].dtype);
+      xla_tensor->SetShardingSpec(*sharding_spec);
+      tensors[i] = bridge::AtenFromXlaTensor(std::move(xla_tensor));
+    }
+    if (!sources.empty()) {
+      std::vector<runtime::ComputationClient::DataPtr> datas =
+          client->TransferToDevice(sources);
+      for (size_t j = 0; j < datas.size(); ++j) {
+        size_t i = source_indices[j];
+        tensors[i] = bridge::AtenFromXlaTensor(
+            XLATensor::Create(std::move(datas[j]), infos[i].dtype));
+      }
+    }
+    // The runtime is done reading the views once the transfers return.
+    for (size_t i = begin; i < end; ++i) {
+      file->DropPages(infos[i].offset, views[i].nbytes());
+    }
+    TORCH_LAZY_COUNTER("MappedTensorBatches", 1);
+    begin = end;
+  }
+  return tensors;
+}
+
+}  // namespace torch_xla
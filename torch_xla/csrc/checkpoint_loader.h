@@ -0,0 +1,44 @@
+#ifndef XLA_TORCH_XLA_CSRC_CHECKPOINT_LOADER_H_
+#define XLA_TORCH_XLA_CSRC_CHECKPOINT_LOADER_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ATen/Tensor.h>
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xla/xla_data.pb.h"
+
+#include "torch_xla/csrc/device.h"
+
+namespace torch_xla {
+
+// A tensor stored dense and row major at `offset` bytes into a checkpoint
+// file, as safetensors files store them.
+struct MappedTensorInfo {
+  int64_t offset = 0;
+  at::ScalarType dtype = at::ScalarType::Float;
+  std::vector<int64_t> sizes;
+  // Shards the tensor across the local devices when set, which requires
+  // `device` to be the SPMD virtual device.
+  std::optional<xla::OpSharding> sharding;
+};
+
+// Uploads the tensors of `infos` to `device` straight out of a read-only
+// mapping of the file at `path`, and returns them as XLA tensors. The evenly
+// sharded tiles are transferred from strided views of the mapping; only the
+// padded tiles of uneven shardings and the tensors needing a type conversion
+// are copied on the host. The tensors go in batches of at most
+// `max_inflight_bytes` of host data, and the pages of each batch are dropped
+// once it is transferred, so the host memory used stays bounded by the batch
+// size rather than the size of the checkpoint.
+absl::StatusOr<std::vector<at::Tensor>> LoadMappedTensors(
+    const std::string& path, absl::Span<const MappedTensorInfo> infos,
+    const torch::lazy::BackendDevice& device, int64_t max_inflight_bytes);
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_CHECKPOINT_LOADER_H_
@@ -4,6 +4,7 @@
 
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/shape_helper.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/xla_lower_util.h"
@@ -123,34 +124,75 @@ xla::XlaOp PadInputFromOutputSize(xla::XlaOp input,
 ConvOpAttrs MakeConvOpAttrs(absl::Span<const int64_t> spatial_stride,
                             absl::Span<const int64_t> spatial_padding,
                             absl::Span<const int64_t> spatial_dilation,
-                            bool depthwise) {
+                            bool depthwise,
+                            TensorFormat data_format = FORMAT_NCHW) {
   int num_spatial_dims = spatial_stride.size();
   XLA_CHECK_EQ(spatial_padding.size(), num_spatial_dims);
   XLA_CHECK_EQ(spatial_dilation.size(), num_spatial_dims);
+  int num_dims = num_spatial_dims + 2;
   ConvOpAttrs conv_op_attrs;
   conv_op_attrs.depthwise = depthwise;
   conv_op_attrs.num_spatial_dims = num_spatial_dims;
   // Stride, dilation and padding must be set for the batch and feature in the
   // TF convolution metadata. Set them to 1 (stride and dilation) or 0 (padding)
   // for the batch and feature dimensions.
-  conv_op_attrs.dilations = {1, 1};
-  std::copy(spatial_dilation.begin(), spatial_dilation.end(),
-            std::back_inserter(conv_op_attrs.dilations));
-  conv_op_attrs.strides = {1, 1};
-  std::copy(spatial_stride.begin(), spatial_stride.end(),
-            std::back_inserter(conv_op_attrs.strides));
+  conv_op_attrs.dilations.assign(num_dims, 1);
+  conv_op_attrs.strides.assign(num_dims, 1);
   conv_op_attrs.padding = Padding::EXPLICIT;
   // https://github.com/tensorflow/tensorflow/blob/ec81825aaf7e848d9f8ddffdf1e0d20aebe9172c/tensorflow/core/util/padding.cc#L40
   // explicit_padding requires to have (spatial_dims + 2) * 2 elements
-  conv_op_attrs.explicit_paddings.resize(4);
+  conv_op_attrs.explicit_paddings.assign(num_dims * 2, 0);
   for (int spatial_dim = 0; spatial_dim < num_spatial_dims; ++spatial_dim) {
-    conv_op_attrs.explicit_paddings.push_back(spatial_padding[spatial_dim]);
-    conv_op_attrs.explicit_paddings.push_back(spatial_padding[spatial_dim]);
+    int dim = GetTensorSpatialDimIndex(num_dims, data_format, spatial_dim);
+    conv_op_attrs.dilations[dim] = spatial_dilation[spatial_dim];
+    conv_op_attrs.strides[dim] = spatial_stride[spatial_dim];
+    conv_op_attrs.explicit_paddings[2 * dim] = spatial_padding[spatial_dim];
+    conv_op_attrs.explicit_paddings[2 * dim + 1] = spatial_padding[spatial_dim];
   }
-  conv_op_attrs.data_format = TensorFormat::FORMAT_NCHW;
+  conv_op_attrs.data_format = data_format;
   return conv_op_attrs;
 }
 
+// Moves the feature dimension of an NCHW (or NCDHW) tensor last.
+std::vector<int64_t> ChannelsLastPermutation(int64_t rank) {
+  std::vector<int64_t> permutation = {0};
+  for (int64_t dim = 2; dim < rank; ++dim) {
+    permutation.push_back(dim);
+  }
+  permutation.push_back(1);
+  return permutation;
+}
+
+xla::XlaOp ToChannelsLast(xla::XlaOp op) {
+  int64_t rank = ShapeHelper::ShapeOfXlaOp(op).dimensions_size();
+  return xla::Transpose(op, ChannelsLastPermutation(rank));
+}
+
+xla::XlaOp FromChannelsLast(xla::XlaOp op) {
+  int64_t rank = ShapeHelper::ShapeOfXlaOp(op).dimensions_size();
+  return xla::Transpose(
+      op, xla::InversePermutation(ChannelsLastPermutation(rank)));
+}
+
+// The dimension numbers of a convolution of an NHWC input with an HWIO
+// kernel, to an NHWC output.
+xla::ConvolutionDimensionNumbers ChannelsLastConvDimensionNumbers(
+    int64_t num_spatial_dims) {
+  xla::ConvolutionDimensionNumbers dnums;
+  dnums.set_input_batch_dimension(0);
+  dnums.set_input_feature_dimension(num_spatial_dims + 1);
+  dnums.set_kernel_input_feature_dimension(num_spatial_dims);
+  dnums.set_kernel_output_feature_dimension(num_spatial_dims + 1);
+  dnums.set_output_batch_dimension(0);
+  dnums.set_output_feature_dimension(num_spatial_dims + 1);
+  for (int64_t i = 0; i < num_spatial_dims; ++i) {
+    dnums.add_input_spatial_dimensions(i + 1);
+    dnums.add_kernel_spatial_dimensions(i);
+    dnums.add_output_spatial_dimensions(i + 1);
+  }
+  return dnums;
+}
+
 // Transpose filter shape to have [channel, batch] as last two dimensions.
 // 4D case: (N, C, H, W) -> (H, W, C, N)
 const std::vector<int64_t>& FilterTransposePermutation(const int64_t k) {
@@ -214,11 +256,22 @@ xla::XlaOp BuildConvBackwardInput(xla::XlaOp grad_output, xla::XlaOp kernel,
                                   absl::Span<const int64_t> spatial_stride,
                                   absl::Span<const int64_t> spatial_padding,
                                   absl::Span<const int64_t> spatial_dilation,
-                                  int64_t groups) {
-  ConvOpAttrs conv_op_attrs =
-      MakeConvOpAttrs(spatial_stride, spatial_padding, spatial_dilation, false);
+                                  int64_t groups, bool channels_last = false) {
+  ConvOpAttrs conv_op_attrs = MakeConvOpAttrs(
+      spatial_stride, spatial_padding, spatial_dilation, false,
+      channels_last ? FORMAT_NHWC : FORMAT_NCHW);
   xla::XlaOp kernel_transposed = xla::Transpose(
       kernel, FilterTransposePermutation(input_shape.dimensions_size()));
+  if (channels_last) {
+    xla::Shape channels_last_shape = xla::ShapeUtil::PermuteDimensions(
+        ChannelsLastPermutation(input_shape.dimensions_size()), input_shape);
+    XLA_ASSIGN_OR_THROW(
+        xla::XlaOp conv_backward_input,
+        MakeXlaBackpropInputConvOp("conv_backward_input", channels_last_shape,
+                                   kernel_transposed,
+                                   ToChannelsLast(grad_output), conv_op_attrs));
+    return FromChannelsLast(conv_backward_input);
+  }
   XLA_ASSIGN_OR_THROW(xla::XlaOp conv_backward_input,
                       MakeXlaBackpropInputConvOp("conv_backward_input",
                                                  input_shape, kernel_transposed,
@@ -232,15 +285,20 @@ xla::XlaOp BuildConvBackwardWeight(xla::XlaOp grad_output, xla::XlaOp input,
                                    absl::Span<const int64_t> spatial_stride,
                                    absl::Span<const int64_t> spatial_padding,
                                    absl::Span<const int64_t> spatial_dilation,
-                                   int64_t groups) {
-  ConvOpAttrs conv_op_attrs =
-      MakeConvOpAttrs(spatial_stride, spatial_padding, spatial_dilation, false);
+                                   int64_t groups, bool channels_last = false) {
+  ConvOpAttrs conv_op_attrs = MakeConvOpAttrs(
+      spatial_stride, spatial_padding, spatial_dilation, false,
+      channels_last ? FORMAT_NHWC : FORMAT_NCHW);
   auto transpose_permutation =
       FilterTransposePermutation(kernel_shape.dimensions_size());
   auto inv_transpose_permutation =
       xla::InversePermutation(transpose_permutation);
   xla::Shape transposed_weight_shape =
       xla::ShapeUtil::PermuteDimensions(transpose_permutation, kernel_shape);
+  if (channels_last) {
+    input = ToChannelsLast(input);
+    grad_output = ToChannelsLast(grad_output);
+  }
   XLA_ASSIGN_OR_THROW(xla::XlaOp conv_backward_weight,
                       MakeXlaBackpropFilterConvOp("conv_backward_weight", input,
                                                   transposed_weight_shape,
@@ -317,13 +375,39 @@ ConvGrads BuildTransposedConvolutionBackward(
 
 }  // namespace
 
+bool UseChannelsLastConvolution(XlaDeviceType hw_type) {
+  static const std::string* conv_layout = new std::string(
+      runtime::sys_util::GetEnvString("XLA_CONV_LAYOUT", "nchw"));
+  if (*conv_layout == "nhwc") {
+    return true;
+  }
+  XLA_CHECK(*conv_layout == "nchw" || *conv_layout == "auto")
+      << "Invalid XLA_CONV_LAYOUT: " << *conv_layout;
+  return *conv_layout == "auto" && hw_type == XlaDeviceType::CUDA;
+}
+
 xla::XlaOp BuildConvolutionOverrideable(
     xla::XlaOp input, xla::XlaOp kernel, absl::Span<const int64_t> stride,
     absl::Span<const int64_t> padding, absl::Span<const int64_t> dilation,
-    bool transposed, absl::Span<const int64_t> output_padding, int64_t groups) {
+    bool transposed, absl::Span<const int64_t> output_padding, int64_t groups,
+    bool channels_last) {
   if (transposed) {
     return BuildTransposedConvolution(input, kernel, stride, padding, dilation,
                                       output_padding, groups);
+  } else if (channels_last) {
+    xla::PrecisionConfig precision_config =
+        XlaHelpers::BuildPrecisionConfig(XlaHelpers::mat_mul_precision());
+    int64_t rank = ShapeHelper::ShapeOfXlaOp(kernel).dimensions_size();
+    xla::XlaOp conv = xla::ConvGeneralDilated(
+        ToChannelsLast(input),
+        xla::Transpose(kernel, FilterTransposePermutation(rank)), stride,
+        MakePadding(padding),
+        /*lhs_dilation*/ {},
+        /*rhs_dilation*/ dilation,
+        /*dimension_numbers*/ ChannelsLastConvDimensionNumbers(stride.size()),
+        /*feature_group_count*/ groups,
+        /*batch_group_count=*/1, &precision_config);
+    return FromChannelsLast(conv);
   } else {
     auto dims_padding = MakePadding(padding);
     xla::PrecisionConfig precision_config =
@@ -343,10 +427,11 @@ xla::XlaOp BuildConvolutionOverrideableBias(
     xla::XlaOp input, xla::XlaOp kernel, xla::XlaOp bias,
     absl::Span<const int64_t> stride, absl::Span<const int64_t> padding,
     absl::Span<const int64_t> dilation, bool transposed,
-    absl::Span<const int64_t> output_padding, int64_t groups) {
-  xla::XlaOp conv =
-      BuildConvolutionOverrideable(input, kernel, stride, padding, dilation,
-                                   transposed, output_padding, groups);
+    absl::Span<const int64_t> output_padding, int64_t groups,
+    bool channels_last) {
+  xla::XlaOp conv = BuildConvolutionOverrideable(
+      input, kernel, stride, padding, dilation, transposed, output_padding,
+      groups, channels_last);
   auto broadcast_sizes = XlaHelpers::SizesOfXlaOp(conv);
   std::vector<int64_t> conv_dims(broadcast_sizes.size());
   std::iota(conv_dims.begin(), conv_dims.end(), 0);
@@ -379,7 +464,8 @@ ConvGrads BuildConvolutionBackwardOverrideable(
     xla::XlaOp grad_output, xla::XlaOp input, xla::XlaOp kernel,
     absl::Span<const int64_t> stride, absl::Span<const int64_t> padding,
     absl::Span<const int64_t> dilation, bool transposed,
-    absl::Span<const int64_t> output_padding, int64_t groups) {
+    absl::Span<const int64_t> output_padding, int64_t groups,
+    bool channels_last) {
   if (transposed) {
     return BuildTransposedConvolutionBackward(grad_output, input, kernel,
                                               stride, padding, dilation,
@@ -387,10 +473,10 @@ ConvGrads BuildConvolutionBackwardOverrideable(
   } else {
     xla::XlaOp grad_input = BuildConvBackwardInput(
         grad_output, kernel, ShapeHelper::ShapeOfXlaOp(input), stride, padding,
-        dilation, groups);
+        dilation, groups, channels_last);
     xla::XlaOp grad_weight = BuildConvBackwardWeight(
         grad_output, input, ShapeHelper::ShapeOfXlaOp(kernel), stride, padding,
-        dilation, groups);
+        dilation, groups, channels_last);
     xla::XlaOp grad_bias = BuildGradBias(grad_output);
     return {grad_input, grad_weight, grad_bias};
   }
@@ -5,22 +5,34 @@
 #include "xla/hlo/builder/xla_builder.h"
 
 #include "torch_xla/csrc/convolution_helper.h"
+#include "torch_xla/csrc/device.h"
 
 namespace torch_xla {
 
+// Whether the convolutions on `hw_type` are lowered with the channels as the
+// last dimension of their operands, per $XLA_CONV_LAYOUT: "nchw", the default,
+// "nhwc", or "auto", which picks the channels last lowering on CUDA, where
+// cuDNN runs it without relayouts.
+bool UseChannelsLastConvolution(XlaDeviceType hw_type);
+
 // Computes the convolution of the given input and kernel with the given
-// precision, with the given stride and padding.
+// precision, with the given stride and padding. The inputs and the result stay
+// in the PyTorch NCHW order. With `channels_last`, the non transposed
+// convolutions transpose them to and from NHWC around the convolution, so that
+// XLA assigns the channels last layout to them and to the ops in between.
 xla::XlaOp BuildConvolutionOverrideable(
     xla::XlaOp input, xla::XlaOp kernel, absl::Span<const int64_t> stride,
     absl::Span<const int64_t> padding, absl::Span<const int64_t> dilation,
-    bool transposed, absl::Span<const int64_t> output_padding, int64_t groups);
+    bool transposed, absl::Span<const int64_t> output_padding, int64_t groups,
+    bool channels_last = false);
 
 // Same as above, then broadcasts the bias and adds it to the result.
 xla::XlaOp BuildConvolutionOverrideableBias(
     xla::XlaOp input, xla::XlaOp kernel, xla::XlaOp bias,
     absl::Span<const int64_t> stride, absl::Span<const int64_t> padding,
     absl::Span<const int64_t> dilation, bool transposed,
-    absl::Span<const int64_t> output_padding, int64_t groups);
+    absl::Span<const int64_t> output_padding, int64_t groups,
+    bool channels_last = false);
 
 struct ConvGrads {
   xla::XlaOp grad_input;
@@ -33,7 +45,8 @@ ConvGrads BuildConvolutionBackwardOverrideable(
     xla::XlaOp grad_output, xla::XlaOp input, xla::XlaOp kernel,
     absl::Span<const int64_t> stride, absl::Span<const int64_t> padding,
     absl::Span<const int64_t> dilation, bool transposed,
-    absl::Span<const int64_t> output_padding, int64_t groups);
+    absl::Span<const int64_t> output_padding, int64_t groups,
+    bool channels_last = false);
 
 }  // namespace torch_xla
 
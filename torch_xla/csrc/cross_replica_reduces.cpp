@@ -1,9 +1,16 @@
 #include "torch_xla/csrc/cross_replica_reduces.h"
 
+#include <algorithm>
 #include <map>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <utility>
 
 #include <torch/csrc/lazy/core/util.h>
 
+#include "xla/hlo/builder/lib/constants.h"
+#include "xla/primitive_util.h"
 #include "xla/shape_util.h"
 
 #include "torch_xla/csrc/aten_xla_bridge.h"
@@ -13,6 +20,7 @@
 #include "torch_xla/csrc/layout_manager.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/util.h"
 #include "torch_xla/csrc/shape_helper.h"
 #include "torch_xla/csrc/tensor_methods.h"
@@ -25,9 +33,14 @@ namespace {
 // Note [V3-8 Threading]
 // For V3-8 + PJRT, we have 4 processes and each process has 2 threads to manage
 // the 8 cores. Therefore, we need different tokens for different threads.
-std::unordered_map<int64_t, std::shared_ptr<torch::lazy::Value>>
+// Each device further keeps one token per domain, as the collectives of
+// different domains need not be ordered with respect to each other.
+std::map<std::pair<int64_t, std::string>, std::shared_ptr<torch::lazy::Value>>
     g_all_reduce_tokens;
 
+// The token domain the collectives issued by this thread are chained into.
+thread_local std::string g_token_domain;
+
 struct PerTypeContext {
   std::vector<xla::XlaOp> ops;
   std::vector<size_t> indices;
@@ -95,6 +108,216 @@ std::vector<xla::ReplicaGroup> CreateReduceGroups(
   return reduce_groups;
 }
 
+// The layout of the replicas over the hosts, for the collectives over all the
+// replicas that run hierarchically. Replica `h * host_size + i` is the i-th
+// replica of host `h`.
+struct HostTopology {
+  int64_t num_hosts = 0;
+  int64_t host_size = 0;
+
+  int64_t num_replicas() const { return num_hosts * host_size; }
+};
+
+// Returns the topology with which to run a collective over `groups`
+// hierarchically, if enabled and the collective spans all the replicas of
+// more than one host.
+std::optional<HostTopology> GetHierarchicalTopology(
+    const std::vector<std::vector<int64_t>>& groups) {
+  if (!UseHierarchicalCollectives()) {
+    return std::nullopt;
+  }
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  HostTopology topology;
+  topology.num_hosts = client->GetNumProcesses();
+  topology.host_size = client->GetNumLocalDevices();
+  if (topology.num_hosts < 2 || topology.host_size < 2 ||
+      topology.num_replicas() !=
+          static_cast<int64_t>(client->GetAllDevices().size())) {
+    return std::nullopt;
+  }
+  if (!groups.empty()) {
+    std::vector<int64_t> all_replicas(topology.num_replicas());
+    std::iota(all_replicas.begin(), all_replicas.end(), 0);
+    if (groups.size() != 1 || groups.front() != all_replicas) {
+      return std::nullopt;
+    }
+  }
+  return topology;
+}
+
+// The groups of the replicas of each host.
+std::vector<xla::ReplicaGroup> CreateIntraHostGroups(
+    const HostTopology& topology) {
+  std::vector<std::vector<int64_t>> groups(topology.num_hosts);
+  for (int64_t h = 0; h < topology.num_hosts; ++h) {
+    for (int64_t i = 0; i < topology.host_size; ++i) {
+      groups[h].push_back(h * topology.host_size + i);
+    }
+  }
+  return CreateReduceGroups(groups);
+}
+
+// The groups of the replicas with the same index within their host.
+std::vector<xla::ReplicaGroup> CreateInterHostGroups(
+    const HostTopology& topology) {
+  std::vector<std::vector<int64_t>> groups(topology.host_size);
+  for (int64_t i = 0; i < topology.host_size; ++i) {
+    for (int64_t h = 0; h < topology.num_hosts; ++h) {
+      groups[i].push_back(h * topology.host_size + i);
+    }
+  }
+  return CreateReduceGroups(groups);
+}
+
+// All-reduces the rank 1 `input` as a reduce-scatter within the hosts, an
+// all-reduce of the shards across the hosts and an all-gather within the
+// hosts, so that only 1/host_size of the data crosses the hosts.
+xla::XlaOp BuildHierarchicalAllReduce(AllReduceType reduce_type,
+                                      xla::XlaOp input,
+                                      const HostTopology& topology) {
+  const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
+  xla::PrimitiveType type = input_shape.element_type();
+  int64_t size = input_shape.dimensions(0);
+  int64_t padded_size =
+      (size + topology.host_size - 1) / topology.host_size * topology.host_size;
+  std::vector<xla::ReplicaGroup> intra_groups =
+      CreateIntraHostGroups(topology);
+  xla::XlaComputation reduce = GetReduceComputation(reduce_type, type);
+  xla::XlaOp padded = input;
+  if (padded_size != size) {
+    padded = xla::PadInDim(input, xla::Zero(input.builder(), type),
+                           /*dimno=*/0, /*pad_lo=*/0,
+                           /*pad_hi=*/padded_size - size);
+  }
+  xla::XlaOp shard = xla::ReduceScatter(padded, reduce, /*scatter_dimension=*/0,
+                                        topology.host_size, intra_groups);
+  shard = xla::AllReduce(shard, reduce, CreateInterHostGroups(topology));
+  xla::XlaOp result = xla::AllGather(shard, /*all_gather_dimension=*/0,
+                                     topology.host_size, intra_groups);
+  if (padded_size != size) {
+    result = xla::SliceInDim(result, 0, size, 1, 0);
+  }
+  return result;
+}
+
+// Runs the all-reduce of the operands of each type, and of the token, through
+// BuildHierarchicalAllReduce() as a single flat buffer.
+std::vector<xla::XlaOp> BuildHierarchicalAllReduce(
+    AllReduceType reduce_type, absl::Span<const xla::XlaOp> operands,
+    xla::XlaOp token, double scale, const HostTopology& topology) {
+  TORCH_LAZY_COUNTER("HierarchicalAllReduce", 1);
+  xla::XlaOp chained_token = token;
+  ReduceContext redux = GetReduceContext(operands);
+  std::vector<xla::XlaOp> result(operands.size());
+  for (auto& type_ctx : redux.contexts) {
+    const PerTypeContext& ctx = type_ctx.second;
+    std::vector<xla::XlaOp> flat_ops;
+    flat_ops.reserve(ctx.ops.size() + 1);
+    for (size_t i = 0; i < ctx.ops.size(); ++i) {
+      flat_ops.push_back(xla::Reshape(
+          ctx.ops[i], {xla::ShapeUtil::ElementsIn(ctx.operand_shapes[i])}));
+    }
+    flat_ops.push_back(
+        xla::Reshape(MaybeConvertTo(chained_token, type_ctx.first), {1}));
+    xla::XlaOp reduced = BuildHierarchicalAllReduce(
+        reduce_type, xla::ConcatInDim(operands[0].builder(), flat_ops, 0),
+        topology);
+    int64_t offset = 0;
+    for (size_t i = 0; i < ctx.indices.size(); ++i) {
+      const xla::Shape& shape = ctx.operand_shapes[i];
+      int64_t size = xla::ShapeUtil::ElementsIn(shape);
+      xla::XlaOp op =
+          xla::Reshape(xla::SliceInDim(reduced, offset, offset + size, 1, 0),
+                       shape.dimensions());
+      if (scale != 1.0) {
+        op = op * XlaHelpers::ScalarValue<float>(scale, type_ctx.first,
+                                                 op.builder());
+      }
+      result[ctx.indices[i]] = op;
+      offset += size;
+    }
+    chained_token =
+        xla::Reshape(xla::SliceInDim(reduced, offset, offset + 1, 1, 0), {});
+  }
+  result.push_back(
+      MaybeConvertTo(chained_token, XlaHelpers::TypeOfXlaOp(token)));
+  return result;
+}
+
+// Reduce-scatters `input` over all the replicas as a reduce-scatter within
+// the hosts followed by one across the hosts. The chunks of `scatter_dim` are
+// first reordered host index major, so that chunk `r` still lands on replica
+// `r`.
+xla::XlaOp BuildHierarchicalReduceScatter(AllReduceType reduce_type,
+                                          xla::XlaOp input, int64_t scatter_dim,
+                                          const HostTopology& topology) {
+  TORCH_LAZY_COUNTER("HierarchicalReduceScatter", 1);
+  const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
+  std::vector<int64_t> dims(input_shape.dimensions().begin(),
+                            input_shape.dimensions().end());
+  std::vector<int64_t> split_dims(dims.begin(), dims.begin() + scatter_dim);
+  split_dims.push_back(topology.num_hosts);
+  split_dims.push_back(topology.host_size);
+  split_dims.push_back(dims[scatter_dim] / topology.num_replicas());
+  split_dims.insert(split_dims.end(), dims.begin() + scatter_dim + 1,
+                    dims.end());
+  std::vector<int64_t> permutation(split_dims.size());
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::swap(permutation[scatter_dim], permutation[scatter_dim + 1]);
+  xla::XlaOp reordered = xla::Reshape(
+      xla::Transpose(xla::Reshape(input, split_dims), permutation), dims);
+  xla::XlaComputation reduce =
+      GetReduceComputation(reduce_type, input_shape.element_type());
+  xla::XlaOp shard =
+      xla::ReduceScatter(reordered, reduce, scatter_dim, topology.host_size,
+                         CreateIntraHostGroups(topology));
+  return xla::ReduceScatter(shard, reduce, scatter_dim, topology.num_hosts,
+                            CreateInterHostGroups(topology));
+}
+
+// Whether the operands of `type` are reduced in the narrower `element_type`.
+bool ShouldCompress(xla::PrimitiveType type, xla::PrimitiveType element_type) {
+  return xla::primitive_util::IsFloatingPointType(type) &&
+         xla::primitive_util::BitWidth(element_type) <
+             xla::primitive_util::BitWidth(type);
+}
+
+int64_t GetReplicaGroupSize(const std::vector<std::vector<int64_t>>& groups) {
+  if (!groups.empty()) {
+    return groups.front().size();
+  }
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  return client->GetAllDevices().size();
+}
+
+// Returns the factor by which to scale the `inputs` of `type` before their
+// conversion to the fp8 `element_type`, so that their sum over the
+// `group_size` replicas stays within the fp8 range. The factor comes from the
+// largest magnitude of the inputs over all the replicas, so that every replica
+// uses the same one.
+xla::XlaOp BuildFp8RangeScale(absl::Span<const xla::XlaOp> inputs,
+                              xla::PrimitiveType type,
+                              xla::PrimitiveType element_type,
+                              const std::vector<xla::ReplicaGroup>& groups,
+                              int64_t group_size) {
+  xla::XlaBuilder* builder = inputs[0].builder();
+  xla::XlaComputation max = XlaHelpers::CreateMaxComputation(type);
+  xla::XlaOp zero = xla::Zero(builder, type);
+  xla::XlaOp amax = zero;
+  for (xla::XlaOp input : inputs) {
+    amax = xla::Max(amax, xla::ReduceAll(xla::Abs(input), zero, max));
+  }
+  amax = xla::AllReduce(amax, max, groups);
+  xla::XlaOp limit =
+      xla::ConvertElementType(xla::MaxFiniteValue(builder, element_type),
+                              type) /
+      XlaHelpers::ScalarValue<float>(group_size, type, builder);
+  return xla::Select(xla::Gt(amax, zero), limit / amax,
+                     xla::One(builder, type));
+}
+
 std::shared_ptr<torch::lazy::Value> CreateToken(
     const torch::lazy::BackendDevice& device) {
   // This should be using xla::CreateToken() once we have added Token support to
@@ -135,7 +358,22 @@ TORCH_LIBRARY_IMPL(_c10d_functional, XLA, m) {
 std::vector<xla::XlaOp> BuildAllReduce(
     AllReduceType reduce_type, absl::Span<const xla::XlaOp> operands,
     xla::XlaOp token, double scale,
-    const std::vector<std::vector<int64_t>>& groups, bool pin_layout) {
+    const std::vector<std::vector<int64_t>>& groups, bool pin_layout,
+    std::optional<xla::PrimitiveType> reduce_element_type,
+    absl::Span<const xla::XlaOp> residuals) {
+  XLA_CHECK(residuals.empty() || residuals.size() == operands.size())
+      << "Expected one residual per operand, got " << residuals.size()
+      << " residuals for " << operands.size() << " operands";
+  std::optional<HostTopology> topology = GetHierarchicalTopology(groups);
+  if (topology.has_value() && !reduce_element_type.has_value() &&
+      residuals.empty() &&
+      std::all_of(operands.begin(), operands.end(), [](xla::XlaOp op) {
+        return ShapeHelper::ShapeOfXlaOp(op).is_static();
+      })) {
+    // The flat buffer has a single layout, so there is no layout to pin.
+    return BuildHierarchicalAllReduce(reduce_type, operands, token, scale,
+                                      *topology);
+  }
   std::vector<xla::ReplicaGroup> reduce_groups = CreateReduceGroups(groups);
   // TODO: We use pseudo-tokens ATM, which are real values. This need to be
   // switched to use the real XLA Token once support has been added to XLA
@@ -143,39 +381,84 @@ std::vector<xla::XlaOp> BuildAllReduce(
   xla::XlaOp chained_token = token;
   ReduceContext redux = GetReduceContext(operands);
   std::vector<xla::XlaOp> result(operands.size());
+  std::vector<xla::XlaOp> new_residuals(residuals.size());
   for (auto& type_ctx : redux.contexts) {
-    xla::XlaOp token_op = MaybeConvertTo(chained_token, type_ctx.first);
-    type_ctx.second.ops.push_back(token_op);
-    type_ctx.second.operand_shapes.push_back(
-        ShapeHelper::ShapeOfXlaOp(token_op));
+    PerTypeContext& ctx = type_ctx.second;
+    bool compress = reduce_element_type.has_value() &&
+                    ShouldCompress(type_ctx.first, *reduce_element_type);
+    xla::PrimitiveType element_type =
+        compress ? *reduce_element_type : type_ctx.first;
+    xla::XlaBuilder* builder = operands[0].builder();
+    if (!residuals.empty()) {
+      for (size_t i = 0; i < ctx.indices.size(); ++i) {
+        size_t op_idx = ctx.indices[i];
+        ctx.ops[i] = ctx.ops[i] + residuals[op_idx];
+        if (!compress) {
+          new_residuals[op_idx] = xla::ZerosLike(residuals[op_idx]);
+        }
+      }
+    }
+    std::optional<xla::XlaOp> range_scale;
+    if (compress && xla::primitive_util::IsF8Type(element_type)) {
+      range_scale = BuildFp8RangeScale(ctx.ops, type_ctx.first, element_type,
+                                       reduce_groups,
+                                       GetReplicaGroupSize(groups));
+    }
+    if (compress) {
+      TORCH_LAZY_COUNTER("CompressedAllReduceOperands", ctx.ops.size());
+      for (size_t i = 0; i < ctx.ops.size(); ++i) {
+        xla::XlaOp input =
+            range_scale.has_value() ? ctx.ops[i] * *range_scale : ctx.ops[i];
+        xla::XlaOp compressed = xla::ConvertElementType(input, element_type);
+        if (!residuals.empty()) {
+          xla::XlaOp restored =
+              xla::ConvertElementType(compressed, type_ctx.first);
+          if (range_scale.has_value()) {
+            restored = restored / *range_scale;
+          }
+          new_residuals[ctx.indices[i]] = ctx.ops[i] - restored;
+        }
+        ctx.ops[i] = compressed;
+        ctx.operand_shapes[i].set_element_type(element_type);
+      }
+    }
+    xla::XlaOp token_op = MaybeConvertTo(chained_token, element_type);
+    ctx.ops.push_back(token_op);
+    ctx.operand_shapes.push_back(ShapeHelper::ShapeOfXlaOp(token_op));
 
     xla::XlaOp reduce;
     if (pin_layout) {
       reduce = xla::AllReduce(
-          xla::Tuple(operands[0].builder(), type_ctx.second.ops),
-          GetReduceComputation(reduce_type, type_ctx.first), reduce_groups,
+          xla::Tuple(builder, ctx.ops),
+          GetReduceComputation(reduce_type, element_type), reduce_groups,
           /*channel_id=*/absl::nullopt,
           /*shape_with_layout=*/
-          MakeReduceShape(type_ctx.second.operand_shapes));
+          MakeReduceShape(ctx.operand_shapes));
     } else {
-      reduce = xla::AllReduce(
-          xla::Tuple(operands[0].builder(), type_ctx.second.ops),
-          GetReduceComputation(reduce_type, type_ctx.first), reduce_groups);
+      reduce =
+          xla::AllReduce(xla::Tuple(builder, ctx.ops),
+                         GetReduceComputation(reduce_type, element_type),
+                         reduce_groups);
     }
-    for (size_t i = 0; i < type_ctx.second.indices.size(); ++i) {
-      size_t op_idx = type_ctx.second.indices[i];
+    for (size_t i = 0; i < ctx.indices.size(); ++i) {
+      size_t op_idx = ctx.indices[i];
       xla::XlaOp gte = xla::GetTupleElement(reduce, i);
+      if (compress) {
+        gte = xla::ConvertElementType(gte, type_ctx.first);
+        if (range_scale.has_value()) {
+          gte = gte / *range_scale;
+        }
+      }
       if (scale != 1.0) {
-        xla::XlaOp scaling_value = XlaHelpers::ScalarValue<float>(
-            scale, type_ctx.second.operand_shapes[i].element_type(),
-            gte.builder());
+        xla::XlaOp scaling_value =
+            XlaHelpers::ScalarValue<float>(scale, type_ctx.first, builder);
         gte = gte * scaling_value;
       }
       result[op_idx] = gte;
     }
-    chained_token =
-        xla::GetTupleElement(reduce, type_ctx.second.indices.size());
+    chained_token = xla::GetTupleElement(reduce, ctx.indices.size());
   }
+  result.insert(result.end(), new_residuals.begin(), new_residuals.end());
   result.push_back(
       MaybeConvertTo(chained_token, XlaHelpers::TypeOfXlaOp(token)));
   return result;
@@ -229,6 +512,107 @@ AllToAllResult BuildAllToAll(xla::XlaOp input, xla::XlaOp token,
   return {reduce_result, token_handler.GetNewToken(reduce_result)};
 }
 
+AllToAllResultCoalesced BuildAllToAllCoalesced(
+    absl::Span<const xla::XlaOp> inputs, xla::XlaOp token,
+    int64_t split_dimension, int64_t concat_dimension, int64_t split_count,
+    const std::vector<std::vector<int64_t>>& groups, bool pin_layout) {
+  XLA_CHECK(!inputs.empty());
+  xla::XlaBuilder* builder = inputs[0].builder();
+  // Each input is laid out as [split_count, bytes], the chunk sent to each
+  // replica in its own row, and the rows of all the inputs are concatenated,
+  // so that inputs of any type share one all-to-all.
+  std::vector<xla::Shape> input_shapes;
+  std::vector<xla::XlaOp> input_bytes;
+  std::vector<int64_t> byte_counts;
+  for (xla::XlaOp input : inputs) {
+    const xla::Shape& shape = ShapeHelper::ShapeOfXlaOp(input);
+    XLA_CHECK(shape.is_static())
+        << "Coalesced all-to-all requires static shapes: " << shape;
+    XLA_CHECK_EQ(shape.dimensions(split_dimension) % split_count, 0)
+        << "Split dimension " << split_dimension << " of " << shape
+        << " is not divisible by " << split_count;
+    std::vector<int64_t> permutation(shape.dimensions_size());
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::rotate(permutation.begin(), permutation.begin() + split_dimension,
+                permutation.begin() + split_dimension + 1);
+    int64_t chunk_elements =
+        xla::ShapeUtil::ElementsIn(shape) / split_count;
+    xla::XlaOp rows = xla::Reshape(xla::Transpose(input, permutation),
+                                   {split_count, chunk_elements});
+    if (shape.element_type() == xla::PrimitiveType::PRED) {
+      rows = xla::ConvertElementType(rows, xla::PrimitiveType::U8);
+    }
+    int64_t width =
+        xla::primitive_util::ByteWidth(XlaHelpers::TypeOfXlaOp(rows));
+    if (XlaHelpers::TypeOfXlaOp(rows) != xla::PrimitiveType::U8) {
+      rows = xla::Reshape(
+          xla::BitcastConvertType(rows, xla::PrimitiveType::U8),
+          {split_count, chunk_elements * width});
+    }
+    input_shapes.push_back(shape);
+    input_bytes.push_back(rows);
+    byte_counts.push_back(chunk_elements * width);
+  }
+  AllToAllResult bytes_result = BuildAllToAll(
+      xla::ConcatInDim(builder, input_bytes, 1), token,
+      /*split_dimension=*/0, /*concat_dimension=*/0, split_count, groups,
+      pin_layout);
+
+  std::vector<xla::XlaOp> result;
+  result.reserve(inputs.size());
+  int64_t offset = 0;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const xla::Shape& shape = input_shapes[i];
+    xla::PrimitiveType type = shape.element_type() == xla::PrimitiveType::PRED
+                                  ? xla::PrimitiveType::U8
+                                  : shape.element_type();
+    int64_t width = xla::primitive_util::ByteWidth(type);
+    int64_t chunk_elements = byte_counts[i] / width;
+    xla::XlaOp rows = xla::SliceInDim(bytes_result.result, offset,
+                                      offset + byte_counts[i], 1, 1);
+    offset += byte_counts[i];
+    if (type != xla::PrimitiveType::U8) {
+      rows = xla::BitcastConvertType(
+          xla::Reshape(rows, {split_count, chunk_elements, width}), type);
+    }
+    if (type != shape.element_type()) {
+      rows = xla::ConvertElementType(rows, shape.element_type());
+    }
+    // Row r holds the chunk received from replica r, in the dimension order
+    // the split dimension was moved first in.
+    std::vector<int64_t> chunk_dims(shape.dimensions().begin(),
+                                    shape.dimensions().end());
+    chunk_dims[split_dimension] /= split_count;
+    std::vector<int64_t> moved_dims = {split_count,
+                                       chunk_dims[split_dimension]};
+    for (int64_t d = 0; d < shape.dimensions_size(); ++d) {
+      if (d != split_dimension) {
+        moved_dims.push_back(chunk_dims[d]);
+      }
+    }
+    // Restores the dimension order of the chunks, with the replica dimension
+    // right before the concat dimension, and merges the two.
+    std::vector<int64_t> permutation;
+    for (int64_t d = 0; d < shape.dimensions_size(); ++d) {
+      if (d == concat_dimension) {
+        permutation.push_back(0);
+      }
+      if (d == split_dimension) {
+        permutation.push_back(1);
+      } else {
+        permutation.push_back(d < split_dimension ? d + 2 : d + 1);
+      }
+    }
+    std::vector<int64_t> result_dims = chunk_dims;
+    result_dims[concat_dimension] *= split_count;
+    result.push_back(xla::Reshape(
+        xla::Transpose(xla::Reshape(rows, moved_dims), permutation),
+        result_dims));
+  }
+  TORCH_LAZY_COUNTER("CoalescedAllToAllInputs", inputs.size());
+  return {result, bytes_result.token};
+}
+
 AllGatherResult BuildAllGather(xla::XlaOp input, xla::XlaOp token, int64_t dim,
                                int64_t shard_count,
                                const std::vector<std::vector<int64_t>>& groups,
@@ -413,6 +797,22 @@ ReduceScatterResult BuildReduceScatter(
   std::vector<xla::ReplicaGroup> reduce_groups = CreateReduceGroups(groups);
   TokenHandler token_handler(token);
   const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
+  // The channel ids come with global device ids as groups, which the host
+  // topology does not describe.
+  std::optional<HostTopology> topology =
+      channel_id.has_value() ? std::nullopt : GetHierarchicalTopology(groups);
+  if (topology.has_value() && input_shape.is_static() &&
+      shard_count == topology->num_replicas()) {
+    xla::XlaOp reduce_result = BuildHierarchicalReduceScatter(
+        reduce_type, token_handler.GetInput(input, &input_shape), scatter_dim,
+        *topology);
+    if (scale != 1.0) {
+      xla::XlaOp scaling_value = XlaHelpers::ScalarValue<float>(
+          scale, input_shape.element_type(), input.builder());
+      reduce_result = reduce_result * scaling_value;
+    }
+    return {reduce_result, token_handler.GetNewToken(reduce_result)};
+  }
   std::optional<xla::ChannelHandle> channel_handle = std::nullopt;
   if (channel_id.has_value()) {
     xla::ChannelHandle channel_handle_value;
@@ -572,17 +972,35 @@ std::vector<torch::lazy::Value> GetOperandListWithToken(
 
 const torch::lazy::Value& GetAllReduceToken(
     const torch::lazy::BackendDevice& device) {
-  auto it = g_all_reduce_tokens.find(device.ordinal());
-  if (it == g_all_reduce_tokens.end() || it->second == nullptr) {
-    g_all_reduce_tokens[device.ordinal()] = CreateToken(device);
-    return *g_all_reduce_tokens[device.ordinal()];
+  std::shared_ptr<torch::lazy::Value>& token =
+      g_all_reduce_tokens[{device.ordinal(), g_token_domain}];
+  if (token == nullptr) {
+    token = CreateToken(device);
   }
-  return *it->second;
+  return *token;
 }
 
 void SetAllReduceToken(const torch::lazy::BackendDevice& device,
                        const std::shared_ptr<torch::lazy::Value>& token) {
-  g_all_reduce_tokens[device.ordinal()] = token;
+  g_all_reduce_tokens[{device.ordinal(), g_token_domain}] = token;
+}
+
+void ResetAllReduceTokens(const torch::lazy::BackendDevice& device) {
+  auto it = g_all_reduce_tokens.lower_bound({device.ordinal(), ""});
+  while (it != g_all_reduce_tokens.end() &&
+         it->first.first == device.ordinal()) {
+    it = g_all_reduce_tokens.erase(it);
+  }
+}
+
+const std::string& GetTokenDomain() { return g_token_domain; }
+
+void SetTokenDomain(std::string domain) { g_token_domain = std::move(domain); }
+
+bool UseHierarchicalCollectives() {
+  static const bool use_hierarchical_collectives =
+      runtime::sys_util::GetEnvBool("XLA_HIERARCHICAL_COLLECTIVES", false);
+  return use_hierarchical_collectives;
 }
 
 AllReduceType GetReduceType(std::string_view reduce_type) {
@@ -1,6 +1,8 @@
 #ifndef XLA_TORCH_XLA_CSRC_CROSS_REPLICA_REDUCES_H_
 #define XLA_TORCH_XLA_CSRC_CROSS_REPLICA_REDUCES_H_
 
+#include <optional>
+#include <string>
 #include <vector>
 
 #include <torch/csrc/lazy/core/ir.h>
@@ -27,6 +29,11 @@ struct AllToAllResult {
   xla::XlaOp token;
 };
 
+struct AllToAllResultCoalesced {
+  std::vector<xla::XlaOp> result;
+  xla::XlaOp token;
+};
+
 struct AllGatherResult {
   xla::XlaOp result;
   xla::XlaOp token;
@@ -62,10 +69,19 @@ struct ReduceScatterResultCoalesced {
   xla::XlaOp token;
 };
 
+// Returns the reduced operands followed by the new token. With
+// `reduce_element_type`, the floating point operands are reduced in that
+// narrower type, like bf16 or fp8, and converted back. Fp8 operands are scaled
+// into range by a factor shared by all the operands of the same type. With
+// `residuals`, one per operand, each residual is added to its operand before
+// the conversion, and the new residuals, the errors of the conversions, are
+// returned between the reduced operands and the token.
 std::vector<xla::XlaOp> BuildAllReduce(
     AllReduceType reduce_type, absl::Span<const xla::XlaOp> operands,
     xla::XlaOp token, double scale,
-    const std::vector<std::vector<int64_t>>& groups, bool pin_layout);
+    const std::vector<std::vector<int64_t>>& groups, bool pin_layout,
+    std::optional<xla::PrimitiveType> reduce_element_type = std::nullopt,
+    absl::Span<const xla::XlaOp> residuals = {});
 
 xla::XlaOp BuildAllReduce(AllReduceType reduce_type, xla::XlaOp operand,
                           double scale,
@@ -77,6 +93,13 @@ AllToAllResult BuildAllToAll(xla::XlaOp input, xla::XlaOp token,
                              const std::vector<std::vector<int64_t>>& groups,
                              bool pin_layout);
 
+// Runs the all-to-all of each input, with the same split and concat
+// dimensions, as a single all-to-all of their bytes.
+AllToAllResultCoalesced BuildAllToAllCoalesced(
+    absl::Span<const xla::XlaOp> inputs, xla::XlaOp token,
+    int64_t split_dimension, int64_t concat_dimension, int64_t split_count,
+    const std::vector<std::vector<int64_t>>& groups, bool pin_layout);
+
 AllGatherResult BuildAllGather(
     xla::XlaOp input, xla::XlaOp token, int64_t dim, int64_t shard_count,
     const std::vector<std::vector<int64_t>>& groups, bool pin_layout,
@@ -119,11 +142,28 @@ std::vector<torch::lazy::Value> GetOperandListWithToken(
     c10::ArrayRef<torch::lazy::Value> operands,
     const torch::lazy::Value& token);
 
+// Gets and sets the token ordering the collectives of `device` within the
+// token domain of the calling thread.
 const torch::lazy::Value& GetAllReduceToken(
     const torch::lazy::BackendDevice& device);
 void SetAllReduceToken(const torch::lazy::BackendDevice& device,
                        const std::shared_ptr<torch::lazy::Value>& token);
 
+// Drops the tokens of all the token domains of `device`, so that the next
+// collective of each domain starts a new chain.
+void ResetAllReduceTokens(const torch::lazy::BackendDevice& device);
+
+// The token domain of the calling thread. Collectives are only ordered with
+// the other collectives of their domain, which lets XLA overlap the ones of
+// different domains. The default domain is the empty string.
+const std::string& GetTokenDomain();
+void SetTokenDomain(std::string domain);
+
+// Whether the all-reduces and reduce-scatters over all the replicas of more
+// than one host run as collectives within the hosts and across them, from
+// $XLA_HIERARCHICAL_COLLECTIVES.
+bool UseHierarchicalCollectives();
+
 AllReduceType GetReduceType(std::string_view reduce_type);
 
 }  // namespace torch_xla
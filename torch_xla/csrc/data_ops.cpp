@@ -260,8 +260,19 @@ xla::XlaOp BuildUnsqueeze(xla::XlaOp input, int64_t dim) {
 }
 
 xla::XlaOp BuildStack(absl::Span<const xla::XlaOp> inputs, int64_t dim) {
-  // Reshape inputs along the dim axis.
   XLA_CHECK_GT(inputs.size(), 0);
+  const xla::Shape& first_shape = ShapeHelper::ShapeOfXlaOp(inputs[0]);
+  if (first_shape.is_static() &&
+      dim < static_cast<int64_t>(first_shape.dimensions().size())) {
+    // Concatenating along `dim` lays the inputs out one after the other, so a
+    // single reshape splitting `dim` stacks them, rather than one per input.
+    std::vector<int64_t> output_sizes(first_shape.dimensions().begin(),
+                                      first_shape.dimensions().end());
+    output_sizes.insert(output_sizes.begin() + dim, inputs.size());
+    return xla::Reshape(xla::ConcatInDim(inputs[0].builder(), inputs, dim),
+                        output_sizes);
+  }
+  // Reshape inputs along the dim axis.
   std::vector<xla::XlaOp> reshaped_inputs;
   for (size_t i = 0; i < inputs.size(); ++i) {
     const xla::XlaOp& input = inputs[i];
@@ -354,6 +365,25 @@ xla::XlaOp BuildUpdateSlice(xla::XlaOp input, xla::XlaOp source,
   return xla::DynamicUpdateSlice(input, reshaped_source, start_indices);
 }
 
+xla::XlaOp BuildDynamicUpdateSlice(xla::XlaOp input, xla::XlaOp source,
+                                   xla::XlaOp start_indices) {
+  const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
+  const xla::Shape& source_shape = ShapeHelper::ShapeOfXlaOp(source);
+  xla::XlaOp update_source = source;
+  if (source_shape.element_type() != input_shape.element_type()) {
+    update_source = ConvertTo(source, source_shape.element_type(),
+                              input_shape.element_type());
+  }
+  xla::XlaOp reshaped_source =
+      XlaHelpers::ReshapeToRank(update_source, input_shape.dimensions_size());
+  std::vector<xla::XlaOp> indices;
+  for (int64_t dim = 0; dim < input_shape.dimensions_size(); ++dim) {
+    indices.push_back(
+        xla::Reshape(xla::SliceInDim(start_indices, dim, dim + 1, 1, 0), {}));
+  }
+  return xla::DynamicUpdateSlice(input, reshaped_source, indices);
+}
+
 xla::XlaOp BuildSlice(xla::XlaOp input, absl::Span<const int64_t> base_indices,
                       absl::Span<const int64_t> sizes) {
   XLA_CHECK_EQ(base_indices.size(), sizes.size());
@@ -89,6 +89,11 @@ std::vector<xla::XlaOp> BuildSplit(xla::XlaOp input,
 xla::XlaOp BuildUpdateSlice(xla::XlaOp input, xla::XlaOp source,
                             absl::Span<const int64_t> base_indices);
 
+// Like BuildUpdateSlice(), with the base indices read from the rank 1 integer
+// tensor start_indices. XLA clamps them so that source fits in input.
+xla::XlaOp BuildDynamicUpdateSlice(xla::XlaOp input, xla::XlaOp source,
+                                   xla::XlaOp start_indices);
+
 xla::XlaOp BuildSlice(xla::XlaOp input, absl::Span<const int64_t> base_indices,
                       absl::Span<const int64_t> sizes);
 
@@ -1,7 +1,11 @@
 #include "torch_xla/csrc/debug_util.h"
 
+#include <algorithm>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <regex>
 #include <sstream>
@@ -54,6 +58,63 @@ std::unordered_set<std::string>* LoadExperiments() {
   return xset.release();
 }
 
+// The structure of a node of a compiled graph: its op, attributes and shape.
+struct NodeFingerprint {
+  torch::lazy::hash_t hash;
+  std::string op;
+  std::string shape;
+  std::string text;
+};
+
+// The structure of a compiled graph, in post order, kept to tell what changed
+// when a later graph needs a new compilation.
+struct GraphFingerprint {
+  torch::lazy::hash_t hash;
+  std::vector<NodeFingerprint> nodes;
+};
+
+GraphFingerprint CreateGraphFingerprint(
+    torch::lazy::hash_t graph_hash,
+    absl::Span<const torch::lazy::Node* const> post_order) {
+  GraphFingerprint fingerprint;
+  fingerprint.hash = graph_hash;
+  fingerprint.nodes.reserve(post_order.size());
+  for (const torch::lazy::Node* node : post_order) {
+    NodeFingerprint& node_fingerprint = fingerprint.nodes.emplace_back();
+    node_fingerprint.op = node->op().ToString();
+    const XlaNode* xla_node = dynamic_cast<const XlaNode*>(node);
+    if (xla_node != nullptr) {
+      node_fingerprint.shape = xla_node->xla_shape().ToString();
+      // The node hash covers the op and its attributes, like the values of
+      // the scalars, but not always the shape.
+      node_fingerprint.hash =
+          torch::lazy::HashCombine(xla_node->node_hash(),
+                                   torch::lazy::Hash(node_fingerprint.shape));
+    } else {
+      node_fingerprint.hash = node->op().hash();
+    }
+    node_fingerprint.text = node->ToString();
+  }
+  return fingerprint;
+}
+
+// Number of nodes which differ between two graphs, compared position by
+// position, and the position of the first one.
+std::pair<size_t, size_t> DiffGraphFingerprints(const GraphFingerprint& lhs,
+                                                const GraphFingerprint& rhs) {
+  size_t common_size = std::min(lhs.nodes.size(), rhs.nodes.size());
+  size_t diff_count =
+      std::max(lhs.nodes.size(), rhs.nodes.size()) - common_size;
+  size_t first_diff = common_size;
+  for (size_t i = 0; i < common_size; ++i) {
+    if (lhs.nodes[i].hash != rhs.nodes[i].hash) {
+      first_diff = std::min(first_diff, i);
+      ++diff_count;
+    }
+  }
+  return {diff_count, first_diff};
+}
+
 }  // namespace
 
 DebugUtil::GraphFormat DebugUtil::GetDefaultGraphFormat() {
@@ -92,7 +153,12 @@ std::string DebugUtil::GetTensorsGraphHlo(
 std::string DebugUtil::GetTensorsGraphInfo(
     absl::Span<const XLATensorPtr> tensors, const std::vector<size_t>* indices,
     GraphFormat format) {
-  std::vector<const torch::lazy::Node*> root_nodes;
+  return CaptureTensorsGraphInfo(tensors, indices, format)();
+}
+
+std::function<std::string()> DebugUtil::CaptureTensorsGraphInfo(
+    absl::Span<const XLATensorPtr> tensors, const std::vector<size_t>* indices,
+    GraphFormat format) {
   std::vector<torch::lazy::Value> root_values;
   std::vector<torch::lazy::hash_t> root_hashes;
   torch::lazy::Unique<torch::lazy::BackendDevice> unique_device;
@@ -101,7 +167,6 @@ std::string DebugUtil::GetTensorsGraphInfo(
       const XLATensorPtr& tensor = tensors[index];
       torch::lazy::Value ir_value = tensor->CurrentIrValue();
       if (ir_value) {
-        root_nodes.push_back(ir_value.node.get());
         root_hashes.push_back(ir_value.hash());
         root_values.push_back(std::move(ir_value));
         unique_device.set(tensor->GetDevice());
@@ -111,7 +176,6 @@ std::string DebugUtil::GetTensorsGraphInfo(
     for (auto& tensor : tensors) {
       torch::lazy::Value ir_value = tensor->CurrentIrValue();
       if (ir_value) {
-        root_nodes.push_back(ir_value.node.get());
         root_hashes.push_back(ir_value.hash());
         root_values.push_back(std::move(ir_value));
         unique_device.set(tensor->GetDevice());
@@ -140,26 +204,36 @@ std::string DebugUtil::GetTensorsGraphInfo(
     ss << torch::lazy::HashToString(root_hashes[i]);
   }
   ss << ")\n";
-
-  std::string graph_str;
-  if (format == GraphFormat::kText) {
-    graph_str = DumpUtil::ToText(root_nodes);
-  } else if (format == GraphFormat::kDot) {
-    graph_str = DumpUtil::ToDot(root_nodes);
-  } else if (format == GraphFormat::kHlo) {
-    graph_str = DumpUtil::ToHlo(root_values, unique_device
-                                                 ? *unique_device
-                                                 : bridge::GetCurrentDevice());
-  } else if (format == GraphFormat::kStableHlo) {
-    graph_str = DumpUtil::ToHlo(
-        root_values,
-        unique_device ? *unique_device : bridge::GetCurrentDevice(),
-        EmitMode::kStableHloReadable);
-  } else {
-    XLA_ERROR() << "Invalid graph format: " << format;
+  ss << "\n## BEGIN_GRAPH\n";
+  std::string header = ss.str();
+
+  if (format == GraphFormat::kText || format == GraphFormat::kDot) {
+    return [header = std::move(header), root_values = std::move(root_values),
+            format]() {
+      std::vector<const torch::lazy::Node*> root_nodes;
+      root_nodes.reserve(root_values.size());
+      for (const torch::lazy::Value& ir_value : root_values) {
+        root_nodes.push_back(ir_value.node.get());
+      }
+      return header + (format == GraphFormat::kText
+                           ? DumpUtil::ToText(root_nodes)
+                           : DumpUtil::ToDot(root_nodes));
+    };
+  }
+  if (format == GraphFormat::kHlo || format == GraphFormat::kStableHlo) {
+    // The lowering needs the device data of the graph, which may be donated
+    // once the graph runs, so only the emission of the text is deferred.
+    auto computation =
+        std::make_shared<const xla::XlaComputation>(DumpUtil::ToXlaComputation(
+            root_values,
+            unique_device ? *unique_device : bridge::GetCurrentDevice()));
+    EmitMode mode = format == GraphFormat::kHlo ? EmitMode::kHloReadable
+                                                : EmitMode::kStableHloReadable;
+    return [header = std::move(header), computation, mode]() {
+      return header + DumpUtil::EmitComputation(*computation, mode);
+    };
   }
-  ss << "\n## BEGIN_GRAPH\n" << graph_str;
-  return ss.str();
+  XLA_ERROR() << "Invalid graph format: " << format;
 }
 
 void DebugUtil::SaveTensorsGraphInfo(const char* name,
@@ -513,4 +587,128 @@ void DebugUtil::post_compilation_analysis(
   }
 }
 
+void DebugUtil::analyze_recompilation(
+    torch::lazy::hash_t graph_hash,
+    absl::Span<const torch::lazy::Node* const> post_order) {
+  static const int pt_xla_debug_level = GetDebugLevel();
+  static const bool is_master_process =
+      (runtime::sys_util::GetEnvInt("PJRT_LOCAL_PROCESS_RANK", 0) == 0);
+  static const std::string debug_file_name =
+      runtime::sys_util::GetEnvString("PT_XLA_DEBUG_FILE", "");
+  static const int64_t max_frame_count =
+      runtime::sys_util::GetEnvInt("PT_XLA_DEBUG_MAX_FRAME", 8);
+  static const size_t max_graph_count = runtime::sys_util::GetEnvInt(
+      "PT_XLA_DEBUG_MAX_RECOMPILATION_GRAPHS", 16);
+  if (pt_xla_debug_level <= 0 || !is_master_process ||
+      max_graph_count == 0 || XLAGraphExecutor::Get()->UseEagerMode()) {
+    return;
+  }
+
+  static std::mutex mutex;
+  static std::deque<GraphFingerprint>* graphs =
+      new std::deque<GraphFingerprint>();
+  GraphFingerprint fingerprint = CreateGraphFingerprint(graph_hash, post_order);
+  std::lock_guard<std::mutex> lock(mutex);
+  // The most recent graph wins the ties.
+  const GraphFingerprint* closest = nullptr;
+  std::pair<size_t, size_t> closest_diff;
+  for (auto it = graphs->rbegin(); it != graphs->rend(); ++it) {
+    std::pair<size_t, size_t> diff = DiffGraphFingerprints(*it, fingerprint);
+    if (closest == nullptr || diff.first < closest_diff.first) {
+      closest = &*it;
+      closest_diff = diff;
+    }
+  }
+
+  std::stringstream ss;
+  if (closest != nullptr) {
+    constexpr std::string_view debug_output_prefix =
+        "Recompilation Analysis: ";
+    auto [diff_count, first_diff] = closest_diff;
+    ss << "\n"
+       << debug_output_prefix
+       << "=================================================================="
+          "=============="
+       << "\n";
+    ss << debug_output_prefix << "Graph "
+       << torch::lazy::HashToString(graph_hash)
+       << " is closest to the previously compiled graph "
+       << torch::lazy::HashToString(closest->hash) << "\n";
+    ss << debug_output_prefix << "  " << diff_count << " of "
+       << fingerprint.nodes.size() << " nodes differ, the first one is node "
+       << first_diff << "\n";
+    const NodeFingerprint* before = first_diff < closest->nodes.size()
+                                        ? &closest->nodes[first_diff]
+                                        : nullptr;
+    const NodeFingerprint* now = first_diff < fingerprint.nodes.size()
+                                     ? &fingerprint.nodes[first_diff]
+                                     : nullptr;
+    if (before != nullptr && now != nullptr) {
+      if (before->op != now->op) {
+        ss << debug_output_prefix << "  Different op: " << before->op
+           << " became " << now->op << "\n";
+      } else if (before->shape != now->shape) {
+        ss << debug_output_prefix << "  Different shape of " << now->op << ": "
+           << before->shape << " became " << now->shape << "\n";
+      } else {
+        ss << debug_output_prefix << "  Different attributes of " << now->op
+           << ", like the value of a scalar\n";
+      }
+    } else {
+      ss << debug_output_prefix << "  The graph has "
+         << fingerprint.nodes.size() << " nodes instead of "
+         << closest->nodes.size() << "\n";
+    }
+    if (before != nullptr) {
+      ss << debug_output_prefix << "  Before: " << before->text << "\n";
+    }
+    if (now != nullptr) {
+      ss << debug_output_prefix << "  Now: " << now->text << "\n";
+    }
+    // The frame which created the node is only known with XLA_IR_DEBUG.
+    std::vector<torch::lazy::SourceLocation> frames;
+    if (now != nullptr) {
+      frames = post_order[first_diff]->metadata().frame_info;
+    }
+    if (frames.empty()) {
+      ss << debug_output_prefix
+         << "Python Frame Triggered Compilation (set XLA_IR_DEBUG=1 for the "
+            "one which created the node): \n";
+      frames = torch::lazy::GetPythonFrames();
+    } else {
+      ss << debug_output_prefix << "Python Frame Created Node: \n";
+    }
+    int64_t remain_frame_count = max_frame_count;
+    for (auto& location : frames) {
+      if (--remain_frame_count < 0) {
+        ss << debug_output_prefix << "  ..........\n";
+        break;
+      }
+      ss << debug_output_prefix << "  " << location.function << " ("
+         << location.file << ":" << location.line << ")\n";
+    }
+    ss << debug_output_prefix
+       << "=================================================================="
+          "=============="
+       << "\n";
+  }
+
+  if (graphs->size() >= max_graph_count) {
+    graphs->pop_front();
+  }
+  graphs->push_back(std::move(fingerprint));
+
+  if (ss.tellp() == 0) {
+    return;
+  }
+  if (debug_file_name == "") {
+    // print to stderr by default
+    std::cerr << ss.str();
+  } else {
+    std::ofstream outFile;
+    outFile.open(debug_file_name, std::ios_base::app);
+    outFile << ss.rdbuf();
+  }
+}
+
 }  // namespace torch_xla
@@ -1,6 +1,7 @@
 #ifndef XLA_TORCH_XLA_CSRC_DEBUG_UTIL_H_
 #define XLA_TORCH_XLA_CSRC_DEBUG_UTIL_H_
 
+#include <functional>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -42,6 +43,16 @@ class DebugUtil {
       const std::vector<size_t>* indices,
       GraphFormat format = GetDefaultGraphFormat());
 
+  // Captures the report of GetTensorsGraphInfo() and returns the function
+  // rendering it, so that only the reports which are read are rendered. The
+  // Python frames and, for the HLO formats, the lowered computation are
+  // captured right away. The text and dot formats keep the IR of the tensors
+  // alive until the function is released.
+  static std::function<std::string()> CaptureTensorsGraphInfo(
+      absl::Span<const XLATensorPtr> tensors,
+      const std::vector<size_t>* indices,
+      GraphFormat format = GetDefaultGraphFormat());
+
   // If the environment variable XLA_SAVE_TENSORS_FILE is set to the proper
   // output path, an instance of the report returned by GetTensorsGraphInfo() is
   // saved.
@@ -65,6 +76,13 @@ class DebugUtil {
 
   static void post_compilation_analysis(
       runtime::ComputationClient::ComputationPtr computation);
+
+  // Compares the graph of `graph_hash`, about to be compiled, with the graphs
+  // compiled before it, and reports the closest one along with the first node
+  // which differs between them and the Python frame which created it.
+  static void analyze_recompilation(
+      torch::lazy::hash_t graph_hash,
+      absl::Span<const torch::lazy::Node* const> post_order);
 };
 
 }  // namespace torch_xla
@@ -0,0 +1,143 @@
+#include "torch_xla/csrc/device_prefetcher.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "tsl/platform/env.h"
+#include "tsl/profiler/lib/traceme.h"
+
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/tensor_util.h"
+
+namespace torch_xla {
+namespace {
+
+std::string GetXlaDevice(const std::string& device) {
+  return bridge::AtenDeviceToXlaDevice(c10::Device(device)).toString();
+}
+
+}  // namespace
+
+DevicePrefetcher::DevicePrefetcher(std::string device, size_t max_in_flight,
+                                   size_t num_threads)
+    : device_(GetXlaDevice(device)),
+      max_in_flight_(std::max<size_t>(max_in_flight, 1)) {
+  num_threads = std::max<size_t>(num_threads, 1);
+  pool_ = std::make_unique<tsl::thread::ThreadPool>(
+      tsl::Env::Default(), "pytorchxla_prefetch", num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    pool_->Schedule([this]() { Run(); });
+  }
+}
+
+DevicePrefetcher::~DevicePrefetcher() {
+  Close();
+  pool_.reset();
+}
+
+bool DevicePrefetcher::Enqueue(
+    std::vector<at::Tensor> tensors,
+    std::vector<XLATensor::ShardingSpecPtr> shardings) {
+  auto batch = std::make_shared<Batch>();
+  batch->tensors = std::move(tensors);
+  batch->shardings = std::move(shardings);
+  std::unique_lock<std::mutex> lock(lock_);
+  cv_.wait(lock, [&]() {
+    return closed_ || write_closed_ || batches_.size() < max_in_flight_;
+  });
+  if (closed_ || write_closed_) {
+    return false;
+  }
+  batches_.push_back(batch);
+  pending_.push_back(std::move(batch));
+  cv_.notify_all();
+  return true;
+}
+
+std::optional<std::vector<at::Tensor>> DevicePrefetcher::Dequeue() {
+  std::shared_ptr<Batch> batch;
+  {
+    std::unique_lock<std::mutex> lock(lock_);
+    cv_.wait(lock, [&]() {
+      return closed_ || (batches_.empty() && write_closed_) ||
+             (!batches_.empty() && batches_.front()->uploaded);
+    });
+    if (closed_ || batches_.empty()) {
+      return std::nullopt;
+    }
+    batch = std::move(batches_.front());
+    batches_.pop_front();
+    cv_.notify_all();
+  }
+  if (batch->error != nullptr) {
+    std::rethrow_exception(batch->error);
+  }
+  return std::move(batch->tensors);
+}
+
+void DevicePrefetcher::CloseWrite() {
+  std::lock_guard<std::mutex> lock(lock_);
+  write_closed_ = true;
+  cv_.notify_all();
+}
+
+void DevicePrefetcher::Close() {
+  std::lock_guard<std::mutex> lock(lock_);
+  closed_ = true;
+  batches_.clear();
+  pending_.clear();
+  cv_.notify_all();
+}
+
+void DevicePrefetcher::Run() {
+  while (true) {
+    std::shared_ptr<Batch> batch;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      cv_.wait(lock, [&]() { return closed_ || !pending_.empty(); });
+      if (closed_) {
+        return;
+      }
+      batch = std::move(pending_.front());
+      pending_.pop_front();
+    }
+    // The exceptions cannot cross the thread pool boundary, so they are
+    // captured and re-thrown to the consumer of the batch.
+    try {
+      Upload(batch.get());
+    } catch (...) {
+      batch->error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(lock_);
+    batch->uploaded = true;
+    cv_.notify_all();
+  }
+}
+
+void DevicePrefetcher::Upload(Batch* batch) const {
+  tsl::profiler::TraceMe activity("DevicePrefetcher::Upload",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  std::vector<std::string> devices(batch->tensors.size(), device_);
+  std::vector<torch::lazy::BackendDataPtr> data =
+      batch->shardings.empty()
+          ? CreateTensorsData(batch->tensors, devices)
+          : CreateTensorsData(batch->tensors, batch->shardings, devices);
+  std::vector<at::Tensor> results;
+  results.reserve(data.size());
+  for (size_t i = 0; i < data.size(); ++i) {
+    XLATensorPtr xla_tensor = XLATensor::Create(std::move(data[i]));
+    if (!batch->shardings.empty() && batch->shardings[i] != nullptr) {
+      xla_tensor->SetShardingSpec(*batch->shardings[i]);
+    }
+    results.push_back(torch::autograd::make_variable(
+        bridge::AtenFromXlaTensor(std::move(xla_tensor)),
+        /*requires_grad=*/batch->tensors[i].requires_grad()));
+  }
+  batch->tensors = std::move(results);
+  TORCH_LAZY_COUNTER("DevicePrefetcherBatches", 1);
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,84 @@
+#ifndef XLA_TORCH_XLA_CSRC_DEVICE_PREFETCHER_H_
+#define XLA_TORCH_XLA_CSRC_DEVICE_PREFETCHER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ATen/Tensor.h>
+
+#include "tsl/platform/threadpool.h"
+
+#include "torch_xla/csrc/tensor.h"
+
+namespace torch_xla {
+
+// Uploads batches of CPU tensors to a device from threads of its own, so that
+// the input pipeline feeding the device does not hold the GIL. At most
+// `max_in_flight` batches are uploading, or uploaded and waiting for their
+// consumer, at any time. The batches are dequeued in the order they were
+// enqueued in, whichever thread uploads them.
+class DevicePrefetcher {
+ public:
+  DevicePrefetcher(std::string device, size_t max_in_flight,
+                   size_t num_threads);
+
+  // Closes the prefetcher, and waits for the uploads in progress.
+  ~DevicePrefetcher();
+
+  // Schedules the upload of `tensors`, sharded by `shardings` if not empty,
+  // blocking while `max_in_flight` batches are in flight. Returns false, and
+  // drops the batch, if the prefetcher is closed.
+  bool Enqueue(std::vector<at::Tensor> tensors,
+               std::vector<XLATensor::ShardingSpecPtr> shardings);
+
+  // Returns the device tensors of the oldest batch, blocking until it is
+  // uploaded, or std::nullopt once the prefetcher is closed, or closed for
+  // writing and drained. Rethrows the error of a failed upload.
+  std::optional<std::vector<at::Tensor>> Dequeue();
+
+  // Lets the batches in flight be dequeued, but no more be enqueued.
+  void CloseWrite();
+
+  // Drops the batches in flight, and unblocks the Enqueue() and Dequeue()
+  // callers.
+  void Close();
+
+  size_t max_in_flight() const { return max_in_flight_; }
+
+ private:
+  struct Batch {
+    std::vector<at::Tensor> tensors;
+    std::vector<XLATensor::ShardingSpecPtr> shardings;
+    bool uploaded = false;
+    std::exception_ptr error;
+  };
+
+  // Uploads the pending batches until the prefetcher is closed.
+  void Run();
+
+  void Upload(Batch* batch) const;
+
+  const std::string device_;
+  const size_t max_in_flight_;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  // The batches in flight, in enqueue order.
+  std::deque<std::shared_ptr<Batch>> batches_;
+  // The batches no thread picked up yet, in enqueue order.
+  std::deque<std::shared_ptr<Batch>> pending_;
+  bool write_closed_ = false;
+  bool closed_ = false;
+  // Destroyed first, which joins the threads running Run().
+  std::unique_ptr<tsl::thread::ThreadPool> pool_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_DEVICE_PREFETCHER_H_
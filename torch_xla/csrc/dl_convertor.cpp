@@ -1,10 +1,12 @@
 #include "torch_xla/csrc/dl_convertor.h"
 
 #include <memory>
+#include <optional>
 #include <utility>
 #include <vector>
 
 #include <ATen/DLConvertor.h>
+#include <torch/csrc/lazy/core/metrics.h>
 
 #include "absl/log/absl_check.h"
 #include "absl/status/status.h"
@@ -53,6 +55,9 @@ DLDeviceType DLDeviceTypeForDevice(const xla::PjRtDevice& device) {
   if (device.client()->platform_id() == xla::CpuId()) {
     return DLDeviceType::kDLCPU;
   }
+  if (device.client()->platform_id() == xla::CudaId()) {
+    return DLDeviceType::kDLCUDA;
+  }
   XLA_ERROR() << "Device " << device.DebugString()
               << " cannot be used as a DLPack device.";
 }
@@ -119,7 +124,8 @@ std::vector<int64_t> StridesForShape(xla::PrimitiveType element_type,
 }
 
 // Convert an XLA tensor to a dlPack tensor.
-DLManagedTensor* toDLPack(const at::Tensor& input) {
+DLManagedTensor* toDLPack(const at::Tensor& input,
+                          std::optional<std::intptr_t> stream) {
   ABSL_CHECK(bridge::IsXlaTensor(input)) << "The input should be an XLA tensor";
   std::shared_ptr<runtime::ComputationClient::Data> handle =
       get_data_handle(input);
@@ -143,8 +149,15 @@ DLManagedTensor* toDLPack(const at::Tensor& input) {
     // AcquireExternalReference may block
     XLA_ASSIGN_OR_THROW(pack->external_reference,
                         pjrt_buffer->AcquireExternalReference());
-    xla::PjRtFuture<> future = pjrt_buffer->GetReadyFuture();
-    XLA_THROW_IF_ERROR(future.Await());
+    if (stream && pjrt_buffer->client()->platform_id() == xla::CudaId()) {
+      if (*stream != -1) {
+        XLA_THROW_IF_ERROR(
+            pack->external_reference->WaitUntilBufferReadyOnStream(*stream));
+      }
+    } else {
+      xla::PjRtFuture<> future = pjrt_buffer->GetReadyFuture();
+      XLA_THROW_IF_ERROR(future.Await());
+    }
   }
   pack->buffer_reference = pjrt_buffer;
 
@@ -171,11 +184,23 @@ DLManagedTensor* toDLPack(const at::Tensor& input) {
 // Reference: https://github.com/openxla/xla/blob/main/xla/python/dlpack.cc
 absl::StatusOr<xla::PjRtDevice*> DeviceForDLDevice(const DLDevice& context) {
   switch (context.device_type) {
-    case DLDeviceType::kDLCPU: {
+    case DLDeviceType::kDLCPU:
+    case DLDeviceType::kDLCUDAHost: {
+      XLA_ASSIGN_OR_RETURN(
+          runtime::ComputationClient * absl_nonnull const client,
+          runtime::GetComputationClient());
+      if (client->GetPlatformID() == xla::CpuId()) {
+        return client->LookupAddressableDevice(context.device_id);
+      }
+      // The host memory goes to a host memory space of the current device.
+      return client->LookupAddressableDevice(
+          bridge::GetCurrentDevice().ordinal());
+    }
+    case DLDeviceType::kDLCUDA: {
       XLA_ASSIGN_OR_RETURN(
           runtime::ComputationClient * absl_nonnull const client,
           runtime::GetComputationClient());
-      XLA_CHECK_EQ(client->GetPlatformID(), xla::CpuId());
+      XLA_CHECK_EQ(client->GetPlatformID(), xla::CudaId());
       return client->LookupAddressableDevice(context.device_id);
     }
     default:
@@ -299,6 +324,51 @@ absl::StatusOr<std::vector<int64_t>> StridesToLayout(
   return minor_to_major;
 }
 
+// Returns the memory space of `device` whose buffers may alias host memory,
+// or nullptr if it has none.
+xla::PjRtMemorySpace* HostMemorySpace(xla::PjRtDevice* device) {
+  if (device->client()->platform_id() == xla::CpuId()) {
+    return *device->default_memory_space();
+  }
+  xla::PjRtMemorySpace* host_space = nullptr;
+  for (xla::PjRtMemorySpace* memory_space : device->memory_spaces()) {
+    if (memory_space->kind() == "pinned_host") {
+      return memory_space;
+    } else if (memory_space->kind() == "unpinned_host") {
+      host_space = memory_space;
+    }
+  }
+  return host_space;
+}
+
+// Creates a buffer over the host memory of `dlmt`, which it keeps until the
+// buffer is deleted. The buffer aliases the memory when its layout and
+// alignment allow it, and copies it otherwise.
+absl::StatusOr<std::unique_ptr<xla::PjRtBuffer>> BufferFromHostDLPack(
+    DLManagedTensor* dlmt, xla::PrimitiveType element_type,
+    xla::PjRtMemorySpace* memory_space) {
+  const DLTensor& dt = dlmt->dl_tensor;
+  absl::Span<int64_t const> dimensions(const_cast<int64_t*>(dt.shape),
+                                       dt.ndim);
+  std::vector<int64_t> strides;
+  std::optional<absl::Span<int64_t const>> byte_strides;
+  if (dt.strides) {
+    for (int64_t i = 0; i < dt.ndim; ++i) {
+      strides.push_back(dt.strides[i] * (dt.dtype.bits / 8));
+    }
+    byte_strides = strides;
+  }
+  return memory_space->client()->BufferFromHostBuffer(
+      static_cast<char*>(dt.data) + dt.byte_offset, element_type, dimensions,
+      byte_strides, xla::PjRtClient::HostBufferSemantics::kImmutableZeroCopy,
+      [dlmt]() {
+        if (dlmt->deleter) {
+          dlmt->deleter(dlmt);
+        }
+      },
+      memory_space, /*device_layout=*/nullptr);
+}
+
 at::Tensor fromDLPack(DLManagedTensor* dlmt) {
   ABSL_CHECK(dlmt->dl_tensor.ndim >= 0)
       << "Number of dimensions in DLManagedTensor must be nonnegative, got "
@@ -322,16 +392,33 @@ at::Tensor fromDLPack(DLManagedTensor* dlmt) {
   xla::Shape shape = xla::ShapeUtil::MakeShapeWithDenseLayout(
       element_type, dimensions, minor_to_major);
 
-  std::function<void()> on_delete_callback;
-  if (dlmt->deleter) {
-    on_delete_callback = [dlmt]() { dlmt->deleter(dlmt); };
+  std::unique_ptr<xla::PjRtBuffer> pjrt_buffer;
+  DLDeviceType device_type = dlmt->dl_tensor.device.device_type;
+  if (device_type == DLDeviceType::kDLCPU ||
+      device_type == DLDeviceType::kDLCUDAHost) {
+    // The host memory is imported with zero-copy semantics, which the CPU
+    // plugins support where they may not support views of device buffers.
+    xla::PjRtMemorySpace* host_space = HostMemorySpace(device);
+    XLA_CHECK(host_space != nullptr)
+        << "Device " << device->DebugString()
+        << " has no host memory space to import a host DLPack tensor into.";
+    XLA_ASSIGN_OR_THROW(pjrt_buffer,
+                        BufferFromHostDLPack(dlmt, element_type, host_space));
+    shape = xla::ShapeUtil::MakeShapeWithDescendingLayout(element_type,
+                                                          dimensions);
+    TORCH_LAZY_COUNTER("ZeroCopyDLPackImport", 1);
+  } else {
+    std::function<void()> on_delete_callback;
+    if (dlmt->deleter) {
+      on_delete_callback = [dlmt]() { dlmt->deleter(dlmt); };
+    }
+    XLA_ASSIGN_OR_THROW(
+        pjrt_buffer,
+        device->client()->CreateViewOfDeviceBuffer(
+            static_cast<char*>(dlmt->dl_tensor.data) +
+                dlmt->dl_tensor.byte_offset,
+            shape, *device->default_memory_space(), on_delete_callback));
   }
-  XLA_ASSIGN_OR_THROW(
-      std::unique_ptr<xla::PjRtBuffer> pjrt_buffer,
-      device->client()->CreateViewOfDeviceBuffer(
-          static_cast<char*>(dlmt->dl_tensor.data) +
-              dlmt->dl_tensor.byte_offset,
-          shape, *device->default_memory_space(), on_delete_callback));
   ABSL_CHECK(pjrt_buffer.get() != nullptr) << "pjrt buffer is null.";
 
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
@@ -4,9 +4,18 @@
 #include <ATen/Tensor.h>
 #include <ATen/dlpack.h>
 
+#include <cstdint>
+#include <optional>
+
 namespace torch_xla {
 
-DLManagedTensor* toDLPack(const at::Tensor& src);
+// Exports the buffer of `src`. Without a `stream`, blocks until the pending
+// computations writing it complete. On CUDA devices, with `stream`, a CUDA
+// stream of the consumer in the encoding of the DLPack protocol, returns right
+// away, and makes `stream` wait for the buffer instead; -1 skips any
+// synchronization, leaving it to the consumer.
+DLManagedTensor* toDLPack(const at::Tensor& src,
+                          std::optional<std::intptr_t> stream = std::nullopt);
 at::Tensor fromDLPack(DLManagedTensor* src);
 
 }  // namespace torch_xla
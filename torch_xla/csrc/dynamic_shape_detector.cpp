@@ -1,7 +1,10 @@
 #include "torch_xla/csrc/dynamic_shape_detector.h"
 
+#include <algorithm>
 #include <sstream>
 
+#include <torch/csrc/lazy/core/metrics.h>
+
 #include "torch_xla/csrc/runtime/debug_macros.h"
 
 namespace torch_xla {
@@ -271,4 +274,77 @@ bool TrieBuilder::MarkGraphBoundary(bool allow_new_graph) {
   return node_->MarkGraphBoundary(matched_, allow_new_graph);
 }
 
+ShapeBucketer* ShapeBucketer::Get() {
+  static ShapeBucketer* bucketer = new ShapeBucketer();
+  return bucketer;
+}
+
+void ShapeBucketer::SetBuckets(const std::string& name,
+                               std::vector<int64_t> buckets) {
+  std::sort(buckets.begin(), buckets.end());
+  std::lock_guard<std::mutex> lock(lock_);
+  sessions_[name].buckets = std::move(buckets);
+}
+
+int64_t ShapeBucketer::GetBucketSize(absl::Span<const int64_t> buckets,
+                                     int64_t size) {
+  if (buckets.empty()) {
+    int64_t bucket = 1;
+    while (bucket < size) {
+      bucket <<= 1;
+    }
+    return bucket;
+  }
+  auto it = std::lower_bound(buckets.begin(), buckets.end(), size);
+  if (it == buckets.end()) {
+    TORCH_LAZY_COUNTER("ShapeBucketingOverflow", 1);
+    return size;
+  }
+  return *it;
+}
+
+std::vector<int64_t> ShapeBucketer::GetBucketedSizes(
+    const std::string& name, std::size_t index,
+    absl::Span<const int64_t> sizes) {
+  std::lock_guard<std::mutex> lock(lock_);
+  SessionBuckets& session = sessions_[name];
+  if (session.inputs.size() <= index) {
+    session.inputs.resize(index + 1);
+  }
+  InputInfo& info = session.inputs[index];
+  if (info.sizes.size() != sizes.size()) {
+    // First call, or the rank changed: start over from these sizes.
+    info.sizes.assign(sizes.begin(), sizes.end());
+    info.dynamic.assign(sizes.size(), false);
+  }
+  std::vector<int64_t> bucketed(sizes.begin(), sizes.end());
+  int64_t num_elements = 1;
+  int64_t num_bucketed_elements = 1;
+  for (std::size_t dim = 0; dim < sizes.size(); ++dim) {
+    if (!info.dynamic[dim] && sizes[dim] != info.sizes[dim]) {
+      TF_VLOG(5) << "Session " << name << " input " << index << " dimension "
+                 << dim << " is dynamic: " << info.sizes[dim] << " vs "
+                 << sizes[dim];
+      info.dynamic[dim] = true;
+    }
+    if (info.dynamic[dim]) {
+      bucketed[dim] = GetBucketSize(session.buckets, sizes[dim]);
+    }
+    num_elements *= sizes[dim];
+    num_bucketed_elements *= bucketed[dim];
+  }
+  if (num_bucketed_elements != num_elements) {
+    TORCH_LAZY_COUNTER("ShapeBucketingPaddedInputs", 1);
+    TORCH_LAZY_COUNTER("ShapeBucketingPaddingElements",
+                       num_bucketed_elements - num_elements);
+  }
+  TORCH_LAZY_COUNTER("ShapeBucketingInputElements", num_elements);
+  return bucketed;
+}
+
+void ShapeBucketer::RemoveSessionIfExists(const std::string& name) {
+  std::lock_guard<std::mutex> lock(lock_);
+  sessions_.erase(name);
+}
+
 }  // namespace torch_xla
@@ -2,6 +2,10 @@
 #define XLA_TORCH_XLA_CSRC_DYNAMIC_SHAPE_DETECTOR_H_
 
 #include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <torch/csrc/lazy/core/hash.h>
 
@@ -245,6 +249,50 @@ class DynamicShapeDetector {
   TrieBuilder builder_;
 };
 
+// Bounds the number of graphs compiled for a session, by padding the input
+// dimensions that vary across its calls to the sizes of a bucket ladder.
+//
+// The first size seen for each input dimension is used as is. Once a
+// dimension takes a different size, it is considered dynamic and, from then
+// on, padded up to the smallest bucket that fits it. Sizes larger than the
+// last bucket of the ladder are not padded.
+class ShapeBucketer {
+ public:
+  static ShapeBucketer* Get();
+
+  // Sets the bucket ladder of the session named `name`. An empty ladder means
+  // powers of two.
+  void SetBuckets(const std::string& name, std::vector<int64_t> buckets);
+
+  // Records the sizes of the `index`-th input of the session named `name`,
+  // and returns the sizes it should be padded to.
+  std::vector<int64_t> GetBucketedSizes(const std::string& name,
+                                        std::size_t index,
+                                        absl::Span<const int64_t> sizes);
+
+  // Maybe removes the session entry.
+  void RemoveSessionIfExists(const std::string& name);
+
+ private:
+  // Sizes first seen for an input, and which of its dimensions vary.
+  struct InputInfo {
+    std::vector<int64_t> sizes;
+    std::vector<bool> dynamic;
+  };
+
+  struct SessionBuckets {
+    std::vector<int64_t> buckets;
+    std::vector<InputInfo> inputs;
+  };
+
+  // Returns the smallest bucket of the ladder that fits `size`.
+  static int64_t GetBucketSize(absl::Span<const int64_t> buckets,
+                               int64_t size);
+
+  std::mutex lock_;
+  std::unordered_map<std::string, SessionBuckets> sessions_;
+};
+
 }  // namespace torch_xla
 
 #endif  // XLA_TORCH_XLA_CSRC_DYNAMIC_SHAPE_DETECTOR_H_
@@ -0,0 +1,159 @@
+#include "torch_xla/csrc/einsum_path.h"
+
+#include <limits>
+#include <memory>
+#include <unordered_map>
+
+#include <torch/csrc/lazy/core/hash.h>
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+
+#include "torch_xla/csrc/runtime/cache.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+
+namespace torch_xla {
+namespace {
+
+using EinsumPathCache = runtime::util::Cache<torch::lazy::hash_t, EinsumPath,
+                                             torch::lazy::HashReducer>;
+
+EinsumPathCache* GetEinsumPathCache() {
+  static int64_t cache_size =
+      runtime::sys_util::GetEnvInt("XLA_EINSUM_PATH_CACHE_SIZE", 1024);
+  static EinsumPathCache* cache = new EinsumPathCache(cache_size);
+  return cache;
+}
+
+// The number of elements of a tensor with `labels`.
+double LabelsSize(const std::string& labels,
+                  const std::unordered_map<char, int64_t>& sizes) {
+  double size = 1;
+  for (char label : labels) {
+    size *= sizes.at(label);
+  }
+  return size;
+}
+
+// The labels of `lhs` and `rhs` which `needed` holds, in the order they first
+// appear in `lhs` then `rhs`.
+std::string ContractionLabels(const std::string& lhs, const std::string& rhs,
+                              const std::string& needed) {
+  std::string labels;
+  for (char label : lhs + rhs) {
+    if (needed.find(label) != std::string::npos &&
+        labels.find(label) == std::string::npos) {
+      labels.push_back(label);
+    }
+  }
+  return labels;
+}
+
+EinsumPath FindGreedyPath(std::vector<std::string> operands,
+                          const std::string& output,
+                          const std::unordered_map<char, int64_t>& sizes) {
+  EinsumPath path;
+  while (operands.size() > 1) {
+    size_t best_lhs = 0;
+    size_t best_rhs = 1;
+    std::string best_labels;
+    double best_cost = std::numeric_limits<double>::infinity();
+    double best_flops = std::numeric_limits<double>::infinity();
+    for (size_t i = 0; i < operands.size(); ++i) {
+      for (size_t j = i + 1; j < operands.size(); ++j) {
+        std::string labels;
+        if (operands.size() == 2) {
+          labels = output;
+        } else {
+          std::string needed = output;
+          for (size_t k = 0; k < operands.size(); ++k) {
+            if (k != i && k != j) {
+              needed += operands[k];
+            }
+          }
+          labels = ContractionLabels(operands[i], operands[j], needed);
+        }
+        double cost = LabelsSize(labels, sizes) -
+                      LabelsSize(operands[i], sizes) -
+                      LabelsSize(operands[j], sizes);
+        // The contraction multiplies once per combination of its labels.
+        std::string all_labels = operands[i] + operands[j];
+        double flops = LabelsSize(
+            ContractionLabels(operands[i], operands[j], all_labels), sizes);
+        if (cost < best_cost || (cost == best_cost && flops < best_flops)) {
+          best_lhs = i;
+          best_rhs = j;
+          best_labels = std::move(labels);
+          best_cost = cost;
+          best_flops = flops;
+        }
+      }
+    }
+    path.push_back(EinsumContraction{
+        best_lhs, best_rhs,
+        absl::StrCat(operands[best_lhs], ",", operands[best_rhs], "->",
+                     best_labels)});
+    operands.erase(operands.begin() + best_rhs);
+    operands.erase(operands.begin() + best_lhs);
+    operands.push_back(std::move(best_labels));
+  }
+  return path;
+}
+
+}  // namespace
+
+std::optional<EinsumPath> GetEinsumPath(
+    const std::string& equation,
+    absl::Span<const std::vector<int64_t>> shapes) {
+  if (shapes.size() < 3 || equation.find('.') != std::string::npos) {
+    return std::nullopt;
+  }
+  std::vector<std::string> sides = absl::StrSplit(equation, "->");
+  if (sides.size() != 2) {
+    return std::nullopt;
+  }
+  std::vector<std::string> operands = absl::StrSplit(sides[0], ',');
+  const std::string& output = sides[1];
+  if (operands.size() != shapes.size()) {
+    return std::nullopt;
+  }
+  std::unordered_map<char, int64_t> sizes;
+  for (size_t i = 0; i < operands.size(); ++i) {
+    const std::string& labels = operands[i];
+    if (labels.size() != shapes[i].size()) {
+      return std::nullopt;
+    }
+    std::unordered_map<char, int64_t> operand_sizes;
+    for (size_t dim = 0; dim < labels.size(); ++dim) {
+      if (!operand_sizes.emplace(labels[dim], shapes[i][dim]).second) {
+        return std::nullopt;
+      }
+      auto it = sizes.emplace(labels[dim], shapes[i][dim]).first;
+      if (it->second != shapes[i][dim]) {
+        return std::nullopt;
+      }
+    }
+  }
+  for (size_t i = 0; i < output.size(); ++i) {
+    if (sizes.count(output[i]) == 0 ||
+        output.find(output[i], i + 1) != std::string::npos) {
+      return std::nullopt;
+    }
+  }
+
+  torch::lazy::hash_t key = torch::lazy::MHash(equation);
+  for (const std::vector<int64_t>& shape : shapes) {
+    key = torch::lazy::HashCombine(key, torch::lazy::MHash(shape));
+  }
+  EinsumPathCache* cache = GetEinsumPathCache();
+  std::shared_ptr<EinsumPath> path = cache->Get(key);
+  if (path == nullptr) {
+    TORCH_LAZY_COUNTER("EinsumPathSearches", 1);
+    path = cache->Add(key, std::make_shared<EinsumPath>(
+                               FindGreedyPath(operands, output, sizes)));
+  }
+  return *path;
+}
+
+}  // namespace torch_xla
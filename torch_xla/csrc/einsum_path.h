@@ -0,0 +1,43 @@
+#ifndef XLA_TORCH_XLA_CSRC_EINSUM_PATH_H_
+#define XLA_TORCH_XLA_CSRC_EINSUM_PATH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+
+namespace torch_xla {
+
+// A contraction of two of the live operands of an einsum.
+struct EinsumContraction {
+  // The positions of the operands in the list of live operands, which starts
+  // as the einsum operands. Both are removed from the list, and the result is
+  // appended to it.
+  size_t lhs = 0;
+  size_t rhs = 0;
+  // The two operand equation computing the result. The result keeps the labels
+  // of the operands which a later contraction or the output needs, and the
+  // last result is the output of the einsum.
+  std::string equation;
+};
+
+using EinsumPath = std::vector<EinsumContraction>;
+
+// Finds the order in which the pairs of operands of an einsum of three or more
+// operands, with `shapes`, are contracted. The pair contracted at every step
+// is the one whose result shrinks the live operands the most, the greedy
+// strategy of opt_einsum, with the smallest number of multiplications as the
+// tie breaker. The paths are cached per equation and shapes. Returns
+// std::nullopt for the equations with no output, ellipses, repeated labels
+// within an operand, or labels of different sizes, which are left to the
+// upstream einsum.
+std::optional<EinsumPath> GetEinsumPath(
+    const std::string& equation,
+    absl::Span<const std::vector<int64_t>> shapes);
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_EINSUM_PATH_H_
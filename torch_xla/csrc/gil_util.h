@@ -0,0 +1,36 @@
+#ifndef XLA_TORCH_XLA_CSRC_GIL_UTIL_H_
+#define XLA_TORCH_XLA_CSRC_GIL_UTIL_H_
+
+#include <Python.h>
+
+namespace torch_xla {
+
+// Releases the GIL, if held, for the lifetime of the object.
+// HACK: The C++ code may be called outside of python (mainly in C++ tests) or
+// when the GIL is already released, so we must check both cases here. If
+// possible, prefer to release the GIL in the python bindings before copying
+// this pattern.
+class ScopedGilRelease {
+ public:
+  explicit ScopedGilRelease(bool release = true) {
+    if (release && Py_IsInitialized() && PyGILState_Check()) {
+      save_ = PyEval_SaveThread();
+    }
+  }
+
+  ~ScopedGilRelease() {
+    if (save_) {
+      PyEval_RestoreThread(save_);
+    }
+  }
+
+  ScopedGilRelease(const ScopedGilRelease&) = delete;
+  ScopedGilRelease& operator=(const ScopedGilRelease&) = delete;
+
+ private:
+  PyThreadState* save_ = nullptr;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_GIL_UTIL_H_
@@ -0,0 +1,124 @@
+#include "torch_xla/csrc/graph_split.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "torch_xla/csrc/ops/device_data.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+
+namespace torch_xla {
+namespace {
+
+bool IsLeaf(const torch::lazy::Node* node) { return node->operands().empty(); }
+
+}  // namespace
+
+size_t GetGraphSplitMaxNodes() {
+  static const size_t max_nodes =
+      runtime::sys_util::GetEnvInt("XLA_GRAPH_SPLIT_MAX_NODES", 0);
+  return max_nodes;
+}
+
+size_t GetGraphSplitMaxParameters() {
+  static const size_t max_parameters =
+      runtime::sys_util::GetEnvInt("XLA_GRAPH_SPLIT_MAX_PARAMETERS", 0);
+  return max_parameters;
+}
+
+std::vector<std::vector<const torch::lazy::Node*>> SplitPostOrder(
+    c10::ArrayRef<const torch::lazy::Node*> post_order,
+    c10::ArrayRef<const torch::lazy::Node*> roots, size_t max_nodes,
+    size_t max_parameters) {
+  std::vector<std::vector<const torch::lazy::Node*>> cuts;
+  if (max_nodes == 0 && max_parameters == 0) {
+    return cuts;
+  }
+  const size_t num_nodes = post_order.size();
+  std::unordered_map<const torch::lazy::Node*, size_t> positions;
+  positions.reserve(num_nodes);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    positions.emplace(post_order[i], i);
+  }
+  // The position of the last user of each node, past the end for the roots.
+  std::vector<size_t> last_use(num_nodes, 0);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    for (const torch::lazy::Output& operand : post_order[i]->operands()) {
+      size_t& use = last_use[positions.at(operand.node)];
+      use = std::max(use, i);
+    }
+  }
+  for (const torch::lazy::Node* root : roots) {
+    last_use[positions.at(root)] = num_nodes;
+  }
+  // The number of outputs of the nodes up to each position which are used
+  // after it, which a cut right after the position hands over.
+  std::vector<size_t> live(num_nodes, 0);
+  std::vector<size_t> deaths(num_nodes + 1, 0);
+  size_t num_live = 0;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    const torch::lazy::Node* node = post_order[i];
+    if (!IsLeaf(node) && last_use[i] > i) {
+      num_live += node->num_outputs();
+      deaths[last_use[i]] += node->num_outputs();
+    }
+    num_live -= deaths[i];
+    live[i] = num_live;
+  }
+
+  std::unordered_set<const torch::lazy::Node*> handed_over;
+  size_t start = 0;
+  while (start < num_nodes) {
+    // Finds the first node which does not fit in the piece.
+    size_t nodes = 0;
+    std::unordered_set<const torch::lazy::Node*> parameters;
+    size_t end = start;
+    for (; end < num_nodes; ++end) {
+      const torch::lazy::Node* node = post_order[end];
+      if (IsLeaf(node)) {
+        continue;
+      }
+      ++nodes;
+      for (const torch::lazy::Output& operand : node->operands()) {
+        if (DeviceData::Cast(operand.node) != nullptr ||
+            handed_over.count(operand.node) > 0) {
+          parameters.insert(operand.node);
+        }
+      }
+      if ((max_nodes > 0 && nodes > max_nodes) ||
+          (max_parameters > 0 && parameters.size() > max_parameters)) {
+        break;
+      }
+    }
+    if (end == num_nodes) {
+      // The rest of the graph makes the last piece.
+      break;
+    }
+    // A node which does not fit on its own makes a piece of its own.
+    end = std::max(end, start + 1);
+    size_t cut = start + (end - start - 1) / 2;
+    for (size_t i = cut + 1; i < end; ++i) {
+      if (live[i] <= live[cut]) {
+        cut = i;
+      }
+    }
+    // The nodes live across the cut from the previous pieces were handed over
+    // already, as they were live across the previous cut too.
+    std::vector<const torch::lazy::Node*> frontier;
+    for (size_t i = start; i <= cut; ++i) {
+      const torch::lazy::Node* node = post_order[i];
+      if (!IsLeaf(node) && last_use[i] > cut) {
+        frontier.push_back(node);
+        handed_over.insert(node);
+      }
+    }
+    if (!frontier.empty()) {
+      cuts.push_back(std::move(frontier));
+    }
+    start = cut + 1;
+  }
+  return cuts;
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,42 @@
+#ifndef XLA_TORCH_XLA_CSRC_GRAPH_SPLIT_H_
+#define XLA_TORCH_XLA_CSRC_GRAPH_SPLIT_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <c10/util/ArrayRef.h>
+#include <torch/csrc/lazy/core/ir.h>
+
+namespace torch_xla {
+
+// Returns the number of nodes, from $XLA_GRAPH_SPLIT_MAX_NODES, above which a
+// graph gets split into several executables. Zero, the default, does not
+// split the graphs on their size.
+size_t GetGraphSplitMaxNodes();
+
+// Returns the number of parameters, from $XLA_GRAPH_SPLIT_MAX_PARAMETERS,
+// above which a graph gets split into several executables. Zero, the default,
+// does not split the graphs on their parameters.
+size_t GetGraphSplitMaxParameters();
+
+// Cuts `post_order`, the post order of the graph of the `roots`, into pieces
+// of at most `max_nodes` nodes and `max_parameters` parameters each, zero not
+// bounding them. Returns, for every piece but the last one, the nodes which
+// the piece hands over to the next ones, in post order: the nodes of the
+// piece whose outputs the next pieces or the roots use. Returns no cut when
+// the graph fits in a single piece.
+//
+// Each piece ends at the node of its second half after which the fewest
+// outputs are live, so that the fewest tensors get materialized between the
+// pieces. The nodes without operands, like the device data and the constants,
+// are not counted as nodes, and are lowered again by every piece using them
+// rather than handed over; the device data count as parameters, as do the
+// nodes handed over by the previous pieces.
+std::vector<std::vector<const torch::lazy::Node*>> SplitPostOrder(
+    c10::ArrayRef<const torch::lazy::Node*> post_order,
+    c10::ArrayRef<const torch::lazy::Node*> roots, size_t max_nodes,
+    size_t max_parameters);
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_GRAPH_SPLIT_H_
@@ -51,7 +51,10 @@
 #include "torch_xla/csrc/aten_autograd_ops.h"
 #include "torch_xla/csrc/aten_fallback.h"
 #include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/autocast_mode.h"
+#include "torch_xla/csrc/checkpoint_loader.h"
 #include "torch_xla/csrc/device.h"
+#include "torch_xla/csrc/device_prefetcher.h"
 #include "torch_xla/csrc/dl_convertor.h"
 #include "torch_xla/csrc/dtype.h"
 #include "torch_xla/csrc/dynamic_shape_detector.h"
@@ -59,8 +62,11 @@
 #include "torch_xla/csrc/ir.h"
 #include "torch_xla/csrc/ir_dump_util.h"
 #include "torch_xla/csrc/layout_manager.h"
+#include "torch_xla/csrc/memory_sampler.h"
+#include "torch_xla/csrc/metrics_exporter.h"
 #include "torch_xla/csrc/ops/device_data.h"
 #include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/cache.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/env_vars.h"
 #include "torch_xla/csrc/runtime/metrics.h"
@@ -70,18 +76,23 @@
 #include "torch_xla/csrc/runtime/pjrt_registry.h"
 #include "torch_xla/csrc/runtime/profiler.h"
 #include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/snapshot.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/timeline.h"
 #include "torch_xla/csrc/runtime/util.h"
 #include "torch_xla/csrc/runtime/xla_coordinator.h"
 #include "torch_xla/csrc/runtime/xla_util.h"
 #include "torch_xla/csrc/shape_helper.h"
+#include "torch_xla/csrc/sharded_batch.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/tensor_impl.h"
 #include "torch_xla/csrc/tensor_methods.h"
 #include "torch_xla/csrc/tensor_util.h"
 #include "torch_xla/csrc/torch_util.h"
+#include "torch_xla/csrc/trace_profiler.h"
 #include "torch_xla/csrc/version.h"
 #include "torch_xla/csrc/xla_backend_impl.h"
+#include "torch_xla/csrc/xla_generator.h"
 #include "torch_xla/csrc/xla_graph_executor.h"
 #include "torch_xla/csrc/xla_op_builder.h"
 #include "torch_xla/csrc/xla_sharding_util.h"
@@ -275,7 +286,7 @@ void PrepareToExit() {
       runtime::GetComputationClientIfInitialized();
   if (client != nullptr) {
     auto xla_device = GetDeviceOrCurrent("");
-    SetAllReduceToken(xla_device, nullptr);
+    ResetAllReduceTokens(xla_device);
     WaitDeviceOps();
   }
 }
@@ -350,6 +361,19 @@ std::vector<std::vector<int64_t>> CreateReduceGroups(const py::list& groups) {
   return replica_groups;
 }
 
+// The gathered parameters and the optional gradient norm of a ZeRO optimizer
+// step, as Python values.
+std::tuple<std::vector<at::Tensor>, std::optional<at::Tensor>>
+ZeroOptimizerStepResults(
+    const std::pair<std::vector<XLATensorPtr>, XLATensorPtr>& results) {
+  std::optional<at::Tensor> grad_norm;
+  if (results.second != nullptr) {
+    grad_norm = bridge::AtenFromXlaTensor(results.second);
+  }
+  return std::make_tuple(bridge::AtenFromXlaTensors(results.first),
+                         std::move(grad_norm));
+}
+
 std::vector<std::vector<int>> ExtractXlaDotGeneralDimVectors(
     const py::tuple& dimension_numbers) {
   // Expect Python arg `dimension_numbers` to be
@@ -414,28 +438,51 @@ std::vector<std::pair<int64_t, int64_t>> CreateSourceTargetPairs(
   return source_target_pairs;
 }
 
+std::optional<xla::PrimitiveType> GetReduceElementType(
+    const std::optional<py::object>& reduce_dtype) {
+  if (!reduce_dtype.has_value() || reduce_dtype->is_none()) {
+    return std::nullopt;
+  }
+  return XlaTypeFromTorchType(
+      reinterpret_cast<THPDtype*>(reduce_dtype->ptr())->scalar_type);
+}
+
 void AllReduceInPlace(const std::string& reduce_type,
                       const std::vector<at::Tensor>& tensors, double scale,
                       const std::vector<std::vector<int64_t>>& replica_groups,
-                      bool pin_layout) {
+                      bool pin_layout,
+                      std::optional<xla::PrimitiveType> reduce_element_type,
+                      const std::vector<at::Tensor>& residuals) {
   TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
   XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xtensors,
                       bridge::GetXlaTensors(tensors));
-  tensor_methods::all_reduce(xtensors, GetReduceType(reduce_type), scale,
-                             replica_groups, pin_layout);
+  XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xresiduals,
+                      bridge::GetXlaTensors(residuals));
+  tensor_methods::all_reduce(
+      xtensors, GetReduceType(reduce_type), scale, replica_groups, pin_layout,
+      reduce_element_type,
+      std::vector<XLATensorPtr>(xresiduals.begin(), xresiduals.end()));
   XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> new_xtensors,
                       bridge::GetXlaTensors(tensors));
   XLA_THROW_IF_ERROR(bridge::ReplaceXlaTensor(tensors, new_xtensors));
+  if (!residuals.empty()) {
+    XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> new_xresiduals,
+                        bridge::GetXlaTensors(residuals));
+    XLA_THROW_IF_ERROR(bridge::ReplaceXlaTensor(residuals, new_xresiduals));
+  }
 }
 
 at::Tensor AllReduce(const std::string& reduce_type, const at::Tensor& input,
                      double scale,
                      const std::vector<std::vector<int64_t>>& replica_groups,
-                     bool pin_layout) {
+                     bool pin_layout,
+                     std::optional<xla::PrimitiveType> reduce_element_type) {
   TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
   XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input, bridge::GetXlaTensor(input));
-  auto result = tensor_methods::all_reduce(
-      xla_input, GetReduceType(reduce_type), scale, replica_groups, pin_layout);
+  auto result = tensor_methods::all_reduce(xla_input,
+                                           GetReduceType(reduce_type), scale,
+                                           replica_groups, pin_layout,
+                                           reduce_element_type);
   return bridge::AtenFromXlaTensor(std::move(result));
 }
 
@@ -649,6 +696,28 @@ std::pair<at::Tensor, std::shared_ptr<torch::lazy::Value>> AllToAll(
       std::make_shared<torch::lazy::Value>(new_token));
 }
 
+std::pair<std::vector<at::Tensor>, std::shared_ptr<torch::lazy::Value>>
+AllToAllCoalesced(const std::vector<at::Tensor>& inputs,
+                  const std::shared_ptr<torch::lazy::Value>& token,
+                  int64_t split_dimension, int64_t concat_dimension,
+                  int64_t split_count,
+                  const std::vector<std::vector<int64_t>>& replica_groups,
+                  bool pin_layout) {
+  TORCH_LAZY_FN_COUNTER_TIMED_TRACING("xla::");
+  XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xinputs,
+                      bridge::GetXlaTensors(inputs));
+  std::vector<XLATensorPtr> result;
+  torch::lazy::Value new_token;
+  std::tie(result, new_token) = tensor_methods::all_to_all_coalesced(
+      xinputs, *token, split_dimension, concat_dimension, split_count,
+      replica_groups, pin_layout);
+  std::vector<at::Tensor> aten_result;
+  for (auto& xt : result) {
+    aten_result.emplace_back(bridge::AtenFromXlaTensor(std::move(xt)));
+  }
+  return {aten_result, std::make_shared<torch::lazy::Value>(new_token)};
+}
+
 std::pair<at::Tensor, std::shared_ptr<torch::lazy::Value>> CollectivePermute(
     const at::Tensor& input, const std::shared_ptr<torch::lazy::Value>& token,
     const std::vector<std::pair<int64_t, int64_t>>& source_target_pairs) {
@@ -742,6 +811,28 @@ uint64_t GetRngSeed(const std::string& device_str) {
       GetDeviceOrCurrent(device_str));
 }
 
+// Serializes the seed and offset of the device's random stream as the state of
+// an XLA generator.
+at::Tensor GetRngGeneratorState(const std::string& device_str) {
+  torch::lazy::BackendDevice device = GetDeviceOrCurrent(device_str);
+  auto [seed, offset] = XLAGraphExecutor::Get()->GetRngState(device);
+  at::Generator generator = at::make_generator<at::XLAGeneratorImpl>(
+      static_cast<c10::DeviceIndex>(device.ordinal()));
+  generator.set_current_seed(seed);
+  generator.set_offset(offset);
+  return generator.get_state();
+}
+
+void SetRngGeneratorState(const at::Tensor& state,
+                          const std::string& device_str) {
+  torch::lazy::BackendDevice device = GetDeviceOrCurrent(device_str);
+  at::Generator generator = at::make_generator<at::XLAGeneratorImpl>(
+      static_cast<c10::DeviceIndex>(device.ordinal()));
+  generator.set_state(state);
+  XLAGraphExecutor::Get()->SetRngState(device, generator.current_seed(),
+                                       generator.get_offset());
+}
+
 std::string GetTensorsHloGraph(const std::vector<at::Tensor>& tensors,
                                EmitMode mode) {
   std::vector<XLATensorPtr> xtensors = CollectXlaTensors(tensors);
@@ -887,6 +978,33 @@ std::vector<at::Tensor> GetXlaTensorsFromAten(
   return xla_tensors;
 }
 
+// Pads the `index`-th input of a session to the sizes picked by the
+// ShapeBucketer. Returns the padded tensor, and a boolean mask of its valid
+// elements, or None if no padding was needed.
+py::tuple PadToShapeBucket(const std::string& session, int64_t index,
+                           const at::Tensor& tensor) {
+  std::vector<int64_t> bucketed =
+      ShapeBucketer::Get()->GetBucketedSizes(session, index, tensor.sizes());
+  py::tuple result(2);
+  if (tensor.sizes() == at::IntArrayRef(bucketed)) {
+    result[0] = tensor;
+    result[1] = py::none();
+    return result;
+  }
+  // constant_pad_nd takes (before, after) pairs, starting from the last
+  // dimension.
+  std::vector<int64_t> pad;
+  for (int64_t dim = tensor.dim() - 1; dim >= 0; --dim) {
+    pad.push_back(0);
+    pad.push_back(bucketed[dim] - tensor.size(dim));
+  }
+  at::Tensor mask =
+      at::ones(tensor.sizes(), tensor.options().dtype(at::kBool));
+  result[0] = at::constant_pad_nd(tensor, pad, 0);
+  result[1] = at::constant_pad_nd(mask, pad, 0);
+  return result;
+}
+
 at::Tensor GetXlaTensorDimensionSize(const at::Tensor& tensor, int64_t dim) {
   XLA_ASSIGN_OR_THROW(XLATensorPtr xtensor, bridge::GetXlaTensor(tensor));
   return bridge::AtenFromXlaTensor(
@@ -948,6 +1066,27 @@ absl::StatusOr<std::vector<at::Tensor>> XlaUserComputation(
   return results;
 }
 
+absl::StatusOr<std::vector<at::Tensor>> XlaScan(
+    const std::vector<at::Tensor>& operands,
+    runtime::ComputationClient::ComputationPtr body, int64_t num_carry,
+    int64_t num_xs, std::vector<int64_t> parameter_operands,
+    int64_t seed_operand, bool reverse) {
+  XLA_ASSIGN_OR_RETURN(std::vector<absl_nonnull XLATensorPtr> xla_operands,
+                       bridge::GetXlaTensors(operands));
+  XLA_ASSIGN_OR_RETURN(
+      std::vector<absl_nonnull XLATensorPtr> xla_results,
+      tensor_methods::scan(xla_operands, std::move(body), num_carry, num_xs,
+                           std::move(parameter_operands), seed_operand,
+                           reverse));
+
+  std::vector<at::Tensor> results(xla_results.size());
+  std::transform(xla_results.begin(), xla_results.end(), results.begin(),
+                 [](const XLATensorPtr& xla_result) {
+                   return bridge::AtenFromXlaTensor(std::move(xla_result));
+                 });
+  return results;
+}
+
 runtime::ComputationClient::ComputationPtr CreateComputation(
     const std::string& name, xla::XlaOp root) {
   XLA_ASSIGN_OR_THROW(xla::XlaComputation computation,
@@ -956,13 +1095,54 @@ runtime::ComputationClient::ComputationPtr CreateComputation(
       name, std::move(computation));
 }
 
+using UserComputationCache =
+    runtime::util::Cache<torch::lazy::hash_t,
+                         runtime::ComputationClient::Computation,
+                         torch::lazy::HashReducer>;
+
+// The latest computations built from module protos, by name and serialized
+// proto.
+UserComputationCache* GetUserComputationCache() {
+  static const size_t cache_size =
+      runtime::sys_util::GetEnvInt("XLA_USER_COMPUTATION_CACHE_SIZE", 64);
+  static UserComputationCache* cache = new UserComputationCache(cache_size);
+  return cache;
+}
+
+// The lowerings of scan, fori_loop and alike build their computations from the
+// same module proto on every trace. Those share the computation built first,
+// so that the proto is parsed, and fingerprinted for the graph hash, once.
 runtime::ComputationClient::ComputationPtr CreateComputationFromProto(
     const std::string& name, const std::string& module_proto) {
+  torch::lazy::hash_t key = torch::lazy::MHash(name, module_proto);
+  UserComputationCache* cache = GetUserComputationCache();
+  runtime::ComputationClient::ComputationPtr cached = cache->Get(key);
+  if (cached != nullptr) {
+    TORCH_LAZY_COUNTER("CachedUserComputation", 1);
+    return cached;
+  }
   xla::HloModuleProto proto;
   proto.ParseFromString(module_proto);
   xla::XlaComputation computation(std::move(proto));
-  return std::make_shared<runtime::ComputationClient::Computation>(
-      name, std::move(computation));
+  return cache->Add(std::move(key),
+                    std::make_shared<runtime::ComputationClient::Computation>(
+                        name, std::move(computation)));
+}
+
+// Custom losses, samplers and alike build the same computation with the op
+// builder on every step. Those share the computation built first from the
+// same sequence of ops, skipping building and fingerprinting it again.
+runtime::ComputationClient::ComputationPtr CreateComputationFromOp(
+    const std::string& name, const op_builder::OpPtr& root) {
+  torch::lazy::hash_t key =
+      torch::lazy::MHash(name, root->builder->signature(), root->signature);
+  UserComputationCache* cache = GetUserComputationCache();
+  runtime::ComputationClient::ComputationPtr cached = cache->Get(key);
+  if (cached != nullptr) {
+    TORCH_LAZY_COUNTER("CachedBuilderComputation", 1);
+    return cached;
+  }
+  return cache->Add(std::move(key), CreateComputation(name, root->op));
 }
 
 xla::Shape GetTensorShape(const at::Tensor& tensor,
@@ -988,6 +1168,7 @@ py::dict GetMemoryInfo(const std::string& device_str) {
   py_dict["bytes_used"] = mem_info.bytes_used;
   py_dict["bytes_limit"] = mem_info.bytes_limit;
   py_dict["peak_bytes_used"] = mem_info.peak_bytes_used;
+  py_dict["largest_free_block_bytes"] = mem_info.largest_free_block_bytes;
   return py_dict;
 }
 
@@ -1019,6 +1200,7 @@ void MapXlaEnvVarsToLazy() {
       runtime::sys_util::GetEnvBool("XLA_IR_DEBUG", false) |
       runtime::sys_util::GetEnvBool("XLA_HLO_DEBUG", false);
   FLAGS_torch_lazy_ir_debug = wants_frames;
+  MaybeSamplePythonFrames();
   static bool no_scalars =
       runtime::sys_util::GetEnvBool("XLA_NO_SPECIAL_SCALARS", false);
   FLAGS_torch_lazy_handle_special_scalars = !no_scalars;
@@ -1562,7 +1744,7 @@ void InitXlaModuleBindings(py::module m) {
       m, "IrValue");
 
   // Define the _XLAC.XlaBuilder class.
-  py::class_<xla::XlaBuilder, op_builder::BuilderPtr>(m, "XlaBuilder");
+  py::class_<op_builder::Builder, op_builder::BuilderPtr>(m, "XlaBuilder");
 
   // Define the _XLAC.XlaOp class.
   py::class_<op_builder::Op, op_builder::OpPtr>(m, "XlaOp");
@@ -1571,6 +1753,75 @@ void InitXlaModuleBindings(py::module m) {
   py::class_<runtime::ComputationClient::Computation,
              runtime::ComputationClient::ComputationPtr>(m, "XlaComputation");
 
+  // Define the _XLAC.CapturedGraph class.
+  py::class_<XLAGraphExecutor::CapturedGraph,
+             std::shared_ptr<XLAGraphExecutor::CapturedGraph>>(m,
+                                                              "CapturedGraph")
+      .def_property_readonly(
+          "hash", [](const XLAGraphExecutor::CapturedGraph& graph) {
+            return torch::lazy::HashToString(graph.hash);
+          });
+
+  // Define the _XLAC.TensorsTransfer class.
+  py::class_<XLAGraphExecutor::TensorsTransfer,
+             std::shared_ptr<XLAGraphExecutor::TensorsTransfer>>(
+      m, "TensorsTransfer")
+      .def("is_ready",
+           [](XLAGraphExecutor::TensorsTransfer& transfer) {
+             NoGilSection nogil;
+             return transfer.IsReady();
+           })
+      .def("wait", [](XLAGraphExecutor::TensorsTransfer& transfer) {
+        NoGilSection nogil;
+        return transfer.Wait();
+      });
+
+  // Define the _XLAC.ShardedBatchAssembler class.
+  py::class_<ShardedBatchAssembler, std::shared_ptr<ShardedBatchAssembler>>(
+      m, "ShardedBatchAssembler")
+      .def(py::init([](XLATensor::ShardingSpecPtr sharding_spec) {
+        XLA_ASSIGN_OR_THROW(std::unique_ptr<ShardedBatchAssembler> assembler,
+                            ShardedBatchAssembler::Create(sharding_spec));
+        return std::shared_ptr<ShardedBatchAssembler>(std::move(assembler));
+      }))
+      .def("add_shard",
+           [](ShardedBatchAssembler& assembler, int64_t index,
+              const at::Tensor& shard) {
+             NoGilSection nogil;
+             XLA_THROW_IF_ERROR(assembler.AddShard(index, shard));
+           })
+      .def("finish", [](ShardedBatchAssembler& assembler) -> at::Tensor {
+        XLA_ASSIGN_OR_THROW(at::Tensor tensor, assembler.Finish());
+        return torch::autograd::make_variable(tensor, /*requires_grad=*/false);
+      });
+
+  // Define the _XLAC.DevicePrefetcher class.
+  py::class_<DevicePrefetcher, std::shared_ptr<DevicePrefetcher>>(
+      m, "DevicePrefetcher")
+      .def(py::init<std::string, size_t, size_t>(), py::arg("device"),
+           py::arg("max_in_flight"), py::arg("num_threads") = 1)
+      .def(
+          "enqueue",
+          [](DevicePrefetcher& prefetcher, std::vector<at::Tensor> tensors,
+             std::optional<std::vector<XLATensor::ShardingSpecPtr>>
+                 shardings) {
+            NoGilSection nogil;
+            return prefetcher.Enqueue(std::move(tensors),
+                                      std::move(shardings).value_or(
+                                          std::vector<
+                                              XLATensor::ShardingSpecPtr>()));
+          },
+          py::arg("tensors"), py::arg("shardings") = py::none())
+      .def("dequeue",
+           [](DevicePrefetcher& prefetcher) {
+             NoGilSection nogil;
+             return prefetcher.Dequeue();
+           })
+      .def("close_write",
+           [](DevicePrefetcher& prefetcher) { prefetcher.CloseWrite(); })
+      .def("close", [](DevicePrefetcher& prefetcher) { prefetcher.Close(); })
+      .def_property_readonly("max_in_flight", &DevicePrefetcher::max_in_flight);
+
   // Define the _XLAC.OpSharding class.
   PythonScope<py::class_<xla::OpSharding>>(m, "OpSharding")
       // Constructor for V1 shardings
@@ -1610,6 +1861,8 @@ void InitXlaModuleBindings(py::module m) {
   module
       .def("_prepare_to_exit",  //
            &PrepareToExit)
+      .def("_xla_start_runtime_initialization",
+           []() { runtime::StartComputationClientInitialization(); })
       .def("_xla_runtime_is_initialized",
            []() {
             return runtime::GetComputationClientIfInitialized() != nullptr;
@@ -1634,6 +1887,23 @@ void InitXlaModuleBindings(py::module m) {
             }
             return results;
            })
+      .def("_xla_scan",
+           [](const std::vector<at::Tensor>& operands,
+              const runtime::ComputationClient::ComputationPtr& body,
+              int64_t num_carry, int64_t num_xs,
+              std::vector<int64_t> parameter_operands, int64_t seed_operand,
+              bool reverse) {
+             std::vector<at::Tensor> results;
+             {
+               py::gil_scoped_release gil;
+               XLA_ASSIGN_OR_THROW(
+                   results,
+                   XlaScan(operands, body, num_carry, num_xs,
+                           std::move(parameter_operands), seed_operand,
+                           reverse));
+             }
+             return results;
+           })
       .def("_get_xla_tensors_dot",
            [](const std::vector<at::Tensor>& tensors) -> std::string {
             auto coverter =
@@ -1890,29 +2160,43 @@ void InitXlaModuleBindings(py::module m) {
       .def("_xla_all_reduce_inplace",
            [](const std::string& reduce_type,
               const std::vector<at::Tensor>& tensors, double scale,
-              const py::list& groups, bool pin_layout) {
+              const py::list& groups, bool pin_layout,
+              const std::optional<py::object>& reduce_dtype,
+              const std::vector<at::Tensor>& residuals) {
             std::vector<std::vector<int64_t>> replica_groups =
                 CreateReduceGroups(groups);
+            std::optional<xla::PrimitiveType> reduce_element_type =
+                GetReduceElementType(reduce_dtype);
             {
               NoGilSection nogil;
               AllReduceInPlace(reduce_type, tensors, scale, replica_groups,
-                               pin_layout);
+                               pin_layout, reduce_element_type, residuals);
             }
-           })
+           },
+           py::arg("reduce_type"), py::arg("tensors"), py::arg("scale"),
+           py::arg("groups"), py::arg("pin_layout"),
+           py::arg("reduce_dtype") = py::none(),
+           py::arg("residuals") = std::vector<at::Tensor>())
       .def("_xla_all_reduce",
            [](const std::string& reduce_type, const at::Tensor& input,
-              double scale, const py::list& groups, bool pin_layout) {
+              double scale, const py::list& groups, bool pin_layout,
+              const std::optional<py::object>& reduce_dtype) {
             std::vector<std::vector<int64_t>> replica_groups =
                 CreateReduceGroups(groups);
+            std::optional<xla::PrimitiveType> reduce_element_type =
+                GetReduceElementType(reduce_dtype);
             at::Tensor result;
             {
               NoGilSection nogil;
               result = AllReduce(reduce_type, input, scale, replica_groups,
-                                 pin_layout);
+                                 pin_layout, reduce_element_type);
             }
             return torch::autograd::make_variable(
                 result, /*requires_grad=*/input.requires_grad());
-           })
+           },
+           py::arg("reduce_type"), py::arg("input"), py::arg("scale"),
+           py::arg("groups"), py::arg("pin_layout"),
+           py::arg("reduce_dtype") = py::none())
       .def("_xla_spmd_all_reduce",
            [](const std::string& reduce_type, const at::Tensor& input,
               double scale, const py::list& groups) {
@@ -1951,15 +2235,85 @@ void InitXlaModuleBindings(py::module m) {
           py::arg("dimension_numbers"),              //
           py::arg("precision_config") = py::none(),  //
           py::arg("preferred_element_type") = py::none())
-      .def("_xla_cast_int4",
-           [](const at::Tensor& weight,
-              const std::vector<int>& int4_weight_values) -> at::Tensor {
+      .def(
+          "_xla_cast_int4",
+          [](const at::Tensor& weight,
+             const std::vector<int>& int4_weight_values) -> at::Tensor {
             at::Tensor result;
             {
               NoGilSection nogil;
               result = CastInt4(weight, int4_weight_values);
             }
             return result;
+          },
+          py::arg("weight"),
+          py::arg("int4_weight_values") = std::vector<int>())
+      .def(
+          "_xla_quantized_dot",
+          [](const at::Tensor& x, const at::Tensor& w, const at::Tensor& scale,
+             const std::optional<at::Tensor>& x_scale,
+             const std::optional<at::Tensor>& zero_point,
+             int64_t block_size) -> at::Tensor {
+            XLATensorPtr result;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_x, bridge::GetXlaTensor(x));
+              const torch::lazy::BackendDevice& device = xla_x->GetDevice();
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_w, bridge::GetXlaTensor(w));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_scale,
+                  bridge::GetXlaTensor(scale));
+              result = tensor_methods::quantized_dot(
+                  xla_x, xla_w, xla_scale,
+                  bridge::GetOrCreateXlaTensor(x_scale, device),
+                  bridge::GetOrCreateXlaTensor(zero_point, device),
+                  block_size);
+            }
+            return bridge::AtenFromXlaTensor(std::move(result));
+          },
+          py::arg("x"), py::arg("w"), py::arg("scale"),
+          py::arg("x_scale") = py::none(), py::arg("zero_point") = py::none(),
+          py::arg("block_size") = -1)
+      .def("_xla_fp8_dot",
+           [](const at::Tensor& lhs, const at::Tensor& rhs,
+              at::Tensor& lhs_scale, at::Tensor& rhs_scale,
+              at::Tensor& lhs_amax_history, at::Tensor& rhs_amax_history,
+              const py::object& lhs_dtype, const py::object& rhs_dtype,
+              int64_t rhs_contracting_dim, int64_t margin) -> at::Tensor {
+             at::ScalarType lhs_type =
+                 reinterpret_cast<THPDtype*>(lhs_dtype.ptr())->scalar_type;
+             at::ScalarType rhs_type =
+                 reinterpret_cast<THPDtype*>(rhs_dtype.ptr())->scalar_type;
+             XLATensorPtr result;
+             {
+               NoGilSection nogil;
+               XLA_ASSIGN_OR_THROW(XLATensorPtr xla_lhs,
+                                   bridge::GetXlaTensor(lhs));
+               XLA_ASSIGN_OR_THROW(XLATensorPtr xla_rhs,
+                                   bridge::GetXlaTensor(rhs));
+               XLA_ASSIGN_OR_THROW(XLATensorPtr xla_lhs_scale,
+                                   bridge::GetXlaTensor(lhs_scale));
+               XLA_ASSIGN_OR_THROW(XLATensorPtr xla_rhs_scale,
+                                   bridge::GetXlaTensor(rhs_scale));
+               XLA_ASSIGN_OR_THROW(XLATensorPtr xla_lhs_amax_history,
+                                   bridge::GetXlaTensor(lhs_amax_history));
+               XLA_ASSIGN_OR_THROW(XLATensorPtr xla_rhs_amax_history,
+                                   bridge::GetXlaTensor(rhs_amax_history));
+               result = tensor_methods::fp8_dot(
+                   xla_lhs, xla_rhs, xla_lhs_scale, xla_rhs_scale,
+                   xla_lhs_amax_history, xla_rhs_amax_history, lhs_type,
+                   rhs_type, rhs_contracting_dim, margin);
+             }
+             return bridge::AtenFromXlaTensor(std::move(result));
+           })
+      .def("_xla_pack_int4",
+           [](const at::Tensor& tensor) -> at::Tensor {
+             NoGilSection nogil;
+             return PackInt4(tensor);
+           })
+      .def("_xla_unpack_int4",
+           [](const at::Tensor& packed) -> at::Tensor {
+             NoGilSection nogil;
+             return UnpackInt4(packed);
            })
       .def("_xla_quantize_tensor",
            [](const at::Tensor& input, const std::vector<float>& scale_list,
@@ -2006,6 +2360,29 @@ void InitXlaModuleBindings(py::module m) {
             result_tuple[1] = new_token;
             return result_tuple;
            })
+      .def("_xla_all_to_all_coalesced",
+           [](const std::vector<at::Tensor>& inputs,
+              const std::shared_ptr<torch::lazy::Value>& token,
+              int64_t split_dimension, int64_t concat_dimension,
+              int64_t split_count, const py::list& groups, bool pin_layout) {
+            std::vector<std::vector<int64_t>> replica_groups =
+                CreateReduceGroups(groups);
+            std::vector<at::Tensor> results;
+            std::shared_ptr<torch::lazy::Value> new_token;
+            {
+              NoGilSection nogil;
+              std::tie(results, new_token) = AllToAllCoalesced(
+                  inputs, token, split_dimension, concat_dimension,
+                  split_count, replica_groups, pin_layout);
+            }
+            auto result_list = py::list(results.size() + 1);
+            for (size_t i = 0; i < results.size(); ++i) {
+              result_list[i] = torch::autograd::make_variable(
+                  results[i], /*requires_grad=*/inputs[i].requires_grad());
+            }
+            result_list[results.size()] = new_token;
+            return result_list;
+           })
       .def("_xla_all_gather",
            [](const at::Tensor& input, int64_t dim, int64_t shard_count,
               const py::list& groups, bool pin_layout,
@@ -2320,6 +2697,19 @@ void InitXlaModuleBindings(py::module m) {
           "_xla_get_rng_seed",
           [](const std::string& device) { return GetRngSeed(device); },
           py::arg("device") = "")
+      .def(
+          "_xla_get_rng_generator_state",
+          [](const std::string& device) {
+            return GetRngGeneratorState(device);
+          },
+          py::arg("device") = "")
+      .def(
+          "_xla_set_rng_generator_state",
+          [](const at::Tensor& state, const std::string& device) {
+            SetRngGeneratorState(state, device);
+          },
+          py::arg("state"),  //
+          py::arg("device") = "")
       .def(
           "_xla_set_enable_alias_with_buffer_donor_config",
           [](bool enable_user_config_alias, const std::string& device_str) {
@@ -2359,6 +2749,76 @@ void InitXlaModuleBindings(py::module m) {
           },
           py::arg("tensors"),  //
           py::arg("devices"))
+      .def(
+          "_xla_warm_up_cache_batch",
+          [](const std::vector<std::vector<at::Tensor>>& tensor_groups,
+             const std::vector<std::string>& devices) {
+            std::vector<std::vector<XLATensorPtr>> xtensor_groups;
+            xtensor_groups.reserve(tensor_groups.size());
+            for (const std::vector<at::Tensor>& tensors : tensor_groups) {
+              xtensor_groups.push_back(CollectXlaTensors(tensors));
+            }
+            NoGilSection nogil;
+            XLAGraphExecutor::Get()->WarmUpCache(xtensor_groups, devices);
+          },
+          py::arg("tensor_groups"),  //
+          py::arg("devices"))
+      .def("_xla_get_cpu_tensors_async",
+           [](const std::vector<at::Tensor>& tensors) {
+             XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xinputs,
+                                 bridge::GetXlaTensors(tensors));
+             std::vector<XLATensorPtr> xtensors(xinputs.begin(), xinputs.end());
+             NoGilSection nogil;
+             return XLAGraphExecutor::Get()->GetTensorsAsync(&xtensors);
+           })
+      .def("_xla_capture_graph",
+           [](const std::vector<at::Tensor>& inputs,
+              const std::vector<at::Tensor>& outputs) {
+             XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xinputs,
+                                 bridge::GetXlaTensors(inputs));
+             XLA_ASSIGN_OR_THROW(
+                 std::vector<absl_nonnull XLATensorPtr> xoutputs,
+                 bridge::GetXlaTensors(outputs));
+             NoGilSection nogil;
+             return XLAGraphExecutor::Get()->CaptureGraph(
+                 {xinputs.begin(), xinputs.end()},
+                 {xoutputs.begin(), xoutputs.end()});
+           })
+      .def("_xla_replay_graph",
+           [](const XLAGraphExecutor::CapturedGraph& graph,
+              const std::vector<at::Tensor>& inputs) {
+             XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xinputs,
+                                 bridge::GetXlaTensors(inputs));
+             std::vector<XLATensorPtr> xoutputs;
+             {
+               NoGilSection nogil;
+               xoutputs = XLAGraphExecutor::Get()->ReplayGraph(
+                   graph, {xinputs.begin(), xinputs.end()});
+             }
+             std::vector<at::Tensor> outputs;
+             outputs.reserve(xoutputs.size());
+             for (const XLATensorPtr& xoutput : xoutputs) {
+               outputs.push_back(bridge::AtenFromXlaTensor(xoutput));
+             }
+             return outputs;
+           })
+      .def(
+          "_xla_wait_pending_compilations",
+          [](const std::vector<std::string>& hash_strs) {
+            std::vector<torch::lazy::hash_t> hashes;
+            hashes.reserve(hash_strs.size());
+            for (const std::string& hash_str : hash_strs) {
+              XLA_CHECK(hash_str.size() == sizeof(torch::lazy::hash_t));
+              hashes.push_back(*(torch::lazy::hash_t*)(hash_str.c_str()));
+            }
+            NoGilSection nogil;
+            XLAGraphExecutor::Get()->WaitPendingCompilations(hashes);
+          },
+          py::arg("hashes") = std::vector<std::string>())
+      .def("_xla_get_num_pending_compilations",
+           []() -> size_t {
+             return XLAGraphExecutor::Get()->GetNumPendingCompilations();
+           })
       .def(
           "_xla_sync_live_tensors",
           [](const std::string& device, const std::vector<std::string>& devices,
@@ -2380,6 +2840,7 @@ void InitXlaModuleBindings(py::module m) {
           py::arg("devices"),      //
           py::arg("wait") = true,  //
           py::arg("reset_scope") = true)
+      .def("_xla_clear_autocast_cache", []() { ClearAutocastCache(); })
       .def("_get_stablehlo",
            [](const std::vector<at::Tensor>& tensors, const std::string& device,
               const std::vector<std::string>& devices,
@@ -2398,6 +2859,22 @@ void InitXlaModuleBindings(py::module m) {
             return py::bytes(
                 XLAGraphExecutor::Get()->DumpHloComputation(xtensors, mode));
            })
+      .def("_save_stablehlo",
+           [](const std::vector<at::Tensor>& tensors, const std::string& device,
+              bool emit_bytecode, const std::string& path) {
+             std::vector<XLATensorPtr> xtensors;
+             if (tensors.empty()) {
+               torch::lazy::BackendDevice backend_device =
+                   GetDeviceOrCurrent(device);
+               xtensors =
+                   XLAGraphExecutor::Get()->GetLiveTensors(&backend_device);
+             } else {
+               xtensors = CollectXlaTensors(tensors);
+             }
+             NoGilSection nogil;
+             XLAGraphExecutor::Get()->DumpStablehloToFile(xtensors,
+                                                          emit_bytecode, path);
+           })
       .def("_run_stablehlo",
            [](const std::string& bytecode,
               const std::vector<at::IValue>& graph_inputs)
@@ -2461,6 +2938,45 @@ void InitXlaModuleBindings(py::module m) {
            [](const std::string& name) -> py::object {
             return GetMetricData(name);
            })
+      .def("_xla_openmetrics_report",
+           []() { return CreateOpenMetricsReport(); })
+      .def("_xla_step_timeline",
+           []() { return runtime::timeline::ToChromeTrace(); })
+      .def("_xla_dump_step_timeline",
+           [](const std::string& path) {
+             XLA_THROW_IF_ERROR(runtime::timeline::Dump(path));
+           })
+      .def(
+          "_xla_trace_profile",
+          [](bool total) {
+            py::list py_stats;
+            for (const trace_profiler::OpStats& stats :
+                 trace_profiler::GetStats(total)) {
+              auto py_dict = py::dict();
+              switch (stats.category) {
+                case trace_profiler::Category::kAtenOp:
+                  py_dict["category"] = "aten_op";
+                  break;
+                case trace_profiler::Category::kNodeCreation:
+                  py_dict["category"] = "node_creation";
+                  break;
+                case trace_profiler::Category::kShapeInference:
+                  py_dict["category"] = "shape_inference";
+                  break;
+                case trace_profiler::Category::kLowering:
+                  py_dict["category"] = "lowering";
+                  py_dict["instructions"] = stats.instructions;
+                  break;
+              }
+              py_dict["op"] = stats.op.toQualString();
+              py_dict["count"] = stats.count;
+              py_dict["total_ns"] = stats.total_ns;
+              py_dict["max_ns"] = stats.max_ns;
+              py_stats.append(py_dict);
+            }
+            return py_stats;
+          },
+          py::arg("total") = false)
       .def("_xla_metrics_report",
            []() {
             // NOTE: [TORCH_LAZY_COUNTER v.s. XLA_COUNTER]
@@ -2476,7 +2992,9 @@ void InitXlaModuleBindings(py::module m) {
                                 runtime::GetComputationClient());
             return torch::lazy::CreateMetricReport() +
                    runtime::metrics_reader::CreateMetricReport(
-                       client->GetMetrics());
+                       client->GetMetrics()) +
+                   XLAGraphExecutor::Get()->CreateGraphStatsReport() +
+                   trace_profiler::CreateLoweringReport();
            })
       .def("_short_xla_metrics_report",
            [](const py::list& counter_names, const py::list& metric_names) {
@@ -2513,6 +3031,41 @@ void InitXlaModuleBindings(py::module m) {
           py::arg("device") = "")
       .def("_xla_memory_info",
            [](const std::string& device) { return GetMemoryInfo(device); })
+      .def("_xla_memory_history",
+           []() {
+             auto py_history = py::dict();
+             for (const MemorySampler::DeviceHistory& history :
+                  MemorySampler::Get()->GetHistory()) {
+               py::list py_samples;
+               for (const MemorySampler::Sample& sample : history.samples) {
+                 auto py_sample = py::dict();
+                 py_sample["time_ns"] = sample.time_ns;
+                 py_sample["step"] = sample.step;
+                 py_sample["bytes_used"] = sample.bytes_used;
+                 py_sample["peak_bytes_used"] = sample.peak_bytes_used;
+                 py_sample["largest_free_block_bytes"] =
+                     sample.largest_free_block_bytes;
+                 py_samples.append(py_sample);
+               }
+               py::list py_step_peaks;
+               for (const MemorySampler::StepPeak& peak : history.step_peaks) {
+                 auto py_peak = py::dict();
+                 py_peak["step"] = peak.step;
+                 py_peak["peak_bytes_used"] = peak.peak_bytes_used;
+                 py_peak["fragmentation"] = peak.fragmentation;
+                 py_step_peaks.append(py_peak);
+               }
+               auto py_device = py::dict();
+               py_device["bytes_limit"] = history.bytes_limit;
+               py_device["samples"] = py_samples;
+               py_device["step_peaks"] = py_step_peaks;
+               py_device["growth_alerts"] = history.growth_alerts;
+               py_device["fragmentation_alerts"] =
+                   history.fragmentation_alerts;
+               py_history[py::str(history.device)] = py_device;
+             }
+             return py_history;
+           })
       .def("_xla_set_mat_mul_precision",
            [](const std::string& mat_mul_precision) {
             XLA_ASSIGN_OR_THROW(xla::PrecisionConfig::Precision precision,
@@ -2526,7 +3079,7 @@ void InitXlaModuleBindings(py::module m) {
       })
       .def("_xla_op_create_builder",
            [](const std::string& name) {
-            return std::make_shared<xla::XlaBuilder>(name);
+            return std::make_shared<op_builder::Builder>(name);
            })
       .def("_xla_op_tensor_shape",
            [](const at::Tensor& tensor, const std::string& device) {
@@ -2537,17 +3090,15 @@ void InitXlaModuleBindings(py::module m) {
            [](op_builder::BuilderPtr builder, int64_t param_no,
               py::object py_shape) {
             xla::Shape shape = op_builder::PyShapeToShape(py_shape);
-            xla::XlaOp param = xla::Parameter(builder.get(), param_no, shape,
-                                              absl::StrCat("p", param_no));
-            return std::make_shared<op_builder::Op>(std::move(builder),
-                                                    std::move(param));
+            return op_builder::CreateParameter(std::move(builder), param_no,
+                                               shape);
            })
       .def("_xla_op_build",
            [](const std::string& name, op_builder::OpPtr root) {
             runtime::ComputationClient::ComputationPtr computation;
             {
               NoGilSection nogil;
-              computation = CreateComputation(name, root->op);
+              computation = CreateComputationFromOp(name, root);
             }
             return computation;
            })
@@ -2582,6 +3133,21 @@ void InitXlaModuleBindings(py::module m) {
               const std::vector<op_builder::OpPtr>& operands, py::dict args) {
             return op_builder::CreateOp(builder, opname, operands, args);
            })
+      .def("_xla_dynamic_update_slice_",
+           [](at::Tensor& input, const at::Tensor& source,
+              const at::Tensor& start_indices) {
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input,
+                  bridge::GetXlaTensor(input));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_source,
+                  bridge::GetXlaTensor(source));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_start_indices,
+                  bridge::GetXlaTensor(start_indices));
+              tensor_methods::dynamic_update_slice_(xla_input, xla_source,
+                                                    xla_start_indices);
+            }
+           })
       .def("_xla_sgd_optimizer_step_",
            [](const at::Tensor& found_inf, at::Tensor& step, at::Tensor& param,
               at::Tensor& buf, const at::Tensor& d_p, double weight_decay,
@@ -2630,6 +3196,324 @@ void InitXlaModuleBindings(py::module m) {
                   weight_decay, eps, amsgrad, maximize, use_adamw);
             }
            })
+      .def("_xla_multi_tensor_adam_optimizer_step_",
+           [](const at::Tensor& found_inf, const std::vector<at::Tensor>& steps,
+              const std::vector<at::Tensor>& params,
+              const std::vector<at::Tensor>& grads,
+              const std::vector<at::Tensor>& exp_avgs,
+              const std::vector<at::Tensor>& exp_avg_sqs,
+              const std::vector<at::Tensor>& max_exp_avg_sqs, double beta1,
+              double beta2, double lr, double weight_decay, double eps,
+              bool amsgrad, bool maximize, bool use_adamw,
+              const std::optional<at::Tensor>& inv_scale) {
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_found_inf,
+                  bridge::GetXlaTensor(found_inf));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_steps,
+                  bridge::GetXlaTensors(steps));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_params,
+                  bridge::GetXlaTensors(params));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_grads,
+                  bridge::GetXlaTensors(grads));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_exp_avgs,
+                  bridge::GetXlaTensors(exp_avgs));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_exp_avg_sqs,
+                  bridge::GetXlaTensors(exp_avg_sqs));
+              std::vector<XLATensorPtr> xla_max_exp_avg_sqs;
+              if (amsgrad) {
+                XLA_ASSIGN_OR_THROW(xla_max_exp_avg_sqs,
+                    bridge::GetXlaTensors(max_exp_avg_sqs));
+              }
+              XLATensorPtr xla_inv_scale;
+              if (inv_scale.has_value()) {
+                XLA_ASSIGN_OR_THROW(xla_inv_scale,
+                    bridge::GetXlaTensor(*inv_scale));
+              }
+              tensor_methods::multi_tensor_adam_optimizer_step_(
+                  xla_found_inf, absl::MakeSpan(xla_steps),
+                  absl::MakeSpan(xla_params), xla_grads,
+                  absl::MakeSpan(xla_exp_avgs),
+                  absl::MakeSpan(xla_exp_avg_sqs),
+                  absl::MakeSpan(xla_max_exp_avg_sqs), beta1, beta2, lr,
+                  weight_decay, eps, amsgrad, maximize, use_adamw,
+                  xla_inv_scale);
+            }
+           },
+           py::arg("found_inf"), py::arg("steps"), py::arg("params"),
+           py::arg("grads"), py::arg("exp_avgs"), py::arg("exp_avg_sqs"),
+           py::arg("max_exp_avg_sqs"), py::arg("beta1"), py::arg("beta2"),
+           py::arg("lr"), py::arg("weight_decay"), py::arg("eps"),
+           py::arg("amsgrad"), py::arg("maximize"), py::arg("use_adamw"),
+           py::arg("inv_scale") = py::none())
+      .def("_xla_lamb_optimizer_step_",
+           [](const at::Tensor& found_inf, const std::vector<at::Tensor>& steps,
+              const std::vector<at::Tensor>& params,
+              const std::vector<at::Tensor>& grads,
+              const std::vector<at::Tensor>& exp_avgs,
+              const std::vector<at::Tensor>& exp_avg_sqs, double beta1,
+              double beta2, double lr, double weight_decay, double eps,
+              bool maximize) {
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_found_inf,
+                  bridge::GetXlaTensor(found_inf));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_steps,
+                  bridge::GetXlaTensors(steps));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_params,
+                  bridge::GetXlaTensors(params));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_grads,
+                  bridge::GetXlaTensors(grads));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_exp_avgs,
+                  bridge::GetXlaTensors(exp_avgs));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_exp_avg_sqs,
+                  bridge::GetXlaTensors(exp_avg_sqs));
+              tensor_methods::lamb_optimizer_step_(
+                  xla_found_inf, absl::MakeSpan(xla_steps),
+                  absl::MakeSpan(xla_params), xla_grads,
+                  absl::MakeSpan(xla_exp_avgs),
+                  absl::MakeSpan(xla_exp_avg_sqs), beta1, beta2, lr,
+                  weight_decay, eps, maximize);
+            }
+           })
+      .def("_xla_adafactor_optimizer_step_",
+           [](const at::Tensor& found_inf, const std::vector<at::Tensor>& steps,
+              const std::vector<at::Tensor>& params,
+              const std::vector<at::Tensor>& grads,
+              const std::vector<at::Tensor>& row_vars,
+              const std::vector<at::Tensor>& col_vars, double lr,
+              double beta2_decay, double eps1, double eps2, double d,
+              double weight_decay, bool maximize) {
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_found_inf,
+                  bridge::GetXlaTensor(found_inf));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_steps,
+                  bridge::GetXlaTensors(steps));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_params,
+                  bridge::GetXlaTensors(params));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_grads,
+                  bridge::GetXlaTensors(grads));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_row_vars,
+                  bridge::GetXlaTensors(row_vars));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_col_vars,
+                  bridge::GetXlaTensors(col_vars));
+              tensor_methods::adafactor_optimizer_step_(
+                  xla_found_inf, absl::MakeSpan(xla_steps),
+                  absl::MakeSpan(xla_params), xla_grads,
+                  absl::MakeSpan(xla_row_vars), absl::MakeSpan(xla_col_vars),
+                  lr, beta2_decay, eps1, eps2, d, weight_decay, maximize);
+            }
+           })
+      .def("_xla_zero_adam_optimizer_step_",
+           [](const std::vector<at::Tensor>& grads,
+              const std::vector<at::Tensor>& shards,
+              const std::vector<at::Tensor>& steps,
+              const std::vector<at::Tensor>& exp_avgs,
+              const std::vector<at::Tensor>& exp_avg_sqs, double beta1,
+              double beta2, double lr, double weight_decay, double eps,
+              bool maximize, bool use_adamw, double scale, int64_t shard_count,
+              const py::list& groups, bool pin_layout,
+              std::optional<double> max_norm) {
+            std::vector<std::vector<int64_t>> replica_groups =
+                CreateReduceGroups(groups);
+            std::pair<std::vector<XLATensorPtr>, XLATensorPtr> results;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_grads,
+                  bridge::GetXlaTensors(grads));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_shards,
+                  bridge::GetXlaTensors(shards));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_steps,
+                  bridge::GetXlaTensors(steps));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_exp_avgs,
+                  bridge::GetXlaTensors(exp_avgs));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_exp_avg_sqs,
+                  bridge::GetXlaTensors(exp_avg_sqs));
+              results = tensor_methods::zero_adam_optimizer_step_(
+                  xla_grads, absl::MakeSpan(xla_shards),
+                  absl::MakeSpan(xla_steps), absl::MakeSpan(xla_exp_avgs),
+                  absl::MakeSpan(xla_exp_avg_sqs), beta1, beta2, lr,
+                  weight_decay, eps, maximize, use_adamw, scale, shard_count,
+                  std::move(replica_groups), pin_layout, max_norm);
+            }
+            return ZeroOptimizerStepResults(results);
+           })
+      .def("_xla_zero_sgd_optimizer_step_",
+           [](const std::vector<at::Tensor>& grads,
+              const std::vector<at::Tensor>& shards,
+              const std::vector<at::Tensor>& steps,
+              const std::vector<at::Tensor>& momentum_buffers,
+              double weight_decay, double momentum, double lr,
+              double dampening, bool nesterov, bool maximize, double scale,
+              int64_t shard_count, const py::list& groups, bool pin_layout,
+              std::optional<double> max_norm) {
+            std::vector<std::vector<int64_t>> replica_groups =
+                CreateReduceGroups(groups);
+            std::pair<std::vector<XLATensorPtr>, XLATensorPtr> results;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_grads,
+                  bridge::GetXlaTensors(grads));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_shards,
+                  bridge::GetXlaTensors(shards));
+              XLA_ASSIGN_OR_THROW(std::vector<XLATensorPtr> xla_steps,
+                  bridge::GetXlaTensors(steps));
+              XLA_ASSIGN_OR_THROW(
+                  std::vector<XLATensorPtr> xla_momentum_buffers,
+                  bridge::GetXlaTensors(momentum_buffers));
+              results = tensor_methods::zero_sgd_optimizer_step_(
+                  xla_grads, absl::MakeSpan(xla_shards),
+                  absl::MakeSpan(xla_steps),
+                  absl::MakeSpan(xla_momentum_buffers), weight_decay,
+                  momentum, lr, dampening, nesterov, maximize, scale,
+                  shard_count, std::move(replica_groups), pin_layout,
+                  max_norm);
+            }
+            return ZeroOptimizerStepResults(results);
+           })
+      .def("_xla_chunked_cross_entropy",
+           [](const at::Tensor& logits, const at::Tensor& target,
+              int64_t chunk_size, int64_t ignore_index) {
+            std::tuple<XLATensorPtr, XLATensorPtr> results;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_logits,
+                  bridge::GetXlaTensor(logits));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_target,
+                  bridge::GetXlaTensor(target));
+              results = tensor_methods::chunked_cross_entropy(
+                  xla_logits, xla_target, chunk_size, ignore_index);
+            }
+            return std::make_tuple(
+                bridge::AtenFromXlaTensor(std::get<0>(results)),
+                bridge::AtenFromXlaTensor(std::get<1>(results)));
+           })
+      .def("_xla_chunked_cross_entropy_backward",
+           [](const at::Tensor& grad_output, const at::Tensor& logits,
+              const at::Tensor& target, const at::Tensor& lse,
+              int64_t chunk_size, int64_t ignore_index) {
+            XLATensorPtr result;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_grad_output,
+                  bridge::GetXlaTensor(grad_output));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_logits,
+                  bridge::GetXlaTensor(logits));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_target,
+                  bridge::GetXlaTensor(target));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_lse,
+                  bridge::GetXlaTensor(lse));
+              result = tensor_methods::chunked_cross_entropy_backward(
+                  xla_grad_output, xla_logits, xla_target, xla_lse,
+                  chunk_size, ignore_index);
+            }
+            return bridge::AtenFromXlaTensor(std::move(result));
+           })
+      .def("_xla_embedding_bag_sparse_backward",
+           [](const at::Tensor& grad, const at::Tensor& indices,
+              const at::Tensor& offset2bag, const at::Tensor& bag_size,
+              const std::optional<at::Tensor>& per_sample_weights,
+              int64_t num_weights, int64_t mode) {
+            std::tuple<XLATensorPtr, XLATensorPtr> results;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_grad,
+                  bridge::GetXlaTensor(grad));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_indices,
+                  bridge::GetXlaTensor(indices));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_offset2bag,
+                  bridge::GetXlaTensor(offset2bag));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_bag_size,
+                  bridge::GetXlaTensor(bag_size));
+              results = tensor_methods::embedding_bag_sparse_backward(
+                  xla_grad, xla_indices, xla_offset2bag, xla_bag_size,
+                  bridge::GetOrCreateXlaTensor(per_sample_weights,
+                                               xla_grad->GetDevice()),
+                  num_weights, mode);
+            }
+            return std::make_tuple(
+                bridge::AtenFromXlaTensor(std::get<0>(results)),
+                bridge::AtenFromXlaTensor(std::get<1>(results)));
+           })
+      .def("_xla_approx_topk",
+           [](const at::Tensor& input, int64_t k, int64_t dim, bool largest,
+              double recall_target) {
+            std::tuple<XLATensorPtr, XLATensorPtr> results;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input,
+                  bridge::GetXlaTensor(input));
+              results = tensor_methods::approx_topk(xla_input, k, dim, largest,
+                                                    recall_target);
+            }
+            return std::make_tuple(
+                bridge::AtenFromXlaTensor(std::get<0>(results)),
+                bridge::AtenFromXlaTensor(std::get<1>(results)));
+           })
+      .def("_xla_sample_tokens",
+           [](const at::Tensor& logits, double temperature, int64_t top_k,
+              double top_p) -> at::Tensor {
+             XLATensorPtr result;
+             {
+               NoGilSection nogil;
+               XLA_ASSIGN_OR_THROW(XLATensorPtr xla_logits,
+                                   bridge::GetXlaTensor(logits));
+               result = tensor_methods::sample_tokens(xla_logits, temperature,
+                                                      top_k, top_p);
+             }
+             return bridge::AtenFromXlaTensor(std::move(result));
+           })
+      .def("_xla_bounded_nonzero",
+           [](const at::Tensor& input) {
+            std::tuple<XLATensorPtr, XLATensorPtr> results;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input,
+                  bridge::GetXlaTensor(input));
+              results = tensor_methods::bounded_nonzero(xla_input);
+            }
+            return std::make_tuple(
+                bridge::AtenFromXlaTensor(std::get<0>(results)),
+                bridge::AtenFromXlaTensor(std::get<1>(results)));
+           })
+      .def("_xla_bounded_masked_select",
+           [](const at::Tensor& input, const at::Tensor& mask) {
+            std::tuple<XLATensorPtr, XLATensorPtr> results;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_input,
+                  bridge::GetXlaTensor(input));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_mask,
+                  bridge::GetXlaTensor(mask));
+              results = tensor_methods::bounded_masked_select(xla_input,
+                                                              xla_mask);
+            }
+            return std::make_tuple(
+                bridge::AtenFromXlaTensor(std::get<0>(results)),
+                bridge::AtenFromXlaTensor(std::get<1>(results)));
+           })
+      .def("_xla_batched_nms",
+           [](const at::Tensor& boxes, const at::Tensor& scores,
+              const at::Tensor& classes, double iou_threshold,
+              double score_threshold, int64_t max_output_size) {
+            std::tuple<XLATensorPtr, XLATensorPtr> results;
+            {
+              NoGilSection nogil;
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_boxes,
+                  bridge::GetXlaTensor(boxes));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_scores,
+                  bridge::GetXlaTensor(scores));
+              XLA_ASSIGN_OR_THROW(XLATensorPtr xla_classes,
+                  bridge::GetXlaTensor(classes));
+              results = tensor_methods::batched_nms(
+                  xla_boxes, xla_scores, xla_classes, iou_threshold,
+                  score_threshold, max_output_size);
+            }
+            return std::make_tuple(
+                bridge::AtenFromXlaTensor(std::get<0>(results)),
+                bridge::AtenFromXlaTensor(std::get<1>(results)));
+           })
       .def("_xla_mark_sharding",
            [](const at::Tensor& input, xla::OpSharding sharding) {
             ShardingUtil::XlaMarkSharding(input, sharding);
@@ -2874,6 +3758,135 @@ void InitXlaModuleBindings(py::module m) {
             }
             return result;
           })
+      .def(
+          // Returns the local shard at `index`, in the order of
+          // `_get_local_shards`, transferring only that shard to the host.
+          "_get_local_shard",
+          [](const at::Tensor& input, int64_t index) -> at::Tensor {
+            XLA_ASSIGN_OR_THROW(
+                runtime::ComputationClient * absl_nonnull const client,
+                runtime::GetComputationClient());
+            XLA_ASSIGN_OR_THROW(XLATensorPtr xtensor,
+                                bridge::GetXlaTensor(input));
+            XLA_CHECK(xtensor->GetXlaData() != nullptr)
+                << "Shard data is not available";
+            XLA_CHECK(xtensor->sharding_spec() != nullptr)
+                << "Tensor is not sharded";
+            std::vector<runtime::ComputationClient::DataPtr> shard_handles =
+                client->GetDataShards(
+                    std::dynamic_pointer_cast<runtime::ComputationClient::Data>(
+                        xtensor->GetXlaData()));
+            XLA_CHECK_GE(index, 0);
+            XLA_CHECK_LT(index, shard_handles.size());
+            runtime::ComputationClient::DataPtr shard = shard_handles[index];
+            XLA_ASSIGN_OR_THROW(
+                std::vector<at::Tensor> cpu_shards,
+                XlaDataToTensors(WrapXlaData({shard}),
+                                 {MaybeUpcastToHostTorchType(
+                                     shard->shape().element_type())}));
+            return cpu_shards[0];
+          })
+      .def(
+          // Returns the region of the sharded `input` spanning
+          // `[starts[d], stops[d])` along every dimension `d`, as a CPU
+          // tensor. Only the local shards overlapping the region are
+          // transferred to the host, once for each distinct shard, rather than
+          // replicating the whole tensor.
+          "_get_local_shards_region",
+          [](const at::Tensor& input, const std::vector<int64_t>& starts,
+             const std::vector<int64_t>& stops) -> at::Tensor {
+            XLA_ASSIGN_OR_THROW(
+                runtime::ComputationClient * absl_nonnull const client,
+                runtime::GetComputationClient());
+            XLA_ASSIGN_OR_THROW(XLATensorPtr xtensor,
+                                bridge::GetXlaTensor(input));
+            XLA_CHECK(xtensor->GetXlaData() != nullptr)
+                << "Shard data is not available";
+            XLA_CHECK(xtensor->sharding_spec() != nullptr)
+                << "Tensor is not sharded";
+            std::vector<runtime::ComputationClient::DataPtr> shards =
+                client->GetDataShards(
+                    std::dynamic_pointer_cast<runtime::ComputationClient::Data>(
+                        xtensor->GetXlaData()));
+            std::vector<std::string> shard_devices;
+            for (auto& shard : shards) {
+              shard_devices.push_back(shard->device());
+            }
+            auto sharding_spec = xtensor->sharding_spec();
+            std::vector<ShardingUtil::ShardOverlap> overlaps =
+                ShardingUtil::GetShardOverlaps(
+                    ShardingUtil::GetShardShape(sharding_spec),
+                    input.sizes().vec(), sharding_spec->sharding,
+                    shard_devices, starts, stops);
+
+            std::vector<runtime::ComputationClient::DataPtr> handles;
+            std::vector<at::ScalarType> element_types;
+            for (auto& overlap : overlaps) {
+              handles.push_back(shards[overlap.shard]);
+              element_types.push_back(MaybeUpcastToHostTorchType(
+                  shards[overlap.shard]->shape().element_type()));
+            }
+            XLA_ASSIGN_OR_THROW(
+                std::vector<at::Tensor> cpu_shards,
+                XlaDataToTensors(WrapXlaData(handles), element_types));
+            TORCH_LAZY_COUNTER("ShardsRegionTransfers", 1);
+            TORCH_LAZY_COUNTER("ShardsRegionShards", overlaps.size());
+
+            std::vector<int64_t> region_sizes;
+            for (size_t d = 0; d < starts.size(); ++d) {
+              region_sizes.push_back(stops[d] - starts[d]);
+            }
+            at::Tensor region =
+                at::empty(region_sizes,
+                          at::TensorOptions().dtype(MaybeUpcastToHostTorchType(
+                              shards[0]->shape().element_type())));
+            for (size_t i = 0; i < overlaps.size(); ++i) {
+              at::Tensor src = cpu_shards[i];
+              at::Tensor dst = region;
+              for (size_t d = 0; d < region_sizes.size(); ++d) {
+                src = src.narrow(d, overlaps[i].shard_offsets[d],
+                                 overlaps[i].sizes[d]);
+                dst = dst.narrow(d, overlaps[i].region_offsets[d],
+                                 overlaps[i].sizes[d]);
+              }
+              dst.copy_(src);
+            }
+            return region;
+          })
+      .def(
+          // Moves the device data of `input` to the `memory_kind` memory space
+          // of its devices, like "device" or "pinned_host". The data must be
+          // materialized.
+          "_xla_set_memory_kind",
+          [](const at::Tensor& input, const std::string& memory_kind) {
+            XLA_ASSIGN_OR_THROW(
+                runtime::ComputationClient * absl_nonnull const client,
+                runtime::GetComputationClient());
+            XLA_ASSIGN_OR_THROW(XLATensorPtr xtensor,
+                                bridge::GetXlaTensor(input));
+            XLA_CHECK(xtensor->CurrentDataHandle() != nullptr)
+                << "The tensor data must be materialized";
+            XLA_ASSIGN_OR_THROW(
+                runtime::ComputationClient::DataPtr data,
+                client->CopyToMemoryKind(
+                    std::dynamic_pointer_cast<runtime::ComputationClient::Data>(
+                        xtensor->CurrentDataHandle()),
+                    memory_kind));
+            xtensor->SetXlaData(data);
+          })
+      .def("_xla_get_memory_kind",
+           [](const at::Tensor& input) -> std::string {
+             XLA_ASSIGN_OR_THROW(
+                 runtime::ComputationClient * absl_nonnull const client,
+                 runtime::GetComputationClient());
+             XLA_ASSIGN_OR_THROW(XLATensorPtr xtensor,
+                                 bridge::GetXlaTensor(input));
+             XLA_CHECK(xtensor->CurrentDataHandle() != nullptr)
+                 << "The tensor data must be materialized";
+             return client->GetMemoryKind(
+                 std::dynamic_pointer_cast<runtime::ComputationClient::Data>(
+                     xtensor->CurrentDataHandle()));
+           })
       .def(
           // For each input tensors' local shards, returns the tuple:
           //        (replica_id: int, indices: Union[List[Slice], Ellipsis]),
@@ -3029,6 +4042,73 @@ void InitXlaModuleBindings(py::module m) {
             auto& coordinator = client->GetCoordinator();
             return coordinator.ReachedSyncPoint(step);
           })
+      .def(
+          // Writes the values of the tensors to a local snapshot file, with
+          // all the device to host transfers in flight at once. Meant to be
+          // called once a preemption sync point is reached.
+          "_xla_write_snapshot",
+          [](const std::vector<at::Tensor>& tensors, const std::string& path) {
+            XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xinputs,
+                                bridge::GetXlaTensors(tensors));
+            std::vector<XLATensorPtr> xtensors(xinputs.begin(), xinputs.end());
+            NoGilSection nogil;
+            XLAGraphExecutor::Get()->SyncTensorsGraph(
+                &xtensors, {}, /*wait=*/true, /*sync_ltc_data=*/true);
+            std::vector<torch::lazy::BackendDataPtr> handles;
+            handles.reserve(xtensors.size());
+            for (const XLATensorPtr& xtensor : xtensors) {
+              handles.push_back(xtensor->GetXlaData());
+            }
+            XLA_ASSIGN_OR_THROW(
+                runtime::ComputationClient * absl_nonnull const client,
+                runtime::GetComputationClient());
+            XLA_THROW_IF_ERROR(
+                runtime::WriteSnapshot(client, UnwrapXlaData(handles), path));
+          })
+      .def("_xla_read_snapshot",
+           [](const std::string& path) {
+             std::vector<at::Tensor> result;
+             {
+               NoGilSection nogil;
+               XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> literals,
+                                   runtime::ReadSnapshot(path));
+               result.reserve(literals.size());
+               for (const xla::Literal& literal : literals) {
+                 result.push_back(MakeTensorFromXlaLiteral(
+                     literal, MaybeUpcastToHostTorchType(
+                                  literal.shape().element_type())));
+               }
+             }
+             return result;
+           })
+      .def(
+          "_xla_load_mapped_tensors",
+          [](const std::string& path, const std::vector<int64_t>& offsets,
+             const std::vector<py::object>& dtypes,
+             const std::vector<std::vector<int64_t>>& sizes,
+             const std::vector<std::optional<xla::OpSharding>>& shardings,
+             int64_t max_inflight_bytes, const std::string& device) {
+            XLA_CHECK_EQ(offsets.size(), dtypes.size());
+            XLA_CHECK_EQ(offsets.size(), sizes.size());
+            XLA_CHECK_EQ(offsets.size(), shardings.size());
+            std::vector<MappedTensorInfo> infos(offsets.size());
+            for (size_t i = 0; i < infos.size(); ++i) {
+              infos[i].offset = offsets[i];
+              infos[i].dtype =
+                  reinterpret_cast<THPDtype*>(dtypes[i].ptr())->scalar_type;
+              infos[i].sizes = sizes[i];
+              infos[i].sharding = shardings[i];
+            }
+            torch::lazy::BackendDevice xla_device = GetDeviceOrCurrent(device);
+            NoGilSection nogil;
+            XLA_ASSIGN_OR_THROW(
+                std::vector<at::Tensor> tensors,
+                LoadMappedTensors(path, infos, xla_device, max_inflight_bytes));
+            return tensors;
+          },
+          py::arg("path"), py::arg("offsets"), py::arg("dtypes"),
+          py::arg("sizes"), py::arg("shardings"),
+          py::arg("max_inflight_bytes"), py::arg("device") = "")
       .def("_is_placecholder",
            [](at::Tensor& input) {
             XLA_ASSIGN_OR_THROW(XLATensorPtr xtensor, bridge::GetXlaTensor(input));
@@ -3070,6 +4150,12 @@ void InitXlaModuleBindings(py::module m) {
            })
       .def("_get_use_eager_mode",
            []() { return XLAGraphExecutor::Get()->UseEagerMode(); })
+      .def("_set_eager_warm_up",
+           [](bool eager_warm_up) {
+             XLAGraphExecutor::Get()->SetEagerWarmUp(eager_warm_up);
+           })
+      .def("_get_eager_warm_up",
+           []() { return XLAGraphExecutor::Get()->EagerWarmUp(); })
       .def("_set_allow_execution",
            [](bool allow_execution) {
             XLAGraphExecutor::Get()->SetAllowExecution(allow_execution);
@@ -3082,6 +4168,23 @@ void InitXlaModuleBindings(py::module m) {
            })
       .def("_get_current_graph_name",
            []() { return XLAGraphExecutor::Get()->CurrentGraphName(); })
+      .def("_set_parameter_wrapping_threshold",
+           [](std::optional<int64_t> threshold) {
+            XLAGraphExecutor::Get()->SetParameterWrappingThreshold(threshold);
+           })
+      .def("_get_parameter_wrapping_threshold",
+           []() {
+            return XLAGraphExecutor::Get()->ParameterWrappingThreshold();
+           })
+      .def("_set_topk_recall_target",
+           [](std::optional<double> recall_target) {
+            XLA_CHECK(!recall_target ||
+                      (*recall_target > 0 && *recall_target <= 1))
+                << "The recall target must be in (0, 1]";
+            XLAGraphExecutor::Get()->SetTopKRecallTarget(recall_target);
+           })
+      .def("_get_topk_recall_target",
+           []() { return XLAGraphExecutor::Get()->TopKRecallTarget(); })
       .def("_dynamic_shape_detector_start_session",
            [](const std::string& session) {
             DynamicShapeDetector::Get()->StartSession(session);
@@ -3091,6 +4194,16 @@ void InitXlaModuleBindings(py::module m) {
       .def("_dynamic_shape_detector_remove_session",
            [](const std::string& session) {
             DynamicShapeDetector::Get()->RemoveSessionIfExists(session);
+            ShapeBucketer::Get()->RemoveSessionIfExists(session);
+           })
+      .def("_xla_shape_bucketing_set_buckets",
+           [](const std::string& session, std::vector<int64_t> buckets) {
+            ShapeBucketer::Get()->SetBuckets(session, std::move(buckets));
+           })
+      .def("_xla_shape_bucketing_pad",
+           [](const std::string& session, int64_t index,
+              const at::Tensor& tensor) -> py::tuple {
+            return PadToShapeBucket(session, index, tensor);
            })
       .def("_dynamic_shape_detector_set_max_different_graphs",
            [](int64_t max_different_graphs) {
@@ -3134,6 +4247,24 @@ void InitXlaModuleBindings(py::module m) {
 
             return bridge::AtenFromXlaTensors(std::move(xla_outputs));
            })
+      .def("_xla_tpu_custom_call",
+           [](const std::vector<at::Tensor>& inputs, int64_t kernel_id,
+              const std::vector<std::vector<int64_t>>& output_shapes,
+              const std::vector<at::ScalarType>& output_dtypes)
+               -> std::vector<at::Tensor> {
+            XLA_ASSIGN_OR_THROW(std::shared_ptr<const TpuKernel> kernel,
+                                GetRegisteredTpuKernel(kernel_id));
+            XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xla_inputs,
+                                bridge::GetXlaTensors(inputs));
+            XLA_ASSIGN_OR_THROW(std::vector<absl_nonnull XLATensorPtr> xla_outputs,
+                                tensor_methods::tpu_custom_call(xla_inputs, kernel, output_shapes, output_dtypes));
+
+            return bridge::AtenFromXlaTensors(std::move(xla_outputs));
+           })
+      .def("_xla_register_tpu_kernel",
+           [](const std::string& payload) -> int64_t {
+            return RegisterTpuKernel(payload);
+           })
       .def("_xla_register_custom_call_target",
            [](const std::string& fn_name, const py::capsule& function_ptr,
               const std::string& platform) {
@@ -3160,7 +4291,15 @@ void InitXlaModuleBindings(py::module m) {
               const std::shared_ptr<torch::lazy::Value>& token) {
             auto device = GetDeviceOrCurrent(device_str);
             SetAllReduceToken(device, token);
-           });
+           })
+      .def("_reset_all_reduce_tokens",
+           [](const std::string& device_str) {
+            auto device = GetDeviceOrCurrent(device_str);
+            ResetAllReduceTokens(device);
+           })
+      .def("_get_token_domain", []() { return GetTokenDomain(); })
+      .def("_set_token_domain",
+           [](const std::string& domain) { SetTokenDomain(domain); });
 
   BuildProfilerSubmodule(&m);
   BuildLoweringContextSubmodule(&m);
@@ -3345,20 +4484,22 @@ void InitXlaModuleBindings(py::module m) {
            })
       .def(
           // from an XLA tensor to a PyCapsule.
-          // When consuming the PyCapsule, we should synchronize
-          // (waits for all kernels in all streams on a CUDA device to complete)
-          // if the current stream is different from the ext_data's stream.
-          // Otherwise, we may risk of getting incorrect results.
+          // Without a stream, blocks until the buffer is ready. On CUDA, a
+          // stream of the consumer, as passed to __dlpack__(), is made to wait
+          // for the buffer instead, and -1 leaves the synchronization to the
+          // consumer.
           "_to_dlpack",
-          [](const at::Tensor& input) -> py::handle {
+          [](const at::Tensor& input,
+             std::optional<std::intptr_t> stream) -> py::handle {
             DLManagedTensor* dlMTensor;
             {
               NoGilSection nogil;
-              dlMTensor = torch_xla::toDLPack(input);
+              dlMTensor = torch_xla::toDLPack(input, stream);
             }
             return PyCapsule_New(dlMTensor, "dltensor",
                                  dlPack_Capsule_Destructor);
-          })
+          },
+          py::arg("input"), py::arg("stream") = py::none())
       .def(
           // from a dlpack PyCapsule to an XLA tensor
           // If ext_data is the result of an CUDA computation, we should
@@ -3486,6 +4627,54 @@ void InitXlaModuleBindings(py::module m) {
              std::string bin((const char*)&hash, sizeof(hash));
              return py::bytes(bin);
            })
+      .def("_get_graph_stats",
+           []() {
+             py::list py_stats;
+             for (const XLAGraphExecutor::GraphStats& stats :
+                  XLAGraphExecutor::Get()->GetGraphStats()) {
+               auto py_dict = py::dict();
+               py_dict["hash"] = py::bytes(std::string(
+                   (const char*)&stats.hash, sizeof(stats.hash)));
+               py_dict["executions"] = stats.executions;
+               py_dict["compilations"] = stats.compilations;
+               py_dict["compile_time_ns"] = stats.compile_time_ns;
+               py_dict["execute_times_ns"] = stats.execute_times_ns;
+               py_dict["input_bytes"] = stats.input_bytes;
+               py_dict["output_bytes"] = stats.output_bytes;
+               py_dict["last_step"] = stats.last_step;
+               py_dict["flops"] = stats.flops;
+               py_dict["bytes_accessed"] = stats.bytes_accessed;
+               py_dict["transcendentals"] = stats.transcendentals;
+               py_stats.append(py_dict);
+             }
+             return py_stats;
+           })
+      .def("_get_graph_memory_footprint",
+           [](const std::string& hash_str) -> py::object {
+             XLA_CHECK(hash_str.size() == sizeof(torch::lazy::hash_t));
+             torch::lazy::hash_t hash =
+                 *(torch::lazy::hash_t*)(hash_str.c_str());
+             XLAGraphExecutor::ComputationCache::TypePtr cached_computation =
+                 XLAGraphExecutor::Get()->GetComputationCache()->Get(hash);
+             if (cached_computation == nullptr) {
+               return py::none();
+             }
+             std::optional<
+                 runtime::ComputationClient::Computation::MemoryFootprint>
+                 footprint =
+                     cached_computation->computation->memory_footprint();
+             if (!footprint.has_value()) {
+               return py::none();
+             }
+             auto py_dict = py::dict();
+             py_dict["argument_bytes"] = footprint->argument_bytes;
+             py_dict["output_bytes"] = footprint->output_bytes;
+             py_dict["alias_bytes"] = footprint->alias_bytes;
+             py_dict["temp_bytes"] = footprint->temp_bytes;
+             py_dict["generated_code_bytes"] = footprint->generated_code_bytes;
+             py_dict["execution_bytes"] = footprint->execution_bytes();
+             return py_dict;
+           })
       .def("_clear_pending_irs",
            [](const std::string& device) {
              // Use with caution. Those tensor whole ir was cleared
@@ -3493,7 +4682,7 @@ void InitXlaModuleBindings(py::module m) {
              // NOT be accessed.
              ClearPendingIrs(device);
              auto xla_device = GetDeviceOrCurrent(device);
-             SetAllReduceToken(xla_device, nullptr);
+             ResetAllReduceTokens(xla_device);
            })
       .def("_unique_id_for_ir_and_data",
            [](const at::Tensor& tensor) -> std::string {
@@ -3510,31 +4699,60 @@ void InitXlaModuleBindings(py::module m) {
                return std::to_string((uintptr_t)xtensor.get());
              }
            })
-      .def("_run_cached_graph",
-           [](const std::string& hash_str,
-              const std::vector<at::IValue>& graph_inputs)
-               -> std::vector<at::Tensor> {
-             XLA_CHECK(hash_str.size() == sizeof(torch::lazy::hash_t));
-             torch::lazy::hash_t hash =
-                 *(torch::lazy::hash_t*)(hash_str.c_str());
-             // Device will be Virtual device if SPMD is enabled.
-             torch::lazy::BackendDevice device =
-                 torch_xla::bridge::GetCurrentDevice();
-             auto results =
-                 XLAGraphExecutor::Get()->ExecuteComputationWithBarrier(
-                     hash, graph_inputs, device);
-             std::vector<at::Tensor> retlist;
-             {
-               TORCH_LAZY_TIMED("RunCachedGraphOutputData");
-               // Convert result back to at::tensor
-               for (const auto& data : results) {
-                 XLATensorPtr xla_tensor = torch_xla::XLATensor::Create(data);
-                 retlist.push_back(bridge::AtenFromXlaTensor(xla_tensor));
-               }
-             }
+      .def(
+          "_run_cached_graph",
+          [](const std::string& hash_str,
+             const std::vector<at::IValue>& graph_inputs,
+             bool sync_inputs) -> std::vector<at::Tensor> {
+            XLA_CHECK(hash_str.size() == sizeof(torch::lazy::hash_t));
+            torch::lazy::hash_t hash =
+                *(torch::lazy::hash_t*)(hash_str.c_str());
+            // Device will be Virtual device if SPMD is enabled.
+            torch::lazy::BackendDevice device =
+                torch_xla::bridge::GetCurrentDevice();
+            if (sync_inputs) {
+              // Materializes the inputs holding pending IR in the same call,
+              // rather than through separate checks and syncs from Python.
+              std::vector<XLATensorPtr> xtensors;
+              xtensors.reserve(graph_inputs.size());
+              for (const at::IValue& ivalue : graph_inputs) {
+                xtensors.push_back(bridge::GetXlaTensor(ivalue.toTensor())
+                                       .value_or(XLATensorPtr{}));
+              }
+              std::vector<bool> need_materialization =
+                  check_materialization_helper(xtensors);
+              std::vector<XLATensorPtr> pending;
+              for (size_t i = 0; i < xtensors.size(); ++i) {
+                if (need_materialization[i]) {
+                  pending.push_back(xtensors[i]);
+                }
+              }
+              if (!pending.empty()) {
+                TORCH_LAZY_COUNTER("DynamoSyncInputExecuteTime", 1);
+                NoGilSection nogil;
+                XLAGraphExecutor::Get()->SyncTensorsGraph(
+                    &pending, {}, /*wait=*/true, /*sync_ltc_data=*/true);
+              }
+            }
+            auto results =
+                XLAGraphExecutor::Get()->ExecuteComputationWithBarrier(
+                    hash, graph_inputs, device);
+            std::vector<at::Tensor> retlist;
+            {
+              TORCH_LAZY_TIMED("RunCachedGraphOutputData");
+              // Convert result back to at::tensor
+              for (const auto& data : results) {
+                XLATensorPtr xla_tensor = torch_xla::XLATensor::Create(data);
+                retlist.push_back(bridge::AtenFromXlaTensor(xla_tensor));
+              }
+            }
 
-             return retlist;
-           })  // -----------Dynamo Integration API End-----------------------
+            return retlist;
+          },
+          py::arg("hash_str"),      //
+          py::arg("graph_inputs"),  //
+          py::arg("sync_inputs") = false)
+      // -----------Dynamo Integration API End-----------------------
       .def("_register_pjrt_plugin",
            [](std::string name,
               std::shared_ptr<const runtime::PjRtPlugin> plugin) {
@@ -1,23 +1,30 @@
 #include "torch_xla/csrc/ir.h"
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
+#include <mutex>
+#include <optional>
 #include <sstream>
 
 #include <torch/csrc/lazy/core/config.h>
 #include <torch/csrc/lazy/core/hash.h>
 #include <torch/csrc/lazy/core/ir_metadata.h>
+#include <torch/csrc/lazy/core/metrics.h>
 #include <torch/csrc/lazy/python/python_util.h>
 
+#include "absl/hash/hash.h"
 #include "absl/log/absl_log.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
 
 #include "torch_xla/csrc/lowering_context.h"
 #include "torch_xla/csrc/runtime/cache.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/trace_profiler.h"
 
 namespace torch_xla {
 namespace {
@@ -46,8 +53,94 @@ torch::lazy::hash_t GetOperandHashes(const torch::lazy::OpList& operands,
   return hash;
 }
 
+// Identifies the output shape of a node by what it depends on: its op and
+// attributes, which the node hash covers, and the shapes of its operands.
+// Unlike the DAG hash, it is shared by the nodes computing the same op over the
+// same shapes, whatever their operands compute.
+torch::lazy::hash_t GetShapeCacheKey(
+    const std::vector<torch::lazy::Output>& operands,
+    const torch::lazy::hash_t& node_hash) {
+  torch::lazy::hash_t key = node_hash;
+  for (const torch::lazy::Output& operand : operands) {
+    const XlaNode* xla_node = dynamic_cast<const XlaNode*>(operand.node);
+    if (xla_node == nullptr) {
+      key = torch::lazy::HashCombine(key, operand.hash());
+      continue;
+    }
+    key = torch::lazy::HashCombine(
+        key, absl::HashOf(xla_node->xla_shape(operand.index)));
+  }
+  return key;
+}
+
+// The op of the XlaNode being constructed on this thread, for the Python
+// frames function called by the torch::lazy::Node constructor, which reads
+// and resets it.
+thread_local std::optional<c10::Symbol> constructing_op;
+
+// When the XlaNode being constructed on this thread started, for the trace
+// profiler, or 0.
+thread_local int64_t node_creation_start_ns = 0;
+
+const torch::lazy::OpKind& SetConstructingOp(const torch::lazy::OpKind& op) {
+  constructing_op = op.op;
+  node_creation_start_ns =
+      trace_profiler::Enabled() ? runtime::sys_util::NowNs() : 0;
+  return op;
+}
+
+void RecordNodeCreation(const torch::lazy::OpKind& op) {
+  if (node_creation_start_ns != 0) {
+    trace_profiler::Record(trace_profiler::Category::kNodeCreation, op.op,
+                           runtime::sys_util::NowNs() - node_creation_start_ns);
+    node_creation_start_ns = 0;
+  }
+}
+
+bool ShouldCapturePythonFrames(std::optional<c10::Symbol> op) {
+  static const std::unordered_set<c10::Symbol>* op_kinds = []() {
+    auto* op_kinds = new std::unordered_set<c10::Symbol>();
+    std::string names =
+        runtime::sys_util::GetEnvString("XLA_IR_DEBUG_OP_KINDS", "");
+    for (absl::string_view name :
+         absl::StrSplit(names, ',', absl::SkipEmpty())) {
+      op_kinds->insert(c10::Symbol::fromQualString(std::string(name)));
+    }
+    return op_kinds;
+  }();
+  static const int64_t sample_rate = std::max<int64_t>(
+      runtime::sys_util::GetEnvInt("XLA_IR_DEBUG_SAMPLE_RATE", 1), 1);
+  static std::atomic<int64_t> node_count(0);
+  if (!op_kinds->empty() && (!op || op_kinds->count(*op) == 0)) {
+    return false;
+  }
+  return sample_rate == 1 ||
+         node_count.fetch_add(1, std::memory_order_relaxed) % sample_rate == 0;
+}
+
 }  // namespace
 
+void MaybeSamplePythonFrames() {
+  if (runtime::sys_util::GetEnvString("XLA_IR_DEBUG_OP_KINDS", "").empty() &&
+      runtime::sys_util::GetEnvInt("XLA_IR_DEBUG_SAMPLE_RATE", 1) <= 1) {
+    return;
+  }
+  static std::once_flag sample_flag;
+  std::call_once(sample_flag, []() {
+    std::function<std::vector<torch::lazy::SourceLocation>()> python_frames =
+        torch::lazy::GetPythonFramesFunction();
+    torch::lazy::GetPythonFramesFunction() =
+        [python_frames]() -> std::vector<torch::lazy::SourceLocation> {
+      std::optional<c10::Symbol> op = constructing_op;
+      constructing_op.reset();
+      if (!python_frames || !ShouldCapturePythonFrames(op)) {
+        return {};
+      }
+      return python_frames();
+    };
+  });
+}
+
 void DetectDynamicShape(torch::lazy::NodePtr node) {
   DynamicShapeDetector* detector = DynamicShapeDetector::Get();
 
@@ -67,29 +160,36 @@ void DetectDynamicShape(torch::lazy::NodePtr node) {
 XlaNode::XlaNode(torch::lazy::OpKind op, torch::lazy::OpList operands,
                  std::vector<torch::lazy::Shape>&& shapes, xla::Shape xla_shape,
                  size_t num_outputs, torch::lazy::hash_t hash_seed)
-    : torch::lazy::Node(op, operands, std::move(shapes), num_outputs),
+    : torch::lazy::Node(SetConstructingOp(op), operands, std::move(shapes),
+                        num_outputs),
       xla_shape_(std::move(xla_shape)),
       node_hash_(torch::lazy::HashCombine(op.hash(), hash_seed)),
-      dag_hash_(GetOperandHashes(operands, node_hash_)) {}
+      dag_hash_(GetOperandHashes(operands, node_hash_)) {
+  RecordNodeCreation(op);
+}
 
 XlaNode::XlaNode(torch::lazy::OpKind op, torch::lazy::OpList operands,
                  std::vector<torch::lazy::Shape>&& shapes,
                  const std::function<xla::Shape()>& xla_shape_fn,
                  size_t num_outputs, torch::lazy::hash_t hash_seed)
-    : torch::lazy::Node(op, operands, std::move(shapes), num_outputs),
+    : torch::lazy::Node(SetConstructingOp(op), operands, std::move(shapes),
+                        num_outputs),
       node_hash_(torch::lazy::HashCombine(op.hash(), hash_seed)),
       dag_hash_(GetOperandHashes(operands, node_hash_)) {
+  RecordNodeCreation(op);
   xla_shape_ = GetOpShape(xla_shape_fn);
 }
 
 XlaNode::XlaNode(torch::lazy::OpKind op, torch::lazy::OpList operands,
                  torch::lazy::Shape shape, xla::Shape xla_shape,
                  size_t num_outputs, torch::lazy::hash_t hash_seed)
-    : torch::lazy::Node(op, operands, std::vector<torch::lazy::Shape>{shape},
-                        num_outputs),
+    : torch::lazy::Node(SetConstructingOp(op), operands,
+                        std::vector<torch::lazy::Shape>{shape}, num_outputs),
       xla_shape_(std::move(xla_shape)),
       node_hash_(torch::lazy::HashCombine(op.hash(), hash_seed)),
-      dag_hash_(GetOperandHashes(operands, node_hash_)) {}
+      dag_hash_(GetOperandHashes(operands, node_hash_)) {
+  RecordNodeCreation(op);
+}
 
 XlaNode::XlaNode(torch::lazy::OpKind op, torch::lazy::OpList operands,
                  xla::Shape xla_shape, size_t num_outputs,
@@ -104,7 +204,11 @@ XlaNode::XlaNode(torch::lazy::OpKind op, torch::lazy::OpList operands,
     : XlaNode(std::move(op), operands, xla::Shape(), num_outputs, hash_seed) {
   // Forward the constructor to the one above (with empty shape), so we have the
   // full hash information, then fetch/compute the real shape.
-  addComputedShape(shape_fn);
+  {
+    trace_profiler::ScopedTimer timer(
+        trace_profiler::Category::kShapeInference, this->op().op);
+    addComputedShape(shape_fn);
+  }
   xla_shape_ = GetOpShape(xla_shape_fn);
 }
 
@@ -120,10 +224,12 @@ XlaNode::XlaNode(torch::lazy::OpKind op, torch::lazy::OpList operands,
 XlaNode::XlaNode(torch::lazy::OpKind op, torch::lazy::Shape shape,
                  xla::Shape xla_shape, size_t num_outputs,
                  torch::lazy::hash_t hash_seed)
-    : torch::lazy::Node(op, shape, num_outputs),
+    : torch::lazy::Node(SetConstructingOp(op), shape, num_outputs),
       xla_shape_(std::move(xla_shape)),
       node_hash_(GetOpHash(op, xla_shape_, hash_seed)),
-      dag_hash_(node_hash_) {}
+      dag_hash_(node_hash_) {
+  RecordNodeCreation(op);
+}
 
 XlaNode::XlaNode(torch::lazy::OpKind op, xla::Shape xla_shape,
                  size_t num_outputs, torch::lazy::hash_t hash_seed)
@@ -225,16 +331,21 @@ void XlaNode::SetSharding(const xla::OpSharding& sharding, size_t index) {
         std::vector<std::shared_ptr<xla::OpSharding>>(num_outputs(), nullptr);
   }
   output_shardings_[index] = std::make_shared<xla::OpSharding>(sharding);
-  // TODO(JackCaoG): fix this hashing
-  UpdateShardingHash();
+  sharding_hash_stale_ = true;
 }
 
 xla::Shape XlaNode::GetOpShape(
     const std::function<xla::Shape()>& shape_fn) const {
+  trace_profiler::ScopedTimer timer(trace_profiler::Category::kShapeInference,
+                                    op().op);
   ShapeCache* shape_cache = GetShapeCache();
-  auto shape = shape_cache->Get(hash());
+  torch::lazy::hash_t key = GetShapeCacheKey(operands(), node_hash());
+  auto shape = shape_cache->Get(key);
   if (shape == nullptr) {
-    shape = shape_cache->Add(hash(), std::make_shared<xla::Shape>(shape_fn()));
+    TORCH_LAZY_COUNTER("IrShapeCacheMiss", 1);
+    shape = shape_cache->Add(key, std::make_shared<xla::Shape>(shape_fn()));
+  } else {
+    TORCH_LAZY_COUNTER("IrShapeCacheHit", 1);
   }
   return *shape;
 }
@@ -254,7 +365,8 @@ const xla::Shape& GetXlaShape(const torch::lazy::Value& value) {
 
 // The sharding hash is only based on relevant fields from the xla::OpSharding
 // object. We skip the field that's irrelevant, which is the layout.
-void XlaNode::UpdateShardingHash() {
+void XlaNode::UpdateShardingHash() const {
+  sharding_hash_stale_ = false;
   sharding_hash_ = node_hash_;
   for (size_t i = 0; i < output_shardings_.size(); i++) {
     // keep the index as part of the hash
@@ -1,12 +1,12 @@
 #ifndef XLA_TORCH_XLA_CSRC_IR_H_
 #define XLA_TORCH_XLA_CSRC_IR_H_
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -22,6 +22,7 @@
 #include "xla/hlo/builder/xla_builder.h"
 
 #include "torch_xla/csrc/dynamic_shape_detector.h"
+#include "torch_xla/csrc/ir_node_pool.h"
 #include "torch_xla/csrc/runtime/types.h"
 
 namespace torch_xla {
@@ -35,9 +36,18 @@ using XlaOpVector = absl::InlinedVector<xla::XlaOp, 1>;
 
 void DetectDynamicShape(torch::lazy::NodePtr node);
 
+// When the nodes capture their Python frames (XLA_IR_DEBUG), only captures
+// them for the nodes of the op kinds in $XLA_IR_DEBUG_OP_KINDS, a comma
+// separated list, if set, and then for one node out of
+// $XLA_IR_DEBUG_SAMPLE_RATE.
+void MaybeSamplePythonFrames();
+
 template <typename T, typename... Args>
 torch::lazy::NodePtr MakeNode(Args&&... args) {
-  torch::lazy::NodePtr res = std::make_shared<T>(std::forward<Args>(args)...);
+  torch::lazy::NodePtr res =
+      UseNodePool() ? std::allocate_shared<T>(NodePoolAllocator<T>(),
+                                              std::forward<Args>(args)...)
+                    : std::make_shared<T>(std::forward<Args>(args)...);
   DetectDynamicShape(res);
   return res;
 }
@@ -107,6 +117,12 @@ class XlaNode : public torch::lazy::Node {
   // multi-output node, output_index must be zero.
   const xla::Shape& xla_shape(size_t output_index) const;
 
+  // Returns the node of the operand at `index`, which, unlike the one of
+  // operand(), callers can hold on to.
+  const torch::lazy::NodePtr& operand_node(size_t index) const {
+    return operands_.at(index);
+  }
+
   virtual torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const;
 
   // Lowers the current XlaNode using `loctx`.
@@ -137,15 +153,24 @@ class XlaNode : public torch::lazy::Node {
   torch::lazy::hash_t node_hash() const { return node_hash_; }
 
   torch::lazy::hash_t hash() const override {
-    if (sharding_hash_ != 0) {
-      return torch::lazy::HashCombine(dag_hash_, sharding_hash_);
+    torch::lazy::hash_t sharding_hash = shardingHash();
+    if (sharding_hash != 0) {
+      return torch::lazy::HashCombine(dag_hash_, sharding_hash);
     }
     return dag_hash_;
   }
 
   torch::lazy::hash_t shapeHash() const override { return dag_hash_; }
 
-  torch::lazy::hash_t shardingHash() const { return sharding_hash_; }
+  // The sharding hash is computed when first needed after the shardings
+  // change, so that annotating several outputs, or annotating a node again
+  // before it is used, hashes the shardings once.
+  torch::lazy::hash_t shardingHash() const {
+    if (sharding_hash_stale_) {
+      UpdateShardingHash();
+    }
+    return sharding_hash_;
+  }
 
   // The node's outputs get assigned the same HLO sharding
   const std::shared_ptr<xla::OpSharding> GetSharding(size_t index) const {
@@ -160,15 +185,21 @@ class XlaNode : public torch::lazy::Node {
   void ClearSharding() {
     output_shardings_.clear();
     sharding_hash_ = 0;
+    sharding_hash_stale_ = false;
   }
 
   std::string ToString() const override;
 
   void MarkDynamicDimension(uint32_t dim) {
-    unbounded_dynamic_dims_.insert(dim);
+    auto it = std::lower_bound(unbounded_dynamic_dims_.begin(),
+                               unbounded_dynamic_dims_.end(), dim);
+    if (it == unbounded_dynamic_dims_.end() || *it != dim) {
+      unbounded_dynamic_dims_.insert(it, dim);
+    }
   }
 
-  const std::unordered_set<uint32_t>& dynamic_dims() const {
+  // Returns the dimensions marked dynamic, in increasing order.
+  absl::Span<const uint32_t> dynamic_dims() const {
     return unbounded_dynamic_dims_;
   }
 
@@ -176,7 +207,9 @@ class XlaNode : public torch::lazy::Node {
       std::shared_ptr<torch::lazy::UserMetaData> user_meta);
 
  protected:
-  std::unordered_set<uint32_t> unbounded_dynamic_dims_;
+  // A sorted vector rather than a set: few nodes have dynamic dimensions, and
+  // an empty vector takes less than half the memory of an empty set.
+  std::vector<uint32_t> unbounded_dynamic_dims_;
 
  private:
   xla::Shape GetOpShape(const std::function<xla::Shape()>& shape_fn) const;
@@ -187,7 +220,7 @@ class XlaNode : public torch::lazy::Node {
 
   static std::vector<torch::lazy::SourceLocation> GetFrameInfo();
 
-  void UpdateShardingHash();
+  void UpdateShardingHash() const;
 
   // Checks that the resulting lowering output is valid in 2 ways:
   //
@@ -203,10 +236,12 @@ class XlaNode : public torch::lazy::Node {
   xla::Shape xla_shape_;
   torch::lazy::hash_t node_hash_ = 0;
   torch::lazy::hash_t dag_hash_;
-  torch::lazy::hash_t sharding_hash_ = 0;
+  mutable torch::lazy::hash_t sharding_hash_ = 0;
 
   // Experimental sharding annotations attached to the IR node.
   std::vector<std::shared_ptr<xla::OpSharding>> output_shardings_;
+  // Last, so that it does not pad the hashes and the shardings.
+  mutable bool sharding_hash_stale_ = false;
 };
 
 inline std::ostream& operator<<(std::ostream& stream, const XlaNode& node) {
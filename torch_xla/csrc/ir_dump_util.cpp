@@ -256,6 +256,12 @@ std::string DumpUtil::PostOrderToText(
 std::string DumpUtil::ToHlo(c10::ArrayRef<torch::lazy::Value> values,
                             const torch::lazy::BackendDevice& device,
                             EmitMode mode) {
+  return EmitComputation(ToXlaComputation(values, device), mode);
+}
+
+xla::XlaComputation DumpUtil::ToXlaComputation(
+    c10::ArrayRef<torch::lazy::Value> values,
+    const torch::lazy::BackendDevice& device) {
   LoweringContext lowering_ctx("IrToHlo", device);
   for (auto& ir_value : values) {
     lowering_ctx.AddResult(
@@ -285,7 +291,11 @@ std::string DumpUtil::ToHlo(c10::ArrayRef<torch::lazy::Value> values,
         computations = client->Compile(std::move(instances));
     computation = std::move(computations[0]->move_computation());
   }
+  return computation;
+}
 
+std::string DumpUtil::EmitComputation(const xla::XlaComputation& computation,
+                                      EmitMode mode) {
   switch (mode) {
     case EmitMode::kHloReadable: {
       XLA_ASSIGN_OR_THROW(std::string hlo_text,
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "absl/types/span.h"
+#include "xla/hlo/builder/xla_computation.h"
 
 #include "torch_xla/csrc/device.h"
 #include "torch_xla/csrc/ir.h"
@@ -35,6 +36,15 @@ class DumpUtil {
   static std::string ToHlo(c10::ArrayRef<torch::lazy::Value> values,
                            const torch::lazy::BackendDevice& device,
                            EmitMode mode = EmitMode::kHloReadable);
+
+  // Lowers the graph of `values` as ToHlo() does, without emitting it.
+  static xla::XlaComputation ToXlaComputation(
+      c10::ArrayRef<torch::lazy::Value> values,
+      const torch::lazy::BackendDevice& device);
+
+  // Emits a computation returned by ToXlaComputation() in `mode`.
+  static std::string EmitComputation(const xla::XlaComputation& computation,
+                                     EmitMode mode);
 };
 
 }  // namespace torch_xla
@@ -0,0 +1,74 @@
+#include "torch_xla/csrc/ir_node_pool.h"
+
+#include <array>
+#include <new>
+
+#include "torch_xla/csrc/runtime/sys_util.h"
+
+namespace torch_xla {
+namespace {
+
+constexpr size_t kNumSizeClasses = kNodePoolMaxBlockSize / kNodePoolAlignment;
+constexpr size_t kSlabSize = 256 * 1024;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct ThreadPool {
+  std::array<FreeBlock*, kNumSizeClasses> free_lists{};
+  char* slab = nullptr;
+  size_t slab_left = 0;
+};
+
+thread_local ThreadPool thread_pool;
+
+size_t SizeClass(size_t size) {
+  return (size + kNodePoolAlignment - 1) / kNodePoolAlignment - 1;
+}
+
+}  // namespace
+
+bool UseNodePool() {
+  static const bool use_node_pool =
+      runtime::sys_util::GetEnvBool("XLA_IR_NODE_POOL", false);
+  return use_node_pool;
+}
+
+void* AllocateNodeMemory(size_t size) {
+  if (size == 0 || size > kNodePoolMaxBlockSize) {
+    return ::operator new(size, std::align_val_t(kNodePoolAlignment));
+  }
+  size_t size_class = SizeClass(size);
+  FreeBlock*& free_list = thread_pool.free_lists[size_class];
+  if (free_list != nullptr) {
+    FreeBlock* block = free_list;
+    free_list = block->next;
+    return block;
+  }
+  size_t block_size = (size_class + 1) * kNodePoolAlignment;
+  if (thread_pool.slab_left < block_size) {
+    // The rest of the previous slab is too small for this block, and is left
+    // unused.
+    thread_pool.slab = static_cast<char*>(
+        ::operator new(kSlabSize, std::align_val_t(kNodePoolAlignment)));
+    thread_pool.slab_left = kSlabSize;
+  }
+  void* block = thread_pool.slab;
+  thread_pool.slab += block_size;
+  thread_pool.slab_left -= block_size;
+  return block;
+}
+
+void DeallocateNodeMemory(void* ptr, size_t size) {
+  if (size == 0 || size > kNodePoolMaxBlockSize) {
+    ::operator delete(ptr, std::align_val_t(kNodePoolAlignment));
+    return;
+  }
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  FreeBlock*& free_list = thread_pool.free_lists[SizeClass(size)];
+  block->next = free_list;
+  free_list = block;
+}
+
+}  // namespace torch_xla
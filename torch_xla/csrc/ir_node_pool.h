@@ -0,0 +1,69 @@
+#ifndef XLA_TORCH_XLA_CSRC_IR_NODE_POOL_H_
+#define XLA_TORCH_XLA_CSRC_IR_NODE_POOL_H_
+
+#include <cstddef>
+#include <memory>
+
+namespace torch_xla {
+
+// Whether the IR nodes are allocated from the node pool, per
+// $XLA_IR_NODE_POOL.
+bool UseNodePool();
+
+// Returns `size` bytes aligned to `kNodePoolAlignment`. The blocks up to
+// `kNodePoolMaxBlockSize` come from the free list of their size class for the
+// calling thread, or else are carved out of a slab of the thread. The freed
+// blocks go back onto the free list of the freeing thread, so that the nodes
+// of a step reuse the memory of the nodes of the previous one, which are freed
+// when their tensors get the device data of the step, without calling malloc
+// or free. The slabs are never returned. Larger blocks use operator new.
+void* AllocateNodeMemory(size_t size);
+
+// Returns the block of `size` bytes allocated by AllocateNodeMemory().
+void DeallocateNodeMemory(void* ptr, size_t size);
+
+inline constexpr size_t kNodePoolAlignment = 16;
+inline constexpr size_t kNodePoolMaxBlockSize = 1024;
+
+// Allocator to create nodes with std::allocate_shared(), which lays out the
+// node and its control block in a single block of the node pool.
+template <typename T>
+class NodePoolAllocator {
+ public:
+  using value_type = T;
+
+  NodePoolAllocator() = default;
+
+  template <typename U>
+  NodePoolAllocator(const NodePoolAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    if constexpr (alignof(T) > kNodePoolAlignment) {
+      return std::allocator<T>().allocate(n);
+    } else {
+      return static_cast<T*>(AllocateNodeMemory(n * sizeof(T)));
+    }
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if constexpr (alignof(T) > kNodePoolAlignment) {
+      std::allocator<T>().deallocate(ptr, n);
+    } else {
+      DeallocateNodeMemory(ptr, n * sizeof(T));
+    }
+  }
+
+  template <typename U>
+  bool operator==(const NodePoolAllocator<U>&) const {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const NodePoolAllocator<U>&) const {
+    return false;
+  }
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_IR_NODE_POOL_H_
@@ -0,0 +1,289 @@
+#include "torch_xla/csrc/ir_simplification.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <c10/core/Scalar.h>
+#include <torch/csrc/lazy/core/hash.h>
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/hash/hash.h"
+#include "xla/shape.h"
+
+#include "torch_xla/csrc/ir.h"
+#include "torch_xla/csrc/ops/device_data.h"
+#include "torch_xla/csrc/ops/scalar.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/status.h"
+
+namespace torch_xla {
+namespace {
+
+// The ops whose nodes are not only functions of their operands: the
+// collectives, which issue a transfer each, and the custom calls, which may
+// have side effects.
+bool IsUnique(const torch::lazy::Node* node) {
+  const torch::lazy::OpKind& op = node->op();
+  return op == xla_all_gather || op == xla_all_to_all ||
+         op == xla_collective_permute || op == xla_cross_replica_sum ||
+         op == xla_reduce_scatter || op == xla_send || op == xla_recv ||
+         op == xla_custom_call || op == xla_tpu_custom_call ||
+         op == xla_optimization_barrier || op == xla_mark_tensor ||
+         op == xla_custom_sharding || op == xla_not_supported;
+}
+
+std::optional<torch::lazy::BackendData::Handle> GetDataHandle(
+    const DeviceData* device_data) {
+  absl::StatusOr<runtime::ComputationClient::DataPtr> data =
+      runtime::AsComputationClientData(device_data->data());
+  if (!data.ok()) {
+    return std::nullopt;
+  }
+  absl::StatusOr<torch::lazy::BackendData::Handle> handle =
+      (*data)->SafeGetHandle();
+  if (!handle.ok()) {
+    return std::nullopt;
+  }
+  return *handle;
+}
+
+// Folds the binary arithmetic op `op` over two scalars of `type`. Only the
+// 32 and 64 bit integers and floats are folded, in their own precision, and
+// the integer divisions are left to XLA.
+std::optional<at::Scalar> FoldScalars(const torch::lazy::OpKind& op,
+                                      const at::Scalar& lhs,
+                                      const at::Scalar& rhs,
+                                      xla::PrimitiveType type) {
+  switch (type) {
+    case xla::PrimitiveType::S32:
+    case xla::PrimitiveType::S64: {
+      // The products and sums wrap around, as they do on the device.
+      uint64_t a = static_cast<uint64_t>(lhs.toLong());
+      uint64_t b = static_cast<uint64_t>(rhs.toLong());
+      if (type == xla::PrimitiveType::S32) {
+        a = static_cast<uint64_t>(static_cast<int32_t>(a));
+        b = static_cast<uint64_t>(static_cast<int32_t>(b));
+      }
+      uint64_t result;
+      if (op == torch::lazy::OpKind(at::aten::add)) {
+        result = a + b;
+      } else if (op == torch::lazy::OpKind(at::aten::sub)) {
+        result = a - b;
+      } else if (op == torch::lazy::OpKind(at::aten::mul)) {
+        result = a * b;
+      } else {
+        return std::nullopt;
+      }
+      if (type == xla::PrimitiveType::S32) {
+        return at::Scalar(static_cast<int64_t>(static_cast<int32_t>(result)));
+      }
+      return at::Scalar(static_cast<int64_t>(result));
+    }
+    case xla::PrimitiveType::F32:
+    case xla::PrimitiveType::F64: {
+      double a = lhs.toDouble();
+      double b = rhs.toDouble();
+      if (type == xla::PrimitiveType::F32) {
+        a = static_cast<float>(a);
+        b = static_cast<float>(b);
+      }
+      double result;
+      if (op == torch::lazy::OpKind(at::aten::add)) {
+        result = a + b;
+      } else if (op == torch::lazy::OpKind(at::aten::sub)) {
+        result = a - b;
+      } else if (op == torch::lazy::OpKind(at::aten::mul)) {
+        result = a * b;
+      } else if (op == torch::lazy::OpKind(at::aten::div)) {
+        result = a / b;
+      } else {
+        return std::nullopt;
+      }
+      // The double result of an op over floats rounds to the float result.
+      if (type == xla::PrimitiveType::F32) {
+        result = static_cast<float>(result);
+      }
+      return at::Scalar(result);
+    }
+    default:
+      return std::nullopt;
+  }
+}
+
+class Simplifier {
+ public:
+  IrSimplification Run(c10::ArrayRef<const torch::lazy::Node*> post_order) {
+    for (const torch::lazy::Node* node : post_order) {
+      const XlaNode* xla_node = dynamic_cast<const XlaNode*>(node);
+      if (xla_node == nullptr || xla_node->shardingHash() != 0 ||
+          !xla_node->dynamic_dims().empty()) {
+        continue;
+      }
+      if (!Fold(xla_node)) {
+        Deduplicate(xla_node);
+      }
+    }
+    return std::move(result_);
+  }
+
+ private:
+  const torch::lazy::Node* Original(const torch::lazy::Node* node) const {
+    auto it = result_.duplicates.find(node);
+    return it != result_.duplicates.end() ? it->second : node;
+  }
+
+  const Scalar* AsScalar(const torch::lazy::Output& output) const {
+    auto it = result_.folded.find(output.node);
+    if (it != result_.folded.end()) {
+      return dynamic_cast<const Scalar*>(it->second.get());
+    }
+    return dynamic_cast<const Scalar*>(Original(output.node));
+  }
+
+  bool Fold(const XlaNode* node) {
+    if (node->operands().size() != 2 || node->num_outputs() != 1) {
+      return false;
+    }
+    const Scalar* lhs = AsScalar(node->operand(0));
+    const Scalar* rhs = AsScalar(node->operand(1));
+    const xla::Shape& shape = node->xla_shape();
+    if (lhs == nullptr || rhs == nullptr || lhs->xla_shape() != shape ||
+        rhs->xla_shape() != shape) {
+      return false;
+    }
+    std::optional<at::Scalar> value = FoldScalars(
+        node->op(), lhs->value(), rhs->value(), shape.element_type());
+    if (!value) {
+      return false;
+    }
+    result_.folded.emplace(node, MakeNode<Scalar>(*value, shape));
+    return true;
+  }
+
+  void Deduplicate(const XlaNode* node) {
+    if (IsUnique(node)) {
+      return;
+    }
+    const DeviceData* device_data = DeviceData::Cast(node);
+    if (device_data != nullptr) {
+      std::optional<torch::lazy::BackendData::Handle> handle =
+          GetDataHandle(device_data);
+      if (handle) {
+        auto it = device_data_.emplace(*handle, node).first;
+        if (it->second != node) {
+          result_.duplicates.emplace(node, it->second);
+        }
+      }
+      return;
+    }
+
+    std::vector<torch::lazy::Output> operands;
+    operands.reserve(node->operands().size());
+    torch::lazy::hash_t key = torch::lazy::HashCombine(
+        node->node_hash(), absl::HashOf(node->xla_shape()));
+    for (const torch::lazy::Output& operand : node->operands()) {
+      if (result_.folded.count(operand.node) > 0) {
+        // The folded scalars are lowered on their own, so their users are not
+        // compared to each other.
+        return;
+      }
+      const torch::lazy::Node* original = Original(operand.node);
+      operands.emplace_back(original, operand.index);
+      key = torch::lazy::HashCombine(
+          key, absl::HashOf(reinterpret_cast<uintptr_t>(original),
+                            operand.index));
+    }
+    std::vector<const XlaNode*>& candidates = candidates_[key];
+    for (const XlaNode* candidate : candidates) {
+      if (IsSame(candidate, node, operands)) {
+        result_.duplicates.emplace(node, candidate);
+        return;
+      }
+    }
+    candidates.push_back(node);
+  }
+
+  bool IsSame(const XlaNode* candidate, const XlaNode* node,
+              const std::vector<torch::lazy::Output>& operands) const {
+    if (candidate->op() != node->op() ||
+        candidate->node_hash() != node->node_hash() ||
+        candidate->num_outputs() != node->num_outputs() ||
+        candidate->operands().size() != operands.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < node->num_outputs(); ++i) {
+      if (candidate->xla_shape(i) != node->xla_shape(i)) {
+        return false;
+      }
+    }
+    for (size_t i = 0; i < operands.size(); ++i) {
+      const torch::lazy::Output& operand = candidate->operand(i);
+      if (Original(operand.node) != operands[i].node ||
+          operand.index != operands[i].index) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  IrSimplification result_;
+  std::unordered_map<torch::lazy::BackendData::Handle, const XlaNode*>
+      device_data_;
+  std::unordered_map<torch::lazy::hash_t, std::vector<const XlaNode*>,
+                     torch::lazy::HashReducer>
+      candidates_;
+};
+
+}  // namespace
+
+bool UseIrSimplification() {
+  static const bool use_ir_simplification =
+      runtime::sys_util::GetEnvBool("XLA_IR_SIMPLIFY", false);
+  return use_ir_simplification;
+}
+
+IrSimplification SimplifyPostOrder(
+    c10::ArrayRef<const torch::lazy::Node*> post_order) {
+  IrSimplification simplification = Simplifier().Run(post_order);
+  size_t saved =
+      simplification.duplicates.size() + simplification.folded.size();
+  TORCH_LAZY_VALUE_METRIC("IrSimplifiedNodes", saved);
+  if (!simplification.duplicates.empty()) {
+    TORCH_LAZY_COUNTER("IrDeduplicatedNodes",
+                       simplification.duplicates.size());
+  }
+  if (!simplification.folded.empty()) {
+    TORCH_LAZY_COUNTER("IrFoldedNodes", simplification.folded.size());
+  }
+  return simplification;
+}
+
+absl::StatusOr<bool> LowerSimplified(const torch::lazy::Node& node,
+                                     const IrSimplification& simplification,
+                                     LoweringContext* loctx) {
+  auto duplicate_it = simplification.duplicates.find(&node);
+  if (duplicate_it != simplification.duplicates.end()) {
+    for (size_t i = 0; i < node.num_outputs(); ++i) {
+      XLA_ASSIGN_OR_RETURN(xla::XlaOp op,
+                           loctx->SafeGetOutputOp(
+                               torch::lazy::Output(duplicate_it->second, i)));
+      loctx->AssignOutputOp(torch::lazy::Output(&node, i), op);
+    }
+    return true;
+  }
+  auto folded_it = simplification.folded.find(&node);
+  if (folded_it != simplification.folded.end()) {
+    XLA_ASSIGN_OR_RETURN(XlaOpVector ops,
+                         loctx->LowerNode(*folded_it->second));
+    loctx->AssignOutputOp(torch::lazy::Output(&node, 0), ops.front());
+    return true;
+  }
+  return false;
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,45 @@
+#ifndef XLA_TORCH_XLA_CSRC_IR_SIMPLIFICATION_H_
+#define XLA_TORCH_XLA_CSRC_IR_SIMPLIFICATION_H_
+
+#include <unordered_map>
+
+#include <c10/util/ArrayRef.h>
+#include <torch/csrc/lazy/core/ir.h>
+
+#include "absl/status/statusor.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+
+namespace torch_xla {
+
+// Whether the post orders are simplified before they are lowered, per
+// $XLA_IR_SIMPLIFY.
+bool UseIrSimplification();
+
+// The nodes of a post order which need not be lowered on their own.
+struct IrSimplification {
+  // Maps the nodes with the same op, attributes, shape and operands as an
+  // earlier node of the post order to that node. The device data nodes of the
+  // same data are duplicates too. The collectives, the custom calls, and the
+  // nodes carrying shardings or dynamic dimensions are never duplicates.
+  std::unordered_map<const torch::lazy::Node*, const torch::lazy::Node*>
+      duplicates;
+  // Maps the additions, subtractions, multiplications and divisions of scalars
+  // to the scalar of their result.
+  std::unordered_map<const torch::lazy::Node*, torch::lazy::NodePtr> folded;
+};
+
+// Finds the duplicate and the constant nodes of `post_order`, and records the
+// number of nodes saved in the IrSimplifiedNodes metric.
+IrSimplification SimplifyPostOrder(
+    c10::ArrayRef<const torch::lazy::Node*> post_order);
+
+// Lowers `node` to the outputs of its original, or to its folded scalar, if it
+// has one in `simplification`. Returns whether it did.
+absl::StatusOr<bool> LowerSimplified(const torch::lazy::Node& node,
+                                     const IrSimplification& simplification,
+                                     LoweringContext* loctx);
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_IR_SIMPLIFICATION_H_
@@ -0,0 +1,164 @@
+#include "torch_xla/csrc/layer_norm.h"
+
+#include <vector>
+
+#include "xla/hlo/builder/lib/constants.h"
+#include "xla/primitive_util.h"
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/helpers.h"
+#include "torch_xla/csrc/shape_helper.h"
+
+namespace torch_xla {
+namespace {
+
+// The dimensions of the input which are normalized, and the other ones.
+struct NormDims {
+  std::vector<int64_t> outer_dims;
+  std::vector<int64_t> normalized_dims;
+  // The sizes of the outer dimensions, and the shape of the statistics.
+  std::vector<int64_t> outer_sizes;
+  std::vector<int64_t> stat_sizes;
+  int64_t normalized_count = 1;
+};
+
+NormDims GetNormDims(const xla::Shape& shape, int64_t normalized_ndim) {
+  NormDims dims;
+  int64_t rank = shape.dimensions_size();
+  for (int64_t i = 0; i < rank; ++i) {
+    if (i < rank - normalized_ndim) {
+      dims.outer_dims.push_back(i);
+      dims.outer_sizes.push_back(shape.dimensions(i));
+      dims.stat_sizes.push_back(shape.dimensions(i));
+    } else {
+      dims.normalized_dims.push_back(i);
+      dims.stat_sizes.push_back(1);
+      dims.normalized_count *= shape.dimensions(i);
+    }
+  }
+  return dims;
+}
+
+// The half precision inputs are normalized in F32.
+xla::PrimitiveType GetComputeType(xla::PrimitiveType type) {
+  return xla::primitive_util::BitWidth(type) < 32 ? xla::PrimitiveType::F32
+                                                  : type;
+}
+
+xla::XlaOp ReduceSum(xla::XlaOp input, absl::Span<const int64_t> dims) {
+  xla::PrimitiveType type = ShapeHelper::ShapeOfXlaOp(input).element_type();
+  return xla::Reduce(input, xla::Zero(input.builder(), type),
+                     XlaHelpers::CreateAddComputation(type), dims);
+}
+
+xla::XlaOp ReduceMean(xla::XlaOp input, const NormDims& dims) {
+  xla::PrimitiveType type = ShapeHelper::ShapeOfXlaOp(input).element_type();
+  return ReduceSum(input, dims.normalized_dims) /
+         XlaHelpers::ScalarValue<double>(
+             static_cast<double>(dims.normalized_count), type,
+             input.builder());
+}
+
+// Broadcasts the per row statistics "stat" to the shape of the input.
+xla::XlaOp BroadcastStat(xla::XlaOp stat, const xla::Shape& shape,
+                         const NormDims& dims) {
+  return xla::BroadcastInDim(stat, shape.dimensions(), dims.outer_dims);
+}
+
+// Broadcasts "param", of the shape of the normalized dimensions, to the shape
+// of the input, in "type".
+xla::XlaOp BroadcastParam(xla::XlaOp param, const xla::Shape& shape,
+                          const NormDims& dims, xla::PrimitiveType type) {
+  return xla::BroadcastInDim(xla::ConvertElementType(param, type),
+                             shape.dimensions(), dims.normalized_dims);
+}
+
+}  // namespace
+
+LayerNormOutput BuildLayerNorm(xla::XlaOp input, xla::XlaOp weight,
+                               xla::XlaOp bias, int64_t normalized_ndim,
+                               double eps, bool center) {
+  const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
+  xla::PrimitiveType type = GetComputeType(input_shape.element_type());
+  xla::Shape shape = xla::ShapeUtil::ChangeElementType(input_shape, type);
+  NormDims dims = GetNormDims(input_shape, normalized_ndim);
+  xla::XlaOp x = xla::ConvertElementType(input, type);
+
+  LayerNormOutput result;
+  if (center) {
+    xla::XlaOp mean = ReduceMean(x, dims);
+    x = x - BroadcastStat(mean, shape, dims);
+    result.mean = xla::Reshape(mean, dims.stat_sizes);
+  }
+  xla::XlaOp rstd = xla::Rsqrt(
+      ReduceMean(x * x, dims) +
+      XlaHelpers::ScalarValue<double>(eps, type, input.builder()));
+  xla::XlaOp output = x * BroadcastStat(rstd, shape, dims);
+  if (weight.valid()) {
+    output = output * BroadcastParam(weight, shape, dims, type);
+  }
+  if (bias.valid()) {
+    output = output + BroadcastParam(bias, shape, dims, type);
+  }
+  result.output = xla::ConvertElementType(output, input_shape.element_type());
+  result.rstd = xla::Reshape(rstd, dims.stat_sizes);
+  return result;
+}
+
+LayerNormGrads BuildLayerNormBackward(xla::XlaOp grad, xla::XlaOp input,
+                                      xla::XlaOp mean, xla::XlaOp rstd,
+                                      xla::XlaOp weight,
+                                      int64_t normalized_ndim, bool center) {
+  const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
+  xla::PrimitiveType type = GetComputeType(input_shape.element_type());
+  xla::Shape shape = xla::ShapeUtil::ChangeElementType(input_shape, type);
+  NormDims dims = GetNormDims(input_shape, normalized_ndim);
+  xla::XlaOp x = xla::ConvertElementType(input, type);
+  xla::XlaOp grad_output = xla::ConvertElementType(grad, type);
+  xla::XlaOp rstd_rows = BroadcastStat(
+      xla::Reshape(xla::ConvertElementType(rstd, type), dims.outer_sizes),
+      shape, dims);
+  if (center) {
+    x = x - BroadcastStat(xla::Reshape(xla::ConvertElementType(mean, type),
+                                       dims.outer_sizes),
+                          shape, dims);
+  }
+  xla::XlaOp normalized = x * rstd_rows;
+
+  // With g the gradient of the normalized input, the gradient of the input is
+  // rstd * (g - mean(g) - normalized * mean(g * normalized)), without the
+  // mean(g) term for an RMSNorm.
+  xla::XlaOp grad_normalized = grad_output;
+  if (weight.valid()) {
+    grad_normalized =
+        grad_normalized * BroadcastParam(weight, shape, dims, type);
+  }
+  xla::XlaOp grad_input =
+      grad_normalized -
+      normalized *
+          BroadcastStat(ReduceMean(grad_normalized * normalized, dims), shape,
+                        dims);
+  if (center) {
+    grad_input =
+        grad_input - BroadcastStat(ReduceMean(grad_normalized, dims), shape,
+                                   dims);
+  }
+
+  LayerNormGrads grads;
+  grads.grad_input = xla::ConvertElementType(grad_input * rstd_rows,
+                                             input_shape.element_type());
+  // The gradients of the parameters are in their own type, which is the one
+  // of the input without them.
+  xla::PrimitiveType param_type =
+      weight.valid() ? ShapeHelper::ShapeOfXlaOp(weight).element_type()
+                     : input_shape.element_type();
+  grads.grad_weight = xla::ConvertElementType(
+      ReduceSum(grad_output * normalized, dims.outer_dims), param_type);
+  if (center) {
+    grads.grad_bias = xla::ConvertElementType(
+        ReduceSum(grad_output, dims.outer_dims), param_type);
+  }
+  return grads;
+}
+
+}  // namespace torch_xla
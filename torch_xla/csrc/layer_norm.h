@@ -0,0 +1,43 @@
+#ifndef XLA_TORCH_XLA_CSRC_LAYER_NORM_H_
+#define XLA_TORCH_XLA_CSRC_LAYER_NORM_H_
+
+#include <cstdint>
+
+#include "xla/hlo/builder/xla_builder.h"
+
+namespace torch_xla {
+
+struct LayerNormOutput {
+  xla::XlaOp output;
+  // Not set for an RMSNorm.
+  xla::XlaOp mean;
+  xla::XlaOp rstd;
+};
+
+struct LayerNormGrads {
+  xla::XlaOp grad_input;
+  xla::XlaOp grad_weight;
+  // Not set for an RMSNorm.
+  xla::XlaOp grad_bias;
+};
+
+// Normalizes "input" over its last "normalized_ndim" dimensions, and scales
+// it by "weight" and shifts it by "bias", which have the shape of those
+// dimensions. With "center" it is a LayerNorm; without it an RMSNorm, which
+// divides by the root mean square and has no mean and no "bias". The
+// statistics are computed in F32 for the half precision inputs, and returned
+// in that type with the shape of "input" whose normalized dimensions are 1.
+LayerNormOutput BuildLayerNorm(xla::XlaOp input, xla::XlaOp weight,
+                               xla::XlaOp bias, int64_t normalized_ndim,
+                               double eps, bool center);
+
+// Builds the gradients of BuildLayerNorm() from the saved "mean" and "rstd",
+// in a single pass over "grad" and "input".
+LayerNormGrads BuildLayerNormBackward(xla::XlaOp grad, xla::XlaOp input,
+                                      xla::XlaOp mean, xla::XlaOp rstd,
+                                      xla::XlaOp weight,
+                                      int64_t normalized_ndim, bool center);
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_LAYER_NORM_H_
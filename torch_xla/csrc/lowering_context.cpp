@@ -1,11 +1,11 @@
 #include "torch_xla/csrc/lowering_context.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -34,6 +34,7 @@
 #include "torch_xla/csrc/shape_helper.h"
 #include "torch_xla/csrc/stack_frame_index_builder.h"
 #include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/trace_profiler.h"
 
 namespace torch_xla {
 namespace {
@@ -113,7 +114,7 @@ class HloMetadataSetter {
 };
 
 absl::Status CheckEmptyUnboundedDynamicDims(
-    const std::unordered_set<uint32_t>& unbounded_dynamic_dims) {
+    absl::Span<const uint32_t> unbounded_dynamic_dims) {
   if (!unbounded_dynamic_dims.empty()) {
     return XLA_ERROR_WITH_LOCATION(absl::InternalError(absl::StrCat(
         "expected no unbounded dynamic dims, but got: { ",
@@ -145,7 +146,7 @@ LoweringContext::LoweringContext(
 
 absl::StatusOr<xla::XlaOp> LoweringContext::GetParameter(
     const torch::lazy::BackendDataPtr& backend_data,
-    const std::unordered_set<uint32_t>& unbounded_dynamic_dims) {
+    absl::Span<const uint32_t> unbounded_dynamic_dims) {
   XLA_ASSIGN_OR_RETURN(absl_nonnull runtime::ComputationClient::DataPtr data,
                        runtime::AsComputationClientData(backend_data));
   XLA_ASSIGN_OR_RETURN(const torch::lazy::BackendData::Handle handle,
@@ -250,6 +251,14 @@ absl::StatusOr<xla::XlaComputation> LoweringContext::BuildXla(
 void LoweringContext::AssignOutputOp(const torch::lazy::Output& output,
                                      const xla::XlaOp op) {
   emitted_outputs_[output] = op;
+  const XlaNode* const casted = dynamic_cast<const XlaNode*>(output.node);
+  if (casted != nullptr) {
+    const std::shared_ptr<xla::OpSharding> sharding =
+        casted->GetSharding(output.index);
+    if (sharding != nullptr && sharding->type() != xla::OpSharding::UNKNOWN) {
+      sharded_outputs_[output] = op;
+    }
+  }
 }
 
 xla::XlaOp LoweringContext::GetOutputOp(const torch::lazy::Output& output) {
@@ -277,6 +286,8 @@ absl::StatusOr<XlaOpVector> LoweringContext::LowerNode(
   const HloMetadataSetter meta_setter(*this, node);
   const XlaNode* const casted = dynamic_cast<const XlaNode*>(&node);
 
+  const int64_t start_ns =
+      trace_profiler::Enabled() ? runtime::sys_util::NowNs() : 0;
   XLA_ASSIGN_OR_RETURN(XlaOpVector output, casted->CheckedLower(this));
 
   if (!casted->dynamic_dims().empty()) {
@@ -296,6 +307,21 @@ absl::StatusOr<XlaOpVector> LoweringContext::LowerNode(
     }
   }
 
+  if (start_ns != 0) {
+    // The builder numbers its instructions in sequence, including those of
+    // the computations they call, so the outputs tell how many were emitted.
+    int64_t last_handle = last_lowered_handle_;
+    for (const xla::XlaOp& op : output) {
+      if (op.valid()) {
+        last_handle = std::max(last_handle, op.handle());
+      }
+    }
+    trace_profiler::Record(trace_profiler::Category::kLowering, node.op().op,
+                           runtime::sys_util::NowNs() - start_ns,
+                           last_handle - last_lowered_handle_);
+    last_lowered_handle_ = last_handle;
+  }
+
   return output;
 }
 
@@ -7,7 +7,6 @@
 #include <optional>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
 #include <c10/util/ArrayRef.h>
@@ -20,6 +19,7 @@
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "xla/hlo/builder/xla_builder.h"
 #include "xla/hlo/builder/xla_computation.h"
 
@@ -54,7 +54,7 @@ class LoweringContext : public torch::lazy::LoweringContext {
   // held in data.
   absl::StatusOr<xla::XlaOp> GetParameter(
       const torch::lazy::BackendDataPtr& backend_data,
-      const std::unordered_set<uint32_t>& unbounded_dynamic_dims = {});
+      absl::Span<const uint32_t> unbounded_dynamic_dims = {});
 
   // If a parameter associated with data has already been declared, returns its
   // ID. Otherwise, returns `std::nullopt`.
@@ -125,10 +125,17 @@ class LoweringContext : public torch::lazy::LoweringContext {
 
   torch::lazy::ComputationPtr Build() override;
 
-  const torch::lazy::OutputMap<xla::XlaOp> GetEmittedOutputs() const {
+  const torch::lazy::OutputMap<xla::XlaOp>& GetEmittedOutputs() const {
     return emitted_outputs_;
   }
 
+  // Returns the emitted outputs whose nodes carry a sharding annotation, which
+  // are tracked as the outputs get assigned so that annotating the HLO does not
+  // need to visit every emitted output.
+  const torch::lazy::OutputMap<xla::XlaOp>& GetShardedOutputs() const {
+    return sharded_outputs_;
+  }
+
   // Return stack frame id
   int64_t AddStackFrameLocation(const torch::lazy::SourceLocation& source,
                                 int64_t parent_id);
@@ -148,7 +155,11 @@ class LoweringContext : public torch::lazy::LoweringContext {
       parameters_map_;
   std::vector<xla::XlaOp> root_tuple_;
   torch::lazy::OutputMap<xla::XlaOp> emitted_outputs_;
+  torch::lazy::OutputMap<xla::XlaOp> sharded_outputs_;
   std::string name_;
+  // The largest handle of the outputs lowered so far, when the lowerings are
+  // profiled.
+  int64_t last_lowered_handle_ = 0;
 
   std::shared_ptr<StackFrameIndexBuilder> stack_frame_index_builder_;
 };  // namespace torch_xla
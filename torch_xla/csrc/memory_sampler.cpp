@@ -0,0 +1,211 @@
+#include "torch_xla/csrc/memory_sampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <thread>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tf_logging.h"
+
+namespace torch_xla {
+namespace {
+
+double Fragmentation(int64_t bytes_limit, const MemorySampler::Sample& sample) {
+  int64_t free_bytes = bytes_limit - sample.bytes_used;
+  // Not all the allocators report their largest free block.
+  if (free_bytes <= 0 || sample.largest_free_block_bytes <= 0) {
+    return 0.0;
+  }
+  return std::clamp(
+      1.0 - static_cast<double>(sample.largest_free_block_bytes) / free_bytes,
+      0.0, 1.0);
+}
+
+void RunSampler(MemorySampler* sampler, int64_t interval_ms) {
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    sampler->SampleDevices();
+  }
+}
+
+}  // namespace
+
+MemorySampler* MemorySampler::Get() {
+  static MemorySampler* sampler = new MemorySampler();
+  return sampler;
+}
+
+MemorySampler::MemorySampler()
+    : enabled_(runtime::sys_util::GetEnvBool("XLA_MEMORY_SAMPLER", false)),
+      max_samples_(std::max<int64_t>(
+          runtime::sys_util::GetEnvInt("XLA_MEMORY_SAMPLER_SAMPLES", 4096),
+          1)),
+      warmup_steps_(runtime::sys_util::GetEnvInt(
+          "XLA_MEMORY_SAMPLER_WARMUP_STEPS", 10)),
+      alert_threshold_(runtime::sys_util::GetEnvDouble(
+          "XLA_MEMORY_GROWTH_ALERT_THRESHOLD", 0.05)) {}
+
+void MemorySampler::SampleDevices() {
+  if (!enabled_) {
+    return;
+  }
+  runtime::ComputationClient* client = nullptr;
+  try {
+    client = runtime::GetComputationClientIfInitialized();
+  } catch (const std::exception&) {
+    return;
+  }
+  if (client == nullptr) {
+    return;
+  }
+  for (const std::string& device : client->GetLocalDevices()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (unsupported_devices_.count(device) > 0) {
+        continue;
+      }
+    }
+    runtime::ComputationClient::MemoryInfo mem_info;
+    try {
+      mem_info = client->GetMemoryInfo(device);
+    } catch (const std::exception&) {
+      // Not all the platforms report memory statistics.
+      TF_VLOG(1) << "Device " << device << " does not report its memory";
+      std::lock_guard<std::mutex> lock(mutex_);
+      unsupported_devices_.insert(device);
+      continue;
+    }
+    Sample sample;
+    sample.time_ns = runtime::sys_util::NowNs();
+    sample.bytes_used = mem_info.bytes_used;
+    sample.peak_bytes_used = mem_info.peak_bytes_used;
+    sample.largest_free_block_bytes = mem_info.largest_free_block_bytes;
+    AddSample(device, mem_info.bytes_limit, sample);
+  }
+}
+
+void MemorySampler::AddSample(const std::string& device, int64_t bytes_limit,
+                              const Sample& sample) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = devices_.find(device);
+  if (it == devices_.end()) {
+    it = devices_.emplace(device, DeviceState()).first;
+    it->second.current.step = step_;
+    it->second.step_peak_metric = new runtime::metrics::Metric(
+        absl::StrCat("DeviceMemoryStepPeak/", device),
+        runtime::metrics::MetricFnBytes);
+    it->second.fragmentation_metric = new runtime::metrics::Metric(
+        absl::StrCat("DeviceMemoryFragmentation/", device),
+        runtime::metrics::MetricFnValue);
+  }
+  DeviceState& state = it->second;
+  state.bytes_limit = bytes_limit;
+  state.samples.push_back(sample);
+  state.samples.back().step = step_;
+  if (state.samples.size() > max_samples_) {
+    state.samples.pop_front();
+  }
+  // A peak higher than the previous one was reached since the previous
+  // sample, which the bytes in use of the samples alone may have missed.
+  int64_t peak_bytes_used = sample.bytes_used;
+  if (sample.peak_bytes_used > state.last_peak_bytes_used) {
+    peak_bytes_used = std::max(peak_bytes_used, sample.peak_bytes_used);
+    state.last_peak_bytes_used = sample.peak_bytes_used;
+  }
+  state.current.peak_bytes_used =
+      std::max(state.current.peak_bytes_used, peak_bytes_used);
+  state.current.fragmentation = std::max(state.current.fragmentation,
+                                         Fragmentation(bytes_limit, sample));
+}
+
+void MemorySampler::MarkStep() {
+  if (!enabled_) {
+    return;
+  }
+  SampleDevices();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& device_state : devices_) {
+    CloseStep(device_state.first, &device_state.second);
+  }
+  ++step_;
+}
+
+void MemorySampler::CloseStep(const std::string& device, DeviceState* state) {
+  StepPeak peak = state->current;
+  state->current = StepPeak();
+  state->current.step = step_ + 1;
+  state->step_peaks.push_back(peak);
+  if (state->step_peaks.size() > max_samples_) {
+    state->step_peaks.pop_front();
+  }
+  state->step_peak_metric->AddSample(peak.peak_bytes_used);
+  state->fragmentation_metric->AddSample(peak.fragmentation);
+
+  if (peak.step < warmup_steps_) {
+    state->growth_alert_bytes =
+        std::max(state->growth_alert_bytes, peak.peak_bytes_used);
+    state->fragmentation_alert_level =
+        std::max(state->fragmentation_alert_level, peak.fragmentation);
+    return;
+  }
+  // After an alert, the next one is only raised once the peak grew again by
+  // the threshold, so that a steady growth warns at a bounded rate.
+  if (state->growth_alert_bytes > 0 &&
+      peak.peak_bytes_used >
+          state->growth_alert_bytes * (1.0 + alert_threshold_)) {
+    XLA_COUNTER("DeviceMemoryGrowthAlert", 1);
+    ++state->growth_alerts;
+    TF_LOG(WARNING) << "The peak memory of step " << peak.step << " on "
+                    << device << " is " << peak.peak_bytes_used
+                    << " bytes, up from " << state->growth_alert_bytes
+                    << " bytes (limit " << state->bytes_limit << " bytes)";
+    state->growth_alert_bytes = peak.peak_bytes_used;
+  }
+  if (peak.fragmentation >
+      state->fragmentation_alert_level + alert_threshold_) {
+    XLA_COUNTER("DeviceMemoryFragmentationAlert", 1);
+    ++state->fragmentation_alerts;
+    TF_LOG(WARNING) << "The memory fragmentation of step " << peak.step
+                    << " on " << device << " is " << peak.fragmentation
+                    << ", up from " << state->fragmentation_alert_level;
+    state->fragmentation_alert_level = peak.fragmentation;
+  }
+}
+
+std::vector<MemorySampler::DeviceHistory> MemorySampler::GetHistory() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<DeviceHistory> history;
+  history.reserve(devices_.size());
+  for (const auto& device_state : devices_) {
+    const DeviceState& state = device_state.second;
+    DeviceHistory device_history;
+    device_history.device = device_state.first;
+    device_history.bytes_limit = state.bytes_limit;
+    device_history.samples.assign(state.samples.begin(), state.samples.end());
+    device_history.step_peaks.assign(state.step_peaks.begin(),
+                                     state.step_peaks.end());
+    device_history.growth_alerts = state.growth_alerts;
+    device_history.fragmentation_alerts = state.fragmentation_alerts;
+    history.push_back(std::move(device_history));
+  }
+  return history;
+}
+
+void MemorySampler::MaybeStart() {
+  static std::once_flag start_flag;
+  std::call_once(start_flag, [this]() {
+    int64_t interval_ms = runtime::sys_util::GetEnvInt(
+        "XLA_MEMORY_SAMPLER_INTERVAL_MS", 1000);
+    if (enabled_ && interval_ms > 0) {
+      std::thread(RunSampler, this, interval_ms).detach();
+    }
+  });
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,105 @@
+#ifndef XLA_TORCH_XLA_CSRC_MEMORY_SAMPLER_H_
+#define XLA_TORCH_XLA_CSRC_MEMORY_SAMPLER_H_
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "torch_xla/csrc/runtime/metrics.h"
+
+namespace torch_xla {
+
+// Records the memory statistics of the local devices over time, when
+// $XLA_MEMORY_SAMPLER is set: every $XLA_MEMORY_SAMPLER_INTERVAL_MS on a
+// background thread, and at every step boundary. Each step gets the peak of
+// the bytes in use and of the fragmentation seen during it, and a warning is
+// logged when they grow past the ones of the first steps, so that a slow creep
+// toward an OOM shows up long before it happens.
+class MemorySampler {
+ public:
+  struct Sample {
+    int64_t time_ns = 0;
+    int64_t step = 0;
+    int64_t bytes_used = 0;
+    int64_t peak_bytes_used = 0;
+    int64_t largest_free_block_bytes = 0;
+  };
+
+  struct StepPeak {
+    int64_t step = 0;
+    int64_t peak_bytes_used = 0;
+    // One minus the largest free block over the free bytes. It gets closer to
+    // 1 as the free memory is split in smaller blocks.
+    double fragmentation = 0.0;
+  };
+
+  struct DeviceHistory {
+    std::string device;
+    int64_t bytes_limit = 0;
+    std::vector<Sample> samples;
+    std::vector<StepPeak> step_peaks;
+    int64_t growth_alerts = 0;
+    int64_t fragmentation_alerts = 0;
+  };
+
+  static MemorySampler* Get();
+
+  bool enabled() const { return enabled_; }
+
+  // Samples the memory statistics of all the local devices. Does nothing
+  // before the computation client is initialized.
+  void SampleDevices();
+
+  // Samples the devices and closes the current step.
+  void MarkStep();
+
+  // Returns the most recent samples and step peaks of each device, from the
+  // oldest.
+  std::vector<DeviceHistory> GetHistory();
+
+  // Starts the sampling thread if the sampler is enabled. Only the first call
+  // has an effect.
+  void MaybeStart();
+
+ private:
+  struct DeviceState {
+    int64_t bytes_limit = 0;
+    std::deque<Sample> samples;
+    std::deque<StepPeak> step_peaks;
+    StepPeak current;
+    int64_t last_peak_bytes_used = 0;
+    // The levels above which the next alerts are raised, set once the warmup
+    // steps are done.
+    int64_t growth_alert_bytes = 0;
+    double fragmentation_alert_level = 0.0;
+    int64_t growth_alerts = 0;
+    int64_t fragmentation_alerts = 0;
+    runtime::metrics::Metric* step_peak_metric = nullptr;
+    runtime::metrics::Metric* fragmentation_metric = nullptr;
+  };
+
+  MemorySampler();
+
+  void AddSample(const std::string& device, int64_t bytes_limit,
+                 const Sample& sample);
+
+  void CloseStep(const std::string& device, DeviceState* state);
+
+  bool enabled_;
+  size_t max_samples_;
+  int64_t warmup_steps_;
+  double alert_threshold_;
+  std::mutex mutex_;
+  std::map<std::string, DeviceState> devices_;
+  // The devices which do not report memory statistics.
+  std::set<std::string> unsupported_devices_;
+  int64_t step_ = 0;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_MEMORY_SAMPLER_H_
@@ -0,0 +1,290 @@
+#include "torch_xla/csrc/metrics_exporter.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+
+#include "torch_xla/csrc/runtime/env_vars.h"
+#include "torch_xla/csrc/runtime/metrics.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tf_logging.h"
+#include "torch_xla/csrc/xla_graph_executor.h"
+
+namespace torch_xla {
+namespace {
+
+constexpr double kQuantiles[] = {0.5, 0.9, 0.99};
+
+// The values of a metric or counter, copied out of their arena so that the
+// report is formatted without holding the arena lock.
+struct MetricSnapshot {
+  std::string name;
+  size_t total_samples = 0;
+  double accumulator = 0.0;
+  std::vector<double> values;
+};
+
+struct CounterSnapshot {
+  std::string name;
+  int64_t value = 0;
+};
+
+// Takes the snapshots out of the lazy tensor and the runtime arenas, which
+// have the same interface.
+template <typename Arena>
+void SnapshotArena(Arena* arena, std::vector<MetricSnapshot>* metrics,
+                   std::vector<CounterSnapshot>* counters) {
+  arena->ForEachMetric([&](const std::string& name, auto* data) {
+    MetricSnapshot snapshot;
+    snapshot.name = name;
+    for (const auto& sample :
+         data->Samples(&snapshot.accumulator, &snapshot.total_samples)) {
+      snapshot.values.push_back(sample.value);
+    }
+    if (snapshot.total_samples > 0) {
+      metrics->push_back(std::move(snapshot));
+    }
+  });
+  arena->ForEachCounter([&](const std::string& name, auto* data) {
+    int64_t value = data->Value();
+    if (value > 0) {
+      counters->push_back({name, value});
+    }
+  });
+}
+
+std::string SanitizeName(const std::string& name) {
+  std::string sanitized = "ptxla_";
+  for (char c : name) {
+    bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                 (c >= '0' && c <= '9') || c == '_';
+    sanitized.push_back(valid ? c : '_');
+  }
+  return sanitized;
+}
+
+const std::string& DeviceLabel() {
+  static const std::string device_label = absl::StrCat(
+      "device=\"",
+      runtime::sys_util::GetEnvString(runtime::env::kEnvPjRtDevice, ""), "\"");
+  return device_label;
+}
+
+std::string FormatValue(double value) {
+  std::stringstream ss;
+  ss.precision(17);
+  ss << value;
+  return ss.str();
+}
+
+void WriteFile(const std::string& path, const std::string& contents) {
+  // Scrapers must never see a partially written file.
+  std::string tmp_path = absl::StrCat(path, ".tmp");
+  {
+    std::ofstream file(tmp_path, std::ios::trunc);
+    file << contents;
+    if (!file) {
+      TF_LOG(WARNING) << "Failed to write metrics to " << tmp_path;
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    TF_LOG(WARNING) << "Failed to rename " << tmp_path << " to " << path;
+  }
+}
+
+void RunFileExporter(const std::string& path, int64_t interval_s) {
+  while (true) {
+    WriteFile(path, CreateOpenMetricsReport());
+    std::this_thread::sleep_for(std::chrono::seconds(interval_s));
+  }
+}
+
+// A minimal HTTP server, answering every request with the report. Scrapes
+// are served one at a time on this thread only.
+void RunHttpExporter(int port) {
+  int server = socket(AF_INET6, SOCK_STREAM, 0);
+  if (server < 0) {
+    TF_LOG(WARNING) << "Failed to create the metrics exporter socket";
+    return;
+  }
+  int enable = 1;
+  setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  sockaddr_in6 address = {};
+  address.sin6_family = AF_INET6;
+  address.sin6_addr = in6addr_any;
+  address.sin6_port = htons(port);
+  if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+          0 ||
+      listen(server, /*backlog=*/16) != 0) {
+    TF_LOG(WARNING) << "Failed to serve the metrics on port " << port;
+    close(server);
+    return;
+  }
+  TF_VLOG(1) << "Serving the metrics on port " << port;
+  while (true) {
+    int connection = accept(server, nullptr, nullptr);
+    if (connection < 0) {
+      continue;
+    }
+    timeval timeout = {/*tv_sec=*/5, /*tv_usec=*/0};
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // The request itself does not matter, every path serves the report.
+    char request[4096];
+    if (recv(connection, request, sizeof(request), 0) > 0) {
+      std::string body = CreateOpenMetricsReport();
+      std::string response = absl::StrCat(
+          "HTTP/1.1 200 OK\r\n"
+          "Content-Type: application/openmetrics-text; version=1.0.0; "
+          "charset=utf-8\r\n"
+          "Content-Length: ",
+          body.size(), "\r\nConnection: close\r\n\r\n", body);
+      size_t sent = 0;
+      while (sent < response.size()) {
+        ssize_t count = send(connection, response.data() + sent,
+                             response.size() - sent, MSG_NOSIGNAL);
+        if (count <= 0) {
+          break;
+        }
+        sent += count;
+      }
+    }
+    close(connection);
+  }
+}
+
+// Emits the families of the per graph statistics, labeled by graph hash.
+void EmitGraphStats(std::vector<XLAGraphExecutor::GraphStats> graphs,
+                    std::stringstream* ss) {
+  if (graphs.empty()) {
+    return;
+  }
+  std::vector<std::string> labels;
+  labels.reserve(graphs.size());
+  for (XLAGraphExecutor::GraphStats& stats : graphs) {
+    labels.push_back(absl::StrCat(DeviceLabel(), ",graph_hash=\"",
+                                  torch::lazy::HashToString(stats.hash),
+                                  "\""));
+    std::sort(stats.execute_times_ns.begin(), stats.execute_times_ns.end());
+  }
+  (*ss) << "# TYPE ptxla_graph_execute_time summary\n";
+  for (size_t i = 0; i < graphs.size(); ++i) {
+    const std::vector<int64_t>& times = graphs[i].execute_times_ns;
+    for (double quantile : kQuantiles) {
+      if (!times.empty()) {
+        size_t index =
+            std::min<size_t>(quantile * times.size(), times.size() - 1);
+        (*ss) << "ptxla_graph_execute_time{" << labels[i] << ",quantile=\""
+              << quantile << "\"} " << times[index] << "\n";
+      }
+    }
+  }
+  auto emit = [&](const char* name, const char* type, const char* suffix,
+                  auto value_fn) {
+    (*ss) << "# TYPE " << name << " " << type << "\n";
+    for (size_t i = 0; i < graphs.size(); ++i) {
+      (*ss) << name << suffix << "{" << labels[i] << "} "
+            << value_fn(graphs[i]) << "\n";
+    }
+  };
+  using GraphStats = XLAGraphExecutor::GraphStats;
+  emit("ptxla_graph_executions", "counter", "_total",
+       [](const GraphStats& stats) { return stats.executions; });
+  emit("ptxla_graph_compilations", "counter", "_total",
+       [](const GraphStats& stats) { return stats.compilations; });
+  emit("ptxla_graph_compile_time", "counter", "_total",
+       [](const GraphStats& stats) { return stats.compile_time_ns; });
+  emit("ptxla_graph_input_bytes", "gauge", "",
+       [](const GraphStats& stats) { return stats.input_bytes; });
+  emit("ptxla_graph_output_bytes", "gauge", "",
+       [](const GraphStats& stats) { return stats.output_bytes; });
+  emit("ptxla_graph_last_step", "gauge", "",
+       [](const GraphStats& stats) { return stats.last_step; });
+  emit("ptxla_graph_flops", "gauge", "",
+       [](const GraphStats& stats) { return FormatValue(stats.flops); });
+  emit("ptxla_graph_bytes_accessed", "gauge", "", [](const GraphStats& stats) {
+    return FormatValue(stats.bytes_accessed);
+  });
+}
+
+}  // namespace
+
+std::string CreateOpenMetricsReport() {
+  std::vector<MetricSnapshot> metrics;
+  std::vector<CounterSnapshot> counters;
+  SnapshotArena(torch::lazy::MetricsArena::Get(), &metrics, &counters);
+  SnapshotArena(runtime::metrics::MetricsArena::Get(), &metrics, &counters);
+
+  const std::string& labels = DeviceLabel();
+  // Both arenas may have an entry of the same name, in which case the lazy
+  // tensor one, which comes first, is exported.
+  std::set<std::string> families;
+  std::stringstream ss;
+  for (MetricSnapshot& metric : metrics) {
+    std::string name = SanitizeName(metric.name);
+    if (!families.insert(name).second) {
+      continue;
+    }
+    std::sort(metric.values.begin(), metric.values.end());
+    ss << "# TYPE " << name << " summary\n";
+    if (!metric.values.empty()) {
+      for (double quantile : kQuantiles) {
+        size_t index = std::min<size_t>(quantile * metric.values.size(),
+                                        metric.values.size() - 1);
+        ss << name << "{" << labels << ",quantile=\"" << quantile << "\"} "
+           << FormatValue(metric.values[index]) << "\n";
+      }
+    }
+    ss << name << "_sum{" << labels << "} " << FormatValue(metric.accumulator)
+       << "\n";
+    ss << name << "_count{" << labels << "} " << metric.total_samples << "\n";
+  }
+  for (const CounterSnapshot& counter : counters) {
+    std::string name = SanitizeName(counter.name);
+    if (!families.insert(name).second) {
+      continue;
+    }
+    ss << "# TYPE " << name << " counter\n";
+    ss << name << "_total{" << labels << "} " << counter.value << "\n";
+  }
+  EmitGraphStats(XLAGraphExecutor::Get()->GetGraphStats(), &ss);
+  ss << "# EOF\n";
+  return ss.str();
+}
+
+void MaybeStartMetricsExporter() {
+  static std::once_flag start_flag;
+  std::call_once(start_flag, []() {
+    int64_t port =
+        runtime::sys_util::GetEnvInt("XLA_METRICS_EXPORTER_PORT", 0);
+    if (port > 0) {
+      std::thread(RunHttpExporter, port).detach();
+    }
+    std::string path =
+        runtime::sys_util::GetEnvString("XLA_METRICS_EXPORTER_FILE", "");
+    if (!path.empty()) {
+      int64_t interval_s = std::max<int64_t>(
+          runtime::sys_util::GetEnvInt("XLA_METRICS_EXPORTER_INTERVAL", 10),
+          1);
+      std::thread(RunFileExporter, path, interval_s).detach();
+    }
+  });
+}
+
+}  // namespace torch_xla
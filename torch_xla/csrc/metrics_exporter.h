@@ -0,0 +1,25 @@
+#ifndef XLA_TORCH_XLA_CSRC_METRICS_EXPORTER_H_
+#define XLA_TORCH_XLA_CSRC_METRICS_EXPORTER_H_
+
+#include <string>
+
+namespace torch_xla {
+
+// Creates a report of the lazy tensor and runtime counters and metrics in the
+// OpenMetrics text format. Counters are exported as `ptxla_<name>_total`, and
+// metrics as summaries with fixed quantiles, where the names are the metric
+// names with the characters OpenMetrics does not allow replaced by '_'. All
+// the samples carry a `device` label with the $PJRT_DEVICE type. Time metrics
+// are in nanoseconds, as in the text report. The statistics of each graph are
+// exported as ptxla_graph_* families with an additional `graph_hash` label.
+std::string CreateOpenMetricsReport();
+
+// Starts the metrics exporter threads configured by the environment: an HTTP
+// endpoint serving CreateOpenMetricsReport() on $XLA_METRICS_EXPORTER_PORT,
+// and a file at $XLA_METRICS_EXPORTER_FILE rewritten with it every
+// $XLA_METRICS_EXPORTER_INTERVAL seconds. Only the first call has an effect.
+void MaybeStartMetricsExporter();
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_METRICS_EXPORTER_H_
@@ -1,12 +1,17 @@
 #include "torch_xla/csrc/nll_loss.h"
 
+#include <algorithm>
+
 #include "absl/types/span.h"
 #include "xla/hlo/builder/lib/constants.h"
+#include "xla/hlo/builder/lib/loops.h"
 #include "xla/hlo/builder/lib/math.h"
+#include "xla/util.h"
 
 #include "torch_xla/csrc/data_ops.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/shape_helper.h"
+#include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/tensor_util.h"
 
 namespace torch_xla {
@@ -108,6 +113,53 @@ WeightScale GetMaskedWeight(xla::XlaOp weight, const xla::Shape& logits_shape,
   return {result_weight, scale};
 }
 
+// A chunk of the classes of the rows of the logits, in F32.
+struct LogitsChunk {
+  xla::XlaOp logits;
+  // The class of every logit of the chunk.
+  xla::XlaOp classes;
+  // The offset of the chunk in the classes.
+  xla::XlaOp offset;
+  // Whether a logit belongs to the chunk. The last chunk is moved back to end
+  // at the last class, and its classes which belong to the chunk before are
+  // not valid.
+  xla::XlaOp valid;
+};
+
+LogitsChunk GetLogitsChunk(xla::XlaOp logits, xla::XlaOp index,
+                           int64_t num_classes, int64_t chunk_size) {
+  xla::XlaBuilder* builder = logits.builder();
+  int64_t rows = ShapeHelper::ShapeOfXlaOp(logits).dimensions(0);
+  xla::XlaOp start = index * xla::ConstantR0<int32_t>(
+                                 builder, static_cast<int32_t>(chunk_size));
+  xla::XlaOp offset = xla::Min(
+      start, xla::ConstantR0<int32_t>(
+                 builder, static_cast<int32_t>(num_classes - chunk_size)));
+  xla::XlaOp slice = xla::DynamicSlice(
+      logits, {xla::Zero(builder, xla::PrimitiveType::S32), offset},
+      {rows, chunk_size});
+  xla::XlaOp classes =
+      xla::Iota(builder,
+                xla::ShapeUtil::MakeShape(xla::PrimitiveType::S32,
+                                          {rows, chunk_size}),
+                1) +
+      offset;
+  return {xla::ConvertElementType(slice, xla::PrimitiveType::F32), classes,
+          offset, xla::Ge(classes, start)};
+}
+
+xla::XlaOp MaskIgnoredRows(xla::XlaOp values, xla::XlaOp labels,
+                           int ignore_index) {
+  const xla::Shape& shape = ShapeHelper::ShapeOfXlaOp(values);
+  xla::XlaOp ignored = xla::Eq(
+      labels, xla::ConstantR0<int32_t>(labels.builder(), ignore_index));
+  return xla::Select(ignored,
+                     xla::Broadcast(xla::Zero(values.builder(),
+                                              shape.element_type()),
+                                    shape.dimensions()),
+                     values);
+}
+
 }  // namespace
 
 // Builds the NLLLoss for log-probabilities "logits" and class indices "labels".
@@ -191,4 +243,137 @@ xla::XlaOp BuildNllLossBackward(xla::XlaOp grad_output, xla::XlaOp logits,
   return result / weight_scale.scale;
 }
 
+std::vector<xla::XlaOp> BuildChunkedCrossEntropy(xla::XlaOp logits,
+                                                 xla::XlaOp labels,
+                                                 int64_t chunk_size,
+                                                 int ignore_index) {
+  const xla::PrimitiveType kF32 = xla::PrimitiveType::F32;
+  xla::XlaBuilder* builder = logits.builder();
+  const xla::Shape& logits_shape = ShapeHelper::ShapeOfXlaOp(logits);
+  int64_t rows = logits_shape.dimensions(0);
+  int64_t num_classes = logits_shape.dimensions(1);
+  chunk_size = std::min(chunk_size, num_classes);
+  int64_t num_chunks = xla::CeilOfRatio(num_classes, chunk_size);
+  xla::XlaOp labels_s32 =
+      xla::ConvertElementType(labels, xla::PrimitiveType::S32);
+
+  // The loop carries the index of the chunk, the running max, the running sum
+  // of the exponentials relative to it and the logit of the label of every
+  // row, and the logits and labels.
+  std::vector<xla::XlaOp> init_values = {
+      xla::Zero(builder, xla::PrimitiveType::S32),
+      xla::Broadcast(xla::MinFiniteValue(builder, kF32), {rows}),
+      xla::Broadcast(xla::Zero(builder, kF32), {rows}),
+      xla::Broadcast(xla::Zero(builder, kF32), {rows}), logits, labels_s32};
+  XLA_ASSIGN_OR_THROW(
+      std::vector<xla::XlaOp> result,
+      xla::WhileLoopHelper(
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            return xla::Lt(values[0], xla::ConstantR0<int32_t>(
+                                          builder,
+                                          static_cast<int32_t>(num_chunks)));
+          },
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            LogitsChunk chunk =
+                GetLogitsChunk(values[4], values[0], num_classes, chunk_size);
+            xla::XlaOp zero = xla::Zero(builder, kF32);
+            xla::XlaOp zeros = xla::Broadcast(zero, {rows, chunk_size});
+            xla::XlaOp logits = xla::Select(
+                chunk.valid, chunk.logits,
+                xla::Broadcast(xla::MinValue(builder, kF32),
+                               {rows, chunk_size}));
+            xla::XlaOp max = xla::Max(
+                values[1],
+                xla::Reduce(logits, xla::MinValue(builder, kF32),
+                            XlaHelpers::CreateMaxComputation(kF32), {1}));
+            xla::XlaOp exps = xla::Exp(
+                logits - xla::BroadcastInDim(max, {rows, chunk_size}, {0}));
+            xla::XlaComputation add_func =
+                XlaHelpers::CreateAddComputation(kF32);
+            xla::XlaOp sum = values[2] * xla::Exp(values[1] - max) +
+                             xla::Reduce(exps, zero, add_func, {1});
+            xla::XlaOp labels =
+                xla::BroadcastInDim(values[5], {rows, chunk_size}, {0});
+            xla::XlaOp is_label =
+                xla::And(chunk.valid, xla::Eq(chunk.classes, labels));
+            xla::XlaOp label_logits =
+                values[3] + xla::Reduce(xla::Select(is_label, logits, zeros),
+                                        zero, add_func, {1});
+            return std::vector<xla::XlaOp>{
+                values[0] + xla::One(builder, xla::PrimitiveType::S32),
+                max,
+                sum,
+                label_logits,
+                values[4],
+                values[5]};
+          },
+          init_values, "ChunkedCrossEntropyLoop", builder));
+  xla::XlaOp lse = result[1] + xla::Log(result[2]);
+  xla::XlaOp losses =
+      MaskIgnoredRows(lse - result[3], labels_s32, ignore_index);
+  return {xla::ConvertElementType(losses, logits_shape.element_type()), lse};
+}
+
+xla::XlaOp BuildChunkedCrossEntropyBackward(xla::XlaOp grad_output,
+                                            xla::XlaOp logits,
+                                            xla::XlaOp labels, xla::XlaOp lse,
+                                            int64_t chunk_size,
+                                            int ignore_index) {
+  const xla::PrimitiveType kF32 = xla::PrimitiveType::F32;
+  xla::XlaBuilder* builder = logits.builder();
+  const xla::Shape& logits_shape = ShapeHelper::ShapeOfXlaOp(logits);
+  xla::PrimitiveType type = logits_shape.element_type();
+  int64_t rows = logits_shape.dimensions(0);
+  int64_t num_classes = logits_shape.dimensions(1);
+  chunk_size = std::min(chunk_size, num_classes);
+  int64_t num_chunks = xla::CeilOfRatio(num_classes, chunk_size);
+  xla::XlaOp labels_s32 =
+      xla::ConvertElementType(labels, xla::PrimitiveType::S32);
+  xla::XlaOp scale = MaskIgnoredRows(
+      xla::ConvertElementType(grad_output, kF32), labels_s32, ignore_index);
+
+  // The shared classes of the last chunk are written twice, with the same
+  // values, so the chunks need no mask here.
+  std::vector<xla::XlaOp> init_values = {
+      xla::Zero(builder, xla::PrimitiveType::S32),
+      xla::Broadcast(xla::Zero(builder, type), logits_shape.dimensions()),
+      logits,
+      labels_s32,
+      lse,
+      scale};
+  XLA_ASSIGN_OR_THROW(
+      std::vector<xla::XlaOp> result,
+      xla::WhileLoopHelper(
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            return xla::Lt(values[0], xla::ConstantR0<int32_t>(
+                                          builder,
+                                          static_cast<int32_t>(num_chunks)));
+          },
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            LogitsChunk chunk =
+                GetLogitsChunk(values[2], values[0], num_classes, chunk_size);
+            std::vector<int64_t> chunk_dims = {rows, chunk_size};
+            xla::XlaOp probs = xla::Exp(
+                chunk.logits - xla::BroadcastInDim(values[4], chunk_dims, {0}));
+            xla::XlaOp one_hot = xla::ConvertElementType(
+                xla::Eq(chunk.classes,
+                        xla::BroadcastInDim(values[3], chunk_dims, {0})),
+                kF32);
+            xla::XlaOp grad = (probs - one_hot) *
+                              xla::BroadcastInDim(values[5], chunk_dims, {0});
+            xla::XlaOp grads = xla::DynamicUpdateSlice(
+                values[1], xla::ConvertElementType(grad, type),
+                {xla::Zero(builder, xla::PrimitiveType::S32), chunk.offset});
+            return std::vector<xla::XlaOp>{
+                values[0] + xla::One(builder, xla::PrimitiveType::S32),
+                grads,
+                values[2],
+                values[3],
+                values[4],
+                values[5]};
+          },
+          init_values, "ChunkedCrossEntropyBackwardLoop", builder));
+  return result[1];
+}
+
 }  // namespace torch_xla
@@ -1,6 +1,9 @@
 #ifndef XLA_TORCH_XLA_CSRC_NLL_LOSS_H_
 #define XLA_TORCH_XLA_CSRC_NLL_LOSS_H_
 
+#include <cstdint>
+#include <vector>
+
 #include "absl/types/optional.h"
 #include "xla/hlo/builder/xla_builder.h"
 
@@ -19,6 +22,26 @@ xla::XlaOp BuildNllLossBackward(xla::XlaOp grad_output, xla::XlaOp logits,
                                 xla::XlaOp total_weight, int ignore_index,
                                 ReductionMode reduction_mode);
 
+// Builds the cross-entropy of the rows of "logits", of shape [N, C], and the
+// class indices "labels", of shape [N], without the log-probabilities: a loop
+// reads "chunk_size" classes at a time, in F32, and adds them to an online
+// log-sum-exp. Returns the per row losses, in the type of "logits" and zero for
+// the ignored rows, and the F32 log-sum-exps the backward reads.
+std::vector<xla::XlaOp> BuildChunkedCrossEntropy(xla::XlaOp logits,
+                                                 xla::XlaOp labels,
+                                                 int64_t chunk_size,
+                                                 int ignore_index);
+
+// Builds the gradient of BuildChunkedCrossEntropy() for the logits, from the
+// gradient of the per row losses "grad_output" and the log-sum-exps "lse". The
+// softmax of a chunk is recomputed from "lse", and written into the gradient,
+// so only a chunk of F32 values is live at a time.
+xla::XlaOp BuildChunkedCrossEntropyBackward(xla::XlaOp grad_output,
+                                            xla::XlaOp logits,
+                                            xla::XlaOp labels, xla::XlaOp lse,
+                                            int64_t chunk_size,
+                                            int ignore_index);
+
 }  // namespace torch_xla
 
 #endif  // XLA_TORCH_XLA_CSRC_NLL_LOSS_H_
\ No newline at end of file
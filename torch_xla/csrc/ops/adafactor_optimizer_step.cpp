@@ -0,0 +1,150 @@
+#include "torch_xla/csrc/ops/adafactor_optimizer_step.h"
+
+#include <sstream>
+#include <vector>
+
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/shape_helper.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+// The operands are the scalars, then the step, the parameter, the gradient,
+// the row variance and, if it is factored, the column variance of each
+// parameter, one parameter after the other.
+constexpr size_t kNumScalarOperands = 7;
+
+std::vector<torch::lazy::Value> GetOperandList(
+    const torch::lazy::Value& found_inf,
+    c10::ArrayRef<torch::lazy::Value> steps,
+    c10::ArrayRef<torch::lazy::Value> params,
+    c10::ArrayRef<torch::lazy::Value> grads,
+    c10::ArrayRef<torch::lazy::Value> row_vars,
+    c10::ArrayRef<torch::lazy::Value> col_vars, const torch::lazy::Value& lr,
+    const torch::lazy::Value& beta2_decay, const torch::lazy::Value& eps1,
+    const torch::lazy::Value& eps2, const torch::lazy::Value& d,
+    const torch::lazy::Value& weight_decay) {
+  XLA_CHECK_EQ(steps.size(), params.size());
+  XLA_CHECK_EQ(grads.size(), params.size());
+  XLA_CHECK_EQ(row_vars.size(), params.size());
+  XLA_CHECK_EQ(col_vars.size(), params.size());
+  std::vector<torch::lazy::Value> operands = {
+      found_inf, lr, beta2_decay, eps1, eps2, d, weight_decay};
+  for (size_t i = 0; i < params.size(); ++i) {
+    operands.insert(operands.end(),
+                    {steps[i], params[i], grads[i], row_vars[i]});
+    if (IsAdafactorFactored(GetXlaShape(params[i]))) {
+      operands.push_back(col_vars[i]);
+    }
+  }
+  return operands;
+}
+
+size_t NumOutputs(c10::ArrayRef<torch::lazy::Value> params) {
+  size_t num_outputs = 0;
+  for (const torch::lazy::Value& param : params) {
+    num_outputs += IsAdafactorFactored(GetXlaShape(param)) ? 4 : 3;
+  }
+  return num_outputs;
+}
+
+xla::Shape NodeOutputShape(c10::ArrayRef<torch::lazy::Value> steps,
+                           c10::ArrayRef<torch::lazy::Value> params,
+                           c10::ArrayRef<torch::lazy::Value> row_vars,
+                           c10::ArrayRef<torch::lazy::Value> col_vars) {
+  std::vector<xla::Shape> shapes;
+  for (size_t i = 0; i < params.size(); ++i) {
+    shapes.push_back(/*step=*/GetXlaShape(steps[i]));
+    shapes.push_back(/*param=*/GetXlaShape(params[i]));
+    shapes.push_back(/*row_var=*/GetXlaShape(row_vars[i]));
+    if (IsAdafactorFactored(GetXlaShape(params[i]))) {
+      shapes.push_back(/*col_var=*/GetXlaShape(col_vars[i]));
+    }
+  }
+  return xla::ShapeUtil::MakeTupleShape(shapes);
+}
+
+}  // namespace
+
+AdafactorOptimizerStep::AdafactorOptimizerStep(
+    const torch::lazy::Value& found_inf,
+    c10::ArrayRef<torch::lazy::Value> steps,
+    c10::ArrayRef<torch::lazy::Value> params,
+    c10::ArrayRef<torch::lazy::Value> grads,
+    c10::ArrayRef<torch::lazy::Value> row_vars,
+    c10::ArrayRef<torch::lazy::Value> col_vars, const torch::lazy::Value& lr,
+    const torch::lazy::Value& beta2_decay, const torch::lazy::Value& eps1,
+    const torch::lazy::Value& eps2, const torch::lazy::Value& d,
+    const torch::lazy::Value& weight_decay, bool use_weight_decay)
+    : XlaNode(xla_adafactor_optimizer_step,
+              GetOperandList(found_inf, steps, params, grads, row_vars,
+                             col_vars, lr, beta2_decay, eps1, eps2, d,
+                             weight_decay),
+              NodeOutputShape(steps, params, row_vars, col_vars),
+              /*num_outputs=*/NumOutputs(params),
+              torch::lazy::MHash(params.size(), use_weight_decay)),
+      num_params_(params.size()),
+      use_weight_decay_(use_weight_decay) {}
+
+torch::lazy::NodePtr AdafactorOptimizerStep::Clone(
+    torch::lazy::OpList operands) const {
+  std::vector<torch::lazy::Value> steps;
+  std::vector<torch::lazy::Value> params;
+  std::vector<torch::lazy::Value> grads;
+  std::vector<torch::lazy::Value> row_vars;
+  std::vector<torch::lazy::Value> col_vars;
+  size_t index = kNumScalarOperands;
+  for (size_t i = 0; i < num_params_; ++i) {
+    steps.push_back(operands.at(index++));
+    params.push_back(operands.at(index++));
+    grads.push_back(operands.at(index++));
+    row_vars.push_back(operands.at(index++));
+    col_vars.push_back(IsAdafactorFactored(GetXlaShape(params.back()))
+                           ? operands.at(index++)
+                           : row_vars.back());
+  }
+  return torch_xla::MakeNode<AdafactorOptimizerStep>(
+      operands.at(0), steps, params, grads, row_vars, col_vars, operands.at(1),
+      operands.at(2), operands.at(3), operands.at(4), operands.at(5),
+      operands.at(6), use_weight_decay_);
+}
+
+XlaOpVector AdafactorOptimizerStep::Lower(LoweringContext* loctx) const {
+  std::vector<xla::XlaOp> ops;
+  ops.reserve(operands().size());
+  for (const torch::lazy::Output& operand : operands()) {
+    ops.push_back(loctx->GetOutputOp(operand));
+  }
+  std::vector<xla::XlaOp> results;
+  results.reserve(num_outputs());
+  size_t index = kNumScalarOperands;
+  for (size_t i = 0; i < num_params_; ++i) {
+    xla::XlaOp step = ops[index++];
+    xla::XlaOp param = ops[index++];
+    xla::XlaOp grad = ops[index++];
+    xla::XlaOp row_var = ops[index++];
+    xla::XlaOp col_var;
+    if (IsAdafactorFactored(ShapeHelper::ShapeOfXlaOp(param))) {
+      col_var = ops[index++];
+    }
+    std::vector<xla::XlaOp> param_results = BuildAdafactorOptimizerStep(
+        ops[0], step, param, grad, row_var, col_var, ops[1], ops[2], ops[3],
+        ops[4], ops[5], ops[6], use_weight_decay_);
+    results.insert(results.end(), param_results.begin(), param_results.end());
+  }
+  return ReturnOps(results, loctx);
+}
+
+std::string AdafactorOptimizerStep::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", num_params=" << num_params_
+     << ", use_weight_decay=" << use_weight_decay_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,45 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_ADAFACTOR_OPTIMIZER_STEP_H_
+#define XLA_TORCH_XLA_CSRC_OPS_ADAFACTOR_OPTIMIZER_STEP_H_
+
+#include <cstddef>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The Adafactor step of a list of parameters, in a single node sharing the
+// found_inf flag and the hyper parameters. The parameters of rank two or more
+// keep their second moment as a row variance, without the last dimension, and
+// a column variance, without the one before. The others keep a full
+// variance, passed as their row variance, and their column variance is
+// ignored. The outputs are the step, the parameter and the variances of each
+// parameter, one parameter after the other.
+class AdafactorOptimizerStep : public XlaNode {
+ public:
+  AdafactorOptimizerStep(
+      const torch::lazy::Value& found_inf,
+      c10::ArrayRef<torch::lazy::Value> steps,
+      c10::ArrayRef<torch::lazy::Value> params,
+      c10::ArrayRef<torch::lazy::Value> grads,
+      c10::ArrayRef<torch::lazy::Value> row_vars,
+      c10::ArrayRef<torch::lazy::Value> col_vars,
+      const torch::lazy::Value& lr, const torch::lazy::Value& beta2_decay,
+      const torch::lazy::Value& eps1, const torch::lazy::Value& eps2,
+      const torch::lazy::Value& d, const torch::lazy::Value& weight_decay,
+      bool use_weight_decay);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+ private:
+  size_t num_params_;
+  bool use_weight_decay_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_ADAFACTOR_OPTIMIZER_STEP_H_
@@ -3,22 +3,38 @@
 #include <torch/csrc/lazy/core/util.h>
 
 #include "absl/strings/str_join.h"
+#include "xla/primitive_util.h"
 #include "xla/shape_util.h"
 
 #include "torch_xla/csrc/lowering_context.h"
 #include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/util.h"
 
 namespace torch_xla {
 namespace {
 
+std::vector<torch::lazy::Value> GetOperandList(
+    c10::ArrayRef<torch::lazy::Value> operands,
+    c10::ArrayRef<torch::lazy::Value> residuals,
+    const torch::lazy::Value& token) {
+  std::vector<torch::lazy::Value> operand_list(operands.begin(),
+                                               operands.end());
+  operand_list.insert(operand_list.end(), residuals.begin(), residuals.end());
+  return GetOperandListWithToken(operand_list, token);
+}
+
 xla::Shape NodeOutputShape(c10::ArrayRef<torch::lazy::Value> operands,
+                           c10::ArrayRef<torch::lazy::Value> residuals,
                            const torch::lazy::Value& token) {
   std::vector<xla::Shape> tuple_shapes;
-  tuple_shapes.reserve(operands.size() + 1);
+  tuple_shapes.reserve(operands.size() + residuals.size() + 1);
   for (auto& operand : operands) {
     tuple_shapes.push_back(GetXlaShape(operand));
   }
+  for (auto& residual : residuals) {
+    tuple_shapes.push_back(GetXlaShape(residual));
+  }
   tuple_shapes.push_back(GetXlaShape(token));
   return xla::ShapeUtil::MakeTupleShape(tuple_shapes);
 }
@@ -28,17 +44,27 @@ xla::Shape NodeOutputShape(c10::ArrayRef<torch::lazy::Value> operands,
 AllReduce::AllReduce(AllReduceType reduce_type,
                      c10::ArrayRef<torch::lazy::Value> operands,
                      const torch::lazy::Value& token, double scale,
-                     std::vector<std::vector<int64_t>> groups, bool pin_layout)
+                     std::vector<std::vector<int64_t>> groups, bool pin_layout,
+                     std::optional<xla::PrimitiveType> reduce_element_type,
+                     c10::ArrayRef<torch::lazy::Value> residuals)
     : XlaNode(
-          xla_cross_replica_sum, GetOperandListWithToken(operands, token),
-          [&]() { return NodeOutputShape(operands, token); },
-          /*num_outputs=*/operands.size() + 1,
-          torch::lazy::MHash(torch::lazy::GetEnumValue(reduce_type), scale,
-                             groups, pin_layout)),
+          xla_cross_replica_sum, GetOperandList(operands, residuals, token),
+          [&]() { return NodeOutputShape(operands, residuals, token); },
+          /*num_outputs=*/operands.size() + residuals.size() + 1,
+          torch::lazy::MHash(
+              torch::lazy::GetEnumValue(reduce_type), scale, groups,
+              pin_layout,
+              static_cast<int>(reduce_element_type.value_or(
+                  xla::PRIMITIVE_TYPE_INVALID)),
+              !residuals.empty())),
       reduce_type_(reduce_type),
       scale_(scale),
       groups_(std::move(groups)),
-      pin_layout_(pin_layout) {}
+      pin_layout_(pin_layout),
+      reduce_element_type_(reduce_element_type),
+      has_residuals_(!residuals.empty()) {
+  XLA_CHECK(residuals.empty() || residuals.size() == operands.size());
+}
 
 AllReduce::AllReduce(AllReduceType reduce_type, torch::lazy::Value operand,
                      double scale, std::vector<std::vector<int64_t>> groups)
@@ -53,11 +79,19 @@ AllReduce::AllReduce(AllReduceType reduce_type, torch::lazy::Value operand,
       has_token_(false) {}
 
 torch::lazy::NodePtr AllReduce::Clone(torch::lazy::OpList operands) const {
-  std::vector<torch::lazy::Value> operand_list(operands.begin(),
-                                               operands.end() - 1);
+  if (!has_token_) {
+    return torch_xla::MakeNode<AllReduce>(reduce_type_, operands.at(0), scale_,
+                                          groups_);
+  }
+  size_t num_inputs = (operands.size() - 1) / (has_residuals_ ? 2 : 1);
+  std::vector<torch::lazy::Value> operand_list(
+      operands.begin(), operands.begin() + num_inputs);
+  std::vector<torch::lazy::Value> residuals(operands.begin() + num_inputs,
+                                            operands.end() - 1);
   return torch_xla::MakeNode<AllReduce>(reduce_type_, operand_list,
                                         operands.back(), scale_, groups_,
-                                        pin_layout_);
+                                        pin_layout_, reduce_element_type_,
+                                        residuals);
 }
 
 XlaOpVector AllReduce::Lower(LoweringContext* loctx) const {
@@ -68,22 +102,38 @@ XlaOpVector AllReduce::Lower(LoweringContext* loctx) const {
   }
 
   auto& operand_list = operands();
+  size_t num_inputs = (operand_list.size() - 1) / (has_residuals_ ? 2 : 1);
   std::vector<xla::XlaOp> inputs;
-  inputs.reserve(operand_list.size());
+  inputs.reserve(num_inputs);
+  std::vector<xla::XlaOp> residuals;
   for (size_t i = 0; i + 1 < operand_list.size(); ++i) {
-    inputs.push_back(loctx->GetOutputOp(operand_list[i]));
+    xla::XlaOp op = loctx->GetOutputOp(operand_list[i]);
+    if (i < num_inputs) {
+      inputs.push_back(op);
+    } else {
+      residuals.push_back(op);
+    }
   }
   xla::XlaOp token = loctx->GetOutputOp(operand_list.back());
-  return ReturnOps(
-      BuildAllReduce(reduce_type_, inputs, token, scale_, groups_, pin_layout_),
-      loctx);
+  return ReturnOps(BuildAllReduce(reduce_type_, inputs, token, scale_, groups_,
+                                  pin_layout_, reduce_element_type_, residuals),
+                   loctx);
 }
 
 std::string AllReduce::ToString() const {
   std::stringstream ss;
   ss << XlaNode::ToString()
      << ", reduce_type=" << torch::lazy::GetEnumValue(reduce_type_)
-     << ", scale=" << scale_ << ", pin_layout=" << pin_layout_ << ", groups=(";
+     << ", scale=" << scale_ << ", pin_layout=" << pin_layout_;
+  if (reduce_element_type_.has_value()) {
+    ss << ", reduce_element_type="
+       << xla::primitive_util::LowercasePrimitiveTypeName(
+              *reduce_element_type_);
+  }
+  if (has_residuals_) {
+    ss << ", residuals=1";
+  }
+  ss << ", groups=(";
   for (size_t i = 0; i < groups_.size(); ++i) {
     ss << (i == 0 ? "(" : ",(");
     ss << absl::StrJoin(groups_[i], ", ") << ")";
@@ -1,6 +1,8 @@
 #ifndef XLA_TORCH_XLA_CSRC_OPS_ALL_REDUCE_H_
 #define XLA_TORCH_XLA_CSRC_OPS_ALL_REDUCE_H_
 
+#include <optional>
+
 #include "torch_xla/csrc/cross_replica_reduces.h"
 #include "torch_xla/csrc/ir.h"
 
@@ -8,10 +10,15 @@ namespace torch_xla {
 
 class AllReduce : public XlaNode {
  public:
-  AllReduce(AllReduceType reduce_type,
-            c10::ArrayRef<torch::lazy::Value> operands,
-            const torch::lazy::Value& token, double scale,
-            std::vector<std::vector<int64_t>> groups, bool pin_layout);
+  // The operands are followed by the `residuals`, if any, and the token, and
+  // so are the outputs. See BuildAllReduce() for `reduce_element_type` and
+  // `residuals`.
+  AllReduce(
+      AllReduceType reduce_type, c10::ArrayRef<torch::lazy::Value> operands,
+      const torch::lazy::Value& token, double scale,
+      std::vector<std::vector<int64_t>> groups, bool pin_layout,
+      std::optional<xla::PrimitiveType> reduce_element_type = std::nullopt,
+      c10::ArrayRef<torch::lazy::Value> residuals = {});
   AllReduce(AllReduceType reduce_type, torch::lazy::Value operand, double scale,
             std::vector<std::vector<int64_t>> groups);
 
@@ -29,12 +36,22 @@ class AllReduce : public XlaNode {
 
   bool pin_layout() const { return pin_layout_; }
 
+  bool has_token() const { return has_token_; }
+
+  const std::optional<xla::PrimitiveType>& reduce_element_type() const {
+    return reduce_element_type_;
+  }
+
+  bool has_residuals() const { return has_residuals_; }
+
  private:
   AllReduceType reduce_type_;
   double scale_;
   std::vector<std::vector<int64_t>> groups_;
   bool pin_layout_{false};
   bool has_token_{true};
+  std::optional<xla::PrimitiveType> reduce_element_type_;
+  bool has_residuals_{false};
 };
 
 }  // namespace torch_xla
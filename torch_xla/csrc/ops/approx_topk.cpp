@@ -0,0 +1,62 @@
+#include "torch_xla/csrc/ops/approx_topk.h"
+
+#include <sstream>
+
+#include "torch_xla/csrc/device.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& input, int64_t k,
+                           int64_t dim, bool largest, double recall_target) {
+  auto lower_for_shape_fn =
+      [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
+    return xla::Tuple(operands[0].builder(),
+                      CreateApproxTopK(operands[0], k, dim, largest,
+                                       recall_target, /*custom_call=*/false));
+  };
+  return InferOutputShape({GetXlaShape(input)}, lower_for_shape_fn);
+}
+
+}  // namespace
+
+ApproxTopK::ApproxTopK(const torch::lazy::Value& input, int64_t k, int64_t dim,
+                       bool largest, double recall_target)
+    : XlaNode(
+          xla_approx_topk, {input},
+          [&]() {
+            return NodeOutputShape(input, k, dim, largest, recall_target);
+          },
+          /*num_outputs=*/2,
+          torch::lazy::MHash(k, dim, largest, recall_target)),
+      k_(k),
+      dim_(dim),
+      largest_(largest),
+      recall_target_(recall_target) {}
+
+torch::lazy::NodePtr ApproxTopK::Clone(torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<ApproxTopK>(operands.at(0), k_, dim_, largest_,
+                                         recall_target_);
+}
+
+XlaOpVector ApproxTopK::Lower(LoweringContext* loctx) const {
+  xla::XlaOp input = loctx->GetOutputOp(operand(0));
+  bool custom_call =
+      CheckTpuDevice(static_cast<XlaDeviceType>(loctx->device().type()));
+  return ReturnOps(CreateApproxTopK(input, k_, dim_, largest_, recall_target_,
+                                    custom_call),
+                   loctx);
+}
+
+std::string ApproxTopK::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", k=" << k_ << ", dim=" << dim_
+     << ", largest=" << largest_ << ", recall_target=" << recall_target_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
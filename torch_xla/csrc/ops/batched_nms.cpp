@@ -0,0 +1,73 @@
+#include "torch_xla/csrc/ops/batched_nms.h"
+
+#include <sstream>
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& boxes,
+                           const torch::lazy::Value& scores,
+                           const torch::lazy::Value& classes,
+                           const torch::lazy::Value& iou_threshold,
+                           const torch::lazy::Value& score_threshold,
+                           int64_t max_output_size) {
+  auto lower_for_shape_fn =
+      [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
+    return xla::Tuple(operands[0].builder(),
+                      BuildBatchedNms(operands[0], operands[1], operands[2],
+                                      operands[3], operands[4],
+                                      max_output_size));
+  };
+  return InferOutputShape({GetXlaShape(boxes), GetXlaShape(scores),
+                           GetXlaShape(classes), GetXlaShape(iou_threshold),
+                           GetXlaShape(score_threshold)},
+                          lower_for_shape_fn);
+}
+
+}  // namespace
+
+BatchedNms::BatchedNms(const torch::lazy::Value& boxes,
+                       const torch::lazy::Value& scores,
+                       const torch::lazy::Value& classes,
+                       const torch::lazy::Value& iou_threshold,
+                       const torch::lazy::Value& score_threshold,
+                       int64_t max_output_size)
+    : XlaNode(
+          xla_batched_nms,
+          {boxes, scores, classes, iou_threshold, score_threshold},
+          [&]() {
+            return NodeOutputShape(boxes, scores, classes, iou_threshold,
+                                   score_threshold, max_output_size);
+          },
+          /*num_outputs=*/2, torch::lazy::MHash(max_output_size)),
+      max_output_size_(max_output_size) {}
+
+torch::lazy::NodePtr BatchedNms::Clone(torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<BatchedNms>(operands.at(0), operands.at(1),
+                                         operands.at(2), operands.at(3),
+                                         operands.at(4), max_output_size_);
+}
+
+XlaOpVector BatchedNms::Lower(LoweringContext* loctx) const {
+  xla::XlaOp boxes = loctx->GetOutputOp(operand(0));
+  xla::XlaOp scores = loctx->GetOutputOp(operand(1));
+  xla::XlaOp classes = loctx->GetOutputOp(operand(2));
+  xla::XlaOp iou_threshold = loctx->GetOutputOp(operand(3));
+  xla::XlaOp score_threshold = loctx->GetOutputOp(operand(4));
+  return ReturnOps(BuildBatchedNms(boxes, scores, classes, iou_threshold,
+                                   score_threshold, max_output_size_),
+                   loctx);
+}
+
+std::string BatchedNms::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", max_output_size=" << max_output_size_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
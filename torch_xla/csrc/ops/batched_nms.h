@@ -0,0 +1,36 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_BATCHED_NMS_H_
+#define XLA_TORCH_XLA_CSRC_OPS_BATCHED_NMS_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The per class NMS of a batch of box sets, built with BuildBatchedNms(). The
+// outputs are the [B, max_output_size] indices of the kept boxes, padded with
+// -1, and the [B] numbers of kept boxes.
+class BatchedNms : public XlaNode {
+ public:
+  BatchedNms(const torch::lazy::Value& boxes, const torch::lazy::Value& scores,
+             const torch::lazy::Value& classes,
+             const torch::lazy::Value& iou_threshold,
+             const torch::lazy::Value& score_threshold,
+             int64_t max_output_size);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  int64_t max_output_size() const { return max_output_size_; }
+
+ private:
+  int64_t max_output_size_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_BATCHED_NMS_H_
@@ -0,0 +1,67 @@
+#include "torch_xla/csrc/ops/blocked_attention.h"
+
+#include <sstream>
+#include <vector>
+
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/attention.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& query,
+                           const torch::lazy::Value& value) {
+  const xla::Shape& query_shape = GetXlaShape(query);
+  const xla::Shape& value_shape = GetXlaShape(value);
+  int64_t rank = query_shape.dimensions_size();
+  xla::Shape output_shape = query_shape;
+  output_shape.set_dimensions(rank - 1, value_shape.dimensions(rank - 1));
+  std::vector<int64_t> lse_dims(query_shape.dimensions().begin(),
+                                query_shape.dimensions().end() - 1);
+  return xla::ShapeUtil::MakeTupleShape(
+      {output_shape,
+       xla::ShapeUtil::MakeShape(xla::PrimitiveType::F32, lse_dims)});
+}
+
+}  // namespace
+
+BlockedAttention::BlockedAttention(const torch::lazy::Value& query,
+                                   const torch::lazy::Value& key,
+                                   const torch::lazy::Value& value,
+                                   double scale, bool is_causal,
+                                   int64_t block_size)
+    : XlaNode(xla_blocked_attention, {query, key, value},
+              NodeOutputShape(query, value),
+              /*num_outputs=*/2,
+              torch::lazy::MHash(scale, is_causal, block_size)),
+      scale_(scale),
+      is_causal_(is_causal),
+      block_size_(block_size) {}
+
+torch::lazy::NodePtr BlockedAttention::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<BlockedAttention>(operands.at(0), operands.at(1),
+                                               operands.at(2), scale_,
+                                               is_causal_, block_size_);
+}
+
+XlaOpVector BlockedAttention::Lower(LoweringContext* loctx) const {
+  xla::XlaOp query = loctx->GetOutputOp(operand(0));
+  xla::XlaOp key = loctx->GetOutputOp(operand(1));
+  xla::XlaOp value = loctx->GetOutputOp(operand(2));
+  return ReturnOps(BuildBlockedAttention(query, key, value, scale_,
+                                         is_causal_, block_size_),
+                   loctx);
+}
+
+std::string BlockedAttention::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", scale=" << scale_
+     << ", is_causal=" << is_causal_ << ", block_size=" << block_size_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,41 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_BLOCKED_ATTENTION_H_
+#define XLA_TORCH_XLA_CSRC_OPS_BLOCKED_ATTENTION_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The scaled dot product attention, computed over blocks of the keys with
+// BuildBlockedAttention(). The outputs are the attention output and the F32
+// log-sum-exps of the scores of every query.
+class BlockedAttention : public XlaNode {
+ public:
+  BlockedAttention(const torch::lazy::Value& query,
+                   const torch::lazy::Value& key,
+                   const torch::lazy::Value& value, double scale,
+                   bool is_causal, int64_t block_size);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  double scale() const { return scale_; }
+
+  bool is_causal() const { return is_causal_; }
+
+  int64_t block_size() const { return block_size_; }
+
+ private:
+  double scale_;
+  bool is_causal_;
+  int64_t block_size_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_BLOCKED_ATTENTION_H_
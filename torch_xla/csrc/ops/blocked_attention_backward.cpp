@@ -0,0 +1,54 @@
+#include "torch_xla/csrc/ops/blocked_attention_backward.h"
+
+#include <sstream>
+#include <vector>
+
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/attention.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+
+namespace torch_xla {
+
+BlockedAttentionBackward::BlockedAttentionBackward(
+    const torch::lazy::Value& grad_output, const torch::lazy::Value& query,
+    const torch::lazy::Value& key, const torch::lazy::Value& value,
+    const torch::lazy::Value& output, const torch::lazy::Value& lse,
+    double scale, bool is_causal, int64_t block_size)
+    : XlaNode(xla_blocked_attention_backward,
+              {grad_output, query, key, value, output, lse},
+              xla::ShapeUtil::MakeTupleShape(
+                  {GetXlaShape(query), GetXlaShape(key), GetXlaShape(value)}),
+              /*num_outputs=*/3,
+              torch::lazy::MHash(scale, is_causal, block_size)),
+      scale_(scale),
+      is_causal_(is_causal),
+      block_size_(block_size) {}
+
+torch::lazy::NodePtr BlockedAttentionBackward::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<BlockedAttentionBackward>(
+      operands.at(0), operands.at(1), operands.at(2), operands.at(3),
+      operands.at(4), operands.at(5), scale_, is_causal_, block_size_);
+}
+
+XlaOpVector BlockedAttentionBackward::Lower(LoweringContext* loctx) const {
+  std::vector<xla::XlaOp> ops;
+  for (const torch::lazy::Output& operand : operands()) {
+    ops.push_back(loctx->GetOutputOp(operand));
+  }
+  return ReturnOps(
+      BuildBlockedAttentionBackward(ops[0], ops[1], ops[2], ops[3], ops[4],
+                                    ops[5], scale_, is_causal_, block_size_),
+      loctx);
+}
+
+std::string BlockedAttentionBackward::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", scale=" << scale_
+     << ", is_causal=" << is_causal_ << ", block_size=" << block_size_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
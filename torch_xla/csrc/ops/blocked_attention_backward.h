@@ -0,0 +1,43 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_BLOCKED_ATTENTION_BACKWARD_H_
+#define XLA_TORCH_XLA_CSRC_OPS_BLOCKED_ATTENTION_BACKWARD_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The gradients of BlockedAttention for the query, the keys and the values,
+// computed over the same blocks of the keys.
+class BlockedAttentionBackward : public XlaNode {
+ public:
+  BlockedAttentionBackward(const torch::lazy::Value& grad_output,
+                           const torch::lazy::Value& query,
+                           const torch::lazy::Value& key,
+                           const torch::lazy::Value& value,
+                           const torch::lazy::Value& output,
+                           const torch::lazy::Value& lse, double scale,
+                           bool is_causal, int64_t block_size);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  double scale() const { return scale_; }
+
+  bool is_causal() const { return is_causal_; }
+
+  int64_t block_size() const { return block_size_; }
+
+ private:
+  double scale_;
+  bool is_causal_;
+  int64_t block_size_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_BLOCKED_ATTENTION_BACKWARD_H_
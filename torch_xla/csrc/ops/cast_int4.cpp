@@ -29,6 +29,12 @@ torch::lazy::NodePtr CastInt4::Clone(torch::lazy::OpList operands) const {
 
 XlaOpVector CastInt4::Lower(LoweringContext* loctx) const {
   xla::XlaOp weight = loctx->GetOutputOp(operand(0));
+  if (int4_vals_.empty()) {
+    // The int8 values of the weight are in the int4 range, so the conversion
+    // keeps them as they are.
+    return ReturnOp(xla::ConvertElementType(weight, xla::PrimitiveType::S4),
+                    loctx);
+  }
   xla::Shape weight_shape = ShapeHelper::ShapeOfXlaOp(weight);
   std::vector<xla::s4> values(int4_vals_.begin(), int4_vals_.end());
   const auto literal =
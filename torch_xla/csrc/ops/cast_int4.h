@@ -5,6 +5,9 @@
 
 namespace torch_xla {
 
+// Reinterprets the int8 weight, of values in [-8, 7], as int4. The lowering
+// embeds `int4_weight_values` as a constant, or converts the weight on the
+// device when they are empty.
 class CastInt4 : public XlaNode {
  public:
   CastInt4(const torch::lazy::Value& weight,
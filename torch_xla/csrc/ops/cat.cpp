@@ -14,6 +14,24 @@ xla::Shape NodeOutputShape(c10::ArrayRef<torch::lazy::Value> values,
       [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
     return BuildCat(operands, dim, dtype);
   };
+  // With static shapes, the output is the first input grown along `dim`, so
+  // the shape is inferred from that input alone rather than from a builder
+  // with a parameter per input, which is slow on hundreds of inputs.
+  xla::Shape first_shape = GetXlaShape(values.front());
+  bool is_static = first_shape.is_static();
+  int64_t dim_size = 0;
+  for (auto& value : values) {
+    const xla::Shape& shape = GetXlaShape(value);
+    if (!shape.is_static()) {
+      is_static = false;
+      break;
+    }
+    dim_size += shape.dimensions(dim);
+  }
+  if (is_static) {
+    first_shape.set_dimensions(dim, dim_size);
+    return InferOutputShape({first_shape}, lower_for_shape_fn);
+  }
   std::vector<xla::Shape> shapes;
   shapes.reserve(values.size());
   for (auto& value : values) {
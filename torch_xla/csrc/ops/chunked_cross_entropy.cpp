@@ -0,0 +1,55 @@
+#include "torch_xla/csrc/ops/chunked_cross_entropy.h"
+
+#include <sstream>
+
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/nll_loss.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& logits) {
+  const xla::Shape& logits_shape = GetXlaShape(logits);
+  xla::Shape losses_shape = xla::ShapeUtil::MakeShape(
+      logits_shape.element_type(), {logits_shape.dimensions(0)});
+  xla::Shape lse_shape = xla::ShapeUtil::MakeShape(
+      xla::PrimitiveType::F32, {logits_shape.dimensions(0)});
+  return xla::ShapeUtil::MakeTupleShape({losses_shape, lse_shape});
+}
+
+}  // namespace
+
+ChunkedCrossEntropy::ChunkedCrossEntropy(const torch::lazy::Value& logits,
+                                         const torch::lazy::Value& labels,
+                                         int64_t chunk_size, int ignore_index)
+    : XlaNode(xla_chunked_cross_entropy, {logits, labels},
+              NodeOutputShape(logits),
+              /*num_outputs=*/2, torch::lazy::MHash(chunk_size, ignore_index)),
+      chunk_size_(chunk_size),
+      ignore_index_(ignore_index) {}
+
+torch::lazy::NodePtr ChunkedCrossEntropy::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<ChunkedCrossEntropy>(
+      operands.at(0), operands.at(1), chunk_size_, ignore_index_);
+}
+
+XlaOpVector ChunkedCrossEntropy::Lower(LoweringContext* loctx) const {
+  xla::XlaOp logits = loctx->GetOutputOp(operand(0));
+  xla::XlaOp labels = loctx->GetOutputOp(operand(1));
+  return ReturnOps(
+      BuildChunkedCrossEntropy(logits, labels, chunk_size_, ignore_index_),
+      loctx);
+}
+
+std::string ChunkedCrossEntropy::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", chunk_size=" << chunk_size_
+     << ", ignore_index=" << ignore_index_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
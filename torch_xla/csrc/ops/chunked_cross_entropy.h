@@ -0,0 +1,37 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_CHUNKED_CROSS_ENTROPY_H_
+#define XLA_TORCH_XLA_CSRC_OPS_CHUNKED_CROSS_ENTROPY_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The cross-entropy of the rows of the logits, computed over chunks of the
+// classes with BuildChunkedCrossEntropy(). The outputs are the per row losses
+// and the F32 log-sum-exps of the rows.
+class ChunkedCrossEntropy : public XlaNode {
+ public:
+  ChunkedCrossEntropy(const torch::lazy::Value& logits,
+                      const torch::lazy::Value& labels, int64_t chunk_size,
+                      int ignore_index);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  int64_t chunk_size() const { return chunk_size_; }
+
+  int ignore_index() const { return ignore_index_; }
+
+ private:
+  int64_t chunk_size_;
+  int ignore_index_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_CHUNKED_CROSS_ENTROPY_H_
@@ -0,0 +1,46 @@
+#include "torch_xla/csrc/ops/chunked_cross_entropy_backward.h"
+
+#include <sstream>
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/nll_loss.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+
+namespace torch_xla {
+
+ChunkedCrossEntropyBackward::ChunkedCrossEntropyBackward(
+    const torch::lazy::Value& grad_output, const torch::lazy::Value& logits,
+    const torch::lazy::Value& labels, const torch::lazy::Value& lse,
+    int64_t chunk_size, int ignore_index)
+    : XlaNode(xla_chunked_cross_entropy_backward,
+              {grad_output, logits, labels, lse}, GetXlaShape(logits),
+              /*num_outputs=*/1, torch::lazy::MHash(chunk_size, ignore_index)),
+      chunk_size_(chunk_size),
+      ignore_index_(ignore_index) {}
+
+torch::lazy::NodePtr ChunkedCrossEntropyBackward::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<ChunkedCrossEntropyBackward>(
+      operands.at(0), operands.at(1), operands.at(2), operands.at(3),
+      chunk_size_, ignore_index_);
+}
+
+XlaOpVector ChunkedCrossEntropyBackward::Lower(LoweringContext* loctx) const {
+  xla::XlaOp grad_output = loctx->GetOutputOp(operand(0));
+  xla::XlaOp logits = loctx->GetOutputOp(operand(1));
+  xla::XlaOp labels = loctx->GetOutputOp(operand(2));
+  xla::XlaOp lse = loctx->GetOutputOp(operand(3));
+  return ReturnOp(
+      BuildChunkedCrossEntropyBackward(grad_output, logits, labels, lse,
+                                       chunk_size_, ignore_index_),
+      loctx);
+}
+
+std::string ChunkedCrossEntropyBackward::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", chunk_size=" << chunk_size_
+     << ", ignore_index=" << ignore_index_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,38 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_CHUNKED_CROSS_ENTROPY_BACKWARD_H_
+#define XLA_TORCH_XLA_CSRC_OPS_CHUNKED_CROSS_ENTROPY_BACKWARD_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The gradient of ChunkedCrossEntropy for the logits, computed over the same
+// chunks of the classes.
+class ChunkedCrossEntropyBackward : public XlaNode {
+ public:
+  ChunkedCrossEntropyBackward(const torch::lazy::Value& grad_output,
+                              const torch::lazy::Value& logits,
+                              const torch::lazy::Value& labels,
+                              const torch::lazy::Value& lse,
+                              int64_t chunk_size, int ignore_index);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  int64_t chunk_size() const { return chunk_size_; }
+
+  int ignore_index() const { return ignore_index_; }
+
+ private:
+  int64_t chunk_size_;
+  int ignore_index_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_CHUNKED_CROSS_ENTROPY_BACKWARD_H_
@@ -47,9 +47,8 @@ torch::lazy::hash_t LiteralHash(const xla::Literal& l) {
       return;
     }
     XLA_CHECK(xla::LayoutUtil::IsDenseArray(subshape));
-    auto data = absl::MakeConstSpan(
-        static_cast<const char*>(l.untyped_data(index)), l.size_bytes(index));
-    hash = torch::lazy::HashCombine(torch::lazy::Hash(data), hash);
+    hash = torch::lazy::HashCombine(
+        ContentHash(l.untyped_data(index), l.size_bytes(index)), hash);
   });
   return hash;
 }
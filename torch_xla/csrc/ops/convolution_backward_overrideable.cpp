@@ -68,9 +68,11 @@ XlaOpVector ConvolutionBackwardOverrideable::Lower(
   xla::XlaOp grad_output = loctx->GetOutputOp(operand(0));
   xla::XlaOp input = loctx->GetOutputOp(operand(1));
   xla::XlaOp weight = loctx->GetOutputOp(operand(2));
+  bool channels_last = UseChannelsLastConvolution(
+      static_cast<XlaDeviceType>(loctx->device().type()));
   auto grads = BuildConvolutionBackwardOverrideable(
       grad_output, input, weight, stride_, padding_, dilation_, transposed_,
-      output_padding_, groups_);
+      output_padding_, groups_, channels_last);
   return ReturnOps({std::move(grads.grad_input), std::move(grads.grad_weight),
                     std::move(grads.grad_bias)},
                    loctx);
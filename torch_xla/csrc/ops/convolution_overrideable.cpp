@@ -90,17 +90,20 @@ torch::lazy::NodePtr ConvolutionOverrideable::Clone(
 XlaOpVector ConvolutionOverrideable::Lower(LoweringContext* loctx) const {
   xla::XlaOp input = loctx->GetOutputOp(operand(0));
   xla::XlaOp kernel = loctx->GetOutputOp(operand(1));
+  bool channels_last = UseChannelsLastConvolution(
+      static_cast<XlaDeviceType>(loctx->device().type()));
   xla::XlaOp output;
   if (operands().size() == 3) {
     xla::XlaOp bias = loctx->GetOutputOp(operand(2));
-    output = BuildConvolutionOverrideableBias(input, kernel, bias, stride_,
-                                              padding_, dilation_, transposed_,
-                                              output_padding_, groups_);
+    output = BuildConvolutionOverrideableBias(
+        input, kernel, bias, stride_, padding_, dilation_, transposed_,
+        output_padding_, groups_, channels_last);
   } else {
     XLA_CHECK_EQ(operands().size(), 2);
     output = BuildConvolutionOverrideable(input, kernel, stride_, padding_,
                                           dilation_, transposed_,
-                                          output_padding_, groups_);
+                                          output_padding_, groups_,
+                                          channels_last);
   }
   return ReturnOp(output, loctx);
 }
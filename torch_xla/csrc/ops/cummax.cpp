@@ -16,15 +16,31 @@ namespace {
 
 xla::XlaOp LowerCumMax(xla::XlaOp input, int64_t dim) {
   const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
-  xla::XlaOp value_init_value = xla::ConstantLiteral(
-      input.builder(), xla::LiteralUtil::MinValue(input_shape.element_type()));
-  xla::XlaOp index_init_value = xla::ConstantLiteral(
-      input.builder(), xla::LiteralUtil::Zero(xla::PrimitiveType::S32));
   xla::XlaOp iota =
       xla::Iota(input.builder(),
                 xla::ShapeUtil::MakeShape(xla::PrimitiveType::S32,
                                           input_shape.dimensions()),
                 dim);
+  if (UseAssociativeScan(input_shape, dim)) {
+    // Combines like CreateMaxAndArgMaxComputation(), which keeps the lowest
+    // index of the equal values.
+    std::vector<xla::XlaOp> values_and_indices = BuildAssociativeScan(
+        {input, iota}, dim,
+        [](absl::Span<const xla::XlaOp> lhs,
+           absl::Span<const xla::XlaOp> rhs) {
+          xla::XlaOp cmp = xla::Ge(lhs[0], rhs[0]);
+          xla::XlaOp index = xla::Select(
+              xla::Eq(lhs[0], rhs[0]), xla::Min(lhs[1], rhs[1]),
+              xla::Select(cmp, lhs[1], rhs[1]));
+          return std::vector<xla::XlaOp>{xla::Select(cmp, lhs[0], rhs[0]),
+                                         index};
+        });
+    return xla::Tuple(input.builder(), values_and_indices);
+  }
+  xla::XlaOp value_init_value = xla::ConstantLiteral(
+      input.builder(), xla::LiteralUtil::MinValue(input_shape.element_type()));
+  xla::XlaOp index_init_value = xla::ConstantLiteral(
+      input.builder(), xla::LiteralUtil::Zero(xla::PrimitiveType::S32));
   xla::XlaComputation reducer = XlaHelpers::CreateMaxAndArgMaxComputation(
       input_shape.element_type(), xla::PrimitiveType::S32);
   return BuildCumulativeComputationWithIndices(
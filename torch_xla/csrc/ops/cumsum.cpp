@@ -18,6 +18,14 @@ xla::XlaOp LowerCumSum(xla::XlaOp input, int64_t dim,
                        std::optional<at::ScalarType> dtype) {
   xla::XlaOp casted_input = CastToScalarType(input, dtype);
   const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(casted_input);
+  if (UseAssociativeScan(input_shape, dim)) {
+    return BuildAssociativeScan(
+        {casted_input}, dim,
+        [](absl::Span<const xla::XlaOp> lhs,
+           absl::Span<const xla::XlaOp> rhs) {
+          return std::vector<xla::XlaOp>{lhs[0] + rhs[0]};
+        })[0];
+  }
   xla::XlaOp init = XlaHelpers::ScalarValue<float>(
       0, input_shape.element_type(), casted_input.builder());
   xla::XlaComputation reducer =
@@ -0,0 +1,39 @@
+#include "torch_xla/csrc/ops/dropout_mask.h"
+
+#include <sstream>
+
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+
+DropoutMask::DropoutMask(const torch::lazy::Value& seed,
+                         const xla::Shape& input_shape, float p)
+    : XlaNode(xla_dropout_mask, {seed},
+              xla::ShapeUtil::ChangeElementType(input_shape,
+                                                xla::PrimitiveType::PRED),
+              /*num_outputs=*/1,
+              torch::lazy::MHash(torch::lazy::Hash(input_shape), p)),
+      input_shape_(input_shape),
+      p_(p) {}
+
+torch::lazy::NodePtr DropoutMask::Clone(torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<DropoutMask>(operands.at(0), input_shape_, p_);
+}
+
+XlaOpVector DropoutMask::Lower(LoweringContext* loctx) const {
+  xla::XlaOp seed = loctx->GetOutputOp(operand(0));
+  return ReturnOp(BuildDropoutMask(seed, input_shape_, p_), loctx);
+}
+
+std::string DropoutMask::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", input_shape=" << input_shape_.ToString()
+     << ", p=" << p_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,31 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_DROPOUT_MASK_H_
+#define XLA_TORCH_XLA_CSRC_OPS_DROPOUT_MASK_H_
+
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The keep mask of a NativeDropout of an input of `input_shape`, regenerated
+// from the seed of the dropout, so that it does not have to stay alive from
+// the forward to the backward.
+class DropoutMask : public XlaNode {
+ public:
+  DropoutMask(const torch::lazy::Value& seed, const xla::Shape& input_shape,
+              float p);
+
+  std::string ToString() const override;
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+ private:
+  xla::Shape input_shape_;
+  float p_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_DROPOUT_MASK_H_
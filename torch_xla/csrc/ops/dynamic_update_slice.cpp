@@ -0,0 +1,30 @@
+#include "torch_xla/csrc/ops/dynamic_update_slice.h"
+
+#include "torch_xla/csrc/data_ops.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+
+namespace torch_xla {
+
+DynamicUpdateSlice::DynamicUpdateSlice(const torch::lazy::Value& input,
+                                       const torch::lazy::Value& source,
+                                       const torch::lazy::Value& start_indices)
+    : XlaNode(xla_dynamic_update_slice, {input, source, start_indices},
+              GetXlaShape(input),
+              /*num_outputs=*/1) {}
+
+torch::lazy::NodePtr DynamicUpdateSlice::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<DynamicUpdateSlice>(operands.at(0), operands.at(1),
+                                                 operands.at(2));
+}
+
+XlaOpVector DynamicUpdateSlice::Lower(LoweringContext* loctx) const {
+  xla::XlaOp input = loctx->GetOutputOp(operand(0));
+  xla::XlaOp source = loctx->GetOutputOp(operand(1));
+  xla::XlaOp start_indices = loctx->GetOutputOp(operand(2));
+  return ReturnOp(BuildDynamicUpdateSlice(input, source, start_indices),
+                  loctx);
+}
+
+}  // namespace torch_xla
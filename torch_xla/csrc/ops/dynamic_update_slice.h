@@ -0,0 +1,24 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_DYNAMIC_UPDATE_SLICE_H_
+#define XLA_TORCH_XLA_CSRC_OPS_DYNAMIC_UPDATE_SLICE_H_
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// Writes source into input, at the base indices held by the rank 1 tensor
+// start_indices. Unlike UpdateSlice, the indices are data, so that the node
+// of every step of a decoding loop is the same.
+class DynamicUpdateSlice : public XlaNode {
+ public:
+  DynamicUpdateSlice(const torch::lazy::Value& input,
+                     const torch::lazy::Value& source,
+                     const torch::lazy::Value& start_indices);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_DYNAMIC_UPDATE_SLICE_H_
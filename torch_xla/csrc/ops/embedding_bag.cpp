@@ -1,8 +1,6 @@
 #include "torch_xla/csrc/ops/embedding_bag.h"
 
-#include "tsl/platform/stacktrace.h"
 #include "xla/hlo/builder/lib/constants.h"
-#include "xla/hlo/builder/lib/loops.h"
 #include "xla/hlo/builder/lib/slicing.h"
 #include "xla/shape_util.h"
 
@@ -10,6 +8,7 @@
 #include "torch_xla/csrc/lowering_context.h"
 #include "torch_xla/csrc/ops/infer_output_shape.h"
 #include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/reduction.h"
 #include "torch_xla/csrc/shape_helper.h"
 #include "torch_xla/csrc/xla_lower_util.h"
 
@@ -18,6 +17,53 @@ namespace {
 const int MODE_SUM = 0;
 const int MODE_MEAN = 1;
 const int MODE_MAX = 2;
+
+// Returns the bag of every one of the `num_indices` indices, from the start
+// `offsets` of the `num_bags` bags. The bags are contiguous, so the bag of an
+// index is the number of bags after the first one starting at or before it.
+xla::XlaOp BuildOffsetToBag(xla::XlaOp offsets, int64_t num_indices,
+                            int64_t num_bags) {
+  xla::XlaBuilder* builder = offsets.builder();
+  xla::PrimitiveType type = ShapeHelper::ShapeOfXlaOp(offsets).element_type();
+  xla::XlaOp zero = xla::Zero(builder, type);
+  xla::XlaOp starts = xla::Broadcast(zero, {num_indices});
+  if (num_bags > 1) {
+    // Counts the bags starting at every index. The empty bags start at the
+    // index of the next bag, and the ones after the last index are dropped.
+    xla::ScatterDimensionNumbers dim_numbers;
+    dim_numbers.set_index_vector_dim(1);
+    dim_numbers.add_inserted_window_dims(0);
+    dim_numbers.add_scatter_dims_to_operand_dims(0);
+    starts = xla::Scatter(
+        starts,
+        xla::Reshape(xla::SliceInDim(offsets, 1, num_bags, 1, 0),
+                     {num_bags - 1, 1}),
+        xla::Broadcast(xla::One(builder, type), {num_bags - 1}),
+        XlaHelpers::CreateAddComputation(type), dim_numbers,
+        /*indices_are_sorted=*/true, /*unique_indices=*/false);
+  }
+  return BuildCumulativeComputation(
+      starts, 0, XlaHelpers::CreateAddComputation(type), zero);
+}
+
+// Reduces the [N, D] `rows` into the [B, D] `init` at their sorted [N] `bags`
+// with `combiner`.
+xla::XlaOp ReduceRowsToBags(xla::XlaOp init, xla::XlaOp bags, xla::XlaOp rows,
+                            const xla::XlaComputation& combiner) {
+  xla::ScatterDimensionNumbers dim_numbers;
+  dim_numbers.set_index_vector_dim(1);
+  dim_numbers.add_update_window_dims(1);
+  dim_numbers.add_inserted_window_dims(0);
+  dim_numbers.add_scatter_dims_to_operand_dims(0);
+  xla::XlaOp scatter_indices =
+      xla::Reshape(bags, {ShapeHelper::ShapeOfXlaOp(bags).dimensions(0), 1});
+  return xla::Scatter(init, scatter_indices, rows, combiner, dim_numbers,
+                      /*indices_are_sorted=*/true, /*unique_indices=*/false);
+}
+
+// Reduces the bags of embeddings with sorted segment reductions: every
+// looked up and weighted embedding is reduced into the row of its bag by a
+// scatter whose indices are sorted, since the bags are contiguous.
 std::vector<xla::XlaOp> BuildEmbeddingBag(xla::XlaOp weight, xla::XlaOp indices,
                                           xla::XlaOp offsets,
                                           xla::XlaOp per_sample_weights,
@@ -28,105 +74,66 @@ std::vector<xla::XlaOp> BuildEmbeddingBag(xla::XlaOp weight, xla::XlaOp indices,
   int64_t weight_dim = weight_shape.dimensions(1);
   xla::Shape indices_shape = ShapeHelper::ShapeOfXlaOp(indices);
   int64_t num_embeddings = indices_shape.dimensions(0);
-  XLA_CHECK(indices_shape.dimensions_size() == 1 ||
-            indices_shape.dimensions_size() == 2)
-      << "input has to be a 1D or 2D Tensor, but got Tensor of dimension "
+  XLA_CHECK(indices_shape.dimensions_size() == 1)
+      << "input has to be a 1D Tensor, but got Tensor of dimension "
       << indices_shape.dimensions_size();
-  if (indices_shape.dimensions_size() == 1) {
-    XLA_CHECK(offset_shape.dimensions_size() == 1)
-        << "offsets has to be a 1D Tensor, but got Tensor of dimension "
-        << offset_shape.dimensions_size();
-  }
+  XLA_CHECK(offset_shape.dimensions_size() == 1)
+      << "offsets has to be a 1D Tensor, but got Tensor of dimension "
+      << offset_shape.dimensions_size();
   XLA_CHECK(weight_shape.dimensions_size() == 2)
       << "weight has to be a 2D Tensor, but got Tensor of dimension "
       << weight_shape.dimensions_size();
-
-  xla::XlaOp output2 = xla::ZerosLike(indices);
-  xla::XlaOp output3 = xla::ZerosLike(offsets);
+  XLA_CHECK(mode == MODE_SUM || mode == MODE_MEAN || mode == MODE_MAX)
+      << "Unknown embedding_bag mode " << mode;
+  xla::XlaBuilder* builder = offsets.builder();
+  xla::PrimitiveType type = weight_shape.element_type();
+  xla::PrimitiveType offset_type = offset_shape.element_type();
+  int64_t num_bags = include_last_offset ? n - 1 : n;
+
+  xla::XlaOp offset2bag = BuildOffsetToBag(offsets, num_embeddings, num_bags);
+  xla::XlaOp bag_size = ReduceRowsToBags(
+      xla::Zeros(builder, xla::ShapeUtil::MakeShape(offset_type, {n, 1})),
+      offset2bag,
+      xla::Broadcast(xla::One(builder, offset_type), {num_embeddings, 1}),
+      XlaHelpers::CreateAddComputation(offset_type));
+  bag_size = xla::Reshape(bag_size, {n});
   std::vector<int64_t> sizes = {n, weight_dim};
-  xla::XlaOp output4 =
-      xla::Zeros(offsets.builder(),
-                 xla::ShapeUtil::MakeShape(offset_shape.element_type(), sizes));
+  xla::XlaOp max_indices =
+      xla::Zeros(builder, xla::ShapeUtil::MakeShape(offset_type, sizes));
 
   xla::XlaOp embeddings = xla::TorchIndexSelect(weight, indices, 0);
   xla::XlaOp embeddings_weighted = xla::Mul(
       embeddings, xla::ConvertElementType(
                       xla::BroadcastInDim(per_sample_weights,
                                           {num_embeddings, weight_dim}, {0}),
-                      weight_shape.element_type()));
-
-  std::vector<xla::Shape> shape_elements = {
-      xla::ShapeUtil::MakeShape(offset_shape.element_type(), {}),
-      xla::ShapeUtil::MakeShape(offset_shape.element_type(), {}),
-      xla::ShapeUtil::MakeShape(weight_shape.element_type(),
-                                {num_embeddings, weight_dim}),
-      xla::ShapeUtil::MakeShape(weight_shape.element_type(), {1, weight_dim})};
-  xla::Shape result_shape = xla::ShapeUtil::MakeTupleShape(shape_elements);
-
-  xla::XlaComputation condition;
-  {
-    xla::XlaBuilder builder("condition");
-    auto prev = xla::Parameter(&builder, 0, result_shape, "prev");
-    auto index = xla::GetTupleElement(prev, 0);
-    auto final_value = xla::GetTupleElement(prev, 1);
-    xla::Lt(index, final_value);
-    condition = builder.Build().value();
-  }
-
-  xla::XlaComputation body;
-  {
-    xla::XlaBuilder builder("body");
-    auto prev = xla::Parameter(&builder, 0, result_shape, "prev");
-    auto index = xla::GetTupleElement(prev, 0);
-    auto emb = xla::GetTupleElement(prev, 2);
-    auto w = xla::GetTupleElement(prev, 3);
-
-    xla::XlaOp slice = xla::DynamicSlice(
-        emb,
-        {index, xla::ConvertElementType(xla::ConstantR0<int64_t>(&builder, 0),
-                                        offset_shape.element_type())},
-        {1, weight_dim});
-    xla::XlaOp result =
-        mode == MODE_SUM ? xla::Add(w, slice) : xla::Max(w, slice);
-
-    xla::Tuple(&builder,
-               {
-                   xla::Add(index, xla::ConvertElementType(
-                                       xla::ConstantR0<int64_t>(&builder, 1),
-                                       offset_shape.element_type())),
-                   xla::GetTupleElement(prev, 1),
-                   xla::GetTupleElement(prev, 2),
-                   result,
-               });
-    body = builder.Build().value();
+                      type));
+  xla::Shape output_shape =
+      xla::ShapeUtil::MakeShape(type, {num_bags, weight_dim});
+  xla::XlaOp bag_rows_size = xla::BroadcastInDim(
+      xla::ConvertElementType(xla::SliceInDim(bag_size, 0, num_bags, 1, 0),
+                              type),
+      output_shape.dimensions(), {0});
+  xla::XlaOp output;
+  if (mode == MODE_MAX) {
+    output = ReduceRowsToBags(
+        xla::Broadcast(xla::MinValue(builder, type),
+                       output_shape.dimensions()),
+        offset2bag, embeddings_weighted,
+        XlaHelpers::CreateMaxComputation(type));
+    // The empty bags are zeros.
+    output = xla::Select(xla::Gt(bag_rows_size, xla::Zero(builder, type)),
+                         output, xla::ZerosLike(output));
+  } else {
+    output = ReduceRowsToBags(xla::Zeros(builder, output_shape), offset2bag,
+                              embeddings_weighted,
+                              XlaHelpers::CreateAddComputation(type));
+    if (mode == MODE_MEAN) {
+      output = output / xla::Max(bag_rows_size, xla::One(builder, type));
+    }
   }
-
-  xla::Array<float> initial_vector({1, weight_dim}, 0.f);
-  std::vector<xla::XlaOp> results;
-  for (int64_t i = 0; i < n; i++) {
-    xla::XlaOp start = xla::DynamicSlice(
-        offsets, {xla::ConstantR0<int64_t>(offsets.builder(), i)}, {1});
-    if (i == n - 1 && include_last_offset) continue;
-    xla::XlaOp end =
-        i == n - 1 && !include_last_offset
-            ? xla::ConvertElementType(xla::ConstantR1<int64_t>(
-                                          offsets.builder(), 1, num_embeddings),
-                                      offset_shape.element_type())
-            : xla::DynamicSlice(
-                  offsets, {xla::ConstantR0<int64_t>(offsets.builder(), i + 1)},
-                  {1});
-    // Create a While node with computations for the condition and the body.
-    auto init_tuple = xla::Tuple(
-        offsets.builder(),
-        {xla::Reshape(start, {}), xla::Reshape(end, {}), embeddings_weighted,
-         xla::ConvertElementType(
-             xla::ConstantFromArray<float>(offsets.builder(), initial_vector),
-             weight_shape.element_type())});
-    auto result = xla::While(condition, body, init_tuple);
-    results.push_back(xla::GetTupleElement(result, 3));
-  };
-  xla::XlaOp output1 = xla::ConcatInDim(offsets.builder(), results, 0);
-  return {output1, output2, output3, output4};
+  xla::XlaOp output2 = xla::ConvertElementType(offset2bag,
+                                               indices_shape.element_type());
+  return {output, output2, bag_size, max_indices};
 }
 
 xla::Shape NodeOutputShapes(const torch::lazy::Value& weight,
@@ -176,7 +183,8 @@ EmbeddingBag::EmbeddingBag(const torch::lazy::Value& weight,
 torch::lazy::NodePtr EmbeddingBag::Clone(torch::lazy::OpList operands) const {
   return torch_xla::MakeNode<EmbeddingBag>(operands.at(0), operands.at(1),
                                            operands.at(2), mode_,
-                                           operands.at(3), false);
+                                           operands.at(3),
+                                           include_last_offset_);
 }
 
 XlaOpVector EmbeddingBag::Lower(LoweringContext* loctx) const {
@@ -0,0 +1,112 @@
+#include "torch_xla/csrc/ops/embedding_bag_backward.h"
+
+#include <sstream>
+#include <vector>
+
+#include "xla/hlo/builder/lib/constants.h"
+#include "xla/hlo/builder/lib/slicing.h"
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/shape_helper.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+const int MODE_MEAN = 1;
+
+std::vector<xla::XlaOp> BuildEmbeddingBagBackward(
+    xla::XlaOp grad, xla::XlaOp indices, xla::XlaOp offset2bag,
+    xla::XlaOp bag_size, xla::XlaOp per_sample_weights, int64_t num_weights,
+    int64_t mode, bool sparse) {
+  const xla::Shape& grad_shape = ShapeHelper::ShapeOfXlaOp(grad);
+  xla::PrimitiveType type = grad_shape.element_type();
+  int64_t num_indices = ShapeHelper::ShapeOfXlaOp(indices).dimensions(0);
+  int64_t weight_dim = grad_shape.dimensions(1);
+  std::vector<int64_t> rows_dims = {num_indices, weight_dim};
+
+  // Every index gets the gradient of its bag, scaled like its embedding was.
+  xla::XlaOp rows = xla::TorchIndexSelect(grad, offset2bag, 0);
+  xla::XlaOp scale = xla::ConvertElementType(per_sample_weights, type);
+  if (mode == MODE_MEAN) {
+    xla::XlaOp index_bag_size = xla::ConvertElementType(
+        xla::TorchIndexSelect(bag_size, offset2bag, 0), type);
+    scale = scale / xla::Max(index_bag_size, xla::One(grad.builder(), type));
+  }
+  rows = rows * xla::BroadcastInDim(scale, rows_dims, {0});
+
+  if (sparse) {
+    auto [unique_indices, values] = CreateUniqueSegmentSums(
+        xla::ConvertElementType(indices, xla::PrimitiveType::S64), rows,
+        num_weights);
+    return {unique_indices, values};
+  }
+  xla::XlaOp zeros =
+      xla::Zeros(grad.builder(),
+                 xla::ShapeUtil::MakeShape(type, {num_weights, weight_dim}));
+  return {CreateSortedIndexAdd(zeros, xla::Reshape(indices, {num_indices, 1}),
+                               rows)};
+}
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& grad,
+                           const torch::lazy::Value& indices,
+                           int64_t num_weights, bool sparse) {
+  const xla::Shape& grad_shape = GetXlaShape(grad);
+  int64_t weight_dim = grad_shape.dimensions(1);
+  if (!sparse) {
+    return xla::ShapeUtil::MakeShape(grad_shape.element_type(),
+                                     {num_weights, weight_dim});
+  }
+  int64_t num_indices = GetXlaShape(indices).dimensions(0);
+  return xla::ShapeUtil::MakeTupleShape(
+      {xla::ShapeUtil::MakeShape(xla::PrimitiveType::S64, {num_indices}),
+       xla::ShapeUtil::MakeShape(grad_shape.element_type(),
+                                 {num_indices, weight_dim})});
+}
+
+}  // namespace
+
+EmbeddingBagBackward::EmbeddingBagBackward(
+    const torch::lazy::Value& grad, const torch::lazy::Value& indices,
+    const torch::lazy::Value& offset2bag, const torch::lazy::Value& bag_size,
+    const torch::lazy::Value& per_sample_weights, int64_t num_weights,
+    int64_t mode, bool sparse)
+    : XlaNode(sparse ? xla_embedding_bag_sparse_backward
+                     : torch::lazy::OpKind(at::aten::_embedding_bag_backward),
+              {grad, indices, offset2bag, bag_size, per_sample_weights},
+              NodeOutputShape(grad, indices, num_weights, sparse),
+              /*num_outputs=*/sparse ? 2 : 1,
+              torch::lazy::MHash(num_weights, mode, sparse)),
+      num_weights_(num_weights),
+      mode_(mode),
+      sparse_(sparse) {}
+
+torch::lazy::NodePtr EmbeddingBagBackward::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<EmbeddingBagBackward>(
+      operands.at(0), operands.at(1), operands.at(2), operands.at(3),
+      operands.at(4), num_weights_, mode_, sparse_);
+}
+
+XlaOpVector EmbeddingBagBackward::Lower(LoweringContext* loctx) const {
+  xla::XlaOp grad = loctx->GetOutputOp(operand(0));
+  xla::XlaOp indices = loctx->GetOutputOp(operand(1));
+  xla::XlaOp offset2bag = loctx->GetOutputOp(operand(2));
+  xla::XlaOp bag_size = loctx->GetOutputOp(operand(3));
+  xla::XlaOp per_sample_weights = loctx->GetOutputOp(operand(4));
+  return ReturnOps(BuildEmbeddingBagBackward(grad, indices, offset2bag,
+                                             bag_size, per_sample_weights,
+                                             num_weights_, mode_, sparse_),
+                   loctx);
+}
+
+std::string EmbeddingBagBackward::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", num_weights=" << num_weights_
+     << ", mode=" << mode_ << ", sparse=" << sparse_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,47 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_EMBEDDING_BAG_BACKWARD_H_
+#define XLA_TORCH_XLA_CSRC_OPS_EMBEDDING_BAG_BACKWARD_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The weight gradient of an EmbeddingBag of the sum or mean mode, from the
+// offset2bag and bag_size it returns. The gradients of the rows looked up more
+// than once are summed in sorted index order. The dense gradient is the
+// [num_weights, D] weight gradient. The sparse one has two outputs, for the N
+// indices: the S64 unique indices, in increasing order and padded with
+// num_weights, and the [N, D] gradient rows of those indices, zero for the
+// padding.
+class EmbeddingBagBackward : public XlaNode {
+ public:
+  EmbeddingBagBackward(const torch::lazy::Value& grad,
+                       const torch::lazy::Value& indices,
+                       const torch::lazy::Value& offset2bag,
+                       const torch::lazy::Value& bag_size,
+                       const torch::lazy::Value& per_sample_weights,
+                       int64_t num_weights, int64_t mode, bool sparse);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  int64_t num_weights() const { return num_weights_; }
+
+  int64_t mode() const { return mode_; }
+
+  bool sparse() const { return sparse_; }
+
+ private:
+  int64_t num_weights_;
+  int64_t mode_;
+  bool sparse_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_EMBEDDING_BAG_BACKWARD_H_
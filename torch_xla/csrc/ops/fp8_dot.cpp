@@ -0,0 +1,97 @@
+#include "torch_xla/csrc/ops/fp8_dot.h"
+
+#include <sstream>
+#include <vector>
+
+#include "torch_xla/csrc/dtype.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/shape_helper.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+std::vector<xla::XlaOp> LowerFp8Dot(absl::Span<const xla::XlaOp> operands,
+                                    at::ScalarType lhs_type,
+                                    at::ScalarType rhs_type,
+                                    int64_t rhs_contracting_dim,
+                                    int64_t margin) {
+  return BuildFp8Dot(
+      operands[0], operands[1], operands[2], operands[3], operands[4],
+      operands[5], XlaTypeFromTorchType(lhs_type),
+      XlaTypeFromTorchType(rhs_type), rhs_contracting_dim, margin,
+      ShapeHelper::ShapeOfXlaOp(operands[0]).element_type());
+}
+
+xla::Shape NodeOutputShape(absl::Span<const torch::lazy::Value> operands,
+                           at::ScalarType lhs_type, at::ScalarType rhs_type,
+                           int64_t rhs_contracting_dim, int64_t margin) {
+  auto lower_for_shape_fn =
+      [&](absl::Span<const xla::XlaOp> ops) -> xla::XlaOp {
+    return xla::Tuple(ops[0].builder(),
+                      LowerFp8Dot(ops, lhs_type, rhs_type,
+                                  rhs_contracting_dim, margin));
+  };
+  std::vector<xla::Shape> shapes;
+  for (const torch::lazy::Value& operand : operands) {
+    shapes.push_back(GetXlaShape(operand));
+  }
+  return InferOutputShape(shapes, lower_for_shape_fn);
+}
+
+}  // namespace
+
+Fp8Dot::Fp8Dot(const torch::lazy::Value& lhs, const torch::lazy::Value& rhs,
+               const torch::lazy::Value& lhs_scale,
+               const torch::lazy::Value& rhs_scale,
+               const torch::lazy::Value& lhs_amax_history,
+               const torch::lazy::Value& rhs_amax_history,
+               at::ScalarType lhs_type, at::ScalarType rhs_type,
+               int64_t rhs_contracting_dim, int64_t margin)
+    : XlaNode(
+          xla_fp8_dot,
+          {lhs, rhs, lhs_scale, rhs_scale, lhs_amax_history, rhs_amax_history},
+          [&]() {
+            return NodeOutputShape({lhs, rhs, lhs_scale, rhs_scale,
+                                    lhs_amax_history, rhs_amax_history},
+                                   lhs_type, rhs_type, rhs_contracting_dim,
+                                   margin);
+          },
+          /*num_outputs=*/5,
+          torch::lazy::MHash(static_cast<int>(lhs_type),
+                             static_cast<int>(rhs_type), rhs_contracting_dim,
+                             margin)),
+      lhs_type_(lhs_type),
+      rhs_type_(rhs_type),
+      rhs_contracting_dim_(rhs_contracting_dim),
+      margin_(margin) {}
+
+torch::lazy::NodePtr Fp8Dot::Clone(torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<Fp8Dot>(
+      operands.at(0), operands.at(1), operands.at(2), operands.at(3),
+      operands.at(4), operands.at(5), lhs_type_, rhs_type_,
+      rhs_contracting_dim_, margin_);
+}
+
+XlaOpVector Fp8Dot::Lower(LoweringContext* loctx) const {
+  std::vector<xla::XlaOp> ops;
+  for (const torch::lazy::Output& operand : operands()) {
+    ops.push_back(loctx->GetOutputOp(operand));
+  }
+  return ReturnOps(
+      LowerFp8Dot(ops, lhs_type_, rhs_type_, rhs_contracting_dim_, margin_),
+      loctx);
+}
+
+std::string Fp8Dot::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", lhs_type=" << lhs_type_
+     << ", rhs_type=" << rhs_type_
+     << ", rhs_contracting_dim=" << rhs_contracting_dim_
+     << ", margin=" << margin_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,41 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_FP8_DOT_H_
+#define XLA_TORCH_XLA_CSRC_OPS_FP8_DOT_H_
+
+#include <c10/core/ScalarType.h>
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The FP8 product with delayed scaling of BuildFp8Dot(), which carries the
+// scales and the amax histories of its operands, so that they are updated on
+// the device, in the executable of the product. The outputs are the product,
+// then the new scales and amax histories of the lhs and of the rhs.
+class Fp8Dot : public XlaNode {
+ public:
+  Fp8Dot(const torch::lazy::Value& lhs, const torch::lazy::Value& rhs,
+         const torch::lazy::Value& lhs_scale,
+         const torch::lazy::Value& rhs_scale,
+         const torch::lazy::Value& lhs_amax_history,
+         const torch::lazy::Value& rhs_amax_history, at::ScalarType lhs_type,
+         at::ScalarType rhs_type, int64_t rhs_contracting_dim, int64_t margin);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+ private:
+  at::ScalarType lhs_type_;
+  at::ScalarType rhs_type_;
+  int64_t rhs_contracting_dim_;
+  int64_t margin_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_FP8_DOT_H_
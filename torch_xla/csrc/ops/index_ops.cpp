@@ -1,5 +1,7 @@
 #include "torch_xla/csrc/ops/index_ops.h"
 
+#include <limits>
+
 #include <ATen/ExpandUtils.h>
 #include <ATen/Functions.h>
 #include <ATen/ops/select_copy.h>
@@ -11,6 +13,7 @@
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/lowering_context.h"
 #include "torch_xla/csrc/ops/arithmetic_ir_ops.h"
+#include "torch_xla/csrc/ops/cast.h"
 #include "torch_xla/csrc/ops/expand.h"
 #include "torch_xla/csrc/ops/index_get.h"
 #include "torch_xla/csrc/ops/index_put.h"
@@ -19,6 +22,7 @@
 #include "torch_xla/csrc/ops/permute.h"
 #include "torch_xla/csrc/ops/scalar.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/util.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/tensor_methods.h"
@@ -29,6 +33,25 @@
 namespace torch_xla {
 namespace {
 
+bool DowncastIndices() {
+  static const bool downcast_indices =
+      runtime::sys_util::GetEnvBool("XLA_DOWNCAST_INDICES", false);
+  return downcast_indices;
+}
+
+// Returns the size of the largest of the `num_indices` dimensions of `base`
+// indexed from `start_dim` on.
+int64_t GetMaxIndexedDimSize(const XLATensorPtr& base, size_t num_indices,
+                             int64_t start_dim) {
+  auto base_shape_ref = base->shape();
+  int64_t max_dim_size = 0;
+  for (size_t i = 0; i < num_indices; ++i) {
+    max_dim_size = std::max(max_dim_size,
+                            base_shape_ref.get().dimensions(start_dim + i));
+  }
+  return max_dim_size;
+}
+
 void CheckIndexTensorTypes(
     const c10::List<std::optional<at::Tensor>>& indices) {
   for (const std::optional<at::Tensor>& tensor : indices) {
@@ -279,6 +302,25 @@ torch::lazy::Value EnsureRank1(const torch::lazy::Value& index) {
              : index;
 }
 
+torch::lazy::Value MaybeDowncastIndex(const torch::lazy::Value& index,
+                                      int64_t max_dim_size) {
+  if (!DowncastIndices() ||
+      GetXlaShape(index).element_type() != xla::PrimitiveType::S64 ||
+      max_dim_size > std::numeric_limits<int32_t>::max()) {
+    return index;
+  }
+  TORCH_LAZY_COUNTER("DowncastIndex", 1);
+  // An s32 index cast to s64 is used as is, rather than cast back.
+  const Cast* cast = dynamic_cast<const Cast*>(index.node.get());
+  if (cast != nullptr) {
+    torch::lazy::Value input(cast->operand_node(0), cast->operand(0).index);
+    if (GetXlaShape(input).element_type() == xla::PrimitiveType::S32) {
+      return input;
+    }
+  }
+  return torch_xla::MakeNode<Cast>(index, xla::PrimitiveType::S32);
+}
+
 bool HasZeroElementIndex(absl::Span<const XLATensorPtr> indices) {
   return std::any_of(indices.begin(), indices.end(),
                      [](const XLATensorPtr& index) {
@@ -343,8 +385,12 @@ XLATensorPtr IndexByTensors(const XLATensorPtr& base,
   XLA_ASSIGN_OR_THROW(absl_nonnull XLATensorPtr indices_nd,
                       tensor_methods::stack(canonical_indices, indices_rank));
   return XLATensor::Create(
-      torch_xla::MakeNode<IndexGet>(base->GetIrValue(),
-                                    indices_nd->GetIrValue(), start_dim),
+      torch_xla::MakeNode<IndexGet>(
+          base->GetIrValue(),
+          MaybeDowncastIndex(
+              indices_nd->GetIrValue(),
+              GetMaxIndexedDimSize(base, indices.size(), start_dim)),
+          start_dim),
       base->GetDevice(), base->dtype());
 }
 
@@ -363,9 +409,12 @@ torch::lazy::Value IndexPutByTensors(
   XLA_ASSIGN_OR_THROW(absl_nonnull XLATensorPtr indices_nd,
                       tensor_methods::stack(canonical_indices, indices_rank));
   return torch_xla::MakeNode<Permute>(
-      torch_xla::MakeNode<IndexPut>(base->GetIrValue(),
-                                    indices_nd->GetIrValue(), start_dim,
-                                    values->GetIrValue(), accumulate),
+      torch_xla::MakeNode<IndexPut>(
+          base->GetIrValue(),
+          MaybeDowncastIndex(
+              indices_nd->GetIrValue(),
+              GetMaxIndexedDimSize(base, indices.size(), start_dim)),
+          start_dim, values->GetIrValue(), accumulate),
       torch::lazy::ToVector<int64_t>(result_permutation));
 }
 
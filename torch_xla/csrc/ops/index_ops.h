@@ -54,6 +54,12 @@ CanonicalIndexInfo GetCanonicalIndexInfo(
 // Expands a rank <= 1 tensor to rank 1, if necessary.
 torch::lazy::Value EnsureRank1(const torch::lazy::Value& index);
 
+// Converts an s64 `index`, into dimensions of at most `max_dim_size` elements,
+// to s32 when XLA_DOWNCAST_INDICES is set, as every index in range of those
+// dimensions fits. Returns `index` unchanged otherwise.
+torch::lazy::Value MaybeDowncastIndex(const torch::lazy::Value& index,
+                                      int64_t max_dim_size);
+
 // Implements indexing by tensors of long according to the top-level
 // description.
 XLATensorPtr IndexByTensors(const XLATensorPtr& base,
@@ -33,6 +33,12 @@ XlaOpVector IndexPut::Lower(LoweringContext* loctx) const {
   xla::XlaOp base = loctx->GetOutputOp(operand(0));
   xla::XlaOp indices = loctx->GetOutputOp(operand(1));
   xla::XlaOp values = loctx->GetOutputOp(operand(2));
+  const xla::Shape& indices_shape = GetXlaShape(operand(1));
+  if (accumulate_ && start_dim_ == 0 &&
+      indices_shape.dimensions(indices_shape.dimensions_size() - 1) == 1 &&
+      UseSortedScatterAdd(xla_shape())) {
+    return ReturnOp(CreateSortedIndexAdd(base, indices, values), loctx);
+  }
   xla::XlaOp output =
       CreateIndexUpdate(base, indices, start_dim_, values,
                         accumulate_ ? add_scatter_combiner : nullptr);
@@ -0,0 +1,115 @@
+#include "torch_xla/csrc/ops/lamb_optimizer_step.h"
+
+#include <sstream>
+#include <vector>
+
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+// The operands are the scalars, then the tensors of each kind, each in the
+// order of the parameters.
+constexpr size_t kNumScalarOperands = 6;
+constexpr size_t kNumOutputsPerParam = 4;
+
+std::vector<torch::lazy::Value> GetOperandList(
+    const torch::lazy::Value& found_inf,
+    c10::ArrayRef<torch::lazy::Value> steps,
+    c10::ArrayRef<torch::lazy::Value> params,
+    c10::ArrayRef<torch::lazy::Value> grads,
+    c10::ArrayRef<torch::lazy::Value> exp_avgs,
+    c10::ArrayRef<torch::lazy::Value> exp_avg_sqs,
+    const torch::lazy::Value& beta1, const torch::lazy::Value& beta2,
+    const torch::lazy::Value& lr, const torch::lazy::Value& weight_decay,
+    const torch::lazy::Value& eps) {
+  std::vector<torch::lazy::Value> operands = {found_inf, beta1,        beta2,
+                                              lr,        weight_decay, eps};
+  for (c10::ArrayRef<torch::lazy::Value> values :
+       {steps, params, grads, exp_avgs, exp_avg_sqs}) {
+    XLA_CHECK_EQ(values.size(), params.size());
+    operands.insert(operands.end(), values.begin(), values.end());
+  }
+  return operands;
+}
+
+xla::Shape NodeOutputShape(c10::ArrayRef<torch::lazy::Value> steps,
+                           c10::ArrayRef<torch::lazy::Value> params) {
+  std::vector<xla::Shape> shapes;
+  for (size_t i = 0; i < params.size(); ++i) {
+    const xla::Shape& param_shape = GetXlaShape(params[i]);
+    shapes.push_back(/*step=*/GetXlaShape(steps[i]));
+    shapes.push_back(/*param=*/param_shape);
+    shapes.push_back(/*exp_avg=*/param_shape);
+    shapes.push_back(/*exp_avg_sq=*/param_shape);
+  }
+  return xla::ShapeUtil::MakeTupleShape(shapes);
+}
+
+}  // namespace
+
+LambOptimizerStep::LambOptimizerStep(
+    const torch::lazy::Value& found_inf,
+    c10::ArrayRef<torch::lazy::Value> steps,
+    c10::ArrayRef<torch::lazy::Value> params,
+    c10::ArrayRef<torch::lazy::Value> grads,
+    c10::ArrayRef<torch::lazy::Value> exp_avgs,
+    c10::ArrayRef<torch::lazy::Value> exp_avg_sqs,
+    const torch::lazy::Value& beta1, const torch::lazy::Value& beta2,
+    const torch::lazy::Value& lr, const torch::lazy::Value& weight_decay,
+    const torch::lazy::Value& eps, bool use_weight_decay)
+    : XlaNode(xla_lamb_optimizer_step,
+              GetOperandList(found_inf, steps, params, grads, exp_avgs,
+                             exp_avg_sqs, beta1, beta2, lr, weight_decay, eps),
+              NodeOutputShape(steps, params),
+              /*num_outputs=*/params.size() * kNumOutputsPerParam,
+              torch::lazy::MHash(params.size(), use_weight_decay)),
+      num_params_(params.size()),
+      use_weight_decay_(use_weight_decay) {}
+
+torch::lazy::NodePtr LambOptimizerStep::Clone(
+    torch::lazy::OpList operands) const {
+  auto tensors = [&](size_t kind) {
+    return operands.slice(kNumScalarOperands + kind * num_params_,
+                          num_params_);
+  };
+  return torch_xla::MakeNode<LambOptimizerStep>(
+      operands.at(0), tensors(0), tensors(1), tensors(2), tensors(3),
+      tensors(4), operands.at(1), operands.at(2), operands.at(3),
+      operands.at(4), operands.at(5), use_weight_decay_);
+}
+
+XlaOpVector LambOptimizerStep::Lower(LoweringContext* loctx) const {
+  std::vector<xla::XlaOp> ops;
+  ops.reserve(operands().size());
+  for (const torch::lazy::Output& operand : operands()) {
+    ops.push_back(loctx->GetOutputOp(operand));
+  }
+  auto tensor = [&](size_t kind, size_t i) {
+    return ops[kNumScalarOperands + kind * num_params_ + i];
+  };
+  std::vector<xla::XlaOp> results;
+  results.reserve(num_params_ * kNumOutputsPerParam);
+  for (size_t i = 0; i < num_params_; ++i) {
+    std::vector<xla::XlaOp> param_results = BuildLambOptimizerStep(
+        ops[0], tensor(0, i), tensor(1, i), tensor(2, i), tensor(3, i),
+        tensor(4, i), ops[1], ops[2], ops[3], ops[4], ops[5],
+        use_weight_decay_);
+    results.insert(results.end(), param_results.begin(), param_results.end());
+  }
+  return ReturnOps(results, loctx);
+}
+
+std::string LambOptimizerStep::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", num_params=" << num_params_
+     << ", use_weight_decay=" << use_weight_decay_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,42 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_LAMB_OPTIMIZER_STEP_H_
+#define XLA_TORCH_XLA_CSRC_OPS_LAMB_OPTIMIZER_STEP_H_
+
+#include <cstddef>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The LAMB step of a list of parameters, in a single node sharing the
+// found_inf flag and the hyper parameters. The trust ratio is computed per
+// parameter. The outputs are the step, the parameter, exp_avg and exp_avg_sq
+// of each parameter, one parameter after the other.
+class LambOptimizerStep : public XlaNode {
+ public:
+  LambOptimizerStep(const torch::lazy::Value& found_inf,
+                    c10::ArrayRef<torch::lazy::Value> steps,
+                    c10::ArrayRef<torch::lazy::Value> params,
+                    c10::ArrayRef<torch::lazy::Value> grads,
+                    c10::ArrayRef<torch::lazy::Value> exp_avgs,
+                    c10::ArrayRef<torch::lazy::Value> exp_avg_sqs,
+                    const torch::lazy::Value& beta1,
+                    const torch::lazy::Value& beta2,
+                    const torch::lazy::Value& lr,
+                    const torch::lazy::Value& weight_decay,
+                    const torch::lazy::Value& eps, bool use_weight_decay);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+ private:
+  size_t num_params_;
+  bool use_weight_decay_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_LAMB_OPTIMIZER_STEP_H_
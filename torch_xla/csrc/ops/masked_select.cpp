@@ -1,5 +1,7 @@
 #include "torch_xla/csrc/ops/masked_select.h"
 
+#include <sstream>
+
 #include "xla/shape_util.h"
 
 #include "torch_xla/csrc/lowering_context.h"
@@ -9,13 +11,13 @@
 namespace torch_xla {
 namespace {
 
-xla::Shape NodeOutputShape(const torch::lazy::Value& input) {
+xla::Shape NodeOutputShape(const torch::lazy::Value& input, bool bounded) {
   const xla::Shape& input_shape = GetXlaShape(input);
   int64_t input_elements = xla::ShapeUtil::ElementsIn(input_shape);
   xla::PrimitiveType size_type = GetShapeDimensionType(/*device=*/nullptr);
   xla::Shape result_shape =
       xla::ShapeUtil::MakeShape(input_shape.element_type(), {input_elements});
-  result_shape.set_dynamic_dimension(0, true);
+  result_shape.set_dynamic_dimension(0, !bounded);
   return xla::ShapeUtil::MakeTupleShape(
       {result_shape, xla::ShapeUtil::MakeShape(size_type, {})});
 }
@@ -23,19 +25,27 @@ xla::Shape NodeOutputShape(const torch::lazy::Value& input) {
 }  // namespace
 
 MaskedSelect::MaskedSelect(const torch::lazy::Value& input,
-                           const torch::lazy::Value& mask)
+                           const torch::lazy::Value& mask, bool bounded)
     : XlaNode(torch::lazy::OpKind(at::aten::masked_select), {input, mask},
-              NodeOutputShape(input),
-              /*num_outputs=*/2) {}
+              NodeOutputShape(input, bounded),
+              /*num_outputs=*/2, torch::lazy::MHash(bounded)),
+      bounded_(bounded) {}
 
 torch::lazy::NodePtr MaskedSelect::Clone(torch::lazy::OpList operands) const {
-  return torch_xla::MakeNode<MaskedSelect>(operands.at(0), operands.at(1));
+  return torch_xla::MakeNode<MaskedSelect>(operands.at(0), operands.at(1),
+                                           bounded_);
 }
 
 XlaOpVector MaskedSelect::Lower(LoweringContext* loctx) const {
   xla::XlaOp input = loctx->GetOutputOp(operand(0));
   xla::XlaOp mask = loctx->GetOutputOp(operand(1));
-  return ReturnOps(BuildMaskedSelect(input, mask), loctx);
+  return ReturnOps(BuildMaskedSelect(input, mask, bounded_), loctx);
+}
+
+std::string MaskedSelect::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", bounded=" << bounded_;
+  return ss.str();
 }
 
 }  // namespace torch_xla
@@ -5,16 +5,24 @@
 
 namespace torch_xla {
 
-// This node has no metadata, so it could have been implemented as generic-op in
-// ops.cpp, but since this might require special handling from upper IR layers,
-// it gets its own IR node class.
+// This node might require special handling from upper IR layers, so it gets
+// its own IR node class. Its outputs are the selected elements and their
+// count. The elements have a dynamic size, unless the node is `bounded`: they
+// then keep the size of the input, the elements past the count being zero, so
+// that the graph keeps static shapes.
 class MaskedSelect : public XlaNode {
  public:
-  MaskedSelect(const torch::lazy::Value& input, const torch::lazy::Value& mask);
+  MaskedSelect(const torch::lazy::Value& input, const torch::lazy::Value& mask,
+               bool bounded = false);
 
   torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
 
   XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+ private:
+  bool bounded_;
 };
 
 }  // namespace torch_xla
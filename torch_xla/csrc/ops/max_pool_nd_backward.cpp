@@ -19,7 +19,8 @@ xla::Shape NodeOutputShape(const torch::lazy::Value& grad_output,
     XLA_CHECK_EQ(operands.size(), 2);
     return BuildMaxPoolNdBackward(/*out_backprop=*/operands[0],
                                   /*input=*/operands[1], spatial_dim_count,
-                                  kernel_size, stride, padding, ceil_mode);
+                                  kernel_size, stride, padding, ceil_mode,
+                                  /*dense=*/false);
   };
   return InferOutputShape({GetXlaShape(grad_output), GetXlaShape(input)},
                           lower_for_shape_fn);
@@ -71,7 +72,9 @@ XlaOpVector MaxPoolNdBackward::Lower(LoweringContext* loctx) const {
   xla::XlaOp input = loctx->GetOutputOp(operand(1));
   xla::XlaOp output = BuildMaxPoolNdBackward(
       /*out_backprop=*/grad_output, /*input=*/input, spatial_dim_count_,
-      kernel_size_, stride_, padding_, ceil_mode_);
+      kernel_size_, stride_, padding_, ceil_mode_,
+      UseDenseMaxPoolBackward(
+          static_cast<XlaDeviceType>(loctx->device().type())));
   return ReturnOp(output, loctx);
 }
 
@@ -0,0 +1,156 @@
+#include "torch_xla/csrc/ops/multi_tensor_adam_optimizer_step.h"
+
+#include <sstream>
+#include <vector>
+
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+// The operands are the scalars, then the tensors of each kind, each in the
+// order of the parameters, then the inv_scale, if any.
+constexpr size_t kNumScalarOperands = 6;
+
+std::vector<torch::lazy::Value> GetOperandList(
+    const torch::lazy::Value& found_inf,
+    c10::ArrayRef<torch::lazy::Value> steps,
+    c10::ArrayRef<torch::lazy::Value> params,
+    c10::ArrayRef<torch::lazy::Value> grads,
+    c10::ArrayRef<torch::lazy::Value> exp_avgs,
+    c10::ArrayRef<torch::lazy::Value> exp_avg_sqs,
+    c10::ArrayRef<torch::lazy::Value> max_exp_avg_sqs,
+    const torch::lazy::Value& beta1, const torch::lazy::Value& beta2,
+    const torch::lazy::Value& lr, const torch::lazy::Value& weight_decay,
+    const torch::lazy::Value& eps, bool use_amsgrad,
+    const std::optional<torch::lazy::Value>& inv_scale) {
+  std::vector<torch::lazy::Value> operands = {found_inf, beta1,        beta2,
+                                              lr,        weight_decay, eps};
+  for (c10::ArrayRef<torch::lazy::Value> values :
+       {steps, params, grads, exp_avgs, exp_avg_sqs}) {
+    XLA_CHECK_EQ(values.size(), params.size());
+    operands.insert(operands.end(), values.begin(), values.end());
+  }
+  if (use_amsgrad) {
+    XLA_CHECK_EQ(max_exp_avg_sqs.size(), params.size());
+    operands.insert(operands.end(), max_exp_avg_sqs.begin(),
+                    max_exp_avg_sqs.end());
+  }
+  if (inv_scale) {
+    operands.push_back(*inv_scale);
+  }
+  return operands;
+}
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& found_inf,
+                           c10::ArrayRef<torch::lazy::Value> steps,
+                           c10::ArrayRef<torch::lazy::Value> params,
+                           bool use_amsgrad, bool unscale) {
+  std::vector<xla::Shape> shapes;
+  for (size_t i = 0; i < params.size(); ++i) {
+    const xla::Shape& param_shape = GetXlaShape(params[i]);
+    shapes.push_back(/*step=*/GetXlaShape(steps[i]));
+    shapes.push_back(/*param=*/param_shape);
+    shapes.push_back(/*exp_avg=*/param_shape);
+    shapes.push_back(/*exp_avg_sq=*/param_shape);
+    if (use_amsgrad) {
+      shapes.push_back(/*max_exp_avg_sq=*/param_shape);
+    }
+  }
+  if (unscale) {
+    shapes.push_back(/*found_inf=*/GetXlaShape(found_inf));
+  }
+  return xla::ShapeUtil::MakeTupleShape(shapes);
+}
+
+}  // namespace
+
+MultiTensorAdamOptimizerStep::MultiTensorAdamOptimizerStep(
+    const torch::lazy::Value& found_inf,
+    c10::ArrayRef<torch::lazy::Value> steps,
+    c10::ArrayRef<torch::lazy::Value> params,
+    c10::ArrayRef<torch::lazy::Value> grads,
+    c10::ArrayRef<torch::lazy::Value> exp_avgs,
+    c10::ArrayRef<torch::lazy::Value> exp_avg_sqs,
+    c10::ArrayRef<torch::lazy::Value> max_exp_avg_sqs,
+    const torch::lazy::Value& beta1, const torch::lazy::Value& beta2,
+    const torch::lazy::Value& lr, const torch::lazy::Value& weight_decay,
+    const torch::lazy::Value& eps, bool use_weight_decay, bool use_amsgrad,
+    bool use_adamw, const std::optional<torch::lazy::Value>& inv_scale)
+    : XlaNode(xla_multi_tensor_adam_optimizer_step,
+              GetOperandList(found_inf, steps, params, grads, exp_avgs,
+                             exp_avg_sqs, max_exp_avg_sqs, beta1, beta2, lr,
+                             weight_decay, eps, use_amsgrad, inv_scale),
+              NodeOutputShape(found_inf, steps, params, use_amsgrad,
+                              inv_scale.has_value()),
+              /*num_outputs=*/params.size() * (use_amsgrad ? 5 : 4) +
+                  (inv_scale ? 1 : 0),
+              torch::lazy::MHash(params.size(), use_weight_decay, use_amsgrad,
+                                 use_adamw, inv_scale.has_value())),
+      num_params_(params.size()),
+      use_weight_decay_(use_weight_decay),
+      use_amsgrad_(use_amsgrad),
+      use_adamw_(use_adamw),
+      unscale_(inv_scale.has_value()) {}
+
+torch::lazy::NodePtr MultiTensorAdamOptimizerStep::Clone(
+    torch::lazy::OpList operands) const {
+  auto tensors = [&](size_t kind) {
+    return operands.slice(kNumScalarOperands + kind * num_params_,
+                          num_params_);
+  };
+  return torch_xla::MakeNode<MultiTensorAdamOptimizerStep>(
+      operands.at(0), tensors(0), tensors(1), tensors(2), tensors(3),
+      tensors(4),
+      use_amsgrad_ ? tensors(5) : c10::ArrayRef<torch::lazy::Value>(),
+      operands.at(1), operands.at(2), operands.at(3), operands.at(4),
+      operands.at(5), use_weight_decay_, use_amsgrad_, use_adamw_,
+      unscale_ ? std::optional<torch::lazy::Value>(operands.back())
+               : std::nullopt);
+}
+
+XlaOpVector MultiTensorAdamOptimizerStep::Lower(LoweringContext* loctx) const {
+  std::vector<xla::XlaOp> ops;
+  ops.reserve(operands().size());
+  for (const torch::lazy::Output& operand : operands()) {
+    ops.push_back(loctx->GetOutputOp(operand));
+  }
+  absl::Span<const xla::XlaOp> all_ops(ops);
+  auto tensors = [&](size_t kind) {
+    return all_ops.subspan(kNumScalarOperands + kind * num_params_,
+                           num_params_);
+  };
+  xla::XlaOp found_inf = ops[0];
+  std::vector<xla::XlaOp> grads(tensors(2).begin(), tensors(2).end());
+  if (unscale_) {
+    grads = BuildAmpForeachNonFiniteCheckAndUnscale(grads, found_inf,
+                                                    ops.back());
+    found_inf = grads.back();
+    grads.pop_back();
+  }
+  std::vector<xla::XlaOp> results = BuildMultiTensorAdamOptimizerStep(
+      found_inf, tensors(0), tensors(1), grads, tensors(3), tensors(4),
+      use_amsgrad_ ? tensors(5) : absl::Span<const xla::XlaOp>(), ops[1],
+      ops[2], ops[3], ops[4], ops[5], use_weight_decay_, use_amsgrad_,
+      use_adamw_);
+  if (unscale_) {
+    results.push_back(found_inf);
+  }
+  return ReturnOps(results, loctx);
+}
+
+std::string MultiTensorAdamOptimizerStep::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", num_params=" << num_params_
+     << ", use_weight_decay=" << use_weight_decay_
+     << ", use_amsgrad=" << use_amsgrad_ << ", use_adamw=" << use_adamw_
+     << ", unscale=" << unscale_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,53 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_MULTI_TENSOR_ADAM_OPTIMIZER_STEP_H_
+#define XLA_TORCH_XLA_CSRC_OPS_MULTI_TENSOR_ADAM_OPTIMIZER_STEP_H_
+
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The Adam/AdamW step of a list of parameters, as AdamOptimizerStep does for
+// one, in a single node sharing the found_inf flag and the hyper parameters.
+// The outputs are the step, the parameter, exp_avg, exp_avg_sq and, with
+// amsgrad, max_exp_avg_sq of each parameter, one parameter after the other.
+// With an `inv_scale`, the node also unscales the AMP scaled gradients and
+// checks them for non finite values, as _amp_foreach_non_finite_check_and_
+// unscale_ does, and its last output is the updated found_inf flag, so that
+// the unscaled gradients are never written back to memory.
+class MultiTensorAdamOptimizerStep : public XlaNode {
+ public:
+  // The max_exp_avg_sqs are ignored, and may be empty, without amsgrad.
+  MultiTensorAdamOptimizerStep(
+      const torch::lazy::Value& found_inf,
+      c10::ArrayRef<torch::lazy::Value> steps,
+      c10::ArrayRef<torch::lazy::Value> params,
+      c10::ArrayRef<torch::lazy::Value> grads,
+      c10::ArrayRef<torch::lazy::Value> exp_avgs,
+      c10::ArrayRef<torch::lazy::Value> exp_avg_sqs,
+      c10::ArrayRef<torch::lazy::Value> max_exp_avg_sqs,
+      const torch::lazy::Value& beta1, const torch::lazy::Value& beta2,
+      const torch::lazy::Value& lr, const torch::lazy::Value& weight_decay,
+      const torch::lazy::Value& eps, bool use_weight_decay, bool use_amsgrad,
+      bool use_adamw,
+      const std::optional<torch::lazy::Value>& inv_scale = std::nullopt);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+ private:
+  size_t num_params_;
+  bool use_weight_decay_;
+  bool use_amsgrad_;
+  bool use_adamw_;
+  bool unscale_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_MULTI_TENSOR_ADAM_OPTIMIZER_STEP_H_
@@ -0,0 +1,70 @@
+#include "torch_xla/csrc/ops/native_layer_norm.h"
+
+#include <sstream>
+
+#include "torch_xla/csrc/layer_norm.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& input,
+                           const torch::lazy::Value& weight,
+                           const torch::lazy::Value& bias,
+                           int64_t normalized_ndim) {
+  auto lower_for_shape_fn =
+      [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
+    LayerNormOutput output =
+        BuildLayerNorm(operands[0], operands[1], operands[2], normalized_ndim,
+                       /*eps=*/0.5, /*center=*/true);
+    return xla::Tuple(operands[0].builder(),
+                      {output.output, output.mean, output.rstd});
+  };
+  return InferOutputShape(
+      {GetXlaShape(input), GetXlaShape(weight), GetXlaShape(bias)},
+      lower_for_shape_fn);
+}
+
+}  // namespace
+
+NativeLayerNorm::NativeLayerNorm(const torch::lazy::Value& input,
+                                 const torch::lazy::Value& weight,
+                                 const torch::lazy::Value& bias,
+                                 int64_t normalized_ndim, double eps)
+    : XlaNode(
+          torch::lazy::OpKind(at::aten::native_layer_norm),
+          {input, weight, bias},
+          [&]() {
+            return NodeOutputShape(input, weight, bias, normalized_ndim);
+          },
+          /*num_outputs=*/3, torch::lazy::MHash(normalized_ndim, eps)),
+      normalized_ndim_(normalized_ndim),
+      eps_(eps) {}
+
+torch::lazy::NodePtr NativeLayerNorm::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<NativeLayerNorm>(
+      operands.at(0), operands.at(1), operands.at(2), normalized_ndim_, eps_);
+}
+
+XlaOpVector NativeLayerNorm::Lower(LoweringContext* loctx) const {
+  xla::XlaOp input = loctx->GetOutputOp(operand(0));
+  xla::XlaOp weight = loctx->GetOutputOp(operand(1));
+  xla::XlaOp bias = loctx->GetOutputOp(operand(2));
+  LayerNormOutput output = BuildLayerNorm(input, weight, bias,
+                                          normalized_ndim_, eps_,
+                                          /*center=*/true);
+  return ReturnOps({std::move(output.output), std::move(output.mean),
+                    std::move(output.rstd)},
+                   loctx);
+}
+
+std::string NativeLayerNorm::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", normalized_ndim=" << normalized_ndim_
+     << ", eps=" << eps_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
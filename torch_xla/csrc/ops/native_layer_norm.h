@@ -0,0 +1,38 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_NATIVE_LAYER_NORM_H_
+#define XLA_TORCH_XLA_CSRC_OPS_NATIVE_LAYER_NORM_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The layer normalization of the last "normalized_ndim" dimensions of the
+// input, built with BuildLayerNorm(). The outputs are the normalized input and
+// the mean and the reciprocal standard deviation of every row.
+class NativeLayerNorm : public XlaNode {
+ public:
+  NativeLayerNorm(const torch::lazy::Value& input,
+                  const torch::lazy::Value& weight,
+                  const torch::lazy::Value& bias, int64_t normalized_ndim,
+                  double eps);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  int64_t normalized_ndim() const { return normalized_ndim_; }
+
+  double eps() const { return eps_; }
+
+ private:
+  int64_t normalized_ndim_;
+  double eps_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_NATIVE_LAYER_NORM_H_
@@ -0,0 +1,74 @@
+#include "torch_xla/csrc/ops/native_layer_norm_backward.h"
+
+#include <sstream>
+
+#include "torch_xla/csrc/layer_norm.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& grad_out,
+                           const torch::lazy::Value& input,
+                           const torch::lazy::Value& mean,
+                           const torch::lazy::Value& rstd,
+                           const torch::lazy::Value& weight,
+                           int64_t normalized_ndim) {
+  auto lower_for_shape_fn =
+      [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
+    LayerNormGrads grads = BuildLayerNormBackward(
+        operands[0], operands[1], operands[2], operands[3], operands[4],
+        normalized_ndim, /*center=*/true);
+    return xla::Tuple(operands[0].builder(),
+                      {grads.grad_input, grads.grad_weight, grads.grad_bias});
+  };
+  return InferOutputShape(
+      {GetXlaShape(grad_out), GetXlaShape(input), GetXlaShape(mean),
+       GetXlaShape(rstd), GetXlaShape(weight)},
+      lower_for_shape_fn);
+}
+
+}  // namespace
+
+NativeLayerNormBackward::NativeLayerNormBackward(
+    const torch::lazy::Value& grad_out, const torch::lazy::Value& input,
+    const torch::lazy::Value& mean, const torch::lazy::Value& rstd,
+    const torch::lazy::Value& weight, int64_t normalized_ndim)
+    : XlaNode(
+          torch::lazy::OpKind(at::aten::native_layer_norm_backward),
+          {grad_out, input, mean, rstd, weight},
+          [&]() {
+            return NodeOutputShape(grad_out, input, mean, rstd, weight,
+                                   normalized_ndim);
+          },
+          /*num_outputs=*/3, torch::lazy::MHash(normalized_ndim)),
+      normalized_ndim_(normalized_ndim) {}
+
+torch::lazy::NodePtr NativeLayerNormBackward::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<NativeLayerNormBackward>(
+      operands.at(0), operands.at(1), operands.at(2), operands.at(3),
+      operands.at(4), normalized_ndim_);
+}
+
+XlaOpVector NativeLayerNormBackward::Lower(LoweringContext* loctx) const {
+  xla::XlaOp grad_out = loctx->GetOutputOp(operand(0));
+  xla::XlaOp input = loctx->GetOutputOp(operand(1));
+  xla::XlaOp mean = loctx->GetOutputOp(operand(2));
+  xla::XlaOp rstd = loctx->GetOutputOp(operand(3));
+  xla::XlaOp weight = loctx->GetOutputOp(operand(4));
+  LayerNormGrads grads = BuildLayerNormBackward(
+      grad_out, input, mean, rstd, weight, normalized_ndim_, /*center=*/true);
+  return ReturnOps({std::move(grads.grad_input), std::move(grads.grad_weight),
+                    std::move(grads.grad_bias)},
+                   loctx);
+}
+
+std::string NativeLayerNormBackward::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", normalized_ndim=" << normalized_ndim_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
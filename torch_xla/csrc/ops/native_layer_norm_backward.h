@@ -0,0 +1,37 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_NATIVE_LAYER_NORM_BACKWARD_H_
+#define XLA_TORCH_XLA_CSRC_OPS_NATIVE_LAYER_NORM_BACKWARD_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The input, weight and bias gradients of a NativeLayerNorm, built with
+// BuildLayerNormBackward() from its saved mean and reciprocal standard
+// deviation.
+class NativeLayerNormBackward : public XlaNode {
+ public:
+  NativeLayerNormBackward(const torch::lazy::Value& grad_out,
+                          const torch::lazy::Value& input,
+                          const torch::lazy::Value& mean,
+                          const torch::lazy::Value& rstd,
+                          const torch::lazy::Value& weight,
+                          int64_t normalized_ndim);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  int64_t normalized_ndim() const { return normalized_ndim_; }
+
+ private:
+  int64_t normalized_ndim_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_NATIVE_LAYER_NORM_BACKWARD_H_
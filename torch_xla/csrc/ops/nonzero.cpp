@@ -1,5 +1,7 @@
 #include "torch_xla/csrc/ops/nonzero.h"
 
+#include <sstream>
+
 #include "xla/shape_util.h"
 
 #include "torch_xla/csrc/lowering_context.h"
@@ -9,31 +11,38 @@
 namespace torch_xla {
 namespace {
 
-xla::Shape NodeOutputShape(const torch::lazy::Value& input) {
+xla::Shape NodeOutputShape(const torch::lazy::Value& input, bool bounded) {
   const xla::Shape& input_shape = GetXlaShape(input);
   int64_t index_elements = xla::ShapeUtil::ElementsIn(input_shape);
   xla::PrimitiveType size_type = GetShapeDimensionType(/*device=*/nullptr);
   xla::Shape result_shape = xla::ShapeUtil::MakeShape(
       size_type, {index_elements, input_shape.dimensions_size()});
-  result_shape.set_dynamic_dimension(0, true);
+  result_shape.set_dynamic_dimension(0, !bounded);
   return xla::ShapeUtil::MakeTupleShape(
       {result_shape, xla::ShapeUtil::MakeShape(size_type, {})});
 }
 
 }  // namespace
 
-NonZero::NonZero(const torch::lazy::Value& input)
+NonZero::NonZero(const torch::lazy::Value& input, bool bounded)
     : XlaNode(torch::lazy::OpKind(at::aten::nonzero), {input},
-              NodeOutputShape(input),
-              /*num_outputs=*/2) {}
+              NodeOutputShape(input, bounded),
+              /*num_outputs=*/2, torch::lazy::MHash(bounded)),
+      bounded_(bounded) {}
 
 torch::lazy::NodePtr NonZero::Clone(torch::lazy::OpList operands) const {
-  return torch_xla::MakeNode<NonZero>(operands.at(0));
+  return torch_xla::MakeNode<NonZero>(operands.at(0), bounded_);
 }
 
 XlaOpVector NonZero::Lower(LoweringContext* loctx) const {
   xla::XlaOp input = loctx->GetOutputOp(operand(0));
-  return ReturnOps(BuildNonZero(input), loctx);
+  return ReturnOps(BuildNonZero(input, bounded_), loctx);
+}
+
+std::string NonZero::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", bounded=" << bounded_;
+  return ss.str();
 }
 
 }  // namespace torch_xla
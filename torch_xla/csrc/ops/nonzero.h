@@ -5,16 +5,23 @@
 
 namespace torch_xla {
 
-// This node has no metadata, so it could have been implemented as generic-op in
-// ops.cpp, but since this might require special handling from upper IR layers,
-// it gets its own IR node class.
+// This node might require special handling from upper IR layers, so it gets
+// its own IR node class. Its outputs are the indices of the non zero elements
+// and their count. The indices have a dynamic number of rows, unless the node
+// is `bounded`: they then keep one row per input element, the rows past the
+// count being zero, so that the graph keeps static shapes.
 class NonZero : public XlaNode {
  public:
-  NonZero(const torch::lazy::Value& input);
+  NonZero(const torch::lazy::Value& input, bool bounded = false);
 
   torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
 
   XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+ private:
+  bool bounded_;
 };
 
 }  // namespace torch_xla
@@ -0,0 +1,108 @@
+#include "torch_xla/csrc/ops/quantized_dot.h"
+
+#include <sstream>
+#include <vector>
+
+#include "torch_xla/csrc/dtype.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/util.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+// Splits the optional activation scale and zero point off the operands.
+std::pair<xla::XlaOp, xla::XlaOp> OptionalOperands(
+    absl::Span<const xla::XlaOp> operands, bool has_x_scale) {
+  xla::XlaOp x_scale;
+  xla::XlaOp zero_point;
+  size_t next = 3;
+  if (has_x_scale) {
+    x_scale = operands[next++];
+  }
+  if (operands.size() > next) {
+    zero_point = operands[next];
+  }
+  return {x_scale, zero_point};
+}
+
+xla::Shape NodeOutputShape(absl::Span<const torch::lazy::Value> operands,
+                           bool has_x_scale, int64_t block_size,
+                           at::ScalarType output_type) {
+  auto lower_for_shape_fn =
+      [&](absl::Span<const xla::XlaOp> ops) -> xla::XlaOp {
+    auto [x_scale, zero_point] = OptionalOperands(ops, has_x_scale);
+    return BuildQuantizedDot(
+        ops[0], ops[1], ops[2], x_scale, zero_point, block_size,
+        MakeXlaPrimitiveType(output_type, /*device=*/nullptr));
+  };
+  std::vector<xla::Shape> shapes;
+  for (const torch::lazy::Value& operand : operands) {
+    shapes.push_back(GetXlaShape(operand));
+  }
+  return InferOutputShape(shapes, lower_for_shape_fn);
+}
+
+}  // namespace
+
+QuantizedDot::QuantizedDot(const torch::lazy::Value& x,
+                           const torch::lazy::Value& w,
+                           const torch::lazy::Value& scale,
+                           const std::optional<torch::lazy::Value>& x_scale,
+                           const std::optional<torch::lazy::Value>& zero_point,
+                           int64_t block_size, at::ScalarType output_type)
+    : XlaNode(
+          xla_quantized_dot,
+          runtime::util::GetValuesVector<torch::lazy::Value>(
+              {x, w, scale}, {&x_scale, &zero_point}),
+          [&]() {
+            return NodeOutputShape(
+                runtime::util::GetValuesVector<torch::lazy::Value>(
+                    {x, w, scale}, {&x_scale, &zero_point}),
+                x_scale.has_value(), block_size, output_type);
+          },
+          /*num_outputs=*/1,
+          torch::lazy::MHash(x_scale.has_value(), block_size,
+                             static_cast<int>(output_type))),
+      has_x_scale_(x_scale.has_value()),
+      block_size_(block_size),
+      output_type_(output_type) {}
+
+torch::lazy::NodePtr QuantizedDot::Clone(torch::lazy::OpList operands) const {
+  std::optional<torch::lazy::Value> x_scale;
+  std::optional<torch::lazy::Value> zero_point;
+  size_t next = 3;
+  if (has_x_scale_) {
+    x_scale = operands.at(next++);
+  }
+  if (operands.size() > next) {
+    zero_point = operands.at(next);
+  }
+  return torch_xla::MakeNode<QuantizedDot>(operands.at(0), operands.at(1),
+                                           operands.at(2), x_scale, zero_point,
+                                           block_size_, output_type_);
+}
+
+XlaOpVector QuantizedDot::Lower(LoweringContext* loctx) const {
+  std::vector<xla::XlaOp> ops;
+  for (const torch::lazy::Output& operand : operands()) {
+    ops.push_back(loctx->GetOutputOp(operand));
+  }
+  auto [x_scale, zero_point] = OptionalOperands(ops, has_x_scale_);
+  return ReturnOp(
+      BuildQuantizedDot(ops[0], ops[1], ops[2], x_scale, zero_point,
+                        block_size_,
+                        MakeXlaPrimitiveType(output_type_, &loctx->device())),
+      loctx);
+}
+
+std::string QuantizedDot::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", block_size=" << block_size_
+     << ", output_type=" << output_type_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
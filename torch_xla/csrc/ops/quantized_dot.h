@@ -0,0 +1,43 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_QUANTIZED_DOT_H_
+#define XLA_TORCH_XLA_CSRC_OPS_QUANTIZED_DOT_H_
+
+#include <c10/core/ScalarType.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The product of activations and of a per channel or blockwise quantized
+// weight, built with BuildQuantizedDot(), with the scales applied to the
+// products of the low precision dot.
+class QuantizedDot : public XlaNode {
+ public:
+  QuantizedDot(const torch::lazy::Value& x, const torch::lazy::Value& w,
+               const torch::lazy::Value& scale,
+               const std::optional<torch::lazy::Value>& x_scale,
+               const std::optional<torch::lazy::Value>& zero_point,
+               int64_t block_size, at::ScalarType output_type);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  int64_t block_size() const { return block_size_; }
+
+  at::ScalarType output_type() const { return output_type_; }
+
+ private:
+  bool has_x_scale_;
+  int64_t block_size_;
+  at::ScalarType output_type_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_QUANTIZED_DOT_H_
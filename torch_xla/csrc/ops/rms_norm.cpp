@@ -0,0 +1,60 @@
+#include "torch_xla/csrc/ops/rms_norm.h"
+
+#include <sstream>
+
+#include "torch_xla/csrc/layer_norm.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& input,
+                           const torch::lazy::Value& weight,
+                           int64_t normalized_ndim) {
+  auto lower_for_shape_fn =
+      [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
+    LayerNormOutput output =
+        BuildLayerNorm(operands[0], operands[1], xla::XlaOp(),
+                       normalized_ndim, /*eps=*/0.5, /*center=*/false);
+    return xla::Tuple(operands[0].builder(), {output.output, output.rstd});
+  };
+  return InferOutputShape({GetXlaShape(input), GetXlaShape(weight)},
+                          lower_for_shape_fn);
+}
+
+}  // namespace
+
+RmsNorm::RmsNorm(const torch::lazy::Value& input,
+                 const torch::lazy::Value& weight, int64_t normalized_ndim,
+                 double eps)
+    : XlaNode(
+          xla_rms_norm, {input, weight},
+          [&]() { return NodeOutputShape(input, weight, normalized_ndim); },
+          /*num_outputs=*/2, torch::lazy::MHash(normalized_ndim, eps)),
+      normalized_ndim_(normalized_ndim),
+      eps_(eps) {}
+
+torch::lazy::NodePtr RmsNorm::Clone(torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<RmsNorm>(operands.at(0), operands.at(1),
+                                      normalized_ndim_, eps_);
+}
+
+XlaOpVector RmsNorm::Lower(LoweringContext* loctx) const {
+  xla::XlaOp input = loctx->GetOutputOp(operand(0));
+  xla::XlaOp weight = loctx->GetOutputOp(operand(1));
+  LayerNormOutput output =
+      BuildLayerNorm(input, weight, xla::XlaOp(), normalized_ndim_, eps_,
+                     /*center=*/false);
+  return ReturnOps({std::move(output.output), std::move(output.rstd)}, loctx);
+}
+
+std::string RmsNorm::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", normalized_ndim=" << normalized_ndim_
+     << ", eps=" << eps_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,36 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_RMS_NORM_H_
+#define XLA_TORCH_XLA_CSRC_OPS_RMS_NORM_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The root mean square normalization of the last "normalized_ndim" dimensions
+// of the input, built with BuildLayerNorm(). The outputs are the normalized
+// input and the reciprocal root mean square of every row.
+class RmsNorm : public XlaNode {
+ public:
+  RmsNorm(const torch::lazy::Value& input, const torch::lazy::Value& weight,
+          int64_t normalized_ndim, double eps);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  int64_t normalized_ndim() const { return normalized_ndim_; }
+
+  double eps() const { return eps_; }
+
+ private:
+  int64_t normalized_ndim_;
+  double eps_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_RMS_NORM_H_
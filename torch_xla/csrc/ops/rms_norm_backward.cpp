@@ -0,0 +1,72 @@
+#include "torch_xla/csrc/ops/rms_norm_backward.h"
+
+#include <sstream>
+
+#include "torch_xla/csrc/layer_norm.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/infer_output_shape.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& grad_out,
+                           const torch::lazy::Value& input,
+                           const torch::lazy::Value& rstd,
+                           const torch::lazy::Value& weight,
+                           int64_t normalized_ndim) {
+  auto lower_for_shape_fn =
+      [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
+    LayerNormGrads grads = BuildLayerNormBackward(
+        operands[0], operands[1], xla::XlaOp(), operands[2], operands[3],
+        normalized_ndim, /*center=*/false);
+    return xla::Tuple(operands[0].builder(),
+                      {grads.grad_input, grads.grad_weight});
+  };
+  return InferOutputShape({GetXlaShape(grad_out), GetXlaShape(input),
+                           GetXlaShape(rstd), GetXlaShape(weight)},
+                          lower_for_shape_fn);
+}
+
+}  // namespace
+
+RmsNormBackward::RmsNormBackward(const torch::lazy::Value& grad_out,
+                                 const torch::lazy::Value& input,
+                                 const torch::lazy::Value& rstd,
+                                 const torch::lazy::Value& weight,
+                                 int64_t normalized_ndim)
+    : XlaNode(
+          xla_rms_norm_backward, {grad_out, input, rstd, weight},
+          [&]() {
+            return NodeOutputShape(grad_out, input, rstd, weight,
+                                   normalized_ndim);
+          },
+          /*num_outputs=*/2, torch::lazy::MHash(normalized_ndim)),
+      normalized_ndim_(normalized_ndim) {}
+
+torch::lazy::NodePtr RmsNormBackward::Clone(
+    torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<RmsNormBackward>(operands.at(0), operands.at(1),
+                                              operands.at(2), operands.at(3),
+                                              normalized_ndim_);
+}
+
+XlaOpVector RmsNormBackward::Lower(LoweringContext* loctx) const {
+  xla::XlaOp grad_out = loctx->GetOutputOp(operand(0));
+  xla::XlaOp input = loctx->GetOutputOp(operand(1));
+  xla::XlaOp rstd = loctx->GetOutputOp(operand(2));
+  xla::XlaOp weight = loctx->GetOutputOp(operand(3));
+  LayerNormGrads grads =
+      BuildLayerNormBackward(grad_out, input, xla::XlaOp(), rstd, weight,
+                             normalized_ndim_, /*center=*/false);
+  return ReturnOps({std::move(grads.grad_input), std::move(grads.grad_weight)},
+                   loctx);
+}
+
+std::string RmsNormBackward::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", normalized_ndim=" << normalized_ndim_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,56 @@
+#include "torch_xla/csrc/ops/sample_tokens.h"
+
+#include <sstream>
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(const torch::lazy::Value& logits) {
+  const xla::Shape& logits_shape = GetXlaShape(logits);
+  XLA_CHECK_GE(logits_shape.dimensions_size(), 1)
+      << "The logits must have a vocabulary dimension";
+  return xla::ShapeUtil::MakeShape(
+      xla::PrimitiveType::S64,
+      logits_shape.dimensions().subspan(
+          0, logits_shape.dimensions_size() - 1));
+}
+
+}  // namespace
+
+SampleTokens::SampleTokens(const torch::lazy::Value& logits,
+                           const torch::lazy::Value& temperature,
+                           const torch::lazy::Value& top_p,
+                           const torch::lazy::Value& seed, int64_t top_k)
+    : XlaNode(
+          xla_sample_tokens, {logits, temperature, top_p, seed},
+          [&]() { return NodeOutputShape(logits); },
+          /*num_outputs=*/1, torch::lazy::MHash(top_k)),
+      top_k_(top_k) {}
+
+torch::lazy::NodePtr SampleTokens::Clone(torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<SampleTokens>(operands.at(0), operands.at(1),
+                                           operands.at(2), operands.at(3),
+                                           top_k_);
+}
+
+XlaOpVector SampleTokens::Lower(LoweringContext* loctx) const {
+  xla::XlaOp logits = loctx->GetOutputOp(operand(0));
+  xla::XlaOp temperature = loctx->GetOutputOp(operand(1));
+  xla::XlaOp top_p = loctx->GetOutputOp(operand(2));
+  xla::XlaOp seed = loctx->GetOutputOp(operand(3));
+  return ReturnOp(BuildSampleTokens(logits, temperature, top_p, seed, top_k_),
+                  loctx);
+}
+
+std::string SampleTokens::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", top_k=" << top_k_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,35 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_SAMPLE_TOKENS_H_
+#define XLA_TORCH_XLA_CSRC_OPS_SAMPLE_TOKENS_H_
+
+#include <cstdint>
+#include <string>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The token sampling of BuildSampleTokens(), which draws a token id from each
+// row of the logits on the device, with the temperature and the top-p as
+// operands so that changing them does not compile a new graph.
+class SampleTokens : public XlaNode {
+ public:
+  SampleTokens(const torch::lazy::Value& logits,
+               const torch::lazy::Value& temperature,
+               const torch::lazy::Value& top_p, const torch::lazy::Value& seed,
+               int64_t top_k);
+
+  std::string ToString() const override;
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  int64_t top_k() const { return top_k_; }
+
+ private:
+  int64_t top_k_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_SAMPLE_TOKENS_H_
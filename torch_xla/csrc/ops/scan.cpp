@@ -0,0 +1,85 @@
+#include "torch_xla/csrc/ops/scan.h"
+
+#include <sstream>
+
+#include "absl/strings/str_join.h"
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+xla::Shape NodeOutputShape(
+    torch::lazy::OpList operands,
+    const runtime::ComputationClient::ComputationPtr& body, int64_t num_carry) {
+  XLA_CHECK_GT(operands.size(), num_carry) << "scan() needs an xs operand";
+  int64_t num_iters = GetXlaShape(operands[num_carry]).dimensions(0);
+  const xla::Shape& result_shape = body->program_shape().result();
+  XLA_CHECK(result_shape.IsTuple()) << "The scan body must return a tuple";
+  std::vector<xla::Shape> shapes;
+  for (int64_t i = 0; i < result_shape.tuple_shapes_size(); ++i) {
+    const xla::Shape& shape = result_shape.tuple_shapes(i);
+    if (i < num_carry) {
+      shapes.push_back(shape);
+      continue;
+    }
+    std::vector<int64_t> dimensions = {num_iters};
+    dimensions.insert(dimensions.end(), shape.dimensions().begin(),
+                      shape.dimensions().end());
+    shapes.push_back(
+        xla::ShapeUtil::MakeShape(shape.element_type(), dimensions));
+  }
+  return xla::ShapeUtil::MakeTupleShape(shapes);
+}
+
+}  // namespace
+
+Scan::Scan(torch::lazy::OpList operands,
+           runtime::ComputationClient::ComputationPtr body, int64_t num_carry,
+           int64_t num_xs, std::vector<int64_t> parameter_operands,
+           int64_t seed_operand, bool reverse)
+    : XlaNode(xla_scan, operands,
+              NodeOutputShape(operands, body, num_carry),
+              body->program_shape().result().tuple_shapes_size(),
+              torch::lazy::HashCombine(
+                  body->hash(),
+                  torch::lazy::MHash(num_carry, num_xs, parameter_operands,
+                                     seed_operand, reverse))),
+      body_(std::move(body)),
+      num_carry_(num_carry),
+      num_xs_(num_xs),
+      parameter_operands_(std::move(parameter_operands)),
+      seed_operand_(seed_operand),
+      reverse_(reverse) {}
+
+torch::lazy::NodePtr Scan::Clone(torch::lazy::OpList operands) const {
+  return torch_xla::MakeNode<Scan>(operands, body_, num_carry_, num_xs_,
+                                   parameter_operands_, seed_operand_,
+                                   reverse_);
+}
+
+XlaOpVector Scan::Lower(LoweringContext* loctx) const {
+  std::vector<xla::XlaOp> inputs;
+  for (auto& operand : operands()) {
+    inputs.push_back(loctx->GetOutputOp(operand));
+  }
+  return ReturnOps(BuildScan(body_->computation(), inputs, num_carry_,
+                             num_xs_, parameter_operands_, seed_operand_,
+                             reverse_),
+                   loctx);
+}
+
+std::string Scan::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString() << ", body=" << body_->name()
+     << ", num_carry=" << num_carry_ << ", num_xs=" << num_xs_
+     << ", parameter_operands=(" << absl::StrJoin(parameter_operands_, ", ")
+     << "), seed_operand=" << seed_operand_ << ", reverse=" << reverse_;
+  return ss.str();
+}
+
+}  // namespace torch_xla
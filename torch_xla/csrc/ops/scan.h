@@ -0,0 +1,46 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_SCAN_H_
+#define XLA_TORCH_XLA_CSRC_OPS_SCAN_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "torch_xla/csrc/ir.h"
+#include "torch_xla/csrc/runtime/computation_client.h"
+
+namespace torch_xla {
+
+// Runs `body` once per leading index of the xs operands, in an XLA While. The
+// operands are the `num_carry` carries, the `num_xs` xs, and the tensors the
+// body reads without being passed them. Parameter i of `body` takes operand
+// `parameter_operands[i]`, sliced at the iteration for the xs and for the
+// `seed_operand`, which holds a seed per iteration, or -1. The body returns
+// the next carries followed by the ys of the iteration, and the node returns
+// the last carries followed by the ys stacked along a new leading dimension.
+// The node hashes the body by its HLO, so that the graphs scanning the same
+// layer hash the same, and compile once.
+class Scan : public XlaNode {
+ public:
+  Scan(torch::lazy::OpList operands,
+       runtime::ComputationClient::ComputationPtr body, int64_t num_carry,
+       int64_t num_xs, std::vector<int64_t> parameter_operands,
+       int64_t seed_operand, bool reverse);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+ private:
+  runtime::ComputationClient::ComputationPtr body_;
+  int64_t num_carry_;
+  int64_t num_xs_;
+  std::vector<int64_t> parameter_operands_;
+  int64_t seed_operand_;
+  bool reverse_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_SCAN_H_
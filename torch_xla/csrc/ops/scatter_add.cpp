@@ -24,6 +24,9 @@ XlaOpVector ScatterAdd::Lower(LoweringContext* loctx) const {
   xla::XlaOp input = loctx->GetOutputOp(operand(0));
   xla::XlaOp index = loctx->GetOutputOp(operand(1));
   xla::XlaOp src = loctx->GetOutputOp(operand(2));
+  if (UseSortedScatterAdd(xla_shape())) {
+    return ReturnOp(CreateSortedScatterAdd(input, index, src, dim_), loctx);
+  }
   ScatterOptions options(NumericAddCombiner());
   return ReturnOp(
       CreateScatter(loctx->device(), input, index, src, dim_, options), loctx);
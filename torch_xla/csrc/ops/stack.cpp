@@ -1,5 +1,7 @@
 #include "torch_xla/csrc/ops/stack.h"
 
+#include "xla/shape_util.h"
+
 #include "torch_xla/csrc/data_ops.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/lowering_context.h"
@@ -14,6 +16,15 @@ xla::Shape NodeOutputShape(c10::ArrayRef<torch::lazy::Value> values,
       [&](absl::Span<const xla::XlaOp> operands) -> xla::XlaOp {
     return BuildStack(operands, dim);
   };
+  // The inputs of a stack share their shape, so with static shapes the output
+  // is the first one with the stacked dimension inserted.
+  const xla::Shape& first_shape = GetXlaShape(values.front());
+  if (first_shape.is_static()) {
+    std::vector<int64_t> dimensions(first_shape.dimensions().begin(),
+                                    first_shape.dimensions().end());
+    dimensions.insert(dimensions.begin() + dim, values.size());
+    return xla::ShapeUtil::MakeShape(first_shape.element_type(), dimensions);
+  }
   std::vector<xla::Shape> shapes;
   shapes.reserve(values.size());
   for (auto& value : values) {
@@ -1,21 +1,108 @@
 #include "torch_xla/csrc/ops/tpu_custom_call.h"
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+
 #include "torch_xla/csrc/lowering_context.h"
 #include "torch_xla/csrc/ops/xla_ops.h"
 #include "torch_xla/csrc/xla_lower_util.h"
 
 namespace torch_xla {
+namespace {
+
+class TpuKernelRegistry {
+ public:
+  static TpuKernelRegistry* Get() {
+    static TpuKernelRegistry* registry = new TpuKernelRegistry();
+    return registry;
+  }
+
+  std::shared_ptr<const TpuKernel> Intern(const std::string& payload) {
+    torch::lazy::hash_t hash = torch::lazy::MHash(payload);
+    std::lock_guard<std::mutex> lock(lock_);
+    std::weak_ptr<const TpuKernel>& entry = kernels_[hash];
+    std::shared_ptr<const TpuKernel> kernel = entry.lock();
+    if (kernel != nullptr && kernel->payload == payload) {
+      TORCH_LAZY_COUNTER("TpuKernelInterned", 1);
+      return kernel;
+    }
+    kernel = std::make_shared<const TpuKernel>(TpuKernel{payload, hash});
+    if (entry.expired()) {
+      entry = kernel;
+    }
+    return kernel;
+  }
+
+  int64_t Register(const std::string& payload) {
+    std::shared_ptr<const TpuKernel> kernel = Intern(payload);
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = ids_.find(kernel->hash);
+    if (it != ids_.end() && registered_[it->second]->payload == payload) {
+      return it->second;
+    }
+    int64_t id = registered_.size();
+    registered_.push_back(std::move(kernel));
+    ids_.emplace(registered_.back()->hash, id);
+    return id;
+  }
+
+  absl::StatusOr<std::shared_ptr<const TpuKernel>> GetRegistered(int64_t id) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (id < 0 || id >= static_cast<int64_t>(registered_.size())) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("No TPU kernel is registered under ID ", id, "."));
+    }
+    return registered_[id];
+  }
+
+ private:
+  std::mutex lock_;
+  // The interned kernels, by content hash, for as long as a node holds them.
+  std::unordered_map<torch::lazy::hash_t, std::weak_ptr<const TpuKernel>,
+                     torch::lazy::HashReducer>
+      kernels_;
+  // The registered kernels, by ID, and their IDs by content hash.
+  std::vector<std::shared_ptr<const TpuKernel>> registered_;
+  std::unordered_map<torch::lazy::hash_t, int64_t, torch::lazy::HashReducer>
+      ids_;
+};
+
+}  // namespace
+
+std::shared_ptr<const TpuKernel> InternTpuKernel(const std::string& payload) {
+  return TpuKernelRegistry::Get()->Intern(payload);
+}
+
+int64_t RegisterTpuKernel(const std::string& payload) {
+  return TpuKernelRegistry::Get()->Register(payload);
+}
+
+absl::StatusOr<std::shared_ptr<const TpuKernel>> GetRegisteredTpuKernel(
+    int64_t id) {
+  return TpuKernelRegistry::Get()->GetRegistered(id);
+}
 
 TpuCustomCall::TpuCustomCall(torch::lazy::OpList inputs,
                              xla::Shape output_shape,
                              const std::string& payload)
+    : TpuCustomCall(inputs, std::move(output_shape),
+                    InternTpuKernel(payload)) {}
+
+TpuCustomCall::TpuCustomCall(torch::lazy::OpList inputs,
+                             xla::Shape output_shape,
+                             std::shared_ptr<const TpuKernel> kernel)
     : XlaNode(xla_tpu_custom_call, inputs, output_shape,
-              /*num_outputs=*/output_shape.tuple_shapes_size(),
-              torch::lazy::MHash(payload)),
-      payload_(payload) {}
+              /*num_outputs=*/output_shape.tuple_shapes_size(), kernel->hash),
+      kernel_(std::move(kernel)) {}
 
 torch::lazy::NodePtr TpuCustomCall::Clone(torch::lazy::OpList operands) const {
-  return torch_xla::MakeNode<TpuCustomCall>(operands, xla_shape(), payload_);
+  return torch_xla::MakeNode<TpuCustomCall>(operands, xla_shape(), kernel_);
 }
 
 XlaOpVector TpuCustomCall::Lower(LoweringContext* loctx) const {
@@ -24,13 +111,13 @@ XlaOpVector TpuCustomCall::Lower(LoweringContext* loctx) const {
   for (auto& operand : operands()) {
     inputs.push_back(loctx->GetOutputOp(operand));
   }
-  auto output = BuildTpuCustomCall(inputs, xla_shape(), payload_);
+  auto output = BuildTpuCustomCall(inputs, xla_shape(), kernel_->payload);
   return ReturnOps(output, loctx);
 }
 
 std::string TpuCustomCall::ToString() const {
   std::stringstream ss;
-  ss << XlaNode::ToString() << ", " << payload_;
+  ss << XlaNode::ToString() << ", " << kernel_->payload;
   return ss.str();
 }
 
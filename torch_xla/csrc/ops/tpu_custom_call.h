@@ -1,16 +1,45 @@
 #ifndef XLA_TORCH_XLA_CSRC_OPS_TPU_CUSTOM_CALL_H_
 #define XLA_TORCH_XLA_CSRC_OPS_TPU_CUSTOM_CALL_H_
 
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/statusor.h"
+
 #include "torch_xla/csrc/ir.h"
 
 namespace torch_xla {
 
+// The payload of a TPU custom call, e.g., a Mosaic kernel, along with its
+// content hash.
+struct TpuKernel {
+  std::string payload;
+  torch::lazy::hash_t hash;
+};
+
+// Returns the kernel holding `payload`, which the live calls of the same
+// content share, so that their nodes hold a single copy of it.
+std::shared_ptr<const TpuKernel> InternTpuKernel(const std::string& payload);
+
+// Registers `payload` for the lifetime of the process, and returns the ID the
+// calls can refer to it by instead of passing it every time. The same content
+// always gets the same ID.
+int64_t RegisterTpuKernel(const std::string& payload);
+
+// Returns the kernel registered under `id`.
+absl::StatusOr<std::shared_ptr<const TpuKernel>> GetRegisteredTpuKernel(
+    int64_t id);
+
 class TpuCustomCall : public XlaNode {
  public:
   // Make a TPU custom call with payload, e.g., Mosaic.
   TpuCustomCall(torch::lazy::OpList inputs, xla::Shape output_shape,
                 const std::string& payload);
 
+  TpuCustomCall(torch::lazy::OpList inputs, xla::Shape output_shape,
+                std::shared_ptr<const TpuKernel> kernel);
+
   torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
 
   XlaOpVector Lower(LoweringContext* loctx) const override;
@@ -18,7 +47,7 @@ class TpuCustomCall : public XlaNode {
   std::string ToString() const override;
 
  private:
-  std::string payload_;
+  std::shared_ptr<const TpuKernel> kernel_;
 };
 
 }  // namespace torch_xla
@@ -2,11 +2,21 @@
 
 namespace torch_xla {
 
+const OpKindWrapper xla_adafactor_optimizer_step(
+    "xla::adafactor_optimizer_step");
 const OpKindWrapper xla_adam_optimizer_step("xla::adam_optimizer_step");
 const OpKindWrapper xla_all_gather("xla::all_gather");
 const OpKindWrapper xla_all_to_all("xla::all_to_all");
+const OpKindWrapper xla_approx_topk("xla::approx_topk");
 const OpKindWrapper xla_as_strided_view_update("xla::as_strided_view_update");
+const OpKindWrapper xla_batched_nms("xla::batched_nms");
+const OpKindWrapper xla_blocked_attention("xla::blocked_attention");
+const OpKindWrapper xla_blocked_attention_backward(
+    "xla::blocked_attention_backward");
 const OpKindWrapper xla_cast("xla::cast");
+const OpKindWrapper xla_chunked_cross_entropy("xla::chunked_cross_entropy");
+const OpKindWrapper xla_chunked_cross_entropy_backward(
+    "xla::chunked_cross_entropy_backward");
 const OpKindWrapper xla_collective_permute("xla::collective_permute");
 const OpKindWrapper xla_cross_replica_sum("xla::cross_replica_sum");
 const OpKindWrapper xla_custom_call("xla::custom_call");
@@ -14,29 +24,43 @@ const OpKindWrapper xla_device_data("xla::device_data");
 const OpKindWrapper xla_dequantize_tensor("xla::dequantize_tensor");
 const OpKindWrapper xla_diagonal_view_update("xla::diagonal_view_update");
 const OpKindWrapper xla_dot_general("xla::dot_general");
+const OpKindWrapper xla_dropout_mask("xla::dropout_mask");
 const OpKindWrapper xla_dynamic_expand("xla::dynamic_expand");
+const OpKindWrapper xla_dynamic_update_slice("xla::dynamic_update_slice");
 const OpKindWrapper xla_dynamic_view("xla::dynamic_view");
 const OpKindWrapper xla_einsum_backward("xla::einsum_backward");
+const OpKindWrapper xla_embedding_bag_sparse_backward(
+    "xla::embedding_bag_sparse_backward");
+const OpKindWrapper xla_fp8_dot("xla::fp8_dot");
 const OpKindWrapper xla_generic_slice("xla::generic_slice");
 const OpKindWrapper xla_get_dimensions_size("xla::xla_get_dimensions_size");
+const OpKindWrapper xla_lamb_optimizer_step("xla::lamb_optimizer_step");
 const OpKindWrapper xla_mark_tensor("xla::mark_tensor");
 const OpKindWrapper xla_moving_average("xla::moving_average");
+const OpKindWrapper xla_multi_tensor_adam_optimizer_step(
+    "xla::multi_tensor_adam_optimizer_step");
 const OpKindWrapper xla_nms("xla::nms");
 const OpKindWrapper xla_not_supported("xla::not_supported");
 const OpKindWrapper xla_optimization_barrier("xla::optimization_barrier");
 const OpKindWrapper xla_quantize_tensor("xla::quantize_tensor");
+const OpKindWrapper xla_quantized_dot("xla::quantized_dot");
 const OpKindWrapper xla_recv("xla::recv");
 const OpKindWrapper xla_reduce_scatter("xla::reduce_scatter");
 const OpKindWrapper xla_cast_int4("xla::cast_int4");
 const OpKindWrapper xla_replication_pad("xla::replication_pad");
 const OpKindWrapper xla_replication_pad_backward(
     "xla::replication_pad_backward");
+const OpKindWrapper xla_rms_norm("xla::rms_norm");
+const OpKindWrapper xla_rms_norm_backward("xla::rms_norm_backward");
+const OpKindWrapper xla_sample_tokens("xla::sample_tokens");
+const OpKindWrapper xla_scan("xla::scan");
 const OpKindWrapper xla_select("xla::select");
 const OpKindWrapper xla_send("xla::send");
 const OpKindWrapper xla_sgd_optimizer_step("xla::sgd_optimizer_step");
 const OpKindWrapper xla_tensor_data("xla::tensor_data");
 const OpKindWrapper xla_unselect("xla::unselect");
 const OpKindWrapper xla_update_slice("xla::update_slice");
+const OpKindWrapper xla_zero_optimizer_step("xla::zero_optimizer_step");
 const OpKindWrapper xla_custom_sharding("xla::custom_sharding");
 const OpKindWrapper xla_tpu_custom_call("xla::tpu_custom_call");
 
@@ -28,11 +28,18 @@ class OpKindWrapper {
   mutable std::once_flag once_;
 };
 
+extern const OpKindWrapper xla_adafactor_optimizer_step;
 extern const OpKindWrapper xla_adam_optimizer_step;
 extern const OpKindWrapper xla_all_gather;
 extern const OpKindWrapper xla_all_to_all;
+extern const OpKindWrapper xla_approx_topk;
 extern const OpKindWrapper xla_as_strided_view_update;
+extern const OpKindWrapper xla_batched_nms;
+extern const OpKindWrapper xla_blocked_attention;
+extern const OpKindWrapper xla_blocked_attention_backward;
 extern const OpKindWrapper xla_cast;
+extern const OpKindWrapper xla_chunked_cross_entropy;
+extern const OpKindWrapper xla_chunked_cross_entropy_backward;
 extern const OpKindWrapper xla_collective_permute;
 extern const OpKindWrapper xla_cross_replica_sum;
 extern const OpKindWrapper xla_custom_call;
@@ -40,28 +47,40 @@ extern const OpKindWrapper xla_device_data;
 extern const OpKindWrapper xla_dequantize_tensor;
 extern const OpKindWrapper xla_diagonal_view_update;
 extern const OpKindWrapper xla_dot_general;
+extern const OpKindWrapper xla_dropout_mask;
 extern const OpKindWrapper xla_dynamic_expand;
+extern const OpKindWrapper xla_dynamic_update_slice;
 extern const OpKindWrapper xla_dynamic_view;
 extern const OpKindWrapper xla_einsum_backward;
+extern const OpKindWrapper xla_embedding_bag_sparse_backward;
+extern const OpKindWrapper xla_fp8_dot;
 extern const OpKindWrapper xla_generic_slice;
 extern const OpKindWrapper xla_get_dimensions_size;
+extern const OpKindWrapper xla_lamb_optimizer_step;
 extern const OpKindWrapper xla_mark_tensor;
 extern const OpKindWrapper xla_moving_average;
+extern const OpKindWrapper xla_multi_tensor_adam_optimizer_step;
 extern const OpKindWrapper xla_nms;
 extern const OpKindWrapper xla_not_supported;
 extern const OpKindWrapper xla_optimization_barrier;
 extern const OpKindWrapper xla_quantize_tensor;
+extern const OpKindWrapper xla_quantized_dot;
 extern const OpKindWrapper xla_recv;
 extern const OpKindWrapper xla_reduce_scatter;
 extern const OpKindWrapper xla_cast_int4;
 extern const OpKindWrapper xla_replication_pad;
 extern const OpKindWrapper xla_replication_pad_backward;
+extern const OpKindWrapper xla_rms_norm;
+extern const OpKindWrapper xla_rms_norm_backward;
+extern const OpKindWrapper xla_sample_tokens;
+extern const OpKindWrapper xla_scan;
 extern const OpKindWrapper xla_select;
 extern const OpKindWrapper xla_send;
 extern const OpKindWrapper xla_sgd_optimizer_step;
 extern const OpKindWrapper xla_tensor_data;
 extern const OpKindWrapper xla_unselect;
 extern const OpKindWrapper xla_update_slice;
+extern const OpKindWrapper xla_zero_optimizer_step;
 extern const OpKindWrapper xla_custom_sharding;
 extern const OpKindWrapper xla_tpu_custom_call;
 
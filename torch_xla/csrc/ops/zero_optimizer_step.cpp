@@ -0,0 +1,250 @@
+#include "torch_xla/csrc/ops/zero_optimizer_step.h"
+
+#include <torch/csrc/lazy/core/util.h>
+
+#include <sstream>
+
+#include "absl/strings/str_join.h"
+#include "xla/hlo/builder/lib/constants.h"
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/convert_ops.h"
+#include "torch_xla/csrc/cross_replica_reduces.h"
+#include "torch_xla/csrc/helpers.h"
+#include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/shape_helper.h"
+#include "torch_xla/csrc/xla_lower_util.h"
+
+namespace torch_xla {
+namespace {
+
+// The operands are the scalars, then the tensors of each kind, each in the
+// order of the parameters, then the token. The states are grouped by kind too,
+// e.g. all the exp_avgs, then all the exp_avg_sqs.
+enum TensorKind : size_t { kGrad = 0, kShard, kStep, kFirstState };
+
+std::vector<torch::lazy::Value> GetOperandList(
+    ZeroOptimizer optimizer, c10::ArrayRef<torch::lazy::Value> scalars,
+    c10::ArrayRef<torch::lazy::Value> grads,
+    c10::ArrayRef<torch::lazy::Value> shards,
+    c10::ArrayRef<torch::lazy::Value> steps,
+    c10::ArrayRef<torch::lazy::Value> states,
+    const torch::lazy::Value& token) {
+  XLA_CHECK_EQ(scalars.size(), ZeroOptimizerStep::NumScalars(optimizer));
+  XLA_CHECK(!shards.empty());
+  std::vector<torch::lazy::Value> operands(scalars.begin(), scalars.end());
+  for (c10::ArrayRef<torch::lazy::Value> values : {grads, shards, steps}) {
+    XLA_CHECK_EQ(values.size(), shards.size());
+    operands.insert(operands.end(), values.begin(), values.end());
+  }
+  XLA_CHECK_EQ(states.size(),
+               shards.size() * ZeroOptimizerStep::NumStates(optimizer));
+  operands.insert(operands.end(), states.begin(), states.end());
+  operands.push_back(token);
+  return operands;
+}
+
+xla::Shape NodeOutputShape(ZeroOptimizer optimizer,
+                           c10::ArrayRef<torch::lazy::Value> grads,
+                           c10::ArrayRef<torch::lazy::Value> shards,
+                           c10::ArrayRef<torch::lazy::Value> steps,
+                           const torch::lazy::Value& token, bool clip) {
+  std::vector<xla::Shape> shapes;
+  for (size_t i = 0; i < shards.size(); ++i) {
+    shapes.push_back(/*step=*/GetXlaShape(steps[i]));
+    shapes.push_back(/*shard=*/GetXlaShape(shards[i]));
+    for (size_t j = 0; j < ZeroOptimizerStep::NumStates(optimizer); ++j) {
+      shapes.push_back(/*state=*/GetXlaShape(shards[i]));
+    }
+  }
+  for (const torch::lazy::Value& grad : grads) {
+    // The gathered parameters have the shapes of the padded gradients.
+    shapes.push_back(GetXlaShape(grad));
+  }
+  if (clip) {
+    shapes.push_back(xla::ShapeUtil::MakeScalarShape(
+        GetXlaShape(shards[0]).element_type()));
+  }
+  shapes.push_back(GetXlaShape(token));
+  return xla::ShapeUtil::MakeTupleShape(shapes);
+}
+
+}  // namespace
+
+ZeroOptimizerStep::ZeroOptimizerStep(
+    ZeroOptimizer optimizer, c10::ArrayRef<torch::lazy::Value> scalars,
+    c10::ArrayRef<torch::lazy::Value> grads,
+    c10::ArrayRef<torch::lazy::Value> shards,
+    c10::ArrayRef<torch::lazy::Value> steps,
+    c10::ArrayRef<torch::lazy::Value> states, const torch::lazy::Value& token,
+    bool use_weight_decay, bool use_momentum, bool use_nesterov, double scale,
+    int64_t shard_count, std::vector<std::vector<int64_t>> groups,
+    bool pin_layout, std::optional<double> max_norm)
+    : XlaNode(xla_zero_optimizer_step,
+              GetOperandList(optimizer, scalars, grads, shards, steps, states,
+                             token),
+              NodeOutputShape(optimizer, grads, shards, steps, token,
+                              max_norm.has_value()),
+              /*num_outputs=*/shards.size() * (3 + NumStates(optimizer)) +
+                  (max_norm ? 1 : 0) + 1,
+              torch::lazy::MHash(torch::lazy::GetEnumValue(optimizer),
+                                 shards.size(), use_weight_decay, use_momentum,
+                                 use_nesterov, scale, shard_count, groups,
+                                 pin_layout, max_norm.has_value(),
+                                 max_norm.value_or(0.0))),
+      optimizer_(optimizer),
+      num_params_(shards.size()),
+      use_weight_decay_(use_weight_decay),
+      use_momentum_(use_momentum),
+      use_nesterov_(use_nesterov),
+      scale_(scale),
+      shard_count_(shard_count),
+      groups_(std::move(groups)),
+      pin_layout_(pin_layout),
+      max_norm_(max_norm) {}
+
+size_t ZeroOptimizerStep::NumScalars(ZeroOptimizer optimizer) {
+  return optimizer == ZeroOptimizer::kSgd ? 4 : 5;
+}
+
+size_t ZeroOptimizerStep::NumStates(ZeroOptimizer optimizer) {
+  return optimizer == ZeroOptimizer::kSgd ? 1 : 2;
+}
+
+torch::lazy::NodePtr ZeroOptimizerStep::Clone(
+    torch::lazy::OpList operands) const {
+  size_t num_scalars = NumScalars(optimizer_);
+  auto tensors = [&](size_t kind, size_t count) {
+    return operands.slice(num_scalars + kind * num_params_, count);
+  };
+  return torch_xla::MakeNode<ZeroOptimizerStep>(
+      optimizer_, operands.slice(0, num_scalars),
+      tensors(kGrad, num_params_), tensors(kShard, num_params_),
+      tensors(kStep, num_params_),
+      tensors(kFirstState, num_params_ * NumStates(optimizer_)),
+      operands.back(), use_weight_decay_, use_momentum_, use_nesterov_, scale_,
+      shard_count_, groups_, pin_layout_, max_norm_);
+}
+
+XlaOpVector ZeroOptimizerStep::Lower(LoweringContext* loctx) const {
+  std::vector<xla::XlaOp> ops;
+  ops.reserve(operands().size());
+  for (const torch::lazy::Output& operand : operands()) {
+    ops.push_back(loctx->GetOutputOp(operand));
+  }
+  absl::Span<const xla::XlaOp> all_ops(ops);
+  size_t num_scalars = NumScalars(optimizer_);
+  auto tensors = [&](size_t kind, size_t count) {
+    return all_ops.subspan(num_scalars + kind * num_params_, count);
+  };
+  absl::Span<const xla::XlaOp> scalars = all_ops.subspan(0, num_scalars);
+  absl::Span<const xla::XlaOp> shards = tensors(kShard, num_params_);
+  absl::Span<const xla::XlaOp> steps = tensors(kStep, num_params_);
+  absl::Span<const xla::XlaOp> states =
+      tensors(kFirstState, num_params_ * NumStates(optimizer_));
+  xla::XlaOp token = ops.back();
+  xla::XlaBuilder* builder = token.builder();
+  xla::PrimitiveType type =
+      ShapeHelper::ShapeOfXlaOp(shards[0]).element_type();
+
+  ReduceScatterResultCoalesced reduced = BuildReduceScatterCoalesced(
+      AllReduceType::kSum, tensors(kGrad, num_params_), token, scale_,
+      /*scatter_dim=*/0, shard_count_, groups_, pin_layout_);
+  token = reduced.token;
+  std::vector<xla::XlaOp> grads;
+  grads.reserve(num_params_);
+  for (xla::XlaOp grad : reduced.result) {
+    grads.push_back(MaybeConvertTo(grad, type));
+  }
+
+  xla::XlaOp grad_norm;
+  if (max_norm_) {
+    // The padding of the shards is zero, and does not count.
+    xla::XlaOp zero = xla::Zero(builder, type);
+    xla::XlaComputation add = XlaHelpers::CreateAddComputation(type);
+    xla::XlaOp sum_sq = zero;
+    for (xla::XlaOp grad : grads) {
+      sum_sq = sum_sq + xla::ReduceAll(grad * grad, zero, add);
+    }
+    std::vector<xla::XlaOp> reduced_sum_sq =
+        BuildAllReduce(AllReduceType::kSum, {sum_sq}, token, /*scale=*/1.0,
+                       groups_, pin_layout_);
+    token = reduced_sum_sq.back();
+    grad_norm = xla::Sqrt(reduced_sum_sq.front());
+    xla::XlaOp clip_coef = xla::Min(
+        XlaHelpers::ScalarValue<double>(*max_norm_, type, builder) /
+            (grad_norm + XlaHelpers::ScalarValue<double>(1e-6, type, builder)),
+        xla::One(builder, type));
+    for (xla::XlaOp& grad : grads) {
+      grad = grad * clip_coef;
+    }
+  }
+
+  // ZeRO does not skip steps, so nothing is ever found non finite.
+  xla::XlaOp found_inf = xla::Zero(builder, type);
+  std::vector<xla::XlaOp> results;
+  if (optimizer_ == ZeroOptimizer::kSgd) {
+    for (size_t i = 0; i < num_params_; ++i) {
+      std::vector<xla::XlaOp> param_results = BuildSgdOptimizerStep(
+          found_inf, steps[i], shards[i], states[i], grads[i], scalars[0],
+          scalars[1], scalars[2], scalars[3], use_weight_decay_, use_momentum_,
+          use_nesterov_);
+      results.insert(results.end(), param_results.begin(),
+                     param_results.end());
+    }
+  } else {
+    results = BuildMultiTensorAdamOptimizerStep(
+        found_inf, steps, shards, grads, states.subspan(0, num_params_),
+        states.subspan(num_params_, num_params_),
+        /*max_exp_avg_sqs=*/{}, scalars[0], scalars[1], scalars[2],
+        scalars[3], scalars[4], use_weight_decay_, /*use_amsgrad=*/false,
+        /*use_adamw=*/optimizer_ == ZeroOptimizer::kAdamW);
+  }
+  size_t results_per_param = 2 + NumStates(optimizer_);
+  XLA_CHECK_EQ(results.size(), num_params_ * results_per_param);
+
+  std::vector<xla::XlaOp> updated_shards;
+  updated_shards.reserve(num_params_);
+  for (size_t i = 0; i < num_params_; ++i) {
+    // The parameters are gathered in the type of their gradients.
+    xla::PrimitiveType param_type =
+        ShapeHelper::ShapeOfXlaOp(tensors(kGrad, num_params_)[i])
+            .element_type();
+    updated_shards.push_back(
+        MaybeConvertTo(results[i * results_per_param + 1], param_type));
+  }
+  AllGatherResultCoalesced gathered = BuildAllGatherCoalesced(
+      updated_shards, token, /*dim=*/0, shard_count_, groups_, pin_layout_);
+  results.insert(results.end(), gathered.result.begin(),
+                 gathered.result.end());
+  if (max_norm_) {
+    results.push_back(grad_norm);
+  }
+  results.push_back(gathered.token);
+  return ReturnOps(results, loctx);
+}
+
+std::string ZeroOptimizerStep::ToString() const {
+  std::stringstream ss;
+  ss << XlaNode::ToString()
+     << ", optimizer=" << torch::lazy::GetEnumValue(optimizer_)
+     << ", num_params=" << num_params_
+     << ", use_weight_decay=" << use_weight_decay_
+     << ", use_momentum=" << use_momentum_
+     << ", use_nesterov=" << use_nesterov_ << ", scale=" << scale_
+     << ", shard_count=" << shard_count_ << ", pin_layout=" << pin_layout_;
+  if (max_norm_) {
+    ss << ", max_norm=" << *max_norm_;
+  }
+  ss << ", groups=(";
+  for (size_t i = 0; i < groups_.size(); ++i) {
+    ss << (i == 0 ? "(" : ",(");
+    ss << absl::StrJoin(groups_[i], ", ") << ")";
+  }
+  ss << ")";
+  return ss.str();
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,77 @@
+#ifndef XLA_TORCH_XLA_CSRC_OPS_ZERO_OPTIMIZER_STEP_H_
+#define XLA_TORCH_XLA_CSRC_OPS_ZERO_OPTIMIZER_STEP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "torch_xla/csrc/ir.h"
+
+namespace torch_xla {
+
+// The update of the local shards of a ZeroOptimizerStep.
+enum class ZeroOptimizer {
+  // The hyper parameters are weight_decay, momentum, lr and dampening, and the
+  // state of each shard is its momentum buffer.
+  kSgd,
+  // The hyper parameters are beta1, beta2, lr, weight_decay and eps, and the
+  // state of each shard is its exp_avg and exp_avg_sq.
+  kAdam,
+  kAdamW,
+};
+
+// The ZeRO-1 step of a list of parameters. The full, padded, gradients are
+// reduce-scattered as one coalesced collective, the local shards of the
+// parameters are updated with the reduced gradient shards, and all-gathered
+// back as one coalesced collective, so that XLA schedules the collectives and
+// the updates as a unit. With a `max_norm`, the gradient shards are clipped
+// to that global norm first, whose all-reduce is part of the node too.
+//
+// The `states` are those of all the shards for the first state kind, then for
+// the next one, in the order of ZeroOptimizer. The outputs are the step, the
+// shard and the states of each parameter, one parameter after the other, then
+// the gathered padded parameters, then, with a `max_norm`, the norm of the
+// gradients, then the new token.
+class ZeroOptimizerStep : public XlaNode {
+ public:
+  ZeroOptimizerStep(ZeroOptimizer optimizer,
+                    c10::ArrayRef<torch::lazy::Value> scalars,
+                    c10::ArrayRef<torch::lazy::Value> grads,
+                    c10::ArrayRef<torch::lazy::Value> shards,
+                    c10::ArrayRef<torch::lazy::Value> steps,
+                    c10::ArrayRef<torch::lazy::Value> states,
+                    const torch::lazy::Value& token, bool use_weight_decay,
+                    bool use_momentum, bool use_nesterov, double scale,
+                    int64_t shard_count,
+                    std::vector<std::vector<int64_t>> groups,
+                    bool pin_layout, std::optional<double> max_norm);
+
+  torch::lazy::NodePtr Clone(torch::lazy::OpList operands) const override;
+
+  XlaOpVector Lower(LoweringContext* loctx) const override;
+
+  std::string ToString() const override;
+
+  // The number of hyper parameters and of state tensors per shard of the
+  // `optimizer`.
+  static size_t NumScalars(ZeroOptimizer optimizer);
+  static size_t NumStates(ZeroOptimizer optimizer);
+
+ private:
+  ZeroOptimizer optimizer_;
+  size_t num_params_;
+  bool use_weight_decay_;
+  bool use_momentum_;
+  bool use_nesterov_;
+  double scale_;
+  int64_t shard_count_;
+  std::vector<std::vector<int64_t>> groups_;
+  bool pin_layout_;
+  std::optional<double> max_norm_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OPS_ZERO_OPTIMIZER_STEP_H_
@@ -0,0 +1,137 @@
+#include "torch_xla/csrc/output_arena.h"
+
+#include <memory>
+#include <set>
+#include <utility>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+#include "xla/literal.h"
+
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tensor_source.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/unwrap_data.h"
+
+namespace torch_xla {
+
+bool UseOutputArena() {
+  static const bool use_output_arena =
+      runtime::sys_util::GetEnvBool("XLA_OUTPUT_ARENA", false);
+  return use_output_arena;
+}
+
+bool IsOutputArenaShape(const xla::Shape& shape) {
+  return shape.IsArray() && shape.is_static();
+}
+
+size_t AddOutputArenaParameters(xla::XlaBuilder* builder,
+                                absl::Span<const xla::XlaOp> results,
+                                size_t num_parameters) {
+  size_t num_added = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    XLA_ASSIGN_OR_THROW(xla::Shape shape, builder->GetShape(results[i]));
+    if (!IsOutputArenaShape(shape)) {
+      continue;
+    }
+    int64_t param_number = num_parameters + num_added;
+    xla::Parameter(builder, param_number, shape,
+                   absl::StrCat("output_arena.", i));
+    builder->SetUpAlias(/*output_index=*/{static_cast<int64_t>(i)},
+                        param_number, /*param_index=*/{});
+    ++num_added;
+  }
+  return num_added;
+}
+
+size_t CountAliasedOutputs(
+    const runtime::ComputationClient::Computation& computation) {
+  std::set<int64_t> outputs;
+  for (const auto& entry :
+       computation.computation().proto().input_output_alias().entries()) {
+    // An alias of the whole result stands for its single output.
+    outputs.insert(entry.output_shape_index().empty()
+                       ? 0
+                       : entry.output_shape_index(0));
+  }
+  return outputs.size();
+}
+
+OutputArena* OutputArena::Get() {
+  static OutputArena* arena = new OutputArena();
+  return arena;
+}
+
+std::vector<size_t> OutputArena::Bind(
+    const torch::lazy::hash_t& hash,
+    const runtime::ComputationClient::Computation& computation,
+    const std::string& device,
+    std::vector<runtime::ComputationClient::DataPtr>* arguments,
+    size_t* allocated) {
+  *allocated = 0;
+  const xla::ProgramShape& program_shape = computation.program_shape();
+  const size_t num_parameters = arguments->size();
+  const size_t num_total_parameters = program_shape.parameters_size();
+  if (num_total_parameters <= num_parameters ||
+      !program_shape.result().IsTuple()) {
+    return {};
+  }
+  std::vector<size_t> outputs;
+  const xla::Shape& result = program_shape.result();
+  for (size_t i = 0; i < result.tuple_shapes().size(); ++i) {
+    if (IsOutputArenaShape(result.tuple_shapes(i))) {
+      outputs.push_back(i);
+    }
+  }
+  XLA_CHECK_EQ(num_parameters + outputs.size(), num_total_parameters);
+
+  std::vector<size_t> missing;
+  std::vector<std::shared_ptr<const runtime::TensorSource>> sources;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::vector<torch::lazy::BackendDataPtr>& slots = slots_[hash];
+    slots.resize(outputs.size());
+    for (size_t slot = 0; slot < outputs.size(); ++slot) {
+      // Only the arena holds the last output of the slot once its tensor has
+      // been dropped, or updated by a later execution.
+      if (slots[slot] != nullptr && slots[slot].use_count() == 1 &&
+          slots[slot]->HasValue()) {
+        arguments->push_back(UnwrapXlaData(slots[slot]));
+      } else {
+        arguments->push_back(nullptr);
+        missing.push_back(num_parameters + slot);
+        sources.push_back(std::make_shared<runtime::LiteralSource>(
+            xla::Literal::CreateFromShape(
+                program_shape.parameters(num_parameters + slot)),
+            device));
+      }
+      slots[slot] = nullptr;
+    }
+  }
+  if (outputs.size() > missing.size()) {
+    TORCH_LAZY_COUNTER("OutputArenaReuses", outputs.size() - missing.size());
+  }
+  if (!sources.empty()) {
+    XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                        runtime::GetComputationClient());
+    std::vector<runtime::ComputationClient::DataPtr> buffers =
+        client->TransferToDevice(sources);
+    for (size_t i = 0; i < missing.size(); ++i) {
+      (*arguments)[missing[i]] = std::move(buffers[i]);
+    }
+    TORCH_LAZY_COUNTER("OutputArenaAllocations", missing.size());
+    *allocated = missing.size();
+  }
+  return outputs;
+}
+
+void OutputArena::Keep(const torch::lazy::hash_t& hash,
+                       std::vector<torch::lazy::BackendDataPtr> outputs) {
+  std::lock_guard<std::mutex> lock(lock_);
+  slots_[hash] = std::move(outputs);
+}
+
+}  // namespace torch_xla
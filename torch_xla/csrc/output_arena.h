@@ -0,0 +1,78 @@
+#ifndef XLA_TORCH_XLA_CSRC_OUTPUT_ARENA_H_
+#define XLA_TORCH_XLA_CSRC_OUTPUT_ARENA_H_
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <torch/csrc/lazy/backend/backend_data.h>
+#include <torch/csrc/lazy/core/hash.h>
+
+#include "absl/types/span.h"
+#include "xla/hlo/builder/xla_builder.h"
+#include "xla/shape.h"
+
+#include "torch_xla/csrc/runtime/computation_client.h"
+
+namespace torch_xla {
+
+// Returns whether the graphs write their outputs into the buffers of an
+// arena, from $XLA_OUTPUT_ARENA, off by default.
+bool UseOutputArena();
+
+// Returns whether an output of `shape` can be written into an arena buffer.
+bool IsOutputArenaShape(const xla::Shape& shape);
+
+// Adds, after the `num_parameters` parameters of the graph, a parameter
+// aliased with each of the `results` which can be written into an arena
+// buffer, in order. Returns the number of parameters added.
+size_t AddOutputArenaParameters(xla::XlaBuilder* builder,
+                                absl::Span<const xla::XlaOp> results,
+                                size_t num_parameters);
+
+// Counts the outputs of `computation` which are written into the buffer of one
+// of its parameters, rather than into a newly allocated one.
+size_t CountAliasedOutputs(
+    const runtime::ComputationClient::Computation& computation);
+
+// Holds, for each graph taking the parameters of AddOutputArenaParameters(),
+// the output data of its last execution. Once nothing else holds them, their
+// buffers are donated to the next execution of the graph, which writes its
+// outputs into them, so that the steady state steps of a fixed-shape loop do
+// not allocate their outputs. The buffers of an output still in use are
+// replaced by new ones.
+class OutputArena {
+ public:
+  static OutputArena* Get();
+
+  // Appends to `arguments`, the arguments of the execution of `computation`
+  // for graph `hash` on `device`, the buffers of its arena parameters, if it
+  // has any. Returns the indices of the outputs written into them, and sets
+  // `allocated` to the number of buffers which had to be allocated.
+  std::vector<size_t> Bind(
+      const torch::lazy::hash_t& hash,
+      const runtime::ComputationClient::Computation& computation,
+      const std::string& device,
+      std::vector<runtime::ComputationClient::DataPtr>* arguments,
+      size_t* allocated);
+
+  // Keeps `outputs`, the data of the outputs of the execution of graph `hash`
+  // which Bind() returned, for the next execution of the graph.
+  void Keep(const torch::lazy::hash_t& hash,
+            std::vector<torch::lazy::BackendDataPtr> outputs);
+
+ private:
+  OutputArena() = default;
+
+  std::mutex lock_;
+  std::unordered_map<torch::lazy::hash_t,
+                     std::vector<torch::lazy::BackendDataPtr>,
+                     torch::lazy::HashReducer>
+      slots_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_OUTPUT_ARENA_H_
@@ -0,0 +1,231 @@
+#include "torch_xla/csrc/parallel_lowering.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "xla/hlo/builder/xla_builder.h"
+#include "xla/hlo/builder/xla_computation.h"
+
+#include "torch_xla/csrc/all_reduce_bucketing.h"
+#include "torch_xla/csrc/ops/device_data.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/thread_pool.h"
+
+namespace torch_xla {
+namespace {
+
+size_t FindComponent(std::vector<size_t>* parents, size_t node) {
+  while ((*parents)[node] != node) {
+    (*parents)[node] = (*parents)[(*parents)[node]];
+    node = (*parents)[node];
+  }
+  return node;
+}
+
+size_t GetParallelLoweringMinNodes() {
+  static const size_t min_nodes =
+      runtime::sys_util::GetEnvInt("XLA_PARALLEL_LOWERING_MIN_NODES", 4096);
+  return min_nodes;
+}
+
+// Lowers a partition into `loctx`, and builds the computation returning the
+// ops of its roots.
+absl::StatusOr<xla::XlaComputation> LowerPartition(
+    c10::ArrayRef<const torch::lazy::Node*> partition,
+    const std::vector<torch::lazy::Output>& roots, int64_t bucket_cap_bytes,
+    LoweringContext* loctx) {
+  XLA_RETURN_IF_ERROR(
+      LowerWithAllReduceBuckets(partition, bucket_cap_bytes, loctx));
+  for (const torch::lazy::Output& root : roots) {
+    XLA_ASSIGN_OR_RETURN(xla::XlaOp op, loctx->SafeGetOutputOp(root));
+    loctx->AddResult(op);
+  }
+  return loctx->BuildXla();
+}
+
+}  // namespace
+
+int64_t GetParallelLoweringThreads() {
+  static const int64_t num_threads =
+      runtime::sys_util::GetEnvInt("XLA_PARALLEL_LOWERING_THREADS", 0);
+  return num_threads;
+}
+
+std::vector<std::vector<const torch::lazy::Node*>> PartitionPostOrder(
+    c10::ArrayRef<const torch::lazy::Node*> post_order, size_t max_partitions,
+    size_t min_partition_nodes) {
+  const size_t num_nodes = post_order.size();
+  const size_t num_partitions = std::min(
+      max_partitions, num_nodes / std::max<size_t>(min_partition_nodes, 1));
+  if (num_partitions < 2) {
+    return {post_order.vec()};
+  }
+
+  std::unordered_map<const torch::lazy::Node*, size_t> indices;
+  indices.reserve(num_nodes);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    indices.emplace(post_order[i], i);
+  }
+  std::vector<size_t> parents(num_nodes);
+  std::iota(parents.begin(), parents.end(), 0);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    for (const torch::lazy::Output& operand : post_order[i]->operands()) {
+      auto it = indices.find(operand.node);
+      if (it != indices.end()) {
+        parents[FindComponent(&parents, it->second)] =
+            FindComponent(&parents, i);
+      }
+    }
+  }
+
+  // Numbers the components in the order of their first node.
+  std::vector<size_t> components(num_nodes);
+  std::unordered_map<size_t, size_t> component_ids;
+  std::vector<size_t> component_sizes;
+  for (size_t i = 0; i < num_nodes; ++i) {
+    auto it = component_ids
+                  .emplace(FindComponent(&parents, i), component_sizes.size())
+                  .first;
+    if (it->second == component_sizes.size()) {
+      component_sizes.push_back(0);
+    }
+    components[i] = it->second;
+    ++component_sizes[it->second];
+  }
+  if (component_sizes.size() < 2) {
+    return {post_order.vec()};
+  }
+
+  // Assigns the largest components first, each to the least loaded partition.
+  std::vector<size_t> order(component_sizes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return component_sizes[a] > component_sizes[b];
+  });
+  std::vector<size_t> loads(num_partitions, 0);
+  std::vector<size_t> component_partitions(component_sizes.size());
+  for (size_t component : order) {
+    size_t partition =
+        std::min_element(loads.begin(), loads.end()) - loads.begin();
+    component_partitions[component] = partition;
+    loads[partition] += component_sizes[component];
+  }
+
+  std::vector<std::vector<const torch::lazy::Node*>> partitions(
+      num_partitions);
+  for (size_t i = 0; i < num_nodes; ++i) {
+    partitions[component_partitions[components[i]]].push_back(post_order[i]);
+  }
+  partitions.erase(
+      std::remove_if(partitions.begin(), partitions.end(),
+                     [](const std::vector<const torch::lazy::Node*>& nodes) {
+                       return nodes.empty();
+                     }),
+      partitions.end());
+  return partitions;
+}
+
+absl::Status LowerInParallel(c10::ArrayRef<const torch::lazy::Node*> post_order,
+                             c10::ArrayRef<torch::lazy::Output> roots,
+                             int64_t bucket_cap_bytes, int64_t num_threads,
+                             LoweringContext* loctx) {
+  std::vector<std::vector<const torch::lazy::Node*>> partitions;
+  if (num_threads > 1) {
+    partitions = PartitionPostOrder(post_order, num_threads,
+                                    GetParallelLoweringMinNodes());
+  }
+  if (partitions.size() < 2) {
+    return LowerWithAllReduceBuckets(post_order, bucket_cap_bytes, loctx);
+  }
+
+  std::unordered_map<const torch::lazy::Node*, size_t> node_partitions;
+  node_partitions.reserve(post_order.size());
+  for (size_t p = 0; p < partitions.size(); ++p) {
+    for (const torch::lazy::Node* node : partitions[p]) {
+      node_partitions.emplace(node, p);
+    }
+  }
+  std::vector<std::vector<torch::lazy::Output>> partition_roots(
+      partitions.size());
+  torch::lazy::OutputMap<bool> seen_roots;
+  for (const torch::lazy::Output& root : roots) {
+    auto it = node_partitions.find(root.node);
+    if (it != node_partitions.end() && seen_roots.emplace(root, true).second) {
+      partition_roots[it->second].push_back(root);
+    }
+  }
+
+  // The parameters are declared in post order, as the sequential lowering
+  // does, so that they match the device data collected with the post order.
+  for (const torch::lazy::Node* node : post_order) {
+    const DeviceData* device_data = DeviceData::Cast(node);
+    if (device_data != nullptr) {
+      XLA_RETURN_IF_ERROR(
+          loctx->GetParameter(device_data->data(), device_data->dynamic_dims())
+              .status());
+    }
+  }
+
+  const std::string& name = loctx->builder()->name();
+  std::vector<std::unique_ptr<LoweringContext>> contexts;
+  for (size_t p = 0; p < partitions.size(); ++p) {
+    contexts.push_back(std::make_unique<LoweringContext>(
+        absl::StrCat(name, "_partition", p), loctx->device()));
+  }
+  std::vector<absl::StatusOr<xla::XlaComputation>> computations(
+      partitions.size());
+  // Exceptions cannot cross the thread pool boundary, so they are captured and
+  // the first one is re-thrown on the calling thread.
+  std::vector<std::exception_ptr> errors(partitions.size());
+  auto lower = [&](size_t p) {
+    try {
+      computations[p] = LowerPartition(partitions[p], partition_roots[p],
+                                       bucket_cap_bytes, contexts[p].get());
+    } catch (...) {
+      errors[p] = std::current_exception();
+    }
+  };
+  absl::BlockingCounter counter(partitions.size() - 1);
+  for (size_t p = 1; p < partitions.size(); ++p) {
+    thread::ScheduleLowering([&, p]() {
+      lower(p);
+      counter.DecrementCount();
+    });
+  }
+  lower(0);
+  counter.Wait();
+  for (const std::exception_ptr& error : errors) {
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  for (size_t p = 0; p < partitions.size(); ++p) {
+    XLA_RETURN_IF_ERROR(computations[p].status());
+    std::vector<xla::XlaOp> args;
+    for (const torch::lazy::BackendDataPtr& data :
+         contexts[p]->GetParametersData()) {
+      XLA_ASSIGN_OR_RETURN(xla::XlaOp arg, loctx->GetParameter(data));
+      args.push_back(arg);
+    }
+    xla::XlaOp call = xla::Call(loctx->builder(), *computations[p], args);
+    for (size_t i = 0; i < partition_roots[p].size(); ++i) {
+      loctx->AssignOutputOp(partition_roots[p][i],
+                            xla::GetTupleElement(call, i));
+    }
+  }
+  TORCH_LAZY_COUNTER("ParallelLoweringPartitions", partitions.size());
+  return absl::OkStatus();
+}
+
+}  // namespace torch_xla
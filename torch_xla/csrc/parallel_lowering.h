@@ -0,0 +1,45 @@
+#ifndef XLA_TORCH_XLA_CSRC_PARALLEL_LOWERING_H_
+#define XLA_TORCH_XLA_CSRC_PARALLEL_LOWERING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <c10/util/ArrayRef.h>
+#include <torch/csrc/lazy/core/ir.h>
+
+#include "absl/status/status.h"
+
+#include "torch_xla/csrc/lowering_context.h"
+
+namespace torch_xla {
+
+// Returns the number of threads lowering the independent sub-graphs of a
+// graph, from $XLA_PARALLEL_LOWERING_THREADS. Zero, the default, lowers every
+// graph on the calling thread.
+int64_t GetParallelLoweringThreads();
+
+// Splits `post_order` into at most `max_partitions` partitions of at least
+// `min_partition_nodes` nodes, each in post order. A partition holds whole
+// connected components of the graph, so that no node of a partition has an
+// operand in another one. Returns a single partition when the graph cannot be
+// split.
+std::vector<std::vector<const torch::lazy::Node*>> PartitionPostOrder(
+    c10::ArrayRef<const torch::lazy::Node*> post_order, size_t max_partitions,
+    size_t min_partition_nodes);
+
+// Lowers the nodes of `post_order` into `loctx`, like
+// LowerWithAllReduceBuckets(), and assigns the ops of the `roots`. With more
+// than one partition of at most `num_threads`, every partition is lowered
+// into a builder of its own, in parallel, and `loctx` calls the computation of
+// each of them, with the parameters it declares in post order, as if it had
+// lowered the nodes itself. The `roots` must cover the outputs used outside of
+// `post_order`.
+absl::Status LowerInParallel(c10::ArrayRef<const torch::lazy::Node*> post_order,
+                             c10::ArrayRef<torch::lazy::Output> roots,
+                             int64_t bucket_cap_bytes, int64_t num_threads,
+                             LoweringContext* loctx);
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_PARALLEL_LOWERING_H_
@@ -13,6 +13,7 @@
 #include "torch_xla/csrc/data_ops.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/util.h"
 #include "torch_xla/csrc/shape_helper.h"
 #include "torch_xla/csrc/status.h"
@@ -24,6 +25,10 @@ namespace {
 
 const xla::PrimitiveType kIndicesType = xla::PrimitiveType::U32;
 
+// The largest number of window elements of the dense max pooling gradients,
+// which take a slice and a pad per element.
+const int64_t kMaxDenseMaxPoolWindowSize = 64;
+
 struct PoolingOpAttributes {
   std::vector<int64_t> kernel_size;
   std::vector<int64_t> stride;
@@ -378,8 +383,94 @@ xla::XlaOp ComputeMaxPoolIndices(
   return xla::Reshape(results[result_id], pool_result_shape.dimensions());
 }
 
+// Computes the max pooling gradient of the already padded `input` without a
+// select and scatter. For every offset in the window, a strided slice of the
+// input gives the element at that offset of every window. The windows whose
+// maximum is that element, the first one winning ties like the select of
+// BuildMaxPoolNdBackward() does, pass their gradient to it, and a strided pad
+// of the masked gradient puts it back at the input positions of the elements.
+xla::XlaOp BuildDenseMaxPoolBackward(
+    xla::XlaOp out_backprop, xla::XlaOp padded_input,
+    const PoolingOpAttributes& pooling_op_attributes) {
+  xla::XlaBuilder* builder = padded_input.builder();
+  const xla::Shape& padded_shape = ShapeHelper::ShapeOfXlaOp(padded_input);
+  const xla::Shape& out_shape = ShapeHelper::ShapeOfXlaOp(out_backprop);
+  const int64_t rank = padded_shape.dimensions_size();
+  std::vector<std::vector<int64_t>> offsets = {{}};
+  for (int64_t dim = 0; dim < rank; ++dim) {
+    std::vector<std::vector<int64_t>> dim_offsets;
+    for (const std::vector<int64_t>& offset : offsets) {
+      for (int64_t i = 0; i < pooling_op_attributes.kernel_size[dim]; ++i) {
+        dim_offsets.push_back(offset);
+        dim_offsets.back().push_back(i);
+      }
+    }
+    offsets = std::move(dim_offsets);
+  }
+
+  std::vector<xla::XlaOp> elements;
+  for (const std::vector<int64_t>& offset : offsets) {
+    std::vector<int64_t> limit(rank);
+    for (int64_t dim = 0; dim < rank; ++dim) {
+      limit[dim] = offset[dim] +
+                   (out_shape.dimensions(dim) - 1) *
+                       pooling_op_attributes.stride[dim] +
+                   1;
+    }
+    elements.push_back(xla::Slice(padded_input, offset, limit,
+                                  pooling_op_attributes.stride));
+  }
+  xla::XlaOp pool_result = elements[0];
+  for (size_t i = 1; i < elements.size(); ++i) {
+    pool_result = xla::Max(pool_result, elements[i]);
+  }
+  // NaN maximums come from the first NaN element of their window.
+  xla::XlaOp nan_result = xla::Ne(pool_result, pool_result);
+
+  xla::XlaOp zero = xla::Zero(builder, padded_shape.element_type());
+  xla::XlaOp zero_grad = xla::Broadcast(zero, out_shape.dimensions());
+  xla::XlaOp routed = xla::Broadcast(xla::ConstantR0<bool>(builder, false),
+                                     out_shape.dimensions());
+  xla::XlaOp grad_input = xla::Broadcast(zero, padded_shape.dimensions());
+  for (size_t i = 0; i < elements.size(); ++i) {
+    xla::XlaOp is_max = xla::And(
+        xla::Not(routed),
+        xla::Or(xla::Eq(elements[i], pool_result),
+                xla::And(nan_result, xla::Ne(elements[i], elements[i]))));
+    routed = xla::Or(routed, is_max);
+    xla::PaddingConfig padding_config;
+    for (int64_t dim = 0; dim < rank; ++dim) {
+      xla::PaddingConfig::PaddingConfigDimension* dims =
+          padding_config.add_dimensions();
+      int64_t extent = (out_shape.dimensions(dim) - 1) *
+                           pooling_op_attributes.stride[dim] +
+                       1;
+      dims->set_edge_padding_low(offsets[i][dim]);
+      dims->set_interior_padding(pooling_op_attributes.stride[dim] - 1);
+      dims->set_edge_padding_high(padded_shape.dimensions(dim) -
+                                  offsets[i][dim] - extent);
+    }
+    grad_input =
+        grad_input + xla::Pad(xla::Select(is_max, out_backprop, zero_grad),
+                              zero, padding_config);
+  }
+  return grad_input;
+}
+
 }  // namespace
 
+bool UseDenseMaxPoolBackward(XlaDeviceType hw_type) {
+  static const std::string* lowering =
+      new std::string(runtime::sys_util::GetEnvString(
+          "XLA_MAX_POOL_BACKWARD_LOWERING", "auto"));
+  if (*lowering == "dense") {
+    return true;
+  }
+  XLA_CHECK(*lowering == "select_and_scatter" || *lowering == "auto")
+      << "Invalid XLA_MAX_POOL_BACKWARD_LOWERING: " << *lowering;
+  return *lowering == "auto" && hw_type == XlaDeviceType::CUDA;
+}
+
 bool IsSupportedAdaptivePool(absl::Span<const int64_t> input_size,
                              absl::Span<const int64_t> output_size,
                              int pool_dim) {
@@ -498,7 +589,7 @@ xla::XlaOp BuildMaxPoolNdBackward(xla::XlaOp out_backprop, xla::XlaOp input,
                                   absl::Span<const int64_t> kernel_size,
                                   absl::Span<const int64_t> stride,
                                   absl::Span<const int64_t> padding,
-                                  bool ceil_mode) {
+                                  bool ceil_mode, bool dense) {
   xla::XlaBuilder* builder = out_backprop.builder();
   BatchInput batch_input_info = CreateBatchInput(input, spatial_dim_count);
   const xla::Shape& input_shape =
@@ -518,6 +609,30 @@ xla::XlaOp BuildMaxPoolNdBackward(xla::XlaOp out_backprop, xla::XlaOp input,
                         ceil_mode_padding.end());
   BatchInput batch_out_backprop_info =
       CreateBatchInput(out_backprop, spatial_dim_count);
+  if (dense && runtime::util::Multiply<int64_t>(kernel_size) <=
+                   kMaxDenseMaxPoolWindowSize) {
+    xla::XlaOp padded_input = xla::Pad(
+        batch_input_info.batch_input,
+        xla::MinValue(builder, input_shape.element_type()),
+        MakeXlaPaddingConfig(ceil_mode_padding));
+    xla::XlaOp padded_result = BuildDenseMaxPoolBackward(
+        batch_out_backprop_info.batch_input, padded_input,
+        pooling_op_attributes);
+    // Removes the window padding.
+    std::vector<int64_t> start(input_shape.dimensions_size(), 0);
+    std::vector<int64_t> limit(input_shape.dimensions().begin(),
+                               input_shape.dimensions().end());
+    for (size_t i = 0; i < ceil_mode_padding.size(); ++i) {
+      start[2 + i] = ceil_mode_padding[i].first;
+      limit[2 + i] += ceil_mode_padding[i].first;
+    }
+    xla::XlaOp batch_result = xla::Slice(
+        padded_result, start, limit,
+        std::vector<int64_t>(input_shape.dimensions_size(), 1));
+    return RemoveTrivialBatch(/*batch=*/batch_result,
+                              /*original_rank=*/batch_input_info.original_rank,
+                              /*spatial_dim_count=*/spatial_dim_count);
+  }
   xla::XlaOp batch_result = xla::SelectAndScatterWithGeneralPadding(
       /*operand=*/batch_input_info.batch_input,
       /*select=*/select,
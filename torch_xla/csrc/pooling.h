@@ -19,13 +19,19 @@ MaxPoolResult BuildMaxPoolNd(xla::XlaOp input, int64_t spatial_dim_count,
                              absl::Span<const int64_t> stride,
                              absl::Span<const int64_t> padding, bool ceil_mode);
 
-// Computes the gradient for max pooling.
+// Whether the max pooling gradients on `hw_type` devices are computed without
+// a select and scatter, from $XLA_MAX_POOL_BACKWARD_LOWERING.
+bool UseDenseMaxPoolBackward(XlaDeviceType hw_type);
+
+// Computes the gradient for max pooling. If dense is true, and the window is
+// small enough, the gradient is computed with a strided slice and a strided
+// pad per window offset rather than with a select and scatter.
 xla::XlaOp BuildMaxPoolNdBackward(xla::XlaOp out_backprop, xla::XlaOp input,
                                   int64_t spatial_dim_count,
                                   absl::Span<const int64_t> kernel_size,
                                   absl::Span<const int64_t> stride,
                                   absl::Span<const int64_t> padding,
-                                  bool ceil_mode);
+                                  bool ceil_mode, bool dense);
 
 // Computes average pooling for the given input.
 xla::XlaOp BuildAvgPoolNd(xla::XlaOp input, int64_t spatial_dim_count,
@@ -1,6 +1,10 @@
 #include "torch_xla/csrc/reduction.h"
 
+#include <algorithm>
 #include <cmath>
+#include <numeric>
+#include <optional>
+#include <string>
 #include <unordered_set>
 
 #include <ATen/core/Reduction.h>
@@ -11,11 +15,13 @@
 #include "xla/hlo/builder/lib/constants.h"
 #include "xla/hlo/builder/lib/matrix.h"
 #include "xla/literal_util.h"
+#include "xla/util.h"
 
 #include "torch_xla/csrc/convert_ops.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/ops/einsum_utilities.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/shape_helper.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/tensor_util.h"
@@ -98,6 +104,98 @@ xla::XlaOp GetScaleValue(xla::XlaOp input, xla::XlaOp count,
   }
 }
 
+// How the summations accumulate low precision floating point inputs, per
+// $XLA_REDUCTION_ACCUMULATION.
+enum class Accumulation {
+  // In the input type.
+  kInput,
+  // In F32, converting the result back to the input type.
+  kF32,
+  // In the input type, summing blocks of kPairwiseBlockSize elements of the
+  // longest reduced dimension first, and then their partial sums, which bounds
+  // the error growth by the block size and the number of blocks rather than
+  // by the number of elements.
+  kPairwise,
+};
+
+constexpr int64_t kPairwiseBlockSize = 128;
+
+Accumulation GetAccumulation() {
+  static const Accumulation accumulation = []() {
+    std::string name =
+        runtime::sys_util::GetEnvString("XLA_REDUCTION_ACCUMULATION", "input");
+    if (name == "f32") {
+      return Accumulation::kF32;
+    }
+    if (name == "pairwise") {
+      return Accumulation::kPairwise;
+    }
+    XLA_CHECK(name == "input")
+        << "Invalid XLA_REDUCTION_ACCUMULATION: " << name;
+    return Accumulation::kInput;
+  }();
+  return accumulation;
+}
+
+// Returns how the summation of the `dimensions` of `shape` accumulates. The
+// summations of fewer than $XLA_REDUCTION_UPCAST_MIN_SIZE elements keep
+// accumulating in the input type, the rounding error of short summations
+// being small, and so do the ones of high precision types.
+Accumulation GetAccumulation(const xla::Shape& shape,
+                             absl::Span<const int64_t> dimensions) {
+  static const int64_t min_size =
+      runtime::sys_util::GetEnvInt("XLA_REDUCTION_UPCAST_MIN_SIZE", 0);
+  if (shape.element_type() != xla::PrimitiveType::BF16 &&
+      shape.element_type() != xla::PrimitiveType::F16) {
+    return Accumulation::kInput;
+  }
+  int64_t size = 1;
+  for (int64_t dim : dimensions) {
+    if (shape.is_dynamic_dimension(dim)) {
+      return GetAccumulation();
+    }
+    size *= shape.dimensions(dim);
+  }
+  return size < min_size ? Accumulation::kInput : GetAccumulation();
+}
+
+xla::XlaOp ReduceAdd(xla::XlaOp input, absl::Span<const int64_t> dimensions) {
+  xla::PrimitiveType type = XlaHelpers::TypeOfXlaOp(input);
+  return xla::Reduce(input, xla::Zero(input.builder(), type),
+                     XlaHelpers::CreateAddComputation(type), dimensions);
+}
+
+xla::XlaOp PairwiseReduceAdd(xla::XlaOp input, const xla::Shape& shape,
+                             absl::Span<const int64_t> dimensions) {
+  std::optional<int64_t> longest;
+  for (int64_t dim : dimensions) {
+    if (shape.is_dynamic_dimension(dim)) {
+      return ReduceAdd(input, dimensions);
+    }
+    if (!longest || shape.dimensions(dim) > shape.dimensions(*longest)) {
+      longest = dim;
+    }
+  }
+  if (!longest || shape.dimensions(*longest) <= kPairwiseBlockSize) {
+    return ReduceAdd(input, dimensions);
+  }
+  // Splits the longest dimension into [num_blocks, kPairwiseBlockSize], zero
+  // padding its end, and sums the blocks away first.
+  int64_t num_blocks =
+      xla::CeilOfRatio(shape.dimensions(*longest), kPairwiseBlockSize);
+  xla::XlaOp padded = xla::PadInDim(
+      input, xla::Zero(input.builder(), shape.element_type()), *longest,
+      /*pad_lo=*/0,
+      /*pad_hi=*/num_blocks * kPairwiseBlockSize - shape.dimensions(*longest));
+  std::vector<int64_t> sizes(shape.dimensions().begin(),
+                             shape.dimensions().end());
+  sizes[*longest] = num_blocks;
+  sizes.insert(sizes.begin() + *longest + 1, kPairwiseBlockSize);
+  xla::XlaOp partial_sums =
+      ReduceAdd(xla::Reshape(padded, sizes), {*longest + 1});
+  return ReduceAdd(partial_sums, dimensions);
+}
+
 xla::XlaOp AverageValue(xla::XlaOp input, xla::XlaOp reduced) {
   const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
   xla::XlaOp num_elements =
@@ -111,17 +209,22 @@ SummationResult CreateSummation(xla::XlaOp input,
                                 absl::Span<const int64_t> dimensions,
                                 bool keep_reduced_dimensions, bool scale) {
   const xla::Shape& shape = ShapeHelper::ShapeOfXlaOp(input);
-  xla::XlaOp init_value = xla::Zero(input.builder(), shape.element_type());
   SummationResult result;
   result.rinfo =
       GetReductionInfo(input, shape, dimensions, keep_reduced_dimensions);
-  result.result = xla::Reduce(
-      input, init_value, XlaHelpers::CreateAddComputation(shape.element_type()),
-      dimensions);
+  Accumulation accumulation = GetAccumulation(shape, dimensions);
+  xla::PrimitiveType sum_type = accumulation == Accumulation::kF32
+                                    ? xla::PrimitiveType::F32
+                                    : shape.element_type();
+  result.result =
+      accumulation == Accumulation::kPairwise
+          ? PairwiseReduceAdd(input, shape, dimensions)
+          : ReduceAdd(MaybeConvertTo(input, sum_type), dimensions);
   if (scale) {
     result.result = GetScaleValue(
-        result.result, result.rinfo.element_count.size, shape.element_type());
+        result.result, result.rinfo.element_count.size, sum_type);
   }
+  result.result = MaybeConvertTo(result.result, shape.element_type());
   if (keep_reduced_dimensions) {
     if (shape.is_unbounded_dynamic()) {
       for (size_t i = 0; i < result.rinfo.new_dimensions.size(); ++i) {
@@ -154,6 +257,65 @@ xla::XlaOp CreateProduct(xla::XlaOp input, absl::Span<const int64_t> dimensions,
   return result;
 }
 
+// Lowers the two operand einsums which neither contract nor reduce a label,
+// like the outer and the elementwise products, to a broadcast multiply, which
+// XLA fuses with its neighbours, instead of a dot with no contracting
+// dimensions. Returns std::nullopt for the other einsums.
+std::optional<xla::XlaOp> BuildEinsumProduct(xla::XlaOp lhs, xla::XlaOp rhs,
+                                             const std::string& equation) {
+  size_t comma = equation.find(',');
+  size_t arrow = equation.find("->");
+  if (comma == std::string::npos || arrow == std::string::npos ||
+      equation.find('.') != std::string::npos) {
+    return std::nullopt;
+  }
+  std::string output = equation.substr(arrow + 2);
+  std::vector<std::string> labels = {
+      equation.substr(0, comma), equation.substr(comma + 1, arrow - comma - 1)};
+  std::vector<xla::XlaOp> inputs = {lhs, rhs};
+  std::vector<int64_t> output_sizes(output.size(), -1);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const xla::Shape& shape = ShapeHelper::ShapeOfXlaOp(inputs[i]);
+    if (shape.is_dynamic() || shape.dimensions_size() != labels[i].size()) {
+      return std::nullopt;
+    }
+    for (size_t dim = 0; dim < labels[i].size(); ++dim) {
+      size_t position = output.find(labels[i][dim]);
+      if (position == std::string::npos ||
+          labels[i].find(labels[i][dim], dim + 1) != std::string::npos ||
+          (output_sizes[position] >= 0 &&
+           output_sizes[position] != shape.dimensions(dim))) {
+        return std::nullopt;
+      }
+      output_sizes[position] = shape.dimensions(dim);
+    }
+  }
+  if (std::find(output_sizes.begin(), output_sizes.end(), -1) !=
+      output_sizes.end()) {
+    return std::nullopt;
+  }
+  xla::PrimitiveType type = XlaHelpers::PromoteType(
+      XlaHelpers::TypeOfXlaOp(lhs), XlaHelpers::TypeOfXlaOp(rhs));
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    // Orders the dimensions of the input as the output does, and broadcasts
+    // it to the dimensions of the output.
+    std::vector<int64_t> permutation(labels[i].size());
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::sort(permutation.begin(), permutation.end(),
+              [&](int64_t a, int64_t b) {
+                return output.find(labels[i][a]) < output.find(labels[i][b]);
+              });
+    std::vector<int64_t> broadcast_dimensions;
+    for (int64_t dim : permutation) {
+      broadcast_dimensions.push_back(output.find(labels[i][dim]));
+    }
+    inputs[i] = xla::BroadcastInDim(
+        xla::Transpose(MaybeConvertTo(inputs[i], type), permutation),
+        output_sizes, broadcast_dimensions);
+  }
+  return inputs[0] * inputs[1];
+}
+
 }  // namespace
 
 ReductionMode GetXlaReductionMode(int64_t reduction) {
@@ -190,9 +352,10 @@ xla::XlaOp BuildBinaryCrossEntropy(xla::XlaOp input, xla::XlaOp target,
   if (reduction == ReductionMode::kNone) {
     return result;
   }
-  xla::XlaOp reduced_result = xla::ReduceAll(
-      result, xla::Zero(input.builder(), input_shape.element_type()),
-      XlaHelpers::CreateAddComputation(input_shape.element_type()));
+  xla::XlaOp reduced_result =
+      CreateSummation(result, XlaHelpers::GetAllDimensions(input_shape),
+                      /*keep_reduced_dimensions=*/false, /*scale=*/false)
+          .result;
   if (reduction == ReductionMode::kMean) {
     reduced_result = AverageValue(result, reduced_result);
   }
@@ -236,9 +399,9 @@ xla::XlaOp BuildMseLoss(xla::XlaOp input, xla::XlaOp target,
   }
   const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
   const xla::Shape& result_shape = ShapeHelper::ShapeOfXlaOp(result);
-  result = xla::ReduceAll(
-      result, xla::Zero(result.builder(), result_shape.element_type()),
-      XlaHelpers::CreateAddComputation(result_shape.element_type()));
+  result = CreateSummation(result, XlaHelpers::GetAllDimensions(result_shape),
+                           /*keep_reduced_dimensions=*/false, /*scale=*/false)
+               .result;
   if (reduction == ReductionMode::kMean) {
     int64_t num_elements = xla::ShapeUtil::ElementsIn(input_shape);
     if (num_elements == 0) {
@@ -306,6 +469,74 @@ xla::XlaOp BuildCumulativeComputationWithIndices(
       /*base_dilations=*/{}, /*window_dilations=*/{}, padding);
 }
 
+bool UseAssociativeScan(const xla::Shape& shape, int64_t dim) {
+  static const int64_t min_size =
+      runtime::sys_util::GetEnvInt("XLA_ASSOCIATIVE_SCAN_MIN_SIZE", 2048);
+  return min_size > 0 && shape.dimensions(dim) >= min_size &&
+         !shape.is_dynamic_dimension(dim);
+}
+
+std::vector<xla::XlaOp> BuildAssociativeScan(
+    absl::Span<const xla::XlaOp> inputs, int64_t dim,
+    const ScanCombiner& combiner) {
+  XLA_CHECK(!inputs.empty());
+  const int64_t size = ShapeHelper::ShapeOfXlaOp(inputs[0]).dimensions(dim);
+  std::vector<xla::XlaOp> elements(inputs.begin(), inputs.end());
+  if (size < 2) {
+    return elements;
+  }
+  auto slice = [&](absl::Span<const xla::XlaOp> ops, int64_t start,
+                   int64_t limit, int64_t stride) {
+    std::vector<xla::XlaOp> slices;
+    for (xla::XlaOp op : ops) {
+      slices.push_back(xla::SliceInDim(op, start, limit, stride, dim));
+    }
+    return slices;
+  };
+  // The odd outputs are the scan of the combined pairs of elements, and every
+  // even output but the first one combines the odd output before it with its
+  // own element.
+  const int64_t num_odd = size / 2;
+  const int64_t num_even = size - num_odd;
+  std::vector<xla::XlaOp> odd = BuildAssociativeScan(
+      combiner(slice(elements, 0, size - 1, 2), slice(elements, 1, size, 2)),
+      dim, combiner);
+  std::vector<xla::XlaOp> even;
+  if (num_even > 1) {
+    even = combiner(slice(odd, 0, num_even - 1, 1),
+                    slice(elements, 2, size, 2));
+  }
+
+  std::vector<xla::XlaOp> outputs;
+  for (size_t i = 0; i < elements.size(); ++i) {
+    xla::XlaOp first = xla::SliceInDim(elements[i], 0, 1, 1, dim);
+    xla::XlaOp even_output =
+        even.empty() ? first : xla::ConcatInDim(first.builder(),
+                                                {first, even[i]}, dim);
+    xla::XlaOp odd_output = odd[i];
+    if (num_odd < num_even) {
+      odd_output = xla::PadInDim(
+          odd_output,
+          xla::Zero(odd_output.builder(), XlaHelpers::TypeOfXlaOp(odd_output)),
+          dim, /*pad_lo=*/0, /*pad_hi=*/1);
+    }
+    // Interleaves the even and the odd outputs, through a [..., M, 2, ...]
+    // tensor.
+    std::vector<int64_t> sizes = XlaHelpers::SizesOfXlaOp(even_output);
+    std::vector<int64_t> pair_sizes = sizes;
+    pair_sizes.insert(pair_sizes.begin() + dim + 1, 1);
+    xla::XlaOp pairs = xla::ConcatInDim(
+        first.builder(),
+        {xla::Reshape(even_output, pair_sizes),
+         xla::Reshape(odd_output, pair_sizes)},
+        dim + 1);
+    sizes[dim] *= 2;
+    outputs.push_back(
+        xla::SliceInDim(xla::Reshape(pairs, sizes), 0, size, 1, dim));
+  }
+  return outputs;
+}
+
 xla::XlaOp BuildMean(xla::XlaOp input, absl::Span<const int64_t> dimensions,
                      bool keep_reduced_dimensions) {
   return CreateSummation(input, dimensions, keep_reduced_dimensions,
@@ -581,6 +812,11 @@ xla::XlaOp BuildEinsum(absl::Span<const xla::XlaOp> operands,
         operands[0], equation,
         xla::PrecisionConfig::Precision::PrecisionConfig_Precision_DEFAULT);
   } else if (operands.size() == 2) {
+    std::optional<xla::XlaOp> product =
+        BuildEinsumProduct(operands[0], operands[1], equation);
+    if (product) {
+      return *product;
+    }
     return xla::Einsum(
         operands[0], operands[1], equation,
         xla::PrecisionConfig::Precision::PrecisionConfig_Precision_DEFAULT,
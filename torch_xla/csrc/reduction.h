@@ -1,8 +1,12 @@
 #ifndef XLA_TORCH_XLA_CSRC_REDUCTION_H_
 #define XLA_TORCH_XLA_CSRC_REDUCTION_H_
 
+#include <functional>
+#include <vector>
+
 #include "absl/types/span.h"
 #include "xla/hlo/builder/xla_builder.h"
+#include "xla/shape.h"
 
 namespace torch_xla {
 
@@ -96,6 +100,24 @@ xla::XlaOp BuildCumulativeComputationWithIndices(
     const xla::XlaComputation& reducer, xla::XlaOp value_init,
     xla::XlaOp index_init);
 
+// Combines the elements "lhs" of the operands of an associative scan with the
+// elements "rhs" which follow them, element-wise.
+using ScanCombiner = std::function<std::vector<xla::XlaOp>(
+    absl::Span<const xla::XlaOp> lhs, absl::Span<const xla::XlaOp> rhs)>;
+
+// Whether the cumulative computations of "shape" in the dimension "dim" use
+// BuildAssociativeScan(), per $XLA_ASSOCIATIVE_SCAN_MIN_SIZE.
+bool UseAssociativeScan(const xla::Shape& shape, int64_t dim);
+
+// Computes the inclusive scan of "inputs", which have the same dimensions, in
+// the dimension "dim", with the associative "combiner". The scan recurses on
+// the combined pairs of elements, so it takes O(N) combinations in O(log N)
+// levels of slices, where the reduce window of BuildCumulativeComputation()
+// takes O(N^2) for a dimension of size N.
+std::vector<xla::XlaOp> BuildAssociativeScan(
+    absl::Span<const xla::XlaOp> inputs, int64_t dim,
+    const ScanCombiner& combiner);
+
 xla::XlaOp BuildAll(xla::XlaOp input, absl::Span<const int64_t> dimensions,
                     bool keep_reduced_dimensions);
 
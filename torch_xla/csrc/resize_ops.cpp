@@ -1,5 +1,8 @@
 #include "torch_xla/csrc/resize_ops.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "absl/strings/str_cat.h"
 #include "xla/hlo/builder/lib/constants.h"
 #include "xla/shape_util.h"
@@ -225,6 +228,67 @@ std::string GetBackendConfig(bool align_corners, bool half_pixel_centers) {
   return absl::StrCat("\"", align_corners, half_pixel_centers, "\"");
 }
 
+// Returns the [out_size, in_size] matrix of the weights of the input elements
+// in the bilinear interpolation of each output element, computed the way
+// PyTorch computes the source index of the output elements.
+xla::XlaOp BuildInterpolationMatrix(xla::XlaBuilder* builder, int64_t in_size,
+                                    int64_t out_size, bool align_corners,
+                                    xla::PrimitiveType type) {
+  double scale = static_cast<double>(in_size) / out_size;
+  if (align_corners) {
+    scale = out_size > 1 ? static_cast<double>(in_size - 1) / (out_size - 1)
+                         : 0.0;
+  }
+  std::vector<float> weights(out_size * in_size, 0.0f);
+  for (int64_t i = 0; i < out_size; ++i) {
+    double source = align_corners ? scale * i
+                                  : std::max(scale * (i + 0.5) - 0.5, 0.0);
+    int64_t lower = std::min(static_cast<int64_t>(source), in_size - 1);
+    int64_t upper = std::min(lower + 1, in_size - 1);
+    double lambda = source - lower;
+    weights[i * in_size + lower] += 1.0 - lambda;
+    weights[i * in_size + upper] += lambda;
+  }
+  return xla::ConvertElementType(
+      xla::Reshape(xla::ConstantR1<float>(builder, weights),
+                   {out_size, in_size}),
+      type);
+}
+
+// Resizes the NCHW `input` to `output_shape` with a matmul per spatial
+// dimension, replacing the gathers of BuildResize(). With `transpose`, applies
+// the transposed matrices to the NCHW gradient `input` of the resize from
+// `output_shape`, which computes the gradient of its input.
+xla::XlaOp BuildMatmulResize(xla::XlaOp input, const xla::Shape& output_shape,
+                             bool align_corners, bool transpose) {
+  const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
+  xla::XlaOp matrices[2];
+  for (int dim = 0; dim < 2; ++dim) {
+    int64_t in_size = input_shape.dimensions(2 + dim);
+    int64_t out_size = output_shape.dimensions(2 + dim);
+    matrices[dim] =
+        transpose ? BuildInterpolationMatrix(input.builder(), out_size,
+                                             in_size, align_corners,
+                                             input_shape.element_type())
+                  : BuildInterpolationMatrix(input.builder(), in_size,
+                                             out_size, align_corners,
+                                             input_shape.element_type());
+  }
+  xla::PrecisionConfig precision_config =
+      XlaHelpers::BuildPrecisionConfig(XlaHelpers::mat_mul_precision());
+  xla::DotDimensionNumbers dimension_numbers;
+  dimension_numbers.add_rhs_contracting_dimensions(transpose ? 0 : 1);
+  // [N, C, H, W] x [W', W] -> [N, C, H, W']
+  dimension_numbers.add_lhs_contracting_dimensions(3);
+  xla::XlaOp resized = xla::DotGeneral(input, matrices[1], dimension_numbers,
+                                       &precision_config);
+  // [N, C, H, W'] x [H', H] -> [N, C, W', H']
+  dimension_numbers.set_lhs_contracting_dimensions(0, 2);
+  resized = xla::DotGeneral(resized, matrices[0], dimension_numbers,
+                            &precision_config);
+  return xla::Transpose(resized, {0, 1, 3, 2});
+}
+
 double ResizeFactor(const xla::Shape& input_shape,
                     const xla::Shape& output_shape, int dim) {
   return static_cast<double>(input_shape.dimensions(dim)) /
@@ -233,6 +297,17 @@ double ResizeFactor(const xla::Shape& input_shape,
 
 }  // namespace
 
+bool UseMatmulResize(XlaDeviceType hw_type) {
+  static const std::string* lowering = new std::string(
+      runtime::sys_util::GetEnvString("XLA_RESIZE_LOWERING", "auto"));
+  if (*lowering == "matmul") {
+    return true;
+  }
+  XLA_CHECK(*lowering == "gather" || *lowering == "auto")
+      << "Invalid XLA_RESIZE_LOWERING: " << *lowering;
+  return *lowering == "auto" && hw_type == XlaDeviceType::CUDA;
+}
+
 xla::Shape GetForwardOutputShape2d(const xla::Shape& input_shape,
                                    absl::Span<const int64_t> output_size) {
   XLA_CHECK_EQ(output_size.size(), 2);
@@ -260,6 +335,12 @@ xla::XlaOp LowerForward2d(const std::string& target, xla::XlaOp input,
   if (input_shape.dimensions(2) == 1 && input_shape.dimensions(3) == 1) {
     return input + xla::Zeros(input.builder(), output_shape);
   }
+  XlaDeviceType hw_type =
+      static_cast<XlaDeviceType>(bridge::GetCurrentDevice().type());
+  if (target == "ResizeBilinear" && UseMatmulResize(hw_type)) {
+    return BuildMatmulResize(input, output_shape, align_corners,
+                             /*transpose=*/false);
+  }
   // XLA wants NHWC while PyTorch comes in as NCHW, so we need to transpose,
   // call the kernel, and transpose back.
   std::vector<int64_t> transpose_permute({0, 3, 2, 1});
@@ -269,9 +350,6 @@ xla::XlaOp LowerForward2d(const std::string& target, xla::XlaOp input,
   xla::XlaOp tinput = xla::Transpose(input, transpose_permute);
 
   xla::XlaOp resized;
-
-  XlaDeviceType hw_type =
-      static_cast<XlaDeviceType>(bridge::GetCurrentDevice().type());
   if (CheckTpuDevice(hw_type) || CheckNeuronDevice(hw_type)) {
     // TPU uses custom call implementation
     resized =
@@ -303,6 +381,12 @@ xla::XlaOp LowerBackward2d(const std::string& target, xla::XlaOp input,
       input_shape.dimensions(3) == output_shape.dimensions(3)) {
     return input;
   }
+  if (target == "ResizeBilinearGrad" &&
+      UseMatmulResize(
+          static_cast<XlaDeviceType>(bridge::GetCurrentDevice().type()))) {
+    return BuildMatmulResize(input, output_shape, align_corners,
+                             /*transpose=*/true);
+  }
   // XLA wants NHWC while PyTorch comes in as NCHW, so we need to transpose,
   // call the kernel, and transpose back.
   std::vector<int64_t> transpose_permute({0, 3, 2, 1});
@@ -6,9 +6,15 @@
 #include "absl/types/span.h"
 #include "xla/hlo/builder/xla_builder.h"
 
+#include "torch_xla/csrc/device.h"
+
 namespace torch_xla {
 namespace resize {
 
+// Whether the bilinear resizes on `hw_type` devices, and their gradients, are
+// lowered to matmuls with interpolation matrices, from $XLA_RESIZE_LOWERING.
+bool UseMatmulResize(XlaDeviceType hw_type);
+
 xla::Shape GetForwardOutputShape2d(const xla::Shape& input_shape,
                                    absl::Span<const int64_t> output_size);
 
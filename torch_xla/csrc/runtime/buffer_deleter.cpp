@@ -0,0 +1,95 @@
+#include "torch_xla/csrc/runtime/buffer_deleter.h"
+
+#include <utility>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "torch_xla/csrc/runtime/sys_util.h"
+
+namespace torch_xla {
+namespace runtime {
+
+BufferDeleter* BufferDeleter::Get() {
+  static BufferDeleter* deleter = []() -> BufferDeleter* {
+    if (!sys_util::GetEnvBool("XLA_ASYNC_BUFFER_DELETION", true)) {
+      return nullptr;
+    }
+    int64_t max_pending_mb =
+        sys_util::GetEnvInt("XLA_ASYNC_BUFFER_DELETION_MAX_PENDING_MB", 1024);
+    return new BufferDeleter(static_cast<size_t>(max_pending_mb) << 20);
+  }();
+  return deleter;
+}
+
+BufferDeleter::BufferDeleter(size_t max_pending_bytes)
+    : max_pending_bytes_(max_pending_bytes), thread_([this]() { Run(); }) {}
+
+BufferDeleter::~BufferDeleter() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    stop_ = true;
+  }
+  queued_cv_.notify_one();
+  thread_.join();
+}
+
+void BufferDeleter::Delete(std::shared_ptr<void> buffer, size_t size_bytes) {
+  bool over_limit;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    queue_.push_back(std::move(buffer));
+    queued_bytes_ += size_bytes;
+    pending_bytes_ += size_bytes;
+    ++num_queued_;
+    over_limit = pending_bytes_ > max_pending_bytes_;
+  }
+  queued_cv_.notify_one();
+  if (over_limit) {
+    TORCH_LAZY_COUNTER("AsyncBufferDeletionThrottled", 1);
+    Flush();
+  }
+}
+
+void BufferDeleter::Flush() {
+  std::unique_lock<std::mutex> lock(lock_);
+  uint64_t num_queued = num_queued_;
+  if (num_released_ >= num_queued) {
+    return;
+  }
+  TORCH_LAZY_COUNTER("AsyncBufferDeletionWaits", 1);
+  released_cv_.wait(lock, [&]() { return num_released_ >= num_queued; });
+}
+
+size_t BufferDeleter::pending_bytes() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return pending_bytes_;
+}
+
+void BufferDeleter::Run() {
+  while (true) {
+    std::vector<std::shared_ptr<void>> batch;
+    size_t batch_bytes;
+    {
+      std::unique_lock<std::mutex> lock(lock_);
+      queued_cv_.wait(lock, [&]() { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      batch.swap(queue_);
+      batch_bytes = queued_bytes_;
+      queued_bytes_ = 0;
+    }
+    size_t batch_size = batch.size();
+    batch.clear();
+    TORCH_LAZY_COUNTER("AsyncBufferDeletions", batch_size);
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      pending_bytes_ -= batch_bytes;
+      num_released_ += batch_size;
+    }
+    released_cv_.notify_all();
+  }
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
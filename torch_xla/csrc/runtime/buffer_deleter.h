@@ -0,0 +1,70 @@
+#ifndef XLA_CLIENT_BUFFER_DELETER_H_
+#define XLA_CLIENT_BUFFER_DELETER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace torch_xla {
+namespace runtime {
+
+// Releases device buffers on a background thread, so that dropping many
+// tensors at once, like the parameters a step replaces, does not stall the
+// thread dropping them. The buffers queued while a batch is being released
+// make up the next batch.
+//
+// Releasing a buffer only drops a reference to it, and the runtime still
+// frees its memory once the usage holds on it are gone. Callers about to
+// allocate device memory call Flush(), so that the memory of the buffers
+// already dropped is available.
+class BufferDeleter {
+ public:
+  // Returns the process wide deleter, or nullptr if the asynchronous
+  // deletion is disabled by XLA_ASYNC_BUFFER_DELETION=0. At most
+  // XLA_ASYNC_BUFFER_DELETION_MAX_PENDING_MB (default 1024) MiB are pending
+  // at any time.
+  static BufferDeleter* Get();
+
+  explicit BufferDeleter(size_t max_pending_bytes);
+
+  // Releases the pending buffers before returning.
+  ~BufferDeleter();
+
+  BufferDeleter(const BufferDeleter&) = delete;
+  BufferDeleter& operator=(const BufferDeleter&) = delete;
+
+  // Queues `buffer`, of `size_bytes` bytes, for release. Waits for the pending
+  // buffers to be released once they are more than the pending bytes limit.
+  void Delete(std::shared_ptr<void> buffer, size_t size_bytes);
+
+  // Waits until the buffers queued so far are released.
+  void Flush();
+
+  size_t pending_bytes() const;
+
+ private:
+  void Run();
+
+  const size_t max_pending_bytes_;
+  mutable std::mutex lock_;
+  std::condition_variable queued_cv_;
+  std::condition_variable released_cv_;
+  std::vector<std::shared_ptr<void>> queue_;
+  // The bytes of the queued buffers, and of the batch being released.
+  size_t pending_bytes_ = 0;
+  size_t queued_bytes_ = 0;
+  // The number of buffers ever queued, and released.
+  uint64_t num_queued_ = 0;
+  uint64_t num_released_ = 0;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_BUFFER_DELETER_H_
@@ -0,0 +1,72 @@
+#include "torch_xla/csrc/runtime/buffer_deleter.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace torch_xla {
+namespace runtime {
+
+// Returns a buffer which bumps `released` once released, from the thread
+// which was `releaser` then.
+std::shared_ptr<void> MakeBuffer(std::atomic<int>* released,
+                                 std::thread::id* releaser = nullptr) {
+  return std::shared_ptr<void>(new int(0), [released, releaser](void* data) {
+    delete static_cast<int*>(data);
+    if (releaser != nullptr) {
+      *releaser = std::this_thread::get_id();
+    }
+    ++*released;
+  });
+}
+
+TEST(BufferDeleterTest, ReleasesOnTheBackgroundThread) {
+  BufferDeleter deleter(/*max_pending_bytes=*/1 << 20);
+  std::atomic<int> released{0};
+  std::thread::id releaser;
+  deleter.Delete(MakeBuffer(&released, &releaser), /*size_bytes=*/100);
+  for (int i = 0; i < 99; ++i) {
+    deleter.Delete(MakeBuffer(&released), /*size_bytes=*/100);
+  }
+  deleter.Flush();
+  EXPECT_EQ(released, 100);
+  EXPECT_NE(releaser, std::this_thread::get_id());
+  EXPECT_EQ(deleter.pending_bytes(), 0);
+}
+
+TEST(BufferDeleterTest, SharedBuffersStayAlive) {
+  BufferDeleter deleter(/*max_pending_bytes=*/1 << 20);
+  std::atomic<int> released{0};
+  std::shared_ptr<void> buffer = MakeBuffer(&released);
+  deleter.Delete(buffer, /*size_bytes=*/100);
+  deleter.Flush();
+  EXPECT_EQ(released, 0);
+  buffer.reset();
+  EXPECT_EQ(released, 1);
+}
+
+TEST(BufferDeleterTest, WaitsOverThePendingLimit) {
+  BufferDeleter deleter(/*max_pending_bytes=*/150);
+  std::atomic<int> released{0};
+  deleter.Delete(MakeBuffer(&released), /*size_bytes=*/100);
+  // Goes over the limit, so the pending buffers are released when it returns.
+  deleter.Delete(MakeBuffer(&released), /*size_bytes=*/100);
+  EXPECT_EQ(released, 2);
+  EXPECT_EQ(deleter.pending_bytes(), 0);
+}
+
+TEST(BufferDeleterTest, ReleasesThePendingBuffersOnDestruction) {
+  std::atomic<int> released{0};
+  {
+    BufferDeleter deleter(/*max_pending_bytes=*/1 << 20);
+    for (int i = 0; i < 10; ++i) {
+      deleter.Delete(MakeBuffer(&released), /*size_bytes=*/100);
+    }
+  }
+  EXPECT_EQ(released, 10);
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
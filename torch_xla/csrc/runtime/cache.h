@@ -1,17 +1,29 @@
 #ifndef XLA_CLIENT_CACHE_H_
 #define XLA_CLIENT_CACHE_H_
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <torch/csrc/lazy/core/metrics.h>
 
@@ -25,40 +37,157 @@ class AbstractCache {
  public:
   using TypePtr = std::shared_ptr<T>;
   virtual TypePtr Add(K key, TypePtr object) = 0;
+  // Same as Add(), but replaces the existing object, if any.
+  virtual TypePtr Replace(K key, TypePtr object) = 0;
   virtual TypePtr Get(const K& key) = 0;
   virtual size_t GetNumInMemoryCachedGraph() const = 0;
   virtual bool Erase(const K& key) = 0;
   virtual void Clear() = 0;
+  // Advances the step clock of the cache, and unloads the objects which were
+  // not used during the last `idle_steps` steps. Returns the number of
+  // unloaded objects.
+  virtual size_t UnloadIdle(size_t idle_steps) = 0;
+};
+
+// Cost hints an object gives to the Cache eviction policy and capacity limits.
+struct CacheCost {
+  // Relative cost of re-creating the object once evicted, e.g. the time it
+  // takes to compile it.
+  double cost = 1.0;
+  // Size of the object in bytes. Zero if unknown.
+  size_t size_bytes = 0;
+};
+
+// Decides which object a Cache evicts once it grows beyond its limits. Objects
+// are identified by the address of their key, which is stable for as long as
+// the object is tracked by the cache. Calls are serialized by the cache.
+template <typename K>
+class EvictionPolicy {
+ public:
+  virtual ~EvictionPolicy() = default;
+
+  virtual void OnAdd(const K* key, const CacheCost& cost) = 0;
+
+  virtual void OnAccess(const K* key) = 0;
+
+  virtual void OnErase(const K* key) = 0;
+
+  // Stops tracking the next object to evict, and returns its key. Only called
+  // when at least one object is tracked.
+  virtual const K* Evict() = 0;
+
+  virtual void Clear() = 0;
+};
+
+// GreedyDual-Size eviction policy. Each object gets a priority of L + cost/size
+// when added or accessed, where L is the priority of the last evicted object,
+// and the object with the lowest priority is evicted first. Cheap and large
+// objects go first, while expensive ones survive a long sequence of one-off
+// objects; raising L ages objects which are no longer accessed.
+template <typename K>
+class GreedyDualSizeEvictionPolicy : public EvictionPolicy<K> {
+ public:
+  void OnAdd(const K* key, const CacheCost& cost) override {
+    Entry& entry = entries_[key];
+    entry.credit =
+        cost.cost / static_cast<double>(std::max<size_t>(cost.size_bytes, 1));
+    Enqueue(key, &entry);
+  }
+
+  void OnAccess(const K* key) override {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      queue_.erase(it->second.position);
+      Enqueue(key, &it->second);
+    }
+  }
+
+  void OnErase(const K* key) override {
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      queue_.erase(it->second.position);
+      entries_.erase(it);
+    }
+  }
+
+  const K* Evict() override {
+    auto it = queue_.begin();
+    const K* key = it->second;
+    inflation_ = it->first.first;
+    queue_.erase(it);
+    entries_.erase(key);
+    return key;
+  }
+
+  void Clear() override {
+    queue_.clear();
+    entries_.clear();
+    inflation_ = 0.0;
+  }
+
+ private:
+  // Ordered by (priority, insertion sequence), to break ties by recency.
+  using Queue = std::map<std::pair<double, uint64_t>, const K*>;
+
+  struct Entry {
+    double credit = 0.0;
+    typename Queue::iterator position;
+  };
+
+  void Enqueue(const K* key, Entry* entry) {
+    entry->position =
+        queue_.emplace(std::make_pair(inflation_ + entry->credit, sequence_++),
+                       key)
+            .first;
+  }
+
+  Queue queue_;
+  std::unordered_map<const K*, Entry> entries_;
+  double inflation_ = 0.0;
+  uint64_t sequence_ = 0;
 };
 
 // Generic key and object cache with LRU expiration policy. The objects of type
 // T will be stored as std::shared_ptr<T> and taken and returned as such, by the
 // cache API.
+// The cache is bounded by its number of objects, and optionally by the total
+// size in bytes reported by `cost_fn`. A custom EvictionPolicy can be given to
+// replace LRU, in which case `cost_fn` provides its cost hints.
 template <typename K, typename T, typename H = std::hash<K>,
           typename E = std::equal_to<K>>
 class Cache : public AbstractCache<K, T, H, E> {
  public:
   using TypePtr = std::shared_ptr<T>;
   using Element = std::pair<K, TypePtr>;
-  explicit Cache(size_t max_size) : max_size_(max_size) {}
+  using CostFn = std::function<CacheCost(const T&)>;
+
+  explicit Cache(size_t max_size, size_t max_bytes = 0,
+                 std::unique_ptr<EvictionPolicy<K>> policy = nullptr,
+                 CostFn cost_fn = nullptr)
+      : max_size_(max_size),
+        max_bytes_(max_bytes),
+        policy_(std::move(policy)),
+        cost_fn_(std::move(cost_fn)) {}
 
   // Adds an object to the cache, unless it already exists. If the cache grows
-  // beyond the limit set during construction, the oldest used object will be
-  // removed from the cache.
+  // beyond the limits set during construction, objects are evicted according
+  // to the eviction policy, the oldest used one first by default. The byte
+  // limit never evicts the last object left.
   TypePtr Add(K key, TypePtr object) override {
     std::lock_guard<std::mutex> slock(lock_);
-    element_list_.emplace_front(Element(std::move(key), std::move(object)));
-    auto it = element_list_.begin();
-    auto emplace_result = element_map_.emplace(&it->first, it);
-    if (!emplace_result.second) {
-      element_list_.erase(it);
-      DoLRU(emplace_result.first->second);
-    } else if (element_list_.size() > max_size_) {
-      Element* last = &element_list_.back();
-      element_map_.erase(&last->first);
-      element_list_.pop_back();
+    return AddLocked(std::move(key), std::move(object));
+  }
+
+  TypePtr Replace(K key, TypePtr object) override {
+    std::lock_guard<std::mutex> slock(lock_);
+    auto it = element_map_.find(&key);
+    if (it != element_map_.end()) {
+      if (policy_ != nullptr) {
+        policy_->OnErase(it->first);
+      }
+      EraseElement(it);
     }
-    return emplace_result.first->second->second;
+    return AddLocked(std::move(key), std::move(object));
   }
 
   // Retrieves the existing object if it exists. If it does, it's position in
@@ -71,23 +200,36 @@ class Cache : public AbstractCache<K, T, H, E> {
     if (it == element_map_.end()) {
       return nullptr;
     }
-    DoLRU(it->second);
-    return it->second->second;
+    Touch(it->second.it);
+    it->second.last_step = step_;
+    return it->second.it->second;
+  }
+
+  // Returns whether an object with the specified key is in the cache, without
+  // counting as a use of it.
+  bool Contains(const K& key) {
+    std::lock_guard<std::mutex> slock(lock_);
+    return element_map_.find(&key) != element_map_.end();
   }
 
   size_t GetNumInMemoryCachedGraph() const override {
     return element_list_.size();
   }
 
+  // Returns the total size in bytes of the cached objects, as reported by the
+  // cost function.
+  size_t GetNumInMemoryCachedBytes() const { return total_bytes_; }
+
   bool Erase(const K& key) override {
     std::lock_guard<std::mutex> slock(lock_);
     auto it = element_map_.find(&key);
     if (it == element_map_.end()) {
       return false;
     }
-    auto lit = it->second;
-    element_map_.erase(it);
-    element_list_.erase(lit);
+    if (policy_ != nullptr) {
+      policy_->OnErase(it->first);
+    }
+    EraseElement(it);
     return true;
   }
 
@@ -95,11 +237,41 @@ class Cache : public AbstractCache<K, T, H, E> {
     std::lock_guard<std::mutex> slock(lock_);
     element_map_.clear();
     element_list_.clear();
+    total_bytes_ = 0;
+    if (policy_ != nullptr) {
+      policy_->Clear();
+    }
+  }
+
+  // The objects are dropped, as this cache has nowhere else to keep them.
+  size_t UnloadIdle(size_t idle_steps) override {
+    std::lock_guard<std::mutex> slock(lock_);
+    ++step_;
+    size_t unloaded = 0;
+    for (auto it = element_map_.begin(); it != element_map_.end();) {
+      auto next = std::next(it);
+      if (step_ - it->second.last_step > idle_steps) {
+        if (policy_ != nullptr) {
+          policy_->OnErase(it->first);
+        }
+        EraseElement(it);
+        ++unloaded;
+      }
+      it = next;
+    }
+    return unloaded;
   }
 
  private:
   using ElementList = std::list<Element>;
 
+  struct ElementRef {
+    typename ElementList::iterator it;
+    size_t size_bytes = 0;
+    // The step clock when the object was last added or looked up.
+    uint64_t last_step = 0;
+  };
+
   struct Hasher {
     size_t operator()(const K* key) const { return hasher(*key); }
 
@@ -115,19 +287,346 @@ class Cache : public AbstractCache<K, T, H, E> {
   };
 
   using ElementMap =
-      std::unordered_map<const K*, typename ElementList::iterator, Hasher,
-                         Equaler>;
+      std::unordered_map<const K*, ElementRef, Hasher, Equaler>;
 
   void DoLRU(typename ElementList::iterator it) {
     element_list_.splice(element_list_.begin(), element_list_, it);
   }
 
+  void Touch(typename ElementList::iterator it) {
+    if (policy_ != nullptr) {
+      policy_->OnAccess(&it->first);
+    } else {
+      DoLRU(it);
+    }
+  }
+
+  TypePtr AddLocked(K key, TypePtr object) {
+    element_list_.emplace_front(Element(std::move(key), std::move(object)));
+    auto it = element_list_.begin();
+    auto emplace_result =
+        element_map_.emplace(&it->first, ElementRef{it, 0, step_});
+    if (!emplace_result.second) {
+      element_list_.erase(it);
+      Touch(emplace_result.first->second.it);
+      emplace_result.first->second.last_step = step_;
+      return emplace_result.first->second.it->second;
+    }
+    CacheCost cost = cost_fn_ ? cost_fn_(*it->second) : CacheCost();
+    emplace_result.first->second.size_bytes = cost.size_bytes;
+    total_bytes_ += cost.size_bytes;
+    if (policy_ != nullptr) {
+      policy_->OnAdd(&it->first, cost);
+    }
+    // The object might be evicted right away if it is the best candidate.
+    TypePtr result = it->second;
+    EvictOverCapacity();
+    return result;
+  }
+
+  void EraseElement(typename ElementMap::iterator it) {
+    total_bytes_ -= it->second.size_bytes;
+    auto lit = it->second.it;
+    element_map_.erase(it);
+    element_list_.erase(lit);
+  }
+
+  void EvictOverCapacity() {
+    while (element_list_.size() > max_size_ ||
+           (max_bytes_ > 0 && total_bytes_ > max_bytes_ &&
+            element_list_.size() > 1)) {
+      const K* key =
+          policy_ != nullptr ? policy_->Evict() : &element_list_.back().first;
+      EraseElement(element_map_.find(key));
+    }
+  }
+
   std::mutex lock_;
   size_t max_size_ = 0;
+  size_t max_bytes_ = 0;
+  size_t total_bytes_ = 0;
+  uint64_t step_ = 0;
+  std::unique_ptr<EvictionPolicy<K>> policy_;
+  CostFn cost_fn_;
   ElementList element_list_;
   ElementMap element_map_;
 };
 
+// Metadata tracked by the persistent cache index for every stored entry.
+struct CacheIndexEntry {
+  size_t size_bytes = 0;
+  // Cost hint of the entry, as given by the cache cost function.
+  double cost = 0.0;
+  // Last time the entry was written or loaded, in nanoseconds since epoch.
+  int64_t last_access_ns = 0;
+};
+
+// Backend storing the serialized entries of a PersistentCache by name. Calls
+// are serialized by the owning cache.
+class CacheStorage {
+ public:
+  virtual ~CacheStorage() = default;
+
+  virtual bool Contains(const std::string& name) = 0;
+
+  // Returns the serialized entry, or std::nullopt if it is not stored.
+  virtual std::optional<std::string> Read(const std::string& name) = 0;
+
+  // Stores the entry, unless the storage is readonly.
+  virtual void Write(const std::string& name, const std::string& data,
+                     double cost) = 0;
+
+  virtual bool Remove(const std::string& name) = 0;
+
+  // Removes all the entries, unless the storage is readonly.
+  virtual void Clear() = 0;
+
+  // Returns the entries known to the storage index.
+  virtual std::vector<std::pair<std::string, CacheIndexEntry>> List()
+      const = 0;
+};
+
+// Stores the serialized entries of a PersistentCache as files of a local
+// directory. Reads are memory mapped, and writes go to a temporary file which
+// is then atomically renamed, so that readers never observe a truncated entry,
+// even with concurrent writers sharing the directory.
+// An append-only index of the entries is kept in the directory, so that the
+// stored entries can be listed at startup and lookups of indexed entries don't
+// need a stat() call. Entries written by other processes after the index was
+// loaded are still found, falling back to stat().
+class DiskCacheStorage : public CacheStorage {
+ public:
+  static constexpr char kIndexFileName[] = "index";
+
+  DiskCacheStorage(std::filesystem::path dir, bool readonly)
+      : dir_(std::move(dir)), readonly_(readonly) {
+    std::filesystem::create_directories(dir_);
+    LoadIndex();
+  }
+
+  bool Contains(const std::string& name) override {
+    if (index_.count(name) > 0) {
+      return true;
+    }
+    struct stat buffer;
+    if (stat((dir_ / name).c_str(), &buffer) != 0) {
+      return false;
+    }
+    index_[name].size_bytes = buffer.st_size;
+    return true;
+  }
+
+  std::optional<std::string> Read(const std::string& name) override {
+    int fd = open((dir_ / name).c_str(), O_RDONLY);
+    if (fd < 0) {
+      index_.erase(name);
+      return std::nullopt;
+    }
+    struct stat buffer;
+    std::optional<std::string> data;
+    if (fstat(fd, &buffer) == 0) {
+      size_t size = buffer.st_size;
+      void* mapped =
+          size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                   : nullptr;
+      if (mapped != MAP_FAILED) {
+        data.emplace(static_cast<const char*>(mapped), size);
+        if (mapped != nullptr) {
+          munmap(mapped, size);
+        }
+      }
+    }
+    close(fd);
+    if (data) {
+      CacheIndexEntry& entry = index_[name];
+      entry.size_bytes = data->size();
+      entry.last_access_ns = NowNs();
+      AppendToIndex(name, entry);
+    }
+    return data;
+  }
+
+  void Write(const std::string& name, const std::string& data,
+             double cost) override {
+    if (readonly_) {
+      return;
+    }
+    std::filesystem::path path = dir_ / name;
+    std::filesystem::path tmp_path = TempPath(path);
+    {
+      std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+      out.write(data.data(), data.size());
+      if (!out.good()) {
+        out.close();
+        std::filesystem::remove(tmp_path);
+        return;
+      }
+    }
+    std::filesystem::rename(tmp_path, path);
+    CacheIndexEntry& entry = index_[name];
+    entry.size_bytes = data.size();
+    entry.cost = cost;
+    entry.last_access_ns = NowNs();
+    AppendToIndex(name, entry);
+  }
+
+  bool Remove(const std::string& name) override {
+    index_.erase(name);
+    if (readonly_ || !std::filesystem::remove(dir_ / name)) {
+      return false;
+    }
+    AppendToIndex(name, std::nullopt);
+    return true;
+  }
+
+  void Clear() override {
+    index_.clear();
+    if (!readonly_) {
+      std::filesystem::remove_all(dir_);
+      std::filesystem::create_directories(dir_);
+    }
+  }
+
+  std::vector<std::pair<std::string, CacheIndexEntry>> List() const override {
+    return {index_.begin(), index_.end()};
+  }
+
+ private:
+  static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+  static std::filesystem::path TempPath(const std::filesystem::path& path) {
+    static std::atomic<uint64_t> counter(0);
+    std::stringstream ss;
+    ss << path.string() << ".tmp." << getpid() << "." << counter++;
+    return ss.str();
+  }
+
+  // The index is a log of "+ <name> <size_bytes> <cost> <last_access_ns>" and
+  // "- <name>" records, where later records override the earlier ones. It is
+  // compacted when loaded.
+  void LoadIndex() {
+    std::ifstream in(dir_ / kIndexFileName);
+    std::string line;
+    while (std::getline(in, line)) {
+      std::istringstream record(line);
+      char op;
+      std::string name;
+      if (!(record >> op >> name)) {
+        continue;
+      }
+      if (op == '-') {
+        index_.erase(name);
+        continue;
+      }
+      CacheIndexEntry entry;
+      if (op == '+' && record >> entry.size_bytes >> entry.cost >>
+                           entry.last_access_ns) {
+        index_[name] = entry;
+      }
+    }
+    in.close();
+    if (readonly_) {
+      return;
+    }
+    std::filesystem::path path = dir_ / kIndexFileName;
+    std::filesystem::path tmp_path = TempPath(path);
+    {
+      std::ofstream out(tmp_path, std::ios::trunc);
+      for (const auto& [entry_name, entry] : index_) {
+        WriteRecord(out, entry_name, entry);
+      }
+    }
+    std::filesystem::rename(tmp_path, path);
+  }
+
+  void AppendToIndex(const std::string& name,
+                     const std::optional<CacheIndexEntry>& entry) {
+    if (readonly_) {
+      return;
+    }
+    std::ofstream out(dir_ / kIndexFileName, std::ios::app);
+    WriteRecord(out, name, entry);
+  }
+
+  static void WriteRecord(std::ostream& out, const std::string& name,
+                          const std::optional<CacheIndexEntry>& entry) {
+    // Records are flushed one at a time, so that appends of concurrent writers
+    // don't interleave.
+    std::stringstream ss;
+    if (entry) {
+      ss << "+ " << name << " " << entry->size_bytes << " " << entry->cost
+         << " " << entry->last_access_ns << "\n";
+    } else {
+      ss << "- " << name << "\n";
+    }
+    out << ss.str() << std::flush;
+  }
+
+  std::filesystem::path dir_;
+  const bool readonly_;
+  std::unordered_map<std::string, CacheIndexEntry> index_;
+};
+
+// Stores the serialized entries of a PersistentCache in host memory, for the
+// caches which only persist them across the unloading of their objects.
+class HostMemoryCacheStorage : public CacheStorage {
+ public:
+  bool Contains(const std::string& name) override {
+    return entries_.count(name) > 0;
+  }
+
+  std::optional<std::string> Read(const std::string& name) override {
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+      return std::nullopt;
+    }
+    it->second.index.last_access_ns = NowNs();
+    return it->second.data;
+  }
+
+  void Write(const std::string& name, const std::string& data,
+             double cost) override {
+    Entry& entry = entries_[name];
+    entry.data = data;
+    entry.index.size_bytes = data.size();
+    entry.index.cost = cost;
+    entry.index.last_access_ns = NowNs();
+  }
+
+  bool Remove(const std::string& name) override {
+    return entries_.erase(name) > 0;
+  }
+
+  void Clear() override { entries_.clear(); }
+
+  std::vector<std::pair<std::string, CacheIndexEntry>> List() const override {
+    std::vector<std::pair<std::string, CacheIndexEntry>> entries;
+    entries.reserve(entries_.size());
+    for (const auto& [name, entry] : entries_) {
+      entries.emplace_back(name, entry.index);
+    }
+    return entries;
+  }
+
+ private:
+  struct Entry {
+    std::string data;
+    CacheIndexEntry index;
+  };
+
+  static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+  }
+
+  std::unordered_map<std::string, Entry> entries_;
+};
+
 // A persistent cache which serializes values to disk. This wraps a Cache
 // instance, so values will only be read from disk once and subsequent reads
 // will go through the wrapped Cache.
@@ -140,14 +639,33 @@ class PersistentCache : public AbstractCache<K, T, H, E> {
   explicit PersistentCache(
       int kMaxMemoryCacheSize, std::string cache_dir, bool readonly_storage,
       std::function<std::string(const TypePtr&)> serialize,
-      std::function<TypePtr(const std::string&)> deserialize)
-      : memory_cache_(kMaxMemoryCacheSize),
-        cache_dir_(cache_dir),
+      std::function<TypePtr(const std::string&)> deserialize,
+      size_t max_memory_cache_bytes = 0,
+      std::unique_ptr<EvictionPolicy<K>> policy = nullptr,
+      typename Cache<K, T, H, E>::CostFn cost_fn = nullptr)
+      : PersistentCache(kMaxMemoryCacheSize,
+                        std::make_unique<DiskCacheStorage>(cache_dir,
+                                                           readonly_storage),
+                        readonly_storage, std::move(serialize),
+                        std::move(deserialize), max_memory_cache_bytes,
+                        std::move(policy), std::move(cost_fn)) {}
+
+  // Same as above, but stores the serialized values in `storage`.
+  explicit PersistentCache(
+      int kMaxMemoryCacheSize, std::unique_ptr<CacheStorage> storage,
+      bool readonly_storage,
+      std::function<std::string(const TypePtr&)> serialize,
+      std::function<TypePtr(const std::string&)> deserialize,
+      size_t max_memory_cache_bytes = 0,
+      std::unique_ptr<EvictionPolicy<K>> policy = nullptr,
+      typename Cache<K, T, H, E>::CostFn cost_fn = nullptr)
+      : memory_cache_(kMaxMemoryCacheSize, max_memory_cache_bytes,
+                      std::move(policy), cost_fn),
+        storage_(std::move(storage)),
         readonly_storage_(readonly_storage),
-        serialize_(serialize),
-        deserialize_(deserialize) {
-    std::filesystem::create_directories(cache_dir);
-  }
+        serialize_(std::move(serialize)),
+        deserialize_(std::move(deserialize)),
+        cost_fn_(std::move(cost_fn)) {}
 
   // Add the value to the persistent cache. This only writes to disk if no
   // existing value is tracked to avoid unnecessary serialization overhead.
@@ -155,96 +673,232 @@ class PersistentCache : public AbstractCache<K, T, H, E> {
   // incur deserialization.
   // If the cache is readonly, nothing is written to disk.
   TypePtr Add(K key, TypePtr obj) override {
-    std::lock_guard<std::mutex> slock(lock_);
-    std::string path = GetPath(key);
-    if (!Exists(path) && !readonly_storage_) {
-      std::ofstream out(path, std::ios::binary);
-      out << serialize_(obj);
+    std::string name = GetName(key);
+    bool stored = readonly_storage_;
+    if (!stored) {
+      std::lock_guard<std::mutex> slock(storage_lock_);
+      stored = storage_->Contains(name);
+    }
+    if (!stored) {
+      double cost = cost_fn_ ? cost_fn_(*obj).cost : CacheCost().cost;
+      std::string serialization = serialize_(obj);
+      std::lock_guard<std::mutex> slock(storage_lock_);
+      storage_->Write(name, serialization, cost);
     }
     return memory_cache_.Add(key, obj);
   }
 
+  // Same as Add(), but overwrites the stored value, unless the cache is
+  // readonly, and the one tracked in memory.
+  TypePtr Replace(K key, TypePtr obj) override {
+    std::string name = GetName(key);
+    if (!readonly_storage_) {
+      double cost = cost_fn_ ? cost_fn_(*obj).cost : CacheCost().cost;
+      std::string serialization = serialize_(obj);
+      std::lock_guard<std::mutex> slock(storage_lock_);
+      storage_->Write(name, serialization, cost);
+    }
+    {
+      std::lock_guard<std::mutex> slock(lock_);
+      prefetched_.erase(name);
+    }
+    return memory_cache_.Replace(key, obj);
+  }
+
   // Get the TypePtr associated with the key. This method will first check
   // if the key is tracked in memory, and if not it will check for a persisted
   // version on disk.
+  // The deserialization does not hold any lock, so lookups of other keys are
+  // not blocked by it.
   TypePtr Get(const K& key) override {
-    std::lock_guard<std::mutex> slock(lock_);
     TypePtr mem = memory_cache_.Get(key);
     if (mem) {
       return mem;
     }
-
-    std::string path = GetPath(key);
-    if (!Exists(path)) {
-      TORCH_LAZY_COUNTER("PersistentCacheMiss", 1);
-      return nullptr;
-    }
-    TORCH_LAZY_TIMED("PersistentCacheLoad");
-    std::stringstream ss;
-    std::ifstream in(path, std::ios::binary);
-    ss << in.rdbuf();
-    std::string serialization = ss.str();
-
-    TypePtr val = deserialize_(serialization);
+    TypePtr val = Load(GetName(key), /*prefetch=*/false);
     if (!val) {
-      TORCH_LAZY_COUNTER("PersistentCacheDeserializeFailure", 1);
-      // Remove the serialized value from disk to allow a new value to be stored
-      EraseImpl(key);
       return nullptr;
     }
-    TORCH_LAZY_COUNTER("PersistentCacheHit", 1);
     // Make sure the memory_cache_ tracks the value to prevent multiple loads
     return memory_cache_.Add(key, val);
   }
 
+  // Loads and deserializes the given stored entries ahead of their first Get(),
+  // which will then find them in memory. Entries which fail to load are
+  // skipped. Meant to be run on a background thread.
+  void Prefetch(const std::vector<std::string>& names) {
+    TORCH_LAZY_TIMED("PersistentCachePrefetch");
+    for (const std::string& name : names) {
+      try {
+        if (Load(name, /*prefetch=*/true) != nullptr) {
+          TORCH_LAZY_COUNTER("PersistentCachePrefetched", 1);
+        }
+      } catch (...) {
+        TORCH_LAZY_COUNTER("PersistentCachePrefetchFailure", 1);
+      }
+    }
+  }
+
+  // Prefetches the stored entry of `key`, unless it is in memory already.
+  void PrefetchKey(const K& key) {
+    if (!memory_cache_.Contains(key)) {
+      Prefetch({GetName(key)});
+    }
+  }
+
+  // Returns the names of the `n` most recently written or loaded stored
+  // entries, most recent first.
+  std::vector<std::string> GetMostRecentlyUsedNames(size_t n) {
+    std::vector<std::pair<std::string, CacheIndexEntry>> entries =
+        ListStoredEntries();
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) {
+                return a.second.last_access_ns > b.second.last_access_ns;
+              });
+    std::vector<std::string> names;
+    for (size_t i = 0; i < std::min(n, entries.size()); ++i) {
+      names.push_back(entries[i].first);
+    }
+    return names;
+  }
+
   size_t GetNumInMemoryCachedGraph() const override {
     return memory_cache_.GetNumInMemoryCachedGraph();
   }
 
   void Clear() override {
     std::lock_guard<std::mutex> slock(lock_);
+    prefetched_.clear();
     memory_cache_.Clear();
-    // Delete and recreate the cache directory on disk.
-    if (!readonly_storage_) {
-      std::filesystem::remove_all(cache_dir_);
-      std::filesystem::create_directories(cache_dir_);
-    }
+    std::lock_guard<std::mutex> storage_slock(storage_lock_);
+    storage_->Clear();
   }
 
   bool Erase(const K& key) override {
-    std::lock_guard<std::mutex> slock(lock_);
-    return EraseImpl(key);
+    std::string name = GetName(key);
+    {
+      std::lock_guard<std::mutex> slock(lock_);
+      prefetched_.erase(name);
+    }
+    memory_cache_.Erase(key);
+    std::lock_guard<std::mutex> slock(storage_lock_);
+    return storage_->Remove(name);
+  }
+
+  // The unloaded objects are loaded again from the storage on their next
+  // Get(), unless the storage is readonly and did not have them.
+  size_t UnloadIdle(size_t idle_steps) override {
+    return memory_cache_.UnloadIdle(idle_steps);
   }
 
   Cache<K, T, H, E>& GetMemoryCache() { return memory_cache_; }
 
+  // Returns the entries of the storage index, keyed by their name.
+  std::vector<std::pair<std::string, CacheIndexEntry>> ListStoredEntries() {
+    std::lock_guard<std::mutex> slock(storage_lock_);
+    return storage_->List();
+  }
+
  private:
-  std::string GetPath(K key) {
+  std::string GetName(const K& key) {
     std::stringstream ss;
     ss << key;
-    return cache_dir_ / ss.str();
+    return ss.str();
   }
 
-  bool Exists(std::string path) {
-    struct stat buffer;
-    return stat(path.c_str(), &buffer) == 0;
+  // Returns the deserialized entry, or nullptr if it is not stored. Concurrent
+  // loads of the same entry share a single deserialization. Prefetched
+  // entries are held until their first non-prefetch load.
+  TypePtr Load(const std::string& name, bool prefetch) {
+    std::promise<TypePtr> promise;
+    {
+      std::unique_lock<std::mutex> slock(lock_);
+      auto prefetched_it = prefetched_.find(name);
+      if (prefetched_it != prefetched_.end()) {
+        TypePtr val = prefetched_it->second;
+        if (!prefetch) {
+          TORCH_LAZY_COUNTER("PersistentCachePrefetchHit", 1);
+          prefetched_.erase(prefetched_it);
+        }
+        return val;
+      }
+      auto loading_it = loading_.find(name);
+      if (loading_it != loading_.end()) {
+        std::shared_future<TypePtr> loading = loading_it->second;
+        slock.unlock();
+        TypePtr val = loading.get();
+        if (!prefetch) {
+          slock.lock();
+          prefetched_.erase(name);
+        }
+        return val;
+      }
+      loading_.emplace(name, promise.get_future().share());
+    }
+    TypePtr val;
+    try {
+      val = LoadFromStorage(name);
+    } catch (...) {
+      std::lock_guard<std::mutex> slock(lock_);
+      loading_.erase(name);
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+    {
+      std::lock_guard<std::mutex> slock(lock_);
+      loading_.erase(name);
+      if (prefetch && val != nullptr) {
+        prefetched_.emplace(name, val);
+      }
+    }
+    promise.set_value(val);
+    return val;
   }
 
-  bool EraseImpl(const K& key) {
-    memory_cache_.Erase(key);
-    return !readonly_storage_ && std::filesystem::remove(GetPath(key));
+  TypePtr LoadFromStorage(const std::string& name) {
+    std::unique_lock<std::mutex> storage_slock(storage_lock_);
+    if (!storage_->Contains(name)) {
+      TORCH_LAZY_COUNTER("PersistentCacheMiss", 1);
+      return nullptr;
+    }
+    TORCH_LAZY_TIMED("PersistentCacheLoad");
+    std::optional<std::string> serialization = storage_->Read(name);
+    storage_slock.unlock();
+    if (!serialization) {
+      TORCH_LAZY_COUNTER("PersistentCacheMiss", 1);
+      return nullptr;
+    }
+
+    TypePtr val = deserialize_(*serialization);
+    if (!val) {
+      TORCH_LAZY_COUNTER("PersistentCacheDeserializeFailure", 1);
+      // Remove the serialized value from disk to allow a new value to be stored
+      std::lock_guard<std::mutex> slock(storage_lock_);
+      storage_->Remove(name);
+      return nullptr;
+    }
+    TORCH_LAZY_COUNTER("PersistentCacheHit", 1);
+    return val;
   }
 
   Cache<K, T, H, E> memory_cache_;
-  std::function<std::string(const TypePtr&)> serialize_;
-  std::function<TypePtr(const std::string&)> deserialize_;
-  std::filesystem::path cache_dir_;
+  std::unique_ptr<CacheStorage> storage_;
+  // Guards prefetched_ and loading_.
   std::mutex lock_;
+  // Guards storage_, which is not thread safe.
+  std::mutex storage_lock_;
+  // Prefetched entries which have not been looked up yet, by name.
+  std::unordered_map<std::string, TypePtr> prefetched_;
+  // Entries being loaded from the storage, by name.
+  std::unordered_map<std::string, std::shared_future<TypePtr>> loading_;
   // readonly_storage_ controls whether the cache will treat the persistence
   // layer as readonly. When set, operations which mutate the cache, such as
   // Erase and Add, are not written to disk, but they are still applied to the
   // in-memory cache.
   const bool readonly_storage_;
+  std::function<std::string(const TypePtr&)> serialize_;
+  std::function<TypePtr(const std::string&)> deserialize_;
+  typename Cache<K, T, H, E>::CostFn cost_fn_;
 };
 
 }  // namespace util
@@ -0,0 +1,161 @@
+#include "torch_xla/csrc/runtime/cache_codec.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace util {
+namespace {
+
+constexpr char kMagic[4] = {'P', 'T', 'X', 'C'};
+constexpr uint8_t kVersion = 1;
+
+// Fixed size header prefixed to every encoded entry. Integers are stored in
+// host byte order, cache entries are not portable across architectures anyway.
+struct EntryHeader {
+  char magic[4];
+  uint8_t version;
+  CacheCodec codec;
+  uint16_t flags;
+  uint64_t uncompressed_size;
+};
+static_assert(sizeof(EntryHeader) == 16, "Unexpected EntryHeader padding");
+
+// zlib counts bytes with 32-bit integers, so larger buffers are fed in chunks.
+constexpr size_t kMaxZlibChunk = std::numeric_limits<uInt>::max();
+
+std::string ZlibCompress(std::string_view data, int level, std::string prefix) {
+  z_stream stream = {};
+  deflateInit(&stream,
+              std::clamp(level, Z_DEFAULT_COMPRESSION, Z_BEST_COMPRESSION));
+  std::string output = std::move(prefix);
+  size_t offset = output.size();
+  output.resize(offset + deflateBound(&stream, data.size()));
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  size_t remaining_in = data.size();
+  int flush = Z_NO_FLUSH;
+  int ret = Z_OK;
+  while (ret != Z_STREAM_END) {
+    if (stream.avail_in == 0) {
+      stream.avail_in = std::min(remaining_in, kMaxZlibChunk);
+      remaining_in -= stream.avail_in;
+      flush = remaining_in == 0 ? Z_FINISH : Z_NO_FLUSH;
+    }
+    size_t produced = offset + stream.total_out;
+    if (produced == output.size()) {
+      output.resize(output.size() * 2);
+    }
+    stream.next_out = reinterpret_cast<Bytef*>(&output[produced]);
+    stream.avail_out = std::min(output.size() - produced, kMaxZlibChunk);
+    ret = deflate(&stream, flush);
+  }
+  output.resize(offset + stream.total_out);
+  deflateEnd(&stream);
+  return output;
+}
+
+absl::Status ZlibDecompress(std::string_view data, std::string* output) {
+  z_stream stream = {};
+  if (inflateInit(&stream) != Z_OK) {
+    return absl::InternalError("Failed to initialize zlib");
+  }
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  size_t remaining_in = data.size();
+  int ret = Z_OK;
+  while (ret == Z_OK) {
+    if (stream.avail_in == 0) {
+      stream.avail_in = std::min(remaining_in, kMaxZlibChunk);
+      remaining_in -= stream.avail_in;
+    }
+    size_t produced = stream.total_out;
+    stream.next_out = reinterpret_cast<Bytef*>(output->data() + produced);
+    stream.avail_out = std::min(output->size() - produced, kMaxZlibChunk);
+    ret = inflate(&stream, Z_NO_FLUSH);
+    if (ret == Z_BUF_ERROR && stream.avail_out > 0 && remaining_in > 0) {
+      ret = Z_OK;
+    }
+  }
+  size_t produced = stream.total_out;
+  inflateEnd(&stream);
+  if (ret != Z_STREAM_END || produced != output->size()) {
+    return absl::DataLossError(
+        absl::StrCat("Corrupted compressed cache entry, zlib error ", ret));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<CacheCodec> ParseCacheCodec(std::string_view name) {
+  if (name == "none") {
+    return CacheCodec::kNone;
+  }
+  if (name == "zlib") {
+    return CacheCodec::kZlib;
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("Unknown persistent cache codec: ", std::string(name)));
+}
+
+std::string EncodeCacheEntry(std::string_view data, CacheCodec codec,
+                             int level, uint16_t flags) {
+  EntryHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.codec = codec;
+  header.flags = flags;
+  header.uncompressed_size = data.size();
+  std::string prefix(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (codec == CacheCodec::kZlib) {
+    return ZlibCompress(data, level, std::move(prefix));
+  }
+  return prefix.append(data);
+}
+
+absl::StatusOr<std::string> DecodeCacheEntry(std::string entry,
+                                             uint16_t* flags) {
+  if (flags != nullptr) {
+    *flags = 0;
+  }
+  EntryHeader header;
+  if (entry.size() < sizeof(header) ||
+      std::memcmp(entry.data(), kMagic, sizeof(kMagic)) != 0) {
+    return entry;
+  }
+  std::memcpy(&header, entry.data(), sizeof(header));
+  if (header.version != kVersion) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "Unsupported persistent cache entry version ", header.version));
+  }
+  if (flags != nullptr) {
+    *flags = header.flags;
+  }
+  std::string_view payload = std::string_view(entry).substr(sizeof(header));
+  switch (header.codec) {
+    case CacheCodec::kNone:
+      return std::string(payload);
+    case CacheCodec::kZlib: {
+      std::string output(header.uncompressed_size, '\0');
+      absl::Status status = ZlibDecompress(payload, &output);
+      if (!status.ok()) {
+        return status;
+      }
+      return output;
+    }
+  }
+  return absl::FailedPreconditionError(
+      absl::StrCat("Unsupported persistent cache codec ",
+                   static_cast<int>(header.codec)));
+}
+
+}  // namespace util
+}  // namespace runtime
+}  // namespace torch_xla
@@ -0,0 +1,47 @@
+#ifndef XLA_CLIENT_CACHE_CODEC_H_
+#define XLA_CLIENT_CACHE_CODEC_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "absl/status/statusor.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace util {
+
+// Compression codecs of the persistent compilation cache entries.
+enum class CacheCodec : uint8_t {
+  kNone = 0,
+  kZlib = 1,
+};
+
+// Flags of the cache entries, stored in their header.
+enum CacheEntryFlags : uint16_t {
+  // The executable was compiled with the options chosen by the compile option
+  // autotuner.
+  kCacheEntryAutotuned = 1 << 0,
+};
+
+// Parses a codec name, "none" or "zlib".
+absl::StatusOr<CacheCodec> ParseCacheCodec(std::string_view name);
+
+// Encodes a serialized cache entry with the given codec and compression level.
+// The result starts with a header holding the format version, the codec, the
+// CacheEntryFlags `flags` and the uncompressed size.
+std::string EncodeCacheEntry(std::string_view data, CacheCodec codec,
+                             int level, uint16_t flags = 0);
+
+// Decodes an entry produced by EncodeCacheEntry(), and stores its flags in
+// `flags`, if not null. The output buffer is sized from the header, and
+// decompressed into in a single pass. Entries without a header, as written
+// before the header was introduced, are returned as is, without flags.
+absl::StatusOr<std::string> DecodeCacheEntry(std::string entry,
+                                             uint16_t* flags = nullptr);
+
+}  // namespace util
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_CACHE_CODEC_H_
@@ -0,0 +1,69 @@
+#include "torch_xla/csrc/runtime/cache_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace torch_xla {
+namespace runtime {
+namespace util {
+
+TEST(CacheCodecTest, RoundTrip) {
+  std::string data;
+  for (int i = 0; i < 100000; ++i) {
+    data += std::to_string(i % 97);
+  }
+  for (CacheCodec codec : {CacheCodec::kNone, CacheCodec::kZlib}) {
+    std::string encoded = EncodeCacheEntry(data, codec, /*level=*/1);
+    absl::StatusOr<std::string> decoded = DecodeCacheEntry(encoded);
+    ASSERT_TRUE(decoded.ok()) << decoded.status();
+    EXPECT_EQ(*decoded, data);
+  }
+  EXPECT_LT(EncodeCacheEntry(data, CacheCodec::kZlib, 1).size(),
+            data.size() / 2);
+}
+
+TEST(CacheCodecTest, EmptyEntry) {
+  std::string encoded = EncodeCacheEntry("", CacheCodec::kZlib, 9);
+  absl::StatusOr<std::string> decoded = DecodeCacheEntry(encoded);
+  ASSERT_TRUE(decoded.ok()) << decoded.status();
+  EXPECT_TRUE(decoded->empty());
+}
+
+TEST(CacheCodecTest, Flags) {
+  for (CacheCodec codec : {CacheCodec::kNone, CacheCodec::kZlib}) {
+    std::string encoded = EncodeCacheEntry("executable", codec, /*level=*/1,
+                                           kCacheEntryAutotuned);
+    uint16_t flags = 0;
+    absl::StatusOr<std::string> decoded = DecodeCacheEntry(encoded, &flags);
+    ASSERT_TRUE(decoded.ok()) << decoded.status();
+    EXPECT_EQ(*decoded, "executable");
+    EXPECT_EQ(flags, kCacheEntryAutotuned);
+  }
+  uint16_t flags = kCacheEntryAutotuned;
+  ASSERT_TRUE(DecodeCacheEntry("legacy executable", &flags).ok());
+  EXPECT_EQ(flags, 0);
+}
+
+TEST(CacheCodecTest, LegacyEntryPassesThrough) {
+  absl::StatusOr<std::string> decoded = DecodeCacheEntry("legacy executable");
+  ASSERT_TRUE(decoded.ok());
+  EXPECT_EQ(*decoded, "legacy executable");
+}
+
+TEST(CacheCodecTest, CorruptedEntry) {
+  std::string encoded =
+      EncodeCacheEntry(std::string(1000, 'x'), CacheCodec::kZlib, 1);
+  encoded.resize(encoded.size() - 4);
+  EXPECT_FALSE(DecodeCacheEntry(encoded).ok());
+}
+
+TEST(CacheCodecTest, ParseCacheCodec) {
+  EXPECT_EQ(*ParseCacheCodec("none"), CacheCodec::kNone);
+  EXPECT_EQ(*ParseCacheCodec("zlib"), CacheCodec::kZlib);
+  EXPECT_FALSE(ParseCacheCodec("zstd").ok());
+}
+
+}  // namespace util
+}  // namespace runtime
+}  // namespace torch_xla
@@ -3,6 +3,8 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -38,6 +40,68 @@ TEST(UtilTest, XlaUtilCacheTest) {
   EXPECT_EQ(ptr, nullptr);
 }
 
+TEST(UtilTest, XlaUtilCacheByteLimitTest) {
+  static const int kMaxSize = 64;
+  static const size_t kMaxBytes = 10;
+  torch_xla::runtime::util::Cache<int, std::string> cache(
+      kMaxSize, kMaxBytes, /*policy=*/nullptr,
+      [](const std::string& value) {
+        return CacheCost{/*cost=*/1.0, /*size_bytes=*/value.size()};
+      });
+
+  cache.Add(0, std::make_shared<std::string>("aaaa"));
+  cache.Add(1, std::make_shared<std::string>("bbbb"));
+  EXPECT_EQ(cache.GetNumInMemoryCachedBytes(), 8);
+  // Going over the byte limit evicts the least recently used object.
+  cache.Get(0);
+  cache.Add(2, std::make_shared<std::string>("cccc"));
+  EXPECT_EQ(cache.GetNumInMemoryCachedGraph(), 2);
+  EXPECT_EQ(cache.GetNumInMemoryCachedBytes(), 8);
+  EXPECT_NE(cache.Get(0), nullptr);
+  EXPECT_EQ(cache.Get(1), nullptr);
+  EXPECT_NE(cache.Get(2), nullptr);
+
+  // An object larger than the limit is kept if it is the only one left.
+  auto ptr = cache.Add(3, std::make_shared<std::string>("dddddddddddd"));
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(cache.GetNumInMemoryCachedGraph(), 1);
+  EXPECT_NE(cache.Get(3), nullptr);
+
+  EXPECT_TRUE(cache.Erase(3));
+  EXPECT_EQ(cache.GetNumInMemoryCachedBytes(), 0);
+}
+
+TEST(UtilTest, XlaUtilCacheGreedyDualSizeTest) {
+  static const int kMaxSize = 4;
+  // The cost of each object is encoded in its value.
+  torch_xla::runtime::util::Cache<int, std::string> cache(
+      kMaxSize, /*max_bytes=*/0,
+      std::make_unique<GreedyDualSizeEvictionPolicy<int>>(),
+      [](const std::string& value) {
+        return CacheCost{/*cost=*/std::stod(value), /*size_bytes=*/1};
+      });
+
+  cache.Add(-1, std::make_shared<std::string>("1000"));
+  // A long sequence of cheap objects does not evict the expensive one.
+  for (int i = 0; i < 16; ++i) {
+    cache.Add(i, std::make_shared<std::string>("1"));
+  }
+  EXPECT_EQ(cache.GetNumInMemoryCachedGraph(), kMaxSize);
+  EXPECT_NE(cache.Get(-1), nullptr);
+  EXPECT_EQ(cache.Get(0), nullptr);
+  EXPECT_NE(cache.Get(15), nullptr);
+
+  // Among objects of the same cost, the least recently used goes first.
+  cache.Get(13);
+  cache.Add(16, std::make_shared<std::string>("1"));
+  EXPECT_NE(cache.Get(13), nullptr);
+  EXPECT_EQ(cache.Get(14), nullptr);
+
+  cache.Clear();
+  EXPECT_EQ(cache.GetNumInMemoryCachedGraph(), 0);
+  EXPECT_EQ(cache.Get(-1), nullptr);
+}
+
 TEST(UtilTest, XlaUtilPersistentCacheTest) {
   static const int kMaxSize = 64;
   auto serialize_fn = [](std::shared_ptr<std::string> value) -> std::string {
@@ -155,6 +219,195 @@ TEST(UtilTest, XlaUtilPersistentCacheTest) {
   unlink(tmpdir);
 }
 
+TEST(UtilTest, XlaUtilPersistentCacheIndexTest) {
+  static const int kMaxSize = 64;
+  auto serialize_fn = [](std::shared_ptr<std::string> value) -> std::string {
+    return *value;
+  };
+  auto deserialize_fn = [](std::string value) -> std::shared_ptr<std::string> {
+    return std::make_shared<std::string>(value);
+  };
+  char format[] = "/tmp/tmp.XXXXXX";
+  char* tmpdir = mkdtemp(format);
+  ASSERT_NE(tmpdir, nullptr);
+  auto cache = std::make_unique<PersistentCache<int, std::string>>(
+      kMaxSize, std::string(tmpdir), /*readonly=*/false, serialize_fn,
+      deserialize_fn);
+  for (int i = 0; i < 4; ++i) {
+    cache->Add(i, std::make_shared<std::string>(std::string(i + 1, 'x')));
+  }
+  EXPECT_TRUE(cache->Erase(3));
+
+  // A new cache loads the index left by the previous one.
+  cache = std::make_unique<PersistentCache<int, std::string>>(
+      kMaxSize, std::string(tmpdir), /*readonly=*/true, serialize_fn,
+      deserialize_fn);
+  auto entries = cache->ListStoredEntries();
+  std::sort(entries.begin(), entries.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+  ASSERT_EQ(entries.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(entries[i].first, std::to_string(i));
+    EXPECT_EQ(entries[i].second.size_bytes, i + 1);
+    EXPECT_GT(entries[i].second.last_access_ns, 0);
+    auto ptr = cache->Get(i);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(*ptr, std::string(i + 1, 'x'));
+  }
+  EXPECT_EQ(cache->Get(3), nullptr);
+
+  // Writes go through temporary files which must not be left behind.
+  size_t num_files = 0;
+  for (const auto& file : std::filesystem::directory_iterator(tmpdir)) {
+    EXPECT_EQ(file.path().string().find(".tmp."), std::string::npos);
+    ++num_files;
+  }
+  EXPECT_EQ(num_files, 4);
+
+  std::filesystem::remove_all(tmpdir);
+}
+
+TEST(UtilTest, XlaUtilPersistentCacheReplaceTest) {
+  static const int kMaxSize = 64;
+  auto serialize_fn = [](std::shared_ptr<std::string> value) -> std::string {
+    return *value;
+  };
+  auto deserialize_fn = [](std::string value) -> std::shared_ptr<std::string> {
+    return std::make_shared<std::string>(value);
+  };
+  char format[] = "/tmp/tmp.XXXXXX";
+  char* tmpdir = mkdtemp(format);
+  ASSERT_NE(tmpdir, nullptr);
+  auto cache = std::make_unique<PersistentCache<int, std::string>>(
+      kMaxSize, std::string(tmpdir), /*readonly=*/false, serialize_fn,
+      deserialize_fn);
+  cache->Add(0, std::make_shared<std::string>("old"));
+  // Add() keeps the existing value, Replace() does not.
+  EXPECT_EQ(*cache->Add(0, std::make_shared<std::string>("new")), "old");
+  EXPECT_EQ(*cache->Replace(0, std::make_shared<std::string>("new")), "new");
+  EXPECT_EQ(*cache->Get(0), "new");
+
+  // The replaced value is the one stored.
+  cache = std::make_unique<PersistentCache<int, std::string>>(
+      kMaxSize, std::string(tmpdir), /*readonly=*/true, serialize_fn,
+      deserialize_fn);
+  auto ptr = cache->Get(0);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(*ptr, "new");
+
+  std::filesystem::remove_all(tmpdir);
+}
+
+TEST(UtilTest, XlaUtilPersistentCachePrefetchTest) {
+  static const int kMaxSize = 64;
+  int num_deserialized = 0;
+  auto serialize_fn = [](std::shared_ptr<std::string> value) -> std::string {
+    return *value;
+  };
+  auto deserialize_fn =
+      [&](std::string value) -> std::shared_ptr<std::string> {
+    ++num_deserialized;
+    return std::make_shared<std::string>(value);
+  };
+  char format[] = "/tmp/tmp.XXXXXX";
+  char* tmpdir = mkdtemp(format);
+  ASSERT_NE(tmpdir, nullptr);
+  auto cache = std::make_unique<PersistentCache<int, std::string>>(
+      kMaxSize, std::string(tmpdir), /*readonly=*/false, serialize_fn,
+      deserialize_fn);
+  for (int i = 0; i < 4; ++i) {
+    cache->Add(i, std::make_shared<std::string>(std::to_string(i)));
+  }
+
+  cache = std::make_unique<PersistentCache<int, std::string>>(
+      kMaxSize, std::string(tmpdir), /*readonly=*/false, serialize_fn,
+      deserialize_fn);
+  std::vector<std::string> names = cache->GetMostRecentlyUsedNames(2);
+  ASSERT_EQ(names.size(), 2);
+  EXPECT_EQ(names[0], "3");
+  EXPECT_EQ(names[1], "2");
+  cache->Prefetch(names);
+  EXPECT_EQ(num_deserialized, 2);
+
+  // Prefetched entries are not deserialized again.
+  for (int i : {3, 2}) {
+    auto ptr = cache->Get(i);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_EQ(*ptr, std::to_string(i));
+  }
+  EXPECT_EQ(num_deserialized, 2);
+  ASSERT_NE(cache->Get(0), nullptr);
+  EXPECT_EQ(num_deserialized, 3);
+
+  cache->Clear();
+  std::filesystem::remove_all(tmpdir);
+}
+
+TEST(UtilTest, XlaUtilPersistentCachePrefetchKeyTest) {
+  int num_deserialized = 0;
+  auto serialize_fn = [](std::shared_ptr<std::string> value) -> std::string {
+    return *value;
+  };
+  auto deserialize_fn =
+      [&](std::string value) -> std::shared_ptr<std::string> {
+    ++num_deserialized;
+    return std::make_shared<std::string>(value);
+  };
+  PersistentCache<int, std::string> cache(
+      /*kMaxMemoryCacheSize=*/64, std::make_unique<HostMemoryCacheStorage>(),
+      /*readonly_storage=*/false, serialize_fn, deserialize_fn);
+  cache.Add(0, std::make_shared<std::string>("0"));
+  cache.Add(1, std::make_shared<std::string>("1"));
+  cache.GetMemoryCache().Erase(1);
+
+  // Only the entry which is not in memory is deserialized.
+  cache.PrefetchKey(0);
+  cache.PrefetchKey(1);
+  cache.PrefetchKey(2);
+  EXPECT_EQ(num_deserialized, 1);
+  auto ptr = cache.Get(1);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(*ptr, "1");
+  EXPECT_EQ(num_deserialized, 1);
+}
+
+TEST(UtilTest, XlaUtilCacheUnloadIdleTest) {
+  Cache<int, std::string> cache(/*max_size=*/64);
+  cache.Add(0, std::make_shared<std::string>("0"));
+  cache.Add(1, std::make_shared<std::string>("1"));
+  EXPECT_EQ(cache.UnloadIdle(/*idle_steps=*/1), 0);
+  // Only the object used during the last step stays loaded.
+  cache.Get(0);
+  EXPECT_EQ(cache.UnloadIdle(/*idle_steps=*/1), 1);
+  EXPECT_NE(cache.Get(0), nullptr);
+  EXPECT_EQ(cache.Get(1), nullptr);
+}
+
+TEST(UtilTest, XlaUtilPersistentCacheUnloadIdleTest) {
+  int num_deserialized = 0;
+  auto serialize_fn = [](std::shared_ptr<std::string> value) -> std::string {
+    return *value;
+  };
+  auto deserialize_fn =
+      [&](std::string value) -> std::shared_ptr<std::string> {
+    ++num_deserialized;
+    return std::make_shared<std::string>(value);
+  };
+  PersistentCache<int, std::string> cache(
+      /*kMaxMemoryCacheSize=*/64, std::make_unique<HostMemoryCacheStorage>(),
+      /*readonly_storage=*/false, serialize_fn, deserialize_fn);
+  cache.Add(0, std::make_shared<std::string>("0"));
+  EXPECT_EQ(cache.UnloadIdle(/*idle_steps=*/0), 1);
+  EXPECT_EQ(cache.GetNumInMemoryCachedGraph(), 0);
+
+  // The unloaded object is loaded again from its serialized form.
+  auto ptr = cache.Get(0);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(*ptr, "0");
+  EXPECT_EQ(num_deserialized, 1);
+  EXPECT_EQ(cache.GetNumInMemoryCachedGraph(), 1);
+}
+
 }  // namespace util
 }  // namespace runtime
 }  // namespace torch_xla
@@ -0,0 +1,36 @@
+#include "torch_xla/csrc/runtime/compile_option_autotuner.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace util {
+
+absl::StatusOr<std::vector<CompileOptionSet>> ParseCompileOptionCandidates(
+    std::string_view spec) {
+  std::vector<CompileOptionSet> candidates;
+  for (std::string_view set_spec :
+       absl::StrSplit(spec, ';', absl::SkipWhitespace())) {
+    CompileOptionSet options;
+    for (std::string_view option :
+         absl::StrSplit(set_spec, ',', absl::SkipWhitespace())) {
+      std::vector<std::string_view> parts =
+          absl::StrSplit(option, absl::MaxSplits('=', 1));
+      std::string_view name = absl::StripAsciiWhitespace(parts[0]);
+      if (parts.size() != 2 || name.empty()) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Invalid compile option candidate: ", std::string(option)));
+      }
+      options[std::string(name)] =
+          std::string(absl::StripAsciiWhitespace(parts[1]));
+    }
+    candidates.push_back(std::move(options));
+  }
+  return candidates;
+}
+
+}  // namespace util
+}  // namespace runtime
+}  // namespace torch_xla
@@ -0,0 +1,181 @@
+#ifndef XLA_CLIENT_COMPILE_OPTION_AUTOTUNER_H_
+#define XLA_CLIENT_COMPILE_OPTION_AUTOTUNER_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "absl/status/statusor.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace util {
+
+using CompileOptionSet = std::unordered_map<std::string, std::string>;
+
+// Parses the candidate compile option sets of the autotuner, separated by
+// semicolons, each made of comma separated name=value pairs, e.g.
+// "xla_foo=true,xla_bar=2;xla_foo=false" for two candidates.
+absl::StatusOr<std::vector<CompileOptionSet>> ParseCompileOptionCandidates(
+    std::string_view spec);
+
+// Picks, for each hot key, the fastest of the executables compiled with the
+// candidate compile option sets and the original one.
+//
+// A key turns hot after `min_executions` executions, upon which the caller
+// compiles the candidates, in the background, and hands them over with
+// SetCandidates(). The following executions of the key then alternate between
+// the original executable and the candidates, so that they are timed on real
+// inputs, and the one with the lowest median execute time over `num_samples`
+// executions wins. Every key is tuned at most once.
+template <typename K, typename T, typename H = std::hash<K>>
+class CompileOptionAutotuner {
+ public:
+  using TypePtr = std::shared_ptr<T>;
+
+  struct Winner {
+    // The index of the winning candidate option set, not set when the
+    // original executable wins.
+    std::optional<size_t> candidate;
+    TypePtr object;
+  };
+
+  CompileOptionAutotuner(std::vector<CompileOptionSet> candidates,
+                         size_t min_executions, size_t num_samples)
+      : candidates_(std::move(candidates)),
+        min_executions_(std::max<size_t>(min_executions, 1)),
+        num_samples_(std::max<size_t>(num_samples, 1)) {}
+
+  const std::vector<CompileOptionSet>& candidates() const {
+    return candidates_;
+  }
+
+  // Returns the object to execute for `key`, whose original is `object`. Sets
+  // `start_tuning` when the key just turned hot, and the caller has to compile
+  // the candidates.
+  TypePtr Select(const K& key, TypePtr object, bool* start_tuning) {
+    std::lock_guard<std::mutex> lock(lock_);
+    *start_tuning = false;
+    Tuning& tuning = tunings_[key];
+    switch (tuning.state) {
+      case State::kCounting:
+        if (++tuning.executions >= min_executions_) {
+          tuning.state = State::kCompiling;
+          *start_tuning = true;
+        }
+        return object;
+      case State::kTiming: {
+        size_t selected = 0;
+        for (size_t i = 1; i < tuning.objects.size(); ++i) {
+          if (tuning.dispatches[i] < tuning.dispatches[selected]) {
+            selected = i;
+          }
+        }
+        ++tuning.dispatches[selected];
+        return tuning.objects[selected];
+      }
+      default:
+        return object;
+    }
+  }
+
+  // Starts timing the `original` object of `key` against the `compiled`
+  // candidates, one per candidate option set. Passing no candidate, e.g. when
+  // they failed to compile, gives the key up.
+  void SetCandidates(const K& key, TypePtr original,
+                     std::vector<TypePtr> compiled) {
+    std::lock_guard<std::mutex> lock(lock_);
+    Tuning& tuning = tunings_[key];
+    if (compiled.empty()) {
+      tuning = Tuning();
+      tuning.state = State::kDone;
+      return;
+    }
+    tuning.state = State::kTiming;
+    tuning.objects.clear();
+    tuning.objects.push_back(std::move(original));
+    for (TypePtr& object : compiled) {
+      tuning.objects.push_back(std::move(object));
+    }
+    tuning.dispatches.assign(tuning.objects.size(), 0);
+    tuning.samples.assign(tuning.objects.size(), {});
+  }
+
+  // Records the execute time of `object`, which Select() returned for `key`.
+  // Returns the winner once every contestant has been timed enough.
+  std::optional<Winner> RecordExecuteTime(const K& key, const T* object,
+                                          int64_t execute_time_ns) {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = tunings_.find(key);
+    if (it == tunings_.end() || it->second.state != State::kTiming) {
+      return std::nullopt;
+    }
+    Tuning& tuning = it->second;
+    for (size_t i = 0; i < tuning.objects.size(); ++i) {
+      if (tuning.objects[i].get() == object) {
+        tuning.samples[i].push_back(execute_time_ns);
+        break;
+      }
+    }
+    for (const std::vector<int64_t>& samples : tuning.samples) {
+      if (samples.size() < num_samples_) {
+        return std::nullopt;
+      }
+    }
+    size_t best = 0;
+    int64_t best_median = Median(tuning.samples[0]);
+    for (size_t i = 1; i < tuning.samples.size(); ++i) {
+      int64_t median = Median(tuning.samples[i]);
+      if (median < best_median) {
+        best = i;
+        best_median = median;
+      }
+    }
+    Winner winner;
+    if (best > 0) {
+      winner.candidate = best - 1;
+    }
+    winner.object = std::move(tuning.objects[best]);
+    tuning = Tuning();
+    tuning.state = State::kDone;
+    return winner;
+  }
+
+ private:
+  enum class State { kCounting, kCompiling, kTiming, kDone };
+
+  struct Tuning {
+    State state = State::kCounting;
+    size_t executions = 0;
+    // The original object first, then the candidates.
+    std::vector<TypePtr> objects;
+    std::vector<size_t> dispatches;
+    std::vector<std::vector<int64_t>> samples;
+  };
+
+  static int64_t Median(std::vector<int64_t> samples) {
+    auto middle = samples.begin() + samples.size() / 2;
+    std::nth_element(samples.begin(), middle, samples.end());
+    return *middle;
+  }
+
+  const std::vector<CompileOptionSet> candidates_;
+  const size_t min_executions_;
+  const size_t num_samples_;
+  std::mutex lock_;
+  std::unordered_map<K, Tuning, H> tunings_;
+};
+
+}  // namespace util
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_COMPILE_OPTION_AUTOTUNER_H_
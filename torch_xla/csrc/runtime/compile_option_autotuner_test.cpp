@@ -0,0 +1,96 @@
+#include "torch_xla/csrc/runtime/compile_option_autotuner.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace torch_xla {
+namespace runtime {
+namespace util {
+namespace {
+
+using Autotuner = CompileOptionAutotuner<int, std::string>;
+
+TEST(CompileOptionAutotunerTest, ParseCandidates) {
+  absl::StatusOr<std::vector<CompileOptionSet>> candidates =
+      ParseCompileOptionCandidates("a=1, b = x=y;a=2;");
+  ASSERT_TRUE(candidates.ok()) << candidates.status();
+  ASSERT_EQ(candidates->size(), 2);
+  EXPECT_EQ((*candidates)[0],
+            (CompileOptionSet{{"a", "1"}, {"b", "x=y"}}));
+  EXPECT_EQ((*candidates)[1], (CompileOptionSet{{"a", "2"}}));
+
+  EXPECT_FALSE(ParseCompileOptionCandidates("a=1,b").ok());
+  EXPECT_FALSE(ParseCompileOptionCandidates("=1").ok());
+}
+
+TEST(CompileOptionAutotunerTest, PicksTheFastest) {
+  Autotuner tuner({{{"a", "1"}}, {{"a", "2"}}}, /*min_executions=*/2,
+                  /*num_samples=*/3);
+  auto original = std::make_shared<std::string>("original");
+  auto slow = std::make_shared<std::string>("slow");
+  auto fast = std::make_shared<std::string>("fast");
+
+  bool start_tuning = true;
+  EXPECT_EQ(tuner.Select(0, original, &start_tuning), original);
+  EXPECT_FALSE(start_tuning);
+  EXPECT_EQ(tuner.Select(0, original, &start_tuning), original);
+  ASSERT_TRUE(start_tuning);
+  // The key is not tuned again while its candidates compile.
+  EXPECT_EQ(tuner.Select(0, original, &start_tuning), original);
+  EXPECT_FALSE(start_tuning);
+
+  tuner.SetCandidates(0, original, {slow, fast});
+  std::optional<Autotuner::Winner> winner;
+  for (int i = 0; i < 9; ++i) {
+    Autotuner::TypePtr selected = tuner.Select(0, original, &start_tuning);
+    // The contestants take turns.
+    EXPECT_EQ(selected,
+              (std::vector<Autotuner::TypePtr>{original, slow, fast})[i % 3]);
+    int64_t time_ns = selected == fast ? 10 : (selected == slow ? 30 : 20);
+    EXPECT_FALSE(winner.has_value());
+    winner = tuner.RecordExecuteTime(0, selected.get(), time_ns);
+  }
+  ASSERT_TRUE(winner.has_value());
+  EXPECT_EQ(winner->candidate, std::optional<size_t>(1));
+  EXPECT_EQ(winner->object, fast);
+  EXPECT_EQ(tuner.Select(0, original, &start_tuning), original);
+  EXPECT_FALSE(start_tuning);
+}
+
+TEST(CompileOptionAutotunerTest, OriginalWins) {
+  Autotuner tuner({{{"a", "1"}}}, /*min_executions=*/1, /*num_samples=*/1);
+  auto original = std::make_shared<std::string>("original");
+  auto candidate = std::make_shared<std::string>("candidate");
+
+  bool start_tuning = false;
+  tuner.Select(0, original, &start_tuning);
+  ASSERT_TRUE(start_tuning);
+  tuner.SetCandidates(0, original, {candidate});
+  EXPECT_FALSE(tuner.RecordExecuteTime(0, original.get(), 10).has_value());
+  std::optional<Autotuner::Winner> winner =
+      tuner.RecordExecuteTime(0, candidate.get(), 20);
+  ASSERT_TRUE(winner.has_value());
+  EXPECT_FALSE(winner->candidate.has_value());
+  EXPECT_EQ(winner->object, original);
+}
+
+TEST(CompileOptionAutotunerTest, GivesUpWithoutCandidates) {
+  Autotuner tuner({{{"a", "1"}}}, /*min_executions=*/1, /*num_samples=*/1);
+  auto original = std::make_shared<std::string>("original");
+
+  bool start_tuning = false;
+  tuner.Select(0, original, &start_tuning);
+  ASSERT_TRUE(start_tuning);
+  tuner.SetCandidates(0, original, {});
+  EXPECT_EQ(tuner.Select(0, original, &start_tuning), original);
+  EXPECT_FALSE(start_tuning);
+  EXPECT_FALSE(tuner.RecordExecuteTime(0, original.get(), 10).has_value());
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace runtime
+}  // namespace torch_xla
@@ -21,6 +21,7 @@
 #include "torch_xla/csrc/runtime/env_vars.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/xla_util.h"
+#include "torch_xla/csrc/status.h"
 
 namespace torch_xla {
 namespace runtime {
@@ -46,6 +47,57 @@ std::shared_ptr<ComputationClient::Computation> ComputationClient::Compile(
   return std::move(results[0]);
 }
 
+namespace {
+
+// A transfer which completed before being returned.
+class CompletedTransfer : public ComputationClient::AsyncTransfer {
+ public:
+  explicit CompletedTransfer(absl::StatusOr<std::vector<xla::Literal>> literals)
+      : literals_(std::move(literals)) {}
+
+  bool IsReady() override { return true; }
+
+  absl::StatusOr<std::vector<xla::Literal>> Await() override {
+    return std::move(literals_);
+  }
+
+ private:
+  absl::StatusOr<std::vector<xla::Literal>> literals_;
+};
+
+}  // namespace
+
+std::unique_ptr<ComputationClient::AsyncTransfer>
+ComputationClient::TransferFromDeviceAsync(absl::Span<const DataPtr> handles) {
+  return std::make_unique<CompletedTransfer>(TransferFromDevice(handles));
+}
+
+absl::StatusOr<std::vector<std::shared_ptr<const xla::LiteralBase>>>
+ComputationClient::TransferFromDeviceToHostPool(
+    absl::Span<const DataPtr> handles) {
+  XLA_ASSIGN_OR_RETURN(std::vector<xla::Literal> literals,
+                       TransferFromDevice(handles));
+  std::vector<std::shared_ptr<const xla::LiteralBase>> results;
+  results.reserve(literals.size());
+  for (xla::Literal& literal : literals) {
+    results.push_back(std::make_shared<xla::Literal>(std::move(literal)));
+  }
+  return results;
+}
+
+void ComputationClient::TransferFromDeviceStreaming(
+    absl::Span<const DataPtr> handles, const LiteralCallback& on_ready) {
+  absl::StatusOr<std::vector<std::shared_ptr<const xla::LiteralBase>>>
+      literals = TransferFromDeviceToHostPool(handles);
+  for (size_t i = 0; i < handles.size(); ++i) {
+    if (literals.ok()) {
+      on_ready(i, std::move((*literals)[i]));
+    } else {
+      on_ready(i, literals.status());
+    }
+  }
+}
+
 std::vector<std::string> ComputationClient::GetCompilationDevices(
     const std::string& device, absl::Span<const std::string> devices) {
   std::vector<std::string> compilation_devices;
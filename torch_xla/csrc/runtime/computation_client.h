@@ -3,9 +3,12 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <ATen/Tensor.h>
@@ -207,11 +210,57 @@ class ComputationClient {
       XLA_ERROR() << "Unimplemented";
     }
 
+    // Size of the compiled executable in bytes, or zero if unknown.
+    virtual size_t executable_size_bytes() const { return 0; }
+
+    // Device memory used by an execution of the computation, on each of its
+    // devices.
+    struct MemoryFootprint {
+      int64_t argument_bytes = 0;
+      int64_t output_bytes = 0;
+      int64_t alias_bytes = 0;
+      int64_t temp_bytes = 0;
+      int64_t generated_code_bytes = 0;
+
+      // Bytes allocated by an execution on top of its arguments. Aliased
+      // outputs reuse the memory of donated arguments.
+      int64_t execution_bytes() const {
+        return output_bytes - alias_bytes + temp_bytes;
+      }
+    };
+
+    // Returns the memory footprint of the compiled computation, if known.
+    virtual std::optional<MemoryFootprint> memory_footprint() const {
+      return std::nullopt;
+    }
+
+    // Cost of an execution of the computation on each of its devices, as
+    // estimated by the XLA cost analysis of the compiled module.
+    struct CostAnalysis {
+      double flops = 0;
+      double bytes_accessed = 0;
+      double transcendentals = 0;
+    };
+
+    // Returns the cost analysis of the compiled computation, if known.
+    virtual std::optional<CostAnalysis> cost_analysis() const {
+      return std::nullopt;
+    }
+
+    // Wall time spent compiling this computation, or zero if unknown (e.g. it
+    // was deserialized).
+    int64_t compile_time_ns() const { return compile_time_ns_; }
+
+    void set_compile_time_ns(int64_t compile_time_ns) {
+      compile_time_ns_ = compile_time_ns;
+    }
+
    private:
     xla::XlaComputation computation_;
     xla::ProgramShape program_shape_;
     std::vector<std::string> devices_;
     bool computation_moved_ = false;
+    int64_t compile_time_ns_ = 0;
 
     torch::lazy::hash_t hash_;
     std::string name_;
@@ -226,6 +275,19 @@ class ComputationClient {
 
   using ComputationPtr = std::shared_ptr<Computation>;
 
+  // A transfer from device started by TransferFromDeviceAsync().
+  class AsyncTransfer {
+   public:
+    virtual ~AsyncTransfer() = default;
+
+    // Returns whether the literals are available, without blocking.
+    virtual bool IsReady() = 0;
+
+    // Blocks until the transfer completes, and returns the literals. Must be
+    // called at most once.
+    virtual absl::StatusOr<std::vector<xla::Literal>> Await() = 0;
+  };
+
   // TODO(wcromar): Should CompileInstance still exist? Should it be a subclass
   // of torch::lazy::Computation?
   struct CompileInstance {
@@ -262,6 +324,9 @@ class ComputationClient {
     std::vector<int64_t> auto_spmd_mesh_shape;
     std::vector<int64_t> auto_spmd_mesh_ids;
     bool eager_mode;
+    // Compile options applied on top of the custom compile options, which they
+    // override. Only the PJRT client applies them.
+    std::unordered_map<std::string, std::string> option_overrides;
   };
 
   struct ExecuteComputationOptions : public ClientExecuteOptions {};
@@ -272,6 +337,7 @@ class ComputationClient {
     int64_t bytes_used = 0;
     int64_t bytes_limit = 0;
     int64_t peak_bytes_used = 0;
+    int64_t largest_free_block_bytes = 0;
   };
 
   virtual ~ComputationClient() {}
@@ -321,6 +387,15 @@ class ComputationClient {
   // Copies `data->buffer` to `dst` device buffer.
   virtual DataPtr CopyToDevice(DataPtr data, std::string dst) = 0;
 
+  // Returns a copy of `data` held by the `memory_kind` memory space of the
+  // same devices, like "device" or "pinned_host". Returns `data` itself if it
+  // is already there.
+  virtual absl::StatusOr<DataPtr> CopyToMemoryKind(
+      DataPtr data, const std::string& memory_kind) = 0;
+
+  // Returns the kind of the memory space holding `data`.
+  virtual std::string GetMemoryKind(DataPtr data) = 0;
+
   // Reads the tensor literal values stored at TPU server sites, behind the
   // supplied handles.
   // Note: `TransferFromDevice` call will block until the `DataPtrs` are ready
@@ -329,6 +404,34 @@ class ComputationClient {
   virtual absl::StatusOr<std::vector<xla::Literal>> TransferFromDevice(
       absl::Span<const DataPtr> handles) = 0;
 
+  // Starts reading the values behind the handles, like TransferFromDevice(),
+  // and returns without waiting for them. The default implementation performs
+  // the transfer before returning.
+  virtual std::unique_ptr<AsyncTransfer> TransferFromDeviceAsync(
+      absl::Span<const DataPtr> handles);
+
+  // Reads the values behind the handles, like TransferFromDevice(), into
+  // buffers of the host buffer pool instead of newly allocated literals. The
+  // small values are packed together into a single buffer. A buffer goes
+  // back to the pool once all the literals it backs are destroyed. The
+  // default implementation returns the literals of TransferFromDevice().
+  virtual absl::StatusOr<std::vector<std::shared_ptr<const xla::LiteralBase>>>
+  TransferFromDeviceToHostPool(absl::Span<const DataPtr> handles);
+
+  // Called with the index of a value read by TransferFromDeviceStreaming(),
+  // and its literal or the error reading it.
+  using LiteralCallback = std::function<void(
+      size_t, absl::StatusOr<std::shared_ptr<const xla::LiteralBase>>)>;
+
+  // Reads the values behind the handles, like TransferFromDeviceToHostPool(),
+  // and calls `on_ready` for each of them as soon as it lands, so that the
+  // caller can process the values while the others are still in flight. The
+  // calls can be concurrent, from the runtime threads, so they must not block.
+  // Returns once `on_ready` was called for every handle. The default
+  // implementation calls it once TransferFromDeviceToHostPool() returned.
+  virtual void TransferFromDeviceStreaming(absl::Span<const DataPtr> handles,
+                                           const LiteralCallback& on_ready);
+
   virtual std::uintptr_t UnsafeBufferPointer(const DataPtr handle) = 0;
 
   virtual std::shared_ptr<xla::PjRtBuffer> GetPjRtBuffer(
@@ -350,6 +453,11 @@ class ComputationClient {
   // Returns a hash of the current compilation environment.
   virtual torch::lazy::hash_t HashCompilationEnv() = 0;
 
+  // Returns a counter which changes whenever HashCompilationEnv() does, e.g.
+  // when the custom compile options are set, so that callers can memoize the
+  // latter.
+  virtual uint64_t CompilationEnvVersion() const { return 0; }
+
   // Executes computation with arguments and returns the result.
   // The passed device must match the common device of the arguments Data.
   // If options.explode_tuple is true, the output tuple will be decomposed into
@@ -411,6 +519,11 @@ class ComputationClient {
 
   virtual MemoryInfo GetMemoryInfo(const std::string& device) = 0;
 
+  // Returns the measured time in nanoseconds it takes ExecuteReplicated() to
+  // prepare the handles of one argument, for all the devices, or zero if the
+  // client does not measure it.
+  virtual double GetArgumentHandleCostNs() const { return 0; }
+
   // Block until pass in devices' async operation are finished. If empty, all
   // the local devices will be waited for.
   virtual void WaitDeviceOps(absl::Span<const std::string> devices = {}) = 0;
@@ -0,0 +1,188 @@
+// Runs the same SPMD programs through the PJRT and the IFRT clients, to check
+// that they agree, and reports the throughput of their hot paths side by side.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "tsl/platform/env.h"
+#include "xla/hlo/builder/xla_builder.h"
+#include "xla/hlo/builder/xla_computation.h"
+#include "xla/hlo/ir/hlo_sharding.h"
+#include "xla/literal.h"
+#include "xla/literal_util.h"
+#include "xla/tests/literal_test_util.h"
+
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/ifrt_computation_client.h"
+#include "torch_xla/csrc/runtime/pjrt_computation_client.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tensor_source.h"
+#include "torch_xla/csrc/status.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+// The virtual device of the SPMD data, as the clients name it.
+constexpr char kSpmdDevice[] = "SPMD:0";
+
+struct ClientFactory {
+  std::string name;
+  std::function<std::unique_ptr<ComputationClient>()> create;
+};
+
+std::vector<ClientFactory> GetClientFactories() {
+  return {
+      {"PjRt",
+       []() -> std::unique_ptr<ComputationClient> {
+         XLA_ASSIGN_OR_THROW(std::unique_ptr<PjRtComputationClient> client,
+                             PjRtComputationClient::Create());
+         return client;
+       }},
+      {"Ifrt",
+       []() -> std::unique_ptr<ComputationClient> {
+         XLA_ASSIGN_OR_THROW(std::unique_ptr<IfrtComputationClient> client,
+                             IfrtComputationClient::Create());
+         return client;
+       }},
+  };
+}
+
+// Returns a computation to compute x + y where x and y are both F32[2,2]
+// arrays.
+absl::StatusOr<xla::XlaComputation> MakeAddComputation() {
+  const xla::Shape input_shape =
+      xla::ShapeUtil::MakeShape(xla::PrimitiveType::F32, {2, 2});
+  xla::XlaBuilder builder("AddComputation");
+  xla::XlaOp x = xla::Parameter(&builder, 0, input_shape, "x");
+  xla::XlaOp y = xla::Parameter(&builder, 1, input_shape, "y");
+  xla::XlaOp sum = xla::Add(x, y);
+  return builder.Build();
+}
+
+class ComputationClientConformanceTest
+    : public ::testing::TestWithParam<ClientFactory> {
+ protected:
+  ComputationClientConformanceTest() {
+    // Get a CPU client.
+    tsl::setenv("PJRT_DEVICE", "CPU", true);
+    client_ = GetParam().create();
+    device_ = client_->GetDefaultDevice();
+    devices_ = client_->GetLocalDevices();
+  }
+
+  ComputationClient::ComputationPtr CompileAdd() {
+    xla::Shape out_shape = xla::ShapeUtil::MakeShape(xla::F32, {2, 2});
+    std::vector<ComputationClient::CompileInstance> instances;
+    instances.push_back(ComputationClient::CompileInstance(
+        std::move(MakeAddComputation().value()), device_,
+        client_->GetCompilationDevices(device_, devices_), &out_shape,
+        /*parameter_is_tupled_arguments=*/false, /*is_sharded=*/true));
+    return client_->Compile(std::move(instances)).front();
+  }
+
+  // Transfers `literal` to all the local devices, as replicated data.
+  ComputationClient::DataPtr TransferReplicated(const xla::Literal& literal) {
+    std::vector<std::shared_ptr<const TensorSource>> shards;
+    for (const std::string& device : devices_) {
+      shards.push_back(
+          std::make_shared<LiteralSource>(literal.Clone(), device));
+    }
+    return client_->TransferShardsToDevice(
+        shards, kSpmdDevice, literal.shape(),
+        xla::HloSharding::Replicate().ToProto());
+  }
+
+  std::vector<ComputationClient::DataPtr> TransferArguments() {
+    return {TransferReplicated(xla::LiteralUtil::CreateR2<float>(
+                {{1.0f, 2.0f}, {3.0f, 4.0f}})),
+            TransferReplicated(xla::LiteralUtil::CreateR2<float>(
+                {{5.0f, 6.0f}, {7.0f, 8.0f}}))};
+  }
+
+  void ExpectAddResult(const ComputationClient::Computation& computation) {
+    XLA_ASSIGN_OR_THROW(std::vector<ComputationClient::DataPtr> results,
+                        client_->ExecuteReplicated(computation,
+                                                   TransferArguments(),
+                                                   devices_, options_));
+    ASSERT_EQ(results.size(), 1);
+    XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> result_literals,
+                        client_->TransferFromDevice(results));
+    ASSERT_THAT(result_literals, ::testing::SizeIs(1));
+    EXPECT_TRUE(xla::LiteralTestUtil::Equal(
+        xla::LiteralUtil::CreateR2<float>({{6.0f, 8.0f}, {10.0f, 12.0f}}),
+        result_literals[0]));
+  }
+
+  std::unique_ptr<ComputationClient> client_;
+  std::string device_;
+  std::vector<std::string> devices_;
+  ComputationClient::ExecuteReplicatedOptions options_;
+};
+
+TEST_P(ComputationClientConformanceTest, TransfersRoundTrip) {
+  xla::Literal literal =
+      xla::LiteralUtil::CreateR2<float>({{1.0f, 2.0f}, {3.0f, 4.0f}});
+  std::vector<ComputationClient::DataPtr> handles = {
+      TransferReplicated(literal)};
+
+  XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> literals,
+                      client_->TransferFromDevice(handles));
+  ASSERT_THAT(literals, ::testing::SizeIs(1));
+  EXPECT_TRUE(xla::LiteralTestUtil::Equal(literal, literals[0]));
+
+  XLA_ASSIGN_OR_THROW(literals,
+                      client_->TransferFromDeviceAsync(handles)->Await());
+  ASSERT_THAT(literals, ::testing::SizeIs(1));
+  EXPECT_TRUE(xla::LiteralTestUtil::Equal(literal, literals[0]));
+}
+
+TEST_P(ComputationClientConformanceTest, ExecutesReplicated) {
+  ExpectAddResult(*CompileAdd());
+}
+
+TEST_P(ComputationClientConformanceTest, ExecutesDeserializedComputation) {
+  std::string serialized = client_->SerializeComputation(CompileAdd());
+  ASSERT_FALSE(serialized.empty());
+  ComputationClient::ComputationPtr computation =
+      client_->DeserializeComputation(serialized);
+  ASSERT_NE(computation, nullptr);
+  ExpectAddResult(*computation);
+}
+
+// Reports the time per execution, with the argument handling and the result
+// transfer, which the clients should be on par for.
+TEST_P(ComputationClientConformanceTest, ReportsExecuteThroughput) {
+  constexpr int64_t kIterations = 1000;
+  ComputationClient::ComputationPtr computation = CompileAdd();
+  std::vector<ComputationClient::DataPtr> arguments = TransferArguments();
+  int64_t start_ns = sys_util::NowNs();
+  for (int64_t i = 0; i < kIterations; ++i) {
+    XLA_ASSIGN_OR_THROW(std::vector<ComputationClient::DataPtr> results,
+                        client_->ExecuteReplicated(*computation, arguments,
+                                                   devices_, options_));
+    XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> literals,
+                        client_->TransferFromDevice(results));
+    ASSERT_THAT(literals, ::testing::SizeIs(1));
+  }
+  std::cout << GetParam().name << " client: "
+            << (sys_util::NowNs() - start_ns) / 1000.0 / kIterations
+            << " us per execution" << std::endl;
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Clients, ComputationClientConformanceTest,
+    ::testing::ValuesIn(GetClientFactories()),
+    [](const ::testing::TestParamInfo<ClientFactory>& info) {
+      return info.param.name;
+    });
+
+}  // namespace
+}  // namespace runtime
+}  // namespace torch_xla
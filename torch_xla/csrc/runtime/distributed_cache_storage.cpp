@@ -0,0 +1,140 @@
+#include "torch_xla/csrc/runtime/distributed_cache_storage.h"
+
+#include <algorithm>
+#include <sstream>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+#include "tsl/platform/hash.h"
+
+#include "torch_xla/csrc/runtime/tf_logging.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+// Entries are split in chunks to stay well below the RPC message size limit of
+// the coordination service.
+constexpr size_t kChunkBytes = 2 << 20;
+
+std::string ChunkKey(const std::string& name, size_t chunk) {
+  return absl::StrCat(name, "/", chunk);
+}
+
+}  // namespace
+
+DistributedCacheStorage::DistributedCacheStorage(
+    std::unique_ptr<util::CacheStorage> local,
+    std::shared_ptr<xla::KeyValueStoreInterface> kv_store,
+    int64_t process_index, int64_t num_publishers,
+    absl::Duration wait_timeout)
+    : local_(std::move(local)),
+      kv_store_(std::move(kv_store)),
+      process_index_(process_index),
+      num_publishers_(std::max<int64_t>(num_publishers, 1)),
+      wait_timeout_(wait_timeout) {}
+
+bool DistributedCacheStorage::IsPublisher(const std::string& name) const {
+  // The hash must agree between the hosts, so it cannot be seeded per process.
+  uint64_t owner = tsl::Hash64(name) % static_cast<uint64_t>(num_publishers_);
+  return static_cast<int64_t>(owner) == process_index_;
+}
+
+bool DistributedCacheStorage::Contains(const std::string& name) {
+  return local_->Contains(name) ||
+         LookupPublished(name, /*wait=*/!IsPublisher(name)).has_value();
+}
+
+std::optional<std::string> DistributedCacheStorage::Read(
+    const std::string& name) {
+  std::optional<std::string> data = local_->Read(name);
+  if (data || IsPublisher(name)) {
+    return data;
+  }
+  data = FetchPublished(name);
+  if (data) {
+    TORCH_LAZY_COUNTER("DistributedCacheStorageFetch", 1);
+    local_->Write(name, *data, util::CacheCost().cost);
+  }
+  return data;
+}
+
+void DistributedCacheStorage::Write(const std::string& name,
+                                    const std::string& data, double cost) {
+  local_->Write(name, data, cost);
+  if (IsPublisher(name)) {
+    Publish(name, data);
+  }
+}
+
+bool DistributedCacheStorage::Remove(const std::string& name) {
+  return local_->Remove(name);
+}
+
+void DistributedCacheStorage::Clear() { local_->Clear(); }
+
+std::vector<std::pair<std::string, util::CacheIndexEntry>>
+DistributedCacheStorage::List() const {
+  return local_->List();
+}
+
+std::optional<size_t> DistributedCacheStorage::LookupPublished(
+    const std::string& name, bool wait) {
+  // The manifest is published last and holds the number of chunks.
+  absl::StatusOr<std::string> manifest =
+      wait && wait_timeout_ > absl::ZeroDuration()
+          ? kv_store_->Get(name, wait_timeout_)
+          : kv_store_->TryGet(name);
+  size_t num_chunks = 0;
+  if (!manifest.ok() || !(std::istringstream(*manifest) >> num_chunks)) {
+    return std::nullopt;
+  }
+  return num_chunks;
+}
+
+std::optional<std::string> DistributedCacheStorage::FetchPublished(
+    const std::string& name) {
+  std::optional<size_t> num_chunks = LookupPublished(name, /*wait=*/false);
+  if (!num_chunks) {
+    return std::nullopt;
+  }
+  std::string data;
+  for (size_t chunk = 0; chunk < *num_chunks; ++chunk) {
+    absl::StatusOr<std::string> value =
+        kv_store_->TryGet(ChunkKey(name, chunk));
+    if (!value.ok()) {
+      TF_LOG(WARNING) << "Failed to fetch the published cache entry " << name
+                      << ": " << value.status();
+      return std::nullopt;
+    }
+    data.append(*value);
+  }
+  return data;
+}
+
+void DistributedCacheStorage::Publish(const std::string& name,
+                                      const std::string& data) {
+  size_t num_chunks = (data.size() + kChunkBytes - 1) / kChunkBytes;
+  for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+    size_t offset = chunk * kChunkBytes;
+    absl::Status status = kv_store_->Set(
+        ChunkKey(name, chunk),
+        std::string_view(data).substr(offset, kChunkBytes));
+    if (!status.ok()) {
+      TF_LOG(WARNING) << "Failed to publish the cache entry " << name << ": "
+                      << status;
+      return;
+    }
+  }
+  absl::Status status = kv_store_->Set(name, absl::StrCat(num_chunks));
+  if (!status.ok()) {
+    TF_LOG(WARNING) << "Failed to publish the cache entry " << name << ": "
+                    << status;
+    return;
+  }
+  TORCH_LAZY_COUNTER("DistributedCacheStoragePublish", 1);
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
@@ -0,0 +1,80 @@
+#ifndef XLA_CLIENT_DISTRIBUTED_CACHE_STORAGE_H_
+#define XLA_CLIENT_DISTRIBUTED_CACHE_STORAGE_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "xla/pjrt/distributed/key_value_store_interface.h"
+
+#include "torch_xla/csrc/runtime/cache.h"
+
+namespace torch_xla {
+namespace runtime {
+
+// Persistent cache storage shared between the hosts of a multi-host job
+// through the distributed key-value store of the XlaCoordinator.
+//
+// Entries are always read and written through a local storage. Every entry has
+// a publisher host, picked by hashing its name over the first `num_publishers`
+// process indices, which additionally publishes the entry to the key-value
+// store when it writes it. The other hosts fall back to the key-value store on
+// local misses, storing what they fetch locally. When `wait_timeout` is not
+// zero, the other hosts wait up to that long for the publisher to publish a
+// missing entry, which lets them skip compiling programs, such as SPMD ones,
+// that every host compiles identically. With more than one publisher, the
+// compilation of new programs is spread over the hosts.
+//
+// Entry names are graph hashes, which already include the compilation
+// environment hash, so hosts with different topologies never share entries.
+class DistributedCacheStorage : public util::CacheStorage {
+ public:
+  DistributedCacheStorage(
+      std::unique_ptr<util::CacheStorage> local,
+      std::shared_ptr<xla::KeyValueStoreInterface> kv_store,
+      int64_t process_index, int64_t num_publishers,
+      absl::Duration wait_timeout);
+
+  // Whether this host publishes the entry `name`.
+  bool IsPublisher(const std::string& name) const;
+
+  bool Contains(const std::string& name) override;
+
+  std::optional<std::string> Read(const std::string& name) override;
+
+  void Write(const std::string& name, const std::string& data,
+             double cost) override;
+
+  // Removal and clearing only apply to the local storage, the published
+  // entries live as long as the key-value store.
+  bool Remove(const std::string& name) override;
+
+  void Clear() override;
+
+  std::vector<std::pair<std::string, util::CacheIndexEntry>> List()
+      const override;
+
+ private:
+  // Returns the number of chunks of the published entry, or std::nullopt if
+  // it has not been published.
+  std::optional<size_t> LookupPublished(const std::string& name, bool wait);
+
+  std::optional<std::string> FetchPublished(const std::string& name);
+
+  void Publish(const std::string& name, const std::string& data);
+
+  std::unique_ptr<util::CacheStorage> local_;
+  std::shared_ptr<xla::KeyValueStoreInterface> kv_store_;
+  const int64_t process_index_;
+  const int64_t num_publishers_;
+  const absl::Duration wait_timeout_;
+};
+
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_DISTRIBUTED_CACHE_STORAGE_H_
@@ -0,0 +1,98 @@
+#include "torch_xla/csrc/runtime/distributed_cache_storage.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+
+#include "xla/pjrt/distributed/in_memory_key_value_store.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+std::string MakeTempDir() {
+  char format[] = "/tmp/tmp.XXXXXX";
+  char* tmpdir = mkdtemp(format);
+  EXPECT_NE(tmpdir, nullptr);
+  return tmpdir;
+}
+
+TEST(DistributedCacheStorageTest, ReadsEntriesPublishedByAnotherHost) {
+  auto kv_store = std::make_shared<xla::InMemoryKeyValueStore>();
+  std::string publisher_dir = MakeTempDir();
+  std::string follower_dir = MakeTempDir();
+  DistributedCacheStorage publisher(
+      std::make_unique<util::DiskCacheStorage>(publisher_dir,
+                                               /*readonly=*/false),
+      kv_store, /*process_index=*/0, /*num_publishers=*/1,
+      absl::ZeroDuration());
+  DistributedCacheStorage follower(
+      std::make_unique<util::DiskCacheStorage>(follower_dir,
+                                               /*readonly=*/false),
+      kv_store, /*process_index=*/1, /*num_publishers=*/1,
+      absl::ZeroDuration());
+
+  EXPECT_FALSE(follower.Contains("small"));
+  EXPECT_FALSE(follower.Read("small").has_value());
+
+  // The large entry spans multiple chunks.
+  std::string large(5 << 20, 'x');
+  large[3 << 20] = 'y';
+  publisher.Write("small", "value", /*cost=*/1.0);
+  publisher.Write("large", large, /*cost=*/1.0);
+
+  ASSERT_TRUE(follower.Contains("small"));
+  EXPECT_EQ(follower.Read("small"), "value");
+  EXPECT_EQ(follower.Read("large"), large);
+
+  // Fetched entries are stored in the local storage of the follower.
+  util::DiskCacheStorage follower_local(follower_dir, /*readonly=*/true);
+  EXPECT_EQ(follower_local.Read("large"), large);
+
+  // Entries written by the follower are not published.
+  follower.Write("local", "value", /*cost=*/1.0);
+  EXPECT_FALSE(publisher.Contains("local"));
+
+  std::filesystem::remove_all(publisher_dir);
+  std::filesystem::remove_all(follower_dir);
+}
+
+TEST(DistributedCacheStorageTest, ShardsPublishersByEntryName) {
+  auto kv_store = std::make_shared<xla::InMemoryKeyValueStore>();
+  std::vector<std::string> dirs = {MakeTempDir(), MakeTempDir()};
+  std::vector<std::unique_ptr<DistributedCacheStorage>> hosts;
+  for (int64_t index = 0; index < 2; ++index) {
+    hosts.push_back(std::make_unique<DistributedCacheStorage>(
+        std::make_unique<util::DiskCacheStorage>(dirs[index],
+                                                 /*readonly=*/false),
+        kv_store, index, /*num_publishers=*/2, absl::ZeroDuration()));
+  }
+
+  // Each entry has exactly one publisher, and both hosts publish some.
+  std::vector<int> published(2, 0);
+  for (int entry = 0; entry < 16; ++entry) {
+    std::string name = absl::StrCat("entry", entry);
+    ASSERT_NE(hosts[0]->IsPublisher(name), hosts[1]->IsPublisher(name));
+    int publisher = hosts[0]->IsPublisher(name) ? 0 : 1;
+    ++published[publisher];
+    hosts[publisher]->Write(name, name, /*cost=*/1.0);
+    EXPECT_EQ(hosts[1 - publisher]->Read(name), name);
+  }
+  EXPECT_GT(published[0], 0);
+  EXPECT_GT(published[1], 0);
+
+  for (const std::string& dir : dirs) {
+    std::filesystem::remove_all(dir);
+  }
+}
+
+}  // namespace
+}  // namespace runtime
+}  // namespace torch_xla
@@ -0,0 +1,110 @@
+#include "torch_xla/csrc/runtime/host_buffer_pool.h"
+
+#include <cstdlib>
+#include <new>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "torch_xla/csrc/runtime/sys_util.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+// Buffers are page aligned, which is also the smallest size class.
+constexpr size_t kAlignment = 4096;
+
+void* AllocateBuffer(size_t capacity) {
+  void* data = std::aligned_alloc(kAlignment, capacity);
+  if (data == nullptr) {
+    throw std::bad_alloc();
+  }
+  return data;
+}
+
+}  // namespace
+
+HostBufferPool::HostBuffer::~HostBuffer() {
+  pool_->Release(data_, capacity_);
+}
+
+std::shared_ptr<HostBufferPool> HostBufferPool::Get() {
+  static std::shared_ptr<HostBufferPool>* pool = []() {
+    int64_t size_mb = sys_util::GetEnvInt("XLA_HOST_BUFFER_POOL_SIZE_MB", 0);
+    return new std::shared_ptr<HostBufferPool>(
+        size_mb > 0 ? Create(static_cast<size_t>(size_mb) << 20) : nullptr);
+  }();
+  return *pool;
+}
+
+std::shared_ptr<HostBufferPool> HostBufferPool::Create(size_t max_idle_bytes) {
+  return std::shared_ptr<HostBufferPool>(new HostBufferPool(max_idle_bytes));
+}
+
+HostBufferPool::~HostBufferPool() { Clear(); }
+
+std::unique_ptr<HostBufferPool::HostBuffer> HostBufferPool::Acquire(
+    size_t size) {
+  size_t capacity = SizeClass(size);
+  void* data = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = idle_buffers_.find(capacity);
+    if (it != idle_buffers_.end() && !it->second.empty()) {
+      data = it->second.back();
+      it->second.pop_back();
+      idle_bytes_ -= capacity;
+    }
+  }
+  if (data != nullptr) {
+    TORCH_LAZY_COUNTER("HostBufferPoolHit", 1);
+  } else {
+    TORCH_LAZY_COUNTER("HostBufferPoolMiss", 1);
+    data = AllocateBuffer(capacity);
+  }
+  return std::unique_ptr<HostBuffer>(
+      new HostBuffer(shared_from_this(), data, size, capacity));
+}
+
+void HostBufferPool::Clear() {
+  std::map<size_t, std::vector<void*>> idle_buffers;
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    idle_buffers.swap(idle_buffers_);
+    idle_bytes_ = 0;
+  }
+  for (auto& size_buffers : idle_buffers) {
+    for (void* data : size_buffers.second) {
+      std::free(data);
+    }
+  }
+}
+
+size_t HostBufferPool::idle_bytes() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  return idle_bytes_;
+}
+
+size_t HostBufferPool::SizeClass(size_t size) {
+  size_t capacity = kAlignment;
+  while (capacity < size) {
+    capacity <<= 1;
+  }
+  return capacity;
+}
+
+void HostBufferPool::Release(void* data, size_t capacity) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (idle_bytes_ + capacity <= max_idle_bytes_) {
+      idle_buffers_[capacity].push_back(data);
+      idle_bytes_ += capacity;
+      return;
+    }
+  }
+  TORCH_LAZY_COUNTER("HostBufferPoolEvict", 1);
+  std::free(data);
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
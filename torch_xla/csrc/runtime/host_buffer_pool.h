@@ -0,0 +1,89 @@
+#ifndef XLA_CLIENT_HOST_BUFFER_POOL_H_
+#define XLA_CLIENT_HOST_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace torch_xla {
+namespace runtime {
+
+// Pool of page-aligned host staging buffers used to feed host to device
+// transfers. Buffers are bucketed in power of two size classes, and returned
+// to the pool when the owning HostBuffer is destroyed, which for transfers
+// happens once the runtime signals it is done with the host memory.
+class HostBufferPool : public std::enable_shared_from_this<HostBufferPool> {
+ public:
+  class HostBuffer {
+   public:
+    ~HostBuffer();
+
+    HostBuffer(const HostBuffer&) = delete;
+    HostBuffer& operator=(const HostBuffer&) = delete;
+
+    void* data() const { return data_; }
+
+    // The usable size, as requested to Acquire().
+    size_t size() const { return size_; }
+
+    // The allocated size, which is the size class of the buffer.
+    size_t capacity() const { return capacity_; }
+
+   private:
+    friend class HostBufferPool;
+
+    HostBuffer(std::shared_ptr<HostBufferPool> pool, void* data, size_t size,
+               size_t capacity)
+        : pool_(std::move(pool)),
+          data_(data),
+          size_(size),
+          capacity_(capacity) {}
+
+    std::shared_ptr<HostBufferPool> pool_;
+    void* data_;
+    size_t size_;
+    size_t capacity_;
+  };
+
+  // Returns the process wide pool, or nullptr if pooling is disabled. The
+  // amount of idle memory kept by the pool is set by the
+  // XLA_HOST_BUFFER_POOL_SIZE_MB environment variable, which defaults to 0
+  // (disabled).
+  static std::shared_ptr<HostBufferPool> Get();
+
+  static std::shared_ptr<HostBufferPool> Create(size_t max_idle_bytes);
+
+  ~HostBufferPool();
+
+  // Returns a buffer of at least `size` bytes, reusing an idle buffer of the
+  // same size class if there is one.
+  std::unique_ptr<HostBuffer> Acquire(size_t size);
+
+  // Frees all the idle buffers.
+  void Clear();
+
+  size_t idle_bytes() const;
+
+  static size_t SizeClass(size_t size);
+
+ private:
+  explicit HostBufferPool(size_t max_idle_bytes)
+      : max_idle_bytes_(max_idle_bytes) {}
+
+  void Release(void* data, size_t capacity);
+
+  const size_t max_idle_bytes_;
+  mutable std::mutex lock_;
+  size_t idle_bytes_ = 0;
+  // Maps a size class to its idle buffers.
+  std::map<size_t, std::vector<void*>> idle_buffers_;
+};
+
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_HOST_BUFFER_POOL_H_
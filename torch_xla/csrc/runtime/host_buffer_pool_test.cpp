@@ -0,0 +1,69 @@
+#include "torch_xla/csrc/runtime/host_buffer_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace torch_xla {
+namespace runtime {
+
+TEST(HostBufferPoolTest, SizeClass) {
+  EXPECT_EQ(HostBufferPool::SizeClass(0), 4096);
+  EXPECT_EQ(HostBufferPool::SizeClass(1), 4096);
+  EXPECT_EQ(HostBufferPool::SizeClass(4096), 4096);
+  EXPECT_EQ(HostBufferPool::SizeClass(4097), 8192);
+  EXPECT_EQ(HostBufferPool::SizeClass(1000000), 1 << 20);
+}
+
+TEST(HostBufferPoolTest, ReusesReleasedBuffers) {
+  std::shared_ptr<HostBufferPool> pool = HostBufferPool::Create(1 << 20);
+  void* data = nullptr;
+  {
+    std::unique_ptr<HostBufferPool::HostBuffer> buffer = pool->Acquire(5000);
+    EXPECT_EQ(buffer->size(), 5000);
+    EXPECT_EQ(buffer->capacity(), 8192);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer->data()) % 4096, 0);
+    data = buffer->data();
+    EXPECT_EQ(pool->idle_bytes(), 0);
+  }
+  EXPECT_EQ(pool->idle_bytes(), 8192);
+
+  // Same size class, the idle buffer is handed out again.
+  std::unique_ptr<HostBufferPool::HostBuffer> buffer = pool->Acquire(8000);
+  EXPECT_EQ(buffer->data(), data);
+  EXPECT_EQ(pool->idle_bytes(), 0);
+
+  // Different size class, a new buffer is allocated.
+  std::unique_ptr<HostBufferPool::HostBuffer> other = pool->Acquire(100);
+  EXPECT_NE(other->data(), data);
+}
+
+TEST(HostBufferPoolTest, BoundsIdleMemory) {
+  std::shared_ptr<HostBufferPool> pool = HostBufferPool::Create(8192);
+  {
+    std::unique_ptr<HostBufferPool::HostBuffer> a = pool->Acquire(4096);
+    std::unique_ptr<HostBufferPool::HostBuffer> b = pool->Acquire(4096);
+    std::unique_ptr<HostBufferPool::HostBuffer> c = pool->Acquire(4096);
+  }
+  EXPECT_EQ(pool->idle_bytes(), 8192);
+  {
+    std::unique_ptr<HostBufferPool::HostBuffer> large = pool->Acquire(1 << 16);
+  }
+  EXPECT_EQ(pool->idle_bytes(), 8192);
+  pool->Clear();
+  EXPECT_EQ(pool->idle_bytes(), 0);
+}
+
+TEST(HostBufferPoolTest, BufferOutlivesPoolReference) {
+  std::unique_ptr<HostBufferPool::HostBuffer> buffer;
+  {
+    std::shared_ptr<HostBufferPool> pool = HostBufferPool::Create(1 << 20);
+    buffer = pool->Acquire(16);
+  }
+  static_cast<char*>(buffer->data())[15] = 1;
+  buffer.reset();
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
@@ -0,0 +1,152 @@
+#include "torch_xla/csrc/runtime/host_local_cache_storage.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <fstream>
+#include <string>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+
+#include "torch_xla/csrc/runtime/tf_logging.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+constexpr char kMarkerSuffix[] = ".compiling";
+
+// Whether the process which wrote the marker at `path` is gone. Markers which
+// cannot be read, e.g. being written, are assumed to be alive.
+bool IsStaleMarker(const std::filesystem::path& path) {
+  std::ifstream in(path);
+  pid_t pid = 0;
+  if (!(in >> pid) || pid <= 0) {
+    return false;
+  }
+  return kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+}  // namespace
+
+HostLocalCacheStorage::HostLocalCacheStorage(
+    std::unique_ptr<util::CacheStorage> local, std::filesystem::path dir,
+    absl::Duration wait_timeout, absl::Duration poll_interval)
+    : local_(std::move(local)),
+      dir_(std::move(dir)),
+      wait_timeout_(wait_timeout),
+      poll_interval_(poll_interval) {}
+
+HostLocalCacheStorage::~HostLocalCacheStorage() {
+  for (const std::string& name : claimed_) {
+    std::filesystem::remove(MarkerPath(name));
+  }
+}
+
+bool HostLocalCacheStorage::Contains(const std::string& name) {
+  if (local_->Contains(name)) {
+    return true;
+  }
+  if (claimed_.count(name) > 0 || timed_out_.count(name) > 0) {
+    return false;
+  }
+  absl::Time deadline = absl::Now() + wait_timeout_;
+  bool waited = false;
+  while (true) {
+    if (TryClaim(name)) {
+      // The claimer of the entry may have written it since the last lookup.
+      if (local_->Contains(name)) {
+        Release(name);
+        break;
+      }
+      TORCH_LAZY_COUNTER("HostLocalCacheClaim", 1);
+      return false;
+    }
+    if (local_->Contains(name)) {
+      break;
+    }
+    if (absl::Now() >= deadline) {
+      TF_LOG(WARNING) << "Timed out waiting for another process to compile "
+                      << name << ", compiling it instead";
+      TORCH_LAZY_COUNTER("HostLocalCacheWaitTimeout", 1);
+      timed_out_.insert(name);
+      return false;
+    }
+    waited = true;
+    absl::SleepFor(poll_interval_);
+  }
+  if (waited) {
+    TORCH_LAZY_COUNTER("HostLocalCacheWaitHit", 1);
+  }
+  return true;
+}
+
+std::optional<std::string> HostLocalCacheStorage::Read(
+    const std::string& name) {
+  return local_->Read(name);
+}
+
+void HostLocalCacheStorage::Write(const std::string& name,
+                                  const std::string& data, double cost) {
+  local_->Write(name, data, cost);
+  // The entry is written before its marker goes away, so that the waiting
+  // processes always find one of them.
+  if (claimed_.count(name) > 0) {
+    Release(name);
+  }
+}
+
+bool HostLocalCacheStorage::Remove(const std::string& name) {
+  return local_->Remove(name);
+}
+
+void HostLocalCacheStorage::Clear() {
+  claimed_.clear();
+  timed_out_.clear();
+  local_->Clear();
+}
+
+std::vector<std::pair<std::string, util::CacheIndexEntry>>
+HostLocalCacheStorage::List() const {
+  return local_->List();
+}
+
+std::filesystem::path HostLocalCacheStorage::MarkerPath(
+    const std::string& name) const {
+  return dir_ / absl::StrCat(name, kMarkerSuffix);
+}
+
+bool HostLocalCacheStorage::TryClaim(const std::string& name) {
+  std::filesystem::path path = MarkerPath(name);
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    int fd = open(path.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+    if (fd >= 0) {
+      std::string pid = absl::StrCat(getpid(), "\n");
+      if (write(fd, pid.data(), pid.size()) < 0) {
+        TF_VLOG(3) << "Failed to write the marker " << path;
+      }
+      close(fd);
+      claimed_.insert(name);
+      return true;
+    }
+    if (errno != EEXIST || !IsStaleMarker(path)) {
+      return false;
+    }
+    TF_VLOG(3) << "Taking over the stale marker " << path;
+    std::filesystem::remove(path);
+  }
+  return false;
+}
+
+void HostLocalCacheStorage::Release(const std::string& name) {
+  claimed_.erase(name);
+  std::filesystem::remove(MarkerPath(name));
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
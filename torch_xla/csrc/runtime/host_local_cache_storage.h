@@ -0,0 +1,78 @@
+#ifndef XLA_CLIENT_HOST_LOCAL_CACHE_STORAGE_H_
+#define XLA_CLIENT_HOST_LOCAL_CACHE_STORAGE_H_
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/time/time.h"
+
+#include "torch_xla/csrc/runtime/cache.h"
+
+namespace torch_xla {
+namespace runtime {
+
+// Persistent cache storage coordinating the processes of one host which share
+// its directory, such as the processes spawned one per local device, so that
+// only one of them compiles a missing entry while the others wait for it.
+//
+// The first process to miss an entry claims it, by creating a "compile in
+// progress" marker file next to it, and compiles it; the marker is removed
+// once the claimer writes the entry. The other processes missing the entry
+// meanwhile poll the directory for it, up to `wait_timeout`, and then load it
+// instead of compiling it. Markers of processes which exited without writing
+// their entry are taken over, and a process which waited out the timeout
+// compiles the entry itself.
+class HostLocalCacheStorage : public util::CacheStorage {
+ public:
+  HostLocalCacheStorage(std::unique_ptr<util::CacheStorage> local,
+                        std::filesystem::path dir, absl::Duration wait_timeout,
+                        absl::Duration poll_interval = absl::Milliseconds(50));
+
+  // Removes the markers of the entries claimed and not written.
+  ~HostLocalCacheStorage() override;
+
+  // On a miss, either claims the entry, or waits for the process which
+  // claimed it to write it.
+  bool Contains(const std::string& name) override;
+
+  std::optional<std::string> Read(const std::string& name) override;
+
+  void Write(const std::string& name, const std::string& data,
+             double cost) override;
+
+  bool Remove(const std::string& name) override;
+
+  void Clear() override;
+
+  std::vector<std::pair<std::string, util::CacheIndexEntry>> List()
+      const override;
+
+  // Returns the path of the marker of the entry `name`.
+  std::filesystem::path MarkerPath(const std::string& name) const;
+
+ private:
+  // Creates the marker of `name`, taking it over if the process which created
+  // it is gone. Returns whether the marker is now owned by this process.
+  bool TryClaim(const std::string& name);
+
+  void Release(const std::string& name);
+
+  std::unique_ptr<util::CacheStorage> local_;
+  const std::filesystem::path dir_;
+  const absl::Duration wait_timeout_;
+  const absl::Duration poll_interval_;
+  // Entries this process claimed and has not written yet.
+  std::unordered_set<std::string> claimed_;
+  // Entries this process waited out the timeout for, and compiles itself.
+  std::unordered_set<std::string> timed_out_;
+};
+
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_HOST_LOCAL_CACHE_STORAGE_H_
@@ -0,0 +1,91 @@
+#include "torch_xla/csrc/runtime/host_local_cache_storage.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+std::string MakeTempDir() {
+  char format[] = "/tmp/tmp.XXXXXX";
+  char* tmpdir = mkdtemp(format);
+  EXPECT_NE(tmpdir, nullptr);
+  return tmpdir;
+}
+
+std::unique_ptr<HostLocalCacheStorage> MakeStorage(
+    const std::string& dir, absl::Duration wait_timeout) {
+  return std::make_unique<HostLocalCacheStorage>(
+      std::make_unique<util::DiskCacheStorage>(dir, /*readonly=*/false), dir,
+      wait_timeout, /*poll_interval=*/absl::Milliseconds(5));
+}
+
+TEST(HostLocalCacheStorageTest, WaitsForTheClaimerToWriteTheEntry) {
+  std::string dir = MakeTempDir();
+  auto claimer = MakeStorage(dir, absl::Seconds(10));
+  auto waiter = MakeStorage(dir, absl::Seconds(10));
+
+  // The first miss claims the entry.
+  EXPECT_FALSE(claimer->Contains("entry"));
+  EXPECT_TRUE(std::filesystem::exists(claimer->MarkerPath("entry")));
+
+  std::thread compile([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    claimer->Write("entry", "value", /*cost=*/1.0);
+  });
+  // The other process waits for the entry instead of claiming it.
+  EXPECT_TRUE(waiter->Contains("entry"));
+  compile.join();
+  EXPECT_EQ(waiter->Read("entry"), "value");
+  EXPECT_FALSE(std::filesystem::exists(claimer->MarkerPath("entry")));
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(HostLocalCacheStorageTest, CompilesTheEntryAfterTheTimeout) {
+  std::string dir = MakeTempDir();
+  auto claimer = MakeStorage(dir, absl::Seconds(10));
+  auto waiter = MakeStorage(dir, absl::Milliseconds(20));
+
+  EXPECT_FALSE(claimer->Contains("entry"));
+  EXPECT_FALSE(waiter->Contains("entry"));
+  // The waiter does not wait again when it adds the entry it compiled.
+  EXPECT_FALSE(waiter->Contains("entry"));
+  waiter->Write("entry", "value", /*cost=*/1.0);
+  EXPECT_TRUE(claimer->Contains("entry"));
+  // The marker stays with its claimer.
+  EXPECT_TRUE(std::filesystem::exists(claimer->MarkerPath("entry")));
+
+  claimer.reset();
+  EXPECT_FALSE(std::filesystem::exists(waiter->MarkerPath("entry")));
+  std::filesystem::remove_all(dir);
+}
+
+TEST(HostLocalCacheStorageTest, TakesOverTheMarkersOfExitedProcesses) {
+  std::string dir = MakeTempDir();
+  auto storage = MakeStorage(dir, absl::Seconds(10));
+  {
+    // No process has the largest pid, which is above the kernel limit.
+    std::ofstream marker(storage->MarkerPath("entry"));
+    marker << "2147483647\n";
+  }
+
+  EXPECT_FALSE(storage->Contains("entry"));
+  storage->Write("entry", "value", /*cost=*/1.0);
+  EXPECT_FALSE(std::filesystem::exists(storage->MarkerPath("entry")));
+  EXPECT_EQ(storage->Read("entry"), "value");
+
+  std::filesystem::remove_all(dir);
+}
+
+}  // namespace
+}  // namespace runtime
+}  // namespace torch_xla
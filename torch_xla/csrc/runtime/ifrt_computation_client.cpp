@@ -6,7 +6,6 @@
 
 #include "absl/log/absl_check.h"
 #include "absl/strings/ascii.h"
-#include "absl/synchronization/blocking_counter.h"
 #include "absl/types/span.h"
 #include "tsl/profiler/lib/traceme.h"
 #include "xla/hlo/builder/xla_builder.h"
@@ -21,11 +20,13 @@
 #include "xla/python/ifrt/basic_device_list.h"
 #include "xla/python/ifrt/compiler.h"
 #include "xla/python/ifrt/device_list.h"
+#include "xla/python/ifrt/future.h"
 #include "xla/python/ifrt/memory.h"
 #include "xla/python/ifrt/sharding.h"
 #include "xla/python/pjrt_ifrt/pjrt_array.h"
 #include "xla/python/pjrt_ifrt/pjrt_attribute_map_util.h"
 #include "xla/python/pjrt_ifrt/pjrt_client.h"
+#include "xla/python/pjrt_ifrt/xla_compiler.h"
 #include "xla/python/pjrt_ifrt/xla_sharding.h"
 #include "xla/shape.h"
 
@@ -36,6 +37,7 @@
 #include "torch_xla/csrc/runtime/pjrt_registry.h"
 #include "torch_xla/csrc/runtime/stablehlo_helper.h"
 #include "torch_xla/csrc/runtime/tf_logging.h"
+#include "torch_xla/csrc/runtime/timeline.h"
 #include "torch_xla/csrc/runtime/xla_coordinator.h"
 #include "torch_xla/csrc/status.h"
 
@@ -99,6 +101,54 @@ torch::lazy::hash_t hash_comp_env(
   return hash;
 }
 
+// Reads arrays into literals, with all the copies to the host in flight at
+// once, as PjRtAsyncTransfer does for the PJRT client.
+class IfrtAsyncTransfer : public ComputationClient::AsyncTransfer {
+ public:
+  // Starts reading `array`, of device shape `shape`, into the next literal.
+  // Returns its size.
+  int64_t Add(tsl::RCReference<xla::ifrt::Array> array,
+              const xla::Shape& shape) {
+    // TODO: handle dynamic shapes
+    literals_.push_back(std::make_unique<xla::Literal>(
+        xla::ShapeUtil::DeviceShapeToHostShape(shape)));
+    xla::Literal& literal = *literals_.back();
+    std::vector<int64_t> byte_strides(literal.shape().dimensions_size());
+    XLA_CHECK_OK(xla::ShapeUtil::ByteStrides(literal.shape(),
+                                             absl::MakeSpan(byte_strides)));
+    futures_.push_back(array->CopyToHostBuffer(
+        literal.untyped_data(), byte_strides,
+        xla::ifrt::ArrayCopySemantics::kAlwaysCopy));
+    arrays_.push_back(std::move(array));
+    return literal.size_bytes();
+  }
+
+  void Join() {
+    future_ = xla::ifrt::JoinFutures(futures_);
+    futures_.clear();
+  }
+
+  bool IsReady() override { return future_->IsReady(); }
+
+  absl::StatusOr<std::vector<xla::Literal>> Await() override {
+    XLA_RETURN_IF_ERROR(future_->Await());
+    arrays_.clear();
+    std::vector<xla::Literal> literals;
+    literals.reserve(literals_.size());
+    for (std::unique_ptr<xla::Literal>& literal : literals_) {
+      literals.push_back(std::move(*literal));
+    }
+    literals_.clear();
+    return literals;
+  }
+
+ private:
+  std::vector<tsl::RCReference<xla::ifrt::Array>> arrays_;
+  std::vector<std::unique_ptr<xla::Literal>> literals_;
+  std::vector<xla::ifrt::Future<>> futures_;
+  std::optional<xla::ifrt::Future<>> future_;
+};
+
 }  // namespace
 
 std::string IfrtComputationClient::IfrtDeviceToString(
@@ -290,6 +340,7 @@ std::vector<ComputationClient::DataPtr> IfrtComputationClient::TransferToDevice(
       std::make_shared<metrics::TimedSection>(TransferToDeviceMetric());
   tsl::profiler::TraceMe activity("IfrtComputationClient::TransferToDevice",
                                   tsl::profiler::TraceMeLevel::kInfo);
+  timeline::ScopedEvent event(timeline::Phase::kTransferToDevice);
   std::vector<ComputationClient::DataPtr> datas;
   datas.reserve(tensors.size());
   int64_t total_size = 0;
@@ -298,6 +349,13 @@ std::vector<ComputationClient::DataPtr> IfrtComputationClient::TransferToDevice(
 
     total_size += xla::ShapeUtil::ByteSizeOf(tensor->shape());
 
+    // The caller may mutate its data as soon as we return.
+    xla::ifrt::Client::HostBufferSemantics semantics =
+        tensor->shares_caller_data()
+            ? xla::ifrt::Client::HostBufferSemantics::kImmutableOnlyDuringCall
+            : xla::ifrt::Client::HostBufferSemantics::
+                  kImmutableUntilTransferCompletes;
+
     tsl::RCReference<xla::ifrt::Array> buffer =
         client_
             ->MakeArrayFromHostBuffer(
@@ -307,9 +365,7 @@ std::vector<ComputationClient::DataPtr> IfrtComputationClient::TransferToDevice(
                 // TODO: what is MemoryKind?
                 xla::ifrt::SingleDeviceSharding::Create(
                     ifrt_device, xla::ifrt::MemoryKind()),
-                xla::ifrt::Client::HostBufferSemantics::
-                    kImmutableUntilTransferCompletes,
-                [tensor, timed]() { /* frees tensor and timer */ })
+                semantics, [tensor, timed]() { /* frees tensor and timer */ })
             .value();
 
     ComputationClient::DataPtr data =
@@ -443,33 +499,29 @@ IfrtComputationClient::TransferFromDevice(absl::Span<const DataPtr> handles) {
   metrics::TimedSection timed(TransferFromDeviceMetric());
   tsl::profiler::TraceMe activity("IfrtComputationClient::TransferFromDevice",
                                   tsl::profiler::TraceMeLevel::kInfo);
-  std::vector<xla::Literal> literals;
-  literals.reserve(handles.size());
+  timeline::ScopedEvent event(timeline::Phase::kTransferFromDevice);
+  return TransferFromDeviceAsync(handles)->Await();
+}
+
+std::unique_ptr<ComputationClient::AsyncTransfer>
+IfrtComputationClient::TransferFromDeviceAsync(
+    absl::Span<const DataPtr> handles) {
+  tsl::profiler::TraceMe activity(
+      "IfrtComputationClient::TransferFromDeviceAsync",
+      tsl::profiler::TraceMeLevel::kInfo);
+  auto transfer = std::make_unique<IfrtAsyncTransfer>();
   int64_t total_size = 0;
   for (const auto& handle : handles) {
     // Use XLA replication to reassemble the sharded data. If input handle
     // is not sharded, then it is a no-op.
     auto ifrt_data = std::dynamic_pointer_cast<IfrtData>(handle);
-    tsl::RCReference<xla::ifrt::Array> replicated_array =
-        ReplicateShardedData(ifrt_data);
-
-    // TODO: handle dynamic shapes
-    auto& literal = literals.emplace_back(
-        xla::ShapeUtil::DeviceShapeToHostShape(ifrt_data->shape()));
-    std::vector<int64_t> byte_strides(literal.shape().dimensions_size());
-    XLA_RETURN_IF_ERROR(xla::ShapeUtil::ByteStrides(
-        literal.shape(), absl::MakeSpan(byte_strides)));
-    XLA_RETURN_IF_ERROR(
-        replicated_array
-            ->CopyToHostBuffer(literal.untyped_data(), byte_strides,
-                               xla::ifrt::ArrayCopySemantics::kAlwaysCopy)
-            .Await());
-
-    total_size += literal.size_bytes();
+    total_size +=
+        transfer->Add(ReplicateShardedData(ifrt_data), ifrt_data->shape());
   }
+  transfer->Join();
   InboundDataMetric()->AddSample(total_size);
 
-  return literals;
+  return transfer;
 }
 
 std::vector<ComputationClient::ComputationPtr> IfrtComputationClient::Compile(
@@ -542,6 +594,50 @@ std::vector<ComputationClient::ComputationPtr> IfrtComputationClient::Compile(
   return computations;
 }
 
+std::string IfrtComputationClient::SerializeComputation(
+    const ComputationPtr computation) {
+  const IfrtComputation& ifrt_computation =
+      dynamic_cast<const IfrtComputation&>(*computation);
+  XLA_ASSIGN_OR_THROW(std::string serialized_executable,
+                      ifrt_computation.executable->Serialize());
+  return serialized_executable;
+}
+
+ComputationClient::ComputationPtr IfrtComputationClient::DeserializeComputation(
+    const std::string& serialized) {
+  auto options = std::make_unique<xla::ifrt::XlaDeserializeExecutableOptions>();
+  options->devices = xla::ifrt::BasicDeviceList::Create(
+      {client_->addressable_devices().begin(),
+       client_->addressable_devices().end()});
+  absl::StatusOr<std::shared_ptr<xla::ifrt::LoadedExecutable>> executable_or =
+      client_->GetDefaultCompiler()->DeserializeLoadedExecutable(
+          serialized, std::move(options));
+  if (!executable_or.ok()) {
+    TF_LOG(WARNING) << "Failed to deserialize executable: "
+                    << executable_or.status();
+    return nullptr;
+  }
+  std::shared_ptr<xla::ifrt::LoadedExecutable> executable =
+      std::move(executable_or.value());
+
+  auto hlo_modules = executable->GetHloModules();
+  if (!hlo_modules.ok()) {
+    TF_LOG(WARNING)
+        << "Failed to retrieve HLO modules from deserialized executable";
+    return nullptr;
+  }
+  XLA_CHECK(hlo_modules->size() == 1)
+      << "Only a single module is supported for persistent computation "
+         "caching. Please unset the XLA_PERSISTENT_CACHE_PATH "
+         "variable to disable persistent caching.";
+  xla::XlaComputation computation((*hlo_modules)[0]->ToProto());
+
+  // The IFRT client only compiles SPMD computations.
+  std::vector<std::string> devices = {spmd_device_str};
+  return std::make_shared<IfrtComputation>(std::move(computation), devices,
+                                           std::move(executable));
+}
+
 absl::StatusOr<std::vector<ComputationClient::DataPtr>>
 IfrtComputationClient::ExecuteComputation(
     const ComputationClient::Computation& computation,
@@ -571,21 +667,23 @@ IfrtComputationClient::ExecuteReplicated(
   std::vector<tsl::RCReference<xla::ifrt::Array>> argument_handles(
       arguments.size());
   {
-    absl::BlockingCounter counter(arguments.size());
+    tsl::profiler::TraceMe activity(
+        "IfrtComputationClient::ExecuteReplicated_argument_handle",
+        tsl::profiler::TraceMeLevel::kInfo);
 
     // Cost to handle one input argument. See tsl::ThreadPool::ParallelFor
-    // documentation
-    static const int32_t argument_handle_cost_ns = 1000;
+    // documentation. ParallelFor returns once all the arguments are handled.
+    static constexpr int64_t argument_handle_cost_ns = 1000;
     pool_.ParallelFor(arguments.size(), argument_handle_cost_ns,
                       [&](int64_t start, int64_t end) {
-                        for (int32_t i = start; i < end; ++i) {
-                          auto ifrt_data =
-                              std::dynamic_pointer_cast<IfrtData>(arguments[i]);
-                          argument_handles[i] = ifrt_data->buffer;
-                          counter.DecrementCount();
+                        for (int64_t i = start; i < end; ++i) {
+                          ABSL_DCHECK(dynamic_cast<const IfrtData*>(
+                                          arguments[i].get()) != nullptr);
+                          argument_handles[i] =
+                              static_cast<const IfrtData*>(arguments[i].get())
+                                  ->buffer;
                         }
                       });
-    counter.Wait();
   }
 
   xla::ifrt::ExecuteOptions execute_options;
@@ -596,10 +694,16 @@ IfrtComputationClient::ExecuteReplicated(
   TF_VLOG(5) << "ExecuteReplicated acquiring IFRT device lock for "
              << spmd_device_str << " Done";
 
-  XLA_ASSIGN_OR_RETURN(
-      xla::ifrt::LoadedExecutable::ExecuteResult result,
-      ifrt_computation.executable->Execute(absl::MakeSpan(argument_handles),
-                                           execute_options, std::nullopt));
+  xla::ifrt::LoadedExecutable::ExecuteResult result;
+  {
+    tsl::profiler::TraceMe activity(
+        "IfrtComputationClient::ExecuteReplicated_execute",
+        tsl::profiler::TraceMeLevel::kInfo);
+    XLA_ASSIGN_OR_RETURN(
+        result,
+        ifrt_computation.executable->Execute(absl::MakeSpan(argument_handles),
+                                             execute_options, std::nullopt));
+  }
 
   result.status.OnReady(std::move([timed, op_tracker = std::move(op_tracker)](
                                       absl::Status status) mutable {
@@ -620,20 +724,20 @@ IfrtComputationClient::ExecuteReplicated(
 
   std::vector<ComputationClient::DataPtr> data_handles(outputs.size());
   {
-    absl::BlockingCounter counter(outputs.size());
+    tsl::profiler::TraceMe activity(
+        "IfrtComputationClient::ExecuteReplicated_result_handle",
+        tsl::profiler::TraceMeLevel::kInfo);
 
     // Cost to handle one output. See tsl::ThreadPool::ParallelFor
     // documentation.
-    static const int32_t result_handle_cost_ns = 2000;
+    static constexpr int64_t result_handle_cost_ns = 2000;
     pool_.ParallelFor(outputs.size(), result_handle_cost_ns,
                       [&](int64_t start, int64_t end) {
-                        for (int32_t i = start; i < end; ++i) {
+                        for (int64_t i = start; i < end; ++i) {
                           data_handles[i] = std::make_shared<IfrtData>(
                               spmd_device_str, outputs[i], output_shardings[i]);
-                          counter.DecrementCount();
                         }
                       });
-    counter.Wait();
   }
 
   TF_VLOG(1) << "Returning " << data_handles.size() << " sharded outputs.";
@@ -705,8 +809,20 @@ xla::ifrt::Device* IfrtComputationClient::StringToIfrtDevice(
 void IfrtComputationClient::WaitDeviceOps(
     absl::Span<const std::string> devices) {
   TF_VLOG(3) << "Waiting for " << absl::StrJoin(devices, ", ");
-  operation_manager_.WaitForDevices(devices.empty() ? GetLocalDevices()
-                                                    : devices);
+  XLA_ASSIGN_OR_THROW(absl::Duration waited,
+                      operation_manager_.WaitForDevices(
+                          devices.empty() ? GetLocalDevices() : devices));
+  TF_VLOG(3) << "Waited " << absl::FormatDuration(waited)
+             << " for the device operations";
+}
+
+void IfrtComputationClient::OnReadyCallback(
+    ComputationClient::DataPtr data, const std::function<void()>& callback) {
+  auto ifrt_data = std::dynamic_pointer_cast<IfrtData>(data);
+  XLA_CHECK(ifrt_data) << "received invalid data pointer";
+  XLA_CHECK(ifrt_data->buffer) << "received placeholder data as argument";
+  ifrt_data->buffer->GetReadyFuture().OnReady(
+      [callback](absl::Status unused) { callback(); });
 }
 
 std::map<std::string, Metric> IfrtComputationClient::GetMetrics() const {
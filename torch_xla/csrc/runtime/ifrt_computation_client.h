@@ -66,6 +66,9 @@ class IfrtComputationClient : public ComputationClient {
   absl::StatusOr<std::vector<xla::Literal>> TransferFromDevice(
       absl::Span<const DataPtr> handles) override;
 
+  std::unique_ptr<AsyncTransfer> TransferFromDeviceAsync(
+      absl::Span<const DataPtr> handles) override;
+
   std::uintptr_t UnsafeBufferPointer(const DataPtr handle) override;
 
   std::shared_ptr<xla::PjRtBuffer> GetPjRtBuffer(const DataPtr handle) override;
@@ -76,9 +79,22 @@ class IfrtComputationClient : public ComputationClient {
 
   DataPtr CopyToDevice(DataPtr data, std::string dst) override;
 
+  absl::StatusOr<DataPtr> CopyToMemoryKind(
+      DataPtr data, const std::string& memory_kind) override {
+    XLA_ERROR() << __FUNCTION__ << " not implemented";
+  }
+
+  std::string GetMemoryKind(DataPtr data) override {
+    XLA_ERROR() << __FUNCTION__ << " not implemented";
+  }
+
   std::vector<ComputationPtr> Compile(
       std::vector<CompileInstance> instances) override;
 
+  std::string SerializeComputation(const ComputationPtr computation) override;
+
+  ComputationPtr DeserializeComputation(const std::string& serialized) override;
+
   absl::StatusOr<std::vector<DataPtr>> ExecuteComputation(
       const Computation& computation, absl::Span<const DataPtr> arguments,
       const std::string& device,
@@ -154,24 +170,13 @@ class IfrtComputationClient : public ComputationClient {
     XLA_ERROR() << __FUNCTION__ << " not implemented";
   }
 
-  std::string SerializeComputation(const ComputationPtr computation) override {
-    XLA_ERROR() << __FUNCTION__ << " not implemented";
-  }
-
-  ComputationPtr DeserializeComputation(
-      const std::string& serialized) override {
-    XLA_ERROR() << __FUNCTION__ << " not implemented";
-  }
-
   void RegisterCustomCall(const std::string& fn_name, void* function_ptr,
                           const std::string& platform) override {
     XLA_ERROR() << __FUNCTION__ << " not implemented";
   };
 
   void OnReadyCallback(DataPtr data,
-                       const std::function<void()>& callback) override {
-    XLA_ERROR() << __FUNCTION__ << " not implemented";
-  }
+                       const std::function<void()>& callback) override;
 
   void SetCustomCompileOptions(
       const std::unordered_map<std::string, std::string>& options) override {
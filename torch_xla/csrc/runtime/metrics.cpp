@@ -85,6 +85,17 @@ void EmitCounterInfo(const std::string& name, CounterData* data,
 
 }  // namespace
 
+namespace internal {
+
+std::atomic<bool> metrics_enabled(
+    !sys_util::GetEnvBool("XLA_METRICS_DISABLED", false));
+
+}  // namespace internal
+
+void SetMetricsEnabled(bool enabled) {
+  internal::metrics_enabled.store(enabled, std::memory_order_relaxed);
+}
+
 MetricsArena* MetricsArena::Get() {
   static MetricsArena* arena = new MetricsArena();
   return arena;
@@ -164,66 +175,104 @@ CounterData* MetricsArena::GetCounter(const std::string& name) {
 }
 
 void MetricsArena::ClearCounters() {
+  std::lock_guard<std::mutex> lock(lock_);
   for (auto& counter : counters_) {
     counter.second->Clear();
   }
 }
 
 void MetricsArena::ClearMetrics() {
+  std::lock_guard<std::mutex> lock(lock_);
   for (auto& metrics : metrics_) {
     metrics.second->Clear();
   }
 }
 
 MetricData::MetricData(MetricReprFn repr_fn, size_t max_samples)
-    : repr_fn_(std::move(repr_fn)), samples_(max_samples) {}
+    : repr_fn_(std::move(repr_fn)),
+      samples_(new Slot[max_samples]),
+      max_samples_(max_samples) {}
 
 void MetricData::AddSample(int64_t timestamp_ns, double value) {
-  std::lock_guard<std::mutex> lock(lock_);
-  size_t position = count_ % samples_.size();
-  ++count_;
-  accumulator_ += value;
-  samples_[position] = Sample(timestamp_ns, value);
+  size_t index = count_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = samples_[index % max_samples_];
+  slot.sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.timestamp_ns.store(timestamp_ns, std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.sequence.store(index + 1, std::memory_order_release);
+
+  double accumulator = accumulator_.load(std::memory_order_relaxed);
+  while (!accumulator_.compare_exchange_weak(accumulator, accumulator + value,
+                                             std::memory_order_relaxed)) {
+  }
 }
 
 double MetricData::Accumulator() const {
-  std::lock_guard<std::mutex> lock(lock_);
-  return accumulator_;
+  return accumulator_.load(std::memory_order_relaxed);
 }
 
 size_t MetricData::TotalSamples() const {
-  std::lock_guard<std::mutex> lock(lock_);
-  return count_;
+  return count_.load(std::memory_order_relaxed);
 }
 
 void MetricData::Clear() {
-  std::lock_guard<std::mutex> lock(lock_);
-  count_ = 0;
-  accumulator_ = 0.0;
-  samples_ = std::vector<Sample>(samples_.size());
+  count_.store(0, std::memory_order_relaxed);
+  accumulator_.store(0.0, std::memory_order_relaxed);
+  for (size_t i = 0; i < max_samples_; ++i) {
+    samples_[i].sequence.store(0, std::memory_order_relaxed);
+  }
 }
 
 std::vector<Sample> MetricData::Samples(double* accumulator,
                                         size_t* total_samples) const {
-  std::lock_guard<std::mutex> lock(lock_);
+  size_t count = count_.load(std::memory_order_acquire);
+  size_t start = count > max_samples_ ? count - max_samples_ : 0;
   std::vector<Sample> samples;
-  if (count_ <= samples_.size()) {
-    samples.insert(samples.end(), samples_.begin(), samples_.begin() + count_);
-  } else {
-    size_t position = count_ % samples_.size();
-    samples.insert(samples.end(), samples_.begin() + position, samples_.end());
-    samples.insert(samples.end(), samples_.begin(),
-                   samples_.begin() + position);
+  samples.reserve(count - start);
+  for (size_t index = start; index < count; ++index) {
+    const Slot& slot = samples_[index % max_samples_];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    Sample sample(slot.timestamp_ns.load(std::memory_order_relaxed),
+                  slot.value.load(std::memory_order_relaxed));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Skip the samples which are being written or were overwritten by newer
+    // ones while being read.
+    if (sequence == index + 1 &&
+        slot.sequence.load(std::memory_order_relaxed) == sequence) {
+      samples.push_back(sample);
+    }
   }
   if (accumulator != nullptr) {
-    *accumulator = accumulator_;
+    *accumulator = Accumulator();
   }
   if (total_samples != nullptr) {
-    *total_samples = count_;
+    *total_samples = count;
   }
   return samples;
 }
 
+int64_t CounterData::Value() const {
+  int64_t value = 0;
+  for (const Shard& shard : shards_) {
+    value += shard.value.load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+void CounterData::Clear() {
+  for (Shard& shard : shards_) {
+    shard.value.store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t CounterData::ShardIndex() {
+  static std::atomic<size_t> next_shard(0);
+  thread_local size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+  return shard;
+}
+
 Metric::Metric(std::string name, MetricReprFn repr_fn, size_t max_samples)
     : name_(std::move(name)),
       repr_fn_(std::move(repr_fn)),
@@ -235,11 +284,15 @@ Metric::Metric(std::string name, MetricReprFn repr_fn, size_t max_samples)
 double Metric::Accumulator() const { return GetData()->Accumulator(); }
 
 void Metric::AddSample(int64_t timestamp_ns, double value) {
-  GetData()->AddSample(timestamp_ns, value);
+  if (MetricsEnabled()) {
+    GetData()->AddSample(timestamp_ns, value);
+  }
 }
 
 void Metric::AddSample(double value) {
-  GetData()->AddSample(sys_util::NowNs(), value);
+  if (MetricsEnabled()) {
+    GetData()->AddSample(sys_util::NowNs(), value);
+  }
 }
 
 std::vector<Sample> Metric::Samples(double* accumulator,
@@ -1,6 +1,7 @@
 #ifndef XLA_CLIENT_METRICS_H_
 #define XLA_CLIENT_METRICS_H_
 
+#include <array>
 #include <atomic>
 #include <map>
 #include <memory>
@@ -28,8 +29,28 @@ struct Sample {
 
 using MetricReprFn = std::function<std::string(double)>;
 
+namespace internal {
+
+extern std::atomic<bool> metrics_enabled;
+
+}  // namespace internal
+
+// Whether samples and counter updates are recorded. Metrics are disabled by
+// setting $XLA_METRICS_DISABLED, or at run time with SetMetricsEnabled(), in
+// which case recording them, timed sections included, costs a single branch.
+inline bool MetricsEnabled() {
+  return internal::metrics_enabled.load(std::memory_order_relaxed);
+}
+
+void SetMetricsEnabled(bool enabled);
+
 // Class used to collect time-stamped numeric samples. The samples are stored in
 // a circular buffer whose size can be configured at constructor time.
+//
+// Posting a sample never blocks: writers claim a slot of the buffer with an
+// atomic increment, and readers skip the slots which are being overwritten
+// while they are read. Samples(), the accumulator and the count are hence
+// only consistent with each other when no sample is posted concurrently.
 class MetricData {
  public:
   // Creates a new MetricData object with the internal circular buffer storing
@@ -55,27 +76,46 @@ class MetricData {
   void Clear();
 
  private:
-  mutable std::mutex lock_;
+  // A slot of the circular buffer. The sequence is 0 while the slot is
+  // empty or being written, and otherwise 1 + the index of the sample it
+  // holds, so that readers recognize both torn and overwritten samples.
+  struct Slot {
+    std::atomic<size_t> sequence{0};
+    std::atomic<int64_t> timestamp_ns{0};
+    std::atomic<double> value{0};
+  };
+
   MetricReprFn repr_fn_;
-  size_t count_ = 0;
-  std::vector<Sample> samples_;
-  double accumulator_ = 0.0;
+  std::atomic<size_t> count_{0};
+  std::unique_ptr<Slot[]> samples_;
+  size_t max_samples_;
+  std::atomic<double> accumulator_{0.0};
 };
 
 // Counters are a very lightweight form of metrics which do not need to track
-// sample time.
+// sample time. The value is sharded over cache lines, with threads spread
+// over the shards, so that counters hit from many threads do not bounce a
+// single cache line between cores. Reading a counter sums the shards.
 class CounterData {
  public:
-  CounterData() : value_(0) {}
-
-  void AddValue(int64_t value) { value_ += value; }
+  void AddValue(int64_t value) {
+    shards_[ShardIndex()].value.fetch_add(value, std::memory_order_relaxed);
+  }
 
-  int64_t Value() const { return value_; }
+  int64_t Value() const;
 
-  void Clear() { value_ = 0; }
+  void Clear();
 
  private:
-  std::atomic<int64_t> value_;
+  static constexpr size_t kNumShards = 16;
+
+  struct alignas(64) Shard {
+    std::atomic<int64_t> value{0};
+  };
+
+  static size_t ShardIndex();
+
+  std::array<Shard, kNumShards> shards_;
 };
 
 class MetricsArena {
@@ -167,7 +207,11 @@ class Counter {
  public:
   explicit Counter(std::string name);
 
-  void AddValue(int64_t value) { GetData()->AddValue(value); }
+  void AddValue(int64_t value) {
+    if (MetricsEnabled()) {
+      GetData()->AddValue(value);
+    }
+  }
 
   int64_t Value() const { return GetData()->Value(); }
 
@@ -233,15 +277,18 @@ void ClearMetrics();
 class TimedSection {
  public:
   explicit TimedSection(Metric* metric)
-      : metric_(metric), start_(sys_util::NowNs()) {}
+      : metric_(metric), start_(MetricsEnabled() ? sys_util::NowNs() : 0) {}
 
   ~TimedSection() {
-    int64_t now = sys_util::NowNs();
-    metric_->AddSample(now, now - start_);
+    if (start_ != 0) {
+      int64_t now = sys_util::NowNs();
+      metric_->AddSample(now, now - start_);
+    }
   }
 
   double Elapsed() const {
-    return 1e-9 * static_cast<double>(sys_util::NowNs() - start_);
+    return start_ != 0 ? 1e-9 * static_cast<double>(sys_util::NowNs() - start_)
+                       : 0.0;
   }
 
  private:
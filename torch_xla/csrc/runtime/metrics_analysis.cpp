@@ -1,6 +1,9 @@
 #include "torch_xla/csrc/runtime/metrics_analysis.h"
 
+#include <algorithm>
+
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/types/variant.h"
 
@@ -184,6 +187,78 @@ class UnloweredOp : public Analyzer {
   }
 };
 
+// Reports the costs of the CPU fallbacks, from the most expensive operator,
+// as accounted by aten_fallback.cpp in the `<op>/<phase>Time` and
+// `<op>/<phase>Bytes` metrics.
+class FallbackCost : public Analyzer {
+ public:
+  Analysis Run() override {
+    std::vector<OpCost> costs;
+    for (const std::string& name : MetricsArena::Get()->GetCounterNames()) {
+      if (!absl::StartsWith(name, "aten::")) {
+        continue;
+      }
+      MetricData* cpu_time = GetMetric(absl::StrCat(name, "/CpuTime"));
+      if (cpu_time == nullptr) {
+        continue;
+      }
+      OpCost& cost = costs.emplace_back();
+      cost.name = name;
+      cost.total_ns = cpu_time->Accumulator();
+      std::stringstream ss;
+      ss << name << " (" << cpu_time->TotalSamples() << " calls";
+      for (const char* phase : {"Sync", "TransferFromDevice"}) {
+        AppendPhase(name, phase, &cost, &ss);
+      }
+      ss << ", Cpu " << MetricFnTime(cpu_time->Accumulator());
+      AppendPhase(name, "TransferToDevice", &cost, &ss);
+      ss << ")";
+      cost.repr = ss.str();
+    }
+    if (costs.empty()) {
+      return {Analysis::Symptom::kNormal};
+    }
+    std::sort(costs.begin(), costs.end(),
+              [](const OpCost& lhs, const OpCost& rhs) {
+                return lhs.total_ns > rhs.total_ns;
+              });
+    std::stringstream ss;
+    for (const OpCost& cost : costs) {
+      ss << cost.repr << ", ";
+    }
+    return {Analysis::Symptom::kFallbackCost,
+            absl::StrCat(kAnalysisPrefix,
+                         ": CPU fallback costs, from the most expensive: ",
+                         ss.str(),
+                         " Lowering the first op(s) would save the most.")};
+  }
+
+ private:
+  struct OpCost {
+    std::string name;
+    double total_ns = 0;
+    std::string repr;
+  };
+
+  static void AppendPhase(const std::string& name, const char* phase,
+                          OpCost* cost, std::stringstream* ss) {
+    MetricData* time = GetMetric(absl::StrCat(name, "/", phase, "Time"));
+    if (time == nullptr) {
+      return;
+    }
+    cost->total_ns += time->Accumulator();
+    (*ss) << ", " << phase << " " << MetricFnTime(time->Accumulator());
+    if (std::string_view(phase) == "Sync") {
+      (*ss) << " in " << time->TotalSamples() << " syncs";
+      return;
+    }
+    MetricData* bytes = GetMetric(absl::StrCat(name, "/", phase, "Bytes"));
+    if (bytes != nullptr) {
+      (*ss) << " for " << MetricFnBytes(bytes->Accumulator());
+    }
+  }
+};
+
 std::vector<Analyzer*>* GetAnalyzers() {
   static std::vector<Analyzer*>* analyzers = new std::vector<Analyzer*>{
       new MetricFrequency("CompileTime", 0.5f, 10),
@@ -191,6 +266,7 @@ std::vector<Analyzer*>* GetAnalyzers() {
       new MetricTime("CompileTime", 300e9),
       new MetricTime("ExecuteTime", 30e9),
       new UnloweredOp(),
+      new FallbackCost(),
       new XrtMetricFrequency({{"XrtTryFreeMemory", 0.1f},
                               {"XrtCompaction", 0.1f},
                               {"XrtExecutorEvict", 0.1f}},
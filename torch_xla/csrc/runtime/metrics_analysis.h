@@ -20,6 +20,7 @@ namespace metrics {
 // - Frequent XLA->CPU transfers
 // - Device HBM to host RAM swapping and HBM defragmentation
 // - Unlowered aten:: ops
+// - Costs of the CPU fallbacks of the unlowered ops
 
 struct Analysis {
   enum class Symptom {
@@ -27,6 +28,7 @@ struct Analysis {
     kMetricTooFrequent,
     kMetricTooSlow,
     kUnloweredOp,
+    kFallbackCost,
   };
 
   Analysis() = default;
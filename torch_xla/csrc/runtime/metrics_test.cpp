@@ -0,0 +1,86 @@
+#include "torch_xla/csrc/runtime/metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace torch_xla {
+namespace runtime {
+namespace metrics {
+namespace {
+
+TEST(MetricsTest, CounterSumsUpdatesFromAllThreads) {
+  Counter counter("MetricsTestCounter");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 1000; ++j) {
+        counter.AddValue(1);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.Value(), 8000);
+  EXPECT_EQ(GetCounter("MetricsTestCounter")->Value(), 8000);
+}
+
+TEST(MetricsTest, MetricKeepsTheLatestSamples) {
+  Metric metric("MetricsTestMetric", MetricFnValue, /*max_samples=*/4);
+  for (int i = 1; i <= 6; ++i) {
+    metric.AddSample(/*timestamp_ns=*/i, i);
+  }
+  double accumulator = 0;
+  size_t total_samples = 0;
+  std::vector<Sample> samples = metric.Samples(&accumulator, &total_samples);
+  EXPECT_EQ(accumulator, 21);
+  EXPECT_EQ(total_samples, 6u);
+  ASSERT_EQ(samples.size(), 4u);
+  for (size_t i = 0; i < samples.size(); ++i) {
+    EXPECT_EQ(samples[i].timestamp_ns, static_cast<int64_t>(i) + 3);
+    EXPECT_EQ(samples[i].value, static_cast<double>(i) + 3);
+  }
+}
+
+TEST(MetricsTest, ConcurrentSamplesAreAllAccounted) {
+  Metric metric("MetricsTestConcurrentMetric", MetricFnValue,
+                /*max_samples=*/16);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 1000; ++j) {
+        metric.AddSample(1.0);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  double accumulator = 0;
+  size_t total_samples = 0;
+  std::vector<Sample> samples = metric.Samples(&accumulator, &total_samples);
+  EXPECT_EQ(accumulator, 4000);
+  EXPECT_EQ(total_samples, 4000u);
+  EXPECT_EQ(samples.size(), 16u);
+}
+
+TEST(MetricsTest, DisabledMetricsAreNotRecorded) {
+  Counter counter("MetricsTestDisabledCounter");
+  Metric metric("MetricsTestDisabledMetric");
+  SetMetricsEnabled(false);
+  counter.AddValue(1);
+  metric.AddSample(1.0);
+  {
+    TimedSection timed(&metric);
+  }
+  SetMetricsEnabled(true);
+  EXPECT_EQ(counter.Value(), 0);
+  EXPECT_TRUE(metric.Samples(nullptr, nullptr).empty());
+}
+
+}  // namespace
+}  // namespace metrics
+}  // namespace runtime
+}  // namespace torch_xla
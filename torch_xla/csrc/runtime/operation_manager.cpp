@@ -1,7 +1,7 @@
 #include "torch_xla/csrc/runtime/operation_manager.h"
 
-#include <shared_mutex>
-
+#include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 
 #include "torch_xla/csrc/runtime/debug_macros.h"
@@ -12,7 +12,9 @@ namespace runtime {
 
 OperationManager::OperationManager(absl::Span<const std::string> devices) {
   for (auto& device : devices) {
-    op_counters_.try_emplace(device, device);
+    if (device_indices_.try_emplace(device, op_counters_.size()).second) {
+      op_counters_.push_back(std::make_unique<Counter>(device));
+    }
   }
 }
 
@@ -26,58 +28,125 @@ OperationManager::OperationTracker::~OperationTracker() {
   counter_->Decrement();
 }
 
+size_t OperationManager::GetDeviceIndex(const std::string& device) const {
+  auto it = device_indices_.find(device);
+  XLA_CHECK(it != device_indices_.end()) << "Unknown device " << device;
+  return it->second;
+}
+
+std::unique_ptr<OperationManager::OperationTracker>
+OperationManager::StartOperation(const std::string& device) {
+  return StartOperation(GetDeviceIndex(device));
+}
+
 std::unique_ptr<OperationManager::OperationTracker>
-OperationManager::StartOperation(std::string device) {
-  return std::make_unique<OperationTracker>(&op_counters_.at(device));
+OperationManager::StartOperation(size_t device_index) {
+  XLA_CHECK_LT(device_index, op_counters_.size());
+  return std::make_unique<OperationTracker>(op_counters_[device_index].get());
 }
 
-void OperationManager::WaitForDevices(absl::Span<const std::string> devices) {
-  std::vector<std::unique_lock<std::shared_mutex>> locks;
-  locks.reserve(devices.size());
+absl::StatusOr<absl::Duration> OperationManager::WaitForDevices(
+    absl::Span<const std::string> devices, absl::Duration timeout) {
+  absl::Time start = absl::Now();
+  absl::Time deadline = start + timeout;
+  std::vector<Counter*> blocked;
+  blocked.reserve(devices.size());
+  absl::Status status;
 
   for (const std::string& device_str : devices) {
+    Counter* counter = op_counters_[GetDeviceIndex(device_str)].get();
     TF_VLOG(5) << "Blocking new operations on " << device_str;
-    auto lock = op_counters_.at(device_str).BlockNewOperations();
-    locks.emplace_back(std::move(lock));
+    counter->BlockNewOperations();
+    blocked.push_back(counter);
 
     TF_VLOG(3) << "Waiting for device execution for " << device_str
                << " to finish";
-    op_counters_.at(device_str).Wait();
+    if (!counter->Wait(deadline)) {
+      status = absl::DeadlineExceededError(
+          absl::StrCat("Timed out after ", absl::FormatDuration(timeout),
+                       " waiting for the operations on ", device_str));
+      break;
+    }
     TF_VLOG(3) << "Finished operations on device " << device_str;
   }
+  for (Counter* counter : blocked) {
+    counter->UnblockNewOperations();
+  }
+  if (!status.ok()) {
+    return status;
+  }
+  return absl::Now() - start;
 }
 
 void OperationManager::Counter::Increment() {
-  // Block new operations after BlockNewOperations() is called. count_ is
-  // already atomic, so atomic so we don't need an exclusive lock to prevent
-  // data races.
-  std::shared_lock lock(pending_operations_mu_);
-  auto current = count_.fetch_add(1, std::memory_order_acq_rel) + 1;
-  TF_VLOG(5) << "Incremented operations for " << device_ << " to " << current;
+  while (true) {
+    // Optimistically register the operation, and back off if new operations
+    // got blocked meanwhile. All the accesses are sequentially consistent, so
+    // either the blocker sees the operation, or the operation sees the
+    // blocker.
+    if (blockers_.load() == 0) {
+      auto current = count_.fetch_add(1) + 1;
+      if (blockers_.load() == 0) {
+        TF_VLOG(5) << "Incremented operations for " << device_ << " to "
+                   << current;
+        return;
+      }
+      Decrement();
+    }
+    waiters_.fetch_add(1);
+    {
+      std::unique_lock cv_lock(cv_mu_);
+      cv_.wait(cv_lock, [this] { return blockers_.load() == 0; });
+    }
+    waiters_.fetch_sub(1);
+  }
 }
 
 void OperationManager::Counter::Decrement() {
-  auto current = count_.fetch_sub(1, std::memory_order_acq_rel) - 1;
+  auto current = count_.fetch_sub(1) - 1;
   TF_VLOG(5) << "Decremented operations for " << device_ << " to " << current;
 
   if (current == 0) {
-    std::unique_lock cv_lock(cv_mu_);
     TF_VLOG(3) << "All operations complete for " << device_;
-    cv_.notify_all();
+    NotifyWaiters();
   }
 }
 
-std::unique_lock<std::shared_mutex>
-OperationManager::Counter::BlockNewOperations() {
-  return std::unique_lock(pending_operations_mu_);
+void OperationManager::Counter::BlockNewOperations() { blockers_.fetch_add(1); }
+
+void OperationManager::Counter::UnblockNewOperations() {
+  if (blockers_.fetch_sub(1) == 1) {
+    NotifyWaiters();
+  }
 }
 
-void OperationManager::Counter::Wait() {
+void OperationManager::Counter::NotifyWaiters() {
+  // A waiter registers itself before checking its condition under the lock,
+  // so taking the lock here guarantees it is either woken up, or sees the
+  // updated count.
+  if (waiters_.load() > 0) {
+    std::lock_guard cv_lock(cv_mu_);
+    cv_.notify_all();
+  }
+}
+
+bool OperationManager::Counter::Wait(absl::Time deadline) {
   TF_VLOG(5) << "Waiting for " << count_ << " operations on " << device_;
-  std::unique_lock cv_lock(cv_mu_);
-  cv_.wait(cv_lock,
-           [this] { return count_.load(std::memory_order_acquire) == 0; });
+  auto done = [this] { return count_.load() == 0; };
+  bool completed = true;
+  waiters_.fetch_add(1);
+  {
+    std::unique_lock cv_lock(cv_mu_);
+    if (deadline == absl::InfiniteFuture()) {
+      cv_.wait(cv_lock, done);
+    } else {
+      completed =
+          cv_.wait_until(cv_lock, absl::ToChronoTime(deadline), done);
+    }
+  }
+  waiters_.fetch_sub(1);
   TF_VLOG(5) << "Done waiting for " << device_;
+  return completed;
 }
 
 }  // namespace runtime
@@ -3,10 +3,15 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <memory>
 #include <mutex>
-#include <shared_mutex>
+#include <string>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/statusor.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
 
 namespace torch_xla {
@@ -31,24 +36,33 @@ class OperationManager {
     Counter(const Counter&) = delete;
     Counter& operator=(const Counter&) = delete;
 
-    // Register a new operation. Blocks if `BlockNewOperations` has been called.
+    // Register a new operation. Blocks if new operations are blocked by
+    // `BlockNewOperations`, and is lock free otherwise.
     void Increment();
 
-    // Mark an inflight task completed.
+    // Mark an inflight task completed. Only takes a lock to wake up waiters.
     void Decrement();
 
-    // Wait until all operations are complete. Does not block new operations
-    // (see BlockNewOperations).
-    void Wait();
+    // Wait until all operations are complete, or until `deadline`. Returns
+    // false on timeout. Does not block new operations (see
+    // BlockNewOperations).
+    bool Wait(absl::Time deadline = absl::InfiniteFuture());
 
-    // Returns a lock that prevents new operations on the device.
-    std::unique_lock<std::shared_mutex> BlockNewOperations();
+    // Prevents new operations on the device until `UnblockNewOperations` is
+    // called. Calls may be nested.
+    void BlockNewOperations();
+
+    void UnblockNewOperations();
 
    private:
+    // Wakes up the threads blocked in `Increment` or `Wait`, if any.
+    void NotifyWaiters();
+
     std::string device_;
 
-    std::shared_mutex pending_operations_mu_;
     std::atomic<int64_t> count_{0};
+    std::atomic<int64_t> blockers_{0};
+    std::atomic<int64_t> waiters_{0};
 
     std::mutex cv_mu_;
     std::condition_variable cv_;
@@ -66,18 +80,27 @@ class OperationManager {
     OperationTracker& operator=(const OperationTracker&) = delete;
 
    private:
-    std::string device_;
     Counter* counter_;
   };
 
+  // Returns the index of `device`, which can be passed to `StartOperation`
+  // to skip the device lookup.
+  size_t GetDeviceIndex(const std::string& device) const;
+
   // Register a new operation for `device`.
-  std::unique_ptr<OperationTracker> StartOperation(std::string device);
+  std::unique_ptr<OperationTracker> StartOperation(const std::string& device);
+
+  std::unique_ptr<OperationTracker> StartOperation(size_t device_index);
 
-  // Wait for all device execution to complete on devices.
-  void WaitForDevices(absl::Span<const std::string> devices);
+  // Wait for all device execution to complete on devices, for at most
+  // `timeout`. Returns the time spent waiting, or a DeadlineExceeded error.
+  absl::StatusOr<absl::Duration> WaitForDevices(
+      absl::Span<const std::string> devices,
+      absl::Duration timeout = absl::InfiniteDuration());
 
  private:
-  std::unordered_map<std::string, Counter> op_counters_;
+  absl::flat_hash_map<std::string, size_t> device_indices_;
+  std::vector<std::unique_ptr<Counter>> op_counters_;
 };
 
 }  // namespace runtime
@@ -0,0 +1,68 @@
+#include "torch_xla/csrc/runtime/operation_manager.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace torch_xla {
+namespace runtime {
+
+TEST(OperationManagerTest, DeviceIndices) {
+  OperationManager manager(std::vector<std::string>({"TPU:0", "TPU:1"}));
+  EXPECT_EQ(manager.GetDeviceIndex("TPU:0"), 0);
+  EXPECT_EQ(manager.GetDeviceIndex("TPU:1"), 1);
+}
+
+TEST(OperationManagerTest, WaitsForInflightOperations) {
+  OperationManager manager(std::vector<std::string>({"TPU:0", "TPU:1"}));
+  auto tracker = manager.StartOperation(manager.GetDeviceIndex("TPU:0"));
+  std::thread finisher([&]() {
+    absl::SleepFor(absl::Milliseconds(50));
+    tracker.reset();
+  });
+  absl::StatusOr<absl::Duration> waited = manager.WaitForDevices({"TPU:0"});
+  finisher.join();
+  ASSERT_TRUE(waited.ok());
+  EXPECT_GE(*waited, absl::Milliseconds(40));
+}
+
+TEST(OperationManagerTest, WaitTimesOut) {
+  OperationManager manager(std::vector<std::string>({"TPU:0"}));
+  auto tracker = manager.StartOperation("TPU:0");
+  absl::StatusOr<absl::Duration> waited =
+      manager.WaitForDevices({"TPU:0"}, absl::Milliseconds(10));
+  EXPECT_EQ(waited.status().code(), absl::StatusCode::kDeadlineExceeded);
+  // New operations are unblocked after the timeout.
+  auto other_tracker = manager.StartOperation("TPU:0");
+}
+
+TEST(OperationManagerTest, BlocksNewOperationsWhileWaiting) {
+  OperationManager manager(std::vector<std::string>({"TPU:0"}));
+  auto tracker = manager.StartOperation("TPU:0");
+  std::atomic<bool> started{false};
+  std::thread waiter(
+      [&]() { EXPECT_TRUE(manager.WaitForDevices({"TPU:0"}).ok()); });
+  // Let the waiter block new operations, then start one from another thread.
+  absl::SleepFor(absl::Milliseconds(20));
+  std::thread starter([&]() {
+    manager.StartOperation("TPU:0");
+    started = true;
+  });
+  absl::SleepFor(absl::Milliseconds(20));
+  EXPECT_FALSE(started);
+  tracker.reset();
+  waiter.join();
+  starter.join();
+  EXPECT_TRUE(started);
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
@@ -1,9 +1,14 @@
 #include "torch_xla/csrc/runtime/pjrt_computation_client.h"
 
 #include <algorithm>
+#include <exception>
+#include <map>
+#include <numeric>
+#include <optional>
 #include <stdexcept>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/log/absl_check.h"
 #include "absl/strings/ascii.h"
 #include "absl/synchronization/blocking_counter.h"
@@ -11,6 +16,7 @@
 #include "tsl/profiler/lib/traceme.h"
 #include "xla/hlo/builder/xla_builder.h"
 #include "xla/hlo/builder/xla_computation.h"
+#include "xla/hlo/ir/hlo_sharding.h"
 #include "xla/literal.h"
 #include "xla/pjrt/c/pjrt_c_api_wrapper_impl.h"
 #include "xla/pjrt/pjrt_api.h"
@@ -19,16 +25,20 @@
 #include "xla/pjrt/pjrt_executable.h"
 #include "xla/service/custom_call_target_registry.h"
 #include "xla/shape.h"
+#include "xla/shape_util.h"
 
+#include "torch_xla/csrc/runtime/buffer_deleter.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/env_hash.h"
 #include "torch_xla/csrc/runtime/env_vars.h"
+#include "torch_xla/csrc/runtime/host_buffer_pool.h"
 #include "torch_xla/csrc/runtime/pjrt_registry.h"
 #include "torch_xla/csrc/runtime/stablehlo_helper.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/tensor_source.h"
 #include "torch_xla/csrc/runtime/tf_logging.h"
+#include "torch_xla/csrc/runtime/timeline.h"
 #include "torch_xla/csrc/runtime/util.h"
 #include "torch_xla/csrc/runtime/xla_coordinator.h"
 #include "torch_xla/csrc/status.h"
@@ -40,6 +50,14 @@ using xla::internal::XlaBuilderFriend;
 
 namespace {
 
+// Waits for the release of the buffers pending deletion, whose memory the
+// next allocations may need.
+void FlushBufferDeletions() {
+  if (BufferDeleter* deleter = BufferDeleter::Get()) {
+    deleter->Flush();
+  }
+}
+
 // Builds a map from the device's global ordinal to its index in the `devices`
 // array.
 std::unordered_map<int, int> build_index_map(
@@ -94,6 +112,219 @@ torch::lazy::hash_t hash_comp_env(
   return hash;
 }
 
+// Region of a sharded value held by one of its shards.
+struct ShardTile {
+  size_t shard;
+  std::vector<int64_t> offset;
+  std::vector<int64_t> sizes;
+};
+
+// Returns, for a value of `shape` tiled by `sharding`, one shard holding each
+// of its tiles, or nullopt if the sharding is not a plain tiling or some tiles
+// are not held by the `shard_devices`.
+std::optional<std::vector<ShardTile>> GetShardTiles(
+    const xla::OpSharding& sharding, const xla::Shape& shape,
+    absl::Span<const std::string> shard_devices) {
+  if (sharding.type() != xla::OpSharding::OTHER || shape.IsTuple()) {
+    return std::nullopt;
+  }
+  absl::StatusOr<xla::HloSharding> hlo_sharding =
+      xla::HloSharding::FromProto(sharding);
+  if (!hlo_sharding.ok() || !hlo_sharding->IsTiled() ||
+      !hlo_sharding->subgroup_types().empty()) {
+    return std::nullopt;
+  }
+  std::map<std::vector<int64_t>, ShardTile> tiles;
+  int64_t covered_elements = 0;
+  for (size_t i = 0; i < shard_devices.size(); ++i) {
+    int64_t ordinal = ComputationClient::GetDeviceOrdinal(shard_devices[i]);
+    if (!hlo_sharding->UsesDevice(ordinal)) {
+      return std::nullopt;
+    }
+    ShardTile tile{i, hlo_sharding->TileOffsetForDevice(shape, ordinal),
+                   hlo_sharding->TileLimitForDevice(shape, ordinal)};
+    int64_t elements = 1;
+    for (size_t d = 0; d < tile.sizes.size(); ++d) {
+      tile.sizes[d] -= tile.offset[d];
+      elements *= tile.sizes[d];
+    }
+    // Tiles are disjoint, and the replicas of a tile share its offset.
+    if (elements > 0 && tiles.emplace(tile.offset, tile).second) {
+      covered_elements += elements;
+    }
+  }
+  if (covered_elements != xla::ShapeUtil::ElementsIn(shape)) {
+    return std::nullopt;
+  }
+  std::vector<ShardTile> result;
+  result.reserve(tiles.size());
+  for (auto& offset_tile : tiles) {
+    result.push_back(std::move(offset_tile.second));
+  }
+  return result;
+}
+
+// Literals filled by in flight ToLiteral() calls, holding on to the buffers
+// they are read from. A sharded value can be read as its tiles, which are
+// stitched on the host once all the reads complete.
+class PjRtAsyncTransfer : public ComputationClient::AsyncTransfer {
+ public:
+  // Starts reading `buffer` into the next literal. Returns its size.
+  int64_t Add(std::shared_ptr<xla::PjRtBuffer> buffer) {
+    outputs_.push_back({Read(std::move(buffer)), std::nullopt, {}});
+    return reads_.back()->size_bytes();
+  }
+
+  // Starts reading the `tiles` of `shards` into the next literal, of `shape`.
+  // Returns its size.
+  int64_t AddTiled(const xla::Shape& shape,
+                   absl::Span<const std::shared_ptr<xla::PjRtBuffer>> shards,
+                   std::vector<ShardTile> tiles) {
+    for (ShardTile& tile : tiles) {
+      tile.shard = Read(shards[tile.shard]);
+    }
+    xla::Shape host_shape = xla::ShapeUtil::MakeShapeWithDescendingLayout(
+        shape.element_type(), shape.dimensions());
+    int64_t size = xla::ShapeUtil::ByteSizeOf(host_shape);
+    outputs_.push_back({0, std::move(host_shape), std::move(tiles)});
+    return size;
+  }
+
+  void Join() {
+    future_ = xla::JoinFutures(futures_);
+    futures_.clear();
+  }
+
+  bool IsReady() override { return future_->IsReady(); }
+
+  absl::StatusOr<std::vector<xla::Literal>> Await() override {
+    XLA_RETURN_IF_ERROR(future_->Await());
+    buffers_.clear();
+    std::vector<xla::Literal> literals;
+    literals.reserve(outputs_.size());
+    for (Output& output : outputs_) {
+      if (!output.shape.has_value()) {
+        literals.push_back(std::move(*reads_[output.read]));
+        continue;
+      }
+      xla::Literal& literal = literals.emplace_back(*output.shape);
+      std::vector<int64_t> src_base(output.shape->dimensions_size(), 0);
+      for (const ShardTile& tile : output.tiles) {
+        // Shards of uneven shardings are padded past the tile sizes.
+        XLA_RETURN_IF_ERROR(literal.CopySliceFrom(
+            *reads_[tile.shard], src_base, tile.offset, tile.sizes));
+        reads_[tile.shard].reset();
+      }
+    }
+    reads_.clear();
+    return literals;
+  }
+
+ private:
+  struct Output {
+    // Index of the read holding the literal, if it is not assembled.
+    size_t read;
+    // The shape of the assembled literal, and its tiles, whose `shard` is
+    // the index of the read holding them.
+    std::optional<xla::Shape> shape;
+    std::vector<ShardTile> tiles;
+  };
+
+  size_t Read(std::shared_ptr<xla::PjRtBuffer> buffer) {
+    reads_.push_back(
+        std::make_unique<xla::Literal>(host_output_shape(buffer.get())));
+    futures_.push_back(buffer->ToLiteral(reads_.back().get()));
+    buffers_.push_back(std::move(buffer));
+    return reads_.size() - 1;
+  }
+
+  std::vector<std::shared_ptr<xla::PjRtBuffer>> buffers_;
+  std::vector<std::unique_ptr<xla::Literal>> reads_;
+  std::vector<Output> outputs_;
+  std::vector<xla::PjRtFuture<>> futures_;
+  std::optional<xla::PjRtFuture<>> future_;
+};
+
+// Whether the buffers of `memory_space` may alias host memory, so that a
+// transfer with kImmutableZeroCopy semantics does not copy at all.
+bool SupportsZeroCopy(xla::PjRtClient* client,
+                      xla::PjRtMemorySpace* memory_space) {
+  return client->platform_id() == xla::CpuId() ||
+         memory_space->kind() == "pinned_host" ||
+         memory_space->kind() == "unpinned_host";
+}
+
+// Samples the memory footprint of a newly compiled or loaded computation.
+void RecordMemoryFootprint(const ComputationClient::Computation& computation) {
+  std::optional<ComputationClient::Computation::MemoryFootprint> footprint =
+      computation.memory_footprint();
+  if (!footprint.has_value()) {
+    return;
+  }
+  XLA_VALUE_METRIC("ComputationArgumentBytes", footprint->argument_bytes);
+  XLA_VALUE_METRIC("ComputationOutputBytes", footprint->output_bytes);
+  XLA_VALUE_METRIC("ComputationTempBytes", footprint->temp_bytes);
+  XLA_VALUE_METRIC("ComputationCodeBytes", footprint->generated_code_bytes);
+}
+
+// Samples the cost analysis of a newly compiled or loaded computation.
+void RecordCostAnalysis(const ComputationClient::Computation& computation) {
+  std::optional<ComputationClient::Computation::CostAnalysis> cost_analysis =
+      computation.cost_analysis();
+  if (!cost_analysis.has_value()) {
+    return;
+  }
+  XLA_VALUE_METRIC("ComputationFlops", cost_analysis->flops);
+  XLA_VALUE_METRIC("ComputationBytesAccessed", cost_analysis->bytes_accessed);
+}
+
+// Fraction of the device memory limit above which the least recently used
+// device data is spilled to host memory. 0 disables spilling.
+double DeviceMemorySpillWatermark() {
+  static const double watermark =
+      sys_util::GetEnvDouble("XLA_DEVICE_MEMORY_SPILL_WATERMARK", 0.0);
+  return watermark;
+}
+
+// Whether the host transfers use the parameter layouts of the compiled
+// computations.
+bool TransferParameterLayouts() {
+  static const bool enabled =
+      sys_util::GetEnvBool("XLA_TRANSFER_PARAMETER_LAYOUTS", false);
+  return enabled;
+}
+
+// Returns the key of the arrays of `shape` in the parameter layouts map.
+std::string ParameterLayoutKey(const xla::Shape& shape) {
+  return xla::ShapeUtil::HumanString(shape);
+}
+
+// Returns the host memory space of `device` which spilled buffers move to, or
+// nullptr if it has none besides its default memory space.
+xla::PjRtMemorySpace* GetSpillMemorySpace(
+    xla::PjRtDevice* device, xla::PjRtMemorySpace* default_memory_space) {
+  xla::PjRtMemorySpace* spill_space = nullptr;
+  for (xla::PjRtMemorySpace* memory_space : device->memory_spaces()) {
+    if (memory_space == default_memory_space) {
+      continue;
+    } else if (memory_space->kind() == "pinned_host") {
+      return memory_space;
+    } else if (memory_space->kind() == "unpinned_host") {
+      spill_space = memory_space;
+    }
+  }
+  return spill_space;
+}
+
+// Returns the devices of `client` by increasing ID.
+std::vector<xla::PjRtDevice*> DevicesById(xla::PjRtClient* client) {
+  std::vector<xla::PjRtDevice*> ordered_devices(client->device_count());
+  std::partial_sort_copy(client->devices().begin(), client->devices().end(),
+                         ordered_devices.begin(), ordered_devices.end(),
+                         [](auto& a, auto& b) { return a->id() < b->id(); });
+  return ordered_devices;
+}
+
 }  // namespace
 
 std::string PjRtComputationClient::PjRtDeviceToString(
@@ -124,19 +355,15 @@ absl::Status PjRtComputationClient::Initialize() {
   XLA_ASSIGN_OR_RETURN(std::tie(client_, coordinator_),
                        InitializePjRt(device_type));
 
+  XLA_TIMED("StartupDeviceSetupTime");
   // PjRtDevice IDs are not guaranteed to be dense, so we need to track
   // a device's global ordinal separately from its device ID. Order the
   // devices by increasing ID to assign global ordinals.
-  std::vector<xla::PjRtDevice*> ordered_devices(client_->device_count());
-  std::partial_sort_copy(client_->devices().begin(), client_->devices().end(),
-                         ordered_devices.begin(), ordered_devices.end(),
-                         [](auto& a, auto& b) { return a->id() < b->id(); });
-  for (auto* device : ordered_devices) {
+  for (auto* device : DevicesById(client_.get())) {
     global_ordinals_[device->id()] = global_ordinals_.size();
     std::string device_str = PjRtDeviceToString(device);
     string_to_device_.emplace(device_str, device);
   }
-  comp_env_hash_ = hash_comp_env(client_.get(), ordered_devices);
 
   auto tracked_devices = GetLocalDevices();
   tracked_devices.emplace_back(spmd_device_str);
@@ -153,6 +380,7 @@ PjRtComputationClient::Create() {
 }
 
 PjRtComputationClient::~PjRtComputationClient() {
+  FlushBufferDeletions();
   client_ = nullptr;
   coordinator_ = nullptr;
 }
@@ -178,6 +406,13 @@ XlaCoordinator& PjRtComputationClient::GetCoordinator() {
   return *coordinator_;
 }
 
+PjRtComputationClient::PjRtData::~PjRtData() {
+  BufferDeleter* deleter = BufferDeleter::Get();
+  if (deleter != nullptr && buffer != nullptr) {
+    deleter->Delete(std::move(buffer), xla::ShapeUtil::ByteSizeOf(shape()));
+  }
+}
+
 void PjRtComputationClient::PjRtData::Assign(
     const torch::lazy::BackendData& data) {
   const PjRtData& pjrt_data = dynamic_cast<const PjRtData&>(data);
@@ -194,7 +429,9 @@ ComputationClient::DataPtr PjRtComputationClient::CreateDataPlaceholder(
         std::move(device), std::move(shape), std::move(*sharding));
   }
 
-  return std::make_shared<PjRtData>(std::move(device), std::move(shape));
+  auto data = std::make_shared<PjRtData>(std::move(device), std::move(shape));
+  TrackSpillableData(data);
+  return data;
 }
 
 ComputationClient::DataPtr PjRtComputationClient::CreateData(
@@ -267,29 +504,47 @@ std::vector<ComputationClient::DataPtr> PjRtComputationClient::TransferToDevice(
   metrics::TimedSection timed(TransferToDeviceMetric());
   tsl::profiler::TraceMe activity("PjRtComputationClient::TransferToDevice",
                                   tsl::profiler::TraceMeLevel::kInfo);
-  std::vector<ComputationClient::DataPtr> datas;
-  datas.reserve(tensors.size());
+  timeline::ScopedEvent event(timeline::Phase::kTransferToDevice);
+  std::vector<ComputationClient::DataPtr> datas(tensors.size());
+  std::vector<int64_t> sizes;
+  sizes.reserve(tensors.size());
   int64_t total_size = 0;
   for (auto& tensor : tensors) {
-    xla::PjRtDevice* pjrt_device = StringToPjRtDevice(tensor->device());
-
-    total_size += xla::ShapeUtil::ByteSizeOf(tensor->shape());
-
-    std::shared_ptr<xla::PjRtBuffer> buffer =
-        std::move(client_
-                      ->BufferFromHostBuffer(
-                          tensor->data(), tensor->primitive_type(),
-                          tensor->dimensions(), tensor->byte_strides(),
-                          xla::PjRtClient::HostBufferSemantics::
-                              kImmutableUntilTransferCompletes,
-                          [tensor]() { /* frees tensor */ },
-                          *pjrt_device->default_memory_space(),
-                          /*device_layout=*/nullptr)
-                      .value());
-
-    ComputationClient::DataPtr data =
-        std::make_shared<PjRtData>(tensor->device(), tensor->shape(), buffer);
-    datas.push_back(data);
+    sizes.push_back(xla::ShapeUtil::ByteSizeOf(tensor->shape()));
+    total_size += sizes.back();
+  }
+
+  if (tensors.size() == 1) {
+    datas[0] = TransferSingleToDevice(tensors[0]);
+  } else if (!tensors.empty()) {
+    // Enqueue the transfers from the pool, biggest first so that the longest
+    // copies start as early as possible. Exceptions cannot cross the thread
+    // pool boundary, so they are captured and the first one is re-thrown on
+    // the calling thread.
+    std::vector<size_t> order(tensors.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+    std::vector<std::exception_ptr> errors(tensors.size());
+    // Staging the data costs in the order of a nanosecond per byte, so small
+    // tensors are kept on the calling thread.
+    int64_t transfer_cost_ns = total_size / tensors.size();
+    pool_.ParallelFor(
+        order.size(), transfer_cost_ns, [&](int64_t start, int64_t end) {
+          for (int64_t i = start; i < end; ++i) {
+            size_t index = order[i];
+            try {
+              datas[index] = TransferSingleToDevice(tensors[index]);
+            } catch (...) {
+              errors[index] = std::current_exception();
+            }
+          }
+        });
+    for (auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
   }
   OutboundDataMetric()->AddSample(total_size);
   CreateDataHandlesCounter()->AddValue(datas.size());
@@ -297,23 +552,239 @@ std::vector<ComputationClient::DataPtr> PjRtComputationClient::TransferToDevice(
   return datas;
 }
 
+ComputationClient::DataPtr PjRtComputationClient::TransferSingleToDevice(
+    const std::shared_ptr<const TensorSource>& tensor) {
+  xla::PjRtDevice* pjrt_device = StringToPjRtDevice(tensor->device());
+  xla::PjRtMemorySpace* memory_space = *pjrt_device->default_memory_space();
+
+  // Data shared with the caller may be mutated as soon as we return, so the
+  // runtime must be done reading it within the call. Data owned by the
+  // source can be aliased by the buffer where the memory space allows it.
+  xla::PjRtClient::HostBufferSemantics semantics =
+      xla::PjRtClient::HostBufferSemantics::kImmutableUntilTransferCompletes;
+  if (tensor->shares_caller_data()) {
+    semantics = xla::PjRtClient::HostBufferSemantics::kImmutableOnlyDuringCall;
+  } else if (SupportsZeroCopy(client_.get(), memory_space)) {
+    semantics = xla::PjRtClient::HostBufferSemantics::kImmutableZeroCopy;
+    TORCH_LAZY_COUNTER("ZeroCopyTransferToDevice", 1);
+  }
+
+  std::optional<xla::Layout> device_layout;
+  if (TransferParameterLayouts()) {
+    device_layout = GetParameterLayout(tensor->shape());
+    if (device_layout.has_value()) {
+      TORCH_LAZY_COUNTER("ParameterLayoutTransferToDevice", 1);
+    }
+  }
+
+  auto transfer = [&]() {
+    return client_->BufferFromHostBuffer(
+        tensor->data(), tensor->primitive_type(), tensor->dimensions(),
+        tensor->byte_strides(), semantics, [tensor]() { /* frees tensor */ },
+        memory_space, device_layout.has_value() ? &*device_layout : nullptr);
+  };
+  absl::StatusOr<std::unique_ptr<xla::PjRtBuffer>> transferred = transfer();
+  // The memory missing may be that of the buffers pending deletion.
+  BufferDeleter* deleter = BufferDeleter::Get();
+  if (absl::IsResourceExhausted(transferred.status()) && deleter != nullptr &&
+      deleter->pending_bytes() > 0) {
+    TORCH_LAZY_COUNTER("TransferToDeviceRetriedAfterDeletions", 1);
+    deleter->Flush();
+    transferred = transfer();
+  }
+  std::shared_ptr<xla::PjRtBuffer> buffer = std::move(transferred.value());
+
+  auto data =
+      std::make_shared<PjRtData>(tensor->device(), tensor->shape(), buffer);
+  TrackSpillableData(data);
+  return data;
+}
+
+void PjRtComputationClient::TrackSpillableData(
+    const std::shared_ptr<PjRtData>& data) {
+  if (DeviceMemorySpillWatermark() <= 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(spill_mutex_);
+  if (spillable_data_.size() >= next_spillable_data_prune_) {
+    PruneSpillableData();
+    next_spillable_data_prune_ =
+        std::max<size_t>(1024, 2 * spillable_data_.size());
+  }
+  spillable_data_.push_back(data);
+}
+
+void PjRtComputationClient::RecordParameterLayouts(
+    const PjRtComputation& computation) {
+  if (!TransferParameterLayouts() ||
+      computation.executable->num_partitions() != 1) {
+    return;
+  }
+  auto layouts_status_or = computation.executable->GetParameterLayouts();
+  const xla::ProgramShape& program_shape = computation.program_shape();
+  if (!layouts_status_or.ok() ||
+      layouts_status_or->size() != program_shape.parameters_size()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(parameter_layouts_mutex_);
+  for (size_t i = 0; i < layouts_status_or->size(); ++i) {
+    const xla::Shape& shape = program_shape.parameters(i);
+    if (!shape.IsArray()) {
+      continue;
+    }
+    // The default layouts are recorded too, so that an array shape wanted in
+    // the default layout by any computation is transferred in it.
+    const xla::Layout& layout = (*layouts_status_or)[i]->xla_layout();
+    auto it = parameter_layouts_.emplace(ParameterLayoutKey(shape), layout);
+    if (!it.second && it.first->second.has_value() &&
+        *it.first->second != layout) {
+      it.first->second = std::nullopt;
+    }
+    auto default_layout_status_or =
+        client_->GetDefaultLayout(shape.element_type(), shape.dimensions());
+    if (default_layout_status_or.ok() && *default_layout_status_or != layout) {
+      XLA_COUNTER("NonDefaultParameterLayouts", 1);
+    }
+  }
+}
+
+std::optional<xla::Layout> PjRtComputationClient::GetParameterLayout(
+    const xla::Shape& shape) {
+  std::lock_guard<std::mutex> lock(parameter_layouts_mutex_);
+  auto it = parameter_layouts_.find(ParameterLayoutKey(shape));
+  return it != parameter_layouts_.end() ? it->second : std::nullopt;
+}
+
+void PjRtComputationClient::PruneSpillableData() {
+  spillable_data_.erase(
+      std::remove_if(spillable_data_.begin(), spillable_data_.end(),
+                     [](const auto& data) { return data.expired(); }),
+      spillable_data_.end());
+}
+
+void PjRtComputationClient::PrepareExecutionMemory(
+    const std::string& device, absl::Span<const DataPtr> arguments) {
+  const double watermark = DeviceMemorySpillWatermark();
+  if (watermark <= 0) {
+    return;
+  }
+  tsl::profiler::TraceMe activity(
+      "PjRtComputationClient::PrepareExecutionMemory",
+      tsl::profiler::TraceMeLevel::kInfo);
+  xla::PjRtDevice* pjrt_device = StringToPjRtDevice(device);
+  xla::PjRtMemorySpace* device_space = *pjrt_device->default_memory_space();
+  std::lock_guard<std::mutex> lock(spill_mutex_);
+  const int64_t step = ++execution_step_;
+  // The arguments are brought back to the device first, since they must be
+  // there for the execution whatever the memory pressure.
+  for (const DataPtr& argument : arguments) {
+    auto* pjrt_data = dynamic_cast<PjRtData*>(argument.get());
+    pjrt_data->last_use_step = step;
+    if (pjrt_data->spilled && pjrt_data->HasValue()) {
+      XLA_ASSIGN_OR_THROW(
+          std::unique_ptr<xla::PjRtBuffer> restored,
+          pjrt_data->buffer->CopyToMemorySpace(device_space));
+      pjrt_data->buffer = std::move(restored);
+      pjrt_data->spilled = false;
+      XLA_COUNTER("RestoredSpilledData", 1);
+    }
+  }
+
+  absl::StatusOr<tsl::AllocatorStats> stats = pjrt_device->GetAllocatorStats();
+  if (!stats.ok() || !stats->bytes_limit.has_value()) {
+    return;
+  }
+  const int64_t threshold = watermark * *stats->bytes_limit;
+  int64_t bytes_in_use = stats->bytes_in_use;
+  xla::PjRtMemorySpace* spill_space =
+      GetSpillMemorySpace(pjrt_device, device_space);
+  if (bytes_in_use <= threshold || spill_space == nullptr) {
+    return;
+  }
+
+  // Spill the live data of the device which this execution does not use,
+  // least recently used first.
+  PruneSpillableData();
+  std::vector<std::shared_ptr<PjRtData>> candidates;
+  for (const std::weak_ptr<PjRtData>& weak_data : spillable_data_) {
+    std::shared_ptr<PjRtData> data = weak_data.lock();
+    if (data != nullptr && data->last_use_step < step && data->HasValue() &&
+        data->buffer->memory_space() == device_space) {
+      candidates.push_back(std::move(data));
+    }
+  }
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const auto& a, const auto& b) {
+                     return a->last_use_step < b->last_use_step;
+                   });
+  for (const std::shared_ptr<PjRtData>& data : candidates) {
+    if (bytes_in_use <= threshold) {
+      break;
+    }
+    absl::StatusOr<size_t> size = data->buffer->GetOnDeviceSizeInBytes();
+    absl::StatusOr<std::unique_ptr<xla::PjRtBuffer>> spilled =
+        data->buffer->CopyToMemorySpace(spill_space);
+    if (!size.ok() || !spilled.ok()) {
+      TF_VLOG(3) << "Failed to spill data of shape " << data->shape() << ": "
+                 << (size.ok() ? spilled.status() : size.status());
+      continue;
+    }
+    data->buffer = std::move(spilled).value();
+    data->spilled = true;
+    bytes_in_use -= *size;
+    XLA_COUNTER("SpilledData", 1);
+    XLA_COUNTER("SpilledDataBytes", *size);
+  }
+}
+
 ComputationClient::DataPtr PjRtComputationClient::TransferShardsToDevice(
     absl::Span<const std::shared_ptr<const TensorSource>> tensor_shards,
     std::string device, xla::Shape shape, xla::OpSharding sharding) {
   tsl::profiler::TraceMe activity(
       "PjRtComputationClient::TransferShardsToDevice",
       tsl::profiler::TraceMeLevel::kInfo);
-  // TODO(jonbolin): Consider using CopyToDevice when sharding is REPLICATED.
-  // We are opting out of CopyToDevice for now due to the synchronization
-  // issues observed in ShardingUtil::InputHandler, but because CopyToDevice
-  // directly copies buffers between devices using ICI, it can be much faster
-  // than transferring from the host to each device.
-  auto data_shards = TransferToDevice(tensor_shards);
+  static const bool replicate_with_device_copies =
+      sys_util::GetEnvBool("XLA_REPLICATE_WITH_DEVICE_COPIES", true);
   std::vector<std::shared_ptr<PjRtData>> pjrt_data_shards;
-  for (auto& shard : data_shards) {
-    auto pjrt_shard = dynamic_cast<PjRtData*>(shard.get());
+  if (replicate_with_device_copies &&
+      sharding.type() == xla::OpSharding::REPLICATED &&
+      tensor_shards.size() > 1) {
+    // All the shards hold the same data, so it is uploaded once and fanned
+    // out with device to device copies, which go over the interconnect rather
+    // than the host link. The copies are ordered after the upload by the
+    // runtime, and the executions using them wait on their definition events,
+    // as for any other buffer.
+    DataPtr source_data = TransferToDevice(tensor_shards.subspan(0, 1)).front();
+    auto source = std::dynamic_pointer_cast<PjRtData>(source_data);
     pjrt_data_shards.push_back(std::make_shared<PjRtData>(
-        pjrt_shard->device(), pjrt_shard->shape(), pjrt_shard->buffer));
+        source->device(), source->shape(), source->buffer));
+    for (size_t i = 1; i < tensor_shards.size(); ++i) {
+      const std::string& shard_device = tensor_shards[i]->device();
+      xla::PjRtDevice* pjrt_device = StringToPjRtDevice(shard_device);
+      absl::StatusOr<std::unique_ptr<xla::PjRtBuffer>> buffer =
+          source->buffer->CopyToMemorySpace(
+              *pjrt_device->default_memory_space());
+      if (buffer.ok()) {
+        XLA_COUNTER("ReplicatedShardDeviceCopies", 1);
+        pjrt_data_shards.push_back(std::make_shared<PjRtData>(
+            shard_device, tensor_shards[i]->shape(),
+            std::shared_ptr<xla::PjRtBuffer>(std::move(buffer).value())));
+      } else {
+        TF_VLOG(3) << "Falling back to a host transfer for device "
+                   << shard_device << ": " << buffer.status();
+        DataPtr shard = TransferToDevice(tensor_shards.subspan(i, 1)).front();
+        auto pjrt_shard = dynamic_cast<PjRtData*>(shard.get());
+        pjrt_data_shards.push_back(std::make_shared<PjRtData>(
+            pjrt_shard->device(), pjrt_shard->shape(), pjrt_shard->buffer));
+      }
+    }
+  } else {
+    auto data_shards = TransferToDevice(tensor_shards);
+    for (auto& shard : data_shards) {
+      auto pjrt_shard = dynamic_cast<PjRtData*>(shard.get());
+      pjrt_data_shards.push_back(std::make_shared<PjRtData>(
+          pjrt_shard->device(), pjrt_shard->shape(), pjrt_shard->buffer));
+    }
   }
   return std::make_shared<PjRtShardedData>(device, shape, pjrt_data_shards,
                                            sharding);
@@ -339,6 +810,62 @@ ComputationClient::DataPtr PjRtComputationClient::CopyToDevice(
                                     std::move(status_or.value()));
 }
 
+absl::StatusOr<ComputationClient::DataPtr>
+PjRtComputationClient::CopyToMemoryKind(DataPtr data,
+                                        const std::string& memory_kind) {
+  tsl::profiler::TraceMe activity("PjRtComputationClient::CopyToMemoryKind",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  auto copy_to_memory_kind = [&](const std::shared_ptr<PjRtData>& pjrt_data)
+      -> absl::StatusOr<std::shared_ptr<PjRtData>> {
+    XLA_CHECK(pjrt_data->HasValue()) << "Can't copy invalid device data.";
+    xla::PjRtBuffer* buffer = pjrt_data->buffer.get();
+    if (buffer->memory_space()->kind() == memory_kind) {
+      return pjrt_data;
+    }
+    for (xla::PjRtMemorySpace* memory_space :
+         buffer->device()->memory_spaces()) {
+      if (memory_space->kind() == memory_kind) {
+        XLA_ASSIGN_OR_RETURN(std::unique_ptr<xla::PjRtBuffer> copy,
+                             buffer->CopyToMemorySpace(memory_space));
+        return std::make_shared<PjRtData>(pjrt_data->device(),
+                                          pjrt_data->shape(), std::move(copy));
+      }
+    }
+    return absl::InvalidArgumentError(
+        absl::StrCat("Device ", pjrt_data->device(),
+                     " has no memory space of kind ", memory_kind));
+  };
+
+  if (auto pjrt_data = std::dynamic_pointer_cast<PjRtData>(data)) {
+    XLA_ASSIGN_OR_RETURN(std::shared_ptr<PjRtData> copy,
+                         copy_to_memory_kind(pjrt_data));
+    return copy;
+  }
+  auto sharded_data = std::dynamic_pointer_cast<PjRtShardedData>(data);
+  XLA_CHECK(sharded_data != nullptr) << "Unexpected data type";
+  std::vector<std::shared_ptr<PjRtData>> shards;
+  shards.reserve(sharded_data->shards.size());
+  for (const std::shared_ptr<PjRtData>& shard : sharded_data->shards) {
+    XLA_ASSIGN_OR_RETURN(std::shared_ptr<PjRtData> copy,
+                         copy_to_memory_kind(shard));
+    shards.push_back(std::move(copy));
+  }
+  return std::make_shared<PjRtShardedData>(
+      sharded_data->device(), sharded_data->shape(), std::move(shards),
+      sharded_data->GetSharding());
+}
+
+std::string PjRtComputationClient::GetMemoryKind(DataPtr data) {
+  if (auto sharded_data = std::dynamic_pointer_cast<PjRtShardedData>(data)) {
+    XLA_CHECK(!sharded_data->shards.empty());
+    data = sharded_data->shards.front();
+  }
+  auto pjrt_data = std::dynamic_pointer_cast<PjRtData>(data);
+  XLA_CHECK(pjrt_data != nullptr && pjrt_data->HasValue())
+      << "Can't get the memory kind of invalid device data.";
+  return std::string(pjrt_data->buffer->memory_space()->kind());
+}
+
 std::shared_ptr<PjRtComputationClient::PjRtData>
 PjRtComputationClient::ReplicateShardedData(
     const ComputationClient::DataPtr& handle) {
@@ -412,8 +939,13 @@ std::vector<ComputationClient::DataPtr> PjRtComputationClient::ReshardData(
       << "input handles and shardings must have the same length.";
   XLA_CHECK(UseVirtualDevice()) << "We only supports SPMD mode resharding.";
 
-  // Perform a simple identity calculation to reshard.
+  // Perform a simple identity calculation to reshard. The SPMD partitioner
+  // lowers each change of sharding to the collectives it calls for, like an
+  // all-to-all between FSDP and TP layouts, or a collective-permute between
+  // tilings of different device orders. The compiled program is reused for
+  // the next resharding of the same layouts.
   xla::XlaBuilder builder("ReshardData");
+  std::string cache_key;
 
   std::vector<xla::Shape> shapes;
   shapes.reserve(handles.size());
@@ -439,39 +971,51 @@ std::vector<ComputationClient::DataPtr> PjRtComputationClient::ReshardData(
 
     xla::OpSharding fallback_sharding;
     fallback_sharding.set_type(xla::OpSharding::REPLICATED);
-    xla::XlaScopedShardingAssignment assign(
-        &builder, sharded_data->GetSharding().type() == xla::OpSharding::UNKNOWN
-                      ? fallback_sharding
-                      : sharded_data->GetSharding());
+    xla::OpSharding source_sharding =
+        sharded_data->GetSharding().type() == xla::OpSharding::UNKNOWN
+            ? fallback_sharding
+            : sharded_data->GetSharding();
+    xla::XlaScopedShardingAssignment assign(&builder, source_sharding);
     param_ops.push_back(
         xla::Parameter(&builder, i, shapes[i], absl::StrCat("p.", i)));
+    absl::StrAppend(&cache_key, shapes[i].ToString(/*print_layout=*/true),
+                    ";", source_sharding.SerializeAsString(), ";",
+                    sharding.SerializeAsString(), ";");
   }
 
-  xla::XlaOp root;
-  {
-    xla::Shape shapes_tuple = xla::ShapeUtil::MakeTupleShape(shapes);
-    XLA_CHECK_EQ(shapes_tuple.tuple_shapes_size(), hlo_shardings.size());
-    xla::HloSharding new_shardings_tuple =
-        xla::HloSharding::Tuple(shapes_tuple, hlo_shardings);
-    xla::XlaScopedShardingAssignment assign(&builder,
-                                            new_shardings_tuple.ToProto());
-    root = xla::Tuple(&builder, param_ops);
-  }
-
-  XLA_ASSIGN_OR_THROW(xla::XlaComputation xla_computation, builder.Build(root));
-  XLA_ASSIGN_OR_THROW(xla::ProgramShape program_shape,
-                      xla_computation.GetProgramShape());
-
-  std::string device = GetDefaultDevice();
-  std::vector<torch_xla::runtime::ComputationClient::CompileInstance> instances;
-  instances.push_back({std::move(xla_computation), device,
-                       GetCompilationDevices(device, {}),
-                       &program_shape.result(),
-                       /*should_wrap_parameter=*/false,
-                       /*is_sharded=*/true,
-                       /*allow_spmd_sharding_propagation_to_output=*/false});
-  std::shared_ptr<torch_xla::runtime::ComputationClient::Computation>
-      computation = Compile(std::move(instances)).front();
+  std::shared_ptr<Computation> computation =
+      reshard_computations_.Get(cache_key);
+  if (computation != nullptr) {
+    XLA_COUNTER("ReshardDataCacheHit", 1);
+  } else {
+    xla::XlaOp root;
+    {
+      xla::Shape shapes_tuple = xla::ShapeUtil::MakeTupleShape(shapes);
+      XLA_CHECK_EQ(shapes_tuple.tuple_shapes_size(), hlo_shardings.size());
+      xla::HloSharding new_shardings_tuple =
+          xla::HloSharding::Tuple(shapes_tuple, hlo_shardings);
+      xla::XlaScopedShardingAssignment assign(&builder,
+                                              new_shardings_tuple.ToProto());
+      root = xla::Tuple(&builder, param_ops);
+    }
+
+    XLA_ASSIGN_OR_THROW(xla::XlaComputation xla_computation,
+                        builder.Build(root));
+    XLA_ASSIGN_OR_THROW(xla::ProgramShape program_shape,
+                        xla_computation.GetProgramShape());
+
+    std::string device = GetDefaultDevice();
+    std::vector<torch_xla::runtime::ComputationClient::CompileInstance>
+        instances;
+    instances.push_back({std::move(xla_computation), device,
+                         GetCompilationDevices(device, {}),
+                         &program_shape.result(),
+                         /*should_wrap_parameter=*/false,
+                         /*is_sharded=*/true,
+                         /*allow_spmd_sharding_propagation_to_output=*/false});
+    computation = reshard_computations_.Add(
+        std::move(cache_key), Compile(std::move(instances)).front());
+  }
 
   torch_xla::runtime::ComputationClient::ExecuteReplicatedOptions
       execute_options;
@@ -516,12 +1060,38 @@ PjRtComputationClient::TransferFromDevice(absl::Span<const DataPtr> handles) {
   metrics::TimedSection timed(TransferFromDeviceMetric());
   tsl::profiler::TraceMe activity("PjRtComputationClient::TransferFromDevice",
                                   tsl::profiler::TraceMeLevel::kInfo);
-  std::vector<xla::PjRtFuture<>> futures;
-  futures.reserve(handles.size());
-  std::vector<xla::Literal> literals;
-  literals.reserve(handles.size());
+  timeline::ScopedEvent event(timeline::Phase::kTransferFromDevice);
+  return TransferFromDeviceAsync(handles)->Await();
+}
+
+std::unique_ptr<ComputationClient::AsyncTransfer>
+PjRtComputationClient::TransferFromDeviceAsync(
+    absl::Span<const DataPtr> handles) {
+  tsl::profiler::TraceMe activity(
+      "PjRtComputationClient::TransferFromDeviceAsync",
+      tsl::profiler::TraceMeLevel::kInfo);
+  auto transfer = std::make_unique<PjRtAsyncTransfer>();
   int64_t total_size = 0;
   for (auto handle : handles) {
+    // Tiled data is read shard by shard and assembled on the host, which
+    // needs neither a replication program nor its device memory.
+    if (auto sharded_data =
+            std::dynamic_pointer_cast<PjRtShardedData>(handle)) {
+      std::vector<std::string> shard_devices;
+      std::vector<std::shared_ptr<xla::PjRtBuffer>> shard_buffers;
+      for (const std::shared_ptr<PjRtData>& shard : sharded_data->shards) {
+        shard_devices.push_back(shard->device());
+        shard_buffers.push_back(shard->buffer);
+      }
+      std::optional<std::vector<ShardTile>> tiles = GetShardTiles(
+          sharded_data->GetSharding(), sharded_data->shape(), shard_devices);
+      if (tiles.has_value()) {
+        XLA_COUNTER("HostAssembledShardedData", 1);
+        total_size += transfer->AddTiled(sharded_data->shape(), shard_buffers,
+                                         std::move(*tiles));
+        continue;
+      }
+    }
     // Use XLA replication to reassemble the sharded data. If input handle
     // is not sharded, then it is a no-op.
     std::shared_ptr<PjRtData> pjrt_data = ReplicateShardedData(handle);
@@ -529,16 +1099,142 @@ PjRtComputationClient::TransferFromDevice(absl::Span<const DataPtr> handles) {
     ABSL_CHECK(pjrt_data->buffer != nullptr)
         << "PjRt buffer is null in " << __FUNCTION__;
 
-    xla::Literal& literal = literals.emplace_back(
-        xla::Literal(host_output_shape(pjrt_data->buffer.get())));
-    futures.push_back(pjrt_data->buffer->ToLiteral(&literal));
-
-    total_size += literal.size_bytes();
+    total_size += transfer->Add(pjrt_data->buffer);
   }
-  XLA_RETURN_IF_ERROR(xla::JoinFutures(futures).Await());
+  transfer->Join();
   InboundDataMetric()->AddSample(total_size);
 
-  return literals;
+  return transfer;
+}
+
+std::optional<PjRtComputationClient::HostTransfer>
+PjRtComputationClient::StartHostTransfer(absl::Span<const DataPtr> handles,
+                                         HostBufferPool* pool) {
+  // Values up to this size are packed into one buffer per call.
+  static constexpr int64_t kMaxPackedBytes = 64 * 1024;
+  // The alignment of the values in a packed buffer.
+  static constexpr int64_t kPackedAlignment = 64;
+  std::vector<std::shared_ptr<xla::PjRtBuffer>> buffers;
+  std::vector<xla::Shape> shapes;
+  buffers.reserve(handles.size());
+  shapes.reserve(handles.size());
+  for (const DataPtr& handle : handles) {
+    // Sharded data is assembled by TransferFromDevice().
+    if (std::dynamic_pointer_cast<PjRtShardedData>(handle) != nullptr) {
+      return std::nullopt;
+    }
+    std::shared_ptr<PjRtData> pjrt_data =
+        std::dynamic_pointer_cast<PjRtData>(handle);
+    ABSL_CHECK(pjrt_data) << "PjRt_data is null in " << __FUNCTION__;
+    ABSL_CHECK(pjrt_data->buffer != nullptr)
+        << "PjRt buffer is null in " << __FUNCTION__;
+    xla::Shape shape = host_output_shape(pjrt_data->buffer.get());
+    if (!shape.IsArray() || shape.is_dynamic()) {
+      return std::nullopt;
+    }
+    buffers.push_back(pjrt_data->buffer);
+    shapes.push_back(std::move(shape));
+  }
+
+  HostTransfer transfer;
+  // The offset of each value in the packed buffer, or -1 for the values with
+  // a buffer of their own.
+  std::vector<int64_t> offsets(shapes.size(), -1);
+  int64_t packed_size = 0;
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    int64_t size = xla::ShapeUtil::ByteSizeOf(shapes[i]);
+    transfer.total_size += size;
+    if (pool != nullptr && size <= kMaxPackedBytes) {
+      offsets[i] = packed_size;
+      packed_size +=
+          (size + kPackedAlignment - 1) / kPackedAlignment * kPackedAlignment;
+    }
+  }
+  std::shared_ptr<HostBufferPool::HostBuffer> packed_buffer;
+  if (packed_size > 0) {
+    packed_buffer = pool->Acquire(packed_size);
+    XLA_COUNTER("PackedTransferFromDevice", 1);
+  }
+
+  transfer.literals.reserve(shapes.size());
+  transfer.futures.reserve(shapes.size());
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    if (pool == nullptr) {
+      auto literal = std::make_shared<xla::Literal>(shapes[i]);
+      transfer.futures.push_back(buffers[i]->ToLiteral(literal.get()));
+      transfer.literals.push_back(std::move(literal));
+      continue;
+    }
+    std::shared_ptr<HostBufferPool::HostBuffer> host_buffer = packed_buffer;
+    char* data = nullptr;
+    if (offsets[i] >= 0) {
+      data = static_cast<char*>(host_buffer->data()) + offsets[i];
+    } else {
+      host_buffer = pool->Acquire(xla::ShapeUtil::ByteSizeOf(shapes[i]));
+      data = static_cast<char*>(host_buffer->data());
+    }
+    auto literal = std::make_shared<xla::MutableBorrowingLiteral>(data,
+                                                                  shapes[i]);
+    transfer.futures.push_back(buffers[i]->ToLiteral(literal.get()));
+    // The literal keeps its host buffer out of the pool for its lifetime.
+    transfer.literals.push_back(std::shared_ptr<const xla::LiteralBase>(
+        literal.get(), [literal, host_buffer](const xla::LiteralBase*) {}));
+  }
+  return transfer;
+}
+
+absl::StatusOr<std::vector<std::shared_ptr<const xla::LiteralBase>>>
+PjRtComputationClient::TransferFromDeviceToHostPool(
+    absl::Span<const DataPtr> handles) {
+  std::shared_ptr<HostBufferPool> pool = HostBufferPool::Get();
+  if (pool == nullptr) {
+    return ComputationClient::TransferFromDeviceToHostPool(handles);
+  }
+  metrics::TimedSection timed(TransferFromDeviceMetric());
+  tsl::profiler::TraceMe activity(
+      "PjRtComputationClient::TransferFromDeviceToHostPool",
+      tsl::profiler::TraceMeLevel::kInfo);
+  timeline::ScopedEvent event(timeline::Phase::kTransferFromDevice);
+  std::optional<HostTransfer> transfer =
+      StartHostTransfer(handles, pool.get());
+  if (!transfer.has_value()) {
+    return ComputationClient::TransferFromDeviceToHostPool(handles);
+  }
+  XLA_RETURN_IF_ERROR(xla::JoinFutures(transfer->futures).Await());
+  InboundDataMetric()->AddSample(transfer->total_size);
+  return std::move(transfer->literals);
+}
+
+void PjRtComputationClient::TransferFromDeviceStreaming(
+    absl::Span<const DataPtr> handles, const LiteralCallback& on_ready) {
+  std::shared_ptr<HostBufferPool> pool = HostBufferPool::Get();
+  metrics::TimedSection timed(TransferFromDeviceMetric());
+  tsl::profiler::TraceMe activity(
+      "PjRtComputationClient::TransferFromDeviceStreaming",
+      tsl::profiler::TraceMeLevel::kInfo);
+  timeline::ScopedEvent event(timeline::Phase::kTransferFromDevice);
+  std::optional<HostTransfer> transfer =
+      StartHostTransfer(handles, pool.get());
+  if (!transfer.has_value()) {
+    ComputationClient::TransferFromDeviceStreaming(handles, on_ready);
+    return;
+  }
+  absl::BlockingCounter counter(handles.size());
+  for (size_t i = 0; i < handles.size(); ++i) {
+    transfer->futures[i].OnReady(
+        [&, i, literal = std::move(transfer->literals[i])](
+            absl::Status status) mutable {
+          if (status.ok()) {
+            on_ready(i, std::move(literal));
+          } else {
+            on_ready(i, std::move(status));
+          }
+          counter.DecrementCount();
+        });
+  }
+  counter.Wait();
+  InboundDataMetric()->AddSample(transfer->total_size);
+  XLA_COUNTER("StreamingTransferFromDevice", 1);
 }
 
 std::vector<ComputationClient::ComputationPtr> PjRtComputationClient::Compile(
@@ -550,140 +1246,207 @@ std::vector<ComputationClient::ComputationPtr> PjRtComputationClient::Compile(
   metrics::TimedSection timed(metrics_fn());
   tsl::profiler::TraceMe activity("PjRtComputationClient::Compile",
                                   tsl::profiler::TraceMeLevel::kInfo);
-  std::vector<ComputationClient::ComputationPtr> computations;
+  std::vector<ComputationClient::ComputationPtr> computations(
+      instances.size());
+  if (instances.size() == 1) {
+    computations[0] = CompileSingle(instances[0]);
+    return computations;
+  }
+
+  // The instances are independent of each other, so compile them in parallel.
+  // Exceptions cannot cross the thread pool boundary, so they are captured and
+  // the first one is re-thrown on the calling thread.
+  std::vector<std::exception_ptr> errors(instances.size());
+  absl::BlockingCounter counter(instances.size());
+  // Compilations are far more expensive than the thread hand-off, make sure
+  // ParallelFor gives each instance its own shard.
+  static constexpr int64_t compile_cost_ns = 1000000000;
+  pool_.ParallelFor(
+      instances.size(), compile_cost_ns, [&](int64_t start, int64_t end) {
+        for (int64_t i = start; i < end; ++i) {
+          try {
+            computations[i] = CompileSingle(instances[i]);
+          } catch (...) {
+            errors[i] = std::current_exception();
+          }
+          counter.DecrementCount();
+        }
+      });
+  counter.Wait();
+  for (const std::exception_ptr& error : errors) {
+    if (error != nullptr) {
+      std::rethrow_exception(error);
+    }
+  }
+  return computations;
+}
+
+ComputationClient::ComputationPtr PjRtComputationClient::CompileSingle(
+    ComputationClient::CompileInstance& instance) {
   static bool enable_cm_in_mp =
       runtime::sys_util::GetEnvBool("ENABLE_COLLECTIVE_MATMUL_IN_MP", false);
+  int64_t start_ns = sys_util::NowNs();
 
-  for (auto& instance : instances) {
-    xla::CompileOptions compile_options;
-    for (const auto& [name, value] : custom_compile_options_) {
+  xla::CompileOptions compile_options;
+  for (const auto& [name, value] : custom_compile_options_) {
+    if (instance.option_overrides.count(name) == 0) {
       compile_options.env_option_overrides.push_back({name, value});
     }
-    if (enable_cm_in_mp) {
-      compile_options.executable_build_options.set_use_spmd_partitioning(true);
-      compile_options.env_option_overrides.push_back(
-          {"xla_tpu_decompose_all_gather_einsum", true});
-      compile_options.env_option_overrides.push_back(
-          {"xla_tpu_decompose_einsum_reduce_scatter", true});
-    }
-
-    if (instance.is_sharded) {
-      // TODO(yeounoh) multi-host, multi-slice configurations
-      compile_options.executable_build_options.set_use_spmd_partitioning(true);
+  }
+  for (const auto& [name, value] : instance.option_overrides) {
+    compile_options.env_option_overrides.push_back({name, value});
+  }
+  if (enable_cm_in_mp) {
+    compile_options.executable_build_options.set_use_spmd_partitioning(true);
+    compile_options.env_option_overrides.push_back(
+        {"xla_tpu_decompose_all_gather_einsum", true});
+    compile_options.env_option_overrides.push_back(
+        {"xla_tpu_decompose_einsum_reduce_scatter", true});
+  }
 
-      // We can override the compiler's default behavior to replicate the
-      // outputs. Setting this to true would wrapping the sharded outputs in
-      // PjRtShardedData.
+  if (instance.is_sharded) {
+    // TODO(yeounoh) multi-host, multi-slice configurations
+    compile_options.executable_build_options.set_use_spmd_partitioning(true);
+
+    // We can override the compiler's default behavior to replicate the
+    // outputs. Setting this to true would wrapping the sharded outputs in
+    // PjRtShardedData.
+    compile_options.executable_build_options
+        .set_allow_spmd_sharding_propagation_to_output(
+            {instance.allow_spmd_sharding_propagation_to_output});
+
+    int num_partitions = client_->device_count();
+    compile_options.executable_build_options.set_num_partitions(
+        num_partitions);
+    compile_options.executable_build_options.set_num_replicas(1);
+    compile_options.parameter_is_tupled_arguments =
+        instance.parameter_is_tupled_arguments;
+    compile_options.executable_build_options.set_use_auto_spmd_partitioning(
+        instance.use_auto_spmd_partitioning);
+    TF_VLOG(3) << "Auto SPMD partitioning "
+               << (instance.use_auto_spmd_partitioning ? "enabled!"
+                                                       : "disabled.");
+    if (!instance.auto_spmd_mesh_shape.empty()) {
       compile_options.executable_build_options
-          .set_allow_spmd_sharding_propagation_to_output(
-              {instance.allow_spmd_sharding_propagation_to_output});
-
-      int num_partitions = client_->device_count();
-      compile_options.executable_build_options.set_num_partitions(
-          num_partitions);
-      compile_options.executable_build_options.set_num_replicas(1);
-      compile_options.parameter_is_tupled_arguments =
-          instance.parameter_is_tupled_arguments;
-      compile_options.executable_build_options.set_use_auto_spmd_partitioning(
-          instance.use_auto_spmd_partitioning);
-      TF_VLOG(3) << "Auto SPMD partitioning "
-                 << (instance.use_auto_spmd_partitioning ? "enabled!"
-                                                         : "disabled.");
-      if (!instance.auto_spmd_mesh_shape.empty()) {
-        compile_options.executable_build_options
-            .set_auto_spmd_partitioning_mesh_shape(
-                instance.auto_spmd_mesh_shape);
-        TF_VLOG(3) << "auto_spmd_partitioning_mesh_shape="
-                   << absl::StrJoin(compile_options.executable_build_options
-                                        .auto_spmd_partitioning_mesh_shape(),
-                                    ",");
-      }
-      if (!instance.auto_spmd_mesh_ids.empty()) {
-        compile_options.executable_build_options
-            .set_auto_spmd_partitioning_mesh_ids(instance.auto_spmd_mesh_ids);
-        TF_VLOG(3) << "auto_spmd_partitioning_mesh_ids="
-                   << absl::StrJoin(compile_options.executable_build_options
-                                        .auto_spmd_partitioning_mesh_ids(),
-                                    ",");
-      }
-
-      // TODO(244391366) verify this is correct for the collectives ops
-      xla::DeviceAssignment device_assignment(1, client_->device_count());
-      // DeviceAssignment values must be the PjRtDevice ID, so we need to
-      // unwind the global ordinal mapping.
-      for (const auto& [device_id, global_ordinal] : global_ordinals_) {
-        device_assignment(0, global_ordinal) = device_id;
-      }
-      compile_options.executable_build_options.set_device_assignment(
-          device_assignment);
-    } else {
-      // TODO(wcromar): set compile_options.argument_layouts, enable strict
-      // shapes
-      compile_options.executable_build_options.set_num_partitions(1);
-      compile_options.executable_build_options.set_num_replicas(
-          client_->device_count());
-      compile_options.parameter_is_tupled_arguments =
-          instance.parameter_is_tupled_arguments;
-
-      xla::DeviceAssignment device_assignment(client_->device_count(), 1);
-      // DeviceAssignment values must be the PjRtDevice ID, so we need to
-      // unwind the global ordinal mapping.
-      for (const auto& [device_id, global_ordinal] : global_ordinals_) {
-        device_assignment(global_ordinal, 0) = device_id;
-      }
-      compile_options.executable_build_options.set_device_assignment(
-          device_assignment);
+          .set_auto_spmd_partitioning_mesh_shape(
+              instance.auto_spmd_mesh_shape);
+      TF_VLOG(3) << "auto_spmd_partitioning_mesh_shape="
+                 << absl::StrJoin(compile_options.executable_build_options
+                                      .auto_spmd_partitioning_mesh_shape(),
+                                  ",");
     }
-
-    // Compile the computation to an executible. For better user experience, if
-    // the XLA compiler fails for any reason, we raise a Python exception.
-    std::unique_ptr<xla::PjRtLoadedExecutable> executable;
-    if (runtime::sys_util::GetEnvBool("XLA_STABLEHLO_COMPILE", false)) {
-      // Convert HLO to StableHLO for PjRt client compilation.
-      mlir::MLIRContext context;
-      mlir::ModuleOp mlir_module =
-          mlir::ModuleOp::create(mlir::UnknownLoc::get(&context));
-      ConvertHloToStableHlo(instance.computation.mutable_proto(), &mlir_module);
-      if (runtime::sys_util::GetEnvBool("CONVERT_SHLO_TO_SHARDY", false)) {
-        ConvertStableHloToSdy(&mlir_module);
-      }
-      executable = util::RaisePythonValueErrorOnFailure([&] {
-        return fake_xla_compile_
-                   ? fake_xla_compile_()
-                   : client_->CompileAndLoad(mlir_module, compile_options);
-      });
-      StableHloCompileCounter()->AddValue(1);
-    } else {
-      executable = util::RaisePythonValueErrorOnFailure([&] {
-        return fake_xla_compile_ ? fake_xla_compile_()
-                                 : client_->CompileAndLoad(instance.computation,
-                                                           compile_options);
-      });
+    if (!instance.auto_spmd_mesh_ids.empty()) {
+      compile_options.executable_build_options
+          .set_auto_spmd_partitioning_mesh_ids(instance.auto_spmd_mesh_ids);
+      TF_VLOG(3) << "auto_spmd_partitioning_mesh_ids="
+                 << absl::StrJoin(compile_options.executable_build_options
+                                      .auto_spmd_partitioning_mesh_ids(),
+                                  ",");
     }
 
-    auto memory_stats_status_or = executable->GetCompiledMemoryStats();
-    if (memory_stats_status_or.ok()) {
-      xla::CompiledMemoryStats memory_stats = memory_stats_status_or.value();
-      TF_VLOG(3) << "memory usage detail = " << memory_stats.DebugString();
-    } else {
-      TF_VLOG(3) << "memory usage is not availiable";
+    // TODO(244391366) verify this is correct for the collectives ops
+    xla::DeviceAssignment device_assignment(1, client_->device_count());
+    // DeviceAssignment values must be the PjRtDevice ID, so we need to
+    // unwind the global ordinal mapping.
+    for (const auto& [device_id, global_ordinal] : global_ordinals_) {
+      device_assignment(0, global_ordinal) = device_id;
     }
+    compile_options.executable_build_options.set_device_assignment(
+        device_assignment);
+  } else {
+    // TODO(wcromar): set compile_options.argument_layouts, enable strict
+    // shapes
+    compile_options.executable_build_options.set_num_partitions(1);
+    compile_options.executable_build_options.set_num_replicas(
+        client_->device_count());
+    compile_options.parameter_is_tupled_arguments =
+        instance.parameter_is_tupled_arguments;
+
+    xla::DeviceAssignment device_assignment(client_->device_count(), 1);
+    // DeviceAssignment values must be the PjRtDevice ID, so we need to
+    // unwind the global ordinal mapping.
+    for (const auto& [device_id, global_ordinal] : global_ordinals_) {
+      device_assignment(global_ordinal, 0) = device_id;
+    }
+    compile_options.executable_build_options.set_device_assignment(
+        device_assignment);
+  }
 
-    XLA_ASSIGN_OR_THROW(
-        const std::vector<std::shared_ptr<xla::HloModule>>& hlo_modules,
-        executable->GetHloModules());
-    xla::HloComputation* hlo_computation = hlo_modules[0]->entry_computation();
-    std::shared_ptr<PjRtComputation> pjrt_computation =
-        std::make_shared<PjRtComputation>(
-            std::move(xla::XlaComputation(hlo_modules[0]->ToProto())),
-            instance.devices, std::move(executable));
-
-    computations.push_back(pjrt_computation);
+  // Compile the computation to an executible. For better user experience, if
+  // the XLA compiler fails for any reason, we raise a Python exception.
+  std::unique_ptr<xla::PjRtLoadedExecutable> executable;
+  if (runtime::sys_util::GetEnvBool("XLA_STABLEHLO_COMPILE", false)) {
+    // Convert HLO to StableHLO for PjRt client compilation.
+    mlir::MLIRContext context;
+    mlir::ModuleOp mlir_module =
+        mlir::ModuleOp::create(mlir::UnknownLoc::get(&context));
+    ConvertHloToStableHlo(instance.computation.mutable_proto(), &mlir_module);
+    if (runtime::sys_util::GetEnvBool("CONVERT_SHLO_TO_SHARDY", false)) {
+      ConvertStableHloToSdy(&mlir_module);
+    }
+    executable = util::RaisePythonValueErrorOnFailure([&] {
+      return fake_xla_compile_
+                 ? fake_xla_compile_()
+                 : client_->CompileAndLoad(mlir_module, compile_options);
+    });
+    StableHloCompileCounter()->AddValue(1);
+  } else {
+    executable = util::RaisePythonValueErrorOnFailure([&] {
+      return fake_xla_compile_ ? fake_xla_compile_()
+                               : client_->CompileAndLoad(instance.computation,
+                                                         compile_options);
+    });
+  }
 
-    CreateCompileHandlesCounter()->AddValue(1);
+  auto memory_stats_status_or = executable->GetCompiledMemoryStats();
+  if (memory_stats_status_or.ok()) {
+    xla::CompiledMemoryStats memory_stats = memory_stats_status_or.value();
+    TF_VLOG(3) << "memory usage detail = " << memory_stats.DebugString();
+  } else {
+    TF_VLOG(3) << "memory usage is not availiable";
   }
 
-  return computations;
+  XLA_ASSIGN_OR_THROW(
+      const std::vector<std::shared_ptr<xla::HloModule>>& hlo_modules,
+      executable->GetHloModules());
+  xla::HloComputation* hlo_computation = hlo_modules[0]->entry_computation();
+  std::shared_ptr<PjRtComputation> pjrt_computation =
+      std::make_shared<PjRtComputation>(
+          std::move(xla::XlaComputation(hlo_modules[0]->ToProto())),
+          instance.devices, std::move(executable));
+  pjrt_computation->set_compile_time_ns(sys_util::NowNs() - start_ns);
+  RecordMemoryFootprint(*pjrt_computation);
+  RecordCostAnalysis(*pjrt_computation);
+  RecordParameterLayouts(*pjrt_computation);
+
+  CreateCompileHandlesCounter()->AddValue(1);
+
+  return pjrt_computation;
+}
+
+PjRtComputationClient::PjRtComputation::CostAnalysis
+PjRtComputationClient::PjRtComputation::ToCostAnalysis(
+    const absl::flat_hash_map<std::string, xla::PjRtValueType>& properties) {
+  // The properties are those of xla::HloCostAnalysis, which backends report
+  // as floats, or as integers for some of them.
+  auto get = [&](const std::string& key) -> double {
+    auto it = properties.find(key);
+    if (it == properties.end()) {
+      return 0;
+    }
+    if (const float* value = std::get_if<float>(&it->second)) {
+      return *value;
+    }
+    if (const int64_t* value = std::get_if<int64_t>(&it->second)) {
+      return static_cast<double>(*value);
+    }
+    return 0;
+  };
+  CostAnalysis cost_analysis;
+  cost_analysis.flops = get("flops");
+  cost_analysis.bytes_accessed = get("bytes accessed");
+  cost_analysis.transcendentals = get("transcendentals");
+  return cost_analysis;
 }
 
 std::string PjRtComputationClient::SerializeComputation(
@@ -723,15 +1486,31 @@ ComputationClient::ComputationPtr PjRtComputationClient::DeserializeComputation(
 
   std::vector<std::string> devices = {UseVirtualDevice() ? spmd_device_str
                                                          : GetDefaultDevice()};
-  return std::make_shared<PjRtComputation>(std::move(computation), devices,
-                                           std::move(loaded_executable));
+  auto pjrt_computation = std::make_shared<PjRtComputation>(
+      std::move(computation), devices, std::move(loaded_executable));
+  RecordMemoryFootprint(*pjrt_computation);
+  RecordCostAnalysis(*pjrt_computation);
+  RecordParameterLayouts(*pjrt_computation);
+  return pjrt_computation;
 }
 
 torch::lazy::hash_t PjRtComputationClient::HashCompilationEnv() {
   // TODO(jonbolin): Incorporate CompileOptions into the hash. These are
   // deterministically generated at the moment, so they don't need to be
   // included. It will require a small refactor, so punting on this for now.
-  return comp_env_hash_;
+  //
+  // The topology query behind the hash is deferred to the first use, which
+  // is the first compilation, rather than paid at startup.
+  std::call_once(comp_env_hash_once_, [this]() {
+    std::vector<xla::PjRtDevice*> ordered_devices = DevicesById(client_.get());
+    comp_env_hash_ = hash_comp_env(client_.get(), ordered_devices);
+  });
+  std::lock_guard<std::mutex> lock(custom_compile_options_hash_lock_);
+  if (!custom_compile_options_hash_.has_value()) {
+    return comp_env_hash_;
+  }
+  return torch::lazy::HashCombine(comp_env_hash_,
+                                  *custom_compile_options_hash_);
 }
 
 absl::StatusOr<std::vector<ComputationClient::DataPtr>>
@@ -749,14 +1528,20 @@ PjRtComputationClient::ExecuteComputation(
   auto timed = std::make_shared<metrics::TimedSection>(metrics_fn());
   tsl::profiler::TraceMe activity("PjRtComputationClient::ExecuteComputation",
                                   tsl::profiler::TraceMeLevel::kInfo);
+  FlushBufferDeletions();
   TF_VLOG(1) << "Executing PjRt computation on " << device;
   const PjRtComputation& pjrt_computation =
       dynamic_cast<const PjRtComputation&>(computation);
 
   xla::PjRtDevice* pjrt_device = StringToPjRtDevice(device);
   ABSL_CHECK(pjrt_device->IsAddressable()) << pjrt_device->DebugString();
+  PrepareExecutionMemory(device, arguments);
 
+  xla::PjRtMemorySpace* device_space = *pjrt_device->default_memory_space();
   std::vector<xla::PjRtBuffer*> buffers;
+  // Device copies of the arguments placed in other memory spaces with
+  // CopyToMemoryKind(), alive until the execution completes.
+  std::vector<std::shared_ptr<xla::PjRtBuffer>> staged_buffers;
   buffers.reserve(arguments.size());
   for (auto& argument : arguments) {
     const PjRtData* pjrt_data = dynamic_cast<PjRtData*>(argument.get());
@@ -765,7 +1550,15 @@ PjRtComputationClient::ExecuteComputation(
         << "The device currently being used : " << pjrt_device->DebugString()
         << " is different from the device where the buffer resides: "
         << pjrt_data->buffer->device()->DebugString();
-    buffers.push_back(pjrt_data->buffer.get());
+    xla::PjRtBuffer* buffer = pjrt_data->buffer.get();
+    if (buffer->memory_space() != device_space) {
+      XLA_ASSIGN_OR_RETURN(std::unique_ptr<xla::PjRtBuffer> staged,
+                           buffer->CopyToMemorySpace(device_space));
+      buffer = staged.get();
+      staged_buffers.push_back(std::move(staged));
+      XLA_COUNTER("StagedMemoryKindArguments", 1);
+    }
+    buffers.push_back(buffer);
   }
 
   xla::ExecuteOptions execute_options;
@@ -786,8 +1579,10 @@ PjRtComputationClient::ExecuteComputation(
       pjrt_computation.executable->ExecuteSharded(
           buffers, pjrt_device, execute_options, returned_future));
 
-  returned_future->OnReady(std::move(
-      [timed, op_tracker = std::move(op_tracker)](absl::Status unused) mutable {
+  returned_future->OnReady(
+      std::move([timed, op_tracker = std::move(op_tracker),
+                 staged_buffers = std::move(staged_buffers)](
+                    absl::Status unused) mutable {
         timed.reset();
         TF_VLOG(3) << "ExecuteComputation returned_future->OnReady finished";
       }));
@@ -821,44 +1616,54 @@ PjRtComputationClient::ExecuteReplicated(
       std::make_shared<metrics::TimedSection>(ExecuteReplicatedMetric());
   tsl::profiler::TraceMe activity("PjRtComputationClient::ExecuteReplicated",
                                   tsl::profiler::TraceMeLevel::kInfo);
+  FlushBufferDeletions();
   const PjRtComputation& pjrt_computation =
       dynamic_cast<const PjRtComputation&>(computation);
 
+  std::shared_ptr<const std::vector<xla::PjRtDevice*>> pjrt_devices =
+      GetExecuteDevices(pjrt_computation, devices);
+  const size_t num_arguments = arguments.size();
   std::vector<std::vector<xla::PjRtBuffer*>> argument_handles(
-      devices.size(), std::vector<xla::PjRtBuffer*>(arguments.size()));
+      devices.size(), std::vector<xla::PjRtBuffer*>(num_arguments));
   {
     tsl::profiler::TraceMe activity(
         "PjRtComputationClient::ExecuteReplicated_argument_handle",
         tsl::profiler::TraceMeLevel::kInfo);
 
-    absl::BlockingCounter counter(arguments.size());
-
-    // Time in nanoseconds that it takes to prepare an argument. Used to tune
-    // number of threads spawned by ParallelFor. Measured on 2023/11/28.
-    static constexpr int64_t argument_handle_cost_ns = 10000;
+    // Time in nanoseconds that it takes to prepare an argument, with the
+    // devices resolved ahead. Used to tune number of threads spawned by
+    // ParallelFor.
+    static constexpr int64_t argument_handle_cost_ns = 1000;
+    const int64_t start_ns = sys_util::NowNs();
     pool_.ParallelFor(
-        arguments.size(), argument_handle_cost_ns,
+        num_arguments, argument_handle_cost_ns,
         [&](int64_t start, int64_t end) {
-          for (int32_t i = start; i < end; ++i) {
-            auto pjrt_data =
-                std::dynamic_pointer_cast<PjRtShardedData>(arguments[i]);
+          for (int64_t i = start; i < end; ++i) {
+            ABSL_DCHECK(dynamic_cast<const PjRtShardedData*>(
+                            arguments[i].get()) != nullptr);
+            const auto* pjrt_data =
+                static_cast<const PjRtShardedData*>(arguments[i].get());
             ABSL_CHECK_EQ(pjrt_data->shards.size(), devices.size())
                 << "Expected one shard per device";
 
-            for (int32_t d = 0; d < devices.size(); d++) {
-              std::shared_ptr<PjRtData> shard = pjrt_data->shards[d];
-
-              xla::PjRtDevice* pjrt_device = StringToPjRtDevice(devices[d]);
-              ABSL_CHECK_EQ(shard->buffer->device(), pjrt_device);
-              ABSL_CHECK(pjrt_device->IsAddressable())
-                  << pjrt_device->DebugString();
-
-              argument_handles[d][i] = shard->buffer.get();
+            for (size_t d = 0; d < devices.size(); ++d) {
+              xla::PjRtBuffer* buffer = pjrt_data->shards[d]->buffer.get();
+              ABSL_DCHECK_EQ(buffer->device(), (*pjrt_devices)[d]);
+              argument_handles[d][i] = buffer;
             }
-            counter.DecrementCount();
           }
         });
-    counter.Wait();
+    // The few arguments of a small graph do not tell the cost of a large one.
+    static constexpr size_t kMinMeasuredArguments = 64;
+    if (num_arguments >= kMinMeasuredArguments) {
+      double cost_ns =
+          static_cast<double>(sys_util::NowNs() - start_ns) / num_arguments;
+      double average_ns =
+          argument_handle_cost_ns_.load(std::memory_order_relaxed);
+      argument_handle_cost_ns_.store(
+          average_ns == 0 ? cost_ns : 0.9 * average_ns + 0.1 * cost_ns,
+          std::memory_order_relaxed);
+    }
   }
 
   xla::ExecuteOptions execute_options;
@@ -953,6 +1758,26 @@ PjRtComputationClient::ExecuteReplicated(
   return data_handles;
 }
 
+std::shared_ptr<const std::vector<xla::PjRtDevice*>>
+PjRtComputationClient::GetExecuteDevices(
+    const PjRtComputation& computation,
+    absl::Span<const std::string> devices) {
+  std::lock_guard<std::mutex> lock(computation.execute_devices_mutex_);
+  if (computation.execute_devices_ == nullptr ||
+      !absl::c_equal(computation.execute_device_names_, devices)) {
+    auto pjrt_devices = std::make_shared<std::vector<xla::PjRtDevice*>>();
+    pjrt_devices->reserve(devices.size());
+    for (const std::string& device : devices) {
+      xla::PjRtDevice* pjrt_device = StringToPjRtDevice(device);
+      XLA_CHECK(pjrt_device->IsAddressable()) << pjrt_device->DebugString();
+      pjrt_devices->push_back(pjrt_device);
+    }
+    computation.execute_device_names_.assign(devices.begin(), devices.end());
+    computation.execute_devices_ = std::move(pjrt_devices);
+  }
+  return computation.execute_devices_;
+}
+
 size_t PjRtComputationClient::GetNumLocalDevices() const {
   return client_->addressable_device_count();
 }
@@ -1017,11 +1842,15 @@ xla::PjRtDevice* PjRtComputationClient::StringToPjRtDevice(
 void PjRtComputationClient::WaitDeviceOps(
     absl::Span<const std::string> devices) {
   TF_VLOG(3) << "Waiting for " << absl::StrJoin(devices, ", ");
-  operation_manager_.WaitForDevices(
-      devices.empty()
-          ? (UseVirtualDevice() ? std::vector<std::string>({spmd_device_str})
-                                : GetLocalDevices())
-          : devices);
+  XLA_ASSIGN_OR_THROW(
+      absl::Duration waited,
+      operation_manager_.WaitForDevices(
+          devices.empty() ? (UseVirtualDevice()
+                                 ? std::vector<std::string>({spmd_device_str})
+                                 : GetLocalDevices())
+                          : devices));
+  TF_VLOG(3) << "Waited " << absl::FormatDuration(waited)
+             << " for the device operations";
 }
 
 std::map<std::string, Metric> PjRtComputationClient::GetMetrics() const {
@@ -1033,6 +1862,8 @@ ComputationClient::MemoryInfo PjRtComputationClient::GetMemoryInfo(
     const std::string& device) {
   XLA_CHECK_NE(device, spmd_device_str)
       << "MemoryInfo not supported for SPMD virtual device.";
+  // The stats account for the memory of the buffers dropped so far.
+  FlushBufferDeletions();
   xla::PjRtDevice* pjrt_device =
       PjRtComputationClient::StringToPjRtDevice(device);
   tsl::AllocatorStats stats = pjrt_device->GetAllocatorStats().value();
@@ -1041,6 +1872,7 @@ ComputationClient::MemoryInfo PjRtComputationClient::GetMemoryInfo(
       stats.bytes_in_use,
       *stats.bytes_limit,
       stats.peak_bytes_in_use,
+      stats.largest_free_block_bytes,
   };
 }
 
@@ -1067,6 +1899,21 @@ void PjRtComputationClient::SetCustomCompileOptions(
   for (const auto& [key, value] : options) {
     custom_compile_options_[key] = value;
   }
+  // The options are hashed in a deterministic order.
+  std::optional<torch::lazy::hash_t> options_hash;
+  if (!options.empty()) {
+    std::map<std::string, std::string> sorted(options.begin(), options.end());
+    torch::lazy::hash_t hash = torch::lazy::MHash(sorted.size());
+    for (const auto& [key, value] : sorted) {
+      hash = torch::lazy::HashCombine(hash, torch::lazy::MHash(key, value));
+    }
+    options_hash = hash;
+  }
+  {
+    std::lock_guard<std::mutex> lock(custom_compile_options_hash_lock_);
+    custom_compile_options_hash_ = options_hash;
+  }
+  comp_env_version_.fetch_add(1, std::memory_order_acq_rel);
 }
 
 }  // namespace runtime
@@ -1,25 +1,33 @@
 #ifndef XLA_CLIENT_PJRT_COMPUTATION_CLIENT_H_
 #define XLA_CLIENT_PJRT_COMPUTATION_CLIENT_H_
 
+#include <atomic>
 #include <cstdint>
 #include <mutex>
+#include <optional>
 #include <shared_mutex>
+#include <string>
 
 #include <torch/csrc/lazy/backend/backend_data.h>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/types/span.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/threadpool.h"
 #include "xla/hlo/builder/xla_computation.h"
+#include "xla/layout.h"
 #include "xla/literal.h"
 #include "xla/pjrt/pjrt_api.h"
 #include "xla/pjrt/pjrt_client.h"
 #include "xla/pjrt/pjrt_executable.h"
 #include "xla/shape.h"
 
+#include "torch_xla/csrc/runtime/cache.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/host_buffer_pool.h"
 #include "torch_xla/csrc/runtime/operation_manager.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/util.h"
 
 namespace torch_xla {
@@ -69,6 +77,15 @@ class PjRtComputationClient : public ComputationClient {
   absl::StatusOr<std::vector<xla::Literal>> TransferFromDevice(
       absl::Span<const DataPtr> handles) override;
 
+  std::unique_ptr<AsyncTransfer> TransferFromDeviceAsync(
+      absl::Span<const DataPtr> handles) override;
+
+  absl::StatusOr<std::vector<std::shared_ptr<const xla::LiteralBase>>>
+  TransferFromDeviceToHostPool(absl::Span<const DataPtr> handles) override;
+
+  void TransferFromDeviceStreaming(absl::Span<const DataPtr> handles,
+                                   const LiteralCallback& on_ready) override;
+
   std::uintptr_t UnsafeBufferPointer(const DataPtr handle) override;
 
   std::shared_ptr<xla::PjRtBuffer> GetPjRtBuffer(const DataPtr handle) override;
@@ -79,6 +96,11 @@ class PjRtComputationClient : public ComputationClient {
 
   DataPtr CopyToDevice(DataPtr data, std::string dst) override;
 
+  absl::StatusOr<DataPtr> CopyToMemoryKind(
+      DataPtr data, const std::string& memory_kind) override;
+
+  std::string GetMemoryKind(DataPtr data) override;
+
   std::vector<ComputationPtr> Compile(
       std::vector<CompileInstance> instances) override;
 
@@ -127,6 +149,10 @@ class PjRtComputationClient : public ComputationClient {
 
   torch::lazy::hash_t HashCompilationEnv() override;
 
+  uint64_t CompilationEnvVersion() const override {
+    return comp_env_version_.load(std::memory_order_acquire);
+  }
+
   int GetProcessIndex() const override { return client_->process_index(); };
 
   int GetNumProcesses() const override;
@@ -154,6 +180,10 @@ class PjRtComputationClient : public ComputationClient {
 
   MemoryInfo GetMemoryInfo(const std::string& device) override;
 
+  double GetArgumentHandleCostNs() const override {
+    return argument_handle_cost_ns_.load(std::memory_order_relaxed);
+  }
+
   std::string PjRtDeviceToString(xla::PjRtDevice* const device) const override;
   std::vector<std::string> PjRtDevicesToString(
       absl::Span<xla::PjRtDevice* const> devices) const;
@@ -195,17 +225,38 @@ class PjRtComputationClient : public ComputationClient {
   std::unordered_map<std::string, xla::PjRtDevice* const> string_to_device_;
   std::shared_ptr<std::vector<std::string>> replication_devices_;
   OperationManager operation_manager_;
+  // The moving average of the time per argument of the argument handles of
+  // the replicated executions.
+  std::atomic<double> argument_handle_cost_ns_{0};
   tsl::thread::ThreadPool pool_ = tsl::thread::ThreadPool(
       tsl::Env::Default(), "pjrt", std::thread::hardware_concurrency());
+  std::once_flag comp_env_hash_once_;
   torch::lazy::hash_t comp_env_hash_;
+  // The hash of the custom compile options merged into the compilation
+  // environment hash, and the version of the latter.
+  std::mutex custom_compile_options_hash_lock_;
+  std::optional<torch::lazy::hash_t> custom_compile_options_hash_;
+  std::atomic<uint64_t> comp_env_version_{0};
 
   // If not nullptr, invoke this instead of the actual XLA compilation. Used
   // only for testing.
   std::function<absl::Status()> fake_xla_compile_ = nullptr;
   std::unordered_map<std::string, std::string> custom_compile_options_;
+  // The resharding programs, by the shapes and the source and destination
+  // shardings of their parameters.
+  util::Cache<std::string, Computation> reshard_computations_ =
+      util::Cache<std::string, Computation>(
+          sys_util::GetEnvInt("XLA_RESHARD_CACHE_SIZE", 128));
 
   xla::PjRtDevice* StringToPjRtDevice(const std::string& device);
 
+  // Compiles a single instance on the calling thread.
+  ComputationPtr CompileSingle(CompileInstance& instance);
+
+  // Starts the transfer of a single tensor on the calling thread.
+  DataPtr TransferSingleToDevice(
+      const std::shared_ptr<const TensorSource>& tensor);
+
   struct PjRtData : public Data {
     PjRtData(std::string device, xla::Shape device_shape)
         : Data(std::move(device), std::move(device_shape)) {}
@@ -220,6 +271,9 @@ class PjRtComputationClient : public ComputationClient {
                           buffer->is_dynamic_dimension())),
           buffer(buffer) {}
 
+    // Hands the buffer over to the BufferDeleter, if enabled.
+    ~PjRtData() override;
+
     Handle GetHandle() override {
       // If the data is a placeholder, use the address of this object as the
       // handle.
@@ -260,6 +314,11 @@ class PjRtComputationClient : public ComputationClient {
     }
 
     std::shared_ptr<xla::PjRtBuffer> buffer;
+    // The execution step which last used this data as an argument, and
+    // whether `buffer` was moved to host memory by the spilling, guarded by
+    // `spill_mutex_`.
+    int64_t last_use_step = 0;
+    bool spilled = false;
   };
 
   struct PjRtShardedData : public Data {
@@ -328,6 +387,20 @@ class PjRtComputationClient : public ComputationClient {
         : Computation(std::move(computation), std::move(devices)),
           executable(std::move(executable)) {
       output_shardings_ = this->executable->GetOutputShardings();
+      auto memory_stats_status_or = this->executable->GetCompiledMemoryStats();
+      if (memory_stats_status_or.ok()) {
+        const xla::CompiledMemoryStats& stats = memory_stats_status_or.value();
+        memory_footprint_ = MemoryFootprint{
+            stats.argument_size_in_bytes, stats.output_size_in_bytes,
+            stats.alias_size_in_bytes, stats.temp_size_in_bytes,
+            stats.generated_code_size_in_bytes};
+      }
+      // The cost analysis runs once per executable, here, and is only read
+      // from then on.
+      auto cost_analysis_status_or = this->executable->GetCostAnalysis();
+      if (cost_analysis_status_or.ok()) {
+        cost_analysis_ = ToCostAnalysis(cost_analysis_status_or.value());
+      }
     }
 
     const std::string get_memory_info() const override {
@@ -339,12 +412,94 @@ class PjRtComputationClient : public ComputationClient {
       }
     }
 
+    size_t executable_size_bytes() const override {
+      auto memory_stats_status_or = executable->GetCompiledMemoryStats();
+      if (!memory_stats_status_or.ok()) {
+        return 0;
+      }
+      return memory_stats_status_or.value().generated_code_size_in_bytes;
+    }
+
+    std::optional<MemoryFootprint> memory_footprint() const override {
+      return memory_footprint_;
+    }
+
+    std::optional<CostAnalysis> cost_analysis() const override {
+      return cost_analysis_;
+    }
+
+    static CostAnalysis ToCostAnalysis(
+        const absl::flat_hash_map<std::string, xla::PjRtValueType>&
+            properties);
+
     std::unique_ptr<xla::PjRtLoadedExecutable> executable;
     std::optional<std::vector<xla::OpSharding>> output_shardings_;
+    std::optional<MemoryFootprint> memory_footprint_;
+    std::optional<CostAnalysis> cost_analysis_;
+
+    // Devices of the last `ExecuteReplicated` call, resolved once since the
+    // same computation is normally executed on the same devices every step.
+    mutable std::mutex execute_devices_mutex_;
+    mutable std::vector<std::string> execute_device_names_;
+    mutable std::shared_ptr<const std::vector<xla::PjRtDevice*>>
+        execute_devices_;
   };
 
+  // Returns the PJRT devices of `devices`, cached in `computation`.
+  std::shared_ptr<const std::vector<xla::PjRtDevice*>> GetExecuteDevices(
+      const PjRtComputation& computation,
+      absl::Span<const std::string> devices);
+
   // Use XLA replication to re-assemble the sharded data.
   std::shared_ptr<PjRtData> ReplicateShardedData(const DataPtr& handle);
+
+  // Makes `data` a candidate for spilling to host memory, if enabled with
+  // XLA_DEVICE_MEMORY_SPILL_WATERMARK.
+  // The literals being read from the device by StartHostTransfer(), each
+  // ready once its future is.
+  struct HostTransfer {
+    std::vector<std::shared_ptr<const xla::LiteralBase>> literals;
+    std::vector<xla::PjRtFuture<>> futures;
+    int64_t total_size = 0;
+  };
+
+  // Starts reading the values behind `handles` into buffers of `pool`, or
+  // into newly allocated literals if `pool` is nullptr. Returns nullopt if
+  // some value is sharded, or not a static array, which TransferFromDevice()
+  // reads instead.
+  std::optional<HostTransfer> StartHostTransfer(
+      absl::Span<const DataPtr> handles, HostBufferPool* pool);
+
+  void TrackSpillableData(const std::shared_ptr<PjRtData>& data);
+
+  // Moves the spilled `arguments` of an execution on `device` back to device
+  // memory. Then, if the device memory use is over the spill watermark,
+  // moves the least recently used data of `device` to host memory.
+  void PrepareExecutionMemory(const std::string& device,
+                              absl::Span<const DataPtr> arguments);
+
+  // Drops the expired entries of `spillable_data_`.
+  void PruneSpillableData();
+
+  std::mutex spill_mutex_;
+  std::vector<std::weak_ptr<PjRtData>> spillable_data_;
+  size_t next_spillable_data_prune_ = 1024;
+  int64_t execution_step_ = 0;
+
+  // Records the parameter layouts of `computation`, if enabled with
+  // XLA_TRANSFER_PARAMETER_LAYOUTS. The host transfers of arrays of the same
+  // shape are then laid out for the computation, instead of being relaid out
+  // on the device at every step.
+  void RecordParameterLayouts(const PjRtComputation& computation);
+
+  // Returns the device layout recorded for the arrays of `shape`, if any.
+  std::optional<xla::Layout> GetParameterLayout(const xla::Shape& shape);
+
+  std::mutex parameter_layouts_mutex_;
+  // Keyed by the shape without its layout. The shapes which computations want
+  // in different layouts map to nullopt, and use the default device layout.
+  absl::flat_hash_map<std::string, std::optional<xla::Layout>>
+      parameter_layouts_;
 };
 
 }  // namespace runtime
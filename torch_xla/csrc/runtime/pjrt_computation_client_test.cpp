@@ -4,6 +4,8 @@
 
 #include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -131,5 +133,53 @@ TEST_F(PjRtComputationClientTest, Init) {
       result_literals[0]));
 }
 
+TEST_F(PjRtComputationClientTest, CustomCompileOptionsChangeTheEnvHash) {
+  torch::lazy::hash_t default_hash = client_->HashCompilationEnv();
+  uint64_t version = client_->CompilationEnvVersion();
+
+  client_->SetCustomCompileOptions({{"xla_foo", "1"}, {"xla_bar", "2"}});
+  EXPECT_NE(client_->CompilationEnvVersion(), version);
+  torch::lazy::hash_t custom_hash = client_->HashCompilationEnv();
+  EXPECT_NE(custom_hash, default_hash);
+
+  // The hash does not depend on the order of the options.
+  client_->SetCustomCompileOptions({{"xla_bar", "2"}, {"xla_foo", "1"}});
+  EXPECT_EQ(client_->HashCompilationEnv(), custom_hash);
+
+  client_->SetCustomCompileOptions({});
+  EXPECT_EQ(client_->HashCompilationEnv(), default_hash);
+}
+
+TEST_F(PjRtComputationClientTest, TransferFromDeviceStreaming) {
+  std::vector<std::shared_ptr<const TensorSource>> args = {
+      std::make_shared<LiteralSource>(
+          xla::LiteralUtil::CreateR2<float>({{1.0f, 2.0f}, {3.0f, 4.0f}}),
+          device_),
+      std::make_shared<LiteralSource>(
+          xla::LiteralUtil::CreateR1<int32_t>({5, 6, 7}), device_)};
+  std::vector<ComputationClient::DataPtr> handles =
+      client_->TransferToDevice(absl::MakeConstSpan(args));
+
+  std::mutex lock;
+  std::vector<std::optional<xla::Literal>> literals(handles.size());
+  client_->TransferFromDeviceStreaming(
+      handles,
+      [&](size_t index,
+          absl::StatusOr<std::shared_ptr<const xla::LiteralBase>> literal) {
+        ASSERT_TRUE(literal.ok()) << literal.status();
+        std::lock_guard<std::mutex> guard(lock);
+        literals[index] = (*literal)->Clone();
+      });
+
+  // Every value has landed by the time the call returns.
+  ASSERT_TRUE(literals[0].has_value());
+  EXPECT_TRUE(xla::LiteralTestUtil::Equal(
+      xla::LiteralUtil::CreateR2<float>({{1.0f, 2.0f}, {3.0f, 4.0f}}),
+      *literals[0]));
+  ASSERT_TRUE(literals[1].has_value());
+  EXPECT_TRUE(xla::LiteralTestUtil::Equal(
+      xla::LiteralUtil::CreateR1<int32_t>({5, 6, 7}), *literals[1]));
+}
+
 }  // namespace runtime
 }  // namespace torch_xla
@@ -2,6 +2,8 @@
 
 #include <c10/util/Exception.h>
 
+#include <future>
+
 #include "absl/log/absl_check.h"
 #include "absl/log/initialize.h"
 #include "xla/pjrt/c/pjrt_c_api.h"
@@ -14,6 +16,7 @@
 
 #include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/env_vars.h"
+#include "torch_xla/csrc/runtime/metrics.h"
 #include "torch_xla/csrc/runtime/profiler.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/tf_logging.h"
@@ -61,6 +64,17 @@ absl::StatusOr<std::shared_ptr<const PjRtPlugin>> GetPjRtPlugin(
   return entry->second;
 }
 
+// Loads and initializes the PjRt plugin of `device_type` from `library_path`.
+absl::StatusOr<const PJRT_Api*> LoadPlugin(const std::string& device_type,
+                                           const std::string& library_path) {
+  XLA_TIMED("StartupPluginLoadTime");
+  XLA_ASSIGN_OR_RETURN(
+      const PJRT_Api* c_api,
+      pjrt::LoadPjrtPlugin(absl::AsciiStrToLower(device_type), library_path));
+  XLA_RETURN_IF_ERROR(pjrt::InitializePjrtPlugin(device_type));
+  return c_api;
+}
+
 }  // namespace
 
 void RegisterPjRtPlugin(std::string name,
@@ -84,6 +98,12 @@ InitializePjRt(const std::string& device_type) {
       // Init the absl logging to avoid the log spam.
       absl::InitializeLog();
 
+      // Loading the plugin does not depend on the coordinator, so it overlaps
+      // with the connection to the coordinator service.
+      std::future<absl::StatusOr<const PJRT_Api*>> c_api_future =
+          std::async(std::launch::async, LoadPlugin, device_type,
+                     plugin->library_path());
+
       std::shared_ptr<xla::KeyValueStoreInterface> kv_store = nullptr;
       if (plugin->requires_xla_coordinator()) {
         int local_process_rank = sys_util::GetEnvInt(
@@ -106,32 +126,35 @@ InitializePjRt(const std::string& device_type) {
                    << ", coordinator address=" << master_addr << ":" << port;
 
         // Use the XlaCoordinator as the distributed key-value store.
-        XLA_ASSIGN_OR_RETURN(
-            coordinator,
-            XlaCoordinator::Create(global_process_rank, global_world_size,
-                                   master_addr, port));
+        {
+          XLA_TIMED("StartupCoordinatorTime");
+          XLA_ASSIGN_OR_RETURN(
+              coordinator,
+              XlaCoordinator::Create(global_process_rank, global_world_size,
+                                     master_addr, port));
+        }
         std::shared_ptr<xla::DistributedRuntimeClient> distributed_client =
             coordinator->GetClient();
         kv_store = xla::GetDistributedKeyValueStore(distributed_client,
                                                     /*key_prefix=*/"pjrt:");
       }
-      XLA_ASSIGN_OR_RETURN(
-          const PJRT_Api* c_api,
-          pjrt::LoadPjrtPlugin(absl::AsciiStrToLower(device_type),
-                               plugin->library_path()));
-      XLA_RETURN_IF_ERROR(pjrt::InitializePjrtPlugin(device_type));
+      XLA_ASSIGN_OR_RETURN(const PJRT_Api* c_api, c_api_future.get());
       auto create_options = plugin->client_create_options();
-      XLA_ASSIGN_OR_RETURN(
-          client,
-          xla::GetCApiClient(absl::AsciiStrToUpper(device_type),
-                             {create_options.begin(), create_options.end()},
-                             kv_store));
+      {
+        XLA_TIMED("StartupClientCreateTime");
+        XLA_ASSIGN_OR_RETURN(
+            client,
+            xla::GetCApiClient(absl::AsciiStrToUpper(device_type),
+                               {create_options.begin(), create_options.end()},
+                               kv_store));
+      }
       profiler::RegisterProfilerForPlugin(c_api);
     }
   } else if (device_type == "CPU") {
     TF_VLOG(1) << "Initializing PjRt CPU client...";
     bool async = sys_util::GetEnvBool(env::kEnvPjrtAsyncCpuClient, true);
     int cpu_device_count = sys_util::GetEnvInt(env::kEnvNumCpu, 1);
+    XLA_TIMED("StartupClientCreateTime");
     XLA_ASSIGN_OR_RETURN(client,
                          xla::GetPjRtCpuClient(async, cpu_device_count));
   } else if (device_type == "TPU") {
@@ -143,8 +166,8 @@ InitializePjRt(const std::string& device_type) {
         env::kEnvTpuLibraryPath,
         sys_util::GetEnvString(env::kEnvInferredTpuLibraryPath, "libtpu.so"));
     XLA_ASSIGN_OR_RETURN(const PJRT_Api* c_api,
-                         pjrt::LoadPjrtPlugin("tpu", tpu_library_path));
-    XLA_RETURN_IF_ERROR(pjrt::InitializePjrtPlugin("tpu"));
+                         LoadPlugin("tpu", tpu_library_path));
+    XLA_TIMED("StartupClientCreateTime");
     XLA_ASSIGN_OR_RETURN(client, xla::GetCApiClient("TPU"));
     profiler::RegisterProfilerForPlugin(c_api);
   } else if (device_type == "TPU_LEGACY") {
@@ -2,12 +2,15 @@
 
 #include <torch/csrc/lazy/backend/backend_device.h>
 
+#include <thread>
+
 #include "absl/log/absl_check.h"
 #include "tsl/platform/stacktrace_handler.h"
 
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/env_vars.h"
 #include "torch_xla/csrc/runtime/ifrt_computation_client.h"
+#include "torch_xla/csrc/runtime/metrics.h"
 #include "torch_xla/csrc/runtime/pjrt_computation_client.h"
 #include "torch_xla/csrc/status.h"
 
@@ -20,6 +23,7 @@ static std::atomic<bool> g_computation_client_initialized(false);
 // Can only be called when g_computation_client_initialized is false.
 static absl::StatusOr<ComputationClient * absl_nonnull>
 InitializeComputationClient() {
+  XLA_TIMED("StartupTime");
   if (sys_util::GetEnvBool("XLA_DUMP_FATAL_STACK", false)) {
     tsl::testing::InstallStacktraceHandler();
   }
@@ -61,6 +65,13 @@ const absl::StatusOr<ComputationClient * absl_nonnull>& GetComputationClient() {
   return maybe_client;
 }
 
+void StartComputationClientInitialization() {
+  // The function local singleton in GetComputationClient() makes any other
+  // caller wait for this initialization to complete, rather than start
+  // another one.
+  std::thread([]() { GetComputationClient(); }).detach();
+}
+
 ComputationClient* GetComputationClientIfInitialized() {
   if (!g_computation_client_initialized) {
     return nullptr;
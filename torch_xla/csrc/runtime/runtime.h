@@ -11,6 +11,11 @@ namespace torch_xla::runtime {
 // Returns the ComputationClient singleton.
 const absl::StatusOr<ComputationClient * absl_nonnull>& GetComputationClient();
 
+// Starts initializing the ComputationClient singleton in the background, so
+// that loading the PjRt plugin and creating the client overlap with the work
+// of the caller. GetComputationClient() blocks until it completes.
+void StartComputationClientInitialization();
+
 // Returns the ComputationClient singleton if it was successfully initialized.
 // Returns a nullptr if the ComputationClient wasn't initialized yet.
 // Throws an exception if the ComputationClient was initialized but the
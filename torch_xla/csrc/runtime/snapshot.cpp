@@ -0,0 +1,335 @@
+#include "torch_xla/csrc/runtime/snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+#include "absl/strings/str_cat.h"
+#include "tsl/profiler/lib/traceme.h"
+#include "xla/shape_util.h"
+
+#include "torch_xla/csrc/runtime/metrics.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tf_logging.h"
+#include "torch_xla/csrc/status.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+// Layout of a snapshot file:
+//   Header
+//   value 0, aligned to kAlignment
+//   ...
+//   value N - 1, aligned to kAlignment
+//   index: for each value, its element type, rank and dimensions.
+constexpr char kMagic[8] = {'P', 'T', 'X', 'L', 'S', 'N', 'P', '1'};
+constexpr size_t kAlignment = 64;
+
+struct Header {
+  char magic[sizeof(kMagic)];
+  uint64_t num_values;
+  uint64_t index_offset;
+  uint64_t index_size;
+};
+
+size_t AlignUp(size_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+absl::Status ErrnoError(const std::string& what, const std::string& path) {
+  return absl::InternalError(
+      absl::StrCat(what, " ", path, ": ", std::strerror(errno)));
+}
+
+// The dense, row major shape values are stored with.
+xla::Shape HostShape(const xla::Shape& shape) {
+  return xla::ShapeUtil::MakeShapeWithDescendingLayout(shape.element_type(),
+                                                       shape.dimensions());
+}
+
+// Offsets of the values of `shapes` in the file, followed by the offset of
+// the index.
+std::vector<size_t> ValueOffsets(absl::Span<const xla::Shape> shapes) {
+  std::vector<size_t> offsets;
+  offsets.reserve(shapes.size() + 1);
+  size_t offset = AlignUp(sizeof(Header));
+  for (const xla::Shape& shape : shapes) {
+    offsets.push_back(offset);
+    offset = AlignUp(offset + xla::ShapeUtil::ByteSizeOf(shape));
+  }
+  offsets.push_back(offset);
+  return offsets;
+}
+
+std::string EncodeIndex(absl::Span<const xla::Shape> shapes) {
+  std::string index;
+  auto append = [&](int64_t value) {
+    index.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+  for (const xla::Shape& shape : shapes) {
+    append(shape.element_type());
+    append(shape.dimensions_size());
+    for (int64_t dimension : shape.dimensions()) {
+      append(dimension);
+    }
+  }
+  return index;
+}
+
+absl::StatusOr<std::vector<xla::Shape>> DecodeIndex(const char* data,
+                                                    size_t size,
+                                                    size_t num_values) {
+  size_t position = 0;
+  auto next = [&](int64_t* value) {
+    if (position + sizeof(*value) > size) {
+      return false;
+    }
+    std::memcpy(value, data + position, sizeof(*value));
+    position += sizeof(*value);
+    return true;
+  };
+  std::vector<xla::Shape> shapes;
+  shapes.reserve(num_values);
+  for (size_t i = 0; i < num_values; ++i) {
+    int64_t element_type = 0;
+    int64_t rank = 0;
+    if (!next(&element_type) || !next(&rank) || rank < 0 ||
+        !xla::PrimitiveType_IsValid(element_type)) {
+      return absl::DataLossError("Corrupted snapshot index");
+    }
+    std::vector<int64_t> dimensions(rank);
+    for (int64_t& dimension : dimensions) {
+      if (!next(&dimension) || dimension < 0) {
+        return absl::DataLossError("Corrupted snapshot index");
+      }
+    }
+    shapes.push_back(xla::ShapeUtil::MakeShapeWithDescendingLayout(
+        static_cast<xla::PrimitiveType>(element_type), dimensions));
+  }
+  return shapes;
+}
+
+// A file mapped in memory, unmapped and closed on destruction.
+class MappedFile {
+ public:
+  // Creates the file at `path`, of `size` bytes, mapped for writing.
+  static absl::StatusOr<std::unique_ptr<MappedFile>> Create(
+      const std::string& path, size_t size) {
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      return ErrnoError("Failed to create", path);
+    }
+    auto file = std::make_unique<MappedFile>(fd, size);
+    if (ftruncate(fd, size) != 0) {
+      return ErrnoError("Failed to allocate", path);
+    }
+    XLA_RETURN_IF_ERROR(file->Map(PROT_READ | PROT_WRITE, path));
+    return file;
+  }
+
+  // Opens the file at `path`, mapped for reading.
+  static absl::StatusOr<std::unique_ptr<MappedFile>> Open(
+      const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return ErrnoError("Failed to open", path);
+    }
+    struct stat buffer;
+    if (fstat(fd, &buffer) != 0) {
+      close(fd);
+      return ErrnoError("Failed to stat", path);
+    }
+    auto file = std::make_unique<MappedFile>(fd, buffer.st_size);
+    XLA_RETURN_IF_ERROR(file->Map(PROT_READ, path));
+    return file;
+  }
+
+  MappedFile(int fd, size_t size) : fd_(fd), size_(size) {}
+
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+    close(fd_);
+  }
+
+  char* data() const { return data_; }
+
+  size_t size() const { return size_; }
+
+  // Writes the dirty pages back to the file.
+  absl::Status Sync(const std::string& path) {
+    if (data_ != nullptr && msync(data_, size_, MS_SYNC) != 0) {
+      return ErrnoError("Failed to sync", path);
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Status Map(int protection, const std::string& path) {
+    if (size_ == 0) {
+      return absl::OkStatus();
+    }
+    void* mapped = mmap(nullptr, size_, protection, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+      return ErrnoError("Failed to map", path);
+    }
+    data_ = static_cast<char*>(mapped);
+    return absl::OkStatus();
+  }
+
+  int fd_;
+  size_t size_;
+  char* data_ = nullptr;
+};
+
+// Writes a snapshot of values of `shapes`, where `copy_value(i, dst)` copies
+// the i-th value, in its host shape, to `dst`. The file is written next to
+// `path` and only renamed once complete, so that a snapshot interrupted by
+// the preemption never shadows a previous one.
+absl::Status WriteSnapshotFile(
+    absl::Span<const xla::Shape> shapes,
+    const std::function<absl::Status(size_t, char*)>& copy_value,
+    const std::string& path) {
+  std::string index = EncodeIndex(shapes);
+  std::vector<size_t> offsets = ValueOffsets(shapes);
+  std::string tmp_path = absl::StrCat(path, ".tmp");
+  auto write = [&]() -> absl::Status {
+    XLA_ASSIGN_OR_RETURN(
+        std::unique_ptr<MappedFile> file,
+        MappedFile::Create(tmp_path, offsets.back() + index.size()));
+    Header header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.num_values = shapes.size();
+    header.index_offset = offsets.back();
+    header.index_size = index.size();
+    std::memcpy(file->data(), &header, sizeof(header));
+    for (size_t i = 0; i < shapes.size(); ++i) {
+      XLA_RETURN_IF_ERROR(copy_value(i, file->data() + offsets[i]));
+    }
+    std::memcpy(file->data() + offsets.back(), index.data(), index.size());
+    return file->Sync(tmp_path);
+  };
+  std::error_code error;
+  absl::Status status = write();
+  if (!status.ok()) {
+    std::filesystem::remove(tmp_path, error);
+    return status;
+  }
+  std::filesystem::rename(tmp_path, path, error);
+  if (error) {
+    return absl::InternalError(absl::StrCat("Failed to rename ", tmp_path,
+                                            " to ", path, ": ",
+                                            error.message()));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CopyLiteral(const xla::Literal& literal, const xla::Shape& shape,
+                         char* dst) {
+  if (xla::ShapeUtil::Equal(literal.shape(), shape)) {
+    std::memcpy(dst, literal.untyped_data(), literal.size_bytes());
+    return absl::OkStatus();
+  }
+  if (!xla::ShapeUtil::Compatible(literal.shape(), shape)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Snapshot value of shape ", literal.shape().ToString(),
+                     " does not match ", shape.ToString()));
+  }
+  xla::Literal relayout = literal.Relayout(shape);
+  std::memcpy(dst, relayout.untyped_data(), relayout.size_bytes());
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status WriteSnapshot(ComputationClient* client,
+                           absl::Span<const ComputationClient::DataPtr> handles,
+                           const std::string& path) {
+  tsl::profiler::TraceMe activity("WriteSnapshot",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  int64_t start_ns = sys_util::NowNs();
+  // One transfer per handle, so that each value can be written as soon as it
+  // lands instead of waiting for the slowest one.
+  std::vector<std::unique_ptr<ComputationClient::AsyncTransfer>> transfers;
+  std::vector<xla::Shape> shapes;
+  transfers.reserve(handles.size());
+  shapes.reserve(handles.size());
+  for (const ComputationClient::DataPtr& handle : handles) {
+    transfers.push_back(client->TransferFromDeviceAsync({handle}));
+    shapes.push_back(HostShape(handle->shape()));
+  }
+  XLA_RETURN_IF_ERROR(WriteSnapshotFile(
+      shapes,
+      [&](size_t i, char* dst) -> absl::Status {
+        XLA_ASSIGN_OR_RETURN(std::vector<xla::Literal> literals,
+                             transfers[i]->Await());
+        transfers[i].reset();
+        return CopyLiteral(literals.front(), shapes[i], dst);
+      },
+      path));
+  XLA_VALUE_METRIC("SnapshotTime", sys_util::NowNs() - start_ns);
+  TF_VLOG(1) << "Wrote a snapshot of " << handles.size() << " values to "
+             << path << " in " << (sys_util::NowNs() - start_ns) / 1000000
+             << " ms";
+  return absl::OkStatus();
+}
+
+absl::Status WriteSnapshot(absl::Span<const xla::Literal> literals,
+                           const std::string& path) {
+  std::vector<xla::Shape> shapes;
+  shapes.reserve(literals.size());
+  for (const xla::Literal& literal : literals) {
+    shapes.push_back(HostShape(literal.shape()));
+  }
+  return WriteSnapshotFile(
+      shapes,
+      [&](size_t i, char* dst) {
+        return CopyLiteral(literals[i], shapes[i], dst);
+      },
+      path);
+}
+
+absl::StatusOr<std::vector<xla::Literal>> ReadSnapshot(
+    const std::string& path) {
+  XLA_ASSIGN_OR_RETURN(std::unique_ptr<MappedFile> file,
+                       MappedFile::Open(path));
+  Header header;
+  if (file->size() < sizeof(header)) {
+    return absl::DataLossError(absl::StrCat("Truncated snapshot ", path));
+  }
+  std::memcpy(&header, file->data(), sizeof(header));
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.index_offset > file->size() ||
+      header.index_size > file->size() - header.index_offset) {
+    return absl::DataLossError(absl::StrCat("Not a valid snapshot ", path));
+  }
+  XLA_ASSIGN_OR_RETURN(
+      std::vector<xla::Shape> shapes,
+      DecodeIndex(file->data() + header.index_offset, header.index_size,
+                  header.num_values));
+  std::vector<size_t> offsets = ValueOffsets(shapes);
+  if (offsets.back() != header.index_offset) {
+    return absl::DataLossError(absl::StrCat("Corrupted snapshot ", path));
+  }
+  std::vector<xla::Literal> literals;
+  literals.reserve(shapes.size());
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    xla::Literal& literal = literals.emplace_back(shapes[i]);
+    std::memcpy(literal.untyped_data(), file->data() + offsets[i],
+                literal.size_bytes());
+  }
+  return literals;
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
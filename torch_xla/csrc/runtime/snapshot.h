@@ -0,0 +1,38 @@
+#ifndef XLA_CLIENT_SNAPSHOT_H_
+#define XLA_CLIENT_SNAPSHOT_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "xla/literal.h"
+
+#include "torch_xla/csrc/runtime/computation_client.h"
+
+namespace torch_xla {
+namespace runtime {
+
+// Snapshots are local files holding the values of a list of device data,
+// meant to be written within the notice window of a preemption. The values
+// are stored raw, one after the other, followed by an index of their shapes.
+
+// Writes the values behind `handles` to a snapshot at `path`. The transfers
+// from device of all the handles are started at once, and every value is
+// copied into the memory mapped file as soon as its transfer lands.
+absl::Status WriteSnapshot(ComputationClient* client,
+                           absl::Span<const ComputationClient::DataPtr> handles,
+                           const std::string& path);
+
+// Writes `literals` to a snapshot at `path`.
+absl::Status WriteSnapshot(absl::Span<const xla::Literal> literals,
+                           const std::string& path);
+
+// Reads back the values of a snapshot written by WriteSnapshot.
+absl::StatusOr<std::vector<xla::Literal>> ReadSnapshot(const std::string& path);
+
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_SNAPSHOT_H_
@@ -0,0 +1,59 @@
+#include "torch_xla/csrc/runtime/snapshot.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "xla/layout_util.h"
+#include "xla/literal.h"
+#include "xla/literal_util.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+std::string MakeTempDir() {
+  char format[] = "/tmp/tmp.XXXXXX";
+  char* tmpdir = mkdtemp(format);
+  EXPECT_NE(tmpdir, nullptr);
+  return tmpdir;
+}
+
+TEST(SnapshotTest, RoundTrip) {
+  std::string dir = MakeTempDir();
+  std::string path = dir + "/snapshot";
+  std::vector<xla::Literal> literals;
+  literals.push_back(xla::LiteralUtil::CreateR2<float>({{1, 2, 3}, {4, 5, 6}}));
+  literals.push_back(xla::LiteralUtil::CreateR0<int32_t>(42));
+  literals.push_back(xla::LiteralUtil::CreateR1<bool>({true, false, true}));
+  // Column major values are written in row major order.
+  literals.push_back(xla::LiteralUtil::CreateR2WithLayout<int64_t>(
+      {{1, 2}, {3, 4}}, xla::LayoutUtil::MakeLayout({0, 1})));
+  ASSERT_TRUE(WriteSnapshot(literals, path).ok());
+  EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+  absl::StatusOr<std::vector<xla::Literal>> read = ReadSnapshot(path);
+  ASSERT_TRUE(read.ok()) << read.status();
+  ASSERT_EQ(read->size(), literals.size());
+  for (size_t i = 0; i < literals.size(); ++i) {
+    EXPECT_EQ((*read)[i], literals[i]) << i;
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST(SnapshotTest, RejectsCorruptedFiles) {
+  std::string dir = MakeTempDir();
+  std::string path = dir + "/snapshot";
+  EXPECT_FALSE(ReadSnapshot(path).ok());
+  std::ofstream(path) << "not a snapshot";
+  EXPECT_EQ(ReadSnapshot(path).status().code(), absl::StatusCode::kDataLoss);
+  std::filesystem::remove_all(dir);
+}
+
+}  // namespace
+}  // namespace runtime
+}  // namespace torch_xla
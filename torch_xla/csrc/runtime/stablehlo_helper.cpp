@@ -1,25 +1,33 @@
 #include "torch_xla/csrc/runtime/stablehlo_helper.h"
 
 #include <iostream>
+#include <memory>
 
-#include "mlir/IR/Verifier.h"       // from @llvm-project
-#include "mlir/Pass/PassManager.h"  // from @llvm-project
+#include "absl/strings/str_cat.h"
+#include "llvm/Support/FileSystem.h"    // from @llvm-project
+#include "llvm/Support/ThreadPool.h"    // from @llvm-project
+#include "llvm/Support/raw_ostream.h"   // from @llvm-project
+#include "mlir/IR/Verifier.h"           // from @llvm-project
+#include "mlir/Pass/PassManager.h"      // from @llvm-project
 #include "mlir/Transforms/Passes.h"
 #include "stablehlo/api/PortableApi.h"        // from @stablehlo
 #include "stablehlo/dialect/Serialization.h"  // from @stablehlo
 #include "stablehlo/dialect/StablehloOps.h"   // from @stablehlo
 #include "stablehlo/dialect/Version.h"        // from @stablehlo
 #include "stablehlo/dialect/VhloOps.h"        // from @stablehlo
+#include "tsl/platform/fingerprint.h"
 #include "xla/hlo/translate/hlo_to_mhlo/hlo_to_mlir_hlo.h"
 #include "xla/hlo/translate/mhlo_to_hlo/mlir_hlo_to_hlo.h"
 #include "xla/mlir_hlo/mhlo/transforms/passes.h"
 #include "xla/service/spmd/shardy/stablehlo_round_trip/stablehlo_import.h"
 
+#include "torch_xla/csrc/runtime/cache.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/stablehlo_composite_helper.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/xla_mlir_debuginfo_helper.h"
 #include "torch_xla/csrc/runtime/xla_util.h"
+#include "torch_xla/csrc/status.h"
 
 namespace torch_xla {
 
@@ -28,9 +36,8 @@ static std::string getHloModuleStr(const xla::HloModuleProto* proto) {
   return hlo_module.value()->ToString();
 }
 
-static std::string getMlirModuleStr(mlir::ModuleOp& mlir_module) {
-  std::string txt_mlir_module;
-  llvm::raw_string_ostream os{txt_mlir_module};
+static void writeMlirModuleStr(mlir::ModuleOp& mlir_module,
+                               llvm::raw_ostream& os) {
   // Enable Debug Info to include source line info in the StableHLO dump.
   mlir::OpPrintingFlags flags;
   static bool withSrcLineInfo =
@@ -39,18 +46,54 @@ static std::string getMlirModuleStr(mlir::ModuleOp& mlir_module) {
     flags.enableDebugInfo(/*enable=*/true, /*prettyForm=*/true);
   }
   mlir_module.print(os, flags);
-  return txt_mlir_module;
 }
 
-static std::string getMlirModuleBytecode(mlir::ModuleOp& mlir_module) {
-  std::string txt_mlir_module;
-  llvm::raw_string_ostream os{txt_mlir_module};
+static void writeMlirModuleBytecode(mlir::ModuleOp& mlir_module,
+                                    llvm::raw_ostream& os) {
   const std::string stablehlo_version =
       mlir::vhlo::Version::getCurrentVersion().toString();
   auto result = mlir::stablehlo::serializePortableArtifact(
       mlir_module, /* target_version = */ stablehlo_version, os);
   XLA_CHECK(result.succeeded()) << "Serializing StableHLO Failed";
-  return txt_mlir_module;
+}
+
+// The contexts of the conversions share a single thread pool, rather than
+// each starting threads of its own, to run the nested passes in parallel.
+static llvm::ThreadPoolInterface& getConversionThreadPool() {
+  static llvm::DefaultThreadPool* pool = new llvm::DefaultThreadPool();
+  return *pool;
+}
+
+static std::unique_ptr<mlir::MLIRContext> createConversionContext() {
+  auto context = std::make_unique<mlir::MLIRContext>(
+      mlir::MLIRContext::Threading::DISABLED);
+  context->setThreadPool(getConversionThreadPool());
+  return context;
+}
+
+// Converts `proto` and writes it to `os`, in bytecode if `emit_bytecode`.
+static void writeStablehlo(const xla::HloModuleProto* proto,
+                           bool emit_bytecode, llvm::raw_ostream& os) {
+  std::unique_ptr<mlir::MLIRContext> context = createConversionContext();
+  mlir::ModuleOp mlir_module =
+      mlir::ModuleOp::create(mlir::UnknownLoc::get(context.get()));
+  ConvertHloToStableHlo(proto, &mlir_module);
+  if (emit_bytecode) {
+    writeMlirModuleBytecode(mlir_module, os);
+  } else {
+    writeMlirModuleStr(mlir_module, os);
+  }
+  os.flush();
+}
+
+using StablehloCache = runtime::util::Cache<std::string, std::string>;
+
+// The conversions of the latest modules, by module fingerprint and format.
+static StablehloCache* getStablehloCache() {
+  static const size_t cache_size =
+      runtime::sys_util::GetEnvInt("XLA_STABLEHLO_CACHE_SIZE", 8);
+  static StablehloCache* cache = new StablehloCache(cache_size);
+  return cache;
 }
 
 static absl::Status ConvertHloToMhlo(const xla::HloModuleProto* proto,
@@ -124,15 +167,35 @@ void ConvertStableHloToSdy(mlir::ModuleOp* mlir_module) {
 
 std::string hloToStablehlo(const xla::HloModuleProto* proto,
                            bool emit_bytecode) {
-  mlir::MLIRContext context;
-  mlir::ModuleOp mlir_module =
-      mlir::ModuleOp::create(mlir::UnknownLoc::get(&context));
-  ConvertHloToStableHlo(proto, &mlir_module);
-  if (emit_bytecode) {
-    return getMlirModuleBytecode(mlir_module);
-  } else {
-    return getMlirModuleStr(mlir_module);
+  XLA_ASSIGN_OR_THROW(
+      std::string serialized_proto,
+      runtime::util::GetDeterministicSerializedModuleProto(*proto));
+  tsl::Fprint128 fingerprint = tsl::Fingerprint128(serialized_proto);
+  std::string key = absl::StrCat(fingerprint.low64, "_", fingerprint.high64,
+                                 emit_bytecode ? "_bytecode" : "_text");
+  StablehloCache* cache = getStablehloCache();
+  std::shared_ptr<std::string> stablehlo = cache->Get(key);
+  if (stablehlo != nullptr) {
+    TORCH_LAZY_COUNTER("CachedStablehloConversion", 1);
+    return *stablehlo;
   }
+  stablehlo = std::make_shared<std::string>();
+  llvm::raw_string_ostream os{*stablehlo};
+  writeStablehlo(proto, emit_bytecode, os);
+  cache->Add(std::move(key), stablehlo);
+  return *stablehlo;
+}
+
+void hloToStablehloFile(const xla::HloModuleProto* proto, bool emit_bytecode,
+                        const std::string& path) {
+  std::error_code error;
+  llvm::raw_fd_ostream os(path, error,
+                          emit_bytecode ? llvm::sys::fs::OF_None
+                                        : llvm::sys::fs::OF_Text);
+  XLA_CHECK(!error) << "Failed to open " << path << ": " << error.message();
+  writeStablehlo(proto, emit_bytecode, os);
+  XLA_CHECK(!os.has_error())
+      << "Failed to write " << path << ": " << os.error().message();
 }
 
 std::string GetHloModuleStr(const xla::HloModuleProto* proto) {
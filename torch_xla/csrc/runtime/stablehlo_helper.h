@@ -10,9 +10,17 @@ class MLIRContext;
 
 namespace torch_xla {
 
+// Converts `proto` to StableHLO text, or bytecode if `emit_bytecode`. The
+// conversions of the latest modules are cached by module fingerprint, up to
+// $XLA_STABLEHLO_CACHE_SIZE of them.
 std::string hloToStablehlo(const xla::HloModuleProto* proto,
                            bool emit_bytecode);
 
+// Converts `proto` as hloToStablehlo() does, and streams the result to the
+// file at `path`, without holding it in memory.
+void hloToStablehloFile(const xla::HloModuleProto* proto, bool emit_bytecode,
+                        const std::string& path);
+
 void ConvertStableHloToSdy(mlir::ModuleOp* mlir_module);
 
 void ConvertHloToStableHlo(const xla::HloModuleProto* proto,
@@ -0,0 +1,108 @@
+#include "torch_xla/csrc/runtime/straggler_monitor.h"
+
+#include <algorithm>
+#include <string_view>
+#include <utility>
+
+#include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+
+#include "torch_xla/csrc/runtime/tf_logging.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+std::optional<StragglerMonitor::StepTimes> ParseStepTimes(
+    std::string_view value) {
+  std::vector<std::string_view> parts = absl::StrSplit(value, ',');
+  StragglerMonitor::StepTimes times;
+  if (parts.size() != 2 || !absl::SimpleAtoi(parts[0], &times.host_ns) ||
+      !absl::SimpleAtoi(parts[1], &times.device_ns)) {
+    return std::nullopt;
+  }
+  return times;
+}
+
+int64_t Median(std::vector<int64_t> values) {
+  auto middle = values.begin() + values.size() / 2;
+  std::nth_element(values.begin(), middle, values.end());
+  return *middle;
+}
+
+double Ratio(int64_t value, int64_t median) {
+  return median > 0 ? static_cast<double>(value) / median : 0.0;
+}
+
+}  // namespace
+
+StragglerMonitor::StragglerMonitor(
+    std::shared_ptr<xla::KeyValueStoreInterface> kv_store,
+    int64_t process_index, int64_t num_processes, double threshold,
+    absl::Duration timeout)
+    : kv_store_(std::move(kv_store)),
+      process_index_(process_index),
+      num_processes_(num_processes),
+      threshold_(threshold),
+      timeout_(timeout) {}
+
+std::string StragglerMonitor::StepKey(int64_t step,
+                                      int64_t process_index) const {
+  return absl::StrCat(step, "/", process_index);
+}
+
+absl::Status StragglerMonitor::Publish(int64_t step, const StepTimes& times) {
+  return kv_store_->Set(StepKey(step, process_index_),
+                        absl::StrCat(times.host_ns, ",", times.device_ns));
+}
+
+StragglerMonitor::Report StragglerMonitor::Collect(int64_t step) {
+  Report report;
+  report.step = step;
+  report.times.resize(num_processes_);
+  absl::Time deadline = absl::Now() + timeout_;
+  std::vector<int64_t> host_ns;
+  std::vector<int64_t> device_ns;
+  for (int64_t index = 0; index < num_processes_; ++index) {
+    absl::Duration remaining = deadline - absl::Now();
+    absl::StatusOr<std::string> value =
+        remaining > absl::ZeroDuration()
+            ? kv_store_->Get(StepKey(step, index), remaining)
+            : kv_store_->TryGet(StepKey(step, index));
+    if (!value.ok()) {
+      continue;
+    }
+    report.times[index] = ParseStepTimes(*value);
+    if (!report.times[index]) {
+      TF_LOG(WARNING) << "Invalid step times of process " << index << ": "
+                      << *value;
+      continue;
+    }
+    host_ns.push_back(report.times[index]->host_ns);
+    device_ns.push_back(report.times[index]->device_ns);
+  }
+  if (!host_ns.empty()) {
+    report.median.host_ns = Median(std::move(host_ns));
+    report.median.device_ns = Median(std::move(device_ns));
+  }
+  for (int64_t index = 0; index < num_processes_; ++index) {
+    const std::optional<StepTimes>& times = report.times[index];
+    if (!times) {
+      report.stragglers.push_back(index);
+      continue;
+    }
+    double host_ratio = Ratio(times->host_ns, report.median.host_ns);
+    double device_ratio = Ratio(times->device_ns, report.median.device_ns);
+    report.max_host_ratio = std::max(report.max_host_ratio, host_ratio);
+    report.max_device_ratio = std::max(report.max_device_ratio, device_ratio);
+    if (host_ratio > threshold_ || device_ratio > threshold_) {
+      report.stragglers.push_back(index);
+    }
+  }
+  return report;
+}
+
+}  // namespace runtime
+}  // namespace torch_xla
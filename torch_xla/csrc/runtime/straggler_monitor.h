@@ -0,0 +1,72 @@
+#ifndef XLA_CLIENT_STRAGGLER_MONITOR_H_
+#define XLA_CLIENT_STRAGGLER_MONITOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "xla/pjrt/distributed/key_value_store_interface.h"
+
+namespace torch_xla {
+namespace runtime {
+
+// Detects the straggler hosts of a multi-host job from the step times every
+// host publishes to the distributed key-value store of the XlaCoordinator.
+//
+// Every host publishes its host-side and device-side times of a step with
+// Publish(), under a key unique to the step and the process, and the collector,
+// usually process 0, gathers them with Collect(). A process is a straggler when
+// either of its times exceeds `threshold` times the median one over the
+// processes, or when it did not publish the step within `timeout`.
+class StragglerMonitor {
+ public:
+  struct StepTimes {
+    // The wall time of the step on the host.
+    int64_t host_ns = 0;
+    // The device time of the executions of the step.
+    int64_t device_ns = 0;
+  };
+
+  struct Report {
+    int64_t step = 0;
+    // The times published by every process, unset for the missing ones.
+    std::vector<std::optional<StepTimes>> times;
+    StepTimes median;
+    // The process indices of the stragglers.
+    std::vector<int64_t> stragglers;
+    // The ratio of the slowest time of the step to the median one.
+    double max_host_ratio = 0.0;
+    double max_device_ratio = 0.0;
+  };
+
+  StragglerMonitor(std::shared_ptr<xla::KeyValueStoreInterface> kv_store,
+                   int64_t process_index, int64_t num_processes,
+                   double threshold, absl::Duration timeout);
+
+  int64_t process_index() const { return process_index_; }
+
+  // Publishes the times of `step` of this process.
+  absl::Status Publish(int64_t step, const StepTimes& times);
+
+  // Gathers the times of `step` of every process, waiting up to the timeout
+  // overall for the ones not published yet.
+  Report Collect(int64_t step);
+
+ private:
+  std::string StepKey(int64_t step, int64_t process_index) const;
+
+  std::shared_ptr<xla::KeyValueStoreInterface> kv_store_;
+  const int64_t process_index_;
+  const int64_t num_processes_;
+  const double threshold_;
+  const absl::Duration timeout_;
+};
+
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_STRAGGLER_MONITOR_H_
@@ -0,0 +1,65 @@
+#include "torch_xla/csrc/runtime/straggler_monitor.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "xla/pjrt/distributed/in_memory_key_value_store.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace {
+
+using ::testing::ElementsAre;
+
+std::vector<std::unique_ptr<StragglerMonitor>> MakeMonitors(
+    int64_t num_processes) {
+  auto kv_store = std::make_shared<xla::InMemoryKeyValueStore>();
+  std::vector<std::unique_ptr<StragglerMonitor>> monitors;
+  for (int64_t index = 0; index < num_processes; ++index) {
+    monitors.push_back(std::make_unique<StragglerMonitor>(
+        kv_store, index, num_processes, /*threshold=*/1.2,
+        absl::ZeroDuration()));
+  }
+  return monitors;
+}
+
+TEST(StragglerMonitorTest, FlagsSlowProcesses) {
+  std::vector<std::unique_ptr<StragglerMonitor>> monitors = MakeMonitors(4);
+  ASSERT_TRUE(monitors[0]->Publish(10, {100, 50}).ok());
+  ASSERT_TRUE(monitors[1]->Publish(10, {105, 50}).ok());
+  // Slow on the host side, then on the device side.
+  ASSERT_TRUE(monitors[2]->Publish(10, {150, 50}).ok());
+  ASSERT_TRUE(monitors[3]->Publish(10, {100, 80}).ok());
+
+  StragglerMonitor::Report report = monitors[0]->Collect(10);
+  EXPECT_EQ(report.step, 10);
+  EXPECT_EQ(report.median.host_ns, 105);
+  EXPECT_EQ(report.median.device_ns, 50);
+  EXPECT_THAT(report.stragglers, ElementsAre(2, 3));
+  EXPECT_DOUBLE_EQ(report.max_host_ratio, 150.0 / 105);
+  EXPECT_DOUBLE_EQ(report.max_device_ratio, 80.0 / 50);
+
+  // The steps are reported independently.
+  for (auto& monitor : monitors) {
+    ASSERT_TRUE(monitor->Publish(20, {100, 50}).ok());
+  }
+  EXPECT_TRUE(monitors[0]->Collect(20).stragglers.empty());
+}
+
+TEST(StragglerMonitorTest, FlagsMissingProcesses) {
+  std::vector<std::unique_ptr<StragglerMonitor>> monitors = MakeMonitors(3);
+  ASSERT_TRUE(monitors[0]->Publish(1, {100, 50}).ok());
+  ASSERT_TRUE(monitors[2]->Publish(1, {100, 50}).ok());
+
+  StragglerMonitor::Report report = monitors[0]->Collect(1);
+  EXPECT_FALSE(report.times[1].has_value());
+  EXPECT_THAT(report.stragglers, ElementsAre(1));
+  EXPECT_DOUBLE_EQ(report.max_host_ratio, 1.0);
+}
+
+}  // namespace
+}  // namespace runtime
+}  // namespace torch_xla
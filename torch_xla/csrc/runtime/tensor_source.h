@@ -1,6 +1,7 @@
 #ifndef XLA_CLIENT_TENSOR_SOURCE_H_
 #define XLA_CLIENT_TENSOR_SOURCE_H_
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -14,6 +15,7 @@
 
 #include "torch_xla/csrc/dtype.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/host_buffer_pool.h"
 #include "torch_xla/csrc/status.h"
 
 namespace torch_xla {
@@ -46,6 +48,10 @@ class TensorSource {
     return shape().element_type();
   }
 
+  // Whether data() points into memory the caller still owns, and may mutate
+  // once the transfer call returns.
+  virtual bool shares_caller_data() const { return false; }
+
  private:
   std::string device_;
 };
@@ -58,6 +64,16 @@ class AtenSource : public TensorSource {
     if (target_torch_type != tensor.type().scalarType()) {
       TORCH_LAZY_COUNTER("AtenSourceDowncasts", 1);
     }
+    if (tensor.device().is_cpu() && tensor.layout() == at::kStrided &&
+        tensor.scalar_type() == target_torch_type && tensor.is_contiguous() &&
+        !tensor.is_conj() && !tensor.is_neg()) {
+      // The tensor is already laid out as the transfer needs it, so we keep a
+      // reference to its storage rather than copying it.
+      TORCH_LAZY_COUNTER("AtenSourceSharedStorage", 1);
+      tensor_ = tensor;
+      shares_caller_data_ = true;
+      return;
+    }
     // TODO(ysiraichi): check, first, if tensor lives in a device that the
     // current PjRt client has access. If so, we don't need to go through the
     // CPU.
@@ -72,9 +88,13 @@ class AtenSource : public TensorSource {
   const xla::Shape& shape() const override { return shape_; }
 
   std::vector<int64_t> byte_strides() const override {
-    std::vector<int64_t> strides;
-    for (auto& stride : tensor_.strides()) {
-      strides.push_back(stride * tensor_.itemsize());
+    // Computed from the sizes, as contiguous tensors may carry arbitrary
+    // strides on dimensions of size one.
+    std::vector<int64_t> strides(tensor_.dim());
+    int64_t stride = tensor_.itemsize();
+    for (int64_t i = tensor_.dim() - 1; i >= 0; --i) {
+      strides[i] = stride;
+      stride *= tensor_.size(i);
     }
     return strides;
   }
@@ -84,9 +104,106 @@ class AtenSource : public TensorSource {
     return {sizes.begin(), sizes.end()};
   }
 
+  bool shares_caller_data() const override { return shares_caller_data_; }
+
  private:
   at::Tensor tensor_;
   xla::Shape shape_;
+  bool shares_caller_data_ = false;
+};
+
+// Holds data already converted to the layout and type of `shape()` inside a
+// pooled host staging buffer. The buffer goes back to the pool when the source
+// is destroyed, that is, after the transfer released its last reference.
+class HostBufferSource : public TensorSource {
+ public:
+  HostBufferSource(std::unique_ptr<HostBufferPool::HostBuffer> buffer,
+                   xla::Shape shape, std::string device)
+      : TensorSource(std::move(device)),
+        buffer_(std::move(buffer)),
+        shape_(std::move(shape)) {}
+
+  const void* data() const override { return buffer_->data(); }
+
+  const xla::Shape& shape() const override { return shape_; }
+
+ private:
+  std::unique_ptr<HostBufferPool::HostBuffer> buffer_;
+  xla::Shape shape_;
+};
+
+// Reads a strided CPU view, already of the element type of `shape()`, in
+// place, so that the runtime gathers it straight into its staging buffer. By
+// default, the view's storage is memory the runtime must not keep
+// referencing, like the caller's tensor or a file mapping that is dropped
+// page by page as a checkpoint loads, so the data is copied out within the
+// transfer call.
+class StridedViewSource : public TensorSource {
+ public:
+  StridedViewSource(at::Tensor view, xla::Shape shape, std::string device,
+                    bool shares_caller_data = true)
+      : TensorSource(std::move(device)),
+        view_(std::move(view)),
+        shape_(std::move(shape)),
+        shares_caller_data_(shares_caller_data) {
+    XLA_CHECK(view_.device().is_cpu());
+    XLA_CHECK_EQ(view_.scalar_type(), TorchTypeFromXlaType(primitive_type()));
+  }
+
+  const void* data() const override { return view_.const_data_ptr(); }
+
+  const xla::Shape& shape() const override { return shape_; }
+
+  std::vector<int64_t> byte_strides() const override {
+    std::vector<int64_t> strides(view_.dim());
+    for (int64_t i = 0; i < view_.dim(); ++i) {
+      strides[i] = view_.stride(i) * view_.itemsize();
+    }
+    return strides;
+  }
+
+  std::vector<int64_t> dimensions() const override {
+    auto sizes = view_.sizes();
+    return {sizes.begin(), sizes.end()};
+  }
+
+  bool shares_caller_data() const override { return shares_caller_data_; }
+
+ private:
+  at::Tensor view_;
+  xla::Shape shape_;
+  bool shares_caller_data_;
+};
+
+// Reads the data of another source, for the transfer of a replica of it to
+// another device, so that replicated data is staged once for all of them.
+class ReplicaSource : public TensorSource {
+ public:
+  ReplicaSource(std::shared_ptr<const TensorSource> source, std::string device)
+      : TensorSource(std::move(device)), source_(std::move(source)) {}
+
+  const void* data() const override { return source_->data(); }
+
+  const xla::Shape& shape() const override { return source_->shape(); }
+
+  std::vector<int64_t> byte_strides() const override {
+    return source_->byte_strides();
+  }
+
+  std::vector<int64_t> dimensions() const override {
+    return source_->dimensions();
+  }
+
+  xla::PrimitiveType primitive_type() const override {
+    return source_->primitive_type();
+  }
+
+  bool shares_caller_data() const override {
+    return source_->shares_caller_data();
+  }
+
+ private:
+  std::shared_ptr<const TensorSource> source_;
 };
 
 class LiteralSource : public TensorSource {
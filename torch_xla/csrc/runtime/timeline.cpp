@@ -0,0 +1,251 @@
+#include "torch_xla/csrc/runtime/timeline.h"
+
+#include <semaphore.h>
+#include <signal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/tf_logging.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace timeline {
+namespace {
+
+const char* PhaseName(Phase phase) {
+  switch (phase) {
+    case Phase::kTrace:
+      return "Trace";
+    case Phase::kPostOrder:
+      return "PostOrder";
+    case Phase::kLowering:
+      return "Lowering";
+    case Phase::kCompile:
+      return "Compile";
+    case Phase::kTransferToDevice:
+      return "TransferToDevice";
+    case Phase::kExecute:
+      return "Execute";
+    case Phase::kTransferFromDevice:
+      return "TransferFromDevice";
+  }
+  return "Unknown";
+}
+
+// A slot of the ring. As for the metric samples, the sequence is 0 while the
+// slot is empty or being written, and otherwise 1 + the index of the event it
+// holds, so that readers can skip the events being overwritten.
+struct Slot {
+  std::atomic<size_t> sequence{0};
+  std::atomic<int> phase{0};
+  std::atomic<int64_t> thread_id{0};
+  std::atomic<int64_t> step{0};
+  std::atomic<int64_t> start_ns{0};
+  std::atomic<int64_t> end_ns{0};
+  std::atomic<uint64_t> hash_high{0};
+  std::atomic<uint64_t> hash_low{0};
+};
+
+struct Event {
+  Phase phase;
+  int64_t thread_id;
+  int64_t step;
+  int64_t start_ns;
+  int64_t end_ns;
+  uint64_t hash_high;
+  uint64_t hash_low;
+};
+
+class Ring {
+ public:
+  static Ring* Get() {
+    static Ring* ring = new Ring(
+        sys_util::GetEnvInt("XLA_STEP_TIMELINE_EVENTS", 16384));
+    return ring;
+  }
+
+  explicit Ring(int64_t size)
+      : size_(std::max<int64_t>(size, 0)), slots_(new Slot[size_]) {}
+
+  bool enabled() const { return size_ > 0; }
+
+  void Add(const Event& event) {
+    size_t index = count_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[index % size_];
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.phase.store(static_cast<int>(event.phase), std::memory_order_relaxed);
+    slot.thread_id.store(event.thread_id, std::memory_order_relaxed);
+    slot.step.store(event.step, std::memory_order_relaxed);
+    slot.start_ns.store(event.start_ns, std::memory_order_relaxed);
+    slot.end_ns.store(event.end_ns, std::memory_order_relaxed);
+    slot.hash_high.store(event.hash_high, std::memory_order_relaxed);
+    slot.hash_low.store(event.hash_low, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+  }
+
+  std::vector<Event> Events() const {
+    size_t count = count_.load(std::memory_order_acquire);
+    size_t start = count > size_ ? count - size_ : 0;
+    std::vector<Event> events;
+    events.reserve(count - start);
+    for (size_t index = start; index < count; ++index) {
+      const Slot& slot = slots_[index % size_];
+      size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      Event event;
+      event.phase =
+          static_cast<Phase>(slot.phase.load(std::memory_order_relaxed));
+      event.thread_id = slot.thread_id.load(std::memory_order_relaxed);
+      event.step = slot.step.load(std::memory_order_relaxed);
+      event.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+      event.end_ns = slot.end_ns.load(std::memory_order_relaxed);
+      event.hash_high = slot.hash_high.load(std::memory_order_relaxed);
+      event.hash_low = slot.hash_low.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence == index + 1 &&
+          slot.sequence.load(std::memory_order_relaxed) == sequence) {
+        events.push_back(event);
+      }
+    }
+    return events;
+  }
+
+ private:
+  size_t size_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<size_t> count_{0};
+};
+
+std::atomic<int64_t> g_step(0);
+
+// Small, stable thread identifiers, which read better in the trace viewers
+// than the system ones.
+int64_t ThreadId() {
+  static std::atomic<int64_t> next_thread_id(0);
+  thread_local int64_t thread_id = next_thread_id.fetch_add(1);
+  return thread_id;
+}
+
+sem_t g_dump_semaphore;
+
+void DumpSignalHandler(int) {
+  // sem_post() is async-signal-safe, the dump itself happens on the dumper
+  // thread.
+  sem_post(&g_dump_semaphore);
+}
+
+void RunDumper(const std::string& path) {
+  while (true) {
+    if (sem_wait(&g_dump_semaphore) != 0) {
+      continue;
+    }
+    absl::Status status = Dump(path);
+    if (status.ok()) {
+      TF_LOG(INFO) << "Dumped the step timeline to " << path;
+    } else {
+      TF_LOG(WARNING) << "Failed to dump the step timeline: " << status;
+    }
+  }
+}
+
+}  // namespace
+
+bool Enabled() { return Ring::Get()->enabled(); }
+
+void Record(Phase phase, int64_t start_ns, int64_t end_ns, uint64_t hash_high,
+            uint64_t hash_low) {
+  Ring* ring = Ring::Get();
+  if (ring->enabled()) {
+    ring->Add({phase, ThreadId(), g_step.load(std::memory_order_relaxed),
+               start_ns, end_ns, hash_high, hash_low});
+  }
+}
+
+void MarkStep() { g_step.fetch_add(1, std::memory_order_relaxed); }
+
+ScopedEvent::ScopedEvent(Phase phase, uint64_t hash_high, uint64_t hash_low)
+    : phase_(phase),
+      hash_high_(hash_high),
+      hash_low_(hash_low),
+      start_ns_(Enabled() ? sys_util::NowNs() : 0) {}
+
+ScopedEvent::~ScopedEvent() {
+  if (start_ns_ != 0) {
+    Record(phase_, start_ns_, sys_util::NowNs(), hash_high_, hash_low_);
+  }
+}
+
+std::string ToChromeTrace() {
+  std::stringstream ss;
+  ss << "{\"traceEvents\":[";
+  bool first = true;
+  for (const Event& event : Ring::Get()->Events()) {
+    if (!first) {
+      ss << ",";
+    }
+    first = false;
+    ss << "{\"name\":\"" << PhaseName(event.phase)
+       << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread_id
+       << ",\"ts\":" << absl::StrFormat("%.3f", event.start_ns / 1000.0)
+       << ",\"dur\":"
+       << absl::StrFormat("%.3f", (event.end_ns - event.start_ns) / 1000.0)
+       << ",\"args\":{\"step\":" << event.step;
+    if (event.hash_high != 0 || event.hash_low != 0) {
+      ss << ",\"graph_hash\":\""
+         << absl::StrFormat("%x%016x", event.hash_high, event.hash_low)
+         << "\"";
+    }
+    ss << "}}";
+  }
+  ss << "],\"displayTimeUnit\":\"ms\"}";
+  return ss.str();
+}
+
+absl::Status Dump(const std::string& path) {
+  std::string tmp_path = absl::StrCat(path, ".tmp");
+  {
+    std::ofstream file(tmp_path, std::ios::trunc);
+    file << ToChromeTrace();
+    if (!file) {
+      return absl::InternalError(absl::StrCat("Failed to write ", tmp_path));
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    return absl::InternalError(
+        absl::StrCat("Failed to rename ", tmp_path, " to ", path));
+  }
+  return absl::OkStatus();
+}
+
+void MaybeInstallDumpSignalHandler() {
+  static std::once_flag install_flag;
+  std::call_once(install_flag, []() {
+    std::string path = sys_util::GetEnvString("XLA_STEP_TIMELINE_FILE", "");
+    if (path.empty() || !Enabled()) {
+      return;
+    }
+    sem_init(&g_dump_semaphore, /*pshared=*/0, /*value=*/0);
+    std::thread(RunDumper, path).detach();
+    struct sigaction action = {};
+    action.sa_handler = DumpSignalHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &action, nullptr);
+  });
+}
+
+}  // namespace timeline
+}  // namespace runtime
+}  // namespace torch_xla
@@ -0,0 +1,68 @@
+#ifndef XLA_CLIENT_TIMELINE_H_
+#define XLA_CLIENT_TIMELINE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/status/status.h"
+
+namespace torch_xla {
+namespace runtime {
+namespace timeline {
+
+// The step timeline is an always on, fixed size ring of the most recent step
+// phase events, tagged with the step and the graph hash they belong to. It can
+// be dumped as a Chrome trace at any time, without a profiler session. Its
+// size is $XLA_STEP_TIMELINE_EVENTS, and 0 disables it.
+
+enum class Phase {
+  kTrace,
+  kPostOrder,
+  kLowering,
+  kCompile,
+  kTransferToDevice,
+  kExecute,
+  kTransferFromDevice,
+};
+
+// Whether the events are recorded.
+bool Enabled();
+
+// Records an event of `phase` from `start_ns` to `end_ns`, on the calling
+// thread, for the graph of hash `(hash_high, hash_low)` if any.
+void Record(Phase phase, int64_t start_ns, int64_t end_ns,
+            uint64_t hash_high = 0, uint64_t hash_low = 0);
+
+// Starts a new step, which the events recorded from now on belong to.
+void MarkStep();
+
+// Records an event of `phase` for the lifetime of the object.
+class ScopedEvent {
+ public:
+  explicit ScopedEvent(Phase phase, uint64_t hash_high = 0,
+                       uint64_t hash_low = 0);
+
+  ~ScopedEvent();
+
+ private:
+  Phase phase_;
+  uint64_t hash_high_;
+  uint64_t hash_low_;
+  int64_t start_ns_;
+};
+
+// Returns the events of the timeline, from the oldest, as Chrome trace JSON.
+std::string ToChromeTrace();
+
+// Writes ToChromeTrace() to `path`.
+absl::Status Dump(const std::string& path);
+
+// If $XLA_STEP_TIMELINE_FILE is set, dumps the timeline to it every time the
+// process receives SIGUSR2. Only the first call has an effect.
+void MaybeInstallDumpSignalHandler();
+
+}  // namespace timeline
+}  // namespace runtime
+}  // namespace torch_xla
+
+#endif  // XLA_CLIENT_TIMELINE_H_
@@ -0,0 +1,29 @@
+#include "torch_xla/csrc/runtime/timeline.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace torch_xla {
+namespace runtime {
+namespace timeline {
+namespace {
+
+TEST(TimelineTest, RecordsEventsWithStepAndGraphHash) {
+  MarkStep();
+  Record(Phase::kCompile, /*start_ns=*/1000, /*end_ns=*/3000,
+         /*hash_high=*/0xab, /*hash_low=*/0xcd);
+  { ScopedEvent event(Phase::kLowering); }
+  std::string trace = ToChromeTrace();
+  EXPECT_EQ(trace.rfind("{\"traceEvents\":[", 0), 0);
+  EXPECT_NE(trace.find("\"name\":\"Compile\",\"ph\":\"X\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ts\":1.000,\"dur\":2.000"), std::string::npos);
+  EXPECT_NE(trace.find("\"graph_hash\":\"ab00000000000000cd\""),
+            std::string::npos);
+  EXPECT_NE(trace.find("\"name\":\"Lowering\""), std::string::npos);
+}
+
+}  // namespace
+}  // namespace timeline
+}  // namespace runtime
+}  // namespace torch_xla
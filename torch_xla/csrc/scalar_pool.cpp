@@ -0,0 +1,113 @@
+#include "torch_xla/csrc/scalar_pool.h"
+
+#include <cstring>
+
+#include <ATen/Functions.h>
+#include <torch/csrc/lazy/core/hash.h>
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "torch_xla/csrc/device.h"
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor_util.h"
+
+namespace torch_xla {
+namespace {
+
+bool BatchScalarTransfers() {
+  static const bool batch_scalar_transfers =
+      runtime::sys_util::GetEnvBool("XLA_BATCH_SCALAR_TRANSFERS", true);
+  return batch_scalar_transfers;
+}
+
+}  // namespace
+
+size_t ScalarPool::KeyHasher::operator()(const Key& key) const {
+  torch::lazy::hash_t hash = torch::lazy::HashCombine(
+      torch::lazy::Hash(key.device),
+      torch::lazy::Hash(static_cast<int>(key.scalar_type)));
+  return torch::lazy::HashReduce(torch::lazy::HashCombine(
+      hash, torch::lazy::DataHash(key.bytes.data(), key.bytes.size())));
+}
+
+ScalarPool* ScalarPool::Get() {
+  static ScalarPool* pool = new ScalarPool();
+  return pool;
+}
+
+ScalarPool::ScalarPool()
+    : cache_(runtime::sys_util::GetEnvInt("XLA_SCALAR_POOL_SIZE", 1024)) {}
+
+torch::lazy::BackendDataPtr ScalarPool::GetDeviceData(
+    const at::Scalar& value, at::ScalarType scalar_type,
+    const torch::lazy::BackendDevice& device) {
+  // at::scalar_tensor() does not support bfloat16.
+  at::Tensor tensor = at::scalar_tensor(
+      value, at::TensorOptions(scalar_type == at::ScalarType::BFloat16
+                                   ? at::ScalarType::Float
+                                   : scalar_type));
+  if (scalar_type == at::ScalarType::BFloat16) {
+    tensor = tensor.to(scalar_type);
+  }
+  return GetDeviceData(tensor, device);
+}
+
+torch::lazy::BackendDataPtr ScalarPool::GetDeviceData(
+    const at::Tensor& tensor, const torch::lazy::BackendDevice& device) {
+  XLA_CHECK_EQ(tensor.dim(), 0);
+  Key key{device.toString(), tensor.scalar_type()};
+  XLA_CHECK_LE(tensor.element_size(), key.bytes.size());
+  std::memcpy(key.bytes.data(), tensor.const_data_ptr(),
+              tensor.element_size());
+  torch::lazy::BackendDataPtr data = cache_.Get(key);
+  if (data != nullptr) {
+    return data;
+  }
+  TORCH_LAZY_COUNTER("DeviceDataCacheMiss", 1);
+  // The replication of SPMD data does not go through placeholders.
+  if (!BatchScalarTransfers() ||
+      static_cast<XlaDeviceType>(device.type()) == XlaDeviceType::SPMD) {
+    data = TensorToXlaData(tensor, device);
+  } else {
+    XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                        runtime::GetComputationClient());
+    data = client->CreateDataPlaceholder(
+        device.toString(), CreateComputationShapeFromTensor(tensor, &device));
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.emplace_back(tensor, data);
+  }
+  // Another thread may have added the same value meanwhile, whose data is
+  // then returned instead, and ours is uploaded for nothing.
+  return cache_.Add(std::move(key), std::move(data));
+}
+
+void ScalarPool::Flush() {
+  std::vector<std::pair<at::Tensor, torch::lazy::BackendDataPtr>> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.empty()) {
+      return;
+    }
+    pending.swap(pending_);
+  }
+  std::vector<at::Tensor> tensors;
+  std::vector<std::string> devices;
+  tensors.reserve(pending.size());
+  devices.reserve(pending.size());
+  for (const auto& tensor_and_data : pending) {
+    tensors.push_back(tensor_and_data.first);
+    devices.push_back(tensor_and_data.second->device().toString());
+  }
+  std::vector<torch::lazy::BackendDataPtr> datas =
+      CreateTensorsData(tensors, devices);
+  for (size_t i = 0; i < datas.size(); ++i) {
+    pending[i].second->Assign(*datas[i]);
+  }
+  TORCH_LAZY_COUNTER("BatchedScalarTransfers", 1);
+  TORCH_LAZY_COUNTER("BatchedScalars", pending.size());
+}
+
+}  // namespace torch_xla
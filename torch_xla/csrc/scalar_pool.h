@@ -0,0 +1,70 @@
+#ifndef XLA_TORCH_XLA_CSRC_SCALAR_POOL_H_
+#define XLA_TORCH_XLA_CSRC_SCALAR_POOL_H_
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <ATen/Tensor.h>
+#include <torch/csrc/lazy/backend/backend_data.h>
+#include <torch/csrc/lazy/backend/backend_device.h>
+
+#include "torch_xla/csrc/runtime/cache.h"
+
+namespace torch_xla {
+
+// Holds the device data of the non-special scalars that graphs take as
+// parameters, like learning rates and loss scales, so that the same value of
+// the same type is uploaded once per device, within an LRU of
+// $XLA_SCALAR_POOL_SIZE entries. The scalars missing from the pool are not
+// uploaded right away: they get placeholders, which are filled by a single
+// transfer for all of them when the pending scalars are flushed, before the
+// graphs using them run.
+class ScalarPool {
+ public:
+  static ScalarPool* Get();
+
+  // Returns the device data holding `value` as `scalar_type` on `device`.
+  torch::lazy::BackendDataPtr GetDeviceData(
+      const at::Scalar& value, at::ScalarType scalar_type,
+      const torch::lazy::BackendDevice& device);
+
+  // Same as above, for the value of the 0-dim CPU `tensor`.
+  torch::lazy::BackendDataPtr GetDeviceData(
+      const at::Tensor& tensor, const torch::lazy::BackendDevice& device);
+
+  // Uploads the scalars whose device data are still placeholders, in a single
+  // transfer. Must be called before their device data are read.
+  void Flush();
+
+ private:
+  struct Key {
+    std::string device;
+    at::ScalarType scalar_type;
+    // The value, in `scalar_type`. Large enough for a complex double.
+    std::array<char, 16> bytes{};
+
+    bool operator==(const Key& other) const {
+      return device == other.device && scalar_type == other.scalar_type &&
+             bytes == other.bytes;
+    }
+  };
+
+  struct KeyHasher {
+    size_t operator()(const Key& key) const;
+  };
+
+  ScalarPool();
+
+  runtime::util::Cache<Key, torch::lazy::BackendData, KeyHasher> cache_;
+  std::mutex mutex_;
+  // The tensors to upload, and the placeholders they fill.
+  std::vector<std::pair<at::Tensor, torch::lazy::BackendDataPtr>> pending_;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_SCALAR_POOL_H_
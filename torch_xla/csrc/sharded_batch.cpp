@@ -0,0 +1,124 @@
+#include "torch_xla/csrc/sharded_batch.h"
+
+#include <utility>
+
+#include <torch/csrc/lazy/core/metrics.h>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "tsl/profiler/lib/traceme.h"
+
+#include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/device.h"
+#include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/tensor_source.h"
+#include "torch_xla/csrc/status.h"
+#include "torch_xla/csrc/tensor_util.h"
+#include "torch_xla/csrc/xla_sharding_util.h"
+
+namespace torch_xla {
+
+absl::StatusOr<std::unique_ptr<ShardedBatchAssembler>>
+ShardedBatchAssembler::Create(XLATensor::ShardingSpecPtr sharding_spec) {
+  if (sharding_spec == nullptr) {
+    return absl::InvalidArgumentError("A sharding spec is required");
+  }
+  if (!UseVirtualDevice()) {
+    return absl::FailedPreconditionError(
+        "Please enable SPMD via `torch_xla.runtime.use_spmd()`");
+  }
+  XLA_ASSIGN_OR_RETURN(runtime::ComputationClient * absl_nonnull const client,
+                       runtime::GetComputationClient());
+  return std::unique_ptr<ShardedBatchAssembler>(new ShardedBatchAssembler(
+      sharding_spec, client->GetLocalDevices(),
+      ShardingUtil::GetShardShape(sharding_spec)));
+}
+
+ShardedBatchAssembler::ShardedBatchAssembler(
+    XLATensor::ShardingSpecPtr sharding_spec, std::vector<std::string> devices,
+    std::vector<int64_t> shard_shape)
+    : sharding_spec_(std::move(sharding_spec)),
+      devices_(std::move(devices)),
+      shard_shape_(std::move(shard_shape)),
+      shards_(devices_.size()),
+      added_(devices_.size(), false) {}
+
+absl::Status ShardedBatchAssembler::AddShard(int64_t index,
+                                             const at::Tensor& shard) {
+  tsl::profiler::TraceMe activity("ShardedBatchAssembler::AddShard",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  if (index < 0 || index >= static_cast<int64_t>(devices_.size())) {
+    return absl::OutOfRangeError(absl::StrCat("Shard index ", index,
+                                              " is out of the ",
+                                              devices_.size(), " devices"));
+  }
+  if (shard.sizes() != at::IntArrayRef(shard_shape_)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Shard shape must include padding: [",
+                     absl::StrJoin(shard.sizes(), ","), "] vs [",
+                     absl::StrJoin(shard_shape_, ","), "]"));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_ || added_[index]) {
+      return absl::FailedPreconditionError(
+          absl::StrCat("The shard of device ", devices_[index],
+                       " was already added"));
+    }
+    if (dtype_.has_value() && *dtype_ != shard.scalar_type()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("Shard type ", c10::toString(shard.scalar_type()),
+                       " differs from the type of the other shards, ",
+                       c10::toString(*dtype_)));
+    }
+    dtype_ = shard.scalar_type();
+    added_[index] = true;
+  }
+
+  // The transfer runs outside of the lock, concurrently with the ones of the
+  // other devices' shards.
+  torch::lazy::BackendDevice device = ParseDeviceString(devices_[index]);
+  xla::Shape shape = CreateComputationShapeFromTensor(shard, &device);
+  if (shape.element_type() != sharding_spec_->shape.element_type()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Shard of type ", c10::toString(shard.scalar_type()),
+                     " does not match the type of the sharded tensor"));
+  }
+  XLA_ASSIGN_OR_RETURN(runtime::ComputationClient * absl_nonnull const client,
+                       runtime::GetComputationClient());
+  std::vector<std::shared_ptr<const runtime::TensorSource>> sources = {
+      CreateTensorSource(shard, std::move(shape), devices_[index])};
+  runtime::ComputationClient::DataPtr data =
+      client->TransferToDevice(sources).front();
+  TORCH_LAZY_COUNTER("ShardedBatchShards", 1);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  shards_[index] = std::move(data);
+  return absl::OkStatus();
+}
+
+absl::StatusOr<at::Tensor> ShardedBatchAssembler::Finish() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (finished_) {
+    return absl::FailedPreconditionError("The batch was already assembled");
+  }
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    if (shards_[i] == nullptr) {
+      return absl::FailedPreconditionError(absl::StrCat(
+          "Missing the shard of device ", devices_[i]));
+    }
+  }
+  XLA_ASSIGN_OR_RETURN(runtime::ComputationClient * absl_nonnull const client,
+                       runtime::GetComputationClient());
+  runtime::ComputationClient::DataPtr data = client->WrapDataShards(
+      shards_, GetVirtualDevice().toString(), sharding_spec_->shape,
+      sharding_spec_->sharding);
+  shards_.clear();
+  finished_ = true;
+  XLATensorPtr xla_tensor = XLATensor::Create(std::move(data), *dtype_);
+  xla_tensor->SetShardingSpec(*sharding_spec_);
+  TORCH_LAZY_COUNTER("ShardedBatches", 1);
+  return bridge::AtenFromXlaTensor(std::move(xla_tensor));
+}
+
+}  // namespace torch_xla
@@ -0,0 +1,61 @@
+#ifndef XLA_TORCH_XLA_CSRC_SHARDED_BATCH_H_
+#define XLA_TORCH_XLA_CSRC_SHARDED_BATCH_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ATen/Tensor.h>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+
+#include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/tensor.h"
+
+namespace torch_xla {
+
+// Assembles a sharded global batch out of the slices an input pipeline
+// produces for the local devices, as a host of a multi-host job does. Each
+// slice goes to its device as soon as it is added, possibly from the worker
+// thread which produced it, so that the host never concatenates the batch
+// only to shard it again.
+class ShardedBatchAssembler {
+ public:
+  // Creates an assembler of a tensor sharded by `sharding_spec`, whose shape is
+  // the one of the global batch, like the specs of `minibatch` shardings.
+  static absl::StatusOr<std::unique_ptr<ShardedBatchAssembler>> Create(
+      XLATensor::ShardingSpecPtr sharding_spec);
+
+  // Uploads the slice of the local device at `index`, in the order of the
+  // local devices of the runtime. The slice must have the shard shape of the
+  // sharding, padding included. Safe to call from several threads.
+  absl::Status AddShard(int64_t index, const at::Tensor& shard);
+
+  // Returns the global tensor, once the slices of all the local devices were
+  // added.
+  absl::StatusOr<at::Tensor> Finish();
+
+ private:
+  ShardedBatchAssembler(XLATensor::ShardingSpecPtr sharding_spec,
+                        std::vector<std::string> devices,
+                        std::vector<int64_t> shard_shape);
+
+  XLATensor::ShardingSpecPtr sharding_spec_;
+  std::vector<std::string> devices_;
+  std::vector<int64_t> shard_shape_;
+  std::mutex mutex_;
+  std::vector<runtime::ComputationClient::DataPtr> shards_;
+  // Whether the shard of each device was added, its transfer possibly still
+  // running.
+  std::vector<bool> added_;
+  std::optional<at::ScalarType> dtype_;
+  bool finished_ = false;
+};
+
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_SHARDED_BATCH_H_
@@ -0,0 +1,462 @@
+#include "torch_xla/csrc/simd_convert.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define XLA_SIMD_CONVERT_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define XLA_SIMD_CONVERT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace torch_xla {
+namespace simd_convert {
+namespace {
+
+Isa DetectIsa() {
+#if defined(XLA_SIMD_CONVERT_X86)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Isa::kAvx512;
+  }
+  // All the CPUs with AVX2 have F16C, but check it anyway.
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("f16c")) {
+    return Isa::kAvx2;
+  }
+  return Isa::kScalar;
+#elif defined(XLA_SIMD_CONVERT_NEON)
+  return Isa::kNeon;
+#else
+  return Isa::kScalar;
+#endif
+}
+
+std::atomic<Isa> max_isa(Isa::kAvx512);
+
+bool Uses(Isa isa) {
+  static const Isa detected_isa = DetectIsa();
+  if (static_cast<int>(isa) >
+      static_cast<int>(max_isa.load(std::memory_order_relaxed))) {
+    return false;
+  }
+  // The CPUs with AVX-512 also have AVX2.
+  return detected_isa == isa ||
+         (isa == Isa::kAvx2 && detected_isa == Isa::kAvx512);
+}
+
+#if defined(XLA_SIMD_CONVERT_X86)
+
+// bfloat16 is the high half of a float, rounded to nearest even. NaNs become
+// 0x7fc0 with their sign, so that the rounding cannot turn them into infinity.
+
+__attribute__((target("avx512f"))) int64_t F32ToBF16Avx512(const float* src,
+                                                           uint16_t* dest,
+                                                           int64_t n) {
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i bias = _mm512_set1_epi32(0x7fff);
+  const __m512i abs_mask = _mm512_set1_epi32(0x7fffffff);
+  const __m512i infinity = _mm512_set1_epi32(0x7f800000);
+  const __m512i sign = _mm512_set1_epi32(0x8000);
+  const __m512i nan = _mm512_set1_epi32(0x7fc0);
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512i x = _mm512_loadu_si512(src + i);
+    __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(x, 16), one);
+    __m512i rounded = _mm512_srli_epi32(
+        _mm512_add_epi32(_mm512_add_epi32(x, bias), lsb), 16);
+    __mmask16 is_nan =
+        _mm512_cmpgt_epi32_mask(_mm512_and_si512(x, abs_mask), infinity);
+    __m512i quiet_nan =
+        _mm512_or_si512(_mm512_and_si512(_mm512_srli_epi32(x, 16), sign), nan);
+    __m512i result = _mm512_mask_blend_epi32(is_nan, rounded, quiet_nan);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        _mm512_cvtepi32_epi16(result));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) int64_t F32ToBF16Avx2(const float* src,
+                                                      uint16_t* dest,
+                                                      int64_t n) {
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i bias = _mm256_set1_epi32(0x7fff);
+  const __m256i abs_mask = _mm256_set1_epi32(0x7fffffff);
+  const __m256i infinity = _mm256_set1_epi32(0x7f800000);
+  const __m256i sign = _mm256_set1_epi32(0x8000);
+  const __m256i nan = _mm256_set1_epi32(0x7fc0);
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(x, 16), one);
+    __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_add_epi32(x, bias), lsb), 16);
+    __m256i is_nan =
+        _mm256_cmpgt_epi32(_mm256_and_si256(x, abs_mask), infinity);
+    __m256i quiet_nan =
+        _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(x, 16), sign), nan);
+    __m256i result = _mm256_blendv_epi8(rounded, quiet_nan, is_nan);
+    // The values fit in 16 bits, so the saturation of the pack does not
+    // apply. It interleaves the 128 bits lanes, which the permute reorders.
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi32(result, result), 0x08);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                     _mm256_castsi256_si128(packed));
+  }
+  return i;
+}
+
+__attribute__((target("avx512f"))) int64_t BF16ToF32Avx512(const uint16_t* src,
+                                                           float* dest,
+                                                           int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm512_storeu_si512(dest + i,
+                        _mm512_slli_epi32(_mm512_cvtepu16_epi32(x), 16));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) int64_t BF16ToF32Avx2(const uint16_t* src,
+                                                      float* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        _mm256_slli_epi32(_mm256_cvtepu16_epi32(x), 16));
+  }
+  return i;
+}
+
+__attribute__((target("avx512f"))) int64_t F32ToF16Avx512(const float* src,
+                                                          uint16_t* dest,
+                                                          int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 x = _mm512_loadu_ps(src + i);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dest + i),
+        _mm512_cvtps_ph(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  return i;
+}
+
+__attribute__((target("avx2,f16c"))) int64_t F32ToF16Avx2(const float* src,
+                                                          uint16_t* dest,
+                                                          int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_loadu_ps(src + i);
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dest + i),
+        _mm256_cvtps_ph(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  return i;
+}
+
+__attribute__((target("avx512f"))) int64_t F16ToF32Avx512(const uint16_t* src,
+                                                          float* dest,
+                                                          int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm512_storeu_ps(dest + i, _mm512_cvtph_ps(x));
+  }
+  return i;
+}
+
+__attribute__((target("avx2,f16c"))) int64_t F16ToF32Avx2(const uint16_t* src,
+                                                          float* dest,
+                                                          int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_ps(dest + i, _mm256_cvtph_ps(x));
+  }
+  return i;
+}
+
+__attribute__((target("avx512f"))) int64_t S64ToS32Avx512(const int64_t* src,
+                                                          int32_t* dest,
+                                                          int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i x = _mm512_loadu_si512(src + i);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        _mm512_cvtepi64_epi32(x));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) int64_t S64ToS32Avx2(const int64_t* src,
+                                                     int32_t* dest, int64_t n) {
+  // Gathers the low halves of the four elements in the low 128 bits.
+  const __m256i low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 0, 0, 0);
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dest + i),
+        _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(x, low_halves)));
+  }
+  return i;
+}
+
+__attribute__((target("avx512f"))) int64_t S32ToS64Avx512(const int32_t* src,
+                                                          int64_t* dest,
+                                                          int64_t n) {
+  int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm512_storeu_si512(dest + i, _mm512_cvtepi32_epi64(x));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) int64_t S32ToS64Avx2(const int32_t* src,
+                                                     int64_t* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i),
+                        _mm256_cvtepi32_epi64(x));
+  }
+  return i;
+}
+
+// The int4 kernels have no AVX-512 variant, since their byte operations
+// would need AVX-512BW.
+
+__attribute__((target("avx2"))) int64_t PackInt4Avx2(const int8_t* src,
+                                                     uint8_t* dest,
+                                                     int64_t n) {
+  const __m256i low_mask = _mm256_set1_epi16(0x000f);
+  const __m256i high_mask = _mm256_set1_epi16(0x00f0);
+  int64_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    // Each 16 bits word holds a pair of elements, the even one in its low
+    // byte, which becomes the byte of the pair in the low byte of the word.
+    __m256i a =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * i));
+    __m256i b =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * i + 32));
+    __m256i packed_a =
+        _mm256_or_si256(_mm256_and_si256(a, low_mask),
+                        _mm256_and_si256(_mm256_srli_epi16(a, 4), high_mask));
+    __m256i packed_b =
+        _mm256_or_si256(_mm256_and_si256(b, low_mask),
+                        _mm256_and_si256(_mm256_srli_epi16(b, 4), high_mask));
+    // The pack interleaves the 128 bits lanes, which the permute reorders.
+    __m256i packed = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(packed_a, packed_b), 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), packed);
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) int64_t UnpackInt4Avx2(const uint8_t* src,
+                                                       int8_t* dest,
+                                                       int64_t n) {
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  const __m256i eight = _mm256_set1_epi8(8);
+  int64_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    // A nibble v is sign extended as (v ^ 8) - 8.
+    __m256i low = _mm256_sub_epi8(
+        _mm256_xor_si256(_mm256_and_si256(x, mask), eight), eight);
+    __m256i high = _mm256_sub_epi8(
+        _mm256_xor_si256(_mm256_and_si256(_mm256_srli_epi16(x, 4), mask),
+                         eight),
+        eight);
+    // The unpacks interleave within the 128 bits lanes, which the permutes
+    // put back in order.
+    __m256i a = _mm256_unpacklo_epi8(low, high);
+    __m256i b = _mm256_unpackhi_epi8(low, high);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 2 * i),
+                        _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + 2 * i + 32),
+                        _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  return i;
+}
+
+#elif defined(XLA_SIMD_CONVERT_NEON)
+
+int64_t F32ToBF16Neon(const float* src, uint16_t* dest, int64_t n) {
+  const uint32x4_t one = vdupq_n_u32(1);
+  const uint32x4_t bias = vdupq_n_u32(0x7fff);
+  const uint32x4_t abs_mask = vdupq_n_u32(0x7fffffff);
+  const uint32x4_t infinity = vdupq_n_u32(0x7f800000);
+  const uint32x4_t sign = vdupq_n_u32(0x8000);
+  const uint32x4_t nan = vdupq_n_u32(0x7fc0);
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint32x4_t x = vld1q_u32(reinterpret_cast<const uint32_t*>(src + i));
+    uint32x4_t lsb = vandq_u32(vshrq_n_u32(x, 16), one);
+    uint32x4_t rounded =
+        vshrq_n_u32(vaddq_u32(vaddq_u32(x, bias), lsb), 16);
+    uint32x4_t is_nan = vcgtq_u32(vandq_u32(x, abs_mask), infinity);
+    uint32x4_t quiet_nan =
+        vorrq_u32(vandq_u32(vshrq_n_u32(x, 16), sign), nan);
+    vst1_u16(dest + i, vmovn_u32(vbslq_u32(is_nan, quiet_nan, rounded)));
+  }
+  return i;
+}
+
+int64_t BF16ToF32Neon(const uint16_t* src, float* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_u32(reinterpret_cast<uint32_t*>(dest + i),
+              vshll_n_u16(vld1_u16(src + i), 16));
+  }
+  return i;
+}
+
+int64_t F32ToF16Neon(const float* src, uint16_t* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1_u16(dest + i,
+             vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(src + i))));
+  }
+  return i;
+}
+
+int64_t F16ToF32Neon(const uint16_t* src, float* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_f32(dest + i,
+              vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(src + i))));
+  }
+  return i;
+}
+
+int64_t S64ToS32Neon(const int64_t* src, int32_t* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    vst1q_s32(dest + i, vcombine_s32(vmovn_s64(vld1q_s64(src + i)),
+                                     vmovn_s64(vld1q_s64(src + i + 2))));
+  }
+  return i;
+}
+
+int64_t S32ToS64Neon(const int32_t* src, int64_t* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    int32x4_t x = vld1q_s32(src + i);
+    vst1q_s64(dest + i, vmovl_s32(vget_low_s32(x)));
+    vst1q_s64(dest + i + 2, vmovl_high_s32(x));
+  }
+  return i;
+}
+
+int64_t PackInt4Neon(const int8_t* src, uint8_t* dest, int64_t n) {
+  const uint8x16_t mask = vdupq_n_u8(0x0f);
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    // Loads the even elements in val[0], and the odd ones in val[1].
+    uint8x16x2_t x = vld2q_u8(reinterpret_cast<const uint8_t*>(src + 2 * i));
+    vst1q_u8(dest + i,
+             vorrq_u8(vandq_u8(x.val[0], mask), vshlq_n_u8(x.val[1], 4)));
+  }
+  return i;
+}
+
+int64_t UnpackInt4Neon(const uint8_t* src, int8_t* dest, int64_t n) {
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    int8x16_t x = vreinterpretq_s8_u8(vld1q_u8(src + i));
+    int8x16x2_t result;
+    result.val[0] = vshrq_n_s8(vshlq_n_s8(x, 4), 4);
+    result.val[1] = vshrq_n_s8(x, 4);
+    vst2q_s8(dest + 2 * i, result);
+  }
+  return i;
+}
+
+#endif
+
+}  // namespace
+
+Isa GetIsa() {
+  if (Uses(Isa::kAvx512)) {
+    return Isa::kAvx512;
+  }
+  if (Uses(Isa::kAvx2)) {
+    return Isa::kAvx2;
+  }
+  return Uses(Isa::kNeon) ? Isa::kNeon : Isa::kScalar;
+}
+
+void SetMaxIsaForTesting(Isa isa) {
+  max_isa.store(isa, std::memory_order_relaxed);
+}
+
+// The AVX-512 kernels leave up to 15 elements, of which the AVX2 ones convert
+// what they can.
+#if defined(XLA_SIMD_CONVERT_X86)
+#define XLA_SIMD_CONVERT_DISPATCH(name, src, dest, n)        \
+  int64_t i = 0;                                             \
+  if (Uses(Isa::kAvx512)) {                                  \
+    i = name##Avx512(src, dest, n);                          \
+  }                                                          \
+  if (Uses(Isa::kAvx2)) {                                    \
+    i += name##Avx2(src + i, dest + i, n - i);               \
+  }                                                          \
+  return i
+#elif defined(XLA_SIMD_CONVERT_NEON)
+#define XLA_SIMD_CONVERT_DISPATCH(name, src, dest, n) \
+  return Uses(Isa::kNeon) ? name##Neon(src, dest, n) : 0
+#else
+#define XLA_SIMD_CONVERT_DISPATCH(name, src, dest, n) return 0
+#endif
+
+int64_t F32ToBF16(const float* src, uint16_t* dest, int64_t n) {
+  XLA_SIMD_CONVERT_DISPATCH(F32ToBF16, src, dest, n);
+}
+
+int64_t BF16ToF32(const uint16_t* src, float* dest, int64_t n) {
+  XLA_SIMD_CONVERT_DISPATCH(BF16ToF32, src, dest, n);
+}
+
+int64_t F32ToF16(const float* src, uint16_t* dest, int64_t n) {
+  XLA_SIMD_CONVERT_DISPATCH(F32ToF16, src, dest, n);
+}
+
+int64_t F16ToF32(const uint16_t* src, float* dest, int64_t n) {
+  XLA_SIMD_CONVERT_DISPATCH(F16ToF32, src, dest, n);
+}
+
+int64_t S64ToS32(const int64_t* src, int32_t* dest, int64_t n) {
+  XLA_SIMD_CONVERT_DISPATCH(S64ToS32, src, dest, n);
+}
+
+int64_t S32ToS64(const int32_t* src, int64_t* dest, int64_t n) {
+  XLA_SIMD_CONVERT_DISPATCH(S32ToS64, src, dest, n);
+}
+
+#undef XLA_SIMD_CONVERT_DISPATCH
+
+int64_t PackInt4(const int8_t* src, uint8_t* dest, int64_t n) {
+#if defined(XLA_SIMD_CONVERT_X86)
+  return Uses(Isa::kAvx2) ? PackInt4Avx2(src, dest, n) : 0;
+#elif defined(XLA_SIMD_CONVERT_NEON)
+  return Uses(Isa::kNeon) ? PackInt4Neon(src, dest, n) : 0;
+#else
+  return 0;
+#endif
+}
+
+int64_t UnpackInt4(const uint8_t* src, int8_t* dest, int64_t n) {
+#if defined(XLA_SIMD_CONVERT_X86)
+  return Uses(Isa::kAvx2) ? UnpackInt4Avx2(src, dest, n) : 0;
+#elif defined(XLA_SIMD_CONVERT_NEON)
+  return Uses(Isa::kNeon) ? UnpackInt4Neon(src, dest, n) : 0;
+#else
+  return 0;
+#endif
+}
+
+}  // namespace simd_convert
+}  // namespace torch_xla
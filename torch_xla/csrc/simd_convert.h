@@ -0,0 +1,47 @@
+#ifndef XLA_TORCH_XLA_CSRC_SIMD_CONVERT_H_
+#define XLA_TORCH_XLA_CSRC_SIMD_CONVERT_H_
+
+#include <cstdint>
+
+namespace torch_xla {
+namespace simd_convert {
+
+// Vectorized element type conversions, for the host copies between the
+// PyTorch and the XLA element types. Each function converts the longest
+// prefix of the `n` elements it can with the vector instructions of the CPU,
+// picked at runtime, and returns its length. The caller converts the rest.
+// The results are the ones of the scalar conversions: round to nearest even,
+// denormals kept, and NaNs mapped to quiet NaNs of the same sign.
+
+enum class Isa {
+  kScalar,
+  kNeon,
+  kAvx2,
+  kAvx512,
+};
+
+// Returns the instruction set the conversions use.
+Isa GetIsa();
+
+// Makes the conversions use at most `isa`, for tests.
+void SetMaxIsaForTesting(Isa isa);
+
+int64_t F32ToBF16(const float* src, uint16_t* dest, int64_t n);
+int64_t BF16ToF32(const uint16_t* src, float* dest, int64_t n);
+int64_t F32ToF16(const float* src, uint16_t* dest, int64_t n);
+int64_t F16ToF32(const uint16_t* src, float* dest, int64_t n);
+// Keeps the low 32 bits of each element, as static_cast<int32_t>() does.
+int64_t S64ToS32(const int64_t* src, int32_t* dest, int64_t n);
+int64_t S32ToS64(const int32_t* src, int64_t* dest, int64_t n);
+
+// Packs the int4 values of `src`, int8 in [-8, 7], two per byte of `dest`: the
+// even elements in the low nibbles. `n` is the number of bytes of `dest`, and
+// the returned length counts them too.
+int64_t PackInt4(const int8_t* src, uint8_t* dest, int64_t n);
+// Reverses PackInt4(), sign extending the nibbles of the `n` bytes of `src`.
+int64_t UnpackInt4(const uint8_t* src, int8_t* dest, int64_t n);
+
+}  // namespace simd_convert
+}  // namespace torch_xla
+
+#endif  // XLA_TORCH_XLA_CSRC_SIMD_CONVERT_H_
@@ -1,5 +1,9 @@
 #include "torch_xla/csrc/stack_frame_index_builder.h"
 
+#include <algorithm>
+
+#include "absl/strings/str_cat.h"
+
 namespace torch_xla {
 
 // Invalid stack frame id - used for stack frame population
@@ -18,21 +22,38 @@ void StackFrameIndexBuilder::AddStackFrameLocations(
     const std::vector<torch::lazy::SourceLocation>& frame_info,
     int max_stack_depth, xla::OpMetadata& metadata_to_populate) {
   if (!frame_info.empty()) {
-    auto frame_it = frame_info.rbegin();
-    int parent_frame_id = kInvalidIndex;
-    int depth = 0;
-    for (; frame_it != frame_info.rend() && depth < max_stack_depth;
-         ++frame_it) {
-      parent_frame_id = AddStackFrameLocation(*frame_it, parent_frame_id);
-      ++depth;
+    size_t depth =
+        std::min(frame_info.size(), static_cast<size_t>(max_stack_depth));
+    std::string stack_key;
+    for (auto frame_it = frame_info.rbegin();
+         frame_it != frame_info.rbegin() + depth; ++frame_it) {
+      absl::StrAppend(&stack_key, frame_it->file, "\n", frame_it->function,
+                      "\n", frame_it->line, "\n");
     }
+    auto stack_iterator = stack_to_id_.find(stack_key);
+    if (stack_iterator == stack_to_id_.end()) {
+      auto frame_it = frame_info.rbegin();
+      int parent_frame_id = kInvalidIndex;
+      for (; frame_it != frame_info.rbegin() + depth; ++frame_it) {
+        parent_frame_id = AddStackFrameLocation(*frame_it, parent_frame_id);
+      }
 
-    // Point to first entry / deepest call / top frame in call stack
-    --frame_it;
+      // Point to first entry / deepest call / top frame in call stack
+      --frame_it;
+
+      stack_iterator =
+          stack_to_id_
+              .emplace(std::move(stack_key),
+                       std::make_pair(frame_info.rend() - frame_it - 1,
+                                      parent_frame_id))
+              .first;
+    }
 
-    metadata_to_populate.set_source_file(frame_it->file);
-    metadata_to_populate.set_source_line(frame_it->line);
-    metadata_to_populate.set_stack_frame_id(parent_frame_id);
+    const auto& [top_frame_index, stack_frame_id] = stack_iterator->second;
+    const torch::lazy::SourceLocation& top_frame = frame_info[top_frame_index];
+    metadata_to_populate.set_source_file(top_frame.file);
+    metadata_to_populate.set_source_line(top_frame.line);
+    metadata_to_populate.set_stack_frame_id(stack_frame_id);
   }
 }
 
@@ -40,19 +61,18 @@ int StackFrameIndexBuilder::AddStackFrameLocation(
     const torch::lazy::SourceLocation& frame, int parent_frame_id) {
   int line = frame.line;
   int column = 0;  // Not provided in torch lazy source location - set to zero
-  std::string filename = frame.file;
-  std::string function_name = frame.function;
 
-  int filename_id = FindId(filename, file_name_to_id_);
+  // The names are only copied the first time they are seen.
+  int filename_id = FindId(frame.file, file_name_to_id_);
   if (filename_id == 0) {
-    indexes_.add_file_names(std::move(filename));
+    indexes_.add_file_names(frame.file);
     filename_id = indexes_.file_names_size();
     file_name_to_id_[indexes_.file_names(filename_id - 1)] = filename_id;
   }
 
-  int function_name_id = FindId(function_name, function_name_to_id_);
+  int function_name_id = FindId(frame.function, function_name_to_id_);
   if (function_name_id == 0) {
-    indexes_.add_function_names(std::move(function_name));
+    indexes_.add_function_names(frame.function);
     function_name_id = indexes_.function_names_size();
     function_name_to_id_[indexes_.function_names(function_name_id - 1)] =
         function_name_id;
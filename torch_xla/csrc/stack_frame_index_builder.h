@@ -1,8 +1,10 @@
 #pragma once
 
 #include <map>
+#include <string>
 #include <string_view>
 #include <tuple>
+#include <unordered_map>
 
 #include <torch/csrc/lazy/core/ir_metadata.h>  // SourceLocation
 
@@ -37,6 +39,10 @@ class StackFrameIndexBuilder {
   std::map<std::string_view, int> file_name_to_id_;
   std::map<std::tuple<int, int, int, int>, int> file_location_to_id_;
   std::map<std::tuple<int, int>, int> frame_to_id_;
+  // The stacks added before, keyed by their frames, to the index of their top
+  // frame within them and their stack frame id. Most nodes share their stack
+  // with other nodes, which then only cost a lookup.
+  std::unordered_map<std::string, std::pair<size_t, int>> stack_to_id_;
 };  // StackFrameIndexBuilder
 
 }  // namespace torch_xla
\ No newline at end of file
@@ -44,6 +44,7 @@
 #include "torch_xla/csrc/runtime/pjrt_computation_client.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/xla_util.h"
+#include "torch_xla/csrc/scalar_pool.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/tensor_util.h"
 #include "torch_xla/csrc/torch_util.h"
@@ -379,6 +380,7 @@ void XLATensor::AssignIrValue(torch::lazy::Value ir_value) const {
   data()->ir_value = std::move(ir_value);
   data()->generation += 1;
   data()->is_cloned = false;
+  XLAGraphExecutor::Get()->TrackDirtyTensor(data());
 }
 
 torch::lazy::Value XLATensor::GetIrValue() const {
@@ -436,7 +438,7 @@ torch::lazy::Value XLATensor::GetIrValueForTensor(
       return ScalarOp(std::move(value),
                       MakeXlaPrimitiveType(tensor.scalar_type(), &device));
     }
-    data = XLAGraphExecutor::Get()->GetDeviceData(tensor.cpu(), device);
+    data = ScalarPool::Get()->GetDeviceData(tensor.cpu(), device);
     read_only = true;
   } else {
     TORCH_LAZY_TIMED("IrValueTensorToXlaData");
@@ -26,6 +26,7 @@
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/layout_manager.h"
 #include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/ops/adafactor_optimizer_step.h"
 #include "torch_xla/csrc/ops/adam_optimizer_step.h"
 #include "torch_xla/csrc/ops/adaptive_max_pool2d.h"
 #include "torch_xla/csrc/ops/all_gather.h"
@@ -33,15 +34,21 @@
 #include "torch_xla/csrc/ops/all_to_all.h"
 #include "torch_xla/csrc/ops/amp_foreach_non_finite_check_and_unscale.h"
 #include "torch_xla/csrc/ops/amp_update_scale.h"
+#include "torch_xla/csrc/ops/approx_topk.h"
 #include "torch_xla/csrc/ops/arithmetic_ir_ops.h"
 #include "torch_xla/csrc/ops/as_strided.h"
 #include "torch_xla/csrc/ops/avg_pool_nd.h"
 #include "torch_xla/csrc/ops/avg_pool_nd_backward.h"
+#include "torch_xla/csrc/ops/batched_nms.h"
 #include "torch_xla/csrc/ops/bernoulli.h"
+#include "torch_xla/csrc/ops/blocked_attention.h"
+#include "torch_xla/csrc/ops/blocked_attention_backward.h"
 #include "torch_xla/csrc/ops/cast.h"
 #include "torch_xla/csrc/ops/cast_int4.h"
 #include "torch_xla/csrc/ops/cat.h"
 #include "torch_xla/csrc/ops/cdist.h"
+#include "torch_xla/csrc/ops/chunked_cross_entropy.h"
+#include "torch_xla/csrc/ops/chunked_cross_entropy_backward.h"
 #include "torch_xla/csrc/ops/collective_permute.h"
 #include "torch_xla/csrc/ops/constant.h"
 #include "torch_xla/csrc/ops/constant_pad_nd.h"
@@ -57,16 +64,20 @@
 #include "torch_xla/csrc/ops/diagonal.h"
 #include "torch_xla/csrc/ops/discrete_uniform.h"
 #include "torch_xla/csrc/ops/dot_general.h"
+#include "torch_xla/csrc/ops/dropout_mask.h"
 #include "torch_xla/csrc/ops/dynamic_expand.h"
+#include "torch_xla/csrc/ops/dynamic_update_slice.h"
 #include "torch_xla/csrc/ops/dynamic_view.h"
 #include "torch_xla/csrc/ops/eigh.h"
 #include "torch_xla/csrc/ops/einsum.h"
 #include "torch_xla/csrc/ops/einsum_backward.h"
 #include "torch_xla/csrc/ops/embedding_bag.h"
+#include "torch_xla/csrc/ops/embedding_bag_backward.h"
 #include "torch_xla/csrc/ops/expand.h"
 #include "torch_xla/csrc/ops/expand_symint.h"
 #include "torch_xla/csrc/ops/exponential.h"
 #include "torch_xla/csrc/ops/flip.h"
+#include "torch_xla/csrc/ops/fp8_dot.h"
 #include "torch_xla/csrc/ops/gather.h"
 #include "torch_xla/csrc/ops/generic.h"
 #include "torch_xla/csrc/ops/generic_slice.h"
@@ -76,6 +87,7 @@
 #include "torch_xla/csrc/ops/index_select.h"
 #include "torch_xla/csrc/ops/infer_output_shape.h"
 #include "torch_xla/csrc/ops/kth_value.h"
+#include "torch_xla/csrc/ops/lamb_optimizer_step.h"
 #include "torch_xla/csrc/ops/linear_interpolation.h"
 #include "torch_xla/csrc/ops/linspace.h"
 #include "torch_xla/csrc/ops/log_softmax.h"
@@ -91,10 +103,13 @@
 #include "torch_xla/csrc/ops/min_in_dim.h"
 #include "torch_xla/csrc/ops/mse_loss.h"
 #include "torch_xla/csrc/ops/mse_loss_backward.h"
+#include "torch_xla/csrc/ops/multi_tensor_adam_optimizer_step.h"
 #include "torch_xla/csrc/ops/multinomial.h"
 #include "torch_xla/csrc/ops/native_batch_norm_backward.h"
 #include "torch_xla/csrc/ops/native_batch_norm_forward.h"
 #include "torch_xla/csrc/ops/native_dropout.h"
+#include "torch_xla/csrc/ops/native_layer_norm.h"
+#include "torch_xla/csrc/ops/native_layer_norm_backward.h"
 #include "torch_xla/csrc/ops/nll_loss.h"
 #include "torch_xla/csrc/ops/nll_loss2d.h"
 #include "torch_xla/csrc/ops/nll_loss2d_backward.h"
@@ -110,6 +125,7 @@
 #include "torch_xla/csrc/ops/put.h"
 #include "torch_xla/csrc/ops/qr.h"
 #include "torch_xla/csrc/ops/quant_tensor.h"
+#include "torch_xla/csrc/ops/quantized_dot.h"
 #include "torch_xla/csrc/ops/randperm.h"
 #include "torch_xla/csrc/ops/recv.h"
 #include "torch_xla/csrc/ops/reduce_scatter.h"
@@ -118,10 +134,14 @@
 #include "torch_xla/csrc/ops/replication_pad.h"
 #include "torch_xla/csrc/ops/replication_pad_backward.h"
 #include "torch_xla/csrc/ops/resize.h"
+#include "torch_xla/csrc/ops/rms_norm.h"
+#include "torch_xla/csrc/ops/rms_norm_backward.h"
 #include "torch_xla/csrc/ops/roll.h"
 #include "torch_xla/csrc/ops/rrelu_with_noise.h"
 #include "torch_xla/csrc/ops/rrelu_with_noise_backward.h"
+#include "torch_xla/csrc/ops/sample_tokens.h"
 #include "torch_xla/csrc/ops/scalar.h"
+#include "torch_xla/csrc/ops/scan.h"
 #include "torch_xla/csrc/ops/scatter.h"
 #include "torch_xla/csrc/ops/scatter_add.h"
 #include "torch_xla/csrc/ops/scatter_reduce.h"
@@ -151,6 +171,7 @@
 #include "torch_xla/csrc/ops/var.h"
 #include "torch_xla/csrc/ops/var_mean.h"
 #include "torch_xla/csrc/ops/view.h"
+#include "torch_xla/csrc/ops/zero_optimizer_step.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/metrics.h"
@@ -162,6 +183,7 @@
 #include "torch_xla/csrc/tensor_ops.h"
 #include "torch_xla/csrc/tensor_util.h"
 #include "torch_xla/csrc/xla_graph_executor.h"
+#include "torch_xla/csrc/xla_lower_util.h"
 
 namespace torch_xla {
 namespace tensor_methods {
@@ -300,6 +322,19 @@ absl::StatusOr<PoolNdInputsOwner> FillAndCheckPoolNdInputs(
   return PoolNdInputsOwner{kernel_size, stride, padding};
 }
 
+// Returns the shape of the layer norm weight or bias: the normalized, last
+// normalized_ndim dimensions of the input.
+xla::Shape LayerNormParamsShape(const XLATensorPtr& input,
+                                int64_t normalized_ndim) {
+  auto input_shape = input->shape();
+  const xla::Shape& shape = input_shape.get();
+  int64_t rank = shape.dimensions_size();
+  std::vector<int64_t> dimensions(
+      shape.dimensions().begin() + (rank - normalized_ndim),
+      shape.dimensions().end());
+  return xla::ShapeUtil::MakeShape(shape.element_type(), dimensions);
+}
+
 // Returns a 1-D shape for batch norm weight or bias based on the input shape.
 xla::Shape BatchNormFeaturesShape(const XLATensorPtr& input) {
   xla::PrimitiveType input_element_type =
@@ -318,6 +353,23 @@ torch::lazy::Value GetIrValueOrDefault(
                      default_value, default_shape, device);
 }
 
+// Returns the node of the dense or the sparse embedding_bag backward.
+torch::lazy::NodePtr EmbeddingBagBackwardNode(
+    const XLATensorPtr& grad, const XLATensorPtr& indices,
+    const XLATensorPtr& offset2bag, const XLATensorPtr& bag_size,
+    const XLATensorPtr& per_sample_weights, int64_t num_weights, int64_t mode,
+    bool sparse) {
+  xla::Shape per_sample_weights_shape = xla::ShapeUtil::MakeShape(
+      grad->shape().get().element_type(), {indices->size(0)});
+  torch::lazy::Value per_sample_weights_value =
+      GetIrValueOrDefault(per_sample_weights, 1, per_sample_weights_shape,
+                          grad->GetDevice());
+  return torch_xla::MakeNode<EmbeddingBagBackward>(
+      grad->GetIrValue(), indices->GetIrValue(), offset2bag->GetIrValue(),
+      bag_size->GetIrValue(), per_sample_weights_value, num_weights, mode,
+      sparse);
+}
+
 // Returns the IR for the given input. If the IR is not a floating point value,
 // cast it to the float_type.
 torch::lazy::Value GetFloatingIrValue(const XLATensorPtr& input,
@@ -742,6 +794,124 @@ absl::Status CheckCatCompatibleShapes(xla::Shape s1, xla::Shape s2,
   return absl::OkStatus();
 }
 
+std::vector<torch::lazy::Value> GetIrValues(
+    absl::Span<const XLATensorPtr> tensors) {
+  std::vector<torch::lazy::Value> values;
+  values.reserve(tensors.size());
+  for (const XLATensorPtr& tensor : tensors) {
+    values.push_back(tensor->GetIrValue());
+  }
+  return values;
+}
+
+std::vector<torch::lazy::Value> GetGradIrValues(
+    absl::Span<const XLATensorPtr> grads, bool maximize) {
+  std::vector<torch::lazy::Value> values;
+  values.reserve(grads.size());
+  for (const XLATensorPtr& grad : grads) {
+    values.push_back(maximize ? mul(grad, -1)->GetIrValue()
+                              : grad->GetIrValue());
+  }
+  return values;
+}
+
+// Sets the outputs of the multi-tensor optimizer step `node` to `tensors`, in
+// order, and executes them in eager mode.
+void SetOptimizerStepOutputs(const torch::lazy::NodePtr& node,
+                             absl::Span<XLATensorPtr* const> tensors) {
+  std::vector<XLATensorPtr> tensors_to_sync;
+  tensors_to_sync.reserve(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    (*tensors[i])
+        ->SetInPlaceIrValue(torch::lazy::Value(node, i),
+                            /*delay_eager_execution=*/true);
+    tensors_to_sync.push_back(*tensors[i]);
+  }
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    // Execute the HLO that will run the update of all the parameters in one
+    // hlo
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+}
+
+// Builds the ZeroOptimizerStep of the `grads`, sets the `shards`, `steps` and
+// `states`, grouped by kind, to their updates, and returns the gathered padded
+// parameters and, with a `max_norm`, the norm of the gradients.
+std::pair<std::vector<XLATensorPtr>, XLATensorPtr> ZeroOptimizerStepImpl(
+    ZeroOptimizer optimizer, absl::Span<const double> scalars,
+    absl::Span<const XLATensorPtr> grads, absl::Span<XLATensorPtr> shards,
+    absl::Span<XLATensorPtr> steps, absl::Span<XLATensorPtr> states,
+    bool use_weight_decay, bool use_momentum, bool use_nesterov,
+    bool maximize, double scale, int64_t shard_count,
+    std::vector<std::vector<int64_t>> groups, bool pin_layout,
+    std::optional<double> max_norm) {
+  const torch::lazy::BackendDevice& device = shards[0]->GetDevice();
+  xla::PrimitiveType type = shards[0]->shape().get().element_type();
+  std::vector<torch::lazy::Value> scalar_values;
+  for (double value : scalars) {
+    scalar_values.push_back(
+        XLAGraphExecutor::Get()->GetIrValueForScalar(value, type, device));
+  }
+  torch::lazy::NodePtr node = torch_xla::MakeNode<ZeroOptimizerStep>(
+      optimizer, scalar_values, GetGradIrValues(grads, maximize),
+      GetIrValues(shards), GetIrValues(steps), GetIrValues(states),
+      GetAllReduceToken(device), use_weight_decay, use_momentum, use_nesterov,
+      scale, shard_count, std::move(groups), pin_layout, max_norm);
+
+  size_t num_states = ZeroOptimizerStep::NumStates(optimizer);
+  std::vector<XLATensorPtr> tensors_to_sync;
+  size_t index = 0;
+  auto set_output = [&](XLATensorPtr& tensor) {
+    tensor->SetInPlaceIrValue(torch::lazy::Value(node, index++),
+                              /*delay_eager_execution=*/true);
+    tensors_to_sync.push_back(tensor);
+  };
+  for (size_t i = 0; i < shards.size(); ++i) {
+    set_output(steps[i]);
+    set_output(shards[i]);
+    for (size_t j = 0; j < num_states; ++j) {
+      set_output(states[j * shards.size() + i]);
+    }
+  }
+  std::vector<XLATensorPtr> params;
+  for (const XLATensorPtr& grad : grads) {
+    params.push_back(grad->CreateFrom(torch::lazy::Value(node, index++),
+                                      /*delay_eager_execution=*/true));
+    tensors_to_sync.push_back(params.back());
+  }
+  XLATensorPtr grad_norm;
+  if (max_norm) {
+    grad_norm = shards[0]->CreateFrom(torch::lazy::Value(node, index++),
+                                      /*delay_eager_execution=*/true);
+    tensors_to_sync.push_back(grad_norm);
+  }
+  SetAllReduceToken(device,
+                    std::make_shared<torch::lazy::Value>(node, index));
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    // Execute the collectives and the updates in one hlo
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return {std::move(params), std::move(grad_norm)};
+}
+
+// Whether the training native_dropout() masks are regenerated from their seed
+// where they are used, per $XLA_DROPOUT_RECOMPUTE_MASK, instead of being kept
+// alive from the forward to the backward.
+bool UseDropoutMaskRecomputation() {
+  static const bool recompute_mask =
+      runtime::sys_util::GetEnvBool("XLA_DROPOUT_RECOMPUTE_MASK", false);
+  return recompute_mask;
+}
+
+// Returns the IR value of the index of a scatter into `dim` of `input`.
+torch::lazy::Value ScatterIndex(const XLATensorPtr& input,
+                                const XLATensorPtr& index, int64_t dim) {
+  return MaybeDowncastIndex(index->GetIrValue(),
+                            input->shape().get().dimensions(dim));
+}
+
 }  // namespace
 
 //////////////////////////////////////////////////////////////////////////////
@@ -749,11 +919,12 @@ absl::Status CheckCatCompatibleShapes(xla::Shape s1, xla::Shape s2,
 //////////////////////////////////////////////////////////////////////////////
 XLATensorPtr all_reduce(const XLATensorPtr& input, AllReduceType reduce_type,
                         double scale, std::vector<std::vector<int64_t>> groups,
-                        bool pin_layout) {
+                        bool pin_layout,
+                        std::optional<xla::PrimitiveType> reduce_element_type) {
   std::vector<torch::lazy::Value> input_values({input->GetIrValue()});
   torch::lazy::NodePtr node = torch_xla::MakeNode<AllReduce>(
       reduce_type, input_values, GetAllReduceToken(input->GetDevice()), scale,
-      std::move(groups), pin_layout);
+      std::move(groups), pin_layout, reduce_element_type);
   SetAllReduceToken(input->GetDevice(),
                     std::make_shared<torch::lazy::Value>(node, 1));
   return input->CreateFrom(torch::lazy::Value(node, 0));
@@ -761,35 +932,48 @@ XLATensorPtr all_reduce(const XLATensorPtr& input, AllReduceType reduce_type,
 
 void all_reduce(const std::vector<XLATensorPtr>& inputs,
                 AllReduceType reduce_type, double scale,
-                std::vector<std::vector<int64_t>> groups, bool pin_layout) {
+                std::vector<std::vector<int64_t>> groups, bool pin_layout,
+                std::optional<xla::PrimitiveType> reduce_element_type,
+                const std::vector<XLATensorPtr>& residuals) {
+  XLA_CHECK(residuals.empty() || residuals.size() == inputs.size())
+      << "Expected one residual per input, got " << residuals.size()
+      << " residuals for " << inputs.size() << " inputs";
   std::vector<torch::lazy::Value> input_values;
   input_values.reserve(inputs.size());
   for (auto& input : inputs) {
     input_values.push_back(input->GetIrValue());
   }
+  std::vector<torch::lazy::Value> residual_values;
+  residual_values.reserve(residuals.size());
+  for (auto& residual : residuals) {
+    residual_values.push_back(residual->GetIrValue());
+  }
   torch::lazy::NodePtr node = torch_xla::MakeNode<AllReduce>(
       reduce_type, input_values, GetAllReduceToken(inputs.front()->GetDevice()),
-      scale, std::move(groups), pin_layout);
-  for (size_t i = 0; i < inputs.size(); ++i) {
+      scale, std::move(groups), pin_layout, reduce_element_type,
+      residual_values);
+  std::vector<XLATensorPtr> updated_tensors(inputs);
+  updated_tensors.insert(updated_tensors.end(), residuals.begin(),
+                         residuals.end());
+  for (size_t i = 0; i < updated_tensors.size(); ++i) {
     // In eager mode we don't want to execute the IR for each tensor because
     // that will execute the `all_reduce` x times.
-    inputs[i]->SetInPlaceIrValue(torch::lazy::Value(node, i),
-                                 /*delay_eager_execution=*/true);
+    updated_tensors[i]->SetInPlaceIrValue(torch::lazy::Value(node, i),
+                                          /*delay_eager_execution=*/true);
   }
 
   XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
   if (graph_executor->UseEagerMode()) {
     // Execute the HLO that will run the `all_reduce` and in place update all
     // tensors in one graph.
-    graph_executor->ApplyEagerSync(
-        const_cast<std::vector<XLATensorPtr>&>(inputs));
+    graph_executor->ApplyEagerSync(updated_tensors);
   } else {
     // all_reduce_token is to enforce the order of the cc ops. There is no point
     // of setting it for eager mode since each cc op will be executed
     // independently.
     SetAllReduceToken(
         inputs.front()->GetDevice(),
-        std::make_shared<torch::lazy::Value>(node, inputs.size()));
+        std::make_shared<torch::lazy::Value>(node, updated_tensors.size()));
   }
 }
 
@@ -891,6 +1075,25 @@ std::pair<XLATensorPtr, torch::lazy::Value> all_to_all(
           torch::lazy::Value(node, 1)};
 }
 
+std::pair<std::vector<XLATensorPtr>, torch::lazy::Value> all_to_all_coalesced(
+    const std::vector<XLATensorPtr>& inputs, const torch::lazy::Value& token,
+    int64_t split_dimension, int64_t concat_dimension, int64_t split_count,
+    std::vector<std::vector<int64_t>> groups, bool pin_layout) {
+  std::vector<torch::lazy::Value> input_values;
+  input_values.reserve(inputs.size());
+  for (auto& input : inputs) {
+    input_values.push_back(input->GetIrValue());
+  }
+  torch::lazy::NodePtr node = torch_xla::MakeNode<AllToAllCoalesced>(
+      input_values, token, split_dimension, concat_dimension, split_count,
+      std::move(groups), pin_layout);
+  std::vector<XLATensorPtr> result;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    result.emplace_back(inputs[i]->CreateFrom(torch::lazy::Value(node, i)));
+  }
+  return {result, torch::lazy::Value(node, inputs.size())};
+}
+
 XLATensorPtr all_gather(const XLATensorPtr& input, int64_t dim,
                         int64_t shard_count,
                         std::vector<std::vector<int64_t>> groups,
@@ -953,6 +1156,85 @@ torch::lazy::Value all_gather_coalesced_out(
   return torch::lazy::Value(node, inputs.size());
 }
 
+std::tuple<XLATensorPtr, XLATensorPtr> blocked_attention(
+    const XLATensorPtr& query, const XLATensorPtr& key,
+    const XLATensorPtr& value, double scale, bool is_causal,
+    int64_t block_size) {
+  XLA_CHECK_GT(block_size, 0);
+  torch::lazy::NodePtr node = torch_xla::MakeNode<BlockedAttention>(
+      query->GetIrValue(), key->GetIrValue(), value->GetIrValue(), scale,
+      is_causal, block_size);
+  XLATensorPtr output = query->CreateFrom(torch::lazy::Value(node, 0),
+                                          /*delay_eager_execution=*/true);
+  XLATensorPtr lse =
+      query->CreateFrom(torch::lazy::Value(node, 1), at::ScalarType::Float,
+                        /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {output, lse};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(output, lse);
+}
+
+std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> blocked_attention_backward(
+    const XLATensorPtr& grad_output, const XLATensorPtr& query,
+    const XLATensorPtr& key, const XLATensorPtr& value,
+    const XLATensorPtr& output, const XLATensorPtr& lse, double scale,
+    bool is_causal, int64_t block_size) {
+  torch::lazy::NodePtr node = torch_xla::MakeNode<BlockedAttentionBackward>(
+      grad_output->GetIrValue(), query->GetIrValue(), key->GetIrValue(),
+      value->GetIrValue(), output->GetIrValue(), lse->GetIrValue(), scale,
+      is_causal, block_size);
+  XLATensorPtr grad_query = query->CreateFrom(torch::lazy::Value(node, 0),
+                                              /*delay_eager_execution=*/true);
+  XLATensorPtr grad_key = key->CreateFrom(torch::lazy::Value(node, 1),
+                                          /*delay_eager_execution=*/true);
+  XLATensorPtr grad_value = value->CreateFrom(torch::lazy::Value(node, 2),
+                                              /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {grad_query, grad_key,
+                                                 grad_value};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(grad_query, grad_key, grad_value);
+}
+
+std::tuple<XLATensorPtr, XLATensorPtr> chunked_cross_entropy(
+    const XLATensorPtr& logits, const XLATensorPtr& target, int64_t chunk_size,
+    int ignore_index) {
+  XLA_CHECK_EQ(logits->shape().get().dimensions_size(), 2)
+      << "The logits of chunked_cross_entropy must be of shape [N, C]";
+  XLA_CHECK_EQ(target->shape().get().dimensions_size(), 1)
+      << "The target of chunked_cross_entropy must be of shape [N]";
+  XLA_CHECK_GT(chunk_size, 0);
+  torch::lazy::NodePtr node = torch_xla::MakeNode<ChunkedCrossEntropy>(
+      logits->GetIrValue(), target->GetIrValue(), chunk_size, ignore_index);
+  XLATensorPtr losses = logits->CreateFrom(torch::lazy::Value(node, 0),
+                                           /*delay_eager_execution=*/true);
+  XLATensorPtr lse =
+      logits->CreateFrom(torch::lazy::Value(node, 1), at::ScalarType::Float,
+                         /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {losses, lse};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(losses, lse);
+}
+
+XLATensorPtr chunked_cross_entropy_backward(const XLATensorPtr& grad_output,
+                                            const XLATensorPtr& logits,
+                                            const XLATensorPtr& target,
+                                            const XLATensorPtr& lse,
+                                            int64_t chunk_size,
+                                            int ignore_index) {
+  return logits->CreateFrom(torch_xla::MakeNode<ChunkedCrossEntropyBackward>(
+      grad_output->GetIrValue(), logits->GetIrValue(), target->GetIrValue(),
+      lse->GetIrValue(), chunk_size, ignore_index));
+}
+
 std::pair<XLATensorPtr, torch::lazy::Value> collective_permute(
     const XLATensorPtr& input, const torch::lazy::Value& token,
     std::vector<std::pair<int64_t, int64_t>> source_target_pairs) {
@@ -1021,6 +1303,15 @@ absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> tpu_custom_call(
     const std::string& payload,
     const std::vector<std::vector<int64_t>>& output_shapes,
     const std::vector<at::ScalarType>& output_dtypes) {
+  return tpu_custom_call(inputs, InternTpuKernel(payload), output_shapes,
+                         output_dtypes);
+}
+
+absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> tpu_custom_call(
+    const std::vector<absl_nonnull XLATensorPtr>& inputs,
+    const std::shared_ptr<const TpuKernel>& kernel,
+    const std::vector<std::vector<int64_t>>& output_shapes,
+    const std::vector<at::ScalarType>& output_dtypes) {
   XLA_ASSIGN_OR_RETURN(
       std::vector<absl_nonnull XLATensorPtr> outputs,
       CustomCallImpl(
@@ -1030,7 +1321,7 @@ absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> tpu_custom_call(
               const std::vector<xla::Shape>& output_xla_shapes) {
             return torch_xla::MakeNode<TpuCustomCall>(
                 values, xla::ShapeUtil::MakeTupleShape(output_xla_shapes),
-                payload);
+                kernel);
           }));
 
   XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
@@ -1041,6 +1332,40 @@ absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> tpu_custom_call(
   return outputs;
 }
 
+void dynamic_update_slice_(XLATensorPtr& input, const XLATensorPtr& source,
+                           const XLATensorPtr& start_indices) {
+  xla::Shape input_shape = input->shape();
+  xla::Shape indices_shape = start_indices->shape();
+  XLA_CHECK_EQ(indices_shape.dimensions_size(), 1)
+      << "dynamic_update_slice_(): expected the `start_indices` to be a rank 1 "
+         "tensor, got "
+      << indices_shape;
+  XLA_CHECK_EQ(indices_shape.dimensions(0), input_shape.dimensions_size())
+      << "dynamic_update_slice_(): expected an index per dimension of "
+      << input_shape;
+  XLA_CHECK(xla::primitive_util::IsIntegralType(indices_shape.element_type()))
+      << "dynamic_update_slice_(): expected integer `start_indices`, got "
+      << indices_shape;
+  XLA_CHECK_LE(source->shape().get().dimensions_size(),
+               input_shape.dimensions_size());
+
+  torch::lazy::BackendDataPtr handle = input->CurrentDataHandle();
+  if (handle == nullptr) {
+    DeviceData* device_data =
+        DeviceData::Cast(input->CurrentIrValue().node.get());
+    if (device_data != nullptr) {
+      handle = device_data->data();
+    }
+  }
+  if (handle != nullptr) {
+    std::dynamic_pointer_cast<runtime::ComputationClient::Data>(handle)
+        ->set_should_donate_buffer(true);
+  }
+  input->SetInPlaceIrValue(torch_xla::MakeNode<DynamicUpdateSlice>(
+      input->GetIrValue(), source->GetIrValue(),
+      start_indices->GetIrValue()));
+}
+
 XLATensorPtr get_dimensions_size(const XLATensorPtr& input,
                                  std::vector<int64_t> dimensions) {
   return input->CreateFrom(torch_xla::MakeNode<GetDimensionsSize>(
@@ -1154,6 +1479,145 @@ void adam_optimizer_step_(const XLATensorPtr& found_inf, XLATensorPtr& step,
   }
 }
 
+void multi_tensor_adam_optimizer_step_(
+    const XLATensorPtr& found_inf, absl::Span<XLATensorPtr> steps,
+    absl::Span<XLATensorPtr> params, absl::Span<const XLATensorPtr> grads,
+    absl::Span<XLATensorPtr> exp_avgs, absl::Span<XLATensorPtr> exp_avg_sqs,
+    absl::Span<XLATensorPtr> max_exp_avg_sqs, double beta1, double beta2,
+    double lr, double weight_decay, double eps, bool amsgrad, bool maximize,
+    bool use_adamw, const XLATensorPtr& inv_scale) {
+  if (params.empty()) {
+    return;
+  }
+  // The hyper parameters are shared by all the parameters, as scalars which
+  // the lowering broadcasts.
+  auto scalar_value = [&](double value) {
+    return XLAGraphExecutor::Get()->GetIrValueForScalar(
+        value, found_inf->shape(), found_inf->GetDevice());
+  };
+  torch::lazy::NodePtr node = torch_xla::MakeNode<MultiTensorAdamOptimizerStep>(
+      found_inf->GetIrValue(), GetIrValues(steps), GetIrValues(params),
+      GetGradIrValues(grads, maximize), GetIrValues(exp_avgs),
+      GetIrValues(exp_avg_sqs),
+      amsgrad ? GetIrValues(max_exp_avg_sqs)
+              : std::vector<torch::lazy::Value>(),
+      scalar_value(beta1), scalar_value(beta2), scalar_value(lr),
+      scalar_value(weight_decay), scalar_value(eps),
+      /*use_weight_decay=*/weight_decay != 0,
+      /*use_amsgrad=*/amsgrad, /*use_adamw=*/use_adamw,
+      inv_scale != nullptr
+          ? std::optional<torch::lazy::Value>(max(inv_scale)->GetIrValue())
+          : std::nullopt);
+  std::vector<XLATensorPtr*> outputs;
+  for (size_t i = 0; i < params.size(); ++i) {
+    outputs.insert(outputs.end(),
+                   {&steps[i], &params[i], &exp_avgs[i], &exp_avg_sqs[i]});
+    if (amsgrad) {
+      outputs.push_back(&max_exp_avg_sqs[i]);
+    }
+  }
+  XLATensorPtr found_inf_output = found_inf;
+  if (inv_scale != nullptr) {
+    outputs.push_back(&found_inf_output);
+  }
+  SetOptimizerStepOutputs(node, outputs);
+}
+
+void lamb_optimizer_step_(
+    const XLATensorPtr& found_inf, absl::Span<XLATensorPtr> steps,
+    absl::Span<XLATensorPtr> params, absl::Span<const XLATensorPtr> grads,
+    absl::Span<XLATensorPtr> exp_avgs, absl::Span<XLATensorPtr> exp_avg_sqs,
+    double beta1, double beta2, double lr, double weight_decay, double eps,
+    bool maximize) {
+  if (params.empty()) {
+    return;
+  }
+  auto scalar_value = [&](double value) {
+    return XLAGraphExecutor::Get()->GetIrValueForScalar(
+        value, found_inf->shape(), found_inf->GetDevice());
+  };
+  torch::lazy::NodePtr node = torch_xla::MakeNode<LambOptimizerStep>(
+      found_inf->GetIrValue(), GetIrValues(steps), GetIrValues(params),
+      GetGradIrValues(grads, maximize), GetIrValues(exp_avgs),
+      GetIrValues(exp_avg_sqs), scalar_value(beta1), scalar_value(beta2),
+      scalar_value(lr), scalar_value(weight_decay), scalar_value(eps),
+      /*use_weight_decay=*/weight_decay != 0);
+  std::vector<XLATensorPtr*> outputs;
+  for (size_t i = 0; i < params.size(); ++i) {
+    outputs.insert(outputs.end(),
+                   {&steps[i], &params[i], &exp_avgs[i], &exp_avg_sqs[i]});
+  }
+  SetOptimizerStepOutputs(node, outputs);
+}
+
+void adafactor_optimizer_step_(
+    const XLATensorPtr& found_inf, absl::Span<XLATensorPtr> steps,
+    absl::Span<XLATensorPtr> params, absl::Span<const XLATensorPtr> grads,
+    absl::Span<XLATensorPtr> row_vars, absl::Span<XLATensorPtr> col_vars,
+    double lr, double beta2_decay, double eps1, double eps2, double d,
+    double weight_decay, bool maximize) {
+  if (params.empty()) {
+    return;
+  }
+  auto scalar_value = [&](double value) {
+    return XLAGraphExecutor::Get()->GetIrValueForScalar(
+        value, found_inf->shape(), found_inf->GetDevice());
+  };
+  torch::lazy::NodePtr node = torch_xla::MakeNode<AdafactorOptimizerStep>(
+      found_inf->GetIrValue(), GetIrValues(steps), GetIrValues(params),
+      GetGradIrValues(grads, maximize), GetIrValues(row_vars),
+      GetIrValues(col_vars), scalar_value(lr), scalar_value(beta2_decay),
+      scalar_value(eps1), scalar_value(eps2), scalar_value(d),
+      scalar_value(weight_decay),
+      /*use_weight_decay=*/weight_decay != 0);
+  std::vector<XLATensorPtr*> outputs;
+  for (size_t i = 0; i < params.size(); ++i) {
+    outputs.insert(outputs.end(), {&steps[i], &params[i], &row_vars[i]});
+    if (IsAdafactorFactored(params[i]->shape().get())) {
+      outputs.push_back(&col_vars[i]);
+    }
+  }
+  SetOptimizerStepOutputs(node, outputs);
+}
+
+std::pair<std::vector<XLATensorPtr>, XLATensorPtr> zero_adam_optimizer_step_(
+    absl::Span<const XLATensorPtr> grads, absl::Span<XLATensorPtr> shards,
+    absl::Span<XLATensorPtr> steps, absl::Span<XLATensorPtr> exp_avgs,
+    absl::Span<XLATensorPtr> exp_avg_sqs, double beta1, double beta2,
+    double lr, double weight_decay, double eps, bool maximize, bool use_adamw,
+    double scale, int64_t shard_count,
+    std::vector<std::vector<int64_t>> groups, bool pin_layout,
+    std::optional<double> max_norm) {
+  if (shards.empty()) {
+    return {};
+  }
+  std::vector<XLATensorPtr> states(exp_avgs.begin(), exp_avgs.end());
+  states.insert(states.end(), exp_avg_sqs.begin(), exp_avg_sqs.end());
+  return ZeroOptimizerStepImpl(
+      use_adamw ? ZeroOptimizer::kAdamW : ZeroOptimizer::kAdam,
+      {beta1, beta2, lr, weight_decay, eps}, grads, shards, steps,
+      absl::MakeSpan(states), /*use_weight_decay=*/weight_decay != 0,
+      /*use_momentum=*/false, /*use_nesterov=*/false, maximize, scale,
+      shard_count, std::move(groups), pin_layout, max_norm);
+}
+
+std::pair<std::vector<XLATensorPtr>, XLATensorPtr> zero_sgd_optimizer_step_(
+    absl::Span<const XLATensorPtr> grads, absl::Span<XLATensorPtr> shards,
+    absl::Span<XLATensorPtr> steps, absl::Span<XLATensorPtr> momentum_buffers,
+    double weight_decay, double momentum, double lr, double dampening,
+    bool nesterov, bool maximize, double scale, int64_t shard_count,
+    std::vector<std::vector<int64_t>> groups, bool pin_layout,
+    std::optional<double> max_norm) {
+  if (shards.empty()) {
+    return {};
+  }
+  return ZeroOptimizerStepImpl(
+      ZeroOptimizer::kSgd, {weight_decay, momentum, lr, dampening}, grads,
+      shards, steps, momentum_buffers, /*use_weight_decay=*/weight_decay != 0,
+      /*use_momentum=*/momentum != 0, /*use_nesterov=*/nesterov, maximize,
+      scale, shard_count, std::move(groups), pin_layout, max_norm);
+}
+
 absl::StatusOr<std::vector<XLATensorPtr>> user_computation(
     const std::string& opname,
     absl::Span<const absl_nonnull XLATensorPtr> inputs,
@@ -1175,6 +1639,33 @@ absl::StatusOr<std::vector<XLATensorPtr>> user_computation(
                                            /*inherit_logical_type=*/false);
 }
 
+absl::StatusOr<std::vector<XLATensorPtr>> scan(
+    absl::Span<const absl_nonnull XLATensorPtr> operands,
+    runtime::ComputationClient::ComputationPtr body, int64_t num_carry,
+    int64_t num_xs, std::vector<int64_t> parameter_operands,
+    int64_t seed_operand, bool reverse) {
+  XLA_RETURN_IF_ERROR(CheckNonEmptyInputs("scan()", operands));
+  XLA_CHECK_GT(num_xs, 0) << "scan() needs at least one xs tensor";
+  const int64_t num_operands = operands.size();
+  XLA_CHECK_LE(num_carry + num_xs, num_operands);
+  for (int64_t operand : parameter_operands) {
+    XLA_CHECK(operand >= 0 && operand < num_operands)
+        << "scan() body parameter takes operand " << operand << " of "
+        << num_operands;
+  }
+
+  std::vector<torch::lazy::Value> values(operands.size());
+  std::transform(
+      operands.begin(), operands.end(), values.begin(),
+      [](const XLATensorPtr& tensor) { return tensor->GetIrValue(); });
+
+  torch::lazy::NodePtr node = torch_xla::MakeNode<Scan>(
+      values, std::move(body), num_carry, num_xs,
+      std::move(parameter_operands), seed_operand, reverse);
+  return operands.front()->MakeOutputTensors(node,
+                                             /*inherit_logical_type=*/false);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // ATEN operators follows here, listed in alphabetical order.
 //////////////////////////////////////////////////////////////////////////////
@@ -1361,6 +1852,28 @@ XLATensorPtr addmm(const XLATensorPtr& input, const XLATensorPtr& weight,
       input->GetIrValue(), weight->GetIrValue(), bias->GetIrValue()));
 }
 
+std::tuple<XLATensorPtr, XLATensorPtr> approx_topk(const XLATensorPtr& input,
+                                                   int64_t k, int64_t dim,
+                                                   bool largest,
+                                                   double recall_target) {
+  torch::lazy::NodePtr node = torch_xla::MakeNode<ApproxTopK>(
+      input->GetIrValue(), k,
+      torch::lazy::GetCanonicalDimensionIndex(
+          dim, input->shape().get().dimensions_size()),
+      largest, recall_target);
+  XLATensorPtr values = input->CreateFrom(torch::lazy::Value(node, 0),
+                                          /*delay_eager_execution=*/true);
+  XLATensorPtr indices =
+      input->CreateFrom(torch::lazy::Value(node, 1), at::ScalarType::Long,
+                        /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {values, indices};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(values, indices);
+}
+
 void arange_out(XLATensorPtr& out, const at::Scalar& start,
                 const at::Scalar& end, const at::Scalar& step,
                 at::ScalarType scalar_type) {
@@ -1448,6 +1961,31 @@ absl::StatusOr<absl_nonnull XLATensorPtr> baddbmm(const XLATensorPtr& input,
       bias_multiplier, product_multiplier));
 }
 
+std::tuple<XLATensorPtr, XLATensorPtr> batched_nms(
+    const XLATensorPtr& boxes, const XLATensorPtr& scores,
+    const XLATensorPtr& classes, double iou_threshold, double score_threshold,
+    int64_t max_output_size) {
+  const torch::lazy::BackendDevice& device = boxes->GetDevice();
+  xla::PrimitiveType threshold_type =
+      MakeXlaPrimitiveType(at::kDouble, &device);
+  torch::lazy::NodePtr node = torch_xla::MakeNode<BatchedNms>(
+      boxes->GetIrValue(), scores->GetIrValue(), classes->GetIrValue(),
+      ScalarOp(iou_threshold, threshold_type),
+      ScalarOp(score_threshold, threshold_type), max_output_size);
+  XLATensorPtr indices =
+      XLATensor::Create(torch::lazy::Value(node, 0), device,
+                        at::ScalarType::Long, /*delay_eager_execution=*/true);
+  XLATensorPtr counts =
+      XLATensor::Create(torch::lazy::Value(node, 1), device,
+                        at::ScalarType::Long, /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {indices, counts};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(indices, counts);
+}
+
 XLATensorPtr bernoulli(const XLATensorPtr& input, double probability) {
   auto input_shape = input->shape();
   return input->CreateFrom(torch_xla::MakeNode<Bernoulli>(
@@ -1494,6 +2032,43 @@ absl::StatusOr<absl_nonnull XLATensorPtr> bmm(const XLATensorPtr& input,
   return matmul(input, mat2);
 }
 
+namespace {
+
+// Returns both outputs of a bounded NonZero or MaskedSelect `node`, the first
+// one of `dtype`.
+std::tuple<XLATensorPtr, XLATensorPtr> CreateBoundedOutputs(
+    const torch::lazy::NodePtr& node, const torch::lazy::BackendDevice& device,
+    std::optional<at::ScalarType> dtype) {
+  XLATensorPtr values = XLATensor::Create(torch::lazy::Value(node, 0), device,
+                                          dtype,
+                                          /*delay_eager_execution=*/true);
+  XLATensorPtr count =
+      XLATensor::Create(torch::lazy::Value(node, 1), device,
+                        at::ScalarType::Long, /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {values, count};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(values, count);
+}
+
+}  // namespace
+
+std::tuple<XLATensorPtr, XLATensorPtr> bounded_masked_select(
+    const XLATensorPtr& input, const XLATensorPtr& mask) {
+  torch::lazy::NodePtr node = torch_xla::MakeNode<MaskedSelect>(
+      input->GetIrValue(), mask->GetIrValue(), /*bounded=*/true);
+  return CreateBoundedOutputs(node, input->GetDevice(), input->dtype());
+}
+
+std::tuple<XLATensorPtr, XLATensorPtr> bounded_nonzero(
+    const XLATensorPtr& input) {
+  torch::lazy::NodePtr node =
+      torch_xla::MakeNode<NonZero>(input->GetIrValue(), /*bounded=*/true);
+  return CreateBoundedOutputs(node, input->GetDevice(), at::ScalarType::Long);
+}
+
 absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> broadcast_tensors(
     absl::Span<const absl_nonnull XLATensorPtr> tensors) {
   XLA_RETURN_IF_ERROR(CheckNonEmptyInputs("broadcast_tensors()", tensors));
@@ -1996,6 +2571,38 @@ embedding_bag(const XLATensorPtr& weight, const XLATensorPtr& indices,
   return std::make_tuple(t1, t2, t3, t4);
 }
 
+XLATensorPtr embedding_bag_backward(const XLATensorPtr& grad,
+                                    const XLATensorPtr& indices,
+                                    const XLATensorPtr& offset2bag,
+                                    const XLATensorPtr& bag_size,
+                                    const XLATensorPtr& per_sample_weights,
+                                    int64_t num_weights, int64_t mode) {
+  return grad->CreateFrom(EmbeddingBagBackwardNode(
+      grad, indices, offset2bag, bag_size, per_sample_weights, num_weights,
+      mode, /*sparse=*/false));
+}
+
+std::tuple<XLATensorPtr, XLATensorPtr> embedding_bag_sparse_backward(
+    const XLATensorPtr& grad, const XLATensorPtr& indices,
+    const XLATensorPtr& offset2bag, const XLATensorPtr& bag_size,
+    const XLATensorPtr& per_sample_weights, int64_t num_weights,
+    int64_t mode) {
+  torch::lazy::NodePtr node = EmbeddingBagBackwardNode(
+      grad, indices, offset2bag, bag_size, per_sample_weights, num_weights,
+      mode, /*sparse=*/true);
+  XLATensorPtr unique_indices = grad->CreateFrom(
+      torch::lazy::Value(node, 0), at::ScalarType::Long,
+      /*delay_eager_execution=*/true);
+  XLATensorPtr values = grad->CreateFrom(torch::lazy::Value(node, 1),
+                                         /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {unique_indices, values};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(unique_indices, values);
+}
+
 XLATensorPtr exp(const XLATensorPtr& input) {
   return input->CreateFrom(Exp(input->GetIrValue()));
 }
@@ -2125,7 +2732,9 @@ absl::StatusOr<absl_nonnull XLATensorPtr> gather(const XLATensorPtr& input,
   XLA_RETURN_IF_ERROR(
       CheckGatherSizesAreCompatible(input, index, canonical_dim));
   return input->CreateFrom(torch_xla::MakeNode<Gather>(
-      input->GetIrValue(), canonical_dim, index->GetIrValue()));
+      input->GetIrValue(), canonical_dim,
+      MaybeDowncastIndex(index->GetIrValue(),
+                         input->shape().get().dimensions(canonical_dim))));
 }
 
 XLATensorPtr ge(const XLATensorPtr& input, const at::Scalar& other) {
@@ -2239,12 +2848,13 @@ void index_put_(XLATensorPtr& input, const XLATensorPtr& canonical_base,
 
 XLATensorPtr index_select(const XLATensorPtr& input, int64_t dim,
                           const XLATensorPtr& index) {
-  torch::lazy::Value index_value = EnsureRank1(index->GetIrValue());
+  int64_t canonical_dim = torch::lazy::GetCanonicalDimensionIndex(
+      dim, input->shape().get().dimensions_size());
+  torch::lazy::Value index_value =
+      MaybeDowncastIndex(EnsureRank1(index->GetIrValue()),
+                         input->shape().get().dimensions(canonical_dim));
   return input->CreateFrom(torch_xla::MakeNode<IndexSelect>(
-      input->GetIrValue(),
-      torch::lazy::GetCanonicalDimensionIndex(
-          dim, input->shape().get().dimensions_size()),
-      index_value));
+      input->GetIrValue(), canonical_dim, index_value));
 }
 
 XLATensorPtr isnan(const XLATensorPtr& input) {
@@ -2839,15 +3449,22 @@ std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> native_batch_norm_backward(
 
 std::tuple<XLATensorPtr, XLATensorPtr> native_dropout(
     const XLATensorPtr& input, double p, std::optional<bool> train) {
-  torch::lazy::NodePtr node = torch_xla::MakeNode<NativeDropout>(
-      input->GetIrValue(),
-      XLAGraphExecutor::Get()->GetRngSeed(input->GetDevice()), p, train);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  torch::lazy::Value seed = graph_executor->GetRngSeed(input->GetDevice());
+  torch::lazy::NodePtr node =
+      torch_xla::MakeNode<NativeDropout>(input->GetIrValue(), seed, p, train);
   XLATensorPtr t1 = input->CreateFrom(torch::lazy::Value(node, 0),
                                       /*delay_eager_execution=*/true);
-  XLATensorPtr t2 =
-      input->CreateFrom(torch::lazy::Value(node, 1), at::ScalarType::Bool,
-                        /*delay_eager_execution=*/true);
-  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  torch::lazy::Value mask(node, 1);
+  if (UseDropoutMaskRecomputation() && train.value_or(true) && p > 0 &&
+      !graph_executor->UseEagerMode()) {
+    // The mask only holds the seed alive, and the backward draws its bits
+    // again.
+    mask = torch_xla::MakeNode<DropoutMask>(seed, input->shape().get(), p);
+    TORCH_LAZY_COUNTER("DropoutMaskRecomputed", 1);
+  }
+  XLATensorPtr t2 = input->CreateFrom(mask, at::ScalarType::Bool,
+                                      /*delay_eager_execution=*/true);
   if (graph_executor->UseEagerMode()) {
     // Execute the HLO that will run the `native_dropout` and in one hlo
     std::vector<XLATensorPtr> tensors_to_sync = {t1, t2};
@@ -2856,6 +3473,63 @@ std::tuple<XLATensorPtr, XLATensorPtr> native_dropout(
   return std::make_tuple(t1, t2);
 }
 
+std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> native_layer_norm(
+    const XLATensorPtr& input, int64_t normalized_ndim,
+    const XLATensorPtr& weight, const XLATensorPtr& bias, double eps) {
+  xla::Shape params_shape = LayerNormParamsShape(input, normalized_ndim);
+  torch::lazy::Value weight_value =
+      GetIrValueOrDefault(weight, 1, params_shape, input->GetDevice());
+  torch::lazy::Value bias_value =
+      GetIrValueOrDefault(bias, 0, params_shape, input->GetDevice());
+  torch::lazy::NodePtr node = torch_xla::MakeNode<NativeLayerNorm>(
+      input->GetIrValue(), weight_value, bias_value, normalized_ndim, eps);
+  XLATensorPtr output = input->CreateFrom(torch::lazy::Value(node, 0),
+                                          /*delay_eager_execution=*/true);
+  XLATensorPtr mean = input->CreateFrom(torch::lazy::Value(node, 1),
+                                        /*logical_element_type=*/std::nullopt,
+                                        /*delay_eager_execution=*/true);
+  XLATensorPtr rstd = input->CreateFrom(torch::lazy::Value(node, 2),
+                                        /*logical_element_type=*/std::nullopt,
+                                        /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    // Execute the HLO that will run the `native_layer_norm` and in one hlo
+    std::vector<XLATensorPtr> tensors_to_sync = {output, mean, rstd};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(std::move(output), std::move(mean), std::move(rstd));
+}
+
+std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> native_layer_norm_backward(
+    const XLATensorPtr& grad_out, const XLATensorPtr& input,
+    int64_t normalized_ndim, const XLATensorPtr& mean,
+    const XLATensorPtr& rstd, const XLATensorPtr& weight) {
+  xla::Shape params_shape = LayerNormParamsShape(input, normalized_ndim);
+  torch::lazy::Value weight_value =
+      GetIrValueOrDefault(weight, 1, params_shape, input->GetDevice());
+  torch::lazy::NodePtr node = torch_xla::MakeNode<NativeLayerNormBackward>(
+      grad_out->GetIrValue(), input->GetIrValue(), mean->GetIrValue(),
+      rstd->GetIrValue(), weight_value, normalized_ndim);
+  XLATensorPtr grad_input = input->CreateFrom(torch::lazy::Value(node, 0),
+                                              /*delay_eager_execution=*/true);
+  XLATensorPtr grad_weight = input->CreateFrom(
+      torch::lazy::Value(node, 1), /*logical_element_type=*/std::nullopt,
+      /*delay_eager_execution=*/true);
+  XLATensorPtr grad_bias = input->CreateFrom(
+      torch::lazy::Value(node, 2), /*logical_element_type=*/std::nullopt,
+      /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    // Execute the HLO that will run the `native_layer_norm_backward` and in
+    // one hlo
+    std::vector<XLATensorPtr> tensors_to_sync = {grad_input, grad_weight,
+                                                 grad_bias};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(std::move(grad_input), std::move(grad_weight),
+                         std::move(grad_bias));
+}
+
 XLATensorPtr ne(const XLATensorPtr& input, const at::Scalar& other) {
   return DispatchComparisonOp(at::aten::ne, input, other);
 }
@@ -3138,6 +3812,49 @@ XLATensorPtr cast_int4(const XLATensorPtr& weight,
   return weight->CreateFrom(torch::lazy::Value(node));
 }
 
+XLATensorPtr quantized_dot(const XLATensorPtr& x, const XLATensorPtr& w,
+                           const XLATensorPtr& scale,
+                           const XLATensorPtr& x_scale,
+                           const XLATensorPtr& zero_point, int64_t block_size) {
+  at::ScalarType output_type = at::promote_types(
+      scale->dtype(), x_scale ? x_scale->dtype() : x->dtype());
+  return x->CreateFrom(
+      torch_xla::MakeNode<QuantizedDot>(
+          x->GetIrValue(), w->GetIrValue(), scale->GetIrValue(),
+          GetOptionalIrValue(x_scale), GetOptionalIrValue(zero_point),
+          block_size, output_type),
+      output_type);
+}
+
+XLATensorPtr fp8_dot(const XLATensorPtr& lhs, const XLATensorPtr& rhs,
+                     XLATensorPtr& lhs_scale, XLATensorPtr& rhs_scale,
+                     XLATensorPtr& lhs_amax_history,
+                     XLATensorPtr& rhs_amax_history, at::ScalarType lhs_type,
+                     at::ScalarType rhs_type, int64_t rhs_contracting_dim,
+                     int64_t margin) {
+  torch::lazy::NodePtr node = torch_xla::MakeNode<Fp8Dot>(
+      lhs->GetIrValue(), rhs->GetIrValue(), lhs_scale->GetIrValue(),
+      rhs_scale->GetIrValue(), lhs_amax_history->GetIrValue(),
+      rhs_amax_history->GetIrValue(), lhs_type, rhs_type, rhs_contracting_dim,
+      margin);
+  XLATensorPtr output = lhs->CreateFrom(torch::lazy::Value(node, 0),
+                                        /*delay_eager_execution=*/true);
+  std::vector<XLATensorPtr> tensors_to_sync = {output};
+  size_t index = 1;
+  for (XLATensorPtr* state :
+       {&lhs_scale, &rhs_scale, &lhs_amax_history, &rhs_amax_history}) {
+    (*state)->SetInPlaceIrValue(torch::lazy::Value(node, index++),
+                                /*delay_eager_execution=*/true);
+    tensors_to_sync.push_back(*state);
+  }
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    // Execute the product and the scaling updates in one hlo
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return output;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 // Dynamic Reshape ops here.
 //////////////////////////////////////////////////////////////////////////////
@@ -3307,6 +4024,51 @@ void resize_(XLATensorPtr& input, std::vector<int64_t> size) {
   }
 }
 
+std::tuple<XLATensorPtr, XLATensorPtr> rms_norm(const XLATensorPtr& input,
+                                                int64_t normalized_ndim,
+                                                const XLATensorPtr& weight,
+                                                double eps) {
+  xla::Shape params_shape = LayerNormParamsShape(input, normalized_ndim);
+  torch::lazy::Value weight_value =
+      GetIrValueOrDefault(weight, 1, params_shape, input->GetDevice());
+  torch::lazy::NodePtr node = torch_xla::MakeNode<RmsNorm>(
+      input->GetIrValue(), weight_value, normalized_ndim, eps);
+  XLATensorPtr output = input->CreateFrom(torch::lazy::Value(node, 0),
+                                          /*delay_eager_execution=*/true);
+  XLATensorPtr rstd = input->CreateFrom(torch::lazy::Value(node, 1),
+                                        /*logical_element_type=*/std::nullopt,
+                                        /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {output, rstd};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(std::move(output), std::move(rstd));
+}
+
+std::tuple<XLATensorPtr, XLATensorPtr> rms_norm_backward(
+    const XLATensorPtr& grad_out, const XLATensorPtr& input,
+    int64_t normalized_ndim, const XLATensorPtr& rstd,
+    const XLATensorPtr& weight) {
+  xla::Shape params_shape = LayerNormParamsShape(input, normalized_ndim);
+  torch::lazy::Value weight_value =
+      GetIrValueOrDefault(weight, 1, params_shape, input->GetDevice());
+  torch::lazy::NodePtr node = torch_xla::MakeNode<RmsNormBackward>(
+      grad_out->GetIrValue(), input->GetIrValue(), rstd->GetIrValue(),
+      weight_value, normalized_ndim);
+  XLATensorPtr grad_input = input->CreateFrom(torch::lazy::Value(node, 0),
+                                              /*delay_eager_execution=*/true);
+  XLATensorPtr grad_weight = input->CreateFrom(
+      torch::lazy::Value(node, 1), /*logical_element_type=*/std::nullopt,
+      /*delay_eager_execution=*/true);
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  if (graph_executor->UseEagerMode()) {
+    std::vector<XLATensorPtr> tensors_to_sync = {grad_input, grad_weight};
+    graph_executor->ApplyEagerSync(tensors_to_sync);
+  }
+  return std::make_tuple(std::move(grad_input), std::move(grad_weight));
+}
+
 absl::StatusOr<absl_nonnull XLATensorPtr> roll(
     const absl_nonnull XLATensorPtr& input, absl::Span<const int64_t> shifts,
     absl::Span<const int64_t> dims) {
@@ -3403,50 +4165,70 @@ void copy_(XLATensorPtr& input, XLATensorPtr& src) {
   }
 }
 
+XLATensorPtr sample_tokens(const XLATensorPtr& logits, double temperature,
+                           int64_t top_k, double top_p) {
+  XLA_CHECK_GE(temperature, 0.0) << "The temperature must not be negative";
+  const torch::lazy::BackendDevice& device = logits->GetDevice();
+  // The temperature and the top-p are device data, so that their changes
+  // between the decoding steps do not compile new graphs.
+  XLAGraphExecutor* graph_executor = XLAGraphExecutor::Get();
+  return logits->CreateFrom(
+      torch_xla::MakeNode<SampleTokens>(
+          logits->GetIrValue(),
+          graph_executor->GetDeviceDataIrValue(temperature, xla::F32, device),
+          graph_executor->GetDeviceDataIrValue(top_p, xla::F32, device),
+          graph_executor->GetRngSeed(device), top_k),
+      at::ScalarType::Long);
+}
+
 XLATensorPtr scatter(const XLATensorPtr& input, int64_t dim,
                      const XLATensorPtr& index, const XLATensorPtr& src) {
+  int64_t canonical_dim = torch::lazy::GetCanonicalDimensionIndex(
+      dim, input->shape().get().dimensions_size());
   return input->CreateFrom(torch_xla::MakeNode<Scatter>(
-      input->GetIrValue(), index->GetIrValue(), src->GetIrValue(),
-      torch::lazy::GetCanonicalDimensionIndex(
-          dim, input->shape().get().dimensions_size())));
+      input->GetIrValue(), ScatterIndex(input, index, canonical_dim),
+      src->GetIrValue(), canonical_dim));
 }
 
 XLATensorPtr scatter(const XLATensorPtr& input, int64_t dim,
                      const XLATensorPtr& index, const at::Scalar& value) {
   torch::lazy::Value constant = XLAGraphExecutor::Get()->GetIrValueForScalar(
       value, input->shape(), input->GetDevice());
+  int64_t canonical_dim = torch::lazy::GetCanonicalDimensionIndex(
+      dim, input->shape().get().dimensions_size());
   return input->CreateFrom(torch_xla::MakeNode<Scatter>(
-      input->GetIrValue(), index->GetIrValue(), constant,
-      torch::lazy::GetCanonicalDimensionIndex(
-          dim, input->shape().get().dimensions_size())));
+      input->GetIrValue(), ScatterIndex(input, index, canonical_dim), constant,
+      canonical_dim));
 }
 
 XLATensorPtr scatter_add(const XLATensorPtr& input, int64_t dim,
                          const XLATensorPtr& index, const XLATensorPtr& src) {
+  int64_t canonical_dim = torch::lazy::GetCanonicalDimensionIndex(
+      dim, input->shape().get().dimensions_size());
   return input->CreateFrom(torch_xla::MakeNode<ScatterAdd>(
-      input->GetIrValue(), index->GetIrValue(), src->GetIrValue(),
-      torch::lazy::GetCanonicalDimensionIndex(
-          dim, input->shape().get().dimensions_size())));
+      input->GetIrValue(), ScatterIndex(input, index, canonical_dim),
+      src->GetIrValue(), canonical_dim));
 }
 
 XLATensorPtr scatter_add(const XLATensorPtr& input, int64_t dim,
                          const XLATensorPtr& index, const at::Scalar& value) {
   torch::lazy::Value constant = XLAGraphExecutor::Get()->GetIrValueForScalar(
       value, input->shape(), input->GetDevice());
+  int64_t canonical_dim = torch::lazy::GetCanonicalDimensionIndex(
+      dim, input->shape().get().dimensions_size());
   return input->CreateFrom(torch_xla::MakeNode<ScatterAdd>(
-      input->GetIrValue(), index->GetIrValue(), constant,
-      torch::lazy::GetCanonicalDimensionIndex(
-          dim, input->shape().get().dimensions_size())));
+      input->GetIrValue(), ScatterIndex(input, index, canonical_dim), constant,
+      canonical_dim));
 }
 
 XLATensorPtr scatter_reduce(const XLATensorPtr& input, int64_t dim,
                             const XLATensorPtr& index, const XLATensorPtr& src,
                             std::string_view reduce, bool include_self) {
+  int64_t canonical_dim = torch::lazy::GetCanonicalDimensionIndex(
+      dim, input->shape().get().dimensions_size());
   return input->CreateFrom(torch_xla::MakeNode<ScatterReduce>(
-      input->GetIrValue(), index->GetIrValue(), src->GetIrValue(), reduce,
-      include_self,
-      torch::lazy::GetCanonicalDimensionIndex(
-          dim, input->shape().get().dimensions_size())));
+      input->GetIrValue(), ScatterIndex(input, index, canonical_dim),
+      src->GetIrValue(), reduce, include_self, canonical_dim));
 }
 
 XLATensorPtr select(const XLATensorPtr& input, int64_t dim, int64_t index) {
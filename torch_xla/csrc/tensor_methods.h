@@ -6,6 +6,7 @@
 
 #include "torch_xla/csrc/cross_replica_reduces.h"
 #include "torch_xla/csrc/ops/custom_sharding.h"
+#include "torch_xla/csrc/ops/tpu_custom_call.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/tensor.h"
 
@@ -15,13 +16,19 @@ namespace tensor_methods {
 //////////////////////////////////////////////////////////////////////////////
 // XLA dedicated operators follows here, listed in alphabetical order.
 //////////////////////////////////////////////////////////////////////////////
-XLATensorPtr all_reduce(const XLATensorPtr& input, AllReduceType reduce_type,
-                        double scale, std::vector<std::vector<int64_t>> groups,
-                        bool pin_layout);
+XLATensorPtr all_reduce(
+    const XLATensorPtr& input, AllReduceType reduce_type, double scale,
+    std::vector<std::vector<int64_t>> groups, bool pin_layout,
+    std::optional<xla::PrimitiveType> reduce_element_type = std::nullopt);
 
-void all_reduce(const std::vector<XLATensorPtr>& inputs,
-                AllReduceType reduce_type, double scale,
-                std::vector<std::vector<int64_t>> groups, bool pin_layout);
+// Reduces the `inputs` in place. With `residuals`, one per input, the
+// residuals are added to the inputs before their conversion to
+// `reduce_element_type`, and updated in place with the conversion errors.
+void all_reduce(
+    const std::vector<XLATensorPtr>& inputs, AllReduceType reduce_type,
+    double scale, std::vector<std::vector<int64_t>> groups, bool pin_layout,
+    std::optional<xla::PrimitiveType> reduce_element_type = std::nullopt,
+    const std::vector<XLATensorPtr>& residuals = {});
 
 XLATensorPtr all_reduce(const XLATensorPtr& input, AllReduceType reduce_type,
                         double scale, std::vector<std::vector<int64_t>> groups);
@@ -66,6 +73,11 @@ std::pair<XLATensorPtr, torch::lazy::Value> all_to_all(
     int64_t split_dimension, int64_t concat_dimension, int64_t split_count,
     std::vector<std::vector<int64_t>> groups, bool pin_layout);
 
+std::pair<std::vector<XLATensorPtr>, torch::lazy::Value> all_to_all_coalesced(
+    const std::vector<XLATensorPtr>& inputs, const torch::lazy::Value& token,
+    int64_t split_dimension, int64_t concat_dimension, int64_t split_count,
+    std::vector<std::vector<int64_t>> groups, bool pin_layout);
+
 XLATensorPtr all_gather(
     const XLATensorPtr& input, int64_t dim, int64_t shard_count,
     std::vector<std::vector<int64_t>> groups, bool pin_layout,
@@ -89,6 +101,37 @@ torch::lazy::Value all_gather_coalesced_out(
     const torch::lazy::Value& token, int64_t dim, int64_t shard_count,
     std::vector<std::vector<int64_t>> groups, bool pin_layout);
 
+// The scaled dot product attention of `query`, `key` and `value`, and the
+// F32 log-sum-exps of the scores of every query. The keys are read
+// `block_size` at a time, so the [Sq, Sk] scores are never materialized.
+std::tuple<XLATensorPtr, XLATensorPtr> blocked_attention(
+    const XLATensorPtr& query, const XLATensorPtr& key,
+    const XLATensorPtr& value, double scale, bool is_causal,
+    int64_t block_size);
+
+// The gradients of blocked_attention() for `query`, `key` and `value`.
+std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> blocked_attention_backward(
+    const XLATensorPtr& grad_output, const XLATensorPtr& query,
+    const XLATensorPtr& key, const XLATensorPtr& value,
+    const XLATensorPtr& output, const XLATensorPtr& lse, double scale,
+    bool is_causal, int64_t block_size);
+
+// The per row cross-entropy losses of the [N, C] `logits` and the [N]
+// `target`, and the F32 log-sum-exps of the rows. The classes are read
+// `chunk_size` at a time, so the log-probabilities are never materialized.
+std::tuple<XLATensorPtr, XLATensorPtr> chunked_cross_entropy(
+    const XLATensorPtr& logits, const XLATensorPtr& target, int64_t chunk_size,
+    int ignore_index);
+
+// The gradient of chunked_cross_entropy() for the `logits`, recomputed chunk
+// by chunk from the log-sum-exps `lse`.
+XLATensorPtr chunked_cross_entropy_backward(const XLATensorPtr& grad_output,
+                                            const XLATensorPtr& logits,
+                                            const XLATensorPtr& target,
+                                            const XLATensorPtr& lse,
+                                            int64_t chunk_size,
+                                            int ignore_index);
+
 std::pair<XLATensorPtr, torch::lazy::Value> collective_permute(
     const XLATensorPtr& input, const torch::lazy::Value& token,
     std::vector<std::pair<int64_t, int64_t>> source_target_pairs);
@@ -112,6 +155,20 @@ absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> tpu_custom_call(
     const std::vector<std::vector<int64_t>>& output_shapes,
     const std::vector<at::ScalarType>& output_dtypes);
 
+// Same as above, with a kernel interned or registered beforehand.
+absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> tpu_custom_call(
+    const std::vector<absl_nonnull XLATensorPtr>& inputs,
+    const std::shared_ptr<const TpuKernel>& kernel,
+    const std::vector<std::vector<int64_t>>& output_shapes,
+    const std::vector<at::ScalarType>& output_dtypes);
+
+// Writes `source` into `input` in place, at the base indices held by the
+// rank 1 integer tensor `start_indices`. The current buffer of `input` is
+// marked for donation, so that the execution updating it reuses the buffer
+// rather than copying it, as decoding loops updating a KV cache need.
+void dynamic_update_slice_(XLATensorPtr& input, const XLATensorPtr& source,
+                           const XLATensorPtr& start_indices);
+
 XLATensorPtr get_dimensions_size(const XLATensorPtr& input,
                                  std::vector<int64_t> dimensions);
 
@@ -136,11 +193,74 @@ void adam_optimizer_step_(const XLATensorPtr& found_inf, XLATensorPtr& step,
                           double eps, bool amsgrad, bool maximize,
                           bool use_adamw);
 
+// The adam_optimizer_step_() of every parameter, in a single IR node. The
+// hyper parameters are device scalars, so changing them does not recompile.
+// With an `inv_scale`, the `grads` are AMP scaled: the node unscales them and
+// checks them for non finite values on the way, updating `found_inf` like
+// _amp_foreach_non_finite_check_and_unscale_() would, but leaves the `grads`
+// scaled.
+void multi_tensor_adam_optimizer_step_(
+    const XLATensorPtr& found_inf, absl::Span<XLATensorPtr> steps,
+    absl::Span<XLATensorPtr> params, absl::Span<const XLATensorPtr> grads,
+    absl::Span<XLATensorPtr> exp_avgs, absl::Span<XLATensorPtr> exp_avg_sqs,
+    absl::Span<XLATensorPtr> max_exp_avg_sqs, double beta1, double beta2,
+    double lr, double weight_decay, double eps, bool amsgrad, bool maximize,
+    bool use_adamw, const XLATensorPtr& inv_scale = nullptr);
+
+// The LAMB step of every parameter, in a single IR node.
+void lamb_optimizer_step_(
+    const XLATensorPtr& found_inf, absl::Span<XLATensorPtr> steps,
+    absl::Span<XLATensorPtr> params, absl::Span<const XLATensorPtr> grads,
+    absl::Span<XLATensorPtr> exp_avgs, absl::Span<XLATensorPtr> exp_avg_sqs,
+    double beta1, double beta2, double lr, double weight_decay, double eps,
+    bool maximize);
+
+// The Adafactor step of every parameter, in a single IR node. The
+// `col_vars` of the parameters of rank less than two are ignored, and their
+// `row_vars` hold their full variance.
+void adafactor_optimizer_step_(
+    const XLATensorPtr& found_inf, absl::Span<XLATensorPtr> steps,
+    absl::Span<XLATensorPtr> params, absl::Span<const XLATensorPtr> grads,
+    absl::Span<XLATensorPtr> row_vars, absl::Span<XLATensorPtr> col_vars,
+    double lr, double beta2_decay, double eps1, double eps2, double d,
+    double weight_decay, bool maximize);
+
+// The ZeRO-1 step of every parameter, in a single IR node: the full padded
+// `grads` are reduce-scattered with `scale` over the `shard_count` ranks of
+// the `groups`, the local `shards` of the parameters are updated with the
+// reduced gradient shards, clipped to a global norm of `max_norm` if set, and
+// all-gathered back. Returns the gathered padded parameters, in the types of
+// the `grads`, and the norm of the gradients, only with a `max_norm`.
+std::pair<std::vector<XLATensorPtr>, XLATensorPtr> zero_adam_optimizer_step_(
+    absl::Span<const XLATensorPtr> grads, absl::Span<XLATensorPtr> shards,
+    absl::Span<XLATensorPtr> steps, absl::Span<XLATensorPtr> exp_avgs,
+    absl::Span<XLATensorPtr> exp_avg_sqs, double beta1, double beta2,
+    double lr, double weight_decay, double eps, bool maximize, bool use_adamw,
+    double scale, int64_t shard_count,
+    std::vector<std::vector<int64_t>> groups, bool pin_layout,
+    std::optional<double> max_norm);
+
+std::pair<std::vector<XLATensorPtr>, XLATensorPtr> zero_sgd_optimizer_step_(
+    absl::Span<const XLATensorPtr> grads, absl::Span<XLATensorPtr> shards,
+    absl::Span<XLATensorPtr> steps, absl::Span<XLATensorPtr> momentum_buffers,
+    double weight_decay, double momentum, double lr, double dampening,
+    bool nesterov, bool maximize, double scale, int64_t shard_count,
+    std::vector<std::vector<int64_t>> groups, bool pin_layout,
+    std::optional<double> max_norm);
+
 absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> user_computation(
     const std::string& opname,
     absl::Span<const absl_nonnull XLATensorPtr> inputs,
     runtime::ComputationClient::ComputationPtr computation);
 
+// Scans `body` over the leading dimension of the xs `operands`. See the Scan
+// node for the arguments.
+absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> scan(
+    absl::Span<const absl_nonnull XLATensorPtr> operands,
+    runtime::ComputationClient::ComputationPtr body, int64_t num_carry,
+    int64_t num_xs, std::vector<int64_t> parameter_operands,
+    int64_t seed_operand, bool reverse);
+
 //////////////////////////////////////////////////////////////////////////////
 // Quantization related ops here.
 //////////////////////////////////////////////////////////////////////////////
@@ -159,6 +279,25 @@ XLATensorPtr dequantize_tensor(const XLATensorPtr& input,
 XLATensorPtr cast_int4(const XLATensorPtr& weight,
                        const std::vector<int>& int4_vals);
 
+// The product of `x` and the quantized weight `w`, see BuildQuantizedDot().
+// The output has the promoted type of `scale` and of `x`, or of `x_scale` for
+// an int8 `x`. The `x_scale` and the `zero_point` may be null.
+XLATensorPtr quantized_dot(const XLATensorPtr& x, const XLATensorPtr& w,
+                           const XLATensorPtr& scale,
+                           const XLATensorPtr& x_scale,
+                           const XLATensorPtr& zero_point, int64_t block_size);
+
+// The product of `lhs` and `rhs` in FP8 with delayed scaling, see
+// BuildFp8Dot(). The operands are cast to `lhs_type` and `rhs_type` with their
+// current scales, and the scales and the amax histories are updated in place,
+// as part of the same graph.
+XLATensorPtr fp8_dot(const XLATensorPtr& lhs, const XLATensorPtr& rhs,
+                     XLATensorPtr& lhs_scale, XLATensorPtr& rhs_scale,
+                     XLATensorPtr& lhs_amax_history,
+                     XLATensorPtr& rhs_amax_history, at::ScalarType lhs_type,
+                     at::ScalarType rhs_type, int64_t rhs_contracting_dim,
+                     int64_t margin);
+
 //////////////////////////////////////////////////////////////////////////////
 // Dynamic Reshape ops here.
 //////////////////////////////////////////////////////////////////////////////
@@ -240,6 +379,13 @@ XLATensorPtr addmm(const XLATensorPtr& input, const XLATensorPtr& weight,
 
 XLATensorPtr alias(const XLATensorPtr& input);
 
+// The sorted values and indices of the `k` approximate largest, or smallest,
+// elements of `input` in `dim`, found with a recall of `recall_target`.
+std::tuple<XLATensorPtr, XLATensorPtr> approx_topk(const XLATensorPtr& input,
+                                                   int64_t k, int64_t dim,
+                                                   bool largest,
+                                                   double recall_target);
+
 XLATensorPtr amax(const XLATensorPtr& input, std::vector<int64_t> dimensions,
                   bool keep_reduced_dimensions);
 
@@ -281,6 +427,14 @@ absl::StatusOr<absl_nonnull XLATensorPtr> baddbmm(const XLATensorPtr& input,
                                                   const at::Scalar& beta,
                                                   const at::Scalar& alpha);
 
+// Runs the per class NMS of `boxes` [B, N, 4], with the `scores` and the
+// `classes` [B, N], for every image at once. Returns the [B, max_output_size]
+// indices of the kept boxes, padded with -1, and the [B] numbers of kept boxes.
+std::tuple<XLATensorPtr, XLATensorPtr> batched_nms(
+    const XLATensorPtr& boxes, const XLATensorPtr& scores,
+    const XLATensorPtr& classes, double iou_threshold, double score_threshold,
+    int64_t max_output_size);
+
 XLATensorPtr bernoulli(const XLATensorPtr& input, double probability);
 XLATensorPtr bernoulli(const XLATensorPtr& input);
 void bernoulli_(XLATensorPtr& input, const XLATensorPtr& probability);
@@ -305,6 +459,17 @@ XLATensorPtr bitwise_xor(const XLATensorPtr& input, const XLATensorPtr& other);
 absl::StatusOr<absl_nonnull XLATensorPtr> bmm(const XLATensorPtr& input,
                                               const XLATensorPtr& mat2);
 
+// Like masked_select(), but returns the selected elements padded with zeros
+// to the number of elements of `input`, and their count, so that the size of
+// no tensor depends on the data.
+std::tuple<XLATensorPtr, XLATensorPtr> bounded_masked_select(
+    const XLATensorPtr& input, const XLATensorPtr& mask);
+
+// Like nonzero(), but returns the indices padded with zero rows to a row per
+// element of `input`, and their number of rows.
+std::tuple<XLATensorPtr, XLATensorPtr> bounded_nonzero(
+    const XLATensorPtr& input);
+
 // Broadcasts the given tensors according to broadcasting semantics.
 absl::StatusOr<std::vector<absl_nonnull XLATensorPtr>> broadcast_tensors(
     absl::Span<const absl_nonnull XLATensorPtr> tensors);
@@ -423,6 +588,25 @@ embedding_bag(const XLATensorPtr& weight, const XLATensorPtr& indices,
               const XLATensorPtr& offsets, int64_t mode,
               const XLATensorPtr& per_sample_weights, bool include_last_offset);
 
+// Returns the weight gradient of an embedding_bag of the sum or mean mode,
+// from the offset2bag and bag_size outputs of the forward. The
+// per_sample_weights may be null.
+XLATensorPtr embedding_bag_backward(const XLATensorPtr& grad,
+                                    const XLATensorPtr& indices,
+                                    const XLATensorPtr& offset2bag,
+                                    const XLATensorPtr& bag_size,
+                                    const XLATensorPtr& per_sample_weights,
+                                    int64_t num_weights, int64_t mode);
+
+// Like embedding_bag_backward, but returns the gradient as the unique indices
+// looked up, padded with num_weights, and their gradient rows, which are zero
+// for the padding.
+std::tuple<XLATensorPtr, XLATensorPtr> embedding_bag_sparse_backward(
+    const XLATensorPtr& grad, const XLATensorPtr& indices,
+    const XLATensorPtr& offset2bag, const XLATensorPtr& bag_size,
+    const XLATensorPtr& per_sample_weights, int64_t num_weights,
+    int64_t mode);
+
 XLATensorPtr embedding(const XLATensorPtr& weight, const XLATensorPtr& indices);
 
 XLATensorPtr eq(const XLATensorPtr& input, const at::Scalar& other);
@@ -699,6 +883,19 @@ std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> native_batch_norm_backward(
 std::tuple<XLATensorPtr, XLATensorPtr> native_dropout(
     const XLATensorPtr& input, double p, std::optional<bool> train);
 
+// Normalizes the last normalized_ndim dimensions of the input, and returns the
+// output with the mean and the reciprocal standard deviation of every row,
+// which are F32 for the half precision inputs.
+std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> native_layer_norm(
+    const XLATensorPtr& input, int64_t normalized_ndim,
+    const XLATensorPtr& weight, const XLATensorPtr& bias, double eps);
+
+// Returns the input, weight and bias gradients.
+std::tuple<XLATensorPtr, XLATensorPtr, XLATensorPtr> native_layer_norm_backward(
+    const XLATensorPtr& grad_out, const XLATensorPtr& input,
+    int64_t normalized_ndim, const XLATensorPtr& mean,
+    const XLATensorPtr& rstd, const XLATensorPtr& weight);
+
 XLATensorPtr ne(const XLATensorPtr& input, const at::Scalar& other);
 
 XLATensorPtr ne(const XLATensorPtr& input, const XLATensorPtr& other);
@@ -826,6 +1023,20 @@ XLATensorPtr replication_pad3d_backward(const XLATensorPtr& grad_output,
 
 void resize_(XLATensorPtr& input, std::vector<int64_t> size);
 
+// Like native_layer_norm, but divides by the root mean square of every row,
+// without centering it, and returns the output and the reciprocal root mean
+// square.
+std::tuple<XLATensorPtr, XLATensorPtr> rms_norm(const XLATensorPtr& input,
+                                                int64_t normalized_ndim,
+                                                const XLATensorPtr& weight,
+                                                double eps);
+
+// Returns the input and weight gradients.
+std::tuple<XLATensorPtr, XLATensorPtr> rms_norm_backward(
+    const XLATensorPtr& grad_out, const XLATensorPtr& input,
+    int64_t normalized_ndim, const XLATensorPtr& rstd,
+    const XLATensorPtr& weight);
+
 absl::StatusOr<absl_nonnull XLATensorPtr> roll(
     const absl_nonnull XLATensorPtr& input, absl::Span<const int64_t> shifts,
     absl::Span<const int64_t> dims);
@@ -850,6 +1061,12 @@ XLATensorPtr rsub(
 
 void copy_(XLATensorPtr& input, XLATensorPtr& src);
 
+// The token ids sampled from each row of the last dimension of `logits` at
+// `temperature`, among the `top_k` most likely ones, zero not bounding them,
+// and the smallest set of most likely ones whose probability reaches `top_p`.
+XLATensorPtr sample_tokens(const XLATensorPtr& logits, double temperature,
+                           int64_t top_k, double top_p);
+
 XLATensorPtr scatter(const XLATensorPtr& input, int64_t dim,
                      const XLATensorPtr& index, const XLATensorPtr& src);
 XLATensorPtr scatter(const XLATensorPtr& input, int64_t dim,
@@ -1,33 +1,47 @@
 #include "torch_xla/csrc/tensor_util.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <functional>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <thread>
 
 #include <ATen/Formatting.h>
 #include <ATen/Functions.h>
+#include <ATen/Parallel.h>
+#include <c10/core/CPUAllocator.h>
 #include <torch/csrc/lazy/core/hash.h>
+#include <torch/csrc/lazy/core/metrics.h>
 #include <torch/csrc/lazy/core/util.h>
 
 #include "absl/synchronization/blocking_counter.h"
 #include "tsl/platform/bfloat16.h"
+#include "xla/layout_util.h"
 #include "xla/literal_util.h"
 #include "xla/shape_util.h"
 
+#include "torch_xla/csrc/aten_fallback.h"
 #include "torch_xla/csrc/aten_xla_bridge.h"
 #include "torch_xla/csrc/dtype.h"
+#include "torch_xla/csrc/gil_util.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/layout_manager.h"
 #include "torch_xla/csrc/ops/device_data.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/host_buffer_pool.h"
 #include "torch_xla/csrc/runtime/runtime.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/tf_logging.h"
 #include "torch_xla/csrc/runtime/util.h"
+#include "torch_xla/csrc/scalar_pool.h"
+#include "torch_xla/csrc/simd_convert.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/thread_pool.h"
 #include "torch_xla/csrc/torch_util.h"
@@ -325,6 +339,93 @@ void CopyData<tsl::float8_e5m2, at::Float8_e5m2>(tsl::float8_e5m2* dest,
   CheckedMemcpy<tsl::float8_e5m2, at::Float8_e5m2>(dest, source, n);
 }
 
+// Converts with the vectorized kernel as many elements as it can, and the
+// rest one at a time.
+template <typename D, typename S, typename KD, typename KS>
+void VectorizedCopy(D* dest, const S* source, int64_t n,
+                    int64_t (*kernel)(const KS*, KD*, int64_t)) {
+  static_assert(sizeof(D) == sizeof(KD) && sizeof(S) == sizeof(KS),
+                "Types size mismatch");
+  int64_t converted = kernel(reinterpret_cast<const KS*>(source),
+                             reinterpret_cast<KD*>(dest), n);
+  StridedCopy(dest + converted, 1, source + converted, 1, n - converted);
+}
+
+template <>
+void CopyData<tsl::bfloat16, float>(tsl::bfloat16* dest, const float* source,
+                                    int64_t n, const CopyCasted&) {
+  VectorizedCopy(dest, source, n, simd_convert::F32ToBF16);
+}
+template <>
+void CopyData<float, tsl::bfloat16>(float* dest, const tsl::bfloat16* source,
+                                    int64_t n, const CopyCasted&) {
+  VectorizedCopy(dest, source, n, simd_convert::BF16ToF32);
+}
+template <>
+void CopyData<float, at::BFloat16>(float* dest, const at::BFloat16* source,
+                                   int64_t n, const CopyCasted&) {
+  VectorizedCopy(dest, source, n, simd_convert::BF16ToF32);
+}
+template <>
+void CopyData<xla::half, float>(xla::half* dest, const float* source,
+                                int64_t n, const CopyCasted&) {
+  VectorizedCopy(dest, source, n, simd_convert::F32ToF16);
+}
+template <>
+void CopyData<float, xla::half>(float* dest, const xla::half* source,
+                                int64_t n, const CopyCasted&) {
+  VectorizedCopy(dest, source, n, simd_convert::F16ToF32);
+}
+template <>
+void CopyData<float, at::Half>(float* dest, const at::Half* source, int64_t n,
+                               const CopyCasted&) {
+  VectorizedCopy(dest, source, n, simd_convert::F16ToF32);
+}
+template <>
+void CopyData<int32_t, int64_t>(int32_t* dest, const int64_t* source,
+                                int64_t n, const CopyDirect&) {
+  VectorizedCopy(dest, source, n, simd_convert::S64ToS32);
+}
+template <>
+void CopyData<int64_t, int32_t>(int64_t* dest, const int32_t* source,
+                                int64_t n, const CopyDirect&) {
+  VectorizedCopy(dest, source, n, simd_convert::S32ToS64);
+}
+
+// The 256 float8 values are looked up in a table of their float conversions.
+template <typename S>
+void CopyFloat8ToFloat(float* dest, const S* source, int64_t n) {
+  static_assert(sizeof(S) == sizeof(uint8_t), "Types size mismatch");
+  static const std::array<float, 256>* table = []() {
+    auto* table = new std::array<float, 256>();
+    Caster<S> caster;
+    for (size_t i = 0; i < table->size(); ++i) {
+      uint8_t bits = i;
+      S value;
+      std::memcpy(&value, &bits, sizeof(value));
+      (*table)[i] = caster.template cast<float>(value);
+    }
+    return table;
+  }();
+  const uint8_t* bits = reinterpret_cast<const uint8_t*>(source);
+  for (int64_t i = 0; i < n; ++i) {
+    dest[i] = (*table)[bits[i]];
+  }
+}
+
+template <>
+void CopyData<float, tsl::float8_e4m3fn>(float* dest,
+                                         const tsl::float8_e4m3fn* source,
+                                         int64_t n, const CopyCasted&) {
+  CopyFloat8ToFloat(dest, source, n);
+}
+template <>
+void CopyData<float, tsl::float8_e5m2>(float* dest,
+                                       const tsl::float8_e5m2* source,
+                                       int64_t n, const CopyCasted&) {
+  CopyFloat8ToFloat(dest, source, n);
+}
+
 std::vector<int64_t> GetIterationDimensions(const xla::Shape& shape) {
   // We want to favor the most minor dimension as core iteration dimension, as
   // this walks one of the two tensors buffers in a cache friendly fashion.
@@ -391,6 +492,72 @@ std::vector<CopyPartition> CreateCopyPartitions(
   return parts;
 }
 
+// Returns the number of elements of the chunks a same layout copy is split in,
+// which is num_elements if it is not worth splitting. The chunks are
+// multiples of 64 elements, so that whatever the element size, no two threads
+// write to the same cache line.
+int64_t GetContiguousCopyChunkElements(int64_t num_elements,
+                                       size_t element_size) {
+  // The minimum number of bytes copied by a thread.
+  static const int64_t kMinThreadBytes = 1 << 20;
+  static const int64_t kChunkAlignment = 64;
+  // Use at most 50% of the available cores, as for the sliced copies.
+  int64_t max_parts =
+      std::max<int64_t>(std::thread::hardware_concurrency() / 2, 1);
+  int64_t chunk_elements =
+      std::max<int64_t>(num_elements / max_parts,
+                        kMinThreadBytes / static_cast<int64_t>(element_size));
+  chunk_elements = (chunk_elements + kChunkAlignment - 1) / kChunkAlignment *
+                   kChunkAlignment;
+  return std::min(chunk_elements, num_elements);
+}
+
+// Runs fn(begin, end) over the chunks of [0, n) on the calling thread and on
+// the transfer pool. The calling thread takes chunks as well, and only waits
+// for the ones already running elsewhere, so that it never waits on the queue
+// of the pool, which it may be running on.
+void ParallelCopyChunks(int64_t n, int64_t chunk_elements,
+                        const std::function<void(int64_t, int64_t)>& fn) {
+  struct State {
+    const std::function<void(int64_t, int64_t)>* fn = nullptr;
+    int64_t n = 0;
+    int64_t chunk_elements = 0;
+    int64_t num_chunks = 0;
+    std::atomic<int64_t> next_chunk{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+    int64_t done_chunks = 0;
+  };
+  auto state = std::make_shared<State>();
+  state->fn = &fn;
+  state->n = n;
+  state->chunk_elements = chunk_elements;
+  state->num_chunks = (n + chunk_elements - 1) / chunk_elements;
+  auto run_chunks = [state]() {
+    int64_t done_chunks = 0;
+    for (int64_t chunk = state->next_chunk.fetch_add(1);
+         chunk < state->num_chunks; chunk = state->next_chunk.fetch_add(1)) {
+      int64_t begin = chunk * state->chunk_elements;
+      (*state->fn)(begin, std::min(begin + state->chunk_elements, state->n));
+      ++done_chunks;
+    }
+    if (done_chunks > 0) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->done_chunks += done_chunks;
+      if (state->done_chunks == state->num_chunks) {
+        state->cv.notify_all();
+      }
+    }
+  };
+  for (int64_t i = 1; i < state->num_chunks; ++i) {
+    thread::ScheduleTransfer(run_chunks);
+  }
+  run_chunks();
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->cv.wait(lock,
+                 [&]() { return state->done_chunks == state->num_chunks; });
+}
+
 template <typename SType, typename DType>
 void SlicedCopy(absl::Span<const int64_t> dimensions, const SType* src_data,
                 absl::Span<const int64_t> src_strides, DType* dest_data,
@@ -431,9 +598,18 @@ void CopyTensors(const void* src_buffer, const xla::Shape& src_shape,
   DType* dest_data = reinterpret_cast<DType*>(dest_buffer);
   if (src_shape.layout().minor_to_major() ==
       dest_shape.layout().minor_to_major()) {
-    CopyData<DType, SType>(dest_data, src_data, total_elements,
-                           typename CopyType < NeedCast<SType>::value ||
-                               NeedCast<DType>::value > ::type());
+    auto copy_fn = [&](int64_t begin, int64_t end) {
+      CopyData<DType, SType>(dest_data + begin, src_data + begin, end - begin,
+                             typename CopyType < NeedCast<SType>::value ||
+                                 NeedCast<DType>::value > ::type());
+    };
+    int64_t chunk_elements = GetContiguousCopyChunkElements(
+        total_elements, std::max(sizeof(SType), sizeof(DType)));
+    if (chunk_elements < total_elements) {
+      ParallelCopyChunks(total_elements, chunk_elements, copy_fn);
+    } else {
+      copy_fn(0, total_elements);
+    }
   } else if (total_elements > 0) {
     // We issue a multi-threaded copy by slicing the bigger dimension and
     // assigning its copy to different threads. This code is only valid for
@@ -450,7 +626,7 @@ void CopyTensors(const void* src_buffer, const xla::Shape& src_shape,
                                  dest_data, dest_strides, iter_dims, parts[i]);
         counter.DecrementCount();
       };
-      thread::Schedule(std::move(copy_fn));
+      thread::ScheduleTransfer(std::move(copy_fn));
     }
     counter.Wait();
   }
@@ -551,6 +727,7 @@ torch::lazy::BackendDataPtr TensorToXlaData(
     const at::Tensor& tensor, const xla::Shape& shape,
     const torch::lazy::BackendDevice& device) {
   TORCH_LAZY_TIMED("TensorToData");
+  FallbackPhaseTimer transfer_timer(FallbackPhase::kTransferToDevice);
 
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
                       runtime::GetComputationClient());
@@ -567,7 +744,7 @@ torch::lazy::BackendDataPtr TensorToXlaData(
 
   std::vector<std::shared_ptr<const runtime::TensorSource>> source_tensors;
   source_tensors.push_back(
-      std::make_shared<runtime::AtenSource>(tensor, shape, device.toString()));
+      CreateTensorSource(tensor, shape, device.toString()));
 
   auto handles = client->TransferToDevice(source_tensors);
   XLA_CHECK_EQ(handles.size(), 1);
@@ -575,7 +752,7 @@ torch::lazy::BackendDataPtr TensorToXlaData(
 }
 
 template <typename SType, typename DType>
-at::Tensor XlaLiteralToTensor(const xla::Literal& literal,
+at::Tensor XlaLiteralToTensor(const xla::LiteralBase& literal,
                               at::ScalarType atype) {
   std::vector<int64_t> dimensions =
       torch::lazy::ToVector<int64_t>(literal.shape().dimensions());
@@ -593,7 +770,7 @@ at::Tensor XlaLiteralToTensor(const xla::Literal& literal,
 }
 
 template <typename SType>
-at::Tensor XlaLiteralToTensorHelper(const xla::Literal& literal,
+at::Tensor XlaLiteralToTensorHelper(const xla::LiteralBase& literal,
                                     at::ScalarType dest_element_type) {
   switch (dest_element_type) {
     case at::ScalarType::Bool:
@@ -722,6 +899,23 @@ void PopulateTensorBuffer(const at::Tensor& tensor,
   }
 }
 
+std::shared_ptr<const runtime::TensorSource> CreateTensorSource(
+    const at::Tensor& tensor, xla::Shape shape, const std::string& device) {
+  std::shared_ptr<runtime::HostBufferPool> pool =
+      runtime::HostBufferPool::Get();
+  if (pool == nullptr || !tensor.device().is_cpu() || shape.is_dynamic()) {
+    return std::make_shared<runtime::AtenSource>(tensor, std::move(shape),
+                                                 device);
+  }
+  size_t size = xla::ShapeUtil::ByteSizeOf(shape);
+  std::unique_ptr<runtime::HostBufferPool::HostBuffer> buffer =
+      pool->Acquire(size);
+  PopulateTensorBuffer(tensor, shape, buffer->data(), size,
+                       ParseDeviceString(device));
+  return std::make_shared<runtime::HostBufferSource>(
+      std::move(buffer), std::move(shape), device);
+}
+
 std::vector<int64_t> ComputeShapeStrides(const xla::Shape& shape) {
   std::vector<int64_t> strides(shape.dimensions_size());
   int64_t stride = 1;
@@ -732,7 +926,7 @@ std::vector<int64_t> ComputeShapeStrides(const xla::Shape& shape) {
   return strides;
 }
 
-at::Tensor MakeTensorFromXlaLiteral(const xla::Literal& literal,
+at::Tensor MakeTensorFromXlaLiteral(const xla::LiteralBase& literal,
                                     at::ScalarType dest_element_type) {
   switch (literal.shape().element_type()) {
     case xla::PrimitiveType::PRED:
@@ -780,6 +974,68 @@ at::Tensor MakeTensorFromXlaLiteral(const xla::Literal& literal,
   }
 }
 
+namespace {
+
+// Whether a tensor of `dest_element_type` can take over the buffer of
+// `literal`, which already holds its data in the PyTorch element type and
+// layout.
+bool CanWrapLiteral(const xla::LiteralBase& literal,
+                    at::ScalarType dest_element_type) {
+  static const bool zero_copy =
+      runtime::sys_util::GetEnvBool("XLA_ZERO_COPY_READBACK", true);
+  const xla::Shape& shape = literal.shape();
+  return zero_copy && shape.IsArray() && !shape.is_dynamic() &&
+         literal.size_bytes() > 0 &&
+         XlaTypeFromTorchType(dest_element_type) == shape.element_type() &&
+         xla::LayoutUtil::IsMonotonicWithDim0Major(shape.layout());
+}
+
+// Returns a tensor whose storage is the buffer of `literal`, released with
+// the storage. The storage stays resizable: a resize copies the data to a
+// buffer of the CPU allocator and releases the literal.
+at::Tensor WrapLiteral(std::shared_ptr<const xla::LiteralBase> literal,
+                       at::ScalarType dest_element_type) {
+  TORCH_LAZY_COUNTER("ZeroCopyLiteralToTensor", 1);
+  std::vector<int64_t> dimensions =
+      torch::lazy::ToVector<int64_t>(literal->shape().dimensions());
+  size_t size_bytes = literal->size_bytes();
+  void* data = const_cast<void*>(literal->untyped_data());
+  auto* owner = new std::shared_ptr<const xla::LiteralBase>(std::move(literal));
+  c10::DataPtr data_ptr(
+      data, owner,
+      [](void* ctx) {
+        delete static_cast<std::shared_ptr<const xla::LiteralBase>*>(ctx);
+      },
+      c10::Device(c10::DeviceType::CPU));
+  c10::Storage storage(c10::Storage::use_byte_size_t(), size_bytes,
+                       std::move(data_ptr), c10::GetCPUAllocator(),
+                       /*resizable=*/true);
+  at::Tensor tensor =
+      at::empty({0}, at::TensorOptions(dest_element_type).device(at::kCPU));
+  tensor.set_(std::move(storage), /*storage_offset=*/0, dimensions);
+  return tensor;
+}
+
+}  // namespace
+
+at::Tensor MakeTensorFromXlaLiteral(xla::Literal&& literal,
+                                    at::ScalarType dest_element_type) {
+  if (!CanWrapLiteral(literal, dest_element_type)) {
+    return MakeTensorFromXlaLiteral(literal, dest_element_type);
+  }
+  return WrapLiteral(std::make_shared<xla::Literal>(std::move(literal)),
+                     dest_element_type);
+}
+
+at::Tensor MakeTensorFromXlaLiteral(
+    std::shared_ptr<const xla::LiteralBase> literal,
+    at::ScalarType dest_element_type) {
+  if (!CanWrapLiteral(*literal, dest_element_type)) {
+    return MakeTensorFromXlaLiteral(*literal, dest_element_type);
+  }
+  return WrapLiteral(std::move(literal), dest_element_type);
+}
+
 bool TensorCompare(const at::Tensor& t1, const at::Tensor& t2) {
   if (t1.scalar_type() != t2.scalar_type() || t1.sizes() != t2.sizes()) {
     return false;
@@ -809,6 +1065,8 @@ std::vector<torch::lazy::BackendDataPtr> CreateTensorsData(
     return {};
   }
 
+  FallbackPhaseTimer transfer_timer(FallbackPhase::kTransferToDevice);
+
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
                       runtime::GetComputationClient());
 
@@ -819,26 +1077,37 @@ std::vector<torch::lazy::BackendDataPtr> CreateTensorsData(
                     [&](const std::string& s) { return s == devices[0]; }))
         << "can't mix virtual device and real device.";
 
+    // Each tensor is converted once for all its replicas, and the tensors are
+    // spread over the intra-op thread pool, as below.
     std::vector<std::string> local_devices = client->GetLocalDevices();
-    std::vector<runtime::ComputationClient::DataPtr> handles;
-    for (size_t i = 0; i < tensors.size(); ++i) {
-      auto device = ParseDeviceString(devices[i]);
-      auto shape = CreateComputationShapeFromTensor(tensors[i], &device);
-      auto replicated_data =
-          std::vector<at::Tensor>(local_devices.size(), tensors[i]);
-      handles.push_back(ShardingUtil::CreateShardedData(
-          replicated_data, local_devices, nullptr));
-    }
+    std::vector<runtime::ComputationClient::DataPtr> handles(tensors.size());
+    auto create_replicated_data = [&](int64_t start, int64_t end) {
+      for (int64_t i = start; i < end; ++i) {
+        auto replicated_data =
+            std::vector<at::Tensor>(local_devices.size(), tensors[i]);
+        handles[i] = ShardingUtil::CreateShardedData(replicated_data,
+                                                     local_devices, nullptr);
+      }
+    };
+    at::parallel_for(0, tensors.size(), /*grain_size=*/1,
+                     create_replicated_data);
     return WrapXlaData(handles);
   }
 
-  std::vector<std::shared_ptr<const runtime::TensorSource>> source_tensors;
-  for (size_t i = 0; i < tensors.size(); ++i) {
-    torch::lazy::BackendDevice device = ParseDeviceString(devices[i]);
-    xla::Shape shape = CreateComputationShapeFromTensor(tensors[i], &device);
-    source_tensors.push_back(std::make_shared<runtime::AtenSource>(
-        tensors[i], std::move(shape), devices[i]));
-  }
+  // The sources hold the tensors converted to their device type and layout.
+  // The conversions are independent, so they are spread over the intra-op
+  // thread pool, where the copies nested in them run inline.
+  std::vector<std::shared_ptr<const runtime::TensorSource>> source_tensors(
+      tensors.size());
+  auto create_sources = [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; ++i) {
+      torch::lazy::BackendDevice device = ParseDeviceString(devices[i]);
+      xla::Shape shape = CreateComputationShapeFromTensor(tensors[i], &device);
+      source_tensors[i] =
+          CreateTensorSource(tensors[i], std::move(shape), devices[i]);
+    }
+  };
+  at::parallel_for(0, tensors.size(), /*grain_size=*/1, create_sources);
   return WrapXlaData(client->TransferToDevice(source_tensors));
 }
 
@@ -847,39 +1116,72 @@ std::vector<torch::lazy::BackendDataPtr> CreateTensorsData(
     const std::vector<XLATensor::ShardingSpecPtr>& shardings,
     const std::vector<std::string>& devices) {
   TORCH_LAZY_TIMED("TensorToData");
+  FallbackPhaseTimer transfer_timer(FallbackPhase::kTransferToDevice);
   XLA_CHECK_EQ(tensors.size(), shardings.size());
   XLA_CHECK_EQ(tensors.size(), devices.size());
 
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
                       runtime::GetComputationClient());
 
-  std::vector<runtime::ComputationClient::DataPtr> handles;
-  for (size_t i = 0; i < tensors.size(); ++i) {
-    torch::lazy::BackendDevice device = ParseDeviceString(devices[i]);
-    xla::Shape shape = CreateComputationShapeFromTensor(tensors[i], &device);
-
-    std::vector<std::shared_ptr<const runtime::TensorSource>>
-        source_tensors;                                            // in
-    std::vector<runtime::ComputationClient::DataPtr> new_handles;  // out
-    if (static_cast<XlaDeviceType>(device.type()) == XlaDeviceType::SPMD) {
+  // The sharded tensors are split, converted and transferred, and the others
+  // converted, in parallel over the intra-op thread pool. The unsharded ones
+  // are then transferred at once.
+  std::vector<runtime::ComputationClient::DataPtr> handles(tensors.size());
+  std::vector<std::shared_ptr<const runtime::TensorSource>> source_tensors(
+      tensors.size());
+  auto create_data = [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; ++i) {
+      torch::lazy::BackendDevice device = ParseDeviceString(devices[i]);
+      if (static_cast<XlaDeviceType>(device.type()) != XlaDeviceType::SPMD) {
+        xla::Shape shape =
+            CreateComputationShapeFromTensor(tensors[i], &device);
+        source_tensors[i] =
+            CreateTensorSource(tensors[i], std::move(shape), devices[i]);
+        continue;
+      }
       // GetLocalDevices returns the list of local devices specified by their
       // global ordinals (e.g. ["TPU:4", "TPU:5", "TPU:6", "TPU:7"]).
-
       std::vector<std::string> local_devices = client->GetLocalDevices();
+      const at::Tensor& tensor = tensors[i];
+      if (shardings[i] != nullptr &&
+          shardings[i]->sharding.type() == xla::OpSharding::OTHER &&
+          tensor.device().is_cpu() && tensor.layout() == at::kStrided &&
+          !tensor.is_conj() && !tensor.is_neg()) {
+        // The tiles are read by the transfers straight out of the tensor.
+        std::vector<std::shared_ptr<const runtime::TensorSource>> sources =
+            ShardingUtil::CreateShardSources(tensor, shardings[i],
+                                             local_devices);
+        handles[i] = client->TransferShardsToDevice(
+            sources, GetVirtualDevice().toString(), shardings[i]->shape,
+            shardings[i]->sharding);
+        continue;
+      }
       // Shards the input tensors with padding, to split evenly.
       // The execution requires consistent shard sizes, and the zero-padded
       // values should be ignored.
       std::vector<at::Tensor> local_shards =
           ShardingUtil::ShardTensor(tensors[i], shardings[i], local_devices,
                                     /*padded=*/true);
-      new_handles.push_back(ShardingUtil::CreateShardedData(
-          local_shards, local_devices, shardings[i]));
-    } else {
-      source_tensors.push_back(std::make_shared<runtime::AtenSource>(
-          tensors[i], std::move(shape), devices[i]));
-      new_handles = client->TransferToDevice(source_tensors);
+      handles[i] = ShardingUtil::CreateShardedData(local_shards, local_devices,
+                                                   shardings[i]);
+    }
+  };
+  at::parallel_for(0, tensors.size(), /*grain_size=*/1, create_data);
+
+  std::vector<std::shared_ptr<const runtime::TensorSource>> unsharded_sources;
+  std::vector<size_t> unsharded_indices;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    if (source_tensors[i] != nullptr) {
+      unsharded_sources.push_back(std::move(source_tensors[i]));
+      unsharded_indices.push_back(i);
+    }
+  }
+  if (!unsharded_sources.empty()) {
+    std::vector<runtime::ComputationClient::DataPtr> unsharded_handles =
+        client->TransferToDevice(unsharded_sources);
+    for (size_t j = 0; j < unsharded_indices.size(); ++j) {
+      handles[unsharded_indices[j]] = std::move(unsharded_handles[j]);
     }
-    handles.insert(handles.end(), new_handles.begin(), new_handles.end());
   }
   return WrapXlaData(handles);
 }
@@ -901,83 +1203,156 @@ xla::Literal GetTensorLiteral(const at::Tensor& tensor, const xla::Shape* shape,
   return literal;
 }
 
-absl::StatusOr<std::vector<xla::Literal>> ReleaseGilAndTransferData(
-    absl::Span<const torch::lazy::BackendDataPtr> xla_data) {
-  // HACK: This method may be called outside of python (mainly in C++ tests) or
-  // when the GIL is already released, so we must check both cases here. If
-  // possible, prefer to release the GIL in the python bindings before copying
-  // this pattern.
-  PyThreadState* save = nullptr;
+namespace {
+
+bool ReleaseGilDuringTransfer() {
   // TODO(wcromar): Remove this setting when we are more confident
   static const bool release_gil =
       runtime::sys_util::GetEnvBool("XLA_RELEASE_GIL_DURING_TRANSFER", true);
-  if (release_gil && Py_IsInitialized() && PyGILState_Check()) {
-    save = PyEval_SaveThread();
-  }
+  return release_gil;
+}
+
+}  // namespace
 
+absl::StatusOr<std::vector<xla::Literal>> ReleaseGilAndTransferData(
+    absl::Span<const torch::lazy::BackendDataPtr> xla_data) {
+  ScopedGilRelease gil_release(ReleaseGilDuringTransfer());
+  ScalarPool::Get()->Flush();
   XLA_ASSIGN_OR_RETURN(runtime::ComputationClient * absl_nonnull const client,
                        runtime::GetComputationClient());
-  XLA_ASSIGN_OR_RETURN(std::vector<xla::Literal> literals,
-                       client->TransferFromDevice(UnwrapXlaData(xla_data)));
+  return client->TransferFromDevice(UnwrapXlaData(xla_data));
+}
 
-  if (save) {
-    PyEval_RestoreThread(save);
-  }
+absl::StatusOr<std::vector<std::shared_ptr<const xla::LiteralBase>>>
+ReleaseGilAndTransferDataToHostPool(
+    absl::Span<const torch::lazy::BackendDataPtr> xla_data) {
+  ScopedGilRelease gil_release(ReleaseGilDuringTransfer());
+  ScalarPool::Get()->Flush();
+  XLA_ASSIGN_OR_RETURN(runtime::ComputationClient * absl_nonnull const client,
+                       runtime::GetComputationClient());
+  return client->TransferFromDeviceToHostPool(UnwrapXlaData(xla_data));
+}
 
-  return literals;
+void ReleaseGilAndTransferDataStreaming(
+    absl::Span<const torch::lazy::BackendDataPtr> xla_data,
+    const runtime::ComputationClient::LiteralCallback& on_ready) {
+  ScopedGilRelease gil_release(ReleaseGilDuringTransfer());
+  ScalarPool::Get()->Flush();
+  const absl::StatusOr<runtime::ComputationClient * absl_nonnull>& client =
+      runtime::GetComputationClient();
+  if (!client.ok()) {
+    for (size_t i = 0; i < xla_data.size(); ++i) {
+      on_ready(i, client.status());
+    }
+    return;
+  }
+  (*client)->TransferFromDeviceStreaming(UnwrapXlaData(xla_data), on_ready);
 }
 
 absl::StatusOr<std::vector<at::Tensor>> XlaDataToTensors(
     absl::Span<const torch::lazy::BackendDataPtr> xla_data,
     absl::Span<const at::ScalarType> dest_element_type) {
-  XLA_ASSIGN_OR_RETURN(std::vector<xla::Literal> literals,
-                       ReleaseGilAndTransferData(xla_data));
-  std::vector<at::Tensor> tensors(literals.size());
-  absl::BlockingCounter counter(literals.size());
-  for (size_t i = 0; i < tensors.size(); ++i) {
-    auto copy_fn = [&, i]() {
-      tensors[i] = MakeTensorFromXlaLiteral(literals[i], dest_element_type[i]);
-      counter.DecrementCount();
-    };
-    thread::Schedule(std::move(copy_fn));
-  }
+  std::vector<at::Tensor> tensors(xla_data.size());
+  absl::BlockingCounter counter(xla_data.size());
+  std::mutex status_lock;
+  absl::Status status;
+  ReleaseGilAndTransferDataStreaming(
+      xla_data,
+      [&](size_t i,
+          absl::StatusOr<std::shared_ptr<const xla::LiteralBase>> literal) {
+        if (!literal.ok()) {
+          std::lock_guard<std::mutex> lock(status_lock);
+          status.Update(literal.status());
+          counter.DecrementCount();
+          return;
+        }
+        auto copy_fn = [&, i, literal = std::move(*literal)]() mutable {
+          // The literal, and the pooled buffer behind it, are released once
+          // converted, unless the tensor takes the buffer over.
+          tensors[i] = MakeTensorFromXlaLiteral(std::move(literal),
+                                                dest_element_type[i]);
+          counter.DecrementCount();
+        };
+        thread::ScheduleTransfer(std::move(copy_fn));
+      });
   counter.Wait();
+  XLA_RETURN_IF_ERROR(status);
   return tensors;
 }
 
 torch::lazy::hash_t TensorHash(const at::Tensor& tensor) {
-  at::Tensor ctensor = tensor.contiguous();
-  int64_t size = ctensor.numel() * ctensor.element_size();
-  switch (ctensor.scalar_type()) {
+  switch (tensor.scalar_type()) {
     case at::ScalarType::Bool:
-      return torch::lazy::DataHash(ctensor.data_ptr<bool>(), size);
     case at::ScalarType::Byte:
-      return torch::lazy::DataHash(ctensor.data_ptr<uint8_t>(), size);
     case at::ScalarType::Char:
-      return torch::lazy::DataHash(ctensor.data_ptr<int8_t>(), size);
     case at::ScalarType::Short:
-      return torch::lazy::DataHash(ctensor.data_ptr<int16_t>(), size);
     case at::ScalarType::Int:
-      return torch::lazy::DataHash(ctensor.data_ptr<int32_t>(), size);
     case at::ScalarType::Long:
-      return torch::lazy::DataHash(ctensor.data_ptr<int64_t>(), size);
     case at::ScalarType::Float:
-      return torch::lazy::DataHash(ctensor.data_ptr<float>(), size);
     case at::ScalarType::Double:
-      return torch::lazy::DataHash(ctensor.data_ptr<double>(), size);
     case at::ScalarType::BFloat16:
-      return torch::lazy::DataHash(ctensor.data_ptr<at::BFloat16>(), size);
     case at::ScalarType::Half:
-      return torch::lazy::DataHash(ctensor.data_ptr<at::Half>(), size);
     case at::ScalarType::ComplexFloat:
-      return torch::lazy::DataHash(ctensor.data_ptr<c10::complex<float>>(),
-                                   size);
     case at::ScalarType::ComplexDouble:
-      return torch::lazy::DataHash(ctensor.data_ptr<c10::complex<double>>(),
-                                   size);
+      break;
     default:
-      XLA_ERROR() << "Unsupported scalar type: " << ctensor.scalar_type();
+      XLA_ERROR() << "Unsupported scalar type: " << tensor.scalar_type();
   }
+  at::Tensor ctensor = tensor.contiguous();
+  return ContentHash(ctensor.data_ptr(),
+                     ctensor.numel() * ctensor.element_size());
+}
+
+namespace {
+
+// The number of packed bytes per task of PackInt4() and UnpackInt4().
+constexpr int64_t kInt4GrainSize = 1 << 16;
+
+}  // namespace
+
+at::Tensor PackInt4(const at::Tensor& tensor) {
+  XLA_CHECK(tensor.device().is_cpu()) << tensor.device();
+  XLA_CHECK_EQ(tensor.scalar_type(), at::ScalarType::Char);
+  XLA_CHECK_GT(tensor.dim(), 0);
+  XLA_CHECK_EQ(tensor.size(-1) % 2, 0) << tensor.sizes();
+  at::Tensor ctensor = tensor.contiguous();
+  std::vector<int64_t> sizes = ctensor.sizes().vec();
+  sizes.back() /= 2;
+  at::Tensor packed = at::empty(sizes, at::TensorOptions(at::kByte));
+  const int8_t* src = ctensor.data_ptr<int8_t>();
+  uint8_t* dest = packed.data_ptr<uint8_t>();
+  at::parallel_for(
+      0, packed.numel(), kInt4GrainSize, [&](int64_t begin, int64_t end) {
+        int64_t i = begin + simd_convert::PackInt4(src + 2 * begin,
+                                                   dest + begin, end - begin);
+        for (; i < end; ++i) {
+          dest[i] = (src[2 * i] & 0xf) | ((src[2 * i + 1] & 0xf) << 4);
+        }
+      });
+  return packed;
+}
+
+at::Tensor UnpackInt4(const at::Tensor& packed) {
+  XLA_CHECK(packed.device().is_cpu()) << packed.device();
+  XLA_CHECK_EQ(packed.scalar_type(), at::ScalarType::Byte);
+  XLA_CHECK_GT(packed.dim(), 0);
+  at::Tensor cpacked = packed.contiguous();
+  std::vector<int64_t> sizes = cpacked.sizes().vec();
+  sizes.back() *= 2;
+  at::Tensor tensor = at::empty(sizes, at::TensorOptions(at::kChar));
+  const uint8_t* src = cpacked.data_ptr<uint8_t>();
+  int8_t* dest = tensor.data_ptr<int8_t>();
+  at::parallel_for(
+      0, cpacked.numel(), kInt4GrainSize, [&](int64_t begin, int64_t end) {
+        int64_t i = begin + simd_convert::UnpackInt4(src + begin,
+                                                     dest + 2 * begin,
+                                                     end - begin);
+        for (; i < end; ++i) {
+          dest[2 * i] = ((src[i] & 0xf) ^ 8) - 8;
+          dest[2 * i + 1] = ((src[i] >> 4) ^ 8) - 8;
+        }
+      });
+  return tensor;
 }
 
 std::vector<xla::Shape> GetComponentShapes(const xla::Shape& shape) {
@@ -1,6 +1,7 @@
 #ifndef XLA_TORCH_XLA_CSRC_TENSOR_UTIL_H_
 #define XLA_TORCH_XLA_CSRC_TENSOR_UTIL_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -15,6 +16,7 @@
 
 #include "torch_xla/csrc/device.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
+#include "torch_xla/csrc/runtime/tensor_source.h"
 #include "torch_xla/csrc/tensor.h"
 #include "torch_xla/csrc/unwrap_data.h"
 
@@ -23,15 +25,38 @@ namespace torch_xla {
 std::vector<int64_t> ComputeShapeStrides(const xla::Shape& shape);
 
 // Converts an XLA literal to an at::Tensor of the given element type.
-at::Tensor MakeTensorFromXlaLiteral(const xla::Literal& literal,
+at::Tensor MakeTensorFromXlaLiteral(const xla::LiteralBase& literal,
                                     at::ScalarType dest_element_type);
 
+// Same as above, but the tensor takes over the literal buffer, without a copy,
+// when the literal has the element type and the row-major layout of the
+// tensor.
+at::Tensor MakeTensorFromXlaLiteral(xla::Literal&& literal,
+                                    at::ScalarType dest_element_type);
+at::Tensor MakeTensorFromXlaLiteral(
+    std::shared_ptr<const xla::LiteralBase> literal,
+    at::ScalarType dest_element_type);
+
 // Execution and data transfer are async in PJRT, so TransferFromDevice may
 // block until `DataPtr`s are ready. Release the GIL so other threads can
 // proceed and unblock any transfers or collective computations.
 absl::StatusOr<std::vector<xla::Literal>> ReleaseGilAndTransferData(
     absl::Span<const torch::lazy::BackendDataPtr> xla_data);
 
+// Same as above, but the data is read into buffers of the host buffer pool,
+// which go back to the pool when the literals are destroyed.
+absl::StatusOr<std::vector<std::shared_ptr<const xla::LiteralBase>>>
+ReleaseGilAndTransferDataToHostPool(
+    absl::Span<const torch::lazy::BackendDataPtr> xla_data);
+
+// Same as above, but calls `on_ready` for each value as soon as it lands, as
+// ComputationClient::TransferFromDeviceStreaming() does.
+void ReleaseGilAndTransferDataStreaming(
+    absl::Span<const torch::lazy::BackendDataPtr> xla_data,
+    const runtime::ComputationClient::LiteralCallback& on_ready);
+
+// Each value is converted on the transfer pool as soon as it lands, while the
+// others are still in flight.
 // TODO LTC @wonjoo - Migrate to upstream after Device -> BackendDevice
 absl::StatusOr<std::vector<at::Tensor>> XlaDataToTensors(
     absl::Span<const torch::lazy::BackendDataPtr> xla_data,
@@ -47,6 +72,15 @@ torch::lazy::BackendDataPtr TensorToXlaData(
 
 torch::lazy::hash_t TensorHash(const at::Tensor& tensor);
 
+// Packs the int4 values, int8 in [-8, 7], of the CPU tensor `tensor` two per
+// byte along its last dimension, which must be even: the even elements in the
+// low nibbles. Returns a uint8 tensor.
+at::Tensor PackInt4(const at::Tensor& tensor);
+
+// Reverses PackInt4(): returns the int8 tensor of the sign extended nibbles
+// of the uint8 CPU tensor `packed`, twice as large along the last dimension.
+at::Tensor UnpackInt4(const at::Tensor& packed);
+
 // Retrieves the device data handles by parallel uploading data onto the
 // corresponding devices.
 // TODO LTC @wonjoo - Migrate to upstream after Device -> BackendDevice
@@ -82,6 +116,12 @@ void PopulateTensorBuffer(const at::Tensor& tensor,
                           size_t dest_buffer_size,
                           const torch::lazy::BackendDevice& device);
 
+// Create the source of a host to device transfer of the tensor's data. When the
+// host buffer pool is enabled, the data is converted straight into a pooled
+// staging buffer, instead of a new contiguous CPU tensor.
+std::shared_ptr<const runtime::TensorSource> CreateTensorSource(
+    const at::Tensor& tensor, xla::Shape shape, const std::string& device);
+
 // Create the XLA shape to be used within a lowered XLA computation, to
 // represent a given tensor data.
 xla::Shape CreateComputationShapeFromTensor(
@@ -1,21 +1,102 @@
 #include "torch_xla/csrc/thread_pool.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <functional>
+#include <string>
+#include <thread>
+
+#include <torch/csrc/lazy/core/metrics.h>
 
 #include "tsl/platform/env.h"
+#include "tsl/platform/numa.h"
 #include "tsl/platform/threadpool.h"
 
 #include "torch_xla/csrc/runtime/sys_util.h"
 
 namespace torch_xla {
 namespace thread {
+namespace {
+
+// A thread pool reporting its queue depth and the time closures wait before
+// starting, as the <name>ThreadPoolQueueDepth and <name>ThreadPoolWaitTime
+// metrics.
+class Pool {
+ public:
+  Pool(const std::string& name, const std::string& thread_name,
+       int num_threads)
+      : queue_depth_metric_(name + "ThreadPoolQueueDepth"),
+        wait_time_metric_(name + "ThreadPoolWaitTime",
+                          torch::lazy::MetricFnTime),
+        pool_(tsl::Env::Default(), GetThreadOptions(), thread_name,
+              std::max(num_threads, 1)) {}
+
+  void Schedule(std::function<void()> fn) {
+    queue_depth_metric_.AddSample(queued_.fetch_add(1) + 1);
+    auto start = std::chrono::steady_clock::now();
+    pool_.Schedule([this, start, fn = std::move(fn)]() {
+      queued_.fetch_sub(1);
+      wait_time_metric_.AddSample(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+      fn();
+    });
+  }
+
+ private:
+  static tsl::ThreadOptions GetThreadOptions() {
+    tsl::ThreadOptions options;
+    options.numa_node = runtime::sys_util::GetEnvInt(
+        "XLA_THREAD_POOL_NUMA_NODE", tsl::port::kNUMANoAffinity);
+    return options;
+  }
+
+  std::atomic<int64_t> queued_{0};
+  torch::lazy::Metric queue_depth_metric_;
+  torch::lazy::Metric wait_time_metric_;
+  tsl::thread::ThreadPool pool_;
+};
+
+}  // namespace
 
 void Schedule(std::function<void()> fn) {
-  static size_t num_threads = torch_xla::runtime::sys_util::GetEnvInt(
-      "XLA_THREAD_POOL_SIZE", std::thread::hardware_concurrency());
-  static tsl::thread::ThreadPool pool(tsl::Env::Default(), "pytorchxla",
-                                      num_threads);
-  pool.Schedule(std::move(fn));
+  static Pool* pool = new Pool(
+      "Execution", "pytorchxla",
+      runtime::sys_util::GetEnvInt("XLA_THREAD_POOL_SIZE",
+                                   std::thread::hardware_concurrency()));
+  pool->Schedule(std::move(fn));
+}
+
+void ScheduleCompile(std::function<void()> fn) {
+  static Pool* pool = new Pool(
+      "Compile", "pytorchxla_compile",
+      runtime::sys_util::GetEnvInt("XLA_COMPILE_THREAD_POOL_SIZE", 4));
+  pool->Schedule(std::move(fn));
+}
+
+void ScheduleTransfer(std::function<void()> fn) {
+  static Pool* pool = new Pool(
+      "Transfer", "pytorchxla_transfer",
+      runtime::sys_util::GetEnvInt("XLA_TRANSFER_THREAD_POOL_SIZE",
+                                   std::thread::hardware_concurrency()));
+  pool->Schedule(std::move(fn));
+}
+
+void ScheduleIo(std::function<void()> fn) {
+  static Pool* pool = new Pool(
+      "Io", "pytorchxla_io",
+      runtime::sys_util::GetEnvInt("XLA_IO_THREAD_POOL_SIZE", 2));
+  pool->Schedule(std::move(fn));
+}
+
+void ScheduleLowering(std::function<void()> fn) {
+  static Pool* pool = new Pool(
+      "Lowering", "pytorchxla_lowering",
+      runtime::sys_util::GetEnvInt("XLA_PARALLEL_LOWERING_THREADS", 1));
+  pool->Schedule(std::move(fn));
 }
 
 }  // namespace thread
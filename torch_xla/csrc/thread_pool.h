@@ -10,6 +10,24 @@ namespace thread {
 // events.
 void Schedule(std::function<void()> fn);
 
+// Schedules a closure to be run on the dedicated compilation thread pool.
+// Compilations are long running, so they are kept away from the pool used by
+// Schedule() to avoid starving the asynchronous graph executions.
+void ScheduleCompile(std::function<void()> fn);
+
+// Schedules a closure to be run on the dedicated host data transfer and
+// conversion thread pool.
+void ScheduleTransfer(std::function<void()> fn);
+
+// Schedules a closure to be run on the dedicated pool for background file and
+// network I/O, like persistent cache reads.
+void ScheduleIo(std::function<void()> fn);
+
+// Schedules a closure to be run on the dedicated pool lowering the independent
+// sub-graphs of a graph, sized by $XLA_PARALLEL_LOWERING_THREADS. The graphs
+// are lowered from the compile pool, so the lowering needs a pool of its own.
+void ScheduleLowering(std::function<void()> fn);
+
 }  // namespace thread
 }  // namespace torch_xla
 
@@ -1,9 +1,15 @@
 #include "torch_xla/csrc/torch_util.h"
 
+#include <algorithm>
+#include <vector>
+
+#include <ATen/Parallel.h>
+
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/ir_builder.h"
 #include "torch_xla/csrc/ops/constant.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/xla_util.h"
 #include "torch_xla/csrc/tensor.h"
 
@@ -64,6 +70,30 @@ at::Tensor UnwrapNumber(const at::Tensor& tensor, at::ScalarType dtype) {
                                                            : tensor;
 }
 
+torch::lazy::hash_t ContentHash(const void* data, size_t size) {
+  // Part of the graph hashes, so changing it invalidates the persistent
+  // compilation caches.
+  constexpr size_t chunk_size = 1 << 20;
+  if (size <= chunk_size) {
+    return torch::lazy::DataHash(data, size);
+  }
+  const char* bytes = static_cast<const char*>(data);
+  int64_t num_chunks = (size + chunk_size - 1) / chunk_size;
+  std::vector<torch::lazy::hash_t> chunk_hashes(num_chunks);
+  at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      size_t offset = i * chunk_size;
+      chunk_hashes[i] = torch::lazy::DataHash(
+          bytes + offset, std::min(chunk_size, size - offset));
+    }
+  });
+  torch::lazy::hash_t hash = torch::lazy::Hash(static_cast<uint64_t>(size));
+  for (const torch::lazy::hash_t& chunk_hash : chunk_hashes) {
+    hash = torch::lazy::HashCombine(hash, chunk_hash);
+  }
+  return hash;
+}
+
 at::Tensor MaybeWrapTensorToFunctional(const at::Tensor& tensor) {
   bool disable_functionalization =
       runtime::sys_util::GetEnvBool("XLA_DISABLE_FUNCTIONALIZATION", false);
@@ -64,6 +64,11 @@ at::Scalar MakeFloatScalar(T value) {
 // Unwraps tensor to target dtype if it's a wrapped number.
 at::Tensor UnwrapNumber(const at::Tensor& tensor, at::ScalarType dtype);
 
+// Hashes `size` bytes of `data`. Buffers larger than a chunk are hashed a
+// chunk at a time, in parallel, and the chunk hashes are combined in order, so
+// the result does not depend on the number of threads.
+torch::lazy::hash_t ContentHash(const void* data, size_t size);
+
 // Wraps tensor to functional tensor if XLA_DISABLE_FUNCTIONALIZATION is false
 // or not set. For unwrapping, `torch::lazy::maybe_unwrap_functional()` will
 // only unwrap tensors that are functional. So, nothing needs to be done there.
@@ -0,0 +1,152 @@
+#include "torch_xla/csrc/trace_profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "torch_xla/csrc/runtime/metrics.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
+
+namespace torch_xla {
+namespace trace_profiler {
+namespace {
+
+constexpr size_t kNumCategories = 4;
+
+struct Stats {
+  int64_t count = 0;
+  int64_t total_ns = 0;
+  int64_t max_ns = 0;
+  int64_t instructions = 0;
+
+  void Add(const Stats& other) {
+    count += other.count;
+    total_ns += other.total_ns;
+    max_ns = std::max(max_ns, other.max_ns);
+    instructions += other.instructions;
+  }
+};
+
+using StatsMap =
+    std::array<std::unordered_map<c10::Symbol, Stats>, kNumCategories>;
+
+std::mutex stats_mutex;
+StatsMap* current_stats = new StatsMap();
+StatsMap* last_step_stats = new StatsMap();
+StatsMap* total_stats = new StatsMap();
+
+// The number of kAtenOp timers alive on this thread.
+thread_local int aten_op_depth = 0;
+
+}  // namespace
+
+bool Enabled() {
+  static const bool enabled =
+      runtime::sys_util::GetEnvBool("XLA_TRACE_PROFILER", false);
+  return enabled;
+}
+
+void Record(Category category, c10::Symbol op, int64_t duration_ns,
+            int64_t instructions) {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  (*current_stats)[static_cast<size_t>(category)][op].Add(
+      {1, duration_ns, duration_ns, instructions});
+}
+
+void MarkStep() {
+  if (!Enabled()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  for (size_t i = 0; i < kNumCategories; ++i) {
+    for (const auto& op_stats : (*current_stats)[i]) {
+      (*total_stats)[i][op_stats.first].Add(op_stats.second);
+    }
+  }
+  std::swap(current_stats, last_step_stats);
+  for (auto& stats : *current_stats) {
+    stats.clear();
+  }
+}
+
+std::vector<OpStats> GetStats(bool total) {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  const StatsMap& stats_map = total ? *total_stats : *last_step_stats;
+  std::vector<OpStats> result;
+  for (size_t i = 0; i < kNumCategories; ++i) {
+    for (const auto& op_stats : stats_map[i]) {
+      const Stats& stats = op_stats.second;
+      result.push_back({static_cast<Category>(i), op_stats.first, stats.count,
+                        stats.total_ns, stats.max_ns, stats.instructions});
+    }
+  }
+  std::sort(result.begin(), result.end(),
+            [](const OpStats& a, const OpStats& b) {
+              return a.total_ns > b.total_ns;
+            });
+  return result;
+}
+
+std::string CreateLoweringReport() {
+  if (!Enabled()) {
+    return "";
+  }
+  std::unordered_map<c10::Symbol, Stats> lowering_stats;
+  {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    // The graphs lowered since the last step are not in the totals yet.
+    for (const StatsMap* stats_map : {total_stats, current_stats}) {
+      for (const auto& op_stats :
+           (*stats_map)[static_cast<size_t>(Category::kLowering)]) {
+        lowering_stats[op_stats.first].Add(op_stats.second);
+      }
+    }
+  }
+  std::vector<std::pair<c10::Symbol, Stats>> sorted_stats(
+      lowering_stats.begin(), lowering_stats.end());
+  std::sort(sorted_stats.begin(), sorted_stats.end(),
+            [](const auto& a, const auto& b) {
+              return a.second.total_ns > b.second.total_ns;
+            });
+  std::stringstream ss;
+  for (const auto& [op, stats] : sorted_stats) {
+    ss << "Lowering: " << op.toQualString() << std::endl;
+    ss << "  Count: " << stats.count << std::endl;
+    ss << "  TotalTime: " << runtime::metrics::MetricFnTime(stats.total_ns)
+       << std::endl;
+    ss << "  MaxTime: " << runtime::metrics::MetricFnTime(stats.max_ns)
+       << std::endl;
+    ss << "  Instructions: " << stats.instructions << std::endl;
+  }
+  return ss.str();
+}
+
+ScopedTimer::ScopedTimer(Category category, c10::Symbol op)
+    : category_(category), op_(op) {
+  if (!Enabled()) {
+    return;
+  }
+  if (category_ == Category::kAtenOp && aten_op_depth++ > 0) {
+    return;
+  }
+  start_ns_ = runtime::sys_util::NowNs();
+}
+
+ScopedTimer::~ScopedTimer() {
+  if (!Enabled()) {
+    return;
+  }
+  if (category_ == Category::kAtenOp) {
+    --aten_op_depth;
+  }
+  if (start_ns_ != 0) {
+    Record(category_, op_, runtime::sys_util::NowNs() - start_ns_);
+  }
+}
+
+}  // namespace trace_profiler
+}  // namespace torch_xla
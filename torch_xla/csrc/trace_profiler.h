@@ -0,0 +1,86 @@
+#ifndef XLA_TORCH_XLA_CSRC_TRACE_PROFILER_H_
+#define XLA_TORCH_XLA_CSRC_TRACE_PROFILER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <ATen/core/interned_strings.h>
+
+namespace torch_xla {
+namespace trace_profiler {
+
+// The trace profiler attributes the host time spent tracing to ATen ops and
+// IR op kinds, per step, when $XLA_TRACE_PROFILER is set. It tells which ops
+// make a step host bound, and so which ones are worth caching. The lowering of
+// the IR nodes into HLO is attributed to their op kinds too, with the number
+// of instructions they emit.
+
+enum class Category {
+  // An XLANativeFunctions entry point, from the dispatch to the lowering into
+  // IR, including the IR nodes it creates. Nested calls are accounted to the
+  // outermost one.
+  kAtenOp,
+  // The construction of an IR node, its hashing and its metadata, without
+  // the shape inference.
+  kNodeCreation,
+  // The shape inference of an IR node, including the shape cache lookup.
+  kShapeInference,
+  // The lowering of an IR node into HLO, by LoweringContext::LowerNode().
+  kLowering,
+};
+
+struct OpStats {
+  Category category;
+  c10::Symbol op;
+  int64_t count = 0;
+  int64_t total_ns = 0;
+  int64_t max_ns = 0;
+  // The number of HLO instructions emitted, for kLowering.
+  int64_t instructions = 0;
+};
+
+// Whether the times are recorded.
+bool Enabled();
+
+// Accounts `duration_ns`, and the `instructions` it emitted, to `op` in
+// `category`, for the current step.
+void Record(Category category, c10::Symbol op, int64_t duration_ns,
+            int64_t instructions = 0);
+
+// Closes the current step.
+void MarkStep();
+
+// Returns the stats of the last closed step, or of all of them if `total` is
+// true.
+std::vector<OpStats> GetStats(bool total);
+
+// Returns the Lowering section of the metrics report, with the lowering stats
+// of every op kind over all the steps, or an empty string if there are none.
+std::string CreateLoweringReport();
+
+// Records the time of `op` in `category` for the lifetime of the object.
+class ScopedTimer {
+ public:
+  ScopedTimer(Category category, c10::Symbol op);
+
+  ~ScopedTimer();
+
+ private:
+  Category category_;
+  c10::Symbol op_;
+  int64_t start_ns_ = 0;
+};
+
+}  // namespace trace_profiler
+}  // namespace torch_xla
+
+// Times the calling XLANativeFunctions entry point as the ATen op of the same
+// name.
+#define XLA_TRACE_PROFILER_ATEN_OP()                                     \
+  static const c10::Symbol __trace_profiler_op =                         \
+      c10::Symbol::aten(__FUNCTION__);                                   \
+  ::torch_xla::trace_profiler::ScopedTimer __trace_profiler_timer(       \
+      ::torch_xla::trace_profiler::Category::kAtenOp, __trace_profiler_op)
+
+#endif  // XLA_TORCH_XLA_CSRC_TRACE_PROFILER_H_
@@ -3,9 +3,14 @@
 #include <algorithm>
 #include <functional>
 #include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
 
+#include <torch/csrc/lazy/core/metrics.h>
 #include <torch/csrc/lazy/core/util.h>
 
+#include "absl/types/span.h"
 #include "xla/shape_util.h"
 #include "xla/util.h"
 
@@ -124,6 +129,106 @@ torch::lazy::Value ApplyUpdate(torch::lazy::Value ir_value,
   return result;
 }
 
+bool IsIdentityPermutation(absl::Span<const int64_t> permutation) {
+  for (size_t i = 0; i < permutation.size(); ++i) {
+    if (permutation[i] != static_cast<int64_t>(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Composes the view `second`, taken on the result of `first`, into a single
+// view of the source of `first`. Returns std::nullopt when the two views are
+// not of a kind which composes. The composed view is a kNoOp one when the two
+// views cancel each other out.
+std::optional<ViewInfo> ComposeViewInfos(const ViewInfo& first,
+                                         const ViewInfo& second) {
+  if (first.view_type != second.view_type) {
+    return std::nullopt;
+  }
+  switch (first.view_type) {
+    case ViewInfo::Type::kNarrow: {
+      ViewInfo composed(ViewInfo::Type::kNarrow, second.shape,
+                        first.source_shape);
+      for (size_t i = 0; i < composed.indices.size(); ++i) {
+        composed.indices[i] = first.indices[i] + second.indices[i];
+      }
+      return composed;
+    }
+    case ViewInfo::Type::kPermute: {
+      std::vector<int64_t> permutation(second.permutation.size());
+      for (size_t i = 0; i < permutation.size(); ++i) {
+        permutation[i] = first.permutation[second.permutation[i]];
+      }
+      if (IsIdentityPermutation(permutation)) {
+        return ViewInfo(ViewInfo::Type::kNoOp, second.shape,
+                        first.source_shape);
+      }
+      return ViewInfo(ViewInfo::Type::kPermute, first.source_shape,
+                      std::move(permutation));
+    }
+    case ViewInfo::Type::kReshape: {
+      ViewInfo::Type view_type =
+          second.shape.dimensions() == first.source_shape.dimensions()
+              ? ViewInfo::Type::kNoOp
+              : ViewInfo::Type::kReshape;
+      return ViewInfo(view_type, second.shape, first.source_shape);
+    }
+    case ViewInfo::Type::kSelect: {
+      if (first.select->dim != second.select->dim) {
+        return std::nullopt;
+      }
+      // The i-th element of `second` is the (second.start + i * stride)-th
+      // element of `first`.
+      int64_t first_stride = Select::GetStride(
+          first.select->start, first.select->end, first.select->stride);
+      int64_t second_stride = Select::GetStride(
+          second.select->start, second.select->end, second.select->stride);
+      int64_t size = second.shape.dimensions(second.select->dim);
+      SelectInfo select;
+      select.dim = first.select->dim;
+      select.start = first.select->start + second.select->start * first_stride;
+      select.stride = first_stride * second_stride;
+      select.end = size > 0 ? select.start + (size - 1) * select.stride + 1
+                            : select.start;
+      return ViewInfo(ViewInfo::Type::kSelect, first.source_shape, select);
+    }
+    default:
+      return std::nullopt;
+  }
+}
+
+// Appends `view_info` to `view_infos`, composing it with the last view of the
+// chain where possible, so that the chains of views of the same kind are
+// replayed as a single view.
+void AppendViewInfo(std::vector<ViewInfo>* view_infos, ViewInfo view_info) {
+  if (view_infos->empty()) {
+    view_infos->push_back(std::move(view_info));
+    return;
+  }
+  if (view_info.view_type == ViewInfo::Type::kNoOp) {
+    return;
+  }
+  ViewInfo& last = view_infos->back();
+  if (last.view_type == ViewInfo::Type::kNoOp) {
+    last = std::move(view_info);
+    return;
+  }
+  std::optional<ViewInfo> composed = ComposeViewInfos(last, view_info);
+  if (!composed) {
+    view_infos->push_back(std::move(view_info));
+    return;
+  }
+  TORCH_LAZY_COUNTER("ComposedViews", 1);
+  if (composed->view_type == ViewInfo::Type::kNoOp &&
+      view_infos->size() > 1) {
+    view_infos->pop_back();
+  } else {
+    last = *std::move(composed);
+  }
+}
+
 }  // namespace
 
 ViewInfo::ViewInfo(Type view_type, xla::Shape shape, xla::Shape source_shape)
@@ -220,7 +325,7 @@ void View::Update(torch::lazy::Value ir_value) {
 std::shared_ptr<View> View::CreateSubView(xla::Shape shape,
                                           ViewInfo view_info) {
   std::vector<ViewInfo> view_infos(view_infos_);
-  view_infos.push_back(std::move(view_info));
+  AppendViewInfo(&view_infos, std::move(view_info));
   return std::make_shared<View>(std::move(shape), alias_,
                                 std::move(view_infos));
 }
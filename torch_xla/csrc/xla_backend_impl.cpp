@@ -6,10 +6,13 @@
 #include "torch_xla/csrc/device.h"
 #include "torch_xla/csrc/ir_builder.h"
 #include "torch_xla/csrc/lowering_context.h"
+#include "torch_xla/csrc/memory_sampler.h"
+#include "torch_xla/csrc/metrics_exporter.h"
 #include "torch_xla/csrc/ops/device_data.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
 #include "torch_xla/csrc/runtime/runtime.h"
+#include "torch_xla/csrc/runtime/timeline.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/tensor_util.h"
 
@@ -265,6 +268,9 @@ bool InitXlaBackend() {
   s_registrar =
       std::make_unique<torch::lazy::BackendRegistrar>(GetXlaBackendImpl());
   torch::lazy::LazyGraphExecutor::Register(GetXlaLazyGraphExecutor());
+  MaybeStartMetricsExporter();
+  MemorySampler::Get()->MaybeStart();
+  runtime::timeline::MaybeInstallDumpSignalHandler();
   return true;
 };
 
@@ -3,13 +3,16 @@
 #include <Python.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <condition_variable>
 #include <exception>
 #include <fstream>
 #include <functional>
+#include <future>
 #include <mutex>
 #include <set>
+#include <sstream>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
@@ -26,19 +29,28 @@
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
 #include "stablehlo/dialect/Serialization.h"  // from @stablehlo
 #include "tsl/platform/errors.h"
 #include "tsl/profiler/lib/traceme.h"
 #include "xla/literal_util.h"
+#include "xla/pjrt/distributed/distributed.h"
 #include "xla/shape_util.h"
 
+#include "torch_xla/csrc/all_reduce_bucketing.h"
+#include "torch_xla/csrc/aten_fallback.h"
 #include "torch_xla/csrc/aten_xla_bridge.h"
+#include "torch_xla/csrc/autocast_mode.h"
+#include "torch_xla/csrc/cross_replica_reduces.h"
 #include "torch_xla/csrc/dtype.h"
+#include "torch_xla/csrc/gil_util.h"
+#include "torch_xla/csrc/graph_split.h"
 #include "torch_xla/csrc/hash_util.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/ir_dump_util.h"
 #include "torch_xla/csrc/layout_manager.h"
+#include "torch_xla/csrc/memory_sampler.h"
 #include "torch_xla/csrc/ops/arithmetic_ir_ops.h"
 #include "torch_xla/csrc/ops/cast.h"
 #include "torch_xla/csrc/ops/device_data.h"
@@ -48,20 +60,32 @@
 #include "torch_xla/csrc/ops/ops.h"
 #include "torch_xla/csrc/ops/view.h"
 #include "torch_xla/csrc/ops/xla_ops.h"
+#include "torch_xla/csrc/output_arena.h"
+#include "torch_xla/csrc/parallel_lowering.h"
 #include "torch_xla/csrc/runtime/cache.h"
+#include "torch_xla/csrc/runtime/cache_codec.h"
+#include "torch_xla/csrc/runtime/compile_option_autotuner.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/distributed_cache_storage.h"
 #include "torch_xla/csrc/runtime/env_vars.h"
+#include "torch_xla/csrc/runtime/host_local_cache_storage.h"
+#include "torch_xla/csrc/runtime/metrics.h"
 #include "torch_xla/csrc/runtime/pjrt_computation_client.h"
 #include "torch_xla/csrc/runtime/runtime.h"
 #include "torch_xla/csrc/runtime/stablehlo_helper.h"
+#include "torch_xla/csrc/runtime/straggler_monitor.h"
 #include "torch_xla/csrc/runtime/sys_util.h"
+#include "torch_xla/csrc/runtime/timeline.h"
+#include "torch_xla/csrc/runtime/xla_coordinator.h"
 #include "torch_xla/csrc/runtime/xla_util.h"
+#include "torch_xla/csrc/scalar_pool.h"
 #include "torch_xla/csrc/shape_helper.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/tensor_util.h"
 #include "torch_xla/csrc/thread_pool.h"
 #include "torch_xla/csrc/torch_util.h"
+#include "torch_xla/csrc/trace_profiler.h"
 #include "torch_xla/csrc/version.h"
 #include "torch_xla/csrc/xla_backend_impl.h"
 #include "torch_xla/csrc/xla_sharding_util.h"
@@ -81,33 +105,402 @@ bool ShouldSyncIrValue(const torch::lazy::Value& ir_value) {
   return ir_value->op() != xla_not_supported;
 }
 
+// Whether every random op derives its seed from the base seed and a per op
+// offset counted on the host, instead of the previous op's seed.
+bool UseCounterBasedRng() {
+  static const bool counter_based_rng =
+      runtime::sys_util::GetEnvBool("XLA_RNG_COUNTER_BASED", false);
+  return counter_based_rng;
+}
+
+// Whether the live tensor syncs only visit the tensors which hold pending work,
+// rather than every live tensor.
+bool UseDirtyTensorTracking() {
+  static const bool dirty_tensor_tracking =
+      runtime::sys_util::GetEnvBool("XLA_TRACK_DIRTY_TENSORS", true);
+  return dirty_tensor_tracking;
+}
+
+// The number of consecutive eager ops synced as one graph.
+size_t GetEagerWindowOps() {
+  static const size_t window_ops =
+      runtime::sys_util::GetEnvInt("XLA_EAGER_WINDOW_OPS", 1);
+  return window_ops;
+}
+
+bool IsDirty(const XLATensor::Data& data) {
+  return data.ir_value || data.view != nullptr ||
+         (data.handle == nullptr && data.tensor_data.has_value());
+}
+
+// Maps an offset to the term added to the base seed, with the splitmix64
+// finalizer, so that the seeds of consecutive offsets share no bits.
+uint64_t MixRngOffset(uint64_t offset) {
+  uint64_t z = (offset + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Whether cache hits are executed on the tracing thread instead of the thread
+// pool, which saves the thread hand-off when there is nothing to overlap the
+// execution dispatch with, like in latency sensitive serving.
+bool UseInlineExecution() {
+  static const bool inline_execution =
+      runtime::sys_util::GetEnvBool("XLA_INLINE_EXECUTION", false);
+  return inline_execution;
+}
+
+// Peak TFLOP/s of a device, which the achieved TFLOP/s are compared with to
+// report the model FLOPs utilization. 0 if unknown.
+double PeakTflops() {
+  static const double peak_tflops =
+      runtime::sys_util::GetEnvDouble("XLA_PEAK_TFLOPS", 0);
+  return peak_tflops;
+}
+
+// Returns the number of parameters from which a graph takes its parameters as
+// a single tuple. Unless the graph or $XLA_PARAMETER_WRAPPING_THREADSHOLD sets
+// it, the argument handles of a graph with as many parameters, at the cost the
+// client measured, take as long as the ones of 3200 parameters at the 1us per
+// parameter the client assumes, which made the former fixed threshold.
+int64_t GetParameterWrappingThreshold(
+    std::optional<int64_t> graph_threshold,
+    const runtime::ComputationClient* client) {
+  static constexpr int64_t kDefaultThreshold = 3200;
+  static constexpr double kArgumentHandleBudgetNs = kDefaultThreshold * 1000.0;
+  static constexpr int64_t kMinThreshold = 512;
+  static constexpr int64_t kMaxThreshold = 65536;
+  if (graph_threshold) {
+    return *graph_threshold;
+  }
+  static const int64_t env_threshold = runtime::sys_util::GetEnvInt(
+      "XLA_PARAMETER_WRAPPING_THREADSHOLD", /*defval=*/-1);
+  if (env_threshold >= 0) {
+    return env_threshold;
+  }
+  double cost_ns = client->GetArgumentHandleCostNs();
+  if (cost_ns <= 0) {
+    return kDefaultThreshold;
+  }
+  return std::clamp(static_cast<int64_t>(kArgumentHandleBudgetNs / cost_ns),
+                    kMinThreshold, kMaxThreshold);
+}
+
+// Records a step timeline event of `phase` for the graph of `hash`.
+void RecordTimelineEvent(runtime::timeline::Phase phase, int64_t start_ns,
+                         const torch::lazy::hash_t& hash) {
+  runtime::timeline::Record(phase, start_ns, runtime::sys_util::NowNs(),
+                            c10::Uint128High64(hash), c10::Uint128Low64(hash));
+}
+
+// Records the time a thread spends tracing between two syncs as a step
+// timeline event, from the end of its previous sync to the start of this one.
+class TracingTimelineScope {
+ public:
+  TracingTimelineScope() {
+    if (last_sync_end_ns_ != 0) {
+      runtime::timeline::Record(runtime::timeline::Phase::kTrace,
+                                last_sync_end_ns_, runtime::sys_util::NowNs());
+    }
+  }
+
+  ~TracingTimelineScope() { last_sync_end_ns_ = runtime::sys_util::NowNs(); }
+
+ private:
+  static thread_local int64_t last_sync_end_ns_;
+};
+
+thread_local int64_t TracingTimelineScope::last_sync_end_ns_ = 0;
+
+// The device data of the outputs of the pieces of a split graph which the
+// calling thread ran already, by node, which the next pieces take as
+// parameters rather than computing them again.
+thread_local std::unordered_map<const torch::lazy::Node*,
+                                std::vector<torch::lazy::BackendDataPtr>>
+    graph_cut_data;
+
+// Whether the calling thread is running the pieces of a split graph which
+// hand over their outputs to the next ones.
+thread_local bool splitting_graph = false;
+
+// Forgets the graph cuts of the calling thread at the end of the sync of the
+// split graph, when it is the outermost sync of the thread.
+class GraphSplitScope {
+ public:
+  GraphSplitScope() : outermost_(!splitting_graph && graph_cut_data.empty()) {}
+
+  ~GraphSplitScope() {
+    if (outermost_) {
+      splitting_graph = false;
+      graph_cut_data.clear();
+    }
+  }
+
+  bool outermost() const { return outermost_; }
+
+ private:
+  bool outermost_;
+};
+
+// Returns the outputs of the previous pieces of a split graph which the nodes
+// of `post_order`, or the `roots`, use, with their device data, in the order
+// of their first use.
+std::vector<std::pair<torch::lazy::Output, torch::lazy::BackendDataPtr>>
+GetGraphCutInputs(c10::ArrayRef<const torch::lazy::Node*> post_order,
+                  c10::ArrayRef<torch::lazy::Value> roots) {
+  std::vector<std::pair<torch::lazy::Output, torch::lazy::BackendDataPtr>>
+      inputs;
+  torch::lazy::OutputMap<bool> seen;
+  auto add_input = [&](const torch::lazy::Output& output) {
+    auto it = graph_cut_data.find(output.node);
+    if (it != graph_cut_data.end() && seen.emplace(output, true).second) {
+      inputs.emplace_back(output, it->second.at(output.index));
+    }
+  };
+  for (const torch::lazy::Node* node : post_order) {
+    for (const torch::lazy::Output& operand : node->operands()) {
+      add_input(operand);
+    }
+  }
+  for (const torch::lazy::Value& root : roots) {
+    add_input(torch::lazy::Output(root.node.get(), root.index));
+  }
+  return inputs;
+}
+
+// Sum of the sizes of the arrays within `shape`.
+int64_t ShapeBytes(const xla::Shape& shape) {
+  int64_t bytes = 0;
+  xla::ShapeUtil::ForEachSubshape(
+      shape, [&](const xla::Shape& subshape, const xla::ShapeIndex&) {
+        if (subshape.IsArray()) {
+          bytes += xla::ShapeUtil::ByteSizeOf(subshape);
+        }
+      });
+  return bytes;
+}
+
+// Whether the syncs release the GIL, when called with it held, while they
+// collect, lower, compile and schedule the graph.
+bool ReleaseGilDuringSync() {
+  static const bool release_gil =
+      runtime::sys_util::GetEnvBool("XLA_RELEASE_GIL_DURING_SYNC", true);
+  return release_gil;
+}
+
+bool UseAsyncCompilation() {
+  static const bool async_compilation =
+      runtime::sys_util::GetEnvBool("XLA_ASYNC_COMPILATION", false);
+  return async_compilation;
+}
+
+// Checks the predicted device memory use of an execution against the free
+// memory of `devices`, as configured by XLA_MEMORY_ADMISSION_CHECK: "warn" logs
+// once per graph, "error" refuses to launch it.
+void CheckMemoryAdmission(runtime::ComputationClient* client,
+                          const runtime::ComputationClient::Computation& comp,
+                          absl::Span<const std::string> devices,
+                          const torch::lazy::hash_t& hash) {
+  static const std::string mode =
+      runtime::sys_util::GetEnvString("XLA_MEMORY_ADMISSION_CHECK", "none");
+  if (mode == "none") {
+    return;
+  }
+  XLA_CHECK(mode == "warn" || mode == "error")
+      << "Unknown XLA_MEMORY_ADMISSION_CHECK: " << mode;
+  std::optional<runtime::ComputationClient::Computation::MemoryFootprint>
+      footprint = comp.memory_footprint();
+  if (!footprint.has_value()) {
+    return;
+  }
+  int64_t execution_bytes = footprint->execution_bytes();
+  for (const std::string& device : devices) {
+    runtime::ComputationClient::MemoryInfo mem_info;
+    try {
+      mem_info = client->GetMemoryInfo(device);
+    } catch (const std::exception&) {
+      // Not all the platforms report memory statistics.
+      return;
+    }
+    int64_t free_bytes = mem_info.bytes_limit - mem_info.bytes_used;
+    if (mem_info.bytes_limit <= 0 || execution_bytes <= free_bytes) {
+      continue;
+    }
+    TORCH_LAZY_COUNTER("MemoryAdmissionExceeded", 1);
+    std::string message = absl::StrCat(
+        "Execution of IR graph hash ", torch::lazy::HashToString(hash),
+        " needs ", execution_bytes, " bytes of device memory (",
+        footprint->output_bytes, " output, ", footprint->temp_bytes,
+        " temp), but only ", free_bytes, " bytes are free on ", device);
+    if (mode == "error") {
+      XLA_ERROR() << message;
+    }
+    static std::mutex warned_mutex;
+    static auto* warned =
+        new std::unordered_set<torch::lazy::hash_t, torch::lazy::HashReducer>();
+    std::lock_guard<std::mutex> lock(warned_mutex);
+    if (warned->insert(hash).second) {
+      TF_LOG(WARNING) << message;
+    }
+    return;
+  }
+}
+
+std::unique_ptr<runtime::util::EvictionPolicy<torch::lazy::hash_t>>
+CreateComputationCacheEvictionPolicy() {
+  static const std::string policy = runtime::sys_util::GetEnvString(
+      "XLA_COMPILATION_CACHE_EVICTION_POLICY", "lru");
+  if (policy == "gds") {
+    return std::make_unique<
+        runtime::util::GreedyDualSizeEvictionPolicy<torch::lazy::hash_t>>();
+  }
+  XLA_CHECK_EQ(policy, "lru")
+      << "Unknown XLA_COMPILATION_CACHE_EVICTION_POLICY: " << policy;
+  return nullptr;
+}
+
+std::unique_ptr<runtime::util::CacheStorage> CreatePersistentCacheStorage(
+    const std::string& cache_dir, bool readonly) {
+  static const bool shared =
+      runtime::sys_util::GetEnvBool("XLA_PERSISTENT_CACHE_SHARED", false);
+  static const bool host_shared =
+      runtime::sys_util::GetEnvBool("XLA_PERSISTENT_CACHE_HOST_SHARED", false);
+  std::unique_ptr<runtime::util::CacheStorage> local =
+      std::make_unique<runtime::util::DiskCacheStorage>(cache_dir, readonly);
+  if (host_shared && !readonly) {
+    static const int64_t host_wait_seconds = runtime::sys_util::GetEnvInt(
+        "XLA_PERSISTENT_CACHE_HOST_SHARED_WAIT_SECONDS", 600);
+    local = std::make_unique<runtime::HostLocalCacheStorage>(
+        std::move(local), cache_dir, absl::Seconds(host_wait_seconds));
+  }
+  if (!shared) {
+    return local;
+  }
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  if (!client->CoordinatorInitialized()) {
+    TF_LOG(WARNING) << "XLA_PERSISTENT_CACHE_SHARED=1 requires the "
+                       "XlaCoordinator, which is not initialized. Falling back "
+                       "to a local persistent cache.";
+    return local;
+  }
+  static const int64_t wait_seconds = runtime::sys_util::GetEnvInt(
+      "XLA_PERSISTENT_CACHE_SHARED_WAIT_SECONDS", 0);
+  // A value of 0 spreads the entries over all the processes.
+  static const int64_t num_publishers = runtime::sys_util::GetEnvInt(
+      "XLA_PERSISTENT_CACHE_SHARED_PUBLISHERS", 1);
+  std::shared_ptr<xla::KeyValueStoreInterface> kv_store =
+      xla::GetDistributedKeyValueStore(client->GetCoordinator().GetClient(),
+                                       /*key_prefix=*/"ptxla_cache:");
+  return std::make_unique<runtime::DistributedCacheStorage>(
+      std::move(local), std::move(kv_store), client->GetProcessIndex(),
+      num_publishers > 0 ? std::min<int64_t>(num_publishers,
+                                             client->GetNumProcesses())
+                         : client->GetNumProcesses(),
+      absl::Seconds(wait_seconds));
+}
+
+// Loads the persistent cache entries selected by XLA_PERSISTENT_CACHE_PREFETCH
+// or XLA_PERSISTENT_CACHE_PREFETCH_MANIFEST in background, so that the first
+// lookups of those graphs hit memory.
+void SchedulePersistentCachePrefetch(XLAGraphExecutor::PersistentCache* cache) {
+  static const int64_t prefetch_count =
+      runtime::sys_util::GetEnvInt("XLA_PERSISTENT_CACHE_PREFETCH", 0);
+  static const std::string manifest_path = runtime::sys_util::GetEnvString(
+      "XLA_PERSISTENT_CACHE_PREFETCH_MANIFEST", "");
+  std::vector<std::string> names;
+  if (!manifest_path.empty()) {
+    std::ifstream manifest(manifest_path);
+    std::string name;
+    while (manifest >> name) {
+      names.push_back(name);
+    }
+  } else if (prefetch_count > 0) {
+    names = cache->GetMostRecentlyUsedNames(prefetch_count);
+  }
+  if (names.empty()) {
+    return;
+  }
+  TF_VLOG(3) << "Prefetching " << names.size()
+             << " persistent compilation cache entries";
+  thread::ScheduleIo(
+      [cache, names = std::move(names)]() { cache->Prefetch(names); });
+}
+
+runtime::util::CacheCodec GetPersistentCacheCodec() {
+  XLA_ASSIGN_OR_THROW(
+      runtime::util::CacheCodec codec,
+      runtime::util::ParseCacheCodec(runtime::sys_util::GetEnvString(
+          "XLA_PERSISTENT_CACHE_COMPRESSION", "none")));
+  return codec;
+}
+
+// Returns the number of steps, from $XLA_COMPILATION_CACHE_IDLE_STEPS, after
+// which the executables which did not run get unloaded. Zero, the default,
+// keeps them loaded.
+size_t GetCompilationCacheIdleSteps() {
+  static const size_t idle_steps =
+      runtime::sys_util::GetEnvInt("XLA_COMPILATION_CACHE_IDLE_STEPS", 0);
+  return idle_steps;
+}
+
 XLAGraphExecutor::ComputationCache* CreateComputationCache() {
   static const size_t kMaxCacheSize =
       runtime::sys_util::GetEnvInt("XLA_COMPILATION_CACHE_SIZE", 2048);
+  static const size_t kMaxCacheBytes =
+      runtime::sys_util::GetEnvInt("XLA_COMPILATION_CACHE_BYTES", 0);
+  auto cost_fn = [](const XLAGraphExecutor::CachedComputation& computation) {
+    return computation.GetCacheCost();
+  };
   static const bool readonlyPersistentCache =
       runtime::sys_util::GetEnvBool("XLA_PERSISTENT_CACHE_READ_ONLY", false);
   static std::string persistentCacheDir =
       runtime::sys_util::GetEnvString("XLA_PERSISTENT_CACHE_PATH", "");
-  if (!persistentCacheDir.empty()) {
+  if (!persistentCacheDir.empty() || GetCompilationCacheIdleSteps() > 0) {
     auto serialize_fn =
         [](XLAGraphExecutor::ComputationCache::TypePtr computation)
         -> std::string {
+      TORCH_LAZY_TIMED("SerializeComputation");
       XLA_ASSIGN_OR_THROW(
           runtime::ComputationClient * absl_nonnull const client,
           runtime::GetComputationClient());
-      return client->SerializeComputation(computation->computation);
+      static const runtime::util::CacheCodec codec = GetPersistentCacheCodec();
+      static const int level = runtime::sys_util::GetEnvInt(
+          "XLA_PERSISTENT_CACHE_COMPRESSION_LEVEL", 1);
+      return runtime::util::EncodeCacheEntry(
+          client->SerializeComputation(computation->computation), codec, level,
+          computation->autotuned ? runtime::util::kCacheEntryAutotuned : 0);
     };
     auto deserialize_fn = [](std::string serialization)
         -> XLAGraphExecutor::ComputationCache::TypePtr {
       XLA_ASSIGN_OR_THROW(
           runtime::ComputationClient * absl_nonnull const client,
           runtime::GetComputationClient());
+      uint16_t flags = 0;
+      absl::StatusOr<std::string> decoded =
+          runtime::util::DecodeCacheEntry(std::move(serialization), &flags);
+      if (!decoded.ok()) {
+        TF_LOG(WARNING) << "Failed to decode persistent cache entry: "
+                        << decoded.status();
+        return nullptr;
+      }
       runtime::ComputationClient::ComputationPtr computation =
-          client->DeserializeComputation(serialization);
+          client->DeserializeComputation(*decoded);
       if (!computation) return nullptr;
       return std::make_shared<XLAGraphExecutor::CachedComputation>(
-          computation, /*is_sharded=*/UseVirtualDevice());
+          computation, /*is_sharded=*/UseVirtualDevice(),
+          /*autotuned=*/(flags & runtime::util::kCacheEntryAutotuned) != 0);
     };
+    if (persistentCacheDir.empty()) {
+      // The idle executables get unloaded to free their device memory, while
+      // their serialized form stays in host memory to load them again.
+      return new XLAGraphExecutor::PersistentCache(
+          kMaxCacheSize,
+          std::make_unique<runtime::util::HostMemoryCacheStorage>(),
+          /*readonly_storage=*/false, serialize_fn, deserialize_fn,
+          kMaxCacheBytes, CreateComputationCacheEvictionPolicy(), cost_fn);
+    }
     if (runtime::sys_util::GetEnvBool("XLA_HLO_DEBUG", false) ||
         runtime::sys_util::GetEnvBool("XLA_IR_DEBUG", false)) {
       TF_LOG(WARNING)
@@ -115,11 +508,153 @@ XLAGraphExecutor::ComputationCache* CreateComputationCache() {
              "or XLA_IR_DEBUG=1 is not recommended. Changes to the HLO "
              "metadata will not be reflected in loaded executables.";
     }
-    return new XLAGraphExecutor::PersistentCache(
-        kMaxCacheSize, persistentCacheDir, readonlyPersistentCache,
-        serialize_fn, deserialize_fn);
+    auto* cache = new XLAGraphExecutor::PersistentCache(
+        kMaxCacheSize,
+        CreatePersistentCacheStorage(persistentCacheDir,
+                                     readonlyPersistentCache),
+        readonlyPersistentCache, serialize_fn, deserialize_fn, kMaxCacheBytes,
+        CreateComputationCacheEvictionPolicy(), cost_fn);
+    SchedulePersistentCachePrefetch(cache);
+    return cache;
+  }
+  return new XLAGraphExecutor::MemoryCache(
+      kMaxCacheSize, kMaxCacheBytes, CreateComputationCacheEvictionPolicy(),
+      cost_fn);
+}
+
+// Returns the seed of the hashes of the graphs synced with `force_ltc_data`,
+// which reflects the compilation environment of `client` and the git
+// revisions, so that different versions of the code can produce different
+// hashes for the same graph. The seeds are only recomputed when the
+// compilation environment changes, rather than on every sync.
+torch::lazy::hash_t GetGraphHashSeed(runtime::ComputationClient* client,
+                                     bool force_ltc_data) {
+  struct Seeds {
+    runtime::ComputationClient* client = nullptr;
+    uint64_t version = 0;
+    // Indexed by force_ltc_data.
+    std::array<torch::lazy::hash_t, 2> hashes;
+  };
+  thread_local Seeds seeds;
+  uint64_t version = client->CompilationEnvVersion();
+  if (seeds.client != client || seeds.version != version) {
+    static const torch::lazy::hash_t torch_revision_hash =
+        torch::lazy::StringHash(TORCH_GITREV);
+    static const torch::lazy::hash_t xla_revision_hash =
+        torch::lazy::StringHash(XLA_GITREV);
+    torch::lazy::hash_t env_hash = client->HashCompilationEnv();
+    for (bool force : {false, true}) {
+      // The force_ltc_data controls aliasing compilation, so effectively the
+      // same graph with on/off force_ltc_data should not match, hash wise.
+      torch::lazy::hash_t hash = torch::lazy::MHash(force);
+      MergeHash({env_hash, torch_revision_hash, xla_revision_hash}, &hash);
+      seeds.hashes[force] = hash;
+    }
+    seeds.client = client;
+    seeds.version = version;
+  }
+  return seeds.hashes[force_ltc_data];
+}
+
+using CompileOptionAutotuner = runtime::util::CompileOptionAutotuner<
+    torch::lazy::hash_t, XLAGraphExecutor::CachedComputation,
+    torch::lazy::HashReducer>;
+
+// Returns the autotuner of the candidate compile option sets listed by
+// $XLA_COMPILE_OPTION_CANDIDATES, or null when there is none.
+CompileOptionAutotuner* GetCompileOptionAutotuner() {
+  static CompileOptionAutotuner* autotuner = []() -> CompileOptionAutotuner* {
+    std::string spec =
+        runtime::sys_util::GetEnvString("XLA_COMPILE_OPTION_CANDIDATES", "");
+    XLA_ASSIGN_OR_THROW(
+        std::vector<runtime::util::CompileOptionSet> candidates,
+        runtime::util::ParseCompileOptionCandidates(spec));
+    if (candidates.empty()) {
+      return nullptr;
+    }
+    return new CompileOptionAutotuner(
+        std::move(candidates),
+        runtime::sys_util::GetEnvInt(
+            "XLA_COMPILE_OPTION_AUTOTUNE_MIN_EXECUTIONS", 10),
+        runtime::sys_util::GetEnvInt("XLA_COMPILE_OPTION_AUTOTUNE_SAMPLES",
+                                     5));
+  }();
+  return autotuner;
+}
+
+// Returns every how many steps the hosts report their step times to detect
+// the stragglers, from $XLA_STRAGGLER_REPORT_STEPS, 0 to disable.
+int64_t StragglerReportSteps() {
+  static const int64_t steps =
+      runtime::sys_util::GetEnvInt("XLA_STRAGGLER_REPORT_STEPS", 0);
+  return steps;
+}
+
+// Publishes the times of the step which just ended every
+// StragglerReportSteps() steps, in the background, and has process 0 report
+// the stragglers. Requires the XlaCoordinator, ignoring the steps before it is
+// initialized.
+void ReportStepTimes(int64_t device_ns) {
+  static std::mutex mutex;
+  static int64_t step = 0;
+  static int64_t last_step_ns = runtime::sys_util::NowNs();
+  static std::shared_ptr<runtime::StragglerMonitor> monitor;
+
+  int64_t now_ns = runtime::sys_util::NowNs();
+  std::lock_guard<std::mutex> lock(mutex);
+  runtime::StragglerMonitor::StepTimes times{now_ns - last_step_ns, device_ns};
+  last_step_ns = now_ns;
+  if (++step % StragglerReportSteps() != 0) {
+    return;
+  }
+  if (monitor == nullptr) {
+    XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                        runtime::GetComputationClient());
+    if (!client->CoordinatorInitialized()) {
+      return;
+    }
+    static const double threshold =
+        runtime::sys_util::GetEnvDouble("XLA_STRAGGLER_THRESHOLD", 1.2);
+    static const int64_t timeout_seconds = runtime::sys_util::GetEnvInt(
+        "XLA_STRAGGLER_TIMEOUT_SECONDS", 60);
+    monitor = std::make_shared<runtime::StragglerMonitor>(
+        xla::GetDistributedKeyValueStore(
+            client->GetCoordinator().GetClient(),
+            /*key_prefix=*/"ptxla_straggler:"),
+        client->GetProcessIndex(), client->GetNumProcesses(), threshold,
+        absl::Seconds(timeout_seconds));
   }
-  return new XLAGraphExecutor::MemoryCache(kMaxCacheSize);
+  thread::ScheduleIo([monitor = monitor, step = step, times]() {
+    absl::Status status = monitor->Publish(step, times);
+    if (!status.ok()) {
+      TF_LOG(WARNING) << "Failed to publish the times of step " << step << ": "
+                      << status;
+      return;
+    }
+    if (monitor->process_index() != 0) {
+      return;
+    }
+    runtime::StragglerMonitor::Report report = monitor->Collect(step);
+    XLA_VALUE_METRIC("StragglerHostStepTimeRatio", report.max_host_ratio);
+    XLA_VALUE_METRIC("StragglerDeviceStepTimeRatio", report.max_device_ratio);
+    if (report.stragglers.empty()) {
+      return;
+    }
+    TORCH_LAZY_COUNTER("Stragglers", report.stragglers.size());
+    std::vector<std::string> stragglers;
+    for (int64_t index : report.stragglers) {
+      const auto& straggler = report.times[index];
+      stragglers.push_back(
+          straggler ? absl::StrCat(index, " (host ", straggler->host_ns / 1000,
+                                   "us, device ", straggler->device_ns / 1000,
+                                   "us)")
+                    : absl::StrCat(index, " (missing)"));
+    }
+    TF_LOG(WARNING) << "Straggler processes at step " << step << ", against "
+                    << "a median of host " << report.median.host_ns / 1000
+                    << "us, device " << report.median.device_ns / 1000
+                    << "us: " << absl::StrJoin(stragglers, ", ");
+  });
 }
 
 }  // namespace
@@ -129,20 +664,95 @@ auto XLAGraphExecutor::DeviceContextArena::Get() -> DeviceContextArena* {
   return arena;
 }
 
-std::vector<XLATensorPtr> XLAGraphExecutor::DeviceContextArena::GetLiveTensors(
-    const torch::lazy::BackendDevice* device) {
-  std::vector<XLATensorPtr> tensors;
-  auto fn = [&](DeviceContext* devctx) {
-    std::lock_guard<std::mutex> lock(devctx->lock);
-    for (auto& uid_wptr : devctx->tensors_data) {
-      auto data =
-          std::dynamic_pointer_cast<XLATensor::Data>(uid_wptr.second.lock());
-      if (data != nullptr) {
-        tensors.push_back(XLATensor::Create(std::move(data)));
+void XLAGraphExecutor::DeviceContextArena::TensorRegistry::Insert(
+    const std::shared_ptr<XLATensor::Data>& data) {
+  Shard& shard = GetShard(data->unique_id);
+  std::lock_guard<std::mutex> lock(shard.lock);
+  shard.tensors.emplace(data->unique_id, data);
+}
+
+void XLAGraphExecutor::DeviceContextArena::TensorRegistry::Erase(
+    int64_t unique_id) {
+  Shard& shard = GetShard(unique_id);
+  std::lock_guard<std::mutex> lock(shard.lock);
+  shard.tensors.erase(unique_id);
+}
+
+std::vector<XLATensorPtr>
+XLAGraphExecutor::DeviceContextArena::TensorRegistry::Collect(
+    const torch::lazy::BackendDevice* device,
+    const std::function<bool(const XLATensor::Data&)>& keep) {
+  std::vector<std::shared_ptr<XLATensor::Data>> tensors_data;
+  // The data not returned is released out of the shard locks, as the
+  // destructor of its last reference erases it.
+  std::vector<std::shared_ptr<XLATensor::Data>> released;
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.lock);
+    for (auto it = shard.tensors.begin(); it != shard.tensors.end();) {
+      std::shared_ptr<XLATensor::Data> data = it->second.lock();
+      if (data == nullptr || (keep != nullptr && !keep(*data))) {
+        it = shard.tensors.erase(it);
+        released.push_back(std::move(data));
+        continue;
+      }
+      if (device == nullptr || data->device == *device) {
+        tensors_data.push_back(std::move(data));
+      } else {
+        released.push_back(std::move(data));
       }
+      ++it;
     }
-  };
-  ForAllDeviceContexts(fn, device);
+  }
+  std::sort(tensors_data.begin(), tensors_data.end(),
+            [](const std::shared_ptr<XLATensor::Data>& a,
+               const std::shared_ptr<XLATensor::Data>& b) {
+              if (a->device != b->device) {
+                return a->device < b->device;
+              }
+              return a->unique_id < b->unique_id;
+            });
+  std::vector<XLATensorPtr> tensors;
+  tensors.reserve(tensors_data.size());
+  for (std::shared_ptr<XLATensor::Data>& data : tensors_data) {
+    tensors.push_back(XLATensor::Create(std::move(data)));
+  }
+  return tensors;
+}
+
+void XLAGraphExecutor::DeviceContextArena::RegisterTensor(
+    std::shared_ptr<torch::lazy::LazyTensor::Data> data) {
+  std::shared_ptr<XLATensor::Data> xla_data =
+      std::static_pointer_cast<XLATensor::Data>(std::move(data));
+  live_tensors_.Insert(xla_data);
+  TrackDirtyTensor(xla_data);
+}
+
+void XLAGraphExecutor::DeviceContextArena::UnregisterTensor(
+    torch::lazy::LazyTensor::Data* data) {
+  live_tensors_.Erase(data->unique_id);
+  if (UseDirtyTensorTracking()) {
+    dirty_tensors_.Erase(data->unique_id);
+  }
+}
+
+std::vector<XLATensorPtr> XLAGraphExecutor::DeviceContextArena::GetLiveTensors(
+    const torch::lazy::BackendDevice* device) {
+  return live_tensors_.Collect(device);
+}
+
+void XLAGraphExecutor::DeviceContextArena::TrackDirtyTensor(
+    const std::shared_ptr<XLATensor::Data>& data) {
+  if (UseDirtyTensorTracking() && IsDirty(*data)) {
+    dirty_tensors_.Insert(data);
+  }
+}
+
+std::vector<XLATensorPtr>
+XLAGraphExecutor::DeviceContextArena::GetDirtyTensors(
+    const torch::lazy::BackendDevice* device) {
+  std::vector<XLATensorPtr> tensors = dirty_tensors_.Collect(
+      device, [](const XLATensor::Data& data) { return IsDirty(data); });
+  TORCH_LAZY_VALUE_METRIC("DirtyTensors", tensors.size());
   return tensors;
 }
 
@@ -153,6 +763,9 @@ torch::lazy::Value XLAGraphExecutor::DeviceContextArena::GetRngSeed(
   static const uint64_t kSeedAdd = 2531011;
   DeviceContext* devctx = GetDeviceContext(device);
   std::lock_guard<std::mutex> lock(devctx->lock);
+  if (UseCounterBasedRng()) {
+    return GetCounterRngSeed(devctx, device);
+  }
   if (!devctx->seed_ir_value) {
     devctx->seed_ir_value =
         IrValueFromScalar(MakeIntScalar(devctx->seed), kSeedType, device);
@@ -182,6 +795,63 @@ torch::lazy::Value XLAGraphExecutor::DeviceContextArena::GetRngSeed(
   }
 }
 
+torch::lazy::Value XLAGraphExecutor::DeviceContextArena::GetCounterRngSeed(
+    DeviceContext* devctx, const torch::lazy::BackendDevice& device) {
+  static const at::ScalarType kSeedType = at::ScalarType::Long;
+  RngCounter& counter = GetRngCounter(device);
+  if (counter.seed != devctx->seed) {
+    // The step advanced the base seed, or a new one was set, so the offsets
+    // start over.
+    counter = RngCounter{devctx->seed, 0};
+  }
+  uint64_t offset = counter.offset++;
+  uint64_t mixed_offset = MixRngOffset(offset);
+  devctx->running_seed = devctx->seed + mixed_offset;
+  TORCH_LAZY_COUNTER("CounterRngSeeds", 1);
+  if (XLAGraphExecutor::Get()->UseEagerMode()) {
+    return IrValueFromScalar(MakeIntScalar(devctx->running_seed), kSeedType,
+                             device);
+  }
+  if (!devctx->seed_ir_value) {
+    devctx->seed_ir_value =
+        IrValueFromScalar(MakeIntScalar(devctx->seed), kSeedType, device);
+  }
+  // Every seed is one addition away from the base seed, and the offsets, which
+  // restart at every step, are the only constants the graph hash sees.
+  return devctx->seed_ir_value +
+         ScalarOp(MakeIntScalar(mixed_offset),
+                  MakeXlaPrimitiveType(kSeedType, &device));
+}
+
+XLAGraphExecutor::DeviceContextArena::RngCounter&
+XLAGraphExecutor::DeviceContextArena::GetRngCounter(
+    const torch::lazy::BackendDevice& device) {
+  std::lock_guard<std::mutex> lock(rng_counters_lock_);
+  return rng_counters_[device.toString()];
+}
+
+void XLAGraphExecutor::DeviceContextArena::SetRngSeed(
+    const torch::lazy::BackendDevice& device, uint64_t seed) {
+  SetRngState(device, seed, /*offset=*/0);
+}
+
+void XLAGraphExecutor::DeviceContextArena::SetRngState(
+    const torch::lazy::BackendDevice& device, uint64_t seed,
+    uint64_t offset) {
+  torch::lazy::LazyGraphExecutor::DeviceContextArena::SetRngSeed(device, seed);
+  DeviceContext* devctx = GetDeviceContext(device);
+  std::lock_guard<std::mutex> lock(devctx->lock);
+  GetRngCounter(device) = RngCounter{seed, offset};
+}
+
+uint64_t XLAGraphExecutor::DeviceContextArena::GetRngOffset(
+    const torch::lazy::BackendDevice& device) {
+  DeviceContext* devctx = GetDeviceContext(device);
+  std::lock_guard<std::mutex> lock(devctx->lock);
+  RngCounter& counter = GetRngCounter(device);
+  return counter.seed == devctx->seed ? counter.offset : 0;
+}
+
 torch::lazy::BackendDataPtr
 XLAGraphExecutor::DeviceContextArena::GetBaseSeedData(
     const torch::lazy::BackendDevice& device) {
@@ -203,21 +873,35 @@ void XLAGraphExecutor::DeviceContextArena::SaveGraphAsString(
       runtime::sys_util::GetEnvOrdinalPath(
           "XLA_SAVE_TENSORS_FILE", "", bridge::GetCurrentDevice().ordinal()) !=
       "";
-  if (should_save_graph &&
-      hash_to_graph_map_.find(hash) == hash_to_graph_map_.end()) {
+  if (!should_save_graph) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(graph_maps_lock_);
+    if (hash_to_graph_map_.find(hash) != hash_to_graph_map_.end()) {
+      return;
+    }
+  }
+  // Most of the graphs are never dumped, so they are only rendered the first
+  // time GetGraphByHash() asks for them.
+  std::function<std::string()> render_info =
+      DebugUtil::CaptureTensorsGraphInfo(tensors, indices, format);
+  SavedGraph saved_graph;
+  saved_graph.render = [render_info = std::move(render_info), hash]() {
     std::stringstream ss;
-    ss << DebugUtil::GetTensorsGraphInfo(tensors, indices, format);
+    ss << render_info();
     ss << "Graph Hash: " << torch::lazy::HashToString(hash)
        << "\n\n## END_GRAPH\n\n";
-    hash_to_graph_map_[hash] = ss.str();
-  }
+    return ss.str();
+  };
+  std::lock_guard<std::mutex> lock(graph_maps_lock_);
+  hash_to_graph_map_.emplace(hash, std::move(saved_graph));
 }
 
 void XLAGraphExecutor::DeviceContextArena::SaveOutputShapes(
     torch::lazy::hash_t hash, std::vector<xla::Shape> output_shapes) {
-  if (hash_to_output_shape_map_.find(hash) == hash_to_output_shape_map_.end()) {
-    hash_to_output_shape_map_[hash] = std::move(output_shapes);
-  }
+  std::lock_guard<std::mutex> lock(graph_maps_lock_);
+  hash_to_output_shape_map_.emplace(hash, std::move(output_shapes));
 }
 
 size_t XLAGraphExecutor::DeviceContextArena::GetNumGraphHash() const {
@@ -228,17 +912,33 @@ size_t XLAGraphExecutor::DeviceContextArena::GetNumGraphHash() const {
 
 std::string XLAGraphExecutor::DeviceContextArena::GetGraphByHash(
     torch::lazy::hash_t hash) {
-  auto iter = hash_to_graph_map_.find(hash);
-  if (iter == hash_to_graph_map_.end()) {
-    TF_LOG(INFO) << "Trying to dump graph with an invalid hash";
-    return "";
+  std::function<std::string()> render;
+  {
+    std::lock_guard<std::mutex> lock(graph_maps_lock_);
+    auto iter = hash_to_graph_map_.find(hash);
+    if (iter == hash_to_graph_map_.end()) {
+      TF_LOG(INFO) << "Trying to dump graph with an invalid hash";
+      return "";
+    }
+    if (iter->second.render == nullptr) {
+      return iter->second.graph;
+    }
+    render = iter->second.render;
   }
-  return iter->second;
+  TORCH_LAZY_COUNTER("RenderedGraphDumps", 1);
+  std::string graph = render();
+  std::lock_guard<std::mutex> lock(graph_maps_lock_);
+  SavedGraph& saved_graph = hash_to_graph_map_[hash];
+  // Releases the IR the text and dot formats are rendered from.
+  saved_graph.render = nullptr;
+  saved_graph.graph = graph;
+  return graph;
 }
 
 std::vector<xla::Shape>*
 XLAGraphExecutor::DeviceContextArena::GetOutputShapesByHash(
     torch::lazy::hash_t hash) {
+  std::lock_guard<std::mutex> lock(graph_maps_lock_);
   auto iter = hash_to_output_shape_map_.find(hash);
   XLA_CHECK(iter != hash_to_output_shape_map_.end())
       << "Hash not found, can't retrive output shape";
@@ -269,24 +969,104 @@ XLAGraphExecutor* XLAGraphExecutor::Get() {
 
 void XLAGraphExecutor::RegisterTensor(
     std::shared_ptr<torch::lazy::LazyTensor::Data> data) {
-  DeviceContextArena::Get()->RegisterTensor(data);
+  DeviceContextArena::Get()->RegisterTensor(std::move(data));
   TORCH_LAZY_COUNTER("CreateXlaTensor", 1);
 }
 
+void XLAGraphExecutor::TrackDirtyTensor(
+    const std::shared_ptr<XLATensor::Data>& data) {
+  DeviceContextArena::Get()->TrackDirtyTensor(data);
+}
+
 void XLAGraphExecutor::UnregisterTensor(torch::lazy::LazyTensor::Data* data) {
   DeviceContextArena::Get()->UnregisterTensor(data);
   TORCH_LAZY_COUNTER("DestroyXlaTensor", 1);
 }
 
 void XLAGraphExecutor::ApplyEagerSync(std::vector<XLATensorPtr>& tensors) {
+  if (eager_warm_up_) {
+    WarmUpEagerOp(tensors);
+    return;
+  }
+  if (GetEagerWindowOps() <= 1 || tensors.empty()) {
+    SyncTensorsGraph(&tensors, {}, /*wait=*/false, /*sync_ltc_data=*/false);
+    return;
+  }
+  const torch::lazy::BackendDevice& device = tensors.front()->GetDevice();
+  bool other_device = false;
+  {
+    std::lock_guard<std::mutex> lock(eager_window_lock_);
+    other_device = eager_window_device_ && *eager_window_device_ != device;
+  }
+  if (other_device) {
+    // A graph runs on a single device.
+    FlushEagerWindow();
+  }
+  bool full = false;
+  {
+    std::lock_guard<std::mutex> lock(eager_window_lock_);
+    eager_window_device_ = device;
+    for (const XLATensorPtr& tensor : tensors) {
+      eager_window_.push_back(tensor->data());
+    }
+    full = ++eager_window_ops_ >= GetEagerWindowOps();
+  }
+  if (full) {
+    FlushEagerWindow();
+  }
+}
+
+void XLAGraphExecutor::WarmUpEagerOp(std::vector<XLATensorPtr>& tensors) {
+  SyncTensorsGraph(&tensors, {}, /*wait=*/false, /*sync_ltc_data=*/false,
+                   /*warm_up_cache_only=*/true);
+  // The results become device data, as they would have after running the op,
+  // so that the graphs of the ops consuming them match the eager ones.
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  for (XLATensorPtr& tensor : tensors) {
+    if (!tensor->CurrentIrValue()) {
+      continue;
+    }
+    const torch::lazy::BackendDevice& device = tensor->GetDevice();
+    xla::Shape shape = MakeShapeWithDeviceLayout(
+        tensor->shape(), static_cast<XlaDeviceType>(device.type()));
+    tensor->SetXlaData(
+        client->CreateDataPlaceholder(device.toString(), std::move(shape)));
+  }
+  TORCH_LAZY_COUNTER("EagerWarmUpOps", 1);
+}
+
+void XLAGraphExecutor::FlushEagerWindow() {
+  std::vector<std::weak_ptr<XLATensor::Data>> window;
+  size_t window_ops = 0;
+  {
+    std::lock_guard<std::mutex> lock(eager_window_lock_);
+    window.swap(eager_window_);
+    std::swap(window_ops, eager_window_ops_);
+    eager_window_device_.reset();
+  }
+  if (window_ops == 0) {
+    return;
+  }
+  TORCH_LAZY_VALUE_METRIC("EagerWindowOps", window_ops);
+  // The tensors destroyed since their op never have to be computed, and the
+  // ones updated more than once are synced once.
+  std::vector<XLATensorPtr> tensors;
+  std::unordered_set<int64_t> unique_ids;
+  for (const std::weak_ptr<XLATensor::Data>& weak_data : window) {
+    std::shared_ptr<XLATensor::Data> data = weak_data.lock();
+    if (data != nullptr && unique_ids.insert(data->unique_id).second) {
+      tensors.push_back(XLATensor::Create(std::move(data)));
+    }
+  }
   SyncTensorsGraph(&tensors, {}, /*wait=*/false, /*sync_ltc_data=*/false);
 }
 
 torch::lazy::Value XLAGraphExecutor::GetDeviceDataIrValue(
     const at::Scalar& value, xla::PrimitiveType type,
     const torch::lazy::BackendDevice& device) {
-  torch::lazy::BackendDataPtr data =
-      GetDeviceData(value, MaybeUpcastToHostTorchType(type), device);
+  torch::lazy::BackendDataPtr data = ScalarPool::Get()->GetDeviceData(
+      value, MaybeUpcastToHostTorchType(type), device);
   data->SetInfo(
       std::make_shared<torch::lazy::LazyGraphExecutor::DeviceDataInfo>(
           /*tensor_id=*/-1, /*read_only=*/true));
@@ -375,6 +1155,20 @@ uint64_t XLAGraphExecutor::GetRunningSeed(
   return DeviceContextArena::Get()->GetRunningSeed(device);
 }
 
+void XLAGraphExecutor::SetRngState(const torch::lazy::BackendDevice& device,
+                                   uint64_t seed, uint64_t offset) {
+  DeviceContextArena::Get()->SetRngState(device, seed, offset);
+}
+
+std::pair<uint64_t, uint64_t> XLAGraphExecutor::GetRngState(
+    const torch::lazy::BackendDevice& device) {
+  DeviceContextArena* arena = DeviceContextArena::Get();
+  if (!UseCounterBasedRng()) {
+    return {arena->GetRunningSeed(device), 0};
+  }
+  return {arena->GetBaseSeed(device), arena->GetRngOffset(device)};
+}
+
 torch::lazy::BackendDataPtr XLAGraphExecutor::GetBaseSeedData(
     const torch::lazy::BackendDevice& device) {
   return DeviceContextArena::Get()->GetBaseSeedData(device);
@@ -402,6 +1196,22 @@ std::string XLAGraphExecutor::DumpHloComputation(
              : std::string();
 }
 
+void XLAGraphExecutor::DumpStablehloToFile(
+    const std::vector<XLATensorPtr>& tensors, bool emit_bytecode,
+    const std::string& path) {
+  std::vector<torch::lazy::Value> ir_values;
+  for (auto& tensor : tensors) {
+    torch::lazy::Value ir_value = tensor->CurrentIrValue();
+    if (ir_value) {
+      ir_values.push_back(std::move(ir_value));
+    }
+  }
+  XLA_CHECK(!ir_values.empty()) << "No pending computation to dump";
+  xla::XlaComputation computation =
+      DumpUtil::ToXlaComputation(ir_values, bridge::GetCurrentDevice());
+  hloToStablehloFile(&computation.proto(), emit_bytecode, path);
+}
+
 std::vector<XLATensorPtr> XLAGraphExecutor::GetLiveTensors(
     const torch::lazy::BackendDevice* device) {
   return DeviceContextArena::Get()->GetLiveTensors(device);
@@ -432,7 +1242,10 @@ void XLAGraphExecutor::SyncLiveTensorsGraph(
     c10::ArrayRef<std::string> devices, bool wait) {
   tsl::profiler::TraceMe activity("SyncLiveTensorsGraph",
                                   tsl::profiler::TraceMeLevel::kInfo);
-  auto tensors = GetLiveTensors(device);
+  // The tensors without pending work are not synced anyway.
+  auto tensors = UseDirtyTensorTracking()
+                     ? DeviceContextArena::Get()->GetDirtyTensors(device)
+                     : GetLiveTensors(device);
   TF_VLOG(4) << tensors.size() << " live tensors: devices=("
              << c10::Join(",", devices) << ")";
   SyncTensorsGraph(&tensors, devices, wait, /*sync_ltc_data=*/true);
@@ -445,7 +1258,24 @@ void XLAGraphExecutor::MarkStep(const torch::lazy::BackendDevice& device,
   // runtime::metrics::CreatePerformanceReport(). For more information, see
   // NOTE: [TORCH_LAZY_COUNTER v.s. XLA_COUNTER].
   XLA_COUNTER("MarkStep", 1);
+  int64_t step_execute_ns = graph_stats_.MarkStep();
+  if (StragglerReportSteps() > 0) {
+    ReportStepTimes(step_execute_ns);
+  }
+  if (GetCompilationCacheIdleSteps() > 0) {
+    size_t unloaded =
+        GetComputationCache()->UnloadIdle(GetCompilationCacheIdleSteps());
+    if (unloaded > 0) {
+      TORCH_LAZY_COUNTER("CompilationCacheIdleUnloads", unloaded);
+    }
+  }
+  runtime::timeline::MarkStep();
+  MemorySampler::Get()->MarkStep();
+  trace_profiler::MarkStep();
   DeviceContextArena::Get()->MarkStep(device);
+  post_order_cache_.Clear(device);
+  ClearAutocastCache();
+  FlushEagerWindow();
   if (reset_scope) {
     torch::lazy::ScopePusher::ResetScopes();
   }
@@ -466,6 +1296,7 @@ std::vector<size_t> GetBufferDonorIndexFromUserConfig(
 }
 
 void XLAGraphExecutor::WaitDeviceOps(absl::Span<const std::string> devices) {
+  FlushEagerWindow();
   std::set<torch::lazy::BackendDevice> wait_devices;
   if (!devices.empty()) {
     for (auto& device_str : devices) {
@@ -494,10 +1325,39 @@ std::vector<at::Tensor> XLAGraphExecutor::GetTensors(
     std::vector<XLATensorPtr>* tensors) {
   TF_VLOG(4) << "Trying to get the value of " << tensors->size()
              << " tensor(s)";
+  // The pending eager ops run before the values reach the host, as they
+  // would have without a window.
+  FlushEagerWindow();
+  SyncTensorsConfig config;
+  config.force_ltc_data = false;
+  std::shared_ptr<Async> async;
+  {
+    FallbackPhaseTimer sync_timer(FallbackPhase::kSync);
+    async = SyncTensorsGraphInternal(tensors, {}, config);
+    if (async != nullptr) {
+      async->mwait.Wait();
+    } else {
+      sync_timer.Discard();
+    }
+  }
+  std::vector<torch::lazy::BackendDataPtr> tensors_data = GatherTensorsXlaData(
+      *tensors, async != nullptr ? async->indices : absl::Span<const size_t>(),
+      async != nullptr ? async->tensors_data
+                       : absl::Span<const torch::lazy::BackendDataPtr>());
+  return FetchTensors(tensors, tensors_data,
+                      async != nullptr ? &async->indices : nullptr);
+}
+
+std::shared_ptr<XLAGraphExecutor::TensorsTransfer>
+XLAGraphExecutor::GetTensorsAsync(std::vector<XLATensorPtr>* tensors) {
+  TF_VLOG(4) << "Trying to asynchronously get the value of " << tensors->size()
+             << " tensor(s)";
   SyncTensorsConfig config;
   config.force_ltc_data = false;
   auto async = SyncTensorsGraphInternal(tensors, {}, config);
   if (async != nullptr) {
+    // Only waits for the execution to be dispatched, so that the result data
+    // is assigned its device buffers.
     async->mwait.Wait();
   }
   std::vector<torch::lazy::BackendDataPtr> tensors_data = GatherTensorsXlaData(
@@ -505,11 +1365,58 @@ std::vector<at::Tensor> XLAGraphExecutor::GetTensors(
       async != nullptr ? async->tensors_data
                        : absl::Span<const torch::lazy::BackendDataPtr>());
 
-  XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> literals,
-                      ReleaseGilAndTransferData(tensors_data));
+  // Same matching of the tensors to the gathered data as FetchTensors(),
+  // taken now since the tensors can change before the transfer is awaited.
+  auto transfer = std::make_shared<TensorsTransfer>();
+  size_t sync_index = 0;
+  for (size_t i = 0; i < tensors->size(); ++i) {
+    transfer->element_types_.push_back((*tensors)[i]->dtype());
+    if (async != nullptr && sync_index < async->indices.size() &&
+        i == async->indices[sync_index]) {
+      transfer->tensors_data_.push_back(std::nullopt);
+      ++sync_index;
+    } else {
+      transfer->tensors_data_.push_back((*tensors)[i]->CurrentTensorData());
+    }
+  }
 
-  return FetchTensors(tensors, literals,
-                      async != nullptr ? &async->indices : nullptr);
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  transfer->transfer_ =
+      client->TransferFromDeviceAsync(UnwrapXlaData(tensors_data));
+  TORCH_LAZY_COUNTER("GetTensorsAsync", 1);
+  return transfer;
+}
+
+bool XLAGraphExecutor::TensorsTransfer::IsReady() {
+  std::lock_guard<std::mutex> lock(lock_);
+  return results_.has_value() || transfer_ == nullptr || transfer_->IsReady();
+}
+
+std::vector<at::Tensor> XLAGraphExecutor::TensorsTransfer::Wait() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (!results_.has_value()) {
+    XLA_CHECK(transfer_ != nullptr) << "The transfer from device failed";
+    std::unique_ptr<runtime::ComputationClient::AsyncTransfer> transfer =
+        std::move(transfer_);
+    XLA_ASSIGN_OR_THROW(std::vector<xla::Literal> literals, transfer->Await());
+    std::vector<at::Tensor> results;
+    results.reserve(tensors_data_.size());
+    size_t literals_index = 0;
+    for (size_t i = 0; i < tensors_data_.size(); ++i) {
+      if (tensors_data_[i].has_value()) {
+        results.push_back(*tensors_data_[i]);
+      } else {
+        XLA_CHECK_LT(literals_index, literals.size());
+        results.push_back(MakeTensorFromXlaLiteral(
+            std::move(literals[literals_index]), element_types_[i]));
+        ++literals_index;
+      }
+    }
+    results_ = std::move(results);
+    tensors_data_.clear();
+  }
+  return *results_;
 }
 
 size_t XLAGraphExecutor::GetNumGraphHash() const {
@@ -553,9 +1460,20 @@ torch::lazy::hash_t XLAGraphExecutor::GetGraphHash(
     MergeHash({torch::lazy::MHash(ShardingUtil::GetAutoSharding()),
                torch::lazy::StringHash(
                    runtime::sys_util::GetEnvString("XLA_AUTO_SPMD_MESH", "")
+                       .c_str()),
+               torch::lazy::StringHash(
+                   runtime::sys_util::GetEnvString(
+                       "XLA_AUTO_SPMD_MESH_CANDIDATES", "")
                        .c_str())},
               &res_hash);
   }
+  if (GetAllReduceBucketCapBytes() > 0) {
+    MergeHash(torch::lazy::MHash(GetAllReduceBucketCapBytes()), &res_hash);
+  }
+  if (UseHierarchicalCollectives()) {
+    MergeHash(torch::lazy::MHash(std::string("hierarchical_collectives")),
+              &res_hash);
+  }
   DeviceContextArena::Get()->SaveOutputShapes(res_hash,
                                               std::move(output_shapes));
   DeviceContextArena::Get()->SaveGraphAsString(res_hash, tensors,
@@ -578,6 +1496,27 @@ void XLAGraphExecutor::MaybeDumpGraph(std::string name,
   }
 }
 
+const std::vector<XLATensor::ShardingSpecPtr>&
+XLAGraphExecutor::CachedComputation::GetOutputShardingSpecs(
+    const std::function<std::vector<xla::Shape>()>& get_output_shapes) {
+  std::call_once(output_sharding_specs_once_, [&]() {
+    TORCH_LAZY_COUNTER("UncachedOutputSharding", 1);
+    output_sharding_specs_ =
+        ShardingUtil::GetOutputSharding(get_output_shapes(), computation);
+  });
+  return output_sharding_specs_;
+}
+
+const std::vector<xla::Shape>&
+XLAGraphExecutor::CachedComputation::GetDynamoOutputShapes(
+    const std::function<std::vector<xla::Shape>()>& get_output_shapes) {
+  std::call_once(dynamo_output_shapes_once_, [&]() {
+    TORCH_LAZY_COUNTER("UncachedDynamoOutputShapes", 1);
+    dynamo_output_shapes_ = get_output_shapes();
+  });
+  return dynamo_output_shapes_;
+}
+
 bool XLAGraphExecutor::IsComputationCacheInitialized() {
   return computation_cache_ != nullptr;
 }
@@ -589,31 +1528,179 @@ XLAGraphExecutor::ComputationCache* XLAGraphExecutor::GetComputationCache() {
   return computation_cache_;
 }
 
-void XLAGraphExecutor::ClearPendingIrs(
-    std::vector<XLATensorPtr> tensors,
-    const torch::lazy::BackendDevice& device) {
-  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
-                      runtime::GetComputationClient());
-  std::unordered_set<int64_t> tensor_ids;
-  for (size_t i = 0; i < tensors.size(); ++i) {
-    if (tensor_ids.insert(tensors[i]->GetUniqueId()).second &&
-        tensors[i]->CurrentDataHandle() == nullptr) {
-      torch::lazy::Value ir_value = tensors[i]->CurrentIrValue();
-      // Only clear the IR that is not a DeviceData Node.
-      if (ir_value) {
-        DeviceData* device_data =
-            torch_xla::DeviceData::Cast(ir_value.node.get());
-        if (device_data != nullptr) {
-          tensors[i]->data()->handle = device_data->data();
-        } else {
-          xla::Shape shape = MakeShapeWithDeviceLayout(
-              tensors[i]->shape(), static_cast<XlaDeviceType>(device.type()));
-          torch::lazy::BackendDataPtr handle = client->CreateDataPlaceholder(
-              device.toString(), std::move(shape));
-          tensors[i]->data()->handle = handle;
-          TF_VLOG(4) << "Replacing the IR " << ir_value.node.get()->ToString()
-                     << " of Tensor with ID " << tensors[i]->GetUniqueId()
-                     << " with placeholder";
+void XLAGraphExecutor::WaitPendingCompilations(
+    absl::Span<const torch::lazy::hash_t> hashes) {
+  tsl::profiler::TraceMe activity("WaitPendingCompilations",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  std::vector<PendingCompilation> pending;
+  {
+    std::lock_guard<std::mutex> lock(pending_compilations_lock_);
+    if (hashes.empty()) {
+      for (auto& hash_pending : pending_compilations_) {
+        pending.push_back(hash_pending.second);
+      }
+    } else {
+      for (auto& hash : hashes) {
+        auto it = pending_compilations_.find(hash);
+        if (it != pending_compilations_.end()) {
+          pending.push_back(it->second);
+        }
+      }
+    }
+  }
+  for (auto& pending_computation : pending) {
+    pending_computation.get();
+  }
+}
+
+size_t XLAGraphExecutor::GetNumPendingCompilations() {
+  std::lock_guard<std::mutex> lock(pending_compilations_lock_);
+  return pending_compilations_.size();
+}
+
+std::optional<XLAGraphExecutor::PendingCompilation>
+XLAGraphExecutor::LookupPendingCompilation(const torch::lazy::hash_t& hash) {
+  std::lock_guard<std::mutex> lock(pending_compilations_lock_);
+  auto it = pending_compilations_.find(hash);
+  if (it == pending_compilations_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+XLAGraphExecutor::PendingCompilation XLAGraphExecutor::ScheduleCompile(
+    const torch::lazy::hash_t& hash,
+    std::vector<runtime::ComputationClient::CompileInstance> instances,
+    xla::Shape output_shape, bool is_sharded) {
+  auto promise = std::make_shared<std::promise<ComputationCache::TypePtr>>();
+  PendingCompilation pending = promise->get_future().share();
+  {
+    std::lock_guard<std::mutex> lock(pending_compilations_lock_);
+    pending_compilations_.emplace(hash, pending);
+  }
+  TORCH_LAZY_COUNTER("AsyncCompile", 1);
+
+  // CompileInstance only holds a pointer to the output shape, so the shape
+  // needs to be owned by the closure.
+  auto shape = std::make_shared<xla::Shape>(std::move(output_shape));
+  using CompileInstances =
+      std::vector<runtime::ComputationClient::CompileInstance>;
+  auto compile_instances =
+      std::make_shared<CompileInstances>(std::move(instances));
+  for (auto& instance : *compile_instances) {
+    instance.output_shape = shape.get();
+  }
+  auto compilefn = [this, hash, is_sharded, promise, shape,
+                    compile_instances]() {
+    tsl::profiler::TraceMe activity(
+        [&] {
+          return tsl::profiler::TraceMeEncode(
+              "XLAGraphExecutor::ScheduleCompile_compilefn",
+              {{"graph_hash", torch::lazy::HashToString(hash)}});
+        },
+        tsl::profiler::TraceMeLevel::kInfo);
+    ComputationCache::TypePtr cached_computation;
+    try {
+      XLA_ASSIGN_OR_THROW(
+          runtime::ComputationClient * absl_nonnull const client,
+          runtime::GetComputationClient());
+      int64_t compile_start_ns = runtime::sys_util::NowNs();
+      std::vector<std::shared_ptr<runtime::ComputationClient::Computation>>
+          computations = client->Compile(std::move(*compile_instances));
+      graph_stats_.RecordCompilation(
+          hash, runtime::sys_util::NowNs() - compile_start_ns);
+      RecordTimelineEvent(runtime::timeline::Phase::kCompile, compile_start_ns,
+                          hash);
+      DebugUtil::post_compilation_analysis(computations[0]);
+      cached_computation = std::make_shared<CachedComputation>(
+          std::move(computations.front()), is_sharded);
+      // Add to the cache before dropping the pending entry, so that a lookup
+      // always finds the computation in one of the two places.
+      GetComputationCache()->Add(hash, cached_computation);
+      TF_VLOG(3) << "Background compilation of IR graph hash "
+                 << torch::lazy::HashToString(hash) << " done!";
+    } catch (...) {
+      TF_LOG(ERROR) << "Background compilation of IR graph hash "
+                    << torch::lazy::HashToString(hash) << " failed";
+      {
+        std::lock_guard<std::mutex> lock(pending_compilations_lock_);
+        pending_compilations_.erase(hash);
+      }
+      promise->set_exception(std::current_exception());
+      SchedulePendingExecutions(hash);
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(pending_compilations_lock_);
+      pending_compilations_.erase(hash);
+    }
+    promise->set_value(std::move(cached_computation));
+    SchedulePendingExecutions(hash);
+  };
+  thread::ScheduleCompile(std::move(compilefn));
+  return pending;
+}
+
+void XLAGraphExecutor::ScheduleAfterCompilation(
+    const torch::lazy::hash_t& hash, const PendingCompilation& pending,
+    std::function<void()> fn) {
+  {
+    // The compile thread sets the future before taking the lock to collect
+    // the waiting work, so work registered while the future is not ready is
+    // always collected.
+    std::lock_guard<std::mutex> lock(pending_compilations_lock_);
+    if (pending.wait_for(std::chrono::seconds::zero()) !=
+        std::future_status::ready) {
+      TORCH_LAZY_COUNTER("DeferredExecution", 1);
+      pending_executions_[hash].push_back(std::move(fn));
+      return;
+    }
+  }
+  thread::Schedule(std::move(fn));
+}
+
+void XLAGraphExecutor::SchedulePendingExecutions(
+    const torch::lazy::hash_t& hash) {
+  std::vector<std::function<void()>> executions;
+  {
+    std::lock_guard<std::mutex> lock(pending_compilations_lock_);
+    auto it = pending_executions_.find(hash);
+    if (it == pending_executions_.end()) {
+      return;
+    }
+    executions = std::move(it->second);
+    pending_executions_.erase(it);
+  }
+  for (auto& execution : executions) {
+    thread::Schedule(std::move(execution));
+  }
+}
+
+void XLAGraphExecutor::ClearPendingIrs(
+    std::vector<XLATensorPtr> tensors,
+    const torch::lazy::BackendDevice& device) {
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  std::unordered_set<int64_t> tensor_ids;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    if (tensor_ids.insert(tensors[i]->GetUniqueId()).second &&
+        tensors[i]->CurrentDataHandle() == nullptr) {
+      torch::lazy::Value ir_value = tensors[i]->CurrentIrValue();
+      // Only clear the IR that is not a DeviceData Node.
+      if (ir_value) {
+        DeviceData* device_data =
+            torch_xla::DeviceData::Cast(ir_value.node.get());
+        if (device_data != nullptr) {
+          tensors[i]->data()->handle = device_data->data();
+        } else {
+          xla::Shape shape = MakeShapeWithDeviceLayout(
+              tensors[i]->shape(), static_cast<XlaDeviceType>(device.type()));
+          torch::lazy::BackendDataPtr handle = client->CreateDataPlaceholder(
+              device.toString(), std::move(shape));
+          tensors[i]->data()->handle = handle;
+          TF_VLOG(4) << "Replacing the IR " << ir_value.node.get()->ToString()
+                     << " of Tensor with ID " << tensors[i]->GetUniqueId()
+                     << " with placeholder";
         }
         tensors[i]->AssignIrValue(torch::lazy::Value());
         tensors[i]->data()->view = nullptr;
@@ -627,6 +1714,9 @@ XLAGraphExecutor::SyncTensorCollection XLAGraphExecutor::CollectSyncTensors(
     const std::vector<XLATensorPtr>& tensors, const SyncTensorsConfig& config) {
   tsl::profiler::TraceMe activity("CollectSyncTensors",
                                   tsl::profiler::TraceMeLevel::kInfo);
+  TORCH_LAZY_TIMED("CollectSyncTensors");
+  // The tensors whose IR is a pooled scalar take over its device data.
+  ScalarPool::Get()->Flush();
   torch::lazy::Unique<torch::lazy::BackendDevice> unique_device;
   for (size_t i = 0; i < tensors.size(); ++i) {
     unique_device.set(tensors[i]->GetDevice());
@@ -641,18 +1731,9 @@ XLAGraphExecutor::SyncTensorCollection XLAGraphExecutor::CollectSyncTensors(
   std::vector<XLATensor::ShardingSpecPtr> shardings;
   std::vector<size_t> at_tensor_index;
   std::unordered_set<int64_t> tensor_ids;
-  // The force_ltc_data controls aliasing compilation, so effectively the same
-  // graph with on/off force_ltc_data should not match, hash wise.
-  coll.hash = torch::lazy::MHash(config.force_ltc_data);
-  // Ensure that the compilation environment and git revisions are reflected
-  // in the hash, so that different versions of the code can produce different
-  // hashes for the same graph.
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
                       runtime::GetComputationClient());
-  MergeHash(
-      {client->HashCompilationEnv(), torch::lazy::StringHash(TORCH_GITREV),
-       torch::lazy::StringHash(XLA_GITREV)},
-      &coll.hash);
+  coll.hash = GetGraphHashSeed(client, config.force_ltc_data);
   coll.config = config;
   coll.device = *unique_device;
   coll.indices.reserve(tensors.size());
@@ -741,6 +1822,218 @@ void XLAGraphExecutor::TensorCollectionBarrier(SyncTensorCollection* coll) {
              << " done";
 }
 
+XLAGraphExecutor::InflightSteps::DeviceSteps*
+XLAGraphExecutor::InflightSteps::GetDeviceSteps(const std::string& device) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<DeviceSteps>& steps = devices_[device];
+  if (steps == nullptr) {
+    steps = std::make_unique<DeviceSteps>();
+  }
+  return steps.get();
+}
+
+void XLAGraphExecutor::InflightSteps::Start(const std::string& device) {
+  static const int64_t max_inflight_steps =
+      runtime::sys_util::GetEnvInt("XLA_MAX_INFLIGHT_STEPS", 0);
+  DeviceSteps* steps = GetDeviceSteps(device);
+  std::unique_lock<std::mutex> lock(steps->mutex);
+  if (max_inflight_steps > 0 && steps->inflight >= max_inflight_steps) {
+    TORCH_LAZY_TIMED("InflightStepsWait");
+    steps->cv.wait(lock,
+                   [&] { return steps->inflight < max_inflight_steps; });
+  }
+  ++steps->inflight;
+}
+
+void XLAGraphExecutor::InflightSteps::Dispatched(const std::string& device) {
+  static torch::lazy::Metric* idle_time_metric =
+      new torch::lazy::Metric("DeviceIdleTime", torch::lazy::MetricFnTime);
+  DeviceSteps* steps = GetDeviceSteps(device);
+  std::lock_guard<std::mutex> lock(steps->mutex);
+  if (steps->executing++ == 0 && steps->idle_since_ns > 0) {
+    idle_time_metric->AddSample(runtime::sys_util::NowNs() -
+                                steps->idle_since_ns);
+  }
+}
+
+void XLAGraphExecutor::InflightSteps::Finish(const std::string& device,
+                                             bool dispatched) {
+  DeviceSteps* steps = GetDeviceSteps(device);
+  {
+    std::lock_guard<std::mutex> lock(steps->mutex);
+    --steps->inflight;
+    if (dispatched && --steps->executing == 0) {
+      steps->idle_since_ns = runtime::sys_util::NowNs();
+    }
+  }
+  steps->cv.notify_all();
+}
+
+std::optional<torch::lazy::hash_t> XLAGraphExecutor::GraphPredictor::Next(
+    const std::string& device, const torch::lazy::hash_t& hash) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  DeviceGraphs& graphs = devices_[device];
+  if (graphs.predicted) {
+    if (*graphs.predicted == hash) {
+      TORCH_LAZY_COUNTER("GraphPredictionHits", 1);
+    } else {
+      TORCH_LAZY_COUNTER("GraphPredictionMisses", 1);
+    }
+  }
+  if (graphs.last) {
+    successors_[*graphs.last] = hash;
+  }
+  graphs.last = hash;
+  auto it = successors_.find(hash);
+  graphs.predicted = it != successors_.end()
+                         ? std::optional<torch::lazy::hash_t>(it->second)
+                         : std::nullopt;
+  return graphs.predicted;
+}
+
+XLAGraphExecutor::GraphStatsTracker::Entry*
+XLAGraphExecutor::GraphStatsTracker::GetEntry(const torch::lazy::hash_t& hash) {
+  Entry& entry = graphs_[hash];
+  entry.stats.hash = hash;
+  return &entry;
+}
+
+void XLAGraphExecutor::GraphStatsTracker::RecordCompilation(
+    const torch::lazy::hash_t& hash, int64_t compile_time_ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry* entry = GetEntry(hash);
+  ++entry->stats.compilations;
+  entry->stats.compile_time_ns += compile_time_ns;
+}
+
+void XLAGraphExecutor::GraphStatsTracker::RecordExecution(
+    const torch::lazy::hash_t& hash,
+    const runtime::ComputationClient::Computation& computation) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry* entry = GetEntry(hash);
+  if (entry->stats.executions++ == 0) {
+    const xla::ProgramShape& program_shape = computation.program_shape();
+    for (const xla::Shape& parameter : program_shape.parameters()) {
+      entry->stats.input_bytes += ShapeBytes(parameter);
+    }
+    entry->stats.output_bytes = ShapeBytes(program_shape.result());
+    std::optional<runtime::ComputationClient::Computation::CostAnalysis>
+        cost_analysis = computation.cost_analysis();
+    if (cost_analysis.has_value()) {
+      entry->stats.flops = cost_analysis->flops;
+      entry->stats.bytes_accessed = cost_analysis->bytes_accessed;
+      entry->stats.transcendentals = cost_analysis->transcendentals;
+    }
+  }
+  entry->stats.last_step = step_;
+}
+
+int64_t XLAGraphExecutor::GraphStatsTracker::RecordExecuteTime(
+    const torch::lazy::hash_t& hash, const std::string& device,
+    int64_t dispatch_ns) {
+  int64_t now_ns = runtime::sys_util::NowNs();
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t& device_ready_ns = device_ready_ns_[device];
+  int64_t execute_time_ns = now_ns - std::max(dispatch_ns, device_ready_ns);
+  device_ready_ns = now_ns;
+  Entry* entry = GetEntry(hash);
+  step_flops_ += entry->stats.flops;
+  step_execute_ns_ += execute_time_ns;
+  std::vector<int64_t>& execute_times = entry->stats.execute_times_ns;
+  if (execute_times.size() < kMaxExecuteTimes) {
+    execute_times.push_back(execute_time_ns);
+  } else {
+    execute_times[entry->next_execute_time] = execute_time_ns;
+    entry->next_execute_time =
+        (entry->next_execute_time + 1) % kMaxExecuteTimes;
+  }
+  return execute_time_ns;
+}
+
+int64_t XLAGraphExecutor::GraphStatsTracker::MarkStep() {
+  ++step_;
+  double flops;
+  int64_t execute_ns;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    flops = step_flops_;
+    execute_ns = step_execute_ns_;
+    step_flops_ = 0;
+    step_execute_ns_ = 0;
+  }
+  if (flops <= 0 || execute_ns <= 0) {
+    return execute_ns;
+  }
+  // FLOPs per picosecond are TFLOP/s.
+  double tflops = flops / (execute_ns * 1000.0);
+  XLA_VALUE_METRIC("StepTflops", tflops);
+  if (PeakTflops() > 0) {
+    XLA_VALUE_METRIC("StepModelFlopsUtilization", tflops / PeakTflops());
+  }
+  return execute_ns;
+}
+
+std::vector<XLAGraphExecutor::GraphStats>
+XLAGraphExecutor::GraphStatsTracker::Get() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<GraphStats> stats;
+  stats.reserve(graphs_.size());
+  for (const auto& [hash, entry] : graphs_) {
+    GraphStats& graph_stats = stats.emplace_back(entry.stats);
+    std::rotate(graph_stats.execute_times_ns.begin(),
+                graph_stats.execute_times_ns.begin() + entry.next_execute_time,
+                graph_stats.execute_times_ns.end());
+  }
+  return stats;
+}
+
+std::vector<XLAGraphExecutor::GraphStats> XLAGraphExecutor::GetGraphStats() {
+  return graph_stats_.Get();
+}
+
+std::string XLAGraphExecutor::CreateGraphStatsReport() {
+  std::stringstream ss;
+  for (GraphStats& stats : GetGraphStats()) {
+    ss << "Graph: " << torch::lazy::HashToString(stats.hash) << std::endl;
+    ss << "  Executions: " << stats.executions << std::endl;
+    if (!stats.execute_times_ns.empty()) {
+      std::vector<int64_t>& times = stats.execute_times_ns;
+      std::sort(times.begin(), times.end());
+      ss << "  ExecuteTime: 50%="
+         << runtime::metrics::MetricFnTime(times[times.size() / 2])
+         << "; 99%="
+         << runtime::metrics::MetricFnTime(times[times.size() * 99 / 100])
+         << std::endl;
+    }
+    if (stats.flops > 0) {
+      ss << "  Flops: " << stats.flops << std::endl;
+      ss << "  BytesAccessed: "
+         << runtime::metrics::MetricFnBytes(stats.bytes_accessed) << std::endl;
+      if (!stats.execute_times_ns.empty()) {
+        // At the median execute time.
+        double tflops =
+            stats.flops /
+            (stats.execute_times_ns[stats.execute_times_ns.size() / 2] *
+             1000.0);
+        ss << "  Tflops: " << tflops << std::endl;
+        if (PeakTflops() > 0) {
+          ss << "  ModelFlopsUtilization: " << tflops / PeakTflops()
+             << std::endl;
+        }
+      }
+    }
+    ss << "  Compilations: " << stats.compilations << std::endl;
+    ss << "  CompileTime: "
+       << runtime::metrics::MetricFnTime(stats.compile_time_ns) << std::endl;
+    ss << "  InputBytes: " << runtime::metrics::MetricFnBytes(stats.input_bytes)
+       << std::endl;
+    ss << "  OutputBytes: "
+       << runtime::metrics::MetricFnBytes(stats.output_bytes) << std::endl;
+    ss << "  LastStep: " << stats.last_step << std::endl;
+  }
+  return ss.str();
+}
+
 std::vector<torch::lazy::BackendDataPtr>
 XLAGraphExecutor::ExecuteComputationWithBarrier(
     torch::lazy::hash_t hash, const std::vector<at::IValue>& graph_inputs,
@@ -748,54 +2041,48 @@ XLAGraphExecutor::ExecuteComputationWithBarrier(
   tsl::profiler::TraceMe activity("ExecuteComputationWithBarrier",
                                   tsl::profiler::TraceMeLevel::kInfo);
   MaybeDumpGraph("dynamo", hash);
+  // The graph might have been warmed up by a background compilation.
+  WaitPendingCompilations({hash});
   auto cachedComputation =
       XLAGraphExecutor::Get()->GetComputationCache()->Get(hash);
-  TF_VLOG(5) << "Cached computation (hash: " << torch::lazy::HashToString(hash)
-             << ") is_sharded=" << cachedComputation->is_sharded << std::endl;
-
   // TODO implement a fallback mechanism, or make sure those entries
   // never get kicked out
   XLA_CHECK(cachedComputation)
       << "Failed to get computation by hash " << torch::lazy::HashToString(hash)
       << ". Maybe the entry get "
          "kicked out of the LRU cache";
+  TF_VLOG(5) << "Cached computation (hash: " << torch::lazy::HashToString(hash)
+             << ") is_sharded=" << cachedComputation->is_sharded << std::endl;
 
   DebugUtil::analyze_graph_execution_python_frame(
       DebugUtil::GraphAnalysisSource::DynamoExecution,
       /*graph_hash=*/hash,
       /*program_shape=*/&(cachedComputation->computation->program_shape()));
 
+  // The output shapes are looked up on the first call only, so that the
+  // following ones only bind the data.
+  const std::vector<xla::Shape>& output_shapes =
+      cachedComputation->GetDynamoOutputShapes([&]() {
+        return *DeviceContextArena::Get()->GetOutputShapesByHash(hash);
+      });
+
   // Create DataPlaceHolder that will get filled in async executions.
-  const std::vector<xla::Shape>* output_shapes =
-      DeviceContextArena::Get()->GetOutputShapesByHash(hash);
   std::vector<torch::lazy::BackendDataPtr> placeholders;
+  placeholders.reserve(output_shapes.size());
 
   std::vector<XLATensor::ShardingSpecPtr> sharding_specs;
   if (static_cast<XlaDeviceType>(device.type()) == XlaDeviceType::SPMD) {
-    sharding_specs =
-        std::vector<XLATensor::ShardingSpecPtr>(output_shapes->size());
-    // TODO(JackCaoG): Use LRU cache and add same cache to non-dynamo path.
-    static std::unordered_map<torch::lazy::hash_t,
-                              std::vector<XLATensor::ShardingSpecPtr>,
-                              torch::lazy::HashReducer>
-        output_sharding_hash;
     // For any given graph(each hash correspodning to one graph) there is only
-    // one output sharding. We can cache this sharding here to avoid retrive
-    // the sharding from the computation every time.
-    if (output_sharding_hash.find(hash) == output_sharding_hash.end()) {
-      TORCH_LAZY_COUNTER("UncachedOutputSharding", 1);
-      output_sharding_hash[hash] = ShardingUtil::GetOutputSharding(
-          *output_shapes, cachedComputation->computation);
-    }
-    placeholders =
-        ShardingUtil::CreateShardedPlaceholder(output_sharding_hash[hash]);
+    // one output sharding, which the cached computation keeps.
+    sharding_specs = cachedComputation->GetOutputShardingSpecs(
+        [&]() { return output_shapes; });
+    placeholders = ShardingUtil::CreateShardedPlaceholder(sharding_specs);
   } else {
     XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
                         runtime::GetComputationClient());
-    for (const xla::Shape& shape : *output_shapes) {
-      torch::lazy::BackendDataPtr handle =
-          client->CreateDataPlaceholder(device.toString(), std::move(shape));
-      placeholders.push_back(handle);
+    std::string device_str = device.toString();
+    for (const xla::Shape& shape : output_shapes) {
+      placeholders.push_back(client->CreateDataPlaceholder(device_str, shape));
     }
   }
 
@@ -810,44 +2097,55 @@ XLAGraphExecutor::ExecuteComputationWithBarrier(
   }
 
   std::vector<torch::lazy::BackendDataPtr> arguments;
+  arguments.reserve(graph_inputs.size());
   {
     // GetXlaData must be called within a lock region, otherwise it might
     // extract the placeholder inserted by previous execution.
     TORCH_LAZY_TIMED("RunCachedGraphInputData");
+    auto host_data = [&](const at::Tensor& tensor) {
+      XLA_CHECK(device.type() != (int8_t)XlaDeviceType::SPMD)
+          << "SPMD device data should already be on the XLA backend "
+             "(XLATensor).";
+      return torch_xla::TensorToXlaData(tensor, device);
+    };
     // setup the arguments
-    for (auto& ivalue : graph_inputs) {
-      torch::lazy::BackendDataPtr dataptr;
-      auto xla_tensor_status = bridge::GetXlaTensor(ivalue.toTensor());
-      if (xla_tensor_status.ok()) {
-        auto xla_tensor = std::move(xla_tensor_status).value();
-        bool is_non_data_ir =
-            xla_tensor->CurrentIrValue().node != nullptr &&
-            (torch_xla::DeviceData::Cast(
-                 xla_tensor->CurrentIrValue().node.get()) == nullptr);
-        XLA_CHECK(!is_non_data_ir)
-            << "input data to dynamo graph can not be a pending ir, please set "
-               "`torch_xla._dynamo.config.skip_input_data_check` to False";
-        dataptr = xla_tensor->GetXlaData();
-      } else {
-        XLA_CHECK(device.type() != (int8_t)XlaDeviceType::SPMD)
-            << "SPMD device data should already be on the XLA backend "
-               "(XLATensor).";
-        dataptr = torch_xla::TensorToXlaData(ivalue.toTensor(), device);
+    for (const at::IValue& ivalue : graph_inputs) {
+      const at::Tensor& tensor = ivalue.toTensor();
+      if (tensor.device().type() != at::DeviceType::XLA) {
+        // Not looked up as an XLA tensor, which would fail with an error
+        // status.
+        arguments.push_back(host_data(tensor));
+        continue;
       }
-      arguments.push_back(dataptr);
+      auto xla_tensor_status = bridge::GetXlaTensor(tensor);
+      if (!xla_tensor_status.ok()) {
+        arguments.push_back(host_data(tensor));
+        continue;
+      }
+      XLATensorPtr xla_tensor = std::move(xla_tensor_status).value();
+      torch::lazy::Value ir_value = xla_tensor->CurrentIrValue();
+      bool is_non_data_ir =
+          ir_value.node != nullptr &&
+          torch_xla::DeviceData::Cast(ir_value.node.get()) == nullptr;
+      XLA_CHECK(!is_non_data_ir)
+          << "input data to dynamo graph can not be a pending ir, please set "
+             "`torch_xla._dynamo.config.skip_input_data_check` to False";
+      arguments.push_back(xla_tensor->GetXlaData());
     }
   }
 
   std::shared_ptr<XLAGraphExecutor::Async> async = std::make_shared<Async>(
       &coll, std::move(arguments), placeholders, std::move(cachedComputation));
 
-  auto syncfn = [async, hash, sharding_specs]() {
+  auto syncfn = [this, async, hash, sharding_specs]() {
     try {
       tsl::profiler::TraceMe activity("ExecuteComputationWithBarrier_syncfn",
                                       tsl::profiler::TraceMeLevel::kInfo);
       TF_VLOG(3) << "Executing Dynamo IR graph hash "
                  << torch::lazy::HashToString(hash) << " on device "
                  << async->device << " ...";
+      graph_stats_.RecordExecution(hash,
+                                   *async->cached_computation->computation);
 
       std::vector<torch::lazy::BackendDataPtr> results;
       if (async->cached_computation->is_sharded) {
@@ -909,37 +2207,227 @@ XLAGraphExecutor::ExecuteComputationWithBarrier(
   return placeholders;
 }
 
+std::shared_ptr<XLAGraphExecutor::CapturedGraph>
+XLAGraphExecutor::CaptureGraph(const std::vector<XLATensorPtr>& inputs,
+                               const std::vector<XLATensorPtr>& outputs) {
+  tsl::profiler::TraceMe activity("CaptureGraph",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  TORCH_LAZY_TIMED("CaptureGraph");
+  XLA_CHECK(!ShardingUtil::GetAutoSharding())
+      << "Graph capture is not supported with auto-sharding";
+  // The inputs are synced along with the outputs, so that the ones updated in
+  // place become results of the computation, and can donate their buffers.
+  std::vector<XLATensorPtr> tensors(outputs.begin(), outputs.end());
+  tensors.insert(tensors.end(), inputs.begin(), inputs.end());
+  std::unordered_map<int64_t, int64_t> input_ids;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    input_ids.emplace(inputs[i]->GetUniqueId(), i);
+  }
+  auto input_index = [&](const XLATensorPtr& tensor) -> int64_t {
+    auto it = input_ids.find(tensor->GetUniqueId());
+    return it != input_ids.end() ? it->second : -1;
+  };
+
+  // Same config as a step barrier, and as the sync below, so that the hash
+  // and the parameters computed here are the ones of the synced graph.
+  SyncTensorsConfig config;
+  SyncTensorCollection coll = CollectSyncTensors(tensors, config);
+  XLA_CHECK(!coll.indices.empty())
+      << "The captured outputs do not need any computation";
+  std::vector<torch::lazy::Value> ir_values =
+      CollectRoots(tensors, coll.indices);
+  PostOrderData po_data = RunPostOrder(ir_values, &coll);
+  std::vector<size_t> buffer_donor_indices =
+      FinalizeGraphHash(tensors, &coll, po_data);
+
+  auto graph = std::make_shared<CapturedGraph>();
+  graph->hash = coll.hash;
+  graph->device = coll.device;
+  for (const XLATensorPtr& input : inputs) {
+    XLA_CHECK_EQ(input->GetDevice(), coll.device);
+    graph->input_shapes.push_back(input->shape().get());
+  }
+  for (const torch::lazy::BackendDataPtr& data : po_data.parameters_data) {
+    auto* data_info =
+        static_cast<torch::lazy::LazyGraphExecutor::DeviceDataInfo*>(
+            data->info());
+    auto it = data_info != nullptr ? input_ids.find(data_info->tensor_id)
+                                   : input_ids.end();
+    if (it != input_ids.end()) {
+      graph->parameter_inputs.push_back(it->second);
+      graph->parameters_data.push_back(nullptr);
+    } else {
+      graph->parameter_inputs.push_back(-1);
+      graph->parameters_data.push_back(data);
+    }
+  }
+  std::unordered_map<int64_t, int64_t> result_ids;
+  for (size_t i = 0; i < coll.indices.size(); ++i) {
+    const XLATensorPtr& tensor = tensors[coll.indices[i]];
+    result_ids.emplace(tensor->GetUniqueId(), i);
+    graph->result_inputs.push_back(input_index(tensor));
+    graph->result_element_types.push_back(tensor->dtype_optional());
+  }
+  // A donated buffer is invalidated by the execution, so it must belong to an
+  // input that gets the new value on every replay.
+  for (size_t index : buffer_donor_indices) {
+    int64_t input = graph->parameter_inputs[index];
+    XLA_CHECK(input >= 0 &&
+              std::find(graph->result_inputs.begin(),
+                        graph->result_inputs.end(),
+                        input) != graph->result_inputs.end())
+        << "Captured graphs can only donate the buffers of the inputs they "
+           "update in place, parameter "
+        << index << " is not one of them";
+  }
+  for (const XLATensorPtr& output : outputs) {
+    auto it = result_ids.find(output->GetUniqueId());
+    graph->output_results.push_back(it != result_ids.end() ? it->second : -1);
+    graph->output_inputs.push_back(input_index(output));
+    graph->outputs.push_back(output);
+  }
+
+  SyncTensorsGraph(&tensors, /*devices=*/{}, /*wait=*/true,
+                   /*sync_ltc_data=*/true);
+  WaitPendingCompilations({graph->hash});
+  graph->cached_computation = GetComputationCache()->Get(graph->hash);
+  XLA_CHECK(graph->cached_computation != nullptr)
+      << "Failed to get the captured computation by hash "
+      << torch::lazy::HashToString(graph->hash);
+  for (size_t index : coll.indices) {
+    const XLATensorPtr& tensor = tensors[index];
+    graph->result_shapes.push_back(MakeShapeWithDeviceLayout(
+        tensor->shape(), static_cast<XlaDeviceType>(coll.device.type())));
+    graph->result_sharding_specs.push_back(tensor->sharding_spec());
+  }
+  TF_VLOG(3) << "Captured graph hash " << torch::lazy::HashToString(graph->hash)
+             << " with " << graph->parameter_inputs.size() << " parameters and "
+             << graph->result_inputs.size() << " results";
+  return graph;
+}
+
+std::vector<XLATensorPtr> XLAGraphExecutor::ReplayGraph(
+    const CapturedGraph& graph, const std::vector<XLATensorPtr>& inputs) {
+  tsl::profiler::TraceMe activity("ReplayGraph",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  TORCH_LAZY_TIMED("ReplayGraph");
+  XLA_CHECK_EQ(inputs.size(), graph.input_shapes.size())
+      << "Wrong number of inputs to replay the captured graph";
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    XLA_CHECK_EQ(inputs[i]->GetDevice(), graph.device);
+    XLA_CHECK(xla::ShapeUtil::Compatible(inputs[i]->shape().get(),
+                                         graph.input_shapes[i]))
+        << "Input " << i << " has shape " << inputs[i]->shape().get()
+        << ", but the graph was captured with "
+        << xla::ShapeUtil::HumanString(graph.input_shapes[i]);
+    torch::lazy::Value ir_value = inputs[i]->CurrentIrValue();
+    XLA_CHECK(!ir_value || DeviceData::Cast(ir_value.node.get()) != nullptr)
+        << "Input " << i << " of a captured graph has pending IR";
+  }
+
+  std::vector<torch::lazy::BackendDataPtr> parameters_data =
+      graph.parameters_data;
+  for (size_t i = 0; i < parameters_data.size(); ++i) {
+    if (graph.parameter_inputs[i] >= 0) {
+      parameters_data[i] = inputs[graph.parameter_inputs[i]]->GetXlaData();
+    }
+  }
+
+  std::vector<torch::lazy::BackendDataPtr> tensors_data;
+  if (graph.cached_computation->is_sharded) {
+    tensors_data =
+        ShardingUtil::CreateShardedPlaceholder(graph.result_sharding_specs);
+  } else {
+    XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                        runtime::GetComputationClient());
+    for (const xla::Shape& shape : graph.result_shapes) {
+      tensors_data.push_back(
+          client->CreateDataPlaceholder(graph.device.toString(), shape));
+    }
+  }
+  std::vector<XLATensorPtr> results;
+  results.reserve(tensors_data.size());
+  for (size_t i = 0; i < tensors_data.size(); ++i) {
+    if (graph.result_inputs[i] >= 0) {
+      results.push_back(inputs[graph.result_inputs[i]]);
+      results.back()->SetXlaData(tensors_data[i]);
+    } else {
+      results.push_back(XLATensor::Create(tensors_data[i],
+                                          graph.result_element_types[i]));
+      if (graph.result_sharding_specs[i] != nullptr) {
+        results.back()->SetShardingSpec(*graph.result_sharding_specs[i]);
+      }
+    }
+  }
+  std::vector<XLATensorPtr> outputs;
+  outputs.reserve(graph.outputs.size());
+  for (size_t i = 0; i < graph.outputs.size(); ++i) {
+    if (graph.output_results[i] >= 0) {
+      outputs.push_back(results[graph.output_results[i]]);
+    } else if (graph.output_inputs[i] >= 0) {
+      outputs.push_back(inputs[graph.output_inputs[i]]);
+    } else {
+      outputs.push_back(graph.outputs[i]);
+    }
+  }
+
+  SyncTensorCollection coll;
+  coll.hash = graph.hash;
+  coll.device = graph.device;
+  ScheduleSyncTensorsGraph(&coll, std::move(parameters_data),
+                           std::move(tensors_data),
+                           graph.result_sharding_specs,
+                           graph.cached_computation);
+  return outputs;
+}
+
 std::vector<torch::lazy::BackendDataPtr> XLAGraphExecutor::ExecuteStablehlo(
     std::string bytecode, const std::vector<at::IValue>& graph_inputs,
     const torch::lazy::BackendDevice& device) {
-  // Convert StableHLO to HLO for XLA compilation.
-  // TODO(lsy323): Pass StableHLO to PjrtComputationClient for compilation
-  // after StableHLO compilation API is added in ComputationClient.
-  mlir::MLIRContext context;
-  mlir::OwningOpRef<mlir::ModuleOp> module =
-      mlir::stablehlo::deserializePortableArtifact(bytecode, &context);
-  mlir::ModuleOp mlir_module = *module;
-  xla::HloProto hlo_proto;
-  ConvertStableHloToHlo(&mlir_module, &context, &hlo_proto);
-  xla::HloModuleProto* hlo_module_proto = hlo_proto.mutable_hlo_module();
-  xla::XlaComputation computation(*hlo_module_proto);
-
-  // Get program output shape.
-  // TODO(lsy323): Get shape info from MLIR Module.
-  XLA_ASSIGN_OR_THROW(xla::ProgramShape program_shape,
-                      computation.GetProgramShape());
-  xla::Shape shape = MakeShapeWithDeviceLayout(
-      program_shape.result(), static_cast<XlaDeviceType>(device.type()));
-
+  // The executables of the same bytecode are shared with the computation
+  // cache, and with the persistent cache when there is one, so that repeated
+  // calls skip the parsing, the conversion and the compilation.
+  torch::lazy::hash_t hash = torch::lazy::HashCombine(
+      torch::lazy::DataHash(bytecode.data(), bytecode.size()),
+      torch::lazy::MHash(std::string("ExecuteStablehlo"), device.toString()));
+  ComputationCache::TypePtr cached_computation =
+      GetComputationCache()->Get(hash);
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
                       runtime::GetComputationClient());
-  std::vector<runtime::ComputationClient::CompileInstance> instances;
-  instances.emplace_back(std::move(computation), device.toString(),
-                         client->GetCompilationDevices(
-                             device.toString(), client->GetLocalDevices()),
-                         &shape);
-  std::vector<std::shared_ptr<runtime::ComputationClient::Computation>>
-      computations = client->Compile(std::move(instances));
+  if (cached_computation != nullptr) {
+    TORCH_LAZY_COUNTER("CachedStablehloCompile", 1);
+  } else {
+    TORCH_LAZY_COUNTER("UncachedStablehloCompile", 1);
+    // Convert StableHLO to HLO for XLA compilation.
+    // TODO(lsy323): Pass StableHLO to PjrtComputationClient for compilation
+    // after StableHLO compilation API is added in ComputationClient.
+    mlir::MLIRContext context;
+    mlir::OwningOpRef<mlir::ModuleOp> module =
+        mlir::stablehlo::deserializePortableArtifact(bytecode, &context);
+    mlir::ModuleOp mlir_module = *module;
+    xla::HloProto hlo_proto;
+    ConvertStableHloToHlo(&mlir_module, &context, &hlo_proto);
+    xla::HloModuleProto* hlo_module_proto = hlo_proto.mutable_hlo_module();
+    xla::XlaComputation computation(*hlo_module_proto);
+
+    // Get program output shape.
+    // TODO(lsy323): Get shape info from MLIR Module.
+    XLA_ASSIGN_OR_THROW(xla::ProgramShape program_shape,
+                        computation.GetProgramShape());
+    xla::Shape shape = MakeShapeWithDeviceLayout(
+        program_shape.result(), static_cast<XlaDeviceType>(device.type()));
+
+    std::vector<runtime::ComputationClient::CompileInstance> instances;
+    instances.emplace_back(std::move(computation), device.toString(),
+                           client->GetCompilationDevices(
+                               device.toString(), client->GetLocalDevices()),
+                           &shape);
+    std::vector<std::shared_ptr<runtime::ComputationClient::Computation>>
+        computations = client->Compile(std::move(instances));
+    cached_computation =
+        std::make_shared<CachedComputation>(std::move(computations.front()));
+    GetComputationCache()->Add(hash, cached_computation);
+  }
 
   std::vector<torch::lazy::BackendDataPtr> arguments;
   {
@@ -960,8 +2448,8 @@ std::vector<torch::lazy::BackendDataPtr> XLAGraphExecutor::ExecuteStablehlo(
 
   XLA_ASSIGN_OR_THROW(
       std::vector<runtime::ComputationClient::DataPtr> result_data,
-      client->ExecuteComputation(*computations[0], UnwrapXlaData(arguments),
-                                 device.toString()));
+      client->ExecuteComputation(*cached_computation->computation,
+                                 UnwrapXlaData(arguments), device.toString()));
 
   return WrapXlaData(result_data);
 }
@@ -1054,6 +2542,7 @@ void XLAGraphExecutor::ExtractIRAndPrepareXlaData_(
     std::vector<torch::lazy::BackendDataPtr>& tensor_data_vec) {
   tsl::profiler::TraceMe activity("ExtractIRAndPrepareXlaData_",
                                   tsl::profiler::TraceMeLevel::kInfo);
+  TORCH_LAZY_TIMED("ExtractIRAndPrepareXlaData");
   ir_values.reserve(indices.size());
   tensor_data_vec.reserve(indices.size());
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
@@ -1076,33 +2565,45 @@ void XLAGraphExecutor::ExtractIRAndPrepareXlaData_(
 }
 
 std::vector<at::Tensor> XLAGraphExecutor::FetchTensors(
-    std::vector<XLATensorPtr>* tensors, absl::Span<const xla::Literal> literals,
+    std::vector<XLATensorPtr>* tensors,
+    absl::Span<const torch::lazy::BackendDataPtr> tensors_data,
     const std::vector<size_t>* indices) {
-  std::vector<at::Tensor> results;
-  size_t literals_index = 0;
+  std::vector<std::optional<at::Tensor>> results;
+  std::vector<at::ScalarType> element_types;
   size_t sync_index = 0;
   results.reserve(tensors->size());
   for (size_t i = 0; i < tensors->size(); ++i) {
     if (indices != nullptr && sync_index < indices->size() &&
         i == (*indices)[sync_index]) {
-      results.push_back(MakeTensorFromXlaLiteral(literals[literals_index],
-                                                 (*tensors)[i]->dtype()));
-      ++literals_index;
+      results.push_back(std::nullopt);
+      element_types.push_back((*tensors)[i]->dtype());
       ++sync_index;
     } else {
-      std::optional<at::Tensor> tensor_data =
-          (*tensors)[i]->CurrentTensorData();
-      if (tensor_data) {
-        results.push_back(*tensor_data);
-      } else {
-        XLA_CHECK_LT(literals_index, literals.size());
-        results.push_back(MakeTensorFromXlaLiteral(literals[literals_index],
-                                                   (*tensors)[i]->dtype()));
-        ++literals_index;
+      results.push_back((*tensors)[i]->CurrentTensorData());
+      if (!results.back()) {
+        element_types.push_back((*tensors)[i]->dtype());
       }
     }
   }
-  return results;
+  XLA_CHECK_EQ(element_types.size(), tensors_data.size());
+
+  // The values are converted as they land, rather than once all of them did.
+  FallbackPhaseTimer transfer_timer(FallbackPhase::kTransferFromDevice);
+  XLA_ASSIGN_OR_THROW(std::vector<at::Tensor> fetched,
+                      XlaDataToTensors(tensors_data, element_types));
+  std::vector<at::Tensor> tensors_out;
+  tensors_out.reserve(results.size());
+  size_t fetched_index = 0;
+  for (std::optional<at::Tensor>& result : results) {
+    if (result) {
+      tensors_out.push_back(std::move(*result));
+    } else {
+      transfer_timer.AddBytes(fetched[fetched_index].nbytes());
+      tensors_out.push_back(std::move(fetched[fetched_index]));
+      ++fetched_index;
+    }
+  }
+  return tensors_out;
 }
 
 std::shared_ptr<XLAGraphExecutor::Async>
@@ -1111,20 +2612,43 @@ XLAGraphExecutor::ScheduleSyncTensorsGraph(
     std::vector<torch::lazy::BackendDataPtr> parameters_data,
     std::vector<torch::lazy::BackendDataPtr> tensors_data,
     std::vector<XLATensor::ShardingSpecPtr> sharding_specs,
-    ComputationCache::TypePtr cached_computation) {
-  DebugUtil::analyze_graph_execution_python_frame(
-      DebugUtil::GraphAnalysisSource::Execution,
-      /*graph_hash=*/coll->hash,
-      /*program_shape=*/&(cached_computation->computation->program_shape()));
+    ComputationCache::TypePtr cached_computation,
+    PendingCompilation pending_computation) {
+  XLA_CHECK(cached_computation != nullptr || pending_computation.valid());
+  // The execution analysis of a graph which is still being compiled has
+  // already been covered by the compilation analysis.
+  if (cached_computation != nullptr) {
+    DebugUtil::analyze_graph_execution_python_frame(
+        DebugUtil::GraphAnalysisSource::Execution,
+        /*graph_hash=*/coll->hash,
+        /*program_shape=*/&(cached_computation->computation->program_shape()));
+  }
   tsl::profiler::TraceMe activity("ScheduleSyncTensorsGraph",
                                   tsl::profiler::TraceMeLevel::kInfo);
+  TORCH_LAZY_TIMED("ScheduleSyncTensorsGraph");
   TensorCollectionBarrier(coll);
+  // The outputs of the previous steps are placeholders which the execution of
+  // this one can consume right away, the bound only keeps the host from
+  // running arbitrarily far ahead of the device.
+  inflight_steps_.Start(coll->device.toString());
+  StageNextComputation(coll->hash, coll->device);
   std::shared_ptr<XLAGraphExecutor::Async> async = std::make_shared<Async>(
       coll, std::move(parameters_data), std::move(tensors_data),
       std::move(cached_computation));
-  auto syncfn = [async, hash = coll->hash, sharding_specs = sharding_specs,
-                 use_eager_mode = UseEagerMode()]() {
+  auto syncfn = [this, async, hash = coll->hash,
+                 sharding_specs = sharding_specs,
+                 use_eager_mode = UseEagerMode(), pending_computation]() {
+    std::string step_device = async->device.toString();
+    bool dispatched = false;
+    int64_t dispatch_ns = 0;
+    // The outputs written into the buffers of the output arena.
+    std::vector<size_t> arena_outputs;
     try {
+      if (async->cached_computation == nullptr) {
+        // Only scheduled once the background compilation has landed, so this
+        // does not block.
+        async->cached_computation = pending_computation.get();
+      }
       std::vector<torch::lazy::BackendDataPtr> results;
       // Execute replicated if the compiled computation is partitioned.
       XLA_ASSIGN_OR_THROW(
@@ -1133,6 +2657,13 @@ XLAGraphExecutor::ScheduleSyncTensorsGraph(
       if (async->cached_computation->is_sharded) {
         std::vector<std::string> devices = client->GetLocalDevices();
         runtime::ComputationClient::ExecuteReplicatedOptions execute_options;
+        CheckMemoryAdmission(client, *async->cached_computation->computation,
+                             devices, hash);
+        inflight_steps_.Dispatched(step_device);
+        dispatched = true;
+        dispatch_ns = runtime::sys_util::NowNs();
+        graph_stats_.RecordExecution(hash,
+                                     *async->cached_computation->computation);
         TF_VLOG(3) << "Executing IR graph hash "
                    << torch::lazy::HashToString(hash)
                    << " on devices: " << absl::StrJoin(devices, ",");
@@ -1151,22 +2682,44 @@ XLAGraphExecutor::ScheduleSyncTensorsGraph(
                    << " on devices: " << absl::StrJoin(devices, ",")
                    << " done!";
       } else {
+        const runtime::ComputationClient::Computation& computation =
+            *async->cached_computation->computation;
+        std::vector<runtime::ComputationClient::DataPtr> arguments =
+            UnwrapXlaData(async->parameters_data);
+        size_t arena_allocations = 0;
+        arena_outputs = OutputArena::Get()->Bind(
+            hash, computation, step_device, &arguments, &arena_allocations);
+        CheckMemoryAdmission(client, computation, {step_device}, hash);
+        inflight_steps_.Dispatched(step_device);
+        dispatched = true;
+        dispatch_ns = runtime::sys_util::NowNs();
+        graph_stats_.RecordExecution(hash,
+                                     *async->cached_computation->computation);
         TF_VLOG(3) << "Executing IR graph hash "
                    << torch::lazy::HashToString(hash) << " on device "
                    << async->device << " ...";
         XLA_ASSIGN_OR_THROW(
             std::vector<runtime::ComputationClient::DataPtr> outputs,
-            client->ExecuteComputation(*async->cached_computation->computation,
-                                       UnwrapXlaData(async->parameters_data),
+            client->ExecuteComputation(computation, arguments,
                                        async->device.toString(),
                                        {/*explode_tuple=*/true,
                                         /*eager_mode=*/use_eager_mode}));
         results = WrapXlaData(outputs);
         TORCH_LAZY_COUNTER("ExecuteComputation", 1);
+        // The outputs which are not aliased with a parameter get new device
+        // buffers, as do the arena parameters which could not be reused.
+        TORCH_LAZY_VALUE_METRIC(
+            "OutputDeviceAllocations",
+            results.size() -
+                std::min(CountAliasedOutputs(computation), results.size()) +
+                arena_allocations);
         TF_VLOG(3) << "Executing IR graph hash "
                    << torch::lazy::HashToString(hash) << " on device "
                    << async->device << " done!";
       }
+      // All the outputs of an execution become ready together.
+      runtime::ComputationClient::DataPtr ready_data =
+          results.empty() ? nullptr : UnwrapXlaData(results.front());
       for (size_t i = 0; i < results.size(); ++i) {
         if (async->tensors_data[i] != nullptr) {
           async->tensors_data[i]->Assign(*results[i]);
@@ -1174,7 +2727,31 @@ XLAGraphExecutor::ScheduleSyncTensorsGraph(
           async->tensors_data[i] = std::move(results[i]);
         }
       }
+      if (!arena_outputs.empty()) {
+        std::vector<torch::lazy::BackendDataPtr> arena_data;
+        arena_data.reserve(arena_outputs.size());
+        for (size_t index : arena_outputs) {
+          arena_data.push_back(async->tensors_data[index]);
+        }
+        OutputArena::Get()->Keep(hash, std::move(arena_data));
+      }
+      if (ready_data != nullptr) {
+        client->OnReadyCallback(
+            ready_data, [this, hash, step_device, dispatch_ns,
+                         computation = async->cached_computation]() {
+              RecordAutotunedExecuteTime(
+                  hash, computation.get(),
+                  graph_stats_.RecordExecuteTime(hash, step_device,
+                                                 dispatch_ns));
+              RecordTimelineEvent(runtime::timeline::Phase::kExecute,
+                                  dispatch_ns, hash);
+              inflight_steps_.Finish(step_device, /*dispatched=*/true);
+            });
+      } else {
+        inflight_steps_.Finish(step_device, dispatched);
+      }
     } catch (...) {
+      inflight_steps_.Finish(step_device, dispatched);
       // There are two paths of discovery of an exception happening on an
       // asynchronous task. One happens if the creator of the asynchronous task
       // explicitly waits for completion, in which case the exception will be
@@ -1191,33 +2768,80 @@ XLAGraphExecutor::ScheduleSyncTensorsGraph(
     }
   };
 
-  thread::Schedule(async->mwait.Completer(std::move(syncfn)));
+  if (async->cached_computation == nullptr) {
+    // Rather than holding a pool thread until the background compilation
+    // lands, the execution is only scheduled once it has.
+    ScheduleAfterCompilation(coll->hash, pending_computation,
+                             async->mwait.Completer(std::move(syncfn)));
+  } else if (UseInlineExecution()) {
+    // The completer records the exception, if any, for the waiters, as it
+    // does on the thread pool.
+    TORCH_LAZY_COUNTER("InlineExecution", 1);
+    async->mwait.Completer(std::move(syncfn))();
+  } else {
+    thread::Schedule(async->mwait.Completer(std::move(syncfn)));
+  }
   return async;
 }
 
+void XLAGraphExecutor::StageNextComputation(
+    const torch::lazy::hash_t& hash, const torch::lazy::BackendDevice& device) {
+  static const bool predict_next_graph =
+      runtime::sys_util::GetEnvBool("XLA_PREDICT_NEXT_GRAPH", false);
+  if (!predict_next_graph) {
+    return;
+  }
+  std::optional<torch::lazy::hash_t> next =
+      graph_predictor_.Next(device.toString(), hash);
+  // The computation of the graph being scheduled is loaded already.
+  if (!next || *next == hash) {
+    return;
+  }
+  // The memory cache has nowhere to load the computations it dropped from.
+  auto* cache = dynamic_cast<PersistentCache*>(GetComputationCache());
+  if (cache == nullptr) {
+    return;
+  }
+  TORCH_LAZY_COUNTER("StageNextComputation", 1);
+  thread::ScheduleIo([cache, next = *next]() { cache->PrefetchKey(next); });
+}
+
 std::shared_ptr<XLAGraphExecutor::Async>
 XLAGraphExecutor::ScheduleSyncTensorsGraph(
     std::vector<XLATensorPtr>* tensors, SyncTensorCollection* coll,
     std::vector<torch::lazy::BackendDataPtr> parameters_data,
     std::string device, ComputationCache::TypePtr cached_computation,
-    const std::vector<torch::lazy::BackendDataPtr>& tensor_data_vec) {
+    const std::vector<torch::lazy::BackendDataPtr>& tensor_data_vec,
+    PendingCompilation pending_computation) {
   auto tensors_data =
       SetTensorData(tensors, coll->config, coll->indices, tensor_data_vec);
   std::vector<XLATensor::ShardingSpecPtr> sharding_specs(coll->indices.size(),
                                                          nullptr);
 
   // Extract sharding specs for the results and prepare the sharded data
-  // placeholders if the computation is sharded.
-  if (cached_computation->is_sharded) {
+  // placeholders if the computation is sharded. Sharded computations are never
+  // executed from a pending compilation, as the output shardings are only known
+  // after compilation.
+  if (cached_computation != nullptr && cached_computation->is_sharded) {
+    const std::vector<XLATensor::ShardingSpecPtr>& output_sharding_specs =
+        cached_computation->GetOutputShardingSpecs([&]() {
+          std::vector<xla::Shape> output_shapes;
+          output_shapes.reserve(coll->indices.size());
+          for (size_t index : coll->indices) {
+            output_shapes.push_back((*tensors)[index]->shape().get());
+          }
+          return output_shapes;
+        });
     ShardingUtil::PrepareOutputShardingPropagation(
-        tensors, coll->indices, cached_computation->computation, &tensors_data,
+        tensors, coll->indices, output_sharding_specs, &tensors_data,
         &sharding_specs);
     DebugUtil::SaveOutputShardingInfo(tensors, coll->indices);
   }
 
   return ScheduleSyncTensorsGraph(
       coll, std::move(parameters_data), std::move(tensors_data),
-      std::move(sharding_specs), std::move(cached_computation));
+      std::move(sharding_specs), std::move(cached_computation),
+      std::move(pending_computation));
 }
 
 XLAGraphExecutor::PostOrderData XLAGraphExecutor::RunPostOrder(
@@ -1225,11 +2849,154 @@ XLAGraphExecutor::PostOrderData XLAGraphExecutor::RunPostOrder(
     SyncTensorCollection* coll) {
   tsl::profiler::TraceMe activity("RunPostOrder",
                                   tsl::profiler::TraceMeLevel::kInfo);
-  return torch::lazy::LazyGraphExecutor::RunPostOrder(ir_values, coll);
+  TORCH_LAZY_TIMED("RunPostOrder");
+  runtime::timeline::ScopedEvent event(runtime::timeline::Phase::kPostOrder);
+  // Uploads the pooled scalars the graph may take as parameters, so that they
+  // do not look like the outputs of computations in flight.
+  ScalarPool::Get()->Flush();
+  if (!graph_cut_data.empty()) {
+    // The walk of a piece of a split graph stops at the outputs of the
+    // previous pieces, which the piece takes as its first parameters. It is
+    // specific to the split, so it is not cached.
+    PostOrderData po_data;
+    std::vector<const torch::lazy::Node*> roots;
+    roots.reserve(ir_values.size());
+    for (const torch::lazy::Value& ir_value : ir_values) {
+      roots.push_back(ir_value.node.get());
+    }
+    for (const auto& [node, data] : graph_cut_data) {
+      po_data.emission_map[node] = torch::lazy::Util::kEmitted;
+    }
+    po_data.post_order =
+        torch::lazy::Util::ComputePostOrder(roots, &po_data.emission_map);
+    std::unordered_map<torch::lazy::BackendData::Handle, size_t> data_handles;
+    bool barrier = false;
+    auto add_parameter = [&](const torch::lazy::BackendDataPtr& data) {
+      if (!barrier && !data->HasValue()) {
+        TensorCollectionBarrier(coll);
+        barrier = true;
+      }
+      auto it = data_handles
+                    .emplace(data->GetHandle(), po_data.parameters_data.size())
+                    .first;
+      if (it->second == po_data.parameters_data.size()) {
+        po_data.parameters_data.push_back(data);
+      }
+      po_data.parameter_sequence.push_back(it->second);
+    };
+    for (const auto& [output, data] :
+         GetGraphCutInputs(po_data.post_order, ir_values)) {
+      add_parameter(data);
+    }
+    for (const torch::lazy::Node* node : po_data.post_order) {
+      const DeviceData* device_data = DeviceData::Cast(node);
+      if (device_data != nullptr) {
+        add_parameter(device_data->data());
+      }
+    }
+    return po_data;
+  }
+  std::optional<PostOrderData> cached =
+      post_order_cache_.Get(coll->device, ir_values);
+  if (cached) {
+    TORCH_LAZY_COUNTER("CachedPostOrder", 1);
+    // Same barrier as the upstream walk, computations which are still in
+    // flight may be producing the parameters.
+    for (const torch::lazy::BackendDataPtr& data : cached->parameters_data) {
+      if (!data->HasValue()) {
+        TensorCollectionBarrier(coll);
+        break;
+      }
+    }
+    return std::move(*cached);
+  }
+  PostOrderData po_data =
+      torch::lazy::LazyGraphExecutor::RunPostOrder(ir_values, coll);
+  // The walk keys the parameters by the handle of their data, as
+  // LoweringContext::GetParameter() does, so the device data nodes of the same
+  // buffer, like the ones of the aliases of a tensor, share a parameter.
+  size_t shared_parameters =
+      po_data.parameter_sequence.size() - po_data.parameters_data.size();
+  if (shared_parameters > 0) {
+    TORCH_LAZY_COUNTER("SharedParameters", shared_parameters);
+  }
+  post_order_cache_.Add(coll->device, ir_values, po_data);
+  return po_data;
+}
+
+bool XLAGraphExecutor::PostOrderCache::Matches(
+    const Entry& entry, const std::vector<torch::lazy::Value>& roots) {
+  if (entry.nodes.size() != roots.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < roots.size(); ++i) {
+    if (entry.indices[i] != roots[i].index ||
+        entry.nodes[i].lock() != roots[i].node) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::optional<XLAGraphExecutor::PostOrderData>
+XLAGraphExecutor::PostOrderCache::Get(
+    const torch::lazy::BackendDevice& device,
+    const std::vector<torch::lazy::Value>& roots) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = entries_.find(device);
+  if (it == entries_.end()) {
+    return std::nullopt;
+  }
+  for (const Entry& entry : it->second) {
+    if (Matches(entry, roots)) {
+      return entry.po_data;
+    }
+  }
+  return std::nullopt;
+}
+
+void XLAGraphExecutor::PostOrderCache::Add(
+    const torch::lazy::BackendDevice& device,
+    const std::vector<torch::lazy::Value>& roots,
+    const PostOrderData& po_data) {
+  static const size_t kMaxEntries = 4;
+  Entry entry;
+  entry.nodes.reserve(roots.size());
+  entry.indices.reserve(roots.size());
+  for (const torch::lazy::Value& root : roots) {
+    entry.nodes.push_back(root.node);
+    entry.indices.push_back(root.index);
+  }
+  // The emission map is not kept, the lowering only falls back to it for
+  // nodes missing from the post-order, and rebuilds it if needed.
+  entry.po_data.post_order = po_data.post_order;
+  entry.po_data.parameters_data = po_data.parameters_data;
+  entry.po_data.parameter_sequence = po_data.parameter_sequence;
+
+  std::lock_guard<std::mutex> lock(lock_);
+  std::list<Entry>& entries = entries_[device];
+  entries.remove_if([](const Entry& entry) {
+    return std::any_of(
+        entry.nodes.begin(), entry.nodes.end(),
+        [](const std::weak_ptr<torch::lazy::Node>& node) {
+          return node.expired();
+        });
+  });
+  entries.push_front(std::move(entry));
+  if (entries.size() > kMaxEntries) {
+    entries.pop_back();
+  }
+}
+
+void XLAGraphExecutor::PostOrderCache::Clear(
+    const torch::lazy::BackendDevice& device) {
+  std::lock_guard<std::mutex> lock(lock_);
+  entries_.erase(device);
 }
 
 XLAGraphExecutor::ComputationCache::TypePtr
 XLAGraphExecutor::LookupCachedCompile(const torch::lazy::hash_t& hash) {
+  TORCH_LAZY_TIMED("LookupCachedCompile");
   ComputationCache::TypePtr cached_computation =
       GetComputationCache()->Get(hash);
   if (cached_computation == nullptr) {
@@ -1265,22 +3032,119 @@ XLAGraphExecutor::TryRunCachedSync(
     // tensors to track the new sharded data after resharding.
     const xla::HloModuleProto& computation_proto =
         cached_computation->computation->computation().proto();
-    ShardingUtil::ReshardParameters(computation_proto, tensors,
-                                    &po_data->parameters_data,
-                                    &po_data->post_order);
+    ShardingUtil::ReshardParameters(
+        ShardingUtil::GetAutoShardingInputShardings(coll->hash,
+                                                    computation_proto),
+        tensors, &po_data->parameters_data, &po_data->post_order);
     TF_VLOG(5) << "Parameter sequence hash after resharding: "
                << torch::lazy::Hash(po_data->parameter_sequence);
   }
 
   // don't schedule the execution if the purpose of this SyncTensor is just to
   // warm up the cache.
+  if (warm_up_cache_only) {
+    return std::pair<bool, std::shared_ptr<XLAGraphExecutor::Async>>(cache_hit,
+                                                                     nullptr);
+  }
+  cached_computation = SelectAutotunedComputation(
+      coll->hash, coll->device, std::move(cached_computation));
   return std::pair<bool, std::shared_ptr<XLAGraphExecutor::Async>>(
-      cache_hit, warm_up_cache_only
-                     ? nullptr
-                     : ScheduleSyncTensorsGraph(
-                           tensors, coll, std::move(po_data->parameters_data),
-                           coll->device.toString(),
-                           std::move(cached_computation), tensor_data_vec));
+      cache_hit, ScheduleSyncTensorsGraph(
+                     tensors, coll, std::move(po_data->parameters_data),
+                     coll->device.toString(), std::move(cached_computation),
+                     tensor_data_vec));
+}
+
+XLAGraphExecutor::ComputationCache::TypePtr
+XLAGraphExecutor::SelectAutotunedComputation(
+    const torch::lazy::hash_t& hash, const torch::lazy::BackendDevice& device,
+    ComputationCache::TypePtr cached_computation) {
+  CompileOptionAutotuner* autotuner = GetCompileOptionAutotuner();
+  // The HLO of the sharded computations may be partitioned already.
+  if (autotuner == nullptr || cached_computation->autotuned ||
+      cached_computation->is_sharded) {
+    return cached_computation;
+  }
+  bool start_tuning = false;
+  ComputationCache::TypePtr selected =
+      autotuner->Select(hash, cached_computation, &start_tuning);
+  if (!start_tuning) {
+    return selected;
+  }
+  TORCH_LAZY_COUNTER("CompileOptionAutotune", 1);
+  TF_VLOG(3) << "Compiling " << autotuner->candidates().size()
+             << " compile option candidates of IR graph hash "
+             << torch::lazy::HashToString(hash);
+  thread::ScheduleCompile([autotuner, hash, device, cached_computation]() {
+    std::vector<ComputationCache::TypePtr> candidates;
+    try {
+      XLA_ASSIGN_OR_THROW(
+          runtime::ComputationClient * absl_nonnull const client,
+          runtime::GetComputationClient());
+      // The persistent cache only keeps the executables, so the candidates are
+      // compiled from the HLO module of the cached one.
+      const runtime::ComputationClient::Computation& computation =
+          *cached_computation->computation;
+      const xla::ProgramShape& program_shape = computation.program_shape();
+      xla::Shape shape = MakeShapeWithDeviceLayout(
+          program_shape.result(), static_cast<XlaDeviceType>(device.type()));
+      bool parameter_is_tupled_arguments =
+          program_shape.parameters_size() == 1 &&
+          program_shape.parameters(0).IsTuple();
+      std::vector<runtime::ComputationClient::CompileInstance> instances;
+      for (const runtime::util::CompileOptionSet& options :
+           autotuner->candidates()) {
+        instances.emplace_back(
+            xla::XlaComputation(computation.computation().proto()),
+            device.toString(),
+            client->GetCompilationDevices(device.toString(), {}), &shape,
+            parameter_is_tupled_arguments);
+        instances.back().option_overrides = options;
+      }
+      for (runtime::ComputationClient::ComputationPtr& candidate :
+           client->Compile(std::move(instances))) {
+        candidates.push_back(
+            std::make_shared<CachedComputation>(std::move(candidate)));
+      }
+    } catch (const std::exception& e) {
+      TF_LOG(WARNING) << "Failed to compile the compile option candidates of "
+                      << "IR graph hash " << torch::lazy::HashToString(hash)
+                      << ": " << e.what();
+      candidates.clear();
+    }
+    autotuner->SetCandidates(hash, cached_computation, std::move(candidates));
+  });
+  return selected;
+}
+
+void XLAGraphExecutor::RecordAutotunedExecuteTime(
+    const torch::lazy::hash_t& hash, const CachedComputation* computation,
+    int64_t execute_time_ns) {
+  CompileOptionAutotuner* autotuner = GetCompileOptionAutotuner();
+  if (autotuner == nullptr || computation->autotuned) {
+    return;
+  }
+  std::optional<CompileOptionAutotuner::Winner> winner =
+      autotuner->RecordExecuteTime(hash, computation, execute_time_ns);
+  if (!winner.has_value()) {
+    return;
+  }
+  if (winner->candidate.has_value()) {
+    TORCH_LAZY_COUNTER("CompileOptionAutotuneCandidateWins", 1);
+    TF_VLOG(1) << "Compile option candidate " << *winner->candidate
+               << " is the fastest for IR graph hash "
+               << torch::lazy::HashToString(hash);
+  } else {
+    TF_VLOG(1) << "The default compile options are the fastest for IR graph "
+               << "hash " << torch::lazy::HashToString(hash);
+  }
+  // The winner is stored even when it is the original computation, so that
+  // later runs loading it from the persistent cache do not tune it again.
+  auto tuned = std::make_shared<CachedComputation>(
+      winner->object->computation, /*is_sharded=*/false, /*autotuned=*/true);
+  thread::ScheduleIo([this, hash, tuned = std::move(tuned)]() {
+    GetComputationCache()->Replace(hash, tuned);
+  });
 }
 
 std::vector<size_t> GetBufferDonorIndexForStepMarker(
@@ -1314,6 +3178,135 @@ std::vector<size_t> GetBufferDonorIndexForStepMarker(
   return buffer_donor_indexs;
 }
 
+// Counts the dynamic update slices of a parameter whose buffer is not
+// donated, and which therefore copy the whole buffer rather than update it in
+// place.
+void CountUndonatedDynamicUpdates(
+    const std::vector<const torch::lazy::Node*>& post_order,
+    const std::vector<torch::lazy::BackendDataPtr>& parameters_data,
+    const std::vector<size_t>& buffer_donor_indices) {
+  std::unordered_set<const torch::lazy::BackendData*> donated;
+  for (size_t index : buffer_donor_indices) {
+    donated.insert(parameters_data[index].get());
+  }
+  for (const torch::lazy::Node* node : post_order) {
+    if (node->op() != xla_dynamic_update_slice) {
+      continue;
+    }
+    const DeviceData* device_data = DeviceData::Cast(node->operand(0).node);
+    if (device_data != nullptr &&
+        donated.count(device_data->data().get()) == 0) {
+      TORCH_LAZY_COUNTER("DynamicUpdateSliceNotAliased", 1);
+    }
+  }
+}
+
+bool UseAutoBufferDonation() {
+  static const bool use_auto_buffer_donation =
+      runtime::sys_util::GetEnvBool("XLA_AUTO_BUFFER_DONATION", true);
+  return use_auto_buffer_donation;
+}
+
+// Returns whether the outputs of the graph of `coll` are written into the
+// buffers of the output arena. The sharded and split graphs allocate theirs.
+bool UseOutputArenaForGraph(const SyncTensorCollection& coll) {
+  return UseOutputArena() && !(coll.device == GetVirtualDevice()) &&
+         !UseVirtualDevice() && !ShardingUtil::GetAutoSharding() &&
+         !splitting_graph && graph_cut_data.empty();
+}
+
+// Returns the parameters which nothing references once the graph has run: no
+// live tensor holds their data, nor reaches it through a graph which this
+// sync does not truncate. Their buffers are dead after the execution, so
+// donating them is always safe, whichever tensor they used to belong to.
+std::vector<size_t> GetBufferDonorIndexFromLiveness(
+    const std::vector<XLATensorPtr>& tensors, const SyncTensorCollection& coll,
+    const std::vector<torch::lazy::BackendDataPtr>& parameters_data) {
+  if (!coll.config.force_ltc_data) {
+    // The synced tensors keep their graphs, and so the parameters.
+    return {};
+  }
+  std::unordered_map<const torch::lazy::BackendData*, size_t> candidates;
+  for (size_t i = 0; i < parameters_data.size(); ++i) {
+    auto* data_info =
+        static_cast<torch::lazy::LazyGraphExecutor::DeviceDataInfo*>(
+            parameters_data[i]->info());
+    if (data_info == nullptr || data_info->read_only) {
+      TF_VLOG(5) << "Not donating parameter " << i
+                 << ": the data is read only or of unknown origin";
+      continue;
+    }
+    candidates.emplace(parameters_data[i].get(), i);
+  }
+  if (candidates.empty()) {
+    return {};
+  }
+
+  // The graphs of the synced tensors are replaced by the outputs of this
+  // execution, so they do not keep the parameters alive.
+  std::unordered_set<int64_t> truncated_ids;
+  for (size_t index : coll.indices) {
+    truncated_ids.insert(tensors[index]->GetUniqueId());
+  }
+  auto release = [&](const torch::lazy::BackendData* data,
+                     const XLATensorPtr& tensor, const char* reason) {
+    auto it = candidates.find(data);
+    if (it != candidates.end()) {
+      TF_VLOG(5) << "Not donating parameter " << it->second << ": " << reason
+                 << " of tensor " << tensor->GetUniqueId();
+      candidates.erase(it);
+    }
+  };
+  std::unordered_set<const torch::lazy::Node*> visited;
+  std::vector<const torch::lazy::Node*> stack;
+  for (const XLATensorPtr& tensor :
+       XLAGraphExecutor::Get()->GetLiveTensors(&coll.device)) {
+    if (candidates.empty()) {
+      break;
+    }
+    if (tensor->data()->view != nullptr) {
+      // The aliases of views keep graphs and pending updates of their own.
+      TF_VLOG(5) << "Not donating any parameter: tensor "
+                 << tensor->GetUniqueId() << " is a view";
+      return {};
+    }
+    torch::lazy::BackendDataPtr handle = tensor->CurrentDataHandle();
+    if (handle != nullptr) {
+      release(handle.get(), tensor, "the data is held");
+    }
+    torch::lazy::Value ir_value = tensor->CurrentIrValue();
+    if (!ir_value || truncated_ids.count(tensor->GetUniqueId()) > 0) {
+      continue;
+    }
+    stack.push_back(ir_value.node.get());
+    while (!stack.empty()) {
+      const torch::lazy::Node* node = stack.back();
+      stack.pop_back();
+      if (!visited.insert(node).second) {
+        continue;
+      }
+      const DeviceData* device_data = DeviceData::Cast(node);
+      if (device_data != nullptr) {
+        release(device_data->data().get(), tensor,
+                "the data is read by the pending graph");
+      }
+      for (const torch::lazy::Output& operand : node->operands()) {
+        stack.push_back(operand.node);
+      }
+    }
+  }
+
+  std::vector<size_t> buffer_donor_indexs;
+  buffer_donor_indexs.reserve(candidates.size());
+  for (const auto& candidate : candidates) {
+    TF_VLOG(5) << "Donating parameter " << candidate.second
+               << ": no live tensor references it after the execution";
+    buffer_donor_indexs.push_back(candidate.second);
+  }
+  std::sort(buffer_donor_indexs.begin(), buffer_donor_indexs.end());
+  return buffer_donor_indexs;
+}
+
 std::vector<size_t> XLAGraphExecutor::GetBufferDonors(
     const std::vector<XLATensorPtr>& tensors, const SyncTensorCollection& coll,
     const std::vector<torch::lazy::BackendDataPtr>& parameters_data) {
@@ -1330,6 +3323,11 @@ std::vector<size_t> XLAGraphExecutor::GetBufferDonors(
   if (!enable_aliasing) {
     return {};
   }
+  // The next pieces of a split graph may still read the parameters of the
+  // current one.
+  if (splitting_graph) {
+    return {};
+  }
 
   bool donate_ltc_data =
       coll.config.sync_ltc_data && coll.config.force_ltc_data;
@@ -1386,6 +3384,32 @@ std::vector<size_t> XLAGraphExecutor::GetBufferDonors(
                  user_config_buffer_donor_indices.cbegin(),
                  user_config_buffer_donor_indices.cend(),
                  std::back_inserter(buffer_donor_indices));
+
+  // The liveness analysis catches the dead parameters which the tensor ids
+  // miss, such as the ones of partial syncs, or of tensors whose alias id was
+  // lost along the way.
+  if (UseAutoBufferDonation()) {
+    std::vector<size_t> live_buffer_donor_indices =
+        GetBufferDonorIndexFromLiveness(tensors, coll, parameters_data);
+    std::vector<size_t> auto_buffer_donor_indices;
+    std::set_difference(live_buffer_donor_indices.cbegin(),
+                        live_buffer_donor_indices.cend(),
+                        buffer_donor_indices.cbegin(),
+                        buffer_donor_indices.cend(),
+                        std::back_inserter(auto_buffer_donor_indices));
+    if (!auto_buffer_donor_indices.empty()) {
+      TORCH_LAZY_COUNTER("AutoBufferDonations",
+                         auto_buffer_donor_indices.size());
+      std::vector<size_t> merged_indices;
+      merged_indices.reserve(buffer_donor_indices.size() +
+                             auto_buffer_donor_indices.size());
+      std::merge(buffer_donor_indices.cbegin(), buffer_donor_indices.cend(),
+                 auto_buffer_donor_indices.cbegin(),
+                 auto_buffer_donor_indices.cend(),
+                 std::back_inserter(merged_indices));
+      buffer_donor_indices = std::move(merged_indices);
+    }
+  }
   return buffer_donor_indices;
 }
 
@@ -1399,37 +3423,135 @@ void XLAGraphExecutor::SetBufferDonors(
   TORCH_LAZY_VALUE_METRIC("InputOutputAliasCount", buffer_donor_indexs.size());
 }
 
-XLAGraphExecutor::CompilationResult XLAGraphExecutor::Compile(
-    std::vector<XLATensorPtr>& tensors, absl::Span<const std::string> devices,
-    const SyncTensorCollection& coll, PostOrderData* po_data,
-    const std::vector<torch::lazy::Value>& ir_values,
+std::vector<size_t> XLAGraphExecutor::FinalizeGraphHash(
+    const std::vector<XLATensorPtr>& tensors, SyncTensorCollection* coll,
+    const PostOrderData& po_data) {
+  TORCH_LAZY_TIMED("FinalizeGraphHash");
+  MergeHash(torch::lazy::Hash(po_data.parameter_sequence), &coll->hash);
+  if (!graph_cut_data.empty()) {
+    // The pieces of a split graph take the outputs of the previous pieces as
+    // parameters, unlike the same graph synced whole.
+    MergeHash(torch::lazy::MHash(std::string("graph_split")), &coll->hash);
+    for (const auto& [output, data] :
+         GetGraphCutInputs(po_data.post_order, /*roots=*/{})) {
+      MergeHash(torch::lazy::HashCombine(output.node->hash(),
+                                         torch::lazy::MHash(output.index)),
+                &coll->hash);
+    }
+  }
+
+  std::vector<size_t> buffer_donor_indices =
+      GetBufferDonors(tensors, *coll, po_data.parameters_data);
+  CountUndonatedDynamicUpdates(po_data.post_order, po_data.parameters_data,
+                               buffer_donor_indices);
+  if (buffer_donor_indices.size() > 0) {
+    // Do not include hash on a empty vector.
+    MergeHash(torch::lazy::Hash(buffer_donor_indices), &coll->hash);
+  }
+  if (UseOutputArenaForGraph(*coll)) {
+    MergeHash(torch::lazy::MHash(std::string("output_arena")), &coll->hash);
+  }
+  {
+    // Auto-sharding configs
+    MergeHash({torch::lazy::MHash(ShardingUtil::GetAutoSharding()),
+               torch::lazy::StringHash(
+                   runtime::sys_util::GetEnvString("XLA_AUTO_SPMD_MESH", "")
+                       .c_str()),
+               torch::lazy::StringHash(
+                   runtime::sys_util::GetEnvString(
+                       "XLA_AUTO_SPMD_MESH_CANDIDATES", "")
+                       .c_str())},
+              &coll->hash);
+  }
+  if (GetAllReduceBucketCapBytes() > 0) {
+    MergeHash(torch::lazy::MHash(GetAllReduceBucketCapBytes()), &coll->hash);
+  }
+  if (UseHierarchicalCollectives()) {
+    MergeHash(torch::lazy::MHash(std::string("hierarchical_collectives")),
+              &coll->hash);
+  }
+
+  DebugUtil::SaveGraphHash(coll->hash);
+  TF_VLOG(4) << "Parameter sequence graph hash "
+             << torch::lazy::HashToString(coll->hash);
+  return buffer_donor_indices;
+}
+
+XLAGraphExecutor::LoweringResult XLAGraphExecutor::LowerGraph(
+    absl::Span<const std::string> devices, const SyncTensorCollection& coll,
+    PostOrderData* po_data, const std::vector<torch::lazy::Value>& ir_values,
     const std::vector<size_t>& buffer_donor_indices) {
   tsl::profiler::TraceMe activity(
       [&] {
         return tsl::profiler::TraceMeEncode(
-            "XLAGraphExecutor::Compile",
+            "XLAGraphExecutor::LowerGraph",
             {{"graph_hash", torch::lazy::HashToString(coll.hash)}});
       },
       tsl::profiler::TraceMeLevel::kInfo);
-  static const size_t parameter_wrapping_threadshold =
-      runtime::sys_util::GetEnvInt("XLA_PARAMETER_WRAPPING_THREADSHOLD", 3200);
+  TORCH_LAZY_TIMED("LowerGraph");
+  runtime::timeline::ScopedEvent event(runtime::timeline::Phase::kLowering,
+                                      c10::Uint128High64(coll.hash),
+                                      c10::Uint128Low64(coll.hash));
   static const bool use_autosharding = ShardingUtil::GetAutoSharding();
   std::string graph_name =
       (CurrentGraphName() != "") ? CurrentGraphName() : "SyncTensorsGraph";
-  LoweringContext lowering_ctx(graph_name, coll.device, po_data->post_order,
-                               std::move(po_data->emission_map));
-  for (auto ir_value : ir_values) {
-    xla::XlaOp root = lowering_ctx.GetOutputOp(
-        torch::lazy::Output(ir_value.node.get(), ir_value.index));
-    lowering_ctx.AddResult(root);
-  }
   // Always execute sharded when running in SPMD mode
   bool is_sharded = (coll.device == GetVirtualDevice()) || UseVirtualDevice();
+  // The post order is lowered here rather than by the context, so that the
+  // duplicate all-reduces get merged, the all-reduces get bucketed when
+  // $XLA_ALL_REDUCE_BUCKET_CAP_MB is set, and the independent sub-graphs get
+  // lowered in parallel when $XLA_PARALLEL_LOWERING_THREADS is set. The
+  // sharding annotations are only set on the ops of the graph's own builder,
+  // so the sharded graphs are lowered on this thread.
+  LoweringContext lowering_ctx(graph_name, coll.device, /*post_order=*/{},
+                               std::move(po_data->emission_map));
+  // The pieces of a split graph declare the outputs of the previous pieces
+  // they use first, as RunPostOrder() collected them, and are lowered on this
+  // thread, as the partitions would not see those outputs.
+  std::vector<std::pair<torch::lazy::Output, torch::lazy::BackendDataPtr>>
+      cut_inputs = GetGraphCutInputs(po_data->post_order, ir_values);
+  for (const auto& [output, data] : cut_inputs) {
+    XLA_ASSIGN_OR_THROW(xla::XlaOp parameter, lowering_ctx.GetParameter(data));
+    lowering_ctx.AssignOutputOp(output, parameter);
+  }
+  std::vector<torch::lazy::Output> roots;
+  roots.reserve(ir_values.size());
+  for (const torch::lazy::Value& ir_value : ir_values) {
+    roots.emplace_back(ir_value.node.get(), ir_value.index);
+  }
+  bool lower_in_parallel =
+      !is_sharded && !use_autosharding && graph_cut_data.empty();
+  XLA_THROW_IF_ERROR(LowerInParallel(
+      po_data->post_order, roots, GetAllReduceBucketCapBytes(),
+      lower_in_parallel ? GetParallelLoweringThreads() : 0, &lowering_ctx));
+  for (const torch::lazy::Output& root : roots) {
+    lowering_ctx.AddResult(lowering_ctx.GetOutputOp(root));
+  }
   // Annotate HLO sharding selectively in the compuation.
   ShardingUtil::SetHloSharding(&lowering_ctx);
 
   SetBufferDonors(&lowering_ctx, buffer_donor_indices);
 
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  const int64_t parameter_wrapping_threadshold = GetParameterWrappingThreshold(
+      ParameterWrappingThreshold(), client);
+  // The outputs get written into the buffers of extra parameters, which the
+  // executions bind to the output arena, unless these would get the
+  // parameters wrapped.
+  size_t num_arena_parameters = 0;
+  if (UseOutputArenaForGraph(coll) &&
+      static_cast<int64_t>(po_data->parameters_data.size() + roots.size()) <
+          parameter_wrapping_threadshold) {
+    std::vector<xla::XlaOp> results;
+    results.reserve(roots.size());
+    for (size_t i = 0; i < roots.size(); ++i) {
+      results.push_back(lowering_ctx.GetResult(i));
+    }
+    num_arena_parameters = AddOutputArenaParameters(
+        lowering_ctx.builder(), results, po_data->parameters_data.size());
+  }
+
   XLA_ASSIGN_OR_THROW(xla::XlaComputation computation, lowering_ctx.BuildXla());
   XLA_ASSIGN_OR_THROW(xla::ProgramShape program_shape,
                       computation.GetProgramShape());
@@ -1442,6 +3564,7 @@ XLAGraphExecutor::CompilationResult XLAGraphExecutor::Compile(
     TF_VLOG(3) << "Wrapping graph with " << program_shape.parameters_size()
                << " parameters. Threadshold = "
                << parameter_wrapping_threadshold;
+    TORCH_LAZY_COUNTER("ParameterWrappedGraphs", 1);
 
     // trying to get all op shardings
     std::vector<xla::HloSharding> param_shardings;
@@ -1455,21 +3578,33 @@ XLAGraphExecutor::CompilationResult XLAGraphExecutor::Compile(
                                        param_shardings, buffer_donor_indices));
     XLA_ASSIGN_OR_THROW(program_shape, computation.GetProgramShape());
   }
-  xla::Shape shape = MakeShapeWithDeviceLayout(
-      program_shape.result(), static_cast<XlaDeviceType>(coll.device.type()));
-
-  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
-                      runtime::GetComputationClient());
-  std::vector<runtime::ComputationClient::CompileInstance> instances;
-  instances.push_back(
-      {std::move(computation), coll.device.toString(),
-       client->GetCompilationDevices(coll.device.toString(), devices), &shape,
-       should_wrap_parameter, is_sharded});
-  instances.front().eager_mode = UseEagerMode();
+  auto shape = std::make_unique<xla::Shape>(MakeShapeWithDeviceLayout(
+      program_shape.result(), static_cast<XlaDeviceType>(coll.device.type())));
+
+  runtime::ComputationClient::CompileInstance instance(
+      std::move(computation), coll.device.toString(),
+      client->GetCompilationDevices(coll.device.toString(), devices),
+      shape.get(), should_wrap_parameter, is_sharded);
+  instance.eager_mode = UseEagerMode();
   if (use_autosharding) {
     TF_VLOG(5) << "use_auto_spmd_partitioning is set.";
     TF_CHECK(is_sharded) << "Auto-sharding pass requires SPMD mode.";
-    instances.front().use_auto_spmd_partitioning = use_autosharding;
+    std::optional<ShardingUtil::AutoShardingPlan> plan =
+        ShardingUtil::LookupAutoShardingPlan(coll.hash);
+    if (plan) {
+      absl::Status status = ShardingUtil::ApplyAutoShardingPlan(
+          *plan, instance.computation.mutable_proto());
+      if (!status.ok()) {
+        TF_VLOG(3) << "Ignoring the auto-sharding plan of graph hash "
+                   << torch::lazy::HashToString(coll.hash) << ": " << status;
+        plan.reset();
+      } else {
+        TORCH_LAZY_COUNTER("AutoShardingPlanCacheHit", 1);
+      }
+    }
+    instance.use_auto_spmd_partitioning = !plan.has_value();
+  }
+  if (instance.use_auto_spmd_partitioning) {
     TORCH_LAZY_COUNTER("CompileWithAutoSharding", 1);
 
     // Apply XLA_AUTO_SPMD_MESH if it is set.
@@ -1477,10 +3612,9 @@ XLAGraphExecutor::CompilationResult XLAGraphExecutor::Compile(
     std::vector<int64_t> auto_spmd_mesh_shape =
         ShardingUtil::GetAutoShardingMesh();
     std::vector<int64_t> auto_spmd_mesh_ids =
-        ShardingUtil::GetAutoShardingMeshIds(
-            instances.front().computation.proto());
-    instances.front().auto_spmd_mesh_shape = auto_spmd_mesh_shape;
-    instances.front().auto_spmd_mesh_ids = auto_spmd_mesh_ids;
+        ShardingUtil::GetAutoShardingMeshIds(instance.computation.proto());
+    instance.auto_spmd_mesh_shape = auto_spmd_mesh_shape;
+    instance.auto_spmd_mesh_ids = auto_spmd_mesh_ids;
     TF_VLOG(5) << "auto_spmd_mesh_shape={"
                << absl::StrJoin(auto_spmd_mesh_shape, ",") << "}\n"
                << "auto_spmd_mesh_ids={"
@@ -1490,12 +3624,98 @@ XLAGraphExecutor::CompilationResult XLAGraphExecutor::Compile(
   DebugUtil::analyze_graph_execution_python_frame(
       DebugUtil::GraphAnalysisSource::Compilation,
       /*graph_hash=*/coll.hash, /*program_shape=*/&program_shape);
+  DebugUtil::analyze_recompilation(coll.hash, po_data->post_order);
+
+  if (should_wrap_parameter) {
+    XLA_CHECK_EQ(program_shape.parameters_size(), 1);
+    XLA_CHECK_EQ(program_shape.parameters()[0].tuple_shapes_size(),
+                 po_data->parameters_data.size());
+  } else {
+    XLA_CHECK_EQ(program_shape.parameters_size(),
+                 po_data->parameters_data.size() + num_arena_parameters);
+  }
+
+  return {/*instance=*/std::move(instance),
+          /*output_shape=*/std::move(shape),
+          /*emitted_nodes=*/lowering_ctx.GetEmittedNodeCount(),
+          /*is_sharded=*/is_sharded};
+}
+
+XLAGraphExecutor::CompilationResult XLAGraphExecutor::Compile(
+    std::vector<XLATensorPtr>& tensors, absl::Span<const std::string> devices,
+    const SyncTensorCollection& coll, PostOrderData* po_data,
+    const std::vector<torch::lazy::Value>& ir_values,
+    const std::vector<size_t>& buffer_donor_indices, bool compile_async) {
+  tsl::profiler::TraceMe activity(
+      [&] {
+        return tsl::profiler::TraceMeEncode(
+            "XLAGraphExecutor::Compile",
+            {{"graph_hash", torch::lazy::HashToString(coll.hash)}});
+      },
+      tsl::profiler::TraceMeLevel::kInfo);
+  static const bool use_autosharding = ShardingUtil::GetAutoSharding();
+  LoweringResult lowering =
+      LowerGraph(devices, coll, po_data, ir_values, buffer_donor_indices);
+  std::vector<runtime::ComputationClient::CompileInstance> instances;
+  instances.push_back(std::move(lowering.instance));
+  // The graph is compiled with each candidate auto-sharding mesh, keeping the
+  // cheapest executable.
+  std::vector<std::vector<int64_t>> mesh_candidates;
+  if (instances.front().use_auto_spmd_partitioning && !compile_async) {
+    mesh_candidates = ShardingUtil::GetAutoShardingMeshCandidates();
+  }
+  if (mesh_candidates.size() > 1) {
+    TORCH_LAZY_COUNTER("AutoShardingMeshCandidates", mesh_candidates.size());
+    const runtime::ComputationClient::CompileInstance& instance =
+        instances.front();
+    std::vector<runtime::ComputationClient::CompileInstance> candidates;
+    for (std::vector<int64_t>& mesh_shape : mesh_candidates) {
+      candidates.emplace_back(
+          xla::XlaComputation(instance.computation.proto()),
+          instance.compilation_device, instance.devices,
+          instance.output_shape, instance.parameter_is_tupled_arguments,
+          instance.is_sharded,
+          instance.allow_spmd_sharding_propagation_to_output,
+          /*use_auto_spmd_partitioning=*/true, std::move(mesh_shape),
+          instance.auto_spmd_mesh_ids, instance.eager_mode);
+    }
+    instances = std::move(candidates);
+  }
+
+  if (compile_async) {
+    TF_VLOG(3) << "Scheduling background compilation of IR graph hash "
+               << torch::lazy::HashToString(coll.hash) << " on device "
+               << coll.device;
+    PendingCompilation pending_computation =
+        ScheduleCompile(coll.hash, std::move(instances),
+                        std::move(*lowering.output_shape), lowering.is_sharded);
+    return {/*device=*/coll.device,
+            /*emitted_nodes=*/lowering.emitted_nodes,
+            /*computation=*/nullptr,
+            /*parameters_data=*/std::move(po_data->parameters_data),
+            /*is_sharded=*/lowering.is_sharded,
+            /*pending_computation=*/std::move(pending_computation)};
+  }
 
   TF_VLOG(3) << "Compiling IR graph hash "
              << torch::lazy::HashToString(coll.hash) << " on device "
              << coll.device << " ...";
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  int64_t compile_start_ns = runtime::sys_util::NowNs();
   std::vector<std::shared_ptr<runtime::ComputationClient::Computation>>
       computations = client->Compile(std::move(instances));
+  if (computations.size() > 1) {
+    size_t best = ShardingUtil::SelectAutoShardingCandidate(computations);
+    TF_VLOG(3) << "Selected auto-sharding mesh candidate " << best
+               << " for IR graph hash "
+               << torch::lazy::HashToString(coll.hash);
+    computations = {computations[best]};
+  }
+  graph_stats_.RecordCompilation(
+      coll.hash, runtime::sys_util::NowNs() - compile_start_ns);
+  RecordTimelineEvent(runtime::timeline::Phase::kCompile, compile_start_ns,
+                      coll.hash);
   DebugUtil::post_compilation_analysis(computations[0]);
   TF_VLOG(3) << "Compiling IR graph hash "
              << torch::lazy::HashToString(coll.hash) << " on device "
@@ -1506,27 +3726,24 @@ XLAGraphExecutor::CompilationResult XLAGraphExecutor::Compile(
   if (use_autosharding) {
     const xla::HloModuleProto& computation_proto =
         computations.front()->computation().proto();
-    ShardingUtil::ReshardParameters(computation_proto, &tensors,
-                                    &po_data->parameters_data,
-                                    &po_data->post_order);
+    // Later compilations of the graph reuse the shardings chosen by the
+    // auto-sharding pass, when the executable is not cached anymore.
+    if (!computation_proto.spmd_parameters_shardings().empty()) {
+      ShardingUtil::StoreAutoShardingPlan(coll.hash, computation_proto);
+    }
+    ShardingUtil::ReshardParameters(
+        ShardingUtil::GetAutoShardingInputShardings(coll.hash,
+                                                    computation_proto),
+        &tensors, &po_data->parameters_data, &po_data->post_order);
     TF_VLOG(5) << "Parameter sequence hash after resharding: "
                << torch::lazy::Hash(po_data->parameter_sequence);
   }
 
-  if (should_wrap_parameter) {
-    XLA_CHECK_EQ(program_shape.parameters_size(), 1);
-    XLA_CHECK_EQ(program_shape.parameters()[0].tuple_shapes_size(),
-                 po_data->parameters_data.size());
-  } else {
-    XLA_CHECK_EQ(program_shape.parameters_size(),
-                 po_data->parameters_data.size());
-  }
-
   return {/*device=*/coll.device,
-          /*emitted_nodes=*/lowering_ctx.GetEmittedNodeCount(),
+          /*emitted_nodes=*/lowering.emitted_nodes,
           /*computation=*/computations.front(),
           /*parameters_data=*/std::move(po_data->parameters_data),
-          /*is_sharded=*/is_sharded};
+          /*is_sharded=*/lowering.is_sharded};
 }
 
 std::shared_ptr<XLAGraphExecutor::Async>
@@ -1535,6 +3752,13 @@ XLAGraphExecutor::SyncTensorsGraphInternal(
     const SyncTensorsConfig& config, bool warm_up_cache_only) {
   tsl::profiler::TraceMe activity("SyncTensorsGraphInternal",
                                   tsl::profiler::TraceMeLevel::kInfo);
+  // The Python frames of the IR were captured while tracing, so nothing below
+  // needs the GIL but the debug frame capture, which takes it back itself.
+  // Holding it would stall the other Python threads, like the data loader
+  // workers, for as long as the graph takes to compile.
+  ScopedGilRelease gil_release(ReleaseGilDuringSync());
+  TracingTimelineScope tracing_timeline_scope;
+  GraphSplitScope graph_split_scope;
   SyncTensorCollection coll = CollectSyncTensors(*tensors, config);
   if (coll.indices.empty()) {
     // Enure previous execution is complete before exiting this
@@ -1558,27 +3782,14 @@ XLAGraphExecutor::SyncTensorsGraphInternal(
   std::vector<torch::lazy::BackendDataPtr> tensor_data_vec;
   ExtractIRAndPrepareXlaData_(tensors, coll.config, coll.indices, ir_values,
                               tensor_data_vec);
+  // The previous pieces of an oversized graph run before anything waits on
+  // the device, as they lock it themselves.
+  if (graph_split_scope.outermost() && !warm_up_cache_only) {
+    SplitGraph(devices, coll, ir_values);
+  }
   PostOrderData po_data = RunPostOrder(ir_values, &coll);
-  MergeHash(torch::lazy::Hash(po_data.parameter_sequence), &coll.hash);
-
   std::vector<size_t> buffer_donor_indices =
-      GetBufferDonors(*tensors, coll, po_data.parameters_data);
-  if (buffer_donor_indices.size() > 0) {
-    // Do not include hash on a empty vector.
-    MergeHash(torch::lazy::Hash(buffer_donor_indices), &coll.hash);
-  }
-  {
-    // Auto-sharding configs
-    MergeHash({torch::lazy::MHash(ShardingUtil::GetAutoSharding()),
-               torch::lazy::StringHash(
-                   runtime::sys_util::GetEnvString("XLA_AUTO_SPMD_MESH", "")
-                       .c_str())},
-              &coll.hash);
-  }
-
-  DebugUtil::SaveGraphHash(coll.hash);
-  TF_VLOG(4) << "Parameter sequence graph hash "
-             << torch::lazy::HashToString(coll.hash);
+      FinalizeGraphHash(*tensors, &coll, po_data);
 
   std::pair<bool, std::shared_ptr<XLAGraphExecutor::Async>> cache_res =
       TryRunCachedSync(tensors, &coll, &po_data, tensor_data_vec,
@@ -1587,11 +3798,52 @@ XLAGraphExecutor::SyncTensorsGraphInternal(
     // we have a cache hit, execution has been scheduled by TryRunCachedSync.
     return cache_res.second;
   }
-  CompilationResult compile_result = Compile(*tensors, devices, coll, &po_data,
-                                             ir_values, buffer_donor_indices);
+
+  // Sharded computations need their output shardings, which are only known
+  // after the compilation, to set up the execution. Those can only be compiled
+  // in background when warming up the cache.
+  bool is_sharded = (coll.device == GetVirtualDevice()) || UseVirtualDevice();
+  bool compile_async = UseAsyncCompilation() &&
+                       !ShardingUtil::GetAutoSharding() &&
+                       (warm_up_cache_only || !is_sharded);
+  if (UseAsyncCompilation()) {
+    std::optional<PendingCompilation> pending_computation =
+        LookupPendingCompilation(coll.hash);
+    if (pending_computation) {
+      // The same graph is already being compiled in background, reuse it
+      // rather than lowering and compiling it again.
+      TORCH_LAZY_COUNTER("PendingCompileHit", 1);
+      if (warm_up_cache_only) {
+        return nullptr;
+      }
+      if (!compile_async) {
+        return ScheduleSyncTensorsGraph(
+            tensors, &coll, std::move(po_data.parameters_data),
+            coll.device.toString(), pending_computation->get(),
+            tensor_data_vec);
+      }
+      return ScheduleSyncTensorsGraph(
+          tensors, &coll, std::move(po_data.parameters_data),
+          coll.device.toString(), /*cached_computation=*/nullptr,
+          tensor_data_vec, std::move(*pending_computation));
+    }
+  }
+
+  CompilationResult compile_result =
+      Compile(*tensors, devices, coll, &po_data, ir_values,
+              buffer_donor_indices, compile_async);
 
   TORCH_LAZY_VALUE_METRIC("TensorsGraphSize", compile_result.emitted_nodes);
   TF_VLOG(5) << "TensorsGraphSize=" << compile_result.emitted_nodes;
+  if (compile_result.pending_computation.valid()) {
+    if (warm_up_cache_only) {
+      return nullptr;
+    }
+    return ScheduleSyncTensorsGraph(
+        tensors, &coll, std::move(compile_result.parameters_data),
+        compile_result.device.toString(), /*cached_computation=*/nullptr,
+        tensor_data_vec, std::move(compile_result.pending_computation));
+  }
   auto cached_computation = std::make_shared<CachedComputation>(
       std::move(compile_result.computation), compile_result.is_sharded);
   GetComputationCache()->Add(coll.hash, cached_computation);
@@ -1606,4 +3858,164 @@ XLAGraphExecutor::SyncTensorsGraphInternal(
   }
 }
 
+void XLAGraphExecutor::SplitGraph(
+    absl::Span<const std::string> devices, const SyncTensorCollection& coll,
+    const std::vector<torch::lazy::Value>& ir_values) {
+  const size_t max_nodes = GetGraphSplitMaxNodes();
+  const size_t max_parameters = GetGraphSplitMaxParameters();
+  if (max_nodes == 0 && max_parameters == 0) {
+    return;
+  }
+  // TODO: hand over the outputs of the pieces of the sharded graphs with
+  // their shardings, rather than replicated.
+  if (coll.device == GetVirtualDevice() || UseVirtualDevice()) {
+    return;
+  }
+  tsl::profiler::TraceMe activity("SplitGraph",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  std::vector<const torch::lazy::Node*> roots;
+  roots.reserve(ir_values.size());
+  for (const torch::lazy::Value& ir_value : ir_values) {
+    roots.push_back(ir_value.node.get());
+  }
+  std::vector<const torch::lazy::Node*> post_order =
+      torch::lazy::Util::ComputePostOrder(roots);
+  std::vector<std::vector<const torch::lazy::Node*>> cuts =
+      SplitPostOrder(post_order, roots, max_nodes, max_parameters);
+  if (cuts.empty()) {
+    return;
+  }
+
+  TORCH_LAZY_COUNTER("GraphSplits", 1);
+  TORCH_LAZY_COUNTER("GraphSplitPieces", cuts.size() + 1);
+  static std::mutex warned_mutex;
+  static auto* warned =
+      new std::unordered_set<torch::lazy::hash_t, torch::lazy::HashReducer>();
+  {
+    std::lock_guard<std::mutex> lock(warned_mutex);
+    if (warned->insert(coll.hash).second) {
+      TF_LOG(WARNING)
+          << "Splitting IR graph hash " << torch::lazy::HashToString(coll.hash)
+          << " of " << post_order.size() << " nodes into " << cuts.size() + 1
+          << " executables, as it is larger than XLA_GRAPH_SPLIT_MAX_NODES="
+          << max_nodes
+          << " or XLA_GRAPH_SPLIT_MAX_PARAMETERS=" << max_parameters
+          << ". Such graphs usually come from a missing torch_xla.sync(), "
+             "e.g. in a gradient accumulation loop; syncing each step runs "
+             "faster than splitting the graph.";
+    }
+  }
+
+  // The pieces hold on to the nodes they hand over through the operands of
+  // their users.
+  std::unordered_map<const torch::lazy::Node*, torch::lazy::NodePtr> owners;
+  for (const torch::lazy::Value& ir_value : ir_values) {
+    owners.emplace(ir_value.node.get(), ir_value.node);
+  }
+  for (const torch::lazy::Node* node : post_order) {
+    const XlaNode* xla_node = dynamic_cast<const XlaNode*>(node);
+    XLA_CHECK(xla_node != nullptr) << "Unexpected non-XLA node: " << *node;
+    for (size_t i = 0; i < node->operands().size(); ++i) {
+      owners.emplace(node->operand(i).node, xla_node->operand_node(i));
+    }
+  }
+
+  splitting_graph = true;
+  for (const std::vector<const torch::lazy::Node*>& cut : cuts) {
+    std::vector<XLATensorPtr> outputs;
+    for (const torch::lazy::Node* node : cut) {
+      for (size_t i = 0; i < node->num_outputs(); ++i) {
+        outputs.push_back(XLATensor::Create(
+            torch::lazy::Value(owners.at(node), i), coll.device,
+            /*logical_element_type=*/std::nullopt,
+            /*delay_eager_execution=*/true));
+      }
+    }
+    TF_VLOG(3) << "Running a piece of IR graph hash "
+               << torch::lazy::HashToString(coll.hash) << " handing over "
+               << outputs.size() << " tensor(s)";
+    std::shared_ptr<Async> async =
+        SyncTensorsGraphInternal(&outputs, devices, SyncTensorsConfig());
+    if (async != nullptr) {
+      async->mwait.Wait();
+    }
+    size_t index = 0;
+    for (const torch::lazy::Node* node : cut) {
+      std::vector<torch::lazy::BackendDataPtr>& data = graph_cut_data[node];
+      for (size_t i = 0; i < node->num_outputs(); ++i) {
+        data.push_back(outputs[index++]->CurrentDataHandle());
+      }
+    }
+  }
+  splitting_graph = false;
+}
+
+void XLAGraphExecutor::WarmUpCache(
+    const std::vector<std::vector<XLATensorPtr>>& tensor_groups,
+    absl::Span<const std::string> devices) {
+  tsl::profiler::TraceMe activity("WarmUpCache",
+                                  tsl::profiler::TraceMeLevel::kInfo);
+  TORCH_LAZY_TIMED("WarmUpCache");
+  // Same config as SyncTensorsGraph(warm_up_cache_only=true), so that the
+  // graph hashes match the ones the real executions will look up.
+  SyncTensorsConfig config;
+  config.force_ltc_data = false;
+
+  std::vector<torch::lazy::hash_t> hashes;
+  std::vector<bool> is_sharded;
+  std::vector<std::unique_ptr<xla::Shape>> output_shapes;
+  std::vector<runtime::ComputationClient::CompileInstance> instances;
+  std::unordered_set<torch::lazy::hash_t, torch::lazy::HashReducer> seen;
+  {
+    TORCH_LAZY_TIMED("WarmUpCacheLowering");
+    for (const std::vector<XLATensorPtr>& tensors : tensor_groups) {
+      SyncTensorCollection coll = CollectSyncTensors(tensors, config);
+      if (coll.indices.empty()) {
+        continue;
+      }
+      std::vector<torch::lazy::Value> ir_values =
+          CollectRoots(tensors, coll.indices);
+      PostOrderData po_data = RunPostOrder(ir_values, &coll);
+      std::vector<size_t> buffer_donor_indices =
+          FinalizeGraphHash(tensors, &coll, po_data);
+      if (!seen.insert(coll.hash).second) {
+        TORCH_LAZY_COUNTER("WarmUpCacheDeduplicated", 1);
+        continue;
+      }
+      if (LookupCachedCompile(coll.hash) != nullptr ||
+          LookupPendingCompilation(coll.hash)) {
+        TORCH_LAZY_COUNTER("WarmUpCacheHit", 1);
+        continue;
+      }
+      LoweringResult lowering =
+          LowerGraph(devices, coll, &po_data, ir_values, buffer_donor_indices);
+      TORCH_LAZY_VALUE_METRIC("TensorsGraphSize", lowering.emitted_nodes);
+      hashes.push_back(coll.hash);
+      is_sharded.push_back(lowering.is_sharded);
+      output_shapes.push_back(std::move(lowering.output_shape));
+      instances.push_back(std::move(lowering.instance));
+    }
+  }
+  if (instances.empty()) {
+    return;
+  }
+
+  TF_VLOG(3) << "Warming up the computation cache with " << instances.size()
+             << " graph(s)";
+  TORCH_LAZY_COUNTER("WarmUpCacheGraphs", instances.size());
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  std::vector<runtime::ComputationClient::ComputationPtr> computations;
+  {
+    TORCH_LAZY_TIMED("WarmUpCacheCompile");
+    computations = client->Compile(std::move(instances));
+  }
+  for (size_t i = 0; i < computations.size(); ++i) {
+    DebugUtil::post_compilation_analysis(computations[i]);
+    GetComputationCache()->Add(
+        hashes[i], std::make_shared<CachedComputation>(
+                       std::move(computations[i]), is_sharded[i]));
+  }
+}
+
 }  // namespace torch_xla
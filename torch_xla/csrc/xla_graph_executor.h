@@ -1,10 +1,21 @@
 #ifndef XLA_TORCH_XLA_CSRC_XLA_GRAPH_EXECUTOR_H_
 #define XLA_TORCH_XLA_CSRC_XLA_GRAPH_EXECUTOR_H_
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <c10/core/SymNodeImpl.h>
 #include <torch/csrc/autograd/variable.h>
@@ -38,6 +49,10 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
       std::shared_ptr<torch::lazy::LazyTensor::Data> data) final;
   void UnregisterTensor(torch::lazy::LazyTensor::Data* data) final;
 
+  // Tracks the tensor of `data` for the live tensor syncs if it holds pending
+  // work, so that they need not visit every live tensor.
+  void TrackDirtyTensor(const std::shared_ptr<XLATensor::Data>& data);
+
   // This method just syncs the tensors passed as argument. This method is
   // called at two places:
   // 1. Creating tensor from IR value. This is where an output tensor is created
@@ -56,8 +71,15 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
   // tensors to make it look as if they share same storage. Hence, the
   // operations on view tensor would be repeated when we try to sync the tensor
   // that is affected by the view tensor.
+  // With $XLA_EAGER_WINDOW_OPS above one, the tensors of consecutive ops are
+  // instead collected into a window, which is synced as one graph once it
+  // holds that many ops, or when it is flushed.
   void ApplyEagerSync(std::vector<XLATensorPtr>& tensors);
 
+  // Syncs the live tensors of the eager window, if any. Called before the
+  // values reach the host, and when the device ops are waited on.
+  void FlushEagerWindow();
+
   // We don't use the upstream GetDeviceDataIrValue to have the
   // xla::PrimitiveType.
   torch::lazy::Value GetDeviceDataIrValue(
@@ -96,6 +118,17 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
 
   uint64_t GetRunningSeed(const torch::lazy::BackendDevice& device) final;
 
+  // Sets the seed of `device` and the offset of its next random op. Outside of
+  // the $XLA_RNG_COUNTER_BASED mode, the offset is ignored.
+  void SetRngState(const torch::lazy::BackendDevice& device, uint64_t seed,
+                   uint64_t offset);
+
+  // Returns the seed and offset that SetRngState() restores the random stream
+  // of `device` from. Outside of the $XLA_RNG_COUNTER_BASED mode, these are
+  // the running seed and 0.
+  std::pair<uint64_t, uint64_t> GetRngState(
+      const torch::lazy::BackendDevice& device);
+
   torch::lazy::BackendDataPtr GetBaseSeedData(
       const torch::lazy::BackendDevice& device);
 
@@ -109,6 +142,12 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
   std::string DumpHloComputation(const std::vector<XLATensorPtr>& tensors,
                                  EmitMode mode = EmitMode::kHloReadable);
 
+  // Writes the StableHLO of the same computation to the file at `path`, in
+  // bytecode if `emit_bytecode`, streaming it rather than building it in
+  // memory.
+  void DumpStablehloToFile(const std::vector<XLATensorPtr>& tensors,
+                           bool emit_bytecode, const std::string& path);
+
   // Retrieves the set of XLA tensors which are currently live in the system,
   // for the given device. If device is nullptr, the live tensors for all
   // devices will be returned. Returned tensors are sorted by device as primary
@@ -125,6 +164,14 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
                         absl::Span<const std::string> devices, bool wait,
                         bool sync_ltc_data, bool warm_up_cache_only = false);
 
+  // Compiles the graphs of all the tensor groups and adds them to the
+  // computation cache, without executing them. Groups which lower to the same
+  // graph hash, or whose graph is already cached, are only compiled once. All
+  // the remaining graphs are sent to the runtime in a single Compile() call so
+  // they can be compiled in parallel.
+  void WarmUpCache(const std::vector<std::vector<XLATensorPtr>>& tensor_groups,
+                   absl::Span<const std::string> devices);
+
   // Makes sure that any outstanding IR operation accumulated over live tensors,
   // gets turned into device data. If wait is true, the sync operation will be
   // run synchronously. The devices argument, if not empty, tells the devices
@@ -145,10 +192,67 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
   // active devices.
   void WaitDeviceOps(absl::Span<const std::string> devices);
 
+  // Execution statistics of a compiled graph.
+  struct GraphStats {
+    torch::lazy::hash_t hash;
+    int64_t executions = 0;
+    int64_t compilations = 0;
+    // Total time spent compiling the graph, in nanoseconds.
+    int64_t compile_time_ns = 0;
+    // Device times of the most recent executions, from the oldest, in
+    // nanoseconds.
+    std::vector<int64_t> execute_times_ns;
+    // Sizes of the parameters and of the results of the graph.
+    int64_t input_bytes = 0;
+    int64_t output_bytes = 0;
+    // Number of steps marked before the last execution.
+    int64_t last_step = 0;
+    // Cost of an execution on each device, from the XLA cost analysis, or 0
+    // if the backend does not provide it.
+    double flops = 0;
+    double bytes_accessed = 0;
+    double transcendentals = 0;
+  };
+
+  // Returns the statistics of the graphs compiled or executed by this
+  // process, ordered by hash.
+  std::vector<GraphStats> GetGraphStats();
+
+  // Creates a text report of GetGraphStats(), in the format of the metrics
+  // report.
+  std::string CreateGraphStatsReport();
+
   // Retrieves the PyTorch CPU tensors behind the XLA tensors IR operations.
   // All the tensors must be on the same device.
   std::vector<at::Tensor> GetTensors(std::vector<XLATensorPtr>* tensors);
 
+  // Copies of XLA tensors to CPU started by GetTensorsAsync().
+  class TensorsTransfer {
+   public:
+    // Returns whether the CPU tensors are available, without blocking.
+    bool IsReady();
+
+    // Blocks until the copies complete, and returns the CPU tensors.
+    std::vector<at::Tensor> Wait();
+
+   private:
+    friend class XLAGraphExecutor;
+
+    std::mutex lock_;
+    // Per tensor, the CPU data it already had, or nullopt if it comes from the
+    // next literal of the transfer.
+    std::vector<std::optional<at::Tensor>> tensors_data_;
+    std::vector<at::ScalarType> element_types_;
+    std::unique_ptr<runtime::ComputationClient::AsyncTransfer> transfer_;
+    std::optional<std::vector<at::Tensor>> results_;
+  };
+
+  // Like GetTensors(), but returns once the graph producing the tensors is
+  // dispatched and the copies from device are started, so that they overlap
+  // with the tracing of the next step.
+  std::shared_ptr<TensorsTransfer> GetTensorsAsync(
+      std::vector<XLATensorPtr>* tensors);
+
   size_t GetNumGraphHash() const;
 
   // Returns the hash of the given tensors. This is NOT stable across
@@ -167,11 +271,46 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
   // different.
   struct CachedComputation {
     CachedComputation(runtime::ComputationClient::ComputationPtr computation,
-                      bool is_sharded = false)
-        : computation(std::move(computation)), is_sharded(is_sharded) {}
+                      bool is_sharded = false, bool autotuned = false)
+        : computation(std::move(computation)),
+          is_sharded(is_sharded),
+          autotuned(autotuned) {}
+
+    // Cost hints for the computation cache: recompiling costs the compilation
+    // time in milliseconds, and the executable size counts towards the byte
+    // limit.
+    runtime::util::CacheCost GetCacheCost() const {
+      runtime::util::CacheCost cost;
+      if (computation->compile_time_ns() > 0) {
+        cost.cost = computation->compile_time_ns() * 1e-6;
+      }
+      cost.size_bytes = computation->executable_size_bytes();
+      return cost;
+    }
+
+    // Returns the sharding specs of the outputs of the sharded computation.
+    // They are the same for every execution of it, so they are extracted from
+    // the computation, with the output shapes `get_output_shapes` returns, on
+    // the first call only.
+    const std::vector<XLATensor::ShardingSpecPtr>& GetOutputShardingSpecs(
+        const std::function<std::vector<xla::Shape>()>& get_output_shapes);
+
+    // Returns the shapes of the output placeholders of the Dynamo executions,
+    // which `get_output_shapes` returns on the first call only.
+    const std::vector<xla::Shape>& GetDynamoOutputShapes(
+        const std::function<std::vector<xla::Shape>()>& get_output_shapes);
 
     runtime::ComputationClient::ComputationPtr computation;
     bool is_sharded;
+    // Whether the computation was compiled with the options picked by the
+    // compile option autotuner, which does not tune it again.
+    bool autotuned;
+
+   private:
+    std::once_flag output_sharding_specs_once_;
+    std::vector<XLATensor::ShardingSpecPtr> output_sharding_specs_;
+    std::once_flag dynamo_output_shapes_once_;
+    std::vector<xla::Shape> dynamo_output_shapes_;
   };
 
   using ComputationCache =
@@ -187,10 +326,58 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
   ComputationCache* GetComputationCache();
   bool IsComputationCacheInitialized();
 
+  // Blocks until the background compilations (XLA_ASYNC_COMPILATION=1) of the
+  // given graph hashes have landed in the computation cache. If `hashes` is
+  // empty, waits for all the in-flight compilations. Errors raised by the
+  // compilations are re-thrown here.
+  void WaitPendingCompilations(
+      absl::Span<const torch::lazy::hash_t> hashes = {});
+
+  size_t GetNumPendingCompilations();
+
   std::vector<torch::lazy::BackendDataPtr> ExecuteComputationWithBarrier(
       torch::lazy::hash_t hash, const std::vector<at::IValue>& graph_inputs,
       const torch::lazy::BackendDevice& device);
 
+  // A synced graph recorded by CaptureGraph(), along with how its parameters
+  // and results bind to the inputs, so that it can be executed again on new
+  // inputs without tracing, hashing or lowering it.
+  struct CapturedGraph {
+    torch::lazy::hash_t hash;
+    torch::lazy::BackendDevice device;
+    ComputationCache::TypePtr cached_computation;
+    // Shapes of the inputs the graph was captured with.
+    std::vector<xla::Shape> input_shapes;
+    // For each computation parameter, the index of the input it is bound to,
+    // or -1 if it is bound to the captured data in parameters_data.
+    std::vector<int64_t> parameter_inputs;
+    std::vector<torch::lazy::BackendDataPtr> parameters_data;
+    // For each computation result, the index of the input it updates in
+    // place, or -1 if it is a new tensor. The shapes and sharding specs are
+    // the ones of the result data placeholders.
+    std::vector<int64_t> result_inputs;
+    std::vector<xla::Shape> result_shapes;
+    std::vector<XLATensor::ShardingSpecPtr> result_sharding_specs;
+    std::vector<std::optional<at::ScalarType>> result_element_types;
+    // For each output, the index of the computation result or of the input it
+    // is, or -1 for both if it is the captured tensor in outputs.
+    std::vector<int64_t> output_results;
+    std::vector<int64_t> output_inputs;
+    std::vector<XLATensorPtr> outputs;
+  };
+
+  // Syncs `outputs`, along with the `inputs` updated in place, and records
+  // the computation that produced them. The inputs must not have pending IR.
+  std::shared_ptr<CapturedGraph> CaptureGraph(
+      const std::vector<XLATensorPtr>& inputs,
+      const std::vector<XLATensorPtr>& outputs);
+
+  // Executes a captured graph on `inputs`, which must have the shapes of the
+  // inputs it was captured with and no pending IR. Inputs updated in place by
+  // the captured graph get the new values, and the outputs are returned.
+  std::vector<XLATensorPtr> ReplayGraph(
+      const CapturedGraph& graph, const std::vector<XLATensorPtr>& inputs);
+
   std::vector<torch::lazy::BackendDataPtr> ExecuteStablehlo(
       std::string stablehlo_bytecode,
       const std::vector<at::IValue>& graph_inputs,
@@ -200,11 +387,26 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
                        const torch::lazy::BackendDevice& device);
 
   void SetUseEagerMode(bool use_eager_mode) {
+    if (!use_eager_mode) {
+      FlushEagerWindow();
+    }
     use_eager_mode_ = use_eager_mode;
   }
 
   bool UseEagerMode() { return use_eager_mode_; }
 
+  // While set, the eager ops are compiled into the caches, including the
+  // persistent one, without being executed, and their results are backed by
+  // placeholders which must not be read.
+  void SetEagerWarmUp(bool eager_warm_up) {
+    if (eager_warm_up) {
+      FlushEagerWindow();
+    }
+    eager_warm_up_ = eager_warm_up;
+  }
+
+  bool EagerWarmUp() { return eager_warm_up_; }
+
   void SetAllowExecution(bool allow_execution) {
     allow_execution_ = allow_execution;
   }
@@ -217,6 +419,26 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
 
   std::string CurrentGraphName() { return current_graph_name_; }
 
+  // Sets the number of parameters from which the graphs lowered from now on
+  // take their parameters as a single tuple, or lets the graph executor decide
+  // it, from $XLA_PARAMETER_WRAPPING_THREADSHOLD or the measured cost of the
+  // argument handles, if not set.
+  void SetParameterWrappingThreshold(std::optional<int64_t> threshold) {
+    parameter_wrapping_threshold_ = threshold;
+  }
+
+  std::optional<int64_t> ParameterWrappingThreshold() {
+    return parameter_wrapping_threshold_;
+  }
+
+  // Sets the recall target of the approximate top-k which replaces the
+  // aten::topk traced from now on, or restores the exact top-k, if not set.
+  void SetTopKRecallTarget(std::optional<double> recall_target) {
+    topk_recall_target_ = recall_target;
+  }
+
+  std::optional<double> TopKRecallTarget() { return topk_recall_target_; }
+
  private:
   // This is just to group results from compile(). Since our computation is
   // different, we don't reuse the upstream CompilationResult.
@@ -226,6 +448,24 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
     runtime::ComputationClient::ComputationPtr computation;
     std::vector<torch::lazy::BackendDataPtr> parameters_data;
     bool is_sharded = false;
+    // Only valid when the compilation has been dispatched to the compile
+    // thread pool, in which case `computation` is nullptr.
+    std::shared_future<ComputationCache::TypePtr> pending_computation;
+  };
+
+  using PendingCompilation = std::shared_future<ComputationCache::TypePtr>;
+
+  // Compiles the graph of an eager op, without running it, when
+  // EagerWarmUp() is set.
+  void WarmUpEagerOp(std::vector<XLATensorPtr>& tensors);
+
+  // Groups the results from LowerGraph().
+  struct LoweringResult {
+    runtime::ComputationClient::CompileInstance instance;
+    // Owns the shape pointed to by instance.output_shape.
+    std::unique_ptr<xla::Shape> output_shape;
+    size_t emitted_nodes = 0;
+    bool is_sharded = false;
   };
 
   struct Async : public torch::lazy::LazyGraphExecutor::Async {
@@ -242,14 +482,46 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
    public:
     static DeviceContextArena* Get();
 
+    // These hide the upstream methods, so that the tensors are registered
+    // into the sharded registries below instead of the device contexts.
+    void RegisterTensor(std::shared_ptr<torch::lazy::LazyTensor::Data> data);
+    void UnregisterTensor(torch::lazy::LazyTensor::Data* data);
+
     // This method returns XLATensorPtrs instead of LazyTensorPtrs.
     std::vector<XLATensorPtr> GetLiveTensors(
         const torch::lazy::BackendDevice* device);
 
+    // Tracks `data` as dirty if it holds pending work: an IR value, a view,
+    // or host data to upload. Called whenever a tensor may become dirty.
+    void TrackDirtyTensor(const std::shared_ptr<XLATensor::Data>& data);
+
+    // Returns the live tensors which are dirty, in the order of
+    // GetLiveTensors(), and stops tracking the ones which are not anymore.
+    std::vector<XLATensorPtr> GetDirtyTensors(
+        const torch::lazy::BackendDevice* device);
+
     // We override this to use our own + and * for torch::lazy::Value.
     torch::lazy::Value GetRngSeed(
         const torch::lazy::BackendDevice& device) final;
 
+    // We override this to restart the offsets of the counter based seeds.
+    void SetRngSeed(const torch::lazy::BackendDevice& device,
+                    uint64_t seed) override;
+
+    void SetRngState(const torch::lazy::BackendDevice& device, uint64_t seed,
+                     uint64_t offset);
+
+    // The base seed of the current step, from which the counter based seeds
+    // are derived.
+    uint64_t GetBaseSeed(const torch::lazy::BackendDevice& device) {
+      DeviceContext* devctx = GetDeviceContext(device);
+      std::lock_guard<std::mutex> lock(devctx->lock);
+      return devctx->seed;
+    }
+
+    // The number of counter based seeds taken from the base seed.
+    uint64_t GetRngOffset(const torch::lazy::BackendDevice& device);
+
     torch::lazy::BackendDataPtr GetBaseSeedData(
         const torch::lazy::BackendDevice& device);
 
@@ -285,14 +557,76 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
         const at::Scalar& value, at::ScalarType scalar_type,
         const torch::lazy::BackendDevice& device) final;
 
-    // Below two maps are used for dynamo integration.
-    std::unordered_map<torch::lazy::hash_t, std::string,
+    // The offset of the next counter based seed of a device, valid while the
+    // base seed of the device is `seed`.
+    struct RngCounter {
+      uint64_t seed = 0;
+      uint64_t offset = 0;
+    };
+
+    // Returns the seed of the next random op in the $XLA_RNG_COUNTER_BASED
+    // mode: the base seed plus a constant drawn from the op's offset, computed
+    // on the host, so that no op depends on the seed of the previous one.
+    // Called with the lock of `devctx` held.
+    torch::lazy::Value GetCounterRngSeed(
+        DeviceContext* devctx, const torch::lazy::BackendDevice& device);
+
+    RngCounter& GetRngCounter(const torch::lazy::BackendDevice& device);
+
+    // A graph saved by SaveGraphAsString(), rendered at the first call to
+    // GetGraphByHash().
+    struct SavedGraph {
+      std::function<std::string()> render;
+      std::string graph;
+    };
+
+    // Below two maps are used for dynamo integration. They are shared by all
+    // the devices, and guarded by `graph_maps_lock_`.
+    std::mutex graph_maps_lock_;
+    std::unordered_map<torch::lazy::hash_t, SavedGraph,
                        torch::lazy::HashReducer>
         hash_to_graph_map_;
     std::unordered_map<torch::lazy::hash_t, std::vector<xla::Shape>,
                        torch::lazy::HashReducer>
         hash_to_output_shape_map_;
     bool enable_user_config_aliasing_ = false;
+
+    // A set of tensors by unique ID, split into shards of their own lock, so
+    // that the threads creating and destroying tensors seldom contend.
+    class TensorRegistry {
+     public:
+      void Insert(const std::shared_ptr<XLATensor::Data>& data);
+
+      void Erase(int64_t unique_id);
+
+      // Returns the live tensors of `device`, or of all devices, by device
+      // and increasing unique ID. Erases the destroyed tensors, and the ones
+      // `keep`, if any, rejects.
+      std::vector<XLATensorPtr> Collect(
+          const torch::lazy::BackendDevice* device,
+          const std::function<bool(const XLATensor::Data&)>& keep = nullptr);
+
+     private:
+      static constexpr size_t kNumShards = 64;
+
+      struct Shard {
+        std::mutex lock;
+        std::unordered_map<int64_t, std::weak_ptr<XLATensor::Data>> tensors;
+      };
+
+      Shard& GetShard(int64_t unique_id) {
+        return shards_[static_cast<uint64_t>(unique_id) % kNumShards];
+      }
+
+      std::array<Shard, kNumShards> shards_;
+    };
+
+    TensorRegistry live_tensors_;
+    // The tensors which may be dirty.
+    TensorRegistry dirty_tensors_;
+    // Guarded by `rng_counters_lock_`, keyed by device string.
+    std::mutex rng_counters_lock_;
+    std::unordered_map<std::string, RngCounter> rng_counters_;
   };
 
   XLAGraphExecutor() = default;
@@ -340,32 +674,74 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
       std::vector<torch::lazy::Value>& ir_values,
       std::vector<torch::lazy::BackendDataPtr>& tensor_data_vec);
 
-  // We don't use upstream FetchTensors as we have xla::Literal.
-  std::vector<at::Tensor> FetchTensors(std::vector<XLATensorPtr>* tensors,
-                                       absl::Span<const xla::Literal> literals,
-                                       const std::vector<size_t>* indices);
+  // We don't use upstream FetchTensors as we have xla::Literal. Transfers
+  // `tensors_data`, gathered for the `tensors` which have no host value, and
+  // converts each of them as soon as it lands.
+  std::vector<at::Tensor> FetchTensors(
+      std::vector<XLATensorPtr>* tensors,
+      absl::Span<const torch::lazy::BackendDataPtr> tensors_data,
+      const std::vector<size_t>* indices);
 
   // Schedules the execution of a sync tensors operation in background. The
   // asynchronous operation will hold the device locks by capturing the ones
   // present within the coll structure.
   // We don't use the upstream ScheduleSyncTensorsGraph since
   // our CachedComputation is different from upstream.
+  // If `cached_computation` is nullptr, `pending_computation` must be valid and
+  // the execution will wait for the background compilation to complete.
   std::shared_ptr<Async> ScheduleSyncTensorsGraph(
       SyncTensorCollection* coll,
       std::vector<torch::lazy::BackendDataPtr> parameters_data,
       std::vector<torch::lazy::BackendDataPtr> tensors_data,
       std::vector<XLATensor::ShardingSpecPtr> sharding_specs,
-      ComputationCache::TypePtr cached_computation);
+      ComputationCache::TypePtr cached_computation,
+      PendingCompilation pending_computation = {});
   std::shared_ptr<Async> ScheduleSyncTensorsGraph(
       std::vector<XLATensorPtr>* tensors, SyncTensorCollection* coll,
       std::vector<torch::lazy::BackendDataPtr> parameters_data,
       std::string device, ComputationCache::TypePtr cached_computation,
-      const std::vector<torch::lazy::BackendDataPtr>& tensor_data_vec);
+      const std::vector<torch::lazy::BackendDataPtr>& tensor_data_vec,
+      PendingCompilation pending_computation = {});
 
-  // Override to enable profiler.
+  // Override to enable profiler, and to reuse the post-order of roots which
+  // were already walked.
   PostOrderData RunPostOrder(const std::vector<torch::lazy::Value>& ir_values,
                              SyncTensorCollection* coll) final;
 
+  // Post-order data of the graphs most recently walked by RunPostOrder(), so
+  // that walking the same roots again, e.g. to hash a graph and then sync it,
+  // or to warm up the cache with it, skips the walk. An entry is only reused
+  // while its roots are alive, and all of them are dropped at step markers.
+  //
+  // Entries are matched by root identity rather than by DAG hash: the IR is
+  // rebuilt on every step, and the DAG hash does not tell whether equal
+  // subgraphs are shared, which changes the parameters of the graph.
+  // Entries are kept per device, so that the threads driving different
+  // devices neither evict nor clear each other's entries.
+  class PostOrderCache {
+   public:
+    std::optional<PostOrderData> Get(
+        const torch::lazy::BackendDevice& device,
+        const std::vector<torch::lazy::Value>& roots);
+    void Add(const torch::lazy::BackendDevice& device,
+             const std::vector<torch::lazy::Value>& roots,
+             const PostOrderData& po_data);
+    void Clear(const torch::lazy::BackendDevice& device);
+
+   private:
+    struct Entry {
+      std::vector<std::weak_ptr<torch::lazy::Node>> nodes;
+      std::vector<size_t> indices;
+      PostOrderData po_data;
+    };
+
+    static bool Matches(const Entry& entry,
+                        const std::vector<torch::lazy::Value>& roots);
+
+    std::mutex lock_;
+    std::map<torch::lazy::BackendDevice, std::list<Entry>> entries_;
+  };
+
   // We don't use the upstream LookupCachedCompile since
   // our CachedComputation is different from upstream.
   ComputationCache::TypePtr LookupCachedCompile(
@@ -379,6 +755,22 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
       const std::vector<torch::lazy::BackendDataPtr>& tensor_data_vec,
       bool warm_up_cache_only);
 
+  // Returns the computation to execute for the graph `hash` on `device`, whose
+  // cached computation is `cached_computation`: either the latter, or one of
+  // the candidates of the compile option autotuner being timed against it.
+  // Starts compiling the candidates once the graph turned hot.
+  ComputationCache::TypePtr SelectAutotunedComputation(
+      const torch::lazy::hash_t& hash, const torch::lazy::BackendDevice& device,
+      ComputationCache::TypePtr cached_computation);
+
+  // Records the execute time of `computation`, which
+  // SelectAutotunedComputation() returned for the graph `hash`, and replaces
+  // the cached computation of the graph with the winner of the autotuner,
+  // once picked.
+  void RecordAutotunedExecuteTime(const torch::lazy::hash_t& hash,
+                                  const CachedComputation* computation,
+                                  int64_t execute_time_ns);
+
   std::vector<size_t> GetBufferDonors(
       const std::vector<XLATensorPtr>& tensors,
       const SyncTensorCollection& coll,
@@ -387,14 +779,165 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
   void SetBufferDonors(LoweringContext* lowering_ctx,
                        const std::vector<size_t>& buffer_donor_indices);
 
+  // Merges the parameter sequence, the buffer donors and the auto-sharding
+  // configs into coll->hash. Returns the buffer donor indices.
+  std::vector<size_t> FinalizeGraphHash(
+      const std::vector<XLATensorPtr>& tensors, SyncTensorCollection* coll,
+      const PostOrderData& po_data);
+
+  // Returns the in-flight background compilation for `hash`, if any.
+  std::optional<PendingCompilation> LookupPendingCompilation(
+      const torch::lazy::hash_t& hash);
+
+  // Sends the compilation of `instances` to the compile thread pool. Once
+  // compiled, the computation is added to the computation cache under `hash`
+  // and the returned future becomes ready.
+  PendingCompilation ScheduleCompile(
+      const torch::lazy::hash_t& hash,
+      std::vector<runtime::ComputationClient::CompileInstance> instances,
+      xla::Shape output_shape, bool is_sharded);
+
+  // Sends `fn` to the thread pool once `pending` for `hash` has landed,
+  // instead of having a pool thread wait for it.
+  void ScheduleAfterCompilation(const torch::lazy::hash_t& hash,
+                                const PendingCompilation& pending,
+                                std::function<void()> fn);
+
+  // Schedules the work registered by ScheduleAfterCompilation() for `hash`.
+  void SchedulePendingExecutions(const torch::lazy::hash_t& hash);
+
+  // Lowers the IR graph into a CompileInstance ready to be passed to
+  // ComputationClient::Compile().
+  LoweringResult LowerGraph(absl::Span<const std::string> devices,
+                            const SyncTensorCollection& coll,
+                            PostOrderData* po_data,
+                            const std::vector<torch::lazy::Value>& ir_values,
+                            const std::vector<size_t>& buffer_donor_indices);
+
   // TODO(yeounoh) auto-sharding can change tensors shardings, which needs to be
   // accounted for in Dynamo integration.
+  // If `compile_async` is true, the lowering still happens on the calling
+  // thread but the XLA compilation is sent to the compile thread pool, and the
+  // returned CompilationResult holds a pending_computation instead.
   CompilationResult Compile(std::vector<XLATensorPtr>& tensors,
                             absl::Span<const std::string> devices,
                             const SyncTensorCollection& coll,
                             PostOrderData* po_data,
                             const std::vector<torch::lazy::Value>& ir_values,
-                            const std::vector<size_t>& buffer_donor_indices);
+                            const std::vector<size_t>& buffer_donor_indices,
+                            bool compile_async = false);
+
+  // Tracks the steps in flight on each device, from their scheduling on the
+  // tracing thread until their execution completes on the device. Bounds
+  // their number to XLA_MAX_INFLIGHT_STEPS, and reports the time the devices
+  // sit idle between steps as the DeviceIdleTime metric.
+  class InflightSteps {
+   public:
+    // Blocks until fewer than the maximum number of steps are in flight on
+    // `device`, and registers a new one.
+    void Start(const std::string& device);
+
+    // Marks a step of `device` dispatched for execution.
+    void Dispatched(const std::string& device);
+
+    // Releases a step of `device` once its execution completed, or failed.
+    void Finish(const std::string& device, bool dispatched);
+
+   private:
+    struct DeviceSteps {
+      std::mutex mutex;
+      std::condition_variable cv;
+      int64_t inflight = 0;
+      int64_t executing = 0;
+      // When the device ran out of executions, zero if it never had any.
+      int64_t idle_since_ns = 0;
+    };
+
+    // The steps of each device have their own lock, the devices never wait
+    // for each other.
+    DeviceSteps* GetDeviceSteps(const std::string& device);
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, std::unique_ptr<DeviceSteps>> devices_;
+  };
+
+  // Collects the GraphStats of every graph. The device time of an execution
+  // runs from its dispatch, or from the completion of the previous execution
+  // on the same device if it is later, to the moment its results are ready.
+  // At every step, the FLOPs and device times of the executions completed
+  // since the previous one are sampled as achieved TFLOP/s, and as model FLOPs
+  // utilization against $XLA_PEAK_TFLOPS if set.
+  class GraphStatsTracker {
+   public:
+    void RecordCompilation(const torch::lazy::hash_t& hash,
+                           int64_t compile_time_ns);
+
+    // Records the dispatch of an execution of `computation`.
+    void RecordExecution(
+        const torch::lazy::hash_t& hash,
+        const runtime::ComputationClient::Computation& computation);
+
+    // Records the completion of an execution on `device` which was dispatched
+    // at `dispatch_ns`, and returns its execute time.
+    int64_t RecordExecuteTime(const torch::lazy::hash_t& hash,
+                              const std::string& device, int64_t dispatch_ns);
+
+    // Ends the current step, and returns the device time of the executions
+    // completed in it.
+    int64_t MarkStep();
+
+    std::vector<GraphStats> Get();
+
+   private:
+    static constexpr size_t kMaxExecuteTimes = 128;
+
+    struct Entry {
+      GraphStats stats;
+      // Where the next execution time goes once the samples wrapped around.
+      size_t next_execute_time = 0;
+    };
+
+    Entry* GetEntry(const torch::lazy::hash_t& hash);
+
+    std::mutex mutex_;
+    std::map<torch::lazy::hash_t, Entry> graphs_;
+    // When the last execution on each device completed.
+    std::unordered_map<std::string, int64_t> device_ready_ns_;
+    std::atomic<int64_t> step_{0};
+    // FLOPs and device time of the executions completed in the current step.
+    double step_flops_ = 0;
+    int64_t step_execute_ns_ = 0;
+  };
+
+  // Predicts the graph each device runs after the one it is given to run, as
+  // the graph which followed the latter the last time it ran. Steady state
+  // training steps run the same graphs in the same order every step.
+  class GraphPredictor {
+   public:
+    // Records that `hash` runs next on `device`, and returns the graph
+    // predicted to run after it, if any.
+    std::optional<torch::lazy::hash_t> Next(const std::string& device,
+                                            const torch::lazy::hash_t& hash);
+
+   private:
+    struct DeviceGraphs {
+      std::optional<torch::lazy::hash_t> last;
+      std::optional<torch::lazy::hash_t> predicted;
+    };
+
+    std::mutex mutex_;
+    std::unordered_map<std::string, DeviceGraphs> devices_;
+    std::unordered_map<torch::lazy::hash_t, torch::lazy::hash_t,
+                       torch::lazy::HashReducer>
+        successors_;
+  };
+
+  // With $XLA_PREDICT_NEXT_GRAPH, loads the computation of the graph predicted
+  // to run on `device` after the graph `hash` back from the persistent cache,
+  // in the background, if it is no longer in memory, so that its execution
+  // does not wait for the deserialization.
+  void StageNextComputation(const torch::lazy::hash_t& hash,
+                            const torch::lazy::BackendDevice& device);
 
   // We don't use the upstream SyncTensorsGraphInternal since
   // our CachedComputation is different from upstream.
@@ -402,10 +945,43 @@ class XLAGraphExecutor : public torch::lazy::LazyGraphExecutor {
       std::vector<XLATensorPtr>* tensors, absl::Span<const std::string> devices,
       const SyncTensorsConfig& config, bool warm_up_cache_only = false);
 
+  // Splits the graph of `ir_values`, when larger than
+  // $XLA_GRAPH_SPLIT_MAX_NODES nodes or $XLA_GRAPH_SPLIT_MAX_PARAMETERS
+  // parameters, into the pieces SplitPostOrder() cuts it into. Runs every
+  // piece but the last one, as a graph of its own, and records the device
+  // data of the outputs they hand over, which the last piece, lowered from
+  // `ir_values` right after, takes as parameters.
+  void SplitGraph(absl::Span<const std::string> devices,
+                  const SyncTensorCollection& coll,
+                  const std::vector<torch::lazy::Value>& ir_values);
+
   ComputationCache* computation_cache_;
+  // Background compilations which have not landed in the computation cache
+  // yet, keyed by graph hash.
+  std::mutex pending_compilations_lock_;
+  std::unordered_map<torch::lazy::hash_t, PendingCompilation,
+                     torch::lazy::HashReducer>
+      pending_compilations_;
+  // Work waiting for a background compilation to land, keyed by graph hash.
+  std::unordered_map<torch::lazy::hash_t, std::vector<std::function<void()>>,
+                     torch::lazy::HashReducer>
+      pending_executions_;
+  PostOrderCache post_order_cache_;
+  InflightSteps inflight_steps_;
+  GraphStatsTracker graph_stats_;
+  GraphPredictor graph_predictor_;
   bool use_eager_mode_ = false;
+  bool eager_warm_up_ = false;
+  // The tensors of the eager ops not synced yet, all on
+  // `eager_window_device_`, guarded by `eager_window_lock_`.
+  std::mutex eager_window_lock_;
+  std::vector<std::weak_ptr<XLATensor::Data>> eager_window_;
+  std::optional<torch::lazy::BackendDevice> eager_window_device_;
+  size_t eager_window_ops_ = 0;
   bool allow_execution_ = true;
   std::string current_graph_name_ = "";
+  std::optional<int64_t> parameter_wrapping_threshold_;
+  std::optional<double> topk_recall_target_;
 };
 
 }  // namespace torch_xla
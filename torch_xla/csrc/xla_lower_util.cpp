@@ -1,18 +1,22 @@
 #include "torch_xla/csrc/xla_lower_util.h"
 
 #include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <vector>
 
 #include <torch/csrc/lazy/core/helpers.h>
 #include <torch/csrc/lazy/core/util.h>
 
 #include "absl/status/status.h"
+#include "xla/hlo/builder/lib/approx_topk.h"
 #include "xla/hlo/builder/lib/arithmetic.h"
 #include "xla/hlo/builder/lib/comparators.h"
 #include "xla/hlo/builder/lib/constants.h"
 #include "xla/hlo/builder/lib/loops.h"
 #include "xla/hlo/builder/lib/math.h"
 #include "xla/hlo/builder/lib/slicing.h"
+#include "xla/primitive_util.h"
 #include "xla/shape_util.h"
 #include "xla/stream_executor/dnn.h"
 #include "xla/util.h"
@@ -25,8 +29,10 @@
 #include "torch_xla/csrc/random.h"
 #include "torch_xla/csrc/reduction.h"
 #include "torch_xla/csrc/runtime/debug_macros.h"
+#include "torch_xla/csrc/runtime/sys_util.h"
 #include "torch_xla/csrc/runtime/util.h"
 #include "torch_xla/csrc/shape_helper.h"
+#include "torch_xla/csrc/softmax_builder.h"
 #include "torch_xla/csrc/status.h"
 #include "torch_xla/csrc/tensor_util.h"
 
@@ -86,6 +92,73 @@ bool ShouldUseDenseScatter(const torch::lazy::BackendDevice& device,
   return false;
 }
 
+// The sums of the rows of `values`, of shape [N, W], which have the same of
+// the S64 `keys`, of shape [N]. The rows are sorted by key, and every run of
+// rows of the same key is summed with a segmented scan, in an order which does
+// not depend on the device. Returns the sums, each in the last row of its run,
+// and the keys to scatter the rows to: the key of the run for its last row,
+// and distinct keys from `bound` up, which scatter drops, for the others.
+std::pair<xla::XlaOp, xla::XlaOp> BuildSortedSegmentSums(xla::XlaOp keys,
+                                                         xla::XlaOp values,
+                                                         int64_t bound) {
+  xla::XlaBuilder* builder = keys.builder();
+  const xla::Shape& values_shape = ShapeHelper::ShapeOfXlaOp(values);
+  int64_t num_rows = values_shape.dimensions(0);
+  xla::XlaOp rows = xla::Iota(
+      builder, xla::ShapeUtil::MakeShape(xla::PrimitiveType::S64, {num_rows}),
+      0);
+  xla::XlaOp sorted = xla::Sort(
+      {keys, rows},
+      xla::CreateScalarLtComputation(
+          {xla::PrimitiveType::S64, xla::PrimitiveType::S64}, builder),
+      /*dimension=*/0, /*is_stable=*/true);
+  xla::XlaOp sorted_keys = xla::GetTupleElement(sorted, 0);
+  xla::XlaOp sums =
+      xla::TorchIndexSelect(values, xla::GetTupleElement(sorted, 1), 0);
+  // After the step of a shift, every row holds the sum of the up to 2 * shift
+  // rows of its key ending with it. The rows of a key are contiguous, so the
+  // row shift rows up has the same key only if all of the rows between do.
+  for (int64_t shift = 1; shift < num_rows; shift *= 2) {
+    xla::XlaOp same_key = PadInDim(
+        xla::Eq(xla::SliceInDim(sorted_keys, shift, num_rows, 1, 0),
+                xla::SliceInDim(sorted_keys, 0, num_rows - shift, 1, 0)),
+        0, /*pad_lo=*/shift, /*pad_hi=*/0);
+    xla::XlaOp shifted =
+        PadInDim(xla::SliceInDim(sums, 0, num_rows - shift, 1, 0), 0,
+                 /*pad_lo=*/shift, /*pad_hi=*/0);
+    sums = xla::Select(
+        xla::BroadcastInDim(same_key, values_shape.dimensions(), {0}),
+        sums + shifted, sums);
+  }
+  xla::XlaOp true_value = xla::ConstantR0<bool>(builder, true);
+  xla::XlaOp is_last = PadInDim(
+      xla::Ne(xla::SliceInDim(sorted_keys, 0, num_rows - 1, 1, 0),
+              xla::SliceInDim(sorted_keys, 1, num_rows, 1, 0)),
+      0, /*pad_lo=*/0, /*pad_hi=*/1, &true_value);
+  xla::XlaOp dropped_keys =
+      rows + xla::ConstantR0<int64_t>(builder, bound);
+  return {xla::Select(is_last, sorted_keys, dropped_keys), sums};
+}
+
+// Scatters the [N, W] `sums` into the rows of `buffer` at the [N] `keys` of
+// BuildSortedSegmentSums(), which are unique, and returns it in `shape`.
+xla::XlaOp ScatterSegmentSums(xla::XlaOp buffer, xla::XlaOp keys,
+                              xla::XlaOp sums, const xla::Shape& shape) {
+  xla::PrimitiveType type = shape.element_type();
+  xla::ScatterDimensionNumbers dim_numbers;
+  dim_numbers.set_index_vector_dim(1);
+  dim_numbers.add_update_window_dims(1);
+  dim_numbers.add_inserted_window_dims(0);
+  dim_numbers.add_scatter_dims_to_operand_dims(0);
+  xla::XlaOp scatter_indices =
+      xla::Reshape(keys, {ShapeHelper::ShapeOfXlaOp(keys).dimensions(0), 1});
+  xla::XlaOp result =
+      xla::Scatter(buffer, scatter_indices, sums,
+                   XlaHelpers::CreateAddComputation(type), dim_numbers,
+                   /*indices_are_sorted=*/false, /*unique_indices=*/true);
+  return xla::Reshape(result, shape.dimensions());
+}
+
 xla::XlaOp DotExpand(xla::XlaOp op, const xla::Shape& op_shape,
                      const xla::Shape& to_shape) {
   int64_t rank_delta = to_shape.dimensions_size() - op_shape.dimensions_size();
@@ -276,7 +349,16 @@ xla::XlaOp XlaDenseScatter(xla::XlaOp input, xla::XlaOp index, xla::XlaOp src,
   });
 }
 
-std::vector<xla::XlaOp> BuildConditionIndices(xla::XlaOp condition) {
+// Zeroes the rows of `input` past the first `length` ones.
+xla::XlaOp ZeroPastLength(xla::XlaOp input, xla::XlaOp length) {
+  xla::Shape rows_shape = ShapeHelper::ShapeOfXlaOp(input);
+  rows_shape.set_element_type(ShapeHelper::ShapeOfXlaOp(length).element_type());
+  xla::XlaOp rows = xla::Iota(input.builder(), rows_shape, 0);
+  return xla::Select(xla::Lt(rows, length), input, xla::ZerosLike(input));
+}
+
+std::vector<xla::XlaOp> BuildConditionIndices(xla::XlaOp condition,
+                                              bool bounded = false) {
   ConditionMaskData cmd = CreateConditionMaskData(condition);
   std::vector<xla::XlaOp> to_sort = {cmd.r1_condition_int};
   std::vector<xla::PrimitiveType> types_to_sort = {cmd.condition_int_type};
@@ -300,10 +382,26 @@ std::vector<xla::XlaOp> BuildConditionIndices(xla::XlaOp condition) {
   }
 
   xla::XlaOp result = xla::ConcatInDim(condition.builder(), to_concat, 1);
+  if (bounded) {
+    return {ZeroPastLength(result, cmd.length), cmd.length};
+  }
   xla::XlaOp result_padded = xla::SetDimensionSize(result, cmd.length, 0);
   return {result_padded, cmd.length};
 }
 
+// The sum of the squares of the elements of `input` over `dims`, or over all
+// of them if `dims` is empty.
+xla::XlaOp SumOfSquares(xla::XlaOp input, absl::Span<const int64_t> dims = {}) {
+  xla::PrimitiveType type = ShapeHelper::ShapeOfXlaOp(input).element_type();
+  xla::XlaOp zero = xla::Zero(input.builder(), type);
+  if (dims.empty()) {
+    return xla::ReduceAll(input * input, zero,
+                          XlaHelpers::CreateAddComputation(type));
+  }
+  return xla::Reduce(input * input, zero,
+                     XlaHelpers::CreateAddComputation(type), dims);
+}
+
 }  // namespace
 
 xla::XlaOp PadToSize(xla::XlaOp input, absl::Span<const int64_t> size,
@@ -396,6 +494,220 @@ std::vector<xla::XlaOp> CreateTopK(xla::XlaOp input, int64_t k, int64_t dim,
                                                xla::PrimitiveType::S64))};
 }
 
+std::vector<xla::XlaOp> CreateApproxTopK(xla::XlaOp input, int64_t k,
+                                         int64_t dim, bool largest,
+                                         float recall_target,
+                                         bool custom_call) {
+  const xla::Shape& shape = ShapeHelper::ShapeOfXlaOp(input);
+  XLA_CHECK_LE(k, shape.dimensions(dim));
+  XLA_CHECK(recall_target > 0 && recall_target <= 1)
+      << "The recall target of the approximate top-k must be in (0, 1], got "
+      << recall_target;
+  xla::XlaBuilder* builder = input.builder();
+  xla::Shape iota_shape =
+      xla::ShapeUtil::MakeShape(xla::PrimitiveType::S32, shape.dimensions());
+  xla::XlaOp iota = xla::Iota(builder, iota_shape, dim);
+  xla::XlaComputation comparator =
+      largest ? xla::CreateScalarGtComputation(
+                    {shape.element_type(), xla::PrimitiveType::S32}, builder)
+              : xla::CreateScalarLtComputation(
+                    {shape.element_type(), xla::PrimitiveType::S32}, builder);
+  // The values of the padding of the reduction, which never make the top-k.
+  std::vector<xla::XlaOp> init_values = {
+      xla::ConstantLiteral(
+          builder, largest ? xla::LiteralUtil::MinValue(shape.element_type())
+                           : xla::LiteralUtil::MaxValue(shape.element_type())),
+      xla::ConstantR0<int32_t>(builder, -1)};
+  xla::XlaOp result =
+      custom_call
+          ? xla::ApproxTopK(builder, {input, iota}, init_values, k, dim,
+                            comparator, recall_target,
+                            /*aggregate_to_topk=*/true)
+          : xla::ApproxTopKFallback(builder, {input, iota}, init_values, k,
+                                    dim, comparator, recall_target,
+                                    /*aggregate_to_topk=*/true);
+  xla::XlaOp indices = xla::GetTupleElement(result, 1);
+  return {xla::GetTupleElement(result, 0),
+          xla::ConvertElementType(indices, GetXlaPrimitiveTypeForCurrentDevice(
+                                               xla::PrimitiveType::S64))};
+}
+
+xla::XlaOp BuildQuantizedDot(xla::XlaOp x, xla::XlaOp w, xla::XlaOp scale,
+                             xla::XlaOp x_scale, xla::XlaOp zero_point,
+                             int64_t block_size,
+                             xla::PrimitiveType output_type) {
+  const xla::Shape& x_shape = ShapeHelper::ShapeOfXlaOp(x);
+  const xla::Shape& w_shape = ShapeHelper::ShapeOfXlaOp(w);
+  const int64_t rank = x_shape.dimensions_size();
+  XLA_CHECK_GE(rank, 1);
+  const int64_t in_features = x_shape.dimensions(rank - 1);
+  std::vector<int64_t> rows(x_shape.dimensions().begin(),
+                            x_shape.dimensions().end() - 1);
+  const int64_t num_rows = runtime::util::Multiply<int64_t>(rows);
+  const xla::PrimitiveType x_type = x_shape.element_type();
+  const xla::PrimitiveType w_type = w_shape.element_type();
+  const bool integral = xla::primitive_util::IsIntegralType(x_type);
+  XLA_CHECK(!integral || xla::primitive_util::IsIntegralType(w_type))
+      << "An integer activation needs an integer weight, got "
+      << xla::primitive_util::LowercasePrimitiveTypeName(w_type);
+  XLA_CHECK(x_scale.valid() == integral)
+      << "The activation scale goes with an int8 activation";
+  // The floating point activations are multiplied by the quantized weight in
+  // a mixed precision dot, so the weight is only read in its quantized type,
+  // and the int4 weights are widened to int8 for the int8 activations.
+  const xla::PrimitiveType accumulation_type =
+      integral ? xla::PrimitiveType::S32 : x_type;
+  xla::XlaOp rhs = w;
+  if (integral && w_type != xla::PrimitiveType::S8) {
+    rhs = xla::ConvertElementType(w, xla::PrimitiveType::S8);
+  }
+  xla::XlaOp lhs = xla::Reshape(x, {num_rows, in_features});
+  auto to_f32 = [](xla::XlaOp op) {
+    return xla::ConvertElementType(op, xla::PrimitiveType::F32);
+  };
+
+  xla::XlaOp output;
+  int64_t out_features;
+  xla::DotDimensionNumbers dims;
+  if (block_size < 0) {
+    XLA_CHECK(w_shape.dimensions_size() == 2 &&
+              w_shape.dimensions(1) == in_features)
+        << "The per channel weight must be of shape [N, " << in_features
+        << "], got " << w_shape;
+    out_features = w_shape.dimensions(0);
+    dims.add_lhs_contracting_dimensions(1);
+    dims.add_rhs_contracting_dimensions(1);
+    // [M, N]
+    output =
+        to_f32(xla::DotGeneral(lhs, rhs, dims, /*precision_config=*/nullptr,
+                               accumulation_type)) *
+        xla::BroadcastInDim(to_f32(scale), {num_rows, out_features}, {1});
+    if (zero_point.valid()) {
+      xla::XlaOp sums = xla::Reduce(
+          to_f32(lhs), xla::Zero(x.builder(), xla::PrimitiveType::F32),
+          XlaHelpers::CreateAddComputation(xla::PrimitiveType::F32), {1});
+      output = output -
+               xla::BroadcastInDim(sums, {num_rows, out_features}, {0}) *
+                   xla::BroadcastInDim(to_f32(zero_point),
+                                       {num_rows, out_features}, {1});
+    }
+  } else {
+    XLA_CHECK(!integral)
+        << "The blockwise quantized dot takes floating point activations";
+    XLA_CHECK(block_size > 0 && in_features % block_size == 0)
+        << "The block size " << block_size << " does not divide "
+        << in_features;
+    const int64_t num_blocks = in_features / block_size;
+    XLA_CHECK(w_shape.dimensions_size() == 3 &&
+              w_shape.dimensions(0) == num_blocks &&
+              w_shape.dimensions(1) == block_size)
+        << "The blockwise weight must be of shape [" << num_blocks << ", "
+        << block_size << ", N], got " << w_shape;
+    out_features = w_shape.dimensions(2);
+    xla::XlaOp blocks = xla::Reshape(lhs, {num_rows, num_blocks, block_size});
+    dims.add_lhs_batch_dimensions(1);
+    dims.add_rhs_batch_dimensions(0);
+    dims.add_lhs_contracting_dimensions(2);
+    dims.add_rhs_contracting_dimensions(1);
+    // [S, M, N], scaled per block, then summed over the blocks.
+    std::vector<int64_t> block_dims = {num_blocks, num_rows, out_features};
+    xla::XlaOp products =
+        to_f32(xla::DotGeneral(blocks, rhs, dims, /*precision_config=*/nullptr,
+                               accumulation_type)) *
+        xla::BroadcastInDim(to_f32(scale), block_dims, {0, 2});
+    output = xla::Reduce(
+        products, xla::Zero(x.builder(), xla::PrimitiveType::F32),
+        XlaHelpers::CreateAddComputation(xla::PrimitiveType::F32), {0});
+    if (zero_point.valid()) {
+      // [M, S] x [S, N]
+      xla::XlaOp sums = xla::Reduce(
+          to_f32(blocks), xla::Zero(x.builder(), xla::PrimitiveType::F32),
+          XlaHelpers::CreateAddComputation(xla::PrimitiveType::F32), {2});
+      output = output - xla::Dot(sums, to_f32(zero_point));
+    }
+  }
+  if (x_scale.valid()) {
+    output = output * xla::BroadcastInDim(
+                          xla::Reshape(to_f32(x_scale), {num_rows}),
+                          {num_rows, out_features}, {0});
+  }
+  rows.push_back(out_features);
+  return xla::Reshape(xla::ConvertElementType(output, output_type), rows);
+}
+
+std::vector<xla::XlaOp> BuildFp8Dot(
+    xla::XlaOp lhs, xla::XlaOp rhs, xla::XlaOp lhs_scale, xla::XlaOp rhs_scale,
+    xla::XlaOp lhs_amax_history, xla::XlaOp rhs_amax_history,
+    xla::PrimitiveType lhs_type, xla::PrimitiveType rhs_type,
+    int64_t rhs_contracting_dim, int64_t margin,
+    xla::PrimitiveType output_type) {
+  xla::XlaBuilder* builder = lhs.builder();
+  auto to_f32 = [](xla::XlaOp op) {
+    return xla::ConvertElementType(op, xla::PrimitiveType::F32);
+  };
+  xla::XlaOp zero = xla::Zero(builder, xla::PrimitiveType::F32);
+  xla::XlaComputation max_computation =
+      XlaHelpers::CreateMaxComputation(xla::PrimitiveType::F32);
+  // Returns the FP8 operand, its new scale and its new amax history.
+  auto cast = [&](xla::XlaOp input, xla::XlaOp scale, xla::XlaOp amax_history,
+                  xla::PrimitiveType type) -> std::vector<xla::XlaOp> {
+    xla::XlaOp max_value = to_f32(xla::MaxFiniteValue(builder, type));
+    xla::XlaOp value = to_f32(input);
+    xla::XlaOp current_scale = to_f32(scale);
+    xla::XlaOp fp8_value = xla::ConvertElementType(
+        xla::Clamp(xla::Neg(max_value), value * current_scale, max_value),
+        type);
+
+    const xla::Shape& history_shape = ShapeHelper::ShapeOfXlaOp(amax_history);
+    XLA_CHECK_EQ(history_shape.dimensions_size(), 1)
+        << "The amax history must be 1D, got " << history_shape;
+    int64_t history_length = history_shape.dimensions(0);
+    XLA_CHECK_GE(history_length, 1);
+    xla::XlaOp amax = xla::Reshape(
+        xla::ReduceAll(xla::Abs(value), zero, max_computation), {1});
+    xla::XlaOp history = amax;
+    if (history_length > 1) {
+      history = xla::ConcatInDim(
+          builder,
+          {amax, xla::SliceInDim(to_f32(amax_history), 0, history_length - 1,
+                                 1, 0)},
+          0);
+    }
+    xla::XlaOp history_amax = xla::ReduceAll(history, zero, max_computation);
+    xla::XlaOp next_scale =
+        max_value / history_amax /
+        XlaHelpers::ScalarValue<float>(std::ldexp(1.0f, margin), builder);
+    next_scale = xla::Select(
+        xla::And(xla::Gt(history_amax, zero), xla::IsFinite(history_amax)),
+        next_scale, current_scale);
+    return {fp8_value,
+            xla::ConvertElementType(
+                next_scale, ShapeHelper::ShapeOfXlaOp(scale).element_type()),
+            xla::ConvertElementType(history, history_shape.element_type())};
+  };
+
+  std::vector<xla::XlaOp> lhs_cast =
+      cast(lhs, lhs_scale, lhs_amax_history, lhs_type);
+  std::vector<xla::XlaOp> rhs_cast =
+      cast(rhs, rhs_scale, rhs_amax_history, rhs_type);
+  const xla::Shape& lhs_shape = ShapeHelper::ShapeOfXlaOp(lhs);
+  const xla::Shape& rhs_shape = ShapeHelper::ShapeOfXlaOp(rhs);
+  XLA_CHECK_GE(lhs_shape.dimensions_size(), 1);
+  XLA_CHECK(rhs_shape.dimensions_size() == 2 &&
+            (rhs_contracting_dim == 0 || rhs_contracting_dim == 1))
+      << "The rhs must be 2D and contracted on one of its dimensions, got "
+      << rhs_shape << " contracted on " << rhs_contracting_dim;
+  xla::DotDimensionNumbers dims;
+  dims.add_lhs_contracting_dimensions(lhs_shape.dimensions_size() - 1);
+  dims.add_rhs_contracting_dimensions(rhs_contracting_dim);
+  xla::XlaOp output =
+      xla::DotGeneral(lhs_cast[0], rhs_cast[0], dims,
+                      /*precision_config=*/nullptr, xla::PrimitiveType::F32) /
+      (to_f32(lhs_scale) * to_f32(rhs_scale));
+  return {xla::ConvertElementType(output, output_type), lhs_cast[1],
+          rhs_cast[1], lhs_cast[2], rhs_cast[2]};
+}
+
 xla::XlaOp CreateMatMul(xla::XlaOp lhs, xla::XlaOp rhs) {
   // Expand cases in https://pytorch.org/docs/stable/torch.html#torch.matmul
   xla::Shape lhs_shape = ShapeHelper::ShapeOfXlaOp(lhs);
@@ -539,6 +851,16 @@ std::vector<xla::XlaOp> BuildNativeDropout(xla::XlaOp input, xla::XlaOp seed,
   }
 }
 
+xla::XlaOp BuildDropoutMask(xla::XlaOp seed, const xla::Shape& input_shape,
+                            float probability) {
+  // The barrier keeps XLA from merging the regenerated bits with the ones of
+  // the forward, which would keep them alive until the backward again.
+  seed = xla::OptimizationBarrier(seed);
+  xla::XlaOp prob = XlaHelpers::ScalarBroadcast<float>(
+      1 - probability, input_shape, seed.builder());
+  return BuildBernoulli(prob, seed, xla::PrimitiveType::PRED);
+}
+
 std::vector<xla::XlaOp> CreateBroadcastTensors(
     absl::Span<const xla::XlaOp> operands) {
   xla::Shape result_shape = ShapeHelper::ShapeOfXlaOp(operands.front());
@@ -769,6 +1091,132 @@ xla::XlaOp CreatePut(const torch::lazy::BackendDevice& device, xla::XlaOp input,
   return XlaHelpers::DynamicReshapeAs(r1_scatter, input_shape);
 }
 
+bool UseSortedScatterAdd(const xla::Shape& shape) {
+  static const bool use_sorted_scatter_add =
+      runtime::sys_util::GetEnvBool("XLA_SORTED_SCATTER_ADD", false);
+  return use_sorted_scatter_add &&
+         shape.element_type() != xla::PrimitiveType::PRED &&
+         xla::ShapeUtil::ElementsIn(shape) > 0;
+}
+
+xla::XlaOp CreateSortedIndexAdd(xla::XlaOp buffer, xla::XlaOp indices,
+                                xla::XlaOp values) {
+  const xla::Shape& buffer_shape = ShapeHelper::ShapeOfXlaOp(buffer);
+  const xla::Shape& indices_shape = ShapeHelper::ShapeOfXlaOp(indices);
+  XLA_CHECK_EQ(indices_shape.dimensions(indices_shape.dimensions_size() - 1),
+               1);
+  std::vector<int64_t> values_dims(indices_shape.dimensions().begin(),
+                                   indices_shape.dimensions().end() - 1);
+  int64_t num_rows = xla::ShapeUtil::ElementsIn(indices_shape);
+  if (num_rows == 0) {
+    return buffer;
+  }
+  int64_t num_buffer_rows = buffer_shape.dimensions(0);
+  int64_t row_size = 1;
+  for (int64_t dim = 1; dim < buffer_shape.dimensions_size(); ++dim) {
+    values_dims.push_back(buffer_shape.dimensions(dim));
+    row_size *= buffer_shape.dimensions(dim);
+  }
+  xla::XlaOp rows = values;
+  const xla::Shape& values_shape = ShapeHelper::ShapeOfXlaOp(values);
+  if (buffer_shape.element_type() != values_shape.element_type()) {
+    rows = ConvertTo(rows, values_shape.element_type(),
+                     buffer_shape.element_type());
+  }
+  rows = xla::Reshape(BuildExpand(rows, values_dims), {num_rows, row_size});
+  xla::XlaOp keys = xla::Reshape(
+      xla::ConvertElementType(indices, xla::PrimitiveType::S64), {num_rows});
+  auto [scatter_keys, sums] =
+      BuildSortedSegmentSums(keys, rows, num_buffer_rows);
+  return ScatterSegmentSums(
+      xla::Reshape(buffer, {num_buffer_rows, row_size}), scatter_keys, sums,
+      buffer_shape);
+}
+
+std::pair<xla::XlaOp, xla::XlaOp> CreateUniqueSegmentSums(xla::XlaOp keys,
+                                                          xla::XlaOp values,
+                                                          int64_t bound) {
+  xla::XlaBuilder* builder = keys.builder();
+  int64_t num_rows = ShapeHelper::ShapeOfXlaOp(values).dimensions(0);
+  if (num_rows == 0) {
+    return {keys, values};
+  }
+  auto [segment_keys, sums] = BuildSortedSegmentSums(keys, values, bound);
+  // Moves the sums of the keys in bounds first, in key order, and the other
+  // rows after them, in row order.
+  xla::XlaOp rows = xla::Iota(
+      builder, xla::ShapeUtil::MakeShape(xla::PrimitiveType::S64, {num_rows}),
+      0);
+  xla::XlaOp bound_value = xla::ConstantR0<int64_t>(builder, bound);
+  xla::XlaOp in_bounds =
+      xla::And(xla::Ge(segment_keys, xla::ConstantR0<int64_t>(builder, 0)),
+               xla::Lt(segment_keys, bound_value));
+  xla::XlaOp sorted = xla::Sort(
+      {xla::Select(in_bounds, segment_keys, rows + bound_value), rows},
+      xla::CreateScalarLtComputation(
+          {xla::PrimitiveType::S64, xla::PrimitiveType::S64}, builder));
+  xla::XlaOp order = xla::GetTupleElement(sorted, 1);
+  xla::XlaOp unique_in_bounds = xla::TorchIndexSelect(in_bounds, order, 0);
+  xla::XlaOp unique_keys = xla::Select(
+      unique_in_bounds, xla::TorchIndexSelect(segment_keys, order, 0),
+      xla::Broadcast(bound_value, {num_rows}));
+  xla::XlaOp unique_sums = xla::TorchIndexSelect(sums, order, 0);
+  const xla::Shape& sums_shape = ShapeHelper::ShapeOfXlaOp(unique_sums);
+  unique_sums = xla::Select(
+      xla::BroadcastInDim(unique_in_bounds, sums_shape.dimensions(), {0}),
+      unique_sums, xla::ZerosLike(unique_sums));
+  return {unique_keys, unique_sums};
+}
+
+xla::XlaOp CreateSortedScatterAdd(xla::XlaOp input, xla::XlaOp index,
+                                  xla::XlaOp source, int64_t dim) {
+  const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
+  const xla::Shape& index_shape = ShapeHelper::ShapeOfXlaOp(index);
+  const xla::Shape& source_shape = ShapeHelper::ShapeOfXlaOp(source);
+  XLA_CHECK_EQ(source_shape.dimensions_size(), index_shape.dimensions_size());
+  if (xla::ShapeUtil::ElementsIn(index_shape) == 0) {
+    return input;
+  }
+  xla::XlaBuilder* builder = input.builder();
+  xla::XlaOp source_op = source;
+  if (source_shape.dimensions() != index_shape.dimensions()) {
+    std::vector<int64_t> base_indices(source_shape.dimensions_size(), 0);
+    source_op = BuildSlice(source_op, base_indices, index_shape.dimensions());
+  }
+  if (source_shape.element_type() != input_shape.element_type()) {
+    source_op = ConvertTo(source_op, source_shape.element_type(),
+                          input_shape.element_type());
+  }
+  // Every element scatters to the linear index of its position in the input,
+  // with the index along `dim`. The out of bounds ones get a negative key, and
+  // thus a sum which scatter drops.
+  xla::Shape key_shape = xla::ShapeUtil::ChangeElementType(
+      index_shape, xla::PrimitiveType::S64);
+  xla::XlaOp index_op = xla::ConvertElementType(index, xla::PrimitiveType::S64);
+  xla::XlaOp keys = xla::Zero(builder, xla::PrimitiveType::S64);
+  int64_t stride = 1;
+  for (int64_t i = input_shape.dimensions_size() - 1; i >= 0; --i) {
+    xla::XlaOp coordinate =
+        i == dim ? index_op : xla::Iota(builder, key_shape, i);
+    keys = keys + coordinate * xla::ConstantR0<int64_t>(builder, stride);
+    stride *= input_shape.dimensions(i);
+  }
+  xla::XlaOp in_bounds = xla::And(
+      xla::Ge(index_op, xla::Zero(builder, xla::PrimitiveType::S64)),
+      xla::Lt(index_op, xla::ConstantR0<int64_t>(builder,
+                                                 input_shape.dimensions(dim))));
+  keys = xla::Select(in_bounds, keys,
+                     xla::Broadcast(xla::ConstantR0<int64_t>(builder, -1),
+                                    index_shape.dimensions()));
+  int64_t num_elements = xla::ShapeUtil::ElementsIn(index_shape);
+  int64_t num_input_elements = xla::ShapeUtil::ElementsIn(input_shape);
+  auto [scatter_keys, sums] = BuildSortedSegmentSums(
+      xla::Reshape(keys, {num_elements}),
+      xla::Reshape(source_op, {num_elements, 1}), num_input_elements);
+  return ScatterSegmentSums(xla::Reshape(input, {num_input_elements, 1}),
+                            scatter_keys, sums, input_shape);
+}
+
 xla::XlaOp BuildLinspace(const torch::lazy::BackendDevice& device,
                          xla::XlaOp start, xla::XlaOp end, int64_t steps) {
   XLA_CHECK_GE(steps, 0);
@@ -812,13 +1260,15 @@ xla::XlaOp BuildCountNonzero(xla::XlaOp input, std::vector<int64_t> dims) {
   }
 }
 
-std::vector<xla::XlaOp> BuildNonZero(xla::XlaOp input) {
+std::vector<xla::XlaOp> BuildNonZero(xla::XlaOp input, bool bounded) {
   const xla::Shape& input_shape = ShapeHelper::ShapeOfXlaOp(input);
   return BuildConditionIndices(
-      xla::Ne(input, xla::Zero(input.builder(), input_shape.element_type())));
+      xla::Ne(input, xla::Zero(input.builder(), input_shape.element_type())),
+      bounded);
 }
 
-std::vector<xla::XlaOp> BuildMaskedSelect(xla::XlaOp input, xla::XlaOp mask) {
+std::vector<xla::XlaOp> BuildMaskedSelect(xla::XlaOp input, xla::XlaOp mask,
+                                          bool bounded) {
   xla::Shape input_shape;
   xla::XlaOp r1_input = XlaHelpers::Flatten(input, &input_shape);
   xla::XlaOp r1_bcast_mask = GetPromotedR1Mask(mask, input_shape);
@@ -831,6 +1281,9 @@ std::vector<xla::XlaOp> BuildMaskedSelect(xla::XlaOp input, xla::XlaOp mask) {
       /*dimension=*/0,
       /*is_stable=*/true);
   xla::XlaOp sorted_input = xla::GetTupleElement(sorted, 1);
+  if (bounded) {
+    return {ZeroPastLength(sorted_input, cmd.length), cmd.length};
+  }
   xla::XlaOp sorted_input_padded =
       xla::SetDimensionSize(sorted_input, cmd.length, 0);
   return {sorted_input_padded, cmd.length};
@@ -1052,6 +1505,160 @@ std::vector<xla::XlaOp> BuildAdamOptimizerStep(
   return results;
 }
 
+std::vector<xla::XlaOp> BuildMultiTensorAdamOptimizerStep(
+    const xla::XlaOp& found_inf, absl::Span<const xla::XlaOp> steps,
+    absl::Span<const xla::XlaOp> params, absl::Span<const xla::XlaOp> grads,
+    absl::Span<const xla::XlaOp> exp_avgs,
+    absl::Span<const xla::XlaOp> exp_avg_sqs,
+    absl::Span<const xla::XlaOp> max_exp_avg_sqs, const xla::XlaOp& beta1,
+    const xla::XlaOp& beta2, const xla::XlaOp& lr,
+    const xla::XlaOp& weight_decay, const xla::XlaOp& eps,
+    bool use_weight_decay, bool use_amsgrad, bool use_adamw) {
+  std::vector<xla::XlaOp> results;
+  results.reserve(params.size() * (use_amsgrad ? 5 : 4));
+  for (size_t i = 0; i < params.size(); ++i) {
+    std::vector<xla::XlaOp> param_results = BuildAdamOptimizerStep(
+        found_inf, steps[i], params[i], grads[i], exp_avgs[i], exp_avg_sqs[i],
+        use_amsgrad ? max_exp_avg_sqs[i] : xla::XlaOp(), beta1, beta2, lr,
+        weight_decay, eps, use_weight_decay, use_amsgrad, use_adamw);
+    results.insert(results.end(), param_results.begin(), param_results.end());
+  }
+  return results;
+}
+
+std::vector<xla::XlaOp> BuildLambOptimizerStep(
+    const xla::XlaOp& found_inf, const xla::XlaOp& step,
+    const xla::XlaOp& param, const xla::XlaOp& grad, const xla::XlaOp& exp_avg,
+    const xla::XlaOp& exp_avg_sq, const xla::XlaOp& beta1,
+    const xla::XlaOp& beta2, const xla::XlaOp& lr,
+    const xla::XlaOp& weight_decay, const xla::XlaOp& eps,
+    bool use_weight_decay) {
+  // XLA version of the LAMB algorithm of
+  // https://arxiv.org/abs/1904.00962, with bias correction.
+  xla::PrimitiveType type = ShapeHelper::ShapeOfXlaOp(param).element_type();
+  xla::XlaOp one = xla::One(param.builder(), type);
+  xla::XlaOp zero = xla::Zero(param.builder(), type);
+
+  xla::XlaOp found_inf_cond = xla::Ne(found_inf, zero);
+  xla::XlaOp not_found_inf =
+      xla::ConvertElementType(xla::Not(found_inf_cond), type);
+  xla::XlaOp new_step = step + not_found_inf;
+
+  xla::XlaOp bias_correction1 = one - xla::Pow(beta1, new_step);
+  xla::XlaOp bias_correction2 = one - xla::Pow(beta2, new_step);
+  xla::XlaOp new_exp_avg = exp_avg * beta1 + grad * (one - beta1);
+  xla::XlaOp new_exp_avg_sq = exp_avg_sq * beta2 + grad * grad * (one - beta2);
+  xla::XlaOp update = (new_exp_avg / bias_correction1) /
+                      (xla::Sqrt(new_exp_avg_sq / bias_correction2) + eps);
+  if (use_weight_decay) {
+    update = update + param * weight_decay;
+  }
+  // The trust ratio of the layer, which is one when either norm is zero.
+  xla::XlaOp param_norm = xla::Sqrt(SumOfSquares(param));
+  xla::XlaOp update_norm = xla::Sqrt(SumOfSquares(update));
+  xla::XlaOp trust_ratio = xla::Select(
+      xla::And(xla::Gt(param_norm, zero), xla::Gt(update_norm, zero)),
+      param_norm / update_norm, one);
+  xla::XlaOp new_param = param - lr * trust_ratio * update;
+
+  std::vector<xla::XlaOp> results;
+  results.push_back(new_step);
+  results.push_back(xla::Select(found_inf_cond, param, new_param));
+  results.push_back(xla::Select(found_inf_cond, exp_avg, new_exp_avg));
+  results.push_back(xla::Select(found_inf_cond, exp_avg_sq, new_exp_avg_sq));
+  return results;
+}
+
+bool IsAdafactorFactored(const xla::Shape& param_shape) {
+  return param_shape.dimensions_size() >= 2;
+}
+
+std::vector<xla::XlaOp> BuildAdafactorOptimizerStep(
+    const xla::XlaOp& found_inf, const xla::XlaOp& step,
+    const xla::XlaOp& param, const xla::XlaOp& grad, const xla::XlaOp& row_var,
+    const xla::XlaOp& col_var, const xla::XlaOp& lr,
+    const xla::XlaOp& beta2_decay, const xla::XlaOp& eps1,
+    const xla::XlaOp& eps2, const xla::XlaOp& d,
+    const xla::XlaOp& weight_decay, bool use_weight_decay) {
+  // XLA version of the Adafactor algorithm of torch.optim.Adafactor
+  // https://github.com/pytorch/pytorch/blob/main/torch/optim/_adafactor.py
+  const xla::Shape& shape = ShapeHelper::ShapeOfXlaOp(param);
+  xla::PrimitiveType type = shape.element_type();
+  xla::XlaOp one = xla::One(param.builder(), type);
+  xla::XlaOp zero = xla::Zero(param.builder(), type);
+  const int64_t rank = shape.dimensions_size();
+  const int64_t numel = xla::ShapeUtil::ElementsIn(shape);
+  xla::XlaOp sqrt_numel = XlaHelpers::ScalarValue<double>(
+      std::sqrt(static_cast<double>(numel)), type, param.builder());
+
+  xla::XlaOp found_inf_cond = xla::Ne(found_inf, zero);
+  xla::XlaOp not_found_inf =
+      xla::ConvertElementType(xla::Not(found_inf_cond), type);
+  xla::XlaOp new_step = step + not_found_inf;
+
+  xla::XlaOp one_minus_beta2 = xla::Pow(new_step, beta2_decay);
+  xla::XlaOp rho = xla::Min(lr, xla::Rsqrt(new_step));
+  xla::XlaOp alpha =
+      xla::Max(eps2, xla::Sqrt(SumOfSquares(param)) / sqrt_numel) * rho;
+  xla::XlaOp new_param = param;
+  if (use_weight_decay) {
+    new_param = param * (one - lr * weight_decay);
+  }
+
+  std::vector<xla::XlaOp> new_vars;
+  xla::XlaOp var_estimate;
+  if (IsAdafactorFactored(shape)) {
+    // The second moment is factored into the means of its rows, over the
+    // last dimension, and of its columns, over the one before.
+    const int64_t rows = shape.dimensions(rank - 2);
+    const int64_t cols = shape.dimensions(rank - 1);
+    xla::XlaOp row_mean =
+        SumOfSquares(grad, {rank - 1}) /
+        XlaHelpers::ScalarValue<double>(cols, type, param.builder());
+    xla::XlaOp col_mean =
+        SumOfSquares(grad, {rank - 2}) /
+        XlaHelpers::ScalarValue<double>(rows, type, param.builder());
+    xla::XlaOp new_row_var = row_var + (row_mean - row_var) * one_minus_beta2;
+    xla::XlaOp new_col_var = col_var + (col_mean - col_var) * one_minus_beta2;
+    xla::XlaOp row_var_mean =
+        xla::Reduce(new_row_var, zero, XlaHelpers::CreateAddComputation(type),
+                    {rank - 2}) /
+        XlaHelpers::ScalarValue<double>(rows, type, param.builder());
+
+    std::vector<int64_t> batch_dims(rank - 2);
+    std::iota(batch_dims.begin(), batch_dims.end(), 0);
+    std::vector<int64_t> row_dims = batch_dims;
+    row_dims.push_back(rank - 2);
+    std::vector<int64_t> col_dims = batch_dims;
+    col_dims.push_back(rank - 1);
+    var_estimate =
+        xla::BroadcastInDim(new_row_var, shape.dimensions(), row_dims) *
+        xla::BroadcastInDim(new_col_var, shape.dimensions(), col_dims) /
+        xla::BroadcastInDim(xla::Max(row_var_mean, eps1), shape.dimensions(),
+                            batch_dims);
+    new_vars.push_back(new_row_var);
+    new_vars.push_back(new_col_var);
+  } else {
+    xla::XlaOp new_variance =
+        row_var + (grad * grad - row_var) * one_minus_beta2;
+    var_estimate = new_variance;
+    new_vars.push_back(new_variance);
+  }
+  xla::XlaOp update = xla::Rsqrt(xla::Max(var_estimate, eps1 * eps1)) * grad;
+  xla::XlaOp denom =
+      xla::Max(one, xla::Sqrt(SumOfSquares(update)) / (sqrt_numel * d));
+  new_param = new_param - update * (alpha / denom);
+
+  std::vector<xla::XlaOp> results;
+  results.push_back(new_step);
+  results.push_back(xla::Select(found_inf_cond, param, new_param));
+  const xla::XlaOp vars[] = {row_var, col_var};
+  for (size_t i = 0; i < new_vars.size(); ++i) {
+    results.push_back(xla::Select(found_inf_cond, vars[i], new_vars[i]));
+  }
+  return results;
+}
+
 xla::XlaOp BuildXLogY(xla::XlaOp input, xla::XlaOp other) {
   // input and xla::Log(other) can have different types, need to promote
   // the multiply.
@@ -1276,6 +1883,63 @@ xla::XlaOp BuildMultinomial(xla::XlaOp input, int64_t num_samples,
   return output;
 }
 
+xla::XlaOp BuildSampleTokens(xla::XlaOp logits, xla::XlaOp temperature,
+                             xla::XlaOp top_p, xla::XlaOp seed, int64_t top_k) {
+  // Keeps the Gumbel noise finite.
+  static const float kEpsValue = 1e-6;
+  xla::XlaBuilder* builder = logits.builder();
+  xla::XlaOp input = xla::ConvertElementType(logits, xla::F32);
+  const xla::Shape shape = ShapeHelper::ShapeOfXlaOp(input);
+  int64_t dim = shape.dimensions_size() - 1;
+  int64_t vocab_size = shape.dimensions(dim);
+  temperature = xla::ConvertElementType(temperature, xla::F32);
+  top_p = xla::ConvertElementType(top_p, xla::F32);
+  xla::XlaOp neg_inf = xla::Broadcast(
+      xla::MinValue(builder, xla::F32), shape.dimensions());
+  xla::XlaOp pos_inf = xla::Broadcast(
+      xla::MaxValue(builder, xla::F32), shape.dimensions());
+  xla::XlaOp rank = xla::Iota(
+      builder, xla::ShapeUtil::MakeShape(xla::S32, shape.dimensions()), dim);
+
+  // The logits in decreasing order, without the ones past the top-k.
+  xla::XlaOp sorted = xla::Sort(
+      {input}, xla::CreateScalarGtComputation({xla::F32}, builder), dim,
+      /*is_stable=*/false);
+  if (top_k > 0 && top_k < vocab_size) {
+    sorted = xla::Select(
+        xla::Lt(rank, xla::ConstantR0<int32_t>(builder, top_k)), sorted,
+        neg_inf);
+  }
+  // The top-p keeps the most likely tokens while the probability of the more
+  // likely ones is below it, and always the most likely one.
+  xla::XlaOp safe_temperature = xla::Max(
+      temperature, XlaHelpers::ScalarValue<float>(kEpsValue, builder));
+  xla::XlaOp probs = BuildSoftmax(sorted / safe_temperature, dim);
+  xla::XlaOp preceding_probs =
+      BuildCumulativeComputation(
+          probs, dim, XlaHelpers::CreateAddComputation(xla::F32),
+          xla::Zero(builder, xla::F32)) -
+      probs;
+  xla::XlaOp keep = xla::Or(
+      xla::And(xla::Lt(preceding_probs, top_p), xla::Gt(sorted, neg_inf)),
+      xla::Eq(rank, xla::ConstantR0<int32_t>(builder, 0)));
+  xla::XlaOp threshold = xla::Reduce(
+      xla::Select(keep, sorted, pos_inf), xla::MaxValue(builder, xla::F32),
+      XlaHelpers::CreateMinComputation(xla::F32), {dim});
+  std::vector<int64_t> batch_dims(dim);
+  std::iota(batch_dims.begin(), batch_dims.end(), 0);
+  xla::XlaOp masked =
+      xla::Select(xla::Ge(input, threshold, batch_dims), input, neg_inf);
+
+  // argmax(logits / temperature + gumbel) samples the softmax of the logits
+  // at the temperature, and so does argmax(logits + temperature * gumbel).
+  xla::XlaOp rng = RngUniform(
+      seed, shape, XlaHelpers::ScalarValue<float>(kEpsValue, builder),
+      XlaHelpers::ScalarValue<float>(1.0 - kEpsValue, builder));
+  xla::XlaOp gumbel = xla::Neg(xla::Log(xla::Neg(xla::Log(rng))));
+  return BuildArgMax(masked + temperature * gumbel, dim, /*keepdim=*/false);
+}
+
 xla::XlaOp BuildCustomSharding(const xla::XlaOp& input, const std::string& type,
                                const xla::Shape& output_shape) {
   return xla::CustomCall(input.builder(), /*call_target_name=*/type, {input},
@@ -1573,4 +2237,239 @@ xla::XlaOp BuildNms(xla::XlaOp boxes, xla::XlaOp scores,
   return xla::SetDimensionSize(included_indices_first, included_boxes, 0);
 }
 
+std::vector<xla::XlaOp> BuildBatchedNms(xla::XlaOp boxes, xla::XlaOp scores,
+                                        xla::XlaOp classes,
+                                        xla::XlaOp iou_threshold,
+                                        xla::XlaOp score_threshold,
+                                        int64_t max_output_size) {
+  const xla::PrimitiveType XLAIndexType = xla::PrimitiveType::S32;
+  xla::XlaBuilder* builder = boxes.builder();
+
+  const xla::Shape& boxes_shape = ShapeHelper::ShapeOfXlaOp(boxes);
+  const xla::Shape& scores_shape = ShapeHelper::ShapeOfXlaOp(scores);
+  const xla::Shape& classes_shape = ShapeHelper::ShapeOfXlaOp(classes);
+  XLA_CHECK_EQ(boxes_shape.dimensions_size(), 3)
+      << "batched_nms(): boxes should be of shape [B, N, 4]";
+  XLA_CHECK_EQ(boxes_shape.dimensions(2), 4)
+      << "batched_nms(): boxes should be of shape [B, N, 4]";
+  const int64_t batch_size = boxes_shape.dimensions(0);
+  const int64_t num_boxes = boxes_shape.dimensions(1);
+  XLA_CHECK(scores_shape.dimensions_size() == 2 &&
+            scores_shape.dimensions(0) == batch_size &&
+            scores_shape.dimensions(1) == num_boxes)
+      << "batched_nms(): scores should be of shape [B, N]";
+  XLA_CHECK(xla::ShapeUtil::SameDimensions(scores_shape, classes_shape))
+      << "batched_nms(): classes should be of shape [B, N]";
+  XLA_CHECK_GE(max_output_size, 0);
+
+  // 1. Order the boxes of every image by decreasing score, with their
+  //    indices, classes and coordinates.
+  xla::Shape index_shape =
+      xla::ShapeUtil::MakeShape(XLAIndexType, {batch_size, num_boxes});
+  std::vector<xla::XlaOp> operands = {
+      scores, xla::Iota(builder, index_shape, 1), classes};
+  std::vector<xla::PrimitiveType> types = {scores_shape.element_type(),
+                                           XLAIndexType,
+                                           classes_shape.element_type()};
+  for (int64_t i = 0; i < 4; ++i) {
+    operands.push_back(xla::Reshape(
+        xla::SliceInDim(boxes, i, i + 1, 1, 2), {batch_size, num_boxes}));
+    types.push_back(boxes_shape.element_type());
+  }
+  xla::XlaOp sorted = xla::Sort(
+      operands, xla::CreateScalarGtComputation(types, builder),
+      /*dimension=*/1, /*is_stable=*/true);
+  xla::XlaOp sorted_scores = xla::GetTupleElement(sorted, 0);
+  xla::XlaOp sorted_indices = xla::GetTupleElement(sorted, 1);
+  xla::XlaOp sorted_classes = xla::GetTupleElement(sorted, 2);
+  xla::XlaOp x0 = xla::GetTupleElement(sorted, 3);
+  xla::XlaOp y0 = xla::GetTupleElement(sorted, 4);
+  xla::XlaOp x1 = xla::GetTupleElement(sorted, 5);
+  xla::XlaOp y1 = xla::GetTupleElement(sorted, 6);
+
+  // 2. The [B, N, N] mask of the boxes j ranked after a box i, of the same
+  //    class, whose IoU with it is above the threshold: those which box i
+  //    suppresses when it is kept.
+  std::vector<int64_t> pairs_dims = {batch_size, num_boxes, num_boxes};
+  auto rows = [&](xla::XlaOp op) {
+    return xla::BroadcastInDim(op, pairs_dims, {0, 1});
+  };
+  auto cols = [&](xla::XlaOp op) {
+    return xla::BroadcastInDim(op, pairs_dims, {0, 2});
+  };
+  xla::XlaOp area = (x1 - x0) * (y1 - y0);
+  xla::XlaOp width =
+      xla::Min(rows(x1), cols(x1)) - xla::Max(rows(x0), cols(x0));
+  xla::XlaOp height =
+      xla::Min(rows(y1), cols(y1)) - xla::Max(rows(y0), cols(y0));
+  xla::XlaOp zero = xla::Zero(builder, boxes_shape.element_type());
+  xla::XlaOp intersection = xla::Max(width, zero) * xla::Max(height, zero);
+  xla::XlaOp iou = intersection / (rows(area) + cols(area) - intersection);
+  xla::Shape pairs_shape = xla::ShapeUtil::MakeShape(XLAIndexType, pairs_dims);
+  xla::XlaOp suppression = xla::And(
+      xla::And(xla::Gt(iou, xla::ConvertElementType(
+                                iou_threshold, boxes_shape.element_type())),
+               xla::Eq(rows(sorted_classes), cols(sorted_classes))),
+      xla::Gt(xla::Iota(builder, pairs_shape, 2),
+              xla::Iota(builder, pairs_shape, 1)));
+
+  // 3. Visits the ranks in order, all images at once. The ranks before the
+  //    current one are final, and a kept box clears the boxes it suppresses.
+  xla::XlaOp keep = xla::Gt(
+      sorted_scores,
+      xla::ConvertElementType(score_threshold, scores_shape.element_type()));
+  XLA_ASSIGN_OR_THROW(
+      std::vector<xla::XlaOp> loop_result,
+      xla::WhileLoopHelper(
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            return xla::Lt(values[0], xla::ConstantR0<int32_t>(
+                                          builder, num_boxes));
+          },
+          [=](absl::Span<const xla::XlaOp> values, xla::XlaBuilder* builder) {
+            const xla::XlaOp ZERO = xla::Zero(builder, XLAIndexType);
+            xla::XlaOp rank = values[0];
+            xla::XlaOp state = values[1];
+            xla::XlaOp mask = values[2];
+            xla::XlaOp suppressed = xla::Reshape(
+                xla::DynamicSlice(mask, {ZERO, rank, ZERO},
+                                  {batch_size, 1, num_boxes}),
+                {batch_size, num_boxes});
+            xla::XlaOp kept = xla::BroadcastInDim(
+                xla::Reshape(xla::DynamicSlice(state, {ZERO, rank},
+                                               {batch_size, 1}),
+                             {batch_size}),
+                {batch_size, num_boxes}, {0});
+            return std::vector<xla::XlaOp>{
+                rank + xla::One(builder, XLAIndexType),
+                xla::And(state, xla::Not(xla::And(suppressed, kept))),
+                mask};
+          },
+          {xla::Zero(builder, XLAIndexType), keep, suppression},
+          "BatchedBoxSelectionLoop", builder));
+  keep = xla::ConvertElementType(loop_result[1], XLAIndexType);
+
+  // 4. Moves the indices of the kept boxes first, in rank order, and pads
+  //    them with -1 to max_output_size.
+  xla::XlaOp counts = xla::Min(
+      xla::Reduce(keep, xla::Zero(builder, XLAIndexType),
+                  xla::CreateScalarAddComputation(XLAIndexType, builder), {1}),
+      xla::ConstantR0<int32_t>(builder, max_output_size));
+  xla::XlaOp kept_indices = xla::GetTupleElement(
+      xla::Sort({keep, sorted_indices},
+                xla::CreateScalarGtComputation({XLAIndexType, XLAIndexType},
+                                               builder),
+                /*dimension=*/1, /*is_stable=*/true),
+      1);
+  if (num_boxes >= max_output_size) {
+    kept_indices = xla::SliceInDim(kept_indices, 0, max_output_size, 1, 1);
+  } else {
+    kept_indices = xla::PadInDim(kept_indices,
+                                 xla::ConstantR0<int32_t>(builder, -1), 1,
+                                 /*pad_lo=*/0,
+                                 /*pad_hi=*/max_output_size - num_boxes);
+  }
+  xla::XlaOp positions = xla::Iota(
+      builder, xla::ShapeUtil::MakeShape(XLAIndexType,
+                                         {batch_size, max_output_size}),
+      1);
+  kept_indices = xla::Select(
+      xla::Lt(positions, xla::BroadcastInDim(
+                             counts, {batch_size, max_output_size}, {0})),
+      kept_indices,
+      xla::Broadcast(xla::ConstantR0<int32_t>(builder, -1),
+                     {batch_size, max_output_size}));
+  return {kept_indices, counts};
+}
+
+std::vector<xla::XlaOp> BuildScan(const xla::XlaComputation& body,
+                                  absl::Span<const xla::XlaOp> operands,
+                                  int64_t num_carry, int64_t num_xs,
+                                  absl::Span<const int64_t> parameter_operands,
+                                  int64_t seed_operand, bool reverse) {
+  XLA_CHECK_GT(num_xs, 0);
+  xla::XlaBuilder* builder = operands.front().builder();
+  const int64_t num_operands = operands.size();
+  const int64_t num_iters =
+      ShapeHelper::ShapeOfXlaOp(operands[num_carry]).dimensions(0);
+  XLA_ASSIGN_OR_THROW(xla::ProgramShape body_shape, body.GetProgramShape());
+  const xla::Shape& result_shape = body_shape.result();
+  const int64_t num_ys = result_shape.tuple_shapes_size() - num_carry;
+
+  // The loop state is the iteration, the operands, then the stacked ys.
+  std::vector<xla::XlaOp> init_values;
+  init_values.push_back(xla::Zero(builder, xla::PrimitiveType::S64));
+  init_values.insert(init_values.end(), operands.begin(), operands.end());
+  for (int64_t i = 0; i < num_ys; ++i) {
+    const xla::Shape& y_shape = result_shape.tuple_shapes(num_carry + i);
+    std::vector<int64_t> sizes = {num_iters};
+    sizes.insert(sizes.end(), y_shape.dimensions().begin(),
+                 y_shape.dimensions().end());
+    init_values.push_back(
+        xla::Broadcast(xla::Zero(builder, y_shape.element_type()), sizes));
+  }
+
+  auto cond_fn = [&](absl::Span<const xla::XlaOp> values,
+                     xla::XlaBuilder* cond_builder) -> xla::XlaOp {
+    return xla::Lt(values[0],
+                   xla::ConstantR0<int64_t>(cond_builder, num_iters));
+  };
+  auto body_fn = [&](absl::Span<const xla::XlaOp> values,
+                     xla::XlaBuilder* body_builder)
+      -> absl::StatusOr<std::vector<xla::XlaOp>> {
+    xla::XlaOp zero = xla::Zero(body_builder, xla::PrimitiveType::S64);
+    xla::XlaOp iteration = values[0];
+    xla::XlaOp index =
+        reverse
+            ? xla::ConstantR0<int64_t>(body_builder, num_iters - 1) - iteration
+            : iteration;
+    auto slice = [&](xla::XlaOp op) {
+      const xla::Shape& shape = ShapeHelper::ShapeOfXlaOp(op);
+      std::vector<xla::XlaOp> starts(shape.dimensions().size(), zero);
+      starts[0] = index;
+      std::vector<int64_t> sizes(shape.dimensions().begin(),
+                                 shape.dimensions().end());
+      sizes[0] = 1;
+      return xla::Reshape(xla::DynamicSlice(op, starts, sizes),
+                          absl::MakeConstSpan(sizes).subspan(1));
+    };
+    std::vector<xla::XlaOp> args;
+    args.reserve(parameter_operands.size());
+    for (int64_t operand : parameter_operands) {
+      xla::XlaOp value = values[1 + operand];
+      bool per_iteration =
+          (operand >= num_carry && operand < num_carry + num_xs) ||
+          operand == seed_operand;
+      args.push_back(per_iteration ? slice(value) : value);
+    }
+    xla::XlaOp result = xla::Call(body_builder, body, args);
+
+    std::vector<xla::XlaOp> next(values.begin(), values.end());
+    next[0] = iteration + xla::One(body_builder, xla::PrimitiveType::S64);
+    for (int64_t i = 0; i < num_carry; ++i) {
+      next[1 + i] = xla::GetTupleElement(result, i);
+    }
+    for (int64_t i = 0; i < num_ys; ++i) {
+      xla::XlaOp& ys = next[1 + num_operands + i];
+      xla::XlaOp y = xla::GetTupleElement(result, num_carry + i);
+      const xla::Shape& y_shape = result_shape.tuple_shapes(num_carry + i);
+      std::vector<int64_t> sizes = {1};
+      sizes.insert(sizes.end(), y_shape.dimensions().begin(),
+                   y_shape.dimensions().end());
+      std::vector<xla::XlaOp> starts(sizes.size(), zero);
+      starts[0] = index;
+      ys = xla::DynamicUpdateSlice(ys, xla::Reshape(y, sizes), starts);
+    }
+    return next;
+  };
+  XLA_ASSIGN_OR_THROW(
+      std::vector<xla::XlaOp> results,
+      xla::WhileLoopHelper(cond_fn, body_fn, init_values, "Scan", builder));
+
+  std::vector<xla::XlaOp> outputs(results.begin() + 1,
+                                  results.begin() + 1 + num_carry);
+  outputs.insert(outputs.end(), results.begin() + 1 + num_operands,
+                 results.end());
+  return outputs;
+}
+
 }  // namespace torch_xla
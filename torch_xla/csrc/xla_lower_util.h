@@ -1,6 +1,7 @@
 #ifndef XLA_TORCH_XLA_CSRC_XLA_LOWER_UTIL_H_
 #define XLA_TORCH_XLA_CSRC_XLA_LOWER_UTIL_H_
 
+#include <utility>
 #include <vector>
 
 #include "absl/types/optional.h"
@@ -21,6 +22,15 @@ std::vector<xla::XlaOp> CreateKthValue(xla::XlaOp input, int64_t k, int64_t dim,
 std::vector<xla::XlaOp> CreateTopK(xla::XlaOp input, int64_t k, int64_t dim,
                                    bool largest, bool stable);
 
+// Like CreateTopK(), but the values found by the XLA ApproxTopK, which are
+// the top-k ones with a probability of at least `recall_target`. The
+// `custom_call` runs the partial reduction of the TPU, otherwise the sort of
+// the fallback is exact.
+std::vector<xla::XlaOp> CreateApproxTopK(xla::XlaOp input, int64_t k,
+                                         int64_t dim, bool largest,
+                                         float recall_target,
+                                         bool custom_call);
+
 xla::XlaOp CreateMatMul(xla::XlaOp lhs, xla::XlaOp rhs);
 
 xla::XlaOp BuildMatMul(xla::XlaOp lhs, xla::XlaOp rhs, xla::XlaOp bias);
@@ -30,6 +40,39 @@ xla::XlaOp BuildMatMulWithMultiplier(xla::XlaOp lhs, xla::XlaOp rhs,
                                      xla::XlaOp product_multiplier,
                                      xla::XlaOp bias_multiplier);
 
+// Multiplies the activations `x` [..., K] by the transposed quantized weight
+// `w`, of int8, int4 or fp8 elements, and applies the scales to the
+// accumulated products:
+//   - per channel, if `block_size` < 0, `w` is [N, K] and `scale` is [N];
+//   - blockwise, `w` is [K / block_size, block_size, N] and `scale` is
+//     [K / block_size, N].
+// A floating point `x` is multiplied by the weight in a mixed precision dot,
+// and an int8 `x` with its per row `x_scale` [...] (W8A8) is multiplied
+// natively, into int32. The optional `zero_point`, of the shape of `scale`, is
+// subtracted after the scaling, as the products of the sums of `x` with it.
+// Returns the [..., N] output of `output_type`.
+xla::XlaOp BuildQuantizedDot(xla::XlaOp x, xla::XlaOp w, xla::XlaOp scale,
+                             xla::XlaOp x_scale, xla::XlaOp zero_point,
+                             int64_t block_size,
+                             xla::PrimitiveType output_type);
+
+// Multiplies `lhs` [..., K] by the 2D `rhs`, contracted on its
+// `rhs_contracting_dim`, in FP8 with delayed scaling: each operand is
+// multiplied by its current scalar `scale`, saturated and cast to its FP8
+// type, and the F32 accumulated product is divided by the two scales. The
+// absolute maximum of each operand is pushed at the front of its 1D
+// `amax_history`, dropping the oldest one, and its next scale is the largest
+// finite value of its FP8 type over the maximum of the history, divided by
+// 2^`margin`, or its current scale while the history holds no finite
+// positive value. Returns the product of `output_type`, then the new scales
+// and histories of `lhs` and `rhs`.
+std::vector<xla::XlaOp> BuildFp8Dot(
+    xla::XlaOp lhs, xla::XlaOp rhs, xla::XlaOp lhs_scale, xla::XlaOp rhs_scale,
+    xla::XlaOp lhs_amax_history, xla::XlaOp rhs_amax_history,
+    xla::PrimitiveType lhs_type, xla::PrimitiveType rhs_type,
+    int64_t rhs_contracting_dim, int64_t margin,
+    xla::PrimitiveType output_type);
+
 xla::XlaOp BuildCountNonzero(xla::XlaOp input, std::vector<int64_t> dim);
 
 xla::XlaOp BuildDot(xla::XlaOp lhs, xla::XlaOp rhs);
@@ -40,6 +83,16 @@ xla::XlaOp BuildBernoulli(xla::XlaOp probability, xla::XlaOp seed,
 xla::XlaOp BuildMultinomial(xla::XlaOp input, int64_t num_samples,
                             bool replacement, xla::XlaOp seed);
 
+// Samples a token id from each row of the last dimension of `logits`, among
+// the `top_k` most likely ones, zero not bounding them, and the smallest set
+// of most likely ones whose probability reaches `top_p`, at `temperature`.
+// The sampling is a Gumbel-max over the remaining logits, so it needs neither
+// the normalized probabilities nor their cumulative sum, and a zero
+// `temperature` picks the most likely token. The ties of the top-k and top-p
+// boundaries are kept.
+xla::XlaOp BuildSampleTokens(xla::XlaOp logits, xla::XlaOp temperature,
+                             xla::XlaOp top_p, xla::XlaOp seed, int64_t top_k);
+
 xla::XlaOp BuildExponential(xla::XlaOp lambda, xla::XlaOp seed,
                             xla::PrimitiveType type);
 
@@ -49,6 +102,11 @@ std::vector<xla::XlaOp> BuildNativeDropout(xla::XlaOp input, xla::XlaOp seed,
                                            float probability,
                                            std::optional<bool> train);
 
+// Regenerates, as PRED, the keep mask which BuildNativeDropout() draws from
+// `seed` in training, for an input of `input_shape`.
+xla::XlaOp BuildDropoutMask(xla::XlaOp seed, const xla::Shape& input_shape,
+                            float probability);
+
 xla::XlaOp BuildSigmoidBackward(xla::XlaOp grad_output, xla::XlaOp output,
                                 xla::XlaOp scalar_1);
 
@@ -99,12 +157,46 @@ xla::XlaOp CreateScatter(const torch::lazy::BackendDevice& device,
 xla::XlaOp CreatePut(const torch::lazy::BackendDevice& device, xla::XlaOp input,
                      xla::XlaOp index, xla::XlaOp source, bool accumulate);
 
+// Whether the accumulating index_put() and scatter_add() of a `shape` buffer
+// are lowered to CreateSortedIndexAdd() and CreateSortedScatterAdd(), per
+// $XLA_SORTED_SCATTER_ADD.
+bool UseSortedScatterAdd(const xla::Shape& shape);
+
+// Like CreateIndexUpdate() with an add combiner and a start_dim of 0, for
+// `indices` whose minor dimension is 1, but sums the `values` of the same
+// index before scattering them. The sums do not depend on the order the device
+// scatters in, and the scatter has no colliding indices, which is faster for
+// the many collisions of an embedding backward.
+xla::XlaOp CreateSortedIndexAdd(xla::XlaOp buffer, xla::XlaOp indices,
+                                xla::XlaOp values);
+
+// Sums the rows of the [N, W] `values` of the same of the S64 [N] `keys`, in an
+// order which does not depend on the device. Returns N keys and the N rows of
+// their sums: the unique keys in [0, bound), in increasing order, then `bound`
+// with rows of zeros for the rest.
+std::pair<xla::XlaOp, xla::XlaOp> CreateUniqueSegmentSums(xla::XlaOp keys,
+                                                          xla::XlaOp values,
+                                                          int64_t bound);
+
+// Like CreateScatter() with a NumericAddCombiner(), but sums the `source`
+// elements of the same position before scattering them, as
+// CreateSortedIndexAdd() does.
+xla::XlaOp CreateSortedScatterAdd(xla::XlaOp input, xla::XlaOp index,
+                                  xla::XlaOp source, int64_t dim);
+
 xla::XlaOp BuildLinspace(const torch::lazy::BackendDevice& device,
                          xla::XlaOp start, xla::XlaOp end, int64_t steps);
 
-std::vector<xla::XlaOp> BuildNonZero(xla::XlaOp input);
+// Returns the indices of the non zero elements of `input` and their count.
+// Unless `bounded`, the indices have a dynamic number of rows. Otherwise they
+// have a row per element of `input`, and the rows past the count are zero.
+std::vector<xla::XlaOp> BuildNonZero(xla::XlaOp input, bool bounded = false);
 
-std::vector<xla::XlaOp> BuildMaskedSelect(xla::XlaOp input, xla::XlaOp mask);
+// Returns the elements of `input` selected by `mask`, and their count. Unless
+// `bounded`, the elements have a dynamic size. Otherwise they have the size of
+// `input`, and the elements past the count are zero.
+std::vector<xla::XlaOp> BuildMaskedSelect(xla::XlaOp input, xla::XlaOp mask,
+                                          bool bounded = false);
 
 xla::XlaOp BuildMaskedScatter(xla::XlaOp input, xla::XlaOp mask,
                               xla::XlaOp source);
@@ -135,6 +227,43 @@ std::vector<xla::XlaOp> BuildAdamOptimizerStep(
     const xla::XlaOp& weight_decay, const xla::XlaOp& eps,
     bool use_weight_decay, bool use_amsgrad, bool use_adamw);
 
+// Updates every parameter as BuildAdamOptimizerStep() does, with the same
+// hyper parameters. Returns the results of the parameters one after the other.
+std::vector<xla::XlaOp> BuildMultiTensorAdamOptimizerStep(
+    const xla::XlaOp& found_inf, absl::Span<const xla::XlaOp> steps,
+    absl::Span<const xla::XlaOp> params, absl::Span<const xla::XlaOp> grads,
+    absl::Span<const xla::XlaOp> exp_avgs,
+    absl::Span<const xla::XlaOp> exp_avg_sqs,
+    absl::Span<const xla::XlaOp> max_exp_avg_sqs, const xla::XlaOp& beta1,
+    const xla::XlaOp& beta2, const xla::XlaOp& lr,
+    const xla::XlaOp& weight_decay, const xla::XlaOp& eps,
+    bool use_weight_decay, bool use_amsgrad, bool use_adamw);
+
+// The LAMB step of one parameter, for the LambOptimizerStep node. Returns the
+// new step, parameter, exp_avg and exp_avg_sq.
+std::vector<xla::XlaOp> BuildLambOptimizerStep(
+    const xla::XlaOp& found_inf, const xla::XlaOp& step,
+    const xla::XlaOp& param, const xla::XlaOp& grad, const xla::XlaOp& exp_avg,
+    const xla::XlaOp& exp_avg_sq, const xla::XlaOp& beta1,
+    const xla::XlaOp& beta2, const xla::XlaOp& lr,
+    const xla::XlaOp& weight_decay, const xla::XlaOp& eps,
+    bool use_weight_decay);
+
+// Whether Adafactor factors the second moment of a parameter of the shape,
+// into a row and a column variance, rather than keeping a full variance.
+bool IsAdafactorFactored(const xla::Shape& param_shape);
+
+// The Adafactor step of one parameter, for the AdafactorOptimizerStep node.
+// Returns the new step, parameter, and row and column variances, or only the
+// variance, passed as `row_var`, when the parameter is not factored.
+std::vector<xla::XlaOp> BuildAdafactorOptimizerStep(
+    const xla::XlaOp& found_inf, const xla::XlaOp& step,
+    const xla::XlaOp& param, const xla::XlaOp& grad, const xla::XlaOp& row_var,
+    const xla::XlaOp& col_var, const xla::XlaOp& lr,
+    const xla::XlaOp& beta2_decay, const xla::XlaOp& eps1,
+    const xla::XlaOp& eps2, const xla::XlaOp& d,
+    const xla::XlaOp& weight_decay, bool use_weight_decay);
+
 xla::XlaOp BuildXLogY(xla::XlaOp input, xla::XlaOp other);
 
 xla::XlaOp BuildRoll(xla::XlaOp input, absl::Span<const int64_t> shifts,
@@ -163,6 +292,28 @@ std::vector<xla::XlaOp> BuildTpuCustomCall(
 xla::XlaOp BuildNms(xla::XlaOp boxes, xla::XlaOp scores,
                     xla::XlaOp iou_threshold);
 
+// Runs the NMS of every [N, 4] box set of `boxes` [B, N, 4], with the `scores`
+// and the `classes` [B, N], in a single computation. A box only suppresses the
+// boxes of its own class, and the boxes whose score is not above
+// `score_threshold` are dropped. Returns the S32 indices of the kept boxes of
+// every image, by decreasing score, in a [B, max_output_size] tensor padded
+// with -1, and the [B] numbers of valid indices.
+std::vector<xla::XlaOp> BuildBatchedNms(xla::XlaOp boxes, xla::XlaOp scores,
+                                        xla::XlaOp classes,
+                                        xla::XlaOp iou_threshold,
+                                        xla::XlaOp score_threshold,
+                                        int64_t max_output_size);
+
+// Lowers the Scan node: runs `body` in an XLA While, over the leading
+// dimension of the `num_xs` operands after the `num_carry` carries, and
+// returns the last carries followed by the stacked ys. See ops/scan.h for the
+// other arguments.
+std::vector<xla::XlaOp> BuildScan(const xla::XlaComputation& body,
+                                  absl::Span<const xla::XlaOp> operands,
+                                  int64_t num_carry, int64_t num_xs,
+                                  absl::Span<const int64_t> parameter_operands,
+                                  int64_t seed_operand, bool reverse);
+
 }  // namespace torch_xla
 
 #endif  // XLA_TORCH_XLA_CSRC_XLA_LOWER_UTIL_H_
@@ -53,8 +53,13 @@ TORCH_LIBRARY_IMPL(torchvision, XLA, m) {
 
 // Register generated XLANativeFunctions::einsum as aten::einsum for XLA key.
 // This utilizes the implementation from `xla/torch_xla/csrc/aten_xla_type.cpp`.
+// So are XLANativeFunctions::scaled_dot_product_attention and
+// XLANativeFunctions::rms_norm.
 TORCH_LIBRARY_IMPL(aten, XLA, m) {
   m.impl("aten::einsum", TORCH_FN(XLANativeFunctions::einsum));
+  m.impl("aten::scaled_dot_product_attention",
+         TORCH_FN(XLANativeFunctions::scaled_dot_product_attention));
+  m.impl("aten::rms_norm", TORCH_FN(XLANativeFunctions::rms_norm));
 }
 
 }  // namespace manual
@@ -2,6 +2,9 @@
 
 #include <map>
 
+#include <torch/csrc/autograd/python_variable.h>
+
+#include "absl/strings/str_cat.h"
 #include "absl/types/optional.h"
 #include "xla/hlo/builder/lib/logdet.h"
 #include "xla/hlo/builder/lib/math.h"
@@ -841,6 +844,33 @@ const XlaOpFunctionMap* GetXlaOpFunctionMap() {
   return fn_map;
 }
 
+// Hashes an op argument. Ops and computations hash as their signature and
+// fingerprint, tensors as their content, and the other values as their type
+// and representation.
+torch::lazy::hash_t HashArg(py::handle value) {
+  if (py::isinstance<Op>(value)) {
+    return value.cast<OpPtr>()->signature;
+  }
+  if (py::isinstance<runtime::ComputationClient::Computation>(value)) {
+    return value.cast<runtime::ComputationClient::ComputationPtr>()->hash();
+  }
+  if (THPVariable_Check(value.ptr())) {
+    at::Tensor tensor = value.cast<at::Tensor>();
+    return torch::lazy::MHash(tensor.sizes().vec(),
+                              static_cast<int>(tensor.scalar_type()),
+                              TensorHash(tensor));
+  }
+  if (py::isinstance<py::tuple>(value) || py::isinstance<py::list>(value)) {
+    torch::lazy::hash_t hash = torch::lazy::Hash(py::len(value));
+    for (py::handle item : value) {
+      hash = torch::lazy::HashCombine(hash, HashArg(item));
+    }
+    return hash;
+  }
+  return torch::lazy::MHash(std::string(py::str(value.get_type())),
+                            std::string(py::repr(value)));
+}
+
 }  // namespace
 
 py::object ShapeToPyShape(const xla::Shape& shape) {
@@ -884,6 +914,17 @@ xla::Shape PyShapeToShape(py::object shape) {
   return xla::ShapeUtil::MakeShape(xla_type, dimensions);
 }
 
+OpPtr CreateParameter(BuilderPtr builder, int64_t param_no,
+                      const xla::Shape& shape) {
+  xla::XlaOp param = xla::Parameter(builder.get(), param_no, shape,
+                                    absl::StrCat("p", param_no));
+  builder->AddToSignature(
+      torch::lazy::MHash("Parameter", param_no, shape.ToString(true)));
+  torch::lazy::hash_t signature = builder->signature();
+  return std::make_shared<Op>(std::move(builder), std::move(param),
+                              std::move(signature));
+}
+
 OpPtr CreateOp(BuilderPtr builder, const std::string& opname,
                const std::vector<OpPtr>& operands, py::dict args) {
   const XlaOpFunctionMap* fn_map = GetXlaOpFunctionMap();
@@ -892,7 +933,22 @@ OpPtr CreateOp(BuilderPtr builder, const std::string& opname,
     XLA_ERROR() << "Unknown XLA op name: " << opname;
   }
   xla::XlaOp result = (*it->second)(builder, operands, args);
-  return std::make_shared<Op>(std::move(builder), std::move(result));
+  torch::lazy::hash_t hash = torch::lazy::Hash(opname);
+  for (const OpPtr& operand : operands) {
+    hash = torch::lazy::HashCombine(hash, operand->signature);
+  }
+  for (const auto& [name, value] : args) {
+    std::string arg_name = py::str(name);
+    // The Python wrappers pass along the builder of leaf ops.
+    if (arg_name != "builder") {
+      hash = torch::lazy::HashCombine(
+          hash, torch::lazy::MHash(arg_name, HashArg(value)));
+    }
+  }
+  builder->AddToSignature(hash);
+  torch::lazy::hash_t signature = builder->signature();
+  return std::make_shared<Op>(std::move(builder), std::move(result),
+                              std::move(signature));
 }
 
 }  // namespace op_builder
@@ -6,20 +6,43 @@
 #include <vector>
 
 #include <torch/csrc/jit/python/pybind.h>
+#include <torch/csrc/lazy/core/hash.h>
 
 #include "xla/hlo/builder/xla_builder.h"
 
 namespace torch_xla {
 namespace op_builder {
 
-using BuilderPtr = std::shared_ptr<xla::XlaBuilder>;
+// An XlaBuilder which also hashes the sequence of the ops created in it, with
+// their operands and arguments, so that the computations built from the same
+// sequence can be shared.
+class Builder : public xla::XlaBuilder {
+ public:
+  explicit Builder(const std::string& name)
+      : xla::XlaBuilder(name), signature_(torch::lazy::Hash(name)) {}
+
+  const torch::lazy::hash_t& signature() const { return signature_; }
+
+  void AddToSignature(const torch::lazy::hash_t& hash) {
+    signature_ = torch::lazy::HashCombine(signature_, hash);
+  }
+
+ private:
+  torch::lazy::hash_t signature_;
+};
+
+using BuilderPtr = std::shared_ptr<Builder>;
 
 struct Op {
-  Op(BuilderPtr builder, xla::XlaOp op)
-      : builder(std::move(builder)), op(std::move(op)) {}
+  Op(BuilderPtr builder, xla::XlaOp op, torch::lazy::hash_t signature)
+      : builder(std::move(builder)),
+        op(std::move(op)),
+        signature(std::move(signature)) {}
 
   BuilderPtr builder;
   xla::XlaOp op;
+  // The signature of the builder once the op was created in it.
+  torch::lazy::hash_t signature;
 };
 
 using OpPtr = std::shared_ptr<Op>;
@@ -28,6 +51,9 @@ py::object ShapeToPyShape(const xla::Shape& shape);
 
 xla::Shape PyShapeToShape(py::object shape);
 
+OpPtr CreateParameter(BuilderPtr builder, int64_t param_no,
+                      const xla::Shape& shape);
+
 OpPtr CreateOp(BuilderPtr builder, const std::string& opname,
                const std::vector<OpPtr>& operands, py::dict args);
 
@@ -1,11 +1,18 @@
 #include "torch_xla/csrc/xla_sharding_util.h"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <mutex>
+#include <set>
 #include <unordered_map>
 
+#include <ATen/Parallel.h>
 #include <ATen/TensorIndexing.h>
+#include <torch/csrc/lazy/core/hash.h>
 #include <torch/csrc/lazy/core/ir_util.h>
 
+#include "absl/strings/str_split.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "tsl/profiler/lib/traceme.h"
 #include "xla/execution_options_util.h"
@@ -25,6 +32,7 @@
 #include "torch_xla/csrc/dtype.h"
 #include "torch_xla/csrc/helpers.h"
 #include "torch_xla/csrc/ops/device_data.h"
+#include "torch_xla/csrc/runtime/cache.h"
 #include "torch_xla/csrc/runtime/computation_client.h"
 #include "torch_xla/csrc/runtime/runtime.h"
 #include "torch_xla/csrc/tensor.h"
@@ -167,24 +175,177 @@ std::vector<int64_t> ParseStringToIntVector(const std::string& str) {
   return result;
 }
 
+// Extracts the input shardings generated by the auto-sharding pass.
+std::vector<xla::OpSharding> GetModuleInputShardings(
+    const xla::HloModuleProto& module) {
+  std::vector<xla::OpSharding> input_shardings;
+  if (module.spmd_parameters_shardings().size() == 1 &&
+      module.spmd_parameters_shardings()[0].type() == xla::OpSharding::TUPLE) {
+    auto tuple_shardings =
+        module.spmd_parameters_shardings()[0].tuple_shardings();
+    input_shardings = std::vector<xla::OpSharding>(tuple_shardings.begin(),
+                                                   tuple_shardings.end());
+  } else {
+    for (auto sharding : module.spmd_parameters_shardings()) {
+      input_shardings.push_back(sharding);
+    }
+  }
+  return input_shardings;
+}
+
+// Holds the serialized auto-sharding plans by graph hash, backed by the
+// directory of XLA_AUTO_SPMD_PLAN_CACHE_PATH when set.
+class AutoShardingPlanStore {
+ public:
+  static AutoShardingPlanStore* Get() {
+    static AutoShardingPlanStore* store = new AutoShardingPlanStore();
+    return store;
+  }
+
+  std::optional<std::string> Read(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = plans_.find(name);
+    if (it != plans_.end()) {
+      return it->second;
+    }
+    if (storage_ == nullptr) {
+      return std::nullopt;
+    }
+    std::optional<std::string> data = storage_->Read(name);
+    if (data) {
+      plans_.emplace(name, *data);
+    }
+    return data;
+  }
+
+  void Write(const std::string& name, std::string data) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (storage_ != nullptr) {
+      storage_->Write(name, data, /*cost=*/0.0);
+    }
+    plans_[name] = std::move(data);
+  }
+
+ private:
+  AutoShardingPlanStore() {
+    std::string path =
+        runtime::sys_util::GetEnvString("XLA_AUTO_SPMD_PLAN_CACHE_PATH", "");
+    if (!path.empty()) {
+      storage_ = std::make_unique<runtime::util::DiskCacheStorage>(
+          path, /*readonly=*/false);
+    }
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::string> plans_;
+  std::unique_ptr<runtime::util::DiskCacheStorage> storage_;
+};
+
+template <typename T>
+bool EqualFields(const google::protobuf::RepeatedField<T>& a,
+                 const google::protobuf::RepeatedField<T>& b) {
+  return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+// The canonical copies of the OpShardings in use, bucketed by their hash.
+class OpShardingTable {
+ public:
+  std::shared_ptr<const xla::OpSharding> Intern(
+      const xla::OpSharding& sharding) {
+    torch::lazy::hash_t hash = ShardingUtil::HashOpSharding(sharding);
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& bucket = table_[hash];
+    for (const auto& interned : bucket) {
+      if (ShardingUtil::EqualOpShardings(*interned, sharding)) {
+        return interned;
+      }
+    }
+    TORCH_LAZY_COUNTER("InternedOpShardings", 1);
+    bucket.push_back(std::make_shared<const xla::OpSharding>(sharding));
+    return bucket.back();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::unordered_map<torch::lazy::hash_t,
+                     std::vector<std::shared_ptr<const xla::OpSharding>>,
+                     torch::lazy::HashReducer>
+      table_;
+};
+
+using ShardReplicaAndIndices =
+    std::vector<std::pair<int, std::vector<at::indexing::TensorIndex>>>;
+
+struct ShardIndicesKey {
+  std::vector<int64_t> shard_shape;
+  std::vector<int64_t> tensor_shape;
+  // Interned, so compared by address.
+  std::shared_ptr<const xla::OpSharding> sharding;
+  std::vector<std::string> devices;
+
+  bool operator==(const ShardIndicesKey& other) const {
+    return sharding == other.sharding && shard_shape == other.shard_shape &&
+           tensor_shape == other.tensor_shape && devices == other.devices;
+  }
+};
+
+struct ShardIndicesKeyHasher {
+  size_t operator()(const ShardIndicesKey& key) const {
+    torch::lazy::hash_t hash =
+        torch::lazy::HashCombine(ShardingUtil::HashOpSharding(*key.sharding),
+                                 torch::lazy::MHash(key.shard_shape,
+                                                    key.tensor_shape));
+    for (const std::string& device : key.devices) {
+      hash = torch::lazy::HashCombine(hash, torch::lazy::Hash(device));
+    }
+    return torch::lazy::HashReduce(hash);
+  }
+};
+
+runtime::util::Cache<ShardIndicesKey, ShardReplicaAndIndices,
+                     ShardIndicesKeyHasher>*
+GetShardIndicesCache() {
+  // Holds the indices of the shards of the tensors loaded with the few
+  // shardings of a program, for their few shapes.
+  static auto* cache =
+      new runtime::util::Cache<ShardIndicesKey, ShardReplicaAndIndices,
+                               ShardIndicesKeyHasher>(1024);
+  return cache;
+}
+
+// Writes `shard` at the origin of `dest`, of the padded shard shape, and zeroes
+// only the padding past it, rather than the whole of `dest` beforehand.
+void CopyIntoPaddedShard(const at::Tensor& shard, at::Tensor& dest) {
+  at::Tensor region = dest;
+  for (int64_t j = 0; j < shard.dim(); ++j) {
+    int64_t size = shard.size(j);
+    if (size < dest.size(j)) {
+      TORCH_LAZY_COUNTER("PaddedShardDims", 1);
+      dest.narrow(j, size, dest.size(j) - size).zero_();
+    }
+    region = region.narrow(j, 0, size);
+  }
+  region.copy_(shard);
+}
+
 }  // namespace
 
 bool ShardingUtil::SetHloSharding(LoweringContext* lowering_ctx) {
-  bool is_sharded = false;
-  for (std::pair<torch::lazy::Output, xla::XlaOp> elem :
-       lowering_ctx->GetEmittedOutputs()) {
-    const torch::lazy::Node* node = elem.first.node;
-    const XlaNode* xla_node = dynamic_cast<const XlaNode*>(node);
+  // Only the outputs of annotated nodes are visited, as the lowering context
+  // tracks them when they are emitted.
+  const torch::lazy::OutputMap<xla::XlaOp>& sharded_outputs =
+      lowering_ctx->GetShardedOutputs();
+  if (sharded_outputs.empty()) {
+    return false;
+  }
+  for (const auto& [output, op] : sharded_outputs) {
+    const XlaNode* xla_node = dynamic_cast<const XlaNode*>(output.node);
     xla::HloInstructionProto* instruction =
-        XlaBuilderFriend::GetInstruction(elem.second);
-    const std::shared_ptr<xla::OpSharding> sharding =
-        xla_node->GetSharding(elem.first.index);
-    if (sharding != nullptr && sharding->type() != xla::OpSharding::UNKNOWN) {
-      *instruction->mutable_sharding() = *sharding;
-      is_sharded = true;
-    }
+        XlaBuilderFriend::GetInstruction(op);
+    *instruction->mutable_sharding() = *xla_node->GetSharding(output.index);
   }
-  return is_sharded;
+  TORCH_LAZY_COUNTER("HloShardingAnnotations", sharded_outputs.size());
+  return true;
 }
 
 ShardingUtil::ShardingType ShardingUtil::GetShardingType(
@@ -211,12 +372,68 @@ ShardingUtil::ShardingType ShardingUtil::GetShardingType(
 
 bool ShardingUtil::EqualShardingSpecs(const XLATensor::ShardingSpec& a,
                                       const XLATensor::ShardingSpec& b) {
-  return xla::protobuf_util::HaveSameSerialization(a.sharding, b.sharding);
+  return EqualOpShardings(a.sharding, b.sharding);
 }
 
 bool ShardingUtil::EqualOpShardings(const xla::OpSharding& a,
                                     const xla::OpSharding& b) {
-  return xla::protobuf_util::HaveSameSerialization(a, b);
+  if (&a == &b) {
+    return true;
+  }
+  // The fields describing the placement are compared directly, rather than
+  // serializing both protos.
+  if (a.type() != b.type() ||
+      a.replicate_on_last_tile_dim() != b.replicate_on_last_tile_dim() ||
+      !EqualFields(a.tile_assignment_dimensions(),
+                   b.tile_assignment_dimensions()) ||
+      !EqualFields(a.tile_assignment_devices(), b.tile_assignment_devices()) ||
+      !EqualFields(a.last_tile_dims(), b.last_tile_dims()) ||
+      !EqualFields(a.iota_reshape_dims(), b.iota_reshape_dims()) ||
+      !EqualFields(a.iota_transpose_perm(), b.iota_transpose_perm()) ||
+      a.tuple_shardings_size() != b.tuple_shardings_size()) {
+    return false;
+  }
+  for (int i = 0; i < a.tuple_shardings_size(); ++i) {
+    if (!EqualOpShardings(a.tuple_shardings(i), b.tuple_shardings(i))) {
+      return false;
+    }
+  }
+  // The metadata and the tile shape are seldom set.
+  if (a.metadata_size() > 0 || b.metadata_size() > 0 || a.has_tile_shape() ||
+      b.has_tile_shape()) {
+    return xla::protobuf_util::HaveSameSerialization(a, b);
+  }
+  return true;
+}
+
+torch::lazy::hash_t ShardingUtil::HashOpSharding(
+    const xla::OpSharding& sharding) {
+  torch::lazy::hash_t hash = torch::lazy::MHash(
+      static_cast<int32_t>(sharding.type()),
+      sharding.replicate_on_last_tile_dim());
+  auto hash_field = [&](const auto& field) {
+    for (const auto& value : field) {
+      hash = torch::lazy::HashCombine(hash, static_cast<uint64_t>(value));
+    }
+    // Keeps the values of consecutive fields apart.
+    hash = torch::lazy::HashCombine(
+        hash, static_cast<uint64_t>(field.size()));
+  };
+  hash_field(sharding.tile_assignment_dimensions());
+  hash_field(sharding.tile_assignment_devices());
+  hash_field(sharding.last_tile_dims());
+  hash_field(sharding.iota_reshape_dims());
+  hash_field(sharding.iota_transpose_perm());
+  for (const xla::OpSharding& tuple_sharding : sharding.tuple_shardings()) {
+    hash = torch::lazy::HashCombine(hash, HashOpSharding(tuple_sharding));
+  }
+  return hash;
+}
+
+std::shared_ptr<const xla::OpSharding> ShardingUtil::InternOpSharding(
+    const xla::OpSharding& sharding) {
+  static OpShardingTable* table = new OpShardingTable();
+  return table->Intern(sharding);
 }
 
 xla::OpSharding ShardingUtil::CreateIotaOpSharding(
@@ -361,6 +578,15 @@ ShardingUtil::GetShardReplicaAndIndicesForDevices(
     const std::vector<std::string>& devices) {
   using namespace at::indexing;
 
+  ShardIndicesKey key{shard_shape, tensor_shape, InternOpSharding(sharding),
+                      devices};
+  std::shared_ptr<ShardReplicaAndIndices> cached =
+      GetShardIndicesCache()->Get(key);
+  if (cached != nullptr) {
+    TORCH_LAZY_COUNTER("ShardIndicesCacheHit", 1);
+    return *cached;
+  }
+
   // `shard_indices[dev][dim]` represents the index slice for dimension `dim`
   // that belongs on device `devices[dev]` if the tensor is sharded. If
   // `sharding` is REPLICATED, `shard_indices[dev]` will only have a single
@@ -436,9 +662,75 @@ ShardingUtil::GetShardReplicaAndIndicesForDevices(
   } else {
     XLA_CHECK(false) << "Unsupported OpSharding type " << sharding.type();
   }
+  GetShardIndicesCache()->Add(
+      std::move(key), std::make_shared<ShardReplicaAndIndices>(shard_indices));
   return shard_indices;
 }
 
+std::vector<ShardingUtil::ShardOverlap> ShardingUtil::GetShardOverlaps(
+    const std::vector<int64_t>& shard_shape,
+    const std::vector<int64_t>& tensor_shape, const xla::OpSharding& sharding,
+    const std::vector<std::string>& devices,
+    const std::vector<int64_t>& region_starts,
+    const std::vector<int64_t>& region_stops) {
+  XLA_CHECK_EQ(region_starts.size(), tensor_shape.size());
+  XLA_CHECK_EQ(region_stops.size(), tensor_shape.size());
+  int64_t region_elements = 1;
+  for (size_t d = 0; d < tensor_shape.size(); ++d) {
+    XLA_CHECK(0 <= region_starts[d] && region_starts[d] <= region_stops[d] &&
+              region_stops[d] <= tensor_shape[d])
+        << "Invalid range [" << region_starts[d] << ", " << region_stops[d]
+        << ") along dimension " << d << " of size " << tensor_shape[d];
+    region_elements *= region_stops[d] - region_starts[d];
+  }
+
+  auto replica_and_indices = GetShardReplicaAndIndicesForDevices(
+      shard_shape, tensor_shape, sharding, devices);
+  std::vector<ShardOverlap> overlaps;
+  if (region_elements == 0) {
+    return overlaps;
+  }
+  std::set<std::vector<int64_t>> seen_shard_starts;
+  int64_t overlap_elements = 0;
+  for (size_t i = 0; i < replica_and_indices.size(); ++i) {
+    const std::vector<at::indexing::TensorIndex>& indices =
+        replica_and_indices[i].second;
+    if (indices.empty()) {
+      continue;
+    }
+    bool replicated = indices[0].is_ellipsis();
+    std::vector<int64_t> shard_starts(tensor_shape.size(), 0);
+    ShardOverlap overlap{static_cast<int64_t>(i), {}, {}, {}};
+    int64_t elements = 1;
+    for (size_t d = 0; d < tensor_shape.size(); ++d) {
+      int64_t start = 0;
+      int64_t stop = tensor_shape[d];
+      if (!replicated) {
+        start = indices[d].slice().start().expect_int();
+        stop = indices[d].slice().stop().expect_int();
+      }
+      shard_starts[d] = start;
+      int64_t lo = std::max(start, region_starts[d]);
+      int64_t hi = std::min(stop, region_stops[d]);
+      elements *= std::max<int64_t>(hi - lo, 0);
+      overlap.shard_offsets.push_back(lo - start);
+      overlap.region_offsets.push_back(lo - region_starts[d]);
+      overlap.sizes.push_back(hi - lo);
+    }
+    if (elements == 0 || !seen_shard_starts.insert(shard_starts).second) {
+      continue;
+    }
+    overlap_elements += elements;
+    overlaps.push_back(std::move(overlap));
+    if (replicated) {
+      break;
+    }
+  }
+  XLA_CHECK_EQ(overlap_elements, region_elements)
+      << "The region is not covered by the shards on the given devices";
+  return overlaps;
+}
+
 std::vector<at::Tensor> ShardingUtil::ShardTensor(
     const at::Tensor& tensor, const XLATensor::ShardingSpecPtr shardings,
     const std::vector<std::string>& devices, bool padded) {
@@ -476,21 +768,16 @@ std::vector<at::Tensor> ShardingUtil::ShardTensor(
     for (size_t i = 0; i < shard_indices.size(); i++) {
       at::Tensor shard = tensor.index(
           c10::ArrayRef<at::indexing::TensorIndex>(shard_indices[i]));
-      shards[i] = shard.contiguous(at::MemoryFormat::Contiguous);
-    }
-    // Zero-pad to the right to ensure the sizes are even
-    if (shards.size() > 0 && padded) {
-      for (size_t i = 0; i < shards.size(); ++i) {
-        std::vector<long> pads;
+      // Zero-pad to the right to ensure the sizes are even, writing the
+      // uneven shards straight into their padded tensors.
+      if (padded && shard.sizes() != c10::IntArrayRef(shard_shape)) {
         for (size_t j = 0; j < shard_shape.size(); ++j) {
-          XLA_CHECK_GE(shard_shape[j], shards[i].sizes().at(j));
-          pads.push_back(shard_shape[j] - shards[i].sizes().at(j));
-          pads.push_back(0);  // no padding on lhs
+          XLA_CHECK_GE(shard_shape[j], shard.sizes().at(j));
         }
-        // Padding starts from the last dimension
-        std::reverse(pads.begin(), pads.end());
-        shards[i] = at::constant_pad_nd(
-            shards[i], c10::IntArrayRef(pads.data(), pads.size()), 0);
+        shards[i] = at::empty(shard_shape, shard.options());
+        CopyIntoPaddedShard(shard, shards[i]);
+      } else {
+        shards[i] = shard.contiguous(at::MemoryFormat::Contiguous);
       }
     }
   } else {
@@ -499,6 +786,54 @@ std::vector<at::Tensor> ShardingUtil::ShardTensor(
   return shards;
 }
 
+std::vector<std::shared_ptr<const runtime::TensorSource>>
+ShardingUtil::CreateShardSources(const at::Tensor& tensor,
+                                 const XLATensor::ShardingSpecPtr& shardings,
+                                 const std::vector<std::string>& devices) {
+  XLA_CHECK(shardings != nullptr &&
+            shardings->sharding.type() == xla::OpSharding::OTHER);
+  XLA_CHECK(tensor.device().is_cpu() && tensor.layout() == at::kStrided);
+  std::vector<int64_t> shard_shape = GetShardShape(shardings);
+  std::vector<std::vector<at::indexing::TensorIndex>> shard_indices;
+  if (shardings->minibatch) {
+    shard_indices = GetShardIndicesForMinibatchTensor(shard_shape, devices);
+  } else {
+    auto replica_and_indices = GetShardReplicaAndIndicesForDevices(
+        shard_shape, tensor.sizes().vec(), shardings->sharding, devices);
+    for (auto& replica_and_index : replica_and_indices) {
+      shard_indices.push_back(std::move(replica_and_index.second));
+    }
+  }
+
+  std::vector<std::shared_ptr<const runtime::TensorSource>> sources(
+      devices.size());
+  auto create_sources = [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; ++i) {
+      torch::lazy::BackendDevice device = ParseDeviceString(devices[i]);
+      at::Tensor shard = tensor.index(shard_indices[i]);
+      at::ScalarType target_type = TorchTypeFromXlaType(
+          MakeXlaPrimitiveType(tensor.scalar_type(), &device));
+      bool padded = shard.sizes() != c10::IntArrayRef(shard_shape);
+      if (!padded && shard.scalar_type() == target_type) {
+        TORCH_LAZY_COUNTER("StridedShardSources", 1);
+        sources[i] = std::make_shared<runtime::StridedViewSource>(
+            shard, CreateComputationShapeFromTensor(shard, &device),
+            devices[i]);
+        continue;
+      }
+      // The shard is written once into a tensor of the padded shape, the
+      // padding being zeros, as in ShardTensor().
+      at::Tensor dest = at::empty(shard_shape, at::TensorOptions(target_type));
+      CopyIntoPaddedShard(shard, dest);
+      sources[i] = std::make_shared<runtime::StridedViewSource>(
+          dest, CreateComputationShapeFromTensor(dest, &device), devices[i],
+          /*shares_caller_data=*/false);
+    }
+  };
+  at::parallel_for(0, devices.size(), /*grain_size=*/1, create_sources);
+  return sources;
+}
+
 std::vector<XLATensor::ShardingSpecPtr> ShardingUtil::GetOutputSharding(
     const std::vector<xla::Shape>& output_shapes,
     runtime::ComputationClient::ComputationPtr computation) {
@@ -539,16 +874,13 @@ std::vector<torch::lazy::BackendDataPtr> ShardingUtil::CreateShardedPlaceholder(
   placeholders.reserve(sharding_specs.size());
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
                       runtime::GetComputationClient());
-  for (int i = 0; i < sharding_specs.size(); ++i) {
+  const std::string device = GetVirtualDevice().toString();
+  for (const XLATensor::ShardingSpecPtr& sharding_spec : sharding_specs) {
     // Create sharded data placeholder, this will be used to
     // hold the corresponding computation results for both sharding &
     // replication.
-    auto sharded_data_placeholder = client->CreateDataPlaceholder(
-        GetVirtualDevice().toString(), sharding_specs[i]->shape,
-        sharding_specs[i]->sharding);
-
-    // Register the sharded data placeholder to the tensor and its node.
-    placeholders.push_back(sharded_data_placeholder);
+    placeholders.push_back(client->CreateDataPlaceholder(
+        device, sharding_spec->shape, sharding_spec->sharding));
   }
   return placeholders;
 }
@@ -558,40 +890,35 @@ void ShardingUtil::PrepareOutputShardingPropagation(
     runtime::ComputationClient::ComputationPtr computation,
     std::vector<torch::lazy::BackendDataPtr>* data_placeholders,
     std::vector<XLATensor::ShardingSpecPtr>* sharding_specs) {
-  // Resizes the containers to `indices.size()`.
-  data_placeholders->resize(indices.size());
-  sharding_specs->resize(indices.size());
-
   std::vector<xla::Shape> output_shapes;
   output_shapes.reserve(indices.size());
   for (int i = 0; i < indices.size(); ++i) {
     auto xtensor = (*tensors)[indices[i]];
     output_shapes.push_back(xtensor->shape().get());
   }
-  auto new_sharding_specs = GetOutputSharding(output_shapes, computation);
-  XLA_CHECK(indices.size() == new_sharding_specs.size())
-      << "Expected size: " << indices.size()
-      << ", actual size: " << new_sharding_specs.size();
+  PrepareOutputShardingPropagation(
+      tensors, indices, GetOutputSharding(output_shapes, computation),
+      data_placeholders, sharding_specs);
+}
 
-  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
-                      runtime::GetComputationClient());
+void ShardingUtil::PrepareOutputShardingPropagation(
+    std::vector<XLATensorPtr>* tensors, absl::Span<const size_t> indices,
+    const std::vector<XLATensor::ShardingSpecPtr>& output_sharding_specs,
+    std::vector<torch::lazy::BackendDataPtr>* data_placeholders,
+    std::vector<XLATensor::ShardingSpecPtr>* sharding_specs) {
+  XLA_CHECK(indices.size() == output_sharding_specs.size())
+      << "Expected size: " << indices.size()
+      << ", actual size: " << output_sharding_specs.size();
+  *sharding_specs = output_sharding_specs;
+  *data_placeholders = CreateShardedPlaceholder(output_sharding_specs);
   for (int i = 0; i < indices.size(); ++i) {
-    auto xtensor = (*tensors)[indices[i]];
-    (*sharding_specs)[i] = new_sharding_specs[i];
+    auto& xtensor = (*tensors)[indices[i]];
     // Allow overwriting the sharding specs, since output sharding propagation
     // happens after any resharding that might have already taken place during
     // auto-sharding pass.
     xtensor->SetShardingSpec(*(*sharding_specs)[i], /*allow_overwrite=*/true);
 
-    // Create sharded data placeholder, this will be used to
-    // hold the corresponding computation results for both sharding &
-    // replication.
-    auto sharded_data_placeholder = client->CreateDataPlaceholder(
-        GetVirtualDevice().toString(), (*sharding_specs)[i]->shape,
-        (*sharding_specs)[i]->sharding);
-
     // Register the sharded data placeholder to the tensor and its node.
-    (*data_placeholders)[i] = sharded_data_placeholder;
     xtensor->data()->handle = (*data_placeholders)[i];
     // TODO(JackCaoG): Invesgate why output tensor has IR value here.
     if (xtensor->CurrentIrValue()) {
@@ -625,12 +952,26 @@ runtime::ComputationClient::DataPtr ShardingUtil::CreateShardedData(
     global_shape = sharding_spec->shape;
     sharding = sharding_spec->sharding;
   }
+  // The shards of replicated data are all the same tensor, which is converted
+  // once, its source being shared by the ones of the other devices.
+  std::unordered_map<const c10::TensorImpl*,
+                     std::shared_ptr<const runtime::TensorSource>>
+      converted_shards;
   for (int64_t j = 0; j < devices.size(); ++j) {
+    const c10::TensorImpl* impl = local_shards[j].unsafeGetTensorImpl();
+    auto it = converted_shards.find(impl);
+    if (it != converted_shards.end()) {
+      TORCH_LAZY_COUNTER("ReplicatedShardSources", 1);
+      source_tensors.push_back(
+          std::make_shared<runtime::ReplicaSource>(it->second, devices[j]));
+      continue;
+    }
     auto shard_device = ParseDeviceString(devices[j]);
     auto shard_shape =
         CreateComputationShapeFromTensor(local_shards[j], &shard_device);
-    source_tensors.push_back(std::make_shared<runtime::AtenSource>(
-        local_shards[j], shard_shape, devices[j]));
+    source_tensors.push_back(
+        CreateTensorSource(local_shards[j], shard_shape, devices[j]));
+    converted_shards.emplace(impl, source_tensors.back());
   }
   XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
                       runtime::GetComputationClient());
@@ -658,6 +999,69 @@ std::vector<int64_t> ShardingUtil::GetAutoShardingMesh() {
   return mesh_shape;
 }
 
+std::vector<std::vector<int64_t>>
+ShardingUtil::GetAutoShardingMeshCandidates() {
+  // XLA_AUTO_SPMD_MESH_CANDIDATES lists meshes separated by ";", like
+  // "1,8;2,4;4,2", or is "auto" for the 2D meshes 1xN, 2xN/2, 4xN/4, ...
+  std::string candidates_str =
+      runtime::sys_util::GetEnvString("XLA_AUTO_SPMD_MESH_CANDIDATES", "");
+  std::vector<std::vector<int64_t>> candidates;
+  if (candidates_str.empty()) {
+    return candidates;
+  }
+  XLA_ASSIGN_OR_THROW(runtime::ComputationClient * absl_nonnull const client,
+                      runtime::GetComputationClient());
+  int64_t n_devices = client->GetAllDevices().size();
+  if (candidates_str == "auto") {
+    for (int64_t rows = 1; rows < n_devices; rows *= 2) {
+      if (n_devices % rows == 0) {
+        candidates.push_back({rows, n_devices / rows});
+      }
+    }
+    return candidates;
+  }
+  for (absl::string_view mesh_str : absl::StrSplit(candidates_str, ';')) {
+    std::vector<int64_t> mesh_shape =
+        ParseStringToIntVector(std::string(mesh_str));
+    int64_t total_devices = 1;
+    for (auto i : mesh_shape) {
+      total_devices *= i;
+    }
+    XLA_CHECK_EQ(total_devices, n_devices)
+        << "Invalid auto-sharding mesh_shape candidate: " << mesh_str;
+    candidates.push_back(std::move(mesh_shape));
+  }
+  return candidates;
+}
+
+size_t ShardingUtil::SelectAutoShardingCandidate(
+    const std::vector<runtime::ComputationClient::ComputationPtr>&
+        computations) {
+  // Weighs the bytes accessed per device against its flops, for the
+  // estimated run time of a computation bound by either. This is about the
+  // balance point of the current accelerators.
+  static constexpr double kFlopsPerByte = 100;
+  size_t best = 0;
+  double best_cost = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < computations.size(); ++i) {
+    std::optional<runtime::ComputationClient::Computation::CostAnalysis>
+        cost_analysis = computations[i]->cost_analysis();
+    if (!cost_analysis.has_value()) {
+      continue;
+    }
+    double cost =
+        std::max(cost_analysis->flops + cost_analysis->transcendentals,
+                 cost_analysis->bytes_accessed * kFlopsPerByte);
+    TF_VLOG(3) << "Auto-sharding candidate " << i
+               << " estimated cost: " << cost;
+    if (cost < best_cost) {
+      best = i;
+      best_cost = cost;
+    }
+  }
+  return best;
+}
+
 std::vector<int64_t> ShardingUtil::GetAutoShardingMeshIds(
     const xla::HloModuleProto& module) {
   // Return the first non-default (iota) mesh ids arrangement, as we expect
@@ -698,19 +1102,15 @@ void ShardingUtil::ReshardParameters(
     const xla::HloModuleProto& module, std::vector<XLATensorPtr>* tensors,
     std::vector<torch::lazy::BackendDataPtr>* parameters,
     std::vector<const torch::lazy::Node*>* nodes) {
-  // Extract input shardings generated from auto-sharding pass.
-  std::vector<xla::OpSharding> input_shardings;
-  if (module.spmd_parameters_shardings().size() == 1 &&
-      module.spmd_parameters_shardings()[0].type() == xla::OpSharding::TUPLE) {
-    auto tuple_shardings =
-        module.spmd_parameters_shardings()[0].tuple_shardings();
-    input_shardings = std::vector<xla::OpSharding>(tuple_shardings.begin(),
-                                                   tuple_shardings.end());
-  } else {
-    for (auto sharding : module.spmd_parameters_shardings()) {
-      input_shardings.push_back(sharding);
-    }
-  }
+  ReshardParameters(GetModuleInputShardings(module), tensors, parameters,
+                    nodes);
+}
+
+void ShardingUtil::ReshardParameters(
+    const std::vector<xla::OpSharding>& input_shardings,
+    std::vector<XLATensorPtr>* tensors,
+    std::vector<torch::lazy::BackendDataPtr>* parameters,
+    std::vector<const torch::lazy::Node*>* nodes) {
   if (input_shardings.size() == 0) {
     TF_VLOG(3) << "ReshardParamters... skip with empty input_shardings.";
     return;
@@ -728,8 +1128,8 @@ void ShardingUtil::ReshardParameters(
     XLA_CHECK(input_shardings[i].type() != xla::OpSharding::UNKNOWN)
         << "Resharding by UNKNOWN sharding type is not allowed.";
     // Skip re-sharding if not necessary.
-    if (!xla::protobuf_util::HaveSameSerialization(data[i]->GetSharding(),
-                                                   input_shardings[i])) {
+    if (!ShardingUtil::EqualOpShardings(data[i]->GetSharding(),
+                                        input_shardings[i])) {
       reshard_indices.push_back(i);
       data_to_reshard.push_back(data[i]);
       shardings_to_reshard.push_back(input_shardings[i]);
@@ -883,6 +1283,108 @@ void ShardingUtil::XlaAnnotateCustomSharding(const XLATensorPtr& input,
   tensor_methods::custom_sharding_(input, sharding_spec);
 }
 
+std::optional<ShardingUtil::AutoShardingPlan>
+ShardingUtil::LookupAutoShardingPlan(const torch::lazy::hash_t& hash) {
+  std::optional<std::string> data =
+      AutoShardingPlanStore::Get()->Read(torch::lazy::HashToString(hash));
+  // The plan is stored as a tuple of the input shardings tuple and of the
+  // output sharding.
+  xla::OpSharding plan_sharding;
+  if (!data || !plan_sharding.ParseFromString(*data) ||
+      plan_sharding.tuple_shardings_size() != 2) {
+    return std::nullopt;
+  }
+  const xla::OpSharding& inputs = plan_sharding.tuple_shardings(0);
+  AutoShardingPlan plan;
+  plan.input_shardings.assign(inputs.tuple_shardings().begin(),
+                              inputs.tuple_shardings().end());
+  plan.output_sharding = plan_sharding.tuple_shardings(1);
+  return plan;
+}
+
+ShardingUtil::AutoShardingPlan ShardingUtil::StoreAutoShardingPlan(
+    const torch::lazy::hash_t& hash, const xla::HloModuleProto& module) {
+  AutoShardingPlan plan;
+  plan.input_shardings = GetModuleInputShardings(module);
+  if (plan.input_shardings.empty() || !module.has_spmd_output_sharding()) {
+    return plan;
+  }
+  plan.output_sharding = module.spmd_output_sharding();
+  xla::OpSharding plan_sharding;
+  plan_sharding.set_type(xla::OpSharding::TUPLE);
+  xla::OpSharding* inputs = plan_sharding.add_tuple_shardings();
+  inputs->set_type(xla::OpSharding::TUPLE);
+  for (const xla::OpSharding& sharding : plan.input_shardings) {
+    *inputs->add_tuple_shardings() = sharding;
+  }
+  *plan_sharding.add_tuple_shardings() = plan.output_sharding;
+  TORCH_LAZY_COUNTER("AutoShardingPlanStored", 1);
+  AutoShardingPlanStore::Get()->Write(torch::lazy::HashToString(hash),
+                                      plan_sharding.SerializeAsString());
+  return plan;
+}
+
+absl::Status ShardingUtil::ApplyAutoShardingPlan(
+    const AutoShardingPlan& plan, xla::HloModuleProto* module) {
+  XLA_ASSIGN_OR_RETURN(runtime::ComputationClient * absl_nonnull const client,
+                       runtime::GetComputationClient());
+  int64_t num_devices = client->GetAllDevices().size();
+  xla::HloComputationProto* entry = nullptr;
+  for (xla::HloComputationProto& computation :
+       *module->mutable_computations()) {
+    if (computation.id() == module->entry_computation_id()) {
+      entry = &computation;
+    }
+  }
+  XLA_CHECK(entry != nullptr);
+  // Validates all the shardings before annotating any instruction.
+  std::vector<std::pair<xla::HloInstructionProto*, const xla::OpSharding*>>
+      annotations;
+  for (xla::HloInstructionProto& instruction :
+       *entry->mutable_instructions()) {
+    const xla::OpSharding* sharding = nullptr;
+    if (instruction.opcode() ==
+        xla::HloOpcodeString(xla::HloOpcode::kParameter)) {
+      if (instruction.parameter_number() >=
+          static_cast<int64_t>(plan.input_shardings.size())) {
+        return absl::InvalidArgumentError(
+            "Auto-sharding plan has fewer input shardings than parameters.");
+      }
+      sharding = &plan.input_shardings[instruction.parameter_number()];
+    } else if (instruction.id() == entry->root_id()) {
+      sharding = &plan.output_sharding;
+    } else {
+      continue;
+    }
+    XLA_ASSIGN_OR_RETURN(xla::HloSharding hlo_sharding,
+                         xla::HloSharding::FromProto(*sharding));
+    XLA_RETURN_IF_ERROR(
+        hlo_sharding.Validate(xla::Shape(instruction.shape()), num_devices));
+    annotations.emplace_back(&instruction, sharding);
+  }
+  if (annotations.size() != plan.input_shardings.size() + 1) {
+    return absl::InvalidArgumentError(
+        "Auto-sharding plan does not match the parameters of the graph.");
+  }
+  for (const auto& annotation : annotations) {
+    *annotation.first->mutable_sharding() = *annotation.second;
+  }
+  return absl::OkStatus();
+}
+
+std::vector<xla::OpSharding> ShardingUtil::GetAutoShardingInputShardings(
+    const torch::lazy::hash_t& hash, const xla::HloModuleProto& module) {
+  std::vector<xla::OpSharding> input_shardings =
+      GetModuleInputShardings(module);
+  if (input_shardings.empty()) {
+    std::optional<AutoShardingPlan> plan = LookupAutoShardingPlan(hash);
+    if (plan) {
+      input_shardings = std::move(plan->input_shardings);
+    }
+  }
+  return input_shardings;
+}
+
 void ShardingUtil::SetAutoSharding() {
   // This stays on throughout the program.
   use_auto_sharding = true;
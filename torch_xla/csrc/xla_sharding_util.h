@@ -1,6 +1,7 @@
 #ifndef XLA_TORCH_XLA_CSRC_XLA_SHARDING_UTIL_H_
 #define XLA_TORCH_XLA_CSRC_XLA_SHARDING_UTIL_H_
 
+#include <optional>
 #include <tuple>
 
 #include <torch/csrc/jit/python/pybind.h>
@@ -46,6 +47,15 @@ class ShardingUtil {
   static bool EqualOpShardings(const xla::OpSharding& a,
                                const xla::OpSharding& b);
 
+  // Returns a hash of `sharding`, equal for the OpShardings which
+  // EqualOpShardings() tells are the same.
+  static torch::lazy::hash_t HashOpSharding(const xla::OpSharding& sharding);
+
+  // Returns the canonical copy of `sharding`, shared by all the equal ones
+  // interned, which then compare by address.
+  static std::shared_ptr<const xla::OpSharding> InternOpSharding(
+      const xla::OpSharding& sharding);
+
   // Creates an xla::OpSharding. `tile_assignmnent` is required for TILED
   // `sharding_type` and `replication_groups` for `PARTIAL`.
   static xla::OpSharding CreateOpSharding(const py::list& tile_assignment,
@@ -70,7 +80,7 @@ class ShardingUtil {
   // `REPLICATED` and `OTHER` sharding types.
   // For each input device, returns a pair of the shard's replica_id and a
   // vector of TensorIndex denoting the offset of the device's shard into the
-  // global tensor.
+  // global tensor. The result is memoized by the arguments.
   static std::vector<std::pair<int, std::vector<at::indexing::TensorIndex>>>
   GetShardReplicaAndIndicesForDevices(const std::vector<int64_t>& shard_shape,
                                       const std::vector<int64_t>& tensor_shape,
@@ -83,6 +93,28 @@ class ShardingUtil {
   GetShardIndicesForMinibatchTensor(const std::vector<int64_t>& shard_shape,
                                     const std::vector<std::string>& devices);
 
+  // The part of a shard which overlaps a region of the global tensor.
+  struct ShardOverlap {
+    // Index of the shard's device in the `devices` the overlaps are found for.
+    int64_t shard;
+    // Offsets of the overlap into the shard and into the region.
+    std::vector<int64_t> shard_offsets;
+    std::vector<int64_t> region_offsets;
+    std::vector<int64_t> sizes;
+  };
+
+  // Returns the overlaps of the shards on `devices` with the region of the
+  // global tensor spanning `[region_starts[d], region_stops[d])` along every
+  // dimension `d`. A part held by several replicas is only read from the first
+  // of them, so the overlaps are disjoint. Fails if the shards on `devices` do
+  // not cover the region.
+  static std::vector<ShardOverlap> GetShardOverlaps(
+      const std::vector<int64_t>& shard_shape,
+      const std::vector<int64_t>& tensor_shape,
+      const xla::OpSharding& sharding, const std::vector<std::string>& devices,
+      const std::vector<int64_t>& region_starts,
+      const std::vector<int64_t>& region_stops);
+
   // Shards a tensor and returns the sharded tensors which belong on `devices`
   // based on the `sharding` spec. REPLICATED sharding should result in shards
   // identical to the input; OTHERS (tiled) sharding result in shards where
@@ -97,6 +129,17 @@ class ShardingUtil {
       const at::Tensor& tensor, const XLATensor::ShardingSpecPtr shardings,
       const std::vector<std::string>& devices, bool padded = true);
 
+  // Returns the sources of the transfers of the padded shards ShardTensor()
+  // would return for the CPU `tensor` and the tiled `shardings`, without
+  // copying them out first: the shards are strided views of `tensor`, read
+  // by the transfers straight into the runtime staging buffers. Only the
+  // shards needing padding or an element type conversion are copied on the
+  // host, once, in parallel across the devices.
+  static std::vector<std::shared_ptr<const runtime::TensorSource>>
+  CreateShardSources(const at::Tensor& tensor,
+                     const XLATensor::ShardingSpecPtr& shardings,
+                     const std::vector<std::string>& devices);
+
   // Retrieve output sharding of a given XLA computation. ShardingSpec::shape
   // is always on virtual SPMD device.
   static std::vector<XLATensor::ShardingSpecPtr> GetOutputSharding(
@@ -120,6 +163,14 @@ class ShardingUtil {
       std::vector<torch::lazy::BackendDataPtr>* data_placeholders,
       std::vector<XLATensor::ShardingSpecPtr>* sharding_specs);
 
+  // Same as above, with the `output_sharding_specs` already extracted from the
+  // computation by GetOutputSharding().
+  static void PrepareOutputShardingPropagation(
+      std::vector<XLATensorPtr>* tensors, absl::Span<const size_t> indices,
+      const std::vector<XLATensor::ShardingSpecPtr>& output_sharding_specs,
+      std::vector<torch::lazy::BackendDataPtr>* data_placeholders,
+      std::vector<XLATensor::ShardingSpecPtr>* sharding_specs);
+
   // Transfers the individual shards to the devices and returns a DataPtr for
   // the PjRtShardedData wrapping the shards.
   static runtime::ComputationClient::DataPtr CreateShardedData(
@@ -144,6 +195,18 @@ class ShardingUtil {
   static std::vector<int64_t> GetAutoShardingMeshIds(
       const xla::HloModuleProto& module);
 
+  // Returns the logical meshes of XLA_AUTO_SPMD_MESH_CANDIDATES, which the
+  // graphs are all compiled with, in parallel, to keep the cheapest
+  // executable. Empty if not set.
+  static std::vector<std::vector<int64_t>> GetAutoShardingMeshCandidates();
+
+  // Returns the index of the computation of the lowest estimated run time,
+  // from their cost analysis. Those without one are never selected, unless
+  // none has one, in which case the first is.
+  static size_t SelectAutoShardingCandidate(
+      const std::vector<runtime::ComputationClient::ComputationPtr>&
+          computations);
+
   // Reshard the parameters if the expected shardings mismatch. Resharding is
   // expensive especially for those already sharded. The cost can easily be
   // armotized over multiple steps, though, since the input sharding is
@@ -154,6 +217,43 @@ class ShardingUtil {
       const xla::HloModuleProto& module, std::vector<XLATensorPtr>* tensors,
       std::vector<torch::lazy::BackendDataPtr>* parameters,
       std::vector<const torch::lazy::Node*>* nodes);
+  static void ReshardParameters(
+      const std::vector<xla::OpSharding>& input_shardings,
+      std::vector<XLATensorPtr>* tensors,
+      std::vector<torch::lazy::BackendDataPtr>* parameters,
+      std::vector<const torch::lazy::Node*>* nodes);
+
+  // The input and output shardings chosen by the auto-sharding pass for a
+  // graph.
+  struct AutoShardingPlan {
+    std::vector<xla::OpSharding> input_shardings;
+    xla::OpSharding output_sharding;
+  };
+
+  // Returns the plan of the graph of `hash`, if stored in this process or in
+  // the directory of XLA_AUTO_SPMD_PLAN_CACHE_PATH.
+  static std::optional<AutoShardingPlan> LookupAutoShardingPlan(
+      const torch::lazy::hash_t& hash);
+
+  // Stores the plan of the graph of `hash` found in its auto-sharded and
+  // compiled `module`, and returns it. No plan is stored if `module` has no
+  // auto-sharding results: the input shardings of the returned plan are then
+  // empty.
+  static AutoShardingPlan StoreAutoShardingPlan(
+      const torch::lazy::hash_t& hash, const xla::HloModuleProto& module);
+
+  // Annotates the parameters and the root of the lowered `module` with the
+  // shardings of `plan`, for it to be partitioned without running the
+  // auto-sharding pass. Leaves `module` untouched and returns an error if the
+  // plan does not fit it.
+  static absl::Status ApplyAutoShardingPlan(const AutoShardingPlan& plan,
+                                            xla::HloModuleProto* module);
+
+  // Returns the input shardings generated by the auto-sharding pass for the
+  // compiled `module` of the graph of `hash`, or the ones of its plan if the
+  // module was compiled from one.
+  static std::vector<xla::OpSharding> GetAutoShardingInputShardings(
+      const torch::lazy::hash_t& hash, const xla::HloModuleProto& module);
 
   static void SetAutoSharding();
   static bool GetAutoSharding();
@@ -1,3 +1,5 @@
+import os
+
 import torch_xla
 
 
@@ -64,6 +66,117 @@ def metrics_report():
   return torch_xla._XLAC._xla_metrics_report()
 
 
+def graph_stats():
+  """Retrieves the execution statistics of every compiled graph.
+
+  Returns:
+    A list with a dictionary per graph, with the keys:
+      `hash`: The graph hash, as returned by `_get_graph_hash`.
+      `executions`: The number of executions of the graph.
+      `execute_time_p50_ns`, `execute_time_p99_ns`: The percentiles of the
+        device time of the most recent executions, or None before the first
+        execution completed.
+      `execute_times_ns`: The device times of the most recent executions.
+      `compilations`, `compile_time_ns`: The number of compilations of the
+        graph and the total time they took.
+      `input_bytes`, `output_bytes`: The sizes of the graph inputs and outputs.
+      `last_step`: The number of steps marked before the last execution.
+      `flops`, `bytes_accessed`, `transcendentals`: The cost of an execution
+        on each device, from the XLA cost analysis, or 0 if unknown.
+      `tflops`: The TFLOP/s achieved at the median execute time, or None if
+        unknown.
+      `model_flops_utilization`: `tflops` over `XLA_PEAK_TFLOPS`, or None if
+        either is unknown.
+  """
+  peak_tflops = float(os.environ.get('XLA_PEAK_TFLOPS', 0))
+  stats = torch_xla._XLAC._get_graph_stats()
+  for graph in stats:
+    times = sorted(graph['execute_times_ns'])
+    graph['execute_time_p50_ns'] = times[len(times) // 2] if times else None
+    graph['execute_time_p99_ns'] = times[len(times) * 99 //
+                                         100] if times else None
+    p50 = graph['execute_time_p50_ns']
+    # FLOPs per picosecond are TFLOP/s.
+    tflops = None
+    if graph['flops'] > 0 and p50:
+      tflops = graph['flops'] / (p50 * 1000)
+    graph['tflops'] = tflops
+    graph['model_flops_utilization'] = (
+        tflops / peak_tflops if tflops and peak_tflops > 0 else None)
+  return stats
+
+
+def openmetrics_report():
+  """Retrieves the counters and metrics in the OpenMetrics text format.
+
+  This is the format served by the exporter enabled with
+  `XLA_METRICS_EXPORTER_PORT` or `XLA_METRICS_EXPORTER_FILE`.
+  """
+  return torch_xla._XLAC._xla_openmetrics_report()
+
+
+def step_timeline():
+  """Retrieves the recent step phase events as Chrome trace JSON.
+
+  The events cover tracing, post order, lowering, compilation, transfers and
+  execution, tagged with their step and graph hash. The number of events kept
+  is set by `XLA_STEP_TIMELINE_EVENTS`.
+  """
+  return torch_xla._XLAC._xla_step_timeline()
+
+
+def dump_step_timeline(path: str):
+  """Writes `step_timeline()` to `path`, to be loaded in chrome://tracing or
+  Perfetto.
+  """
+  torch_xla._XLAC._xla_dump_step_timeline(path)
+
+
+def memory_history():
+  """Retrieves the device memory samples of `XLA_MEMORY_SAMPLER`.
+
+  Returns:
+    A dictionary keyed by device, with the keys:
+      `bytes_limit`: The memory limit of the device.
+      `samples`: The most recent samples, from the oldest, each with the
+        `time_ns`, `step`, `bytes_used`, `peak_bytes_used` and
+        `largest_free_block_bytes` keys.
+      `step_peaks`: The most recent steps, from the oldest, each with the
+        `step`, the `peak_bytes_used` and the `fragmentation` seen during it.
+        The fragmentation is one minus the largest free block over the free
+        bytes.
+      `growth_alerts`, `fragmentation_alerts`: The number of warnings logged
+        about the step peaks growing past the ones of the warmup steps.
+  """
+  return torch_xla._XLAC._xla_memory_history()
+
+
+def trace_profile(total: bool = False):
+  """Retrieves the host time spent tracing each op, when `XLA_TRACE_PROFILER`
+  is set.
+
+  Args:
+    total (bool): Whether to return the times of all the steps instead of the
+      last one.
+
+  Returns:
+    A list with a dictionary per op, from the most expensive, with the keys:
+      `category`: `'aten_op'` for the XLA implementation of an ATen op,
+        including the IR it creates, `'node_creation'` for the construction
+        of the IR nodes of an op kind, `'shape_inference'` for their shape
+        inference, and `'lowering'` for their lowering into HLO.
+      `op`: The ATen op or the IR op kind.
+      `count`: The number of calls.
+      `total_ns`, `max_ns`: The total and the longest time of the calls.
+      `instructions`: For `'lowering'`, the number of HLO instructions
+        emitted.
+
+  The lowering stats of all the steps are also in the Lowering section of
+  `metrics_report()`.
+  """
+  return torch_xla._XLAC._xla_trace_profile(total)
+
+
 def short_metrics_report(counter_names: list = None, metric_names: list = None):
   """Retrieves a string containing the full metrics and counters report.
 
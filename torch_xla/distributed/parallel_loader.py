@@ -1,3 +1,4 @@
+import collections
 import itertools
 import queue
 import threading
@@ -10,6 +11,10 @@ import torch_xla.core.xla_model as xm
 import torch_xla.debug.profiler as xp
 
 
+def _is_cpu_tensor(value):
+  return type(value) == torch.Tensor and value.device.type == 'cpu'
+
+
 class PerDeviceQueue(object):
 
   def __init__(self, device, loader_prefetch_size, device_prefetch_size):
@@ -19,6 +24,37 @@ class PerDeviceQueue(object):
     self.close_queue_count = itertools.count()
 
 
+class NativePerDeviceQueue(object):
+  """Uploads the batches of a device with the C++ DevicePrefetcher, whose
+  threads transfer the CPU tensors without holding the GIL."""
+
+  def __init__(self, device, device_prefetch_size, transfer_threads):
+    self.device = device
+    self.prefetcher = torch_xla._XLAC.DevicePrefetcher(
+        str(device), device_prefetch_size, transfer_threads)
+    # The CPU batches in flight, in the order the prefetcher uploads them.
+    self._cpu_batches = collections.deque()
+
+  def put(self, data, input_sharding):
+    tensors = []
+    xu.for_each_instance(data, _is_cpu_tensor, tensors.append)
+    shardings = xm._get_input_shardings(tensors, input_sharding)
+    self._cpu_batches.append(data)
+    if not self.prefetcher.enqueue(tensors, shardings):
+      self._cpu_batches.pop()
+      return False
+    return True
+
+  def get(self):
+    tensors = self.prefetcher.dequeue()
+    if tensors is None:
+      return None
+    data = self._cpu_batches.popleft()
+    xla_tensors = iter(tensors)
+    return xu.for_each_instance_rewrite(data, _is_cpu_tensor,
+                                        lambda _: next(xla_tensors))
+
+
 class PerDeviceLoader(object):
 
   def __init__(self, loader, device):
@@ -80,6 +116,10 @@ class ParallelLoader(object):
       Default: 1
     input_sharding (ShardingSpec, Dict(str, ShardingSpec), optional): Sharding
       spec to apply to compatible input tensors after loading.
+    native_prefetch (bool, optional): Whether the batches are uploaded by C++
+      threads which do not hold the GIL, rather than by Python threads. The
+      sharding dicts always use the Python threads.
+      Default: True
   """
 
   def __init__(self,
@@ -90,7 +130,8 @@ class ParallelLoader(object):
                loader_prefetch_size=16,
                device_prefetch_size=8,
                host_to_device_transfer_threads=1,
-               input_sharding=None):
+               input_sharding=None,
+               native_prefetch=True):
     self._cpu_loader = cpu_loader
     self._devices = [torch.device(x) for x in devices]
     self._batchdim = batchdim
@@ -100,13 +141,20 @@ class ParallelLoader(object):
     self._exception_queue = queue.Queue()
     self._input_sharding = input_sharding
     self._threads = []
+    self._native = native_prefetch and not isinstance(input_sharding, dict)
     for device in self._devices:
-      self._queues[device] = PerDeviceQueue(device, loader_prefetch_size,
-                                            device_prefetch_size)
+      if self._native:
+        self._queues[device] = NativePerDeviceQueue(
+            device, device_prefetch_size, host_to_device_transfer_threads)
+      else:
+        self._queues[device] = PerDeviceQueue(device, loader_prefetch_size,
+                                              device_prefetch_size)
     thread = threading.Thread(target=self._loader_worker)
     thread.daemon = True
     thread.start()
     self._threads.append(thread)
+    if self._native:
+      return
     for dqueue in self._queues.values():
       for i in range(host_to_device_transfer_threads):
         thread = threading.Thread(
@@ -138,11 +186,16 @@ class ParallelLoader(object):
 
   def next_item(self, device):
     dqueue = self._queues[device]
+    if self._native:
+      return dqueue.get()
     return dqueue.queue.get()
 
   def close(self):
     self._done = True
     for dqueue in self._queues.values():
+      if self._native:
+        dqueue.prefetcher.close()
+        continue
       dqueue.queue.close()
       dqueue.cpu_loader_queue.close()
 
@@ -168,11 +221,23 @@ class ParallelLoader(object):
         batch.append(data)
         if len(batch) == len(self._devices):
           for queue_no, device_batch in enumerate(batch):
-            queues[queue_no].cpu_loader_queue.put(device_batch)
+            if not self._native:
+              queues[queue_no].cpu_loader_queue.put(device_batch)
+              continue
+            try:
+              if not queues[queue_no].put(device_batch, self._input_sharding):
+                return
+            except Exception as e:
+              # Raised from the consumer threads, as for the Python workers.
+              self._exception_queue.put(e)
+              return
           batch = []
     finally:
       for dqueue in queues:
-        dqueue.cpu_loader_queue.close_write()
+        if self._native:
+          dqueue.prefetcher.close_write()
+        else:
+          dqueue.cpu_loader_queue.close_write()
 
   def _get_batch(self, dqueue):
     batch = []
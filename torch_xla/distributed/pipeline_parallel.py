@@ -0,0 +1,224 @@
+from typing import Any, Callable, List, Optional, Sequence, Tuple
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.runtime as xr
+
+FORWARD = 'forward'
+BACKWARD = 'backward'
+
+# The number of receive buffers of each direction of a stage link. The
+# transfer of a micro-batch only waits on the transfers which went through the
+# same buffer, so the receive of the next micro-batch is issued while the
+# current one is computed.
+_NUM_RECV_BUFFERS = 2
+
+
+def one_f_one_b_schedule(num_stages: int, stage: int,
+                         num_microbatches: int) -> List[Tuple[str, int]]:
+  """Returns the 1F1B schedule of a pipeline stage.
+
+  The stage runs the forward pass of as many micro-batches as there are stages
+  after it, then alternates one forward and one backward pass, and drains the
+  remaining backward passes. Only `num_stages - stage` micro-batches have their
+  activations alive at any time.
+
+  Args:
+    num_stages (int): The number of stages of the pipeline.
+    stage (int): The index of the stage, from 0 to `num_stages - 1`.
+    num_microbatches (int): The number of micro-batches of the step.
+
+  Returns:
+    The list of `(action, microbatch)` pairs, where `action` is one of
+    `FORWARD` and `BACKWARD`.
+  """
+  warmup = min(num_stages - stage - 1, num_microbatches)
+  schedule = [(FORWARD, i) for i in range(warmup)]
+  backward = 0
+  for forward in range(warmup, num_microbatches):
+    schedule.append((FORWARD, forward))
+    schedule.append((BACKWARD, backward))
+    backward += 1
+  schedule.extend((BACKWARD, i) for i in range(backward, num_microbatches))
+  return schedule
+
+
+class PipelineStage(object):
+  """Runs one stage of a pipeline parallel model over micro-batches.
+
+  The activations go to the next stage, and the gradients come back from it,
+  through `xm.collective_permute()` between the two processes of the link,
+  like the `send()` and `recv()` of the XLA process group. Unlike them, the
+  transfers are not followed by a step boundary, and are not ordered after
+  each other: every direction of a link has `_NUM_RECV_BUFFERS` receive
+  buffers, each with a token domain of its own (see `xm.token_domain()`), and
+  the receive of a micro-batch is issued ahead of the computation of the
+  previous one. The whole schedule is traced into a single graph, in which XLA
+  overlaps the stage-to-stage transfers of a micro-batch with the compute of
+  the next one.
+
+  Every process of the pipeline must create its stage with the same
+  `stage_ranks` and run the same number of micro-batches.
+
+  Args:
+    module (callable): The layers of the stage, applied to the activations
+      received from the previous stage, or to the micro-batch on the
+      first stage.
+    stage (int): The index of the stage of this process.
+    activation_shape (sequence): The shape of the activations sent between
+      the stages, which is also the one of their gradients.
+    activation_dtype (torch.dtype, optional): The type of the activations.
+    stage_ranks (list, optional): The global ordinal of the process running
+      every stage. Default: the first `len(stage_ranks)` ordinals, where the
+      number of stages defaults to the world size.
+    loss_fn (callable, optional): The loss of the last stage, called with the
+      output of the module and the target of the micro-batch.
+  """
+
+  def __init__(self,
+               module: Callable[[torch.Tensor], torch.Tensor],
+               stage: int,
+               activation_shape: Sequence[int],
+               activation_dtype: torch.dtype = torch.float32,
+               stage_ranks: Optional[List[int]] = None,
+               loss_fn: Optional[Callable[[torch.Tensor, Any],
+                                          torch.Tensor]] = None):
+    if stage_ranks is None:
+      stage_ranks = list(range(xr.world_size()))
+    if not 0 <= stage < len(stage_ranks):
+      raise ValueError(
+          f'Stage {stage} out of a pipeline of {len(stage_ranks)} stages')
+    self.module = module
+    self.stage = stage
+    self.stage_ranks = stage_ranks
+    self.num_stages = len(stage_ranks)
+    self.loss_fn = loss_fn
+    self._activation_shape = tuple(activation_shape)
+    self._activation_dtype = activation_dtype
+    self._recv_buffers = {}
+
+  @property
+  def is_first(self) -> bool:
+    return self.stage == 0
+
+  @property
+  def is_last(self) -> bool:
+    return self.stage == self.num_stages - 1
+
+  def _recv_buffer(self, direction: str, slot: int) -> torch.Tensor:
+    key = (direction, slot)
+    buffer = self._recv_buffers.get(key)
+    if buffer is None:
+      buffer = torch.zeros(
+          self._activation_shape,
+          dtype=self._activation_dtype,
+          device=torch_xla.device())
+      self._recv_buffers[key] = buffer
+    return buffer
+
+  def _transfer(self, direction: str, link: int, microbatch: int,
+                value: torch.Tensor) -> torch.Tensor:
+    # Link `i` goes between the stages `i` and `i + 1`, so both ends name the
+    # same token domain, and issue its transfers in the same order.
+    src, dst = link, link + 1
+    if direction == BACKWARD:
+      src, dst = dst, src
+    slot = microbatch % _NUM_RECV_BUFFERS
+    pairs = [[self.stage_ranks[src], self.stage_ranks[dst]]]
+    with xm.token_domain(f'pipeline:{direction}:{link}:{slot}'):
+      return xm.collective_permute(value, pairs=pairs)
+
+  def _recv(self, direction: str, microbatch: int) -> torch.Tensor:
+    link = self.stage - 1 if direction == FORWARD else self.stage
+    buffer = self._recv_buffer(direction, microbatch % _NUM_RECV_BUFFERS)
+    return self._transfer(direction, link, microbatch, buffer)
+
+  def _send(self, direction: str, microbatch: int, value: torch.Tensor):
+    link = self.stage if direction == FORWARD else self.stage - 1
+    self._transfer(direction, link, microbatch, value)
+
+  def _needs_recv(self, action: Tuple[str, int]) -> bool:
+    direction, _ = action
+    return not self.is_first if direction == FORWARD else not self.is_last
+
+  def run(self,
+          microbatches: Optional[Sequence[torch.Tensor]] = None,
+          targets: Optional[Sequence[Any]] = None,
+          num_microbatches: Optional[int] = None,
+          schedule: Optional[List[Tuple[str, int]]] = None) -> List[Any]:
+    """Runs the forward and backward passes of the micro-batches of a step.
+
+    The gradients are accumulated into the parameters of the module, and the
+    optimizer step, as well as the `torch_xla.sync()` which executes the step,
+    is left to the caller.
+
+    Args:
+      microbatches (sequence, optional): The inputs of the micro-batches,
+        required on the first stage.
+      targets (sequence, optional): The targets of the micro-batches, passed
+        to `loss_fn` on the last stage.
+      num_microbatches (int, optional): The number of micro-batches, required
+        on the stages which do not get `microbatches`.
+      schedule (list, optional): The `(action, microbatch)` pairs to run.
+        Default: `one_f_one_b_schedule()`.
+
+    Returns:
+      The losses of the micro-batches on the last stage, and an empty list on
+      the other stages.
+    """
+    if num_microbatches is None:
+      if microbatches is None:
+        raise ValueError('Either microbatches or num_microbatches is required')
+      num_microbatches = len(microbatches)
+    if self.is_first and microbatches is None:
+      raise ValueError('The first stage requires the microbatches')
+    if self.is_last and self.loss_fn is None:
+      raise ValueError('The last stage requires a loss_fn')
+    if schedule is None:
+      schedule = one_f_one_b_schedule(self.num_stages, self.stage,
+                                      num_microbatches)
+
+    received = {}
+    inputs = {}
+    outputs = {}
+    losses = [None] * num_microbatches
+
+    def prefetch(index):
+      # Issues the receive of the next action which needs one, ahead of the
+      # computation of the current action.
+      for action in schedule[index:]:
+        if self._needs_recv(action):
+          if action not in received:
+            received[action] = self._recv(*action)
+          return
+
+    for index, action in enumerate(schedule):
+      direction, microbatch = action
+      if self._needs_recv(action) and action not in received:
+        received[action] = self._recv(*action)
+      prefetch(index + 1)
+      if direction == FORWARD:
+        if self.is_first:
+          x = microbatches[microbatch]
+        else:
+          x = received.pop(action).detach().requires_grad_()
+        y = self.module(x)
+        inputs[microbatch] = x
+        if self.is_last:
+          target = None if targets is None else targets[microbatch]
+          y = self.loss_fn(y, target)
+          losses[microbatch] = y.detach()
+        else:
+          self._send(FORWARD, microbatch, y.detach())
+        outputs[microbatch] = y
+      else:
+        x = inputs.pop(microbatch)
+        y = outputs.pop(microbatch)
+        if self.is_last:
+          torch.autograd.backward(y)
+        else:
+          torch.autograd.backward(y, received.pop(action))
+        if not self.is_first:
+          self._send(BACKWARD, microbatch, x.grad)
+    return losses if self.is_last else []
@@ -1,6 +1,7 @@
 from .xla_sharded_tensor import XLAShard, XLAShardedTensor
 from .xla_sharding import (
-    Mesh, HybridMesh, ShardingType, ShardingSpec, XLAPatchedLinear,
+    Mesh, HybridMesh, ShardingType, ShardingSpec, MinibatchAssembler,
+    XLAPatchedLinear,
     mark_sharding, mark_sharding_with_gradients, clear_sharding, get_1d_mesh,
     wrap_if_sharded, xla_patched_nn_linear_forward, set_global_mesh,
     get_global_mesh, _mark_manual_sharding, enable_manual_sharding,
@@ -16,6 +17,7 @@ __all__ = [
     "HybridMesh",
     "ShardingType",
     "ShardingSpec",
+    "MinibatchAssembler",
     "XLAPatchedLinear",
     "MarkShardingFunction"
     "mark_sharding",
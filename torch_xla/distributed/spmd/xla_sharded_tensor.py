@@ -141,6 +141,26 @@ class XLAShardedTensor(DTensor):
         for (data, dev), (replica, indices) in zip(shard_dev, replica_ind)
     ]
 
+  # Returns the region of the global tensor selected by `indices`, a slice of
+  # step 1 for each of its leading dimensions, as a CPU tensor. Only the parts
+  # of the local shards which overlap the region are read, so this avoids
+  # replicating the whole tensor to read a small part of it.
+  def local_region(self, indices) -> torch.Tensor:
+    if not isinstance(indices, tuple):
+      indices = (indices,)
+    sizes = self.global_tensor.shape
+    assert len(indices) <= len(sizes), "Too many indices for the tensor"
+    starts, stops = [], []
+    for dim, size in enumerate(sizes):
+      index = indices[dim] if dim < len(indices) else slice(None)
+      assert isinstance(index, slice), f"Unsupported index {index}"
+      start, stop, step = index.indices(size)
+      assert step == 1, "Only slices of step 1 are supported"
+      starts.append(start)
+      stops.append(max(start, stop))
+    return torch_xla._XLAC._get_local_shards_region(self.global_tensor, starts,
+                                                    stops)
+
   # Load the given list of local shards into the underlying tensor's data
   # on the local devices.
   def load_local_shards_(self, shards: List[XLAShard]):
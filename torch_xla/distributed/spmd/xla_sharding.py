@@ -953,6 +953,51 @@ class ShardingSpec:
     mark_sharding(t, self.mesh, self.partition_spec)
 
 
+class MinibatchAssembler:
+  """
+  Assembles a global batch, sharded along its batch dimension like a
+  `minibatch` ShardingSpec, out of the slices a host produces for each of its
+  local devices. Every slice is uploaded to its device as soon as it is added,
+  which may happen from the data loader's worker threads, so the host never
+  concatenates its local batch.
+
+  Args:
+    mesh (Mesh): the mesh of the sharding.
+    partition_spec (Tuple, Tuple[int, str], or None): the sharding of the
+      global batch, with its batch dimension sharded across the mesh.
+    local_batch_shape (Tuple[int]): the shape of the host's part of the batch,
+      the concatenation of the slices of its local devices.
+    dtype (torch.dtype): the type of the slices.
+
+  Example:
+    assembler = MinibatchAssembler(mesh, ('data', None), (64, 128),
+                                   torch.float32)
+    for i, device_slice in enumerate(slices):
+      assembler.add_shard(i, device_slice)
+    batch = assembler.finish()
+  """
+
+  def __init__(self, mesh: Mesh, partition_spec: PartitionSpec,
+               local_batch_shape: tuple[int, ...], dtype: torch.dtype):
+    spec = ShardingSpec(mesh, partition_spec, minibatch=True)
+    local_batch = torch.empty(local_batch_shape, dtype=dtype, device='meta')
+    xla_spec = spec.xla_spec(local_batch)
+    assert xla_spec is not None, (
+        f"Partition spec {partition_spec} does not apply to the batch")
+    self._assembler = torch_xla._XLAC.ShardedBatchAssembler(xla_spec)
+
+  def add_shard(self, index: int, shard: torch.Tensor):
+    """
+    Uploads the CPU slice of the `index`th local device, in the order of
+    `torch_xla.runtime.local_runtime_devices()`.
+    """
+    self._assembler.add_shard(index, shard)
+
+  def finish(self) -> XLAShardedTensor:
+    """Returns the global batch, once every local device has its slice."""
+    return XLAShardedTensor(self._assembler.finish())
+
+
 ### Linear layer implementation backed by einsum.
 
 
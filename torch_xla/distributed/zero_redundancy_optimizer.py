@@ -56,6 +56,13 @@ class ZeroRedundancyOptimizer(Optimizer):
             if ``True``, also save sharded master weights. Default: False
         higher_cc_precision (bool, Optional): if ``True``, use higher precision for collective communication
             operators (the same as ``optimizer_dtype``). Default: False
+        fused_step (bool, Optional): if ``True`` and the local optimizer is
+            ``torch.optim.SGD``, ``torch.optim.Adam`` or ``torch.optim.AdamW``,
+            the reduce-scatter, the grad clipping, the update and the
+            all-gather of each parameter group run as a single IR op, which
+            XLA schedules and overlaps as a unit. The steps which the fused
+            op does not support, e.g. with amsgrad, a ``sharding_scheme`` or
+            ``grad_norm_groups``, fall back to the separate ops. Default: False
         **defaults: any trailing arguments, which are forwarded to the local
             optimizer.
 
@@ -81,6 +88,7 @@ class ZeroRedundancyOptimizer(Optimizer):
       use_grad_acc_hook: bool = False,
       save_master_weights: bool = False,
       higher_cc_precision: bool = False,
+      fused_step: bool = False,
       **defaults: Any,
   ):
     if not save_master_weights:
@@ -109,6 +117,7 @@ class ZeroRedundancyOptimizer(Optimizer):
     self.save_master_weights = save_master_weights
     self.higher_cc_precision = higher_cc_precision
     self.use_grad_acc_hook = use_grad_acc_hook
+    self.fused_step = fused_step
     self.grad_accs = []
     self.grad_acc_hooks = []
 
@@ -427,6 +436,10 @@ class ZeroRedundancyOptimizer(Optimizer):
       with torch.enable_grad():
         loss = closure()
 
+    if self._can_fuse_step(kwargs):
+      self._fused_step()
+      return loss
+
     self._reduce_gradients(**kwargs)
 
     if self.grad_clipping:
@@ -437,6 +450,94 @@ class ZeroRedundancyOptimizer(Optimizer):
 
     return loss
 
+  def _can_fuse_step(self, kwargs):
+    if not self.fused_step or kwargs:
+      return False
+    if self.optimizer_class not in (torch.optim.SGD, torch.optim.Adam,
+                                    torch.optim.AdamW):
+      return False
+    if self.grad_clipping and (self._grad_norm_groups is not None or
+                               len(self.param_groups) > 1):
+      # The grad norm spans all the parameter groups, or other groups.
+      return False
+    for group in self.base_optimizer.param_groups:
+      if group.get('amsgrad', False) or group.get('differentiable', False):
+        return False
+    return True
+
+  def _get_step_grads(self, param_group, sharded_param_group):
+    """
+    Returns the padded full gradients of the parameters with one, and their
+    parameters and shards.
+    """
+    grads, params, shards = [], [], []
+    for param, shard in zip(param_group['params'],
+                            sharded_param_group['params']):
+      if param.grad is not None or (self.use_grad_acc_hook and
+                                    hasattr(shard, 'main_grad')):
+        grad = shard.main_grad if self.use_grad_acc_hook else param.grad
+        grad = self._pad_to_world_size(grad, self.local_world_size)
+        if self.higher_cc_precision:
+          grad = grad.to(dtype=self.optimizer_dtype)
+        grads.append(grad)
+        params.append(param)
+        shards.append(shard)
+    return grads, params, shards
+
+  def _get_shard_state(self, shard, names):
+    state = self.base_optimizer.state[shard]
+    if 'step' not in state:
+      state['step'] = torch.zeros([], dtype=shard.dtype, device=self.device)
+    elif not isinstance(state['step'], torch.Tensor) or \
+        state['step'].device != self.device or \
+        state['step'].dtype != shard.dtype:
+      state['step'] = torch.tensor(
+          float(state['step']), dtype=shard.dtype, device=self.device)
+    for name in names:
+      if state.get(name) is None:
+        state[name] = torch.zeros_like(
+            shard, memory_format=torch.preserve_format)
+    return [state['step']] + [state[name] for name in names]
+
+  @torch.no_grad()
+  def _fused_step(self):
+    """
+    Runs the step of each parameter group as a single ZeRO optimizer step op.
+    """
+    self._sync_param_groups(self.param_groups, self.base_optimizer.param_groups)
+    max_norm = float(self.max_norm) if self.grad_clipping else None
+    for param_group, sharded_param_group in zip(
+        self.param_groups, self.base_optimizer.param_groups):
+      grads, params, shards = self._get_step_grads(param_group,
+                                                   sharded_param_group)
+      if not grads:
+        continue
+      collective_args = (1.0 / self.local_world_size, self.local_world_size,
+                         self.sharding_groups, self.pin_layout, max_norm)
+      group = sharded_param_group
+      if self.optimizer_class is torch.optim.SGD:
+        states = [self._get_shard_state(s, ['momentum_buffer']) for s in shards]
+        gathered, grad_norm = torch_xla._XLAC._xla_zero_sgd_optimizer_step_(
+            grads, shards, [s[0] for s in states], [s[1] for s in states],
+            group['weight_decay'], group['momentum'], float(group['lr']),
+            group['dampening'], group['nesterov'], group['maximize'],
+            *collective_args)
+      else:
+        states = [
+            self._get_shard_state(s, ['exp_avg', 'exp_avg_sq']) for s in shards
+        ]
+        beta1, beta2 = group['betas']
+        gathered, grad_norm = torch_xla._XLAC._xla_zero_adam_optimizer_step_(
+            grads, shards, [s[0] for s in states], [s[1] for s in states],
+            [s[2] for s in states], beta1, beta2, float(group['lr']),
+            group['weight_decay'], group['eps'], group['maximize'],
+            self.optimizer_class is torch.optim.AdamW, *collective_args)
+      if grad_norm is not None:
+        self._grad_norm = grad_norm
+      for param, padded_param in zip(params, gathered):
+        param.data.copy_(padded_param.data[:param.size(0)])
+    self._sync_param_groups(self.base_optimizer.param_groups, self.param_groups)
+
   def allgather_weights_and_update_full_parameter(self, sharding_scheme=None):
 
     # All gather the new weights across the ranks and assign them to the full parameters
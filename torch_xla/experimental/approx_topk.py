@@ -0,0 +1,66 @@
+"""Approximate top-k, lowered to the XLA ApproxTopK.
+
+The exact top-k sorts, or partially sorts, the whole reduced dimension, which
+dominates retrieval and MoE routing over large candidate sets on TPU. The
+approximate top-k of XLA reduces the dimension in bins with the TPU's partial
+reduction, and only sorts the candidates of the bins, with the number of bins
+chosen so that every top-k element is found with a probability of at least
+the recall target. On the other devices it falls back to the exact sort.
+
+`approx_topk` runs it explicitly, and the `approx_topk_mode` context replaces
+the `torch.topk` traced in it.
+"""
+
+from contextlib import contextmanager
+from typing import Optional, Tuple
+
+import torch
+
+import torch_xla
+
+DEFAULT_RECALL_TARGET = 0.95
+
+
+def approx_topk(input: torch.Tensor,
+                k: int,
+                dim: int = -1,
+                largest: bool = True,
+                recall_target: float = DEFAULT_RECALL_TARGET
+               ) -> Tuple[torch.Tensor, torch.Tensor]:
+  """Returns the approximate `k` largest, or smallest, elements of `input`.
+
+  Args:
+    input: the XLA tensor.
+    k: the number of elements returned.
+    dim: the reduced dimension.
+    largest: whether the largest or the smallest elements are returned.
+    recall_target: the expected fraction of the exact top-k elements which are
+      returned, in (0, 1].
+
+  Returns:
+    The values and the LongTensor indices of the elements, sorted, as
+    `torch.topk` returns them.
+  """
+  return torch_xla._XLAC._xla_approx_topk(input, k, dim, largest,
+                                          recall_target)
+
+
+def get_topk_recall_target() -> Optional[float]:
+  """Returns the recall target of the `torch.topk` being traced, if approximate.
+  """
+  return torch_xla._XLAC._get_topk_recall_target()
+
+
+@contextmanager
+def approx_topk_mode(recall_target: float = DEFAULT_RECALL_TARGET):
+  """Context manager tracing the `torch.topk` of XLA tensors as `approx_topk`.
+
+  The `sorted` argument of `torch.topk` is ignored, since the approximate
+  top-k is always sorted.
+  """
+  saved_recall_target = get_topk_recall_target()
+  torch_xla._XLAC._set_topk_recall_target(recall_target)
+  try:
+    yield
+  finally:
+    torch_xla._XLAC._set_topk_recall_target(saved_recall_target)
@@ -0,0 +1,95 @@
+"""Inclusive scans with an arbitrary associative combining function.
+
+Reference:
+https://jax.readthedocs.io/en/latest/_autosummary/jax.lax.associative_scan.html
+
+`scan` runs `fn` once per step, in a loop of N iterations. When `fn` is
+associative, like the composition of the linear recurrences of linear
+attention and state-space models, the scan can instead combine the pairs of
+elements and recurse on the N / 2 combined pairs, which takes O(N)
+applications of `fn` in O(log N) levels of slices, each of them vectorized
+over all the elements of its level.
+
+This is the same algorithm as the lowering of cumsum, cumprod and cummax over
+long dimensions (see $XLA_ASSOCIATIVE_SCAN_MIN_SIZE), with a function of torch
+operations in place of the XLA combiner, so the result is differentiable.
+"""
+
+from typing import Callable, TypeVar
+
+import torch
+from torch.utils._pytree import tree_flatten, tree_unflatten
+
+Elems = TypeVar('Elems')
+
+
+def _slice(tensors, start, stop, step, dim):
+  slices = [slice(None)] * tensors[0].dim()
+  slices[dim] = slice(start, stop, step)
+  return [t[tuple(slices)] for t in tensors]
+
+
+def _scan(combine, tensors, dim):
+  size = tensors[0].size(dim)
+  if size < 2:
+    return tensors
+  num_odd = size // 2
+  num_even = size - num_odd
+  odd = _scan(
+      combine,
+      combine(
+          _slice(tensors, 0, size - 1, 2, dim),
+          _slice(tensors, 1, None, 2, dim)), dim)
+  even = _slice(tensors, 0, 1, 1, dim)
+  if num_even > 1:
+    rest = combine(
+        _slice(odd, 0, num_even - 1, 1, dim), _slice(tensors, 2, None, 2, dim))
+    even = [torch.cat([e, r], dim=dim) for e, r in zip(even, rest)]
+  outputs = []
+  for e, o in zip(even, odd):
+    if num_odd < num_even:
+      o = torch.cat([o, torch.zeros_like(e.narrow(dim, 0, 1))], dim=dim)
+    pairs = torch.stack([e, o], dim=dim + 1)
+    outputs.append(pairs.flatten(dim, dim + 1).narrow(dim, 0, size))
+  return outputs
+
+
+def associative_scan(fn: Callable[[Elems, Elems], Elems],
+                     elems: Elems,
+                     dim: int = 0) -> Elems:
+  """Computes the inclusive scan of `elems` in `dim` with `fn`.
+
+  Args:
+    fn: the associative function combining two PyTrees of the structure of
+      `elems`, element-wise: `fn(a, b)` combines the elements `a` with the
+      elements `b` which follow them, and is called on slices of `elems` of any
+      size in `dim`.
+    elems: a tensor, or a PyTree of tensors of the same size in `dim`.
+    dim: the scanned dimension.
+
+  Returns:
+    The PyTree of the structure of `elems` whose element i in `dim` is the
+    combination of the elements 0 to i of `elems`.
+
+  Example:
+
+    >>> # The linear recurrence h[t] = a[t] * h[t - 1] + b[t].
+    >>> def compose(lhs, rhs):
+    ...   return rhs[0] * lhs[0], rhs[0] * lhs[1] + rhs[1]
+    >>> _, h = associative_scan(compose, (a, b))
+  """
+  tensors, spec = tree_flatten(elems)
+  if not tensors:
+    raise ValueError('elems must contain at least one tensor')
+  dim = dim % tensors[0].dim()
+  if any(t.size(dim) != tensors[0].size(dim) for t in tensors):
+    raise ValueError(f'The tensors of elems must have the same size in {dim}')
+
+  def combine(lhs, rhs):
+    combined, combined_spec = tree_flatten(
+        fn(tree_unflatten(lhs, spec), tree_unflatten(rhs, spec)))
+    if combined_spec != spec:
+      raise ValueError('fn must return a PyTree of the structure of elems')
+    return combined
+
+  return tree_unflatten(_scan(combine, tensors, dim), spec)
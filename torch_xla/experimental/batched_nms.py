@@ -0,0 +1,52 @@
+"""Non-maximum suppression of a batch of images, in a single computation.
+
+Detection post-processing usually runs `torchvision.ops.batched_nms` once per
+image, and every call traces a graph of its own, whose output has the
+dynamic number of kept boxes of that image.
+
+`batched_nms` takes the boxes of every image at once, padded to the same
+number of boxes, and lowers to one sort, one [B, N, N] IoU mask and one loop
+over the ranks of the boxes shared by all images. Its outputs have static
+shapes, so that the same graph serves every batch.
+"""
+
+from typing import Tuple
+
+import torch
+
+import torch_xla
+
+
+def batched_nms(boxes: torch.Tensor,
+                scores: torch.Tensor,
+                classes: torch.Tensor,
+                iou_threshold: float,
+                max_output_size: int,
+                score_threshold: float = float('-inf')
+               ) -> Tuple[torch.Tensor, torch.Tensor]:
+  """Runs `torchvision.ops.batched_nms` on every image of a batch.
+
+  Args:
+    boxes: the boxes, of shape [B, N, 4], in (x1, y1, x2, y2) format.
+    scores: the scores of the boxes, of shape [B, N].
+    classes: the class of every box, of shape [B, N]. A box only suppresses
+      the boxes of its own class.
+    iou_threshold: the boxes whose IoU with a kept box of higher score is
+      above it are discarded.
+    max_output_size: the number of indices returned for every image.
+    score_threshold: the boxes whose score is not above it are discarded. The
+      padding boxes of an image can be dropped by giving them a score of
+      -inf.
+
+  Returns:
+    The LongTensor of shape [B, max_output_size] of the indices of the kept
+    boxes of every image, by decreasing score, padded with -1, and the
+    LongTensor of shape [B] of the numbers of kept boxes.
+  """
+  if boxes.dim() != 3 or boxes.size(2) != 4:
+    raise ValueError(f'boxes should be of shape [B, N, 4], got {boxes.shape}')
+  if scores.shape != boxes.shape[:2] or classes.shape != scores.shape:
+    raise ValueError('scores and classes should be of shape [B, N]')
+  return torch_xla._XLAC._xla_batched_nms(boxes, scores, classes,
+                                          iou_threshold, score_threshold,
+                                          max_output_size)
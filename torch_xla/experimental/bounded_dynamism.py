@@ -0,0 +1,55 @@
+"""Data dependent ops with a bounded, static output shape.
+
+The aten `nonzero` and `masked_select` return a tensor whose size depends on
+the data, which either transfers the size from the device to materialize it,
+or gives the graph a dynamic dimension which every later op has to carry. The
+versions here return the output padded to its upper bound, the number of
+elements of the input, along with the number of valid entries as a device
+tensor, so that the graph keeps static shapes and runs without a host sync.
+
+The padding is zero, so the padded indices of `nonzero` stay valid for a
+gather, and `padding_mask` masks the padding out of a reduction.
+"""
+
+from typing import Tuple
+
+import torch
+
+import torch_xla
+
+
+def nonzero(input: torch.Tensor) -> Tuple[torch.Tensor, torch.Tensor]:
+  """Returns the indices of the non zero elements of `input`, padded.
+
+  Args:
+    input: the XLA tensor.
+
+  Returns:
+    The LongTensor indices, of shape `(input.numel(), input.dim())`, whose
+    first `count` rows are the rows `torch.nonzero` returns and the rest zero,
+    and the scalar LongTensor `count`.
+  """
+  return torch_xla._XLAC._xla_bounded_nonzero(input)
+
+
+def masked_select(input: torch.Tensor,
+                  mask: torch.Tensor) -> Tuple[torch.Tensor, torch.Tensor]:
+  """Returns the elements of `input` where `mask` is true, padded.
+
+  Args:
+    input: the XLA tensor.
+    mask: the boolean XLA tensor, broadcastable to `input`.
+
+  Returns:
+    The tensor of shape `(input.numel(),)`, whose first `count` elements are
+    the elements `torch.masked_select` returns and the rest zero, and the
+    scalar LongTensor `count`.
+  """
+  if mask.shape != input.shape:
+    input, mask = torch.broadcast_tensors(input, mask)
+  return torch_xla._XLAC._xla_bounded_masked_select(input, mask)
+
+
+def padding_mask(count: torch.Tensor, length: int) -> torch.Tensor:
+  """Returns the boolean tensor of `length` which is true below `count`."""
+  return torch.arange(length, device=count.device) < count
@@ -0,0 +1,73 @@
+"""Cross-entropy over very large vocabularies, computed chunk by chunk.
+
+`log_softmax` followed by `nll_loss` materializes the log-probabilities of
+every token and class, in full precision, in the forward pass and again in the
+backward pass. With a vocabulary of a few hundred thousand classes this takes
+several GB of device memory.
+
+`chunked_cross_entropy` lowers to a loop over chunks of the classes, which
+keeps an online log-sum-exp of every row and the logit of its target. Only the
+losses and the log-sum-exps are saved for the backward pass, which recomputes
+the softmax of a chunk at a time and writes it into the gradient of the
+logits, in their own dtype.
+"""
+
+import torch
+
+import torch_xla
+
+# The number of classes read per iteration of the loops.
+DEFAULT_CHUNK_SIZE = 8192
+
+
+class _ChunkedCrossEntropy(torch.autograd.Function):
+
+  @staticmethod
+  def forward(ctx, logits, target, chunk_size, ignore_index):
+    losses, lse = torch_xla._XLAC._xla_chunked_cross_entropy(
+        logits, target, chunk_size, ignore_index)
+    ctx.chunk_size = chunk_size
+    ctx.ignore_index = ignore_index
+    ctx.save_for_backward(logits, target, lse)
+    ctx.mark_non_differentiable(lse)
+    return losses, lse
+
+  @staticmethod
+  def backward(ctx, grad_losses, grad_lse):
+    logits, target, lse = ctx.saved_tensors
+    grad_logits = torch_xla._XLAC._xla_chunked_cross_entropy_backward(
+        grad_losses.contiguous(), logits, target, lse, ctx.chunk_size,
+        ctx.ignore_index)
+    return grad_logits, None, None, None
+
+
+def chunked_cross_entropy(input: torch.Tensor,
+                          target: torch.Tensor,
+                          ignore_index: int = -100,
+                          reduction: str = 'mean',
+                          chunk_size: int = DEFAULT_CHUNK_SIZE) -> torch.Tensor:
+  """Computes `torch.nn.functional.cross_entropy` of class indices.
+
+  Args:
+    input: the logits, of shape [..., C].
+    target: the class indices, of the shape of `input` without its last
+      dimension.
+    ignore_index: the target of the rows which do not count in the loss.
+    reduction: 'none', 'sum' or 'mean', as in `cross_entropy`. The mean is
+      taken over the rows which are not ignored.
+    chunk_size: the number of classes read at a time.
+
+  Returns:
+    The loss, of the shape of `target` with 'none' and a scalar otherwise.
+  """
+  if reduction not in ('none', 'sum', 'mean'):
+    raise ValueError(f'Invalid reduction: {reduction}')
+  losses, _ = _ChunkedCrossEntropy.apply(
+      input.reshape(-1, input.shape[-1]), target.reshape(-1), chunk_size,
+      ignore_index)
+  if reduction == 'none':
+    return losses.reshape(target.shape)
+  if reduction == 'sum':
+    return losses.sum()
+  count = (target != ignore_index).sum()
+  return losses.sum() / count.to(losses.dtype)
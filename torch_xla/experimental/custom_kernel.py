@@ -204,7 +204,9 @@ def to_jax_shape_dtype_struct(tensor: torch.Tensor) -> "jax.ShapeDtypeStruct":
                               convert_torch_dtype_to_jax(tensor.dtype))
 
 
-trace_pallas_arg_to_payload: Dict[Tuple[Any], str] = {}
+# Maps the traced arguments to the ID of the kernel registered for them, which
+# _xla_tpu_custom_call takes in place of the payload.
+trace_pallas_arg_to_payload: Dict[Tuple[Any], int] = {}
 
 
 @requires_jax
@@ -251,7 +253,9 @@ def trace_pallas(kernel: Callable,
   payload = _extract_backend_config(ir)
 
   if use_cache:
-    # if we reach here it means we have a cache miss.
+    # if we reach here it means we have a cache miss. The payload is registered
+    # once, so the calls do not pass it again.
+    payload = torch_xla._XLAC._xla_register_tpu_kernel(payload)
     trace_pallas_arg_to_payload[hash_key] = payload
 
   return payload, tensor_args
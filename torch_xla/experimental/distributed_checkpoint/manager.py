@@ -3,6 +3,7 @@ import logging
 import os
 import pickle
 import threading
+import torch
 import torch.distributed as dist
 import torch.distributed.checkpoint as dist_cp
 import torch_xla
@@ -19,7 +20,8 @@ from os.path import basename
 from concurrent.futures import ThreadPoolExecutor, wait
 from typing import Deque, List, Optional, Union
 from torch.distributed.checkpoint.metadata import STATE_DICT_TYPE
-from ._helpers import _sharded_cpu_state_dict
+from torch.utils._pytree import tree_flatten
+from ._helpers import _sharded_cpu_state_dict, _unwrap_xla_sharded_tensor
 
 # TODO(jonbolin): Import path will change
 from torch.distributed.checkpoint._fsspec_filesystem import FsspecReader, FsspecWriter
@@ -102,6 +104,10 @@ class CheckpointManager:
   # Whether a checkpoint should be taken when a preemption is detected.
   chkpt_on_preemption: bool
 
+  # Local directory to write an emergency snapshot into when a preemption is
+  # detected, ahead of the regular checkpoint.
+  snapshot_path: Optional[str]
+
   def __init__(self,
                path: str,
                save_interval: int,
@@ -109,7 +115,8 @@ class CheckpointManager:
                max_pending_async: Optional[int] = 1,
                num_of_threads: Optional[int] = 1,
                process_group: dist.ProcessGroup = None,
-               chkpt_on_preemption: bool = True):
+               chkpt_on_preemption: bool = True,
+               snapshot_path: Optional[str] = None):
     """
     Create a checkpoint manager that reads and writes checkpoints into
     the provided directory.
@@ -136,6 +143,14 @@ class CheckpointManager:
       chkpt_on_preemption: Whether or not to take a checkpoint when a
             preemption has been detected.
             Default: True
+      snapshot_path: A local directory to write an emergency snapshot of the
+            state_dict into when a preemption has been detected, before the
+            checkpoint is taken. The snapshot starts the device to host
+            transfers of all the tensors at once and writes them to a local
+            file, so that it completes within the preemption notice window
+            even if the checkpoint does not. Restore it with
+            `restore_snapshot`.
+            Default: None, in which case no snapshot is written.
     """
     assert dist.is_initialized(), "A process group is required."
     assert save_interval > 0, "save_interval must be positive"
@@ -147,6 +162,9 @@ class CheckpointManager:
     self.max_to_keep = max_to_keep
     self.num_of_threads = num_of_threads
     self.chkpt_on_preemption = chkpt_on_preemption
+    self.snapshot_path = snapshot_path
+    # The last step at which a preemption was detected.
+    self._preemption_step = None
 
     # Create a new group if none is provided
     self.pg = process_group or dist.new_group()
@@ -256,8 +274,64 @@ class CheckpointManager:
           f"Preemption sync point reached at step {step}. Triggering a checkpoint."
       )
       preemption_detected = True
+      self._preemption_step = step
     return step % self.save_interval == 0 or preemption_detected
 
+  def _get_snapshot_file(self, step: int) -> str:
+    return os.path.join(self.snapshot_path, str(step),
+                        f'{xr.process_index()}.snapshot')
+
+  def _maybe_write_snapshot(self, step: int, state_dict: STATE_DICT_TYPE):
+    """
+    Writes an emergency snapshot of the tensors of `state_dict` if a preemption
+    was detected at `step`.
+    """
+    if self.snapshot_path is None or self._preemption_step != step:
+      return
+    flat, _ = tree_flatten(state_dict)
+    tensors = [
+        _unwrap_xla_sharded_tensor(x)
+        for x in flat
+        if isinstance(x, torch.Tensor)
+    ]
+    path = self._get_snapshot_file(step)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    torch_xla._XLAC._xla_write_snapshot(tensors, path)
+    logging.warning(f'Emergency snapshot of step {step} written to {path}.')
+
+  def restore_snapshot(self, state_dict: STATE_DICT_TYPE) -> Optional[int]:
+    """
+    Restores the latest emergency snapshot of this process into `state_dict`.
+    The tensors of `state_dict` are updated in-place, and must have the
+    structure of the state_dict the snapshot was taken from.
+
+    Returns:
+      The step of the restored snapshot, or None if there is no snapshot.
+    """
+    if self.snapshot_path is None or not os.path.isdir(self.snapshot_path):
+      return None
+    steps = [
+        int(x) for x in os.listdir(self.snapshot_path) if x.isdigit() and
+        os.path.exists(self._get_snapshot_file(int(x)))
+    ]
+    if not steps:
+      return None
+    step = max(steps)
+    values = torch_xla._XLAC._xla_read_snapshot(self._get_snapshot_file(step))
+    flat, _ = tree_flatten(state_dict)
+    tensors = [
+        _unwrap_xla_sharded_tensor(x)
+        for x in flat
+        if isinstance(x, torch.Tensor)
+    ]
+    assert len(tensors) == len(values), (
+        f'The snapshot of step {step} holds {len(values)} tensors, but the '
+        f'state_dict has {len(tensors)}')
+    with torch.no_grad():
+      for tensor, value in zip(tensors, values):
+        tensor.copy_(value.to(tensor.dtype))
+    return step
+
   def save(self,
            step,
            state_dict: STATE_DICT_TYPE,
@@ -275,6 +349,7 @@ class CheckpointManager:
     """
     if self.should_save(step) or force:
       self._wait_for_data()
+      self._maybe_write_snapshot(step, state_dict)
       self._save(step, state_dict)
       return True
     return False
@@ -304,6 +379,7 @@ class CheckpointManager:
     """
     if self.should_save(step) or force:
       self._wait_for_data()
+      self._maybe_write_snapshot(step, state_dict)
       # Move the state_dict to CPU
       cpu_state_dict = _sharded_cpu_state_dict(state_dict)
       self._async_sem.acquire()
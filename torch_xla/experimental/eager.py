@@ -1,6 +1,8 @@
 import functools
 from contextlib import contextmanager
+from typing import Callable, Sequence
 
+import torch
 import torch_xla
 import logging
 
@@ -30,3 +32,43 @@ def eager_mode_context(enable: bool):
     yield saved_eager_mode
   finally:
     eager_mode(saved_eager_mode)
+
+
+@contextmanager
+def eager_warm_up():
+  """Context manager compiling the eager ops run within it, without executing
+  them.
+
+  The executables land in the compilation cache, and in the persistent cache
+  when one is set with `torch_xla.runtime.initialize_cache`, so that later
+  eager runs over the same shapes and dtypes do not compile. The results of
+  the ops within the context are placeholders and must not be read.
+  """
+  saved_eager_warm_up = torch_xla._XLAC._get_eager_warm_up()
+  torch_xla._XLAC._set_eager_warm_up(True)
+  try:
+    yield
+  finally:
+    torch_xla._XLAC._set_eager_warm_up(saved_eager_warm_up)
+
+
+def warm_up_eager_ops(fn: Callable,
+                      input_shapes: Sequence[Sequence[Sequence[int]]],
+                      dtype: torch.dtype = torch.float32,
+                      device=None):
+  """Compiles the eager ops of `fn` for every set of input shapes.
+
+  Args:
+    fn: the function whose eager ops are compiled, called with one tensor per
+      shape of a set.
+    input_shapes: the sets of shapes of the inputs of `fn`, for example the
+      buckets its inputs are padded to.
+    dtype: the dtype of the inputs.
+    device: the device of the inputs, the current one by default.
+  """
+  assert is_eager_mode(), 'warm_up_eager_ops() requires the eager mode'
+  device = device or torch_xla.device()
+  for shapes in input_shapes:
+    inputs = [torch.zeros(shape, dtype=dtype).to(device) for shape in shapes]
+    with eager_warm_up():
+      fn(*inputs)
@@ -0,0 +1,143 @@
+"""FP8 matmuls with delayed scaling, for FP8 training.
+
+An FP8 matmul casts its operands to F8E4M3FN or F8E5M2 after scaling them
+into the range of the FP8 type. With delayed scaling, the scale of an operand
+comes from the absolute maximums of its last few values, its amax history,
+rather than from the operand itself, so that the cast does not wait for a
+reduction over the operand. `fp8_dot` carries the scales and the amax
+histories as device tensors, and updates them in the graph of the product,
+so that no step syncs with the host to rescale.
+
+`Fp8Linear` is the `torch.nn.Linear` running its forward and backward
+matmuls in FP8, the activations and the weight in F8E4M3FN and the gradients
+in F8E5M2, each matmul operand with its own scaling state.
+"""
+
+import torch
+
+import torch_xla
+
+DEFAULT_AMAX_HISTORY_LEN = 16
+
+
+def fp8_dot(lhs: torch.Tensor,
+            rhs: torch.Tensor,
+            lhs_scale: torch.Tensor,
+            rhs_scale: torch.Tensor,
+            lhs_amax_history: torch.Tensor,
+            rhs_amax_history: torch.Tensor,
+            lhs_dtype: torch.dtype = torch.float8_e4m3fn,
+            rhs_dtype: torch.dtype = torch.float8_e4m3fn,
+            rhs_contracting_dim: int = 1,
+            margin: int = 0) -> torch.Tensor:
+  """Multiplies `lhs` by `rhs` in FP8, with delayed scaling.
+
+  Args:
+    lhs: the [..., K] XLA tensor, contracted on its last dimension.
+    rhs: the 2D XLA tensor, contracted on `rhs_contracting_dim`.
+    lhs_scale, rhs_scale: the scalar scales of the operands, which multiply
+      them before the FP8 casts. Updated in place.
+    lhs_amax_history, rhs_amax_history: the 1D histories of the absolute
+      maximums of the operands, the latest first. Updated in place.
+    lhs_dtype, rhs_dtype: the FP8 types of the operands.
+    rhs_contracting_dim: the contracted dimension of `rhs`, 1 for the
+      [N, K] weight of a linear layer.
+    margin: the power of two by which the scales keep the operands below the
+      largest value of their FP8 types.
+
+  Returns:
+    The product, of the dtype of `lhs`.
+  """
+  return torch_xla._XLAC._xla_fp8_dot(lhs, rhs, lhs_scale, rhs_scale,
+                                      lhs_amax_history, rhs_amax_history,
+                                      lhs_dtype, rhs_dtype,
+                                      rhs_contracting_dim, margin)
+
+
+# The operands of the matmuls of an FP8 linear layer: the activations and the
+# weight of the forward, the gradient and the weight of the input gradient,
+# and the gradient and the activations of the weight gradient.
+_SCALING_STATES = ('x', 'w', 'grad', 'w_t', 'grad_t', 'x_t')
+
+
+class _Fp8Linear(torch.autograd.Function):
+
+  @staticmethod
+  def forward(ctx, x, weight, states, margin):
+    ctx.states = states
+    ctx.margin = margin
+    ctx.save_for_backward(x, weight)
+    return fp8_dot(x, weight, states['x'][0], states['w'][0], states['x'][1],
+                   states['w'][1], margin=margin)
+
+  @staticmethod
+  def backward(ctx, grad_output):
+    x, weight = ctx.saved_tensors
+    states = ctx.states
+    grad_output = grad_output.contiguous()
+    # [..., N] x [N, K]
+    grad_x = fp8_dot(
+        grad_output,
+        weight,
+        states['grad'][0],
+        states['w_t'][0],
+        states['grad'][1],
+        states['w_t'][1],
+        lhs_dtype=torch.float8_e5m2,
+        rhs_contracting_dim=0,
+        margin=ctx.margin)
+    # [N, M] x [M, K]
+    grad_weight = fp8_dot(
+        grad_output.reshape(-1, grad_output.shape[-1]).t(),
+        x.reshape(-1, x.shape[-1]),
+        states['grad_t'][0],
+        states['x_t'][0],
+        states['grad_t'][1],
+        states['x_t'][1],
+        lhs_dtype=torch.float8_e5m2,
+        rhs_contracting_dim=0,
+        margin=ctx.margin)
+    return grad_x, grad_weight.to(weight.dtype), None, None
+
+
+class Fp8Linear(torch.nn.Linear):
+  """`torch.nn.Linear` with its matmuls in FP8, with delayed scaling.
+
+  The scales and the amax histories are buffers of the module, so they move
+  with it to the XLA device and are saved in its state dict.
+
+  Args:
+    in_features, out_features, bias, device, dtype: as in `torch.nn.Linear`.
+    amax_history_len: the number of steps over which the amax of each matmul
+      operand is tracked.
+    margin: the power of two by which the scales keep the operands below the
+      largest value of their FP8 types.
+  """
+
+  def __init__(self,
+               in_features: int,
+               out_features: int,
+               bias: bool = True,
+               device=None,
+               dtype=None,
+               amax_history_len: int = DEFAULT_AMAX_HISTORY_LEN,
+               margin: int = 0):
+    super().__init__(in_features, out_features, bias, device, dtype)
+    self.margin = margin
+    for name in _SCALING_STATES:
+      self.register_buffer(f'{name}_scale',
+                           torch.ones([], dtype=torch.float32, device=device))
+      self.register_buffer(
+          f'{name}_amax_history',
+          torch.zeros([amax_history_len], dtype=torch.float32, device=device))
+
+  def forward(self, input: torch.Tensor) -> torch.Tensor:
+    states = {
+        name: (getattr(self, f'{name}_scale'),
+               getattr(self, f'{name}_amax_history'))
+        for name in _SCALING_STATES
+    }
+    output = _Fp8Linear.apply(input, self.weight, states, self.margin)
+    if self.bias is not None:
+      output = output + self.bias
+    return output
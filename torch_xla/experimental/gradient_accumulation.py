@@ -143,6 +143,10 @@ class XlaBuildHelper:
 
 
 def _make_init_grad(param):
+  if param.grad is not None:
+    # Accumulate into the existing gradient, which the loop carries in place of
+    # a fresh buffer, so that it is not held alongside the loop gradients.
+    return param.grad
   grad = torch.zeros_like(param, device=param.device, requires_grad=False)
   param_sharding = torch_xla._XLAC._get_xla_op_sharding(param)
   if param_sharding:
@@ -329,12 +333,13 @@ def _gradient_accumulation(accumulation_steps, train_step, iterable_tensors,
   params_with_grad = [
       param for param in model_parameters if param.requires_grad
   ]
-  # Accumulate the resulting gradients.
+  # The loop accumulated into the existing gradients, if any, which are updated
+  # in place so that their buffers can be donated to the loop results.
   for param, grad in zip(params_with_grad, grads):
     if param.grad is None:
       param.grad = grad
     else:
-      param.grad.add_(grad)
+      param.grad.copy_(grad)
 
   if not carried_tensors:
     return loss
@@ -0,0 +1,80 @@
+from typing import Any, Callable, List, Sequence, Tuple
+
+import torch
+import torch.utils._pytree as pytree
+import torch_xla
+
+
+def _sync_pending_inputs(inputs: Sequence[torch.Tensor]):
+  pending = [
+      t for t, need_sync in zip(
+          inputs, torch_xla._XLAC._check_tensor_need_materialization(inputs))
+      if need_sync
+  ]
+  if pending:
+    torch_xla._XLAC._xla_sync_multi(pending, devices=[], wait=False)
+
+
+class CapturedGraph:
+  """A graph recorded by `capture`, which can be replayed on new inputs.
+
+  Replaying binds the new inputs straight to the parameters of the cached
+  executable, skipping the tracing, hashing and lowering a regular step would
+  do, so the Python code of the captured function does not run again.
+  """
+
+  def __init__(self, graph, out_spec: pytree.TreeSpec, leaves: List[Any]):
+    self._graph = graph
+    self._out_spec = out_spec
+    self._leaves = leaves
+
+  @property
+  def hash(self) -> str:
+    return self._graph.hash
+
+  def replay(self, *inputs: torch.Tensor) -> Any:
+    """Executes the captured graph on `inputs`.
+
+    The inputs must have the shapes and devices of the ones the graph was
+    captured with. The ones updated in place by the captured function are
+    updated in place here too.
+    """
+    _sync_pending_inputs(inputs)
+    outputs = iter(
+        torch_xla._XLAC._xla_replay_graph(self._graph, list(inputs)))
+    leaves = [
+        next(outputs) if isinstance(leaf, torch.Tensor) else leaf
+        for leaf in self._leaves
+    ]
+    return pytree.tree_unflatten(leaves, self._out_spec)
+
+
+def capture(fn: Callable, *inputs: torch.Tensor) -> Tuple[CapturedGraph, Any]:
+  """Runs `fn` on `inputs` and captures the resulting graph.
+
+  Every tensor `fn` reads other than `inputs`, such as model weights or the RNG
+  seed, is captured by value, as are non-tensor outputs. State that changes
+  between steps, including tensors `fn` updates in place, must be passed in
+  `inputs`.
+
+  Args:
+    fn: the function to capture, taking `inputs` as positional arguments.
+    inputs: the XLA tensors to bind on every replay.
+
+  Returns:
+    The captured graph, and the outputs of this first execution.
+
+  Example::
+
+    graph, out = capture(model, batch)
+    for batch in loader:
+      out = graph.replay(batch)
+  """
+  # Turn all the inputs into device data, so that even scalar inputs are bound
+  # to parameters of the captured graph rather than folded as constants.
+  torch_xla._XLAC._xla_sync_multi(list(inputs), devices=[], wait=False)
+  out = fn(*inputs)
+  leaves, out_spec = pytree.tree_flatten(out)
+  tensors = [leaf for leaf in leaves if isinstance(leaf, torch.Tensor)]
+  graph = torch_xla._XLAC._xla_capture_graph(list(inputs), tensors)
+  return CapturedGraph(graph, out_spec, leaves), out
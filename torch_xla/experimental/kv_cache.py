@@ -0,0 +1,49 @@
+"""In place updates of preallocated buffers, such as the KV cache of a decoder.
+
+A decoding step writing its new tokens into the cache with `index_copy_` or a
+slice assignment goes through functionalization, which turns the update into
+a new tensor, and the cache buffer is only reused if the donation of the old
+buffer and the aliasing of the output line up. Otherwise every step copies
+the whole cache.
+
+`update_` writes into the cache with a single dynamic update slice, whose
+start indices are device data, so that every step runs the same graph, and it
+marks the cache buffer for donation, so that the step only touches the memory
+of the new tokens. The `DynamicUpdateSliceNotAliased` counter records the
+executions where the buffer could not be donated anyway.
+"""
+
+from typing import Sequence, Union
+
+import torch
+
+import torch_xla
+
+
+StartIndices = Union[torch.Tensor, Sequence[Union[int, torch.Tensor]]]
+
+
+def update_(cache: torch.Tensor, update: torch.Tensor,
+            start_indices: StartIndices) -> torch.Tensor:
+  """Writes `update` into `cache` in place, starting at `start_indices`.
+
+  Args:
+    cache: the XLA tensor updated.
+    update: the XLA tensor written, of at most the rank of `cache`. Its shape
+      is right aligned to the one of `cache`.
+    start_indices: the index in `cache` of the first element written, per
+      dimension of `cache`, either as a rank 1 integer tensor or as a sequence
+      of ints and scalar tensors. As in XLA, the indices are clamped so that
+      `update` fits in `cache`.
+
+  Returns:
+    `cache`.
+  """
+  if not isinstance(start_indices, torch.Tensor):
+    start_indices = torch.stack([
+        torch.as_tensor(index, dtype=torch.int64).to(cache.device)
+        for index in start_indices
+    ])
+  torch_xla._XLAC._xla_dynamic_update_slice_(cache, update,
+                                             start_indices.to(torch.int32))
+  return cache
@@ -0,0 +1,217 @@
+"""Lowers a repeated sub-graph once, and calls it from the graphs using it.
+
+A deep model runs the same layer many times per step, and every call traces
+and lowers the layer's sub-graph again, inlined into the step graph. The HLO
+then grows with the depth of the model, and so do the lowering and the XLA
+compile times.
+
+`lowered_once` traces a function on placeholder tensors, lowers it into an XLA
+computation the first time it is called with a given signature, and emits an
+XLA `Call` of that computation for every call, the first one included. The
+backward pass is lowered once too, as a computation which recomputes the
+forward pass and returns the gradients of the inputs.
+
+A function is reused for every call with the same key and the same input
+shapes, dtypes and gradient requirements, so it must be pure: it may only
+depend on its tensor inputs, the tensors it creates with constant values, and
+the Python values fixed by its key. In particular, it must not use the random
+number generator.
+"""
+
+import functools
+from typing import Any, Callable, Dict, List, Optional, Tuple
+
+import torch
+from torch.utils._pytree import tree_flatten, tree_unflatten
+
+import torch_xla
+import torch_xla.core.xla_builder as xb
+
+# The computations lowered so far, by the key of the function and the
+# signature of its inputs.
+_LOWERED: Dict[Any, '_LoweredComputation'] = {}
+
+# The structure of the outputs of the lowered functions, by key.
+_OUTPUT_SPECS: Dict[Any, Any] = {}
+
+
+class _LoweredComputation(object):
+  """A lowered function, and where to get the arguments of its parameters.
+
+  Every parameter of the computation takes either one of the inputs of the
+  function, by index, or a tensor the function hoisted, like a constant it
+  created.
+  """
+
+  def __init__(self, name: str, fn: Callable[..., List[torch.Tensor]],
+               inputs: List[torch.Tensor]):
+    fakes = [xb.create_placeholder_tensor(t.shape, t.dtype) for t in inputs]
+    outputs = list(fn(*fakes))
+    ids, _ = torch_xla._XLAC._get_tensors_xla_device_data_node(outputs)
+    if torch_xla._XLAC._get_seed_info_id() in ids:
+      raise RuntimeError(
+          f'{name} uses the random number generator, so it cannot be reused')
+    ctx = torch_xla._XLAC.lowering.LoweringContext(name)
+    ctx.set_name_string(name)
+    ctx.build(outputs)
+    self.name = name
+    self.computation = xb.computation_from_module_proto(name, ctx.hlo())
+
+    sources = ctx.device_parameter_id_tensor_mapping()
+    for i, fake in enumerate(fakes):
+      param_id = ctx.tensor_parameter_id(fake)
+      if param_id != -1:
+        sources[param_id] = i
+    self._sources = [sources[i] for i in range(len(sources))]
+
+  def __call__(self, inputs: List[torch.Tensor]) -> List[torch.Tensor]:
+    args = [
+        inputs[source] if isinstance(source, int) else source
+        for source in self._sources
+    ]
+    return torch_xla._XLAC._xla_user_computation(f'xla::{self.name}', args,
+                                                 self.computation)
+
+
+def _get_lowered(key: Any, name: str, fn: Callable[..., List[torch.Tensor]],
+                 inputs: List[torch.Tensor]) -> _LoweredComputation:
+  signature = tuple((tuple(t.shape), t.dtype) for t in inputs)
+  lowered = _LOWERED.get((key, signature))
+  if lowered is None:
+    lowered = _LoweredComputation(name, fn, inputs)
+    _LOWERED[(key, signature)] = lowered
+  return lowered
+
+
+class _LoweredOnceFunction(torch.autograd.Function):
+
+  @staticmethod
+  def forward(ctx, key, name, fn, *inputs):
+    ctx.key = key
+    ctx.name = name
+    ctx.fn = fn
+    ctx.save_for_backward(*inputs)
+    return tuple(_get_lowered(key, name, fn, list(inputs))(list(inputs)))
+
+  @staticmethod
+  def backward(ctx, *grad_outputs):
+    inputs = list(ctx.saved_tensors)
+    needs_grad = tuple(ctx.needs_input_grad[3:])
+    fn = ctx.fn
+
+    def backward_fn(*args):
+      # Recomputes the forward pass, whose activations the call does not keep.
+      xs, grads = args[:len(inputs)], args[len(inputs):]
+      with torch.enable_grad():
+        xs = [
+            x.detach().requires_grad_() if needs else x
+            for x, needs in zip(xs, needs_grad)
+        ]
+        wrt = [x for x, needs in zip(xs, needs_grad) if needs]
+        input_grads = torch.autograd.grad(
+            fn(*xs), wrt, grads, allow_unused=True)
+      return [
+          torch.zeros_like(x) if g is None else g
+          for x, g in zip(wrt, input_grads)
+      ]
+
+    args = inputs + list(grad_outputs)
+    lowered = _get_lowered(('backward', ctx.key, needs_grad),
+                           f'{ctx.name}_backward', backward_fn, args)
+    input_grads = iter(lowered(args))
+    return (None, None, None) + tuple(
+        next(input_grads) if needs else None for needs in needs_grad)
+
+
+def _module_key(module: torch.nn.Module) -> Any:
+  # The representation of a module holds its configuration, like the sizes
+  # and flags of its sub-modules, which the shapes of the inputs may not tell.
+  return (type(module), repr(module))
+
+
+def lowered_once(fn: Optional[Callable[..., Any]] = None,
+                 *,
+                 key: Optional[Any] = None) -> Callable[..., Any]:
+  """Lowers `fn` into an XLA computation once, and calls it from then on.
+
+  Can be used as a decorator, with or without arguments.
+
+  Args:
+    fn (callable or torch.nn.Module): The function to lower, which takes and
+      returns tensors, or PyTrees of tensors. A module is called with its
+      parameters and buffers as inputs of the computation, so that the modules
+      with the same key share it.
+    key (optional): The key under which the computation is reused. Default:
+      `fn` itself for a function, and the type and representation of a module.
+
+  Returns:
+    The callable which runs `fn` through its lowered computation.
+
+  Example:
+
+    >>> layers = [lowered_once(TransformerLayer(config)) for _ in range(96)]
+    >>> for layer in layers:
+    >>>   x = layer(x)
+  """
+  if fn is None:
+    return functools.partial(lowered_once, key=key)
+
+  if isinstance(fn, torch.nn.Module):
+    module = fn
+    if key is None:
+      key = _module_key(module)
+    names = [name for name, _ in module.named_parameters()]
+    names += [name for name, _ in module.named_buffers()]
+
+    @functools.wraps(module.forward)
+    def call_module(*args, **kwargs):
+      state = dict(module.named_parameters())
+      state.update(module.named_buffers())
+      tensors = [state[name] for name in names]
+      return _call(key,
+                   type(module).__name__,
+                   lambda *ts, **kw: torch.func.functional_call(
+                       module, dict(zip(names, ts[:len(names)])),
+                       ts[len(names):], kw), tensors, args, kwargs)
+
+    return call_module
+
+  if key is None:
+    key = fn
+
+  @functools.wraps(fn)
+  def call_fn(*args, **kwargs):
+    return _call(key, getattr(fn, '__name__', 'lowered_once'), fn, [], args,
+                 kwargs)
+
+  return call_fn
+
+
+def _call(key: Any, name: str, fn: Callable[..., Any],
+          leading: List[torch.Tensor], args: Tuple[Any, ...],
+          kwargs: Dict[str, Any]) -> Any:
+  flat_args, args_spec = tree_flatten((args, kwargs))
+  for arg in flat_args:
+    if not isinstance(arg, torch.Tensor):
+      raise TypeError(
+          f'The arguments of {name} must be tensors, got {type(arg).__name__}')
+  out_spec = None
+
+  def flat_fn(*tensors):
+    nonlocal out_spec
+    call_args, call_kwargs = tree_unflatten(
+        list(tensors[len(leading):]), args_spec)
+    outputs, out_spec = tree_flatten(
+        fn(*tensors[:len(leading)], *call_args, **call_kwargs))
+    return outputs
+
+  inputs = leading + flat_args
+  # The outputs of `flat_fn` only get their structure back when it is traced,
+  # so the structure is kept along the computation.
+  call_key = (key, repr(args_spec))
+  outputs = _LoweredOnceFunction.apply(call_key, name, flat_fn, *inputs)
+  if out_spec is None:
+    out_spec = _OUTPUT_SPECS[call_key]
+  else:
+    _OUTPUT_SPECS[call_key] = out_spec
+  return tree_unflatten(list(outputs), out_spec)
@@ -0,0 +1,127 @@
+"""Ring attention over sequence shards, as a single XLA loop.
+
+Every process of the ring holds the queries, keys and values of one block of
+the sequence. The key and value blocks rotate around the ring, one hop per
+step, and every process attends its queries to the block it holds at that step,
+accumulating the result with an online softmax.
+
+The rotation and the attention of a step are the body of a `scan`, so the
+whole ring lowers into one `While` loop instead of one collective and one
+dependency chain per rotation. Within the body, the permute of the blocks for
+the next step does not depend on the attention of the current one, which lets
+XLA run the transfer while the attention is computed.
+"""
+
+import itertools
+from typing import List, Optional
+
+import torch
+import torch_xla
+import torch_xla.core.xla_model as xm
+import torch_xla.runtime as xr
+from torch_xla.experimental.scan import scan
+
+_ring_permute_ids = itertools.count()
+
+
+@torch.library.custom_op("xla::ring_permute", mutates_args=())
+def ring_permute(t: torch.Tensor, sources: List[int],
+                 targets: List[int]) -> torch.Tensor:
+  # Every call, including the one traced into a loop body, gets a fresh token
+  # domain, so the permute never chains onto a token from outside the body.
+  pairs = [[s, d] for s, d in zip(sources, targets)]
+  with xm.token_domain('ring_permute:{}'.format(next(_ring_permute_ids))):
+    return xm.collective_permute(t, pairs)
+
+
+@ring_permute.register_fake
+def _(t: torch.Tensor, sources: List[int], targets: List[int]) -> torch.Tensor:
+  return torch.empty_like(t)
+
+
+def _ring_permute_setup_context(ctx, inputs, output):
+  _, ctx.sources, ctx.targets = inputs
+
+
+def _ring_permute_backward(ctx, grad):
+  # The gradient flows back along the ring, against the rotation.
+  return ring_permute(grad, ctx.targets, ctx.sources), None, None
+
+
+ring_permute.register_autograd(
+    _ring_permute_backward, setup_context=_ring_permute_setup_context)
+
+
+def ring_attention(q: torch.Tensor,
+                   k: torch.Tensor,
+                   v: torch.Tensor,
+                   ring: Optional[List[int]] = None,
+                   causal: bool = False,
+                   sm_scale: float = 1.0) -> torch.Tensor:
+  """Computes the attention of the local queries over the whole sequence.
+
+  Args:
+    q (torch.Tensor): The queries of the local sequence block, of shape
+      `[..., block_len, head_dim]`.
+    k (torch.Tensor): The keys of the local sequence block, of the same shape.
+    v (torch.Tensor): The values of the local sequence block, of the same
+      shape.
+    ring (list, optional): The global ordinals of the processes holding the
+      sequence blocks, in sequence order. Default: all the processes.
+    causal (bool, optional): Whether a query only attends to the keys at or
+      before its position in the sequence.
+    sm_scale (float, optional): The scale applied to the attention logits.
+
+  Returns:
+    The attention output of the local queries, of the shape of `q`.
+  """
+  if ring is None:
+    ring = list(range(xr.world_size()))
+  ring_size = len(ring)
+  sources = list(ring)
+  targets = ring[1:] + ring[:1]
+  device = q.device
+  # The positions on the ring are data, so that every process traces the same
+  # graph. At step `i`, a process holds the block from `i` hops back.
+  position = torch.tensor(
+      ring.index(xr.global_ordinal()) if ring_size > 1 else 0,
+      dtype=torch.int64,
+      device=device)
+  steps = torch.arange(ring_size, dtype=torch.int64, device=device)
+  kv_blocks = torch.remainder(position - steps, ring_size)
+  q_blocks = position.expand(ring_size)
+
+  mask_value = torch.finfo(q.dtype).min
+  out = torch.zeros_like(q)
+  row_max = torch.full(q.shape[:-1], mask_value, dtype=q.dtype, device=device)
+  row_sum = torch.zeros(q.shape[:-1], dtype=q.dtype, device=device)
+
+  def step(carry, blocks):
+    q, k_block, v_block, out, row_max, row_sum = carry
+    q_block, kv_block = blocks
+    # Issued first: nothing below depends on the rotated blocks.
+    k_next = ring_permute(k_block, sources, targets)
+    v_next = ring_permute(v_block, sources, targets)
+
+    logits = torch.matmul(q, k_block.transpose(-1, -2)) * sm_scale
+    if causal:
+      block_len = q.size(-2)
+      q_pos = torch.arange(block_len, device=q.device).unsqueeze(-1)
+      kv_pos = torch.arange(block_len, device=q.device).unsqueeze(0)
+      allowed = (kv_block < q_block) | ((kv_block == q_block) &
+                                        (kv_pos <= q_pos))
+      logits = torch.where(allowed, logits, mask_value)
+    new_max = torch.maximum(row_max, logits.amax(dim=-1))
+    probs = torch.exp(logits - new_max.unsqueeze(-1))
+    if causal:
+      # Fully masked rows would otherwise count every logit once.
+      probs = torch.where(allowed, probs, 0.0)
+    correction = torch.exp(row_max - new_max)
+    row_sum = row_sum * correction + probs.sum(dim=-1)
+    out = out * correction.unsqueeze(-1) + torch.matmul(probs, v_block)
+    return (q, k_next, v_next, out, new_max, row_sum), kv_block
+
+  (_, _, _, out, _, row_sum), _ = scan(step,
+                                       (q, k, v, out, row_max, row_sum),
+                                       (q_blocks, kv_blocks))
+  return out / row_sum.unsqueeze(-1)
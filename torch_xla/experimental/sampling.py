@@ -0,0 +1,34 @@
+"""Token sampling of autoregressive decoding, fused on the device.
+
+Sampling the next token with the eager ops sorts the logits, takes their
+softmax and cumulative sum for the top-p, and draws from the result with
+`torch.multinomial`, and moving the token id to the host to feed the next
+step forces a sync per token. `sample_tokens` traces the whole sampling as one
+op, which draws from the top-k and top-p filtered logits with the Gumbel-max
+trick, so that the token ids stay on the device and feed the next step.
+"""
+
+import torch
+
+import torch_xla
+
+
+def sample_tokens(logits: torch.Tensor,
+                  temperature: float = 1.0,
+                  top_k: int = 0,
+                  top_p: float = 1.0) -> torch.Tensor:
+  """Samples a token id from each row of the last dimension of `logits`.
+
+  Args:
+    logits: the XLA tensor of the logits, with the vocabulary last.
+    temperature: the temperature of the softmax of the logits, zero picking the
+      most likely tokens.
+    top_k: the number of most likely tokens sampled from, zero for all of them.
+    top_p: the probability of the smallest set of most likely tokens sampled
+      from, in (0, 1].
+
+  Returns:
+    The LongTensor of the token ids, with the shape of `logits` without its
+    last dimension.
+  """
+  return torch_xla._XLAC._xla_sample_tokens(logits, temperature, top_k, top_p)
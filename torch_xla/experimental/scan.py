@@ -550,51 +550,6 @@ def _remove_none(s: Sequence[Optional[torch.Tensor]]):
   return filtered, add_back_nones
 
 
-def dynamic_update_slice(ys: xb.Op, y: xb.Op, idx: xb.Op) -> xb.Op:
-  # See https://openxla.org/xla/operation_semantics#dynamicupdateslice.
-  y = y.broadcast([1])
-  indices = [idx]
-  for _ in range(ys.shape().rank - 1):
-    indices.append(idx.zeros_like())
-  return ys.dynamic_update_slice(y, indices)
-
-
-def dynamic_slice(xs: xb.Op, idx: xb.Op) -> xb.Op:
-  indices = [idx]
-  for _ in range(xs.shape().rank - 1):
-    indices.append(idx.zeros_like())
-  slice_shape = list(xs.shape().sizes)
-  slice_shape[0] = 1
-  sliced = xs.dynamic_slice(indices, slice_shape)
-  shape = list(xs.shape().sizes)
-  shape = shape[1:]
-  return sliced.reshape(shape)
-
-
-class Builder:
-
-  def __init__(self, name: str):
-    self._builder = xb.create_builder(name)
-    self._params = []
-    self._param_tensors = []
-
-  def add_param(self, val: torch.Tensor):
-    idx = len(self._params)
-    param = xb.mkparam(self._builder, idx, xb.tensor_shape(val))
-    self._params.append(param)
-    self._param_tensors.append(val)
-    return idx
-
-  def params(self) -> Tuple[xb.Op, ...]:
-    return tuple(self._params)
-
-  def param_tensors(self) -> Tuple[torch.Tensor, ...]:
-    return tuple(self._param_tensors)
-
-  def num_params(self) -> int:
-    return len(self._params)
-
-
 def _scan_impl_flat(fn,
                     init: Sequence[torch.Tensor],
                     xs: Sequence[torch.Tensor],
@@ -650,7 +605,6 @@ def _scan_impl_flat(fn,
     t = xb.create_placeholder_tensor(v.shape, v.dtype)
     return t.requires_grad_(v.requires_grad)
 
-  device = torch_xla.device()
   fake_carry = tree_map(make_fake_tensor, init)
   fake_x = tree_map(lambda v: make_fake_tensor(v[0]), xs)
 
@@ -710,40 +664,21 @@ def _scan_impl_flat(fn,
   fn_computation = xb.computation_from_module_proto("fn_computation", fn_hlo)
 
   # Figure out the shape of `ys` from the abstract tracing.
-  fn_carry_out, fn_y_out = split(fn_outputs, carry_len)
+  fn_carry_out, _ = split(fn_outputs, carry_len)
   assert carry_len + y_len == len(fn_outputs)
   fn_carry_shapes = [v.shape for v in fn_carry_out]
   for fn_carry_shape, init_leaf in zip(fn_carry_shapes, init):
     assert fn_carry_shape == init_leaf.shape, f"`fn` must keep the `carry` shape unchanged. \
       Got {fn_carry_shape} but expected {init_leaf.shape}"
 
-  builder = Builder('scan')
-  num_iters = next(iter(tree_iter(xs))).size(0)
-  ys = [
-      torch.zeros((num_iters, *v.shape), device=device, dtype=v.dtype)
-      for v in fn_y_out
-  ]
-  # Start the `curr_iter` loop variable at zero.
-  zero = torch.tensor(0, device=device)
-  builder.add_param(zero)
-
-  # We are building a bigger XLA computation (the while loop) that calls
-  # a smaller computation (`fn_computation`). This is a mapping from
-  # `fn_computation` param ID to While computation param ID.
-  fn_param_id_to_while_param_id: Dict[int, int] = {}
-
-  # Add carry and x.
-  for real, fake in ((init, fake_carry), (xs, fake_x)):
-    for val, fake_val in zip(real, fake):
-      idx = builder.add_param(val)
-      param_id = fn_ctx.tensor_parameter_id(fake_val)
-      if param_id != -1:
-        fn_param_id_to_while_param_id[param_id] = idx
-
-  # Add the output as a param since our While computation consumes it, updates
-  # one slice, and returns the updated ys in each iteration.
-  for val in ys:
-    builder.add_param(val)
+  # The operands of the native scan are the carry, the xs, then the hoisted
+  # variables. This maps each `fn_computation` param ID to its operand.
+  operands: List[torch.Tensor] = list(itertools.chain(init, xs))
+  fn_param_id_to_operand: Dict[int, int] = {}
+  for idx, fake_val in enumerate(itertools.chain(fake_carry, fake_x)):
+    param_id = fn_ctx.tensor_parameter_id(fake_val)
+    if param_id != -1:
+      fn_param_id_to_operand[param_id] = idx
 
   # Detect hoisted variables.
   hoisted_vars: Dict[
@@ -754,6 +689,7 @@ def _scan_impl_flat(fn,
       del hoisted_vars[param_id]
 
   # Detect RNG seed usage within the scanned function within hoisted variables.
+  num_iters = next(iter(tree_iter(xs))).size(0)
   ids, i_values = torch_xla._XLAC._get_tensors_xla_device_data_node(fn_outputs)
   seed_info_id = torch_xla._XLAC._get_seed_info_id()
   seed_parameter_id = None
@@ -769,82 +705,24 @@ def _scan_impl_flat(fn,
     hoisted_vars[seed_parameter_id] = torch.randint(
         0, 2**62, (num_iters,), dtype=torch.int64, device='xla')
 
-  # Add hoisted variables as While computation params as well,
-  # including the potentially updated seed tensor.
+  # Add hoisted variables as operands as well, including the potentially
+  # updated seed tensor, which the native scan slices per iteration.
   for param_id, tensor in hoisted_vars.items():
-    idx = builder.add_param(tensor.to('xla'))
-    fn_param_id_to_while_param_id[param_id] = idx
-
-  # Since we are threading five objects through the body_fn:
-  #
-  # - curr_iter: the current loop iteration
-  # - carry: the scan state
-  # - xs: the flattened input pytree
-  # - ys: the flattened output of fn
-  # - hoisted_vars: tensors not provided as arguments to fn but still used by fn.
-  #
-  # We need to concatenate all into one big list prior to entering `body_fn` and
-  # `cond_fn`, and split them back which is easier to work with after that. This
-  # pair of `pack`, `unpack` functions is for that purpose.
-  T = TypeVar('T')
-
-  def pack(curr_iter: T, carry: Sequence[T], xs: Sequence[T], ys: Sequence[T],
-           hoisted_vars: Sequence[T]) -> Tuple[T, ...]:
-    return tuple(itertools.chain((curr_iter,), carry, xs, ys, hoisted_vars))
-
-  def unpack(seq: Sequence[T]) -> Tuple[T, List[T], List[T], List[T], List[T]]:
-    curr_iter, carry, xs, ys, hoisted_vars = split(
-        list(seq), 1, carry_len, xs_len, y_len)
-    curr_iter = curr_iter[0]
-    return curr_iter, carry, xs, ys, hoisted_vars
-
-  def replace_rng_seed(curr_iter: xb.Op, *while_params: xb.Op):
-    """Slices the pre-generated seed tensor for the current iteration."""
-    if seed_parameter_id is None:
-      return while_params
-    idx = fn_param_id_to_while_param_id[seed_parameter_id]
-    replaced = list(while_params)
-    replaced[idx] = dynamic_slice(replaced[idx], curr_iter)
-    return replaced
-
-  def call_fn_computation(*while_params: xb.Op) -> xb.Op:
-    # We need to order the tensors in increasing parameter ID order when
-    # passing them to `xb.Op.call`.
-    fn_inputs = [
-        while_params[fn_param_id_to_while_param_id[i]]
-        for i in range(len(fn_param_id_to_while_param_id))
-    ]
-    return xb.Op.call(fn_computation, fn_inputs)
-
-  def cond_fn(curr_iter: xb.Op, *rest):
-    return curr_iter < xb.Op.scalar(
-        curr_iter.builder(), num_iters, dtype=xb.Type.S64)
-
-  def body_fn(*while_params: xb.Op):
-    curr_iter, carry, xs, ys, hoisted_vars = unpack(while_params)
-    if reverse:
-      max_iter = xb.Op.scalar(
-          curr_iter.builder(), num_iters - 1, dtype=xb.Type.S64)
-      idx = max_iter - curr_iter
-    else:
-      idx = curr_iter
-    x = [dynamic_slice(v, idx) for v in xs]
-    result = call_fn_computation(
-        *replace_rng_seed(idx, curr_iter, *carry, *x, *ys, *hoisted_vars))
-    for i in range(carry_len):
-      carry[i] = result.get_tuple_element(i)
-    for i in range(y_len):
-      y = result.get_tuple_element(i + carry_len)
-      ys[i] = dynamic_update_slice(ys[i], y, idx)
-    one = xb.Op.scalar(curr_iter.builder(), 1, dtype=xb.Type.S64)
-    return pack(curr_iter + one, carry, xs, ys, hoisted_vars)
-
-  res = xb.Op.mkwhile(builder.params(), cond_fn, body_fn)
-  computation = res.build('scan')
-  outputs = torch_xla._XLAC._xla_user_computation('xla::scan',
-                                                  builder.param_tensors(),
-                                                  computation)
-  _curr_iter, carry, xs, ys, _hoisted_vars = unpack(outputs)
+    fn_param_id_to_operand[param_id] = len(operands)
+    operands.append(tensor.to('xla'))
+  seed_operand = -1
+  if seed_parameter_id is not None:
+    seed_operand = fn_param_id_to_operand[seed_parameter_id]
+
+  # The native scan node builds the While around `fn_computation` and hashes
+  # it by its HLO, so that scanning the same `fn` compiles once.
+  parameter_operands = [
+      fn_param_id_to_operand[i] for i in range(len(fn_param_id_to_operand))
+  ]
+  outputs = torch_xla._XLAC._xla_scan(operands, fn_computation, carry_len,
+                                      xs_len, parameter_operands, seed_operand,
+                                      reverse)
+  carry, ys = split(outputs, carry_len)
   return carry, ys
 
 
@@ -0,0 +1,101 @@
+"""An EmbeddingBag whose weight gradient is the rows of the looked up indices.
+
+The dense gradient of an `EmbeddingBag` has the shape of its weight, although
+only the rows of the indices of a step are not zero. With millions of
+embeddings most of the backward pass, and of the optimizer step, is spent on
+the zeros.
+
+XLA has no sparse tensors, and the number of distinct indices of a step is
+only known on the device, so `SparseEmbeddingBag` stores the gradient of its
+weight as a pair of tensors of static shapes, instead of `weight.grad`:
+
+  * `indices`: the distinct indices looked up, sorted, of shape [N] for N
+    indices, padded with `num_embeddings`;
+  * `values`: the summed gradient of the rows of `indices`, of shape [N, D],
+    with zeros for the padding.
+
+`apply_sparse_grad_` takes a step of stochastic gradient descent on the rows of
+`indices` only. The padding indices are out of bounds and are dropped by the
+update.
+"""
+
+import torch
+
+import torch_xla
+
+_MODES = {'sum': 0, 'mean': 1}
+
+
+class _SparseEmbeddingBag(torch.autograd.Function):
+
+  @staticmethod
+  def forward(ctx, weight, input, offsets, per_sample_weights, mode,
+              include_last_offset, module):
+    output, offset2bag, bag_size, _ = torch.ops.aten._embedding_bag(
+        weight, input, offsets, False, mode, False, per_sample_weights,
+        include_last_offset, -1)
+    ctx.mode = mode
+    ctx.num_weights = weight.size(0)
+    ctx.module = module
+    ctx.save_for_backward(input, offset2bag, bag_size, per_sample_weights)
+    return output
+
+  @staticmethod
+  def backward(ctx, grad_output):
+    input, offset2bag, bag_size, per_sample_weights = ctx.saved_tensors
+    ctx.module.sparse_grad = (
+        torch_xla._XLAC._xla_embedding_bag_sparse_backward(
+            grad_output.contiguous(), input, offset2bag, bag_size,
+            per_sample_weights, ctx.num_weights, ctx.mode))
+    return None, None, None, None, None, None, None
+
+
+class SparseEmbeddingBag(torch.nn.Module):
+  """An `torch.nn.EmbeddingBag` of 'sum' or 'mean' mode, with 1D indices.
+
+  After a backward pass, `sparse_grad` holds the (indices, values) gradient of
+  the weight, and `weight.grad` is left untouched.
+
+  Args:
+    num_embeddings: the number of rows of the weight.
+    embedding_dim: the size of every row.
+    mode: 'sum' or 'mean'.
+    include_last_offset: whether the last offset is the end of the last bag,
+      as in `torch.nn.EmbeddingBag`.
+  """
+
+  def __init__(self,
+               num_embeddings: int,
+               embedding_dim: int,
+               mode: str = 'mean',
+               include_last_offset: bool = False):
+    super().__init__()
+    if mode not in _MODES:
+      raise ValueError(f'Unsupported mode: {mode}')
+    self.num_embeddings = num_embeddings
+    self.embedding_dim = embedding_dim
+    self.mode = mode
+    self.include_last_offset = include_last_offset
+    self.weight = torch.nn.Parameter(
+        torch.empty(num_embeddings, embedding_dim))
+    self.sparse_grad = None
+    torch.nn.init.normal_(self.weight)
+
+  def forward(self,
+              input: torch.Tensor,
+              offsets: torch.Tensor,
+              per_sample_weights: torch.Tensor = None) -> torch.Tensor:
+    if per_sample_weights is not None and self.mode != 'sum':
+      raise ValueError('per_sample_weights is only supported in sum mode')
+    return _SparseEmbeddingBag.apply(self.weight, input, offsets,
+                                     per_sample_weights, _MODES[self.mode],
+                                     self.include_last_offset, self)
+
+  @torch.no_grad()
+  def apply_sparse_grad_(self, lr: float):
+    """Subtracts `lr` times `sparse_grad` from the rows of the weight."""
+    if self.sparse_grad is None:
+      return
+    indices, values = self.sparse_grad
+    self.weight.index_put_((indices,), values.mul(-lr), accumulate=True)
+    self.sparse_grad = None
@@ -0,0 +1,83 @@
+import json
+import os
+import struct
+from typing import Callable, Dict, Optional, Tuple, Union
+
+import torch
+import torch_xla
+
+# Largest amount of host data uploaded at once.
+DEFAULT_MAX_INFLIGHT_BYTES = 1024 * 1024 * 1024
+
+_SAFETENSORS_DTYPES = {
+    'BOOL': torch.bool,
+    'U8': torch.uint8,
+    'I8': torch.int8,
+    'I16': torch.int16,
+    'I32': torch.int32,
+    'I64': torch.int64,
+    'F16': torch.float16,
+    'BF16': torch.bfloat16,
+    'F32': torch.float32,
+    'F64': torch.float64,
+    'F8_E4M3': torch.float8_e4m3fn,
+    'F8_E5M2': torch.float8_e5m2,
+}
+
+
+def _read_safetensors_header(path: str) -> Tuple[int, Dict[str, dict]]:
+  with open(path, 'rb') as f:
+    header_size, = struct.unpack('<Q', f.read(8))
+    header = json.loads(f.read(header_size))
+  header.pop('__metadata__', None)
+  return 8 + header_size, header
+
+
+def load_safetensors(
+    path: Union[str, os.PathLike],
+    sharding: Optional[Callable[[str, torch.Size],
+                                Optional[torch_xla._XLAC.OpSharding]]] = None,
+    device: Optional[torch.device] = None,
+    max_inflight_bytes: int = DEFAULT_MAX_INFLIGHT_BYTES
+) -> Dict[str, torch.Tensor]:
+  """Loads the tensors of a safetensors file straight to XLA devices.
+
+  Unlike loading the file on the CPU and moving the tensors, the data is
+  never copied into CPU tensors: it is transferred out of a read-only memory
+  mapping of the file, each local shard of an evenly sharded tensor from a
+  view of its tile. The tensors go in batches of at most `max_inflight_bytes`
+  and the pages of each batch are dropped once transferred, so the host memory
+  used stays far below the size of the checkpoint.
+
+  Args:
+    path: The safetensors file to load.
+    sharding: With SPMD, called with the name and shape of each tensor to get
+      its sharding, such as `mesh.get_op_sharding(partition_spec)`. A tensor
+      given no sharding is replicated.
+    device: The XLA device to load the tensors to, the current one if None.
+    max_inflight_bytes: The host data size limit of the batches.
+
+  Returns:
+    The XLA tensors by name, sharded as requested.
+  """
+  path = os.fspath(path)
+  data_offset, header = _read_safetensors_header(path)
+  names, offsets, dtypes, sizes, shardings = [], [], [], [], []
+  for name, info in header.items():
+    if info['dtype'] not in _SAFETENSORS_DTYPES:
+      raise ValueError(f'Unsupported dtype {info["dtype"]} of tensor {name}')
+    names.append(name)
+    offsets.append(data_offset + info['data_offsets'][0])
+    dtypes.append(_SAFETENSORS_DTYPES[info['dtype']])
+    sizes.append(info['shape'])
+    shardings.append(
+        sharding(name, torch.Size(info['shape'])) if sharding else None)
+  tensors = torch_xla._XLAC._xla_load_mapped_tensors(
+      path,
+      offsets,
+      dtypes,
+      sizes,
+      shardings,
+      max_inflight_bytes=max_inflight_bytes,
+      device=str(device) if device is not None else '')
+  return dict(zip(names, tensors))
@@ -0,0 +1,94 @@
+import os
+from typing import Union
+
+import torch
+import torch_xla
+
+# Largest slice of an unsharded tensor copied to the host at once.
+DEFAULT_MAX_CHUNK_BYTES = 256 * 1024 * 1024
+
+
+def _open_destination(tensor: torch.Tensor,
+                      dest: Union[torch.Tensor, str, os.PathLike]):
+  if isinstance(dest, torch.Tensor):
+    if dest.device.type != 'cpu':
+      raise ValueError(f'Destination must be a CPU tensor, got {dest.device}')
+    if dest.shape != tensor.shape or dest.dtype != tensor.dtype:
+      raise ValueError(
+          f'Destination is {dest.dtype}{list(dest.shape)}, expected '
+          f'{tensor.dtype}{list(tensor.shape)}')
+    return dest
+  # A file is written through a shared mapping, created if needed, so the
+  # pages can be flushed while the copy progresses.
+  return torch.from_file(
+      os.fspath(dest), shared=True, size=tensor.numel(),
+      dtype=tensor.dtype).view(tensor.shape)
+
+
+def _copy_shards(tensor: torch.Tensor, dest: torch.Tensor):
+  replica_and_indices = torch_xla._XLAC._get_local_shard_replica_and_indices(
+      [tensor])[0]
+  copied = set()
+  for index, (_, indices) in enumerate(replica_and_indices):
+    key = None if indices is Ellipsis else tuple(
+        (s.start, s.stop) for s in indices)
+    # Replicas of an already copied shard hold the same values.
+    if key in copied:
+      continue
+    copied.add(key)
+    shard = torch_xla._XLAC._get_local_shard(tensor, index)
+    if indices is Ellipsis:
+      dest.copy_(shard)
+    else:
+      # The shards carry the padding of uneven shardings, which the indices
+      # exclude.
+      region = dest[tuple(indices)]
+      region.copy_(shard[tuple(slice(0, size) for size in region.shape)])
+    del shard
+
+
+def _copy_chunks(tensor: torch.Tensor, dest: torch.Tensor,
+                 max_chunk_bytes: int):
+  row_bytes = tensor[0].numel() * tensor.element_size() if tensor.dim() else 0
+  if tensor.dim() == 0 or tensor.shape[0] * row_bytes <= max_chunk_bytes:
+    dest.copy_(tensor.cpu())
+    return
+  rows = max(1, max_chunk_bytes // max(row_bytes, 1))
+  for start in range(0, tensor.shape[0], rows):
+    end = min(start + rows, tensor.shape[0])
+    # The rows are selected by an index uploaded as data, so that all the
+    # chunks of the same size share one compiled graph.
+    index = torch.arange(start, end).to(tensor.device)
+    dest[start:end].copy_(torch.index_select(tensor, 0, index).cpu())
+
+
+def read_to(tensor: torch.Tensor,
+            dest: Union[torch.Tensor, str, os.PathLike],
+            max_chunk_bytes: int = DEFAULT_MAX_CHUNK_BYTES) -> torch.Tensor:
+  """Copies an XLA tensor to `dest` one piece at a time.
+
+  Unlike `tensor.cpu()`, the full tensor is never materialized as a whole on
+  the host, nor replicated on a single device: a sharded tensor is copied one
+  local shard at a time, each replicated shard once, and an unsharded tensor
+  in slices of at most `max_chunk_bytes` along its first dimension. With
+  multiple hosts, only the regions held by the local devices are written.
+
+  Args:
+    tensor: The XLA tensor to read.
+    dest: A CPU tensor of the same shape and dtype, which can map a file or
+      any other memory, or the path of a file which receives the raw tensor
+      data and is created if needed.
+    max_chunk_bytes: The size limit of the slices of unsharded tensors.
+
+  Returns:
+    The CPU tensor written, `dest` itself or the tensor mapping the file.
+  """
+  if hasattr(tensor, 'global_tensor'):
+    tensor = tensor.global_tensor
+  dest = _open_destination(tensor, dest)
+  torch_xla._XLAC._xla_sync_multi([tensor], devices=[], wait=True)
+  if torch_xla._XLAC._get_xla_sharding_spec(tensor) != '':
+    _copy_shards(tensor, dest)
+  else:
+    _copy_chunks(tensor, dest, max_chunk_bytes)
+  return dest
@@ -9,9 +9,15 @@ XLA_LIB.define(
 )
 
 
+# The dtypes of the quantized weights. The int4 weights are held in int8.
+_WEIGHT_DTYPES = (torch.int8, torch.float8_e4m3fn, torch.float8_e5m2)
+
+
 def _check_per_channel_quant_weight_dtype_shapes(input_dim, output_dim, w,
                                                  w_scaler, zero_point):
-  assert w.dtype == torch.int8, f"Weight dtype is expected to be torch.int8, got {w.dtype}."
+  assert w.dtype in _WEIGHT_DTYPES, (
+      f"Weight dtype is expected to be one of {_WEIGHT_DTYPES}, got {w.dtype}."
+  )
   assert w.dim(
   ) == 2, f"Weight tensor is expected to be 2D, got {w.dim()}D Tensor."
   w_shape = list(w.shape)
@@ -27,8 +33,9 @@ def _check_per_channel_quant_weight_dtype_shapes(input_dim, output_dim, w,
 def _check_blockwise_quant_weight_dtype_shapes(input_dim, output_dim,
                                                block_size, w, w_scaler,
                                                zero_point):
-  assert w.dtype == torch.int8, (
-      f"Weight dtype is expected to be torch.int8, got {w.dtype}.")
+  assert w.dtype in _WEIGHT_DTYPES, (
+      f"Weight dtype is expected to be one of {_WEIGHT_DTYPES}, got {w.dtype}."
+  )
   assert w.dim() == 3, (
       f"Weight tensor is expected to be 3D, got {w.dim()}D Tensor.")
   w_shape = list(w.shape)
@@ -73,6 +80,43 @@ def _quantize_tensor(x: torch.Tensor, n_bits: int = 8, dim: int = -1):
   return x_int, scale.to(x.dtype)
 
 
+def pack_int4(w: torch.Tensor) -> torch.Tensor:
+  """Packs int4 values two per byte.
+
+  Args:
+    w (torch.Tensor): CPU torch.int8 tensor of values in [-8, 7], with an even
+      last dimension.
+
+  Returns:
+    torch.Tensor: torch.uint8 tensor half as large along the last dimension,
+      with the even elements in the low nibbles.
+  """
+  return torch_xla._XLAC._xla_pack_int4(w)
+
+
+def unpack_int4(packed: torch.Tensor) -> torch.Tensor:
+  """Unpacks the int4 values packed by `pack_int4`.
+
+  Unpacking an XLA tensor happens on the device, so that moving packed weights
+  to the device only transfers the packed bytes.
+
+  Args:
+    packed (torch.Tensor): torch.uint8 tensor of int4 values packed two per
+      byte.
+
+  Returns:
+    torch.Tensor: torch.int8 tensor of the values, twice as large along the
+      last dimension.
+  """
+  if packed.device.type != 'xla':
+    return torch_xla._XLAC._xla_unpack_int4(packed)
+  packed = packed.to(torch.int8)
+  low = torch.bitwise_left_shift(packed, 4) >> 4
+  high = packed >> 4
+  return torch.stack([low, high], dim=-1).reshape(*packed.shape[:-1],
+                                                  packed.shape[-1] * 2)
+
+
 @impl(XLA_LIB, "quantized_matmul", "XLA")
 def quantized_matmul_xla(x: torch.Tensor,
                          w: torch.Tensor,
@@ -99,19 +143,15 @@ def quantized_matmul_xla(x: torch.Tensor,
                    container (unpacked).
   """
   if int4_weight:
-    # Reinterpret cast the weight to s4 dtype in XLA.
-    w = torch_xla._XLAC._xla_cast_int4(w, w.cpu().flatten().numpy().tolist())
+    # Reinterpret cast the weight to s4 dtype in XLA, on the device.
+    w = torch_xla._XLAC._xla_cast_int4(w)
   if block_size == -1:
     # Per-channel quant.
     _check_per_channel_quant_weight_dtype_shapes(x.shape[-1], scaler.shape[0],
                                                  w, scaler, zero_point)
+    x_scale = None
     if quantize_activation:
       x, x_scale = _quantize_tensor(x)
-      out = torch_xla._XLAC._xla_dot_general(
-          x, w, (([-1], [-1]), ()), preferred_element_type=torch.int32)
-    else:
-      out = F.linear(x, w)
-    out = out * scaler
   else:
     # Blockwise quant.
     assert quantize_activation == False, (
@@ -119,21 +159,11 @@ def quantized_matmul_xla(x: torch.Tensor,
     _check_blockwise_quant_weight_dtype_shapes(x.shape[-1], w.shape[-1],
                                                block_size, w, scaler,
                                                zero_point)
-    x = x.reshape(*x.shape[:-1], x.shape[-1] // block_size, block_size)
-    out = torch.einsum('scn,...sc->...sn', w, x)
-    out = torch.einsum('sn,...sn->...n', scaler, out)
-  if zero_point is not None:
-    if block_size == -1:
-      # Per-channel quant.
-      zp_out = torch.einsum("...c,z->...z", x, zero_point)
-    else:
-      # Blockwise quant.
-      zp_out = x.sum(dim=-1)
-      zp_out = torch.matmul(zp_out, zero_point)
-    out -= zp_out
-  if quantize_activation:
-    out = out * x_scale
-  return out
+    x_scale = None
+  # The weight is read in its quantized dtype by the dot, and the scales are
+  # applied to its products.
+  return torch_xla._XLAC._xla_quantized_dot(x, w, scaler, x_scale, zero_point,
+                                            block_size)
 
 
 @impl(XLA_LIB, "quantized_matmul", "CompositeExplicitAutograd")
@@ -274,3 +274,42 @@ def get_num_cached_compilation_graph():
   the compilation graph will be fetched into the in-memory cache.
   """
   return torch_xla._XLAC._xla_get_num_cached_compilation_graph()
+
+
+def wait_pending_compilations(hashes: Optional[List[bytes]] = None):
+  """Blocks until the background compilations are done.
+
+  Background compilations are only used when `XLA_ASYNC_COMPILATION=1`, in
+  which case a cache miss sends the XLA compilation to a dedicated compile
+  thread pool instead of blocking the tracing thread. Compiled graphs are added
+  to the computation cache once ready.
+
+  Args:
+    hashes (List[bytes], optional): The graph hashes to wait for, as returned
+      by `torch_xla._XLAC._get_graph_hash`. Waits for all the in-flight
+      compilations if not provided.
+  """
+  torch_xla._XLAC._xla_wait_pending_compilations(hashes or [])
+
+
+def get_num_pending_compilations() -> int:
+  """Returns the number of background compilations still in flight."""
+  return torch_xla._XLAC._xla_get_num_pending_compilations()
+
+
+def warm_up_cache(tensor_groups: List[List[torch.Tensor]],
+                  devices: Optional[List[str]] = None):
+  """Compiles the graphs of the given tensor groups without executing them.
+
+  Each group is lowered as if it was synced on its own, and the resulting
+  graphs are added to the computation cache. Groups which lower to the same
+  graph, or whose graph is already cached, are only compiled once, and all the
+  remaining graphs are compiled in parallel.
+
+  Args:
+    tensor_groups (List[List[torch.Tensor]]): The groups of XLA tensors whose
+      pending IR graphs should be compiled.
+    devices (List[str], optional): The devices participating in the replicated
+      computation.
+  """
+  torch_xla._XLAC._xla_warm_up_cache_batch(tensor_groups, devices or [])
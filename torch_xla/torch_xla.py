@@ -2,12 +2,14 @@ import sys
 import collections
 import contextlib
 import functools
+import inspect
 import uuid
-from typing import Any, Callable, List, Optional, Tuple
+from typing import Any, Callable, List, Optional, Tuple, Union
 import weakref
 
 import torch
 import torch.distributed as dist
+import torch.utils._pytree as pytree
 import torch_xla
 import torch_xla.core.xla_model as xm
 import torch_xla.core.xla_env_vars as xenv
@@ -93,7 +95,7 @@ def sync(wait: bool = False, reset_scope: bool = True):
   if xm.is_master_ordinal():
     xm.ms.save_metrics()
   devctx = xm._run_step_closures()
-  torch_xla._XLAC._set_all_reduce_token(devctx.device, None)
+  torch_xla._XLAC._reset_all_reduce_tokens(devctx.device)
 
 
 def step():
@@ -117,6 +119,8 @@ def compile(
     name: Optional[str] = None,
     max_different_graphs: Optional[int] = None,
     custom_compile_options: Optional[dict[str, Any]] = None,
+    shape_buckets: Optional[Union[bool, List[int]]] = None,
+    parameter_wrapping_threshold: Optional[int] = None,
 ):
   """
   Optimizes given model/function using torch_xla's LazyTensor tracing mode.
@@ -142,6 +146,17 @@ def compile(
         and values may be bool, int, float, or str (internally stringified).
         - {} (empty dict): clear previously set options.
         - None (default): do not change previously set options (no-op).
+      shape_buckets (Optional[Union[bool, List[int]]]): pads the dimensions of the
+        tensor positional arguments of `f` that vary across calls to a bucket ladder,
+        so that the number of compiled graphs stays bounded. True uses powers of two,
+        a list of ints uses those sizes. If `f` accepts a `padding_masks` keyword
+        argument, it receives one boolean mask of the valid elements per positional
+        argument (None for arguments that were not padded). Output dimensions whose
+        size is a bucket a single input size was padded to are sliced back.
+      parameter_wrapping_threshold (Optional[int]): the number of parameters from which
+        the compiled graph takes its parameters as a single tuple. By default, it is
+        `XLA_PARAMETER_WRAPPING_THREADSHOLD` if set, or derived from the measured cost
+        of passing the parameters of an execution.
 
   Example::
 
@@ -192,6 +207,8 @@ def compile(
     saved_eager_mode_status = torch_xla._XLAC._get_use_eager_mode()
     saved_allow_execution = torch_xla._XLAC._get_allow_execution()
     saved_current_graph_name = torch_xla._XLAC._get_current_graph_name()
+    saved_parameter_wrapping_threshold = (
+        torch_xla._XLAC._get_parameter_wrapping_threshold())
     torch_xla._XLAC._set_use_eager_mode(False)
     if name is not None:
       torch_xla._XLAC._set_current_graph_name(name + '_clear_pending')
@@ -200,6 +217,9 @@ def compile(
 
     if name is not None:
       torch_xla._XLAC._set_current_graph_name(name)
+    if parameter_wrapping_threshold is not None:
+      torch_xla._XLAC._set_parameter_wrapping_threshold(
+          parameter_wrapping_threshold)
 
     # if full_graph sets to true execution can not happen before the sync below
     torch_xla._XLAC._set_allow_execution(not full_graph)
@@ -220,12 +240,77 @@ def compile(
       sync()
       torch_xla._XLAC._set_use_eager_mode(saved_eager_mode_status)
       torch_xla._XLAC._set_current_graph_name(saved_current_graph_name)
+      torch_xla._XLAC._set_parameter_wrapping_threshold(
+          saved_parameter_wrapping_threshold)
 
   if custom_compile_options is not None:
     torch_xla._XLAC._set_custom_compile_options(custom_compile_options)
+  if shape_buckets is not None and shape_buckets is not False:
+    if f is None:
+      raise ValueError('shape_buckets requires a function to compile')
+    buckets = [] if shape_buckets is True else list(shape_buckets)
+    torch_xla._XLAC._xla_shape_bucketing_set_buckets(current_id, buckets)
+    return _pad_to_shape_buckets(f, _compile()(f), current_id)
   return _compile() if f is None else _compile()(f)
 
 
+def _pad_to_shape_buckets(f: Callable, compiled_f: Callable,
+                          session: str) -> Callable:
+  """Wraps `compiled_f` so that its tensor positional arguments are padded to
+  the shape buckets of `session` before tracing, and its outputs sliced back.
+
+  The padding runs outside of the compiled region, so the traced graph only
+  ever sees bucketed shapes.
+  """
+  try:
+    pass_masks = 'padding_masks' in inspect.signature(f).parameters
+  except (TypeError, ValueError):
+    pass_masks = False
+
+  @functools.wraps(f)
+  def wrapper(*args, **kwargs):
+    padded_args, masks = [], []
+    # Bucket size -> original sizes padded to it, and sizes left unpadded.
+    padded_sizes = collections.defaultdict(set)
+    unpadded_sizes = set()
+    for index, arg in enumerate(args):
+      mask = None
+      if isinstance(arg, torch.Tensor):
+        arg, mask = torch_xla._XLAC._xla_shape_bucketing_pad(
+            session, index, arg)
+        for size, bucket in zip(args[index].shape, arg.shape):
+          if size != bucket:
+            padded_sizes[bucket].add(size)
+          else:
+            unpadded_sizes.add(size)
+      padded_args.append(arg)
+      masks.append(mask)
+    if pass_masks:
+      kwargs['padding_masks'] = masks
+    out = compiled_f(*padded_args, **kwargs)
+
+    # Only slice the dimensions that unambiguously come from a padded input.
+    restore = {
+        bucket: next(iter(sizes))
+        for bucket, sizes in padded_sizes.items()
+        if len(sizes) == 1 and bucket not in unpadded_sizes
+    }
+    if not restore:
+      return out
+
+    def unpad(t):
+      if not isinstance(t, torch.Tensor):
+        return t
+      for dim, size in enumerate(t.shape):
+        if size in restore:
+          t = t.narrow(dim, 0, restore[size])
+      return t
+
+    return pytree.tree_map(unpad, out)
+
+  return wrapper
+
+
 def manual_seed(seed, device=None):
   """Set the seed for generating random numbers for the current XLA device.
 
@@ -5,8 +5,9 @@ import inspect
 import torch
 import warnings
 import torch_xla.core.xla_model as xm
+from torch.utils._python_dispatch import TorchDispatchMode
 from torch.utils.checkpoint import detach_variable, check_backward_validity, _get_device_module, _infer_device_type
-from typing import Iterable, List, Tuple, Union
+from typing import Callable, Iterable, List, Optional, Tuple, Union
 
 # The 2 functions below (get_device_states and set_device_states) are slightly modified versions
 # from PyTorch's original file.
@@ -68,6 +69,79 @@ class CheckpointStatus:
 # chkpt_status is used for FSDP allgather reduction optimizaion
 chkpt_status = CheckpointStatus()
 
+_DOT_OPS = {
+    torch.ops.aten.addmm,
+    torch.ops.aten.baddbmm,
+    torch.ops.aten.bmm,
+    torch.ops.aten.convolution,
+    torch.ops.aten.einsum,
+    torch.ops.aten.mm,
+}
+
+
+def nothing_saveable(func) -> bool:
+  """Recomputes every op of the checkpointed region in the backward."""
+  return False
+
+
+def dots_saveable(func) -> bool:
+  """Saves the outputs of the matmuls and the convolutions, and recomputes the
+  ops in between, like the elementwise ops and the normalizations."""
+  return func.overloadpacket in _DOT_OPS
+
+
+_REMAT_POLICIES = {
+    'nothing_saveable': nothing_saveable,
+    'dots_saveable': dots_saveable,
+}
+
+
+def _get_remat_policy(
+    policy: Union[str, Callable, None]) -> Optional[Callable]:
+  if policy is None or policy is nothing_saveable:
+    return None
+  if isinstance(policy, str):
+    if policy not in _REMAT_POLICIES:
+      raise ValueError(f"Unknown remat policy '{policy}', expected one of "
+                       f"{', '.join(_REMAT_POLICIES)} or a callable")
+    return _get_remat_policy(_REMAT_POLICIES[policy])
+  return policy
+
+
+class _SaveOutputsMode(TorchDispatchMode):
+  """Records the outputs of the ops the policy saves, in execution order."""
+
+  def __init__(self, policy):
+    super().__init__()
+    self.policy = policy
+    self.saved = []
+
+  def __torch_dispatch__(self, func, types, args=(), kwargs=None):
+    out = func(*args, **(kwargs or {}))
+    if self.policy(func) and isinstance(out, torch.Tensor):
+      self.saved.append((func, out.detach()))
+    return out
+
+
+class _ReplayOutputsMode(TorchDispatchMode):
+  """Returns the saved outputs of the ops the policy saved, in the order they
+  were recorded, instead of recomputing them."""
+
+  def __init__(self, policy, saved):
+    super().__init__()
+    self.policy = policy
+    self.saved = list(saved)
+
+  def __torch_dispatch__(self, func, types, args=(), kwargs=None):
+    if self.saved and self.policy(func):
+      saved_func, out = self.saved.pop(0)
+      if saved_func != func:
+        raise RuntimeError(
+            f"The recomputation of the checkpointed region ran {func} where "
+            f"the forward saved the output of {saved_func}")
+      return out
+    return func(*args, **(kwargs or {}))
+
 
 class CheckpointFunction(torch.autograd.Function):
 
@@ -83,10 +157,11 @@ class CheckpointFunction(torch.autograd.Function):
     return tensor_inputs
 
   @staticmethod
-  def forward(ctx, run_function, preserve_rng_state, *args):
+  def forward(ctx, run_function, preserve_rng_state, policy, *args):
     check_backward_validity(args)
     ctx.run_function = run_function
     ctx.preserve_rng_state = preserve_rng_state
+    ctx.policy = policy
 
     # Accommodates the (remote) possibility that autocast is enabled for cpu AND gpu.
     ctx.gpu_autocast_kwargs = {
@@ -135,8 +210,14 @@ class CheckpointFunction(torch.autograd.Function):
 
     ctx.save_for_backward(*tensor_inputs)
 
+    ctx.saved_outputs = []
     with torch.no_grad():
-      outputs = run_function(*args)
+      if policy is None:
+        outputs = run_function(*args)
+      else:
+        with _SaveOutputsMode(policy) as mode:
+          outputs = run_function(*args)
+        ctx.saved_outputs = mode.saved
 
     return outputs
 
@@ -173,9 +254,13 @@ class CheckpointFunction(torch.autograd.Function):
         ctx.run_function.__self__, torch.nn.Module):
       weights = list(ctx.run_function.__self__.parameters())
       buffers = list(ctx.run_function.__self__.buffers())
+    # The saved outputs go through the barrier too, so that XLA keeps them
+    # from the forward rather than recomputing them.
+    saved_outputs = [out for _, out in ctx.saved_outputs]
     xm.optimization_barrier_(
         CheckpointFunction._extract_tensors_from_list(inputs + list(args) +
-                                                      weights + buffers))
+                                                      weights + buffers +
+                                                      saved_outputs))
 
     # torch.random.fork_rng will handle the cpu and gpu seed
     # xm.fork_rng will handle the xla device seed
@@ -192,7 +277,11 @@ class CheckpointFunction(torch.autograd.Function):
             torch.autocast(**ctx.gpu_autocast_kwargs), \
             torch.autocast(**ctx.cpu_autocast_kwargs), \
             torch.autocast(**ctx.xla_autocast_kwargs):
-          outputs = ctx.run_function(*detached_inputs)
+          if ctx.policy is None:
+            outputs = ctx.run_function(*detached_inputs)
+          else:
+            with _ReplayOutputsMode(ctx.policy, ctx.saved_outputs):
+              outputs = ctx.run_function(*detached_inputs)
 
     if isinstance(outputs, torch.Tensor):
       outputs = (outputs,)
@@ -213,7 +302,7 @@ class CheckpointFunction(torch.autograd.Function):
         for inp in detached_inputs)
 
     chkpt_status.in_chkpt_bwd = False
-    return (None, None) + grads
+    return (None, None, None) + grads
 
 
 def checkpoint(function, *args, use_reentrant: bool = True, **kwargs):
@@ -287,6 +376,14 @@ def checkpoint(function, *args, use_reentrant: bool = True, **kwargs):
             allows ``checkpoint`` to support additional functionality, such as
             working as expected with ``torch.autograd.grad``. Note that future
             versions of PyTorch will default to ``use_reentrant=False``.
+        policy(str or callable, optional, default=None): Which outputs of
+            the ops of :attr:`function` are saved in the forward pass rather
+            than recomputed in the backward pass. ``'nothing_saveable'``, like
+            ``None``, recomputes every op. ``'dots_saveable'`` saves the
+            outputs of the matmuls and the convolutions. A callable is called
+            with each aten op overload and returns whether to save its output.
+            The saved outputs are separated from the recomputation by the
+            same ``optimization_barrier_`` as the inputs.
         args: tuple containing inputs to the :attr:`function`
 
     Returns:
@@ -294,11 +391,12 @@ def checkpoint(function, *args, use_reentrant: bool = True, **kwargs):
     """
   # Hack to mix *args with **kwargs in a python 2.7-compliant way
   preserve = kwargs.pop('preserve_rng_state', True)
+  policy = _get_remat_policy(kwargs.pop('policy', None))
   if kwargs:
     raise ValueError("Unexpected keyword arguments: " +
                      ",".join(arg for arg in kwargs))
 
   if use_reentrant:
-    return CheckpointFunction.apply(function, preserve, *args)
+    return CheckpointFunction.apply(function, preserve, policy, *args)
   else:
     raise ValueError("XLA currently does not support use_reentrant==False")
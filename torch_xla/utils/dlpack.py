@@ -1,4 +1,4 @@
-from typing import Any
+from typing import Any, Optional
 import enum
 from torch.utils.dlpack import DLDeviceType
 import torch
@@ -6,15 +6,31 @@ import torch_xla
 import torch_xla.utils.utils as xu
 
 
-def to_dlpack(xla_tensor: Any):
-  return torch_xla._XLAC._to_dlpack(xla_tensor)
+def to_dlpack(xla_tensor: Any, stream: Optional[Any] = None):
+  """Exports the buffer of an XLA tensor as a DLPack capsule.
+
+  Without a `stream`, blocks until the computations writing the buffer
+  complete. On CUDA devices, `stream` is the consumer stream, as an integer of
+  the DLPack `__dlpack__(stream=...)` protocol or a `torch.cuda.Stream`: it is
+  made to wait for the buffer, without blocking the host, so that the producer
+  and the consumer pipeline. -1 skips any synchronization.
+  """
+  if stream is not None and hasattr(stream, 'cuda_stream'):
+    stream = stream.cuda_stream
+  return torch_xla._XLAC._to_dlpack(xla_tensor, stream)
 
 
 def from_dlpack(ext_tensor: Any):
+  """Imports a DLPack capsule, or a tensor or array with `__dlpack__()`.
+
+  The host memory of the CPU tensors and NumPy arrays is aliased by the XLA
+  buffer, rather than copied, when its layout and alignment allow it, and kept
+  alive until the buffer is deleted. It must not be mutated meanwhile.
+  """
   if hasattr(ext_tensor, '__dlpack_device__') and hasattr(
       ext_tensor, '__dlpack__'):
     device_type, _ = ext_tensor.__dlpack_device__()
-    if device_type != DLDeviceType.kDLCPU:
+    if device_type not in (DLDeviceType.kDLCPU, DLDeviceType.kDLCPUPinned):
       raise ValueError(
           "PyTorch/XLA DLPack implementation currently only supports CPU.")
     dlpack = ext_tensor.__dlpack__()